@@ -0,0 +1,117 @@
+#include "app.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "program.h"
+
+namespace glcore
+{
+GLFWwindow *createWindow(const WindowSettings &settings)
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWmonitor *monitor = nullptr;
+    int width = settings.width, height = settings.height;
+    if (settings.fullscreen)
+    {
+        // 与显示器当前模式一致，切换全屏时不改变显示模式
+        monitor = glfwGetPrimaryMonitor();
+        const GLFWvidmode *videoMode = glfwGetVideoMode(monitor);
+        glfwWindowHint(GLFW_RED_BITS, videoMode->redBits);
+        glfwWindowHint(GLFW_GREEN_BITS, videoMode->greenBits);
+        glfwWindowHint(GLFW_BLUE_BITS, videoMode->blueBits);
+        glfwWindowHint(GLFW_REFRESH_RATE, videoMode->refreshRate);
+        width = videoMode->width;
+        height = videoMode->height;
+    }
+
+    GLFWwindow *window = glfwCreateWindow(width, height, settings.title, monitor, NULL);
+    if (window == NULL)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    initProgramCache();
+    return window;
+}
+
+const char *swapModeName(SwapMode mode)
+{
+    switch (mode)
+    {
+    case SwapMode::Immediate:
+        return "immediate";
+    case SwapMode::Vsync:
+        return "vsync";
+    case SwapMode::Adaptive:
+        return "adaptive vsync";
+    }
+    return "";
+}
+
+void FrameLoop::setSwapMode(SwapMode mode)
+{
+    if (mode == SwapMode::Adaptive && !glfwExtensionSupported("WGL_EXT_swap_control_tear") && !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+    {
+        std::cerr << "Adaptive vsync not supported, using vsync" << std::endl;
+        mode = SwapMode::Vsync;
+    }
+    // 自适应垂直同步的交换间隔为 -1
+    glfwSwapInterval(mode == SwapMode::Immediate ? 0 : mode == SwapMode::Vsync ? 1 : -1);
+    swapMode = mode;
+}
+
+bool FrameLoop::begin(GLFWwindow *window)
+{
+    if (glfwWindowShouldClose(window))
+        return false;
+    if (frame == 0)
+        setSwapMode(swapMode);
+    double now = glfwGetTime();
+    deltaTime = frame == 0 ? 0.0f : (float)(now - frameTime);
+    frameTime = now;
+    return true;
+}
+
+void FrameLoop::end(GLFWwindow *window)
+{
+    glfwSwapBuffers(window);
+
+    if (lowLatency)
+    {
+        // 交换之后的栅栏在本帧（包括交换）执行完时触发；等到它再读输入，下一帧的输入就不会排在已提交的帧后面
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 最多100毫秒，避免驱动异常时卡住
+        glDeleteSync(fence);
+    }
+
+    if (frameRateLimit > 0.0)
+    {
+        // 睡到目标时刻前1毫秒，余下的让出时间片等待，系统睡眠的粒度不会让帧超时
+        double target = frameTime + 1.0 / frameRateLimit;
+        double remaining = target - glfwGetTime();
+        if (remaining > 0.002)
+            std::this_thread::sleep_for(std::chrono::duration<double>(remaining - 0.001));
+        while (glfwGetTime() < target)
+            std::this_thread::yield();
+    }
+
+    glfwPollEvents();
+    frame++;
+}
+}
@@ -0,0 +1,50 @@
+// 窗口创建和帧循环，三次作业共用
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+namespace glcore
+{
+struct WindowSettings
+{
+    const char *title = "OpenGL";
+    int width = 800;
+    int height = 600;
+    bool fullscreen = false; // 主显示器独占全屏，分辨率和刷新率取显示器当前模式
+};
+
+// 初始化GLFW，创建 GL 3.3 核心上下文，加载GLAD和程序二进制缓存；失败时返回 nullptr
+GLFWwindow *createWindow(const WindowSettings &settings);
+
+// 交换间隔：不等待 / 垂直同步 / 自适应垂直同步（赶不上刷新时立即交换，允许撕裂而不是掉到半帧率）
+enum class SwapMode
+{
+    Immediate,
+    Vsync,
+    Adaptive
+};
+const char *swapModeName(SwapMode mode);
+
+// 帧循环：
+//   glcore::FrameLoop frameLoop;
+//   while (frameLoop.begin(window)) { ...绘制...; frameLoop.end(window); }
+struct FrameLoop
+{
+    float deltaTime = 0.0f; // 上一帧开始到本帧开始（秒），第一帧为0
+    double frameTime = 0.0; // 本帧开始的 glfwGetTime
+    unsigned int frame = 0;
+
+    SwapMode swapMode = SwapMode::Vsync; // 第一帧开始时设置，之后用 setSwapMode 切换
+    double frameRateLimit = 0.0;         // 帧率上限，0为不限；在轮询输入前睡眠补足帧间隔
+    bool lowLatency = false;             // 交换后等待GPU完成本帧再轮询输入，驱动不再排队多帧，输入延迟更短
+
+    // 需要当前上下文；驱动不支持 *_EXT_swap_control_tear 时自适应退回垂直同步，swapMode 为实际生效的模式
+    void setSwapMode(SwapMode mode);
+
+    // 窗口要关闭时返回 false
+    bool begin(GLFWwindow *window);
+    // 交换缓冲，按设置等待GPU和限帧，然后轮询事件
+    void end(GLFWwindow *window);
+};
+}
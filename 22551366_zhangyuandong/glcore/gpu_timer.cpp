@@ -0,0 +1,47 @@
+#include "gpu_timer.h"
+
+namespace glcore
+{
+void GpuTimer::init(int sections)
+{
+    sectionCount = sections;
+    frame = 0;
+    queries.resize(frameLatency * sectionCount * 2);
+    times.assign(sectionCount, 0.0);
+    glGenQueries((GLsizei)queries.size(), queries.data());
+}
+
+void GpuTimer::deinit()
+{
+    if (!queries.empty())
+    {
+        glDeleteQueries((GLsizei)queries.size(), queries.data());
+    }
+    queries.clear();
+    times.clear();
+}
+
+void GpuTimer::beginFrame()
+{
+    if (!hasResults())
+        return;
+    const unsigned int *frameQueries = &queries[(frame % frameLatency) * sectionCount * 2];
+    for (int section = 0; section < sectionCount; section++)
+    {
+        GLuint64 beginTime = 0, endTime = 0;
+        glGetQueryObjectui64v(frameQueries[section * 2], GL_QUERY_RESULT, &beginTime);
+        glGetQueryObjectui64v(frameQueries[section * 2 + 1], GL_QUERY_RESULT, &endTime);
+        times[section] = (endTime - beginTime) * 1e-6;
+    }
+}
+
+void GpuTimer::begin(int section)
+{
+    glQueryCounter(queries[((frame % frameLatency) * sectionCount + section) * 2], GL_TIMESTAMP);
+}
+
+void GpuTimer::end(int section)
+{
+    glQueryCounter(queries[((frame % frameLatency) * sectionCount + section) * 2 + 1], GL_TIMESTAMP);
+}
+}
@@ -0,0 +1,33 @@
+// GPU分段计时：与 nvgl::ProfilerGpuTimer 相同，每段前后各一个 GL_TIMESTAMP 查询，
+// 查询按帧环形使用，frameLatency 帧后再读回，避免等待GPU
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace glcore
+{
+// 每帧：beginFrame，各段 begin/end（每段每帧都要写入，不用时可为空段），endFrame
+struct GpuTimer
+{
+    static const int frameLatency = 4;
+    int sectionCount = 0;
+    unsigned int frame = 0;
+    std::vector<unsigned int> queries; // [帧][段][开始, 结束]
+    std::vector<double> times;         // 最近读回的耗时（毫秒）
+
+    void init(int sections);
+    void deinit();
+
+    // 读回 frameLatency 帧之前的结果，其查询随后在本帧复用
+    void beginFrame();
+    void endFrame() { frame++; }
+    void begin(int section);
+    void end(int section);
+
+    // 本帧已读回过结果（前 frameLatency 帧还没有）
+    bool hasResults() const { return frame >= frameLatency; }
+    double getMs(int section) const { return times[section]; }
+};
+}
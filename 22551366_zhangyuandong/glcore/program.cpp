@@ -0,0 +1,178 @@
+#include "program.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+
+#include "shader_library.h"
+
+namespace glcore
+{
+// 程序二进制缓存（GL_ARB_get_program_binary，GL 4.1核心）：glad只生成了3.3，函数手动加载
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+typedef void(APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void(APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void(APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+static PFNGLGETPROGRAMBINARYPROC getProgramBinary = nullptr;
+static PFNGLPROGRAMBINARYPROC programBinary = nullptr;
+static PFNGLPROGRAMPARAMETERIPROC programParameteri = nullptr;
+static std::string programCacheDriver; // 驱动标识，驱动更新后缓存自动失效
+
+// GLAD加载后调用，不支持时 getProgramBinary 为空，每次都编译
+void initProgramCache()
+{
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    glGetError(); // 3.3驱动可能不认识该枚举
+    getProgramBinary = (PFNGLGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+    programBinary = (PFNGLPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+    programParameteri = (PFNGLPROGRAMPARAMETERIPROC)glfwGetProcAddress("glProgramParameteri");
+    if (formatCount <= 0 || !getProgramBinary || !programBinary || !programParameteri)
+    {
+        getProgramBinary = nullptr;
+        return;
+    }
+    programCacheDriver = std::string((const char *)glGetString(GL_VENDOR)) + "|" + (const char *)glGetString(GL_RENDERER) + "|" + (const char *)glGetString(GL_VERSION);
+}
+
+// 64位FNV-1a，缓存文件名在不同编译器间保持一致
+static uint64_t hashString(const std::string &text, uint64_t hash = 14695981039346656037ull)
+{
+    for (unsigned char c : text)
+    {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// 缓存文件按着色器源码和驱动标识的哈希命名
+static std::string programCachePath(const char *vertSource, const char *fragSource)
+{
+    uint64_t hash = hashString(programCacheDriver);
+    hash = hashString(vertSource, hash);
+    hash = hashString(fragSource, hash);
+    char name[32];
+    snprintf(name, sizeof(name), "shader_%016llx.glp", (unsigned long long)hash);
+    return name;
+}
+
+// 文件格式：4字节 binaryFormat + 程序二进制
+static bool loadProgramBinary(unsigned int program, const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    GLenum format;
+    if (!file.read((char *)&format, sizeof(format)))
+    {
+        return false;
+    }
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    programBinary(program, format, binary.data(), (GLsizei)binary.size());
+    // 驱动可能拒绝旧的二进制，此时重新编译
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+static void saveProgramBinary(unsigned int program, const std::string &path)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format;
+    getProgramBinary(program, length, &length, &format, binary.data());
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char *)&format, sizeof(format));
+    file.write(binary.data(), length);
+}
+
+// 编译着色器工具函数（有程序二进制缓存时直接加载）
+unsigned int compileShaderProgram(const char *vertSourceWithIncludes, const char *fragSourceWithIncludes)
+{
+    // 先展开 #include，缓存键随共用着色库的修改而变化
+    std::string vertExpanded = expandShaderIncludes(vertSourceWithIncludes);
+    std::string fragExpanded = expandShaderIncludes(fragSourceWithIncludes);
+    const char *vertSource = vertExpanded.c_str();
+    const char *fragSource = fragExpanded.c_str();
+    std::string cachePath;
+    if (getProgramBinary)
+    {
+        cachePath = programCachePath(vertSource, fragSource);
+        unsigned int program = glCreateProgram();
+        if (loadProgramBinary(program, cachePath))
+        {
+            return program;
+        }
+        glDeleteProgram(program);
+    }
+
+    // 编译顶点着色器
+    unsigned int vertShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertShader, 1, &vertSource, NULL);
+    glCompileShader(vertShader);
+    // 检查顶点着色器编译错误
+    int success;
+    char infoLog[512];
+    glGetShaderiv(vertShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertShader, 512, NULL, infoLog);
+        std::cerr << "Vertex Shader Compilation Failed:\n"
+                  << infoLog << std::endl;
+    }
+
+    // 编译片段着色器
+    unsigned int fragShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragShader, 1, &fragSource, NULL);
+    glCompileShader(fragShader);
+    // 检查片段着色器编译错误
+    glGetShaderiv(fragShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(fragShader, 512, NULL, infoLog);
+        std::cerr << "Fragment Shader Compilation Failed:\n"
+                  << infoLog << std::endl;
+    }
+
+    // 链接着色器程序
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertShader);
+    glAttachShader(program, fragShader);
+    if (getProgramBinary)
+    {
+        programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    // 检查链接错误
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "Shader Program Linking Failed:\n"
+                  << infoLog << std::endl;
+    }
+    else if (getProgramBinary)
+    {
+        saveProgramBinary(program, cachePath);
+    }
+
+    // 删除临时着色器对象
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+    return program;
+}
+}
@@ -0,0 +1,14 @@
+// 着色器程序：源码先展开 #include（见 shader_library.h）再编译链接，
+// 驱动支持时经程序二进制缓存直接加载，省去每次启动的编译
+#pragma once
+
+#include <glad/glad.h>
+
+namespace glcore
+{
+// GLAD加载后调用（createWindow 中已调用），不支持时每次都编译
+void initProgramCache();
+
+// 编译失败时输出日志，仍返回程序对象
+unsigned int compileShaderProgram(const char *vertSourceWithIncludes, const char *fragSourceWithIncludes);
+}
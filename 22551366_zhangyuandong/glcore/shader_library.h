@@ -0,0 +1,103 @@
+// 各次作业共用的GLSL着色库，以及着色器源码中 #include "名称" 的展开
+// GLSL 没有 #include：编译前在CPU上把库中同名的代码段替换进来，同一代码段只展开一次
+#pragma once
+
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+
+// 光照：材质输入每个像素只采样一次放入 Material，每个光源先转换为 LightSample，
+// 再由同一个 ShadeLight 累加（Phong 模型，环境光不受阴影影响）
+const char *const shaderLibraryLighting = R"(
+    struct Material {
+        vec3 albedo;     // 纹理颜色，环境光和漫反射共用
+        vec3 specular;   // 镜面反射颜色，无高光时为0
+        float shininess;
+    };
+
+    struct Surface {
+        vec3 position; // 世界空间
+        vec3 normal;   // 已归一化
+        vec3 viewDir;  // 指向观察者，已归一化；无高光时可为0
+    };
+
+    struct LightSample {
+        vec3 direction; // 指向光源，已归一化
+        vec3 ambient;
+        vec3 diffuse;
+        vec3 specular;
+        float attenuation; // 0 表示超出光源范围
+    };
+
+    // 衰减 1/(c + l*d + q*d^2)，coefficients = (c, l, q)
+    float LightAttenuation(vec3 coefficients, float distance) {
+        return 1.0 / (coefficients.x + coefficients.y * distance + coefficients.z * distance * distance);
+    }
+
+    // 背向光源的表面不必计算阴影
+    bool FacesLight(Surface surface, LightSample light) {
+        return dot(surface.normal, light.direction) > 0.0;
+    }
+
+    // shadow 为光源的可见比例，只影响漫反射和镜面反射
+    vec3 ShadeLight(Material material, Surface surface, LightSample light, float shadow) {
+        float diff = max(dot(surface.normal, light.direction), 0.0);
+        vec3 reflectDir = reflect(-light.direction, surface.normal);
+        float spec = pow(max(dot(surface.viewDir, reflectDir), 0.0), material.shininess);
+        vec3 ambient = light.ambient * material.albedo;
+        vec3 diffuse = light.diffuse * diff * material.albedo;
+        vec3 specular = light.specular * spec * material.specular;
+        return (ambient + (diffuse + specular) * shadow) * light.attenuation;
+    }
+)";
+
+struct ShaderLibraryEntry
+{
+    const char *name;
+    const char *source;
+};
+const ShaderLibraryEntry shaderLibrary[] = {
+    {"lighting.glsl", shaderLibraryLighting},
+};
+
+inline std::string expandShaderIncludes(const std::string &source, std::set<std::string> &included)
+{
+    std::istringstream input(source);
+    std::string result, line;
+    while (std::getline(input, line))
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+        {
+            result += line + '\n';
+            continue;
+        }
+        size_t open = line.find('"', start);
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        std::string name = close == std::string::npos ? std::string() : line.substr(open + 1, close - open - 1);
+        const ShaderLibraryEntry *entry = nullptr;
+        for (const ShaderLibraryEntry &candidate : shaderLibrary)
+        {
+            if (name == candidate.name)
+                entry = &candidate;
+        }
+        if (!entry)
+        {
+            // 原样保留，编译时报出具体位置
+            std::cerr << "Shader include not found: " << line << std::endl;
+            result += line + '\n';
+        }
+        else if (included.insert(name).second)
+        {
+            result += expandShaderIncludes(entry->source, included);
+        }
+    }
+    return result;
+}
+
+inline std::string expandShaderIncludes(const std::string &source)
+{
+    std::set<std::string> included;
+    return expandShaderIncludes(source, included);
+}
@@ -0,0 +1,316 @@
+#include "texture_loader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize2.h>
+
+// glad 只生成了 3.3 核心，ARB_texture_compression_bptc 的格式在此定义
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
+namespace glcore
+{
+struct DecodedImage
+{
+    int width = 0, height = 0;
+    unsigned char *pixels = nullptr; // RGBA8，由 stbi_image_free 释放
+    CompressedImage compressed;      // 读取了烘焙纹理时使用，pixels 为空
+};
+struct PendingTexture
+{
+    unsigned int texture;
+    std::string path;
+    std::future<DecodedImage> decoded;
+    int layer = -1; // 纹理数组的层，-1 为二维纹理
+};
+struct UploadBuffer
+{
+    unsigned int pbo = 0;
+    size_t size = 0;
+    GLsync fence = 0; // 上一次上传完成后可复用
+};
+static const int uploadBufferCount = 3;
+static UploadBuffer uploadBuffers[uploadBufferCount];
+static unsigned int uploadBufferIndex = 0;
+static std::vector<PendingTexture> pendingTextures;
+
+std::string getBakedTexturePath(const std::string &path)
+{
+    return std::filesystem::path(path).replace_extension(".ktx2").string();
+}
+
+bool isBakedTextureSupported()
+{
+    static const bool supported = glfwExtensionSupported("GL_ARB_texture_compression_bptc") == GLFW_TRUE;
+    return supported;
+}
+
+template <typename T>
+static T readValue(const std::vector<unsigned char> &data, size_t offset)
+{
+    T value;
+    memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+bool readKTX2(const std::string &path, CompressedImage &image)
+{
+    static const unsigned char identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    const size_t headerSize = 80, levelIndexSize = 24;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    std::vector<unsigned char> data((size_t)file.tellg());
+    file.seekg(0);
+    if (data.size() < headerSize || !file.read((char *)data.data(), data.size()) || memcmp(data.data(), identifier, 12) != 0)
+        return false;
+
+    // 头部：vkFormat、typeSize、宽、高、深度、层数、面数、mip级数、超压缩方式，之后是DFD/KVD/SGD的索引
+    uint32_t vkFormat = readValue<uint32_t>(data, 12);
+    uint32_t depth = readValue<uint32_t>(data, 28), layers = readValue<uint32_t>(data, 32), faces = readValue<uint32_t>(data, 36);
+    uint32_t levelCount = std::max(readValue<uint32_t>(data, 40), 1u);
+    uint32_t supercompression = readValue<uint32_t>(data, 44);
+    if (depth > 1 || layers > 1 || faces != 1 || supercompression != 0 || data.size() < headerSize + levelCount * levelIndexSize)
+        return false;
+    if (vkFormat == 145) // VK_FORMAT_BC7_UNORM_BLOCK
+        image.internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+    else if (vkFormat == 146) // VK_FORMAT_BC7_SRGB_BLOCK
+        image.internalFormat = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+    else
+        return false;
+
+    image.width = (int)readValue<uint32_t>(data, 20);
+    image.height = (int)std::max(readValue<uint32_t>(data, 24), 1u);
+    image.levels.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        uint64_t offset = readValue<uint64_t>(data, headerSize + level * levelIndexSize);
+        uint64_t length = readValue<uint64_t>(data, headerSize + level * levelIndexSize + 8);
+        uint64_t blocks = (uint64_t)((std::max(image.width >> level, 1) + 3) / 4) * ((std::max(image.height >> level, 1) + 3) / 4);
+        if (offset + length > data.size() || length != blocks * 16)
+            return false;
+        image.levels[level].assign(data.begin() + offset, data.begin() + offset + length);
+    }
+    return true;
+}
+
+void uploadCompressedImage(const CompressedImage &image)
+{
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (int)image.levels.size() - 1);
+    for (size_t level = 0; level < image.levels.size(); level++)
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D, (int)level, image.internalFormat, std::max(image.width >> level, 1),
+                               std::max(image.height >> level, 1), 0, (int)image.levels[level].size(), image.levels[level].data());
+    }
+}
+
+// 解码完成前为1x1白色纹理
+unsigned int loadTexture(const std::string &path)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // 纹理参数设置
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // 解码完成前使用默认白色纹理（只有第0级，避免纹理不完整）
+    unsigned char defaultData[] = {255, 255, 255, 255};
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, defaultData);
+
+    // 在工作线程解码图片
+    PendingTexture pending;
+    pending.texture = texture;
+    pending.path = path;
+    std::string baked = isBakedTextureSupported() ? getBakedTexturePath(path) : std::string();
+    pending.decoded = std::async(std::launch::async, [path, baked]()
+                                 {
+                                     DecodedImage image;
+                                     if (!baked.empty() && readKTX2(baked, image.compressed))
+                                         return image;
+                                     image.compressed = CompressedImage();
+                                     int channels;
+                                     image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &channels, STBI_rgb_alpha);
+                                     return image; });
+    pendingTextures.push_back(std::move(pending));
+    return texture;
+}
+
+// 所有层先填白色，图片解码后缩放到层的尺寸
+unsigned int loadTextureArray(const std::vector<std::string> &paths, int size)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    int levels = 1 + (int)std::floor(std::log2((float)size));
+    int layers = std::max((int)paths.size(), 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    for (int level = 0; level < levels; level++)
+    {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, std::max(size >> level, 1), std::max(size >> level, 1), layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    std::vector<unsigned char> white((size_t)size * size * 4, 255);
+    for (int layer = 0; layer < layers; layer++)
+    {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, white.data());
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    for (size_t layer = 0; layer < paths.size(); layer++)
+    {
+        PendingTexture pending;
+        pending.texture = texture;
+        pending.path = paths[layer];
+        pending.layer = (int)layer;
+        std::string path = paths[layer];
+        pending.decoded = std::async(std::launch::async, [path, size]()
+                                     {
+                                         DecodedImage image;
+                                         int width, height, channels;
+                                         unsigned char *pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+                                         if (!pixels)
+                                             return image;
+                                         // stb_image 与 stb_image_resize 都用 malloc 分配，结果同样由 stbi_image_free 释放
+                                         image.pixels = stbir_resize_uint8_linear(pixels, width, height, 0, NULL, size, size, 0, STBIR_RGBA);
+                                         image.width = image.height = image.pixels ? size : 0;
+                                         stbi_image_free(pixels);
+                                         return image; });
+        pendingTextures.push_back(std::move(pending));
+    }
+    return texture;
+}
+
+bool isTextureLoaded(unsigned int texture)
+{
+    return std::none_of(pendingTextures.begin(), pendingTextures.end(), [texture](const PendingTexture &pending)
+                        { return pending.texture == texture; });
+}
+
+// 每帧调用：上传已解码的纹理，PBO上一次的上传未完成时下一帧再试
+void updateTextureUploads()
+{
+    for (auto it = pendingTextures.begin(); it != pendingTextures.end();)
+    {
+        if (it->decoded.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+
+        UploadBuffer &upload = uploadBuffers[uploadBufferIndex];
+        if (upload.fence)
+        {
+            if (glClientWaitSync(upload.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            {
+                return;
+            }
+            glDeleteSync(upload.fence);
+            upload.fence = 0;
+        }
+
+        DecodedImage image = it->decoded.get();
+        if (!image.compressed.levels.empty())
+        {
+            // 烘焙的纹理已含全部mip级别，直接上传，不经PBO
+            glBindTexture(GL_TEXTURE_2D, it->texture);
+            uploadCompressedImage(image.compressed);
+            it = pendingTextures.erase(it);
+            continue;
+        }
+        if (!image.pixels)
+        {
+            std::cerr << "Failed to load texture: " << it->path << std::endl;
+            it = pendingTextures.erase(it);
+            continue;
+        }
+
+        // 拷贝到PBO，由驱动异步传到纹理
+        size_t size = (size_t)image.width * image.height * 4;
+        if (!upload.pbo)
+        {
+            glGenBuffers(1, &upload.pbo);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.pbo);
+        if (upload.size < size)
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+            upload.size = size;
+        }
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        memcpy(mapped, image.pixels, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        stbi_image_free(image.pixels);
+
+        if (it->layer >= 0)
+        {
+            // 数组的存储已分配，只更新该层，再重新生成mip
+            glBindTexture(GL_TEXTURE_2D_ARRAY, it->texture);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, it->layer, image.width, image.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0);
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        }
+        else
+        {
+            // 所有mip级别的存储一次分配，之后只更新内容
+            int levels = 1 + (int)std::floor(std::log2((float)std::max(image.width, image.height)));
+            glBindTexture(GL_TEXTURE_2D, it->texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+            for (int level = 0; level < levels; level++)
+            {
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, std::max(image.width >> level, 1), std::max(image.height >> level, 1), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            }
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        uploadBufferIndex = (uploadBufferIndex + 1) % uploadBufferCount;
+        it = pendingTextures.erase(it);
+    }
+}
+
+void shutdownTextureLoader()
+{
+    // 等待未完成的解码
+    for (PendingTexture &pending : pendingTextures)
+    {
+        stbi_image_free(pending.decoded.get().pixels);
+    }
+    pendingTextures.clear();
+    for (UploadBuffer &upload : uploadBuffers)
+    {
+        if (upload.fence)
+        {
+            glDeleteSync(upload.fence);
+        }
+        glDeleteBuffers(1, &upload.pbo);
+        upload = UploadBuffer();
+    }
+}
+}
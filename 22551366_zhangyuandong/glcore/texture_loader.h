@@ -0,0 +1,48 @@
+// 异步纹理加载：工作线程解码，主线程经PBO环上传，纹理解码完成前显示白色占位纹理
+// stb_image 和 stb_image_resize2 的实现也在这里，各程序只包含头文件
+// 图片旁有构建时烘焙的同名 .ktx2（BC7，含全部mip级别）且驱动支持时，直接上传压缩数据
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace glcore
+{
+// 立即返回纹理（重复寻址、三线性过滤），图片上传后生成全部mip级别
+unsigned int loadTexture(const std::string &path);
+
+// 立即返回纹理数组，每层一张图片，缩放到 size x size；图片上传前该层为白色。
+// 不使用烘焙纹理（各图片的尺寸和格式不同）
+unsigned int loadTextureArray(const std::vector<std::string> &paths, int size);
+
+// 纹理的图片是否已上传（加载失败也算完成），之后纹理不再变化，可以创建 bindless 句柄
+bool isTextureLoaded(unsigned int texture);
+
+// 每帧调用：上传已解码的纹理
+void updateTextureUploads();
+
+// 销毁上下文前调用：等待未完成的解码，释放PBO
+void shutdownTextureLoader();
+
+// asset_baker 生成的压缩纹理，levels[0] 为最大一级
+struct CompressedImage
+{
+    unsigned int internalFormat = 0; // GL 压缩格式
+    int width = 0, height = 0;
+    std::vector<std::vector<unsigned char>> levels;
+};
+
+// 图片对应的烘焙纹理：同目录、扩展名为 .ktx2
+std::string getBakedTexturePath(const std::string &path);
+
+// 当前上下文能否采样 BC7，需在主线程调用
+bool isBakedTextureSupported();
+
+// 读取未超压缩的二维 KTX2 文件，只支持 BC7；可在工作线程调用
+bool readKTX2(const std::string &path, CompressedImage &image);
+
+// 上传到当前绑定的 GL_TEXTURE_2D，设置 mip 级别范围
+void uploadCompressedImage(const CompressedImage &image);
+}
@@ -0,0 +1,44 @@
+// UBO：std140 布局的结构体整体上传到固定的绑定点
+#pragma once
+
+#include <glad/glad.h>
+
+namespace glcore
+{
+template <typename T>
+struct UniformBuffer
+{
+    unsigned int buffer = 0;
+
+    void init(unsigned int binding)
+    {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+    }
+
+    // 内容变化时调用
+    void upload(const T &data)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+    }
+
+    void deinit()
+    {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+};
+
+// 把程序中的 uniform 块连接到绑定点，程序中没有该块时忽略
+inline void bindUniformBlock(unsigned int program, const char *block, unsigned int binding)
+{
+    unsigned int index = glGetUniformBlockIndex(program, block);
+    if (index != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, index, binding);
+    }
+}
+}
@@ -0,0 +1,698 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ CPU microbenchmarks of the framework hot paths.
+
+ Each benchmark runs until `--minTime` seconds have passed (at least 5 iterations), the median time
+ of an iteration is reported. The results are written as JSON, one benchmark per line:
+
+   vk_mini_samples_benchmarks --json baseline.json
+   vk_mini_samples_benchmarks --json current.json --baseline baseline.json --threshold 10
+
+ With a baseline, the benchmarks whose median is slower by more than `--threshold` percent are
+ regressions, and the exit code is the number of them. `--filter` runs only the benchmarks whose
+ name contains it. The benchmarks needing a Vulkan device (BufferSubAllocator, SamplerPool) are
+ skipped when none can be created, or with `--noVulkan`.
+
+ The OBJ viewer's `loadOBJ` lives in its own executable, which has the same JSON output:
+   opengl_learning --benchmark-load model.obj --benchmark-iterations 10 --benchmark-json load.json
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+#include <glm/gtc/quaternion.hpp>
+#include <vulkan/vulkan_core.h>
+
+#define VMA_IMPLEMENTATION
+
+#include <nvimageformats/nv_dds.h>
+#include <nvimageformats/nv_ktx.h>
+#include <nvutils/bit_array.hpp>
+#include <nvutils/file_operations.hpp>
+#include <nvutils/id_pool.hpp>
+#include <nvutils/logger.hpp>
+#include <nvutils/parallel_work.hpp>
+#include <nvutils/parameter_parser.hpp>
+#include <nvutils/primitives.hpp>
+#include <nvvk/buffer_suballocator.hpp>
+#include <nvvk/check_error.hpp>
+#include <nvvk/context.hpp>
+#include <nvvk/resource_allocator.hpp>
+#include <nvvk/sampler_pool.hpp>
+#include <nvvkgltf/scene.hpp>
+
+// Keeps the results of the measured code alive
+static volatile uint64_t g_sink = 0;
+
+//--------------------------------------------------------------------------------------------------
+// Runs the benchmarks and collects their times
+//
+class BenchmarkRunner
+{
+public:
+  struct Result
+  {
+    std::string name;
+    uint64_t    items      = 0;  // processed by one iteration
+    uint32_t    iterations = 0;
+    double      medianNs   = 0.0;
+    double      minNs      = 0.0;
+  };
+
+  BenchmarkRunner(std::string filter, double minTime)
+      : m_filter(std::move(filter))
+      , m_minTime(minTime)
+  {
+  }
+
+  bool enabled(const std::string& name) const { return m_filter.empty() || name.find(m_filter) != std::string::npos; }
+
+  // `fn` is one iteration, `setup` runs before each one and is not measured
+  void run(const std::string& name, uint64_t items, const std::function<void()>& fn, const std::function<void()>& setup = {})
+  {
+    if(!enabled(name))
+      return;
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> times;
+    double              total = 0.0;
+    if(setup)
+      setup();
+    fn();  // warm up the caches and the thread pool
+    while((total < m_minTime || times.size() < 5) && times.size() < 100000)
+    {
+      if(setup)
+        setup();
+      const Clock::time_point start = Clock::now();
+      fn();
+      const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      times.push_back(seconds * 1e9);
+      total += seconds;
+    }
+
+    std::sort(times.begin(), times.end());
+    Result result{name, items, uint32_t(times.size()), times[times.size() / 2], times.front()};
+    LOGI("%-40s %12.1f us  %8.2f ns/item  (%u iterations)\n", name.c_str(), result.medianNs * 1e-3,
+         result.medianNs / double(std::max<uint64_t>(items, 1)), result.iterations);
+    m_results.push_back(std::move(result));
+  }
+
+  void writeJson(const std::filesystem::path& filename) const
+  {
+    std::ofstream file(filename);
+    if(!file)
+    {
+      LOGE("Failed to write the benchmark results %s\n", nvutils::utf8FromPath(filename).c_str());
+      return;
+    }
+    file << fmt::format("{{\n  \"cpuThreads\": {},\n  \"benchmarks\": [", std::thread::hardware_concurrency());
+    for(size_t i = 0; i < m_results.size(); i++)
+    {
+      const Result& r = m_results[i];
+      file << (i ? ",\n" : "\n")
+           << fmt::format("    {{\"name\": \"{}\", \"items\": {}, \"iterations\": {}, \"medianNs\": {:.1f}, \"minNs\": {:.1f}}}",
+                          r.name, r.items, r.iterations, r.medianNs, r.minNs);
+    }
+    file << "\n  ]\n}\n";
+    LOGI("Results of %zu benchmarks written to %s\n", m_results.size(), nvutils::utf8FromPath(filename).c_str());
+  }
+
+  // Returns the number of benchmarks slower than in `filename` by more than `thresholdPercent`
+  uint32_t compareJson(const std::filesystem::path& filename, float thresholdPercent) const
+  {
+    std::ifstream file(filename);
+    if(!file)
+    {
+      LOGE("Failed to read the benchmark baseline %s\n", nvutils::utf8FromPath(filename).c_str());
+      return 0;
+    }
+
+    // the files written by writeJson have one benchmark per line
+    std::unordered_map<std::string, double> baseline;
+    std::string                             line;
+    while(std::getline(file, line))
+    {
+      const size_t name   = line.find("\"name\": \"");
+      const size_t median = line.find("\"medianNs\": ");
+      if(name == std::string::npos || median == std::string::npos)
+        continue;
+      const size_t nameBegin = name + 9;
+      const size_t nameEnd   = line.find('"', nameBegin);
+      baseline[line.substr(nameBegin, nameEnd - nameBegin)] = std::strtod(line.c_str() + median + 12, nullptr);
+    }
+
+    uint32_t regressions = 0;
+    for(const Result& r : m_results)
+    {
+      auto it = baseline.find(r.name);
+      if(it == baseline.end() || it->second <= 0.0)
+        continue;
+      const double change = (r.medianNs / it->second - 1.0) * 100.0;
+      if(change > thresholdPercent)
+      {
+        LOGW("Regression %-40s %+.1f%% (%.1f us -> %.1f us)\n", r.name.c_str(), change, it->second * 1e-3, r.medianNs * 1e-3);
+        regressions++;
+      }
+    }
+    LOGI("%u regressions against %s (threshold %.1f%%)\n", regressions, nvutils::utf8FromPath(filename).c_str(), thresholdPercent);
+    return regressions;
+  }
+
+private:
+  std::string         m_filter;
+  double              m_minTime = 0.25;
+  std::vector<Result> m_results;
+};
+
+//--------------------------------------------------------------------------------------------------
+// parallel_batches: cost of the dispatch for a cheap body, with several batch sizes
+//
+template <uint64_t BATCHSIZE>
+static void benchParallelBatches(BenchmarkRunner& runner, std::vector<float>& values)
+{
+  runner.run(fmt::format("parallel_batches/{}/{}", values.size(), BATCHSIZE), values.size(), [&] {
+    nvutils::parallel_batches<BATCHSIZE>(values.size(), [&](uint64_t i) { values[i] = values[i] * 0.5f + 1.0f; });
+  });
+}
+
+static void benchParallelWork(BenchmarkRunner& runner)
+{
+  for(size_t count : {size_t(4096), size_t(1) << 20})
+  {
+    std::vector<float> values(count, 1.0f);
+    runner.run(fmt::format("parallel_batches/{}/serial", count), count, [&] {
+      nvutils::parallel_batches(values.size(), [&](uint64_t i) { values[i] = values[i] * 0.5f + 1.0f; }, 1);
+    });
+    benchParallelBatches<64>(runner, values);
+    benchParallelBatches<512>(runner, values);
+    benchParallelBatches<4096>(runner, values);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+static void benchBitArray(BenchmarkRunner& runner)
+{
+  const size_t       count = size_t(1) << 22;
+  nvutils::BitArray  bits(count);
+  nvutils::BitArray  other(count);
+  for(size_t i = 0; i < count; i += 5)
+  {
+    other.enableBit(i);
+  }
+
+  runner.run("BitArray/setBit", count, [&] {
+    for(size_t i = 0; i < count; i++)
+    {
+      bits.setBit(i, (i % 3) == 0);
+    }
+  });
+  runner.run("BitArray/getBit", count, [&] {
+    uint64_t sum = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+      sum += bits.getBit(i);
+    }
+    g_sink = sum;
+  });
+  runner.run("BitArray/countSetBits", count, [&] { g_sink = bits.countSetBits(); });
+  runner.run("BitArray/traverseBits", count, [&] {
+    uint64_t sum = 0;
+    bits.traverseBits([&](size_t index) { sum += index; });
+    g_sink = sum;
+  });
+  runner.run("BitArray/and", count, [&] {
+    nvutils::BitArray result = bits & other;
+    g_sink                   = result.data()[0];
+  });
+}
+
+//--------------------------------------------------------------------------------------------------
+// Threads creating and destroying IDs, each holding a few at a time: ConcurrentIDPool against an IDPool behind a mutex
+//
+static void benchIDPool(BenchmarkRunner& runner)
+{
+  if(!runner.enabled("IDPool/"))
+    return;
+
+  constexpr uint32_t kPoolSize  = 1 << 20;
+  constexpr uint32_t kLiveIDs   = 256;  // IDs each thread holds at a time
+  constexpr uint32_t kPerThread = 1 << 16;
+
+  auto churn = [&](uint32_t threads, auto&& create, auto&& destroy) {
+    nvutils::parallel_batches<1>(
+        threads,
+        [&](uint64_t) {
+          std::vector<uint32_t> live(kLiveIDs);
+          for(uint32_t& id : live)
+            create(id);
+          for(uint32_t i = 0; i < kPerThread; i++)
+          {
+            uint32_t& slot = live[i % kLiveIDs];
+            destroy(slot);
+            create(slot);
+          }
+          for(uint32_t id : live)
+            destroy(id);
+        },
+        threads);
+  };
+
+  nvutils::IDPool           idPool(kPoolSize);
+  std::mutex                idPoolMutex;
+  nvutils::ConcurrentIDPool concurrentPool(kPoolSize);
+  for(uint32_t threads : {1U, 8U, std::max(std::thread::hardware_concurrency(), 1U)})
+  {
+    runner.run(fmt::format("IDPool/mutex/{}threads", threads), uint64_t(threads) * kPerThread, [&] {
+      churn(
+          threads,
+          [&](uint32_t& id) {
+            std::lock_guard lock(idPoolMutex);
+            idPool.createID(id);
+          },
+          [&](uint32_t id) {
+            std::lock_guard lock(idPoolMutex);
+            idPool.destroyID(id);
+          });
+    });
+    runner.run(fmt::format("IDPool/concurrent/{}threads", threads), uint64_t(threads) * kPerThread, [&] {
+      churn(threads, [&](uint32_t& id) { concurrentPool.createID(id); }, [&](uint32_t id) { concurrentPool.destroyID(id); });
+    });
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Welds a mesh expanded to 3 vertices per triangle, like a mesh read from an OBJ file
+//
+static void benchPrimitives(BenchmarkRunner& runner)
+{
+  const nvutils::PrimitiveMesh sphere = nvutils::createSphereMesh(0.5f, 6);
+  nvutils::PrimitiveMesh       expanded;
+  for(const nvutils::PrimitiveTriangle& triangle : sphere.triangles)
+  {
+    const uint32_t first = uint32_t(expanded.vertices.size());
+    for(int c = 0; c < 3; c++)
+    {
+      expanded.vertices.push_back(sphere.vertices[triangle.indices[c]]);
+    }
+    expanded.triangles.push_back({{first, first + 1, first + 2}});
+  }
+
+  runner.run("removeDuplicateVertices", expanded.vertices.size(), [&] {
+    g_sink = nvutils::removeDuplicateVertices(expanded).vertices.size();
+  });
+  runner.run("removeDuplicateVertices/positionOnly", expanded.vertices.size(), [&] {
+    g_sink = nvutils::removeDuplicateVertices(expanded, false, false).vertices.size();
+  });
+}
+
+//--------------------------------------------------------------------------------------------------
+// A crowd: `animationCount` animations, each moving and turning `nodesPerAnimation` nodes of its own
+//
+static tinygltf::Model createAnimatedModel(int animationCount, int nodesPerAnimation, int keyCount)
+{
+  tinygltf::Model             model;
+  std::vector<unsigned char>& data = model.buffers.emplace_back().data;
+
+  auto addAccessor = [&](const std::vector<float>& values, int type, int components) {
+    tinygltf::BufferView& view = model.bufferViews.emplace_back();
+    view.buffer                = 0;
+    view.byteOffset            = data.size();
+    view.byteLength            = values.size() * sizeof(float);
+    const auto* bytes          = reinterpret_cast<const unsigned char*>(values.data());
+    data.insert(data.end(), bytes, bytes + view.byteLength);
+
+    tinygltf::Accessor& accessor = model.accessors.emplace_back();
+    accessor.bufferView          = int(model.bufferViews.size()) - 1;
+    accessor.componentType       = TINYGLTF_COMPONENT_TYPE_FLOAT;
+    accessor.count               = values.size() / components;
+    accessor.type                = type;
+    return int(model.accessors.size()) - 1;
+  };
+
+  std::vector<float> times(keyCount);
+  for(int k = 0; k < keyCount; k++)
+  {
+    times[k] = float(k) / 30.0f;
+  }
+  const int input = addAccessor(times, TINYGLTF_TYPE_SCALAR, 1);
+
+  model.nodes.emplace_back();  // root
+  model.scenes.emplace_back().nodes = {0};
+  model.defaultScene                = 0;
+
+  for(int a = 0; a < animationCount; a++)
+  {
+    tinygltf::Animation& animation = model.animations.emplace_back();
+    for(int n = 0; n < nodesPerAnimation; n++)
+    {
+      const int node = int(model.nodes.size());
+      model.nodes.emplace_back();
+      model.nodes[0].children.push_back(node);
+
+      std::vector<float> translations;
+      std::vector<float> rotations;
+      for(int k = 0; k < keyCount; k++)
+      {
+        const float     phase    = float(k) * 0.1f + float(node);
+        const glm::quat rotation = glm::angleAxis(phase, glm::vec3(0.0f, 1.0f, 0.0f));
+        translations.insert(translations.end(), {std::sin(phase), 0.0f, std::cos(phase)});
+        rotations.insert(rotations.end(), {rotation.x, rotation.y, rotation.z, rotation.w});
+      }
+
+      const char* paths[] = {"translation", "rotation"};
+      const int   outputs[] = {addAccessor(translations, TINYGLTF_TYPE_VEC3, 3), addAccessor(rotations, TINYGLTF_TYPE_VEC4, 4)};
+      for(int c = 0; c < 2; c++)
+      {
+        tinygltf::AnimationSampler& sampler = animation.samplers.emplace_back();
+        sampler.input                       = input;
+        sampler.output                      = outputs[c];
+        sampler.interpolation               = "LINEAR";
+
+        tinygltf::AnimationChannel& channel = animation.channels.emplace_back();
+        channel.sampler                     = int(animation.samplers.size()) - 1;
+        channel.target_node                 = node;
+        channel.target_path                 = paths[c];
+      }
+    }
+  }
+  return model;
+}
+
+static void benchGltfAnimation(BenchmarkRunner& runner)
+{
+  if(!runner.enabled("gltf/"))
+    return;
+
+  const int          animationCount    = 64;
+  const int          nodesPerAnimation = 32;
+  nvvkgltf::Scene    scene;
+  scene.takeModel(createAnimatedModel(animationCount, nodesPerAnimation, 120));
+
+  std::vector<uint32_t> animations(scene.getNumAnimations());
+  std::iota(animations.begin(), animations.end(), 0U);
+  auto advance = [&] {
+    for(uint32_t a : animations)
+    {
+      scene.getAnimationInfo(a).incrementTime(1.0f / 60.0f);
+    }
+  };
+
+  const uint64_t channels = uint64_t(animationCount) * nodesPerAnimation * 2;
+  runner.run(
+      "gltf/updateAnimation", channels,
+      [&] {
+        for(uint32_t a : animations)
+        {
+          scene.updateAnimation(a);
+        }
+      },
+      advance);
+  runner.run("gltf/updateAnimations", channels, [&] { scene.updateAnimations(animations); }, advance);
+  runner.run(
+      "gltf/updateRenderNodes", channels, [&] { g_sink = scene.updateRenderNodes().size(); },
+      [&] {
+        advance();
+        scene.updateAnimations(animations);
+      });
+}
+
+//--------------------------------------------------------------------------------------------------
+// Parsing of a 2048x2048 RGBA8 texture with its mips, written in memory by the same library
+//
+static void benchImageFormats(BenchmarkRunner& runner)
+{
+  const uint32_t size     = 2048;
+  const uint32_t numMips  = 12;
+  uint64_t       texels   = 0;
+  std::string    ddsData;
+  std::string    ktxData;
+
+  {
+    nv_dds::Image image;
+    image.mip0Width  = size;
+    image.mip0Height = size;
+    image.dxgiFormat = 28;  // DXGI_FORMAT_R8G8B8A8_UNORM
+    if(image.allocate(numMips))
+      return;
+    for(uint32_t mip = 0; mip < numMips; mip++)
+    {
+      const size_t mipTexels = size_t(image.getWidth(mip)) * image.getHeight(mip);
+      image.subresource(mip).create(mipTexels * 4, nullptr);
+      texels += mipTexels;
+    }
+    std::ostringstream output;
+    if(nv_dds::ErrorWithText error = image.writeToStream(output, {}))
+    {
+      LOGE("nv_dds: %s\n", error->c_str());
+      return;
+    }
+    ddsData = output.str();
+  }
+
+  {
+    nv_ktx::KTXImage image;
+    image.mip_0_width  = size;
+    image.mip_0_height = size;
+    image.format       = VK_FORMAT_R8G8B8A8_UNORM;
+    image.is_srgb      = false;
+    if(image.allocate(numMips))
+      return;
+    for(uint32_t mip = 0; mip < numMips; mip++)
+    {
+      image.subresource(mip).resize(size_t(std::max(size >> mip, 1U)) * std::max(size >> mip, 1U) * 4);
+    }
+    std::ostringstream output;
+    if(nv_ktx::ErrorWithText error = image.writeKTX2Stream(output, {}))
+    {
+      LOGE("nv_ktx: %s\n", error->c_str());
+      return;
+    }
+    ktxData = output.str();
+  }
+
+  runner.run("nv_dds/readHeaderFromMemory", 1, [&] {
+    nv_dds::Image image;
+    g_sink = image.readHeaderFromMemory(ddsData.data(), ddsData.size(), {}).has_value();
+  });
+  runner.run("nv_dds/readFromMemory", texels, [&] {
+    nv_dds::Image image;
+    g_sink = image.readFromMemory(ddsData.data(), ddsData.size(), {}).has_value();
+  });
+  runner.run("nv_dds/readFromMappedMemory", texels, [&] {
+    nv_dds::Image image;
+    g_sink = image.readFromMappedMemory(ddsData.data(), ddsData.size(), {}).has_value();
+  });
+
+  std::istringstream ktxStream(ktxData);
+  runner.run("nv_ktx/readFromStream", texels, [&] {
+    ktxStream.clear();
+    ktxStream.seekg(0);
+    nv_ktx::KTXImage image;
+    g_sink = image.readFromStream(ktxStream, {}).has_value();
+  });
+  runner.run("nv_ktx/readFromMappedMemory", texels, [&] {
+    nv_ktx::KTXImage image;
+    g_sink = image.readFromMappedMemory(ktxData.data(), ktxData.size(), {}).has_value();
+  });
+}
+
+//--------------------------------------------------------------------------------------------------
+// Sub-allocation of a scene of small meshes, freed in an order leaving holes
+//
+static void benchBufferSubAllocator(BenchmarkRunner& runner, nvvk::ResourceAllocator& allocator)
+{
+  if(!runner.enabled("BufferSubAllocator/"))
+    return;
+
+  nvvk::BufferSubAllocator subAllocator;
+  NVVK_CHECK(subAllocator.init({
+      .resourceAllocator = &allocator,
+      .debugName         = "benchmark",
+      .usageFlags        = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT,
+      .memoryUsage       = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+      .blockSize         = VkDeviceSize(64) * 1024 * 1024,
+  }));
+
+  std::vector<nvvk::BufferSubAllocation> allocations(4096);
+  auto                                   allocate = [&] {
+    for(size_t i = 0; i < allocations.size(); i++)
+    {
+      subAllocator.subAllocate(allocations[i], VkDeviceSize(256) << (i % 9));
+    }
+  };
+  auto freeAll = [&] {
+    for(size_t start : {0, 1})
+    {
+      for(size_t i = start; i < allocations.size(); i += 2)
+      {
+        subAllocator.subFree(allocations[i]);
+      }
+    }
+  };
+
+  runner.run("BufferSubAllocator/subAllocate+subFree", allocations.size(), [&] {
+    allocate();
+    freeAll();
+  });
+  subAllocator.deinit();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Samplers acquired and released by several threads at once, as when loading textures in parallel.
+// Each configuration is held once, so the acquisitions find existing samplers.
+//
+static void benchSamplerPool(BenchmarkRunner& runner, VkDevice device)
+{
+  if(!runner.enabled("SamplerPool/"))
+    return;
+
+  nvvk::SamplerPool pool;
+  pool.init(device);
+
+  std::vector<VkSamplerCreateInfo> infos;
+  for(VkSamplerAddressMode mode : {VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE})
+  {
+    for(VkFilter filter : {VK_FILTER_LINEAR, VK_FILTER_NEAREST})
+    {
+      for(VkSamplerMipmapMode mipmap : {VK_SAMPLER_MIPMAP_MODE_LINEAR, VK_SAMPLER_MIPMAP_MODE_NEAREST})
+      {
+        infos.push_back({.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                         .magFilter    = filter,
+                         .minFilter    = filter,
+                         .mipmapMode   = mipmap,
+                         .addressModeU = mode,
+                         .addressModeV = mode,
+                         .addressModeW = mode,
+                         .maxLod       = VK_LOD_CLAMP_NONE});
+      }
+    }
+  }
+  std::vector<VkSampler> held(infos.size());
+  for(size_t i = 0; i < infos.size(); i++)
+  {
+    NVVK_CHECK(pool.acquireSampler(held[i], infos[i]));
+  }
+
+  const uint32_t perThread = 1000;
+  for(uint32_t threads : {1U, 4U, std::max(std::thread::hardware_concurrency(), 1U)})
+  {
+    runner.run(fmt::format("SamplerPool/acquireSampler/{}threads", threads), uint64_t(threads) * perThread, [&] {
+      nvutils::parallel_batches<1>(
+          threads,
+          [&](uint64_t t) {
+            for(uint32_t j = 0; j < perThread; j++)
+            {
+              VkSampler sampler{};
+              pool.acquireSampler(sampler, infos[(j + t) % infos.size()]);
+              pool.releaseSampler(sampler);
+            }
+          },
+          threads);
+    });
+  }
+
+  for(VkSampler sampler : held)
+  {
+    pool.releaseSampler(sampler);
+  }
+  pool.deinit();
+}
+
+static void benchVulkan(BenchmarkRunner& runner)
+{
+  if(!runner.enabled("BufferSubAllocator/") && !runner.enabled("SamplerPool/"))
+    return;
+
+  nvvk::ContextInitInfo vkSetup{.enableValidationLayers = false, .verbose = false};
+  nvvk::Context         vkContext;
+  if(vkContext.init(vkSetup) != VK_SUCCESS)
+  {
+    LOGW("No Vulkan device, skipping the BufferSubAllocator and SamplerPool benchmarks\n");
+    return;
+  }
+
+  nvvk::ResourceAllocator allocator;
+  NVVK_CHECK(allocator.init({
+      .flags            = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT,
+      .physicalDevice   = vkContext.getPhysicalDevice(),
+      .device           = vkContext.getDevice(),
+      .instance         = vkContext.getInstance(),
+      .vulkanApiVersion = VK_API_VERSION_1_4,
+  }));
+
+  benchBufferSubAllocator(runner, allocator);
+  benchSamplerPool(runner, vkContext.getDevice());
+
+  allocator.deinit();
+  vkContext.deinit();
+}
+
+//--------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  std::filesystem::path jsonFile;
+  std::filesystem::path baselineFile;
+  std::string           filter;
+  float                 thresholdPercent = 10.0f;
+  float                 minTime          = 0.25f;
+  bool                  noVulkan         = false;
+
+  nvutils::ParameterParser   cli(nvutils::getExecutablePath().stem().string());
+  nvutils::ParameterRegistry reg;
+  reg.add({"json", "Write the results to this JSON file"}, &jsonFile);
+  reg.add({"baseline", "JSON results of a previous run: the exit code is the number of regressions against it"}, &baselineFile);
+  reg.add({"threshold", "Benchmarks slower than the baseline by more than this percentage are regressions"}, &thresholdPercent);
+  reg.add({"minTime", "Minimum measured time of each benchmark, in seconds"}, &minTime, 0.01f, 60.0f);
+  reg.add({"filter", "Only run the benchmarks whose name contains this string"}, &filter);
+  reg.add({"noVulkan", "Skip the benchmarks needing a Vulkan device"}, &noVulkan, true);
+  cli.add(reg);
+  cli.parse(argc, argv);
+
+  BenchmarkRunner runner(filter, minTime);
+  benchParallelWork(runner);
+  benchBitArray(runner);
+  benchIDPool(runner);
+  benchPrimitives(runner);
+  benchGltfAnimation(runner);
+  benchImageFormats(runner);
+  if(!noVulkan)
+  {
+    benchVulkan(runner);
+  }
+
+  if(!jsonFile.empty())
+  {
+    runner.writeJson(jsonFile);
+  }
+  return baselineFile.empty() ? 0 : int(runner.compareJson(baselineFile, thresholdPercent));
+}
@@ -8,8 +8,15 @@
 #define IM_VEC2_CLASS_EXTRA ImVec2(const glm::vec2& f) {x = f.x; y = f.y;} operator glm::vec2() const { return glm::vec2(x, y); }
 // clang-format on
 
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
 #include <glm/glm.hpp>
+#include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
@@ -19,7 +26,10 @@
 
 #define VMA_IMPLEMENTATION
 
-#include "_autogen/mesh_task.slang.h"  // Pre-compiled shader
+#include "_autogen/grass_vertex.slang.h"  // Pre-compiled shader
+#include "_autogen/hiz.slang.h"           // Pre-compiled shader
+#include "_autogen/mesh_task.slang.h"     // Pre-compiled shader
+#include "_autogen/upscale.slang.h"       // Pre-compiled shader
 
 
 #include <common/utils.hpp>
@@ -28,28 +38,44 @@
 #include <nvapp/elem_default_menu.hpp>
 #include <nvapp/elem_default_title.hpp>
 #include <nvapp/elem_profiler.hpp>
+#include <nvapp/elem_sequencer.hpp>
 #include <nvgui/camera.hpp>
+#include <nvnsight/nsightevents.hpp>
+#include <nvslang/shader_permutations.hpp>
 #include <nvslang/slang.hpp>
 #include <nvutils/file_operations.hpp>
 #include <nvutils/parameter_parser.hpp>
+#include <nvvk/barriers.hpp>
 #include <nvvk/buffer_suballocator.hpp>
 #include <nvvk/check_error.hpp>
+#include <nvvk/compute_pipeline.hpp>
 #include <nvvk/context.hpp>
 #include <nvvk/debug_util.hpp>
 #include <nvvk/default_structs.hpp>
 #include <nvvk/descriptors.hpp>
 #include <nvvk/formats.hpp>
+#include <nvvk/gpu_counters.hpp>
 #include <nvvk/gbuffers.hpp>
 #include <nvvk/graphics_pipeline.hpp>
 #include <nvvk/helpers.hpp>
+#include <nvvk/mipmaps.hpp>
+#include <nvvk/pipeline.hpp>
+#include <nvvk/pipeline_cache.hpp>
+#include <nvvk/pipeline_layout_cache.hpp>
 #include <nvvk/profiler_vk.hpp>
+#include <nvvk/render_graph.hpp>
 #include <nvvk/sampler_pool.hpp>
+#include <nvvk/specialization.hpp>
 #include <nvvk/staging.hpp>
 #include <nvvk/validation_settings.hpp>
 
 // The camera for the scene
 std::shared_ptr<nvutils::CameraManipulator> g_cameraManip{};
 
+// Colors (ARGB) of the CPU ranges seen in Nsight Systems, compiled out without NVTX
+[[maybe_unused]] static constexpr uint32_t kNxColorFrame   = 0xFF76B900;  // Frame setup, UI and pipeline changes
+[[maybe_unused]] static constexpr uint32_t kNxColorCompute = 0xFF2F7FD6;  // Recording of the compute passes
+[[maybe_unused]] static constexpr uint32_t kNxColorDraw    = 0xFFD6592F;  // Recording of the draws
 
 //////////////////////////////////////////////////////////////////////////
 /// Demonstrates mesh and task shaders with grass field rendering
@@ -57,9 +83,98 @@ class MeshShaderGrass : public nvapp::IAppElement
 {
 public:
   glm::vec2 m_windDirection = glm::vec2(1.0f, 0.3f); // 默认风向，可由UI修改
-  MeshShaderGrass()           = default;
+  explicit MeshShaderGrass(nvutils::ProfilerManager* profilerManager)
+      : m_profilerManager(profilerManager)
+  {
+  }
   ~MeshShaderGrass() override = default;
 
+  // Settings that can be given on the command line, or changed by the sequences of a benchmark script
+  void registerParameters(nvutils::ParameterRegistry& reg)
+  {
+    auto bakeAgain    = [this](const nvutils::ParameterBase*) { m_terrainDirty = true; };
+    auto rebuildAgain = [this](const nvutils::ParameterBase*) { m_pipelineDirty = true; };
+    auto fieldsAgain  = [this](const nvutils::ParameterBase*) { m_fieldsDirty = true; };
+
+    reg.add({.name = "grassX", .help = "Number of grass blades in X", .callbackSuccess = bakeAgain}, &m_totalGrassX, 1, 1000);
+    reg.add({.name = "grassZ", .help = "Number of grass blades in Z", .callbackSuccess = bakeAgain}, &m_totalGrassZ, 1, 1000);
+    reg.add({.name = "spacing", .help = "Spacing between grass blades", .callbackSuccess = bakeAgain}, &m_spacing, 0.1f, 100.0f);
+    reg.add({"bladeHeight", "Height of the grass blades"}, &m_bladeHeight, 0.1f, 5.0f);
+    reg.add({"wind", "Enable the wind animation"}, &m_animate);
+    reg.add({"windSpeed", "Wind speed multiplier"}, &m_animSpeed, 0.0f, 3.0f);
+    reg.add({"fixedTimeStep", "Seconds the wind and the camera advance each frame, 0 for real time; reproducible benchmark paths"},
+            &m_fixedTimeStep, 0.0f, 1.0f);
+    reg.add({"swayStrength", "Wind sway strength multiplier"}, &m_swayStrength, 0.0f, 2.0f);
+    reg.add({"lod", "Reduce blade segments with the projected size"}, &m_useLod);
+    reg.add({"thinning", "Drop a share of the blades shrinking on screen and widen the others"}, &m_useThinning);
+    reg.addVector({"thinPixelHeight", "Projected blade height (px) where the thinning starts (x) and ends (y)"}, &m_thinPixelHeight,
+                  glm::vec2(0.0f), glm::vec2(1000.0f));
+    reg.add({"thinMinKeep", "Fraction of the blades kept by the thinning at the smallest projected size"}, &m_thinMinKeep, 0.05f, 1.0f);
+    reg.add({"densityBudget", "Scale the blade density and LODs each frame so the grass draws take the target GPU time"},
+            &m_useDensityBudget);
+    reg.add({"densityBudgetMs", "Target GPU time (ms) of the grass draws for the density budget"}, &m_densityBudgetMs, 0.1f, 100.0f);
+    reg.add({.name = "bladeCache", .help = "Cache the blade attributes in the mesh shader", .callbackSuccess = rebuildAgain}, &m_useBladeCache);
+    reg.add({.name = "compactOutput", .help = "Compact mesh shader outputs", .callbackSuccess = rebuildAgain}, &m_useCompactOutput);
+    reg.add({.name = "shadingRate", .help = "Coarser fragment shading rate for distant blades and blade tips", .callbackSuccess = rebuildAgain},
+            &m_useShadingRate);
+    reg.add({.name = "half", .help = "Evaluate the blade shading math in fp16", .callbackSuccess = rebuildAgain}, &m_useHalf);
+    reg.add({.name = "debugView", .help = "Grass debug view: 0 off, 1 LOD, 2 mesh workgroup fill, 3 task workgroup, 4 task culling",
+             .callbackSuccess = rebuildAgain},
+            &m_debugView, int(shaderio::eDebugViewNone), int(shaderio::eDebugViewTaskCulling));
+    reg.add({"freezeCulling", "Keep the culling frustum of the camera at the time of freezing while the camera moves"}, &m_freezeCulling);
+    reg.addVector({"shadingRateDistance", "Blade distance beyond which 2x2 (x) and 4x4 (y) shading is used"}, &m_shadingRateDistance,
+                  glm::vec2(0.0f), glm::vec2(10000.0f));
+    reg.add({.name = "infinite", .help = "Infinite meadow following the camera", .callbackSuccess = bakeAgain}, &m_infiniteGrass);
+    reg.add({"bakedTerrain", "Sample the baked terrain map"}, &m_useBakedTerrain);
+    reg.add({"virtualTerrain", "Baked terrain from pages generated around the camera instead of the map of the grid"}, &m_useVirtualTerrain);
+    reg.add({"virtualTerrainRadius", "Pages of the virtual terrain kept resident around the camera"}, &m_virtualRadius, 1,
+            kVirtualTerrainMaxRadius);
+    reg.add({"placementBuffer", "Read the blade placement from a baked buffer instead of hashing it"}, &m_usePlacementBuffer);
+    reg.add({"windMap", "Evaluate the wind once per frame into a texture sampled by the blades"}, &m_useWindMap);
+    reg.add({"trample", "Flatten the grass around moving interactors"}, &m_useTrample);
+    reg.add({"ground", "Draw the terrain surface under the grass"}, &m_showGround);
+    reg.add({"trampleWalkers", "Number of interactors walking across the grid"}, &m_trampleWalkers, 0,
+            int(shaderio::TRAMPLE_MAX_INTERACTORS) - 1);
+    reg.add({"tileCulling", "Frustum cull patch tiles in a compute prepass"}, &m_useTileCulling);
+    reg.add({.name = "taskWorkgroupSize", .help = "Task shader threads, 0 for the subgroup size; larger workgroups span several subgroups",
+             .callbackSuccess = rebuildAgain},
+            &m_taskWorkgroupSize, 0, int(kMaxTaskWorkgroupSize));
+    reg.add({"globalCompaction", "Cull all the patches in a compute pass and draw them in full mesh workgroups without task shader"},
+            &m_useGlobalCompaction);
+    reg.add({"vertexFallback", "Draw the grass with the compute and vertex shader fallback of the devices without mesh shaders"},
+            &m_useVertexFallback);
+    reg.add({"comparePaths", "Alternate the mesh shader and the vertex shader paths and average the GPU time of each"}, &m_comparePaths);
+    reg.add({"renderScale", "Rendered fraction of the viewport width and height, upscaled to the viewport"}, &m_renderScale,
+            kMinRenderScale, 1.0f);
+    reg.add({"dynamicResolution", "Scale the rendered resolution each frame so the draws take the target GPU time"},
+            &m_useDynamicResolution);
+    reg.add({"resolutionBudgetMs", "Target GPU time (ms) of the draws for the dynamic resolution"}, &m_resolutionBudgetMs, 0.1f, 100.0f);
+    reg.add({"upscaleSharpness", "Sharpening of the upscaled frame, 0 for bilinear"}, &m_upscaleSharpness, 0.0f, 1.0f);
+    reg.add({.name = "fields", .help = "Number of extra grass fields around the grid", .callbackSuccess = fieldsAgain}, &m_fieldCount, 0,
+            int(shaderio::FIELD_MAX_COUNT));
+    reg.add({"tightBounds", "Cull patches with the baked terrain height range"}, &m_useTightBounds);
+    reg.add({"occlusion", "Two-phase occlusion culling against the depth pyramid"}, &m_useOcclusion);
+    reg.add({"temporalCulling", "Occlusion phase 1 draws the patches visible last frame without testing them"}, &m_useTemporalCulling);
+    reg.add({"shadows", "Cascaded shadow maps of the grass"}, &m_useShadows);
+    reg.add({.name = "multiview", .help = "0: single view, 1: stereo pair, 2: six cube faces", .callbackSuccess = rebuildAgain},
+            &m_multiviewMode, 0, 2);
+    reg.add({"shadowCascades", "Number of shadow cascades"}, &m_shadowCascades, 1, int(shaderio::SHADOW_MAX_CASCADES));
+    reg.add({"shadowDistance", "View depth covered by the shadow cascades"}, &m_shadowDistance, 1.0f, 10000.0f);
+    reg.add({"pipelineCache", "File keeping the compiled pipelines between launches, empty to disable"}, &m_pipelineCacheFile);
+    reg.add({"shaderCache", "Directory keeping the compiled SPIR-V between launches, empty to disable"}, &m_shaderCacheDirectory);
+    reg.add({"releaseShaders", "Compile the shaders with full optimization and no debug information"}, &m_releaseShaders, true);
+    reg.add({"asyncShaders", "Render with the nearest compiled shader variant while the selected one compiles, disable for benchmarks"},
+            &m_asyncShaders);
+    reg.add({"autoTuneMesh", "Time the mesh workgroup configurations at startup and keep the fastest for this device"},
+            &m_autoTuneOnStart, true);
+  }
+
+  // Counters of the last completed frame, nullptr until a frame completed
+  const shaderio::Statistics* getStatistics() const
+  {
+    return m_statsCounters.hasData() ? &m_statsCounters.get<shaderio::Statistics>() : nullptr;
+  }
+
   void onAttach(nvapp::Application* app) override
   {
     m_app    = app;
@@ -77,8 +192,12 @@ public:
 
     m_depthFormat = nvvk::findDepthFormat(app->getPhysicalDevice());
 
+    m_occlusionGraph.init(m_allocator.get());
+    createOcclusionGraph();
+
     // Acquiring the sampler which will be used for displaying the GBuffer
     m_samplerPool.init(app->getDevice());
+    m_layoutCache.init(app->getDevice());
     VkSampler linearSampler{};
     NVVK_CHECK(m_samplerPool.acquireSampler(linearSampler));
     NVVK_DBG_NAME(linearSampler);
@@ -92,47 +211,154 @@ public:
         .descriptorPool = m_app->getTextureDescriptorPool(),
     });
 
-    // Setting up the Slang compiler
-    m_slangCompiler.addSearchPaths(nvsamples::getShaderDirs());
-    m_slangCompiler.defaultTarget();
-    m_slangCompiler.defaultOptions();
-    m_slangCompiler.addOption({slang::CompilerOptionName::DebugInformation, {slang::CompilerOptionValueKind::Int, 1}});
-    m_slangCompiler.addOption({slang::CompilerOptionName::Optimization, {slang::CompilerOptionValueKind::Int, 0}});
+    // Upscaled frame of the dynamic resolution, displayed instead of the GBuffer when rendering below the viewport size
+    m_displayBuffer = std::make_unique<nvvk::GBuffer>();
+    m_displayBuffer->init({
+        .allocator      = m_allocator.get(),
+        .colorFormats   = {m_colorFormat},
+        .imageSampler   = linearSampler,
+        .descriptorPool = m_app->getTextureDescriptorPool(),
+    });
+
+    // Setting up the Slang compilers
+    auto setupCompiler = [this](nvslang::SlangCompiler& compiler) {
+      compiler.addSearchPaths(nvsamples::getShaderDirs());
+      compiler.defaultTarget();
+      compiler.defaultOptions();
+      if(m_releaseShaders)
+      {
+        compiler.releaseOptions();
+      }
+      else
+      {
+        compiler.addOption({slang::CompilerOptionName::DebugInformation, {slang::CompilerOptionValueKind::Int, 1}});
+        compiler.addOption({slang::CompilerOptionName::Optimization, {slang::CompilerOptionValueKind::Int, 0}});
+      }
+      // Unchanged shaders are loaded from the previous compilation
+      compiler.setCacheDirectory(m_shaderCacheDirectory);
+    };
+    setupCompiler(m_slangCompiler);
+
+#if USE_SLANG && MULTI_ENTRY_POINTS
+    // The variants of the grass shader are compiled in the background when first selected
+    setupCompiler(m_shaderPermutations.getCompiler());
+    m_shaderPermutations.init({
+        .filename          = "mesh_task.slang",
+        .getMacros         = getPermutationMacros,
+        .fallbackMatchMask = kPermutationConfigMask,
+    });
+    m_shaderPermutations.addPrecompiled(getEmbeddedPermutationMask(), mesh_task_slang);
+#endif
 
 
 
 
     createFrameInfoBuffer();
-    createStatisticsBuffer();
-    createPipeline();
+    createQueryPools();
+
+    // GPU timers of the render passes, shown by the profiler element
+    m_profilerTimeline = m_profilerManager->createTimeline({"graphics"});
+    m_profilerGpuTimer.init(m_profilerTimeline, m_device, m_app->getPhysicalDevice(), m_app->getQueue(0).familyIndex, true);
+    createStatisticsBuffer();  // Its counters go to the timeline
+    nvvk::PipelineFeedbackLog::getInstance().setProfilerTimeline(m_profilerTimeline);
+
+    // Driver compilation of the pipelines is skipped when the cache of a previous launch matches the device
+    NVVK_CHECK(m_pipelineCache.init(m_device, m_app->getPhysicalDevice(), m_pipelineCacheFile));
+    NVVK_DBG_NAME(m_pipelineCache.getPipelineCache());
+
+    // Mesh workgroup configuration found by a previous auto-tuning on this device
+    if(!m_autoTuneOnStart)
+    {
+      loadMeshTuning();
+    }
+
+    createTerrainMap();
+    createVirtualTerrain();
+    createWindMap();
+    createTrampleMap();
+    createShadowMap();
+    createMultiviewTargets();
+    createTileCullingBuffers();
 
     // Setup camera
     g_cameraManip->setClipPlanes({0.1F, 10000.0F});
     g_cameraManip->setLookat({3, 5, -9}, {0, 0, 0}, {0, 1, 0});
   }
 
+  // Shader compilation and pipeline creation run on the thread pool, while the other elements attach.
+  // One task, as the pipelines share the Slang compiler and the layout cache.
+  void onAttachTasks(std::vector<nvapp::AttachTask>& tasks) override
+  {
+    tasks.push_back({"Grass pipelines", [this] {
+                       createPipeline();
+                       createHizPipeline();
+                       createUpscalePipeline();
+                       createVertexPipelines();
+                     }});
+  }
+
+  // Durations and cache hits of the driver compilations of the startup
+  void onAttachTasksDone() override { nvvk::PipelineFeedbackLog::getInstance().logSummary(); }
+
   // Query and validate mesh shader capabilities
   void initMeshShaderProperties(VkPhysicalDevice physicalDevice)
   {
     VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT};
+    VkPhysicalDeviceFragmentShadingRateFeaturesKHR shadingRateFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR};
     VkPhysicalDeviceVulkan11Features device11Features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES};
+    VkPhysicalDeviceVulkan12Features device12Features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    VkPhysicalDeviceVulkan13Features device13Features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
     VkPhysicalDeviceFeatures2        deviceFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
-    meshShaderFeatures.pNext = &device11Features;
-    deviceFeatures.pNext     = &meshShaderFeatures;
+    device12Features.pNext    = &device13Features;
+    device11Features.pNext    = &device12Features;
+    shadingRateFeatures.pNext = &device11Features;
+    meshShaderFeatures.pNext  = &shadingRateFeatures;
+    deviceFeatures.pNext      = &meshShaderFeatures;
     vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures);
 
+    // Mesh shader invocations and primitives can only be queried with both features
+    m_supportsPipelineQueries = meshShaderFeatures.meshShaderQueries && deviceFeatures.features.pipelineStatisticsQuery;
 
     // Query mesh shader properties
+    VkPhysicalDeviceFragmentShadingRatePropertiesKHR shadingRateProps{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_PROPERTIES_KHR};
+    VkPhysicalDeviceVulkan13Properties device13Props{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_PROPERTIES};
     VkPhysicalDeviceProperties2 deviceProps2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
-    m_meshShaderProps.pNext = &m_device11Props;
-    deviceProps2.pNext      = &m_meshShaderProps;
+    shadingRateProps.pNext  = &m_device11Props;
+    m_meshShaderProps.pNext = &shadingRateProps;
+    device13Props.pNext     = &m_meshShaderProps;
+    deviceProps2.pNext      = &device13Props;
     vkGetPhysicalDeviceProperties2(physicalDevice, &deviceProps2);
 
-    // Check if mesh shader is supported
-    if(!meshShaderFeatures.meshShader || !meshShaderFeatures.taskShader)
+    // The mesh shader can only write the shading rate of its primitives with both
+    m_supportsShadingRate = shadingRateFeatures.primitiveFragmentShadingRate && shadingRateProps.primitiveFragmentShadingRateMeshShader;
+    m_useShadingRate      = m_useShadingRate && m_supportsShadingRate;
+
+    // Mesh shaders with a view mask, for all the views of the cube mode
+    m_supportsMultiview = meshShaderFeatures.multiviewMeshShader && device11Features.multiview
+                          && m_device11Props.maxMultiviewViewCount >= shaderio::MULTIVIEW_MAX_VIEWS;
+    m_multiviewMode     = m_supportsMultiview ? m_multiviewMode : 0;
+
+    // fp16 arithmetic for the shading math, and fp16 mesh outputs when the device can also pass them
+    m_supportsHalf             = device12Features.shaderFloat16;
+    m_supportsHalfInterpolants = m_supportsHalf && device11Features.storageInputOutput16;
+    m_useHalf                  = m_useHalf && m_supportsHalf;
+
+    // The task stage then keeps the default subgroup size whatever its workgroup size, which spans a known number of subgroups
+    m_supportsTaskSubgroupSize = device13Features.subgroupSizeControl
+                                 && (device13Props.requiredSubgroupSizeStages & VK_SHADER_STAGE_TASK_BIT_EXT) != 0;
+
+    // Without mesh shaders, the grass is drawn by the vertex shader fallback (see createVertexPipelines)
+    m_supportsMeshShaders = meshShaderFeatures.meshShader && meshShaderFeatures.taskShader;
+    if(!m_supportsMeshShaders)
     {
-      LOGE("Mesh shader or task shader not supported\n");
-      std::exit(0);
+      LOGW("Mesh shader or task shader not supported, using the vertex shader fallback\n");
+      m_grassStages         = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+      m_grassPipelineStages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+      m_supportsShadingRate = false;
+      m_useShadingRate      = false;
+      m_supportsMultiview   = false;
+      m_multiviewMode       = 0;
+      return;
     }
 
     // Calculate optimal workgroup size based on hardware capabilities
@@ -141,9 +367,10 @@ public:
         std::min(128u, std::min(m_meshShaderProps.maxPreferredMeshWorkGroupInvocations,
                                 std::min(m_meshShaderProps.maxMeshWorkGroupSize[0], m_meshShaderProps.maxMeshWorkGroupInvocations)));
 
-    // NOTE: The shader uses a default workgroup size of 32 (defined in shaderio.h) which is optimal for NVIDIA hardware.
-    // To use a different size, it can be overridden via MESHSHADER_WORKGROUP_SIZE macro in CMakeLists.txt EXTRA_FLAGS.
-    // The runtime Slang compiler path uses the calculated meshShaderWorkgroupSize above via macro definition.
+    // NOTE: The workgroup sizes are specialization constants of the shader (defaults in shaderio.h), the pipelines
+    // are specialized with the calculated meshShaderWorkgroupSize above, unless the auto-tuning stored a better
+    // configuration for this device. The pre-compiled SPIR-V serves any size, no shader compilation is needed.
+    m_meshConfig.workgroupSize = meshShaderWorkgroupSize;
 
     LOGI("Mesh Shader Properties:\n");
     LOGI("  Workgroup size: %u\n", meshShaderWorkgroupSize);
@@ -159,26 +386,71 @@ public:
   void onDetach() override
   {
     vkDeviceWaitIdle(m_device);
+    m_shaderPermutations.deinit();
 
     m_allocator->destroyBuffer(m_frameInfo);
-    m_allocator->destroyBuffer(m_readbackDevice);
-    m_allocator->destroyBuffer(m_readbackHost);
-
-    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    m_statsCounters.deinit();
+    nvvk::PipelineFeedbackLog::getInstance().setProfilerTimeline(nullptr);
+    m_profilerGpuTimer.deinit();
+    m_profilerManager->destroyTimeline(m_profilerTimeline);
+    vkDestroyQueryPool(m_device, m_pipelineStatsPool, nullptr);
+    vkDestroyQueryPool(m_device, m_meshPrimitivesPool, nullptr);
+
+    destroyShaderPipelines(getShaderPipelines());
     vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyPipelineLayout(m_device, m_computePipelineLayout, nullptr);
     m_descriptorPack.deinit();
-
-
-
+    m_allocator->destroyImage(m_terrainMap);
+    m_allocator->destroyImage(m_virtualAtlas);
+    m_allocator->destroyBuffer(m_virtualTable);
+    m_allocator->destroyImage(m_windMap);
+    m_allocator->destroyImage(m_trampleMap);
+    m_allocator->destroyBuffer(m_interactors);
+    m_allocator->destroyImage(m_shadowMap);
+    m_allocator->destroyImage(m_multiviewColor);
+    m_allocator->destroyImage(m_multiviewDepth);
+    m_allocator->destroyBuffer(m_tileBounds);
+    m_allocator->destroyBuffer(m_patchBounds);
+    m_allocator->destroyBuffer(m_placement);
+    m_allocator->destroyBuffer(m_visibleTiles);
+    m_allocator->destroyBuffer(m_fieldBuffer);
+    m_allocator->destroyBuffer(m_visibleFields);
+    m_allocator->destroyBuffer(m_compactBlades);
+
+    m_occlusionGraph.deinit();
+    destroyHizPyramid();
+    m_allocator->destroyBuffer(m_visibility);
+    vkDestroyPipeline(m_device, m_hizPipeline, nullptr);
+    vkDestroyPipeline(m_device, m_upscalePipeline, nullptr);
+    vkDestroyPipeline(m_device, m_vertexCullPipeline, nullptr);
+    vkDestroyPipeline(m_device, m_vertexPipeline, nullptr);
+    m_layoutCache.deinit();
+
+    m_pipelineCache.deinit();
     m_samplerPool.deinit();
     m_gBuffers->deinit();
+    m_displayBuffer->deinit();
     m_allocator->deinit();
   }
 
-  void onResize(VkCommandBuffer cmd, const VkExtent2D& size) override { m_gBuffers->update(cmd, size); }
+  void onResize(VkCommandBuffer cmd, const VkExtent2D& size) override
+  {
+    m_gBuffers->update(cmd, size);
+    m_displayBuffer->update(cmd, size);
+
+    // The depth is sampled by the Hi-Z reduction between the two passes, start from a known layout
+    nvvk::cmdImageMemoryBarrier(cmd, {.image            = m_gBuffers->getDepthImage(),
+                                      .oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED,
+                                      .newLayout        = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+                                      .subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1}});
+    m_occlusionDepth.image = m_gBuffers->getDepthImage();
+
+    createHizPyramid(cmd, size);
+  }
 
   void onUIRender() override
   {
+    NXPROFILEFUNCCOL(__FUNCTION__, kNxColorFrame);
     if(!m_gBuffers)
       return;
 
@@ -189,15 +461,119 @@ public:
       ImGui::Separator();
       ImGui::Text("Mesh Shader Parameters");
 
-      // Calculate safe maximums based on hardware limits
-      // Each task workgroup tests BOXES_PER_TASK grass blades (one per thread), so multiply by BOXES_PER_TASK
-      int maxGrassX = std::min(1000, static_cast<int>(m_meshShaderProps.maxTaskWorkGroupCount[0] * shaderio::BOXES_PER_TASK));
-      int maxGrassZ = std::min(1000, static_cast<int>(m_meshShaderProps.maxTaskWorkGroupCount[1]));
+      // The grid is split into several draws when it exceeds the hardware dispatch limits,
+      // the maximum is the resolution covered by the baked terrain map
+      int maxGrassX = 1000;
+      int maxGrassZ = 1000;
 
-      ImGui::SliderInt("Grass Blades X", &m_totalGrassX, 1, maxGrassX);
-      ImGui::SliderInt("Grass Blades Z", &m_totalGrassZ, 1, maxGrassZ);
+      // The baked terrain depends on the grid and the spacing
+      m_terrainDirty |= ImGui::SliderInt("Grass Blades X", &m_totalGrassX, 1, maxGrassX);
+      m_terrainDirty |= ImGui::SliderInt("Grass Blades Z", &m_totalGrassZ, 1, maxGrassZ);
       ImGui::SliderFloat("Blade Height", &m_bladeHeight, 0.1f, 5.0f);
-      ImGui::SliderFloat("Spacing", &m_spacing, 0.1f, 100.0f);
+      m_terrainDirty |= ImGui::SliderFloat("Spacing", &m_spacing, 0.1f, 100.0f);
+      m_terrainDirty |= ImGui::Checkbox("Infinite Meadow", &m_infiniteGrass);
+      ImGui::SetItemTooltip("The grid follows the camera over an endless field of world cells,\n"
+                            "only the cells entering the grid are baked when the camera moves");
+      if(m_infiniteGrass)
+      {
+        ImGui::SliderInt("Ring Width (cells)", &m_ringCells, 8, 500);
+        ImGui::SliderFloat("Ring Density", &m_ringDensity, 0.1f, 1.0f, "%.2f");
+        ImGui::SetItemTooltip("Fraction of the blades each ring around the camera keeps from the previous one");
+      }
+      ImGui::Checkbox("Baked Terrain", &m_useBakedTerrain);
+      ImGui::SetItemTooltip("Sample terrain height and grass height from a texture baked when the grid changes,\n"
+                            "instead of evaluating the noise for every patch and vertex");
+      if(m_useBakedTerrain)
+      {
+        ImGui::Checkbox("Virtual Terrain", &m_useVirtualTerrain);
+        ImGui::SetItemTooltip("Sample pages of %u x %u cells generated around the camera, on the async compute queue\n"
+                              "with --asyncCompute, instead of the map of the grid. The other pages evaluate the noise.",
+                              shaderio::VIRTUAL_TERRAIN_PAGE_CELLS, shaderio::VIRTUAL_TERRAIN_PAGE_CELLS);
+        if(m_useVirtualTerrain)
+        {
+          ImGui::SliderInt("Page Radius", &m_virtualRadius, 1, kVirtualTerrainMaxRadius);
+          ImGui::SliderInt("Pages per Frame", &m_virtualPagesPerFrame, 1, 64);
+          ImGui::Text("Resident pages: %zu / %u", m_virtualPages.size(), shaderio::VIRTUAL_TERRAIN_MAX_PAGES);
+        }
+      }
+      ImGui::Checkbox("Placement Buffer", &m_usePlacementBuffer);
+      ImGui::SetItemTooltip("Load the blade offset, rotation and height baked with the terrain (8 bytes per blade)\n"
+                            "instead of hashing them in the task and mesh shaders");
+      ImGui::BeginDisabled(m_groundPipeline == VK_NULL_HANDLE);
+      ImGui::Checkbox("Ground", &m_showGround);
+      ImGui::SetItemTooltip("Draw the terrain as a quadtree of task/mesh shader patches, frustum culled per node\n"
+                            "and split by distance to the camera. Not drawn in multiview.");
+      if(m_showGround)
+      {
+        ImGui::SliderFloat("Ground LOD Range", &m_groundLodRange, 2.5f, 8.0f, "%.1f");
+        ImGui::SetItemTooltip("Nodes closer than this many times their size are split in four");
+      }
+      ImGui::EndDisabled();
+      m_fieldsDirty |= ImGui::SliderInt("Extra Fields", &m_fieldCount, 0, int(shaderio::FIELD_MAX_COUNT));
+      ImGui::SetItemTooltip("Meadows of their own size, density, blade height and wind around the grid, frustum culled per field\n"
+                            "and all drawn by one indirect draw. Procedural terrain and wind, no trampling, no shadows.");
+      ImGui::Checkbox("Wind Map", &m_useWindMap);
+      ImGui::SetItemTooltip("Evaluate the wind once per frame into a %ux%u texture over the grid,\n"
+                            "each blade does one bilinear fetch instead of evaluating the waves",
+                            shaderio::WIND_MAP_SIZE, shaderio::WIND_MAP_SIZE);
+      ImGui::Checkbox("Tight Patch Bounds", &m_useTightBounds);
+      ImGui::SetItemTooltip("Cull each patch with a box built from the baked terrain height range under its blade\n"
+                            "instead of a sphere with a fixed margin for the terrain variation");
+      ImGui::Checkbox("Tile Culling", &m_useTileCulling);
+      ImGui::SetItemTooltip("Frustum cull tiles of %u x %u patches in a compute prepass and\n"
+                            "launch task workgroups for the visible tiles only",
+                            m_pipelineTaskSize, shaderio::TILE_ROWS);
+      ImGui::BeginDisabled(m_compactPipeline == VK_NULL_HANDLE);
+      ImGui::Checkbox("Global Compaction", &m_useGlobalCompaction);
+      ImGui::EndDisabled();
+      ImGui::SetItemTooltip("Cull all the patches in a compute pass into one list per LOD, then draw them with a single\n"
+                            "indirect dispatch of full mesh workgroups without task shader, instead of the partly\n"
+                            "filled workgroups of each task workgroup. Not with occlusion culling, which needs the\n"
+                            "task shader. Requires the multi entry point shader.");
+
+      ImGui::Separator();
+      ImGui::Text("Vertex Shader Fallback");
+      if(!m_supportsMeshShaders)
+      {
+        ImGui::TextDisabled("No mesh shaders on this device, the fallback draws the grass");
+      }
+      ImGui::BeginDisabled(!m_supportsMeshShaders || m_vertexPipeline == VK_NULL_HANDLE);
+      ImGui::Checkbox("Vertex Fallback", &m_useVertexFallback);
+      ImGui::SetItemTooltip("Cull all the patches in a compute pass into one list per LOD, then draw each LOD with an\n"
+                            "indirect draw of one instance per blade, the vertices pulled from the list by the vertex\n"
+                            "shader. The path of the devices without mesh shaders, which also lack the baked maps,\n"
+                            "wind map, trampling, fields, shadows, ground and occlusion culling. Camera view only.");
+      if(ImGui::Checkbox("Compare Paths", &m_comparePaths))
+      {
+        m_pathTimings[0] = {};
+        m_pathTimings[1] = {};
+      }
+      ImGui::SetItemTooltip("Alternate both paths every %u frames and average their GPU times", kPathCompareFrames);
+      ImGui::EndDisabled();
+      if(m_comparePaths && ImGui::BeginTable("PathComparison", 4, ImGuiTableFlags_BordersInnerV))
+      {
+        ImGui::TableSetupColumn("Path");
+        ImGui::TableSetupColumn("Cull (ms)");
+        ImGui::TableSetupColumn("Draw (ms)");
+        ImGui::TableSetupColumn("Total (ms)");
+        ImGui::TableHeadersRow();
+        const char* pathNames[2] = {"Mesh Shader", "Vertex Shader"};
+        for(uint32_t path = 0; path < 2; path++)
+        {
+          const PathTiming& timing = m_pathTimings[path];
+          const double      frames = std::max(timing.frames, 1u);
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(pathNames[path]);
+          ImGui::TableNextColumn();
+          ImGui::Text("%.3f", timing.cullMs / frames);
+          ImGui::TableNextColumn();
+          ImGui::Text("%.3f", timing.drawMs / frames);
+          ImGui::TableNextColumn();
+          ImGui::Text("%.3f", (timing.cullMs + timing.drawMs) / frames);
+        }
+        ImGui::EndTable();
+      }
 
       ImGui::Separator();
       ImGui::Text("Wind Animation");
@@ -214,32 +590,269 @@ public:
         ImGui::TextWrapped("Grass sways in the wind - watch the natural movement!");
       }
 
+      ImGui::Separator();
+      ImGui::Checkbox("Trampling", &m_useTrample);
+      ImGui::SetItemTooltip("Interactors flatten the grass into a trample map updated on the GPU each frame,\n"
+                            "each blade does one fetch whatever the number of interactors");
+      if(m_useTrample)
+      {
+        ImGui::SliderInt("Walkers", &m_trampleWalkers, 0, int(shaderio::TRAMPLE_MAX_INTERACTORS) - 1);
+        ImGui::Checkbox("Camera Tramples", &m_trampleCamera);
+        ImGui::SliderFloat("Trample Radius", &m_trampleRadius, 0.1f, 5.0f, "%.2f");
+        ImGui::SliderFloat("Recovery Time (s)", &m_trampleRecovery, 0.1f, 30.0f, "%.1f");
+      }
+
+      ImGui::Separator();
+      // Switching the mesh shader variant recompiles the shaders
+      m_pipelineDirty |= ImGui::Checkbox("Mesh Blade Cache", &m_useBladeCache);
+      ImGui::SetItemTooltip("Compute the per-blade attributes once into groupshared memory (MESH_BLADE_CACHE=1)\n"
+                            "instead of once per vertex. Requires the runtime shader compilation.");
+      m_pipelineDirty |= ImGui::Checkbox("Compact Mesh Outputs", &m_useCompactOutput);
+      ImGui::SetItemTooltip("Output the position and one blade coordinate attribute per vertex and the normal per primitive,\n"
+                            "the fragment shader rebuilds the color (MESH_COMPACT_OUTPUT=1). Requires the runtime shader compilation.");
+      ImGui::BeginDisabled(!m_supportsShadingRate);
+      m_pipelineDirty |= ImGui::Checkbox("Variable Rate Shading", &m_useShadingRate);
+      ImGui::SetItemTooltip("The mesh shader writes a coarser shading rate for the distant blades and the upper half of the blades\n"
+                            "(MESH_SHADING_RATE=1). Requires primitiveFragmentShadingRate with mesh shaders and the runtime shader compilation.");
+      if(m_useShadingRate)
+      {
+        ImGui::SliderFloat2("2x2 / 4x4 Distance", &m_shadingRateDistance.x, 1.0f, 200.0f, "%.1f");
+        m_shadingRateDistance.y = std::max(m_shadingRateDistance.y, m_shadingRateDistance.x);
+      }
+      ImGui::EndDisabled();
+      ImGui::BeginDisabled(!m_supportsHalf);
+      m_pipelineDirty |= ImGui::Checkbox("Half Precision", &m_useHalf);
+      ImGui::SetItemTooltip("Evaluate the blade taper, wind offset, color and lighting in fp16 (MESH_HALF=1), and pass the\n"
+                            "mesh outputs other than the position as fp16 when storageInputOutput16 is supported\n"
+                            "(MESH_HALF_INTERPOLANTS=1). Requires shaderFloat16 and the runtime shader compilation.");
+      ImGui::EndDisabled();
+      ImGui::BeginDisabled(!MULTI_ENTRY_POINTS);
+      const int taskSizes[]   = {0, 32, 64, 128};
+      int       taskSizeIndex = int(std::find(std::begin(taskSizes), std::end(taskSizes), m_taskWorkgroupSize) - std::begin(taskSizes));
+      if(ImGui::Combo("Task Workgroup", &taskSizeIndex, "Subgroup Size\0" "32 Threads\0" "64 Threads\0" "128 Threads\0"))
+      {
+        m_taskWorkgroupSize = taskSizes[taskSizeIndex];
+        m_pipelineDirty     = true;
+      }
+      ImGui::SetItemTooltip("Patches tested by each task workgroup (TASKSHADER_WORKGROUP_SIZE). Above the subgroup size the\n"
+                            "surviving patches are compacted across the subgroups with groupshared atomics: fewer, fuller\n"
+                            "task workgroups and mesh dispatches. Requires the runtime shader compilation.");
+      ImGui::EndDisabled();
+      ImGui::Text("Task Workgroup: %u threads, subgroups of %u%s", m_pipelineTaskSize, m_device11Props.subgroupSize,
+                  m_supportsTaskSubgroupSize ? " (required)" : "");
+      ImGui::Text("Mesh Workgroup: %u blades, %u threads", m_meshConfig.bladesPerMesh, m_meshConfig.workgroupSize);
+      if(m_tuning.active)
+      {
+        ImGui::Text("Auto-tuning %zu / %zu...", m_tuning.current + 1, m_tuning.candidates.size());
+      }
+      else
+      {
+        ImGui::BeginDisabled(!MULTI_ENTRY_POINTS);
+        if(ImGui::Button("Auto-Tune Mesh Workgroup"))
+        {
+          startMeshTuning();
+        }
+        ImGui::EndDisabled();
+        ImGui::SetItemTooltip("Times the grass draws with each blades per mesh workgroup and thread count\n"
+                              "fitting the device limits, then keeps the fastest for this device");
+      }
+
+      ImGui::Separator();
+      ImGui::Text("Blade LOD");
+      ImGui::Checkbox("Enable LOD", &m_useLod);
+      if(m_useLod)
+      {
+        ImGui::SliderFloat("2 Segments Below (px)", &m_lodPixelHeight.x, 1.0f, 200.0f, "%.0f");
+        ImGui::SliderFloat("1 Segment Below (px)", &m_lodPixelHeight.y, 1.0f, m_lodPixelHeight.x, "%.0f");
+      }
+      ImGui::Checkbox("Distance Thinning", &m_useThinning);
+      ImGui::SetItemTooltip("Drop a stable random share of the blades shrinking on screen,\n"
+                            "the kept blades widen so the coverage of the field stays the same");
+      if(m_useThinning)
+      {
+        ImGui::SliderFloat("Thinning Starts (px)", &m_thinPixelHeight.x, 1.0f, 64.0f, "%.1f");
+        ImGui::SliderFloat("Thinning Ends (px)", &m_thinPixelHeight.y, 0.1f, m_thinPixelHeight.x, "%.1f");
+        ImGui::SliderFloat("Kept Below End", &m_thinMinKeep, 0.05f, 1.0f, "%.2f");
+        ImGui::SetItemTooltip("Fraction of the blades kept when their projected height is below the end,\n"
+                              "falling linearly from 1 at the start");
+      }
+      ImGui::Checkbox("Frame Time Budget", &m_useDensityBudget);
+      ImGui::SetItemTooltip("Lowers the density of all the blades (the kept ones widen) and switches to the coarser LODs\n"
+                            "sooner when the grass draws exceed the target GPU time, and restores them when well below it");
+      if(m_useDensityBudget)
+      {
+        ImGui::SliderFloat("Grass GPU Budget (ms)", &m_densityBudgetMs, 0.5f, 20.0f, "%.1f");
+        ImGui::Text("Density: %.0f%%", m_densityScale * 100.0f);
+      }
+
+      ImGui::Separator();
+      ImGui::Text("Resolution");
+      ImGui::Checkbox("Dynamic Resolution", &m_useDynamicResolution);
+      ImGui::SetItemTooltip("Renders at a scaled resolution following the GPU time of the draws, upscaled to the viewport");
+      if(m_useDynamicResolution)
+      {
+        ImGui::SliderFloat("Draw GPU Budget (ms)", &m_resolutionBudgetMs, 0.5f, 33.0f, "%.1f");
+      }
+      else
+      {
+        ImGui::SliderFloat("Render Scale", &m_renderScale, kMinRenderScale, 1.0f, "%.2f");
+      }
+      ImGui::SliderFloat("Upscale Sharpness", &m_upscaleSharpness, 0.0f, 1.0f, "%.2f");
+      ImGui::Text("Rendered: %u x %u (%.0f%%)", m_gBuffers->getSize().width, m_gBuffers->getSize().height,
+                  m_gBuffers->getRenderScale() * 100.0f);
+
+      ImGui::Separator();
+      ImGui::Checkbox("Occlusion Culling (Hi-Z)", &m_useOcclusion);
+      ImGui::SetItemTooltip("Two-phase culling against a depth pyramid:\n"
+                            "- phase 1 draws what was visible in the previous pyramid\n"
+                            "- phase 2 re-tests the rejected patches against the new one");
+      if(m_useOcclusion)
+      {
+        ImGui::Checkbox("Temporal Coherence", &m_useTemporalCulling);
+        ImGui::SetItemTooltip("Phase 1 draws the patches visible last frame in the frustum without any depth test,\n"
+                              "phase 2 tests all the patches against the pyramid of that depth, draws the newly\n"
+                              "visible ones and keeps the visible set for the next frame");
+      }
+
+      ImGui::Separator();
+      ImGui::BeginDisabled(m_shadowPipeline == VK_NULL_HANDLE);
+      ImGui::Checkbox("Shadows", &m_useShadows);
+      ImGui::SetItemTooltip("Cascaded shadow maps of the sun. A single depth-only pass tests each patch against\n"
+                            "all the cascades and draws it into the layers of the cascades it falls in.\n"
+                            "Requires the multi entry point shader.");
+      if(m_useShadows)
+      {
+        ImGui::SliderInt("Cascades", &m_shadowCascades, 1, int(shaderio::SHADOW_MAX_CASCADES));
+        ImGui::SliderFloat("Shadow Distance", &m_shadowDistance, 5.0f, 500.0f, "%.0f");
+        ImGui::SliderFloat("Split Blend", &m_shadowSplitBlend, 0.0f, 1.0f, "%.2f");
+        ImGui::SetItemTooltip("0: cascades of equal depth, 1: logarithmic cascades");
+      }
+      ImGui::EndDisabled();
+
+      ImGui::Separator();
+      ImGui::BeginDisabled(!m_supportsMultiview || !MULTI_ENTRY_POINTS);
+      m_pipelineDirty |= ImGui::Combo("Multiview", &m_multiviewMode, "Off\0Stereo (2 views)\0Cube (6 views)\0");
+      ImGui::SetItemTooltip("Draws the views in a single dispatch with VK_KHR_multiview, the task shader culls against\n"
+                            "the union of the views. The views are shown side by side, without occlusion culling and shadows.\n"
+                            "Requires multiviewMeshShader and the runtime shader compilation.");
+      if(m_multiviewMode == 1)
+      {
+        ImGui::SliderFloat("Eye Distance", &m_stereoEyeDistance, 0.0f, 1.0f, "%.3f");
+      }
+      ImGui::EndDisabled();
+
+      ImGui::Separator();
+      ImGui::Text("Debug");
+      // Only switching the debug view on or off recompiles the shaders
+      const bool hadDebugView = m_debugView != shaderio::eDebugViewNone;
+      if(ImGui::Combo("Debug View", &m_debugView, "Off\0LOD\0Mesh Workgroup Fill\0Task Workgroup\0Task Culling\0"))
+      {
+        m_pipelineDirty |= (m_debugView != shaderio::eDebugViewNone) != hadDebugView;
+      }
+      ImGui::SetItemTooltip("Colors the blades by the work drawing them (MESH_DEBUG_VIEW=1): their LOD (green, yellow, red),\n"
+                            "the fill of their mesh workgroup, a color per task workgroup, or the fraction of the patches of\n"
+                            "their task workgroup surviving the culling. The heatmaps go from blue (empty) to red (full).\n"
+                            "With the global compaction, the workgroups are the mesh workgroups. Mesh shader path only,\n"
+                            "requires the runtime shader compilation.");
+      ImGui::Checkbox("Freeze Culling", &m_freezeCulling);
+      ImGui::SetItemTooltip("Keep culling against the frustum of the camera at the time of freezing: moving away shows\n"
+                            "what was culled. The LODs, the thinning and the occlusion culling follow the camera.");
+
       // Display stats
       uint32_t totalGrass = m_totalGrassX * m_totalGrassZ;
-      uint32_t workgroupsX = (m_totalGrassX + shaderio::BOXES_PER_TASK - 1) / shaderio::BOXES_PER_TASK;  // ceil(totalGrassX / BOXES_PER_TASK)
+      uint32_t workgroupsX = (m_totalGrassX + m_pipelineTaskSize - 1) / m_pipelineTaskSize;  // ceil(totalGrassX / task workgroup size)
       uint32_t workgroupsZ     = m_totalGrassZ;
       uint64_t totalWorkgroups = static_cast<uint64_t>(workgroupsX) * static_cast<uint64_t>(workgroupsZ);
       ImGui::Separator();
       ImGui::Text("Stats:");
       ImGui::Text("Total Grass Blades: %u x %u = %u", m_totalGrassX, m_totalGrassZ, totalGrass);
-      ImGui::Text("Task Workgroups: %u x %u = %llu (%u blades/wg)", workgroupsX, workgroupsZ, totalWorkgroups, shaderio::BOXES_PER_TASK);
+      ImGui::Text("Task Workgroups: %u x %u = %llu (%u blades/wg)", workgroupsX, workgroupsZ, totalWorkgroups, m_pipelineTaskSize);
       ImGui::Text("Workgroup Limits: %u x %u", m_meshShaderProps.maxTaskWorkGroupCount[0],
                   m_meshShaderProps.maxTaskWorkGroupCount[1]);
       ImGui::Text("Max Total Workgroups: %u", m_meshShaderProps.maxTaskWorkGroupTotalCount);
 
       // Read back the statistics from host buffer to display grass blades drawn
-      shaderio::Statistics* stats = reinterpret_cast<shaderio::Statistics*>(m_readbackHost.mapping);
-      if(stats)
+      if(m_statsCounters.hasData())
       {
+        const shaderio::Statistics* stats = &m_statsCounters.get<shaderio::Statistics>();
         ImGui::Separator();
+        ImGui::Text("Statistics of frame %llu (%llu frames ago)", static_cast<unsigned long long>(m_statsCounters.getSnapshotFrameNumber()),
+                    static_cast<unsigned long long>(m_statsCounters.getFrameNumber() - m_statsCounters.getSnapshotFrameNumber()));
         ImGui::Text("Grass Blades Drawn: %u (%.1f%%)", stats->boxesDrawn, totalGrass > 0 ? (100.0f * stats->boxesDrawn / totalGrass) : 0.0f);
+        if(m_useTightBounds)
+        {
+          // Patches the sphere test would have drawn on top of the frustum survivors
+          uint32_t sphereSurvivors = stats->boxesDrawn + stats->tightBoundsCulled;
+          ImGui::Text("Culled by Tight Bounds: %u (%.1f%% of sphere survivors)", stats->tightBoundsCulled,
+                      sphereSurvivors > 0 ? (100.0f * stats->tightBoundsCulled / sphereSurvivors) : 0.0f);
+        }
+        for(uint32_t lod = 0; lod < shaderio::GRASS_LOD_COUNT; lod++)
+        {
+          uint32_t segments = shaderio::GRASS_SEGMENTS >> lod;
+          ImGui::Text("  LOD %u (%u segments): %u", lod, segments, stats->lodBlades[lod]);
+        }
+        ImGui::Text("Task Workgroups Launched: %u", stats->taskWorkgroups);
+        ImGui::Text("Mesh Workgroups Emitted: %u", stats->meshWorkgroups);
+        ImGui::Text("Mesh Workgroup Fill: %.1f%% (%u blades / %u slots)",
+                    stats->meshBladeSlots > 0 ? (100.0f * stats->meshBlades / stats->meshBladeSlots) : 0.0f, stats->meshBlades,
+                    stats->meshBladeSlots);
+        ImGui::Text("Vertices Emitted: %u", stats->verticesEmitted);
+        ImGui::Text("Primitives Emitted: %u", stats->primitivesEmitted);
+        ImGui::Text("Fragments Shaded: %u", stats->fragmentsShaded);
+        if(m_useTileCulling)
+        {
+          uint32_t numTiles = getTileCount().width * getTileCount().height;
+          ImGui::Text("Visible Tiles: %u / %u", stats->tilesVisible, numTiles);
+        }
+        if(m_infiniteGrass)
+        {
+          ImGui::Text("Grid Origin Cell: %d, %d", m_gridOrigin.x, m_gridOrigin.y);
+          ImGui::Text("Thinned by Rings: %u", stats->ringThinned);
+        }
+        if(m_useThinning)
+        {
+          ImGui::Text("Thinned by Distance: %u", stats->distanceThinned);
+        }
+        if(m_useOcclusion)
+        {
+          ImGui::Text("Occlusion Culled: %u", stats->occlusionCulled);
+          ImGui::Text("Occlusion Rescued: %u", stats->occlusionRescued);
+        }
+      }
+
+      // Pipeline statistics queries around the grass draws
+      ImGui::Separator();
+      ImGui::BeginDisabled(!m_supportsPipelineQueries);
+      ImGui::Checkbox("Pipeline Statistics Queries", &m_usePipelineQueries);
+      ImGui::EndDisabled();
+      ImGui::SetItemTooltip("VK_QUERY_TYPE_PIPELINE_STATISTICS and VK_QUERY_TYPE_MESH_PRIMITIVES_GENERATED_EXT\n"
+                            "(requires the pipelineStatisticsQuery and meshShaderQueries features)");
+      if(m_usePipelineQueries && ImGui::BeginTable("PipelineQueries", 3, ImGuiTableFlags_BordersInnerV))
+      {
+        ImGui::TableSetupColumn("Query");
+        ImGui::TableSetupColumn("Frame");
+        ImGui::TableSetupColumn("Average");
+        ImGui::TableHeadersRow();
+        for(uint32_t i = 0; i < kPipelineQueryCount; i++)
+        {
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(kPipelineQueryNames[i]);
+          ImGui::TableNextColumn();
+          ImGui::Text("%llu", static_cast<unsigned long long>(m_queryFrame[i]));
+          ImGui::TableNextColumn();
+          ImGui::Text("%.0f", m_queryAverage[i]);
+        }
+        ImGui::EndTable();
       }
 
-      // Warning if exceeding total workgroup limit
-      if(totalWorkgroups > m_meshShaderProps.maxTaskWorkGroupTotalCount)
+      // Information when exceeding the workgroup limits
+      VkExtent2D tileSize = getDrawTileSize(workgroupsX, workgroupsZ);
+      if(tileSize.width < workgroupsX || tileSize.height < workgroupsZ)
       {
-        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "WARNING: Exceeds total workgroup limit!");
-        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Dispatch will be scaled down automatically.");
+        uint32_t numDraws = ((workgroupsX + tileSize.width - 1) / tileSize.width) * ((workgroupsZ + tileSize.height - 1) / tileSize.height);
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Exceeds workgroup limits: split in %u draws of %u x %u", numDraws,
+                           tileSize.width, tileSize.height);
       }
 
       ImGui::End();
@@ -249,8 +862,8 @@ public:
       ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0F, 0.0F));
       ImGui::Begin("Viewport");
 
-      // Display the G-Buffer image
-      ImGui::Image(ImTextureID(m_gBuffers->getDescriptorSet()), ImGui::GetContentRegionAvail());
+      // Display the G-Buffer image, blitted into the swapchain when nothing of the UI is beneath it
+      m_app->displayViewportImage(getDisplayBuffer());
 
       ImGui::End();
       ImGui::PopStyleVar();
@@ -260,24 +873,125 @@ public:
   void onUIMenu() override
   {
     bool reloadShader = false;
+    if(ImGui::BeginMenu("Tools"))
+    {
+      reloadShader |= ImGui::MenuItem("Reload Shaders", "F5", false, !m_shaderPermutations.isCompiling());
+      ImGui::EndMenu();
+    }
+    reloadShader |= ImGui::IsKeyPressed(ImGuiKey_F5);
+    m_reloadRequested |= reloadShader;
+  }
+
+  void onPreRender() override
+  {
+    NXPROFILEFUNCCOL(__FUNCTION__, kNxColorFrame);
+    m_profilerTimeline->frameAdvance();
+
+    // The selected permutation or the reloaded shaders are compiled, rendering continues with them
+    if(m_shaderPermutations.update() && !m_pipelineDirty
+       && m_shaderPermutations.get(getPermutationMask(getShaderVariant())).generation != m_shaderGeneration)
+    {
+      swapShaderPipelines(buildShaderPipelines(getShaderCode()));
+    }
+
+    if(m_autoTuneOnStart)
+    {
+      m_autoTuneOnStart = false;
+      startMeshTuning();
+    }
+    if(m_tuning.active)
+    {
+      advanceMeshTuning();
+    }
+    updateDensityBudget();
+    updateRenderScale();
+    updatePathComparison();
+    if(!m_supportsMeshShaders)
+    {
+      disableMeshOnlyFeatures();
+    }
+
+    // The mesh shader variant was changed by a parameter or the UI
+    if(m_pipelineDirty)
+    {
+      NXPROFILEFUNCCOL("Rebuild Pipelines", kNxColorFrame);
+      vkDeviceWaitIdle(m_device);
+      destroyShaderPipelines(getShaderPipelines());
+      createShaderPipelines();
+    }
 
+    // Rendering continues with the current pipelines until the shaders are recompiled
+    if(m_reloadRequested)
+    {
+      m_reloadRequested = false;
+      m_shaderPermutations.recompile();
+    }
+  }
 
+  // Pages of the virtual terrain, overlapping the end of the previous frame on the graphics queue
+  void onRenderCompute(VkCommandBuffer cmd) override
+  {
+    if(useVirtualTerrain())
+    {
+      NXPROFILEFUNCCOL("Virtual Terrain", kNxColorCompute);
+      updateVirtualTerrain(cmd, m_app->getFrameCycleIndex());
+    }
   }
 
   void onRender(VkCommandBuffer cmd) override
   {
+    NXPROFILEFUNCCOL(__FUNCTION__, kNxColorFrame);
     NVVK_DBG_SCOPE(cmd);
 
+    uint32_t frameSlot = m_app->getFrameCycleIndex();
+    m_frameNumber++;
+    m_frameInfoOffset = uint32_t(frameSlot * m_frameInfoStride);
 
-    // Update animation time
+    // Update animation time, the camera transitions follow the same clock
+    if(g_cameraManip->getFixedTimeStep() != double(m_fixedTimeStep))
+    {
+      g_cameraManip->setFixedTimeStep(m_fixedTimeStep);
+    }
     if(m_animate)
     {
-      m_time += ImGui::GetIO().DeltaTime * m_animSpeed;
+      m_time += (m_fixedTimeStep > 0.0f ? m_fixedTimeStep : ImGui::GetIO().DeltaTime) * m_animSpeed;
+    }
+
+    // The infinite meadow grid is centered on the cell of the camera
+    if(m_infiniteGrass)
+    {
+      glm::vec3 eye = g_cameraManip->getEye();
+      m_gridOrigin  = glm::ivec2(glm::round(glm::vec2(eye.x, eye.z) / m_spacing)) - glm::ivec2(m_totalGrassX, m_totalGrassZ) / 2;
+    }
+
+    // Bake the terrain and the tile bounds before the shaders use them, with the compute passes of the mesh shader module
+    if(m_supportsMeshShaders && (m_terrainDirty || (m_infiniteGrass && m_gridOrigin != m_bakedOrigin)))
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Terrain Bake");
+      NXPROFILEFUNCCOL("Terrain Bake", kNxColorCompute);
+      bakeTerrain(cmd);
+      m_terrainDirty = false;
+      m_bakedOrigin  = m_gridOrigin;
+    }
+
+    // Without async compute, the pages of the virtual terrain are generated here
+    if(useVirtualTerrain() && !m_app->hasAsyncCompute())
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Virtual Terrain");
+      NXPROFILEFUNCCOL("Virtual Terrain", kNxColorCompute);
+      if(updateVirtualTerrain(cmd, frameSlot) > 0)
+      {
+        nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, m_grassPipelineStages | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+      }
     }
 
-    // Clear device statistics buffer at the start of each frame
-    vkCmdFillBuffer(cmd, m_readbackDevice.buffer, 0, sizeof(shaderio::Statistics), 0);
-    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT);
+    // Pick up the statistics of the frame previously recorded in this slot, which has completed,
+    // then clear the device statistics buffer for this frame
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Stats Clear");
+      NXPROFILEFUNCCOL("Stats Clear", kNxColorCompute);
+      m_statsCounters.cmdBeginFrame(cmd, frameSlot, m_grassPipelineStages | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+    }
 
     // Update Frame buffer uniform buffer
     shaderio::FrameInfo finfo{};
@@ -285,11 +999,85 @@ public:
     finfo.proj   = g_cameraManip->getPerspectiveMatrix();
     finfo.camPos = g_cameraManip->getEye();
 
-    // Calculate frustum planes from view-projection matrix
-    calculateFrustumPlanes(finfo.view, finfo.proj, finfo.frustumPlanes);
+    // Calculate frustum planes from view-projection matrix, of the camera at the time of freezing the culling
+    if(!m_freezeCulling)
+    {
+      m_cullView = finfo.view;
+      m_cullProj = finfo.proj;
+    }
+    calculateFrustumPlanes(m_cullView, m_cullProj, finfo.frustumPlanes);
+
+    finfo.hizSize   = {m_hizSize.width, m_hizSize.height};
+    finfo.hizLevels = m_hizImage.mipLevels;
+
+    // proj[1][1] is 1/tan(fovy/2): half the viewport height covers that many units at distance 1
+    finfo.pixelsPerUnit = std::abs(finfo.proj[1][1]) * 0.5f * float(m_gBuffers->getSize().height);
+
+    finfo.ringCells   = static_cast<uint32_t>(m_ringCells);
+    finfo.ringDensity = m_ringDensity;
+
+    finfo.shadingRateDistance = m_shadingRateDistance;
+
+    finfo.viewProjInv  = glm::inverse(finfo.proj * finfo.view);
+    finfo.viewportSize = glm::vec2(m_gBuffers->getSize().width, m_gBuffers->getSize().height);
+    computeMultiviews(finfo);
+    computeShadowCascades(finfo);
+
+    if(useVirtualTerrain())
+    {
+      const size_t tableSlotSize = sizeof(int32_t) * shaderio::VIRTUAL_TERRAIN_TABLE_SIZE * shaderio::VIRTUAL_TERRAIN_TABLE_SIZE;
+      finfo.virtualTerrainOrigin    = m_virtualOrigin;
+      finfo.virtualTerrainTableAddr = VkDeviceAddress(m_virtualTable.address + frameSlot * tableSlotSize);
+    }
+
+    // Grass parameters shared by all the passes of the frame
+    finfo.statisticsAddr = m_statsCounters.getDeviceAddress();
+    finfo.time           = m_time;
+    finfo.animSpeed      = m_animSpeed;
+    finfo.swayStrength   = m_swayStrength;
+    // 新增风向参数，默认值为(1.0f, 0.3f)，可由UI修改
+    finfo.windDirection  = m_windDirection;
+    // The density budget also biases the LODs, coarser at the same projected size
+    finfo.lodPixelHeight    = m_useLod ? m_lodPixelHeight / m_densityScale : glm::vec2(0.0f);
+    finfo.thinPixelHeight   = m_useThinning ? m_thinPixelHeight : glm::vec2(0.0f);
+    finfo.thinMinKeep       = m_thinMinKeep;
+    finfo.densityScale      = m_densityScale;
+    finfo.placementAddr     = VkDeviceAddress(m_placement.address);
+    finfo.tileBoundsAddr    = VkDeviceAddress(m_tileBounds.address);
+    finfo.visibleTilesAddr  = VkDeviceAddress(m_visibleTiles.address);
+    finfo.compactBladesAddr = VkDeviceAddress(m_compactBlades.address);
+    finfo.patchBoundsAddr   = VkDeviceAddress(m_patchBounds.address);
+    finfo.groundLodRange    = m_groundLodRange;
+    finfo.debugView         = uint32_t(m_debugView);
+    finfo.fieldCount        = uint32_t(m_fieldCount);
+    finfo.fieldsAddr        = VkDeviceAddress(m_fieldBuffer.address);
+    finfo.visibleFieldsAddr = VkDeviceAddress(m_visibleFields.address);
+    if(m_useTrample)
+    {
+      writeInteractors(finfo, frameSlot);
+    }
+
+    // The vertex shader fallback culls all the patches in a compute pass, and draws one instance per blade
+    const bool useVertexPath = isVertexPathActive();
+
+    // Draw using mesh shaders - launch a 2D grid of task shader workgroups
+    // Each task workgroup tests one grass patch per thread, so dispatch ceil(totalGrassX / task workgroup size) workgroups
+    uint32_t workgroupsX = (m_totalGrassX + m_pipelineTaskSize - 1) / m_pipelineTaskSize;  // ceil division
+    uint32_t workgroupsZ = m_totalGrassZ;
+
+    // The depth pyramid is of the camera view, and tested by the task shader
+    const bool useOcclusion = m_useOcclusion && m_pipelineViewCount == 1 && !useVertexPath;
+
+    // One set of occlusion bits per task workgroup of the grid (VISIBILITY_WORDS_PER_TASK of the pipeline)
+    if(useOcclusion)
+    {
+      uint32_t wordsPerTask = (m_pipelineTaskSize + 31) / 32;
+      ensureVisibilityBuffer(VkDeviceSize(workgroupsX) * workgroupsZ * wordsPerTask * sizeof(uint32_t));
+      finfo.visibilityAddr = VkDeviceAddress(m_visibility.address);
+    }
 
-    vkCmdUpdateBuffer(cmd, m_frameInfo.buffer, 0, sizeof(shaderio::FrameInfo), &finfo);
-    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT);
+    // The slot of this frame in flight is no longer read by the GPU, the host write is visible at submission
+    std::memcpy(m_frameInfo.mapping + m_frameInfoOffset, &finfo, sizeof(shaderio::FrameInfo));
 
     // Rendering to the GBuffer
     VkRenderingAttachmentInfo colorAttachment = DEFAULT_VkRenderingAttachmentInfo;
@@ -298,6 +1086,7 @@ public:
     colorAttachment.loadOp                    = VK_ATTACHMENT_LOAD_OP_CLEAR;
     VkRenderingAttachmentInfo depthAttachment = DEFAULT_VkRenderingAttachmentInfo;
     depthAttachment.imageView                 = m_gBuffers->getDepthImageView();
+    depthAttachment.imageLayout               = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
     depthAttachment.clearValue                = {.depthStencil = DEFAULT_VkClearDepthStencilValue};
 
     // Create the rendering info
@@ -307,65 +1096,193 @@ public:
     renderingInfo.pColorAttachments    = &colorAttachment;
     renderingInfo.pDepthAttachment     = &depthAttachment;
 
+    // Layout transitions of the render targets, recorded together
+    nvvk::BarrierContainer targetBarriers;
+
+    // Multiview: all the views into the layers of the multiview target, copied side by side into the GBuffer at the end
+    if(m_pipelineViewCount > 1)
+    {
+      const VkImageSubresourceRange colorRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, shaderio::MULTIVIEW_MAX_VIEWS};
+      const VkImageSubresourceRange depthRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, shaderio::MULTIVIEW_MAX_VIEWS};
+      targetBarriers.appendImageMemoryBarrier({m_multiviewColor.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, colorRange});
+      targetBarriers.appendImageMemoryBarrier({m_multiviewDepth.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, depthRange});
+
+      colorAttachment.imageView = m_multiviewColor.descriptor.imageView;
+      depthAttachment.imageView = m_multiviewDepth.descriptor.imageView;
+      renderingInfo.renderArea  = DEFAULT_VkRect2D(VkExtent2D{kMultiviewSize, kMultiviewSize});
+      renderingInfo.viewMask    = (1u << m_pipelineViewCount) - 1;
+    }
+
     // Allow to render to the GBuffer
-    nvvk::cmdImageMemoryBarrier(cmd, {m_gBuffers->getColorImage(), VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+    targetBarriers.appendImageMemoryBarrier({m_gBuffers->getColorImage(), VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+    targetBarriers.cmdFlush(cmd);
 
-    // Start the rendering
-    vkCmdBeginRendering(cmd, &renderingInfo);
+    // Push constants, what differs between the passes of the frame
+    shaderio::PushConstant pushConst{};
+    pushConst.totalBoxesX        = static_cast<uint32_t>(m_totalGrassX);
+    pushConst.totalBoxesZ        = static_cast<uint32_t>(m_totalGrassZ);
+    pushConst.boxSize            = m_bladeHeight;
+    pushConst.spacing            = m_spacing;
+    pushConst.useBakedTerrain    = m_useBakedTerrain ? 1 : 0;
+    pushConst.usePlacementBuffer = m_usePlacementBuffer ? 1 : 0;
+    pushConst.useTileCulling     = m_useTileCulling ? 1 : 0;
+    pushConst.useTightBounds     = m_useTightBounds ? 1 : 0;
+    pushConst.gridOrigin         = m_gridOrigin;
+    pushConst.infiniteGrass      = m_infiniteGrass ? 1 : 0;
+    pushConst.useWindMap         = m_useWindMap ? 1 : 0;
+    pushConst.useTrample         = m_useTrample ? 1 : 0;
+
+    // Wind of this frame, sampled by the shadow and grass passes
+    if(m_useWindMap)
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Wind Map");
+      NXPROFILEFUNCCOL("Wind Map", kNxColorCompute);
+      updateWindMap(cmd, pushConst);
+    }
 
-    m_graphicState.cmdSetViewportAndScissor(cmd, m_app->getViewportSize());
+    // Flattening of the grass by the interactors of this frame
+    if(m_useTrample)
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Trample Map");
+      NXPROFILEFUNCCOL("Trample Map", kNxColorCompute);
+      updateTrampleMap(cmd, pushConst);
+    }
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 0, nullptr);
+    if(useVertexPath)
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Vertex Cull");
+      NXPROFILEFUNCCOL("Vertex Cull", kNxColorCompute);
+      cullVertexBlades(cmd, pushConst);
+    }
 
-    // Push constants
-    shaderio::PushConstant pushConst{};
-    pushConst.totalBoxesX    = static_cast<uint32_t>(m_totalGrassX);
-    pushConst.totalBoxesZ    = static_cast<uint32_t>(m_totalGrassZ);
-    pushConst.boxSize        = m_bladeHeight;
-    pushConst.spacing        = m_spacing;
-    pushConst.statisticsAddr = VkDeviceAddress(m_readbackDevice.address);
-    pushConst.time           = m_time;
-    pushConst.animSpeed      = m_animSpeed;
-    pushConst.swayStrength   = m_swayStrength;
-    // 新增风向参数，默认值为(1.0f, 0.3f)，可由UI修改
-    pushConst.windDirection  = m_windDirection;
-    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, 0,
-                       sizeof(shaderio::PushConstant), &pushConst);
+    // The global compaction replaces the task shader culling, which the occlusion passes need
+    const bool useCompaction = m_useGlobalCompaction && m_compactPipeline != VK_NULL_HANDLE && !useVertexPath
+                               && !(m_useOcclusion && m_pipelineViewCount == 1);
+    if(useCompaction)
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Blade Compaction");
+      NXPROFILEFUNCCOL("Blade Compaction", kNxColorCompute);
+      compactBlades(cmd, pushConst);
+    }
 
-    // Draw using mesh shaders - launch a 2D grid of task shader workgroups
-    // Each task workgroup tests up to BOXES_PER_TASK grass blades (1 per thread), so dispatch ceil(totalGrassX/BOXES_PER_TASK) workgroups
-    uint32_t workgroupsX = (m_totalGrassX + shaderio::BOXES_PER_TASK - 1) / shaderio::BOXES_PER_TASK;  // ceil division
-    uint32_t workgroupsZ = m_totalGrassZ;
+    // Coarse culling of the tiles, shared by both occlusion passes
+    if(m_useTileCulling && !useCompaction && !useVertexPath)
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Tile Culling");
+      NXPROFILEFUNCCOL("Tile Culling", kNxColorCompute);
+      cullTiles(cmd, pushConst);
+    }
 
-    // IMPORTANT: VK_EXT_mesh_shader has limits on dispatch grid dimensions (typically 0xFFFF = 65535)
-    // Clamp to hardware-reported limits to prevent validation errors and potential crashes
-    workgroupsX = std::min(workgroupsX, m_meshShaderProps.maxTaskWorkGroupCount[0]);
-    workgroupsZ = std::min(workgroupsZ, m_meshShaderProps.maxTaskWorkGroupCount[1]);
+    // The extra fields use the procedural terrain and wind: the baked maps and buffers are of the grid
+    shaderio::PushConstant fieldPushConst = pushConst;
+    fieldPushConst.drawFields             = 1;
+    fieldPushConst.infiniteGrass          = 0;
+    fieldPushConst.useBakedTerrain        = 0;
+    fieldPushConst.usePlacementBuffer     = 0;
+    fieldPushConst.useTileCulling         = 0;
+    fieldPushConst.useTightBounds         = 0;
+    fieldPushConst.useWindMap             = 0;
+    fieldPushConst.useTrample             = 0;
+    fieldPushConst.occlusionPass          = shaderio::OcclusionPass::eOcclusionDisabled;
+    fieldPushConst.temporalCulling        = 0;
+    if(m_fieldCount > 0)
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Field Culling");
+      NXPROFILEFUNCCOL("Field Culling", kNxColorCompute);
+      cullFields(cmd, fieldPushConst);
+    }
 
-    // Clamp total workgroup count to maxTaskWorkGroupTotalCount
-    uint64_t totalWorkgroups = static_cast<uint64_t>(workgroupsX) * static_cast<uint64_t>(workgroupsZ);
-    if(totalWorkgroups > m_meshShaderProps.maxTaskWorkGroupTotalCount)
+    // The grass pass samples the cascades
+    if(finfo.shadowCascades > 0)
     {
-      // Scale down to fit within the limit, maintaining aspect ratio as much as possible
-      double scale =
-          std::sqrt(static_cast<double>(m_meshShaderProps.maxTaskWorkGroupTotalCount) / static_cast<double>(totalWorkgroups));
-      workgroupsX = std::max(1u, static_cast<uint32_t>(workgroupsX * scale));
-      workgroupsZ = std::max(1u, static_cast<uint32_t>(workgroupsZ * scale));
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Shadow Maps");
+      NXPROFILEFUNCCOL("Shadow Maps", kNxColorDraw);
+      drawShadows(cmd, pushConst, workgroupsX, workgroupsZ);
     }
 
-    vkCmdDrawMeshTasksEXT(cmd, workgroupsX, workgroupsZ, 1);
+    // Without occlusion culling, a single frustum-culled pass
+    // With occlusion culling, phase 1 draws against the previous pyramid, then the pyramid is rebuilt
+    // from the new depth and phase 2 draws the patches it rejected that are now visible.
+    // Phase 1 projects with the current camera: a stale pyramid can only reject wrongly, which phase 2 corrects.
+    // With temporal culling, phase 1 draws last frame's visible patches untested and phase 2 tests all of them.
+    // Stale bits (a scrolled infinite grid, a resized buffer) only change what phase 1 draws, never the result.
+    pushConst.occlusionPass   = useOcclusion ? shaderio::OcclusionPass::eOcclusionFirst : shaderio::OcclusionPass::eOcclusionDisabled;
+    pushConst.temporalCulling = useOcclusion && m_useTemporalCulling ? 1 : 0;
+
+    // The ground clears the targets, its depth also feeds the depth pyramid occluding the grass behind the hills
+    if(m_showGround && m_groundPipeline != VK_NULL_HANDLE && m_pipelineViewCount == 1)
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Ground Draw");
+      NXPROFILEFUNCCOL("Ground Draw", kNxColorDraw);
+      drawGround(cmd, renderingInfo, pushConst);
+      colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+      depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    }
 
-    vkCmdEndRendering(cmd);
+    beginPipelineQueries(cmd);
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Grass Draw");
+      NXPROFILEFUNCCOL("Grass Draw", kNxColorDraw);
+      if(useVertexPath)
+      {
+        drawVertexGrass(cmd, renderingInfo, pushConst);
+      }
+      else if(useCompaction)
+      {
+        drawCompactedGrass(cmd, renderingInfo, pushConst);
+      }
+      else
+      {
+        drawGrass(cmd, renderingInfo, pushConst, workgroupsX, workgroupsZ);
+      }
+    }
 
-    // Ensure atomic writes to device statistics buffer are complete, then copy to host buffer
-    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT, VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+    if(useOcclusion)
+    {
+      // The second pass keeps the result of the first one
+      colorAttachment.loadOp  = VK_ATTACHMENT_LOAD_OP_LOAD;
+      depthAttachment.loadOp  = VK_ATTACHMENT_LOAD_OP_LOAD;
+      pushConst.occlusionPass = shaderio::OcclusionPass::eOcclusionSecond;
+
+      // The pyramid build and the second pass, with the barriers of the graph. The first pass left the depth
+      // as attachment, and its writes are waited for by the first access of the graph to the imported resources.
+      m_occlusionDepth.descriptor.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+      m_occlusionFrame                        = {&renderingInfo, pushConst, workgroupsX, workgroupsZ};
+      m_occlusionGraph.recordGraphics(cmd, frameSlot);
+    }
+
+    if(m_fieldCount > 0)
+    {
+      colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+      depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 
-    VkBufferCopy copyRegion{.size = sizeof(shaderio::Statistics)};
-    vkCmdCopyBuffer(cmd, m_readbackDevice.buffer, m_readbackHost.buffer, 1, &copyRegion);
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Fields Draw");
+      NXPROFILEFUNCCOL("Fields Draw", kNxColorDraw);
+      drawFields(cmd, renderingInfo, fieldPushConst);
+    }
+    endPipelineQueries(cmd);
+
+    // Ensure atomic writes to device statistics buffer are complete, then copy to host buffer
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Readback");
+      NXPROFILEFUNCCOL("Readback", kNxColorCompute);
+      m_statsCounters.cmdEndFrame(cmd, m_grassPipelineStages | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+    }
 
     // Allow to display the GBuffer
     nvvk::cmdImageMemoryBarrier(cmd, {m_gBuffers->getColorImage(), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL});
+
+    if(m_pipelineViewCount > 1)
+    {
+      copyMultiviews(cmd);
+    }
+
+    if(isUpscaled())
+    {
+      auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Upscale");
+      NXPROFILEFUNCCOL("Upscale", kNxColorCompute);
+      upscale(cmd);
+    }
   }
 
 private:
@@ -397,116 +1314,2119 @@ private:
     }
   }
 
-  void createPipeline()
+  // One pipeline statistics query and one mesh primitives generated query per frame in flight
+  void createQueryPools()
   {
-    // Descriptor setup
-    nvvk::DescriptorBindings bindings;
-    bindings.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL);
+    if(!m_supportsPipelineQueries)
+    {
+      return;
+    }
 
-    // Create the descriptor layout, pool, and 1 set
-    NVVK_CHECK(m_descriptorPack.init(bindings, m_device, 1));
-    NVVK_DBG_NAME(m_descriptorPack.getLayout());
-    NVVK_DBG_NAME(m_descriptorPack.getPool());
-    NVVK_DBG_NAME(m_descriptorPack.getSet(0));
+    uint32_t numFrames = m_app->getFrameCycleSize();
+    m_queryFrameValid.assign(numFrames, false);
 
-    // Writing to the descriptors
-    nvvk::WriteSetContainer writes{};
-    writes.append(m_descriptorPack.makeWrite(0), m_frameInfo);
+    VkQueryPoolCreateInfo poolInfo{
+        .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+        .queryCount         = numFrames,
+        .pipelineStatistics = kPipelineStatisticFlags,
+    };
+    NVVK_CHECK(vkCreateQueryPool(m_device, &poolInfo, nullptr, &m_pipelineStatsPool));
+    NVVK_DBG_NAME(m_pipelineStatsPool);
+
+    poolInfo.queryType          = VK_QUERY_TYPE_MESH_PRIMITIVES_GENERATED_EXT;
+    poolInfo.pipelineStatistics = 0;
+    NVVK_CHECK(vkCreateQueryPool(m_device, &poolInfo, nullptr, &m_meshPrimitivesPool));
+    NVVK_DBG_NAME(m_meshPrimitivesPool);
+  }
+
+  // Reads the queries of the previous use of this frame slot, then restarts them
+  void beginPipelineQueries(VkCommandBuffer cmd)
+  {
+    if(!m_usePipelineQueries)
+    {
+      return;
+    }
+
+    // The frame previously recorded in this slot has completed
+    uint32_t frame = m_app->getFrameCycleIndex();
+    if(m_queryFrameValid[frame])
+    {
+      std::array<uint64_t, kPipelineQueryCount> values{};
+      VkResult statsResult = vkGetQueryPoolResults(m_device, m_pipelineStatsPool, frame, 1, (kPipelineQueryCount - 1) * sizeof(uint64_t),
+                                                   values.data(), (kPipelineQueryCount - 1) * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+      VkResult primResult = vkGetQueryPoolResults(m_device, m_meshPrimitivesPool, frame, 1, sizeof(uint64_t),
+                                                  &values[kPipelineQueryCount - 1], sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+      if(statsResult == VK_SUCCESS && primResult == VK_SUCCESS)
+      {
+        // Per-frame values, and averages over windows of kQueryAverageFrames frames
+        m_queryFrame = values;
+        for(uint32_t i = 0; i < kPipelineQueryCount; i++)
+        {
+          m_querySum[i] += values[i];
+        }
+        if(++m_querySumFrames == kQueryAverageFrames)
+        {
+          for(uint32_t i = 0; i < kPipelineQueryCount; i++)
+          {
+            m_queryAverage[i] = double(m_querySum[i]) / kQueryAverageFrames;
+            m_querySum[i]     = 0;
+          }
+          m_querySumFrames = 0;
+        }
+      }
+    }
+
+    vkCmdResetQueryPool(cmd, m_pipelineStatsPool, frame, 1);
+    vkCmdResetQueryPool(cmd, m_meshPrimitivesPool, frame, 1);
+    vkCmdBeginQuery(cmd, m_pipelineStatsPool, frame, 0);
+    vkCmdBeginQuery(cmd, m_meshPrimitivesPool, frame, 0);
+    m_queryFrameValid[frame] = true;
+    m_queriesActive          = true;
+  }
+
+  void endPipelineQueries(VkCommandBuffer cmd)
+  {
+    if(!m_queriesActive)
+    {
+      return;
+    }
+
+    uint32_t frame = m_app->getFrameCycleIndex();
+    vkCmdEndQuery(cmd, m_meshPrimitivesPool, frame);
+    vkCmdEndQuery(cmd, m_pipelineStatsPool, frame);
+    m_queriesActive = false;
+  }
+
+  // Evaluate the terrain noise once per grass patch into the terrain map, and the height range of the culling tiles
+  // When the infinite meadow grid moved by a few cells, only the cells entering it are baked
+  void bakeTerrain(VkCommandBuffer cmd)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    // Frames in flight may still read the map and the bounds
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+    shaderio::PushConstant pushConst{};
+    pushConst.totalBoxesX    = static_cast<uint32_t>(m_totalGrassX);
+    pushConst.totalBoxesZ    = static_cast<uint32_t>(m_totalGrassZ);
+    pushConst.spacing        = m_spacing;
+    pushConst.gridOrigin     = m_gridOrigin;
+    pushConst.infiniteGrass  = m_infiniteGrass ? 1 : 0;
+
+    // Baked area: the grid, and one more cell around it for the infinite meadow (see terrainBakeMain)
+    glm::ivec2 bakeSize = glm::ivec2(m_totalGrassX, m_totalGrassZ) + (m_infiniteGrass ? 2 : 0);
+    glm::ivec2 shift    = m_gridOrigin - m_bakedOrigin;
+
+    // Regions to bake (offset, size)
+    std::vector<glm::ivec4> regions;
+    if(m_terrainDirty || std::abs(shift.x) >= bakeSize.x || std::abs(shift.y) >= bakeSize.y)
+    {
+      regions.push_back({0, 0, bakeSize});
+    }
+    else
+    {
+      // The columns and the rows entering the grid, the map wraps around (see getPatchTexel)
+      if(shift.x != 0)
+        regions.push_back({shift.x > 0 ? bakeSize.x - shift.x : 0, 0, std::abs(shift.x), bakeSize.y});
+      if(shift.y != 0)
+        regions.push_back({0, shift.y > 0 ? bakeSize.y - shift.y : 0, bakeSize.x, std::abs(shift.y)});
+    }
+
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_terrainPipeline);
+    for(const glm::ivec4& region : regions)
+    {
+      // Threads past the region bake cells that are already up to date, or stop past the baked area
+      pushConst.tileOffset = glm::uvec2(region.x, region.y);
+      vkCmdPushConstants(cmd, m_computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::PushConstant), &pushConst);
+
+      VkExtent2D groupCounts = nvvk::getGroupCounts(VkExtent2D{uint32_t(region.z), uint32_t(region.w)}, TERRAIN_WORKGROUP_SIZE);
+      vkCmdDispatch(cmd, groupCounts.width, groupCounts.height, 1);
+    }
+
+    // The tile ranges are reduced from the patch ranges
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+    VkExtent2D tileCount = getTileCount();
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_tileBoundsPipeline);
+    vkCmdDispatch(cmd, nvvk::getGroupCounts(tileCount.width * tileCount.height, TILE_WORKGROUP_SIZE), 1, 1);
+
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+  }
+
+  // Evaluate the wind of the frame over the grid into the wind map
+  void updateWindMap(VkCommandBuffer cmd, const shaderio::PushConstant& pushConst)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    // The previous frame may still read the map
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::PushConstant), &pushConst);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_windPipeline);
+
+    VkExtent2D groupCounts = nvvk::getGroupCounts(VkExtent2D{shaderio::WIND_MAP_SIZE, shaderio::WIND_MAP_SIZE}, TERRAIN_WORKGROUP_SIZE);
+    vkCmdDispatch(cmd, groupCounts.width, groupCounts.height, 1);
+
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT);
+  }
+
+  // Write the interactors of the frame into its slot of the interactor ring, referenced by the FrameInfo
+  // The sample moves walkers on circles around the grid center, an application would write its characters and vehicles
+  void writeInteractors(shaderio::FrameInfo& finfo, uint32_t frameSlot)
+  {
+    const size_t slotSize    = sizeof(shaderio::Interactor) * shaderio::TRAMPLE_MAX_INTERACTORS;
+    auto*        interactors = reinterpret_cast<shaderio::Interactor*>(m_interactors.mapping + frameSlot * slotSize);
+
+    const glm::vec2 gridSize   = glm::vec2(m_totalGrassX, m_totalGrassZ);
+    const glm::vec2 originCell = getGridOriginCell();
+    const glm::vec2 gridCenter = (originCell + gridSize * 0.5f) * m_spacing;
+    const float     maxRadius  = std::min(gridSize.x, gridSize.y) * m_spacing * 0.45f;
+
+    uint32_t count = 0;
+    for(int walker = 0; walker < m_trampleWalkers; walker++)
+    {
+      // Golden ratio spread of the circles and the phases, every other walker turning the other way
+      const float     fraction = std::fmod(float(walker) * 0.618034f, 1.0f);
+      const float     circle   = maxRadius * (0.2f + 0.8f * fraction);
+      const float     angle    = (walker & 1 ? -1.0f : 1.0f) * float(ImGui::GetTime()) * 1.5f / circle + float(walker) * 2.39996f;
+      const glm::vec2 position = gridCenter + circle * glm::vec2(std::cos(angle), std::sin(angle));
+      interactors[count++]     = {glm::vec3(position.x, 0.0f, position.y), m_trampleRadius};
+    }
+    if(m_trampleCamera)
+    {
+      const glm::vec3 eye  = g_cameraManip->getEye();
+      interactors[count++] = {glm::vec3(eye.x, 0.0f, eye.z), m_trampleRadius};
+    }
+
+    // Most of the flattening is gone after the recovery time
+    finfo.interactorsAddr = VkDeviceAddress(m_interactors.address + frameSlot * slotSize);
+    finfo.interactorCount = count;
+    finfo.trampleDecay    = std::exp(-3.0f * ImGui::GetIO().DeltaTime / m_trampleRecovery);
+  }
+
+  // Decay the trample map, then flatten it around the interactors of the frame
+  void updateTrampleMap(VkCommandBuffer cmd, const shaderio::PushConstant& pushConst)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    // The previous frame may still read the map
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::PushConstant), &pushConst);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_tramplePipeline);
+
+    VkExtent2D groupCounts = nvvk::getGroupCounts(VkExtent2D{shaderio::TRAMPLE_MAP_SIZE, shaderio::TRAMPLE_MAP_SIZE}, TERRAIN_WORKGROUP_SIZE);
+    vkCmdDispatch(cmd, groupCounts.width, groupCounts.height, 1);
+
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT);
+  }
+
+  bool useVirtualTerrain() const
+  {
+    return m_useBakedTerrain && m_useVirtualTerrain && m_virtualTerrainPipeline != VK_NULL_HANDLE;
+  }
+
+  // Residency of the virtual terrain for this frame: evicts the pages away from the camera, generates the missing ones
+  // within the radius, nearest first and up to the budget, and writes the page table of the frame slot.
+  // Recorded on the async compute queue when there is one, the graphics submit of the frame waits for it.
+  // The layer of an evicted page is reused once the frames in flight which may still sample it are done,
+  // so the generation never waits for the graphics queue. Returns the number of pages generated.
+  uint32_t updateVirtualTerrain(VkCommandBuffer cmd, uint32_t frameSlot)
+  {
+    NVVK_DBG_SCOPE(cmd);
+    m_virtualFrame++;
+
+    auto packPage   = [](glm::ivec2 page) { return (uint64_t(uint32_t(page.x)) << 32) | uint32_t(page.y); };
+    auto unpackPage = [](uint64_t key) { return glm::ivec2(int32_t(uint32_t(key >> 32)), int32_t(uint32_t(key))); };
+    auto retire     = [this](uint32_t layer) { m_virtualRetiredLayers.push_back({layer, m_virtualFrame}); };
+
+    // The pages depend on the spacing
+    if(m_virtualSpacing != m_spacing)
+    {
+      for(const auto& [key, layer] : m_virtualPages)
+      {
+        retire(layer);
+      }
+      m_virtualPages.clear();
+      m_virtualSpacing = m_spacing;
+    }
+
+    const float      pageSize   = m_spacing * float(shaderio::VIRTUAL_TERRAIN_PAGE_CELLS);
+    const glm::vec3  eye        = g_cameraManip->getEye();
+    const glm::ivec2 cameraPage = glm::ivec2(glm::floor(glm::vec2(eye.x, eye.z) / pageSize));
+    m_virtualOrigin             = cameraPage - int(shaderio::VIRTUAL_TERRAIN_TABLE_SIZE / 2);
+
+    // One page of margin, a camera going back and forth over a page border doesn't regenerate pages
+    const int keepRadius = m_virtualRadius + 1;
+    for(auto it = m_virtualPages.begin(); it != m_virtualPages.end();)
+    {
+      const glm::ivec2 distance = glm::abs(unpackPage(it->first) - cameraPage);
+      if(std::max(distance.x, distance.y) > keepRadius)
+      {
+        retire(it->second);
+        it = m_virtualPages.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+
+    // Frames up to the previous one may sample the retired layers
+    std::erase_if(m_virtualRetiredLayers, [&](const std::pair<uint32_t, uint64_t>& retired) {
+      if(m_virtualFrame - retired.second < m_app->getFrameCycleSize())
+      {
+        return false;
+      }
+      m_virtualFreeLayers.push_back(retired.first);
+      return true;
+    });
+
+    std::vector<glm::ivec2> missing;
+    for(int z = -m_virtualRadius; z <= m_virtualRadius; z++)
+    {
+      for(int x = -m_virtualRadius; x <= m_virtualRadius; x++)
+      {
+        const glm::ivec2 page = cameraPage + glm::ivec2(x, z);
+        if(!m_virtualPages.contains(packPage(page)))
+        {
+          missing.push_back(page);
+        }
+      }
+    }
+    std::sort(missing.begin(), missing.end(), [&](glm::ivec2 a, glm::ivec2 b) {
+      return glm::dot(glm::vec2(a - cameraPage), glm::vec2(a - cameraPage)) < glm::dot(glm::vec2(b - cameraPage), glm::vec2(b - cameraPage));
+    });
+    const uint32_t generated = uint32_t(std::min({missing.size(), size_t(m_virtualPagesPerFrame), m_virtualFreeLayers.size()}));
+
+    if(generated > 0)
+    {
+      // The pass only reads its push constants, the frame info of the slot is still written by onRender
+      const uint32_t frameInfoOffset = uint32_t(frameSlot * m_frameInfoStride);
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &frameInfoOffset);
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_virtualTerrainPipeline);
+
+      shaderio::PushConstant pushConst{};
+      pushConst.spacing = m_spacing;
+
+      VkExtent2D groupCounts = nvvk::getGroupCounts(
+          VkExtent2D{shaderio::VIRTUAL_TERRAIN_PAGE_TEXELS, shaderio::VIRTUAL_TERRAIN_PAGE_TEXELS}, TERRAIN_WORKGROUP_SIZE);
+      for(uint32_t i = 0; i < generated; i++)
+      {
+        const uint32_t layer = m_virtualFreeLayers.back();
+        m_virtualFreeLayers.pop_back();
+        m_virtualPages[packPage(missing[i])] = layer;
+
+        pushConst.virtualPageCell  = missing[i] * int(shaderio::VIRTUAL_TERRAIN_PAGE_CELLS);
+        pushConst.virtualPageLayer = layer;
+        vkCmdPushConstants(cmd, m_computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::PushConstant), &pushConst);
+        vkCmdDispatch(cmd, groupCounts.width, groupCounts.height, 1);
+      }
+    }
+
+    // The slot of this frame in flight is no longer read by the GPU
+    const size_t slotSize = sizeof(int32_t) * shaderio::VIRTUAL_TERRAIN_TABLE_SIZE * shaderio::VIRTUAL_TERRAIN_TABLE_SIZE;
+    auto*        table    = reinterpret_cast<int32_t*>(m_virtualTable.mapping + frameSlot * slotSize);
+    std::fill_n(table, shaderio::VIRTUAL_TERRAIN_TABLE_SIZE * shaderio::VIRTUAL_TERRAIN_TABLE_SIZE, -1);
+    for(const auto& [key, layer] : m_virtualPages)
+    {
+      const glm::ivec2 entry = unpackPage(key) - m_virtualOrigin;
+      if(glm::all(glm::greaterThanEqual(entry, glm::ivec2(0))) && glm::all(glm::lessThan(entry, glm::ivec2(shaderio::VIRTUAL_TERRAIN_TABLE_SIZE))))
+      {
+        table[entry.y * shaderio::VIRTUAL_TERRAIN_TABLE_SIZE + entry.x] = int32_t(layer);
+      }
+    }
+    return generated;
+  }
+
+  // World cell of the center of patch (0, 0), as getGridOriginCell in the shader
+  glm::vec2 getGridOriginCell() const
+  {
+    return m_infiniteGrass ? glm::vec2(m_gridOrigin) : -(glm::vec2(m_totalGrassX, m_totalGrassZ) - 1.0f) * 0.5f;
+  }
+
+  // Number of culling tiles over the grid
+  // The task workgroup width is a specialization constant (at least 32 or the subgroup size), the count
+  // is an upper bound for all of them and the default BOXES_PER_TASK (the shaders ignore the extra tiles)
+  VkExtent2D getTileCount() const
+  {
+    uint32_t taskWidth = std::min(shaderio::BOXES_PER_TASK, m_device11Props.subgroupSize);
+    return {(static_cast<uint32_t>(m_totalGrassX) + taskWidth - 1) / taskWidth,
+            (static_cast<uint32_t>(m_totalGrassZ) + shaderio::TILE_ROWS - 1) / shaderio::TILE_ROWS};
+  }
+
+  // Frustum cull the tiles into the indirect draw of the visible ones
+  void cullTiles(VkCommandBuffer cmd, const shaderio::PushConstant& pushConst)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    // Previous frames may still read the list
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT,
+                           VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+
+    // One task workgroup per row of each visible tile (groupCountX is incremented by the shader)
+    const VkDrawMeshTasksIndirectCommandEXT drawCommand{.groupCountX = 0, .groupCountY = shaderio::TILE_ROWS, .groupCountZ = 1};
+    vkCmdUpdateBuffer(cmd, m_visibleTiles.buffer, 0, sizeof(drawCommand), &drawCommand);
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_tileCullPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::PushConstant), &pushConst);
+
+    VkExtent2D tileCount = getTileCount();
+    vkCmdDispatch(cmd, nvvk::getGroupCounts(tileCount.width * tileCount.height, TILE_WORKGROUP_SIZE), 1, 1);
+
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT);
+  }
+
+  // Cull all the patches of the grid into the compacted blade lists and the indirect draw of their mesh workgroups
+  void compactBlades(VkCommandBuffer cmd, const shaderio::PushConstant& pushConst)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    // Previous frames may still read the list
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT,
+                           VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+
+    // groupCountX and the blade counts of the LODs are incremented by the shader. The largest grid, all visible
+    // at full detail, needs 125000 mesh workgroups: within maxMeshWorkGroupCount[0] of current hardware
+    const uint32_t header[shaderio::COMPACT_LIST_OFFSET] = {0, 1, 1};
+    vkCmdUpdateBuffer(cmd, m_compactBlades.buffer, 0, sizeof(header), header);
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_compactCullPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::PushConstant), &pushConst);
+    vkCmdDispatch(cmd, nvvk::getGroupCounts(uint32_t(m_totalGrassX * m_totalGrassZ), TILE_WORKGROUP_SIZE), 1, 1);
+
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT);
+  }
+
+  // Draw the compacted blades with a single indirect dispatch of mesh workgroups
+  void drawCompactedGrass(VkCommandBuffer cmd, const VkRenderingInfo& renderingInfo, const shaderio::PushConstant& pushConst)
+  {
+    vkCmdBeginRendering(cmd, &renderingInfo);
+    m_graphicState.cmdSetViewportAndScissor(cmd, renderingInfo.renderArea.extent);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_compactPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_pipelineLayout, m_grassStages, 0,
+                       sizeof(shaderio::PushConstant), &pushConst);
+    vkCmdDrawMeshTasksIndirectEXT(cmd, m_compactBlades.buffer, 0, 1, sizeof(VkDrawMeshTasksIndirectCommandEXT));
+    vkCmdEndRendering(cmd);
+  }
+
+  // The vertex shader fallback draws the grass without mesh shaders, or when selected (alternating with the mesh
+  // shader path when comparing them). It draws the camera view only.
+  bool isVertexPathActive() const
+  {
+    if(m_vertexPipeline == VK_NULL_HANDLE || m_pipelineViewCount != 1)
+    {
+      return false;
+    }
+    if(!m_supportsMeshShaders)
+    {
+      return true;
+    }
+    return m_comparePaths ? (m_frameNumber / kPathCompareFrames) % 2 == 1 : m_useVertexFallback;
+  }
+
+  // Features of the compute passes of the mesh shader module, which can't be created without mesh shaders.
+  // The shadows, the ground and the compaction check their pipelines instead.
+  void disableMeshOnlyFeatures()
+  {
+    m_useBakedTerrain    = false;
+    m_useVirtualTerrain  = false;
+    m_usePlacementBuffer = false;
+    m_useTightBounds     = false;
+    m_useTileCulling     = false;
+    m_useWindMap         = false;
+    m_useTrample         = false;
+    m_useOcclusion       = false;
+    m_fieldCount         = 0;
+  }
+
+  // Cull all the patches of the grid into the blade lists and the indirect draws of the LODs (see vertexCullMain)
+  void cullVertexBlades(VkCommandBuffer cmd, const shaderio::PushConstant& pushConst)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    // Previous frames may still read the lists
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+                           VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+
+    // The triangles of the strip of each LOD, instanceCount is incremented by the shader and firstInstance is the
+    // start of the list of the LOD, read back by the vertex shader as its instance index
+    const uint32_t patchCount = uint32_t(m_totalGrassX * m_totalGrassZ);
+    std::array<VkDrawIndirectCommand, shaderio::GRASS_LOD_COUNT> draws{};
+    for(uint32_t lod = 0; lod < shaderio::GRASS_LOD_COUNT; lod++)
+    {
+      draws[lod] = {.vertexCount = (shaderio::GRASS_SEGMENTS >> lod) * 2 * 3, .firstInstance = lod * patchCount};
+    }
+    vkCmdUpdateBuffer(cmd, m_compactBlades.buffer, 0, sizeof(draws), draws.data());
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_vertexCullPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::PushConstant), &pushConst);
+    vkCmdDispatch(cmd, nvvk::getGroupCounts(patchCount, TILE_WORKGROUP_SIZE), 1, 1);
+
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT);
+  }
+
+  // Draw the listed blades, one indirect draw per LOD (a single multi-draw would need the multiDrawIndirect feature)
+  void drawVertexGrass(VkCommandBuffer cmd, const VkRenderingInfo& renderingInfo, const shaderio::PushConstant& pushConst)
+  {
+    vkCmdBeginRendering(cmd, &renderingInfo);
+    m_graphicState.cmdSetViewportAndScissor(cmd, renderingInfo.renderArea.extent);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_vertexPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_pipelineLayout, m_grassStages, 0, sizeof(shaderio::PushConstant), &pushConst);
+    for(uint32_t lod = 0; lod < shaderio::GRASS_LOD_COUNT; lod++)
+    {
+      vkCmdDrawIndirect(cmd, m_compactBlades.buffer, lod * sizeof(VkDrawIndirectCommand), 1, sizeof(VkDrawIndirectCommand));
+    }
+    vkCmdEndRendering(cmd);
+  }
+
+  // Extra fields on a spiral around the largest fixed grid, spread with the golden ratio,
+  // each of its own size and blade parameters
+  void generateFields()
+  {
+    m_fields.resize(m_fieldCount);
+    for(int index = 0; index < m_fieldCount; index++)
+    {
+      const float fraction = std::fmod(float(index) * 0.618034f, 1.0f);
+      const float angle    = float(index) * 2.39996f;
+
+      shaderio::GrassField& field = m_fields[index];
+      field.size                  = glm::uvec2(glm::mix(glm::vec2(64.0f), glm::vec2(400.0f), glm::vec2(fraction, 1.0f - fraction)));
+      field.density               = 0.3f + 0.7f * std::fmod(fraction * 7.0f, 1.0f);
+      field.heightScale           = 0.5f + 1.0f * std::fmod(fraction * 3.0f, 1.0f);
+      field.windScale             = 0.3f + 1.2f * std::fmod(fraction * 5.0f, 1.0f);
+
+      // Vogel spiral in cells beyond the fixed grid, centered at the origin and at most 1000 x 1000,
+      // the neighbor centers being about the diagonal of the largest field apart
+      const float     distance = 1000.0f + 320.0f * std::sqrt(float(index));
+      const glm::vec2 center   = distance * glm::vec2(std::cos(angle), std::sin(angle));
+      field.cellOrigin         = glm::ivec2(glm::floor(center - glm::vec2(field.size) * 0.5f));
+    }
+  }
+
+  // Upload the field descriptors when they changed, then frustum cull the fields into the indirect draw of the visible ones
+  void cullFields(VkCommandBuffer cmd, const shaderio::PushConstant& fieldPushConst)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    // Previous frames may still read the descriptors and the list
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT,
+                           VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+
+    if(m_fieldsDirty)
+    {
+      m_fieldsDirty = false;
+      generateFields();
+      vkCmdUpdateBuffer(cmd, m_fieldBuffer.buffer, 0, m_fields.size() * sizeof(shaderio::GrassField), m_fields.data());
+    }
+
+    // The task workgroup grid of the largest field for each visible field (groupCountZ is incremented by the shader)
+    glm::uvec2 maxSize{1};
+    for(const shaderio::GrassField& field : m_fields)
+    {
+      maxSize = glm::max(maxSize, field.size);
+    }
+    const VkDrawMeshTasksIndirectCommandEXT drawCommand{.groupCountX = (maxSize.x + m_pipelineTaskSize - 1) / m_pipelineTaskSize, .groupCountY = maxSize.y, .groupCountZ = 0};
+    vkCmdUpdateBuffer(cmd, m_visibleFields.buffer, 0, sizeof(drawCommand), &drawCommand);
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_fieldCullPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::PushConstant), &fieldPushConst);
+    vkCmdDispatch(cmd, nvvk::getGroupCounts(uint32_t(m_fieldCount), TILE_WORKGROUP_SIZE), 1, 1);
+
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT);
+  }
+
+  // Draw all the visible extra fields with a single indirect draw, groupID.z selecting the field
+  void drawFields(VkCommandBuffer cmd, const VkRenderingInfo& renderingInfo, const shaderio::PushConstant& fieldPushConst)
+  {
+    vkCmdBeginRendering(cmd, &renderingInfo);
+    m_graphicState.cmdSetViewportAndScissor(cmd, renderingInfo.renderArea.extent);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_pipelineLayout, m_grassStages, 0,
+                       sizeof(shaderio::PushConstant), &fieldPushConst);
+    vkCmdDrawMeshTasksIndirectEXT(cmd, m_visibleFields.buffer, 0, 1, sizeof(VkDrawMeshTasksIndirectCommandEXT));
+    vkCmdEndRendering(cmd);
+  }
+
+  // Largest tile of the task workgroup grid that can be drawn at once
+  // IMPORTANT: VK_EXT_mesh_shader has limits on dispatch grid dimensions (typically 0xFFFF = 65535)
+  // and on the total workgroup count (maxTaskWorkGroupTotalCount)
+  VkExtent2D getDrawTileSize(uint32_t workgroupsX, uint32_t workgroupsZ) const
+  {
+    uint32_t tileX = std::max(1u, std::min(workgroupsX, m_meshShaderProps.maxTaskWorkGroupCount[0]));
+    uint32_t tileZ = std::max(1u, std::min(workgroupsZ, m_meshShaderProps.maxTaskWorkGroupCount[1]));
+    tileX          = std::min(tileX, m_meshShaderProps.maxTaskWorkGroupTotalCount);
+    tileZ          = std::max(1u, std::min(tileZ, m_meshShaderProps.maxTaskWorkGroupTotalCount / tileX));
+    return {tileX, tileZ};
+  }
+
+  // Record one grass pass into the GBuffer
+  // The workgroup grid is drawn in tiles fitting the hardware limits, each offset with the push constant
+  // With tile culling, a single indirect draw of the visible tiles instead
+  void drawGrass(VkCommandBuffer cmd, const VkRenderingInfo& renderingInfo, shaderio::PushConstant pushConst, uint32_t workgroupsX, uint32_t workgroupsZ)
+  {
+    // Start the rendering
+    vkCmdBeginRendering(cmd, &renderingInfo);
+
+    m_graphicState.cmdSetViewportAndScissor(cmd, renderingInfo.renderArea.extent);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+
+    if(m_useTileCulling)
+    {
+      vkCmdPushConstants(cmd, m_pipelineLayout, m_grassStages, 0,
+                         sizeof(shaderio::PushConstant), &pushConst);
+      vkCmdDrawMeshTasksIndirectEXT(cmd, m_visibleTiles.buffer, 0, 1, sizeof(VkDrawMeshTasksIndirectCommandEXT));
+      vkCmdEndRendering(cmd);
+      return;
+    }
+
+    cmdDrawGrid(cmd, pushConst, workgroupsX, workgroupsZ);
+    vkCmdEndRendering(cmd);
+  }
+
+  // Draw the ground quadtree, one task workgroup per root node over the grid
+  void drawGround(VkCommandBuffer cmd, const VkRenderingInfo& renderingInfo, const shaderio::PushConstant& pushConst)
+  {
+    vkCmdBeginRendering(cmd, &renderingInfo);
+    m_graphicState.cmdSetViewportAndScissor(cmd, renderingInfo.renderArea.extent);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_groundPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    vkCmdPushConstants(cmd, m_pipelineLayout, m_grassStages, 0,
+                       sizeof(shaderio::PushConstant), &pushConst);
+
+    const VkExtent2D roots = getGroundRootCount();
+    vkCmdDrawMeshTasksEXT(cmd, roots.width, roots.height, 1);
+    vkCmdEndRendering(cmd);
+  }
+
+  // Root nodes of the ground covering the grid, aligned in the world as getGroundRootMin in the shader
+  VkExtent2D getGroundRootCount() const
+  {
+    const glm::vec2 gridSize   = glm::vec2(m_totalGrassX, m_totalGrassZ);
+    const glm::vec2 originCell = getGridOriginCell();
+    const glm::vec2 rootMin    = glm::floor((originCell - 0.5f) / float(shaderio::GROUND_ROOT_PATCHES));
+    const glm::vec2 rootMax    = glm::floor((originCell + gridSize - 0.5f) / float(shaderio::GROUND_ROOT_PATCHES));
+    return {uint32_t(rootMax.x - rootMin.x) + 1, uint32_t(rootMax.y - rootMin.y) + 1};
+  }
+
+  // Draw the whole workgroup grid with the bound pipeline, in tiles fitting the hardware limits
+  void cmdDrawGrid(VkCommandBuffer cmd, shaderio::PushConstant pushConst, uint32_t workgroupsX, uint32_t workgroupsZ) const
+  {
+    VkExtent2D tileSize = getDrawTileSize(workgroupsX, workgroupsZ);
+    for(uint32_t tileZ = 0; tileZ < workgroupsZ; tileZ += tileSize.height)
+    {
+      for(uint32_t tileX = 0; tileX < workgroupsX; tileX += tileSize.width)
+      {
+        pushConst.tileOffset = {tileX, tileZ};
+        vkCmdPushConstants(cmd, m_pipelineLayout, m_grassStages, 0,
+                           sizeof(shaderio::PushConstant), &pushConst);
+
+        vkCmdDrawMeshTasksEXT(cmd, std::min(tileSize.width, workgroupsX - tileX), std::min(tileSize.height, workgroupsZ - tileZ), 1);
+      }
+    }
+  }
+
+  // Views of the multiview rendering around the camera: two eyes apart along the camera right,
+  // or six views at the eye looking along +X, -X, +Y, -Y, +Z and -Z
+  void computeMultiviews(shaderio::FrameInfo& finfo)
+  {
+    finfo.viewCount = m_pipelineViewCount;
+    if(finfo.viewCount <= 1)
+    {
+      return;
+    }
+
+    const glm::vec2 clip = g_cameraManip->getClipPlanes();
+    glm::mat4       views[shaderio::MULTIVIEW_MAX_VIEWS];
+    glm::mat4       proj;
+    if(finfo.viewCount == 2)
+    {
+      // Square eye views with the field of view of the camera
+      proj     = glm::perspectiveRH_ZO(g_cameraManip->getRadFov(), 1.0f, clip.x, clip.y);
+      views[0] = glm::translate(glm::mat4(1.0f), glm::vec3(m_stereoEyeDistance * 0.5f, 0.0f, 0.0f)) * finfo.view;
+      views[1] = glm::translate(glm::mat4(1.0f), glm::vec3(-m_stereoEyeDistance * 0.5f, 0.0f, 0.0f)) * finfo.view;
+    }
+    else
+    {
+      const glm::vec3 directions[] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+      const glm::vec3 ups[]        = {{0, 1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, 1, 0}};
+      proj                         = glm::perspectiveRH_ZO(glm::half_pi<float>(), 1.0f, clip.x, clip.y);
+      for(uint32_t view = 0; view < finfo.viewCount; view++)
+      {
+        views[view] = glm::lookAt(finfo.camPos, finfo.camPos + directions[view], ups[view]);
+      }
+    }
+    proj[1][1] *= -1;  // Flip the Y axis, as the camera
+
+    for(uint32_t view = 0; view < finfo.viewCount; view++)
+    {
+      finfo.multiviewViewProj[view] = proj * views[view];
+      calculateFrustumPlanes(views[view], proj, finfo.multiviewPlanes[view]);
+    }
+
+    // The blade LOD follows the resolution of the views
+    finfo.pixelsPerUnit = std::abs(proj[1][1]) * 0.5f * float(kMultiviewSize);
+  }
+
+  // Copy the views of the multiview target side by side into the GBuffer, in a grid of 2 columns or 3 columns
+  void copyMultiviews(VkCommandBuffer cmd)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    const VkImageSubresourceRange colorRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, shaderio::MULTIVIEW_MAX_VIEWS};
+    nvvk::cmdImageMemoryBarrier(cmd, {m_multiviewColor.image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, colorRange});
+
+    const VkClearColorValue       clearValue = m_clearColor;
+    const VkImageSubresourceRange range      = DEFAULT_VkImageSubresourceRange;
+    vkCmdClearColorImage(cmd, m_gBuffers->getColorImage(), VK_IMAGE_LAYOUT_GENERAL, &clearValue, 1, &range);
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+
+    // Largest square cells fitting the grid in the GBuffer
+    const VkExtent2D size    = m_gBuffers->getSize();
+    const uint32_t   columns = m_pipelineViewCount <= 2 ? 2 : 3;
+    const uint32_t   rows    = (m_pipelineViewCount + columns - 1) / columns;
+    const int32_t    cell    = int32_t(std::min(size.width / columns, size.height / rows));
+    const int32_t    offsetX = (int32_t(size.width) - cell * int32_t(columns)) / 2;
+    const int32_t    offsetY = (int32_t(size.height) - cell * int32_t(rows)) / 2;
+
+    for(uint32_t view = 0; view < m_pipelineViewCount; view++)
+    {
+      const int32_t x = offsetX + int32_t(view % columns) * cell;
+      const int32_t y = offsetY + int32_t(view / columns) * cell;
+
+      VkImageBlit region{
+          .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, view, 1},
+          .srcOffsets     = {{0, 0, 0}, {int32_t(kMultiviewSize), int32_t(kMultiviewSize), 1}},
+          .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+          .dstOffsets     = {{x, y, 0}, {x + cell, y + cell, 1}},
+      };
+      vkCmdBlitImage(cmd, m_multiviewColor.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_gBuffers->getColorImage(),
+                     VK_IMAGE_LAYOUT_GENERAL, 1, &region, VK_FILTER_LINEAR);
+    }
+
+    // The GBuffer is displayed by the fragment shader of the viewport
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT);
+  }
+
+  // Depth of the grass into the layers of the shadow map, one per cascade
+  // The whole grid is drawn: the tile list and the occlusion bits are of the camera
+  void drawShadows(VkCommandBuffer cmd, shaderio::PushConstant pushConst, uint32_t workgroupsX, uint32_t workgroupsZ)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    const VkImageSubresourceRange shadowRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, shaderio::SHADOW_MAX_CASCADES};
+    nvvk::cmdImageMemoryBarrier(cmd, m_shadowMap, {.newLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, .subresourceRange = shadowRange});
+
+    VkRenderingAttachmentInfo depthAttachment = DEFAULT_VkRenderingAttachmentInfo;
+    depthAttachment.imageView                 = m_shadowMap.descriptor.imageView;
+    depthAttachment.imageLayout               = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+    depthAttachment.clearValue                = {.depthStencil = DEFAULT_VkClearDepthStencilValue};
+
+    VkRenderingInfo renderingInfo  = DEFAULT_VkRenderingInfo;
+    renderingInfo.renderArea       = DEFAULT_VkRect2D(VkExtent2D{kShadowMapSize, kShadowMapSize});
+    renderingInfo.layerCount       = shaderio::SHADOW_MAX_CASCADES;
+    renderingInfo.pDepthAttachment = &depthAttachment;
+
+    pushConst.useTileCulling = 0;
+    pushConst.occlusionPass  = shaderio::OcclusionPass::eOcclusionDisabled;
+
+    vkCmdBeginRendering(cmd, &renderingInfo);
+    m_graphicState.cmdSetViewportAndScissor(cmd, {kShadowMapSize, kShadowMapSize});
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_shadowPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, m_descriptorPack.getSetPtr(), 1, &m_frameInfoOffset);
+    cmdDrawGrid(cmd, pushConst, workgroupsX, workgroupsZ);
+    vkCmdEndRendering(cmd);
+
+    nvvk::cmdImageMemoryBarrier(cmd, m_shadowMap, {.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, .subresourceRange = shadowRange});
+  }
+
+  // Cascades of the sun shadow over [near plane, m_shadowDistance] of the camera
+  // Each cascade is an orthographic projection around the bounding sphere of its slice of the view frustum,
+  // so its size does not change with the camera orientation, snapped to the shadow map texels against shimmering
+  void computeShadowCascades(shaderio::FrameInfo& finfo)
+  {
+    finfo.lightDir       = glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f));
+    finfo.shadowCascades = (m_useShadows && m_shadowPipeline != VK_NULL_HANDLE && m_pipelineViewCount == 1) ? uint32_t(m_shadowCascades) : 0;
+
+    const glm::mat4 viewInv  = glm::inverse(finfo.view);
+    const float     tanHalfX = 1.0f / std::abs(finfo.proj[0][0]);
+    const float     tanHalfY = 1.0f / std::abs(finfo.proj[1][1]);
+    const float     nearZ    = g_cameraManip->getClipPlanes().x;
+    const float     farZ     = std::max(m_shadowDistance, nearZ * 2.0f);
+    const glm::vec3 up       = std::abs(finfo.lightDir.z) < 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+
+    float splitNear = nearZ;
+    for(uint32_t cascade = 0; cascade < finfo.shadowCascades; cascade++)
+    {
+      // Practical split scheme: blend of the uniform and the logarithmic splits
+      const float ratio    = float(cascade + 1) / float(finfo.shadowCascades);
+      const float splitFar = glm::mix(nearZ + (farZ - nearZ) * ratio, nearZ * std::pow(farZ / nearZ, ratio), m_shadowSplitBlend);
+
+      glm::vec3 corners[8];
+      glm::vec3 center(0.0f);
+      for(uint32_t i = 0; i < 8; i++)
+      {
+        const float depth = (i & 4) != 0 ? splitFar : splitNear;
+        const float x     = ((i & 1) != 0 ? 1.0f : -1.0f) * tanHalfX * depth;
+        const float y     = ((i & 2) != 0 ? 1.0f : -1.0f) * tanHalfY * depth;
+        corners[i]        = glm::vec3(viewInv * glm::vec4(x, y, -depth, 1.0f));
+        center += corners[i] / 8.0f;
+      }
+      float radius = 0.0f;
+      for(const glm::vec3& corner : corners)
+      {
+        radius = std::max(radius, glm::length(corner - center));
+      }
+      radius = std::ceil(radius * 16.0f) / 16.0f;
+
+      // Move the center by whole texels in the light plane
+      const float     texelSize = 2.0f * radius / float(kShadowMapSize);
+      const glm::mat4 lightRot  = glm::lookAt(glm::vec3(0.0f), -finfo.lightDir, up);
+      glm::vec3       centerLS  = glm::vec3(lightRot * glm::vec4(center, 1.0f));
+      centerLS.x                = std::floor(centerLS.x / texelSize) * texelSize;
+      centerLS.y                = std::floor(centerLS.y / texelSize) * texelSize;
+      center                    = glm::vec3(glm::inverse(lightRot) * glm::vec4(centerLS, 1.0f));
+
+      // The blades between the sun and the slice cast shadows into it
+      const glm::mat4 lightView = glm::lookAt(center + finfo.lightDir * (radius + kShadowCasterMargin), center, up);
+      const glm::mat4 lightProj = glm::orthoRH_ZO(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + kShadowCasterMargin);
+
+      finfo.shadowViewProj[cascade] = lightProj * lightView;
+      calculateFrustumPlanes(lightView, lightProj, finfo.shadowPlanes[cascade]);
+      finfo.shadowSplits[cascade] = splitFar;
+      splitNear                   = splitFar;
+    }
+  }
+
+  // Rebuild the depth pyramid from the depth written by the first pass, the barriers around it come from the graph
+  void buildHizPyramid(VkCommandBuffer cmd)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_hizPipeline);
+
+    VkExtent2D srcSize = m_gBuffers->getSize();
+    for(uint32_t level = 0; level < m_hizImage.mipLevels; level++)
+    {
+      const VkExtent2D dstSize = {std::max(1u, m_hizSize.width >> level), std::max(1u, m_hizSize.height >> level)};
+
+      shaderio::HizPushConstant hizPush{};
+      hizPush.srcSize = {srcSize.width, srcSize.height};
+      hizPush.dstSize = {dstSize.width, dstSize.height};
+      vkCmdPushConstants(cmd, m_hizPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::HizPushConstant), &hizPush);
+
+      // Level 0 reads the depth buffer, the others the previous level
+      nvvk::WriteSetContainer writes(&m_app->getFrameArena().getThreadArena());
+      if(level == 0)
+        writes.append(m_hizBindings.getWriteSet(shaderio::HizBinding::eHizSource), m_gBuffers->getDepthImageView(),
+                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+      else
+        writes.append(m_hizBindings.getWriteSet(shaderio::HizBinding::eHizSource), m_hizLevelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL);
+      writes.append(m_hizBindings.getWriteSet(shaderio::HizBinding::eHizDestination), m_hizLevelViews[level], VK_IMAGE_LAYOUT_GENERAL);
+      vkCmdPushDescriptorSetKHR(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_hizPipelineLayout, 0, writes.size(), writes.data());
+
+      VkExtent2D groupCounts = nvvk::getGroupCounts(dstSize, VkExtent2D{HIZ_WORKGROUP_SIZE, HIZ_WORKGROUP_SIZE});
+      vkCmdDispatch(cmd, groupCounts.width, groupCounts.height, 1);
+
+      // The next level reads this one
+      nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+      srcSize = dstSize;
+    }
+  }
+
+  // The pyramid build and the second occlusion pass, the graph records the barriers around them from their accesses:
+  // the reduction samples the depth of the first pass, the second pass tests the new pyramid, renders to the depth
+  // again and reads the occlusion bits of the first pass. Declared again when the visibility buffer is reallocated.
+  void createOcclusionGraph()
+  {
+    m_occlusionGraph.clear();
+
+    using Graph           = nvvk::RenderGraph;
+    const auto depth      = m_occlusionGraph.importImage(&m_occlusionDepth, VK_IMAGE_ASPECT_DEPTH_BIT, "Depth");
+    const auto hiz        = m_occlusionGraph.importImage(&m_hizImage, VK_IMAGE_ASPECT_COLOR_BIT, "HizPyramid");
+    const auto visibility = m_occlusionGraph.importBuffer(m_visibility, "Visibility");
+
+    m_occlusionGraph
+        .addPass("Hi-Z Pyramid", Graph::QueueType::eGraphics,
+                 [this](VkCommandBuffer cmd, const Graph&) {
+                   auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Hi-Z Pyramid");
+                   NXPROFILEFUNCCOL("Hi-Z Pyramid", kNxColorCompute);
+                   buildHizPyramid(cmd);
+                 })
+        .read(depth, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+        .readWrite(hiz, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+    m_occlusionGraph
+        .addPass("Grass Draw (Occlusion Pass 2)", Graph::QueueType::eGraphics,
+                 [this](VkCommandBuffer cmd, const Graph&) {
+                   auto timerSection = m_profilerGpuTimer.cmdFrameSection(cmd, "Grass Draw (Occlusion Pass 2)");
+                   NXPROFILEFUNCCOL("Grass Draw (Occlusion Pass 2)", kNxColorDraw);
+                   drawGrass(cmd, *m_occlusionFrame.renderingInfo, m_occlusionFrame.pushConst,
+                             m_occlusionFrame.workgroupsX, m_occlusionFrame.workgroupsZ);
+                 })
+        .read(hiz, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT)
+        .readWrite(depth, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+                   VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT)
+        .readWrite(visibility, VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT);
+
+    // Imported resources only, nothing to allocate
+    NVVK_CHECK(m_occlusionGraph.compile({}));
+  }
+
+  void createPipeline()
+  {
+    // Descriptor setup
+    nvvk::DescriptorBindings bindings;
+    bindings.addBinding(shaderio::GrassBinding::eFrameInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_ALL);
+    bindings.addBinding(shaderio::GrassBinding::eHizPyramid, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, m_grassStages);
+    bindings.addBinding(shaderio::GrassBinding::eTerrainMap, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+                        m_grassStages | VK_SHADER_STAGE_COMPUTE_BIT);
+    bindings.addBinding(shaderio::GrassBinding::eTerrainMapStorage, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    bindings.addBinding(shaderio::GrassBinding::eShadowMap, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT);
+    bindings.addBinding(shaderio::GrassBinding::eWindMap, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, m_grassStages);
+    bindings.addBinding(shaderio::GrassBinding::eWindMapStorage, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    bindings.addBinding(shaderio::GrassBinding::eTrampleMap, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, m_grassStages);
+    bindings.addBinding(shaderio::GrassBinding::eTrampleMapStorage, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    bindings.addBinding(shaderio::GrassBinding::eVirtualTerrain, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+                        m_grassStages | VK_SHADER_STAGE_COMPUTE_BIT);
+    bindings.addBinding(shaderio::GrassBinding::eVirtualTerrainStorage, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    // Create the descriptor layout, pool, and 1 set
+    NVVK_CHECK(m_descriptorPack.init(bindings, m_device, 1));
+    NVVK_DBG_NAME(m_descriptorPack.getLayout());
+    NVVK_DBG_NAME(m_descriptorPack.getPool());
+    NVVK_DBG_NAME(m_descriptorPack.getSet(0));
+
+    // Writing to the descriptors
+    nvvk::WriteSetContainer writes{};
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eFrameInfo), m_frameInfo, 0, sizeof(shaderio::FrameInfo));
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eTerrainMap), m_terrainMap);
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eTerrainMapStorage), m_terrainMap);
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eShadowMap), m_shadowMap);
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eWindMap), m_windMap);
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eWindMapStorage), m_windMap);
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eTrampleMap), m_trampleMap);
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eTrampleMapStorage), m_trampleMap);
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eVirtualTerrain), m_virtualAtlas);
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eVirtualTerrainStorage), m_virtualAtlas);
     vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 
-    VkPipelineRenderingCreateInfo prendInfo{VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR};
-    prendInfo.colorAttachmentCount    = 1;
-    prendInfo.pColorAttachmentFormats = &m_colorFormat;
-    prendInfo.depthAttachmentFormat   = m_depthFormat;
+    VkPipelineRenderingCreateInfo prendInfo{VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR};
+    prendInfo.colorAttachmentCount    = 1;
+    prendInfo.pColorAttachmentFormats = &m_colorFormat;
+    prendInfo.depthAttachmentFormat   = m_depthFormat;
+
+    // The push constant information
+    // maxPushConstantsSize is only guaranteed to be 128 bytes, the vertex fallback targets such devices
+    static_assert(sizeof(shaderio::PushConstant) <= 128, "PushConstant exceeds the guaranteed push constant size");
+    const VkPushConstantRange pushConstantRange{
+      .stageFlags = m_grassStages,
+      .offset = 0,
+      .size   = sizeof(shaderio::PushConstant) // 修正为实际结构体大小，确保覆盖所有成员
+    };
+
+    // Create PipelineLayout
+    NVVK_CHECK(nvvk::createPipelineLayout(m_device, &m_pipelineLayout, {m_descriptorPack.getLayout()}, {pushConstantRange}));
+    NVVK_DBG_NAME(m_pipelineLayout);
+
+    // The compute passes of the grass shader share its descriptor set
+    const VkPushConstantRange computePushConstantRange{.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                                                       .size       = sizeof(shaderio::PushConstant)};
+    NVVK_CHECK(nvvk::createPipelineLayout(m_device, &m_computePipelineLayout, {m_descriptorPack.getLayout()}, {computePushConstantRange}));
+    NVVK_DBG_NAME(m_computePipelineLayout);
+
+    createShaderPipelines();
+  }
+
+  // Pipelines depending on the shader code, recreated when the shader variant changes or the shaders are reloaded
+  struct ShaderPipelines
+  {
+    VkPipeline graphics{};
+    VkPipeline terrain{};
+    VkPipeline tileBounds{};
+    VkPipeline tileCull{};
+    VkPipeline fieldCull{};
+    VkPipeline wind{};
+    VkPipeline trample{};
+    VkPipeline virtualTerrain{};
+    VkPipeline ground{};      // Only with the multi entry point shader
+    VkPipeline shadow{};      // Only with the multi entry point shader
+    VkPipeline compactCull{};      // Only with the multi entry point shader
+    VkPipeline compactGraphics{};  // Only with the multi entry point shader
+    uint32_t   viewCount = 1;  // Views of the graphics pipeline (view mask), the rendering must match it
+    uint32_t   taskWorkgroupSize = TASKSHADER_WORKGROUP_SIZE;  // Patches per task workgroup, the dispatches must match it
+  };
+
+  ShaderPipelines getShaderPipelines() const
+  {
+    return {m_pipeline,        m_terrainPipeline, m_tileBoundsPipeline, m_tileCullPipeline,    m_fieldCullPipeline,
+            m_windPipeline,    m_tramplePipeline, m_virtualTerrainPipeline, m_groundPipeline, m_shadowPipeline,
+            m_compactCullPipeline, m_compactPipeline, m_pipelineViewCount, m_pipelineTaskSize};
+  }
+
+  // Compile-time options of the grass shader
+  struct ShaderVariant
+  {
+    bool     bladeCache    = true;   // MESH_BLADE_CACHE
+    bool     compactOutput = true;   // MESH_COMPACT_OUTPUT
+    bool     shadingRate   = false;  // MESH_SHADING_RATE
+    uint32_t viewCount     = 1;      // MESH_MULTIVIEW when more than one
+    bool     half          = false;  // MESH_HALF
+    bool     halfOutputs   = false;  // MESH_HALF_INTERPOLANTS
+    bool     debugView     = false;  // MESH_DEBUG_VIEW
+  };
+
+  ShaderVariant getShaderVariant() const
+  {
+    const uint32_t viewCounts[] = {1, 2, shaderio::MULTIVIEW_MAX_VIEWS};
+    const bool     half         = m_useHalf && m_supportsHalf;
+    return {m_useBladeCache, m_useCompactOutput, m_useShadingRate, viewCounts[m_multiviewMode],
+            half, half && m_supportsHalfInterpolants, m_debugView != shaderio::eDebugViewNone};
+  }
+
+  // Key of the grass shader permutations: a bit per variant feature (the view count isn't compiled in), and the
+  // blades per mesh in the upper bits, which the mesh outputs depend on so a fallback permutation must match them.
+  // The workgroup sizes are specialization constants set when creating the pipelines, not part of the key.
+  static constexpr uint64_t kPermutationBladeCache    = 1ull << 0;
+  static constexpr uint64_t kPermutationCompactOutput = 1ull << 1;
+  static constexpr uint64_t kPermutationShadingRate   = 1ull << 2;
+  static constexpr uint64_t kPermutationMultiview     = 1ull << 3;
+  static constexpr uint64_t kPermutationHalf          = 1ull << 4;
+  static constexpr uint64_t kPermutationHalfOutputs   = 1ull << 5;
+  static constexpr uint64_t kPermutationDebugView     = 1ull << 6;
+  static constexpr uint64_t kPermutationConfigMask    = 0xFFull << 48;
+
+  static uint64_t getPermutationMask(const ShaderVariant& variant, uint32_t bladesPerMesh)
+  {
+    return (variant.bladeCache ? kPermutationBladeCache : 0) | (variant.compactOutput ? kPermutationCompactOutput : 0)
+           | (variant.shadingRate ? kPermutationShadingRate : 0) | (variant.viewCount > 1 ? kPermutationMultiview : 0)
+           | (variant.half ? kPermutationHalf : 0) | (variant.halfOutputs ? kPermutationHalfOutputs : 0)
+           | (variant.debugView ? kPermutationDebugView : 0) | (uint64_t(bladesPerMesh) << 48);
+  }
+
+  // Task workgroup size to specialize: the subgroup size unless set, within the device limits and the 8-bit payload indices
+  uint32_t getTaskWorkgroupSize() const
+  {
+    const uint32_t size = m_taskWorkgroupSize > 0 ? uint32_t(m_taskWorkgroupSize) : m_device11Props.subgroupSize;
+    return std::min({size, kMaxTaskWorkgroupSize, m_meshShaderProps.maxTaskWorkGroupInvocations, m_meshShaderProps.maxTaskWorkGroupSize[0]});
+  }
+
+  // Subgroup size required for the task stages, 0 to leave it to the driver
+  uint32_t getTaskSubgroupSize() const { return m_supportsTaskSubgroupSize ? m_device11Props.subgroupSize : 0; }
+
+  uint64_t getPermutationMask(const ShaderVariant& variant) const
+  {
+    return getPermutationMask(variant, m_meshConfig.bladesPerMesh);
+  }
+
+  // The pre-compiled shader has the defaults of the shader headers
+  static uint64_t getEmbeddedPermutationMask()
+  {
+    return getPermutationMask(ShaderVariant{}, MeshConfig{}.bladesPerMesh);
+  }
+
+  static nvslang::ShaderPermutations::MacroList getPermutationMacros(uint64_t mask)
+  {
+    auto flag = [mask](uint64_t bit) -> std::string { return (mask & bit) ? "1" : "0"; };
+    return {
+        {"GRASS_BLADES_PER_MESH", std::to_string((mask >> 48) & 0xFF)},
+        {"MESH_BLADE_CACHE", flag(kPermutationBladeCache)},
+        {"MESH_COMPACT_OUTPUT", flag(kPermutationCompactOutput)},
+        {"MESH_SHADING_RATE", flag(kPermutationShadingRate)},
+        {"MESH_MULTIVIEW", flag(kPermutationMultiview)},
+        {"MESH_HALF", flag(kPermutationHalf)},
+        {"MESH_HALF_INTERPOLANTS", flag(kPermutationHalfOutputs)},
+        {"MESH_DEBUG_VIEW", flag(kPermutationDebugView)},
+    };
+  }
+
+  // Variant the pipelines are built for, its SPIR-V (Slang multi entry point only) and the specialized workgroup sizes
+  struct ShaderCode
+  {
+    ShaderVariant             variant;
+    std::span<const uint32_t> spirv;
+    uint32_t                  taskWorkgroupSize = TASKSHADER_WORKGROUP_SIZE;
+    uint32_t                  meshWorkgroupSize = MESHSHADER_WORKGROUP_SIZE;
+  };
+
+  // The selected variant when compiled. Otherwise the nearest compiled permutation with the same blades per mesh
+  // is rendered until onPreRender switches to the selected one. Waits for the compilation without async shaders,
+  // while auto-tuning which times each configuration, and when no permutation matches yet.
+  ShaderCode getShaderCode()
+  {
+    ShaderCode code{getShaderVariant(), {}, getTaskWorkgroupSize(), m_meshConfig.workgroupSize};
+#if USE_SLANG && MULTI_ENTRY_POINTS
+    if(!m_supportsMeshShaders)
+    {
+      return code;
+    }
+    const uint64_t                           mask        = getPermutationMask(code.variant);
+    nvslang::ShaderPermutations::Permutation permutation = m_shaderPermutations.get(mask);
+    if(!permutation.exact && (!m_asyncShaders || m_tuning.active || permutation.spirv.empty()))
+    {
+      m_shaderPermutations.wait();
+      permutation = m_shaderPermutations.get(mask);
+    }
+    if(permutation.spirv.empty())
+    {
+      LOGW("mesh_task.slang has no compiled permutation 0x%llx, using the pre-compiled shader\n", (unsigned long long)mask);
+      permutation = {getEmbeddedPermutationMask(), mesh_task_slang, false, 0};
+    }
+
+    // The pipeline state follows the features of the permutation
+    code.variant.bladeCache    = (permutation.mask & kPermutationBladeCache) != 0;
+    code.variant.compactOutput = (permutation.mask & kPermutationCompactOutput) != 0;
+    code.variant.shadingRate   = (permutation.mask & kPermutationShadingRate) != 0;
+    code.variant.viewCount     = (permutation.mask & kPermutationMultiview) ? code.variant.viewCount : 1;
+    code.variant.half          = (permutation.mask & kPermutationHalf) != 0;
+    code.variant.halfOutputs   = (permutation.mask & kPermutationHalfOutputs) != 0;
+    code.variant.debugView     = (permutation.mask & kPermutationDebugView) != 0;
+    code.spirv                 = permutation.spirv;
+    m_shaderGeneration         = permutation.generation;
+#endif
+    return code;
+  }
+
+  void createShaderPipelines()
+  {
+    m_pipelineDirty = false;
+
+    const ShaderPipelines pipelines = buildShaderPipelines(getShaderCode());
+    m_pipeline                      = pipelines.graphics;
+    m_terrainPipeline               = pipelines.terrain;
+    m_tileBoundsPipeline            = pipelines.tileBounds;
+    m_tileCullPipeline              = pipelines.tileCull;
+    m_fieldCullPipeline             = pipelines.fieldCull;
+    m_windPipeline                  = pipelines.wind;
+    m_tramplePipeline               = pipelines.trample;
+    m_virtualTerrainPipeline        = pipelines.virtualTerrain;
+    m_groundPipeline                = pipelines.ground;
+    m_shadowPipeline                = pipelines.shadow;
+    m_compactCullPipeline           = pipelines.compactCull;
+    m_compactPipeline               = pipelines.compactGraphics;
+    m_pipelineViewCount             = pipelines.viewCount;
+    m_pipelineTaskSize              = pipelines.taskWorkgroupSize;
+  }
+
+  // Hot swap of the pipelines built from new SPIR-V, the old ones are freed once no frame in flight uses them
+  void swapShaderPipelines(const ShaderPipelines& pipelines)
+  {
+    const ShaderPipelines oldPipelines = getShaderPipelines();
+    m_pipeline                         = pipelines.graphics;
+    m_terrainPipeline                  = pipelines.terrain;
+    m_tileBoundsPipeline               = pipelines.tileBounds;
+    m_tileCullPipeline                 = pipelines.tileCull;
+    m_fieldCullPipeline                = pipelines.fieldCull;
+    m_windPipeline                     = pipelines.wind;
+    m_tramplePipeline                  = pipelines.trample;
+    m_virtualTerrainPipeline           = pipelines.virtualTerrain;
+    m_groundPipeline                   = pipelines.ground;
+    m_shadowPipeline                   = pipelines.shadow;
+    m_compactCullPipeline              = pipelines.compactCull;
+    m_compactPipeline                  = pipelines.compactGraphics;
+    m_pipelineViewCount                = pipelines.viewCount;
+    m_pipelineTaskSize                 = pipelines.taskWorkgroupSize;
+    m_app->submitResourceFree([this, oldPipelines]() { destroyShaderPipelines(oldPipelines); });
+    LOGI("Shader pipelines updated\n");
+  }
+
+  void destroyShaderPipelines(const ShaderPipelines& pipelines) const
+  {
+    vkDestroyPipeline(m_device, pipelines.graphics, nullptr);
+    vkDestroyPipeline(m_device, pipelines.terrain, nullptr);
+    vkDestroyPipeline(m_device, pipelines.tileBounds, nullptr);
+    vkDestroyPipeline(m_device, pipelines.tileCull, nullptr);
+    vkDestroyPipeline(m_device, pipelines.fieldCull, nullptr);
+    vkDestroyPipeline(m_device, pipelines.wind, nullptr);
+    vkDestroyPipeline(m_device, pipelines.trample, nullptr);
+    vkDestroyPipeline(m_device, pipelines.virtualTerrain, nullptr);
+    vkDestroyPipeline(m_device, pipelines.ground, nullptr);
+    vkDestroyPipeline(m_device, pipelines.shadow, nullptr);
+    vkDestroyPipeline(m_device, pipelines.compactCull, nullptr);
+    vkDestroyPipeline(m_device, pipelines.compactGraphics, nullptr);
+  }
+
+  // Builds the pipelines of the grass shader, from the SPIR-V of `code` with the Slang multi entry point shader
+  ShaderPipelines buildShaderPipelines(const ShaderCode& code)
+  {
+    const ShaderVariant& variant = code.variant;
+    ShaderPipelines      pipelines;
+
+    // The SPIR-V declares the mesh shading capability, only the vertex shader fallback can be created
+    if(!m_supportsMeshShaders)
+    {
+      return pipelines;
+    }
+
+    // Creating the Pipeline with mesh shaders
+    nvvk::GraphicsPipelineState graphicState    = m_graphicState;
+    graphicState.rasterizationState.cullMode    = VK_CULL_MODE_NONE;
+    graphicState.rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;  // Solid fill mode for grass rendering
+
+    // Helper to create the graphic pipeline
+    nvvk::GraphicsPipelineCreator creator;
+    creator.pipelineInfo.layout                  = m_pipelineLayout;
+    creator.colorFormats                         = {m_colorFormat};
+    creator.renderingState.depthAttachmentFormat = m_depthFormat;
+    creator.renderingState.viewMask              = variant.viewCount > 1 ? (1u << variant.viewCount) - 1 : 0;
+    pipelines.viewCount                          = variant.viewCount;
+    pipelines.taskWorkgroupSize                  = code.taskWorkgroupSize;
+
+    // Workgroup sizes of every entry point of the shader
+    nvvk::Specialization specialization;
+    specialization.add(shaderio::eSpecTaskWorkgroupSize, int32_t(code.taskWorkgroupSize));
+    specialization.add(shaderio::eSpecMeshWorkgroupSize, int32_t(code.meshWorkgroupSize));
+    const VkSpecializationInfo* specInfo = specialization.getSpecializationInfo();
+
+    // The default combiners keep the pipeline rate (1x1), the primitive rate of the mesh shader must replace it
+    VkPipelineFragmentShadingRateStateCreateInfoKHR shadingRateState{
+        .sType        = VK_STRUCTURE_TYPE_PIPELINE_FRAGMENT_SHADING_RATE_STATE_CREATE_INFO_KHR,
+        .fragmentSize = {1, 1},
+        .combinerOps  = {VK_FRAGMENT_SHADING_RATE_COMBINER_OP_REPLACE_KHR, VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR},
+    };
+    if(variant.shadingRate)
+    {
+      creator.pipelineInfo.pNext = &shadingRateState;
+    }
+
+    // Adding the shaders to the pipeline (mesh shaders instead of vertex)
+#if USE_SLANG
+
+#if MULTI_ENTRY_POINTS
+    const size_t    codeSize = code.spirv.size_bytes();
+    const uint32_t* spirv    = code.spirv.data();
+    creator.addShader(VK_SHADER_STAGE_TASK_BIT_EXT, "taskMain", codeSize, spirv, specInfo, getTaskSubgroupSize());
+    creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "meshMain", codeSize, spirv, specInfo);
+    creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentMain", codeSize, spirv);
+    createComputePipelines(pipelines, codeSize, spirv, specInfo);
+    createShadowPipeline(pipelines, codeSize, spirv, specInfo);
+    createGroundPipeline(pipelines, codeSize, spirv, specInfo);
+#else
+    creator.addShader(VK_SHADER_STAGE_TASK_BIT_EXT, "taskMain", mesh_task_task_slang, specInfo, getTaskSubgroupSize());
+    creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "meshMain", mesh_task_mesh_slang, specInfo);
+    creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentMain", mesh_task_frag_slang);
+#endif
+#else
+    creator.addShader(VK_SHADER_STAGE_TASK_BIT_EXT, "main", mesh_task_task_glsl);
+    creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "main", mesh_task_mesh_glsl);
+    creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "main", mesh_task_frag_glsl);
+#endif
+
+    creator.debugName = "Grass";
+
+    NVVK_CHECK(creator.createGraphicsPipeline(m_device, m_pipelineCache, graphicState, &pipelines.graphics));
+
+#if USE_SLANG && MULTI_ENTRY_POINTS
+    // Same state for the blades of the global compaction, drawn by the mesh shader alone
+    creator.clearShaders();
+    creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "compactMeshMain", codeSize, spirv, specInfo);
+    creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentMain", codeSize, spirv);
+    creator.debugName = "Grass Compaction";
+    NVVK_CHECK(creator.createGraphicsPipeline(m_device, m_pipelineCache, graphicState, &pipelines.compactGraphics));
+#endif
+    return pipelines;
+  }
+
+  // Compute pipelines of the grass shader (terrain bake, tile bounds, tile and field culling, wind, trampling
+  // and virtual terrain pages),
+  // sharing the descriptor set of the grass pipeline
+  void createComputePipelines(ShaderPipelines& pipelines, size_t codeSize, const uint32_t* code, const VkSpecializationInfo* specInfo) const
+  {
+    VkShaderModuleCreateInfo shaderInfo{.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, .codeSize = codeSize, .pCode = code};
+
+    VkComputePipelineCreateInfo compInfo{
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = {.sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                   .pNext               = &shaderInfo,
+                   .stage               = VK_SHADER_STAGE_COMPUTE_BIT,
+                   .pName               = "terrainBakeMain",
+                   .pSpecializationInfo = specInfo},
+        .layout = m_computePipelineLayout,
+    };
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &pipelines.terrain, "Terrain Bake"));
+
+    compInfo.stage.pName = "tileBoundsMain";
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &pipelines.tileBounds, "Tile Bounds"));
+
+    compInfo.stage.pName = "tileCullMain";
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &pipelines.tileCull, "Tile Culling"));
+
+    compInfo.stage.pName = "fieldCullMain";
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &pipelines.fieldCull, "Field Culling"));
+
+    compInfo.stage.pName = "windMain";
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &pipelines.wind, "Wind Map"));
+
+    compInfo.stage.pName = "trampleMain";
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &pipelines.trample, "Trample Map"));
+
+    compInfo.stage.pName = "virtualTerrainMain";
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &pipelines.virtualTerrain, "Virtual Terrain"));
+
+    compInfo.stage.pName = "compactCullMain";
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &pipelines.compactCull, "Compaction Culling"));
+  }
+
+  // Depth-only pipeline of the shadow pass, the task and mesh shaders without a fragment stage
+  void createShadowPipeline(ShaderPipelines& pipelines, size_t codeSize, const uint32_t* code, const VkSpecializationInfo* specInfo) const
+  {
+    nvvk::GraphicsPipelineState shadowState                = m_graphicState;
+    shadowState.rasterizationState.cullMode                = VK_CULL_MODE_NONE;
+    shadowState.rasterizationState.depthBiasEnable         = VK_TRUE;
+    shadowState.rasterizationState.depthBiasConstantFactor = 1.0f;
+    shadowState.rasterizationState.depthBiasSlopeFactor    = 1.5f;
+    shadowState.colorBlendEnables.clear();
+    shadowState.colorWriteMasks.clear();
+    shadowState.colorBlendEquations.clear();
+
+    nvvk::GraphicsPipelineCreator creator;
+    creator.pipelineInfo.layout                  = m_pipelineLayout;
+    creator.colorFormats                         = {};
+    creator.renderingState.depthAttachmentFormat = kShadowMapFormat;
+    creator.addShader(VK_SHADER_STAGE_TASK_BIT_EXT, "shadowTaskMain", codeSize, code, specInfo, getTaskSubgroupSize());
+    creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "shadowMeshMain", codeSize, code, specInfo);
+
+    creator.debugName = "Grass Shadow";
+
+    NVVK_CHECK(creator.createGraphicsPipeline(m_device, m_pipelineCache, shadowState, &pipelines.shadow));
+  }
+
+  // Terrain surface pipeline, drawn in the single view pass before the grass
+  void createGroundPipeline(ShaderPipelines& pipelines, size_t codeSize, const uint32_t* code, const VkSpecializationInfo* specInfo) const
+  {
+    nvvk::GraphicsPipelineState groundState    = m_graphicState;
+    groundState.rasterizationState.cullMode    = VK_CULL_MODE_NONE;
+    groundState.rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+
+    nvvk::GraphicsPipelineCreator creator;
+    creator.pipelineInfo.layout                  = m_pipelineLayout;
+    creator.colorFormats                         = {m_colorFormat};
+    creator.renderingState.depthAttachmentFormat = m_depthFormat;
+    creator.addShader(VK_SHADER_STAGE_TASK_BIT_EXT, "groundTaskMain", codeSize, code);
+    creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "groundMeshMain", codeSize, code, specInfo);
+    creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "groundFragmentMain", codeSize, code);
+
+    creator.debugName = "Ground";
+
+    NVVK_CHECK(creator.createGraphicsPipeline(m_device, m_pipelineCache, groundState, &pipelines.ground));
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  // Auto-tuning of the mesh workgroup
+  //
+  // Each candidate configuration is built (compiled for new blades per mesh) and the grass draws are timed for kTuningFrames frames
+  // with the GPU timers. The fastest is kept and stored with the vendor, device and driver version.
+  //
+  void startMeshTuning()
+  {
+    m_tuning = {};
+
+    // Full detail blades must fit the output limits, lower LODs pack into the same vertices and primitives
+    const uint32_t verticesPerBlade   = (shaderio::GRASS_SEGMENTS + 1) * 2;
+    const uint32_t primitivesPerBlade = shaderio::GRASS_SEGMENTS * 2;
+    for(uint32_t bladesPerMesh : {4u, 8u, 12u, 16u, 24u, 32u})
+    {
+      const uint32_t vertices   = bladesPerMesh * verticesPerBlade;
+      const uint32_t primitives = bladesPerMesh * primitivesPerBlade;
+      if(vertices > m_meshShaderProps.maxMeshOutputVertices || primitives > m_meshShaderProps.maxMeshOutputPrimitives
+         || getMeshOutputMemory(vertices, primitives) > m_meshShaderProps.maxMeshOutputMemorySize)
+      {
+        continue;
+      }
+      for(uint32_t workgroupSize : {32u, 64u, 128u})
+      {
+        if(workgroupSize <= m_meshShaderProps.maxMeshWorkGroupInvocations && workgroupSize <= m_meshShaderProps.maxMeshWorkGroupSize[0])
+        {
+          m_tuning.candidates.push_back({.config = {bladesPerMesh, workgroupSize}});
+        }
+      }
+    }
+    m_tuning.original = m_meshConfig;
+    m_tuning.active   = !m_tuning.candidates.empty();
+  }
+
+  // Output memory of a mesh workgroup as counted against maxMeshOutputMemorySize, estimated with the vec4
+  // attribute slots of the outputs: 4 per vertex, or 2 per vertex and 1 per primitive in the compact layout,
+  // and the indices of each primitive
+  uint32_t getMeshOutputMemory(uint32_t vertices, uint32_t primitives) const
+  {
+    const uint32_t vertexGranularity    = std::max(m_meshShaderProps.meshOutputPerVertexGranularity, 1u);
+    const uint32_t primitiveGranularity = std::max(m_meshShaderProps.meshOutputPerPrimitiveGranularity, 1u);
+    const uint32_t alignedVertices      = (vertices + vertexGranularity - 1) / vertexGranularity * vertexGranularity;
+    const uint32_t alignedPrimitives    = (primitives + primitiveGranularity - 1) / primitiveGranularity * primitiveGranularity;
+    const uint32_t vertexSlots          = m_useCompactOutput ? 2 : 4;
+    const uint32_t primitiveSlots       = ((m_useCompactOutput || m_useShadingRate) ? 1 : 0) + (m_debugView != shaderio::eDebugViewNone ? 1 : 0);
+    return alignedVertices * vertexSlots * 16 + alignedPrimitives * (primitiveSlots + 1) * 16;
+  }
+
+  // Feedback of the frame time budget, from the GPU time of the grass sections of the last completed frame:
+  // the density moves part of the way toward the one of the target (the time is about proportional to the blades),
+  // only outside of a band around the target so it settles instead of oscillating, and is kept while auto-tuning
+  void updateDensityBudget()
+  {
+    if(!m_useDensityBudget)
+    {
+      m_densityScale = 1.0f;
+      return;
+    }
+    if(m_tuning.active)
+    {
+      return;
+    }
+
+    const double gpuTime = getLastGpuTime({"Shadow Maps", "Grass Draw", "Grass Draw (Occlusion Pass 2)", "Fields Draw"});
+    const double target  = double(m_densityBudgetMs) * 1000.0;
+    if(gpuTime <= 0 || (gpuTime < target * kDensityBudgetOver && gpuTime > target * kDensityBudgetUnder))
+    {
+      return;
+    }
+
+    const float ratio = std::clamp(float(target / gpuTime), 0.5f, 2.0f);
+    m_densityScale    = std::clamp(m_densityScale * glm::mix(1.0f, ratio, kDensityBudgetGain), kDensityMinScale, 1.0f);
+  }
+
+  // GPU time (microseconds) of frame sections in the last completed frame, 0 when none was measured yet
+  double getLastGpuTime(std::initializer_list<const char*> sections) const
+  {
+    double gpuTime = 0;
+    for(const char* section : sections)
+    {
+      nvutils::ProfilerTimeline::TimerInfo info;
+      std::string                          apiName;
+      if(m_profilerTimeline->getFrameTimerInfo(section, info, apiName) && info.numAveraged > 0)
+      {
+        gpuTime += info.gpu.last;
+      }
+    }
+    return gpuTime;
+  }
+
+  // Dynamic resolution, from the GPU time of the draws into the GBuffer: the rendered area is about proportional
+  // to the time of these fill-rate bound draws, the scale corrects part of the way with the hysteresis of the density budget
+  void updateRenderScale()
+  {
+    if(!m_useDynamicResolution)
+    {
+      m_gBuffers->setRenderScale(m_renderScale);
+      return;
+    }
+    if(m_tuning.active)
+    {
+      return;
+    }
+
+    const double gpuTime = getLastGpuTime({"Ground Draw", "Grass Draw", "Grass Draw (Occlusion Pass 2)", "Fields Draw"});
+    const double target  = double(m_resolutionBudgetMs) * 1000.0;
+    if(gpuTime <= 0 || (gpuTime < target * kDensityBudgetOver && gpuTime > target * kDensityBudgetUnder))
+    {
+      return;
+    }
+
+    const float ratio = std::clamp(float(std::sqrt(target / gpuTime)), 0.7f, 1.4f);
+    const float scale = m_gBuffers->getRenderScale() * glm::mix(1.0f, ratio, kDensityBudgetGain);
+    m_gBuffers->setRenderScale(std::clamp(scale, kMinRenderScale, 1.0f));
+  }
+
+  // Side by side GPU times of the two grass paths, alternated by isVertexPathActive. The first frames of each
+  // path are skipped: the timers of the last completed frame lag behind the frames recorded with the new path.
+  // Only the cull pass of the mesh shader path in use is timed, its task shaders cull within the draw.
+  void updatePathComparison()
+  {
+    if(!m_comparePaths || m_frameNumber % kPathCompareFrames < kPathCompareWarmup)
+    {
+      return;
+    }
+
+    const bool   vertexPath = isVertexPathActive();
+    const double drawTime   = getLastGpuTime({"Grass Draw", "Grass Draw (Occlusion Pass 2)"});
+    double       cullTime   = 0;
+    if(vertexPath)
+    {
+      cullTime = getLastGpuTime({"Vertex Cull"});
+    }
+    else if(m_useGlobalCompaction)
+    {
+      cullTime = getLastGpuTime({"Blade Compaction"});
+    }
+    else if(m_useTileCulling)
+    {
+      cullTime = getLastGpuTime({"Tile Culling"});
+    }
+
+    PathTiming& timing = m_pathTimings[vertexPath ? 1 : 0];
+    if(drawTime > 0)
+    {
+      timing.cullMs += cullTime / 1000.0;
+      timing.drawMs += drawTime / 1000.0;
+      timing.frames++;
+    }
+  }
+
+  // The GBuffer is rendered below the viewport size and upscaled into the display buffer
+  bool isUpscaled() const
+  {
+    const VkExtent2D size = m_gBuffers->getSize();
+    const VkExtent2D full = m_gBuffers->getDisplaySize();
+    return size.width != full.width || size.height != full.height;
+  }
+
+  const nvvk::GBuffer& getDisplayBuffer() const { return isUpscaled() ? *m_displayBuffer : *m_gBuffers; }
+
+  // Upscales the rendered rectangle of the GBuffer to the display buffer, both kept in GENERAL layout
+  void upscale(VkCommandBuffer cmd)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT
+                                    | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                           VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
 
-    // The push constant information
-    const VkPushConstantRange pushConstantRange{
-      .stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT,
-      .offset = 0,
-      .size   = sizeof(shaderio::PushConstant) // 修正为实际结构体大小，确保覆盖所有成员
+    const VkExtent2D srcSize = m_gBuffers->getSize();
+    const VkExtent2D dstSize = m_displayBuffer->getSize();
+
+    shaderio::UpscalePushConstant upscalePush{};
+    upscalePush.srcSize   = {srcSize.width, srcSize.height};
+    upscalePush.dstSize   = {dstSize.width, dstSize.height};
+    upscalePush.uvScale   = m_gBuffers->getUVScale();
+    upscalePush.sharpness = m_upscaleSharpness;
+
+    nvvk::WriteSetContainer writes(&m_app->getFrameArena().getThreadArena());
+    writes.append(m_upscaleBindings.getWriteSet(shaderio::UpscaleBinding::eUpscaleSource), m_gBuffers->getDescriptorImageInfo());
+    writes.append(m_upscaleBindings.getWriteSet(shaderio::UpscaleBinding::eUpscaleDestination), m_displayBuffer->getColorImageView(),
+                  VK_IMAGE_LAYOUT_GENERAL);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_upscalePipeline);
+    vkCmdPushDescriptorSetKHR(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_upscalePipelineLayout, 0, writes.size(), writes.data());
+    vkCmdPushConstants(cmd, m_upscalePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::UpscalePushConstant), &upscalePush);
+    VkExtent2D groupCounts = nvvk::getGroupCounts(dstSize, VkExtent2D{UPSCALE_WORKGROUP_SIZE, UPSCALE_WORKGROUP_SIZE});
+    vkCmdDispatch(cmd, groupCounts.width, groupCounts.height, 1);
+
+    // Read by the UI and the screenshot
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+  }
+
+  // Called each frame while tuning, before the pipelines are rebuilt
+  void advanceMeshTuning()
+  {
+    MeshTuning::Candidate& candidate = m_tuning.candidates[m_tuning.current];
+    if(m_tuning.frame == 0)
+    {
+      m_meshConfig    = candidate.config;
+      m_pipelineDirty = true;
+      // Hide the frames still rendered with the previous configuration
+      m_profilerTimeline->resetFrameSections(kTuningWarmupFrames);
+    }
+
+    if(++m_tuning.frame <= kTuningFrames)
+    {
+      return;
+    }
+
+    // Both occlusion passes and the extra fields are grass draws
+    candidate.gpuTime = 0;
+    for(const char* section : {"Grass Draw", "Grass Draw (Occlusion Pass 2)", "Fields Draw"})
+    {
+      nvutils::ProfilerTimeline::TimerInfo info;
+      std::string                          apiName;
+      if(m_profilerTimeline->getFrameTimerInfo(section, info, apiName))
+      {
+        candidate.gpuTime += info.gpu.average;
+      }
+    }
+    LOGI("Mesh workgroup %u blades, %u threads: %.1f us\n", candidate.config.bladesPerMesh, candidate.config.workgroupSize,
+         candidate.gpuTime);
+
+    m_tuning.frame = 0;
+    if(++m_tuning.current < m_tuning.candidates.size())
+    {
+      return;
+    }
+
+    // Done, the fastest measured configuration wins
+    auto measured = [](const MeshTuning::Candidate& c) { return c.gpuTime > 0 ? c.gpuTime : std::numeric_limits<double>::max(); };
+    auto best     = std::min_element(m_tuning.candidates.begin(), m_tuning.candidates.end(),
+                                     [&](const auto& a, const auto& b) { return measured(a) < measured(b); });
+    m_tuning.active = false;
+    m_pipelineDirty = true;
+    if(best->gpuTime <= 0)
+    {
+      LOGW("Mesh workgroup auto-tuning got no GPU timings, keeping the previous configuration\n");
+      m_meshConfig = m_tuning.original;
+      return;
+    }
+    m_meshConfig = best->config;
+    LOGI("Mesh workgroup auto-tuning: %u blades, %u threads\n", m_meshConfig.bladesPerMesh, m_meshConfig.workgroupSize);
+    saveMeshTuning();
+  }
+
+  // One line per device: vendorID deviceID driverVersion bladesPerMesh workgroupSize
+  std::filesystem::path getMeshTuningFilename() const
+  {
+    return nvutils::getExecutablePath().replace_extension(".meshtuning");
+  }
+
+  void loadMeshTuning()
+  {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_app->getPhysicalDevice(), &properties);
+
+    std::ifstream file(getMeshTuningFilename());
+    uint32_t      vendorID, deviceID, driverVersion;
+    MeshConfig    config;
+    while(file >> vendorID >> deviceID >> driverVersion >> config.bladesPerMesh >> config.workgroupSize)
+    {
+      if(vendorID == properties.vendorID && deviceID == properties.deviceID && driverVersion == properties.driverVersion)
+      {
+        m_meshConfig = config;
+        LOGI("Mesh workgroup from auto-tuning: %u blades, %u threads\n", config.bladesPerMesh, config.workgroupSize);
+        return;
+      }
+    }
+  }
+
+  void saveMeshTuning() const
+  {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_app->getPhysicalDevice(), &properties);
+
+    // Keep the results of the other devices
+    std::vector<std::string> lines;
+    {
+      std::ifstream file(getMeshTuningFilename());
+      uint32_t      vendorID, deviceID, driverVersion;
+      MeshConfig    config;
+      while(file >> vendorID >> deviceID >> driverVersion >> config.bladesPerMesh >> config.workgroupSize)
+      {
+        if(vendorID != properties.vendorID || deviceID != properties.deviceID || driverVersion != properties.driverVersion)
+        {
+          lines.push_back(fmt::format("{} {} {} {} {}", vendorID, deviceID, driverVersion, config.bladesPerMesh, config.workgroupSize));
+        }
+      }
+    }
+    lines.push_back(fmt::format("{} {} {} {} {}", properties.vendorID, properties.deviceID, properties.driverVersion,
+                                m_meshConfig.bladesPerMesh, m_meshConfig.workgroupSize));
+
+    std::ofstream file(getMeshTuningFilename());
+    for(const std::string& line : lines)
+    {
+      file << line << "\n";
+    }
+  }
+
+  // Compute pipeline reducing the depth into the Hi-Z pyramid, one level per dispatch
+  void createHizPipeline()
+  {
+    VkShaderModuleCreateInfo shaderInfo{.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    m_slangCompiler.clearMacros();
+    if(m_slangCompiler.compileFile("hiz.slang"))
+    {
+      shaderInfo.codeSize = m_slangCompiler.getSpirvSize();
+      shaderInfo.pCode    = m_slangCompiler.getSpirv();
+    }
+    else
+    {
+      shaderInfo.codeSize = sizeof(hiz_slang);
+      shaderInfo.pCode    = hiz_slang;
+    }
+
+    // The layout comes from the shader, descriptors are pushed per level
+    nvvk::ShaderReflection reflection;
+    reflection.addModule({shaderInfo.pCode, shaderInfo.codeSize / sizeof(uint32_t)});
+    m_hizBindings.clear();
+    reflection.getSetBindings(0, m_hizBindings);
+    const VkDescriptorSetLayoutCreateFlags setFlags[] = {VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR};
+    NVVK_CHECK(m_layoutCache.getPipelineLayout(reflection, &m_hizPipelineLayout, nullptr, setFlags));
+    NVVK_DBG_NAME(m_hizPipelineLayout);
+    assert(reflection.getPushConstantRange().size == sizeof(shaderio::HizPushConstant));
+
+    VkComputePipelineCreateInfo compInfo{
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                   .pNext = &shaderInfo,
+                   .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                   .pName = "hizReduceMain"},
+        .layout = m_hizPipelineLayout,
     };
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &m_hizPipeline, "Hi-Z Pyramid"));
+  }
 
-    // Create PipelineLayout
-    NVVK_CHECK(nvvk::createPipelineLayout(m_device, &m_pipelineLayout, {m_descriptorPack.getLayout()}, {pushConstantRange}));
-    NVVK_DBG_NAME(m_pipelineLayout);
+  // Compute pipeline of the upscale of the dynamic resolution
+  void createUpscalePipeline()
+  {
+    VkShaderModuleCreateInfo shaderInfo{.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    m_slangCompiler.clearMacros();
+    if(m_slangCompiler.compileFile("upscale.slang"))
+    {
+      shaderInfo.codeSize = m_slangCompiler.getSpirvSize();
+      shaderInfo.pCode    = m_slangCompiler.getSpirv();
+    }
+    else
+    {
+      shaderInfo.codeSize = sizeof(upscale_slang);
+      shaderInfo.pCode    = upscale_slang;
+    }
 
-    // Creating the Pipeline with mesh shaders
-    m_graphicState.rasterizationState.cullMode    = VK_CULL_MODE_NONE;
-    m_graphicState.rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;  // Solid fill mode for grass rendering
+    // The layout comes from the shader, descriptors are pushed
+    nvvk::ShaderReflection reflection;
+    reflection.addModule({shaderInfo.pCode, shaderInfo.codeSize / sizeof(uint32_t)});
+    m_upscaleBindings.clear();
+    reflection.getSetBindings(0, m_upscaleBindings);
+    const VkDescriptorSetLayoutCreateFlags setFlags[] = {VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR};
+    NVVK_CHECK(m_layoutCache.getPipelineLayout(reflection, &m_upscalePipelineLayout, nullptr, setFlags));
+    NVVK_DBG_NAME(m_upscalePipelineLayout);
+    assert(reflection.getPushConstantRange().size == sizeof(shaderio::UpscalePushConstant));
+
+    VkComputePipelineCreateInfo compInfo{
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                   .pNext = &shaderInfo,
+                   .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                   .pName = "upscaleMain"},
+        .layout = m_upscalePipelineLayout,
+    };
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &m_upscalePipeline, "Upscale"));
+  }
+
+  // Cull and draw pipelines of the vertex shader fallback, from their own shader without mesh shading capability.
+  // They share the layouts of the grass passes, the blades are pulled from the compaction buffer.
+  void createVertexPipelines()
+  {
+    VkShaderModuleCreateInfo shaderInfo{.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    m_slangCompiler.clearMacros();
+    if(m_slangCompiler.compileFile("grass_vertex.slang"))
+    {
+      shaderInfo.codeSize = m_slangCompiler.getSpirvSize();
+      shaderInfo.pCode    = m_slangCompiler.getSpirv();
+    }
+    else
+    {
+      shaderInfo.codeSize = sizeof(grass_vertex_slang);
+      shaderInfo.pCode    = grass_vertex_slang;
+    }
+
+    VkComputePipelineCreateInfo compInfo{
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                   .pNext = &shaderInfo,
+                   .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                   .pName = "vertexCullMain"},
+        .layout = m_computePipelineLayout,
+    };
+    NVVK_CHECK(nvvk::createComputePipeline(m_device, m_pipelineCache, compInfo, &m_vertexCullPipeline, "Vertex Cull"));
+
+    // The state of the mesh shader grass, without shading rate or multiview
+    nvvk::GraphicsPipelineState graphicState    = m_graphicState;
+    graphicState.rasterizationState.cullMode    = VK_CULL_MODE_NONE;
+    graphicState.rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
 
-    // Helper to create the graphic pipeline
     nvvk::GraphicsPipelineCreator creator;
     creator.pipelineInfo.layout                  = m_pipelineLayout;
     creator.colorFormats                         = {m_colorFormat};
     creator.renderingState.depthAttachmentFormat = m_depthFormat;
+    creator.addShader(VK_SHADER_STAGE_VERTEX_BIT, "grassVertexMain", shaderInfo.codeSize, shaderInfo.pCode);
+    creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "grassFragmentMain", shaderInfo.codeSize, shaderInfo.pCode);
 
-    // Adding the shaders to the pipeline (mesh shaders instead of vertex)
-#if USE_SLANG
+    creator.debugName = "Grass Vertex";
 
-#if MULTI_ENTRY_POINTS
-    // Recompiling only for Slang in Multi-Entry mode
-    m_slangCompiler.clearMacros();
-    std::vector<std::pair<std::string, std::string>> macros = {
-        {"TASKSHADER_WORKGROUP_SIZE", std::to_string(m_device11Props.subgroupSize)},
-        {"MESHSHADER_WORKGROUP_SIZE", std::to_string(m_meshShaderProps.maxPreferredMeshWorkGroupInvocations)},
-    };
-    for(const auto& [k, v] : macros)
-      m_slangCompiler.addMacro({k.c_str(), v.c_str()});
-    if(m_slangCompiler.compileFile("mesh_task.slang"))
+    NVVK_CHECK(creator.createGraphicsPipeline(m_device, m_pipelineCache, graphicState, &m_vertexPipeline));
+  }
+
+  // Terrain height and grass height multiplier of every grass patch, kept in GENERAL layout
+  void createTerrainMap()
+  {
+    VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+    imageInfo.format            = VK_FORMAT_R16G16_SFLOAT;
+    imageInfo.extent            = {shaderio::TERRAIN_MAP_SIZE, shaderio::TERRAIN_MAP_SIZE, 1};
+    imageInfo.usage             = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    VkImageViewCreateInfo viewInfo = DEFAULT_VkImageViewCreateInfo;
+    NVVK_CHECK(m_allocator->createImage(m_terrainMap, imageInfo, viewInfo));
+    NVVK_DBG_NAME(m_terrainMap.image);
+    NVVK_DBG_NAME(m_terrainMap.descriptor.imageView);
+
+    // Bilinear filtering between patch centers, the infinite meadow wraps around the map
+    VkSamplerCreateInfo samplerInfo = DEFAULT_VkSamplerCreateInfo;
+    samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    NVVK_CHECK(m_samplerPool.acquireSampler(m_terrainMap.descriptor.sampler, samplerInfo));
+
+    VkCommandBuffer cmd = m_app->createTempCmdBuffer();
+    nvvk::cmdImageMemoryBarrier(cmd, m_terrainMap, {.newLayout = VK_IMAGE_LAYOUT_GENERAL});
+    m_app->submitAndWaitTempCmdBuffer(cmd);
+  }
+
+  // Atlas of the virtual terrain pages kept in GENERAL layout, shared with the queue family of the async compute
+  // which generates them, and the page tables, one slot per frame in flight
+  void createVirtualTerrain()
+  {
+    VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+    imageInfo.format            = VK_FORMAT_R16G16_SFLOAT;
+    imageInfo.extent            = {shaderio::VIRTUAL_TERRAIN_PAGE_TEXELS, shaderio::VIRTUAL_TERRAIN_PAGE_TEXELS, 1};
+    imageInfo.arrayLayers       = shaderio::VIRTUAL_TERRAIN_MAX_PAGES;
+    imageInfo.usage             = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    const uint32_t queueFamilies[] = {m_app->getQueue(0).familyIndex,
+                                      m_app->hasAsyncCompute() ? m_app->getComputeQueue().familyIndex : m_app->getQueue(0).familyIndex};
+    if(queueFamilies[0] != queueFamilies[1])
     {
-      size_t          codeSize = m_slangCompiler.getSpirvSize();
-      const uint32_t* code     = m_slangCompiler.getSpirv();
-      creator.addShader(VK_SHADER_STAGE_TASK_BIT_EXT, "taskMain", codeSize, code);
-      creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "meshMain", codeSize, code);
-      creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentMain", codeSize, code);
+      imageInfo.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+      imageInfo.queueFamilyIndexCount = 2;
+      imageInfo.pQueueFamilyIndices   = queueFamilies;
     }
-    else
+
+    const VkImageSubresourceRange atlasRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, shaderio::VIRTUAL_TERRAIN_MAX_PAGES};
+    VkImageViewCreateInfo         viewInfo   = DEFAULT_VkImageViewCreateInfo;
+    viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    viewInfo.subresourceRange                = atlasRange;
+    NVVK_CHECK(m_allocator->createImage(m_virtualAtlas, imageInfo, viewInfo));
+    NVVK_DBG_NAME(m_virtualAtlas.image);
+    NVVK_DBG_NAME(m_virtualAtlas.descriptor.imageView);
+
+    // Bilinear filtering within a layer, the texels past the page are never sampled
+    VkSamplerCreateInfo samplerInfo = DEFAULT_VkSamplerCreateInfo;
+    samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    NVVK_CHECK(m_samplerPool.acquireSampler(m_virtualAtlas.descriptor.sampler, samplerInfo));
+
+    NVVK_CHECK(m_allocator->createBuffer(m_virtualTable,
+                                         sizeof(int32_t) * shaderio::VIRTUAL_TERRAIN_TABLE_SIZE
+                                             * shaderio::VIRTUAL_TERRAIN_TABLE_SIZE * m_app->getFrameCycleSize(),
+                                         VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                                         VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT));
+    NVVK_DBG_NAME(m_virtualTable.buffer);
+
+    m_virtualPages.clear();
+    m_virtualRetiredLayers.clear();
+    m_virtualFreeLayers.resize(shaderio::VIRTUAL_TERRAIN_MAX_PAGES);
+    for(uint32_t layer = 0; layer < shaderio::VIRTUAL_TERRAIN_MAX_PAGES; layer++)
     {
-      creator.addShader(VK_SHADER_STAGE_TASK_BIT_EXT, "taskMain", mesh_task_slang);
-      creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "meshMain", mesh_task_slang);
-      creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentMain", mesh_task_slang);
+      m_virtualFreeLayers[layer] = shaderio::VIRTUAL_TERRAIN_MAX_PAGES - 1 - layer;  // Layer 0 first
     }
-#else
-    creator.addShader(VK_SHADER_STAGE_TASK_BIT_EXT, "taskMain", mesh_task_task_slang);
-    creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "meshMain", mesh_task_mesh_slang);
-    creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "fragmentMain", mesh_task_frag_slang);
-#endif
-#else
-    creator.addShader(VK_SHADER_STAGE_TASK_BIT_EXT, "main", mesh_task_task_glsl);
-    creator.addShader(VK_SHADER_STAGE_MESH_BIT_EXT, "main", mesh_task_mesh_glsl);
-    creator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "main", mesh_task_frag_glsl);
-#endif
 
-    NVVK_CHECK(creator.createGraphicsPipeline(m_device, nullptr, m_graphicState, &m_pipeline));
-    NVVK_DBG_NAME(m_pipeline);
+    VkCommandBuffer cmd = m_app->createTempCmdBuffer();
+    nvvk::cmdImageMemoryBarrier(cmd, m_virtualAtlas, {.newLayout = VK_IMAGE_LAYOUT_GENERAL, .subresourceRange = atlasRange});
+    m_app->submitAndWaitTempCmdBuffer(cmd);
   }
 
-  void createFrameInfoBuffer()
+  // Wind displacement over the grid, kept in GENERAL layout
+  void createWindMap()
   {
-    NVVK_CHECK(m_allocator->createBuffer(m_frameInfo, sizeof(shaderio::FrameInfo), VK_BUFFER_USAGE_2_UNIFORM_BUFFER_BIT,
-                                         VMA_MEMORY_USAGE_AUTO_PREFER_HOST));
-    NVVK_DBG_NAME(m_frameInfo.buffer);
+    VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+    imageInfo.format            = VK_FORMAT_R16G16_SFLOAT;
+    imageInfo.extent            = {shaderio::WIND_MAP_SIZE, shaderio::WIND_MAP_SIZE, 1};
+    imageInfo.usage             = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    VkImageViewCreateInfo viewInfo = DEFAULT_VkImageViewCreateInfo;
+    NVVK_CHECK(m_allocator->createImage(m_windMap, imageInfo, viewInfo));
+    NVVK_DBG_NAME(m_windMap.image);
+    NVVK_DBG_NAME(m_windMap.descriptor.imageView);
+
+    // Bilinear filtering, the blades past the last texel centers take the edge values
+    VkSamplerCreateInfo samplerInfo = DEFAULT_VkSamplerCreateInfo;
+    samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    NVVK_CHECK(m_samplerPool.acquireSampler(m_windMap.descriptor.sampler, samplerInfo));
+
+    VkCommandBuffer cmd = m_app->createTempCmdBuffer();
+    nvvk::cmdImageMemoryBarrier(cmd, m_windMap, {.newLayout = VK_IMAGE_LAYOUT_GENERAL});
+    m_app->submitAndWaitTempCmdBuffer(cmd);
   }
 
-  void createStatisticsBuffer()
+  // Trample map cleared to upright grass and kept in GENERAL layout, and the ring of interactors, one slot per frame in flight
+  void createTrampleMap()
+  {
+    VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+    imageInfo.format            = VK_FORMAT_R16G16B16A16_SFLOAT;
+    imageInfo.extent            = {shaderio::TRAMPLE_MAP_SIZE, shaderio::TRAMPLE_MAP_SIZE, 1};
+    imageInfo.usage             = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    VkImageViewCreateInfo viewInfo = DEFAULT_VkImageViewCreateInfo;
+    NVVK_CHECK(m_allocator->createImage(m_trampleMap, imageInfo, viewInfo));
+    NVVK_DBG_NAME(m_trampleMap.image);
+    NVVK_DBG_NAME(m_trampleMap.descriptor.imageView);
+
+    // Bilinear filtering, the map is anchored in the world and wraps around
+    VkSamplerCreateInfo samplerInfo = DEFAULT_VkSamplerCreateInfo;
+    samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    NVVK_CHECK(m_samplerPool.acquireSampler(m_trampleMap.descriptor.sampler, samplerInfo));
+
+    NVVK_CHECK(m_allocator->createBuffer(m_interactors,
+                                         sizeof(shaderio::Interactor) * shaderio::TRAMPLE_MAX_INTERACTORS * m_app->getFrameCycleSize(),
+                                         VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                                         VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT));
+    NVVK_DBG_NAME(m_interactors.buffer);
+
+    VkCommandBuffer cmd = m_app->createTempCmdBuffer();
+    nvvk::cmdImageMemoryBarrier(cmd, m_trampleMap, {.newLayout = VK_IMAGE_LAYOUT_GENERAL});
+    const VkClearColorValue       clearValue = {};
+    const VkImageSubresourceRange range      = DEFAULT_VkImageSubresourceRange;
+    vkCmdClearColorImage(cmd, m_trampleMap.image, VK_IMAGE_LAYOUT_GENERAL, &clearValue, 1, &range);
+    m_app->submitAndWaitTempCmdBuffer(cmd);
+  }
+
+  // Depth of the shadow cascades, one layer each, sampled with a comparison in SHADER_READ_ONLY layout
+  void createShadowMap()
+  {
+    VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+    imageInfo.format            = kShadowMapFormat;
+    imageInfo.extent            = {kShadowMapSize, kShadowMapSize, 1};
+    imageInfo.arrayLayers       = shaderio::SHADOW_MAX_CASCADES;
+    imageInfo.usage             = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    const VkImageSubresourceRange shadowRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, shaderio::SHADOW_MAX_CASCADES};
+    VkImageViewCreateInfo         viewInfo    = DEFAULT_VkImageViewCreateInfo;
+    viewInfo.viewType                         = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    viewInfo.subresourceRange                 = shadowRange;
+    NVVK_CHECK(m_allocator->createImage(m_shadowMap, imageInfo, viewInfo));
+    NVVK_DBG_NAME(m_shadowMap.image);
+    NVVK_DBG_NAME(m_shadowMap.descriptor.imageView);
+
+    // Lit outside of the cascades
+    VkSamplerCreateInfo samplerInfo = DEFAULT_VkSamplerCreateInfo;
+    samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.borderColor         = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    samplerInfo.mipmapMode          = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.compareEnable       = VK_TRUE;
+    samplerInfo.compareOp           = VK_COMPARE_OP_LESS_OR_EQUAL;
+    NVVK_CHECK(m_samplerPool.acquireSampler(m_shadowMap.descriptor.sampler, samplerInfo));
+
+    // Cleared to the far plane until the first shadow pass
+    VkCommandBuffer cmd = m_app->createTempCmdBuffer();
+    nvvk::cmdImageMemoryBarrier(cmd, m_shadowMap, {.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, .subresourceRange = shadowRange});
+    const VkClearDepthStencilValue clearValue = DEFAULT_VkClearDepthStencilValue;
+    vkCmdClearDepthStencilImage(cmd, m_shadowMap.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1, &shadowRange);
+    nvvk::cmdImageMemoryBarrier(cmd, m_shadowMap, {.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, .subresourceRange = shadowRange});
+    m_app->submitAndWaitTempCmdBuffer(cmd);
+  }
+
+  // Color and depth layers of the multiview rendering, one per view
+  void createMultiviewTargets()
+  {
+    if(!m_supportsMultiview)
+    {
+      return;
+    }
+
+    VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+    imageInfo.extent            = {kMultiviewSize, kMultiviewSize, 1};
+    imageInfo.arrayLayers       = shaderio::MULTIVIEW_MAX_VIEWS;
+
+    VkImageViewCreateInfo viewInfo = DEFAULT_VkImageViewCreateInfo;
+    viewInfo.viewType              = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    viewInfo.subresourceRange      = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, shaderio::MULTIVIEW_MAX_VIEWS};
+
+    imageInfo.format = m_colorFormat;
+    imageInfo.usage  = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    NVVK_CHECK(m_allocator->createImage(m_multiviewColor, imageInfo, viewInfo));
+    NVVK_DBG_NAME(m_multiviewColor.image);
+    NVVK_DBG_NAME(m_multiviewColor.descriptor.imageView);
+
+    imageInfo.format                         = m_depthFormat;
+    imageInfo.usage                          = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    viewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_DEPTH_BIT;
+    NVVK_CHECK(m_allocator->createImage(m_multiviewDepth, imageInfo, viewInfo));
+    NVVK_DBG_NAME(m_multiviewDepth.image);
+    NVVK_DBG_NAME(m_multiviewDepth.descriptor.imageView);
+  }
+
+  // Patch and tile height ranges and visible tile list, sized for the largest grid (TERRAIN_MAP_SIZE)
+  void createTileCullingBuffers()
   {
-    // Create device-local buffer for shader writes
-    NVVK_CHECK(m_allocator->createBuffer(m_readbackDevice, sizeof(shaderio::Statistics),
+    uint32_t     taskWidth = std::min(shaderio::BOXES_PER_TASK, m_device11Props.subgroupSize);
+    VkDeviceSize maxTiles  = VkDeviceSize((shaderio::TERRAIN_MAP_SIZE + taskWidth - 1) / taskWidth)
+                            * ((shaderio::TERRAIN_MAP_SIZE + shaderio::TILE_ROWS - 1) / shaderio::TILE_ROWS);
+
+    NVVK_CHECK(m_allocator->createBuffer(m_tileBounds, maxTiles * sizeof(glm::vec2),
+                                         VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
+    NVVK_DBG_NAME(m_tileBounds.buffer);
+
+    NVVK_CHECK(m_allocator->createBuffer(m_patchBounds, VkDeviceSize(shaderio::TERRAIN_MAP_SIZE) * shaderio::TERRAIN_MAP_SIZE * sizeof(glm::vec2),
+                                         VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
+    NVVK_DBG_NAME(m_patchBounds.buffer);
+
+    NVVK_CHECK(m_allocator->createBuffer(m_placement,
+                                         VkDeviceSize(shaderio::TERRAIN_MAP_SIZE) * shaderio::TERRAIN_MAP_SIZE * sizeof(shaderio::BladePlacement),
+                                         VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
+    NVVK_DBG_NAME(m_placement.buffer);
+
+    NVVK_CHECK(m_allocator->createBuffer(m_visibleTiles, (shaderio::TILE_LIST_OFFSET + maxTiles) * sizeof(uint32_t),
+                                         VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT
+                                             | VK_BUFFER_USAGE_2_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
+    NVVK_DBG_NAME(m_visibleTiles.buffer);
+
+    NVVK_CHECK(m_allocator->createBuffer(m_fieldBuffer, shaderio::FIELD_MAX_COUNT * sizeof(shaderio::GrassField),
+                                         VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT
+                                             | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
+    NVVK_DBG_NAME(m_fieldBuffer.buffer);
+
+    NVVK_CHECK(m_allocator->createBuffer(m_visibleFields, (shaderio::FIELD_LIST_OFFSET + shaderio::FIELD_MAX_COUNT) * sizeof(uint32_t),
+                                         VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT
+                                             | VK_BUFFER_USAGE_2_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
+    NVVK_DBG_NAME(m_visibleFields.buffer);
+
+    // One list per LOD, each able to hold all the patches, after the header of the compaction or of the vertex fallback
+    NVVK_CHECK(m_allocator->createBuffer(m_compactBlades,
+                                         (std::max(shaderio::COMPACT_LIST_OFFSET, shaderio::VERTEX_LIST_OFFSET) + VkDeviceSize(shaderio::GRASS_LOD_COUNT) * shaderio::TERRAIN_MAP_SIZE
+                                                                              * shaderio::TERRAIN_MAP_SIZE)
+                                             * sizeof(uint32_t),
                                          VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT
-                                             | VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT,
+                                             | VK_BUFFER_USAGE_2_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
+    NVVK_DBG_NAME(m_compactBlades.buffer);
+  }
+
+  // Depth pyramid at half the viewport resolution, storing the farthest depth of each texel footprint
+  void createHizPyramid(VkCommandBuffer cmd, const VkExtent2D& size)
+  {
+    destroyHizPyramid();
+
+    m_hizSize = {std::max(1u, size.width / 2), std::max(1u, size.height / 2)};
+
+    VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+    imageInfo.format            = VK_FORMAT_R32_SFLOAT;
+    imageInfo.extent            = {m_hizSize.width, m_hizSize.height, 1};
+    imageInfo.mipLevels         = nvvk::mipLevels(m_hizSize);
+    imageInfo.usage             = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    VkImageViewCreateInfo viewInfo = DEFAULT_VkImageViewCreateInfo;
+    NVVK_CHECK(m_allocator->createImage(m_hizImage, imageInfo, viewInfo));
+    NVVK_DBG_NAME(m_hizImage.image);
+    NVVK_DBG_NAME(m_hizImage.descriptor.imageView);
+
+    // One view per level, written by the reduction
+    m_hizLevelViews.resize(imageInfo.mipLevels);
+    for(uint32_t level = 0; level < imageInfo.mipLevels; level++)
+    {
+      viewInfo.image                         = m_hizImage.image;
+      viewInfo.format                        = imageInfo.format;
+      viewInfo.subresourceRange.baseMipLevel = level;
+      viewInfo.subresourceRange.levelCount   = 1;
+      NVVK_CHECK(vkCreateImageView(m_device, &viewInfo, nullptr, &m_hizLevelViews[level]));
+      NVVK_DBG_NAME(m_hizLevelViews[level]);
+    }
+
+    // Cleared to the far plane: nothing is occluded until the pyramid is built
+    nvvk::cmdImageMemoryBarrier(cmd, m_hizImage, {.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL});
+    const VkClearColorValue       clearValue = {{1.0F, 0.0F, 0.0F, 0.0F}};
+    const VkImageSubresourceRange range      = DEFAULT_VkImageSubresourceRange;
+    vkCmdClearColorImage(cmd, m_hizImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1, &range);
+    nvvk::cmdImageMemoryBarrier(cmd, m_hizImage, {.newLayout = VK_IMAGE_LAYOUT_GENERAL});
+
+    // The task shader samples the whole pyramid
+    nvvk::WriteSetContainer writes{};
+    writes.append(m_descriptorPack.makeWrite(shaderio::GrassBinding::eHizPyramid), m_hizImage);
+    vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+  }
+
+  void destroyHizPyramid()
+  {
+    for(VkImageView view : m_hizLevelViews)
+      vkDestroyImageView(m_device, view, nullptr);
+    m_hizLevelViews.clear();
+    m_allocator->destroyImage(m_hizImage);
+  }
+
+  // Grow the buffer of occlusion bits when the grass grid gets larger
+  void ensureVisibilityBuffer(VkDeviceSize size)
+  {
+    if(m_visibility.bufferSize >= size)
+      return;
+
+    // Still possibly used by the frames in flight
+    m_app->submitResourceFree(m_allocator.get(), m_visibility);
+
+    NVVK_CHECK(m_allocator->createBuffer(m_visibility, size, VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
                                          VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
-    NVVK_DBG_NAME(m_readbackDevice.buffer);
+    NVVK_DBG_NAME(m_visibility.buffer);
+    createOcclusionGraph();
+  }
+
+  // One FrameInfo slot per frame in flight, written by the host and selected with the dynamic offset of the binding
+  void createFrameInfoBuffer()
+  {
+    VkPhysicalDeviceProperties deviceProps;
+    vkGetPhysicalDeviceProperties(m_app->getPhysicalDevice(), &deviceProps);
+    const VkDeviceSize alignment = deviceProps.limits.minUniformBufferOffsetAlignment;
+    m_frameInfoStride            = (sizeof(shaderio::FrameInfo) + alignment - 1) & ~(alignment - 1);
+
+    NVVK_CHECK(m_allocator->createBuffer(m_frameInfo, m_frameInfoStride * m_app->getFrameCycleSize(), VK_BUFFER_USAGE_2_UNIFORM_BUFFER_BIT,
+                                         VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                                         VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT));
+    NVVK_DBG_NAME(m_frameInfo.buffer);
+  }
 
-    // Create host-visible mapped buffer for CPU readback
-    NVVK_CHECK(m_allocator->createBuffer(m_readbackHost, sizeof(shaderio::Statistics),
-                                         VK_BUFFER_USAGE_2_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
-                                         VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT));
-    NVVK_DBG_NAME(m_readbackHost.buffer);
+  void createStatisticsBuffer()
+  {
+    // Device buffer written by the shaders, read back without stalls into one host buffer per frame in flight.
+    // The counters also show in the profiler window, next to the GPU timers.
+    NVVK_CHECK(m_statsCounters.init({.allocator        = m_allocator.get(),
+                                     .size             = sizeof(shaderio::Statistics),
+                                     .numFrames        = m_app->getFrameCycleSize(),
+                                     .profilerTimeline = m_profilerTimeline}));
+    m_statsCounters.addCounter("Blades Drawn", offsetof(shaderio::Statistics, boxesDrawn));
+    m_statsCounters.addCounter("Occlusion Culled", offsetof(shaderio::Statistics, occlusionCulled));
+    m_statsCounters.addCounter("Occlusion Rescued", offsetof(shaderio::Statistics, occlusionRescued));
+    for(uint32_t lod = 0; lod < shaderio::GRASS_LOD_COUNT; lod++)
+    {
+      m_statsCounters.addCounter(fmt::format("LOD {} Blades", lod), offsetof(shaderio::Statistics, lodBlades) + lod * sizeof(uint32_t));
+    }
+    m_statsCounters.addCounter("Tiles Visible", offsetof(shaderio::Statistics, tilesVisible));
+    m_statsCounters.addCounter("Tight Bounds Culled", offsetof(shaderio::Statistics, tightBoundsCulled));
+    m_statsCounters.addCounter("Ring Thinned", offsetof(shaderio::Statistics, ringThinned));
+    m_statsCounters.addCounter("Distance Thinned", offsetof(shaderio::Statistics, distanceThinned));
+    m_statsCounters.addCounter("Task Workgroups", offsetof(shaderio::Statistics, taskWorkgroups));
+    m_statsCounters.addCounter("Mesh Workgroups", offsetof(shaderio::Statistics, meshWorkgroups));
+    m_statsCounters.addCounter("Vertices Emitted", offsetof(shaderio::Statistics, verticesEmitted));
+    m_statsCounters.addCounter("Primitives Emitted", offsetof(shaderio::Statistics, primitivesEmitted));
+    m_statsCounters.addCounter("Fragments Shaded", offsetof(shaderio::Statistics, fragmentsShaded));
   }
 
   void onLastHeadlessFrame() override
   {
-    m_app->saveImageToFile(m_gBuffers->getColorImage(), m_gBuffers->getSize(),
+    m_app->saveImageToFile(getDisplayBuffer().getColorImage(), getDisplayBuffer().getSize(),
                            nvutils::getExecutablePath().replace_extension(".jpg").string());
   }
 
@@ -514,40 +3434,298 @@ private:
   nvapp::Application*                      m_app{nullptr};
   std::shared_ptr<nvvk::ResourceAllocator> m_allocator;
 
+  // Profiling
+  nvutils::ProfilerManager*  m_profilerManager{};
+  nvutils::ProfilerTimeline* m_profilerTimeline{};
+  nvvk::ProfilerGpuTimer     m_profilerGpuTimer;
+
   VkFormat                       m_colorFormat = VK_FORMAT_R8G8B8A8_UNORM;
   VkFormat                       m_depthFormat = VK_FORMAT_X8_D24_UNORM_PACK32;
   VkClearColorValue              m_clearColor  = {{0.2F, 0.2F, 0.3F, 1.0F}};
   VkDevice                       m_device      = VK_NULL_HANDLE;
   std::unique_ptr<nvvk::GBuffer> m_gBuffers{};
+  std::unique_ptr<nvvk::GBuffer> m_displayBuffer{};  // Upscale of m_gBuffers with the dynamic resolution
   nvvk::SamplerPool              m_samplerPool{};
+  nvvk::PipelineCache            m_pipelineCache;
+  nvvk::PipelineLayoutCache      m_layoutCache;  // Layouts derived from the shaders
+  std::filesystem::path          m_pipelineCacheFile = nvutils::getExecutablePath().replace_extension(".pipelinecache");
 
   // Resources
-  nvvk::Buffer m_frameInfo;
-  nvvk::Buffer m_readbackDevice;  // Device-local buffer for shader writes
-  nvvk::Buffer m_readbackHost;    // Host-visible mapped buffer for CPU readback
+  nvvk::Buffer      m_frameInfo;            // Ring of FrameInfo, one slot per frame in flight
+  VkDeviceSize      m_frameInfoStride = 0;  // Size of a slot, aligned for the dynamic offset
+  uint32_t          m_frameInfoOffset = 0;  // Slot of the frame being recorded
+  nvvk::GpuCounters m_statsCounters;        // shaderio::Statistics written by the shaders, read back without stalls
+  uint64_t          m_frameNumber = 0;      // Frames rendered
+
+  // Pipeline statistics queries, results in the order of the flag bits, then the mesh primitives generated
+  static constexpr VkQueryPipelineStatisticFlags kPipelineStatisticFlags =
+      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+      | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_TASK_SHADER_INVOCATIONS_BIT_EXT
+      | VK_QUERY_PIPELINE_STATISTIC_MESH_SHADER_INVOCATIONS_BIT_EXT;
+  static constexpr uint32_t    kPipelineQueryCount = 6;
+  static constexpr const char* kPipelineQueryNames[kPipelineQueryCount] = {
+      "Clipping Invocations", "Clipping Primitives", "Fragment Invocations",
+      "Task Invocations",     "Mesh Invocations",    "Mesh Primitives Generated",
+  };
+  static constexpr uint32_t kQueryAverageFrames = 60;
+
+  bool                                      m_supportsPipelineQueries = false;
+  bool                                      m_usePipelineQueries      = false;
+  bool                                      m_queriesActive           = false;  // Queries begun in the frame being recorded
+  VkQueryPool                               m_pipelineStatsPool{};
+  VkQueryPool                               m_meshPrimitivesPool{};
+  std::vector<bool>                         m_queryFrameValid;  // The query of a frame slot holds results
+  std::array<uint64_t, kPipelineQueryCount> m_queryFrame{};     // Results of the last completed frame
+  std::array<uint64_t, kPipelineQueryCount> m_querySum{};
+  std::array<double, kPipelineQueryCount>   m_queryAverage{};
+  uint32_t                                  m_querySumFrames = 0;
 
   // Settings
-  int   m_totalGrassX  = 500;   // Total number of grass blades in X dimension
-  int   m_totalGrassZ  = 500;   // Total number of grass blades in Z dimension
-  float m_bladeHeight  = 0.5f;
-  float m_spacing      = 0.1f;  // Default spacing between grass blades
-  bool  m_animate      = true;  // Enable wind animation
-  float m_animSpeed    = 1.0f;  // Wind speed multiplier
-  float m_swayStrength = 1.0f;  // Wind sway strength multiplier
-  float m_time         = 0.0f;  // Current animation time
+  int   m_totalGrassX   = 500;   // Total number of grass blades in X dimension
+  int   m_totalGrassZ   = 500;   // Total number of grass blades in Z dimension
+  float m_bladeHeight   = 0.5f;
+  float m_spacing       = 0.1f;  // Default spacing between grass blades
+  bool  m_animate       = true;  // Enable wind animation
+  float m_animSpeed     = 1.0f;  // Wind speed multiplier
+  float m_swayStrength  = 1.0f;  // Wind sway strength multiplier
+  float m_time          = 0.0f;  // Current animation time
+  float m_fixedTimeStep = 0.0f;  // Animation time per frame, 0 for the frame time
+
+  bool m_useBladeCache    = true;   // MESH_BLADE_CACHE variant of the mesh shader
+  bool m_useCompactOutput = true;   // MESH_COMPACT_OUTPUT variant of the mesh shader
+  bool m_useShadingRate   = false;  // MESH_SHADING_RATE variant of the mesh shader
+  bool m_useHalf          = false;  // MESH_HALF variant of the grass shaders
+  int  m_debugView        = shaderio::eDebugViewNone;  // DebugView, MESH_DEBUG_VIEW variant of the mesh shader when not none
+  bool m_pipelineDirty    = false;  // The variant changed since the pipelines were created
+
+  // Frozen culling: the frustum planes come from the camera of the last frame before freezing
+  bool      m_freezeCulling = false;
+  glm::mat4 m_cullView      = glm::mat4(1.0f);
+  glm::mat4 m_cullProj      = glm::mat4(1.0f);
+
+  // Mesh workgroup configuration, the blades are compiled into the shader and the workgroup size is specialized
+  struct MeshConfig
+  {
+    uint32_t bladesPerMesh = 8;   // Full detail blades per mesh workgroup (GRASS_BLADES_PER_MESH)
+    uint32_t workgroupSize = 32;  // Mesh shader threads (MESH_WORKGROUP_SIZE specialization constant)
+  };
+  MeshConfig m_meshConfig;
+
+  // Task workgroup size (BOXES_PER_TASK specialization constant)
+  static constexpr uint32_t kMaxTaskWorkgroupSize      = TASKSHADER_MAX_WORKGROUP_SIZE;  // Patch indices of the payloads are 8-bit
+  int                       m_taskWorkgroupSize        = 0;    // 0: the subgroup size
+  uint32_t                  m_pipelineTaskSize         = TASKSHADER_WORKGROUP_SIZE;  // Task workgroup size of m_pipeline
+  bool                      m_supportsTaskSubgroupSize = false;  // subgroupSizeControl for the task stage
+
+  // Auto-tuning of m_meshConfig
+  static constexpr uint32_t kTuningFrames       = 64;
+  static constexpr uint32_t kTuningWarmupFrames = 8;
+  struct MeshTuning
+  {
+    struct Candidate
+    {
+      MeshConfig config;
+      double     gpuTime = 0;  // Grass draws, microseconds
+    };
+    bool                   active = false;
+    std::vector<Candidate> candidates;
+    size_t                 current = 0;
+    uint32_t               frame   = 0;
+    MeshConfig             original;  // Restored when no timing was available
+  };
+  MeshTuning m_tuning;
+  bool       m_autoTuneOnStart = false;
+
+  // Grass shader permutations, compiled in the background, and shader hot reload
+  nvslang::ShaderPermutations m_shaderPermutations;
+  uint64_t                    m_shaderGeneration = 0;  // SPIR-V of the current pipelines
+  bool                        m_asyncShaders     = true;
+  bool                        m_reloadRequested  = false;
+
+  // Blade LOD
+  bool      m_useLod         = true;                     // Reduce blade segments with the projected size
+  glm::vec2 m_lodPixelHeight = glm::vec2(48.0f, 16.0f);  // Projected blade height (px) below which 2 and 1 segment(s) are used
+  bool      m_useThinning     = false;                   // Drop a share of the distant blades, widen the others
+  glm::vec2 m_thinPixelHeight = glm::vec2(8.0f, 2.0f);   // Projected blade height (px) where the thinning starts and ends
+  float     m_thinMinKeep     = 0.25f;                   // Fraction of the blades kept past the end of the thinning
+
+  // Frame time budget of the grass draws, met by scaling the density of the blades
+  static constexpr float  kDensityMinScale    = 0.1f;   // Fewest blades kept by the budget
+  static constexpr float  kDensityBudgetGain  = 0.25f;  // Share of the correction applied each frame
+  static constexpr double kDensityBudgetOver  = 1.05;   // Lowered above this share of the target
+  static constexpr double kDensityBudgetUnder = 0.85;   // Raised below this share of the target
+  bool                    m_useDensityBudget  = false;
+  float                   m_densityBudgetMs   = 4.0f;   // Target GPU time of the grass draws
+  float                   m_densityScale      = 1.0f;   // Current fraction of the blades kept by the budget
+
+  // Dynamic resolution, the GBuffer is rendered at a scaled size and upscaled (see upscale.slang)
+  static constexpr float    kMinRenderScale        = 0.5f;
+  bool                      m_useDynamicResolution = false;
+  float                     m_renderScale          = 1.0f;  // Fixed render scale without the dynamic resolution
+  float                     m_resolutionBudgetMs   = 8.0f;  // Target GPU time of the draws into the GBuffer
+  float                     m_upscaleSharpness     = 0.5f;
+  VkPipeline                m_upscalePipeline{};
+  VkPipelineLayout          m_upscalePipelineLayout{};
+  nvvk::DescriptorBindings  m_upscaleBindings;
+
+  // Variable rate shading
+  bool      m_supportsShadingRate = false;                   // Primitive shading rate writable from mesh shaders
+  glm::vec2 m_shadingRateDistance = glm::vec2(15.0f, 40.0f);  // Blade distance beyond which 2x2 and 4x4 shading is used
+
+  // Half precision
+  bool m_supportsHalf             = false;  // shaderFloat16, for MESH_HALF
+  bool m_supportsHalfInterpolants = false;  // storageInputOutput16 as well, for MESH_HALF_INTERPOLANTS
 
   // Mesh shader properties and limits (queried from device)
   VkPhysicalDeviceMeshShaderPropertiesEXT m_meshShaderProps{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_PROPERTIES_EXT};
   VkPhysicalDeviceVulkan11Properties m_device11Props{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_PROPERTIES};
 
+  // Without mesh shaders only the vertex shader fallback draws the grass, and the stages exclude task and mesh
+  bool                  m_supportsMeshShaders = true;
+  VkShaderStageFlags    m_grassStages         = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT
+                                         | VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  VkPipelineStageFlags2 m_grassPipelineStages = VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT
+                                                | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+
   // Pipeline
   nvvk::GraphicsPipelineState m_graphicState;
   VkPipeline                  m_pipeline{};
   VkPipelineLayout            m_pipelineLayout{};
   nvvk::DescriptorPack        m_descriptorPack{};
 
+  // Infinite meadow
+  bool       m_infiniteGrass = false;  // The grid follows the camera over the world cells
+  glm::ivec2 m_gridOrigin{};           // World cell of patch (0, 0)
+  int        m_ringCells   = 128;      // Width of the density rings around the camera
+  float      m_ringDensity = 0.6f;     // Fraction of the blades kept by each ring from the previous one
+
+  // Cascaded shadow maps of the sun
+  static constexpr uint32_t kShadowMapSize      = 2048;
+  static constexpr VkFormat kShadowMapFormat    = VK_FORMAT_D32_SFLOAT;
+  static constexpr float    kShadowCasterMargin = 50.0f;  // Depth toward the sun in front of each cascade, for the casters outside of it
+  bool                      m_useShadows        = false;
+  int                       m_shadowCascades    = 3;
+  float                     m_shadowDistance    = 80.0f;  // View depth covered by the cascades
+  float                     m_shadowSplitBlend  = 0.75f;  // 0: uniform splits, 1: logarithmic splits
+  nvvk::Image               m_shadowMap;                  // One layer per cascade
+  VkPipeline                m_shadowPipeline{};
+
+  // Multiview rendering
+  static constexpr uint32_t kMultiviewSize      = 512;  // Size of each view
+  bool                      m_supportsMultiview = false;
+  int                       m_multiviewMode     = 0;       // 0: single view, 1: stereo, 2: cube
+  float                     m_stereoEyeDistance = 0.064f;  // Distance between the eyes of the stereo views
+  uint32_t                  m_pipelineViewCount = 1;       // Views of m_pipeline
+  nvvk::Image               m_multiviewColor;              // One layer per view
+  nvvk::Image               m_multiviewDepth;
+
+  // Baked terrain
+  bool             m_useBakedTerrain = false;  // Sample the terrain map instead of evaluating the noise
+  bool             m_usePlacementBuffer = false;  // Load the baked blade placement instead of hashing it
+  nvvk::Buffer     m_placement;                   // Offset, rotation and height multiplier of each patch blade
+  bool             m_terrainDirty    = true;   // The grid or the spacing changed since the last bake
+  nvvk::Image      m_terrainMap;               // RG16F: terrain height, grass height multiplier
+  glm::ivec2       m_bakedOrigin{};            // Infinite meadow: grid origin of the last bake
+  VkPipeline       m_terrainPipeline{};
+  VkPipelineLayout m_computePipelineLayout{};  // Layout of the compute passes of the grass shader
+
+  // Virtual terrain: pages of world cells generated around the camera, sampled by the baked terrain (see updateVirtualTerrain)
+  static constexpr int kVirtualTerrainMaxRadius = 6;  // Its resident square, with the eviction margin, fits in the atlas
+  bool                 m_useVirtualTerrain      = false;
+  int                  m_virtualRadius          = 5;  // Pages kept resident around the page of the camera
+  int                  m_virtualPagesPerFrame   = 8;  // Pages generated at most per frame
+  nvvk::Image          m_virtualAtlas;                // RG16F, one page per layer, as the terrain map
+  nvvk::Buffer         m_virtualTable;                // Page table (layer or -1), one slot per frame in flight
+  glm::ivec2           m_virtualOrigin{};             // Page of the entry (0, 0) of the page table
+  float                m_virtualSpacing = 0.0f;       // Spacing of the resident pages
+  std::unordered_map<uint64_t, uint32_t>     m_virtualPages;          // Resident pages, packed coordinates to layer
+  std::vector<uint32_t>                      m_virtualFreeLayers;
+  std::vector<std::pair<uint32_t, uint64_t>> m_virtualRetiredLayers;  // Layers of evicted pages, and the frame of the eviction
+  uint64_t                                   m_virtualFrame = 0;
+  VkPipeline                                 m_virtualTerrainPipeline{};
+
+  // Ground
+  bool       m_showGround     = true;  // Draw the terrain surface
+  float      m_groundLodRange = 3.0f;  // Split distance of the ground nodes, in node sizes
+  VkPipeline m_groundPipeline{};
+
+  // Wind map
+  bool        m_useWindMap = false;  // Evaluate the wind once per frame into the map instead of per blade
+  nvvk::Image m_windMap;             // RG16F: wind displacement of the blade tips
+  VkPipeline  m_windPipeline{};
+
+  // Trampling
+  bool         m_useTrample      = false;  // Flatten the blades with the trample map
+  int          m_trampleWalkers  = 32;     // Interactors walking across the grid
+  bool         m_trampleCamera   = true;   // The camera flattens the grass under it
+  float        m_trampleRadius   = 0.6f;   // Radius of the flattened area around each interactor
+  float        m_trampleRecovery = 5.0f;   // Seconds for the grass to straighten up
+  nvvk::Image  m_trampleMap;               // RGBA16F: bending direction (xy), flattening (z)
+  nvvk::Buffer m_interactors;              // Ring of interactors, TRAMPLE_MAX_INTERACTORS per frame in flight
+  VkPipeline   m_tramplePipeline{};
+
+  // Tile culling
+  bool         m_useTileCulling = true;  // Coarse frustum culling of BOXES_PER_TASK x TILE_ROWS patch tiles
+  nvvk::Buffer m_tileBounds;             // Terrain height range of each tile
+  nvvk::Buffer m_patchBounds;            // Terrain height range under the blade of each patch
+  bool         m_useTightBounds = true;  // Per-patch box from m_patchBounds instead of the conservative sphere
+  nvvk::Buffer m_visibleTiles;           // Indirect draw command followed by the visible tile indices
+  VkPipeline   m_tileBoundsPipeline{};
+  VkPipeline   m_tileCullPipeline{};
+
+  // Global compaction
+  bool         m_useGlobalCompaction = false;  // Compute cull of all the patches, drawn in full mesh workgroups
+  nvvk::Buffer m_compactBlades;                // Indirect draw command, blade count per LOD and compacted blades of each LOD
+  VkPipeline   m_compactCullPipeline{};
+  VkPipeline   m_compactPipeline{};            // Mesh and fragment shaders of the compacted blades
+
+  // Vertex shader fallback, drawing from the compaction buffer (see VERTEX_LIST_OFFSET)
+  struct PathTiming
+  {
+    double   cullMs = 0;  // Sums over the frames
+    double   drawMs = 0;
+    uint32_t frames = 0;
+  };
+  static constexpr uint32_t kPathCompareFrames = 120;  // Frames of each path in a comparison
+  static constexpr uint32_t kPathCompareWarmup = 8;    // First frames of each path not timed, the timers lag behind
+  bool       m_useVertexFallback = false;  // Also on devices with mesh shaders, to compare the paths
+  bool       m_comparePaths      = false;  // Alternates the paths every kPathCompareFrames frames
+  PathTiming m_pathTimings[2];             // Mesh shader path, vertex shader path
+  VkPipeline m_vertexCullPipeline{};
+  VkPipeline m_vertexPipeline{};           // Vertex and fragment shaders of the listed blades
+
+  // Extra grass fields
+  int                             m_fieldCount  = 0;     // Fields around the grid, at most FIELD_MAX_COUNT
+  bool                            m_fieldsDirty = true;  // The descriptors are uploaded before the next culling
+  std::vector<shaderio::GrassField> m_fields;            // Descriptors of the fields
+  nvvk::Buffer                    m_fieldBuffer;         // GrassField of each field
+  nvvk::Buffer                    m_visibleFields;       // Indirect draw command followed by the visible field indices
+  VkPipeline                      m_fieldCullPipeline{};
+
+  // Occlusion culling
+  bool                     m_useOcclusion = false;  // Two-phase culling against the depth pyramid
+  bool                     m_useTemporalCulling = false;  // Phase 1 draws last frame's visible patches untested
+  nvvk::Image              m_hizImage;              // Farthest-depth pyramid, kept in GENERAL layout
+  std::vector<VkImageView> m_hizLevelViews;         // One view per mip level, written by the reduction
+  VkExtent2D               m_hizSize{};             // Size of the pyramid level 0 (half the viewport)
+  nvvk::Buffer             m_visibility;            // Patches rejected by the first pass, or visible last frame (1 bit per patch)
+  VkPipeline               m_hizPipeline{};
+  VkPipelineLayout         m_hizPipelineLayout{};
+  nvvk::DescriptorBindings m_hizBindings;  // Reflected from the shader, for the pushed descriptors
+  nvvk::RenderGraph        m_occlusionGraph;  // Pyramid build and second pass, see createOcclusionGraph
+  nvvk::Image              m_occlusionDepth;  // GBuffer depth as imported by the graph, which tracks its layout
+  struct OcclusionFrame                       // What the second pass draws, set before recording the graph
+  {
+    const VkRenderingInfo* renderingInfo{};
+    shaderio::PushConstant pushConst{};
+    uint32_t               workgroupsX{};
+    uint32_t               workgroupsZ{};
+  } m_occlusionFrame;
+
   // Compilers
   nvslang::SlangCompiler m_slangCompiler{};
+  bool                   m_releaseShaders       = false;  // Optimized shaders without debug information
+  std::filesystem::path  m_shaderCacheDirectory = nvutils::getExecutablePath().parent_path() / "shader_cache";
 
 
 };
@@ -555,33 +3733,187 @@ private:
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
+/// Statistics counters added to the sequence report, in the order of shaderio::Statistics
+static void appendStatisticsCounters(const shaderio::Statistics& stats, std::vector<nvutils::SequenceReport::Counter>& counters)
+{
+  counters.insert(counters.end(), {
+                                      {"boxesDrawn", double(stats.boxesDrawn)},
+                                      {"occlusionCulled", double(stats.occlusionCulled)},
+                                      {"occlusionRescued", double(stats.occlusionRescued)},
+                                  });
+  for(uint32_t lod = 0; lod < shaderio::GRASS_LOD_COUNT; lod++)
+  {
+    counters.push_back({fmt::format("lodBlades{}", lod), double(stats.lodBlades[lod])});
+  }
+  counters.insert(counters.end(), {
+                                      {"tilesVisible", double(stats.tilesVisible)},
+                                      {"tightBoundsCulled", double(stats.tightBoundsCulled)},
+                                      {"ringThinned", double(stats.ringThinned)},
+                                      {"distanceThinned", double(stats.distanceThinned)},
+                                      {"taskWorkgroups", double(stats.taskWorkgroups)},
+                                      {"meshWorkgroups", double(stats.meshWorkgroups)},
+                                      {"verticesEmitted", double(stats.verticesEmitted)},
+                                      {"primitivesEmitted", double(stats.primitivesEmitted)},
+                                      {"fragmentsShaded", double(stats.fragmentsShaded)},
+                                  });
+}
+
+// Averaged frame timer sections as CSV, for automated runs (times in microseconds)
+static void writeProfilerReport(const nvutils::ProfilerManager& profilerManager, const std::filesystem::path& filename)
+{
+  std::vector<nvutils::ProfilerTimeline::Snapshot> frameSnapshots;
+  std::vector<nvutils::ProfilerTimeline::Snapshot> asyncSnapshots;
+  profilerManager.getSnapshots(frameSnapshots, asyncSnapshots);
+
+  std::ofstream file(filename);
+  if(!file)
+  {
+    LOGE("Failed to write the profiler report %s\n", nvutils::utf8FromPath(filename).c_str());
+    return;
+  }
+
+  file << "timeline,section,level,averagedFrames,gpuAverage,gpuMin,gpuMax,cpuAverage\n";
+  for(const nvutils::ProfilerTimeline::Snapshot& snapshot : frameSnapshots)
+  {
+    for(size_t i = 0; i < snapshot.timerInfos.size(); i++)
+    {
+      const nvutils::ProfilerTimeline::TimerInfo& info = snapshot.timerInfos[i];
+      file << fmt::format("{},{},{},{},{:.3f},{:.3f},{:.3f},{:.3f}\n", snapshot.name, snapshot.timerNames[i], info.level,
+                          info.numAveraged, info.gpu.average, info.gpu.absMinValue, info.gpu.absMaxValue, info.cpu.average);
+    }
+  }
+  LOGI("Profiler report written to %s\n", nvutils::utf8FromPath(filename).c_str());
+}
+
 int main(int argc, char** argv)
 {
   nvapp::ApplicationCreateInfo appInfo;
 
+  nvutils::ProfilerManager   profilerManager;
+  std::filesystem::path      profilerReport;
+  std::filesystem::path      profilerTrace;
+  uint32_t                   profilerTraceFrames = 120;
   nvutils::ParameterParser   cli(nvutils::getExecutablePath().stem().string());
   nvutils::ParameterRegistry reg;
   reg.add({"headless", "Run in headless mode"}, &appInfo.headless, true);
+  reg.add({"headlessFrames", "Frames rendered back to back in headless mode"}, &appInfo.headlessFrameCount, 1u);
+  reg.add({"headlessTimings", "Print the CPU and GPU time of each headless frame"}, &appInfo.headlessTimings, true);
+  reg.add({"headlessTimingsFile", "Write the CPU and GPU time of each headless frame to this JSON file"}, &appInfo.headlessTimingsFile);
+  reg.add({"lowLatency", "Wait for the previous present before sampling the input, uses VK_NV_low_latency2 when available"},
+          &appInfo.lowLatency, true);
+  reg.add({"framesInFlight", "Frames recorded ahead of the GPU (2-4), 0 uses the swapchain image count"},
+          &appInfo.framesInFlight, 0u, 4u);
+  reg.add({"autoFramesInFlight", "Pick the frames in flight from the measured CPU recording and GPU times"},
+          &appInfo.autoFramesInFlight, true);
+  reg.add({"cachedUI", "Rebuild the UI only on input and a few times per second, render the previous one otherwise"},
+          &appInfo.cachedUI, true);
+  std::string presentMode;
+  bool        swapchainMaintenance = false;
+  reg.add({"presentMode", "Present mode instead of the V-Sync setting: fifo, fifoRelaxed, mailbox or immediate"}, &presentMode);
+  bool asyncCompute = false;
+  reg.add({"asyncCompute", "Generate the virtual terrain pages on a compute queue, overlapping the graphics work"}, &asyncCompute, true);
+  reg.add({"swapchainImages", "Number of swapchain images, 0 uses the default"}, &appInfo.swapchainImageCount, 0u, 8u);
+  reg.add({"swapchainMaintenance", "Use VK_EXT_swapchain_maintenance1 when available: present fences, present mode switches without rebuild"},
+          &swapchainMaintenance, true);
+  reg.add({"profilerReport", "Write the averaged GPU timer sections to this CSV file when exiting"}, &profilerReport);
+  reg.add({"profilerTrace", "Capture the first frames as a Chrome trace JSON file (chrome://tracing, ui.perfetto.dev)"}, &profilerTrace);
+  reg.add({"profilerTraceFrames", "Number of frames captured by --profilerTrace"}, &profilerTraceFrames);
+
+  // Camera paths: --cameraPath replays a recorded path frame by frame, and can change with each SEQUENCE;
+  // --cameraRecord writes the camera of the whole run to a path when exiting
+  auto                  elemCamera = std::make_shared<nvapp::ElementCamera>();
+  std::filesystem::path cameraPathFile;
+  std::filesystem::path cameraRecordFile;
+  float                 cameraPathFrameTime = 1.0f / 60.0f;
+
+  auto playCameraPath = [&](const nvutils::ParameterBase*) {
+    nvutils::CameraPath path;
+    if(!cameraPathFile.empty() && path.load(cameraPathFile))
+    {
+      elemCamera->startPlayback(path, cameraPathFrameTime);
+    }
+  };
+  reg.add({"cameraPathFrameTime", "Path time in seconds advanced by each frame of the --cameraPath playback"},
+          &cameraPathFrameTime, 0.001f, 1.0f);
+  reg.add({.name = "cameraPath", .help = "Replay this camera path file, restarted each time it is given", .callbackSuccess = playCameraPath},
+          &cameraPathFile);
+  reg.add({"cameraRecord", "Record the camera to this path file, written when exiting"}, &cameraRecordFile);
+
+  // The grass settings can be given here, and changed by each SEQUENCE of a benchmark script
+  auto elemGrass = std::make_shared<MeshShaderGrass>(&profilerManager);
+  elemGrass->registerParameters(reg);
   cli.add(reg);
+
+  // Benchmark: --sequencefile or --sequencestring, each sequence runs --sequenceframes frames
+  // and is written to --sequencereport, compared against --sequencebaseline when given
+  nvutils::ParameterSequencer::InitInfo sequencerInfo;
+  sequencerInfo.registerScriptParameters(reg, cli);
+  sequencerInfo.parameterParser   = &cli;
+  sequencerInfo.parameterRegistry = &reg;
+  sequencerInfo.profilerManager   = &profilerManager;
+  // Counters of the last completed frame, none when no frame of the sequence completed
+  sequencerInfo.reportCounters = [&](const nvutils::ParameterSequencer::State&, std::vector<nvutils::SequenceReport::Counter>& counters) {
+    if(const shaderio::Statistics* stats = elemGrass->getStatistics())
+    {
+      appendStatisticsCounters(*stats, counters);
+    }
+    // Frame times of the camera path segments played during the sequence
+    const std::vector<double> segmentFrameTimes = elemCamera->getSegmentFrameTimes();
+    for(size_t i = 0; i < segmentFrameTimes.size(); i++)
+    {
+      counters.push_back({fmt::format("cameraSegment{}FrameTimeMs", i), segmentFrameTimes[i]});
+    }
+  };
+
   cli.parse(argc, argv);
 
+  // Compare tool mode, no rendering: --sequencereport current.csv --sequencebaseline baseline.csv
+  if(!sequencerInfo.hasScript() && sequencerInfo.hasReportCompare())
+  {
+    return sequencerInfo.compareReports() == 0 ? 0 : 1;
+  }
+
   // Mesh shader feature and properties structures
   VkPhysicalDeviceMeshShaderPropertiesEXT meshShaderProps{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_PROPERTIES_EXT};
   VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT};
   meshShaderFeatures.pNext = &meshShaderProps;
   VkPhysicalDeviceFragmentShadingRateFeaturesKHR shadingRateFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR};
+  VkPhysicalDevicePresentIdFeaturesKHR   presentIdFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR};
+  VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR};
+  VkPhysicalDeviceSwapchainMaintenance1FeaturesEXT swapchainMaintenanceFeatures{
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SWAPCHAIN_MAINTENANCE_1_FEATURES_EXT};
 
   nvvk::ContextInitInfo vkSetup;
+  if(asyncCompute)
+  {
+    vkSetup.queues.push_back(VK_QUEUE_COMPUTE_BIT);
+  }
   if(!appInfo.headless)
   {
     nvvk::addSurfaceExtensions(vkSetup.instanceExtensions);
     vkSetup.deviceExtensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    // Low latency, all optional: the application falls back to the frame pacer
+    if(appInfo.lowLatency)
+    {
+      vkSetup.deviceExtensions.push_back({VK_KHR_PRESENT_ID_EXTENSION_NAME, &presentIdFeatures, false});
+      vkSetup.deviceExtensions.push_back({VK_KHR_PRESENT_WAIT_EXTENSION_NAME, &presentWaitFeatures, false});
+      vkSetup.deviceExtensions.push_back({VK_NV_LOW_LATENCY_2_EXTENSION_NAME, nullptr, false});
+    }
+    // The instance extension is required, so this is opt-in
+    if(swapchainMaintenance)
+    {
+      vkSetup.instanceExtensions.emplace_back(VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME);
+      vkSetup.deviceExtensions.push_back({VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME, &swapchainMaintenanceFeatures, false});
+    }
   }
   vkSetup.instanceExtensions.emplace_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
   // Enable mesh shader extension
-  vkSetup.deviceExtensions.push_back({VK_EXT_MESH_SHADER_EXTENSION_NAME, &meshShaderFeatures});
-  vkSetup.deviceExtensions.push_back({VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME, &shadingRateFeatures});
+  // Both optional, the grass is drawn by a compute and vertex shader fallback without them
+  vkSetup.deviceExtensions.push_back({VK_EXT_MESH_SHADER_EXTENSION_NAME, &meshShaderFeatures, false});
+  vkSetup.deviceExtensions.push_back({VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME, &shadingRateFeatures, false});
+  // Optional, lines up the GPU sections of the profiler traces with the CPU ones
+  vkSetup.deviceExtensions.push_back({VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME, nullptr, false});
 
   // Adding validation layers
   nvvk::ValidationSettings vvlInfo{};
@@ -598,27 +3930,81 @@ int main(int argc, char** argv)
 
   // Application setup
   appInfo.name           = fmt::format("{} ({})", nvutils::getExecutablePath().stem().string(), SHADER_LANGUAGE_STR);
-  appInfo.vSync          = true;
+  appInfo.vSync          = !sequencerInfo.hasScript();  // Benchmarks measure unthrottled frames
   appInfo.instance       = vkContext.getInstance();
   appInfo.device         = vkContext.getDevice();
   appInfo.physicalDevice = vkContext.getPhysicalDevice();
   appInfo.queues         = vkContext.getQueueInfos();
+  if(asyncCompute && appInfo.queues.size() > 1)
+  {
+    appInfo.computeQueueIndex = 1;
+  }
+
+  // GPU and driver the sequences ran on, for the benchmark report
+  {
+    VkPhysicalDeviceDriverProperties driverProps{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DRIVER_PROPERTIES};
+    VkPhysicalDeviceProperties2      deviceProps{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &driverProps};
+    vkGetPhysicalDeviceProperties2(vkContext.getPhysicalDevice(), &deviceProps);
+    const VkPhysicalDeviceProperties& props = deviceProps.properties;
+    sequencerInfo.reportMachineInfo         = {
+        {"gpu", props.deviceName},
+        {"vendorID", fmt::format("0x{:04x}", props.vendorID)},
+        {"deviceID", fmt::format("0x{:04x}", props.deviceID)},
+        {"driverName", driverProps.driverName},
+        {"driverInfo", driverProps.driverInfo},
+        {"driverVersion", std::to_string(props.driverVersion)},
+        {"vulkanApi", fmt::format("{}.{}.{}", VK_API_VERSION_MAJOR(props.apiVersion), VK_API_VERSION_MINOR(props.apiVersion),
+                                  VK_API_VERSION_PATCH(props.apiVersion))},
+        {"shaderLanguage", SHADER_LANGUAGE_STR},
+    };
+  }
+
+  const bool hasPresentId    = vkContext.hasExtensionEnabled(VK_KHR_PRESENT_ID_EXTENSION_NAME) && presentIdFeatures.presentId;
+  appInfo.presentWaitEnabled = hasPresentId && vkContext.hasExtensionEnabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)
+                               && presentWaitFeatures.presentWait;
+  appInfo.lowLatency2Enabled = hasPresentId && vkContext.hasExtensionEnabled(VK_NV_LOW_LATENCY_2_EXTENSION_NAME);
+  appInfo.profilerManager    = &profilerManager;
+
+  appInfo.swapchainMaintenance1Enabled = vkContext.hasExtensionEnabled(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME)
+                                         && swapchainMaintenanceFeatures.swapchainMaintenance1;
+  if(!presentMode.empty())
+  {
+    const std::unordered_map<std::string, VkPresentModeKHR> presentModes = {{"fifo", VK_PRESENT_MODE_FIFO_KHR},
+                                                                            {"fifoRelaxed", VK_PRESENT_MODE_FIFO_RELAXED_KHR},
+                                                                            {"mailbox", VK_PRESENT_MODE_MAILBOX_KHR},
+                                                                            {"immediate", VK_PRESENT_MODE_IMMEDIATE_KHR}};
+    auto it = presentModes.find(presentMode);
+    if(it != presentModes.end())
+      appInfo.presentMode = it->second;
+    else
+      LOGW("Unknown present mode: %s\n", presentMode.c_str());
+  }
 
   // Setting up the layout of the application
   appInfo.dockSetup = [](ImGuiID viewportID) {
     ImGuiID settingID = ImGui::DockBuilderSplitNode(viewportID, ImGuiDir_Left, 0.2F, nullptr, &viewportID);
     ImGui::DockBuilderDockWindow("Settings", settingID);
+    ImGuiID profilerID = ImGui::DockBuilderSplitNode(viewportID, ImGuiDir_Down, 0.3F, nullptr, &viewportID);
+    ImGui::DockBuilderDockWindow("Profiler", profilerID);
 
   };
 
   // Create the application
   nvapp::Application app;
+  // The sequencer closes the application after the last sequence
+  if(sequencerInfo.hasScript())
+  {
+    appInfo.headlessFrameCount = ~0u;
+  }
   app.init(appInfo);
 
   // Camera manipulator (global)
-  g_cameraManip   = std::make_shared<nvutils::CameraManipulator>();
-  auto elemCamera = std::make_shared<nvapp::ElementCamera>();
+  g_cameraManip = std::make_shared<nvutils::CameraManipulator>();
   elemCamera->setCameraManipulator(g_cameraManip);
+  if(!cameraRecordFile.empty())
+  {
+    elemCamera->startRecording();
+  }
 
 
 
@@ -626,10 +4012,33 @@ int main(int argc, char** argv)
   app.addElement(elemCamera);
   app.addElement(std::make_shared<nvapp::ElementDefaultMenu>());
   app.addElement(std::make_shared<nvapp::ElementDefaultWindowTitle>("", fmt::format("({})", SHADER_LANGUAGE_STR)));
-  app.addElement(std::make_shared<MeshShaderGrass>());
+  app.addElement(std::make_shared<nvapp::ElementProfiler>(&profilerManager));
+  // Before the grass, so the settings of a new sequence apply to the frame it starts
+  app.addElement(std::make_shared<nvapp::ElementSequencer>(sequencerInfo));
+  app.addElement(elemGrass);
+
 
+  if(!profilerTrace.empty())
+  {
+    profilerManager.beginTraceCapture(profilerTraceFrames);
+  }
 
   app.run();
+
+  if(elemCamera->isRecording())
+  {
+    elemCamera->stopRecording().save(cameraRecordFile);
+  }
+
+  // Timelines are destroyed when the elements detach in deinit()
+  if(!profilerReport.empty())
+  {
+    writeProfilerReport(profilerManager, profilerReport);
+  }
+  if(!profilerTrace.empty() && profilerManager.saveTraceJson(profilerTrace))
+  {
+    LOGI("Profiler trace written to %s\n", nvutils::utf8FromPath(profilerTrace).c_str());
+  }
   app.deinit();
 
   vkContext.deinit();
@@ -25,31 +25,253 @@
 NAMESPACE_SHADERIO_BEGIN()
 
 // Constants - are overridden at compile time by the application
+// The task and mesh workgroup sizes are only the defaults of specialization constants (see SpecConstant),
+// one SPIR-V serves every device and every tuned configuration
 #ifndef MESHSHADER_WORKGROUP_SIZE
 #define MESHSHADER_WORKGROUP_SIZE 32U
 #endif
 
+// The task workgroup may span several subgroups, up to 128 threads (8-bit patch indices in the payloads)
 #ifndef TASKSHADER_WORKGROUP_SIZE
 #define TASKSHADER_WORKGROUP_SIZE 32U
 #endif
 
+// The payloads and groupshared arrays of a task workgroup are sized for the largest one
+#define TASKSHADER_MAX_WORKGROUP_SIZE 128U
 
+#ifndef HIZ_WORKGROUP_SIZE
+#define HIZ_WORKGROUP_SIZE 16U
+#endif
+
+#ifndef UPSCALE_WORKGROUP_SIZE
+#define UPSCALE_WORKGROUP_SIZE 16U
+#endif
+
+#ifndef TERRAIN_WORKGROUP_SIZE
+#define TERRAIN_WORKGROUP_SIZE 16U
+#endif
+
+// Ground quadtree (CDLOD): each root node splits up to GROUND_MAX_DEPTH times, the task workgroup of a root
+// has one thread per finest node. A node is drawn by one mesh workgroup as GROUND_NODE_QUADS x GROUND_NODE_QUADS
+// quads, a quad of the finest nodes covers GROUND_QUAD_PATCHES x GROUND_QUAD_PATCHES grass patches.
+#define GROUND_MAX_DEPTH 3U
+#define GROUND_NODE_QUADS 8U
+#define GROUND_QUAD_PATCHES 2U
+
+// 1: the mesh shader computes the per-blade attributes once into groupshared memory
+// 0: every vertex recomputes the attributes of its blade
+#ifndef MESH_BLADE_CACHE
+#define MESH_BLADE_CACHE 1
+#endif
+
+// 1: the mesh shader outputs the position and the blade coordinates per vertex, the normal per primitive,
+//    and the fragment shader rebuilds the color from the height along the blade
+// 0: position, color, normal and uv per vertex
+#ifndef MESH_COMPACT_OUTPUT
+#define MESH_COMPACT_OUTPUT 1
+#endif
+
+// 1: the mesh shader writes a per-primitive fragment shading rate, coarser with the distance and toward the blade tips
+// 0: every fragment is shaded
+#ifndef MESH_SHADING_RATE
+#define MESH_SHADING_RATE 0
+#endif
+
+// 1: the grass is drawn into several views at once with VK_KHR_multiview, the task shader culls against
+//    the union of the views and the mesh shader projects with the matrix of SV_ViewID
+// 0: single view of the camera
+#ifndef MESH_MULTIVIEW
+#define MESH_MULTIVIEW 0
+#endif
+
+// 1: the blade shading math (taper, wind offset, color gradient, lighting) is evaluated in fp16, needs shaderFloat16
+// 0: fp32 everywhere
+#ifndef MESH_HALF
+#define MESH_HALF 0
+#endif
+
+// 1: the mesh shader outputs other than the position are fp16, needs storageInputOutput16
+// 0: fp32 outputs
+#ifndef MESH_HALF_INTERPOLANTS
+#define MESH_HALF_INTERPOLANTS 0
+#endif
+
+// 1: the mesh shaders also output a per-primitive color of the work that drew the blade, shown by the fragment
+//    shader in place of the grass color when FrameInfo::debugView is not eDebugViewNone
+// 0: no debug output
+#ifndef MESH_DEBUG_VIEW
+#define MESH_DEBUG_VIEW 0
+#endif
+
+
+// Specialization constants of mesh_task.slang, set by the host when creating the pipelines
+enum SpecConstant
+{
+  eSpecTaskWorkgroupSize = 0,
+  eSpecMeshWorkgroupSize,
+};
+
+#ifdef __SLANG__
+// Number of boxes per task workgroup (1:1 mapping with threads)
+layout(constant_id = SpecConstant::eSpecTaskWorkgroupSize) const uint BOXES_PER_TASK = TASKSHADER_WORKGROUP_SIZE;
+#else
 static const uint BOXES_PER_TASK = TASKSHADER_WORKGROUP_SIZE;  // Number of boxes per task workgroup (1:1 mapping with threads)
+#endif
 static const uint BOXES_PER_MESH = 8U;  // Max boxes per mesh shader workgroup (limited by max_vertices = 64 / 8 vertices per box)
 static const uint VERTICES_PER_BOX = 8;
 static const uint LINES_PER_BOX    = 12;
 
+// Number of 32-bit words needed to store one visibility bit per patch of a task workgroup, and of the largest one
+#define VISIBILITY_WORDS_PER_TASK ((BOXES_PER_TASK + 31U) / 32U)
+static const uint MAX_VISIBILITY_WORDS_PER_TASK = (TASKSHADER_MAX_WORKGROUP_SIZE + 31U) / 32U;
+
+// Grass blade level of detail: LOD n uses (GRASS_SEGMENTS >> n) segments, so 4, 2 and 1
+static const uint GRASS_SEGMENTS  = 4U;  // Number of segments of a full detail grass blade
+static const uint GRASS_LOD_COUNT = 3U;  // Number of blade LODs
+
+// Culling tiles: one task workgroup wide (BOXES_PER_TASK patches) and TILE_ROWS rows of patches deep
+static const uint TILE_ROWS = 32U;
+
+// Visible tile list written by the tile culling pass: a VkDrawMeshTasksIndirectCommandEXT,
+// padded to TILE_LIST_OFFSET words, followed by the indices of the visible tiles
+static const uint TILE_LIST_OFFSET = 4U;
+
+#ifndef TILE_WORKGROUP_SIZE
+#define TILE_WORKGROUP_SIZE 64U
+#endif
+
+// Extra grass fields, all drawn by one indirect draw of a task workgroup grid per visible field.
+// The visible field list written by the field culling pass is a VkDrawMeshTasksIndirectCommandEXT,
+// padded to FIELD_LIST_OFFSET words, followed by the indices of the visible fields (see fieldCullMain)
+static const uint FIELD_MAX_COUNT   = 64U;
+static const uint FIELD_LIST_OFFSET = 4U;
+
+// Global compaction of the blades: the compacted list written by the compute cull is a VkDrawMeshTasksIndirectCommandEXT
+// of mesh workgroups, the blade count of each LOD at COMPACT_LOD_COUNTS, padded to COMPACT_LIST_OFFSET words, then
+// one region per LOD of the grid patch count holding the surviving patches (x | z << 16) (see compactCullMain)
+static const uint COMPACT_LOD_COUNTS  = 4U;
+static const uint COMPACT_LIST_OFFSET = 8U;
+
+// Vertex shader fallback, in the same buffer as the global compaction: one VkDrawIndirectCommand per LOD drawing
+// an instance per blade, then the same per-LOD regions of surviving patches at VERTEX_LIST_OFFSET (see vertexCullMain)
+static const uint VERTEX_LIST_OFFSET = 4U * GRASS_LOD_COUNT;
+
+// Cascaded shadow maps of the sun: one layer of the shadow map per cascade, drawn by a single
+// shadow pass culling every patch against all the cascades (see shadowTaskMain)
+static const uint SHADOW_MAX_CASCADES = 4U;
+
+// Views of the multiview rendering: the two eyes of a stereo pair, or the six faces of a cube
+static const uint MULTIVIEW_MAX_VIEWS = 6U;
+
+// Resolution of the baked terrain map, one texel per grass patch of the largest grid (1000 x 1000)
+static const uint TERRAIN_MAP_SIZE = 1024U;
+
+// Resolution of the wind map stretched over the grid, the shortest wind wave spans about 25 units
+static const uint WIND_MAP_SIZE = 256U;
+
+static const uint GROUND_LEAVES        = 1U << GROUND_MAX_DEPTH;  // Finest nodes per root side
+static const uint GROUND_ROOT_PATCHES  = GROUND_LEAVES * GROUND_NODE_QUADS * GROUND_QUAD_PATCHES;  // Patches per root side
+static const uint GROUND_NODE_VERTICES = (GROUND_NODE_QUADS + 1) * (GROUND_NODE_QUADS + 1);
+static const uint GROUND_NODE_TRIANGLES = GROUND_NODE_QUADS * GROUND_NODE_QUADS * 2;
+
+// Trample map: TRAMPLE_PATCHES_PER_TEXEL x TRAMPLE_PATCHES_PER_TEXEL patches per texel, anchored in the world
+// and wrapping around, it covers the largest grid. Objects flattening the grass are read from a buffer of at
+// most TRAMPLE_MAX_INTERACTORS
+static const uint TRAMPLE_MAP_SIZE          = 512U;
+static const uint TRAMPLE_PATCHES_PER_TEXEL = 2U;
+static const uint TRAMPLE_MAX_INTERACTORS   = 256U;
+
+// Virtual terrain: the world cells are split in pages of VIRTUAL_TERRAIN_PAGE_CELLS x VIRTUAL_TERRAIN_PAGE_CELLS,
+// the pages around the camera are generated in the layers of an atlas of VIRTUAL_TERRAIN_MAX_PAGES. A page holds
+// one more row and column, the first ones of the next pages, so that the bilinear filtering stays in its layer.
+// The page table is a window of VIRTUAL_TERRAIN_TABLE_SIZE x VIRTUAL_TERRAIN_TABLE_SIZE pages, -1 when not resident
+static const uint VIRTUAL_TERRAIN_PAGE_CELLS  = 128U;
+static const uint VIRTUAL_TERRAIN_PAGE_TEXELS = VIRTUAL_TERRAIN_PAGE_CELLS + 1U;
+static const uint VIRTUAL_TERRAIN_TABLE_SIZE  = 32U;
+static const uint VIRTUAL_TERRAIN_MAX_PAGES   = 256U;
+
+// Bindings of the grass pipeline descriptor set
+enum GrassBinding
+{
+  eFrameInfo = 0,
+  eHizPyramid,
+  eTerrainMap,         // Baked terrain height and grass height multiplier (sampled)
+  eTerrainMapStorage,  // Same image, written by the bake pass
+  eShadowMap,          // Depth of the shadow cascades, one layer each (sampled with comparison)
+  eWindMap,            // Wind displacement over the grid, evaluated each frame (sampled)
+  eWindMapStorage,     // Same image, written by the wind pass
+  eTrampleMap,         // Flattening of the grass by the interactors, decaying over time (sampled)
+  eTrampleMapStorage,  // Same image, written by the trample pass
+  eVirtualTerrain,         // Pages of the virtual terrain, one layer each, same content as the terrain map (sampled)
+  eVirtualTerrainStorage,  // Same image, written by the page generation pass
+};
+
+// Bindings of the depth pyramid reduction pass (push descriptors)
+enum HizBinding
+{
+  eHizSource = 0,
+  eHizDestination,
+};
+
+// Bindings of the upscale pass of the dynamic resolution (push descriptors)
+enum UpscaleBinding
+{
+  eUpscaleSource = 0,
+  eUpscaleDestination,
+};
+
+// Occlusion culling pass executed by the task shader
+// With temporalCulling, the first pass draws the patches visible last frame instead of testing them, and the
+// second pass tests all the patches against the current pyramid, draws the new ones and keeps the visible set
+enum OcclusionPass
+{
+  eOcclusionDisabled = 0,  // Frustum culling only
+  eOcclusionFirst,         // Test against last frame's pyramid, remember rejected patches
+  eOcclusionSecond,        // Re-test the rejected patches against the current pyramid
+};
+
+// Debug visualization of the grass, with MESH_DEBUG_VIEW
+enum DebugView
+{
+  eDebugViewNone = 0,       // Grass shading
+  eDebugViewLod,            // Blade LOD: green, yellow, red
+  eDebugViewMeshFill,       // Blades of the mesh workgroup over its capacity, heatmap from empty (blue) to full (red)
+  eDebugViewTaskWorkgroup,  // A random color per task workgroup (per mesh workgroup with the global compaction)
+  eDebugViewTaskCulling,    // Patches of the task workgroup surviving the culling, heatmap from few (blue) to all (red)
+};
+
 struct PushConstant
 {
   uint32_t totalBoxesX;  // Total number of boxes in X dimension
   uint32_t totalBoxesZ;  // Total number of boxes in Z dimension
   float    boxSize;
   float    spacing;
-  uint64_t statisticsAddr;  // Buffer device address for statistics buffer
-  float    time;            // Animation time
-  float    animSpeed;       // Animation speed multiplier
-  float    swayStrength;    // Wind sway strength multiplier
-  float2   windDirection;   // 风向参数（可由UI修改）
+  uint32_t occlusionPass;   // OcclusionPass executed by this draw
+  uint32_t useBakedTerrain; // Sample the baked terrain map instead of evaluating the noise
+  uint2    tileOffset;      // First task workgroup of this draw, when the grid is split in several draws (first patch of a terrain bake)
+  uint32_t useTileCulling;  // Task workgroups are launched for the visible culling tiles only
+  uint32_t useTightBounds;  // Cull the patches with their baked bounding box instead of the conservative sphere
+  int2     gridOrigin;      // Infinite meadow: world cell of patch (0, 0), the window follows the camera
+  uint32_t infiniteGrass;   // The grid is a window of the world cells around the camera instead of a fixed field
+  uint32_t useWindMap;      // Fetch the wind of the blades from the wind map instead of evaluating it
+  uint32_t useTrample;      // Flatten the blades with the trample map
+  uint32_t usePlacementBuffer;  // Read the blade placement from the placement buffer instead of hashing it
+  uint32_t temporalCulling;     // The occlusion bits are the patches visible last frame, kept from frame to frame
+  uint32_t drawFields;          // The task workgroups are of the extra fields, groupID.z being an entry of the visible field list
+  int2     virtualPageCell;     // Page generation: world cell of the first texel of the page
+  uint32_t virtualPageLayer;    // Page generation: layer of the atlas receiving the page
+};
+
+
+// An extra grass field: a rectangle of world cells with its own density, blade height and wind
+struct GrassField
+{
+  int2  cellOrigin;   // World cell of patch (0, 0), a cell of coordinates c being centered at c * spacing
+  uint2 size;         // Number of patches in X and Z
+  float density;      // Fraction of the patches drawn
+  float heightScale;  // Multiplier of the blade height
+  float windScale;    // Multiplier of the wind sway
+  float _pad;
 };
 
 struct FrameInfo
@@ -59,6 +281,67 @@ struct FrameInfo
   float3   camPos;
   float    _pad0;
   float4   frustumPlanes[6];  // Left, Right, Bottom, Top, Near, Far (xyz=normal, w=distance)
+  uint2    hizSize;           // Size of the depth pyramid level 0
+  uint     hizLevels;         // Number of mip levels of the depth pyramid
+  float    pixelsPerUnit;     // Projected size in pixels of one unit at a distance of one unit
+  uint     ringCells;         // Infinite meadow: width in cells of the density rings around the camera
+  float    ringDensity;       // Infinite meadow: fraction of the patches kept by each ring from the previous one
+  float2   shadingRateDistance;  // Distance of a blade beyond which its fragments are shaded 2x2 (x) and 4x4 (y), MESH_SHADING_RATE
+  float3   lightDir;             // Direction toward the sun
+  uint     shadowCascades;       // Number of shadow cascades, 0 without shadows
+  float4   shadowSplits;         // View depth where each cascade ends
+  float4x4 viewProjInv;          // Inverse of proj * view, rebuilds the world position of a fragment
+  float4x4 shadowViewProj[SHADOW_MAX_CASCADES];     // World to light clip space of each cascade
+  float4   shadowPlanes[SHADOW_MAX_CASCADES][6];    // Culling planes of each cascade, same layout as frustumPlanes
+  float2   viewportSize;         // Size in pixels of the GBuffer
+  uint     viewCount;            // Views of the multiview rendering, MESH_MULTIVIEW
+  uint     _pad1;
+  float4x4 multiviewViewProj[MULTIVIEW_MAX_VIEWS];   // World to clip space of each view
+  float4   multiviewPlanes[MULTIVIEW_MAX_VIEWS][6];  // Frustum planes of each view, same layout as frustumPlanes
+  int2     virtualTerrainOrigin;     // Page of the entry (0, 0) of the virtual terrain page table
+  uint64_t virtualTerrainTableAddr;  // Buffer device address of the page table (int per page), 0 without virtual terrain
+
+  // Grass parameters shared by all the passes of the frame, the push constants only hold what differs between them
+  uint64_t statisticsAddr;     // Buffer device address for statistics buffer
+  uint64_t visibilityAddr;     // Buffer device address of the per-patch occlusion bits (VISIBILITY_WORDS_PER_TASK per task workgroup)
+  uint64_t tileBoundsAddr;     // Buffer device address of the terrain height range (float2) of each culling tile
+  uint64_t visibleTilesAddr;   // Buffer device address of the visible tile list (see TILE_LIST_OFFSET)
+  uint64_t patchBoundsAddr;    // Buffer device address of the terrain height range (float2) under each grass blade
+  uint64_t placementAddr;      // Buffer device address of the BladePlacement of each patch, indexed as the patch bounds
+  uint64_t compactBladesAddr;  // Buffer device address of the compacted blade list of the global compaction (see COMPACT_LIST_OFFSET)
+  uint64_t interactorsAddr;    // Buffer device address of the interactors (Interactor) flattening the grass
+  uint64_t fieldsAddr;         // Buffer device address of the GrassField descriptors
+  uint64_t visibleFieldsAddr;  // Buffer device address of the visible field list (see FIELD_LIST_OFFSET)
+  float2   windDirection;      // 风向参数（可由UI修改）
+  float2   lodPixelHeight;     // Projected blade height (pixels) below which LOD 1 (x) and LOD 2 (y) are used
+  float2   thinPixelHeight;    // Projected blade height (pixels) where the distance thinning starts (x) and reaches thinMinKeep (y), 0 disables it
+  float    time;               // Animation time
+  float    animSpeed;          // Animation speed multiplier
+  float    swayStrength;       // Wind sway strength multiplier
+  float    thinMinKeep;        // Fraction of the blades kept below thinPixelHeight.y, the kept ones widen by its inverse
+  float    densityScale;       // Fraction of the blades kept by the frame time budget on top of the thinning, the kept ones widen as well
+  float    groundLodRange;     // Ground nodes closer than this many times their size are split
+  float    trampleDecay;       // Fraction of the flattening kept since the previous frame
+  uint32_t interactorCount;    // Number of interactors, at most TRAMPLE_MAX_INTERACTORS
+  uint32_t fieldCount;         // Number of extra fields, at most FIELD_MAX_COUNT
+  uint32_t debugView;          // DebugView of the grass, MESH_DEBUG_VIEW
+};
+
+// Push constant of the depth pyramid reduction pass
+struct HizPushConstant
+{
+  uint2 srcSize;  // Size of the level being read
+  uint2 dstSize;  // Size of the level being written
+};
+
+// Push constant of the upscale pass
+struct UpscalePushConstant
+{
+  uint2  srcSize;    // Rendered size, the top-left rectangle of the source image
+  uint2  dstSize;    // Display size
+  float2 uvScale;    // UV of the bottom-right corner of the rendered rectangle
+  float  sharpness;  // 0: bilinear, 1: strongest sharpening
+  float  _pad;
 };
 
 // Task mesh payload (shared between task and mesh shader)
@@ -66,14 +349,62 @@ struct TaskPayload
 {
   uint    gridX;
   uint    gridZ;
+  uint    fieldIndex;                           // Extra field of the patches, with drawFields
   uint    numSurvivingBoxes;                    // Number of boxes that passed frustum culling
-  uint8_t survivingBoxIndices[BOXES_PER_TASK];  // Local indices (0-31) of boxes that survived
+  uint    lodBladeCount[GRASS_LOD_COUNT];       // Surviving boxes per LOD, stored one LOD after the other
+  uint8_t survivingBoxIndices[TASKSHADER_MAX_WORKGROUP_SIZE];  // Local indices (0 to BOXES_PER_TASK-1) of boxes that survived
+};
+
+// Task mesh payload of the ground: the visible nodes of a root, each packed as the finest node of its
+// first corner (3 bits x, 3 bits y) and its depth (2 bits)
+struct GroundPayload
+{
+  int2    root;
+  uint    nodeCount;
+  uint8_t nodes[GROUND_LEAVES * GROUND_LEAVES];
+};
+
+// Placement of the blade of a patch, baked with the terrain (see terrainBakeMain) or authored
+struct BladePlacement
+{
+  uint32_t offset;          // Root within the cell, x and z as 16-bit unorm of the spacing (0.5: cell center)
+  uint32_t rotationHeight;  // Rotation around Y (16-bit unorm of a turn), grass height multiplier (16-bit unorm of 0 to 2)
+};
+
+// Object flattening the grass around it, such as a character or a vehicle
+struct Interactor
+{
+  float3 position;  // World position of the contact with the ground
+  float  radius;    // Radius of the flattened area
+};
+
+// Task mesh payload of the shadow pass: the patches of each cascade, stored one cascade after the other
+struct ShadowPayload
+{
+  uint    gridX;
+  uint    gridZ;
+  uint    cascadeBladeCount[SHADOW_MAX_CASCADES];                    // Patches inside each cascade
+  uint8_t survivingBoxIndices[SHADOW_MAX_CASCADES * TASKSHADER_MAX_WORKGROUP_SIZE];  // Local indices of the patches of each cascade
 };
 
 // Statistics buffer for atomic counters
 struct Statistics
 {
-  uint32_t boxesDrawn;  // Total number of boxes that passed frustum culling and were drawn
+  uint32_t boxesDrawn;        // Total number of boxes that passed frustum culling and were drawn
+  uint32_t occlusionCulled;   // Patches inside the frustum rejected by the depth pyramid in the final pass
+  uint32_t occlusionRescued;  // Patches rejected by the first pass that the second pass found visible
+  uint32_t lodBlades[GRASS_LOD_COUNT];  // Blades drawn at each LOD
+  uint32_t tilesVisible;      // Culling tiles that passed the tile frustum test
+  uint32_t tightBoundsCulled; // Patches the conservative sphere would keep but the tight bounds reject
+  uint32_t ringThinned;       // Infinite meadow: patches skipped by the density falloff of the rings
+  uint32_t distanceThinned;   // Patches dropped by the projected size thinning
+  uint32_t taskWorkgroups;    // Task workgroups launched
+  uint32_t meshWorkgroups;    // Mesh workgroups emitted by the task shaders
+  uint32_t verticesEmitted;   // Vertices output by the mesh shaders
+  uint32_t primitivesEmitted; // Triangles output by the mesh shaders
+  uint32_t fragmentsShaded;   // Fragment shader invocations, after the early depth test
+  uint32_t meshBlades;        // Blades generated by the mesh workgroups
+  uint32_t meshBladeSlots;    // Blades the mesh workgroups could hold at their LOD, meshBlades / meshBladeSlots is the fill rate
 };
 
 NAMESPACE_SHADERIO_END()
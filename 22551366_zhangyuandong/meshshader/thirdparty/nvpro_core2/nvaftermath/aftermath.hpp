@@ -36,6 +36,9 @@
 // 3. Add a callback to the CheckError to catch the device lost.
 // 4. Add the shader binaries to the AftermathCrashTracker::getInstance().addShaderBinary(data) when compiling shaders
 // 5. Add to CMake the Aftermath library: nvpro2::nvaftermath 
+//
+// Aftermath is too costly to keep enabled in production, GpuBreadcrumbs (breadcrumbs.hpp)
+// localizes the crashes with a few markers per frame instead.
 
 
 Example:
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cassert>
+
+#include <volk.h>
+
+#include <nvutils/logger.hpp>
+#include <nvvk/check_error.hpp>
+#include <nvvk/debug_util.hpp>
+
+#include "breadcrumbs.hpp"
+
+
+GpuBreadcrumbs& GpuBreadcrumbs::getInstance()
+{
+  static GpuBreadcrumbs instance;
+  return instance;
+}
+
+VkResult GpuBreadcrumbs::init(nvvk::ResourceAllocator* alloc, uint32_t queueCount, bool bufferMarkerEnabled)
+{
+  assert(!isInitialized() && queueCount > 0);
+  m_alloc           = alloc;
+  m_queueCount      = queueCount;
+  m_useBufferMarker = bufferMarkerEnabled && vkCmdWriteBufferMarker2AMD != nullptr;
+
+  // Host visible and mapped: it is read after the device is lost, without any command
+  NVVK_FAIL_RETURN(alloc->createBuffer(m_buffer, sizeof(uint32_t) * eSlotCount * queueCount, VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
+                                       VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                                       VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT));
+  NVVK_DBG_NAME(m_buffer.buffer);
+
+  uint32_t* words = reinterpret_cast<uint32_t*>(m_buffer.mapping);
+  for(uint32_t queue = 0; queue < queueCount; queue++)
+  {
+    words[queue * eSlotCount + eFrame]     = 0;
+    words[queue * eSlotCount + eStarted]   = kNoPass;
+    words[queue * eSlotCount + eCompleted] = kNoPass;
+  }
+  vmaFlushAllocation(*alloc, m_buffer.allocation, 0, VK_WHOLE_SIZE);
+
+  LOGI("GPU breadcrumbs: %u queues, written with %s\n", queueCount, m_useBufferMarker ? "buffer markers" : "buffer fills");
+  return VK_SUCCESS;
+}
+
+void GpuBreadcrumbs::deinit()
+{
+  if(!isInitialized())
+    return;
+  m_alloc->destroyBuffer(m_buffer);
+  m_buffer     = {};
+  m_queueCount = 0;
+
+  std::lock_guard lock(m_mutex);
+  m_passIndices.clear();
+  m_passNames.clear();
+}
+
+uint32_t GpuBreadcrumbs::getPassIndex(const std::string& name)
+{
+  std::lock_guard lock(m_mutex);
+  auto [it, inserted] = m_passIndices.try_emplace(name, uint32_t(m_passNames.size()));
+  if(inserted)
+  {
+    m_passNames.push_back(name);
+  }
+  return it->second;
+}
+
+void GpuBreadcrumbs::cmdWrite(VkCommandBuffer cmd, uint32_t queue, Slot slot, VkPipelineStageFlags2 stage, uint32_t value)
+{
+  assert(queue < m_queueCount);
+  const VkDeviceSize offset = sizeof(uint32_t) * (queue * eSlotCount + slot);
+
+  if(m_useBufferMarker)
+  {
+    // Written once all the previous commands went through `stage`
+    vkCmdWriteBufferMarker2AMD(cmd, stage, m_buffer.buffer, offset, value);
+    return;
+  }
+
+  // A fill is a transfer that doesn't wait for the previous commands: the completion needs a barrier.
+  // It drains the pipeline, mark the large passes only, or enable VK_AMD_buffer_marker.
+  if(stage != VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT)
+  {
+    const VkMemoryBarrier2 barrier{.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                   .srcStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                                   .dstStageMask  = VK_PIPELINE_STAGE_2_CLEAR_BIT};
+    const VkDependencyInfo dependencyInfo{.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .memoryBarrierCount = 1, .pMemoryBarriers = &barrier};
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+  }
+  vkCmdFillBuffer(cmd, m_buffer.buffer, offset, sizeof(uint32_t), value);
+}
+
+void GpuBreadcrumbs::cmdBeginFrame(VkCommandBuffer cmd, uint32_t queue, uint32_t frame)
+{
+  if(!isInitialized())
+    return;
+  cmdWrite(cmd, queue, eFrame, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, frame);
+}
+
+void GpuBreadcrumbs::cmdBeginPass(VkCommandBuffer cmd, uint32_t queue, const std::string& name)
+{
+  if(!isInitialized())
+    return;
+  cmdWrite(cmd, queue, eStarted, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, getPassIndex(name));
+}
+
+void GpuBreadcrumbs::cmdEndPass(VkCommandBuffer cmd, uint32_t queue, const std::string& name)
+{
+  if(!isInitialized())
+    return;
+  cmdWrite(cmd, queue, eCompleted, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, getPassIndex(name));
+}
+
+std::vector<GpuBreadcrumbs::QueueState> GpuBreadcrumbs::getQueueStates() const
+{
+  std::vector<QueueState> states;
+  if(!isInitialized())
+    return states;
+
+  vmaInvalidateAllocation(*m_alloc, m_buffer.allocation, 0, VK_WHOLE_SIZE);
+  const volatile uint32_t* words = reinterpret_cast<const volatile uint32_t*>(m_buffer.mapping);
+
+  std::lock_guard lock(m_mutex);
+  auto            passName = [&](uint32_t index) -> std::string {
+    if(index == kNoPass)
+      return {};
+    return index < m_passNames.size() ? m_passNames[index] : "<unknown>";
+  };
+
+  states.resize(m_queueCount);
+  for(uint32_t queue = 0; queue < m_queueCount; queue++)
+  {
+    states[queue].frame         = words[queue * eSlotCount + eFrame];
+    states[queue].lastStarted   = passName(words[queue * eSlotCount + eStarted]);
+    states[queue].lastCompleted = passName(words[queue * eSlotCount + eCompleted]);
+  }
+  return states;
+}
+
+void GpuBreadcrumbs::logReport() const
+{
+  const std::vector<QueueState> states = getQueueStates();
+  for(size_t queue = 0; queue < states.size(); queue++)
+  {
+    const QueueState& state = states[queue];
+    if(!state.lastStarted.empty() && state.lastStarted != state.lastCompleted)
+    {
+      LOGE("GPU breadcrumbs, queue %zu: frame %u, in pass \"%s\" (last completed \"%s\")\n", queue, state.frame,
+           state.lastStarted.c_str(), state.lastCompleted.c_str());
+    }
+    else
+    {
+      LOGE("GPU breadcrumbs, queue %zu: frame %u, after pass \"%s\"\n", queue, state.frame, state.lastCompleted.c_str());
+    }
+  }
+}
+
+void GpuBreadcrumbs::errorCallback(VkResult result) const
+{
+  if(result == VK_ERROR_DEVICE_LOST)
+  {
+    logReport();
+  }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_GpuBreadcrumbs(nvvk::ResourceAllocator& alloc, VkCommandBuffer cmd, uint32_t frame)
+{
+  // After the device creation, with VK_AMD_buffer_marker added to the device extensions when supported
+  //---
+  // vkSetup.deviceExtensions.push_back({VK_AMD_BUFFER_MARKER_EXTENSION_NAME, nullptr, false});
+  auto& breadcrumbs = GpuBreadcrumbs::getInstance();
+  NVVK_CHECK(breadcrumbs.init(&alloc, 1, /*bufferMarkerEnabled=*/true));
+
+  // Reporting on device lost, before anything else
+  //---
+  nvvk::CheckError::getInstance().setCallbackFunction([&](VkResult result) {
+    breadcrumbs.errorCallback(result);
+    // AftermathCrashTracker::getInstance().errorCallback(result);
+  });
+
+  // Each frame
+  //---
+  breadcrumbs.cmdBeginFrame(cmd, 0, frame);
+  breadcrumbs.cmdBeginPass(cmd, 0, "Shadows");
+  // ... vkCmdBeginRendering, draws, vkCmdEndRendering
+  breadcrumbs.cmdEndPass(cmd, 0, "Shadows");
+  breadcrumbs.cmdBeginPass(cmd, 0, "Lighting");
+  // ...
+  breadcrumbs.cmdEndPass(cmd, 0, "Lighting");
+
+  // Before destroying the allocator
+  breadcrumbs.deinit();
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include <nvvk/resource_allocator.hpp>
+
+/*-----
+// GPU crash breadcrumbs: an always-on, low-overhead alternative to the full Aftermath crash dumps.
+//
+// Each queue has a few words in a host-visible buffer, which the command buffers write with
+// markers around the passes: the frame, the last pass started and the last pass completed.
+// After a VK_ERROR_DEVICE_LOST, the buffer tells on which queue, in which frame and in which pass
+// the GPU stopped, without Aftermath, debug info or a crash dump.
+//
+// - With VK_AMD_buffer_marker enabled on the device, the markers are written with
+//   vkCmdWriteBufferMarker2AMD at the exact pipeline stages, and can be recorded anywhere.
+// - Otherwise they are written with vkCmdFillBuffer, which can't be recorded within a render pass
+//   or dynamic rendering: mark the passes outside of them.
+// - The markers are a few bytes each, written by the copy engine or the marker hardware:
+//   they cost next to nothing and can stay enabled in production.
+//
+// Usage:
+// 1. Call GpuBreadcrumbs::getInstance().init(alloc, queueCount, ...) after the device creation
+// 2. Add the VK_AMD_buffer_marker extension to the device extensions, optional
+// 3. Record cmdBeginFrame, cmdBeginPass and cmdEndPass in the command buffers of each queue
+// 4. Add a callback to the CheckError to report the breadcrumbs on device lost
+//
+// Example:
+//   see usage_GpuBreadcrumbs in breadcrumbs.cpp
+------*/
+
+class GpuBreadcrumbs
+{
+public:
+  static GpuBreadcrumbs& getInstance();
+
+  // `queueCount` is the number of queue slots, the application chooses which slot a queue uses.
+  // `bufferMarkerEnabled` when the device was created with VK_AMD_buffer_marker.
+  VkResult init(nvvk::ResourceAllocator* alloc, uint32_t queueCount, bool bufferMarkerEnabled = false);
+  void     deinit();
+  bool     isInitialized() const { return m_buffer.buffer != VK_NULL_HANDLE; }
+
+  // Marks the start of a frame on a queue, before its first pass
+  void cmdBeginFrame(VkCommandBuffer cmd, uint32_t queue, uint32_t frame);
+  // Marks a pass started or completed on a queue. Names are registered once, the markers only write their index.
+  void cmdBeginPass(VkCommandBuffer cmd, uint32_t queue, const std::string& name);
+  void cmdEndPass(VkCommandBuffer cmd, uint32_t queue, const std::string& name);
+
+  struct QueueState
+  {
+    uint32_t    frame = 0;
+    std::string lastStarted;    // the pass the GPU was in, when it differs from the last completed one
+    std::string lastCompleted;  // the last pass that got entirely through the pipeline
+  };
+  // Reads back the markers, meaningful once the device is lost or idle
+  std::vector<QueueState> getQueueStates() const;
+  void                    logReport() const;
+
+  // Logs the breadcrumbs on VK_ERROR_DEVICE_LOST, to set as, or call from, the CheckError callback
+  void errorCallback(VkResult result) const;
+
+private:
+  // Words of each queue in the buffer
+  enum Slot : uint32_t
+  {
+    eFrame,
+    eStarted,
+    eCompleted,
+    eSlotCount,
+  };
+  static constexpr uint32_t kNoPass = ~0U;
+
+  GpuBreadcrumbs() = default;
+
+  uint32_t getPassIndex(const std::string& name);
+  void     cmdWrite(VkCommandBuffer cmd, uint32_t queue, Slot slot, VkPipelineStageFlags2 stage, uint32_t value);
+
+  const nvvk::ResourceAllocator* m_alloc{};
+  nvvk::Buffer                   m_buffer;
+  uint32_t                       m_queueCount = 0;
+  bool                           m_useBufferMarker = false;
+
+  mutable std::mutex                        m_mutex;  // command buffers may be recorded on several threads
+  std::unordered_map<std::string, uint32_t> m_passIndices;
+  std::vector<std::string>                  m_passNames;
+};
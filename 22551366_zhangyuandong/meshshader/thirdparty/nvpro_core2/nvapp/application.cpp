@@ -17,8 +17,11 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <filesystem>
+#include <fstream>
 
 #include <volk/volk.h>
 
@@ -33,20 +36,37 @@
 #define NVLOGGER_ENABLE_FMT
 #include <nvutils/logger.hpp>
 #include <nvutils/file_operations.hpp>
+#include <nvutils/parallel_work.hpp>
 #include <nvutils/timers.hpp>
 #include <nvvk/barriers.hpp>
 #include <nvvk/check_error.hpp>
 #include <nvvk/debug_util.hpp>
 #include <nvvk/commands.hpp>
+#include <nvvk/gbuffers.hpp>
 #include <nvvk/helpers.hpp>
+#include <nvvk/resource_allocator.hpp>
 
 #include <nvgui/fonts.hpp>
 #include <nvgui/style.hpp>
 
+#include <nvnsight/nsightevents.hpp>
+
 #include "application.hpp"
 
 // Default values
-constexpr int32_t k_imageQuality = 90;
+constexpr int32_t  k_imageQuality       = 90;
+constexpr uint64_t k_presentWaitTimeout = 100'000'000;  // 100 ms, so an occluded window does not block the loop
+constexpr uint32_t k_minFramesInFlight  = 2;            // CPU records one frame while the GPU executes the other
+constexpr uint32_t k_maxFramesInFlight  = 4;            // Size of the frame ring, the in-flight count can change up to it
+constexpr uint32_t k_autoFramesWindow   = 64;           // Frames averaged before the automatic mode picks a count
+constexpr uint32_t k_captureRingSize    = 8;            // Asynchronous saves in flight before the capture stalls
+constexpr double   k_uiSettleTime       = 1.0;          // Cached UI: seconds rebuilt every frame after an input (hover delays)
+constexpr double   k_uiRefreshInterval  = 0.25;         // Cached UI: seconds between rebuilds while idle, for the statistics
+
+// Colors (ARGB) of the frame stages in Nsight Systems, the ranges are compiled out without NVTX
+[[maybe_unused]] constexpr uint32_t k_nxColorAcquire = 0xFF808080;  // Waiting for the frame slot and the swapchain image
+[[maybe_unused]] constexpr uint32_t k_nxColorRecord  = 0xFF76B900;  // Element callbacks recording the frame
+[[maybe_unused]] constexpr uint32_t k_nxColorSubmit  = 0xFF2F7FD6;  // Queue submission and presentation
 
 // GLFW Callback for file drop
 static void dropCb(GLFWwindow* window, int count, const char** paths)
@@ -147,6 +167,22 @@ void nvapp::Application::init(ApplicationCreateInfo& info)
   m_headlessFrameCount = info.headlessFrameCount;
   m_viewportSize       = {};  // Will be set by the first viewport size
   m_maxTexturePool     = info.texturePoolSize;
+  m_lowLatency         = info.lowLatency && !info.headless;
+  m_autoFramesInFlight = info.autoFramesInFlight;
+  m_computeQueueIndex  = info.computeQueueIndex;
+  m_parallelRecording  = info.parallelRecording;
+  m_cachedUI           = info.cachedUI;
+  m_recordFrameTimings = info.headless && (info.headlessTimings || !info.headlessTimingsFile.empty());
+  m_frameTimingsFile   = info.headlessTimingsFile;
+  assert(m_computeQueueIndex < int32_t(m_queues.size()) && "computeQueueIndex is not in the queues");
+  m_profilerManager    = info.profilerManager;
+
+  // The swapchain images are presented by device 0
+  if(info.deviceCount > 1 && info.deviceGroupMode != nvvk::DeviceGroupMode::eSingle && !info.headless)
+  {
+    LOGW("Device group modes are for headless mode, the frames run on device 0\n");
+  }
+  m_deviceGroup.init(m_device, info.deviceCount, info.headless ? info.deviceGroupMode : nvvk::DeviceGroupMode::eSingle);
 
   if(info.hasUndockableViewport == true)
   {
@@ -185,7 +221,13 @@ void nvapp::Application::init(ApplicationCreateInfo& info)
         .cmdPool               = m_transientCmdPool,
         .preferredVsyncOffMode = info.preferredVsyncOffMode,
         .preferredVsyncOnMode  = info.preferredVsyncOnMode,
+        .presentWait           = m_lowLatency && info.presentWaitEnabled,
+        .lowLatency2           = m_lowLatency && info.lowLatency2Enabled,
+        .swapchainMaintenance1 = info.swapchainMaintenance1Enabled,
+        .presentMode           = info.presentMode,
+        .imageCount            = info.swapchainImageCount,
     };
+    m_presentModeWanted = info.presentMode;
 
     // We do some custom error-handling here to provide additional information
     // about the reason creating the swapchain failed.
@@ -199,19 +241,41 @@ void nvapp::Application::init(ApplicationCreateInfo& info)
     // Update the window size to the actual size of the surface
     NVVK_CHECK(m_swapchain.initResources(m_windowSize, m_vsyncWanted));
 
-    // Create what is needed to submit the scene for each frame in-flight
-    createFrameSubmission(m_swapchain.getMaxFramesInFlight());
+    // Let the driver delay the start of the frames, the swapchain keeps the mode across rebuilds
+    m_swapchain.setLatencySleepMode(true);
+
+    // By default, one frame in flight per swapchain image
+    m_framesInFlight = m_swapchain.getMaxFramesInFlight();
   }
   else
   {
     // In headless mode, there's only 2 pipeline stages (CPU and GPU, no display),
     // so we double instead of triple-buffer.
-    createFrameSubmission(2);
+    m_framesInFlight = 2;
   }
+  if(info.framesInFlight != 0)
+  {
+    m_framesInFlight = info.framesInFlight;
+  }
+  m_framesInFlight = std::clamp(std::max(m_framesInFlight, getMinFramesInFlight()), k_minFramesInFlight, k_maxFramesInFlight);
+
+  // The ring always holds the maximum, so the count in flight can change without reallocations
+  // in the application or in the elements sizing their resources with getFrameCycleSize()
+  createFrameSubmission(k_maxFramesInFlight);
 
   // Set up the resource free queue
   resetFreeQueue(getFrameCycleSize());
 
+  if(m_lowLatency)
+  {
+    LOGI("Low latency mode: present wait %s, NV low latency %s\n", m_swapchain.hasPresentWait() ? "on" : "off",
+         m_swapchain.hasLowLatency2() ? "on" : "off");
+    if(m_profilerManager)
+    {
+      m_latencyTimeline = m_profilerManager->createTimeline({"latency"});
+    }
+  }
+
   // Initialize Dear ImGui
   setupImGuiVulkanBackend(info.imguiConfigFlags);
 }
@@ -250,6 +314,14 @@ void nvapp::Application::deinit()
     glfwGetWindowPos(m_windowHandle, &m_winPos.x, &m_winPos.y);
   }
 
+  // The attach tasks and the callbacks may use resources of the elements
+  for(PendingAttachTask& task : m_attachTasks)
+  {
+    task.future.wait();
+  }
+  m_attachTasks.clear();
+  m_completionService.waitAll();
+
   // This will call the onDetach of the elements
   for(std::shared_ptr<IAppElement>& e : m_elements)
   {
@@ -266,8 +338,24 @@ void nvapp::Application::deinit()
   // Destroy the elements
   m_elements.clear();
 
+  if(m_latencyTimeline)
+  {
+    m_profilerManager->destroyTimeline(m_latencyTimeline);
+    m_latencyTimeline = nullptr;
+  }
+
   NVVK_CHECK(vkDeviceWaitIdle(m_device));
 
+  // Finish writing the pending saves
+  processCaptures(true);
+  for(Capture& capture : m_captures)
+  {
+    vkFreeMemory(m_device, capture.memory, nullptr);
+    vkDestroyImage(m_device, capture.image, nullptr);
+  }
+  m_captures.clear();
+  m_completionService.deinit();
+
   // Clean pending
   resetFreeQueue(0);
 
@@ -285,7 +373,21 @@ void nvapp::Application::deinit()
     vkFreeCommandBuffers(m_device, m_frameData[i].cmdPool, 1, &m_frameData[i].cmdBuffer);
     vkDestroyCommandPool(m_device, m_frameData[i].cmdPool, nullptr);
   }
+  for(size_t i = 0; i < m_frameData.size() && hasAsyncCompute(); i++)
+  {
+    vkFreeCommandBuffers(m_device, m_frameData[i].computeCmdPool, 1, &m_frameData[i].computeCmdBuffer);
+    vkDestroyCommandPool(m_device, m_frameData[i].computeCmdPool, nullptr);
+  }
+  for(FrameData& frame : m_frameData)
+  {
+    for(ThreadCommandPool& threadPool : frame.threadPools)
+    {
+      vkDestroyCommandPool(m_device, threadPool.cmdPool, nullptr);  // Frees its command buffers
+    }
+  }
   vkDestroySemaphore(m_device, m_frameTimelineSemaphore, nullptr);
+  vkDestroySemaphore(m_device, m_computeTimelineSemaphore, nullptr);
+  vkDestroyQueryPool(m_device, m_frameQueryPool, nullptr);
   ImGui::DestroyContext();
 
   if(ImPlot::GetCurrentContext() != nullptr)
@@ -310,6 +412,109 @@ void nvapp::Application::addElement(const std::shared_ptr<IAppElement>& layer)
 {
   m_elements.emplace_back(layer);
   layer->onAttach(this);
+
+  // Started right away, they overlap with the attach of the next elements
+  std::vector<AttachTask> tasks;
+  layer->onAttachTasks(tasks);
+  for(AttachTask& task : tasks)
+  {
+    m_attachTasks.push_back({task.name, layer, nvutils::get_thread_pool().submit_task(std::move(task.run))});
+  }
+}
+
+//-----------------------------------------------------------------------
+// The attach tasks of the elements run on the thread pool, the window shows their progress meanwhile.
+// Cold start then takes the time of the longest task instead of the sum. The elements get their other
+// callbacks only once this returned.
+//
+void nvapp::Application::finishAttachTasks()
+{
+  if(m_attachTasks.empty())
+  {
+    return;
+  }
+  nvutils::ScopedTimer st(__FUNCTION__);
+
+  auto isDone = [](const PendingAttachTask& task) {
+    return task.future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  };
+
+  // Loading screen, nothing of the elements is drawn
+  while(!m_headless && !glfwWindowShouldClose(m_windowHandle) && !std::all_of(m_attachTasks.begin(), m_attachTasks.end(), isDone))
+  {
+    glfwPollEvents();
+    if(glfwGetWindowAttrib(m_windowHandle, GLFW_ICONIFIED) == GLFW_TRUE)
+    {
+      ImGui_ImplGlfw_Sleep(10);
+      continue;
+    }
+
+    ImGui_ImplVulkan_NewFrame();
+    ImGui_ImplGlfw_NewFrame();
+    ImGui::NewFrame();
+    {
+      const ImGuiViewport* viewport = ImGui::GetMainViewport();
+      ImGui::SetNextWindowPos(viewport->GetCenter(), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+      ImGui::Begin("Loading", nullptr,
+                   ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings
+                       | ImGuiWindowFlags_NoDocking | ImGuiWindowFlags_NoMove);
+      const auto done = std::count_if(m_attachTasks.begin(), m_attachTasks.end(), isDone);
+      ImGui::ProgressBar(float(done) / float(m_attachTasks.size()), ImVec2(300.0f, 0.0f),
+                         fmt::format("{} / {}", done, m_attachTasks.size()).c_str());
+      for(const PendingAttachTask& task : m_attachTasks)
+      {
+        if(isDone(task))
+          ImGui::TextDisabled("%s", task.name.c_str());
+        else
+          ImGui::Text("%s...", task.name.c_str());
+      }
+      ImGui::End();
+    }
+    ImGui::Render();
+    m_viewportBlit = {};
+
+    if(prepareFrameResources())
+    {
+      freeResourcesQueue();
+      prepareFrameToSignal(getFrameCycleSize());
+
+      VkCommandBuffer cmd = beginCommandRecording();
+      m_waitSemaphores.clear();
+      m_signalSemaphores.clear();
+      m_commandBuffers.clear();
+      renderToSwapchain(cmd);
+      addSwapchainSemaphores();
+      endFrame(cmd, getFrameCycleSize());
+      presentFrame();
+      advanceFrame(getFrameCycleSize());
+    }
+    ImGui::EndFrame();
+  }
+
+  // Rethrows the exceptions of the tasks
+  std::vector<std::shared_ptr<IAppElement>> elements;
+  for(PendingAttachTask& task : m_attachTasks)
+  {
+    task.future.get();
+    if(std::find(elements.begin(), elements.end(), task.element) == elements.end())
+    {
+      elements.push_back(task.element);
+    }
+  }
+  m_attachTasks.clear();
+
+  for(std::shared_ptr<IAppElement>& e : elements)
+  {
+    e->onAttachTasksDone();
+  }
+
+  // Files dropped on the loading screen
+  std::vector<std::filesystem::path> droppedFiles = std::move(m_pendingFileDrops);
+  m_pendingFileDrops.clear();
+  for(const std::filesystem::path& filename : droppedFiles)
+  {
+    onFileDrop(filename);
+  }
 }
 
 void nvapp::Application::setVsync(bool v)
@@ -318,6 +523,15 @@ void nvapp::Application::setVsync(bool v)
   m_swapchain.requestRebuild();
 }
 
+void nvapp::Application::setPresentMode(VkPresentModeKHR mode)
+{
+  m_presentModeWanted = mode;
+  if(!m_headless)
+  {
+    m_swapchain.setPresentMode(mode);
+  }
+}
+
 VkCommandBuffer nvapp::Application::createTempCmdBuffer() const
 {
   VkCommandBuffer cmd{};
@@ -332,6 +546,13 @@ void nvapp::Application::submitAndWaitTempCmdBuffer(VkCommandBuffer cmd)
 
 void nvapp::Application::onFileDrop(const std::filesystem::path& filename)
 {
+  // The elements may still be loading, they get the file once their attach tasks finished
+  if(!m_attachTasks.empty())
+  {
+    m_pendingFileDrops.push_back(filename);
+    return;
+  }
+
   for(std::shared_ptr<IAppElement>& e : m_elements)
   {
     e->onFileDrop(filename);
@@ -371,13 +592,26 @@ void nvapp::Application::run()
   // Main rendering loop
   while(!glfwWindowShouldClose(m_windowHandle))
   {
+    // Elements added since the last frame finish their attach first
+    finishAttachTasks();
+
     // Window System Events.
     // We add a delay before polling to reduce latency.
-    if(m_vsyncWanted)
+    if(m_lowLatency)
+    {
+      beginLowLatencyFrame();
+    }
+    else if(m_vsyncWanted)
     {
       m_framePacer.pace();
     }
     glfwPollEvents();
+    if(m_lowLatency)
+    {
+      m_swapchain.setLatencyMarker(VK_LATENCY_MARKER_INPUT_SAMPLE_NV);
+      m_inputSampleTime      = m_profilerManager ? m_profilerManager->getMicroseconds() : 0.0;
+      m_inputSamplePresentId = m_swapchain.getPresentId() + 1;
+    }
 
     // Skip rendering when minimized
     if(glfwGetWindowAttrib(m_windowHandle, GLFW_ICONIFIED) == GLFW_TRUE)
@@ -386,68 +620,81 @@ void nvapp::Application::run()
       continue;
     }
 
-    // Begin New Frame for ImGui
-    ImGui_ImplVulkan_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
-
-    // Setup ImGui Docking and UI
-    setupImguiDock();
-    if(m_useMenubar && ImGui::BeginMainMenuBar())
+    // With the cached UI, the draw data of the last UI frame is rendered again when nothing changed
+    m_uiFrame = needsUIFrame();
+    if(m_uiFrame)
     {
-      for(std::shared_ptr<IAppElement>& e : m_elements)
+      // Begin New Frame for ImGui
+      ImGui_ImplVulkan_NewFrame();
+      ImGui_ImplGlfw_NewFrame();
+      ImGui::NewFrame();
+
+      // Setup ImGui Docking and UI
+      setupImguiDock();
+      if(m_useMenubar && ImGui::BeginMainMenuBar())
       {
-        e->onUIMenu();
+        for(std::shared_ptr<IAppElement>& e : m_elements)
+        {
+          e->onUIMenu();
+        }
+        ImGui::EndMainMenuBar();
       }
-      ImGui::EndMainMenuBar();
-    }
 
-    // Handle Viewport Updates
-    VkExtent2D         viewportSize = m_windowSize;
-    const ImGuiWindow* viewport     = ImGui::FindWindowByName("Viewport");
-    if(viewport)
-    {
-      viewportSize = {uint32_t(viewport->Size.x), uint32_t(viewport->Size.y)};
-      ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
-      ImGui::Begin("Viewport");
-      ImGui::End();
-      ImGui::PopStyleVar();
-    }
-
-    // Update viewport if size changed
-    if(m_viewportSize.width != viewportSize.width || m_viewportSize.height != viewportSize.height)
-    {
-      onViewportSizeChange(viewportSize);
-    }
+      // Handle Viewport Updates
+      // The window has no background once displayViewportImage() blits into it, the first Begin() sets the flags
+      const ImGuiWindowFlags viewportFlags = m_viewportBlitWanted ? ImGuiWindowFlags_NoBackground : ImGuiWindowFlags_None;
+      m_viewportBlit                       = {};
+      m_viewportBlitWanted                 = false;
+      VkExtent2D         viewportSize      = m_windowSize;
+      const ImGuiWindow* viewport          = ImGui::FindWindowByName("Viewport");
+      if(viewport)
+      {
+        viewportSize = {uint32_t(viewport->Size.x), uint32_t(viewport->Size.y)};
+        ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
+        ImGui::Begin("Viewport", nullptr, viewportFlags);
+        ImGui::End();
+        ImGui::PopStyleVar();
+      }
 
-    // Handle Screenshot Requests
-    if(m_screenShotRequested && (m_frameRingCurrent == m_screenShotFrame))
-    {
-      saveScreenShot(m_screenShotFilename, k_imageQuality);
-      m_screenShotRequested = false;
+      // Update viewport if size changed
+      if(m_viewportSize.width != viewportSize.width || m_viewportSize.height != viewportSize.height)
+      {
+        onViewportSizeChange(viewportSize);
+      }
     }
 
     // Frame Resource Preparation
+    m_swapchain.setLatencyMarker(VK_LATENCY_MARKER_SIMULATION_END_NV);
     if(prepareFrameResources())
     {
       // Free resources from previous frame
       freeResourcesQueue();
 
       // Prepare Frame Synchronization
-      prepareFrameToSignal(m_swapchain.getMaxFramesInFlight());
+      prepareFrameToSignal(getFrameCycleSize());
 
       // Record Commands
+      m_swapchain.setLatencyMarker(VK_LATENCY_MARKER_RENDERSUBMIT_START_NV);
       VkCommandBuffer cmd = beginCommandRecording();
       drawFrame(cmd);            // Call onUIRender() and onRender() for each element
       renderToSwapchain(cmd);    // Render ImGui to swapchain
+      recordScreenShot(cmd);     // Copy the swapchain image when a screenshot or a capture is pending
       addSwapchainSemaphores();  // Setup synchronization
-      endFrame(cmd, m_swapchain.getMaxFramesInFlight());
+      endFrame(cmd, getFrameCycleSize());
+      m_swapchain.setLatencyMarker(VK_LATENCY_MARKER_RENDERSUBMIT_END_NV);
 
       // Present Frame
+      m_swapchain.setLatencyMarker(VK_LATENCY_MARKER_PRESENT_START_NV);
       presentFrame();  // This can also trigger swapchain rebuild
+      m_swapchain.setLatencyMarker(VK_LATENCY_MARKER_PRESENT_END_NV);
 
       // Advance Frame
-      advanceFrame(m_swapchain.getMaxFramesInFlight());
+      advanceFrame(getFrameCycleSize());
+    }
+
+    if(!m_uiFrame)
+    {
+      continue;
     }
 
     // End ImGui frame
@@ -462,6 +709,33 @@ void nvapp::Application::run()
   }
 }
 
+//-----------------------------------------------------------------------
+// Cached UI: the UI is rebuilt while it reacts to the input, after a requestUIRedraw(),
+// and at a low rate when idle. Otherwise the draw data of the last UI frame stays valid,
+// since ImGui only rewrites it in NewFrame() and Render(). The images it displays, like
+// the GBuffer of the viewport, are sampled again so they still show the latest content.
+//
+bool nvapp::Application::needsUIFrame()
+{
+  if(!m_cachedUI || ImGui::GetDrawData() == nullptr)
+  {
+    return true;
+  }
+
+  const double now = glfwGetTime();
+  if(!ImGui::GetCurrentContext()->InputEventsQueue.empty() || m_uiRedrawRequested || m_swapchain.needRebuilding())
+  {
+    m_uiSettleEndTime   = now + k_uiSettleTime;
+    m_uiRedrawRequested = false;
+  }
+  if(now < m_uiSettleEndTime || now - m_uiLastFrameTime >= k_uiRefreshInterval)
+  {
+    m_uiLastFrameTime = now;
+    return true;
+  }
+  return false;
+}
+
 //-----------------------------------------------------------------------
 // IMGUI Docking
 // Create a dockspace and dock the viewport and settings window.
@@ -525,6 +799,7 @@ void nvapp::Application::onViewportSizeChange(VkExtent2D size)
 //
 void nvapp::Application::drawFrame(VkCommandBuffer cmd)
 {
+  NXPROFILEFUNCCOL(__FUNCTION__, k_nxColorRecord);
   // Reset the extra semaphores and command buffers
   m_waitSemaphores.clear();
   m_signalSemaphores.clear();
@@ -532,13 +807,16 @@ void nvapp::Application::drawFrame(VkCommandBuffer cmd)
 
 
   // Call UI rendering for each element
-  for(std::shared_ptr<IAppElement>& e : m_elements)
+  if(m_uiFrame)
   {
-    e->onUIRender();
-  }
+    for(std::shared_ptr<IAppElement>& e : m_elements)
+    {
+      e->onUIRender();
+    }
 
-  // This is creating the data to draw the UI (not on GPU yet)
-  ImGui::Render();
+    // This is creating the data to draw the UI (not on GPU yet)
+    ImGui::Render();
+  }
 
   // Call onPreRender for each element with the command buffer of the frame
   for(std::shared_ptr<IAppElement>& e : m_elements)
@@ -546,18 +824,159 @@ void nvapp::Application::drawFrame(VkCommandBuffer cmd)
     e->onPreRender();
   }
 
+  // The compute work goes first, so it can start while the previous frame finishes on the graphics queue
+  if(hasAsyncCompute())
+  {
+    submitFrameCompute();
+  }
+
   // Call onRender for each element with the command buffer of the frame
+  if(m_parallelRecording)
+  {
+    recordElementsInParallel(cmd);
+  }
+  else
+  {
+    for(std::shared_ptr<IAppElement>& e : m_elements)
+    {
+      e->onRender(cmd);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------
+// The elements that can record in parallel do it first, on the thread pool, each into a secondary
+// command buffer of the worker's pool. Then the primary command buffer gets, in the order of the
+// elements, either their secondary command buffer or the onRender() of the serial ones.
+//
+void nvapp::Application::recordElementsInParallel(VkCommandBuffer cmd)
+{
+  FrameData& frame = m_frameData[m_frameRingCurrent];
+  for(ThreadCommandPool& threadPool : frame.threadPools)
+  {
+    NVVK_CHECK(vkResetCommandPool(m_device, threadPool.cmdPool, 0));
+    threadPool.usedCount = 0;
+  }
+
+  m_parallelElements.clear();
+  m_elementCmdBuffers.resize(m_elements.size());
+  for(uint32_t i = 0; i < uint32_t(m_elements.size()); i++)
+  {
+    if(m_elements[i]->canRecordInParallel())
+    {
+      m_parallelElements.push_back(i);
+    }
+  }
+
+  nvutils::parallel_batches_pooled<1>(m_parallelElements.size(), [&](uint64_t item, uint32_t threadIndex) {
+    NXPROFILEFUNCCOL("recordElement", k_nxColorRecord);
+    ThreadCommandPool& threadPool = frame.threadPools[threadIndex];
+    if(threadPool.usedCount == threadPool.cmdBuffers.size())
+    {
+      const VkCommandBufferAllocateInfo allocateInfo{
+          .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+          .commandPool        = threadPool.cmdPool,
+          .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+          .commandBufferCount = 1,
+      };
+      VkCommandBuffer secondary{};
+      NVVK_CHECK(vkAllocateCommandBuffers(m_device, &allocateInfo, &secondary));
+      NVVK_DBG_NAME(secondary);
+      threadPool.cmdBuffers.push_back(secondary);
+    }
+    VkCommandBuffer secondary = threadPool.cmdBuffers[threadPool.usedCount++];
+
+    // Not continuing a render pass: the elements begin their own dynamic rendering
+    const VkCommandBufferInheritanceInfo inheritanceInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+
+    const VkCommandBufferBeginInfo beginInfo{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = &inheritanceInfo,
+    };
+    NVVK_CHECK(vkBeginCommandBuffer(secondary, &beginInfo));
+    const uint32_t elementIndex = m_parallelElements[item];
+    m_elements[elementIndex]->onRender(secondary);
+    NVVK_CHECK(vkEndCommandBuffer(secondary));
+    m_elementCmdBuffers[elementIndex] = secondary;
+  });
+
+  for(uint32_t i = 0; i < uint32_t(m_elements.size()); i++)
+  {
+    if(m_elements[i]->canRecordInParallel())
+    {
+      vkCmdExecuteCommands(cmd, 1, &m_elementCmdBuffers[i]);
+    }
+    else
+    {
+      m_elements[i]->onRender(cmd);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------
+// Records onRenderCompute() of all elements and submits it on the compute queue.
+// The graphics submit of the frame waits for it, through the frame's wait semaphores.
+//
+void nvapp::Application::submitFrameCompute()
+{
+  NXPROFILEFUNCCOL(__FUNCTION__, k_nxColorSubmit);
+  FrameData& frame = m_frameData[m_frameRingCurrent];
+
+  NVVK_CHECK(vkResetCommandPool(m_device, frame.computeCmdPool, 0));
+  const VkDeviceGroupCommandBufferBeginInfo deviceGroupInfo{
+      .sType      = VK_STRUCTURE_TYPE_DEVICE_GROUP_COMMAND_BUFFER_BEGIN_INFO,
+      .deviceMask = getFrameDeviceMask(),
+  };
+  const VkCommandBufferBeginInfo beginInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                           .pNext = m_deviceGroup.getDeviceCount() > 1 ? &deviceGroupInfo : nullptr,
+                                           .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+  NVVK_CHECK(vkBeginCommandBuffer(frame.computeCmdBuffer, &beginInfo));
   for(std::shared_ptr<IAppElement>& e : m_elements)
   {
-    e->onRender(cmd);
+    e->onRenderCompute(frame.computeCmdBuffer);
   }
+  NVVK_CHECK(vkEndCommandBuffer(frame.computeCmdBuffer));
+
+  const VkCommandBufferSubmitInfo cmdInfo{.sType         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+                                          .commandBuffer = frame.computeCmdBuffer,
+                                          .deviceMask    = getFrameDeviceMask()};
+  const VkSemaphoreSubmitInfo signalInfo{
+      .sType       = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .semaphore   = m_computeTimelineSemaphore,
+      .value       = frame.frameNumber,
+      .stageMask   = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+      .deviceIndex = getFrameDeviceIndex(),
+  };
+  const VkSubmitInfo2 submitInfo{
+      .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+      .commandBufferInfoCount   = 1,
+      .pCommandBufferInfos      = &cmdInfo,
+      .signalSemaphoreInfoCount = 1,
+      .pSignalSemaphoreInfos    = &signalInfo,
+  };
+  NVVK_CHECK(vkQueueSubmit2(getComputeQueue().queue, 1, &submitInfo, nullptr));
+
+  // The results can be consumed by any graphics stage, including the indirect draws
+  addWaitSemaphore({
+      .sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .semaphore = m_computeTimelineSemaphore,
+      .value     = frame.frameNumber,
+      .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+  });
 }
 
 void nvapp::Application::renderToSwapchain(VkCommandBuffer cmd)
 {
+  // The viewport image is copied first, the UI is drawn over it
+  const bool blitViewport = m_viewportBlit.image != VK_NULL_HANDLE;
+  if(blitViewport)
+  {
+    blitViewportToSwapchain(cmd);
+  }
 
   // Start rendering to the swapchain
-  beginDynamicRenderingToSwapchain(cmd);
+  beginDynamicRenderingToSwapchain(cmd, blitViewport);
   {
     nvvk::DebugUtil::ScopedCmdLabel scopedCmdLabel(cmd, "ImGui");
     // The ImGui draw commands are recorded to the command buffer, which includes the display of our GBuffer image
@@ -566,6 +985,100 @@ void nvapp::Application::renderToSwapchain(VkCommandBuffer cmd)
   endDynamicRenderingToSwapchain(cmd);
 }
 
+//-----------------------------------------------------------------------
+// Direct viewport: the GBuffer image is blitted in the swapchain where ImGui::Image() would have drawn it.
+// Only done when nothing of the UI is drawn beneath it: the window is docked in the central node of the
+// dockspace over the main viewport, whose host leaves that node without background, and the window itself
+// was begun without background. The windows over it are drawn on top as before.
+//
+void nvapp::Application::displayViewportImage(const nvvk::GBuffer& gbuffer, uint32_t colorIndex)
+{
+  const ImVec2         size         = ImGui::GetContentRegionAvail();
+  const ImVec2         pos          = ImGui::GetCursorScreenPos();
+  const ImGuiWindow*   window       = ImGui::GetCurrentWindow();
+  const ImGuiViewport* mainViewport = ImGui::GetMainViewport();
+  const glm::vec2      uvScale      = gbuffer.getUVScale();
+
+  // Rectangle in the swapchain, in pixels
+  const ImVec2 scale = ImGui::GetIO().DisplayFramebufferScale;
+  const ImVec2 dstMin{(pos.x - mainViewport->Pos.x) * scale.x, (pos.y - mainViewport->Pos.y) * scale.y};
+  const ImVec2 dstMax{dstMin.x + size.x * scale.x, dstMin.y + size.y * scale.y};
+
+  bool canBlit = !m_headless && window->DockIsActive && window->DockNode->IsCentralNode() && window->Viewport == mainViewport
+                 && gbuffer.getSampleCount() == VK_SAMPLE_COUNT_1_BIT && dstMin.x >= 0.0f && dstMin.y >= 0.0f
+                 && dstMax.x <= float(m_windowSize.width) && dstMax.y <= float(m_windowSize.height) && size.x >= 1.0f
+                 && size.y >= 1.0f;
+  const VkExtent2D srcSize = gbuffer.getSize();
+  const VkExtent2D dstSize = {uint32_t(dstMax.x) - uint32_t(dstMin.x), uint32_t(dstMax.y) - uint32_t(dstMin.y)};
+  if(canBlit)
+  {
+    VkFormatProperties srcProperties{}, dstProperties{};
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, gbuffer.getColorFormat(colorIndex), &srcProperties);
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, m_swapchain.getImageFormat(), &dstProperties);
+    const bool scaled = srcSize.width != dstSize.width || srcSize.height != dstSize.height;
+    canBlit = (srcProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) != 0
+              && (dstProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT) != 0
+              && (!scaled || (srcProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0);
+  }
+  m_viewportBlitWanted |= canBlit;
+
+  if(canBlit && (window->Flags & ImGuiWindowFlags_NoBackground) != 0)
+  {
+    m_viewportBlit = {
+        .image     = gbuffer.getColorImage(colorIndex),
+        .srcSize   = srcSize,
+        .dstOffset = {int32_t(dstMin.x), int32_t(dstMin.y)},
+        .dstSize   = dstSize,
+    };
+    ImGui::Dummy(size);  // Same layout and hovering as the image
+  }
+  else
+  {
+    ImGui::Image(ImTextureID(gbuffer.getDescriptorSet(colorIndex)), size, ImVec2(0.0f, 0.0f), ImVec2(uvScale.x, uvScale.y));
+  }
+}
+
+//-----------------------------------------------------------------------
+// Clears the swapchain image, as the rendering to it would, and blits the viewport image into its rectangle.
+//
+void nvapp::Application::blitViewportToSwapchain(VkCommandBuffer cmd)
+{
+  nvvk::DebugUtil::ScopedCmdLabel scopedCmdLabel(cmd, "Viewport blit");
+  const VkImage swapchainImage = m_swapchain.getImage();
+
+  // The elements wrote the image in their onRender(), it stays in GENERAL layout
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_BLIT_BIT,
+                         VK_ACCESS_2_MEMORY_WRITE_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+  nvvk::cmdImageMemoryBarrier(cmd, {swapchainImage, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL});
+
+  const VkClearColorValue       clearColor = {{0.0f, 0.0f, 0.0f, 1.0f}};
+  const VkImageSubresourceRange range{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .levelCount = 1, .layerCount = 1};
+  vkCmdClearColorImage(cmd, swapchainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &range);
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_CLEAR_BIT, VK_PIPELINE_STAGE_2_BLIT_BIT);
+
+  const ViewportBlit& blit = m_viewportBlit;
+  const VkImageBlit2  region{
+       .sType          = VK_STRUCTURE_TYPE_IMAGE_BLIT_2,
+       .srcSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .layerCount = 1},
+       .srcOffsets     = {{0, 0, 0}, {int32_t(blit.srcSize.width), int32_t(blit.srcSize.height), 1}},
+       .dstSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .layerCount = 1},
+       .dstOffsets     = {{blit.dstOffset.x, blit.dstOffset.y, 0},
+                          {blit.dstOffset.x + int32_t(blit.dstSize.width), blit.dstOffset.y + int32_t(blit.dstSize.height), 1}},
+  };
+  const bool             scaled = blit.srcSize.width != blit.dstSize.width || blit.srcSize.height != blit.dstSize.height;
+  const VkBlitImageInfo2 blitInfo{
+      .sType          = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2,
+      .srcImage       = blit.image,
+      .srcImageLayout = VK_IMAGE_LAYOUT_GENERAL,
+      .dstImage       = swapchainImage,
+      .dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      .regionCount    = 1,
+      .pRegions       = &region,
+      .filter         = scaled ? VK_FILTER_LINEAR : VK_FILTER_NEAREST,
+  };
+  vkCmdBlitImage2(cmd, &blitInfo);
+}
+
 //-----------------------------------------------------------------------
 // prepareFrameResources is the first step in the rendering process.
 // It looks if the swapchain require rebuild, which happens when the window is resized.
@@ -573,12 +1086,16 @@ void nvapp::Application::renderToSwapchain(VkCommandBuffer cmd)
 ///
 bool nvapp::Application::prepareFrameResources()
 {
+  NXPROFILEFUNCCOL(__FUNCTION__, k_nxColorAcquire);
   if(m_swapchain.needRebuilding())
   {
     NVVK_CHECK(m_swapchain.reinitResources(m_windowSize, m_vsyncWanted));
   }
 
   waitForFrameCompletion();  // Wait until GPU has finished processing
+  processFrameTimestamps(m_frameRingCurrent);
+  m_completionService.poll();  // Run the callbacks of the completed GPU work
+  processCaptures(false);
 
   VkResult result = m_swapchain.acquireNextImage(m_device);
   return (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR);  // Continue only if we got a valid image
@@ -597,11 +1114,25 @@ VkCommandBuffer nvapp::Application::beginCommandRecording()
   NVVK_CHECK(vkResetCommandPool(m_device, frame.cmdPool, 0));
   VkCommandBuffer cmd = frame.cmdBuffer;
 
-  // Begin the command buffer recording for the frame
+  // Begin the command buffer recording for the frame, on the devices of the frame with a device group
+  const VkDeviceGroupCommandBufferBeginInfo deviceGroupInfo{
+      .sType      = VK_STRUCTURE_TYPE_DEVICE_GROUP_COMMAND_BUFFER_BEGIN_INFO,
+      .deviceMask = getFrameDeviceMask(),
+  };
   const VkCommandBufferBeginInfo beginInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                           .pNext = m_deviceGroup.getDeviceCount() > 1 ? &deviceGroupInfo : nullptr,
                                            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
   NVVK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
 
+  // The automatic frames in flight compares the recording time with the GPU execution of the frame
+  m_recordTimer.reset();
+  frame.hasTimestamps = (m_autoFramesInFlight || m_recordFrameTimings || m_vsyncWanted) && m_frameQueryPool;
+  if(frame.hasTimestamps)
+  {
+    vkCmdResetQueryPool(cmd, m_frameQueryPool, m_frameRingCurrent * 2, 2);
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, m_frameQueryPool, m_frameRingCurrent * 2);
+  }
+
   return cmd;
 }
 
@@ -632,13 +1163,18 @@ void nvapp::Application::addSwapchainSemaphores()
 //
 void nvapp::Application::endFrame(VkCommandBuffer cmd, uint32_t frameInFlights)
 {
+  NXPROFILEFUNCCOL(__FUNCTION__, k_nxColorSubmit);
+  // Get the frame data for the current frame in the ring buffer
+  FrameData& frame = m_frameData[m_frameRingCurrent];
+
   // Ends recording of commands for the frame
+  if(frame.hasTimestamps)
+  {
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, m_frameQueryPool, m_frameRingCurrent * 2 + 1);
+  }
   NVVK_CHECK(vkEndCommandBuffer(cmd));
 
 
-  // Get the frame data for the current frame in the ring buffer
-  FrameData& frame = m_frameData[m_frameRingCurrent];
-
   // Add timeline semaphore to signal when GPU completes this frame
   // The color attachment output stage is used since that's when the frame is fully rendered
   m_signalSemaphores.push_back({
@@ -650,11 +1186,31 @@ void nvapp::Application::endFrame(VkCommandBuffer cmd, uint32_t frameInFlights)
 
   // Adding the command buffer of the frame to the list of command buffers to submit
   // Note: extra command buffers could have been added to the list from other parts of the application (elements)
-  m_commandBuffers.push_back({.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, .commandBuffer = cmd});
+  m_commandBuffers.push_back({.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, .commandBuffer = cmd, .deviceMask = getFrameDeviceMask()});
+
+  // With a device group, the first device of the frame waits for and signals the semaphores
+  if(m_deviceGroup.getDeviceCount() > 1)
+  {
+    for(VkSemaphoreSubmitInfo& semaphore : m_waitSemaphores)
+    {
+      semaphore.deviceIndex = getFrameDeviceIndex();
+    }
+    for(VkSemaphoreSubmitInfo& semaphore : m_signalSemaphores)
+    {
+      semaphore.deviceIndex = getFrameDeviceIndex();
+    }
+  }
+
+  // Tells the driver which present the work belongs to, for the latency reports
+  const VkLatencySubmissionPresentIdNV latencySubmission{
+      .sType     = VK_STRUCTURE_TYPE_LATENCY_SUBMISSION_PRESENT_ID_NV,
+      .presentID = m_swapchain.getPresentId() + 1,
+  };
 
   // Populate the submit info to synchronize rendering and send the command buffer
   const VkSubmitInfo2 submitInfo{
       .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+      .pNext                    = m_swapchain.hasLowLatency2() ? &latencySubmission : nullptr,
       .waitSemaphoreInfoCount   = uint32_t(m_waitSemaphores.size()),    //
       .pWaitSemaphoreInfos      = m_waitSemaphores.data(),              // Wait for the image to be available
       .commandBufferInfoCount   = uint32_t(m_commandBuffers.size()),    //
@@ -665,6 +1221,7 @@ void nvapp::Application::endFrame(VkCommandBuffer cmd, uint32_t frameInFlights)
 
   // Submit the command buffer to the GPU and signal when it's done
   NVVK_CHECK(vkQueueSubmit2(m_queues[0].queue, 1, &submitInfo, nullptr));
+  frame.cpuRecordTime = m_recordTimer.getMicroseconds();
 }
 
 //-----------------------------------------------------------------------
@@ -673,6 +1230,7 @@ void nvapp::Application::endFrame(VkCommandBuffer cmd, uint32_t frameInFlights)
 //
 void nvapp::Application::presentFrame()
 {
+  NXPROFILEFUNCCOL(__FUNCTION__, k_nxColorSubmit);
   // Present the image
   m_swapchain.presentFrame(m_queues[0].queue);
 }
@@ -685,32 +1243,193 @@ void nvapp::Application::advanceFrame(uint32_t frameInFlights)
   m_frameRingCurrent = (m_frameRingCurrent + 1) % frameInFlights;
 }
 
+//-----------------------------------------------------------------------
+// Replaces the frame pacer in low latency mode.
+// Waits until the last present is on screen, then lets the driver sleep until the frame should start,
+// so the input sampled right after is as recent as possible. Without the extensions, this falls back to
+// the frame pacer.
+//
+void nvapp::Application::beginLowLatencyFrame()
+{
+  NXPROFILEFUNCCOL(__FUNCTION__, k_nxColorAcquire);
+  if(m_latencyTimeline)
+  {
+    m_latencyTimeline->frameAdvance();
+  }
+
+  // Adds a section covering [beginTime, now] of the profiler clock
+  auto addLatencySection = [&](const char* name, double beginTime) {
+    nvutils::ProfilerTimeline::FrameSectionID sec = m_latencyTimeline->frameBeginSection(name);
+    m_latencyTimeline->frameResetCpuBegin(sec, beginTime);
+    m_latencyTimeline->frameEndSection(sec);
+  };
+
+  const uint64_t presentId = m_swapchain.getPresentId();
+  if(m_swapchain.hasPresentWait())
+  {
+    const double   waitBegin = m_profilerManager ? m_profilerManager->getMicroseconds() : 0.0;
+    const VkResult result    = m_swapchain.waitForPresent(presentId, k_presentWaitTimeout);
+    if(result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+      m_swapchain.requestRebuild();
+    }
+
+    if(m_latencyTimeline)
+    {
+      addLatencySection("Present Wait", waitBegin);
+      if(result == VK_SUCCESS && presentId != 0 && presentId == m_inputSamplePresentId)
+      {
+        addLatencySection("Input to Present", m_inputSampleTime);
+      }
+    }
+  }
+
+  if(m_swapchain.hasLowLatency2())
+  {
+    // The driver timings are in their own clock, only their duration is reported
+    VkLatencyTimingsFrameReportNV report{};
+    if(m_latencyTimeline && m_swapchain.getLatencyTimings(report) && report.presentID != m_latencyReportPresentId
+       && report.gpuRenderEndTimeUs > report.simStartTimeUs)
+    {
+      m_latencyReportPresentId = report.presentID;
+      const double now         = m_profilerManager->getMicroseconds();
+      addLatencySection("Simulation to GPU End (Driver)", now - double(report.gpuRenderEndTimeUs - report.simStartTimeUs));
+    }
+
+    m_swapchain.latencySleep();
+  }
+  else if(m_vsyncWanted && !m_swapchain.hasPresentWait())
+  {
+    m_framePacer.pace();
+  }
+
+  m_swapchain.setLatencyMarker(VK_LATENCY_MARKER_SIMULATION_START_NV);
+}
+
 //-----------------------------------------------------------------------
 //
 void nvapp::Application::waitForFrameCompletion() const
 {
-  // Wait until GPU has finished processing the frame that was using these resources previously (numFramesInFlight frames ago)
-  const VkSemaphoreWaitInfo waitInfo = {
+  // Wait until GPU has finished processing the frame m_framesInFlight frames ago.
+  // The slot's value is what its previous use signals (frame - ring size), which is also
+  // the frame that used these resources. With fewer frames in flight, wait for a later one.
+  const uint64_t            waitValue = m_frameData[m_frameRingCurrent].frameNumber + getFrameCycleSize() - m_framesInFlight;
+  const VkSemaphoreWaitInfo waitInfo  = {
       .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
       .semaphoreCount = 1,
       .pSemaphores    = &m_frameTimelineSemaphore,
-      .pValues        = &m_frameData[m_frameRingCurrent].frameNumber,
+      .pValues        = &waitValue,
   };
   vkWaitSemaphores(m_device, &waitInfo, std::numeric_limits<uint64_t>::max());
 }
 
+//-----------------------------------------------------------------------
+// Alternate frames overlap as many frames as there are devices in the group, one per device.
+//
+uint32_t nvapp::Application::getMinFramesInFlight() const
+{
+  if(m_deviceGroup.getMode() == nvvk::DeviceGroupMode::eAlternateFrame)
+  {
+    return std::min(m_deviceGroup.getDeviceCount(), k_maxFramesInFlight);
+  }
+  return k_minFramesInFlight;
+}
+
+//-----------------------------------------------------------------------
+// Sets the count of frames the CPU can record ahead of the GPU.
+// The ring of frame resources is not touched, only how far back waitForFrameCompletion() waits.
+//
+void nvapp::Application::setFramesInFlight(uint32_t count)
+{
+  m_framesInFlight     = std::clamp(count, k_minFramesInFlight, k_maxFramesInFlight);
+  m_autoFramesInFlight = false;
+}
+
+void nvapp::Application::setAutoFramesInFlight(bool enable)
+{
+  m_autoFramesInFlight = enable;
+  m_frameTimings       = {};
+}
+
+//-----------------------------------------------------------------------
+// Reads the timestamps of the previous frame of a ring slot, once it has completed
+//
+void nvapp::Application::processFrameTimestamps(uint32_t slot)
+{
+  FrameData& frame = m_frameData[slot];
+  if(!frame.hasTimestamps)
+  {
+    return;
+  }
+  frame.hasTimestamps = false;
+
+  uint64_t timestamps[2]{};
+  if(vkGetQueryPoolResults(m_device, m_frameQueryPool, slot * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+                           VK_QUERY_RESULT_64_BIT)
+     != VK_SUCCESS)
+  {
+    return;
+  }
+
+  const double gpuTime = double(timestamps[1] - timestamps[0]) * m_timestampPeriod * 1e-3;  // in microseconds
+  if(m_recordFrameTimings)
+  {
+    m_frameTimingRecords.push_back({frame.frameIndex, frame.cpuFrameTime, frame.cpuRecordTime, gpuTime});
+  }
+  if(m_autoFramesInFlight)
+  {
+    updateFramesInFlight(frame.cpuRecordTime, gpuTime);
+  }
+  m_framePacer.addFrameTimes(frame.cpuRecordTime * 1e-6, gpuTime * 1e-6);
+}
+
+//-----------------------------------------------------------------------
+// Automatic frames in flight, called once the current slot's previous frame has completed.
+// The GPU stays busy when the CPU records the next frame before the GPU finishes the current one:
+// - the recording is always shorter than the GPU execution: 2 frames are enough
+// - the recording is shorter on average but has spikes: extra frames absorb the spikes
+// - the recording is longer on average: the GPU waits anyway, more frames only add latency
+//
+void nvapp::Application::updateFramesInFlight(double cpuRecordTime, double gpuTime)
+{
+  m_frameTimings.cpuSum += cpuRecordTime;
+  m_frameTimings.cpuMax = std::max(m_frameTimings.cpuMax, cpuRecordTime);
+  m_frameTimings.gpuSum += gpuTime;
+  if(++m_frameTimings.count < k_autoFramesWindow)
+  {
+    return;
+  }
+
+  const double cpuAvg = m_frameTimings.cpuSum / m_frameTimings.count;
+  const double gpuAvg = m_frameTimings.gpuSum / m_frameTimings.count;
+  uint32_t     count  = k_minFramesInFlight;
+  if(gpuAvg > 0.0 && cpuAvg < gpuAvg && m_frameTimings.cpuMax > gpuAvg)
+  {
+    count += uint32_t(std::ceil((m_frameTimings.cpuMax - gpuAvg) / gpuAvg));
+  }
+  count = std::clamp(std::max(count, getMinFramesInFlight()), k_minFramesInFlight, k_maxFramesInFlight);
+
+  if(count != m_framesInFlight)
+  {
+    LOGI("Frames in flight: %d -> %d (CPU record %.0f us, max %.0f us, GPU %.0f us)\n", m_framesInFlight, count,
+         cpuAvg, m_frameTimings.cpuMax, gpuAvg);
+    m_framesInFlight = count;
+  }
+  m_frameTimings = {};
+}
+
 
 //-----------------------------------------------------------------------
 // We are using dynamic rendering, which is a more flexible way to render to the swapchain image.
 //
-void nvapp::Application::beginDynamicRenderingToSwapchain(VkCommandBuffer cmd) const
+void nvapp::Application::beginDynamicRenderingToSwapchain(VkCommandBuffer cmd, bool keepContent) const
 {
   // Image to render to
   const VkRenderingAttachmentInfo colorAttachment{
       .sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
       .imageView   = m_swapchain.getImageView(),
       .imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL,
-      .loadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR,   // Clear the image (see clearValue)
+      .loadOp      = keepContent ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR,  // Keep the blitted viewport or clear the image (see clearValue)
       .storeOp     = VK_ATTACHMENT_STORE_OP_STORE,  // Store the image (keep the image)
       .clearValue  = {{{0.0f, 0.0f, 0.0f, 1.0f}}},
   };
@@ -725,7 +1444,8 @@ void nvapp::Application::beginDynamicRenderingToSwapchain(VkCommandBuffer cmd) c
   };
 
   // Transition the swapchain image to the color attachment layout, needed when using dynamic rendering
-  nvvk::cmdImageMemoryBarrier(cmd, {m_swapchain.getImage(), VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+  nvvk::cmdImageMemoryBarrier(cmd, {m_swapchain.getImage(), keepContent ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
 
   vkCmdBeginRendering(cmd, &renderingInfo);
 }
@@ -750,6 +1470,7 @@ void nvapp::Application::endDynamicRenderingToSwapchain(VkCommandBuffer cmd)
 void nvapp::Application::headlessRun()
 {
   nvutils::ScopedTimer st(__FUNCTION__);
+  finishAttachTasks();
   m_viewportSize = m_windowSize;
 
   // Set the display for Imgui
@@ -781,20 +1502,28 @@ void nvapp::Application::headlessRun()
     ImGui::EndFrame();
   }
 
-  // Rendering n-times the scene
+  // Rendering n-times the scene, frames are pipelined as with a window
+  nvutils::PerformanceTimer frameTimer;
   for(uint32_t frameID = 0; frameID < m_headlessFrameCount && !m_headlessClose; frameID++)
   {
+    frameTimer.reset();
     ImGui_ImplVulkan_NewFrame();
     ImGui::NewFrame();  // Even if isn't directly used, helps advancing time if query
 
     waitForFrameCompletion();
+    processFrameTimestamps(m_frameRingCurrent);
+    m_completionService.poll();
+    processCaptures(false);
 
     prepareFrameToSignal(getFrameCycleSize());
 
     VkCommandBuffer cmd = beginCommandRecording();  // Start the command buffer
     drawFrame(cmd);                                 // Call onUIRender() and onRender() for each element
     endFrame(cmd, getFrameCycleSize());             // End the frame and submit it
-    advanceFrame(getFrameCycleSize());              // Advance to the next frame in the ring buffer
+
+    m_frameData[m_frameRingCurrent].frameIndex   = frameID;
+    m_frameData[m_frameRingCurrent].cpuFrameTime = frameTimer.getMicroseconds();
+    advanceFrame(getFrameCycleSize());  // Advance to the next frame in the ring buffer
 
     ImGui::EndFrame();
   }
@@ -803,6 +1532,16 @@ void nvapp::Application::headlessRun()
   // At this point, everything has been rendered. Let it finish.
   vkDeviceWaitIdle(m_device);
 
+  // Collect the frames still in the ring, oldest first
+  if(m_recordFrameTimings)
+  {
+    for(uint32_t i = 0; i < getFrameCycleSize(); i++)
+    {
+      processFrameTimestamps((m_frameRingCurrent + i) % getFrameCycleSize());
+    }
+    writeFrameTimings();
+  }
+
   // Call back the application, such that it can do something with the rendered image
   for(std::shared_ptr<IAppElement>& e : m_elements)
   {
@@ -810,6 +1549,54 @@ void nvapp::Application::headlessRun()
   }
 }
 
+//-----------------------------------------------------------------------
+// Per-frame times of the headless run in microseconds, as JSON to m_frameTimingsFile or to the log
+//
+void nvapp::Application::writeFrameTimings() const
+{
+  FrameTiming average{};
+  for(const FrameTiming& timing : m_frameTimingRecords)
+  {
+    average.cpuFrame += timing.cpuFrame;
+    average.cpuRecord += timing.cpuRecord;
+    average.gpu += timing.gpu;
+  }
+  const double count = double(std::max<size_t>(m_frameTimingRecords.size(), 1));
+  average = {uint64_t(m_frameTimingRecords.size()), average.cpuFrame / count, average.cpuRecord / count, average.gpu / count};
+
+  if(m_frameTimingsFile.empty())
+  {
+    LOGI("Frame, CPU frame, CPU record, GPU (us)\n");
+    for(const FrameTiming& timing : m_frameTimingRecords)
+    {
+      LOGI("%llu, %.3f, %.3f, %.3f\n", (unsigned long long)timing.frame, timing.cpuFrame, timing.cpuRecord, timing.gpu);
+    }
+    LOGI("Average of %zu frames: CPU frame %.3f us, CPU record %.3f us, GPU %.3f us\n", m_frameTimingRecords.size(),
+         average.cpuFrame, average.cpuRecord, average.gpu);
+    return;
+  }
+
+  std::ofstream file(m_frameTimingsFile);
+  if(!file)
+  {
+    LOGE("Failed to write the frame timings %s\n", nvutils::utf8FromPath(m_frameTimingsFile).c_str());
+    return;
+  }
+  file << fmt::format("{{\n  \"frameCount\": {},\n  \"framesInFlight\": {},\n", m_frameTimingRecords.size(), m_framesInFlight);
+  file << fmt::format("  \"average\": {{\"cpuFrame\": {:.3f}, \"cpuRecord\": {:.3f}, \"gpu\": {:.3f}}},\n", average.cpuFrame,
+                      average.cpuRecord, average.gpu);
+  file << "  \"frames\": [";
+  for(size_t i = 0; i < m_frameTimingRecords.size(); i++)
+  {
+    const FrameTiming& timing = m_frameTimingRecords[i];
+    file << (i ? ",\n" : "\n")
+         << fmt::format("    {{\"frame\": {}, \"cpuFrame\": {:.3f}, \"cpuRecord\": {:.3f}, \"gpu\": {:.3f}}}", timing.frame,
+                        timing.cpuFrame, timing.cpuRecord, timing.gpu);
+  }
+  file << "\n  ]\n}\n";
+  LOGI("Timings of %zu frames written to %s\n", m_frameTimingRecords.size(), nvutils::utf8FromPath(m_frameTimingsFile).c_str());
+}
+
 //-----------------------------------------------------------------------
 // Create a command pool for short lived operations
 // The command pool is used to allocate command buffers.
@@ -853,6 +1640,7 @@ void nvapp::Application::createFrameSubmission(uint32_t numFrames)
   const VkSemaphoreCreateInfo semaphoreCreateInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, .pNext = &timelineCreateInfo};
   NVVK_CHECK(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &m_frameTimelineSemaphore));
   NVVK_DBG_NAME(m_frameTimelineSemaphore);
+  m_completionService.init(device);
 
   //Create command pools and buffers for each frame
   //Each frame gets its own command pool to allow parallel command recording while previous frames may still be executing on the GPU
@@ -878,6 +1666,71 @@ void nvapp::Application::createFrameSubmission(uint32_t numFrames)
     NVVK_CHECK(vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &m_frameData[i].cmdBuffer));
     NVVK_DBG_NAME(m_frameData[i].cmdBuffer);
   }
+
+  // Same for the async compute queue, its timeline follows the frame numbers of the graphics one
+  if(hasAsyncCompute())
+  {
+    NVVK_CHECK(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &m_computeTimelineSemaphore));
+    NVVK_DBG_NAME(m_computeTimelineSemaphore);
+
+    const VkCommandPoolCreateInfo computePoolCreateInfo{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .queueFamilyIndex = getComputeQueue().familyIndex,
+    };
+    for(uint32_t i = 0; i < numFrames; i++)
+    {
+      NVVK_CHECK(vkCreateCommandPool(device, &computePoolCreateInfo, nullptr, &m_frameData[i].computeCmdPool));
+      NVVK_DBG_NAME(m_frameData[i].computeCmdPool);
+
+      const VkCommandBufferAllocateInfo commandBufferAllocateInfo = {
+          .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+          .commandPool        = m_frameData[i].computeCmdPool,
+          .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+          .commandBufferCount = 1,
+      };
+      NVVK_CHECK(vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &m_frameData[i].computeCmdBuffer));
+      NVVK_DBG_NAME(m_frameData[i].computeCmdBuffer);
+    }
+  }
+
+  // One pool of secondary command buffers per worker thread and frame, for the parallel recording
+  if(m_parallelRecording)
+  {
+    const uint32_t                threadCount = uint32_t(nvutils::get_thread_pool().get_thread_count());
+    const VkCommandPoolCreateInfo threadPoolCreateInfo{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = m_queues[0].familyIndex,
+    };
+    for(uint32_t i = 0; i < numFrames; i++)
+    {
+      m_frameData[i].threadPools.resize(threadCount);
+      for(ThreadCommandPool& threadPool : m_frameData[i].threadPools)
+      {
+        NVVK_CHECK(vkCreateCommandPool(device, &threadPoolCreateInfo, nullptr, &threadPool.cmdPool));
+        NVVK_DBG_NAME(threadPool.cmdPool);
+      }
+    }
+  }
+
+  // Begin and end timestamps of each frame, for the automatic frames in flight
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+  if(properties.limits.timestampComputeAndGraphics)
+  {
+    m_timestampPeriod = properties.limits.timestampPeriod;
+    const VkQueryPoolCreateInfo queryPoolCreateInfo{
+        .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType  = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = numFrames * 2,
+    };
+    NVVK_CHECK(vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &m_frameQueryPool));
+    NVVK_DBG_NAME(m_frameQueryPool);
+  }
+  else if(m_autoFramesInFlight || m_recordFrameTimings)
+  {
+    LOGW("No timestamp support, no automatic frames in flight or frame timings\n");
+  }
 }
 
 //-----------------------------------------------------------------------
@@ -906,7 +1759,7 @@ void nvapp::Application::createDescriptorPool()
 
 //-----------------------------------------------------------------------
 // Initializes the ImGui context, sets up the settings handler for window
-// size and position, loads the ImGui .ini file, and sets up fonts and style.
+// size and position, loads the ImGui .ini file, and sets up style and fonts (not in headless mode).
 // This function should be called before any logic that depends on the ImGui
 // context or the loaded window settings.
 //
@@ -927,7 +1780,12 @@ void nvapp::Application::initializeImGuiContextAndSettings()
   // Set the ini file name
   io.IniFilename = m_iniFilename.c_str();
 
-  // Initialize fonts
+  // Initialize fonts. Headless runs never show the UI, ImGui falls back to its built-in font
+  // and nvgui::getMonospaceFont() returns nullptr, which PushFont() treats as the current font.
+  if(m_headless)
+  {
+    return;
+  }
   nvgui::addDefaultFont();
   io.FontDefault = nvgui::getDefaultFont();
   nvgui::addMonospaceFont();
@@ -1003,6 +1861,92 @@ void nvapp::Application::saveImageToFile(VkImage srcImage, VkExtent2D imageSize,
 }
 
 
+void nvapp::Application::saveImageToFileAsync(VkCommandBuffer              cmd,
+                                              VkImage                      srcImage,
+                                              VkExtent2D                   imageSize,
+                                              const std::filesystem::path& filename,
+                                              int                          quality)
+{
+  VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+  if(filename.extension() == ".hdr")
+  {
+    format = VK_FORMAT_R32G32B32A32_SFLOAT;
+  }
+
+  const uint32_t index   = acquireCapture(imageSize, format);
+  Capture&       capture = m_captures[index];
+  nvvk::cmdBlitImageToLinear(cmd, srcImage, capture.image, imageSize);
+  capture.frameNumber = getFrameSignalSemaphore().value;
+  capture.filename    = filename;
+  capture.quality     = quality;
+
+  // Once the copy is done the file is written by the thread pool
+  m_completionService.enqueue(nvvk::SemaphoreState::makeFixed(getFrameSignalSemaphore()), [this, index] {
+    Capture& done = m_captures[index];
+    done.encoding = nvutils::get_thread_pool().submit_task([device = m_device, image = done.image, memory = done.memory,
+                                                            size = done.size, filename = done.filename, quality = done.quality] {
+      nvvk::saveImageToFile(device, image, memory, size, filename, quality);
+      vkUnmapMemory(device, memory);
+    });
+    done.frameNumber = 0;
+  });
+}
+
+// Return a readback image which is neither copied to nor read, recreating it when
+// the size or the format differ. Stalls only when the whole ring is still busy.
+uint32_t nvapp::Application::acquireCapture(VkExtent2D size, VkFormat format)
+{
+  auto isFree = [](const Capture& capture) { return capture.frameNumber == 0 && !capture.encoding.valid(); };
+  auto isSame = [&](const Capture& capture) {
+    return isFree(capture) && capture.format == format && capture.size.width == size.width && capture.size.height == size.height;
+  };
+
+  auto it = std::find_if(m_captures.begin(), m_captures.end(), isSame);
+  if(it == m_captures.end())
+  {
+    it = std::find_if(m_captures.begin(), m_captures.end(), isFree);
+  }
+  if(it == m_captures.end() && m_captures.size() < k_captureRingSize)
+  {
+    m_captures.emplace_back();
+    it = std::prev(m_captures.end());
+  }
+  if(it == m_captures.end())
+  {
+    LOGW("Capture: writing the files is slower than the rendering, waiting for the pending saves\n");
+    processCaptures(true);
+    it = m_captures.begin();
+  }
+
+  if(!isSame(*it))
+  {
+    vkFreeMemory(m_device, it->memory, nullptr);
+    vkDestroyImage(m_device, it->image, nullptr);
+    NVVK_CHECK(nvvk::createLinearImage(m_device, m_physicalDevice, size, it->image, it->memory, format));
+    it->size   = size;
+    it->format = format;
+  }
+  return uint32_t(std::distance(m_captures.begin(), it));
+}
+
+// The copies whose frame completed on the GPU are handed to the thread pool by m_completionService,
+// with `wait` all copies and writes are finished on return.
+void nvapp::Application::processCaptures(bool wait)
+{
+  for(Capture& capture : m_captures)
+  {
+    if(capture.frameNumber != 0 && wait)
+    {
+      m_completionService.wait(nvvk::SemaphoreState::makeFixed(m_frameTimelineSemaphore, capture.frameNumber));
+    }
+
+    if(capture.encoding.valid() && (wait || capture.encoding.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+    {
+      capture.encoding.get();
+    }
+  }
+}
+
 // Record that a screenshot is requested, and will be saved after a full
 // frame cycle loop (so that ImGui has time to clear the menu).
 void nvapp::Application::screenShot(const std::filesystem::path& filename, int quality)
@@ -1010,38 +1954,48 @@ void nvapp::Application::screenShot(const std::filesystem::path& filename, int q
   m_screenShotRequested = true;
   m_screenShotFilename  = filename;
   // Making sure the screenshot is taken after the swapchain loop (remove the menu after click)
-  m_screenShotFrame = (m_frameRingCurrent - 1 + m_swapchain.getMaxFramesInFlight()) % m_swapchain.getMaxFramesInFlight();
+  m_screenShotFrame = (m_frameRingCurrent - 1 + getFrameCycleSize()) % getFrameCycleSize();
 }
 
-// Save the current swapchain image to a file
-void nvapp::Application::saveScreenShot(const std::filesystem::path& filename, int quality)
+void nvapp::Application::startCapture(const std::string& pattern, int quality)
 {
-  VkExtent2D     size     = m_windowSize;
-  VkImage        srcImage = m_swapchain.getImage();
-  VkImage        dstImage;
-  VkDeviceMemory dstImageMemory;
+  m_capturing      = true;
+  m_capturePattern = pattern;
+  m_captureQuality = quality;
+  m_captureIndex   = 0;
+}
 
-  vkDeviceWaitIdle(m_device);
-  VkCommandBuffer cmd = createTempCmdBuffer();
+// Copy the swapchain image, once ImGui rendered to it, for the pending screenshot and the capture
+void nvapp::Application::recordScreenShot(VkCommandBuffer cmd)
+{
+  const bool screenShot = m_screenShotRequested && (m_frameRingCurrent == m_screenShotFrame);
+  if(!screenShot && !m_capturing)
+  {
+    return;
+  }
+
+  VkImage srcImage = m_swapchain.getImage();
   nvvk::cmdImageMemoryBarrier(cmd, {srcImage, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_GENERAL});
-  nvvk::imageToLinear(cmd, m_device, m_physicalDevice, srcImage, size, dstImage, dstImageMemory, VK_FORMAT_R8G8B8A8_UNORM);
+  if(screenShot)
+  {
+    saveImageToFileAsync(cmd, srcImage, m_windowSize, m_screenShotFilename, k_imageQuality);
+    m_screenShotRequested = false;
+  }
+  if(m_capturing)
+  {
+    const std::string filename = fmt::format(fmt::runtime(m_capturePattern), m_captureIndex++);
+    saveImageToFileAsync(cmd, srcImage, m_windowSize, nvutils::pathFromUtf8(filename), m_captureQuality);
+  }
   nvvk::cmdImageMemoryBarrier(cmd, {srcImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR});
-  submitAndWaitTempCmdBuffer(cmd);
-
-  nvvk::saveImageToFile(m_device, dstImage, dstImageMemory, size, filename, quality);
-
-  // Clean up resources
-  vkUnmapMemory(m_device, dstImageMemory);
-  vkFreeMemory(m_device, dstImageMemory, nullptr);
-  vkDestroyImage(m_device, dstImage, nullptr);
 }
 
 
 void nvapp::Application::submitResourceFree(std::function<void()>&& func)
 {
+  std::lock_guard<std::mutex> lock(m_resourceFreeMutex);
   if(m_frameRingCurrent < m_resourceFreeQueue.size())
   {
-    m_resourceFreeQueue[m_frameRingCurrent].emplace_back(func);
+    m_resourceFreeQueue[m_frameRingCurrent].functions.emplace_back(std::move(func));
   }
   else
   {
@@ -1049,32 +2003,131 @@ void nvapp::Application::submitResourceFree(std::function<void()>&& func)
   }
 }
 
+void nvapp::Application::submitResourceFree(nvvk::ResourceAllocator* allocator, const nvvk::Buffer& buffer)
+{
+  std::lock_guard<std::mutex> lock(m_resourceFreeMutex);
+  if(m_frameRingCurrent < m_resourceFreeQueue.size())
+  {
+    m_resourceFreeQueue[m_frameRingCurrent].buffers.emplace_back(allocator, buffer);
+  }
+  else
+  {
+    nvvk::Buffer copy = buffer;
+    allocator->destroyBuffer(copy);
+  }
+}
+
+void nvapp::Application::submitResourceFree(nvvk::ResourceAllocator* allocator, const nvvk::Image& image)
+{
+  std::lock_guard<std::mutex> lock(m_resourceFreeMutex);
+  if(m_frameRingCurrent < m_resourceFreeQueue.size())
+  {
+    m_resourceFreeQueue[m_frameRingCurrent].images.emplace_back(allocator, image);
+  }
+  else
+  {
+    nvvk::Image copy = image;
+    allocator->destroyImage(copy);
+  }
+}
+
+void nvapp::Application::submitResourceFree(VkPipeline pipeline)
+{
+  std::lock_guard<std::mutex> lock(m_resourceFreeMutex);
+  if(m_frameRingCurrent < m_resourceFreeQueue.size())
+  {
+    m_resourceFreeQueue[m_frameRingCurrent].pipelines.push_back(pipeline);
+  }
+  else
+  {
+    vkDestroyPipeline(m_device, pipeline, nullptr);
+  }
+}
+
+void nvapp::Application::submitResourceFree(VkDescriptorPool pool, VkDescriptorSet set)
+{
+  std::lock_guard<std::mutex> lock(m_resourceFreeMutex);
+  if(m_frameRingCurrent < m_resourceFreeQueue.size())
+  {
+    m_resourceFreeQueue[m_frameRingCurrent].descriptorSets.emplace_back(pool, set);
+  }
+  else
+  {
+    vkFreeDescriptorSets(m_device, pool, 1, &set);
+  }
+}
+
 void nvapp::Application::resetFreeQueue(uint32_t size)
 {
   vkDeviceWaitIdle(m_device);
 
+  std::lock_guard<std::mutex> lock(m_resourceFreeMutex);
   for(auto& queue : m_resourceFreeQueue)
   {
-    // Free resources in queue
-    for(auto& func : queue)
-    {
-      func();
-    }
-    queue.clear();
+    freeResources(queue);
   }
   m_resourceFreeQueue.clear();
   m_resourceFreeQueue.resize(size);
+
+  m_frameArena.deinit();
+  if(size > 0)
+  {
+    m_frameArena.init(size);
+  }
 }
 
 // This is called to free all resources that are not used anymore
 // By using the frameRingCurrent we can free resources that are not used anymore
 void nvapp::Application::freeResourcesQueue()
 {
-  for(auto& func : m_resourceFreeQueue[m_frameRingCurrent])
+  std::lock_guard<std::mutex> lock(m_resourceFreeMutex);
+  freeResources(m_resourceFreeQueue[m_frameRingCurrent]);
+  m_frameArena.beginFrame(m_frameRingCurrent);
+}
+
+// Destroy the resources of the queue, clearing the vectors without releasing their memory
+void nvapp::Application::freeResources(ResourceFreeQueue& queue)
+{
+  for(auto& [allocator, buffer] : queue.buffers)
+  {
+    allocator->destroyBuffer(buffer);
+  }
+  for(auto& [allocator, image] : queue.images)
+  {
+    allocator->destroyImage(image);
+  }
+  for(VkPipeline pipeline : queue.pipelines)
+  {
+    vkDestroyPipeline(m_device, pipeline, nullptr);
+  }
+  for(auto& [pool, set] : queue.descriptorSets)
+  {
+    vkFreeDescriptorSets(m_device, pool, 1, &set);
+  }
+  for(auto& func : queue.functions)
   {
     func();  // Free resources in queue
   }
-  m_resourceFreeQueue[m_frameRingCurrent].clear();
+  for(auto& [closure, callAndDestroy] : queue.closures)
+  {
+    callAndDestroy(closure);
+  }
+  queue.buffers.clear();
+  queue.images.clear();
+  queue.pipelines.clear();
+  queue.descriptorSets.clear();
+  queue.functions.clear();
+  queue.closures.clear();
+}
+
+uint32_t nvapp::Application::getFrameDeviceMask() const
+{
+  return m_deviceGroup.getFrameDeviceMask(m_frameData[m_frameRingCurrent].frameNumber);
+}
+
+uint32_t nvapp::Application::getFrameDeviceIndex() const
+{
+  return m_deviceGroup.getFrameDeviceIndex(m_frameData[m_frameRingCurrent].frameNumber);
 }
 
 void nvapp::Application::addWaitSemaphore(const VkSemaphoreSubmitInfo& wait)
@@ -22,17 +22,28 @@
 
 #include <functional>
 #include <filesystem>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
 
 #include <glm/vec2.hpp>
 #include <imgui/imgui.h>
 
 #include <nvgui/settings_handler.hpp>
+#include <nvutils/frame_arena.hpp>
+#include <nvutils/profiler.hpp>
+#include <nvvk/completion_service.hpp>
+#include <nvvk/device_group.hpp>
 #include <nvvk/resources.hpp>
 #include <nvvk/swapchain.hpp>
 #include "frame_pacer.hpp"
 
+namespace nvvk {
+class GBuffer;
+}
+
 /*-------------------------------------------------------------------------------------------------
 # class nvapp::Application
 
@@ -111,10 +122,22 @@ Example:
 // Forward declarations
 struct GLFWwindow;
 
+namespace nvvk {
+class ResourceAllocator;
+}
+
 namespace nvapp {
 // Forward declarations
 class Application;
 
+//-------------------------------------------------------------------------------------------------
+// Work of an element's attach that runs on the thread pool, see IAppElement::onAttachTasks()
+struct AttachTask
+{
+  std::string           name;  // Shown on the loading screen
+  std::function<void()> run;
+};
+
 //-------------------------------------------------------------------------------------------------
 // Interface for application elements
 struct IAppElement
@@ -126,10 +149,22 @@ struct IAppElement
   virtual void onUIRender() {}                                           // Called for anything related to UI
   virtual void onUIMenu() {}                                             // This is the menubar to create
   virtual void onPreRender() {}                  // called post onUIRender and prior onRender (looped over all elements)
+  virtual void onRenderCompute(VkCommandBuffer cmd) {}  // Async compute work of the frame, see ApplicationCreateInfo::computeQueueIndex
   virtual void onRender(VkCommandBuffer cmd) {}  // For anything to render within a frame
   virtual void onFileDrop(const std::filesystem::path& filename) {}  // For when a file is dragged on top of the window
   virtual void onLastHeadlessFrame() {};  // Called at the end of the last frame in headless mode
 
+  // With ApplicationCreateInfo::parallelRecording, onRender() may run on a worker thread into a secondary command
+  // buffer, concurrently with the other elements returning true. It must then only touch its own state.
+  virtual bool canRecordInParallel() const { return false; }
+
+  // Work of the attach that can run on the thread pool, like shader compilation, pipeline creation or asset loads.
+  // Called after onAttach(); the tasks of all the elements run concurrently, while the application shows a loading
+  // screen, and no other callback of the elements is called before they all finished. The tasks must not submit to
+  // the queues: work needing them goes in onAttachTasksDone(), called on the main thread afterwards.
+  virtual void onAttachTasks(std::vector<AttachTask>& tasks) {}
+  virtual void onAttachTasksDone() {}
+
 
   virtual ~IAppElement() = default;
 };
@@ -147,6 +182,28 @@ struct ApplicationCreateInfo
   std::vector<nvvk::QueueInfo> queues;                          // Queue family and properties (0: Graphics)
   uint32_t                     texturePoolSize = 128U;          // Maximum number of textures in the descriptor pool
 
+  /*--
+   * [optional] Index in `queues` of a compute queue for IAppElement::onRenderCompute().
+   * Each frame, the compute work is submitted before the graphics work, which waits on it with a timeline
+   * semaphore. The compute of a frame can then overlap with the end of the previous frame on the graphics queue,
+   * so the elements must not overwrite in onRenderCompute() what the previous frame still reads.
+   * Resources used on both queues of different families need VK_SHARING_MODE_CONCURRENT or ownership transfers.
+  -*/
+  int32_t computeQueueIndex = -1;
+
+  /*--
+   * [optional] Device group, `deviceCount` is nvvk::Context::getDeviceCount(). In headless mode (offline renders),
+   * alternate frames run each frame on one device in turn, with at least as many frames in flight as devices (up to 4)
+   * to overlap them, and split frames run on all devices, which the elements split with getDeviceGroup(). Windowed,
+   * the frames run on device 0, which presents.
+  -*/
+  uint32_t              deviceCount     = 1;
+  nvvk::DeviceGroupMode deviceGroupMode = nvvk::DeviceGroupMode::eSingle;
+
+  // Elements whose canRecordInParallel() returns true record their onRender() on the nvutils thread pool,
+  // into secondary command buffers executed in the order of the elements
+  bool parallelRecording{false};
+
   // GLFW
   glm::uvec2 windowSize{0, 0};  // Window size (width, height) or Viewport size (headless)
   bool       vSync{true};       // Enable V-Sync by default
@@ -156,15 +213,32 @@ struct ApplicationCreateInfo
   bool                         hasUndockableViewport{false};  // Allow floating windows
   std::function<void(ImGuiID)> dockSetup;                     // Dock layout setup
   ImGuiConfigFlags             imguiConfigFlags{ImGuiConfigFlags_NavEnableKeyboard | ImGuiConfigFlags_DockingEnable};
+  bool                         cachedUI{false};               // Rebuild the UI only when it changes, see setCachedUI()
 
   // Headless
-  bool     headless{false};        // Run without a window
-  uint32_t headlessFrameCount{1};  // Frames to render in headless mode
+  bool                  headless{false};         // Run without a window
+  uint32_t              headlessFrameCount{1};   // Frames to render in headless mode
+  bool                  headlessTimings{false};  // Report the CPU and GPU times of each headless frame to the log
+  std::filesystem::path headlessTimingsFile;     // [optional] Write them to this JSON file instead
 
   // Swapchain
   // VK_PRESENT_MODE_MAX_ENUM_KHR means no preference
   VkPresentModeKHR preferredVsyncOffMode = VK_PRESENT_MODE_MAX_ENUM_KHR;
   VkPresentModeKHR preferredVsyncOnMode  = VK_PRESENT_MODE_MAX_ENUM_KHR;
+  VkPresentModeKHR presentMode           = VK_PRESENT_MODE_MAX_ENUM_KHR;  // Explicit mode, overrides vSync
+  uint32_t         swapchainImageCount{0};                                // 0: default
+  bool             swapchainMaintenance1Enabled{false};  // VK_EXT_swapchain_maintenance1 is enabled: present fences, mode switches
+
+  // Low latency (ignored in headless mode)
+  // The device extensions must be enabled on the context, see nvvk::Swapchain::InitInfo
+  bool                      lowLatency{false};          // Wait for the previous present before sampling the input
+  bool                      presentWaitEnabled{false};  // VK_KHR_present_id + VK_KHR_present_wait are enabled
+  bool                      lowLatency2Enabled{false};  // VK_NV_low_latency2 is enabled: driver sleep and markers
+  nvutils::ProfilerManager* profilerManager{nullptr};   // [optional] Receives the "latency" timeline
+
+  // Frames in flight (2-4), more frames keep the GPU busy through CPU spikes at the cost of latency
+  uint32_t framesInFlight{0};          // 0: one per swapchain image, 2 when headless
+  bool     autoFramesInFlight{false};  // Pick the smallest count keeping the GPU busy, from the measured times
 };
 
 
@@ -185,13 +259,76 @@ public:
   // Adding engines
   void addElement(const std::shared_ptr<IAppElement>& layer);
 
-  // Safely freeing up resources
+  // Safely freeing up resources, once the frames in flight don't use them anymore.
+  // Can be called from any thread. The typed versions don't allocate once the queues
+  // reached their steady size, prefer them over the closure when freeing many resources.
   void submitResourceFree(std::function<void()>&& func);
+  void submitResourceFree(nvvk::ResourceAllocator* allocator, const nvvk::Buffer& buffer);
+  void submitResourceFree(nvvk::ResourceAllocator* allocator, const nvvk::Image& image);
+  void submitResourceFree(VkPipeline pipeline);
+  void submitResourceFree(VkDescriptorPool pool, VkDescriptorSet set);  // Pool created with FREE_DESCRIPTOR_SET
+  // Closures other than std::function are stored in the frame arena, without allocating
+  template <typename Func, typename = std::enable_if_t<std::is_invocable_v<std::decay_t<Func>&> && !std::is_same_v<std::decay_t<Func>, std::function<void()>>>>
+  void submitResourceFree(Func&& func)
+  {
+    using Closure = std::decay_t<Func>;
+    std::lock_guard<std::mutex> lock(m_resourceFreeMutex);
+    if(m_frameRingCurrent < m_resourceFreeQueue.size())
+    {
+      // the arena of the frame is reset after the queue was freed
+      void* closure = m_frameArena.getThreadArena(m_frameRingCurrent).allocate(sizeof(Closure), alignof(Closure));
+      new(closure) Closure(std::forward<Func>(func));
+      m_resourceFreeQueue[m_frameRingCurrent].closures.push_back({closure, [](void* ptr) {
+                                                                     Closure* c = static_cast<Closure*>(ptr);
+                                                                     (*c)();
+                                                                     c->~Closure();
+                                                                   }});
+    }
+    else
+    {
+      func();
+    }
+  }
 
   // Utilities
-  bool isVsync() const { return m_vsyncWanted; }  // Return true if V-Sync is on
-  void setVsync(bool v);                          // Set V-Sync on or off
-  bool isHeadless() const { return m_headless; }  // Return true if headless
+  bool isVsync() const { return m_vsyncWanted; }                     // Return true if V-Sync is on
+  void setVsync(bool v);                                             // Set V-Sync on or off
+  void setPresentMode(VkPresentModeKHR mode);                        // Explicit present mode, MAX_ENUM returns to V-Sync
+  VkPresentModeKHR getPresentMode() const { return m_swapchain.getPresentMode(); }  // Mode in use
+  VkPresentModeKHR getRequestedPresentMode() const { return m_presentModeWanted; }
+  const std::vector<VkPresentModeKHR>& getSupportedPresentModes() const { return m_swapchain.getSupportedPresentModes(); }
+  bool isHeadless() const { return m_headless; }                     // Return true if headless
+  bool isLowLatency() const { return m_lowLatency; }                 // Return true if the low latency mode is active
+  bool hasAsyncCompute() const { return m_computeQueueIndex >= 0; }  // Return true if onRenderCompute() is called
+
+  // Device group: the devices running the commands of the frame being recorded, see ApplicationCreateInfo::deviceGroupMode
+  const nvvk::DeviceGroup& getDeviceGroup() const { return m_deviceGroup; }
+  uint32_t                 getFrameDeviceMask() const;
+  uint32_t                 getFrameDeviceIndex() const;  // The first of them, which waits for and signals the semaphores
+
+  // Frames the CPU can record ahead of the GPU, can be changed at any time between frames
+  void     setFramesInFlight(uint32_t count);   // Clamped to 2-4, turns the automatic mode off
+  uint32_t getFramesInFlight() const { return m_framesInFlight; }
+  void     setAutoFramesInFlight(bool enable);  // Compares the CPU recording with the GPU execution of the frames
+  bool     isAutoFramesInFlight() const { return m_autoFramesInFlight; }
+
+  // Cached UI: onUIMenu() and onUIRender() are only called on input, after requestUIRedraw() and
+  // a few times per second, the other frames render the previous UI again and still call onRender()
+  void setCachedUI(bool enable) { m_cachedUI = enable; }
+  bool isCachedUI() const { return m_cachedUI; }
+  void requestUIRedraw() { m_uiRedrawRequested = true; }  // A value shown in the UI changed
+
+  // Shows a color image of the GBuffer in the current window, the "Viewport", like ImGui::Image() of its descriptor
+  // set with its UV scale. While that window is docked in the central node of the main window, the rendered rectangle
+  // is blitted straight into the swapchain and the UI drawn on top, instead of being sampled by the ImGui pipeline.
+  // Call it in onUIRender(): the image is read at the end of the frame, in GENERAL layout.
+  void displayViewportImage(const nvvk::GBuffer& gbuffer, uint32_t colorIndex = 0);
+
+  // Pacing of the frames with V-Sync, outside of the low latency mode
+  const FramePacer& getFramePacer() const { return m_framePacer; }
+
+  // Latest driver report of VK_NV_low_latency2, false when unavailable
+  bool getLatencyTimings(VkLatencyTimingsFrameReportNV& report) const { return m_swapchain.getLatencyTimings(report); }
 
   // Following three functions affect the preparation of the current frame's submit info.
   // Content is appended to vectors that are reset every frame
@@ -199,6 +336,10 @@ public:
   void                addSignalSemaphore(const VkSemaphoreSubmitInfo& signal);
   nvvk::SemaphoreInfo getFrameSignalSemaphore() const;  // Return the current frame's signal semaphore
 
+  // Callbacks run once the GPU reaches a semaphore value, e.g. `getFrameSignalSemaphore()` to act after this frame.
+  // Polled before recording each frame; the pending callbacks are run before the elements are detached.
+  nvvk::CompletionService& getCompletionService() { return m_completionService; }
+
   // these command buffers are enqueued before the command buffer that is provided `onRender(cmd)`
   void prependCommandBuffer(const VkCommandBufferSubmitInfo& cmd);
 
@@ -211,6 +352,7 @@ public:
   inline VkPhysicalDevice       getPhysicalDevice() const { return m_physicalDevice; }
   inline VkDevice               getDevice() const { return m_device; }
   inline const nvvk::QueueInfo& getQueue(uint32_t index) const { return m_queues[index]; }
+  inline const nvvk::QueueInfo& getComputeQueue() const { return m_queues[m_computeQueueIndex]; }
   inline VkCommandPool          getCommandPool() const { return m_transientCmdPool; }
   inline VkDescriptorPool       getTextureDescriptorPool() const { return m_descriptorPool; }
   inline const VkExtent2D&      getViewportSize() const { return m_viewportSize; }
@@ -218,6 +360,8 @@ public:
   inline GLFWwindow*            getWindowHandle() const { return m_windowHandle; }
   inline uint32_t               getFrameCycleIndex() const { return m_frameRingCurrent; }
   inline uint32_t               getFrameCycleSize() const { return uint32_t(m_frameData.size()); }
+  // Transient CPU memory, valid until the same frame of the ring comes back (see nvutils::FrameArena)
+  inline nvutils::FrameArena& getFrameArena() { return m_frameArena; }
 
   // Simulate the Drag&Drop of a file
   void onFileDrop(const std::filesystem::path& filename);
@@ -229,6 +373,19 @@ public:
   // Saves a VkImage to a file, blitting it to RGBA8 format along the way.
   void saveImageToFile(VkImage srcImage, VkExtent2D imageSize, const std::filesystem::path& filename, int quality = 100);
 
+  // Same as saveImageToFile, without stalling: the copy of srcImage (in GENERAL layout) is recorded in the
+  // frame command buffer, and the file is written on a worker thread once the frame completed on the GPU.
+  void saveImageToFileAsync(VkCommandBuffer              cmd,
+                            VkImage                      srcImage,
+                            VkExtent2D                   imageSize,
+                            const std::filesystem::path& filename,
+                            int                          quality = 100);
+
+  // Save every presented frame, the pattern is formatted with the capture index (ex. "capture_{:05}.jpg")
+  void startCapture(const std::string& pattern, int quality = 90);
+  void stopCapture() { m_capturing = false; }
+  bool isCapturing() const { return m_capturing; }
+
 
 private:
   void            initGlfw(ApplicationCreateInfo& info);
@@ -237,21 +394,34 @@ private:
   void            createDescriptorPool();
   void            onViewportSizeChange(VkExtent2D size);
   void            headlessRun();
+  void            finishAttachTasks();  // Loading screen until the attach tasks of the elements finished
   VkCommandBuffer beginCommandRecording();
   void            addSwapchainSemaphores();
   void            drawFrame(VkCommandBuffer cmd);
+  void            submitFrameCompute();
+  void            recordElementsInParallel(VkCommandBuffer cmd);
   void            renderToSwapchain(VkCommandBuffer cmd);
   bool            prepareFrameResources();
   void            endFrame(VkCommandBuffer cmd, uint32_t frameInFlights);
   void            presentFrame();
   void            advanceFrame(uint32_t frameInFlights);
+  void            beginLowLatencyFrame();
   void            waitForFrameCompletion() const;
-  void            beginDynamicRenderingToSwapchain(VkCommandBuffer cmd) const;
+  void            processFrameTimestamps(uint32_t slot);
+  void            updateFramesInFlight(double cpuRecordTime, double gpuTime);
+  uint32_t        getMinFramesInFlight() const;  // One per device with alternate frames
+  void            writeFrameTimings() const;
+  void            beginDynamicRenderingToSwapchain(VkCommandBuffer cmd, bool keepContent) const;  // keepContent: after the viewport blit
+  void            blitViewportToSwapchain(VkCommandBuffer cmd);  // Leaves the image in TRANSFER_DST layout
   void            endDynamicRenderingToSwapchain(VkCommandBuffer cmd);
-  void            saveScreenShot(const std::filesystem::path& filename, int quality);  // Immediately save the frame
+  void            recordScreenShot(VkCommandBuffer cmd);             // Copy the swapchain image to save
+  void            processCaptures(bool wait);                        // Hand the completed copies to the workers
+  uint32_t        acquireCapture(VkExtent2D size, VkFormat format);  // Free readback image of that size and format
   void            resetFreeQueue(uint32_t size);
   void            freeResourcesQueue();
+  void            freeResources(ResourceFreeQueue& queue);
   void            setupImguiDock();
+  bool            needsUIFrame();
   void            prepareFrameToSignal(int32_t numFramesInFlight);
   void            testAndSetWindowSizeAndPos(const glm::uvec2& winSize);
   bool            isWindowPosValid(const glm::ivec2& winPos);
@@ -261,8 +431,19 @@ private:
 
   std::vector<std::shared_ptr<IAppElement>> m_elements;  // List of application elements to be called
 
+  // Attach tasks running on the thread pool, started by addElement()
+  struct PendingAttachTask
+  {
+    std::string                  name;
+    std::shared_ptr<IAppElement> element;
+    std::future<void>            future;
+  };
+  std::vector<PendingAttachTask>     m_attachTasks;
+  std::vector<std::filesystem::path> m_pendingFileDrops;  // Dropped while the attach tasks were running
+
   bool        m_useMenubar{true};   // Will use a menubar
   bool        m_vsyncWanted{true};  // Wanting swapchain with vsync
+  VkPresentModeKHR m_presentModeWanted{VK_PRESENT_MODE_MAX_ENUM_KHR};  // Explicit present mode, overrides m_vsyncWanted
   std::string m_iniFilename;        // Holds an .ini name as UTF-8 since ImGui uses this encoding
 
   // Vulkan resources
@@ -277,16 +458,67 @@ private:
 
   // Frame resources and synchronization (Swapchain, Command buffers, Semaphores, Fences)
   nvvk::Swapchain m_swapchain;
+  // Secondary command buffers of one worker thread, reset with the frame
+  struct ThreadCommandPool
+  {
+    VkCommandPool                cmdPool{};
+    std::vector<VkCommandBuffer> cmdBuffers{};  // Allocated on demand, one per element recorded by the thread
+    uint32_t                     usedCount{};   // Command buffers recorded in the current frame
+  };
   struct FrameData
   {
-    VkCommandPool   cmdPool{};      // Command pool for recording commands for this frame
-    VkCommandBuffer cmdBuffer{};    // Command buffer containing the frame's rendering commands
-    uint64_t        frameNumber{};  // Timeline value for synchronization (increases each frame)
+    VkCommandPool                  cmdPool{};           // Command pool for recording commands for this frame
+    VkCommandBuffer                cmdBuffer{};         // Command buffer containing the frame's rendering commands
+    uint64_t                       frameNumber{};       // Timeline value for synchronization (increases each frame)
+    double                         cpuRecordTime{};     // Microseconds from the begin of the recording to the submit
+    bool                           hasTimestamps{};     // The frame wrote its begin and end timestamps
+    uint64_t                       frameIndex{};        // Headless frame, for the timings report
+    double                         cpuFrameTime{};      // Microseconds of the whole headless frame on the CPU
+    VkCommandPool                  computeCmdPool{};    // Command pool of the async compute queue
+    VkCommandBuffer                computeCmdBuffer{};  // Command buffer containing the frame's async compute commands
+    std::vector<ThreadCommandPool> threadPools;         // One per thread of the pool, for the parallel recording
   };
   std::vector<FrameData> m_frameData{};    // Collection of per-frame resources to support multiple frames in flight
   VkSemaphore m_frameTimelineSemaphore{};  // Timeline semaphore used to synchronize CPU submission with GPU completion
   uint32_t m_frameRingCurrent{0};  // Current frame index in the ring buffer (cycles through available frames) : static for resource free queue
 
+  // Async compute, the compute submit of a frame signals the frame number on its own timeline
+  int32_t     m_computeQueueIndex{-1};
+  VkSemaphore m_computeTimelineSemaphore{};
+
+  nvvk::DeviceGroup m_deviceGroup;
+
+  // Parallel recording of the elements
+  bool                         m_parallelRecording{false};
+  std::vector<uint32_t>        m_parallelElements;   // Indices of the elements recorded on the thread pool
+  std::vector<VkCommandBuffer> m_elementCmdBuffers;  // Secondary command buffer of each of these elements
+
+  // Frames in flight, up to the ring size
+  uint32_t                  m_framesInFlight{2};          // Frames the CPU can record ahead of the GPU
+  bool                      m_autoFramesInFlight{false};  // m_framesInFlight follows the measured times
+  VkQueryPool               m_frameQueryPool{};           // Begin and end timestamps per frame of the ring
+  float                     m_timestampPeriod{1.0f};      // Nanoseconds per timestamp tick
+  nvutils::PerformanceTimer m_recordTimer;                // Reset at the begin of the recording
+  struct
+  {
+    double   cpuSum{};
+    double   cpuMax{};
+    double   gpuSum{};
+    uint32_t count{};
+  } m_frameTimings;  // Accumulated over the automatic mode window
+
+  // Per-frame timings of the headless run, in microseconds
+  struct FrameTiming
+  {
+    uint64_t frame{};
+    double   cpuFrame{};
+    double   cpuRecord{};
+    double   gpu{};
+  };
+  bool                     m_recordFrameTimings{false};
+  std::filesystem::path    m_frameTimingsFile;
+  std::vector<FrameTiming> m_frameTimingRecords;
+
   // Fine control over the frame submission
   std::vector<VkSemaphoreSubmitInfo>     m_waitSemaphores;    // Possible extra frame wait semaphores
   std::vector<VkSemaphoreSubmitInfo>     m_signalSemaphores;  // Possible extra frame signal semaphores
@@ -294,17 +526,55 @@ private:
 
   FramePacer m_framePacer;  // Low-latency system
 
+  // Low latency mode, the timeline measures from the input sampling to the completion of the present
+  bool                       m_lowLatency{false};
+  nvutils::ProfilerManager*  m_profilerManager{nullptr};
+  nvutils::ProfilerTimeline* m_latencyTimeline{nullptr};
+  double                     m_inputSampleTime{0.0};       // Profiler time of the last input sampling
+  uint64_t                   m_inputSamplePresentId{0};    // Present id of the frame that sampled it
+  uint64_t                   m_latencyReportPresentId{0};  // Last driver report added to the timeline
+
   GLFWwindow* m_windowHandle{nullptr};  // GLFW Window
   VkExtent2D  m_viewportSize{0, 0};     // Size of the viewport
   VkExtent2D  m_windowSize{0, 0};       // Size of the window
   float       m_dpiScale{1.f};          // Current scaling due to DPI.
 
   //--
-  std::vector<std::vector<std::function<void()>>> m_resourceFreeQueue;  // Queue of functions to free resources
+  // Resources to free when a frame slot is reused, the vectors keep their capacity across frames
+  struct ResourceFreeQueue
+  {
+    std::vector<std::pair<nvvk::ResourceAllocator*, nvvk::Buffer>> buffers;
+    std::vector<std::pair<nvvk::ResourceAllocator*, nvvk::Image>>  images;
+    std::vector<VkPipeline>                                        pipelines;
+    std::vector<std::pair<VkDescriptorPool, VkDescriptorSet>>      descriptorSets;
+    std::vector<std::function<void()>>                             functions;  // Must not submit frees themselves
+    std::vector<std::pair<void*, void (*)(void*)>>                 closures;   // In m_frameArena, called then destroyed
+  };
+  std::vector<ResourceFreeQueue> m_resourceFreeQueue;  // One per frame of the ring
+  std::mutex                     m_resourceFreeMutex;  // Guards the queues for the submissions from other threads
+  nvutils::FrameArena            m_frameArena;         // One frame per queue, reset after freeing it
 
   //--
   std::function<void(ImGuiID)> m_dockSetup;  // Function to setup the docking
 
+  // Cached UI
+  bool   m_cachedUI{false};
+  bool   m_uiFrame{true};            // The UI is rebuilt in the current frame
+  bool   m_uiRedrawRequested{false};
+  double m_uiSettleEndTime{0.0};     // Rebuilt every frame until then
+  double m_uiLastFrameTime{0.0};
+
+  // Viewport image blitted into the swapchain by displayViewportImage(), image is null when ImGui samples it
+  struct ViewportBlit
+  {
+    VkImage    image{};
+    VkExtent2D srcSize{};
+    VkOffset2D dstOffset{};
+    VkExtent2D dstSize{};
+  };
+  ViewportBlit m_viewportBlit;
+  bool         m_viewportBlitWanted{false};  // The "Viewport" window is begun without background in the next UI frame
+
   bool                  m_headless{false};
   bool                  m_headlessClose{false};
   uint32_t              m_headlessFrameCount{1};
@@ -312,6 +582,26 @@ private:
   int                   m_screenShotFrame     = 0;
   std::filesystem::path m_screenShotFilename;
 
+  nvvk::CompletionService m_completionService;
+
+  // Ring of host visible images the asynchronous saves copy to
+  struct Capture
+  {
+    VkImage               image{};
+    VkDeviceMemory        memory{};
+    VkExtent2D            size{};
+    VkFormat              format{VK_FORMAT_UNDEFINED};
+    uint64_t              frameNumber{};  // Timeline value of the frame doing the copy, 0 once handed to a worker by m_completionService
+    std::filesystem::path filename;
+    int                   quality{};
+    std::future<void>     encoding;  // Valid while a worker writes the file
+  };
+  std::vector<Capture> m_captures;
+  bool                 m_capturing{false};
+  std::string          m_capturePattern;
+  int                  m_captureQuality{};
+  uint32_t             m_captureIndex{};
+
   // Use for persist the data
   nvgui::SettingsHandler m_settingsHandler;
   glm::ivec2             m_winPos{};
@@ -44,7 +44,8 @@ void nvapp::ElementCamera::updateCamera(std::shared_ptr<nvutils::CameraManipulat
   if(!inputs.alt)
   {
     // Speed of the camera movement when using WASD and arrows
-    float keyMotionFactor = ImGui::GetIO().DeltaTime;
+    const double fixedTimeStep   = m_cameraManip->getFixedTimeStep();
+    float        keyMotionFactor = fixedTimeStep > 0.0 ? float(fixedTimeStep) : ImGui::GetIO().DeltaTime;
     if(inputs.shift)
     {
       keyMotionFactor *= 5.0F;  // Speed up the camera movement
@@ -118,9 +119,89 @@ void nvapp::ElementCamera::onAttach(nvapp::Application* app)
 void nvapp::ElementCamera::onUIRender()
 {
   assert(m_cameraManip && "Missing setCamera");
+  if(m_playing)
+  {
+    return;
+  }
   updateCamera(m_cameraManip, ImGui::FindWindowByName("Viewport"));
 }
 
+// Called every frame, unlike onUIRender with a cached UI
+void nvapp::ElementCamera::onPreRender()
+{
+  if(m_playing)
+  {
+    // The time since the previous playback frame is the CPU frame time of that frame
+    if(m_playbackFrame > 0)
+    {
+      m_segmentTimeSums[m_playbackSegment] += m_frameTimer.getSeconds();
+      m_segmentFrameCounts[m_playbackSegment]++;
+    }
+    m_frameTimer.reset();
+
+    const double time = double(m_playbackFrame) * m_playbackFrameTime;
+    if(time > m_playbackPath.getDuration())
+    {
+      m_playing = false;
+      LOGI("Camera path: playback completed after %llu frames\n", (unsigned long long)m_playbackFrame);
+      return;
+    }
+    m_cameraManip->updateAnim();
+    m_cameraManip->setCamera(m_playbackPath.evaluate(time));
+    m_playbackSegment = m_playbackPath.getSegment(time);
+    m_playbackFrame++;
+  }
+
+  if(m_recording)
+  {
+    const double fixedTimeStep = m_cameraManip->getFixedTimeStep();
+    m_recordingTime            = fixedTimeStep > 0.0 ? m_recordingTime + fixedTimeStep : m_recordingTimer.getSeconds();
+    m_recordedPath.addKeyframe(m_recordingTime, m_cameraManip->getCamera(), m_recordingSegment);
+  }
+}
+
+void nvapp::ElementCamera::startRecording()
+{
+  m_recordedPath.clear();
+  m_recordingTimer.reset();
+  m_recordingTime    = 0;
+  m_recordingSegment = 0;
+  m_recording        = true;
+  // The first keyframe is at time 0
+  m_recordedPath.addKeyframe(0.0, m_cameraManip->getCamera());
+}
+
+const nvutils::CameraPath& nvapp::ElementCamera::stopRecording()
+{
+  m_recording = false;
+  return m_recordedPath;
+}
+
+void nvapp::ElementCamera::startPlayback(const nvutils::CameraPath& path, double frameTime /*= 1.0 / 60.0*/)
+{
+  assert(frameTime > 0.0);
+  m_playbackPath      = path;
+  m_playbackFrameTime = frameTime;
+  m_playbackFrame     = 0;
+  m_playbackSegment   = 0;
+  m_playing           = !path.empty();
+  m_segmentTimeSums.assign(path.getSegmentCount(), 0.0);
+  m_segmentFrameCounts.assign(path.getSegmentCount(), 0);
+}
+
+std::vector<double> nvapp::ElementCamera::getSegmentFrameTimes() const
+{
+  std::vector<double> frameTimes(m_segmentTimeSums.size(), 0.0);
+  for(size_t i = 0; i < frameTimes.size(); i++)
+  {
+    if(m_segmentFrameCounts[i])
+    {
+      frameTimes[i] = m_segmentTimeSums[i] * 1000.0 / double(m_segmentFrameCounts[i]);
+    }
+  }
+  return frameTimes;
+}
+
 void nvapp::ElementCamera::onResize(VkCommandBuffer cmd, const VkExtent2D& size)
 {
   assert(m_cameraManip && "Missing setCamera");
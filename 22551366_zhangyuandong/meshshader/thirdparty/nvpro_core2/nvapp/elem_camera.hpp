@@ -22,6 +22,8 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 #include <nvutils/camera_manipulator.hpp>
+#include <nvutils/camera_path.hpp>
+#include <nvutils/timers.hpp>
 
 #include "application.hpp"
 
@@ -33,6 +35,13 @@ It is using the `nvutils::CameraManipulator` to handle the camera movement and i
 
 To use this class, you need to add it to the `nvvkhl::Application` using the `addElement` method.
 
+It can also record the camera to a `nvutils::CameraPath` and play a path back:
+- Recording adds one keyframe per frame, timed by the fixed time step of the manipulator when
+  set, by the elapsed time otherwise.
+- The playback is driven by the frame index: frame N shows the path at N * frameTime, whatever
+  the frame rate, and the inputs are ignored. The CPU frame times are averaged per segment of
+  the path, e.g. to be added to the report of a `ParameterSequencer`.
+
 -------------------------------------------------------------------------------------------------*/
 
 
@@ -45,8 +54,22 @@ struct ElementCamera : public nvapp::IAppElement
   void setCameraManipulator(std::shared_ptr<nvutils::CameraManipulator>& pCamera) { m_cameraManip = pCamera; }
   void onAttach(nvapp::Application* app) override;
   void onUIRender() override;
+  void onPreRender() override;
   void onResize(VkCommandBuffer cmd, const VkExtent2D& size) override;
 
+  // Recording, `nextRecordingSegment` starts a new segment of the path at the next keyframe
+  void                       startRecording();
+  void                       nextRecordingSegment() { m_recordingSegment++; }
+  const nvutils::CameraPath& stopRecording();
+  bool                       isRecording() const { return m_recording; }
+
+  // Playback, restarts from the first frame when already playing
+  void startPlayback(const nvutils::CameraPath& path, double frameTime = 1.0 / 60.0);
+  void stopPlayback() { m_playing = false; }
+  bool isPlaying() const { return m_playing; }
+  // Average CPU frame time in milliseconds of each segment of the last playback, 0 for the segments not reached
+  std::vector<double> getSegmentFrameTimes() const;
+
   std::shared_ptr<nvutils::CameraManipulator> getCameraManipulator() const { return m_cameraManip; }
 
   // Can be called independently
@@ -54,6 +77,21 @@ struct ElementCamera : public nvapp::IAppElement
 
 private:
   std::shared_ptr<nvutils::CameraManipulator> m_cameraManip{};
+
+  nvutils::CameraPath       m_recordedPath;
+  nvutils::PerformanceTimer m_recordingTimer;
+  double                    m_recordingTime    = 0;
+  uint32_t                  m_recordingSegment = 0;
+  bool                      m_recording        = false;
+
+  nvutils::CameraPath       m_playbackPath;
+  nvutils::PerformanceTimer m_frameTimer;
+  double                    m_playbackFrameTime = 0;
+  uint64_t                  m_playbackFrame     = 0;
+  uint32_t                  m_playbackSegment   = 0;
+  bool                      m_playing           = false;
+  std::vector<double>       m_segmentTimeSums;  // seconds
+  std::vector<uint32_t>     m_segmentFrameCounts;
 };
 
 }  // namespace nvapp
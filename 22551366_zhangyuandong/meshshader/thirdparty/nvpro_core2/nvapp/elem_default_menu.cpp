@@ -44,6 +44,13 @@ void nvapp::ElementDefaultMenu::onUIMenu()
 #endif
   if(ImGui::BeginMenu("File"))
   {
+    if(ImGui::MenuItem(ICON_MS_PHOTO_CAMERA " Capture Frames", nullptr, m_app->isCapturing()))
+    {
+      if(m_app->isCapturing())
+        m_app->stopCapture();
+      else
+        m_app->startCapture("capture_{:05}.jpg");
+    }
     if(ImGui::MenuItem(ICON_MS_POWER_SETTINGS_NEW " Exit", "Ctrl+Q"))
     {
       close_app = true;
@@ -53,6 +60,43 @@ void nvapp::ElementDefaultMenu::onUIMenu()
   if(ImGui::BeginMenu("View"))
   {
     ImGui::MenuItem(ICON_MS_BOTTOM_PANEL_OPEN " V-Sync", "Ctrl+Shift+V", &v_sync);
+    if(ImGui::BeginMenu("Frames in Flight"))
+    {
+      if(ImGui::MenuItem("Auto", nullptr, m_app->isAutoFramesInFlight()))
+      {
+        m_app->setAutoFramesInFlight(!m_app->isAutoFramesInFlight());
+      }
+      ImGui::Separator();
+      for(uint32_t count = 2; count <= 4; count++)
+      {
+        if(ImGui::MenuItem(std::to_string(count).c_str(), nullptr, m_app->getFramesInFlight() == count))
+        {
+          m_app->setFramesInFlight(count);
+        }
+      }
+      ImGui::EndMenu();
+    }
+    if(!m_app->getSupportedPresentModes().empty() && ImGui::BeginMenu("Present Mode"))
+    {
+      if(ImGui::MenuItem("Auto (V-Sync)", nullptr, m_app->getRequestedPresentMode() == VK_PRESENT_MODE_MAX_ENUM_KHR))
+      {
+        m_app->setPresentMode(VK_PRESENT_MODE_MAX_ENUM_KHR);
+      }
+      ImGui::Separator();
+      for(VkPresentModeKHR mode : m_app->getSupportedPresentModes())
+      {
+        const char* name = mode == VK_PRESENT_MODE_IMMEDIATE_KHR    ? "Immediate" :
+                           mode == VK_PRESENT_MODE_MAILBOX_KHR      ? "Mailbox" :
+                           mode == VK_PRESENT_MODE_FIFO_KHR         ? "FIFO" :
+                           mode == VK_PRESENT_MODE_FIFO_RELAXED_KHR ? "FIFO Relaxed" :
+                                                                      nullptr;
+        if(name && ImGui::MenuItem(name, nullptr, m_app->getRequestedPresentMode() == mode))
+        {
+          m_app->setPresentMode(mode);
+        }
+      }
+      ImGui::EndMenu();
+    }
     ImGui::EndMenu();
   }
 #ifdef SHOW_IMGUI_DEMO
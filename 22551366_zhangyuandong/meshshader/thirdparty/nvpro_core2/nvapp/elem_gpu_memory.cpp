@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+
+#include <implot/implot.h>
+#include <fmt/format.h>
+#include <nvgui/fonts.hpp>
+#include <nvutils/file_operations.hpp>
+#include <nvutils/logger.hpp>
+
+#include "elem_gpu_memory.hpp"
+
+using namespace nvapp;
+
+constexpr float kMiB = 1.0f / (1024.0f * 1024.0f);
+
+ElementGpuMemory::ElementGpuMemory(VmaAllocator allocator, bool show)
+    : showWindow(show)
+    , m_allocator(allocator)
+{
+}
+
+void ElementGpuMemory::addTracker(const std::string& name, const nvvkgltf::GpuMemoryTracker* tracker)
+{
+  const nvvkgltf::GpuMemoryStats total = tracker->getTotalStats();
+  m_trackers.push_back({name, tracker, total.totalAllocations, total.totalDeallocations});
+}
+
+bool ElementGpuMemory::setCsvOutput(const std::filesystem::path& filename)
+{
+  m_csv.close();
+  if(filename.empty())
+    return true;
+
+  m_csv.open(filename);
+  if(!m_csv)
+  {
+    LOGW("Failed to open %s\n", nvutils::utf8FromPath(filename).c_str());
+    return false;
+  }
+  m_csv << "frame,time_s,series,value\n";
+  return true;
+}
+
+void ElementGpuMemory::onAttach(Application* /*app*/)
+{
+  m_settingsHandler.setHandlerName("ElementGpuMemory");
+  m_settingsHandler.setSetting("ShowWindow", &showWindow);
+  m_settingsHandler.addImGuiHandler();
+}
+
+void ElementGpuMemory::onDetach()
+{
+  m_csv.close();
+}
+
+void ElementGpuMemory::onUIMenu()
+{
+  if(ImGui::BeginMenu("View"))
+  {
+    ImGui::MenuItem(ICON_MS_MEMORY " GPU Memory", nullptr, &showWindow);
+    ImGui::EndMenu();
+  }
+}
+
+ElementGpuMemory::Series& ElementGpuMemory::getSeries(std::vector<Series>& series, const std::string& name)
+{
+  for(Series& s : series)
+  {
+    if(s.name == name)
+      return s;
+  }
+  // Series appearing later start at 0, to stay aligned with m_frames
+  series.push_back({name, std::vector<float>(m_frames.size(), 0.0f)});
+  return series.back();
+}
+
+void ElementGpuMemory::addValue(Series& series, float value)
+{
+  if(series.values.size() < historyLength)
+    series.values.push_back(value);
+  else
+    series.values[m_ringOffset] = value;
+}
+
+// Samples the trackers and VMA once per frame, also without UI (headless)
+void ElementGpuMemory::onPreRender()
+{
+  const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+
+  // Categories which are freed keep their series at 0
+  for(Series& series : m_categories)
+    series.lastValue = 0;
+
+  uint64_t allocations = 0;
+  uint64_t frees       = 0;
+  for(Tracker& tracker : m_trackers)
+  {
+    for(const std::string& category : tracker.tracker->getActiveCategories())
+    {
+      getSeries(m_categories, tracker.name + "/" + category).lastValue =
+          float(tracker.tracker->getStats(category).currentBytes) * kMiB;
+    }
+    const nvvkgltf::GpuMemoryStats total = tracker.tracker->getTotalStats();
+    allocations += total.totalAllocations - std::min(tracker.lastAllocations, total.totalAllocations);
+    frees += total.totalDeallocations - std::min(tracker.lastDeallocations, total.totalDeallocations);
+    tracker.lastAllocations   = total.totalAllocations;
+    tracker.lastDeallocations = total.totalDeallocations;
+  }
+  getSeries(m_rates, "Allocations").lastValue = float(allocations);
+  getSeries(m_rates, "Frees").lastValue       = float(frees);
+
+  if(m_allocator)
+  {
+    const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+    vmaGetMemoryProperties(m_allocator, &memoryProperties);
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS]{};
+    vmaGetHeapBudgets(m_allocator, budgets);
+    for(uint32_t heap = 0; heap < memoryProperties->memoryHeapCount; heap++)
+    {
+      const bool        deviceLocal = (memoryProperties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+      const std::string name        = fmt::format("Heap {}{}", heap, deviceLocal ? " (device)" : "");
+      getSeries(m_heaps, name + " usage").lastValue  = float(budgets[heap].usage) * kMiB;
+      getSeries(m_heaps, name + " budget").lastValue = float(budgets[heap].budget) * kMiB;
+    }
+  }
+
+  for(std::vector<Series>* group : {&m_categories, &m_heaps, &m_rates})
+  {
+    for(Series& series : *group)
+    {
+      addValue(series, series.lastValue);
+      if(m_csv)
+        m_csv << m_frame << ',' << time << ",\"" << series.name << "\"," << series.lastValue << '\n';
+    }
+  }
+  if(m_frames.size() < historyLength)
+    m_frames.push_back(float(m_frame));
+  else
+  {
+    m_frames[m_ringOffset] = float(m_frame);
+    m_ringOffset           = (m_ringOffset + 1) % historyLength;
+  }
+  m_frame++;
+}
+
+void ElementGpuMemory::plotSeries(const char* plotName, const char* unit, const std::vector<Series>& series, bool shaded)
+{
+  if(ImPlot::BeginPlot(plotName, ImVec2(-1, 200)))
+  {
+    ImPlot::SetupAxes("Frame", unit, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+    ImPlot::SetupLegend(ImPlotLocation_NorthWest);
+    const int offset = int(m_ringOffset);
+    for(const Series& s : series)
+    {
+      if(shaded)
+      {
+        ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.3f);
+        ImPlot::PlotShaded(s.name.c_str(), m_frames.data(), s.values.data(), int(m_frames.size()), 0.0, 0, offset);
+      }
+      ImPlot::PlotLine(s.name.c_str(), m_frames.data(), s.values.data(), int(m_frames.size()), 0, offset);
+    }
+    ImPlot::EndPlot();
+  }
+}
+
+void ElementGpuMemory::onUIRender()
+{
+  if(!showWindow)
+    return;
+
+  ImGui::SetNextWindowSize({500, 700}, ImGuiCond_FirstUseEver);
+  if(ImGui::Begin("GPU Memory", &showWindow))
+  {
+    plotSeries("Categories", "MiB", m_categories, true);
+    plotSeries("Heaps", "MiB", m_heaps, false);
+    plotSeries("Per frame", "Count", m_rates, false);
+
+    // Largest live allocations of all the trackers
+    std::vector<std::pair<std::string, nvvkgltf::GpuAllocationRecord>> largest;
+    for(const Tracker& tracker : m_trackers)
+    {
+      for(nvvkgltf::GpuAllocationRecord& record : tracker.tracker->getLargestAllocations(10))
+        largest.push_back({tracker.name, std::move(record)});
+    }
+    std::sort(largest.begin(), largest.end(), [](const auto& a, const auto& b) { return a.second.bytes > b.second.bytes; });
+    largest.resize(std::min<size_t>(largest.size(), 10));
+
+    if(ImGui::BeginTable("Largest", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter))
+    {
+      ImGui::TableSetupColumn("Largest allocations");
+      ImGui::TableSetupColumn("MiB", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+      ImGui::TableHeadersRow();
+      for(const auto& [name, record] : largest)
+      {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%s/%s", name.c_str(), record.category.c_str());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", float(record.bytes) * kMiB);
+      }
+      ImGui::EndTable();
+    }
+  }
+  ImGui::End();
+}
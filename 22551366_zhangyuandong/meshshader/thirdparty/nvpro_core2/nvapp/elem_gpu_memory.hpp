@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <vk_mem_alloc.h>
+
+#include "nvgui/settings_handler.hpp"
+#include "nvvkgltf/gpu_memory_tracker.hpp"  // Header only
+
+#include "application.hpp"
+
+/*-------------------------------------------------------------------------------------------------
+# class nvapp::ElementGpuMemory
+
+>  Live view of the GPU memory, sampled every frame:
+- the usage of each category of the added `nvvkgltf::GpuMemoryTracker`s over time
+- the VMA usage and budget of each memory heap
+- the allocations and frees per frame
+- the largest live allocations
+
+`setCsvOutput` writes the samples to a CSV file, one row per frame and series (`frame,time_s,series,value`),
+which also works in headless runs, e.g. to catch leaks and spikes in soak tests.
+
+```cpp
+auto memory = std::make_shared<nvapp::ElementGpuMemory>(allocator);  // nvvk::ResourceAllocator converts to VmaAllocator
+memory->addTracker("Scene", &sceneVk.getMemoryTracker());
+memory->addTracker("RTX", &sceneRtx.getMemoryTracker());
+app.addElement(memory);
+```
+-------------------------------------------------------------------------------------------------*/
+
+namespace nvapp {
+
+class ElementGpuMemory : public IAppElement
+{
+public:
+  explicit ElementGpuMemory(VmaAllocator allocator, bool show = false);
+  ~ElementGpuMemory() = default;
+
+  // The categories of the tracker are shown as "name/category". The tracker must outlive the element.
+  void addTracker(const std::string& name, const nvvkgltf::GpuMemoryTracker* tracker);
+
+  // Writes the samples of the next frames to `filename`, an empty path closes the file
+  bool setCsvOutput(const std::filesystem::path& filename);
+
+  void onAttach(Application* app) override;
+  void onDetach() override;
+  void onUIMenu() override;
+  void onUIRender() override;
+  void onPreRender() override;  // Samples
+
+  // public on purpose so external parameter parser and UI widgets can modify directly with pointer access
+  bool     showWindow{false};
+  uint32_t historyLength = 1000;  // Samples kept for the plots
+
+private:
+  struct Tracker
+  {
+    std::string                       name;
+    const nvvkgltf::GpuMemoryTracker* tracker = nullptr;
+    uint64_t                          lastAllocations   = 0;
+    uint64_t                          lastDeallocations = 0;
+  };
+
+  // Values over time of a plotted quantity, in a ring buffer of historyLength
+  struct Series
+  {
+    std::string        name;
+    std::vector<float> values;
+    float              lastValue = 0;
+  };
+
+  Series& getSeries(std::vector<Series>& series, const std::string& name);
+  void    addValue(Series& series, float value);
+  void    plotSeries(const char* plotName, const char* unit, const std::vector<Series>& series, bool shaded);
+
+  VmaAllocator         m_allocator = nullptr;
+  std::vector<Tracker> m_trackers;
+
+  std::vector<float>  m_frames;          // X axis of the series
+  std::vector<Series> m_categories;      // MiB per tracker category
+  std::vector<Series> m_heaps;           // MiB used and budget per heap
+  std::vector<Series> m_rates;           // Allocations and frees per frame
+  size_t              m_ringOffset = 0;  // Oldest sample once the history is full
+  uint64_t            m_frame      = 0;
+
+  std::chrono::steady_clock::time_point m_startTime = std::chrono::steady_clock::now();
+  std::ofstream                         m_csv;
+  nvgui::SettingsHandler                m_settingsHandler;
+};
+
+}  // namespace nvapp
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <ctype.h>
 #include <iomanip>
+#include <limits>
 #include <regex>
 
 #include <GLFW/glfw3.h>
@@ -605,7 +606,7 @@ public:
     std::string                                        name;
     std::string                                        comment;
     Filter                                             filter;
-    nvvk::Buffer                                       hostBuffer;
+    nvvk::Buffer                                       hostBuffer;  // the presented slot of `readbackRing`
     uint32_t                                           entryCount{0u};
     bool                                               show{false};
     uint32_t                                           filteredEntries{~0u};
@@ -621,6 +622,12 @@ public:
     std::filesystem::path                              snapshotFileName;
     uint32_t                                           formatSizeInBytes{0u};
     bool                                               breakOnFilterPass{false};
+    // The captures are copied to the ring and presented once their frame completed on the GPU,
+    // so that neither the capture nor the UI wait for the GPU
+    std::vector<nvvk::Buffer>                          readbackRing;
+    std::vector<uint64_t>                              readbackFrames;  // frame of the capture in each slot, 0 if none
+    uint32_t                                           presentedSlot{0u};
+    uint64_t                                           presentedFrame{0u};
   };
 
   void createInspectedBuffer(InspectedBuffer&                                          inspectedBuffer,
@@ -635,6 +642,14 @@ public:
 
   void destroyInspectedBuffer(InspectedBuffer& inspectedBuffer);
 
+  void createReadbackRing(InspectedBuffer& inspectedBuffer, VkDeviceSize sizeInBytes);
+  void destroyReadbackRing(InspectedBuffer& inspectedBuffer);
+  // Destination of a capture recorded in the current frame
+  VkBuffer getReadbackBuffer(InspectedBuffer& inspectedBuffer);
+  // Presents the most recent capture whose frame completed
+  void updateReadback(InspectedBuffer& inspectedBuffer);
+  void updateReadbacks();
+
 
   std::vector<InspectedBuffer> m_inspectedBuffers;
 
@@ -961,14 +976,16 @@ public:
 static void memoryBarrier(VkCommandBuffer cmd)
 {
   VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
-  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  // Host reads of the readback ring happen once the frame completed, without any further wait
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_READ_BIT;
   VkPipelineStageFlags srcStage{};
 
   mb.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
 
   srcStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 
-  vkCmdPipelineBarrier(cmd, srcStage, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+  vkCmdPipelineBarrier(cmd, srcStage, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &mb, 0,
+                       nullptr, 0, nullptr);
 }
 
 static const ImVec4 highlightColor = ImVec4(118.f / 255.f, 185.f / 255.f, 0.f, 1.f);
@@ -1122,6 +1139,8 @@ void imguiCopy(nvapp::Application* app, T& src, const std::vector<T>& existingOr
       copyBuffer.showOnlyDiffToSnapshot = false;
       copyBuffer.name                   = std::move(copyName);
       copyBuffer.hostBuffer             = {};
+      copyBuffer.readbackRing.clear();
+      copyBuffer.readbackFrames.clear();
 
       copies.emplace_back(copyBuffer);
       ImGui::CloseCurrentPopup();
@@ -1342,6 +1361,7 @@ void ElementInspector::onUIRender()
   {
     return;
   }
+  m_internals->updateReadbacks();
 
   m_internals->m_childIndex = 1;
 
@@ -1702,6 +1722,10 @@ void ElementInspectorInternal::imGuiImage(uint32_t imageIndex, ImVec2& imageSize
     {
       ImGui::TextDisabled("%s", img.comment.c_str());
     }
+    if(!img.isCopy)
+    {
+      ImGui::TextDisabled("Captured at frame %llu", (unsigned long long)img.presentedFrame);
+    }
     ImGui::SameLine();
     if(ImGui::Button(img.tableView ? "Image view" : "Table view"))
     {
@@ -1985,6 +2009,7 @@ void ElementInspectorInternal::imGuiBuffer(InspectedBuffer& buf,
 
     if(!buf.isCopy)
     {
+      ImGui::TextDisabled("Captured at frame %llu", (unsigned long long)buf.presentedFrame);
       ImGui::BeginDisabled(!buf.hasSnapshotContents);
       imguiPushActiveButtonStyle(buf.showSnapshot);
       if(ImGui::Button(fmt::format("Show snapshot values##Buffer{}", buf.name).c_str()))
@@ -2498,8 +2523,7 @@ void ElementInspectorInternal::createInspectedBuffer(InspectedBuffer&   inspecte
   inspectedBuffer.formatSizeInBytes = computeFormatSizeInBytes(format);
   uint32_t sizeInBytes              = inspectedBuffer.formatSizeInBytes * entryCount;
 
-  m_alloc->createBuffer(inspectedBuffer.hostBuffer, sizeInBytes, VK_BUFFER_USAGE_2_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
-                        VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+  createReadbackRing(inspectedBuffer, sizeInBytes);
   inspectedBuffer.format      = format;
   inspectedBuffer.entryCount  = entryCount;
   inspectedBuffer.isAllocated = true;
@@ -2521,12 +2545,142 @@ void ElementInspectorInternal::createInspectedBuffer(InspectedBuffer&   inspecte
 
 void ElementInspectorInternal::destroyInspectedBuffer(InspectedBuffer& inspectedBuffer)
 {
-  m_alloc->destroyBuffer(inspectedBuffer.hostBuffer);
+  destroyReadbackRing(inspectedBuffer);
   inspectedBuffer.entryCount  = 0u;
   inspectedBuffer.isAllocated = false;
   inspectedBuffer.filter.destroy();
 }
 
+void ElementInspectorInternal::createReadbackRing(InspectedBuffer& inspectedBuffer, VkDeviceSize sizeInBytes)
+{
+  // One slot per frame in flight, plus the presented one
+  const uint32_t ringSize = m_app ? m_app->getFrameCycleSize() + 1 : 2;
+
+  inspectedBuffer.readbackRing.resize(ringSize);
+  inspectedBuffer.readbackFrames.assign(ringSize, 0);
+  for(nvvk::Buffer& buffer : inspectedBuffer.readbackRing)
+  {
+    m_alloc->createBuffer(buffer, sizeInBytes, VK_BUFFER_USAGE_2_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                          VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+  }
+  inspectedBuffer.presentedSlot  = 0u;
+  inspectedBuffer.presentedFrame = 0u;
+  inspectedBuffer.hostBuffer     = inspectedBuffer.readbackRing[0];
+}
+
+void ElementInspectorInternal::destroyReadbackRing(InspectedBuffer& inspectedBuffer)
+{
+  for(nvvk::Buffer& buffer : inspectedBuffer.readbackRing)
+  {
+    m_alloc->destroyBuffer(buffer);
+  }
+  inspectedBuffer.readbackRing.clear();
+  inspectedBuffer.readbackFrames.clear();
+  inspectedBuffer.hostBuffer     = {};
+  inspectedBuffer.presentedFrame = 0u;
+  inspectedBuffer.isInspected    = false;
+}
+
+VkBuffer ElementInspectorInternal::getReadbackBuffer(InspectedBuffer& inspectedBuffer)
+{
+  const nvvk::SemaphoreInfo frame = m_app->getFrameSignalSemaphore();
+
+  // Several captures in the same frame go to the same slot, the last one wins
+  uint32_t slot = ~0u;
+  for(uint32_t i = 0; i < uint32_t(inspectedBuffer.readbackRing.size()); i++)
+  {
+    if(inspectedBuffer.readbackFrames[i] == frame.value)
+    {
+      slot = i;
+    }
+  }
+  // Otherwise the slot of the oldest capture, which is not presented
+  if(slot == ~0u)
+  {
+    for(uint32_t i = 0; i < uint32_t(inspectedBuffer.readbackRing.size()); i++)
+    {
+      if(i != inspectedBuffer.presentedSlot
+         && (slot == ~0u || inspectedBuffer.readbackFrames[i] < inspectedBuffer.readbackFrames[slot]))
+      {
+        slot = i;
+      }
+    }
+    // That slot is still being copied to only if the application has more frames in flight than the ring
+    // was sized for
+    uint64_t completed{};
+    vkGetSemaphoreCounterValue(m_device, frame.semaphore, &completed);
+    if(completed < inspectedBuffer.readbackFrames[slot])
+    {
+      const VkSemaphoreWaitInfo waitInfo = {
+          .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+          .semaphoreCount = 1,
+          .pSemaphores    = &frame.semaphore,
+          .pValues        = &inspectedBuffer.readbackFrames[slot],
+      };
+      NVVK_CHECK(vkWaitSemaphores(m_device, &waitInfo, std::numeric_limits<uint64_t>::max()));
+    }
+  }
+
+  inspectedBuffer.readbackFrames[slot] = frame.value;
+  return inspectedBuffer.readbackRing[slot].buffer;
+}
+
+void ElementInspectorInternal::updateReadback(InspectedBuffer& inspectedBuffer)
+{
+  if(inspectedBuffer.readbackRing.empty())
+  {
+    return;
+  }
+
+  uint64_t completed{};
+  vkGetSemaphoreCounterValue(m_device, m_app->getFrameSignalSemaphore().semaphore, &completed);
+
+  uint32_t slot = ~0u;
+  for(uint32_t i = 0; i < uint32_t(inspectedBuffer.readbackRing.size()); i++)
+  {
+    const uint64_t frame = inspectedBuffer.readbackFrames[i];
+    if(frame != 0 && frame <= completed && frame > inspectedBuffer.presentedFrame
+       && (slot == ~0u || frame > inspectedBuffer.readbackFrames[slot]))
+    {
+      slot = i;
+    }
+  }
+  if(slot == ~0u)
+  {
+    return;
+  }
+
+  inspectedBuffer.presentedSlot   = slot;
+  inspectedBuffer.presentedFrame  = inspectedBuffer.readbackFrames[slot];
+  inspectedBuffer.hostBuffer      = inspectedBuffer.readbackRing[slot];
+  inspectedBuffer.isInspected     = true;
+  inspectedBuffer.filteredEntries = ~0u;
+}
+
+void ElementInspectorInternal::updateReadbacks()
+{
+  for(auto& element : m_inspectedImages)
+  {
+    updateReadback(element);
+  }
+  for(auto& element : m_inspectedBuffers)
+  {
+    updateReadback(element);
+  }
+  for(auto& element : m_inspectedComputeVariables)
+  {
+    updateReadback(element);
+  }
+  for(auto& element : m_inspectedCustomVariables)
+  {
+    updateReadback(element);
+  }
+  for(auto& element : m_inspectedFragmentVariables)
+  {
+    updateReadback(element);
+  }
+}
+
 
 uint32_t getCapturedBlockIndex(uint32_t absoluteBlockIndex, const glm::uvec3& gridSize, const glm::uvec3& minBlock, const glm::uvec3& maxBlock)
 {
@@ -3541,7 +3695,7 @@ void ElementInspectorInternal::initImageInspection(uint32_t index, const Element
   {
     inspectedImage.isAllocated = false;
     m_alloc->destroyImage(inspectedImage.image);
-    m_alloc->destroyBuffer(inspectedImage.hostBuffer);
+    destroyReadbackRing(inspectedImage);
     vkDestroyImageView(m_device, inspectedImage.view, nullptr);
   }
 
@@ -3713,11 +3867,11 @@ void ElementInspectorInternal::inspectImage(VkCommandBuffer cmd, uint32_t index,
   bcpy.imageSubresource.layerCount = 1;
 
   vkCmdCopyImageToBuffer(cmd, internalImg.image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                         internalImg.hostBuffer.buffer, 1, &bcpy);
+                         getReadbackBuffer(internalImg), 1, &bcpy);
+  memoryBarrier(cmd);
 
   nvvk::cmdImageMemoryBarrier(cmd, {internalImg.image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
-  internalImg.isInspected = true;
 }
 
 
@@ -3908,9 +4062,8 @@ void ElementInspectorInternal::inspectBuffer(VkCommandBuffer cmd, uint32_t index
   bcpy.size      = entrySize * internalBuffer.entryCount;
   bcpy.srcOffset = entrySize * internalBuffer.offsetInEntries;
   memoryBarrier(cmd);
-  vkCmdCopyBuffer(cmd, internalBuffer.sourceBuffer, internalBuffer.hostBuffer.buffer, 1, &bcpy);
+  vkCmdCopyBuffer(cmd, internalBuffer.sourceBuffer, getReadbackBuffer(internalBuffer), 1, &bcpy);
   memoryBarrier(cmd);
-  internalBuffer.isInspected = true;
 }
 
 
@@ -4008,7 +4161,7 @@ void ElementInspectorInternal::initComputeInspection(uint32_t index, const Eleme
   if(var.deviceBuffer.buffer)
   {
     m_alloc->destroyBuffer(var.deviceBuffer);
-    m_alloc->destroyBuffer(var.hostBuffer);
+    destroyReadbackRing(var);
     m_alloc->destroyBuffer(var.metadata);
   }
 
@@ -4105,10 +4258,9 @@ void ElementInspectorInternal::inspectComputeVariables(VkCommandBuffer cmd, uint
 
   memoryBarrier(cmd);
 
-  vkCmdCopyBuffer(cmd, var.deviceBuffer.buffer, var.hostBuffer.buffer, 1, &bcpy);
+  vkCmdCopyBuffer(cmd, var.deviceBuffer.buffer, getReadbackBuffer(var), 1, &bcpy);
 
   memoryBarrier(cmd);
-  var.isInspected = true;
 }
 
 bool ElementInspector::updateComputeFormat(uint32_t index, const std::vector<ValueFormat>& newFormat)
@@ -4189,7 +4341,7 @@ void ElementInspectorInternal::initCustomInspection(uint32_t index, const Elemen
   if(var.deviceBuffer.buffer)
   {
     m_alloc->destroyBuffer(var.deviceBuffer);
-    m_alloc->destroyBuffer(var.hostBuffer);
+    destroyReadbackRing(var);
     m_alloc->destroyBuffer(var.metadata);
   }
 
@@ -4277,11 +4429,9 @@ void ElementInspectorInternal::inspectCustomVariables(VkCommandBuffer cmd, uint3
   bcpy.size           = entryCount * var.u32PerThread * sizeof(uint32_t);
   memoryBarrier(cmd);
 
-  vkCmdCopyBuffer(cmd, var.deviceBuffer.buffer, var.hostBuffer.buffer, 1, &bcpy);
+  vkCmdCopyBuffer(cmd, var.deviceBuffer.buffer, getReadbackBuffer(var), 1, &bcpy);
 
   memoryBarrier(cmd);
-
-  var.isInspected = true;
 }
 
 bool ElementInspector::updateCustomFormat(uint32_t index, const std::vector<ValueFormat>& newFormat)
@@ -4356,7 +4506,7 @@ void ElementInspectorInternal::initFragmentInspection(uint32_t index, const Elem
   if(var.deviceBuffer.buffer)
   {
     m_alloc->destroyBuffer(var.deviceBuffer);
-    m_alloc->destroyBuffer(var.hostBuffer);
+    destroyReadbackRing(var);
     m_alloc->destroyBuffer(var.metadata);
   }
 
@@ -4490,12 +4640,11 @@ void ElementInspectorInternal::inspectFragmentVariables(VkCommandBuffer cmd, uin
 
   memoryBarrier(cmd);
 
-  vkCmdCopyBuffer(cmd, var.deviceBuffer.buffer, var.hostBuffer.buffer, 1, &bcpy);
+  vkCmdCopyBuffer(cmd, var.deviceBuffer.buffer, getReadbackBuffer(var), 1, &bcpy);
 
   memoryBarrier(cmd);
 
-  var.isInspected = true;
-  var.isCleared   = false;
+  var.isCleared = false;
 }
 
 void ElementInspector::updateMinMaxFragmentInspection(VkCommandBuffer cmd, uint32_t index, const glm::uvec2& minFragment, const glm::uvec2& maxFragment)
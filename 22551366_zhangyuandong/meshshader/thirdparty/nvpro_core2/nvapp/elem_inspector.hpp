@@ -39,6 +39,10 @@
   IMPORTANT NOTE: if used in a multi threaded environment synchronization needs to be performed
   externally by the application. 
 
+  The captures are read back asynchronously: the copies recorded in a frame are displayed once
+  that frame completed on the GPU, typically one or two frames later, and neither the capture
+  nor the UI waits for the GPU. The frame of the displayed values is shown next to them.
+
  Basic usage:
  ------------------------------------------------------------------------------------------------
  ###                 INITIALIZATION
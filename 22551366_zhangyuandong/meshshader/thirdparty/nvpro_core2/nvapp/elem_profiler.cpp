@@ -19,6 +19,7 @@
 
 #include <nvgui/fonts.hpp>
 #include <nvvk/debug_util.hpp>
+#include <nvutils/file_operations.hpp>
 #include <nvutils/logger.hpp>
 
 #include "elem_profiler.hpp"
@@ -57,6 +58,12 @@ void ElementProfiler::addView(std::shared_ptr<ViewSettings> state)
   m_views.push_back({.state = std::move(state)});
 }
 
+void ElementProfiler::captureTrace(uint32_t frameCount, const std::filesystem::path& filename)
+{
+  m_profiler->beginTraceCapture(frameCount);
+  m_traceFilename = filename;
+}
+
 void ElementProfiler::onUIMenu()
 {
   if(ImGui::BeginMenu("View"))
@@ -82,6 +89,16 @@ void ElementProfiler::onUIRender()
     showWindow &= view.state->show;
   }
 
+  // saving the trace once all the frames are captured
+  if(!m_traceFilename.empty() && !m_profiler->isTraceCapturing())
+  {
+    if(m_profiler->saveTraceJson(m_traceFilename))
+    {
+      LOGI("Profiler trace written to %s\n", nvutils::utf8FromPath(m_traceFilename).c_str());
+    }
+    m_traceFilename.clear();
+  }
+
   // collecting data if needed
   if(s_timeElapsed >= deltaTime)
   {
@@ -125,6 +142,12 @@ void ElementProfiler::onUIRender()
           renderPieChart(view);
           ImGui::EndTabItem();
         }
+        if(ImGui::BeginTabItem("Histogram", NULL,
+                               view.selectDefaultTab && view.state->defaultTab == HISTOGRAM ? ImGuiTabItemFlags_SetSelected : 0))
+        {
+          renderHistogram(view);
+          ImGui::EndTabItem();
+        }
         ImGui::EndTabBar();
       }
 
@@ -242,6 +265,10 @@ void ElementProfiler::displayTableNode(const EntryNode& node, bool detailed, uin
     drawValue(info.gpu.absMinValue);
     ImGui::TableNextColumn();
     drawValue(info.gpu.absMaxValue);
+    ImGui::TableNextColumn();
+    drawValue(info.gpu.p95);
+    ImGui::TableNextColumn();
+    drawValue(info.gpu.p99);
   }
   ImGui::TableNextColumn();
   drawValue(info.cpu.average);
@@ -253,6 +280,10 @@ void ElementProfiler::displayTableNode(const EntryNode& node, bool detailed, uin
     drawValue(info.cpu.absMinValue);
     ImGui::TableNextColumn();
     drawValue(info.cpu.absMaxValue);
+    ImGui::TableNextColumn();
+    drawValue(info.cpu.p95);
+    ImGui::TableNextColumn();
+    drawValue(info.cpu.p99);
   }
   ImGui::PopFont();
 
@@ -284,6 +315,43 @@ void ElementProfiler::drawVsyncCheckbox()
 
   if(changed)
     m_app->setVsync(vsync);
+
+  // Frame cost predicted by the pacer, and how far the frames are from it
+  const FramePacer& pacer = m_app->getFramePacer();
+  if(vsync && !m_app->isLowLatency() && pacer.getPredictedFrameTime() > 0.0)
+  {
+    ImGui::SameLine();
+    ImGui::TextDisabled("Pacing: %.2f ms predicted, %.2f ms error", pacer.getPredictedFrameTime() * 1000.0,
+                        pacer.getPredictionError() * 1000.0);
+    if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+      ImGui::SetTooltip("Predicted CPU recording plus GPU time of the next frame, and average prediction error.\n"
+                        "The frame pacer slept %.2f ms before the last frame.",
+                        pacer.getSleepTime() * 1000.0);
+  }
+}
+
+void ElementProfiler::drawTraceCapture()
+{
+  if(m_traceFilename.empty())
+  {
+    if(ImGui::Button(ICON_MS_FIBER_MANUAL_RECORD " Trace"))
+    {
+      captureTrace(m_traceFrameCount, nvutils::getExecutablePath().replace_extension(".trace.json"));
+    }
+    if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+      ImGui::SetTooltip("Capture the CPU and GPU sections of the next %u frames as a Chrome trace\n"
+                        "(chrome://tracing or ui.perfetto.dev), next to the executable",
+                        m_traceFrameCount);
+  }
+  else
+  {
+    if(ImGui::Button(ICON_MS_STOP " Trace"))
+    {
+      m_profiler->endTraceCapture();
+    }
+    if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
+      ImGui::SetTooltip("Stop the capture and save it");
+  }
 }
 
 void ElementProfiler::renderTable(View& view)
@@ -295,6 +363,9 @@ void ElementProfiler::renderTable(View& view)
   ImGui::SameLine();
   ImGui::Checkbox("detailed", &view.state->table.detailed);
 
+  ImGui::SameLine();
+  drawTraceCapture();
+
   // Copy content
   ImGui::SameLine(ImGui::GetWindowContentRegionMax().x - 38);
   if(ImGui::Button(ICON_MS_CONTENT_COPY))
@@ -305,7 +376,7 @@ void ElementProfiler::renderTable(View& view)
   if(ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort))
     ImGui::SetTooltip("Copy data to clipboard");
 
-  const int minGridSize = view.state->table.detailed ? 1500 : 550;  // minimum size of container for responsive grid mode
+  const int minGridSize = view.state->table.detailed ? 2000 : 550;  // minimum size of container for responsive grid mode
   const bool  gridMode = ImGui::GetContentRegionAvail().x >= minGridSize && m_frameNodes.size() > 1;
   const float width    = ImGui::GetContentRegionAvail().x / (gridMode ? 2.0f : 1.0f) - 5.0f;
 
@@ -322,9 +393,10 @@ void ElementProfiler::renderTable(View& view)
         ImGui::Spacing();  // add a small vertical gap between tables, for better legibility
     }
 
+    ImGui::BeginGroup();  // the timers and counters of a timeline stay together in grid mode
     if(!m_frameNodes[i].child.empty() || m_singleNodes[i].child.empty())
     {
-      int colCount = view.state->table.detailed ? 9 : 3;
+      int colCount = view.state->table.detailed ? 13 : 3;
 
       if(ImGui::BeginTable("EntryTable", colCount, tableFlags, ImVec2(width, 0)))
       {
@@ -336,6 +408,8 @@ void ElementProfiler::renderTable(View& view)
           ImGui::TableSetupColumn("GPU last", ImGuiTableColumnFlags_WidthStretch);
           ImGui::TableSetupColumn("GPU min", ImGuiTableColumnFlags_WidthStretch);
           ImGui::TableSetupColumn("GPU max", ImGuiTableColumnFlags_WidthStretch);
+          ImGui::TableSetupColumn("GPU p95", ImGuiTableColumnFlags_WidthStretch);
+          ImGui::TableSetupColumn("GPU p99", ImGuiTableColumnFlags_WidthStretch);
         }
         ImGui::TableSetupColumn("CPU avg", ImGuiTableColumnFlags_WidthStretch);
         if(view.state->table.detailed)
@@ -343,6 +417,8 @@ void ElementProfiler::renderTable(View& view)
           ImGui::TableSetupColumn("CPU last", ImGuiTableColumnFlags_WidthStretch);
           ImGui::TableSetupColumn("CPU min", ImGuiTableColumnFlags_WidthStretch);
           ImGui::TableSetupColumn("CPU max", ImGuiTableColumnFlags_WidthStretch);
+          ImGui::TableSetupColumn("CPU p95", ImGuiTableColumnFlags_WidthStretch);
+          ImGui::TableSetupColumn("CPU p99", ImGuiTableColumnFlags_WidthStretch);
         }
         ImGui::TableHeadersRow();
 
@@ -359,6 +435,47 @@ void ElementProfiler::renderTable(View& view)
         ImGui::EndTable();
       }
     }
+
+    // counters set on the timeline, e.g. by nvvk::GpuCounters
+    const nvutils::ProfilerTimeline::Snapshot* snapshot = i < m_frameSnapshots.size() ? &m_frameSnapshots[i] : nullptr;
+    if(snapshot && !snapshot->counterNames.empty())
+    {
+      ImGui::Spacing();
+      if(ImGui::BeginTable("CounterTable", view.state->table.detailed ? 5 : 2, tableFlags, ImVec2(width, 0)))
+      {
+        ImGui::TableSetupColumn("Counters", ImGuiTableColumnFlags_NoHide | ImGuiTableColumnFlags_WidthFixed, 250.);
+        ImGui::TableSetupColumn("avg", ImGuiTableColumnFlags_WidthStretch);
+        if(view.state->table.detailed)
+        {
+          ImGui::TableSetupColumn("last", ImGuiTableColumnFlags_WidthStretch);
+          ImGui::TableSetupColumn("min", ImGuiTableColumnFlags_WidthStretch);
+          ImGui::TableSetupColumn("max", ImGuiTableColumnFlags_WidthStretch);
+        }
+        ImGui::TableHeadersRow();
+
+        for(size_t c = 0; c < snapshot->counterNames.size(); c++)
+        {
+          const nvutils::ProfilerTimeline::Snapshot::CounterInfo& info = snapshot->counterInfos[c];
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(snapshot->counterNames[c].c_str());
+          ImGui::TableNextColumn();
+          ImGui::Text("%.1f", info.average);
+          if(view.state->table.detailed)
+          {
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", info.last);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", info.absMinValue);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", info.absMaxValue);
+          }
+        }
+
+        ImGui::EndTable();
+      }
+    }
+    ImGui::EndGroup();
   }
   if(copy)
   {
@@ -697,6 +814,98 @@ void ElementProfiler::renderLineChart(View& view)
   }
 }
 
+// Times of the averaging window in milliseconds, oldest first
+static std::vector<double> getWindowTimes(const nvutils::ProfilerTimeline::TimerInfo& info, bool cpuTimes)
+{
+  const nvutils::ProfilerTimeline::TimerStats& stats = cpuTimes ? info.cpu : info.gpu;
+
+  const uint32_t      count = std::min(info.numAveraged, nvutils::ProfilerTimeline::MAX_LAST_FRAMES);
+  std::vector<double> times(count);
+  for(uint32_t j = 0; j < count; j++)
+  {
+    uint32_t index = (stats.index - count + j) % nvutils::ProfilerTimeline::MAX_LAST_FRAMES;
+    times[j]       = stats.times[index] / 1000.0;
+  }
+  return times;
+}
+
+//
+void ElementProfiler::renderHistogram(View& view)
+{
+  const bool  gridMode = ImGui::GetContentRegionAvail().x >= 600 && m_frameNodes.size() > 1;
+  const float width    = ImGui::GetContentRegionAvail().x / (gridMode ? 2.0f : 1.0f) - 5.0f;
+
+  drawVsyncCheckbox();
+  ImGui::SameLine();
+  ImGui::Checkbox("CPU times", &view.state->histogram.cpuTimes);
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(100.0f);
+  ImGui::SliderInt("Bins", &view.state->histogram.bins, 4, 128);
+
+  const bool cpuTimes = view.state->histogram.cpuTimes;
+
+  for(auto i = 0; i < m_frameNodes.size(); ++i)
+  {
+    const auto& rootNode = m_frameNodes[i];
+
+    // each root node is a timeline, its first node the frame
+    if(rootNode.child.empty())
+      continue;
+
+    const auto&                                  node  = rootNode.child[0];
+    const nvutils::ProfilerTimeline::TimerStats& stats = cpuTimes ? node.timerInfo.cpu : node.timerInfo.gpu;
+
+    const std::vector<double> frameTimes = getWindowTimes(node.timerInfo, cpuTimes);
+    if(frameTimes.empty())
+      continue;
+
+    if(gridMode && i % 2 != 0)
+      ImGui::SameLine();
+
+    ImGui::BeginGroup();
+    ImGui::PushFont(nvgui::getMonospaceFont());
+    ImGui::Text("%s p50 %.3f  p95 %.3f  p99 %.3f  max %.3f ms", node.name.c_str(), stats.p50 / 1000.0,
+                stats.p95 / 1000.0, stats.p99 / 1000.0, stats.windowMax / 1000.0);
+    ImGui::PopFont();
+
+    // use different color palette for better legibility
+    if(i % 3 == 0)
+      ImPlot::PushColormap(ImPlotColormap_Deep);
+    if(i % 3 == 1)
+      ImPlot::PushColormap(ImPlotColormap_Pastel);
+    if(i % 3 == 2)
+      ImPlot::PushColormap(ImPlotColormap_Viridis);
+
+    if(ImPlot::BeginPlot(rootNode.name.c_str(), ImVec2(width, (float)view.state->plotHeight), ImPlotFlags_NoMouseText))
+    {
+      ImPlot::SetupLegend(ImPlotLocation_NorthEast, ImPlotLegendFlags_Outside);
+      ImPlot::SetupAxes("Time in milliseconds", "Frames", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+
+      // the frame and its sections, a section can be hidden by clicking on the legend
+      ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.5f);
+      ImPlot::PlotHistogram(node.name.c_str(), frameTimes.data(), int(frameTimes.size()), view.state->histogram.bins);
+      for(const auto& child : node.child)
+      {
+        const std::vector<double> childTimes = getWindowTimes(child.timerInfo, cpuTimes);
+        if(!childTimes.empty())
+        {
+          ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.5f);
+          ImPlot::PlotHistogram(child.name.c_str(), childTimes.data(), int(childTimes.size()), view.state->histogram.bins);
+        }
+      }
+
+      // percentiles of the frame
+      const double percentiles[] = {stats.p50 / 1000.0, stats.p95 / 1000.0, stats.p99 / 1000.0};
+      ImPlot::PlotInfLines("p50 / p95 / p99", percentiles, 3);
+
+      ImPlot::EndPlot();
+    }
+
+    ImPlot::PopColormap();
+    ImGui::EndGroup();
+  }
+}
+
 void ElementProfiler::addSettingsHandler()
 {
 
@@ -35,7 +35,8 @@ public:
     TABLE,
     BAR_CHART,
     PIE_CHART,
-    LINE_CHART
+    LINE_CHART,
+    HISTOGRAM
   } TabId;
 
   struct ViewSettings
@@ -46,7 +47,7 @@ public:
     int               plotHeight = 250;         // height common to all plots
     struct
     {
-      bool     detailed = false;  // draw detailed timers avg, min, max, last
+      bool     detailed = false;  // draw detailed timers avg, min, max, last, p95, p99
       uint32_t levels   = ~0u;    // number of levels to open first
     } table;                      // table settings
     struct
@@ -64,6 +65,11 @@ public:
       bool gpuLines = true;  // draw GPU timers as lines
       bool gpuFills = true;  // draw GPU timers as filled areas
     } lineChart;             // lineChart settings
+    struct
+    {
+      bool cpuTimes = false;  // distribution of the CPU times instead of the GPU times
+      int  bins     = 32;     // number of bins of the histograms
+    } histogram;              // histogram settings
   };
 
 private:
@@ -87,6 +93,10 @@ public:
   // add a new view, view name in the state parameter must be unique
   void addView(std::shared_ptr<ViewSettings> state);
 
+  // Records a trace of the next `frameCount` frames (`nvutils::ProfilerManager::beginTraceCapture`),
+  // saved as Chrome trace JSON to `filename` once complete
+  void captureTrace(uint32_t frameCount, const std::filesystem::path& filename);
+
   void onAttach(Application* app) override;
 
   // void onDetach() override {}
@@ -139,18 +149,28 @@ private:
   // Rendering the data as a cumulated line chart
   void renderLineChart(View& view);
 
+  // Rendering the distribution of the frame times over the averaging window,
+  // with the p50, p95 and p99 percentiles
+  void renderHistogram(View& view);
+
   // Save/read to/from the .ini file to remember the state of the view windows [open/close]
   void addSettingsHandler();
 
   // draw v-sync toggle
   void drawVsyncCheckbox(void);
 
+  // draw the trace capture button, and save the capture once complete
+  void drawTraceCapture(void);
+
   Application*              m_app{nullptr};
   nvutils::ProfilerManager* m_profiler = nullptr;
   std::vector<View>         m_views;
   std::vector<EntryNode>    m_frameNodes;
   std::vector<EntryNode>    m_singleNodes;
 
+  uint32_t              m_traceFrameCount = 120;
+  std::filesystem::path m_traceFilename;  // pending capture when not empty
+
   std::vector<nvutils::ProfilerTimeline::Snapshot> m_frameSnapshots;
   std::vector<nvutils::ProfilerTimeline::Snapshot> m_singleSnapshots;
 };
@@ -30,6 +30,7 @@
 #include <timeapi.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <limits>
@@ -71,6 +72,38 @@ double getMonitorsMinRefreshRate()
   return refreshRate;
 }
 
+// Margin kept between the predicted frame cost and the refresh interval
+constexpr double k_predictionMargin = 0.5e-3;
+
+void FramePacer::addFrameTimes(double cpuTime, double gpuTime)
+{
+  // The recording and the execution of a frame are serialized, the frame
+  // needs both before it can be presented.
+  const double frameTime = cpuTime + gpuTime;
+  if(m_historyCount > 0)
+  {
+    const double error = std::abs(frameTime - m_predictedTime);
+    m_predictionError  = m_predictionError + (error - m_predictionError) * 0.1;
+  }
+
+  m_history[m_historyNext] = frameTime;
+  m_historyNext            = (m_historyNext + 1) % k_historySize;
+  m_historyCount           = std::min(m_historyCount + 1, k_historySize);
+
+  // Mean plus two standard deviations: frames with a varying cost get a
+  // larger budget, so the spikes still fit.
+  double sum        = 0.0;
+  double sumSquares = 0.0;
+  for(size_t i = 0; i < m_historyCount; i++)
+  {
+    sum += m_history[i];
+    sumSquares += m_history[i] * m_history[i];
+  }
+  const double mean     = sum / double(m_historyCount);
+  const double variance = std::max(0.0, sumSquares / double(m_historyCount) - mean * mean);
+  m_predictedTime       = mean + 2.0 * std::sqrt(variance);
+}
+
 void FramePacer::pace(double refreshRate)
 {
   const double refreshInterval = 1.0 / refreshRate;
@@ -81,12 +114,20 @@ void FramePacer::pace(double refreshRate)
   // will be counted in the CPU time.
   const double cpuTime   = m_cpuTimer.getSeconds();
   double       sleepTime = refreshInterval - cpuTime;
+
+  // Don't sleep past the point where the predicted frame no longer fits
+  // in the interval.
+  if(m_historyCount > 0)
+  {
+    sleepTime = std::min(sleepTime, refreshInterval - m_predictedTime - k_predictionMargin);
+  }
 #ifdef _WIN32
   // On Windows, we know that 1ms is just about the right time to subtract;
   // it's just under the average amount that Windows adds to the sleep call.
   // On Linux the timers are accurate enough that we don't need this.
   sleepTime -= 1e-3;
 #endif
+  m_sleepTime = std::max(sleepTime, 0.0);
   if(sleepTime > 0.0)
   {
     // Reuse the timer to measure how long sleeps actually take.
@@ -17,6 +17,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <array>
+
 #include <nvutils/timers.hpp>
 namespace nvapp {
 
@@ -32,15 +34,36 @@ double getMonitorsMinRefreshRate();
 // For now, we aim for an easier goal: submit a frame once VSync. Since the
 // compositor consumes one frame per VSync, we should render at most one frame
 // per VSync; any faster and we'd get swapchain backpressure and thus latency.
+//
+// When the measured frame times are provided, the pacer predicts the cost of
+// the next frame from the recent ones and shortens the sleep so that the frame
+// still fits in the refresh interval, instead of missing the VSync.
 class FramePacer
 {
 public:
   // Call this just before glfwPollEvents() to sleep.
   void pace(double refreshRate = getMonitorsMinRefreshRate());
 
+  // Measured times of a completed frame, in seconds
+  void addFrameTimes(double cpuTime, double gpuTime);
+
+  double getPredictedFrameTime() const { return m_predictedTime; }  // Cost expected for the next frame, in seconds
+  double getPredictionError() const { return m_predictionError; }   // Average of the absolute errors, in seconds
+  double getSleepTime() const { return m_sleepTime; }               // Last sleep, in seconds
+
 private:
+  static constexpr size_t k_historySize = 32;
+
   // System state
   nvutils::PerformanceTimer m_cpuTimer;
+
+  // Frame cost prediction
+  std::array<double, k_historySize> m_history{};  // CPU recording plus GPU execution of the recent frames
+  size_t                            m_historyCount{0};
+  size_t                            m_historyNext{0};
+  double                            m_predictedTime{0.0};
+  double                            m_predictionError{0.0};
+  double                            m_sleepTime{0.0};
 };
 
 }  // namespace nvapp
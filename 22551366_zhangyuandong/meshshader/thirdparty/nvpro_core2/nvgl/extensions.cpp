@@ -56,6 +56,7 @@ int has_GL_EXT_semaphore_fd = 0;
 int has_GL_EXT_semaphore_win32 = 0;
 int has_GL_EXT_texture_compression_latc = 0;
 int has_GL_EXT_texture_compression_s3tc = 0;
+int has_GL_KHR_parallel_shader_compile = 0;
 int has_GL_NV_bindless_texture = 0;
 int has_GL_NV_blend_equation_advanced = 0;
 int has_GL_NV_clip_space_w_scaling = 0;
@@ -161,6 +162,7 @@ void load_GL(nvGLLoaderGetProcFN fnGetProcAddress)
   has_GL_EXT_semaphore_win32 = load_GL_EXT_semaphore_win32(fnGetProcAddress);
   has_GL_EXT_texture_compression_latc = load_GL_EXT_texture_compression_latc(fnGetProcAddress);
   has_GL_EXT_texture_compression_s3tc = load_GL_EXT_texture_compression_s3tc(fnGetProcAddress);
+  has_GL_KHR_parallel_shader_compile = load_GL_KHR_parallel_shader_compile(fnGetProcAddress);
   has_GL_NV_bindless_texture = load_GL_NV_bindless_texture(fnGetProcAddress);
   has_GL_NV_blend_equation_advanced = load_GL_NV_blend_equation_advanced(fnGetProcAddress);
   has_GL_NV_clip_space_w_scaling = load_GL_NV_clip_space_w_scaling(fnGetProcAddress);
@@ -5817,6 +5819,25 @@ int load_GL_EXT_texture_compression_s3tc(nvGLLoaderGetProcFN fnGetProcAddress)
   return success;
 }
 
+/* /////////////////////////////////// */
+/* GL_KHR_parallel_shader_compile */
+
+static PFNGLMAXSHADERCOMPILERTHREADSKHRPROC pfn_glMaxShaderCompilerThreadsKHR = 0;
+
+GLAPI void APIENTRY glMaxShaderCompilerThreadsKHR(GLuint count)
+{
+  assert(pfn_glMaxShaderCompilerThreadsKHR);
+  pfn_glMaxShaderCompilerThreadsKHR(count);
+}
+
+int load_GL_KHR_parallel_shader_compile(nvGLLoaderGetProcFN fnGetProcAddress)
+{
+  pfn_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)fnGetProcAddress("glMaxShaderCompilerThreadsKHR");
+  int success = has_extension("GL_KHR_parallel_shader_compile");
+  success = success && (pfn_glMaxShaderCompilerThreadsKHR != 0);
+  return success;
+}
+
 /* /////////////////////////////////// */
 /* GL_NV_bindless_texture */
 
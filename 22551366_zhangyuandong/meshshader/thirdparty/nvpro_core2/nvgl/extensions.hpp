@@ -190,6 +190,7 @@ extern int has_GL_EXT_semaphore_fd;
 extern int has_GL_EXT_semaphore_win32;
 extern int has_GL_EXT_texture_compression_latc;
 extern int has_GL_EXT_texture_compression_s3tc;
+extern int has_GL_KHR_parallel_shader_compile;
 extern int has_GL_NV_bindless_texture;
 extern int has_GL_NV_blend_equation_advanced;
 extern int has_GL_NV_clip_space_w_scaling;
@@ -267,6 +268,7 @@ int load_GL_EXT_semaphore_fd(nvGLLoaderGetProcFN fnGetProcAddress);
 int load_GL_EXT_semaphore_win32(nvGLLoaderGetProcFN fnGetProcAddress);
 int load_GL_EXT_texture_compression_latc(nvGLLoaderGetProcFN fnGetProcAddress);
 int load_GL_EXT_texture_compression_s3tc(nvGLLoaderGetProcFN fnGetProcAddress);
+int load_GL_KHR_parallel_shader_compile(nvGLLoaderGetProcFN fnGetProcAddress);
 int load_GL_NV_bindless_texture(nvGLLoaderGetProcFN fnGetProcAddress);
 int load_GL_NV_blend_equation_advanced(nvGLLoaderGetProcFN fnGetProcAddress);
 int load_GL_NV_clip_space_w_scaling(nvGLLoaderGetProcFN fnGetProcAddress);
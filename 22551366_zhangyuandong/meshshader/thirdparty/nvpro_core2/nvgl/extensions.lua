@@ -52,6 +52,7 @@ GL_ARB_bindless_texture
 GL_ARB_texture_filter_minmax
 GL_ARB_texture_float
 GL_ARB_cl_event
+GL_KHR_parallel_shader_compile
 WGL_ARB_pixel_format
 GL_NV_bindless_texture
 GL_NV_blend_equation_advanced
@@ -80,21 +80,19 @@ static bool checkShader(GLuint shader, std::string const& filename)
   return result == GL_TRUE;
 }
 
-bool ProgramManager::setupProgram(Program& prog)
+bool ProgramManager::beginProgram(Program& prog)
 {
-  prog.program = 0;
-
   if(prog.definitions.empty())
     return false;
 
   m_supportsExtendedInclude = has_GL_ARB_shading_language_include != 0;
 
-  std::string combinedPrepend = m_prepend;
-  std::string combinedFilenames;
+  prog.combinedPrepend = m_prepend;
+  prog.combinedFilenames.clear();
   for(size_t i = 0; i < prog.definitions.size(); i++)
   {
-    combinedPrepend += prog.definitions[i].prepend;
-    combinedFilenames += prog.definitions[i].filename;
+    prog.combinedPrepend += prog.definitions[i].prepend;
+    prog.combinedFilenames += prog.definitions[i].filename;
   }
 
   bool allFound = true;
@@ -155,59 +153,114 @@ bool ProgramManager::setupProgram(Program& prog)
     prog.program = PREPROCESS_ONLY_PROGRAM;
     return true;
   }
-  else
+
+  if(has_GL_KHR_parallel_shader_compile && !m_compilerThreadsSet)
   {
-    prog.program = glCreateProgram();
-    if(!m_useCacheFile.empty() && has_GL_VERSION_4_1)
-    {
-      glProgramParameteri(prog.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
-    }
+    glMaxShaderCompilerThreadsKHR(m_compilerThreads);
+    m_compilerThreadsSet = true;
+  }
+
+  GLuint program = glCreateProgram();
+  if(!m_useCacheFile.empty() && has_GL_VERSION_4_1)
+  {
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   }
 
-  bool loadedCache = false;
+  prog.pendingFromCache = false;
   if(!m_useCacheFile.empty() && (!allFound || m_preferCache) && has_GL_VERSION_4_1)
   {
     // try cache
-    loadedCache = loadBinary(prog.program, combinedPrepend, combinedFilenames);
+    prog.pendingFromCache = loadBinary(program, prog.combinedPrepend, prog.combinedFilenames);
   }
-  if(!loadedCache)
+  if(!prog.pendingFromCache)
   {
+    if(!allFound)
+    {
+      glDeleteProgram(program);
+      return false;
+    }
+
+    // with GL_KHR_parallel_shader_compile none of these wait, the status queries in finishProgram do
     for(size_t i = 0; i < prog.definitions.size(); i++)
     {
-      Definition& definition = prog.definitions[i];
-      GLuint      shader     = 0;
-      if(!definition.content.empty())
-      {
-        char const* sourcePointer = definition.content.c_str();
-        shader                    = glCreateShader(definition.type);
-        glShaderSource(shader, 1, &sourcePointer, NULL);
-        glCompileShader(shader);
-      }
-      if(!shader || !checkShader(shader, definition.filename))
-      {
-        glDeleteShader(shader);
-        glDeleteProgram(prog.program);
-        prog.program = 0;
-        return false;
-      }
-      glAttachShader(prog.program, shader);
-      glDeleteShader(shader);
+      char const* sourcePointer = prog.definitions[i].content.c_str();
+      GLuint      shader        = glCreateShader(prog.definitions[i].type);
+      glShaderSource(shader, 1, &sourcePointer, NULL);
+      glCompileShader(shader);
+      glAttachShader(program, shader);
+      prog.pendingShaders.push_back(shader);
     }
-    glLinkProgram(prog.program);
+    glLinkProgram(program);
   }
 
-  if(checkProgram(prog.program))
+  prog.pending = program;
+  return true;
+}
+
+bool ProgramManager::isProgramComplete(const Program& prog) const
+{
+  if(!prog.pending || prog.pendingFromCache || !has_GL_KHR_parallel_shader_compile)
+    return true;
+
+  GLint result = GL_FALSE;
+  glGetProgramiv(prog.pending, GL_COMPLETION_STATUS_KHR, &result);
+  return result == GL_TRUE;
+}
+
+void ProgramManager::finishProgram(Program& prog)
+{
+  if(!prog.pending)
+    return;
+
+  bool linked = true;
+  if(!prog.pendingFromCache)
   {
-    if(!m_useCacheFile.empty() && !loadedCache && has_GL_VERSION_4_1)
+    for(size_t i = 0; i < prog.pendingShaders.size(); i++)
     {
-      saveBinary(prog.program, combinedPrepend, combinedFilenames);
+      linked = checkShader(prog.pendingShaders[i], prog.definitions[i].filename) && linked;
     }
-    return true;
+    linked = linked && checkProgram(prog.pending);
   }
 
-  glDeleteProgram(prog.program);
-  prog.program = 0;
-  return false;
+  GLuint program = prog.pending;
+  for(GLuint shader : prog.pendingShaders)
+  {
+    glDetachShader(program, shader);
+    glDeleteShader(shader);
+  }
+  prog.pendingShaders.clear();
+  prog.pending = 0;
+
+  if(linked && !m_useCacheFile.empty() && !prog.pendingFromCache && has_GL_VERSION_4_1)
+  {
+    saveBinary(program, prog.combinedPrepend, prog.combinedFilenames);
+  }
+
+  // the previous program was in use until now
+  if(prog.program && prog.program != PREPROCESS_ONLY_PROGRAM)
+  {
+    glDeleteProgram(prog.program);
+  }
+  if(!linked)
+  {
+    glDeleteProgram(program);
+    program = 0;
+  }
+  prog.program = program;
+}
+
+void ProgramManager::releasePending(Program& prog)
+{
+  for(GLuint shader : prog.pendingShaders)
+  {
+    glDeleteShader(shader);
+  }
+  prog.pendingShaders.clear();
+  if(prog.pending)
+  {
+    glDeleteProgram(prog.pending);
+  }
+  prog.pending = 0;
 }
 
 ProgramID ProgramManager::createProgram(const Definition& def0,
@@ -234,8 +287,13 @@ ProgramID ProgramManager::createProgram(const std::vector<ProgramManager::Defini
 {
   Program prog;
   prog.definitions = definitions;
+  prog.program     = 0;
 
-  setupProgram(prog);
+  beginProgram(prog);
+  if(!m_asyncCompile)
+  {
+    finishProgram(prog);
+  }
 
   for(size_t i = 0; i < m_programs.size(); i++)
   {
@@ -264,6 +322,7 @@ void ProgramManager::deletePrograms()
 {
   for(size_t i = 0; i < m_programs.size(); i++)
   {
+    releasePending(m_programs[i]);
     if(m_programs[i].program && m_programs[i].program != PREPROCESS_ONLY_PROGRAM)
     {
       glDeleteProgram(m_programs[i].program);
@@ -272,42 +331,98 @@ void ProgramManager::deletePrograms()
   }
 }
 
-void ProgramManager::reloadProgram(ProgramID i)
+void ProgramManager::beginReload(Program& prog)
 {
-  if(!isValid(i))
-    return;
-
   bool old = m_preprocessOnly;
 
-  if(m_programs[i].program && m_programs[i].program != PREPROCESS_ONLY_PROGRAM)
+  // a reload in flight is outdated
+  releasePending(prog);
+
+  m_preprocessOnly = prog.program == PREPROCESS_ONLY_PROGRAM;
+  if(!beginProgram(prog))
   {
-    glDeleteProgram(m_programs[i].program);
+    if(prog.program)
+    {
+      glDeleteProgram(prog.program);
+    }
+    prog.program = 0;
   }
+  m_preprocessOnly = old;
+}
+
+void ProgramManager::reloadProgram(ProgramID i)
+{
+  if(!isValid(i) || m_programs[i].definitions.empty())
+    return;
 
-  m_preprocessOnly      = m_programs[i].program == PREPROCESS_ONLY_PROGRAM;
-  m_programs[i].program = 0;
-  if(!m_programs[i].definitions.empty())
+  beginReload(m_programs[i]);
+  if(!m_asyncCompile)
   {
-    setupProgram(m_programs[i]);
+    finishProgram(m_programs[i]);
   }
-  m_preprocessOnly = old;
 }
 
 void ProgramManager::reloadPrograms()
 {
   LOGI("Reloading programs...\n");
 
+  // all compiles are started before waiting for the first one
+  for(size_t i = 0; i < m_programs.size(); i++)
+  {
+    if(isValid((ProgramID)i) && !m_programs[i].definitions.empty())
+    {
+      beginReload(m_programs[i]);
+    }
+  }
+
+  if(!m_asyncCompile)
+  {
+    finishPrograms();
+    LOGI("done\n");
+  }
+}
+
+bool ProgramManager::updatePrograms()
+{
+  bool done = true;
+  for(size_t i = 0; i < m_programs.size(); i++)
+  {
+    if(!m_programs[i].pending)
+      continue;
+
+    if(isProgramComplete(m_programs[i]))
+    {
+      finishProgram(m_programs[i]);
+    }
+    else
+    {
+      done = false;
+    }
+  }
+  return done;
+}
+
+void ProgramManager::finishPrograms()
+{
   for(size_t i = 0; i < m_programs.size(); i++)
   {
-    reloadProgram((ProgramID)i);
+    finishProgram(m_programs[i]);
   }
+}
 
-  LOGI("done\n");
+bool ProgramManager::hasPendingPrograms() const
+{
+  for(size_t i = 0; i < m_programs.size(); i++)
+  {
+    if(m_programs[i].pending)
+      return true;
+  }
+  return false;
 }
 
 bool ProgramManager::isValid(ProgramID idx) const
 {
-  return idx.isValid() && (m_programs[idx].definitions.empty() || m_programs[idx].program != 0);
+  return idx.isValid() && (m_programs[idx].definitions.empty() || m_programs[idx].program != 0 || m_programs[idx].pending != 0);
 }
 
 unsigned int ProgramManager::get(ProgramID idx) const
@@ -318,6 +433,7 @@ unsigned int ProgramManager::get(ProgramID idx) const
 
 void ProgramManager::destroyProgram(ProgramID idx)
 {
+  releasePending(m_programs[idx]);
   if(m_programs[idx].program && m_programs[idx].program != PREPROCESS_ONLY_PROGRAM)
   {
     glDeleteProgram(m_programs[idx].program);
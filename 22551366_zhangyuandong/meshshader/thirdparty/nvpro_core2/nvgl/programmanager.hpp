@@ -56,6 +56,19 @@ id = mgr.createProgram({{GL_VERTEX_SHADER, "object.vert.glsl"},{GL_FRAGMENT_SHAD
 
 glUseProgram(mgr.get(id));
 ```
+
+With GL_KHR_parallel_shader_compile the shaders of all programs compile at the same time on driver threads.
+Set `m_asyncCompile` so that the reloads don't block: the previous programs stay in use until the new ones
+are linked, which `updatePrograms` checks without waiting.
+
+```cpp
+mgr.m_asyncCompile = true;
+mgr.reloadPrograms();   // returns at once
+
+// every frame
+if(mgr.updatePrograms()) { // nothing in flight, mgr.areProgramsValid() tells if the reload succeeded
+}
+```
 -------------------------------------------------------------------------------------------------*/
 
 
@@ -100,6 +113,13 @@ public:
 
     uint32_t                program;
     std::vector<Definition> definitions;
+
+    // In flight, replaces `program` once linked
+    uint32_t              pending = 0;
+    std::vector<uint32_t> pendingShaders;
+    bool                  pendingFromCache = false;
+    std::string           combinedPrepend;
+    std::string           combinedFilenames;
   };
 
   ProgramID createProgram(const std::vector<Definition>& definitions);
@@ -116,6 +136,13 @@ public:
   void deletePrograms();
   bool areProgramsValid();
 
+  // Replaces the programs whose compile and link are done, without waiting for the others.
+  // Returns true when none is left in flight.
+  bool updatePrograms();
+  // Waits for the programs in flight
+  void finishPrograms();
+  bool hasPendingPrograms() const;
+
 
   bool         isValid(ProgramID idx) const;
   unsigned int get(ProgramID idx) const;
@@ -133,6 +160,11 @@ public:
   bool m_preprocessOnly;
   // don't create actual program, treat filename as raw
   bool m_rawOnly;
+  // createProgram and the reloads only start the compiles, see updatePrograms. Otherwise they wait,
+  // reloadPrograms after starting all of them.
+  bool m_asyncCompile;
+  // given to glMaxShaderCompilerThreadsKHR before the first compile, ~0 lets the implementation choose
+  uint32_t m_compilerThreads;
 
   ProgramManager(ProgramManager const&)            = delete;
   ProgramManager& operator=(ProgramManager const&) = delete;
@@ -141,18 +173,27 @@ public:
       : m_preferCache(false)
       , m_preprocessOnly(false)
       , m_rawOnly(false)
+      , m_asyncCompile(false)
+      , m_compilerThreads(~0U)
   {
     m_filetype = FILETYPE_GLSL;
   }
 
 private:
-  bool setupProgram(Program& prog);
+  // Preprocesses and starts the compile and link of `prog.pending`, or loads it from the cache
+  bool beginProgram(Program& prog);
+  bool isProgramComplete(const Program& prog) const;
+  // Checks the pending program and replaces `prog.program` with it, waits if not complete
+  void finishProgram(Program& prog);
+  void releasePending(Program& prog);
+  void beginReload(Program& prog);
 
   bool        loadBinary(GLuint program, const std::string& combinedPrepend, const std::string& combinedFilenames);
   void        saveBinary(GLuint program, const std::string& combinedPrepend, const std::string& combinedFilenames);
   std::string binaryName(const std::string& combinedPrepend, const std::string& combinedFilenames);
 
   std::vector<Program> m_programs;
+  bool                 m_compilerThreadsSet = false;
 };
 
 }  // namespace nvgl
@@ -24,8 +24,6 @@
 
 #include "elem_gpu_monitor.hpp"
 
-#define SAMPLING_INTERVAL 100  // Sampling every 100 ms
-
 // Time (in ms) during which a throttle reason is shown as currently happening
 #define THROTTLE_SHOW_COOLDOWN_TIME 1000
 // Time (in ms) during which the last throttle reason is shown
@@ -64,8 +62,26 @@ ElementGpuMonitor::ElementGpuMonitor(bool show /*= false*/)
 void ElementGpuMonitor::onAttach(nvapp::Application* app)
 {
   LOGI("Adding GPU Monitor (NVML)\n");
+  m_app = app;
 #if defined(NVML_SUPPORTED)
-  m_nvmlMonitor = std::make_unique<NvmlMonitor>(SAMPLING_INTERVAL, SAMPLING_NUM);
+  m_nvmlMonitor = std::make_unique<NvmlMonitor>(samplingInterval, SAMPLING_NUM);
+  // Logged even when the window is hidden, to know which frames of a benchmark ran throttled
+  m_loggedThrottleReasons.assign(m_nvmlMonitor->getGpuCount(), 0);
+  m_nvmlMonitor->setSampleCallback([this](const NvmlMonitor::Sample& sample) {
+    for(size_t gpu = 0; gpu < sample.devices.size(); gpu++)
+    {
+      const uint64_t reason = sample.devices[gpu].throttleReasons.get();
+      if(reason > 1 && reason != m_loggedThrottleReasons[gpu])
+      {
+        LOGW("Throttle detected for GPU %zu at frame %llu: %s - Performance numbers will be unreliable\n", gpu,
+             (unsigned long long)sample.frameNumber,
+             NvmlMonitor::DevicePerformanceState::getThrottleReasonStrings(reason)[0].c_str());
+      }
+      m_loggedThrottleReasons[gpu] = reason;
+    }
+  });
+  // NVML calls can take milliseconds, they would show as spikes in the frame times
+  m_nvmlMonitor->startSampling();
 #endif
   m_settingsHandler.setHandlerName("ElementNvml");
   m_settingsHandler.setSetting("ShowWindow", &showWindow);
@@ -73,6 +89,15 @@ void ElementGpuMonitor::onAttach(nvapp::Application* app)
 }
 
 
+void ElementGpuMonitor::onPreRender()
+{
+#if defined(NVML_SUPPORTED)
+  // The timeline value of the frame, as in the profiler captures
+  m_nvmlMonitor->setFrameNumber(m_app->getFrameSignalSemaphore().value);
+  m_nvmlMonitor->setInterval(samplingInterval);
+#endif
+}
+
 void ElementGpuMonitor::onDetach()
 {
 #if defined(NVML_SUPPORTED)
@@ -124,7 +149,7 @@ void ElementGpuMonitor::onUIRender()
 
     {  // Averaging the CPU sampling, but limit the
       static double s_refreshRate = ImGui::GetTime();
-      if((ImGui::GetTime() - s_refreshRate) > SAMPLING_INTERVAL / 1000.0)
+      if((ImGui::GetTime() - s_refreshRate) > samplingInterval / 1000.0)
       {
         m_avgCpu.addValue(cpuMeasure.cpu[m_nvmlMonitor->getOffset()]);
         s_refreshRate = ImGui::GetTime();
@@ -223,16 +248,11 @@ void ElementGpuMonitor::onUIRender()
       uint64_t currentThrottleReason = performanceState.throttleReasons.get()[offset];
       if(currentThrottleReason > 1)
       {
-        std::string message =
-            fmt::format("Throttle detected for GPU {}: {} - Performance numbers will be unreliable", deviceIndex,
-                        NvmlMonitor::DevicePerformanceState::getThrottleReasonStrings(currentThrottleReason)[0]);
+        std::string message = fmt::format("Throttle detected for GPU {} at frame {}: {} - Performance numbers will be unreliable",
+                                          deviceIndex, m_nvmlMonitor->getSysInfo().frameNumber[offset],
+                                          NvmlMonitor::DevicePerformanceState::getThrottleReasonStrings(currentThrottleReason)[0]);
         ImGui::TextColored(ImVec4(1.f, 0.f, 0.f, 1.f), "%s", message.c_str());
-        m_throttleDetected = true;
-
-        if(m_lastThrottleReason != currentThrottleReason)
-        {
-          LOGW("%s\n", message.c_str());
-        }
+        m_throttleDetected   = true;
         m_lastThrottleReason = currentThrottleReason;
         m_throttleCooldownTimer.reset();
       }
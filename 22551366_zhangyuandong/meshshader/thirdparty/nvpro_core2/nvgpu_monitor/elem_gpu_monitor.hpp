@@ -35,6 +35,9 @@
 
 >  This class is an element of the application that is responsible for the NVML monitoring. It is using the `NVML` library to get information about the GPU and display it in the application.
 
+The measurements are taken on a background thread every `samplingInterval` ms, and stamped with the frame
+of the application, so a throttled benchmark can be traced to its frames.
+
 To use this class, you need to add it to the `nvapp::Application` using the `addElement` method.
 
 -------------------------------------------------------------------------------------------------*/
@@ -78,12 +81,14 @@ struct ElementGpuMonitor : public nvapp::IAppElement
 
   void onUIRender() override;
   void onUIMenu() override;
+  void onPreRender() override;
   void onAttach(nvapp::Application* app) override;
   void onDetach() override;
 
   // attribute set public on purpose so external parameter parser and UI widgets
   // can modify directly with pointer access
-  bool showWindow{false};
+  bool     showWindow{false};
+  uint32_t samplingInterval{100};  // Milliseconds between measurements, can be changed at any time
 
 private:
   void pushThrottleTabColor() const;
@@ -104,11 +109,13 @@ private:
 
   bool                      m_throttleDetected{false};
   uint64_t                  m_lastThrottleReason{0ull};
+  std::vector<uint64_t>     m_loggedThrottleReasons;  // Per GPU, last reason of the sample callback
   nvutils::PerformanceTimer m_throttleCooldownTimer;
 
   uint32_t m_selectedMemClock{0u};
   uint32_t m_selectedGraphicsClock{0u};
 
+  nvapp::Application*          m_app{};
   std::unique_ptr<NvmlMonitor> m_nvmlMonitor;
   AverageCircularBuffer<float> m_avgCpu = {SAMPLING_NUM};
 
@@ -130,6 +130,7 @@ using namespace nvgpu_monitor;
 NvmlMonitor::NvmlMonitor(uint32_t interval /*= 100*/, uint32_t limit /*= 100*/)
     : m_maxElements(limit)     // limit : number of measures
     , m_minInterval(interval)  // interval : ms between sampling
+    , m_startTime(std::chrono::steady_clock::now())
 {
 #if defined(NVML_SUPPORTED)
 
@@ -148,6 +149,13 @@ NvmlMonitor::NvmlMonitor(uint32_t interval /*= 100*/, uint32_t limit /*= 100*/)
 
   // System Info
   m_sysInfo.cpu.resize(m_maxElements);
+  m_sysInfo.frameNumber.resize(m_maxElements);
+  m_sysInfo.timeMs.resize(m_maxElements);
+
+  // Measurements are filled in place, the ring doesn't allocate once sampling
+  m_syncSample.devices.resize(m_physicalGpuCount);
+  m_lastSample.devices.resize(m_physicalGpuCount);
+  m_ring.resize(kRingSize, m_syncSample);
 
   // Get driver version
   char driverVersion[80];
@@ -179,6 +187,7 @@ NvmlMonitor::NvmlMonitor(uint32_t interval /*= 100*/, uint32_t limit /*= 100*/)
 //
 NvmlMonitor::~NvmlMonitor()
 {
+  stopSampling();
 #if defined(NVML_SUPPORTED)
   nvmlShutdown();
 #endif
@@ -245,8 +254,107 @@ static float getCpuLoad()
 
 #endif
 
+#if defined(NVML_SUPPORTED)
+//-------------------------------------------------------------------------------------------------
+// All the varying measurements of a GPU, the only NVML calls made after the initialization
+//
+static void measureDevice(nvmlDevice_t device, NvmlMonitor::DeviceSample& sample)
+{
+  nvmlBAR1Memory_t bar1Memory{};
+  CHECK_NVML_SUPPORT(nvmlDeviceGetBAR1MemoryInfo(device, &bar1Memory), sample.bar1Total);
+  sample.bar1Total            = bar1Memory.bar1Total;
+  sample.bar1Used             = bar1Memory.bar1Used;
+  sample.bar1Free             = bar1Memory.bar1Free;
+  sample.bar1Used.isSupported = sample.bar1Free.isSupported = sample.bar1Total.isSupported;
+
+  nvmlMemory_t memory{};
+  CHECK_NVML_SUPPORT(nvmlDeviceGetMemoryInfo(device, &memory), sample.memoryTotal);
+  sample.memoryTotal            = memory.total;
+  sample.memoryUsed             = memory.used;
+  sample.memoryFree             = memory.free;
+  sample.memoryUsed.isSupported = sample.memoryFree.isSupported = sample.memoryTotal.isSupported;
+
+  nvmlUtilization_t utilization{};
+  CHECK_NVML_SUPPORT(nvmlDeviceGetUtilizationRates(device, &utilization), sample.gpuUtilization);
+  sample.gpuUtilization             = utilization.gpu;
+  sample.memUtilization             = utilization.memory;
+  sample.memUtilization.isSupported = sample.gpuUtilization.isSupported;
+
+  sample.computeProcesses  = 0;
+  sample.graphicsProcesses = 0;
+  CHECK_NVML_SUPPORT(nvmlDeviceGetComputeRunningProcesses(device, &sample.computeProcesses.get(), nullptr), sample.computeProcesses);
+  CHECK_NVML_SUPPORT(nvmlDeviceGetGraphicsRunningProcesses(device, &sample.graphicsProcesses.get(), nullptr),
+                     sample.graphicsProcesses);
+
+  CHECK_NVML_SUPPORT(nvmlDeviceGetClockInfo(device, NVML_CLOCK_GRAPHICS, &sample.clockGraphics.get()), sample.clockGraphics);
+  CHECK_NVML_SUPPORT(nvmlDeviceGetClockInfo(device, NVML_CLOCK_SM, &sample.clockSM.get()), sample.clockSM);
+  CHECK_NVML_SUPPORT(nvmlDeviceGetClockInfo(device, NVML_CLOCK_MEM, &sample.clockMem.get()), sample.clockMem);
+  CHECK_NVML_SUPPORT(nvmlDeviceGetClockInfo(device, NVML_CLOCK_VIDEO, &sample.clockVideo.get()), sample.clockVideo);
+  CHECK_NVML_SUPPORT(nvmlDeviceGetCurrentClocksThrottleReasons(device, reinterpret_cast<unsigned long long*>(
+                                                                           &sample.throttleReasons.get())),
+                     sample.throttleReasons);
+
+  CHECK_NVML_SUPPORT(nvmlDeviceGetTemperature(device, NVML_TEMPERATURE_GPU, &sample.temperature.get()), sample.temperature);
+  CHECK_NVML_SUPPORT(nvmlDeviceGetPowerUsage(device, &sample.power.get()), sample.power);
+  // Milliwatt to watt
+  sample.power.get() /= 1000;
+  CHECK_NVML_SUPPORT(nvmlDeviceGetFanSpeed(device, &sample.fanSpeed.get()), sample.fanSpeed);
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Pulling the information from NVML, on the calling thread or the sampling thread
+//
+void NvmlMonitor::measure(Sample& sample)
+{
+#if defined(NVML_SUPPORTED)
+  sample.frameNumber = m_frameNumber.load(std::memory_order_relaxed);
+  sample.timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+  sample.cpu    = getCpuLoad();
+
+  for(unsigned int gpu_id = 0; gpu_id < m_physicalGpuCount; gpu_id++)
+  {
+    nvmlDevice_t device;
+    if(nvmlDeviceGetHandleByIndex(gpu_id, &device) == NVML_SUCCESS)
+    {
+      measureDevice(device, sample.devices[gpu_id]);
+    }
+  }
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+// Storing a measurement in the cycle buffers read by the UI
+//
+void NvmlMonitor::store(const Sample& sample)
+{
+  // Increasing where to store the value
+  m_offset = (m_offset + 1) % m_maxElements;
+
+  // System
+  m_sysInfo.cpu[m_offset]         = sample.cpu;
+  m_sysInfo.frameNumber[m_offset] = sample.frameNumber;
+  m_sysInfo.timeMs[m_offset]      = sample.timeMs;
+
+  // All GPUs
+  for(unsigned int gpu_id = 0; gpu_id < m_physicalGpuCount; gpu_id++)
+  {
+    const DeviceSample& deviceSample = sample.devices[gpu_id];
+    m_deviceMemory[gpu_id].store(deviceSample, m_offset);
+    m_deviceUtilization[gpu_id].store(deviceSample, m_offset);
+    m_devicePerformanceState[gpu_id].store(deviceSample, m_offset);
+    m_devicePowerState[gpu_id].store(deviceSample, m_offset);
+  }
+
+  m_lastSample = sample;
+  if(m_sampleCallback)
+  {
+    m_sampleCallback(sample);
+  }
+}
+
 //-------------------------------------------------------------------------------------------------
-// Pulling the information from NVML and storing the data
+// Storing the new measurements
 // Note: the interval is important, as it cannot be query too quickly
 //
 void NvmlMonitor::refresh()
@@ -258,30 +366,80 @@ void NvmlMonitor::refresh()
   if(!m_valid)
     return;
 
+  // Collecting what the sampling thread measured since the last call
+  if(isSampling())
+  {
+    uint32_t       read  = m_ringRead.load(std::memory_order_relaxed);
+    const uint32_t write = m_ringWrite.load(std::memory_order_acquire);
+    for(; read != write; read++)
+    {
+      store(m_ring[read % kRingSize]);
+    }
+    m_ringRead.store(read, std::memory_order_release);
+    return;
+  }
+
   // Pulling the information only when it is over the defined interval
-  if(s_startTime.getMilliseconds() < m_minInterval)
+  if(s_startTime.getMilliseconds() < m_minInterval.load(std::memory_order_relaxed))
     return;
   s_startTime.reset();
 
-  // Increasing where to store the value
-  m_offset = (m_offset + 1) % m_maxElements;
+  measure(m_syncSample);
+  store(m_syncSample);
 
-  // System
-  m_sysInfo.cpu[m_offset] = getCpuLoad();
+#endif  //  NVML_SUPPORTED
+}
 
-  // All GPUs
-  for(unsigned int gpu_id = 0; gpu_id < m_physicalGpuCount; gpu_id++)
-  {
-    nvmlDevice_t device;
-    nvmlReturn_t result = nvmlDeviceGetHandleByIndex(gpu_id, &device);
+void NvmlMonitor::startSampling()
+{
+#if defined(NVML_SUPPORTED)
+  if(!m_valid || isSampling())
+    return;
+
+  // Measurements taken by refresh() before are kept, the ring starts empty
+  m_ringRead.store(0);
+  m_ringWrite.store(0);
+  m_stopSampling   = false;
+  m_samplingThread = std::thread(&NvmlMonitor::samplingLoop, this);
+#endif
+}
+
+void NvmlMonitor::stopSampling()
+{
+  if(!isSampling())
+    return;
 
-    m_deviceMemory[gpu_id].refresh(device, m_offset);
-    m_deviceUtilization[gpu_id].refresh(device, m_offset);
-    m_devicePerformanceState[gpu_id].refresh(device, m_offset);
-    m_devicePowerState[gpu_id].refresh(device, m_offset);
+  {
+    std::lock_guard lock(m_stopMutex);
+    m_stopSampling = true;
   }
+  m_stopCondition.notify_all();
+  m_samplingThread.join();
+}
 
-#endif  //  NVML_SUPPORTED
+void NvmlMonitor::samplingLoop()
+{
+  std::unique_lock lock(m_stopMutex);
+  while(!m_stopSampling)
+  {
+    lock.unlock();
+
+    // A full ring means refresh() isn't called, e.g. the window is minimized: the newest measurement is dropped
+    const uint32_t write = m_ringWrite.load(std::memory_order_relaxed);
+    if(write - m_ringRead.load(std::memory_order_acquire) < kRingSize)
+    {
+      measure(m_ring[write % kRingSize]);
+      m_ringWrite.store(write + 1, std::memory_order_release);
+    }
+    else
+    {
+      m_droppedSamples.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    lock.lock();
+    m_stopCondition.wait_for(lock, std::chrono::milliseconds(m_minInterval.load(std::memory_order_relaxed)),
+                             [this] { return m_stopSampling; });
+  }
 }
 
 void NvmlMonitor::DeviceInfo::refresh(void* dev)
@@ -439,29 +597,21 @@ void NvmlMonitor::DeviceMemory::init(uint32_t maxElements)
   bar1Used.get().resize(maxElements);
 }
 
-void NvmlMonitor::DeviceMemory::refresh(void* dev, uint32_t offset)
+void NvmlMonitor::DeviceMemory::store(const DeviceSample& sample, uint32_t offset)
 {
-#if defined(NVML_SUPPORTED)
-  nvmlDevice_t device = reinterpret_cast<nvmlDevice_t>(dev);
-
-  nvmlBAR1Memory_t bar1Memory{};
-  nvmlMemory_t     memory{};
-  CHECK_NVML_SUPPORT(nvmlDeviceGetBAR1MemoryInfo(device, &bar1Memory), bar1Total);
-
-  bar1Total              = bar1Memory.bar1Total;
-  bar1Used.get()[offset] = bar1Memory.bar1Used;
-  bar1Used.isSupported   = bar1Total.isSupported;
-
-  bar1Free.get()[offset] = bar1Memory.bar1Free;
-  bar1Free.isSupported   = bar1Total.isSupported;
-
-  CHECK_NVML_SUPPORT(nvmlDeviceGetMemoryInfo(device, &memory), memoryTotal);
-  memoryTotal              = memory.total;
-  memoryUsed.get()[offset] = memory.used;
-  memoryUsed.isSupported   = memoryTotal.isSupported;
-  memoryFree.get()[offset] = memory.free;
-  memoryFree.isSupported   = memoryTotal.isSupported;
-#endif
+  bar1Total              = sample.bar1Total.get();
+  bar1Total.isSupported  = sample.bar1Total.isSupported;
+  bar1Used.get()[offset] = sample.bar1Used.get();
+  bar1Used.isSupported   = sample.bar1Used.isSupported;
+  bar1Free.get()[offset] = sample.bar1Free.get();
+  bar1Free.isSupported   = sample.bar1Free.isSupported;
+
+  memoryTotal              = sample.memoryTotal.get();
+  memoryTotal.isSupported  = sample.memoryTotal.isSupported;
+  memoryUsed.get()[offset] = sample.memoryUsed.get();
+  memoryUsed.isSupported   = sample.memoryUsed.isSupported;
+  memoryFree.get()[offset] = sample.memoryFree.get();
+  memoryFree.isSupported   = sample.memoryFree.isSupported;
 }
 
 void NvmlMonitor::DeviceUtilization::init(uint32_t maxElements)
@@ -475,23 +625,16 @@ void NvmlMonitor::DeviceUtilization::init(uint32_t maxElements)
   ;
 }
 
-void NvmlMonitor::DeviceUtilization::refresh(void* dev, uint32_t offset)
+void NvmlMonitor::DeviceUtilization::store(const DeviceSample& sample, uint32_t offset)
 {
-#if defined(NVML_SUPPORTED)
-  nvmlDevice_t device = reinterpret_cast<nvmlDevice_t>(dev);
-
-  nvmlUtilization_t utilization;
-  CHECK_NVML_SUPPORT(nvmlDeviceGetUtilizationRates(device, &utilization), gpuUtilization);
-  gpuUtilization.get()[offset] = utilization.gpu;
-  memUtilization.get()[offset] = utilization.memory;
-  memUtilization.isSupported   = gpuUtilization.isSupported;
-
-
-  computeProcesses.get()[offset]  = 0;
-  graphicsProcesses.get()[offset] = 0;
-  CHECK_NVML_SUPPORT(nvmlDeviceGetComputeRunningProcesses(device, &computeProcesses.get()[offset], nullptr), computeProcesses);
-  CHECK_NVML_SUPPORT(nvmlDeviceGetGraphicsRunningProcesses(device, &graphicsProcesses.get()[offset], nullptr), graphicsProcesses);
-#endif
+  gpuUtilization.get()[offset]    = sample.gpuUtilization.get();
+  gpuUtilization.isSupported      = sample.gpuUtilization.isSupported;
+  memUtilization.get()[offset]    = sample.memUtilization.get();
+  memUtilization.isSupported      = sample.memUtilization.isSupported;
+  computeProcesses.get()[offset]  = sample.computeProcesses.get();
+  computeProcesses.isSupported    = sample.computeProcesses.isSupported;
+  graphicsProcesses.get()[offset] = sample.graphicsProcesses.get();
+  graphicsProcesses.isSupported   = sample.graphicsProcesses.isSupported;
 }
 
 void NvmlMonitor::DevicePerformanceState::init(uint32_t maxElements)
@@ -503,20 +646,18 @@ void NvmlMonitor::DevicePerformanceState::init(uint32_t maxElements)
   throttleReasons.get().resize(maxElements);
 }
 
-void NvmlMonitor::DevicePerformanceState::refresh(void* dev, uint32_t offset)
+void NvmlMonitor::DevicePerformanceState::store(const DeviceSample& sample, uint32_t offset)
 {
-#if defined(NVML_SUPPORTED)
-  nvmlDevice_t device = reinterpret_cast<nvmlDevice_t>(dev);
-
-  CHECK_NVML_SUPPORT(nvmlDeviceGetClockInfo(device, NVML_CLOCK_GRAPHICS, &clockGraphics.get()[offset]), clockGraphics);
-  CHECK_NVML_SUPPORT(nvmlDeviceGetClockInfo(device, NVML_CLOCK_SM, &clockSM.get()[offset]), clockSM);
-  CHECK_NVML_SUPPORT(nvmlDeviceGetClockInfo(device, NVML_CLOCK_MEM, &clockMem.get()[offset]), clockMem);
-  CHECK_NVML_SUPPORT(nvmlDeviceGetClockInfo(device, NVML_CLOCK_VIDEO, &clockVideo.get()[offset]), clockVideo);
-
-  CHECK_NVML_SUPPORT(nvmlDeviceGetCurrentClocksThrottleReasons(device, reinterpret_cast<unsigned long long*>(
-                                                                           &throttleReasons.get()[offset])),
-                     throttleReasons);
-#endif
+  clockGraphics.get()[offset]   = sample.clockGraphics.get();
+  clockGraphics.isSupported     = sample.clockGraphics.isSupported;
+  clockSM.get()[offset]         = sample.clockSM.get();
+  clockSM.isSupported           = sample.clockSM.isSupported;
+  clockMem.get()[offset]        = sample.clockMem.get();
+  clockMem.isSupported          = sample.clockMem.isSupported;
+  clockVideo.get()[offset]      = sample.clockVideo.get();
+  clockVideo.isSupported        = sample.clockVideo.isSupported;
+  throttleReasons.get()[offset] = sample.throttleReasons.get();
+  throttleReasons.isSupported   = sample.throttleReasons.isSupported;
 }
 
 std::vector<std::string> NvmlMonitor::DevicePerformanceState::getThrottleReasonStrings(uint64_t reason)
@@ -593,15 +734,12 @@ void NvmlMonitor::DevicePowerState::init(uint32_t maxElements)
   fanSpeed.get().resize(maxElements);
 }
 
-void NvmlMonitor::DevicePowerState::refresh(void* dev, uint32_t offset)
+void NvmlMonitor::DevicePowerState::store(const DeviceSample& sample, uint32_t offset)
 {
-#if defined(NVML_SUPPORTED)
-  nvmlDevice_t device = reinterpret_cast<nvmlDevice_t>(dev);
-
-  CHECK_NVML_SUPPORT(nvmlDeviceGetTemperature(device, NVML_TEMPERATURE_GPU, &temperature.get()[offset]), temperature);
-  CHECK_NVML_SUPPORT(nvmlDeviceGetPowerUsage(device, &power.get()[offset]), power);
-  // Milliwatt to watt
-  power.get()[offset] /= 1000;
-  CHECK_NVML_SUPPORT(nvmlDeviceGetFanSpeed(device, &fanSpeed.get()[offset]), fanSpeed);
-#endif
+  power.get()[offset]       = sample.power.get();
+  power.isSupported         = sample.power.isSupported;
+  temperature.get()[offset] = sample.temperature.get();
+  temperature.isSupported   = sample.temperature.isSupported;
+  fanSpeed.get()[offset]    = sample.fanSpeed.get();
+  fanSpeed.isSupported      = sample.fanSpeed.isSupported;
 }
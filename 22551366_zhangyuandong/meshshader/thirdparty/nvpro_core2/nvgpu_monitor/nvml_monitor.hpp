@@ -13,9 +13,15 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
-#include <map>
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -25,6 +31,10 @@ Capture the GPU load and memory for all GPUs on the system.
 Usage:
 - There should be only one instance of NvmlMonitor
 - call refresh() in each frame. It will not pull more measurement that the interval(ms)
+- startSampling() : measure on a background thread instead, NVML calls can take milliseconds.
+                    refresh() then only collects the measurements, and never blocks on NVML
+- setFrameNumber() : frame of the application, stored with each measurement to find the frames
+                     of a benchmark that ran throttled
 - isValid() : return if it can be used
 - nbGpu()   : return the number of GPU in the computer
 - getGpuInfo()     : static info about the GPU
@@ -36,6 +46,8 @@ Usage:
 Measurements: 
 - Uses a cycle buffer. 
 - Offset is the last measurement
+- The sampling thread hands its measurements to refresh() through a single-producer,
+  single-consumer ring; measurements are dropped when refresh() isn't called for a while
 
 -------------------------------------------------------------------------------------------------*/
 
@@ -64,6 +76,32 @@ public:
     }
   };
 
+  // One measurement of a GPU
+  struct DeviceSample
+  {
+    NVMLField<uint64_t> bar1Total;
+    NVMLField<uint64_t> bar1Used;
+    NVMLField<uint64_t> bar1Free;
+    NVMLField<uint64_t> memoryTotal;
+    NVMLField<uint64_t> memoryUsed;
+    NVMLField<uint64_t> memoryFree;
+
+    NVMLField<uint32_t> gpuUtilization;
+    NVMLField<uint32_t> memUtilization;
+    NVMLField<uint32_t> computeProcesses;
+    NVMLField<uint32_t> graphicsProcesses;
+
+    NVMLField<uint32_t> clockGraphics;
+    NVMLField<uint32_t> clockSM;
+    NVMLField<uint32_t> clockMem;
+    NVMLField<uint32_t> clockVideo;
+    NVMLField<uint64_t> throttleReasons;
+
+    NVMLField<uint32_t> power;  // Watt
+    NVMLField<uint32_t> temperature;
+    NVMLField<uint32_t> fanSpeed;
+  };
+
   // Static device information
   struct DeviceInfo
   {
@@ -142,7 +180,7 @@ public:
     NVMLField<std::vector<uint64_t>> memoryFree;
 
     void init(uint32_t maxElements);
-    void refresh(void* device, uint32_t offset);
+    void store(const DeviceSample& sample, uint32_t offset);
   };
 
   // Device utilization ratios
@@ -154,7 +192,7 @@ public:
     NVMLField<std::vector<uint32_t>> graphicsProcesses;
 
     void init(uint32_t maxElements);
-    void refresh(void* device, uint32_t offset);
+    void store(const DeviceSample& sample, uint32_t offset);
   };
 
   // Device performance state: clocks and throttling
@@ -167,7 +205,7 @@ public:
     NVMLField<std::vector<uint64_t>> throttleReasons;
 
     void                            init(uint32_t maxElements);
-    void                            refresh(void* device, uint32_t offset);
+    void                            store(const DeviceSample& sample, uint32_t offset);
     static std::vector<std::string> getThrottleReasonStrings(uint64_t reason);
 
     static const std::vector<uint64_t>& getAllThrottleReasonList();
@@ -181,18 +219,29 @@ public:
     NVMLField<std::vector<uint32_t>> fanSpeed;
 
     void init(uint32_t maxElements);
-    void refresh(void* device, uint32_t offset);
+    void store(const DeviceSample& sample, uint32_t offset);
   };
 
   // Other information
   struct SysInfo
   {
-    std::vector<float> cpu;  // Load measurement [0, 100]
-    std::string        driverVersion;
+    std::vector<float>    cpu;          // Load measurement [0, 100]
+    std::vector<uint64_t> frameNumber;  // Frame of the application at each measurement
+    std::vector<double>   timeMs;       // Time of each measurement, since the creation of the monitor
+    std::string           driverVersion;
+  };
+
+  // One measurement of the system and all GPUs
+  struct Sample
+  {
+    uint64_t                  frameNumber = 0;  // see setFrameNumber()
+    double                    timeMs      = 0.0;
+    float                     cpu         = 0.f;
+    std::vector<DeviceSample> devices;
   };
 
 
-  void                          refresh();  // Take measurement
+  void                          refresh();  // Take measurement, or collect those of the sampling thread
   bool                          isValid() { return m_valid; }
   uint32_t                      getGpuCount() { return m_physicalGpuCount; }
   const DeviceInfo&             getDeviceInfo(int gpu) { return m_deviceInfo[gpu]; }
@@ -202,9 +251,28 @@ public:
   const DevicePowerState&       getDevicePowerState(int gpu) { return m_devicePowerState[gpu]; }
   const SysInfo&                getSysInfo() { return m_sysInfo; }
   int                           getOffset() { return m_offset; }
+  const Sample&                 getLastSample() { return m_lastSample; }
+
+  // Measures every `interval` ms on a background thread, until stopSampling() or the destruction
+  void startSampling();
+  void stopSampling();
+  bool isSampling() const { return m_samplingThread.joinable(); }
+  void setInterval(uint32_t interval) { m_minInterval.store(interval, std::memory_order_relaxed); }
+  // Any frame counter of the application, e.g. the timeline value of the frame, read by the sampling thread
+  void setFrameNumber(uint64_t frameNumber) { m_frameNumber.store(frameNumber, std::memory_order_relaxed); }
+  // Called by refresh() for each new measurement, e.g. to log when and how a benchmark got throttled
+  void setSampleCallback(std::function<void(const Sample&)> callback) { m_sampleCallback = std::move(callback); }
+  // Measurements of the sampling thread that refresh() didn't collect in time
+  uint64_t getDroppedSampleCount() const { return m_droppedSamples.load(std::memory_order_relaxed); }
 
 
 private:
+  static constexpr uint32_t kRingSize = 64;  // Measurements in flight between the sampling thread and refresh()
+
+  void measure(Sample& sample);
+  void store(const Sample& sample);
+  void samplingLoop();
+
   std::vector<DeviceInfo>             m_deviceInfo;
   std::vector<DeviceMemory>           m_deviceMemory;
   std::vector<DeviceUtilization>      m_deviceUtilization;
@@ -215,7 +283,23 @@ private:
   uint32_t                            m_physicalGpuCount = 0;    // Number of NVIDIA GPU
   uint32_t                            m_offset           = 0;    // Index of the most recent cpu load sample
   uint32_t                            m_maxElements      = 100;  // Number of max stored measurements
-  uint32_t                            m_minInterval      = 100;  // Minimum interval lapse, in milliseconds
+  std::atomic<uint32_t>               m_minInterval      = 100;  // Minimum interval lapse, in milliseconds
+  std::atomic<uint64_t>               m_frameNumber      = 0;
+
+  Sample                                m_lastSample;  // Last measurement stored by refresh()
+  Sample                                m_syncSample;  // Measurement of refresh() without the sampling thread
+  std::function<void(const Sample&)>    m_sampleCallback;
+  std::chrono::steady_clock::time_point m_startTime;
+
+  // Sampling thread, it writes the ring and refresh() reads it
+  std::vector<Sample>     m_ring;
+  std::atomic<uint32_t>   m_ringWrite      = 0;  // Measurements written, the slot is `m_ringWrite % kRingSize`
+  std::atomic<uint32_t>   m_ringRead       = 0;  // Measurements collected by refresh()
+  std::atomic<uint64_t>   m_droppedSamples = 0;
+  std::thread             m_samplingThread;
+  std::mutex              m_stopMutex;  // Only to wake up the sampling thread when stopping
+  std::condition_variable m_stopCondition;
+  bool                    m_stopSampling = false;
 };
 
 }  // namespace nvgpu_monitor
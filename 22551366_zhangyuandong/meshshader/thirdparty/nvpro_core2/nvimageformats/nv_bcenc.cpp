@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "nv_bcenc.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+
+#ifdef NVP_SUPPORTS_BASISU
+#include <basisu_bc7enc.h>
+#include <basisu_enc.h>
+#endif
+
+namespace nv_bcenc {
+
+size_t getCompressedSize(uint32_t width, uint32_t height)
+{
+  return size_t((width + 3) / 4) * size_t((height + 3) / 4) * 16;
+}
+
+#ifdef NVP_SUPPORTS_BASISU
+namespace {
+
+// Texels of the block at (bx, by), clamped to the image
+std::array<basist::color_quad_u8, 16> loadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by)
+{
+  std::array<basist::color_quad_u8, 16> block;
+  for(uint32_t y = 0; y < 4; y++)
+  {
+    const uint32_t sy = std::min(by * 4 + y, height - 1);
+    for(uint32_t x = 0; x < 4; x++)
+    {
+      const uint32_t sx = std::min(bx * 4 + x, width - 1);
+      memcpy(block[y * 4 + x].m_c, rgba + (size_t(sy) * width + sx) * 4, 4);
+    }
+  }
+  return block;
+}
+
+// Writes `numBits` bits of `value` at `bitOffset` of a 128-bit block
+void putBits(uint8_t* block, uint32_t& bitOffset, uint32_t value, uint32_t numBits)
+{
+  for(uint32_t i = 0; i < numBits; i++, bitOffset++)
+  {
+    if(value & (1u << i))
+      block[bitOffset / 8] |= uint8_t(1u << (bitOffset % 8));
+  }
+}
+
+void compressBlockBC7Mode6(const std::array<basist::color_quad_u8, 16>& pixels, bool perceptual, uint8_t* output)
+{
+  basisu::bc7enc_compress_block_params compParams;
+  basisu::bc7enc_compress_block_params_init(&compParams);
+  if(!perceptual)
+    basisu::bc7enc_compress_block_params_init_linear_weights(&compParams);
+
+  basisu::color_cell_compressor_params params;
+  memset(&params, 0, sizeof(params));
+  params.m_num_pixels            = 16;
+  params.m_pPixels               = pixels.data();
+  params.m_num_selector_weights  = 16;
+  params.m_pSelector_weights     = basist::g_bc7_weights4;
+  params.m_pSelector_weightsx    = reinterpret_cast<const basisu::bc7enc_vec4F*>(basisu::g_bc7_weights4x);
+  params.m_comp_bits             = 7;
+  params.m_has_alpha             = BC7ENC_TRUE;
+  params.m_has_pbits             = BC7ENC_TRUE;
+  params.m_endpoints_share_pbit  = BC7ENC_FALSE;
+  params.m_perceptual            = compParams.m_perceptual;
+  memcpy(params.m_weights, compParams.m_weights, sizeof(params.m_weights));
+
+  uint8_t                                selectors[16];
+  uint8_t                                selectorsTemp[16];
+  basisu::color_cell_compressor_results results;
+  memset(&results, 0, sizeof(results));
+  results.m_pSelectors      = selectors;
+  results.m_pSelectors_temp = selectorsTemp;
+  basisu::color_cell_compression(6, &params, &results, &compParams);
+
+  // The anchor texel stores 3 bits, its most significant one must be 0: otherwise swap the endpoints
+  basist::color_quad_u8 low   = results.m_low_endpoint;
+  basist::color_quad_u8 high  = results.m_high_endpoint;
+  uint32_t              pbits[2] = {results.m_pbits[0], results.m_pbits[1]};
+  if(selectors[0] & 8)
+  {
+    std::swap(low, high);
+    std::swap(pbits[0], pbits[1]);
+    for(uint8_t& selector : selectors)
+      selector = uint8_t(15 - selector);
+  }
+
+  memset(output, 0, 16);
+  uint32_t bitOffset = 0;
+  putBits(output, bitOffset, 1u << 6, 7);  // Mode 6
+  for(uint32_t c = 0; c < 4; c++)
+  {
+    putBits(output, bitOffset, low.m_c[c], 7);
+    putBits(output, bitOffset, high.m_c[c], 7);
+  }
+  putBits(output, bitOffset, pbits[0], 1);
+  putBits(output, bitOffset, pbits[1], 1);
+  for(uint32_t i = 0; i < 16; i++)
+    putBits(output, bitOffset, selectors[i], i == 0 ? 3 : 4);
+}
+
+void initBasis()
+{
+  static std::once_flag once;
+  std::call_once(once, []() { basisu::basisu_encoder_init(); });  // Tables of the BC7 encoder
+}
+
+void forEachBlockRow(uint32_t height, const ParallelForFunc& parallel_for, const std::function<void(size_t)>& job)
+{
+  const size_t numRows = (height + 3) / 4;
+  if(parallel_for)
+  {
+    parallel_for(numRows, job);
+  }
+  else
+  {
+    for(size_t row = 0; row < numRows; row++)
+      job(row);
+  }
+}
+
+}  // namespace
+
+bool compressBC7(const uint8_t* rgba, uint32_t width, uint32_t height, bool perceptual, uint8_t* output, const ParallelForFunc& parallel_for)
+{
+  if(!rgba || !output || width == 0 || height == 0)
+    return false;
+  initBasis();
+
+  const uint32_t blocksX = (width + 3) / 4;
+  forEachBlockRow(height, parallel_for, [&](size_t by) {
+    for(uint32_t bx = 0; bx < blocksX; bx++)
+    {
+      compressBlockBC7Mode6(loadBlock(rgba, width, height, bx, uint32_t(by)), perceptual, output + (by * blocksX + bx) * 16);
+    }
+  });
+  return true;
+}
+
+bool compressBC5(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* output, const ParallelForFunc& parallel_for)
+{
+  if(!rgba || !output || width == 0 || height == 0)
+    return false;
+  initBasis();
+
+  const uint32_t blocksX = (width + 3) / 4;
+  forEachBlockRow(height, parallel_for, [&](size_t by) {
+    for(uint32_t bx = 0; bx < blocksX; bx++)
+    {
+      const std::array<basist::color_quad_u8, 16> block = loadBlock(rgba, width, height, bx, uint32_t(by));
+      uint8_t*                                    dst   = output + (by * blocksX + bx) * 16;
+      basist::encode_bc4(dst, &block[0].m_c[0], 4);      // Red
+      basist::encode_bc4(dst + 8, &block[0].m_c[1], 4);  // Green
+    }
+  });
+  return true;
+}
+
+#else
+
+bool compressBC7(const uint8_t*, uint32_t, uint32_t, bool, uint8_t*, const ParallelForFunc&)
+{
+  return false;
+}
+
+bool compressBC5(const uint8_t*, uint32_t, uint32_t, uint8_t*, const ParallelForFunc&)
+{
+  return false;
+}
+
+#endif
+
+}  // namespace nv_bcenc
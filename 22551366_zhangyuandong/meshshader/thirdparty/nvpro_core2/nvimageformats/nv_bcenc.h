@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*-----------------------------------------------------------------------------
+
+Provides:
+* Block compression of 8-bit RGBA images to BC7 (colors) and BC5 (two
+  channels, e.g. normal maps), for the images that aren't already stored
+  in a GPU format.
+
+BC7 uses mode 6 only (one subset, 7-bit RGBA endpoints and 4-bit weights),
+found by the Basis Universal BC7 endpoint optimizer, which is fast and
+handles any content; BC5 uses the Basis Universal BC4 encoder on the red and
+green channels.
+
+Requires NVP_SUPPORTS_BASISU, otherwise the functions return false.
+
+-----------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace nv_bcenc {
+
+// Apps can compress the rows of blocks on their own threads.
+// The function should call `job(i)` for every i in [0, numJobs), in any order
+// and from any thread, and return once all of them have finished.
+using ParallelForFunc = std::function<void(size_t numJobs, const std::function<void(size_t)>& job)>;
+
+// Size in bytes of a BC5 or BC7 image, 16 bytes per 4x4 block
+size_t getCompressedSize(uint32_t width, uint32_t height);
+
+// `rgba` holds width * height tightly packed texels, `output` getCompressedSize(width, height) bytes.
+// The edge blocks of sizes that are not multiples of 4 repeat the last row and column.
+// `perceptual` weights the error for color images (sRGB), instead of treating the channels equally.
+bool compressBC7(const uint8_t* rgba, uint32_t width, uint32_t height, bool perceptual, uint8_t* output, const ParallelForFunc& parallel_for = nullptr);
+// Only the red and green channels are stored
+bool compressBC5(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* output, const ParallelForFunc& parallel_for = nullptr);
+
+}  // namespace nv_bcenc
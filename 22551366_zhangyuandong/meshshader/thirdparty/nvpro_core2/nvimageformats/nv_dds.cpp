@@ -1720,6 +1720,21 @@ ErrorWithText Image::readFromStream(std::istream& input, const ReadSettings& rea
         {
           // Fast path: not bitmasked; read it directly from the input into
           // the subresource.
+          if(!m_mappedInput.empty())
+          {
+            // Zero-copy: reference the bytes of the mapped input instead.
+            const std::streamoff pos = input.tellg();
+            if(pos < 0 || fileTexSize > m_mappedInput.size() - static_cast<size_t>(pos))
+            {
+              return "Referencing data for an image in a DDS input failed. Is the input truncated?";
+            }
+            resource.mapped = m_mappedInput.subspan(static_cast<size_t>(pos), fileTexSize);
+            if(!input.seekg(static_cast<std::streamoff>(fileTexSize), std::ios::cur))
+            {
+              return "Seeking past an image in a DDS input failed. Is the input truncated?";
+            }
+            continue;
+          }
           UNWRAP_ERROR(resource.create(fileTexSize, nullptr));
           if(!input.read(resource.data.data(), static_cast<std::streamsize>(fileTexSize)))
           {
@@ -1755,6 +1770,19 @@ ErrorWithText Image::readFromMemory(const char* buffer, size_t bufferSize, const
   return readFromStream(stream, readSettings);
 }
 
+ErrorWithText Image::readFromMappedMemory(const char* buffer, size_t bufferSize, const ReadSettings& readSettings)
+{
+  if(bufferSize > static_cast<size_t>(std::numeric_limits<std::streamsize>::max()))
+  {
+    return "The `bufferSize` parameter was too large to be stored in an std::streamsize.";
+  }
+  MemoryStream stream(buffer, bufferSize);
+  m_mappedInput                 = std::span<const char>(buffer, bufferSize);
+  const ErrorWithText maybeError = readFromStream(stream, readSettings);
+  m_mappedInput                 = {};
+  return maybeError;
+}
+
 ErrorWithText Image::writeToStream(std::ostream& output, const WriteSettings& writeSettings)
 {
   //---------------------------------------------------------------------------
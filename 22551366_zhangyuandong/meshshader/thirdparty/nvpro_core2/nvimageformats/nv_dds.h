@@ -76,6 +76,7 @@ absolutely necessary, consider using a library such as NVTT.)
 #include <cstdint>
 #include <iostream>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -223,7 +224,12 @@ struct Subresource
   // Frees image data and resets the size.
   void clear();
 
-  std::vector<char> data;  // The image's raw data.
+  // The image's raw data: `data` when owned, else spans the buffer given to
+  // Image::readFromMappedMemory.
+  std::span<const char> bytes() const { return mapped.empty() ? std::span<const char>(data) : mapped; }
+
+  std::vector<char>     data;    // The image's raw data.
+  std::span<const char> mapped;  // Set instead of `data` by Image::readFromMappedMemory.
 };
 
 // Contains all the settings for reading DDS files.
@@ -356,6 +362,14 @@ public:
                                size_t              bufferSize,     // Its length in bytes.
                                const ReadSettings& readSettings);  // Settings for the reader.
 
+  // Like readFromMemory, but without copying the subresources that are stored
+  // as-is in the file (everything but bitmasked data): their `mapped` span
+  // points into `buffer`, which must outlive this image, e.g. an
+  // nvutils::FileReadMapping. Read the subresources with Subresource::bytes().
+  ErrorWithText readFromMappedMemory(const char*         buffer,         // The buffer in memory.
+                                     size_t              bufferSize,     // Its length in bytes.
+                                     const ReadSettings& readSettings);  // Settings for the reader.
+
 
   // Writes this structure in DDS format to a stream.
   ErrorWithText writeToStream(std::ostream&        output,          // The output stream, at the point to start writing
@@ -493,6 +507,9 @@ private:
 
   FileInfo m_fileInfo = {};
 
+  // The input of readFromMappedMemory, while it reads.
+  std::span<const char> m_mappedInput;
+
   // A structure containing all the image's encoded data. We store this in a
   // buffer with an entry per subresource, and provide accessors to it.
   std::vector<Subresource> m_data;
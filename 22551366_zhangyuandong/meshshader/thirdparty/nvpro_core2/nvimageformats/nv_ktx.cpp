@@ -24,6 +24,8 @@
 #include <atomic>
 #include <cassert>  // Some functions produce assertion errors to assist with debugging when NDEBUG is false.
 #include <fstream>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string.h>  // memcpy
@@ -85,6 +87,98 @@ bool GetNumSubresources(size_t a, size_t b, size_t c, size_t& out)
 {
   return checked_math::mul3(std::max(a, size_t(1)), std::max(b, size_t(1)), std::max(c, size_t(1)), out);
 }
+
+// Suports an std::istream interface that operates on an in-memory array.
+class MemoryStreamBuffer : public std::basic_streambuf<char>
+{
+  char*           m_data        = nullptr;
+  std::streamoff  m_nextIndex   = 0;  // Always in [0, m_sizeInBytes].
+  std::streamsize m_sizeInBytes = 0;
+
+public:
+  MemoryStreamBuffer(char* data, std::streamsize sizeInBytes)
+      : m_data(data)
+      , m_sizeInBytes(sizeInBytes)
+  {
+  }
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) override
+  {
+    const pos_type indicatesError = pos_type(static_cast<off_type>(-1));
+    switch(dir)
+    {
+      case std::ios_base::beg:
+        if(off < 0 || off > m_sizeInBytes)
+          return indicatesError;
+        m_nextIndex = off;
+        break;
+      case std::ios_base::cur:
+        if(((off < 0) && m_nextIndex + off < 0) || (off >= 0 && off > m_sizeInBytes - m_nextIndex))
+          return indicatesError;
+        m_nextIndex += off;
+        break;
+      case std::ios_base::end:
+        if(off > 0 || off < -m_sizeInBytes)
+          return indicatesError;
+        m_nextIndex = m_sizeInBytes + off;
+        break;
+      default:
+        return indicatesError;
+    }
+    return m_nextIndex;
+  }
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) override
+  {
+    return seekoff(static_cast<off_type>(pos), std::ios_base::beg, which);
+  }
+  // Gets the number of characters certainly available.
+  std::streamsize showmanyc() override { return m_sizeInBytes - m_nextIndex; }
+  // Gets the next character advancing the read pointer; EOF on error.
+  int_type uflow() override
+  {
+    if(m_nextIndex < m_sizeInBytes)
+    {
+      return traits_type::to_int_type(m_data[m_nextIndex++]);
+    }
+    return traits_type::eof();
+  }
+  // Gets the next character without advancing the read pointer; EOF on error.
+  int_type underflow() override
+  {
+    if(m_nextIndex < m_sizeInBytes)
+    {
+      return traits_type::to_int_type(m_data[m_nextIndex]);
+    }
+    return traits_type::eof();
+  }
+  // Reads a given number of characters and stores them into s' character array.
+  // Returns the number of characters successfully read.
+  std::streamsize xsgetn(char_type* s, std::streamsize count) override
+  {
+    if(count < 0 || s == nullptr || m_nextIndex >= m_sizeInBytes)
+    {
+      return 0;
+    }
+    const std::streamsize readableChars = std::min(count, m_sizeInBytes - m_nextIndex);
+    memcpy(s, m_data + m_nextIndex, readableChars);
+    m_nextIndex += readableChars;
+    return readableChars;
+  }
+};
+
+// An std::istream interface for a constant, in-memory array.
+// Note that Clang emits a Wreorder-ctor warning unless the memory buffer
+// members are listed before the istream, so we use multiple inheritance
+// here to put them in the right order.
+class MemoryStream : private MemoryStreamBuffer, public std::istream
+{
+public:
+  MemoryStream(const char* data, std::streamsize sizeInBytes)
+      : MemoryStreamBuffer(const_cast<char*>(data), sizeInBytes)
+      , std::istream(this)
+  {
+    rdbuf(this);
+  }
+};
 }  // namespace
 
 ErrorWithText KTXImage::allocate(uint32_t _num_mips, uint32_t _num_layers, uint32_t _num_faces)
@@ -100,12 +194,18 @@ ErrorWithText KTXImage::allocate(uint32_t _num_mips, uint32_t _num_layers, uint3
   {
     return "Computing the required number of subresources overflowed a size_t!";
   }
+  const ErrorWithText maybeError = ResizeVectorOrError(mapped_data, num_subresources);
+  if(maybeError.has_value())
+  {
+    return maybeError;
+  }
   return ResizeVectorOrError(data, num_subresources);
 }
 
 void KTXImage::clear()
 {
   data.clear();
+  mapped_data.clear();
 }
 
 std::vector<char>& KTXImage::subresource(uint32_t mip, uint32_t layer, uint32_t face)
@@ -122,6 +222,13 @@ std::vector<char>& KTXImage::subresource(uint32_t mip, uint32_t layer, uint32_t
   return data[(size_t(mip) * size_t(num_layers_clamped) + size_t(layer)) * size_t(num_faces) + size_t(face)];
 }
 
+std::span<const char> KTXImage::subresourceView(uint32_t mip, uint32_t layer, uint32_t face)
+{
+  const std::vector<char>& owned = subresource(mip, layer, face);  // Checks the range
+  const size_t             index = &owned - data.data();
+  return mapped_data[index].empty() ? std::span<const char>(owned) : mapped_data[index];
+}
+
 VkImageType KTXImage::getImageType() const
 {
   if(mip_0_width == 0)
@@ -1004,11 +1111,66 @@ struct ScopedZlibDStream
     stream.next_in  = Z_NULL;
     return inflateInit(&stream);
   }
+  // Reuses the state of an initialized stream for new data
+  int      Reset() { return (stream.state != Z_NULL) ? inflateReset(&stream) : Init(); }
   void     Free() { inflateEnd(&stream); }
   z_stream stream{};
 };
 #endif
 
+// Hands out (de)compression contexts to the jobs of the parallel mip loops. A released
+// context is reused by the next job, so there are at most as many contexts as jobs
+// running at the same time, whatever the parallel_for runs them on.
+template <class Context>
+class ContextPool
+{
+public:
+  std::unique_ptr<Context> acquire()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_free.empty())
+    {
+      return std::make_unique<Context>();
+    }
+    std::unique_ptr<Context> context = std::move(m_free.back());
+    m_free.pop_back();
+    return context;
+  }
+  void release(std::unique_ptr<Context> context)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(std::move(context));
+  }
+
+private:
+  std::mutex                            m_mutex;
+  std::vector<std::unique_ptr<Context>> m_free;
+};
+
+// Runs job(i) for i in [0, numJobs) through parallel_for if set, else in order, and returns the first error by index.
+static ErrorWithText RunJobs(const ParallelForFunc& parallel_for, size_t numJobs, const std::function<ErrorWithText(size_t)>& job)
+{
+  if(!parallel_for || numJobs < 2)
+  {
+    for(size_t i = 0; i < numJobs; i++)
+    {
+      ErrorWithText jobError = job(i);
+      if(jobError.has_value())
+        return jobError;
+    }
+    return {};
+  }
+
+  std::vector<ErrorWithText> jobErrors(numJobs);
+  parallel_for(numJobs, [&](size_t i) { jobErrors[i] = job(i); });
+  for(ErrorWithText& jobError : jobErrors)
+  {
+    if(jobError.has_value())
+      return jobError;
+  }
+  return {};
+}
+
 #ifdef NVP_SUPPORTS_BASISU
 
 // Stores data per-image that is required to transcode a BasisLZ+ETC1S image.
@@ -1627,7 +1789,10 @@ ErrorWithText KTXImage::readFromKTX2Stream(std::istream& input, const ReadSettin
 
 // Initialize supercompression
 #ifdef NVP_SUPPORTS_ZSTD
-  ScopedZstdDContext zstdDCtx;
+  ContextPool<ScopedZstdDContext> zstdDCtxPool;  // One context per concurrent inflation job
+#endif
+#ifdef NVP_SUPPORTS_GZLIB
+  ContextPool<ScopedZlibDStream> zlibDStreamPool;
 #endif
 #ifdef NVP_SUPPORTS_BASISU
   BasisLZDecompressionObjects basisLZDCtx;
@@ -1683,11 +1848,13 @@ ErrorWithText KTXImage::readFromKTX2Stream(std::istream& input, const ReadSettin
   {
     // Set up Zstandard
 #ifdef NVP_SUPPORTS_ZSTD
-    zstdDCtx.Init();
-    if(zstdDCtx.pCtx == nullptr)
+    std::unique_ptr<ScopedZstdDContext> zstdDCtx = zstdDCtxPool.acquire();
+    zstdDCtx->Init();
+    if(zstdDCtx->pCtx == nullptr)
     {
       return "Initializing Zstandard context failed.";
     }
+    zstdDCtxPool.release(std::move(zstdDCtx));
 #else
     return "KTX2 stream uses Zstandard supercompression, but nv_ktx was built without Zstd.";
 #endif
@@ -1711,12 +1878,9 @@ ErrorWithText KTXImage::readFromKTX2Stream(std::istream& input, const ReadSettin
   // For each mip:
   //   If uncompressed:
   //     Copy each subresource
-  //   Else if Zstd:
-  //     Zstd decompress the mip data
-  //     Copy each subresource
-  //   Else if Zlib:
-  //     Zlib decompress the mip data
-  //     Copy each subresource
+  //   Else if Zstd or Zlib:
+  //     Read the supercompressed mip data
+  //     (once all mips are read: decompress the mips in parallel, then copy each subresource)
   //   Else if Basis ETC1S+BasisLZ:
   //     BasisLZ decompress the mip data to 1 or 2 ETC1S slices.
   //     For each subresource
@@ -1728,9 +1892,97 @@ ErrorWithText KTXImage::readFromKTX2Stream(std::istream& input, const ReadSettin
 
   // First initialize the output:
   UNWRAP_ERROR(allocate(num_mips, num_layers_possibly_0, num_faces));
-  // Temporary buffers used for supercompressed data.
-  std::vector<char> supercompressedData;
+  // Temporary buffer used for the data of the ETC1S and UASTC mips.
   std::vector<char> inflatedData;
+  // Subresources to transcode, with the inflated data of their mip
+  struct TranscodeJob
+  {
+    uint32_t mip;
+    uint32_t layer;
+    uint32_t face;
+    size_t   inflatedDataPos;
+  };
+  std::vector<TranscodeJob>      transcodeJobs;
+  std::vector<std::vector<char>> transcodeInputs(num_mips);
+  // Zstd and Zlib mips, inflated once they have all been read. They are independent, unlike the reads from the stream.
+  struct InflateJob
+  {
+    uint32_t          mip;
+    size_t            inflatedFaceSize;
+    size_t            finalFaceSize;
+    std::vector<char> supercompressedData;
+    std::vector<char> inflatedData;
+  };
+  std::vector<InflateJob> inflateJobs;
+
+  // Writes the inflated data of a mip into each subresource. The UASTC and ETC1S ones are
+  // transcoded to this->format once all mips have been read, see below.
+  auto storeMip = [&](uint32_t mip, std::vector<char>& inflatedData, size_t inflatedFaceSize, size_t finalFaceSize) -> ErrorWithText {
+    // Check size ahead of time to ensure we don't read out of bounds.
+    // This would otherwise result in an access violation on
+    // invalid_face_count_and_padding.ktx2, or on an otherwise truncated file.
+    // This doesn't apply to ETC1S, because it does inflation and transcoding
+    // all at once.
+    if(header.supercompressionScheme != 1)
+    {
+      const size_t inflatedDataSize = inflatedData.size();
+      const size_t expected_bytes_in_this_mip = inflatedFaceSize * size_t(header.layerCount) * size_t(header.faceCount);
+      if(expected_bytes_in_this_mip > inflatedDataSize)
+      {
+        return "Expected " + std::to_string(expected_bytes_in_this_mip) + " bytes in mip " + std::to_string(mip)
+               + ", but the inflated data was only " + std::to_string(inflatedDataSize) + " bytes long.";
+      }
+    }
+
+    size_t inflatedDataPos = 0;  // Read position in inflatedData
+    for(uint32_t layer = 0; layer < header.layerCount; layer++)
+    {
+      for(uint32_t face = 0; face < header.faceCount; face++)
+      {
+        std::vector<char>& subresource_data = subresource(mip, layer, face);
+        // As a fast-path, if we have only one layer and face and no transcoding, the output is the same as the input.
+        if(header.layerCount == 1 && header.faceCount == 1 && input_supercompression == InputSupercompression::eNone)
+        {
+          subresource_data = std::move(inflatedData);
+          break;  // since layerCount == 1 this breaks out of both loops.
+        }
+        // Otherwise, prepare the output buffer.
+        UNWRAP_ERROR(ResizeVectorOrError(subresource_data, finalFaceSize));
+
+        if(input_supercompression != InputSupercompression::eNone)
+        {
+          transcodeJobs.push_back({mip, layer, face, inflatedDataPos});
+        }
+        else
+        {
+          // Not UASTC or ETC1S, no transcoding needed
+          // We've checked to make sure this is okay above, but double-check
+          // here in case the behavior above changes in future versions of
+          // the code.
+          if(header.supercompressionScheme == 1)
+          {
+            return "Failed to read KTX2 file: BasisLZ supercompression was enabled, but control reached the non-BasisLZ copy. This should never happen.";
+          }
+          if(inflatedDataPos + inflatedFaceSize > inflatedData.size())
+          {
+            return "Failed to read KTX2 file: the size of the inflated data didn't match the expected size.";
+          }
+          memcpy(subresource_data.data(), &inflatedData[inflatedDataPos], inflatedFaceSize);
+        }
+
+        // Advance to next image
+        inflatedDataPos += inflatedFaceSize;
+      }
+    }
+
+    // The transcoding jobs of this mip read from its inflated data
+    if(input_supercompression != InputSupercompression::eNone)
+    {
+      transcodeInputs[mip] = std::move(inflatedData);
+    }
+    return {};
+  };
+
   // Traverse mips in reverse order following the spec
   for(int mip = num_mips - 1; mip >= 0; mip--)
   {
@@ -1828,6 +2080,23 @@ ErrorWithText KTXImage::readFromKTX2Stream(std::istream& input, const ReadSettin
         for(uint32_t face = 0; face < header.faceCount; face++)
         {
           std::vector<char>& subresource_data = subresource(mip, layer, face);
+          if(!mapped_input.empty())
+          {
+            // Zero-copy: reference the bytes of the mapped input instead.
+            const std::streamoff pos = input.tellg();
+            if(pos < 0 || finalFaceSize > mapped_input.size() - size_t(pos))
+            {
+              return "Referencing data for mip " + std::to_string(mip) + " layer " + std::to_string(layer) + " face "
+                     + std::to_string(face) + " in the input failed. Is the input truncated?";
+            }
+            mapped_data[&subresource_data - data.data()] = mapped_input.subspan(size_t(pos), finalFaceSize);
+            if(!input.seekg(std::streamoff(finalFaceSize), std::ios::cur))
+            {
+              return "Seeking past mip " + std::to_string(mip) + " layer " + std::to_string(layer) + " face "
+                     + std::to_string(face) + " in the input failed. Is the input truncated?";
+            }
+            continue;
+          }
           UNWRAP_ERROR(ResizeVectorOrError(subresource_data, finalFaceSize));
           if(!input.read(subresource_data.data(), finalFaceSize))
           {
@@ -1866,162 +2135,172 @@ ErrorWithText KTXImage::readFromKTX2Stream(std::istream& input, const ReadSettin
       }
       else
       {
-        // Read into supercompressedData
-        UNWRAP_ERROR(ResizeVectorOrError(supercompressedData, levelIndex.byteLength));
-        if(!input.read(supercompressedData.data(), levelIndex.byteLength))
+        // Read into supercompressedData; the mips are inflated below, once they have all been read
+        InflateJob& job = inflateJobs.emplace_back();
+        job.mip              = uint32_t(mip);
+        job.inflatedFaceSize = inflatedFaceSize;
+        job.finalFaceSize    = finalFaceSize;
+        UNWRAP_ERROR(ResizeVectorOrError(job.supercompressedData, levelIndex.byteLength));
+        if(!input.read(job.supercompressedData.data(), levelIndex.byteLength))
         {
           return "Reading mip " + std::to_string(mip) + "'s supercompressed data failed.";
         }
 
-        // Inflate the supercompressed data. We must use another buffer for this.
-        UNWRAP_ERROR(ResizeVectorOrError(inflatedData, levelIndex.uncompressedByteLength));
+        // The supercompressed data is inflated into another buffer.
+        UNWRAP_ERROR(ResizeVectorOrError(job.inflatedData, levelIndex.uncompressedByteLength));
+        continue;
+      }
 
-        if(header.supercompressionScheme == 2)
-        {
-          // Zstandard
+      UNWRAP_ERROR(storeMip(uint32_t(mip), inflatedData, inflatedFaceSize, finalFaceSize));
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  // Inflate the Zstd and Zlib mips. Each job only writes its own buffer, so they
+  // run in parallel through readSettings.parallel_for, each with a context of the pools.
+  auto inflateMip = [&](InflateJob& job) -> ErrorWithText {
+    const std::string mipString = std::to_string(job.mip);
+    if(header.supercompressionScheme == 2)
+    {
+      // Zstandard
 #ifdef NVP_SUPPORTS_ZSTD
-          size_t zstdError = ZSTD_decompress(inflatedData.data(), inflatedData.size(),  //
-                                             supercompressedData.data(), supercompressedData.size());
-          if(ZSTD_isError(zstdError))
-          {
-            const char* zstdErrorName = ZSTD_getErrorName(zstdError);
-            return "Mip " + std::to_string(mip) + " Zstandard inflation failed with the message '"
-                   + std::string(zstdErrorName) + "' (code " + std::to_string(zstdError) + ").";
-          }
-#else
-          assert(!"nv_ktx was compiled without Zstandard support, but the KTX stream was not rejected! This should never happen.");
-#endif
-        }
-        else if(header.supercompressionScheme == 3)
+      std::unique_ptr<ScopedZstdDContext> zstdDCtx = zstdDCtxPool.acquire();
+      if(zstdDCtx->pCtx == nullptr)
+      {
+        zstdDCtx->Init();
+        if(zstdDCtx->pCtx == nullptr)
         {
-          // Zlib
-#ifdef NVP_SUPPORTS_GZLIB
-          ScopedZlibDStream zlibStream;
-          int               zlibError = zlibStream.Init();
-          if(zlibError != Z_OK)
-          {
-            return "Zlib initialization failed (error code " + std::to_string(zlibError) + ").";
-          }
-          if(supercompressedData.size() > UINT_MAX || inflatedData.size() > UINT_MAX)
-          {
-            return "Zlib compressed or decompressed data for mip " + std::to_string(mip) + " was larger than 4 GB.";
-          }
-          zlibStream.stream.next_in   = reinterpret_cast<Bytef*>(supercompressedData.data());
-          zlibStream.stream.avail_in  = static_cast<uInt>(supercompressedData.size());
-          zlibStream.stream.next_out  = reinterpret_cast<Bytef*>(inflatedData.data());
-          zlibStream.stream.avail_out = static_cast<uInt>(inflatedData.size());
-          zlibError                   = inflate(&zlibStream.stream, Z_NO_FLUSH);
-          if(zlibError != Z_OK)
-          {
-            return "Zlib inflation failed (error code " + std::to_string(zlibError) + ").";
-          }
-          zlibStream.Free();
+          return "Initializing Zstandard context failed.";
+        }
+      }
+      size_t zstdError = ZSTD_decompressDCtx(zstdDCtx->pCtx, job.inflatedData.data(), job.inflatedData.size(),  //
+                                             job.supercompressedData.data(), job.supercompressedData.size());
+      zstdDCtxPool.release(std::move(zstdDCtx));
+      if(ZSTD_isError(zstdError))
+      {
+        const char* zstdErrorName = ZSTD_getErrorName(zstdError);
+        return "Mip " + mipString + " Zstandard inflation failed with the message '" + std::string(zstdErrorName)
+               + "' (code " + std::to_string(zstdError) + ").";
+      }
 #else
-          assert(!"nv_ktx was compiled without Zlib support, but the KTX stream was not rejected! This should never happen.");
+      assert(!"nv_ktx was compiled without Zstandard support, but the KTX stream was not rejected! This should never happen.");
 #endif
-        }
+    }
+    else if(header.supercompressionScheme == 3)
+    {
+      // Zlib
+#ifdef NVP_SUPPORTS_GZLIB
+      if(job.supercompressedData.size() > UINT_MAX || job.inflatedData.size() > UINT_MAX)
+      {
+        return "Zlib compressed or decompressed data for mip " + mipString + " was larger than 4 GB.";
       }
-
-      // Check size ahead of time to ensure we don't read out of bounds.
-      // This would otherwise result in an access violation on
-      // invalid_face_count_and_padding.ktx2, or on an otherwise truncated file.
-      // This doesn't apply to ETC1S, because it does inflation and transcoding
-      // all at once.
-      if(header.supercompressionScheme != 1)
+      std::unique_ptr<ScopedZlibDStream> zlibStream = zlibDStreamPool.acquire();
+      int                                zlibError  = zlibStream->Reset();
+      if(zlibError != Z_OK)
       {
-        const size_t inflatedDataSize = inflatedData.size();
-        const size_t expected_bytes_in_this_mip = inflatedFaceSize * size_t(header.layerCount) * size_t(header.faceCount);
-        if(expected_bytes_in_this_mip > inflatedDataSize)
-        {
-          return "Expected " + std::to_string(expected_bytes_in_this_mip) + " bytes in mip " + std::to_string(mip)
-                 + ", but the inflated data was only " + std::to_string(inflatedDataSize) + " bytes long.";
-        }
+        return "Zlib initialization failed (error code " + std::to_string(zlibError) + ").";
       }
-
-      // Write into each subresource, possibly transcoding from the source
-      // format to this->format (for UASTC and ETC1S).
-      size_t inflatedDataPos = 0;  // Read position in inflatedData
-      for(uint32_t layer = 0; layer < header.layerCount; layer++)
+      zlibStream->stream.next_in   = reinterpret_cast<Bytef*>(job.supercompressedData.data());
+      zlibStream->stream.avail_in  = static_cast<uInt>(job.supercompressedData.size());
+      zlibStream->stream.next_out  = reinterpret_cast<Bytef*>(job.inflatedData.data());
+      zlibStream->stream.avail_out = static_cast<uInt>(job.inflatedData.size());
+      zlibError                    = inflate(&zlibStream->stream, Z_NO_FLUSH);
+      zlibDStreamPool.release(std::move(zlibStream));
+      if(zlibError != Z_OK && zlibError != Z_STREAM_END)
       {
-        for(uint32_t face = 0; face < header.faceCount; face++)
-        {
-          std::vector<char>& subresource_data = subresource(mip, layer, face);
-          // As a fast-path, if we have only one layer and face and no transcoding, the output is the same as the input.
-          if(header.layerCount == 1 && header.faceCount == 1 && input_supercompression == InputSupercompression::eNone)
-          {
-            subresource_data = std::move(inflatedData);
-            break;  // since layerCount == 1 this breaks out of both loops.
-          }
-          // Otherwise, prepare the output buffer.
-          UNWRAP_ERROR(ResizeVectorOrError(subresource_data, finalFaceSize));
-
-          if(input_supercompression == InputSupercompression::eBasisUASTC)
-          {
-#ifdef NVP_SUPPORTS_BASISU
-            BasisUSingleton::GetInstance().TranscodeUASTCToBC7OrASTC44(subresource_data.data(),
-                                                                       &inflatedData[inflatedDataPos], mipWidth, mipHeight,
-                                                                       mipDepth, readSettings.device_supports_astc);
+        return "Zlib inflation failed (error code " + std::to_string(zlibError) + ").";
+      }
 #else
-            assert(!"nv_ktx was compiled without Basis support, but the KTX stream was not rejected! This should never happen.");
+      assert(!"nv_ktx was compiled without Zlib support, but the KTX stream was not rejected! This should never happen.");
 #endif
-          }
-          else if(input_supercompression == InputSupercompression::eBasisETC1S)
-          {
+    }
+    // The supercompressed data is no longer needed
+    job.supercompressedData = {};
+    return {};
+  };
+  UNWRAP_ERROR(RunJobs(readSettings.parallel_for, inflateJobs.size(), [&](size_t i) { return inflateMip(inflateJobs[i]); }));
+  // Same order as the mip loop
+  for(InflateJob& job : inflateJobs)
+  {
+    UNWRAP_ERROR(storeMip(job.mip, job.inflatedData, job.inflatedFaceSize, job.finalFaceSize));
+  }
+
+  //---------------------------------------------------------------------------
+  // Transcode the UASTC and ETC1S subresources. Each job only writes its own
+  // subresource, so they can run in parallel; ETC1S video is the exception,
+  // since its P-frames depend on the state left by the previous frame.
+  if(!transcodeJobs.empty())
+  {
 #ifdef NVP_SUPPORTS_BASISU
-            // Get the ETC1S image description
-            const size_t etc1sImageIdx =
-                (std::max(1u, num_layers_possibly_0) * size_t(mip) + size_t(layer)) * size_t(num_faces) + size_t(face);
-            const basist::ktx2_etc1s_image_desc imageDesc  = basisLZDCtx.etc1sImageDescs[etc1sImageIdx];
-            const size_t                        numBlocksX = (mipWidth + 3) / 4;
-            const size_t                        numBlocksY = (mipHeight + 3) / 4;
-
-            if(!basisLZDCtx.etc1sTranscoder->transcode_image(
-                   basisDstFmt,                                      // Basis destination format
-                   subresource_data.data(),                          // Output data
-                   uint32_t(numBlocksX * numBlocksY),                // Number of blocks in the output
-                   reinterpret_cast<uint8_t*>(inflatedData.data()),  // Compressed data for this level
-                   uint32_t(inflatedData.size()),                    // Compressed data length
-                   uint32_t(numBlocksX), uint32_t(numBlocksY),       // Block dimensions
-                   uint32_t(mipWidth), uint32_t(mipHeight),          // Pixel dimensions
-                   uint32_t(mip),                                    // Mip number
-                   imageDesc.m_rgb_slice_byte_offset, imageDesc.m_rgb_slice_byte_length,  // Range of first slice from the start of the compressed data
-                   imageDesc.m_alpha_slice_byte_offset, imageDesc.m_alpha_slice_byte_length,  // Range of second slice from the start of the compressed data
-                   0,                                                    // No need for nonstandard decoder flags here
-                   (basisETC1SNumSlices == 2),                           // Whether it has 2 slices or only 1
-                   isVideo,                                              // Whether this is ETC1S video
-                   0,                                                    // Output row pitch in blocks, or 0
-                   &basisLZDCtx.ktx2TranscoderState.m_transcoder_state,  // Persistent transcoder state
-                   false))                                               // Output in blocks, not pixels
-            {
-              return "Failed to decompress BasisLZ+ETC1S mip " + std::to_string(mip) + ", layer "
-                     + std::to_string(layer) + ", face " + std::to_string(face) + "!";
-            }
-#else
-            assert(!"nv_ktx was compiled without Basis support, but the KTX stream was not rejected! This should never happen.");
-#endif
-          }
-          else
-          {
-            // Not UASTC or ETC1S, no transcoding needed
-            // We've checked to make sure this is okay above, but double-check
-            // here in case the behavior above changes in future versions of
-            // the code.
-            if(header.supercompressionScheme == 1)
-            {
-              return "Failed to read KTX2 file: BasisLZ supercompression was enabled, but control reached the non-BasisLZ copy. This should never happen.";
-            }
-            if(inflatedDataPos + inflatedFaceSize > inflatedData.size())
-            {
-              return "Failed to read KTX2 file: the size of the inflated data didn't match the expected size.";
-            }
-            memcpy(subresource_data.data(), &inflatedData[inflatedDataPos], inflatedFaceSize);
-          }
+    auto transcode = [&](const TranscodeJob& job, basist::basisu_transcoder_state* state) -> ErrorWithText {
+      const size_t       mipWidth         = std::max(1u, header.pixelWidth >> job.mip);
+      const size_t       mipHeight        = std::max(1u, header.pixelHeight >> job.mip);
+      const size_t       mipDepth         = std::max(1u, header.pixelDepth >> job.mip);
+      std::vector<char>& inflatedData     = transcodeInputs[job.mip];
+      std::vector<char>& subresource_data = subresource(job.mip, job.layer, job.face);
 
-          // Advance to next image
-          inflatedDataPos += inflatedFaceSize;
-        }
+      if(input_supercompression == InputSupercompression::eBasisUASTC)
+      {
+        BasisUSingleton::GetInstance().TranscodeUASTCToBC7OrASTC44(subresource_data.data(), &inflatedData[job.inflatedDataPos],
+                                                                   mipWidth, mipHeight, mipDepth, readSettings.device_supports_astc);
+        return {};
+      }
+
+      // Get the ETC1S image description
+      const size_t etc1sImageIdx =
+          (std::max(1u, num_layers_possibly_0) * size_t(job.mip) + size_t(job.layer)) * size_t(num_faces) + size_t(job.face);
+      const basist::ktx2_etc1s_image_desc imageDesc  = basisLZDCtx.etc1sImageDescs[etc1sImageIdx];
+      const size_t                        numBlocksX = (mipWidth + 3) / 4;
+      const size_t                        numBlocksY = (mipHeight + 3) / 4;
+
+      if(!basisLZDCtx.etc1sTranscoder->transcode_image(
+             basisDstFmt,                                      // Basis destination format
+             subresource_data.data(),                          // Output data
+             uint32_t(numBlocksX * numBlocksY),                // Number of blocks in the output
+             reinterpret_cast<uint8_t*>(inflatedData.data()),  // Compressed data for this level
+             uint32_t(inflatedData.size()),                    // Compressed data length
+             uint32_t(numBlocksX), uint32_t(numBlocksY),       // Block dimensions
+             uint32_t(mipWidth), uint32_t(mipHeight),          // Pixel dimensions
+             uint32_t(job.mip),                                // Mip number
+             imageDesc.m_rgb_slice_byte_offset, imageDesc.m_rgb_slice_byte_length,  // Range of first slice from the start of the compressed data
+             imageDesc.m_alpha_slice_byte_offset, imageDesc.m_alpha_slice_byte_length,  // Range of second slice from the start of the compressed data
+             0,                           // No need for nonstandard decoder flags here
+             (basisETC1SNumSlices == 2),  // Whether it has 2 slices or only 1
+             isVideo,                     // Whether this is ETC1S video
+             0,                           // Output row pitch in blocks, or 0
+             state,                       // Transcoder state
+             false))                      // Output in blocks, not pixels
+      {
+        return "Failed to decompress BasisLZ+ETC1S mip " + std::to_string(job.mip) + ", layer " + std::to_string(job.layer)
+               + ", face " + std::to_string(job.face) + "!";
+      }
+      return {};
+    };
+
+    if(readSettings.parallel_for && !isVideo)
+    {
+      std::vector<ErrorWithText> jobErrors(transcodeJobs.size());
+      readSettings.parallel_for(transcodeJobs.size(), [&](size_t i) {
+        basist::basisu_transcoder_state state;  // Only used by video P-frames, but must not be shared between threads
+        jobErrors[i] = transcode(transcodeJobs[i], &state);
+      });
+      for(ErrorWithText& jobError : jobErrors)
+      {
+        if(jobError.has_value())
+          return jobError;
+      }
+    }
+    else
+    {
+      // Same order as the mip loop, which video decoding relies on
+      for(const TranscodeJob& job : transcodeJobs)
+      {
+        UNWRAP_ERROR(transcode(job, &basisLZDCtx.ktx2TranscoderState.m_transcoder_state));
       }
     }
+#else
+    assert(!"nv_ktx was compiled without Basis support, but the KTX stream was not rejected! This should never happen.");
+#endif
   }
 
   return {};
@@ -2971,17 +3250,19 @@ ErrorWithText KTXImage::writeKTX2Stream(std::ostream& output, const WriteSetting
 
 // Zstandard supercompression context
 #ifdef NVP_SUPPORTS_ZSTD
-  ScopedZstdCContext zstdContext;
-  int                zstd_clamped_supercompression_level = writeSettings.supercompression_level;
+  ContextPool<ScopedZstdCContext> zstdCCtxPool;  // One context per concurrent supercompression job
+  int                             zstd_clamped_supercompression_level = writeSettings.supercompression_level;
 #endif
   if(writeSettings.supercompression == WriteSupercompressionType::ZSTD)
   {
 #ifdef NVP_SUPPORTS_ZSTD
-    zstdContext.Init();
-    if(zstdContext.pCtx == nullptr)
+    std::unique_ptr<ScopedZstdCContext> zstdCCtx = zstdCCtxPool.acquire();
+    zstdCCtx->Init();
+    if(zstdCCtx->pCtx == nullptr)
     {
       return "Initializing the Zstandard context for supercompression failed!";
     }
+    zstdCCtxPool.release(std::move(zstdCCtx));
 
     // Clamp the compression level to Zstandard's min and max
     const int zstdMinLevel = ZSTD_minCLevel();
@@ -2996,6 +3277,83 @@ ErrorWithText KTXImage::writeKTX2Stream(std::ostream& output, const WriteSetting
 #endif
   }
 
+  // Supercompress all the mips before writing them. They are independent, so they
+  // run in parallel through writeSettings.parallel_for, each with a context of the pool.
+  std::vector<std::vector<char>> supercompressedMips(num_mips);
+#ifdef NVP_SUPPORTS_ZSTD
+  if(writeSettings.supercompression == WriteSupercompressionType::ZSTD)
+  {
+    UNWRAP_ERROR(RunJobs(writeSettings.parallel_for, num_mips, [&](size_t mip) -> ErrorWithText {
+      const size_t mipWidth  = std::max(1u, mip_0_width >> mip);
+      const size_t mipHeight = std::max(1u, mip_0_height >> mip);
+      const size_t mipDepth  = std::max(1u, mip_0_depth >> mip);
+
+      size_t subresource_size_bytes = 0;
+      UNWRAP_ERROR(ExportSizeExtended(mipWidth, mipHeight, mipDepth, format, subresource_size_bytes, writeSettings.custom_size_callback));
+
+      // Concatenate all face data into a single buffer.
+      // (Note: could potentially have lower peak memory usage but be more
+      // complex using the Zstandard streaming API.)
+      std::vector<char> rawData;
+      {
+        UNWRAP_ERROR(ResizeVectorOrError(rawData, size_t(num_layers_or_1) * size_t(num_faces) * subresource_size_bytes));
+        size_t pos_in_raw_data = 0;
+        for(uint32_t layer = 0; layer < num_layers_or_1; layer++)
+        {
+          for(uint32_t face = 0; face < num_faces; face++)
+          {
+            const std::vector<char>& this_subresource = subresource(uint32_t(mip), layer, face);
+            assert(this_subresource.size() == subresource_size_bytes);
+            memcpy(&rawData[pos_in_raw_data], this_subresource.data(), this_subresource.size());
+            pos_in_raw_data += this_subresource.size();
+          }
+        }
+      }
+
+      // Also allocate a buffer with the maximum possible compressed size needed.
+      // (Note that this is always larger than the source!)
+      // Also note that we'll always write the supercompressed data even when
+      // it's larger, as the client controls whether supercompression is used.
+      std::vector<char>& supercompressedData = supercompressedMips[mip];
+      try
+      {
+        supercompressedData.resize(ZSTD_COMPRESSBOUND(rawData.size()));
+      }
+      catch(...)
+      {
+        return "Allocating memory for Zstandard supercompressed output failed!";
+      }
+
+      // Compress!
+      std::unique_ptr<ScopedZstdCContext> zstdCCtx = zstdCCtxPool.acquire();
+      if(zstdCCtx->pCtx == nullptr)
+      {
+        zstdCCtx->Init();
+        if(zstdCCtx->pCtx == nullptr)
+        {
+          return "Initializing the Zstandard context for supercompression failed!";
+        }
+      }
+      size_t errOrSize = ZSTD_compressCCtx(zstdCCtx->pCtx, supercompressedData.data(), supercompressedData.size(),
+                                           rawData.data(), rawData.size(), zstd_clamped_supercompression_level);
+      zstdCCtxPool.release(std::move(zstdCCtx));
+      if(ZSTD_isError(errOrSize))
+      {
+        return "Zstandard supercompression returned error " + std::to_string(errOrSize) + ".";
+      }
+
+      if(errOrSize > supercompressedData.size())
+      {
+        assert(false);  // This should never happen
+        return "ZSTD_compressCCtx returned a number that was larger than the size of the supercompressed data "
+               "buffer.";
+      }
+      supercompressedData.resize(errOrSize);
+      return {};
+    }));
+  }
+#endif
+
   // Write mips from smallest to largest.
   for(int64_t mip = static_cast<int64_t>(num_mips) - 1; mip >= 0; mip--)
   {
@@ -3057,62 +3415,16 @@ ErrorWithText KTXImage::writeKTX2Stream(std::ostream& output, const WriteSetting
       {
         return "Only Zstandard supercompression is currently supported.";
       }
-      // Concatenate all face data into a single buffer.
-      // (Note: could potentially have lower peak memory usage but be more
-      // complex using the Zstandard streaming API.)
-      std::vector<char> rawData;
-      {
-        UNWRAP_ERROR(ResizeVectorOrError(rawData, levelIndex[mip].uncompressedByteLength));
-        size_t pos_in_raw_data = 0;
-        for(uint32_t layer = 0; layer < num_layers_or_1; layer++)
-        {
-          for(uint32_t face = 0; face < num_faces; face++)
-          {
-            const std::vector<char>& this_subresource = subresource(uint32_t(mip), layer, face);
-            assert(this_subresource.size() == subresource_size_bytes);
-            memcpy(&rawData[pos_in_raw_data], this_subresource.data(), this_subresource.size());
-            pos_in_raw_data += this_subresource.size();
-          }
-        }
-      }
-
-      // Also allocate a buffer with the maximum possible compressed size needed.
-      // (Note that this is always larger than the source!)
-      // Also note that we'll always write the supercompressed data even when
-      // it's larger, as the client controls whether supercompression is used.
-      const size_t      fullMipUncompressedLength = levelIndex[mip].uncompressedByteLength;
-      const size_t      supercompressedMaxSize    = ZSTD_COMPRESSBOUND(fullMipUncompressedLength);
-      std::vector<char> supercompressedData;
-      try
-      {
-        supercompressedData.resize(supercompressedMaxSize);
-      }
-      catch(...)
-      {
-        return "Allocating memory for Zstandard supercompressed output failed!";
-      }
-
-      // Compress!
-      size_t errOrSize = ZSTD_compressCCtx(zstdContext.pCtx, supercompressedData.data(), supercompressedData.size(),
-                                           rawData.data(), rawData.size(), zstd_clamped_supercompression_level);
-      if(ZSTD_isError(errOrSize))
-      {
-        return "Zstandard supercompression returned error " + std::to_string(errOrSize) + ".";
-      }
-
-      if(errOrSize > supercompressedData.size())
-      {
-        assert(false);  // This should never happen
-        return "ZSTD_compressCCtx returned a number that was larger than the size of the supercompressed data "
-               "buffer.";
-      }
+      // Supercompressed above
+      const std::vector<char>& supercompressedData = supercompressedMips[mip];
+      assert(!supercompressedData.empty());
 
       // Write the supercompressed data to the file.
-      if(!output.write(supercompressedData.data(), errOrSize))
+      if(!output.write(supercompressedData.data(), supercompressedData.size()))
       {
         return "Writing mip " + std::to_string(mip) + "'s supercompressed data to the file failed!";
       }
-      levelIndex[mip].byteLength = errOrSize;
+      levelIndex[mip].byteLength = supercompressedData.size();
 #endif
     }
   }
@@ -3203,6 +3515,19 @@ ErrorWithText KTXImage::readFromFile(const char* filename, const ReadSettings& r
   return readFromStream(input_stream, readSettings);
 }
 
+ErrorWithText KTXImage::readFromMappedMemory(const char* buffer, size_t bufferSize, const ReadSettings& readSettings)
+{
+  if(bufferSize > size_t(std::numeric_limits<std::streamsize>::max()))
+  {
+    return "The `bufferSize` parameter was too large to be stored in an std::streamsize.";
+  }
+  MemoryStream stream(buffer, std::streamsize(bufferSize));
+  mapped_input                   = std::span<const char>(buffer, bufferSize);
+  const ErrorWithText maybeError = readFromStream(stream, readSettings);
+  mapped_input                   = {};
+  return maybeError;
+}
+
 }  // namespace nv_ktx
 
 //-----------------------------------------------------------------------------
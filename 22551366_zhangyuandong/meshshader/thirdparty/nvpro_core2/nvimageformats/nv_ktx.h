@@ -38,9 +38,11 @@ Basis Universal-compressed formats.
 #define __NV_KTX_H__
 
 #include <array>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 #include <vulkan/vulkan_core.h>
@@ -64,6 +66,11 @@ using KeyValueData = std::map<std::string, std::vector<char>>;
 // return a string; if it succeeds, it should return {}.
 using CustomExportSizeFuncPtr = ErrorWithText (*)(size_t, size_t, size_t, VkFormat, size_t&);
 
+// Apps can run the inflation, transcoding and supercompression of files on their own threads.
+// The function should call `job(i)` for every i in [0, numJobs), in any order
+// and from any thread, and return once all of them have finished.
+using ParallelForFunc = std::function<void(size_t numJobs, const std::function<void(size_t)>& job)>;
+
 // Configurable settings for reading files. This is a struct so that it can
 // be extended in the future.
 struct ReadSettings
@@ -86,6 +93,11 @@ struct ReadSettings
   // By default, UASTC is transcoded to BC7 instead of ASTC. Setting this to
   // true will transcode UASTC to ASTC.
   bool device_supports_astc = false;
+  // If set, the Zstandard and Zlib mips (one job per mip) are inflated, and the
+  // Basis UASTC and ETC1S subresources (one job per mip, layer and face) are
+  // transcoded through this function once the file has been read, instead of
+  // one after the other while reading.
+  ParallelForFunc parallel_for = nullptr;
 };
 
 enum class WriteSupercompressionType
@@ -140,6 +152,9 @@ struct WriteSettings
   float rdo_lambda = 10.0f;
   // Enables Rate-Distortion Optimization for ETC1S.
   bool rdo_etc1s = true;
+  // If set, the mips are Zstandard supercompressed through this function
+  // (one job per mip) before being written, instead of one after the other.
+  ParallelForFunc parallel_for = nullptr;
 };
 
 // An enum for each of the possible elements in a ktxSwizzle value.
@@ -199,6 +214,9 @@ public:
   // Mutably accesses the subresource at the given mip, layer, and face. If the
   // given indices are out of range, throws an std::out_of_range exception.
   std::vector<char>& subresource(uint32_t mip = 0, uint32_t layer = 0, uint32_t face = 0);
+  // Same as subresource, or the span into the input of readFromMappedMemory
+  // when the subresource was not copied.
+  std::span<const char> subresourceView(uint32_t mip = 0, uint32_t layer = 0, uint32_t face = 0);
 
   // Reads this structure from a KTX stream, advancing the stream as well.
   // Returns an optional error message if the read failed.
@@ -209,6 +227,14 @@ public:
   ErrorWithText readFromFile(const char*         filename,       // The .ktx or .ktx2 file to read from.
                              const ReadSettings& readSettings);  // Settings for the reader
 
+  // Reads from a buffer in memory, without copying the KTX2 subresources that
+  // are stored as-is (no supercompression nor transcoding): they reference
+  // `buffer`, which must outlive this image, e.g. an nvutils::FileReadMapping.
+  // Read the subresources with subresourceView.
+  ErrorWithText readFromMappedMemory(const char*         buffer,         // The buffer in memory
+                                     size_t              bufferSize,     // Its length in bytes
+                                     const ReadSettings& readSettings);  // Settings for the reader
+
   // Writes this structure in KTX2 format to a stream.
   ErrorWithText writeKTX2Stream(std::ostream&        output,  // The output stream, at the point to start writing
                                 const WriteSettings& writeSettings);  // Settings for the writer
@@ -298,6 +324,10 @@ private:
   // image data. We store this in a buffer with an entry per subresource, and
   // provide accessors to it.
   std::vector<std::vector<char>> data;
+  // Per subresource, set instead of `data` when it references `mapped_input`.
+  std::vector<std::span<const char>> mapped_data;
+  // The input of readFromMappedMemory, while it reads.
+  std::span<const char> mapped_input;
 };
 
 }  // namespace nv_ktx
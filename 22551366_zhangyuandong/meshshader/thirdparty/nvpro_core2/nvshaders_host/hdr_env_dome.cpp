@@ -21,9 +21,12 @@
 #define _USE_MATH_DEFINES
 #include <array>
 #include <cmath>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <numeric>
 
+#include <fmt/format.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -35,6 +38,8 @@
 #include "nvvk/debug_util.hpp"
 #include "nvvk/compute_pipeline.hpp"
 #include "nvvk/descriptors.hpp"
+#include "nvutils/file_operations.hpp"
+#include "nvutils/logger.hpp"
 #include "nvutils/timers.hpp"
 #include "nvvk/check_error.hpp"
 #include "nvvk/default_structs.hpp"
@@ -334,27 +339,10 @@ void HdrEnvDome::prefilterHdr(uint32_t dim, nvvk::Image& target, const std::span
   VkSamplerCreateInfo samplerCreateInfo = DEFAULT_VkSamplerCreateInfo;
   samplerCreateInfo.maxLod              = static_cast<float>(numMipmaps);
 
-
-  {  // Target - cube
-    VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
-    imageInfo.flags             = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-    imageInfo.extent            = {dim, dim, 1};
-    imageInfo.imageType         = VK_IMAGE_TYPE_2D;
-    imageInfo.format            = format;
-    imageInfo.mipLevels         = numMipmaps;
-    imageInfo.arrayLayers       = 6;  // Cube
-    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
-                      | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-    VkImageViewCreateInfo imageView = DEFAULT_VkImageViewCreateInfo;
-    imageView.viewType              = VK_IMAGE_VIEW_TYPE_CUBE;
-
-
-    NVVK_CHECK(m_alloc->createImage(target, imageInfo, imageView));
-    NVVK_DBG_NAME(target.image);
-    NVVK_DBG_NAME(target.descriptor.imageView);
-    target.descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-    m_samplerPool->acquireSampler(target.descriptor.sampler, samplerCreateInfo);
+  createCubeImage(dim, numMipmaps, target);
+  if(loadCubeCache(dim, numMipmaps, target))
+  {
+    return;
   }
 
   nvvk::Image scratchTexture;
@@ -436,6 +424,153 @@ void HdrEnvDome::prefilterHdr(uint32_t dim, nvvk::Image& target, const std::span
   descPack.deinit();
 
   m_alloc->destroyImage(scratchTexture);
+
+  saveCubeCache(dim, numMipmaps, target);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Cube receiving the prefiltered environment, left in VK_IMAGE_LAYOUT_UNDEFINED
+//
+void HdrEnvDome::createCubeImage(uint32_t dim, uint32_t numMips, nvvk::Image& target)
+{
+  VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+  imageInfo.flags             = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+  imageInfo.extent            = {dim, dim, 1};
+  imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+  imageInfo.format            = VK_FORMAT_R16G16B16A16_SFLOAT;
+  imageInfo.mipLevels         = numMips;
+  imageInfo.arrayLayers       = 6;  // Cube
+  imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                    | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  VkImageViewCreateInfo imageView = DEFAULT_VkImageViewCreateInfo;
+  imageView.viewType              = VK_IMAGE_VIEW_TYPE_CUBE;
+
+  NVVK_CHECK(m_alloc->createImage(target, imageInfo, imageView));
+  NVVK_DBG_NAME(target.image);
+  NVVK_DBG_NAME(target.descriptor.imageView);
+  target.descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+  VkSamplerCreateInfo samplerCreateInfo = DEFAULT_VkSamplerCreateInfo;
+  samplerCreateInfo.maxLod              = static_cast<float>(numMips);
+  m_samplerPool->acquireSampler(target.descriptor.sampler, samplerCreateInfo);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Cache of the prefiltered cubes: a header followed by the RGBA16F texels, mip after mip,
+// each mip holding the 6 faces.
+//
+namespace {
+struct EnvDomeCacheHeader
+{
+  uint32_t magic       = 0x4D4F4445;  // "EDOM"
+  uint32_t version     = 1;
+  uint64_t contentHash = 0;
+  uint32_t dim         = 0;
+  uint32_t numMips     = 0;
+};
+
+constexpr VkDeviceSize kCubeTexelSize = 4 * sizeof(uint16_t);  // VK_FORMAT_R16G16B16A16_SFLOAT
+
+// Buffer layout of all the mips of a cube, returns the total size
+VkDeviceSize getCubeCopyRegions(uint32_t dim, uint32_t numMips, std::vector<VkBufferImageCopy>& regions)
+{
+  VkDeviceSize offset = 0;
+  for(uint32_t mip = 0; mip < numMips; mip++)
+  {
+    const uint32_t mipDim = std::max(dim >> mip, 1U);
+    regions.push_back({
+        .bufferOffset     = offset,
+        .imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 6},
+        .imageExtent      = {mipDim, mipDim, 1},
+    });
+    offset += VkDeviceSize(mipDim) * mipDim * 6 * kCubeTexelSize;
+  }
+  return offset;
+}
+}  // namespace
+
+bool HdrEnvDome::loadCubeCache(uint32_t dim, uint32_t numMips, nvvk::Image& target)
+{
+  if(m_cacheDirectory.empty())
+    return false;
+
+  const std::filesystem::path filename = m_cacheDirectory / fmt::format("{:016x}_{}_{}.envdome", m_contentHash, dim, numMips);
+  const std::string           data     = nvutils::loadFile(filename);
+
+  std::vector<VkBufferImageCopy> regions;
+  const VkDeviceSize             dataSize = getCubeCopyRegions(dim, numMips, regions);
+  EnvDomeCacheHeader             header;
+  if(data.size() != sizeof(header) + dataSize)
+    return false;
+  memcpy(&header, data.data(), sizeof(header));
+  if(header.magic != EnvDomeCacheHeader().magic || header.version != EnvDomeCacheHeader().version
+     || header.contentHash != m_contentHash || header.dim != dim || header.numMips != numMips)
+    return false;
+
+  nvutils::ScopedTimer st(__FUNCTION__);
+
+  nvvk::Buffer staging;
+  NVVK_CHECK(m_alloc->createBuffer(staging, dataSize, VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                                   VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT));
+  memcpy(staging.mapping, data.data() + sizeof(header), dataSize);
+  NVVK_CHECK(m_alloc->autoFlushBuffer(staging));
+
+  VkCommandBuffer cmd{};
+  NVVK_CHECK(nvvk::beginSingleTimeCommands(cmd, m_device, m_transientCmdPool));
+  VkImageSubresourceRange subresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, numMips, 0, 6};
+  nvvk::cmdImageMemoryBarrier(cmd, {target.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange});
+  vkCmdCopyBufferToImage(cmd, staging.buffer, target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         static_cast<uint32_t>(regions.size()), regions.data());
+  nvvk::cmdImageMemoryBarrier(cmd, {target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, subresourceRange});
+  NVVK_CHECK(nvvk::endSingleTimeCommands(cmd, m_device, m_transientCmdPool, m_queueInfo.queue));
+
+  m_alloc->destroyBuffer(staging);
+  return true;
+}
+
+void HdrEnvDome::saveCubeCache(uint32_t dim, uint32_t numMips, const nvvk::Image& target)
+{
+  if(m_cacheDirectory.empty())
+    return;
+
+  nvutils::ScopedTimer st(__FUNCTION__);
+
+  std::vector<VkBufferImageCopy> regions;
+  const VkDeviceSize             dataSize = getCubeCopyRegions(dim, numMips, regions);
+
+  nvvk::Buffer readback;
+  NVVK_CHECK(m_alloc->createBuffer(readback, dataSize, VK_BUFFER_USAGE_2_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                                   VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT));
+
+  VkCommandBuffer cmd{};
+  NVVK_CHECK(nvvk::beginSingleTimeCommands(cmd, m_device, m_transientCmdPool));
+  VkImageSubresourceRange subresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, numMips, 0, 6};
+  nvvk::cmdImageMemoryBarrier(cmd, {target.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, subresourceRange});
+  vkCmdCopyImageToBuffer(cmd, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer,
+                         static_cast<uint32_t>(regions.size()), regions.data());
+  nvvk::cmdImageMemoryBarrier(cmd, {target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, subresourceRange});
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_HOST_BIT,
+                         VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_HOST_READ_BIT);
+  NVVK_CHECK(nvvk::endSingleTimeCommands(cmd, m_device, m_transientCmdPool, m_queueInfo.queue));
+  NVVK_CHECK(m_alloc->autoInvalidateBuffer(readback));
+
+  std::error_code ec;
+  std::filesystem::create_directories(m_cacheDirectory, ec);
+
+  const std::filesystem::path filename = m_cacheDirectory / fmt::format("{:016x}_{}_{}.envdome", m_contentHash, dim, numMips);
+  std::ofstream               file(filename, std::ios::binary);
+  if(file)
+  {
+    const EnvDomeCacheHeader header{.contentHash = m_contentHash, .dim = dim, .numMips = numMips};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(static_cast<const char*>(readback.mapping), dataSize);
+  }
+  else
+  {
+    LOGW("Failed to open file for writing: %s\n", nvutils::utf8FromPath(filename).c_str());
+  }
+
+  m_alloc->destroyBuffer(readback);
 }
 
 
@@ -22,6 +22,7 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include <array>
+#include <filesystem>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -46,6 +47,10 @@ class Context;
  - hdr_prefilter_diffuse  : integrate the diffuse contribution in a cubemap
  - hdr_prefilter_glossy   : integrate the glossy reflection in a cubemap
 
+ With `setCache`, the prefiltered cubemaps are saved on disk and loaded back the next time
+ the same environment is used, skipping the prefiltering passes.
+ The key is typically `nvvk::HdrIbl::getContentHash()`.
+
 -------------------------------------------------------------------------------------------------*/
 class HdrEnvDome
 {
@@ -56,6 +61,12 @@ public:
   void init(nvvk::ResourceAllocator* allocator, nvvk::SamplerPool* samplerPool, const nvvk::QueueInfo& queueInfo);
   void deinit();
 
+  // To call before `create`, an empty directory disables the cache (default)
+  void setCache(const std::filesystem::path& directory, uint64_t contentHash)
+  {
+    m_cacheDirectory = directory;
+    m_contentHash    = contentHash;
+  }
 
   void create(VkDescriptorSet                  dstSet,
               VkDescriptorSetLayout            dstSetLayout,
@@ -102,6 +113,9 @@ private:
   VkCommandPool   m_transientCmdPool{};
   nvvk::QueueInfo m_queueInfo;
 
+  std::filesystem::path m_cacheDirectory;
+  uint64_t              m_contentHash{0};
+
   struct Textures
   {
     nvvk::Image diffuse;
@@ -113,6 +127,9 @@ private:
   void createDrawPipeline(const std::span<const uint32_t>& spirvDrawDome);
   void integrateBrdf(uint32_t dimension, nvvk::Image& target, const std::span<const uint32_t>& spirvIntegrateBrdf);
   void prefilterHdr(uint32_t dim, nvvk::Image& target, const std::span<const uint32_t>& spirvCode, bool doMipmap);
+  void createCubeImage(uint32_t dim, uint32_t numMips, nvvk::Image& target);
+  bool loadCubeCache(uint32_t dim, uint32_t numMips, nvvk::Image& target);
+  void saveCubeCache(uint32_t dim, uint32_t numMips, const nvvk::Image& target);
   void renderToCube(const VkCommandBuffer& cmd, nvvk::Image& target, nvvk::Image& scratch, VkPipelineLayout pipelineLayout, uint32_t dim, uint32_t numMips);
 };
 
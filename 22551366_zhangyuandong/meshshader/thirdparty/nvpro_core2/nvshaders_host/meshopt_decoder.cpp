@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+
+#include "meshopt_decoder.hpp"
+#include <nvvk/barriers.hpp>
+#include <nvvk/check_error.hpp>
+#include <nvvk/debug_util.hpp>
+
+// Formats of meshoptimizer, see vertexcodec.cpp and indexcodec.cpp
+static constexpr uint8_t s_vertexHeader     = 0xA0;
+static constexpr uint8_t s_indexHeader      = 0xE0;
+static constexpr uint8_t s_maxVersion       = 1;
+static constexpr size_t  s_vertexTailMinV0  = 32;
+static constexpr size_t  s_vertexTailMinV1  = 24;
+static constexpr size_t  s_indexCodeauxSize = 16;
+
+// Guaranteed maxComputeWorkGroupCount[0]
+static constexpr uint32_t s_maxGroupCount = 65535;
+
+VkResult nvshaders::MeshoptDecoder::init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv)
+{
+  assert(!m_device);
+  m_device = alloc->getDevice();
+
+  // Push constant, the jobs and the streams are read through their addresses
+  VkPushConstantRange pushConstantRange{.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .size = sizeof(shaderio::MeshoptDecodePushConstant)};
+
+  // Pipeline layout
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+      .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges    = &pushConstantRange,
+  };
+  NVVK_FAIL_RETURN(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout));
+  NVVK_DBG_NAME(m_pipelineLayout);
+
+  // Compute Pipeline
+  VkShaderModuleCreateInfo shaderInfo{
+      .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      .codeSize = spirv.size_bytes(),
+      .pCode    = spirv.data(),
+  };
+  VkComputePipelineCreateInfo compInfo{
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .stage =
+          {
+              .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+              .pNext = &shaderInfo,
+              .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+              .pName = "meshoptDecodeMain",
+          },
+      .layout = m_pipelineLayout,
+  };
+  NVVK_FAIL_RETURN(vkCreateComputePipelines(m_device, nullptr, 1, &compInfo, nullptr, &m_pipeline));
+  NVVK_DBG_NAME(m_pipeline);
+
+  return VK_SUCCESS;
+}
+
+void nvshaders::MeshoptDecoder::deinit()
+{
+  if(!m_device)
+    return;
+
+  assert(m_jobs.empty() && "Missing cmdDecodeAppended()");
+
+  vkDestroyPipeline(m_device, m_pipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+
+  m_pipelineLayout = VK_NULL_HANDLE;
+  m_pipeline       = VK_NULL_HANDLE;
+  m_device         = VK_NULL_HANDLE;
+}
+
+VkResult nvshaders::MeshoptDecoder::appendVertexBuffer(nvvk::StagingUploader&      uploader,
+                                                       const nvvk::Buffer&         buffer,
+                                                       VkDeviceSize                bufferOffset,
+                                                       uint32_t                    vertexCount,
+                                                       uint32_t                    vertexSize,
+                                                       std::span<const uint8_t>    encoded,
+                                                       const nvvk::SemaphoreState& semaphoreState)
+{
+  assert(vertexSize > 0 && vertexSize <= 256 && vertexSize % 4 == 0);
+  assert(bufferOffset + VkDeviceSize(vertexCount) * vertexSize <= buffer.bufferSize);
+
+  if(vertexCount == 0)
+    return VK_SUCCESS;
+
+  // The shader trusts the header and the tail: the last vertex, then the channels of version 1
+  if(encoded.empty() || (encoded[0] & 0xF0) != s_vertexHeader || (encoded[0] & 0x0F) > s_maxVersion)
+    return VK_ERROR_INITIALIZATION_FAILED;
+  const bool   version0 = (encoded[0] & 0x0F) == 0;
+  const size_t tailSize = vertexSize + (version0 ? 0 : vertexSize / 4);
+  if(encoded.size() < 1 + std::max(tailSize, version0 ? s_vertexTailMinV0 : s_vertexTailMinV1))
+    return VK_ERROR_INITIALIZATION_FAILED;
+
+  return appendJob(uploader, buffer, bufferOffset, encoded,
+                   {.count = vertexCount, .elementSize = vertexSize, .mode = shaderio::eMeshoptDecodeVertex}, semaphoreState);
+}
+
+VkResult nvshaders::MeshoptDecoder::appendIndexBuffer(nvvk::StagingUploader&      uploader,
+                                                      const nvvk::Buffer&         buffer,
+                                                      VkDeviceSize                bufferOffset,
+                                                      uint32_t                    indexCount,
+                                                      uint32_t                    indexSize,
+                                                      std::span<const uint8_t>    encoded,
+                                                      const nvvk::SemaphoreState& semaphoreState)
+{
+  assert(indexCount % 3 == 0 && (indexSize == 2 || indexSize == 4));
+  assert(bufferOffset + VkDeviceSize(indexCount) * indexSize <= buffer.bufferSize);
+
+  if(indexCount == 0)
+    return VK_SUCCESS;
+
+  // At least the header, a code per triangle and the codeaux table
+  if(encoded.size() < 1 + indexCount / 3 + s_indexCodeauxSize || (encoded[0] & 0xF0) != s_indexHeader
+     || (encoded[0] & 0x0F) > s_maxVersion)
+    return VK_ERROR_INITIALIZATION_FAILED;
+
+  return appendJob(uploader, buffer, bufferOffset, encoded,
+                   {.count = indexCount, .elementSize = indexSize, .mode = shaderio::eMeshoptDecodeIndex}, semaphoreState);
+}
+
+VkResult nvshaders::MeshoptDecoder::appendJob(nvvk::StagingUploader&      uploader,
+                                              const nvvk::Buffer&         buffer,
+                                              VkDeviceSize                bufferOffset,
+                                              std::span<const uint8_t>    encoded,
+                                              shaderio::MeshoptDecodeJob  job,
+                                              const nvvk::SemaphoreState& semaphoreState)
+{
+  assert(m_device && "Missing init()");
+  assert(buffer.address && bufferOffset % 4 == 0);
+
+  // The staging space is aligned, the shader reads it as uints
+  nvvk::BufferRange stagingSpace;
+  NVVK_FAIL_RETURN(uploader.acquireStagingSpace(stagingSpace, encoded.size(), encoded.data(), semaphoreState));
+  assert(stagingSpace.address % 4 == 0);
+
+  job.source      = (uint32_t*)stagingSpace.address;
+  job.destination = (uint32_t*)(buffer.address + bufferOffset);
+  job.sourceSize  = uint32_t(encoded.size());
+  m_jobs.push_back(job);
+
+  return VK_SUCCESS;
+}
+
+VkResult nvshaders::MeshoptDecoder::cmdDecodeAppended(VkCommandBuffer cmd, nvvk::StagingUploader& uploader, const nvvk::SemaphoreState& semaphoreState)
+{
+  NVVK_DBG_SCOPE(cmd);  // <-- Helps to debug in NSight
+  assert(m_device && "Missing init()");
+
+  if(m_jobs.empty())
+    return VK_SUCCESS;
+
+  nvvk::BufferRange jobSpace;
+  NVVK_FAIL_RETURN(uploader.acquireStagingSpace(jobSpace, std::span(m_jobs).size_bytes(), m_jobs.data(), semaphoreState));
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+  // One workgroup per job
+  for(uint32_t firstJob = 0; firstJob < uint32_t(m_jobs.size()); firstJob += s_maxGroupCount)
+  {
+    const shaderio::MeshoptDecodePushConstant pushConstant{
+        .jobs     = (shaderio::MeshoptDecodeJob*)jobSpace.address,
+        .firstJob = firstJob,
+    };
+    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstant), &pushConstant);
+    vkCmdDispatch(cmd, std::min(uint32_t(m_jobs.size()) - firstJob, s_maxGroupCount), 1, 1);
+  }
+
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                         VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT);
+
+  m_jobs.clear();
+  return VK_SUCCESS;
+}
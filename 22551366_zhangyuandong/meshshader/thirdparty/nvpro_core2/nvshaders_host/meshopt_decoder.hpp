@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+#include "nvvk/resource_allocator.hpp"
+#include "nvvk/staging.hpp"
+
+#include <nvshaders/meshopt_decode_io.h.slang>
+
+
+namespace nvshaders {
+
+//-----------------------------------------------------------------
+// Uploads meshoptimizer vertex and index streams (meshopt_encodeVertexBuffer, meshopt_encodeIndexBuffer)
+// as they are stored, and decodes them on the GPU with the compute shader `nvshaders/meshopt_decode.slang`:
+// the CPU only copies the encoded bytes to the staging memory, and only they cross PCIe.
+// This is the fallback of `nvvk::StagingUploader::appendBufferGDeflate` for GPUs without VK_NV_memory_decompression.
+//
+// - One workgroup decodes each stream, reading it from the staging memory of the `nvvk::StagingUploader`.
+//   The vertex streams decode their blocks of 256 vertices in parallel, the index streams are sequential:
+//   split large index buffers into several streams, e.g. one per group of meshlets.
+// - The destination offsets must be 4 byte aligned, 16-bit indices need storageBuffer16BitAccess.
+//
+// Usage:
+//   nvshaders::MeshoptDecoder decoder;
+//   decoder.init(&alloc, meshopt_decode_slang);  // SPIR-V compiled from nvshaders/meshopt_decode.slang
+//   decoder.appendVertexBuffer(uploader, vertexBuffer, 0, vertexCount, sizeof(Vertex), encodedVertices, semaphoreState);
+//   decoder.appendIndexBuffer(uploader, indexBuffer, 0, indexCount, sizeof(uint32_t), encodedIndices, semaphoreState);
+//   decoder.cmdDecodeAppended(cmd, uploader, semaphoreState);
+//   // the buffers are ready for the commands after the barrier ending cmdDecodeAppended
+//-----------------------------------------------------------------
+class MeshoptDecoder
+{
+public:
+  MeshoptDecoder() {};
+  ~MeshoptDecoder() { assert(m_device == VK_NULL_HANDLE); }  //  "Missing to call deinit"
+
+  VkResult init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv);
+  void     deinit();
+
+  // Copies the encoded stream to the staging space, decoded to `vertexCount * vertexSize` bytes at `bufferOffset`.
+  // Returns VK_ERROR_INITIALIZATION_FAILED when the stream is not a valid meshopt vertex stream of version 0 or 1.
+  VkResult appendVertexBuffer(nvvk::StagingUploader&      uploader,
+                              const nvvk::Buffer&         buffer,
+                              VkDeviceSize                bufferOffset,
+                              uint32_t                    vertexCount,
+                              uint32_t                    vertexSize,
+                              std::span<const uint8_t>    encoded,
+                              const nvvk::SemaphoreState& semaphoreState = {});
+
+  // Same for an index stream, `indexSize` is 2 or 4
+  VkResult appendIndexBuffer(nvvk::StagingUploader&      uploader,
+                             const nvvk::Buffer&         buffer,
+                             VkDeviceSize                bufferOffset,
+                             uint32_t                    indexCount,
+                             uint32_t                    indexSize,
+                             std::span<const uint8_t>    encoded,
+                             const nvvk::SemaphoreState& semaphoreState = {});
+
+  bool isAppendedEmpty() const { return m_jobs.empty(); }
+
+  // Records the decodes appended since the last call, the jobs are in staging space too.
+  // Ends with a barrier from the compute shader writes to all commands.
+  VkResult cmdDecodeAppended(VkCommandBuffer cmd, nvvk::StagingUploader& uploader, const nvvk::SemaphoreState& semaphoreState = {});
+
+private:
+  VkResult appendJob(nvvk::StagingUploader&      uploader,
+                     const nvvk::Buffer&         buffer,
+                     VkDeviceSize                bufferOffset,
+                     std::span<const uint8_t>    encoded,
+                     shaderio::MeshoptDecodeJob  job,
+                     const nvvk::SemaphoreState& semaphoreState);
+
+  VkDevice         m_device{};
+  VkPipelineLayout m_pipelineLayout{};
+  VkPipeline       m_pipeline{};
+
+  std::vector<shaderio::MeshoptDecodeJob> m_jobs;
+};
+
+
+}  // namespace nvshaders
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <algorithm>
+#include <array>
+
+#include "single_pass_downsampler.hpp"
+#include <nvvk/barriers.hpp>
+#include <nvvk/check_error.hpp>
+#include <nvvk/compute_pipeline.hpp>
+#include <nvvk/debug_util.hpp>
+
+VkResult nvshaders::SinglePassDownsampler::init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv)
+{
+  assert(!m_device);
+  m_alloc  = alloc;
+  m_device = alloc->getDevice();
+
+  // Atomic counters, cleared on the first dispatch
+  NVVK_FAIL_RETURN(alloc->createBuffer(m_counterBuffer, sizeof(uint32_t) * SPD_MAX_LAYERS,
+                                       VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
+                                       VMA_MEMORY_USAGE_AUTO));
+  NVVK_DBG_NAME(m_counterBuffer.buffer);
+  m_counterCleared = false;
+
+  // Shader descriptor set layout
+  nvvk::DescriptorBindings bindings;
+  bindings.addBinding(shaderio::SpdBinding::eSpdSource, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+  bindings.addBinding(shaderio::SpdBinding::eSpdMips, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, SPD_MAX_MIPS, VK_SHADER_STAGE_COMPUTE_BIT);
+  bindings.addBinding(shaderio::SpdBinding::eSpdCounter, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+
+  NVVK_CHECK(m_descriptorPack.init(bindings, m_device, 0, VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR));
+  NVVK_DBG_NAME(m_descriptorPack.getLayout());
+
+  // Push constant
+  VkPushConstantRange pushConstantRange{.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .size = sizeof(shaderio::SpdPushConstant)};
+
+  // Pipeline layout
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+      .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .setLayoutCount         = 1,
+      .pSetLayouts            = m_descriptorPack.getLayoutPtr(),
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges    = &pushConstantRange,
+  };
+  NVVK_FAIL_RETURN(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout));
+  NVVK_DBG_NAME(m_pipelineLayout);
+
+  // Compute Pipeline
+  VkShaderModuleCreateInfo shaderInfo{
+      .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      .codeSize = spirv.size_bytes(),
+      .pCode    = spirv.data(),
+  };
+  VkComputePipelineCreateInfo compInfo{
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .stage =
+          {
+              .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+              .pNext = &shaderInfo,
+              .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+              .pName = "spdDownsampleMain",
+          },
+      .layout = m_pipelineLayout,
+  };
+  NVVK_FAIL_RETURN(vkCreateComputePipelines(m_device, nullptr, 1, &compInfo, nullptr, &m_pipeline));
+  NVVK_DBG_NAME(m_pipeline);
+
+  return VK_SUCCESS;
+}
+
+void nvshaders::SinglePassDownsampler::deinit()
+{
+  if(!m_device)
+    return;
+
+  m_alloc->destroyBuffer(m_counterBuffer);
+
+  vkDestroyPipeline(m_device, m_pipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+  m_descriptorPack.deinit();
+
+  m_pipelineLayout = VK_NULL_HANDLE;
+  m_pipeline       = VK_NULL_HANDLE;
+  m_device         = VK_NULL_HANDLE;
+}
+
+void nvshaders::SinglePassDownsampler::cmdDownsample(VkCommandBuffer cmd, const DownsampleInfo& info)
+{
+  NVVK_DBG_SCOPE(cmd);  // <-- Helps to debug in NSight
+  assert(m_device && "Missing init()");
+  assert(info.layerCount <= SPD_MAX_LAYERS);
+
+  if(info.mips.empty())
+    return;
+
+  // The shader resets the counters when it completes, they only need clearing once
+  if(!m_counterCleared)
+  {
+    vkCmdFillBuffer(cmd, m_counterBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+    nvvk::cmdBufferMemoryBarrier(cmd, {.buffer        = m_counterBuffer.buffer,
+                                       .srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                                       .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                       .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                       .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT});
+    m_counterCleared = true;
+  }
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+  VkImageView   source       = info.source;
+  VkImageLayout sourceLayout = info.sourceLayout;
+  VkExtent2D    sourceSize   = info.sourceSize;
+  uint32_t      srcIsEncoded = 0;
+  uint32_t      firstMip     = 0;
+
+  while(firstMip < uint32_t(info.mips.size()))
+  {
+    // The last workgroup reduces a single 64x64 tile of the 6th mip, which covers sources up to 4096x4096
+    const uint32_t maxSize  = std::max(sourceSize.width, sourceSize.height);
+    const uint32_t maxMips  = maxSize <= SPD_TILE_SIZE * SPD_TILE_SIZE ? SPD_MAX_MIPS : 6;
+    const uint32_t mipCount = std::min(uint32_t(info.mips.size()) - firstMip, maxMips);
+
+    const VkExtent2D groupCounts = nvvk::getGroupCounts(sourceSize, SPD_TILE_SIZE);
+
+    const shaderio::SpdPushConstant pushConstant{
+        .srcSize          = {sourceSize.width, sourceSize.height},
+        .mipCount         = mipCount,
+        .numWorkGroups    = groupCounts.width * groupCounts.height,
+        .reduction        = uint32_t(info.reduction),
+        .srcIsSrgbEncoded = srcIsEncoded,
+    };
+    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstant), &pushConstant);
+
+    // All the array elements are statically used by the shader: the unused ones repeat the last mip, but are never accessed
+    std::array<VkDescriptorImageInfo, SPD_MAX_MIPS> mipInfos{};
+    for(uint32_t i = 0; i < SPD_MAX_MIPS; i++)
+    {
+      mipInfos[i] = {.imageView = info.mips[firstMip + std::min(i, mipCount - 1)], .imageLayout = VK_IMAGE_LAYOUT_GENERAL};
+    }
+
+    nvvk::WriteSetContainer writeSetContainer;
+    writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::SpdBinding::eSpdSource), source, sourceLayout);
+    writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::SpdBinding::eSpdMips), mipInfos.data());
+    writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::SpdBinding::eSpdCounter), m_counterBuffer);
+    vkCmdPushDescriptorSetKHR(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, writeSetContainer.size(),
+                              writeSetContainer.data());
+
+    vkCmdDispatch(cmd, groupCounts.width, groupCounts.height, info.layerCount);
+
+    // The mips are read by the next dispatch (or the caller), and the counters must not be shared by two dispatches in flight
+    nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                           VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                           VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    // Continue from the last written mip
+    firstMip     += mipCount;
+    source       = info.mips[firstMip - 1];
+    sourceLayout = VK_IMAGE_LAYOUT_GENERAL;
+    sourceSize   = {std::max(info.sourceSize.width >> firstMip, 1u), std::max(info.sourceSize.height >> firstMip, 1u)};
+    srcIsEncoded = info.reduction == shaderio::eSpdAverageSrgb ? 1 : 0;
+  }
+}
+
+VkResult nvshaders::SinglePassDownsampler::createMipViews(VkImage   image,
+                                                          VkFormat  sampledFormat,
+                                                          VkFormat  storageFormat,
+                                                          uint32_t  levelCount,
+                                                          uint32_t  layerCount,
+                                                          MipViews& views) const
+{
+  // Storage views are not allowed on sRGB formats: restrict each view to the usage of its format
+  VkImageViewUsageCreateInfo usageInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO,
+      .usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+  };
+  VkImageViewCreateInfo viewInfo{
+      .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .pNext            = &usageInfo,
+      .image            = image,
+      .viewType         = VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+      .format           = sampledFormat,
+      .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, layerCount},
+  };
+  NVVK_FAIL_RETURN(vkCreateImageView(m_device, &viewInfo, nullptr, &views.source));
+  NVVK_DBG_NAME(views.source);
+
+  // The mips are also sampled when the chain needs more than one dispatch
+  usageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  viewInfo.format = storageFormat;
+
+  views.mips.resize(levelCount > 1 ? levelCount - 1 : 0);
+  for(uint32_t level = 1; level < levelCount; level++)
+  {
+    viewInfo.subresourceRange.baseMipLevel = level;
+    NVVK_FAIL_RETURN(vkCreateImageView(m_device, &viewInfo, nullptr, &views.mips[level - 1]));
+    NVVK_DBG_NAME(views.mips[level - 1]);
+  }
+
+  return VK_SUCCESS;
+}
+
+void nvshaders::SinglePassDownsampler::destroyMipViews(MipViews& views) const
+{
+  vkDestroyImageView(m_device, views.source, nullptr);
+  for(VkImageView view : views.mips)
+  {
+    vkDestroyImageView(m_device, view, nullptr);
+  }
+  views = {};
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+#include "nvvk/resource_allocator.hpp"
+
+#include <nvshaders/spd_io.h.slang>
+#include <nvvk/descriptors.hpp>
+
+
+namespace nvshaders {
+
+//-----------------------------------------------------------------
+// Generates the mip chain of an image with the compute shader `nvshaders/spd_downsample.slang`,
+// up to SPD_MAX_MIPS levels per dispatch instead of one blit and barrier per level (`nvvk::cmdGenerateMipmaps`).
+//
+// - The source is a sampled image view, the destinations are storage views of the mips, in VK_IMAGE_LAYOUT_GENERAL.
+//   All the views are VK_IMAGE_VIEW_TYPE_2D_ARRAY, see `createMipViews`.
+// - sRGB images need VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT and the UNORM format for the mip views, with `eSpdAverageSrgb`.
+// - Min/max reductions allow building a Hi-Z pyramid, where the source is the depth buffer
+//   and the mips are all the levels of the pyramid.
+//
+// Usage:
+//   nvshaders::SinglePassDownsampler spd;
+//   spd.init(&alloc, spd_downsample_slang);  // SPIR-V compiled from nvshaders/spd_downsample.slang
+//   nvshaders::SinglePassDownsampler::MipViews views;
+//   spd.createMipViews(image.image, VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_R8G8B8A8_UNORM, mipLevels, 1, views);
+//   // level 0 in SHADER_READ_ONLY_OPTIMAL, and the other levels in GENERAL
+//   spd.cmdDownsample(cmd, {.source     = views.source,
+//                           .sourceSize = {width, height},
+//                           .mips       = views.mips,
+//                           .reduction  = shaderio::eSpdAverageSrgb});
+//   // once the command buffer completed
+//   spd.destroyMipViews(views);
+//-----------------------------------------------------------------
+class SinglePassDownsampler
+{
+public:
+  SinglePassDownsampler() {};
+  ~SinglePassDownsampler() { assert(m_device == VK_NULL_HANDLE); }  //  "Missing to call deinit"
+
+  VkResult init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv);
+  void     deinit();
+
+  struct DownsampleInfo
+  {
+    VkImageView                  source{};
+    VkImageLayout                sourceLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkExtent2D                   sourceSize{};
+    std::span<const VkImageView> mips;  // destinations, each half the size of the previous one
+    uint32_t                     layerCount = 1;
+    shaderio::SpdReduction       reduction  = shaderio::eSpdAverage;
+  };
+
+  // Records the dispatches, more than one only when the mips don't fit in a single one:
+  // more than SPD_MAX_MIPS levels, or more than 6 for sources larger than 4096.
+  // Ends with a compute shader write barrier.
+  void cmdDownsample(VkCommandBuffer cmd, const DownsampleInfo& info);
+
+  struct MipViews
+  {
+    VkImageView              source{};  // level 0, in `sampledFormat`
+    std::vector<VkImageView> mips;      // levels [1, levelCount), in `storageFormat`
+  };
+
+  // Views of all the levels of `image`, to be used for in-place mip generation
+  VkResult createMipViews(VkImage image, VkFormat sampledFormat, VkFormat storageFormat, uint32_t levelCount, uint32_t layerCount, MipViews& views) const;
+  void destroyMipViews(MipViews& views) const;
+
+private:
+  nvvk::ResourceAllocator* m_alloc{};
+
+  VkDevice             m_device{};
+  nvvk::DescriptorPack m_descriptorPack;
+  VkPipelineLayout     m_pipelineLayout{};
+  VkPipeline           m_pipeline{};
+
+  nvvk::Buffer m_counterBuffer;  // one uint per layer, reset by the shader after each dispatch
+  bool         m_counterCleared = false;
+};
+
+
+}  // namespace nvshaders
@@ -19,11 +19,15 @@
 
 #pragma once
 #include <array>
+#include <cstring>
+#include <type_traits>
 
 #include <glm/glm.hpp>
 
+#include <nvvk/barriers.hpp>
 #include <nvvk/check_error.hpp>
 #include <nvvk/debug_util.hpp>
+#include <nvvk/default_structs.hpp>
 #include <nvvk/resource_allocator.hpp>
 #include <vulkan/vulkan_core.h>
 
@@ -31,27 +35,43 @@
 
 
 namespace nvshaders {
+
+//--------------------------------------------------------------------------------------------------
+// Renders the sky of the simple or physical model to an image, one compute dispatch per frame.
+//
+// The physical sky is expensive to evaluate: it is baked into a sky-view LUT (azimuth and
+// elevation) when its parameters change, and the per-pixel pass only samples the LUT and adds the
+// sun disk, which is too small for the LUT. The shader is sky_physical.slang with its two entry
+// points, `main` and `bakeSkyLut`.
+//--------------------------------------------------------------------------------------------------
 template <typename SkyParams>
 class SkyBase
 {
 public:
+  // The physical sky is cached in a LUT, the simple sky is cheap enough to be evaluated directly
+  static constexpr bool       kUseSkyLut  = std::is_same_v<SkyParams, shaderio::SkyPhysicalParameters>;
+  static constexpr VkExtent2D kSkyLutSize = {256, 128};
+
   SkyBase() = default;
   virtual ~SkyBase() { assert(m_shader == VK_NULL_HANDLE); }  // "Missing to call deinit"
 
   void init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv)
   {
+    m_alloc  = alloc;
     m_device = alloc->getDevice();
 
     // Binding layout
     const auto layoutBindings = std::to_array<VkDescriptorSetLayoutBinding>({
         {.binding = shaderio::SkyBindings::eSkyOutImage, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+        {.binding = shaderio::SkyBindings::eSkyLutImage, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
+        {.binding = shaderio::SkyBindings::eSkyLut, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
     });
 
     // Descriptor set layout
     const VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{
         .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
         .flags        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT,
-        .bindingCount = uint32_t(layoutBindings.size()),
+        .bindingCount = kUseSkyLut ? uint32_t(layoutBindings.size()) : 1U,
         .pBindings    = layoutBindings.data(),
     };
     NVVK_CHECK(vkCreateDescriptorSetLayout(m_device, &descriptorSetLayoutInfo, nullptr, &m_descriptorSetLayout));
@@ -88,10 +108,40 @@ public:
     };
     vkCreateShadersEXT(m_device, 1U, &shaderInfo, nullptr, &m_shader);
     NVVK_DBG_NAME(m_shader);
+
+    if constexpr(kUseSkyLut)
+    {
+      shaderInfo.pName = "bakeSkyLut";
+      vkCreateShadersEXT(m_device, 1U, &shaderInfo, nullptr, &m_bakeShader);
+      NVVK_DBG_NAME(m_bakeShader);
+
+      VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+      imageInfo.extent            = {kSkyLutSize.width, kSkyLutSize.height, 1};
+      imageInfo.format            = VK_FORMAT_R16G16B16A16_SFLOAT;
+      imageInfo.usage             = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+      NVVK_CHECK(m_alloc->createImage(m_skyLut, imageInfo, DEFAULT_VkImageViewCreateInfo));
+      NVVK_DBG_NAME(m_skyLut.image);
+      NVVK_DBG_NAME(m_skyLut.descriptor.imageView);
+
+      // The azimuth wraps around, the elevation doesn't
+      VkSamplerCreateInfo samplerInfo = DEFAULT_VkSamplerCreateInfo;
+      samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+      NVVK_CHECK(vkCreateSampler(m_device, &samplerInfo, nullptr, &m_skyLut.descriptor.sampler));
+      NVVK_DBG_NAME(m_skyLut.descriptor.sampler);
+      m_skyLut.descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+      m_skyLutValid                   = false;
+    }
   }
 
   void deinit()
   {
+    if constexpr(kUseSkyLut)
+    {
+      vkDestroyShaderEXT(m_device, m_bakeShader, nullptr);
+      vkDestroySampler(m_device, m_skyLut.descriptor.sampler, nullptr);
+      m_alloc->destroyImage(m_skyLut);
+      m_bakeShader = VK_NULL_HANDLE;
+    }
     vkDestroyShaderEXT(m_device, m_shader, nullptr);
     vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
     vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
@@ -109,6 +159,14 @@ public:
   {
     NVVK_DBG_SCOPE(cmd);  // <-- Helps to debug in NSight
 
+    if constexpr(kUseSkyLut)
+    {
+      if(!m_skyLutValid || std::memcmp(&m_skyLutParams, &skyParam, sizeof(SkyParams)) != 0)
+      {
+        bakeSkyLut(cmd, skyParam, ioImage);
+      }
+    }
+
     // Bind shader
     const VkShaderStageFlagBits stages[1] = {VK_SHADER_STAGE_COMPUTE_BIT};
     vkCmdBindShadersEXT(cmd, 1, stages, &m_shader);
@@ -124,7 +182,20 @@ public:
 
 
     // Update descriptor sets
-    VkWriteDescriptorSet writeDescriptorSet[1]{
+    pushDescriptors(cmd, ioImage);
+
+    // Dispatching the compute job
+    vkCmdDispatch(cmd, (size.width + 15) / 16, (size.height + 15) / 16, 1);
+  }
+
+  // Forces the LUT to be baked again on the next runCompute, e.g. after the shader was reloaded
+  void invalidateSkyLut() { m_skyLutValid = false; }
+
+
+protected:
+  void pushDescriptors(VkCommandBuffer cmd, const VkDescriptorImageInfo& ioImage)
+  {
+    const VkWriteDescriptorSet writeDescriptorSet[3]{
         {
             .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
             .dstSet          = 0,
@@ -133,19 +204,69 @@ public:
             .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
             .pImageInfo      = &ioImage,
         },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = 0,
+            .dstBinding      = shaderio::SkyBindings::eSkyLutImage,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .pImageInfo      = &m_skyLut.descriptor,
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = 0,
+            .dstBinding      = shaderio::SkyBindings::eSkyLut,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo      = &m_skyLut.descriptor,
+        },
     };
-    vkCmdPushDescriptorSetKHR(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, writeDescriptorSet);
+    vkCmdPushDescriptorSetKHR(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, kUseSkyLut ? 3 : 1, writeDescriptorSet);
+  }
 
-    // Dispatching the compute job
-    vkCmdDispatch(cmd, (size.width + 15) / 16, (size.height + 15) / 16, 1);
+  // Evaluates the sky without the sun disk in all the directions of the LUT
+  void bakeSkyLut(VkCommandBuffer cmd, const SkyParams& skyParam, const VkDescriptorImageInfo& ioImage)
+  {
+    NVVK_DBG_SCOPE(cmd);
+
+    // The whole LUT is written, its previous content can be discarded
+    nvvk::cmdImageMemoryBarrier(cmd, {.image         = m_skyLut.image,
+                                      .oldLayout     = VK_IMAGE_LAYOUT_UNDEFINED,
+                                      .newLayout     = VK_IMAGE_LAYOUT_GENERAL,
+                                      .srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                      .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                      .srcAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                                      .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT});
+
+    const VkShaderStageFlagBits stages[1] = {VK_SHADER_STAGE_COMPUTE_BIT};
+    vkCmdBindShadersEXT(cmd, 1, stages, &m_bakeShader);
+    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SkyParams), &skyParam);
+    pushDescriptors(cmd, ioImage);
+    vkCmdDispatch(cmd, (kSkyLutSize.width + 15) / 16, (kSkyLutSize.height + 15) / 16, 1);
+
+    nvvk::cmdImageMemoryBarrier(cmd, {.image         = m_skyLut.image,
+                                      .oldLayout     = VK_IMAGE_LAYOUT_GENERAL,
+                                      .newLayout     = VK_IMAGE_LAYOUT_GENERAL,
+                                      .srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                      .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                      .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                      .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT});
+
+    m_skyLutParams = skyParam;
+    m_skyLutValid  = true;
   }
 
+  nvvk::ResourceAllocator* m_alloc{};
+  VkDevice                 m_device{};
+  VkDescriptorSetLayout    m_descriptorSetLayout{};
+  VkPipelineLayout         m_pipelineLayout{};
+  VkShaderEXT              m_shader{};
 
-protected:
-  VkDevice              m_device{};
-  VkDescriptorSetLayout m_descriptorSetLayout{};
-  VkPipelineLayout      m_pipelineLayout{};
-  VkShaderEXT           m_shader{};
+  // Sky-view LUT of the physical sky, and the parameters it was baked with
+  VkShaderEXT m_bakeShader{};
+  nvvk::Image m_skyLut{};
+  SkyParams   m_skyLutParams{};
+  bool        m_skyLutValid = false;
 };
 
 // Define specific types
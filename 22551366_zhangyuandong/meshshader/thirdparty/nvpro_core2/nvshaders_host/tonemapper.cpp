@@ -37,13 +37,17 @@ VkResult nvshaders::Tonemapper::init(nvvk::ResourceAllocator* alloc, std::span<c
   m_device = alloc->getDevice();
 
   // Create buffers
-  alloc->createBuffer(m_exposureBuffer, sizeof(float),
+  alloc->createBuffer(m_exposureBuffer, sizeof(float) * 2,
                       VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT | VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT,
                       VMA_MEMORY_USAGE_AUTO);
   NVVK_DBG_NAME(m_exposureBuffer.buffer);
   alloc->createBuffer(m_histogramBuffer, sizeof(uint32_t) * EXPOSURE_HISTOGRAM_SIZE,
                       VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT | VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT,
                       VMA_MEMORY_USAGE_AUTO);
+  NVVK_DBG_NAME(m_histogramBuffer.buffer);
+  alloc->createBuffer(m_counterBuffer, sizeof(uint32_t),
+                      VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO);
+  NVVK_DBG_NAME(m_counterBuffer.buffer);
 
 
   // Shader descriptor set layout
@@ -52,6 +56,7 @@ VkResult nvshaders::Tonemapper::init(nvvk::ResourceAllocator* alloc, std::span<c
   bindings.addBinding(shaderio::TonemapBinding::eImageOutput, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT);
   bindings.addBinding(shaderio::TonemapBinding::eHistogramInputOutput, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
   bindings.addBinding(shaderio::TonemapBinding::eLuminanceInputOutput, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+  bindings.addBinding(shaderio::TonemapBinding::eExposureCounter, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
 
   NVVK_CHECK(m_descriptorPack.init(bindings, m_device, 0, VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR));
   NVVK_DBG_NAME(m_descriptorPack.getLayout());
@@ -95,6 +100,14 @@ VkResult nvshaders::Tonemapper::init(nvvk::ResourceAllocator* alloc, std::span<c
   NVVK_FAIL_RETURN(vkCreateComputePipelines(m_device, nullptr, 1, &compInfo, nullptr, &m_exposurePipeline));
   NVVK_DBG_NAME(m_exposurePipeline);
 
+  compInfo.stage.pName = "HistogramExposure";
+  NVVK_FAIL_RETURN(vkCreateComputePipelines(m_device, nullptr, 1, &compInfo, nullptr, &m_histogramExposurePipeline));
+  NVVK_DBG_NAME(m_histogramExposurePipeline);
+
+  compInfo.stage.pName = "HistogramTonemap";
+  NVVK_FAIL_RETURN(vkCreateComputePipelines(m_device, nullptr, 1, &compInfo, nullptr, &m_histogramTonemapPipeline));
+  NVVK_DBG_NAME(m_histogramTonemapPipeline);
+
   return VK_SUCCESS;
 }
 
@@ -105,10 +118,13 @@ void nvshaders::Tonemapper::deinit()
 
   m_alloc->destroyBuffer(m_exposureBuffer);
   m_alloc->destroyBuffer(m_histogramBuffer);
+  m_alloc->destroyBuffer(m_counterBuffer);
 
   vkDestroyPipeline(m_device, m_tonemapPipeline, nullptr);
   vkDestroyPipeline(m_device, m_histogramPipeline, nullptr);
   vkDestroyPipeline(m_device, m_exposurePipeline, nullptr);
+  vkDestroyPipeline(m_device, m_histogramExposurePipeline, nullptr);
+  vkDestroyPipeline(m_device, m_histogramTonemapPipeline, nullptr);
   vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
   m_descriptorPack.deinit();
 
@@ -129,11 +145,22 @@ void nvshaders::Tonemapper::runCompute(VkCommandBuffer                 cmd,
 {
   NVVK_DBG_SCOPE(cmd);  // <-- Helps to debug in NSight
 
+  const bool       autoExposure = tonemapper.isActive && tonemapper.autoExposure;
+  const VkExtent2D groupCounts  = nvvk::getGroupCounts(size, VkExtent2D{TONEMAP_WORKGROUP_SIZE, TONEMAP_WORKGROUP_SIZE});
+
   // Push constant
   shaderio::TonemapperData tonemapperData = tonemapper;
   tonemapperData.autoExposureSpeed *= float(m_timer.getSeconds());
   tonemapperData.inputMatrix =
       shaderio::getColorCorrectionMatrix(tonemapperData.exposure, tonemapper.temperature, tonemapper.tint);
+  // The single dispatch tonemaps with the luminance of the previous frame while it computes the other one
+  tonemapperData.exposureReadIndex  = m_exposureIndex;
+  tonemapperData.exposureWriteIndex = m_exposureIndex;
+  if(autoExposure && m_autoExposureMode == AutoExposureMode::eFusedTonemap)
+  {
+    tonemapperData.exposureWriteIndex = m_exposureIndex ^ 1;
+  }
+  tonemapperData.numWorkGroups = groupCounts.width * groupCounts.height;
   vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(shaderio::TonemapperData), &tonemapperData);
   m_timer.reset();
 
@@ -143,11 +170,12 @@ void nvshaders::Tonemapper::runCompute(VkCommandBuffer                 cmd,
   writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::TonemapBinding::eImageOutput), outImage);
   writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::TonemapBinding::eHistogramInputOutput), m_histogramBuffer);
   writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::TonemapBinding::eLuminanceInputOutput), m_exposureBuffer);
+  writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::TonemapBinding::eExposureCounter), m_counterBuffer);
   vkCmdPushDescriptorSetKHR(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, writeSetContainer.size(),
                             writeSetContainer.data());
 
   // Run auto-exposure histogram/exposure if enabled
-  if(tonemapper.isActive && tonemapper.autoExposure)
+  if(autoExposure)
   {
     static bool firstRun = true;
     if(firstRun)
@@ -156,14 +184,25 @@ void nvshaders::Tonemapper::runCompute(VkCommandBuffer                 cmd,
       firstRun = false;
     }
 
-    runAutoExposureHistogram(cmd, size, inImage);
-    runAutoExposure(cmd);
+    switch(m_autoExposureMode)
+    {
+      case AutoExposureMode::eSeparate:
+        runAutoExposureHistogram(cmd, size, inImage);
+        runAutoExposure(cmd);
+        break;
+      case AutoExposureMode::eFused:
+        runFusedAutoExposure(cmd, size, m_histogramExposurePipeline);
+        break;
+      case AutoExposureMode::eFusedTonemap:
+        runFusedAutoExposure(cmd, size, m_histogramTonemapPipeline);
+        m_exposureIndex ^= 1;
+        return;
+    }
   }
 
   // Run tonemapper compute shader
   vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_tonemapPipeline);
-  VkExtent2D groupSize = nvvk::getGroupCounts(size, VkExtent2D{TONEMAP_WORKGROUP_SIZE, TONEMAP_WORKGROUP_SIZE});
-  vkCmdDispatch(cmd, groupSize.width, groupSize.height, 1);
+  vkCmdDispatch(cmd, groupCounts.width, groupCounts.height, 1);
 }
 
 void nvshaders::Tonemapper::runAutoExposureHistogram(VkCommandBuffer cmd, const VkExtent2D& size, const VkDescriptorImageInfo& inImage)
@@ -192,15 +231,28 @@ void nvshaders::Tonemapper::runAutoExposure(VkCommandBuffer cmd)
                                      .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT});
 }
 
+// Histogram and exposure in the same dispatch: the last workgroup to finish computes the exposure,
+// which saves the exposure dispatch and the barrier between the two.
+// The dispatch leaves the histogram and the counter cleared, the barrier is for the next frame.
+void nvshaders::Tonemapper::runFusedAutoExposure(VkCommandBuffer cmd, const VkExtent2D& size, VkPipeline pipeline)
+{
+  NVVK_DBG_SCOPE(cmd);  // <-- Helps to debug in NSight
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+  VkExtent2D groupSize = nvvk::getGroupCounts(size, VkExtent2D{TONEMAP_WORKGROUP_SIZE, TONEMAP_WORKGROUP_SIZE});
+  vkCmdDispatch(cmd, groupSize.width, groupSize.height, 1);
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                         VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                         VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+}
+
 void nvshaders::Tonemapper::clearHistogram(VkCommandBuffer cmd)
 {
   std::array<uint32_t, EXPOSURE_HISTOGRAM_SIZE> histogramData{0};
   vkCmdUpdateBuffer(cmd, m_histogramBuffer.buffer, 0, sizeof(uint32_t) * EXPOSURE_HISTOGRAM_SIZE, histogramData.data());
+  vkCmdFillBuffer(cmd, m_counterBuffer.buffer, 0, sizeof(uint32_t), 0);
 
   // Add barrier to ensure update buffer completes before compute shader writes to the buffer
-  nvvk::cmdBufferMemoryBarrier(cmd, {.buffer        = m_histogramBuffer.buffer,
-                                     .srcStageMask  = VK_PIPELINE_STAGE_2_CLEAR_BIT,
-                                     .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-                                     .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                                     .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT});
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_CLEAR_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                         VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
 }
\ No newline at end of file
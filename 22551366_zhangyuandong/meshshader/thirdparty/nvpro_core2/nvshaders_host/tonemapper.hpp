@@ -39,6 +39,16 @@ public:
   VkResult init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv);
   void     deinit();
 
+  // How the auto-exposure is computed
+  enum class AutoExposureMode
+  {
+    eSeparate,      // histogram, exposure and tonemap dispatches
+    eFused,         // the last histogram workgroup computes the exposure, then the tonemap dispatch
+    eFusedTonemap,  // a single dispatch, tonemapping with the exposure of the previous frame
+  };
+  void             setAutoExposureMode(AutoExposureMode mode) { m_autoExposureMode = mode; }
+  AutoExposureMode getAutoExposureMode() const { return m_autoExposureMode; }
+
   void runCompute(VkCommandBuffer                 cmd,
                   const VkExtent2D&               size,
                   const shaderio::TonemapperData& tonemapper,
@@ -49,6 +59,7 @@ private:
   // Add new methods for histogram-based auto-exposure
   void runAutoExposureHistogram(VkCommandBuffer cmd, const VkExtent2D& size, const VkDescriptorImageInfo& inImage);
   void runAutoExposure(VkCommandBuffer cmd);
+  void runFusedAutoExposure(VkCommandBuffer cmd, const VkExtent2D& size, VkPipeline pipeline);
   void clearHistogram(VkCommandBuffer cmd);
 
   nvvk::ResourceAllocator* m_alloc{};
@@ -59,12 +70,17 @@ private:
   VkPipeline           m_tonemapPipeline{};
   VkPipeline           m_histogramPipeline{};
   VkPipeline           m_exposurePipeline{};
+  VkPipeline           m_histogramExposurePipeline{};
+  VkPipeline           m_histogramTonemapPipeline{};
 
   nvutils::PerformanceTimer m_timer;  // Timer for performance measurement
 
   // Auto-Exposure
-  nvvk::Buffer m_exposureBuffer;
-  nvvk::Buffer m_histogramBuffer;
+  nvvk::Buffer     m_exposureBuffer;  // two luminances, alternating in the eFusedTonemap mode
+  nvvk::Buffer     m_histogramBuffer;
+  nvvk::Buffer     m_counterBuffer;  // finished workgroups of the fused modes
+  uint32_t         m_exposureIndex    = 0;
+  AutoExposureMode m_autoExposureMode = AutoExposureMode::eSeparate;
 };
 
 
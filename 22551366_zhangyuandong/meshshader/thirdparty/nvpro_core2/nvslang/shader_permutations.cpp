@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+#include "shader_permutations.hpp"
+
+void nvslang::ShaderPermutations::init(const InitInfo& info)
+{
+  assert(m_entries.empty() && !isCompiling());
+  m_info = info;
+}
+
+void nvslang::ShaderPermutations::deinit()
+{
+  if(m_compiling.valid())
+  {
+    m_compiling.wait();
+    m_compiling = {};
+  }
+  m_entries.clear();
+  m_queue.clear();
+  m_inFlight.clear();
+}
+
+void nvslang::ShaderPermutations::addPrecompiled(uint64_t mask, std::span<const uint32_t> spirv)
+{
+  Entry& entry     = m_entries[mask];
+  entry.spirv      = spirv;
+  entry.generation = ++m_generation;
+  entry.failed     = false;
+  entry.compiledSpirv.clear();
+}
+
+nvslang::ShaderPermutations::Permutation nvslang::ShaderPermutations::get(uint64_t mask)
+{
+  auto it = m_entries.find(mask);
+  if(it != m_entries.end() && !it->second.spirv.empty())
+  {
+    return {mask, it->second.spirv, true, it->second.generation};
+  }
+  const bool inFlight = std::find(m_inFlight.begin(), m_inFlight.end(), mask) != m_inFlight.end();
+  if((it == m_entries.end() || !it->second.failed) && !inFlight)
+  {
+    queue(mask);
+  }
+
+  // Fewest differing features, the lowest mask on ties so the choice doesn't depend on the map order
+  const Entry* nearest     = nullptr;
+  uint64_t     nearestMask = 0;
+  int          nearestBits = 0;
+  for(const auto& [entryMask, entry] : m_entries)
+  {
+    if(entry.spirv.empty() || ((entryMask ^ mask) & m_info.fallbackMatchMask) != 0)
+    {
+      continue;
+    }
+    const int bits = std::popcount(entryMask ^ mask);
+    if(!nearest || bits < nearestBits || (bits == nearestBits && entryMask < nearestMask))
+    {
+      nearest     = &entry;
+      nearestMask = entryMask;
+      nearestBits = bits;
+    }
+  }
+  if(!nearest)
+  {
+    return {mask, {}, false, 0};
+  }
+  return {nearestMask, nearest->spirv, false, nearest->generation};
+}
+
+bool nvslang::ShaderPermutations::update()
+{
+  bool updated = false;
+  if(m_compiling.valid())
+  {
+    if(m_compiling.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+      return false;
+    }
+    updated = collect();
+  }
+  if(!m_queue.empty())
+  {
+    launch();
+  }
+  return updated;
+}
+
+void nvslang::ShaderPermutations::recompile()
+{
+  for(auto it = m_entries.begin(); it != m_entries.end();)
+  {
+    Entry& entry = it->second;
+    if(entry.failed)
+    {
+      queue(it->first);
+      it = m_entries.erase(it);
+      continue;
+    }
+    if(!entry.compiledSpirv.empty())
+    {
+      queue(it->first);
+    }
+    ++it;
+  }
+}
+
+void nvslang::ShaderPermutations::wait()
+{
+  while(isCompiling())
+  {
+    if(m_compiling.valid())
+    {
+      m_compiling.wait();
+    }
+    update();
+  }
+}
+
+void nvslang::ShaderPermutations::queue(uint64_t mask)
+{
+  // A permutation in flight may be queued again by `recompile`, the sources may have changed since it started
+  if(std::find(m_queue.begin(), m_queue.end(), mask) == m_queue.end())
+  {
+    m_queue.push_back(mask);
+  }
+}
+
+bool nvslang::ShaderPermutations::collect()
+{
+  std::vector<SlangCompiler::BatchResult> results = m_compiling.get();
+
+  bool updated = false;
+  for(size_t i = 0; i < results.size(); i++)
+  {
+    SlangCompiler::BatchResult& result = results[i];
+    const uint64_t              mask   = m_inFlight[i];
+    Entry&                      entry  = m_entries[mask];
+    if(result.success)
+    {
+      LOGI("%s permutation 0x%llx %s\n", m_info.filename.string().c_str(), (unsigned long long)mask,
+           result.fromCache ? "loaded from the shader cache" : "compiled");
+      entry.compiledSpirv = std::move(result.spirv);
+      entry.spirv         = entry.compiledSpirv;
+      entry.generation    = ++m_generation;
+      updated             = true;
+    }
+    else
+    {
+      LOGW("%s permutation 0x%llx failed to compile%s\n", m_info.filename.string().c_str(), (unsigned long long)mask,
+           entry.spirv.empty() ? "" : ", keeping the previous SPIR-V");
+      entry.failed = entry.spirv.empty();
+    }
+  }
+  m_inFlight.clear();
+  return updated;
+}
+
+void nvslang::ShaderPermutations::launch()
+{
+  m_inFlight = std::move(m_queue);
+  m_queue.clear();
+
+  std::vector<SlangCompiler::BatchRequest> requests;
+  requests.reserve(m_inFlight.size());
+  for(uint64_t mask : m_inFlight)
+  {
+    requests.push_back({m_info.filename, m_info.entryPoint, m_info.getMacros ? m_info.getMacros(mask) : MacroList{}});
+  }
+
+  // A dedicated thread rather than the shared thread pool: compilations take long enough
+  // to delay the parallel work of the frame queued behind them
+  m_compiling = std::async(std::launch::async, [this, requests = std::move(requests)]() {
+    return m_compiler.compileBatch(requests, m_info.numThreads);
+  });
+}
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_ShaderPermutations(std::span<const uint32_t> embeddedSpirv)
+{
+  enum FeatureBits : uint64_t
+  {
+    eShadows   = 1 << 0,
+    eHalf      = 1 << 1,
+    eWorkgroup = 0xFF00,  // workgroup size, the dispatches depend on it
+  };
+
+  nvslang::ShaderPermutations permutations;
+  permutations.getCompiler().defaultTarget();
+  permutations.getCompiler().defaultOptions();
+  permutations.getCompiler().setCacheDirectory("shader_cache");  // compiled permutations persist between runs
+
+  nvslang::ShaderPermutations::InitInfo info{
+      .filename  = "shader.slang",
+      .getMacros = [](uint64_t mask) -> nvslang::ShaderPermutations::MacroList {
+        return {{"USE_SHADOWS", (mask & eShadows) ? "1" : "0"},
+                {"USE_HALF", (mask & eHalf) ? "1" : "0"},
+                {"WORKGROUP_SIZE", std::to_string((mask & eWorkgroup) >> 8)}};
+      },
+      .fallbackMatchMask = eWorkgroup,
+  };
+  permutations.init(info);
+  // Built offline with the default macros
+  permutations.addPrecompiled(eShadows | (32 << 8), embeddedSpirv);
+
+  // The precompiled permutation is served while USE_HALF=1 compiles
+  const uint64_t                           requested   = eShadows | eHalf | (32 << 8);
+  nvslang::ShaderPermutations::Permutation permutation = permutations.get(requested);
+  uint64_t                                 generation  = permutation.generation;
+  // ... create the pipeline from permutation.spirv
+
+  // Each frame
+  if(permutations.update() && permutations.get(requested).generation != generation)
+  {
+    permutation = permutations.get(requested);
+    generation  = permutation.generation;
+    // ... recreate the pipeline, permutation.exact is now true
+  }
+
+  permutations.deinit();
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include <cassert>
+#include <functional>
+#include <future>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "slang.hpp"
+
+//--------------------------------------------------------------------------------------------------
+// Shader Permutations
+//
+// Compiles the permutations of a shader on demand, keyed by a bitmask of its features which the
+// application translates to macros. A permutation that isn't compiled yet is compiled on a
+// background thread, and the nearest available one is served in the meantime: rendering goes on
+// with a close variant instead of stalling on the compiler.
+//
+// - Permutations built offline (e.g. embedded SPIR-V) are registered with `addPrecompiled`,
+//   they are the fallbacks before anything is compiled.
+// - The nearest permutation has the fewest differing feature bits. Bits the host code depends
+//   on (workgroup sizes, resource layouts...) are listed in `fallbackMatchMask` and must be equal.
+// - With a cache directory on the compiler, the compiled SPIR-V persists between runs and the
+//   permutations used before are loaded from the disk cache instead of compiled.
+//
+// Usage:
+//   see usage_ShaderPermutations
+//--------------------------------------------------------------------------------------------------
+
+namespace nvslang {
+
+class ShaderPermutations
+{
+public:
+  using MacroList = std::vector<std::pair<std::string, std::string>>;
+
+  struct InitInfo
+  {
+    std::filesystem::path                   filename;
+    std::string                             entryPoint;  // all entry points when empty
+    std::function<MacroList(uint64_t mask)> getMacros;  // macros of a permutation, added to those of the compiler
+    uint64_t                                fallbackMatchMask = 0;  // bits a fallback must share with the request
+    uint32_t                                numThreads        = 1;  // parallel compilations, 0 for all hardware threads
+  };
+
+  struct Permutation
+  {
+    uint64_t                  mask       = 0;      // the permutation served, the requested one when exact
+    std::span<const uint32_t> spirv;               // empty when no permutation can be served
+    bool                      exact      = false;  // the requested permutation
+    uint64_t                  generation = 0;      // changes whenever the SPIR-V of the served permutation changes
+  };
+
+  ShaderPermutations() = default;
+  ~ShaderPermutations() { assert(!m_compiling.valid() && "Missing deinit()"); }
+
+  ShaderPermutations(const ShaderPermutations&)            = delete;
+  ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+  // Targets, options, search paths, common macros and cache directory of the compilations.
+  // Set them before the first `get`, the compiler is used by the background thread afterwards.
+  SlangCompiler& getCompiler() { return m_compiler; }
+
+  void init(const InitInfo& info);
+  // Waits for the compilation in flight and drops all permutations
+  void deinit();
+
+  // The SPIR-V is referenced, not copied: it must outlive this object
+  void addPrecompiled(uint64_t mask, std::span<const uint32_t> spirv);
+
+  // Returns the requested permutation when available. Otherwise queues its compilation (unless it failed before)
+  // and returns the nearest available permutation, or an empty one when none matches `fallbackMatchMask`.
+  Permutation get(uint64_t mask);
+
+  // Call once per frame: collects the finished compilations and starts the queued ones.
+  // Returns true when new SPIR-V is available, `get` may then serve a better or a recompiled permutation.
+  bool update();
+
+  // Compiles the compiled permutations again, e.g. after the shader sources were edited, and retries the failed ones.
+  // The current SPIR-V is served until the new one is ready, and kept when the compilation fails.
+  void recompile();
+
+  // Blocks until all queued permutations are compiled
+  void wait();
+
+  bool isCompiling() const { return m_compiling.valid() || !m_queue.empty(); }
+
+private:
+  struct Entry
+  {
+    std::span<const uint32_t> spirv;
+    std::vector<uint32_t>     compiledSpirv;  // storage of `spirv` unless precompiled
+    uint64_t                  generation = 0;
+    bool                      failed     = false;  // not compiled, and not retried until `recompile`
+  };
+
+  void queue(uint64_t mask);
+  bool collect();
+  void launch();
+
+  SlangCompiler                                        m_compiler;
+  InitInfo                                             m_info;
+  std::unordered_map<uint64_t, Entry>                  m_entries;
+  std::vector<uint64_t>                                m_queue;
+  std::vector<uint64_t>                                m_inFlight;  // masks being compiled, in the order of the results
+  uint64_t                                             m_generation = 0;
+  std::future<std::vector<SlangCompiler::BatchResult>> m_compiling;
+};
+
+}  // namespace nvslang
@@ -17,10 +17,54 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <type_traits>
+
 #include "slang.hpp"
 
+// FNV-1a, stable between runs and builds so the cache keys are too
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for(size_t i = 0; i < size; i++)
+  {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+template <typename T>
+static uint64_t hashValue(uint64_t hash, const T& value)
+{
+  static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+  return hashBytes(hash, &value, sizeof(T));
+}
+
+static uint64_t hashString(uint64_t hash, const char* str)
+{
+  // The length separates consecutive strings, -1 separates nullptr from ""
+  const size_t length = str ? strlen(str) : ~size_t(0);
+  hash                = hashValue(hash, length);
+  return str ? hashBytes(hash, str, length) : hash;
+}
+
+static uint64_t hashString(uint64_t hash, const std::string& str)
+{
+  hash = hashValue(hash, str.size());
+  return hashBytes(hash, str.data(), str.size());
+}
+
+static constexpr uint64_t kHashSeed         = 0xcbf29ce484222325ull;
+static constexpr uint32_t kCacheMagic       = 0x43565053;  // "SPVC"
+static constexpr uint32_t kCacheFileVersion = 1;
+
 
 nvslang::SlangCompiler::SlangCompiler(bool enableGLSL)
+    : m_enableGLSL(enableGLSL)
 {
   SlangGlobalSessionDesc desc{.enableGLSL = enableGLSL};
   slang::createGlobalSession(&desc, m_globalSession.writeRef());
@@ -43,6 +87,12 @@ void nvslang::SlangCompiler::defaultOptions()
   // m_options.push_back({slang::CompilerOptionName::AllowGLSL, {slang::CompilerOptionValueKind::Int, 1}});
 }
 
+void nvslang::SlangCompiler::releaseOptions()
+{
+  m_options.push_back({slang::CompilerOptionName::Optimization, {slang::CompilerOptionValueKind::Int, SLANG_OPTIMIZATION_LEVEL_MAXIMAL}});
+  m_options.push_back({slang::CompilerOptionName::DebugInformation, {slang::CompilerOptionValueKind::Int, SLANG_DEBUG_INFO_LEVEL_NONE}});
+}
+
 void nvslang::SlangCompiler::addSearchPaths(const std::vector<std::filesystem::path>& searchPaths)
 {
   for(auto& str : searchPaths)
@@ -63,6 +113,10 @@ void nvslang::SlangCompiler::clearSearchPaths()
 
 const uint32_t* nvslang::SlangCompiler::getSpirv() const
 {
+  if(m_fromCache)
+  {
+    return m_cachedSpirv.data();
+  }
   if(!m_spirv)
   {
     return nullptr;
@@ -72,6 +126,10 @@ const uint32_t* nvslang::SlangCompiler::getSpirv() const
 
 size_t nvslang::SlangCompiler::getSpirvSize() const
 {
+  if(m_fromCache)
+  {
+    return m_cachedSpirv.size() * sizeof(uint32_t);
+  }
   if(!m_spirv)
   {
     return 0;
@@ -97,7 +155,7 @@ slang::IModule* nvslang::SlangCompiler::getSlangModule() const
   return m_module.get();
 }
 
-bool nvslang::SlangCompiler::compileFile(const std::filesystem::path& filename)
+bool nvslang::SlangCompiler::compileFile(const std::filesystem::path& filename, const char* entryPoint)
 {
   const std::filesystem::path sourceFile = nvutils::findFile(filename, m_searchPaths);
   if(sourceFile.empty())
@@ -106,7 +164,7 @@ bool nvslang::SlangCompiler::compileFile(const std::filesystem::path& filename)
     LOGW("%s\n", m_lastDiagnosticMessage.c_str());
     return false;
   }
-  bool success = loadFromSourceString(nvutils::utf8FromPath(sourceFile.stem()), nvutils::loadFile(sourceFile));
+  bool success = loadFromSourceString(nvutils::utf8FromPath(sourceFile.stem()), nvutils::loadFile(sourceFile), entryPoint);
   if(success)
   {
     if(m_callback)
@@ -134,33 +192,66 @@ void nvslang::SlangCompiler::logAndAppendDiagnostics(slang::IBlob* diagnostics)
   }
 }
 
-bool nvslang::SlangCompiler::loadFromSourceString(const std::string& moduleName, const std::string& slangSource)
+bool nvslang::SlangCompiler::loadFromSourceString(const std::string& moduleName, const std::string& slangSource, const char* entryPoint)
 {
-  createSession();
-
   // Clear any previous compilation
-  m_spirv = nullptr;
+  m_spirv         = nullptr;
+  m_module        = nullptr;
+  m_linkedProgram = nullptr;
+  m_fromCache     = false;
+  m_cachedSpirv.clear();
   m_lastDiagnosticMessage.clear();
 
+  const uint64_t cacheKey = m_cacheDirectory.empty() ? 0 : getCacheKey(moduleName, slangSource, entryPoint);
+  if(!m_cacheDirectory.empty() && loadFromCache(cacheKey))
+  {
+    return true;
+  }
+
+  if(!isSessionReusable(moduleName))
+  {
+    createSession();
+  }
+  m_sessionModules.insert(moduleName);
+
   Slang::ComPtr<slang::IBlob> diagnostics;
   // From source code to Slang module
   m_module = m_session->loadModuleFromSourceString(moduleName.c_str(), nullptr, slangSource.c_str(), diagnostics.writeRef());
   logAndAppendDiagnostics(diagnostics);
   if(!m_module)
   {
+    // don't keep a session with a partially loaded module (and its imports)
+    resetSession();
     return false;
   }
+  addSessionDependencies();
 
   // In order to get entrypoint shader reflection, it seems like one must go
   // through the additional step of listing every entry point in the composite
   // type. This matches the docs, but @nbickford wonders if there's a simpler way.
-  const SlangInt32                               definedEntryPointCount = m_module->getDefinedEntryPointCount();
-  std::vector<Slang::ComPtr<slang::IEntryPoint>> entryPoints(definedEntryPointCount);
-  std::vector<slang::IComponentType*>            components(1 + definedEntryPointCount);
+  std::vector<Slang::ComPtr<slang::IEntryPoint>> entryPoints;
+  if(entryPoint)
+  {
+    entryPoints.resize(1);
+    if(SLANG_FAILED(m_module->findEntryPointByName(entryPoint, entryPoints[0].writeRef())) || !entryPoints[0])
+    {
+      m_lastDiagnosticMessage = "Entry point not found: " + std::string(entryPoint);
+      LOGW("%s\n", m_lastDiagnosticMessage.c_str());
+      return false;
+    }
+  }
+  else
+  {
+    entryPoints.resize(m_module->getDefinedEntryPointCount());
+    for(SlangInt32 i = 0; i < SlangInt32(entryPoints.size()); i++)
+    {
+      m_module->getDefinedEntryPoint(i, entryPoints[i].writeRef());
+    }
+  }
+  std::vector<slang::IComponentType*> components(1 + entryPoints.size());
   components[0] = m_module;
-  for(SlangInt32 i = 0; i < definedEntryPointCount; i++)
+  for(size_t i = 0; i < entryPoints.size(); i++)
   {
-    m_module->getDefinedEntryPoint(i, entryPoints[i].writeRef());
     components[1 + i] = entryPoints[i];
   }
 
@@ -188,12 +279,303 @@ bool nvslang::SlangCompiler::loadFromSourceString(const std::string& moduleName,
   {
     return false;
   }
+
+  if(!m_cacheDirectory.empty())
+  {
+    saveToCache(cacheKey);
+  }
+  return true;
+}
+
+uint64_t nvslang::SlangCompiler::getSessionKey() const
+{
+  uint64_t hash = hashString(kHashSeed, m_globalSession->getBuildTagString());
+  for(const slang::PreprocessorMacroDesc& macro : m_macros)
+  {
+    hash = hashString(hash, macro.name);
+    hash = hashString(hash, macro.value);
+  }
+  for(const slang::CompilerOptionEntry& option : m_options)
+  {
+    hash = hashValue(hash, option.name);
+    hash = hashValue(hash, option.value.kind);
+    hash = hashValue(hash, option.value.intValue0);
+    hash = hashValue(hash, option.value.intValue1);
+    hash = hashString(hash, option.value.stringValue0);
+    hash = hashString(hash, option.value.stringValue1);
+  }
+  for(const slang::TargetDesc& target : m_targets)
+  {
+    hash = hashValue(hash, target.format);
+    hash = hashValue(hash, target.profile);
+    hash = hashValue(hash, target.flags);
+    hash = hashValue(hash, target.floatingPointMode);
+    hash = hashValue(hash, target.lineDirectiveMode);
+    hash = hashValue(hash, target.forceGLSLScalarBufferLayout);
+  }
+  for(const std::string& searchPath : m_searchPathsUtf8)
+  {
+    hash = hashString(hash, searchPath);
+  }
+  return hash;
+}
+
+uint64_t nvslang::SlangCompiler::getCacheKey(const std::string& moduleName, const std::string& slangSource, const char* entryPoint) const
+{
+  uint64_t hash = hashValue(kHashSeed, kCacheFileVersion);
+  hash          = hashValue(hash, getSessionKey());
+  hash          = hashString(hash, moduleName);
+  hash          = hashString(hash, slangSource);
+  hash          = hashString(hash, entryPoint);
+  return hash;
+}
+
+std::filesystem::path nvslang::SlangCompiler::getCacheFilename(uint64_t cacheKey) const
+{
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.spvcache", static_cast<unsigned long long>(cacheKey));
+  return m_cacheDirectory / name;
+}
+
+// Cache entry:
+//   uint32_t magic, version, dependency count
+//   per dependency: uint32_t path length, UTF-8 path, uint64_t content hash
+//   uint64_t SPIR-V size in bytes, SPIR-V
+bool nvslang::SlangCompiler::loadFromCache(uint64_t cacheKey)
+{
+  std::ifstream file(getCacheFilename(cacheKey), std::ios::binary);
+  if(!file)
+  {
+    return false;
+  }
+
+  auto read = [&file](auto& value) { return bool(file.read(reinterpret_cast<char*>(&value), sizeof(value))); };
+
+  uint32_t magic = 0, version = 0, dependencyCount = 0;
+  if(!read(magic) || !read(version) || !read(dependencyCount) || magic != kCacheMagic || version != kCacheFileVersion)
+  {
+    return false;
+  }
+
+  // Same key, but an included file may have changed since
+  for(uint32_t i = 0; i < dependencyCount; i++)
+  {
+    uint32_t    pathLength = 0;
+    uint64_t    hash       = 0;
+    std::string path;
+    if(!read(pathLength))
+    {
+      return false;
+    }
+    path.resize(pathLength);
+    if(!file.read(path.data(), pathLength) || !read(hash))
+    {
+      return false;
+    }
+    const std::string content = nvutils::loadFile(nvutils::pathFromUtf8(path));
+    if(hashString(kHashSeed, content) != hash)
+    {
+      return false;
+    }
+  }
+
+  uint64_t spirvSize = 0;
+  if(!read(spirvSize) || spirvSize == 0 || spirvSize % sizeof(uint32_t) != 0)
+  {
+    return false;
+  }
+  m_cachedSpirv.resize(spirvSize / sizeof(uint32_t));
+  if(!file.read(reinterpret_cast<char*>(m_cachedSpirv.data()), spirvSize))
+  {
+    m_cachedSpirv.clear();
+    return false;
+  }
+
+  m_fromCache = true;
   return true;
 }
 
+void nvslang::SlangCompiler::saveToCache(uint64_t cacheKey) const
+{
+  std::error_code error;
+  std::filesystem::create_directories(m_cacheDirectory, error);
+
+  // Write to a temporary file first, so concurrent runs never read a partial entry
+  const std::filesystem::path filename     = getCacheFilename(cacheKey);
+  std::filesystem::path       tempFilename = filename;
+  tempFilename += ".tmp";
+  {
+    std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+      LOGW("Cannot write the shader cache entry %s\n", nvutils::utf8FromPath(tempFilename).c_str());
+      return;
+    }
+
+    auto write = [&file](const auto& value) { file.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+    // Only the dependencies that are actual files, the root module may come from a string
+    std::vector<std::string> dependencies;
+    for(SlangInt32 i = 0; i < m_module->getDependencyFileCount(); i++)
+    {
+      const char* path = m_module->getDependencyFilePath(i);
+      if(path && std::filesystem::is_regular_file(nvutils::pathFromUtf8(path), error))
+      {
+        dependencies.push_back(path);
+      }
+    }
+
+    write(kCacheMagic);
+    write(kCacheFileVersion);
+    write(uint32_t(dependencies.size()));
+    for(const std::string& path : dependencies)
+    {
+      const std::string content = nvutils::loadFile(nvutils::pathFromUtf8(path));
+      write(uint32_t(path.size()));
+      file.write(path.data(), path.size());
+      write(hashString(kHashSeed, content));
+    }
+    write(uint64_t(getSpirvSize()));
+    file.write(reinterpret_cast<const char*>(getSpirv()), getSpirvSize());
+    if(!file)
+    {
+      return;
+    }
+  }
+  std::filesystem::rename(tempFilename, filename, error);
+  if(error)
+  {
+    std::filesystem::remove(tempFilename, error);
+  }
+}
+
+void nvslang::SlangCompiler::resetSession()
+{
+  m_session    = {};
+  m_sessionKey = 0;
+  m_sessionModules.clear();
+  m_sessionDependencies.clear();
+}
+
+bool nvslang::SlangCompiler::isSessionReusable(const std::string& moduleName)
+{
+  // Slang returns the already loaded module for a known name, ignoring the new source
+  if(!m_session || m_sessionKey != getSessionKey() || m_sessionModules.count(moduleName))
+  {
+    return false;
+  }
+
+  // imported modules stay loaded in the session, they must not have changed on disk
+  for(const auto& dependency : m_sessionDependencies)
+  {
+    std::error_code error;
+    if(std::filesystem::last_write_time(dependency.first, error) != dependency.second || error)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void nvslang::SlangCompiler::addSessionDependencies()
+{
+  for(SlangInt32 i = 0; i < m_module->getDependencyFileCount(); i++)
+  {
+    const char* path = m_module->getDependencyFilePath(i);
+    if(!path)
+      continue;
+
+    std::error_code             error;
+    const std::filesystem::path filename  = nvutils::pathFromUtf8(path);
+    const auto                  writeTime = std::filesystem::last_write_time(filename, error);
+    if(!error
+       && std::none_of(m_sessionDependencies.begin(), m_sessionDependencies.end(),
+                       [&](const auto& dependency) { return dependency.first == filename; }))
+    {
+      m_sessionDependencies.push_back({filename, writeTime});
+    }
+  }
+}
+
+std::vector<nvslang::SlangCompiler::BatchResult> nvslang::SlangCompiler::compileBatch(std::span<const BatchRequest> requests,
+                                                                                      uint32_t numThreads)
+{
+  std::vector<BatchResult> results(requests.size());
+  if(requests.empty())
+  {
+    return results;
+  }
+  if(numThreads == 0)
+  {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = std::min(numThreads, uint32_t(requests.size()));
+
+  // Each thread pulls the next request, permutations can have very different compile times
+  std::atomic<size_t> nextRequest{0};
+  auto                compileRequests = [&](SlangCompiler& compiler) {
+    const std::vector<slang::PreprocessorMacroDesc> baseMacros = compiler.m_macros;
+    for(size_t i = nextRequest++; i < requests.size(); i = nextRequest++)
+    {
+      const BatchRequest& request = requests[i];
+      compiler.m_macros           = baseMacros;
+      for(const auto& macro : request.macros)
+      {
+        compiler.m_macros.push_back({macro.first.c_str(), macro.second.c_str()});
+      }
+
+      const char*  entryPoint = request.entryPoint.empty() ? nullptr : request.entryPoint.c_str();
+      BatchResult& result     = results[i];
+      result.success          = compiler.compileFile(request.filename, entryPoint);
+      result.fromCache        = result.success && compiler.isFromCache();
+      result.diagnostics      = compiler.getLastDiagnosticMessage();
+      if(result.success)
+      {
+        result.spirv.assign(compiler.getSpirv(), compiler.getSpirv() + compiler.getSpirvSize() / sizeof(uint32_t));
+      }
+    }
+    compiler.m_macros = baseMacros;
+  };
+
+  // The settings are copied before the calling thread starts changing its macros
+  struct Settings
+  {
+    bool                                      enableGLSL;
+    std::vector<slang::TargetDesc>            targets;
+    std::vector<slang::CompilerOptionEntry>   options;
+    std::vector<std::filesystem::path>        searchPaths;
+    std::vector<slang::PreprocessorMacroDesc> macros;
+    std::filesystem::path                     cacheDirectory;
+    decltype(m_callback)                      callback;
+  };
+  const Settings settings{m_enableGLSL, m_targets, m_options, m_searchPaths, m_macros, m_cacheDirectory, m_callback};
+
+  std::vector<std::thread> threads;
+  for(uint32_t t = 1; t < numThreads; t++)
+  {
+    threads.emplace_back([&]() {
+      SlangCompiler compiler(settings.enableGLSL);
+      compiler.m_targets = settings.targets;
+      compiler.m_options = settings.options;
+      compiler.addSearchPaths(settings.searchPaths);
+      compiler.m_macros         = settings.macros;
+      compiler.m_cacheDirectory = settings.cacheDirectory;
+      compiler.m_callback       = settings.callback;
+      compileRequests(compiler);
+    });
+  }
+  compileRequests(*this);
+  for(std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  return results;
+}
+
 void nvslang::SlangCompiler::createSession()
 {
-  m_session = {};
+  resetSession();
 
   slang::SessionDesc desc{
       .targets                  = m_targets.data(),
@@ -207,6 +589,7 @@ void nvslang::SlangCompiler::createSession()
       .compilerOptionEntryCount = uint32_t(m_options.size()),
   };
   m_globalSession->createSession(desc, m_session.writeRef());
+  m_sessionKey = getSessionKey();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -248,4 +631,19 @@ void nvslang::SlangCompiler::createSession()
       LOGW("Compilation succeeded with warnings: %s\n", warningMessages.c_str());
     }
   }
+
+  // Many permutations at once, e.g. at startup, each with its own macros
+  std::vector<nvslang::SlangCompiler::BatchRequest> requests;
+  for(const char* quality : {"0", "1", "2"})
+  {
+    requests.push_back({.filename = "shader.slang", .entryPoint = "computeMain", .macros = {{"QUALITY", quality}}});
+  }
+  std::vector<nvslang::SlangCompiler::BatchResult> results = slangCompiler.compileBatch(requests);
+  for(size_t i = 0; i < results.size(); i++)
+  {
+    if(!results[i].success)
+    {
+      LOGE("Permutation %zu failed: %s\n", i, results[i].diagnostics.c_str());
+    }
+  }
 }
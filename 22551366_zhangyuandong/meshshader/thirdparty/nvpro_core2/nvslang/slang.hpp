@@ -20,8 +20,11 @@
 #pragma once
 #include <array>
 #include <vector>
+#include <span>
 #include <string>
 #include <filesystem>
+#include <unordered_set>
+#include <utility>
 
 #pragma push_macro("None")
 #pragma push_macro("Bool")
@@ -58,6 +61,7 @@ public:
 
   void defaultTarget();   // Default target is SPIR-V
   void defaultOptions();  // Default options are EmitSpirvDirectly, VulkanUseEntryPointName
+  void releaseOptions();  // Production code: maximal optimization, no debug information
 
   void addOption(const slang::CompilerOptionEntry& option) { m_options.push_back(option); }
   void clearOptions() { m_options.clear(); }
@@ -76,9 +80,49 @@ public:
   void clearMacros() { m_macros.clear(); }
   std::vector<slang::PreprocessorMacroDesc>& macros() { return m_macros; }
 
-  // Compile a file or source
-  bool compileFile(const std::filesystem::path& filename);
-  bool loadFromSourceString(const std::string& moduleName, const std::string& slangSource);
+  // Compile a file or source, with all its entry points or only `entryPoint` when not null.
+  //
+  // The Slang session, with the core module and the imported modules it parsed, is kept between
+  // compilations as long as the targets, options, search paths and macros are unchanged.
+  // It is recreated when a module of the same name is compiled again, or when a file the session
+  // loaded was modified, so edited shaders are always recompiled.
+  bool compileFile(const std::filesystem::path& filename, const char* entryPoint = nullptr);
+  bool loadFromSourceString(const std::string& moduleName, const std::string& slangSource, const char* entryPoint = nullptr);
+
+  // Drops the kept session, the next compilation creates a new one
+  void resetSession();
+
+  // One permutation of a batch compilation: the macros are added to the ones of the compiler
+  struct BatchRequest
+  {
+    std::filesystem::path                            filename;
+    std::string                                      entryPoint;  // all entry points when empty
+    std::vector<std::pair<std::string, std::string>> macros;
+  };
+
+  struct BatchResult
+  {
+    bool                  success   = false;
+    bool                  fromCache = false;
+    std::vector<uint32_t> spirv;
+    std::string           diagnostics;
+  };
+
+  // Compiles the requests in parallel on `numThreads` threads (0 uses all hardware threads), in the order of the requests.
+  // Slang global sessions are not thread-safe so every additional thread creates its own, which costs about as much
+  // as a single compilation: batches pay off with many permutations. The calling thread compiles with this compiler,
+  // whose last compilation results are then those of one of the requests.
+  // The compile callback is called from the compiling threads.
+  std::vector<BatchResult> compileBatch(std::span<const BatchRequest> requests, uint32_t numThreads = 0);
+
+  // SPIR-V disk cache, disabled when empty (default).
+  // Entries are named by a hash of the source, macros, options, targets, search paths and Slang version,
+  // and store the content hash of every included file: an entry is used only when none of them changed.
+  // A compilation loaded from the cache has no Slang module or program, so no reflection.
+  void                         setCacheDirectory(const std::filesystem::path& directory) { m_cacheDirectory = directory; }
+  const std::filesystem::path& getCacheDirectory() const { return m_cacheDirectory; }
+  // Whether the last compilation was loaded from the cache
+  bool isFromCache() const { return m_fromCache; }
 
   // Get result of the compilation
   const uint32_t* getSpirv() const;
@@ -103,8 +147,16 @@ public:
 
 private:
   void createSession();
+  bool isSessionReusable(const std::string& moduleName);
+  void addSessionDependencies();
   void logAndAppendDiagnostics(slang::IBlob* diagnostic);
 
+  uint64_t              getSessionKey() const;
+  uint64_t              getCacheKey(const std::string& moduleName, const std::string& slangSource, const char* entryPoint) const;
+  std::filesystem::path getCacheFilename(uint64_t cacheKey) const;
+  bool                  loadFromCache(uint64_t cacheKey);
+  void                  saveToCache(uint64_t cacheKey) const;
+
   Slang::ComPtr<slang::IGlobalSession>      m_globalSession;
   std::vector<slang::TargetDesc>            m_targets;
   std::vector<slang::CompilerOptionEntry>   m_options;
@@ -117,6 +169,17 @@ private:
   Slang::ComPtr<ISlangBlob>                 m_spirv;
   std::vector<slang::PreprocessorMacroDesc> m_macros;
 
+  // What the kept session was created with and has loaded
+  bool                            m_enableGLSL = false;
+  uint64_t                        m_sessionKey = 0;
+  std::unordered_set<std::string> m_sessionModules;
+  // files of the loaded modules, with their write time
+  std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> m_sessionDependencies;
+
+  std::filesystem::path m_cacheDirectory;
+  std::vector<uint32_t> m_cachedSpirv;  // SPIR-V of the last compilation when loaded from the cache
+  bool                  m_fromCache = false;
+
   std::function<void(const std::filesystem::path& sourceFile, const uint32_t* spirvCode, size_t spirvSize)> m_callback;
 
   // Store the last diagnostic message
@@ -0,0 +1,704 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define NVUTILS_HAS_IO_URING 1
+#endif
+#endif
+
+#include "async_file_reader.hpp"
+#include "file_operations.hpp"
+#include "logger.hpp"
+#include "parallel_work.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nvutils {
+
+namespace {
+#ifdef _WIN32
+using NativeFile = HANDLE;
+const NativeFile    kNoNativeFile = INVALID_HANDLE_VALUE;
+constexpr ULONG_PTR kStopKey      = 1;
+#else
+using NativeFile                   = int;
+constexpr NativeFile kNoNativeFile = -1;
+#endif
+// ReadFile takes a DWORD size, read syscalls return at most ~2 GB
+constexpr uint64_t kMaxReadOp = 1ull << 30;
+#ifdef NVUTILS_HAS_IO_URING
+constexpr uint64_t kStopUserData = ~0ull;
+#endif
+}  // namespace
+
+struct AsyncFileReader::Impl
+{
+  struct File
+  {
+    NativeFile handle = kNoNativeFile;
+    uint64_t   size   = 0;
+  };
+
+  // one in-flight read
+  struct Slot
+  {
+#ifdef _WIN32
+    OVERLAPPED overlapped{};  // first member, the completion port returns its address
+#else
+    iovec iov{};
+#endif
+    NativeFile handle = kNoNativeFile;
+    uint64_t   offset = 0;
+    uint64_t   size   = 0;
+    uint64_t   done   = 0;
+    char*      buffer = nullptr;
+    Callback   callback;
+  };
+
+  Backend backend = Backend::eThreads;
+
+  std::mutex          mutex;  // files and free slots
+  std::vector<File>   files;
+  std::vector<Slot>   slots;
+  std::vector<size_t> freeSlots;
+  std::condition_variable slotFreed;
+
+  // reads and callbacks not finished yet
+  std::atomic_uint32_t    pending{0};
+  std::mutex              idleMutex;
+  std::condition_variable idle;
+
+  std::thread completionThread;
+
+  // eThreads
+  std::vector<std::thread> ioThreads;
+  std::deque<size_t>       ioQueue;  // guarded by `mutex`
+  std::condition_variable  ioQueueCondition;
+  bool                     stop = false;
+
+#ifdef _WIN32
+  HANDLE port = nullptr;
+#endif
+
+#ifdef NVUTILS_HAS_IO_URING
+  int            ringFd     = -1;
+  void*          sqRing     = nullptr;
+  size_t         sqRingSize = 0;
+  void*          cqRing     = nullptr;
+  size_t         cqRingSize = 0;
+  io_uring_sqe*  sqes       = nullptr;
+  size_t         sqesSize   = 0;
+  io_uring_cqe*  cqes       = nullptr;
+  uint32_t*      sqTail     = nullptr;
+  uint32_t*      sqMask     = nullptr;
+  uint32_t*      sqArray    = nullptr;
+  uint32_t*      cqHead     = nullptr;
+  uint32_t*      cqTail     = nullptr;
+  uint32_t*      cqMask     = nullptr;
+  std::mutex     submitMutex;
+
+  bool initIoUring(uint32_t entries);
+  void deinitIoUring();
+  void submitIoUring(uint8_t opcode, int fd, const iovec* iov, uint64_t offset, uint64_t userData);
+  void ioUringLoop();
+#endif
+
+  bool init(uint32_t maxOutstanding);
+  void deinit();
+
+  void issue(size_t slotIndex);
+  // handles a finished read operation, `result` is the byte count or negative on error
+  void complete(size_t slotIndex, int64_t result);
+  void finishPending();
+  void ioThreadLoop();
+#ifdef _WIN32
+  void completionPortLoop();
+#endif
+};
+
+bool AsyncFileReader::Impl::init(uint32_t maxOutstanding)
+{
+  slots = std::vector<Slot>(maxOutstanding);
+  freeSlots.resize(maxOutstanding);
+  for(size_t i = 0; i < freeSlots.size(); i++)
+  {
+    freeSlots[i] = freeSlots.size() - 1 - i;
+  }
+
+#ifdef _WIN32
+  port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+  if(port)
+  {
+    backend          = Backend::eOverlapped;
+    completionThread = std::thread(&Impl::completionPortLoop, this);
+    return true;
+  }
+#elif defined(NVUTILS_HAS_IO_URING)
+  // one extra entry for the stop request
+  if(initIoUring(maxOutstanding + 1))
+  {
+    backend          = Backend::eIoUring;
+    completionThread = std::thread(&Impl::ioUringLoop, this);
+    return true;
+  }
+#endif
+
+  backend = Backend::eThreads;
+  stop    = false;
+  // blocking reads, enough threads to keep several requests in flight on high latency storage
+  const uint32_t numThreads = std::min(maxOutstanding, 16u);
+  for(uint32_t t = 0; t < numThreads; t++)
+  {
+    ioThreads.emplace_back(&Impl::ioThreadLoop, this);
+  }
+  return true;
+}
+
+void AsyncFileReader::Impl::deinit()
+{
+  if(completionThread.joinable())
+  {
+#ifdef _WIN32
+    PostQueuedCompletionStatus(port, 0, kStopKey, nullptr);
+    completionThread.join();
+    CloseHandle(port);
+    port = nullptr;
+#elif defined(NVUTILS_HAS_IO_URING)
+    submitIoUring(IORING_OP_NOP, -1, nullptr, 0, kStopUserData);
+    completionThread.join();
+    deinitIoUring();
+#endif
+  }
+
+  {
+    std::lock_guard lock(mutex);
+    stop = true;
+  }
+  ioQueueCondition.notify_all();
+  for(std::thread& thread : ioThreads)
+  {
+    thread.join();
+  }
+  ioThreads.clear();
+
+  for(File& file : files)
+  {
+    if(file.handle != kNoNativeFile)
+    {
+#ifdef _WIN32
+      CloseHandle(file.handle);
+#else
+      ::close(file.handle);
+#endif
+    }
+  }
+  files.clear();
+  slots.clear();
+  freeSlots.clear();
+}
+
+void AsyncFileReader::Impl::issue(size_t slotIndex)
+{
+  Slot&          slot   = slots[slotIndex];
+  const uint64_t length = std::min(slot.size - slot.done, kMaxReadOp);
+  const uint64_t offset = slot.offset + slot.done;
+
+  switch(backend)
+  {
+#ifdef _WIN32
+    case Backend::eOverlapped: {
+      slot.overlapped            = {};
+      slot.overlapped.Offset     = DWORD(offset);
+      slot.overlapped.OffsetHigh = DWORD(offset >> 32);
+      if(!ReadFile(slot.handle, slot.buffer + slot.done, DWORD(length), nullptr, &slot.overlapped))
+      {
+        const DWORD error = GetLastError();
+        if(error != ERROR_IO_PENDING)
+        {
+          // no completion packet is queued for a failed call
+          complete(slotIndex, error == ERROR_HANDLE_EOF ? 0 : -1);
+        }
+      }
+      break;
+    }
+#endif
+#ifdef NVUTILS_HAS_IO_URING
+    case Backend::eIoUring: {
+      slot.iov.iov_base = slot.buffer + slot.done;
+      slot.iov.iov_len  = size_t(length);
+      submitIoUring(IORING_OP_READV, slot.handle, &slot.iov, offset, slotIndex);
+      break;
+    }
+#endif
+    default: {
+      {
+        std::lock_guard lock(mutex);
+        ioQueue.push_back(slotIndex);
+      }
+      ioQueueCondition.notify_one();
+      break;
+    }
+  }
+}
+
+void AsyncFileReader::Impl::complete(size_t slotIndex, int64_t result)
+{
+  Slot& slot = slots[slotIndex];
+  if(result > 0)
+  {
+    slot.done += uint64_t(result);
+    if(slot.done < slot.size)
+    {
+      // short read, or the request is larger than a single operation
+      issue(slotIndex);
+      return;
+    }
+  }
+
+  const uint64_t bytesRead = slot.done;
+  const bool     success   = result >= 0;
+  Callback       callback  = std::move(slot.callback);
+  slot.callback            = nullptr;
+  {
+    std::lock_guard lock(mutex);
+    freeSlots.push_back(slotIndex);
+  }
+  slotFreed.notify_one();
+
+  if(callback)
+  {
+    get_thread_pool().detach_task([this, callback = std::move(callback), bytesRead, success]() {
+      callback(bytesRead, success);
+      finishPending();
+    });
+  }
+  else
+  {
+    finishPending();
+  }
+}
+
+void AsyncFileReader::Impl::finishPending()
+{
+  if(pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    // taking the lock orders the notification with `wait` checking the counter
+    std::lock_guard lock(idleMutex);
+    idle.notify_all();
+  }
+}
+
+void AsyncFileReader::Impl::ioThreadLoop()
+{
+  while(true)
+  {
+    size_t slotIndex;
+    {
+      std::unique_lock lock(mutex);
+      ioQueueCondition.wait(lock, [&] { return stop || !ioQueue.empty(); });
+      if(ioQueue.empty())
+        return;
+      slotIndex = ioQueue.front();
+      ioQueue.pop_front();
+    }
+
+    Slot&          slot   = slots[slotIndex];
+    const uint64_t length = std::min(slot.size - slot.done, kMaxReadOp);
+    int64_t        result;
+#ifdef _WIN32
+    OVERLAPPED overlapped{};
+    overlapped.Offset     = DWORD(slot.offset + slot.done);
+    overlapped.OffsetHigh = DWORD((slot.offset + slot.done) >> 32);
+    DWORD bytes           = 0;
+    result = ReadFile(slot.handle, slot.buffer + slot.done, DWORD(length), &bytes, &overlapped) ? int64_t(bytes) : -1;
+#else
+    do
+    {
+      result = pread(slot.handle, slot.buffer + slot.done, size_t(length), off_t(slot.offset + slot.done));
+    } while(result < 0 && errno == EINTR);
+#endif
+    complete(slotIndex, result);
+  }
+}
+
+#ifdef _WIN32
+void AsyncFileReader::Impl::completionPortLoop()
+{
+  while(true)
+  {
+    DWORD       bytes      = 0;
+    ULONG_PTR   key        = 0;
+    OVERLAPPED* overlapped = nullptr;
+    const BOOL  ok         = GetQueuedCompletionStatus(port, &bytes, &key, &overlapped, INFINITE);
+    if(!overlapped)
+    {
+      if(key == kStopKey)
+        return;
+      continue;
+    }
+
+    const size_t slotIndex = size_t(reinterpret_cast<Slot*>(overlapped) - slots.data());
+    if(ok)
+    {
+      complete(slotIndex, int64_t(bytes));
+    }
+    else
+    {
+      complete(slotIndex, GetLastError() == ERROR_HANDLE_EOF ? 0 : -1);
+    }
+  }
+}
+#endif
+
+#ifdef NVUTILS_HAS_IO_URING
+bool AsyncFileReader::Impl::initIoUring(uint32_t entries)
+{
+  io_uring_params params{};
+  ringFd = int(syscall(__NR_io_uring_setup, entries, &params));
+  if(ringFd < 0)
+  {
+    ringFd = -1;
+    return false;
+  }
+
+  sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if(params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+  }
+
+  sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+  if(sqRing == MAP_FAILED)
+  {
+    sqRing = nullptr;
+    deinitIoUring();
+    return false;
+  }
+  if(params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    cqRing = sqRing;
+  }
+  else
+  {
+    cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    if(cqRing == MAP_FAILED)
+    {
+      cqRing = nullptr;
+      deinitIoUring();
+      return false;
+    }
+  }
+
+  sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqesPtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+  if(sqesPtr == MAP_FAILED)
+  {
+    deinitIoUring();
+    return false;
+  }
+  sqes = static_cast<io_uring_sqe*>(sqesPtr);
+
+  char* sq = static_cast<char*>(sqRing);
+  char* cq = static_cast<char*>(cqRing);
+  sqTail   = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+  sqMask   = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+  sqArray  = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+  cqHead   = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+  cqTail   = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+  cqMask   = reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+  cqes     = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  return true;
+}
+
+void AsyncFileReader::Impl::deinitIoUring()
+{
+  if(sqes)
+    munmap(sqes, sqesSize);
+  if(cqRing && cqRing != sqRing)
+    munmap(cqRing, cqRingSize);
+  if(sqRing)
+    munmap(sqRing, sqRingSize);
+  if(ringFd >= 0)
+    ::close(ringFd);
+  sqes   = nullptr;
+  cqRing = nullptr;
+  sqRing = nullptr;
+  ringFd = -1;
+}
+
+void AsyncFileReader::Impl::submitIoUring(uint8_t opcode, int fd, const iovec* iov, uint64_t offset, uint64_t userData)
+{
+  std::lock_guard lock(submitMutex);
+
+  // the kernel consumes the entry within io_uring_enter, and at most `slots.size() + 1` are ever in flight,
+  // so the submission queue cannot be full
+  const uint32_t tail  = *sqTail;
+  const uint32_t index = tail & *sqMask;
+  io_uring_sqe&  sqe   = sqes[index];
+  memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode    = opcode;
+  sqe.fd        = fd;
+  sqe.addr      = reinterpret_cast<uint64_t>(iov);
+  sqe.len       = iov ? 1 : 0;
+  sqe.off       = offset;
+  sqe.user_data = userData;
+  sqArray[index] = index;
+  __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+  int result;
+  do
+  {
+    result = int(syscall(__NR_io_uring_enter, ringFd, 1, 0, 0, nullptr, 0));
+  } while(result < 0 && errno == EINTR);
+  assert(result == 1 && "io_uring_enter failed");
+}
+
+void AsyncFileReader::Impl::ioUringLoop()
+{
+  while(true)
+  {
+    uint32_t head = *cqHead;
+    uint32_t tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    if(head == tail)
+    {
+      syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      continue;
+    }
+
+    // The kernel orders the slot writes of the submitter with the completion, but that is invisible to the
+    // C++ memory model. The entries were submitted under `submitMutex`, taking it makes the ordering explicit.
+    {
+      std::lock_guard lock(submitMutex);
+    }
+
+    bool stopRequested = false;
+    for(; head != tail; head++)
+    {
+      const io_uring_cqe cqe = cqes[head & *cqMask];
+      if(cqe.user_data == kStopUserData)
+      {
+        stopRequested = true;
+        continue;
+      }
+      // release the entry before `complete`, which may submit a follow-up read
+      __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+      if(cqe.res == -EINTR || cqe.res == -EAGAIN)
+      {
+        issue(size_t(cqe.user_data));
+      }
+      else
+      {
+        complete(size_t(cqe.user_data), int64_t(cqe.res));
+      }
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    if(stopRequested)
+      return;
+  }
+}
+#endif
+
+AsyncFileReader::AsyncFileReader() = default;
+
+AsyncFileReader::~AsyncFileReader()
+{
+  deinit();
+}
+
+bool AsyncFileReader::init(uint32_t maxOutstanding)
+{
+  assert(!m_impl && "init called twice");
+  m_impl = std::make_unique<Impl>();
+  if(!m_impl->init(std::max(maxOutstanding, 1u)))
+  {
+    m_impl.reset();
+    return false;
+  }
+  return true;
+}
+
+void AsyncFileReader::deinit()
+{
+  if(!m_impl)
+    return;
+
+  wait();
+  m_impl->deinit();
+  m_impl.reset();
+}
+
+AsyncFileReader::FileID AsyncFileReader::openFile(const std::filesystem::path& filePath)
+{
+  Impl::File file;
+#ifdef _WIN32
+  const DWORD flags = m_impl->backend == Backend::eOverlapped ? FILE_FLAG_OVERLAPPED : 0;
+  file.handle = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+  LARGE_INTEGER size{};
+  if(file.handle != kNoNativeFile
+     && (!GetFileSizeEx(file.handle, &size)
+         || (m_impl->backend == Backend::eOverlapped && !CreateIoCompletionPort(file.handle, m_impl->port, 0, 0))))
+  {
+    CloseHandle(file.handle);
+    file.handle = kNoNativeFile;
+  }
+  file.size = uint64_t(size.QuadPart);
+#else
+  file.handle = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat s;
+  if(file.handle != kNoNativeFile && fstat(file.handle, &s) < 0)
+  {
+    ::close(file.handle);
+    file.handle = kNoNativeFile;
+  }
+  file.size = file.handle != kNoNativeFile ? uint64_t(s.st_size) : 0;
+#endif
+
+  if(file.handle == kNoNativeFile)
+  {
+    LOGW("Could not open file: %s\n", utf8FromPath(filePath).c_str());
+    return kInvalidFile;
+  }
+
+  std::lock_guard lock(m_impl->mutex);
+  auto            it = std::find_if(m_impl->files.begin(), m_impl->files.end(),
+                                    [](const Impl::File& f) { return f.handle == kNoNativeFile; });
+  if(it != m_impl->files.end())
+  {
+    *it = file;
+    return FileID(it - m_impl->files.begin());
+  }
+  m_impl->files.push_back(file);
+  return FileID(m_impl->files.size() - 1);
+}
+
+void AsyncFileReader::closeFile(FileID file)
+{
+  std::lock_guard lock(m_impl->mutex);
+  if(file >= m_impl->files.size() || m_impl->files[file].handle == kNoNativeFile)
+    return;
+
+#ifdef _WIN32
+  CloseHandle(m_impl->files[file].handle);
+#else
+  ::close(m_impl->files[file].handle);
+#endif
+  m_impl->files[file] = {};
+}
+
+uint64_t AsyncFileReader::getFileSize(FileID file) const
+{
+  std::lock_guard lock(m_impl->mutex);
+  return file < m_impl->files.size() ? m_impl->files[file].size : 0;
+}
+
+bool AsyncFileReader::read(FileID file, uint64_t offset, uint64_t size, void* buffer, Callback callback)
+{
+  size_t slotIndex;
+  {
+    std::unique_lock lock(m_impl->mutex);
+    if(file >= m_impl->files.size() || m_impl->files[file].handle == kNoNativeFile)
+      return false;
+
+    m_impl->slotFreed.wait(lock, [&] { return !m_impl->freeSlots.empty(); });
+    slotIndex = m_impl->freeSlots.back();
+    m_impl->freeSlots.pop_back();
+
+    Impl::Slot& slot = m_impl->slots[slotIndex];
+    slot.handle      = m_impl->files[file].handle;
+    slot.offset      = offset;
+    // clamp to the file, reading past the end completes with the bytes available
+    slot.size     = offset < m_impl->files[file].size ? std::min(size, m_impl->files[file].size - offset) : 0;
+    slot.done     = 0;
+    slot.buffer   = static_cast<char*>(buffer);
+    slot.callback = std::move(callback);
+  }
+
+  m_impl->pending.fetch_add(1, std::memory_order_relaxed);
+  if(m_impl->slots[slotIndex].size == 0)
+  {
+    m_impl->complete(slotIndex, 0);
+  }
+  else
+  {
+    m_impl->issue(slotIndex);
+  }
+  return true;
+}
+
+bool AsyncFileReader::readChunked(FileID file, uint64_t offset, uint64_t size, void* buffer, uint64_t chunkSize, ChunkCallback callback)
+{
+  chunkSize   = std::max(chunkSize, uint64_t(1));
+  auto shared = std::make_shared<ChunkCallback>(std::move(callback));
+  for(uint64_t chunkOffset = 0; chunkOffset < size; chunkOffset += chunkSize)
+  {
+    Callback chunkCallback;
+    if(*shared)
+    {
+      chunkCallback = [shared, chunkOffset](uint64_t bytesRead, bool success) { (*shared)(chunkOffset, bytesRead, success); };
+    }
+    if(!read(file, offset + chunkOffset, std::min(chunkSize, size - chunkOffset), static_cast<char*>(buffer) + chunkOffset,
+             std::move(chunkCallback)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AsyncFileReader::wait()
+{
+  if(!m_impl)
+    return;
+
+  assert(!BS::this_thread::get_index().has_value() && "must not wait from a pool thread, the callbacks run there");
+  std::unique_lock lock(m_impl->idleMutex);
+  m_impl->idle.wait(lock, [&] { return m_impl->pending.load(std::memory_order_acquire) == 0; });
+}
+
+AsyncFileReader::Backend AsyncFileReader::getBackend() const
+{
+  return m_impl ? m_impl->backend : Backend::eThreads;
+}
+
+}  // namespace nvutils
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+
+namespace nvutils {
+/*-------------------------------------------------------------------------------------------------
+Asynchronous file reader with many outstanding reads, complementing the blocking whole-file
+helpers of file_operations.hpp. Reads go into caller-provided buffers and their completion
+callbacks run on the `parallel_work` thread pool (`get_thread_pool()`), so decoding of a chunk
+overlaps with the reads of the next ones. This hides the latency of network storage.
+
+Backends:
+- Linux: io_uring, falling back to blocking reads on a set of I/O threads where it is unavailable
+  (old kernels, containers filtering the syscall)
+- Windows: overlapped I/O with a completion port
+
+`read` blocks while `maxOutstanding` reads are in flight. Callbacks may issue new reads but must
+not call `wait`. Buffers must stay valid until their callback has run.
+
+```cpp
+nvutils::AsyncFileReader reader;
+reader.init();
+
+nvutils::AsyncFileReader::FileID file = reader.openFile(path);
+std::vector<char>                data(reader.getFileSize(file));
+reader.readChunked(file, 0, data.size(), data.data(), 4 << 20, [&](uint64_t chunkOffset, uint64_t bytesRead, bool success) {
+  if(success)
+    parseChunk(data.data() + chunkOffset, bytesRead);
+});
+reader.wait();
+reader.closeFile(file);
+```
+-------------------------------------------------------------------------------------------------*/
+class AsyncFileReader
+{
+public:
+  using FileID                        = uint32_t;
+  static constexpr FileID kInvalidFile = ~0u;
+
+  // `bytesRead` is less than requested when the read reaches the end of the file, `success` is false on I/O errors
+  using Callback      = std::function<void(uint64_t bytesRead, bool success)>;
+  using ChunkCallback = std::function<void(uint64_t chunkOffset, uint64_t bytesRead, bool success)>;
+
+  enum class Backend
+  {
+    eIoUring,
+    eOverlapped,
+    eThreads,
+  };
+
+  AsyncFileReader();
+  ~AsyncFileReader();
+
+  AsyncFileReader(const AsyncFileReader&)            = delete;
+  AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+  bool init(uint32_t maxOutstanding = 64);
+  // waits for the outstanding reads and closes the files still open
+  void deinit();
+
+  // returns kInvalidFile on failure
+  FileID   openFile(const std::filesystem::path& filePath);
+  void     closeFile(FileID file);  // no reads of the file may be outstanding
+  uint64_t getFileSize(FileID file) const;
+
+  // Queues a read of `size` bytes at `offset` into `buffer`, `callback` may be empty
+  bool read(FileID file, uint64_t offset, uint64_t size, void* buffer, Callback callback);
+
+  // Splits a read into reads of `chunkSize` bytes, `callback` runs once per chunk; `chunkOffset` is relative to `offset`
+  bool readChunked(FileID file, uint64_t offset, uint64_t size, void* buffer, uint64_t chunkSize, ChunkCallback callback);
+
+  // Waits for all reads and their callbacks
+  void wait();
+
+  Backend getBackend() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+}  // namespace nvutils
@@ -19,8 +19,175 @@
 
 #include "bit_array.hpp"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NVUTILS_BIT_ARRAY_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NVUTILS_BIT_ARRAY_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define NVUTILS_BIT_ARRAY_NEON 1
+#endif
+
 namespace nvutils {
 
+namespace {
+
+enum class BitOp
+{
+  eAnd,
+  eOr,
+  eXor,
+  eAndNot,  // a & ~b
+};
+
+template <BitOp OP>
+inline uint64_t applyBitOp(uint64_t a, uint64_t b)
+{
+  if constexpr(OP == BitOp::eAnd)
+    return a & b;
+  else if constexpr(OP == BitOp::eOr)
+    return a | b;
+  else if constexpr(OP == BitOp::eXor)
+    return a ^ b;
+  else
+    return a & ~b;
+}
+
+// dst[i] = OP(a[i], b[i]), dst may alias a
+template <BitOp OP>
+void applyBitOp(uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t numElements)
+{
+  size_t i = 0;
+#if defined(NVUTILS_BIT_ARRAY_AVX2)
+  for(; i + 4 <= numElements; i += 4)
+  {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    __m256i       vr;
+    if constexpr(OP == BitOp::eAnd)
+      vr = _mm256_and_si256(va, vb);
+    else if constexpr(OP == BitOp::eOr)
+      vr = _mm256_or_si256(va, vb);
+    else if constexpr(OP == BitOp::eXor)
+      vr = _mm256_xor_si256(va, vb);
+    else
+      vr = _mm256_andnot_si256(vb, va);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), vr);
+  }
+#elif defined(NVUTILS_BIT_ARRAY_SSE2)
+  for(; i + 2 <= numElements; i += 2)
+  {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    __m128i       vr;
+    if constexpr(OP == BitOp::eAnd)
+      vr = _mm_and_si128(va, vb);
+    else if constexpr(OP == BitOp::eOr)
+      vr = _mm_or_si128(va, vb);
+    else if constexpr(OP == BitOp::eXor)
+      vr = _mm_xor_si128(va, vb);
+    else
+      vr = _mm_andnot_si128(vb, va);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), vr);
+  }
+#elif defined(NVUTILS_BIT_ARRAY_NEON)
+  for(; i + 2 <= numElements; i += 2)
+  {
+    const uint64x2_t va = vld1q_u64(a + i);
+    const uint64x2_t vb = vld1q_u64(b + i);
+    uint64x2_t       vr;
+    if constexpr(OP == BitOp::eAnd)
+      vr = vandq_u64(va, vb);
+    else if constexpr(OP == BitOp::eOr)
+      vr = vorrq_u64(va, vb);
+    else if constexpr(OP == BitOp::eXor)
+      vr = veorq_u64(va, vb);
+    else
+      vr = vbicq_u64(va, vb);
+    vst1q_u64(dst + i, vr);
+  }
+#endif
+  for(; i < numElements; i++)
+  {
+    dst[i] = applyBitOp<OP>(a[i], b[i]);
+  }
+}
+
+size_t popcountElements(const uint64_t* elements, size_t numElements)
+{
+  size_t count = 0;
+  size_t i     = 0;
+#if defined(NVUTILS_BIT_ARRAY_AVX2)
+  // nibble lookup table, without relying on the popcnt instruction
+  const __m256i lookup  = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,  //
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i lowMask = _mm256_set1_epi8(0x0f);
+  __m256i       sums    = _mm256_setzero_si256();
+  for(; i + 4 <= numElements; i += 4)
+  {
+    const __m256i v     = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(elements + i));
+    const __m256i lo    = _mm256_and_si256(v, lowMask);
+    const __m256i hi    = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+    const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    sums                = _mm256_add_epi64(sums, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+  }
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+  count = size_t(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+#elif defined(NVUTILS_BIT_ARRAY_NEON)
+  uint64x2_t sums = vdupq_n_u64(0);
+  for(; i + 2 <= numElements; i += 2)
+  {
+    const uint8x16_t bytes = vcntq_u8(vreinterpretq_u8_u64(vld1q_u64(elements + i)));
+    sums                   = vpadalq_u32(sums, vpaddlq_u16(vpaddlq_u8(bytes)));
+  }
+  count = size_t(vaddvq_u64(sums));
+#endif
+  for(; i < numElements; i++)
+  {
+    count += std::popcount(elements[i]);
+  }
+  return count;
+}
+
+// Returns the first element in [begin, end) that is not zero, or `end`
+size_t findNonZeroElement(const uint64_t* elements, size_t begin, size_t end)
+{
+  size_t i = begin;
+#if defined(NVUTILS_BIT_ARRAY_AVX2)
+  for(; i + 4 <= end; i += 4)
+  {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(elements + i));
+    if(!_mm256_testz_si256(v, v))
+      break;
+  }
+#elif defined(NVUTILS_BIT_ARRAY_SSE2)
+  for(; i + 2 <= end; i += 2)
+  {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(elements + i));
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF)
+      break;
+  }
+#elif defined(NVUTILS_BIT_ARRAY_NEON)
+  for(; i + 2 <= end; i += 2)
+  {
+    const uint32x4_t v = vreinterpretq_u32_u64(vld1q_u64(elements + i));
+    if(vmaxvq_u32(v) != 0)
+      break;
+  }
+#endif
+  for(; i < end; i++)
+  {
+    if(elements[i])
+      return i;
+  }
+  return end;
+}
+
+}  // namespace
+
 /** \brief Create a new BitVector with all bits set to false
       \param size Number of Bits in the Array
   **/
@@ -122,10 +289,7 @@ BitArray BitArray::operator^(BitArray const& rhs)
   assert(size() == rhs.size());
 
   BitArray result(size(), -1);
-  for(size_t index = 0; index < determineNumberOfElements(); ++index)
-  {
-    result.m_bits[index] = m_bits[index] ^ rhs.m_bits[index];
-  }
+  applyBitOp<BitOp::eXor>(result.m_bits.get(), m_bits.get(), rhs.m_bits.get(), determineNumberOfElements());
   clearUnusedBits();
 
   return result;
@@ -136,10 +300,7 @@ BitArray BitArray::operator|(BitArray const& rhs)
   assert(size() == rhs.size());
 
   BitArray result(size(), -1);
-  for(size_t index = 0; index < determineNumberOfElements(); ++index)
-  {
-    result.m_bits[index] = m_bits[index] | rhs.m_bits[index];
-  }
+  applyBitOp<BitOp::eOr>(result.m_bits.get(), m_bits.get(), rhs.m_bits.get(), determineNumberOfElements());
   clearUnusedBits();
 
   return result;
@@ -150,10 +311,7 @@ BitArray BitArray::operator&(BitArray const& rhs)
   assert(size() == rhs.size());
 
   BitArray result(size(), -1);
-  for(size_t index = 0; index < determineNumberOfElements(); ++index)
-  {
-    result.m_bits[index] = m_bits[index] & rhs.m_bits[index];
-  }
+  applyBitOp<BitOp::eAnd>(result.m_bits.get(), m_bits.get(), rhs.m_bits.get(), determineNumberOfElements());
   clearUnusedBits();
 
   return result;
@@ -163,10 +321,7 @@ BitArray& BitArray::operator^=(BitArray const& rhs)
 {
   assert(size() == rhs.size());
 
-  for(size_t index = 0; index < determineNumberOfElements(); ++index)
-  {
-    m_bits[index] ^= rhs.m_bits[index];
-  }
+  applyBitOp<BitOp::eXor>(m_bits.get(), m_bits.get(), rhs.m_bits.get(), determineNumberOfElements());
   clearUnusedBits();
 
   return *this;
@@ -176,10 +331,7 @@ BitArray& BitArray::operator|=(BitArray const& rhs)
 {
   assert(size() == rhs.size());
 
-  for(size_t index = 0; index < determineNumberOfElements(); ++index)
-  {
-    m_bits[index] |= rhs.m_bits[index];
-  }
+  applyBitOp<BitOp::eOr>(m_bits.get(), m_bits.get(), rhs.m_bits.get(), determineNumberOfElements());
 
   return *this;
 }
@@ -188,10 +340,16 @@ BitArray& BitArray::operator&=(BitArray const& rhs)
 {
   assert(size() == rhs.size());
 
-  for(size_t index = 0; index < determineNumberOfElements(); ++index)
-  {
-    m_bits[index] &= rhs.m_bits[index];
-  }
+  applyBitOp<BitOp::eAnd>(m_bits.get(), m_bits.get(), rhs.m_bits.get(), determineNumberOfElements());
+
+  return *this;
+}
+
+BitArray& BitArray::andNot(BitArray const& rhs)
+{
+  assert(size() == rhs.size());
+
+  applyBitOp<BitOp::eAndNot>(m_bits.get(), m_bits.get(), rhs.m_bits.get(), determineNumberOfElements());
 
   return *this;
 }
@@ -226,32 +384,54 @@ void BitArray::fill()
 
 size_t BitArray::countLeadingZeroes() const
 {
-  size_t index = 0;
+  return findNextSetBit(0);
+}
 
-  // first count
-  while(index < determineNumberOfElements() && !m_bits[index])
-  {
-    ++index;
-  }
+size_t BitArray::countSetBits() const
+{
+  return popcountElements(m_bits.get(), determineNumberOfElements());
+}
 
-  size_t leadingZeroes = index * StorageBitsPerElement;
-  if(index < determineNumberOfElements())
+size_t BitArray::countSetBits(size_t begin, size_t count) const
+{
+  assert(begin + count <= m_size);
+  if(!count)
+    return 0;
+
+  const size_t         end          = begin + count;
+  const size_t         endBit       = end % StorageBitsPerElement;
+  const size_t         firstElement = begin / StorageBitsPerElement;
+  const size_t         lastElement  = (end - 1) / StorageBitsPerElement;
+  const BitStorageType firstMask    = ~BitStorageType(0) << (begin % StorageBitsPerElement);
+  const BitStorageType lastMask     = endBit ? ~BitStorageType(0) >> (StorageBitsPerElement - endBit) : ~BitStorageType(0);
+
+  if(firstElement == lastElement)
   {
-    leadingZeroes += std::countr_zero(m_bits[index]);
+    return std::popcount(m_bits[firstElement] & firstMask & lastMask);
   }
 
-  return std::min(leadingZeroes, size());
+  return std::popcount(m_bits[firstElement] & firstMask)
+         + popcountElements(m_bits.get() + firstElement + 1, lastElement - firstElement - 1)
+         + std::popcount(m_bits[lastElement] & lastMask);
 }
 
-size_t BitArray::countSetBits() const
+size_t BitArray::findNextSetBit(size_t index) const
 {
-  size_t count = 0;
-  for(size_t i = 0; i < determineNumberOfElements(); i++)
+  if(index >= m_size)
+    return m_size;
+
+  const size_t   numElements = determineNumberOfElements();
+  size_t         element     = index / StorageBitsPerElement;
+  BitStorageType bits        = m_bits[element] & (~BitStorageType(0) << (index % StorageBitsPerElement));
+  if(!bits)
   {
-    count += std::popcount(m_bits[i]);
+    element = findNonZeroElement(m_bits.get(), element + 1, numElements);
+    if(element == numElements)
+      return m_size;
+    bits = m_bits[element];
   }
 
-  return count;
+  return std::min(element * StorageBitsPerElement + std::countr_zero(bits), m_size);
 }
 
 }  // namespace nvutils
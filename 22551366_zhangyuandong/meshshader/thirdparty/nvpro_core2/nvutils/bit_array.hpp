@@ -25,12 +25,15 @@
 #include <memory>
 
 #include "bit_operations.hpp"
+#include "parallel_work.hpp"
 
 namespace nvutils {
 
 // This class provides a container for an array of bits.
 // It provides utility functions for bitwise operations on all bits,
 // as well as means to traverse all set bits.
+// The bulk operations (bitwise operators, `andNot`, `countSetBits`, `findNextSetBit`) process
+// multiple elements per instruction with AVX2, SSE2 or NEON, depending on the target architecture.
 class BitArray
 {
 public:
@@ -55,6 +58,9 @@ public:
   BitArray& operator|=(BitArray const& rhs);
   BitArray  operator~() const;
 
+  // this = this & ~rhs, e.g. to remove the bits of `rhs` from a set
+  BitArray& andNot(BitArray const& rhs);
+
   void clear();
   void fill();
 
@@ -81,8 +87,19 @@ public:
   template <typename Visitor>
   void traverseBits(Visitor visitor, size_t begin, size_t count) const;
 
+  // Like traverseBits, but distributes batches of `BATCHELEMENTS` elements across threads.
+  // `visitor` is called concurrently and must be thread-safe, the order of the indices is undefined.
+  template <uint64_t BATCHELEMENTS = 64, typename Visitor>
+  void traverseBitsParallel(Visitor visitor) const;
+
   size_t countLeadingZeroes() const;
   size_t countSetBits() const;
+  // number of set bits in [begin, begin + count), arbitrary bit boundaries
+  size_t countSetBits(size_t begin, size_t count) const;
+
+  // Returns the index of the first set bit >= `index`, or size() if there is none.
+  // Empty elements are skipped several at a time.
+  size_t findNextSetBit(size_t index) const;
 
 private:
   size_t                            m_size = 0;
@@ -184,6 +201,18 @@ void BitArray::traverseBits(Visitor visitor, size_t begin, size_t count) const
   }
 }
 
+template <uint64_t BATCHELEMENTS, typename Visitor>
+void BitArray::traverseBitsParallel(Visitor visitor) const
+{
+  const size_t numElements = determineNumberOfElements();
+  const size_t numBatches  = (numElements + BATCHELEMENTS - 1) / BATCHELEMENTS;
+  parallel_batches<1>(numBatches, [&](uint64_t batchIndex) {
+    const size_t elementStart = batchIndex * BATCHELEMENTS;
+    const size_t elementCount = std::min(size_t(BATCHELEMENTS), numElements - elementStart);
+    bitTraverse(m_bits.get() + elementStart, elementCount, visitor, elementStart * StorageBitsPerElement);
+  });
+}
+
 inline void BitArray::clearUnusedBits()
 {
   if(m_size)
@@ -57,7 +57,7 @@ void CameraManipulator::setCamera(Camera camera, bool instantSet /*=true*/)
     m_goal      = camera;
     m_snapshot  = m_current;
     m_animDone  = false;
-    m_startTime = getSystemTime();
+    m_startTime = getAnimationTime();
     findBezierPoints();
   }
 }
@@ -204,7 +204,13 @@ void CameraManipulator::dolly(glm::vec2 displacement, bool keepCenterFixed /*= f
 //   over time.
 void CameraManipulator::updateAnim()
 {
-  auto elapse = static_cast<float>(getSystemTime() - m_startTime) / 1000.f;
+  // The inputs and animations since the previous call are what the previous frame rendered
+  m_previousViewProj = getPerspectiveMatrix() * m_matrix;
+  m_previousJitter   = getJitter();
+  m_frameIndex++;
+  m_fixedTime += m_fixedTimeStep * 1000.0;
+
+  auto elapse = static_cast<float>(getAnimationTime() - m_startTime) / 1000.f;
 
   // Camera moving to new position
   if(m_animDone)
@@ -255,7 +261,7 @@ void CameraManipulator::setMatrix(const glm::mat4& matrix, bool instantSet, floa
   {
     m_goal      = camera;
     m_snapshot  = m_current;
-    m_startTime = getSystemTime();
+    m_startTime = getAnimationTime();
     findBezierPoints();
   }
   updateLookatMatrix();
@@ -438,6 +444,58 @@ double CameraManipulator::getSystemTime()
   return std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / 1000.0;
 }
 
+//--------------------------------------------------------------------------------------------------
+// With a fixed time step, the animation time only advances in updateAnim()
+//
+double CameraManipulator::getAnimationTime()
+{
+  return m_fixedTimeStep > 0.0 ? m_fixedTime : getSystemTime();
+}
+
+void CameraManipulator::setFixedTimeStep(double seconds)
+{
+  // Continue from the current time, an animation in progress neither jumps nor restarts
+  m_fixedTime     = getAnimationTime();
+  m_fixedTimeStep = seconds;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Radical inverse in `base` of `index`, the Halton sequence
+//
+static float halton(uint32_t index, uint32_t base)
+{
+  float result = 0.0f;
+  float f      = 1.0f;
+  while(index > 0)
+  {
+    f /= float(base);
+    result += f * float(index % base);
+    index /= base;
+  }
+  return result;
+}
+
+glm::vec2 CameraManipulator::getJitter() const
+{
+  if(m_jitterLength == 0)
+  {
+    return glm::vec2(0);
+  }
+  // Index 0 of the sequence is (0,0), start at 1
+  const uint32_t index = uint32_t(m_frameIndex % m_jitterLength) + 1;
+  return glm::vec2(halton(index, 2), halton(index, 3)) - 0.5f;
+}
+
+glm::mat4 CameraManipulator::getJitteredPerspectiveMatrix() const
+{
+  glm::mat4 projMatrix = getPerspectiveMatrix();
+  glm::vec2 jitter     = getJitter();
+  // Offset in NDC, after the perspective division
+  projMatrix[2][0] += jitter.x * 2.0f / float(m_windowSize.x);
+  projMatrix[2][1] += jitter.y * 2.0f / float(m_windowSize.y);
+  return projMatrix;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Return a string which can be included in help dialogs
 //
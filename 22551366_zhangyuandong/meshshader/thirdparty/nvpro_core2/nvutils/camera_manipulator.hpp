@@ -21,6 +21,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <string>
@@ -49,6 +50,14 @@ namespace nvutils {
 
   Retrieve the camera matrix by calling getMatrix()
 
+  For temporal techniques (TAA, reprojection):
+  - updateAnim() marks the start of a frame: the view-projection at that moment is kept
+    as the previous frame's, see getPreviousViewProjMatrix()
+  - setJitterSequenceLength() enables sub-pixel offsets of the Halton (2,3) sequence,
+    applied by getJitteredPerspectiveMatrix()
+  - setFixedTimeStep() advances the animations by a constant step per frame, making
+    camera transitions and key motions reproducible at any frame rate
+
   See: appbase_vkpp.hpp
 
   ```cpp
@@ -119,6 +128,7 @@ public:
   void setLookat(const glm::vec3& eye, const glm::vec3& center, const glm::vec3& up, bool instantSet = true);
 
   // This should be called in an application loop to update the camera matrix if this one is animated: new position, key movement
+  // Call it once per frame, before the inputs of the frame: it also advances the jitter and keeps the previous frame's matrices
   void updateAnim();
 
   // To call when the size of the window change.  This allows to do nicer movement according to the window size.
@@ -192,6 +202,25 @@ public:
   void   setAnimationDuration(double val) { m_duration = val; }
   bool   isAnimated() const { return m_animDone == false; }
 
+  // Time step in seconds of each updateAnim() instead of the elapsed time, 0 to follow the system clock.
+  // ElementCamera also uses it for the key motions.
+  void   setFixedTimeStep(double seconds);
+  double getFixedTimeStep() const { return m_fixedTimeStep; }
+
+  // Number of frames before the jitter sequence repeats, 0 disables the jitter
+  void     setJitterSequenceLength(uint32_t length) { m_jitterLength = length; }
+  uint32_t getJitterSequenceLength() const { return m_jitterLength; }
+  // Sub-pixel offset of the current frame, in pixels within [-0.5, 0.5]
+  glm::vec2 getJitter() const;
+  // getPerspectiveMatrix() with the projection shifted by getJitter()
+  glm::mat4 getJitteredPerspectiveMatrix() const;
+
+  // Number of updateAnim() calls
+  uint64_t getFrameIndex() const { return m_frameIndex; }
+  // Unjittered view-projection and jitter of the previous frame
+  const glm::mat4& getPreviousViewProjMatrix() const { return m_previousViewProj; }
+  glm::vec2        getPreviousJitter() const { return m_previousJitter; }
+
   // Returning a default help string
   const std::string& getHelp();
 
@@ -211,6 +240,8 @@ private:
 
 
   double getSystemTime();
+  // Milliseconds of the animations, the system time or the sum of the fixed steps
+  double getAnimationTime();
 
   glm::vec3 computeBezier(float t, glm::vec3& p0, glm::vec3& p1, glm::vec3& p2);
   void      findBezierPoints();
@@ -223,10 +254,18 @@ protected:
   Camera m_snapshot;  // Current camera the moment a set look-at is done
 
   // Animation
-  std::array<glm::vec3, 3> m_bezier    = {};
-  double                   m_startTime = 0;
-  double                   m_duration  = 0.5;
-  bool                     m_animDone  = true;
+  std::array<glm::vec3, 3> m_bezier        = {};
+  double                   m_startTime     = 0;
+  double                   m_duration      = 0.5;
+  bool                     m_animDone      = true;
+  double                   m_fixedTimeStep = 0;
+  double                   m_fixedTime     = 0;  // getAnimationTime() with a fixed time step
+
+  // Temporal
+  uint32_t  m_jitterLength     = 0;
+  uint64_t  m_frameIndex       = 0;
+  glm::mat4 m_previousViewProj = glm::mat4(1);
+  glm::vec2 m_previousJitter   = glm::vec2(0);
 
   // Window size
   glm::uvec2 m_windowSize = glm::uvec2(1, 1);
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <fmt/format.h>
+
+#include "camera_path.hpp"
+#include "file_operations.hpp"
+#include "logger.hpp"
+
+namespace nvutils {
+
+void CameraPath::addKeyframe(double time, const CameraManipulator::Camera& camera, uint32_t segment /*= 0*/)
+{
+  assert(m_keyframes.empty() || time >= m_keyframes.back().time);
+  m_keyframes.push_back({time, segment, camera});
+}
+
+bool CameraPath::save(const std::filesystem::path& filename) const
+{
+  std::ofstream file(filename);
+  if(!file)
+  {
+    LOGE("Camera path: cannot write %s\n", utf8FromPath(filename).c_str());
+    return false;
+  }
+  file << "# time segment {eye}, {center}, {up}, {fov}, {clip}\n";
+  for(const Keyframe& keyframe : m_keyframes)
+  {
+    file << fmt::format("{} {} {}\n", keyframe.time, keyframe.segment, keyframe.camera.getString());
+  }
+  LOGI("Camera path: %zu keyframes written to %s\n", m_keyframes.size(), utf8FromPath(filename).c_str());
+  return true;
+}
+
+bool CameraPath::load(const std::filesystem::path& filename)
+{
+  std::ifstream file(filename);
+  if(!file)
+  {
+    LOGE("Camera path: cannot read %s\n", utf8FromPath(filename).c_str());
+    return false;
+  }
+
+  std::vector<Keyframe> keyframes;
+  std::string           line;
+  uint32_t              lineNumber = 0;
+  while(std::getline(file, line))
+  {
+    lineNumber++;
+    if(line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+
+    Keyframe keyframe;
+    int      cameraOffset = 0;
+    if(sscanf(line.c_str(), "%lf %u %n", &keyframe.time, &keyframe.segment, &cameraOffset) < 2
+       || !keyframe.camera.setFromString(line.substr(cameraOffset))
+       || (!keyframes.empty() && keyframe.time < keyframes.back().time))
+    {
+      LOGE("Camera path: invalid keyframe at %s:%u\n", utf8FromPath(filename).c_str(), lineNumber);
+      return false;
+    }
+    keyframes.push_back(keyframe);
+  }
+
+  m_keyframes = std::move(keyframes);
+  return true;
+}
+
+size_t CameraPath::findKeyframe(double time) const
+{
+  auto it = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time,
+                             [](double t, const Keyframe& keyframe) { return t < keyframe.time; });
+  return it == m_keyframes.begin() ? 0 : size_t(std::distance(m_keyframes.begin(), it)) - 1;
+}
+
+CameraManipulator::Camera CameraPath::evaluate(double time) const
+{
+  if(m_keyframes.empty())
+  {
+    return {};
+  }
+
+  const size_t index = findKeyframe(time);
+  if(index + 1 == m_keyframes.size() || time <= m_keyframes[index].time)
+  {
+    return m_keyframes[index].camera;
+  }
+
+  const CameraManipulator::Camera& a = m_keyframes[index].camera;
+  const CameraManipulator::Camera& b = m_keyframes[index + 1].camera;
+  const float t = float((time - m_keyframes[index].time) / (m_keyframes[index + 1].time - m_keyframes[index].time));
+
+  CameraManipulator::Camera camera;
+  camera.eye  = glm::mix(a.eye, b.eye, t);
+  camera.ctr  = glm::mix(a.ctr, b.ctr, t);
+  camera.up   = glm::normalize(glm::mix(a.up, b.up, t));
+  camera.fov  = glm::mix(a.fov, b.fov, t);
+  camera.clip = glm::mix(a.clip, b.clip, t);
+  return camera;
+}
+
+uint32_t CameraPath::getSegment(double time) const
+{
+  return m_keyframes.empty() ? 0 : m_keyframes[findKeyframe(time)].segment;
+}
+
+}  // namespace nvutils
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_CameraPath()
+{
+  nvutils::CameraManipulator cameraManip;
+
+  // Recording, e.g. once per frame
+  nvutils::CameraPath path;
+  path.addKeyframe(0.0, cameraManip.getCamera());
+  cameraManip.setLookat({0, 2, 10}, {0, 0, 0}, {0, 1, 0});
+  path.addKeyframe(2.5, cameraManip.getCamera());
+  // The second segment starts here
+  cameraManip.setLookat({0, 0, 1}, {0, 0, 0}, {0, 1, 0});
+  path.addKeyframe(4.0, cameraManip.getCamera(), 1);
+  path.save("flyover.campath");
+
+  // Playback driven by the frame index, the same views at any frame rate
+  nvutils::CameraPath playback;
+  if(playback.load("flyover.campath"))
+  {
+    const double frameTime = 1.0 / 60.0;
+    for(uint32_t frame = 0; frame * frameTime <= playback.getDuration(); frame++)
+    {
+      cameraManip.setCamera(playback.evaluate(frame * frameTime));
+      // ... render, accumulate the frame time of playback.getSegment(frame * frameTime)
+    }
+  }
+}
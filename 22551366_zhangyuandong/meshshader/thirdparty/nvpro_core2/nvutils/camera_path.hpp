@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "camera_manipulator.hpp"
+
+namespace nvutils {
+
+//--------------------------------------------------------------------------------------------------
+// Camera Path
+//
+// Timestamped cameras (eye, center, up, fov, clip planes), recorded from a `CameraManipulator`
+// and played back to replay the exact same views, e.g. across the runs of a benchmark.
+//
+// - The cameras in between two keyframes are interpolated linearly, the time is clamped to the path.
+// - Keyframes are grouped in segments (e.g. "fly over", "close up"), the frame times of a
+//   playback can be reported per segment.
+// - The file is text, one keyframe per line: `time segment {eye}, {center}, {up}, {fov}, {clip}`,
+//   the camera in the format of `CameraManipulator::Camera::getString`.
+//
+// Usage:
+//   see usage_CameraPath in camera_path.cpp, and `nvapp::ElementCamera` for recording and playback
+//--------------------------------------------------------------------------------------------------
+
+class CameraPath
+{
+public:
+  struct Keyframe
+  {
+    double                    time    = 0;  // seconds since the start of the path
+    uint32_t                  segment = 0;
+    CameraManipulator::Camera camera;
+  };
+
+  void clear() { m_keyframes.clear(); }
+  bool empty() const { return m_keyframes.empty(); }
+
+  // `time` must not be before the last keyframe
+  void addKeyframe(double time, const CameraManipulator::Camera& camera, uint32_t segment = 0);
+
+  bool save(const std::filesystem::path& filename) const;
+  bool load(const std::filesystem::path& filename);
+
+  CameraManipulator::Camera evaluate(double time) const;
+  // Segment of the keyframe at or before `time`
+  uint32_t getSegment(double time) const;
+  uint32_t getSegmentCount() const { return m_keyframes.empty() ? 0 : m_keyframes.back().segment + 1; }
+
+  double                       getDuration() const { return m_keyframes.empty() ? 0.0 : m_keyframes.back().time; }
+  const std::vector<Keyframe>& getKeyframes() const { return m_keyframes; }
+
+private:
+  // Index of the last keyframe at or before `time`
+  size_t findKeyframe(double time) const;
+
+  std::vector<Keyframe> m_keyframes;
+};
+
+}  // namespace nvutils
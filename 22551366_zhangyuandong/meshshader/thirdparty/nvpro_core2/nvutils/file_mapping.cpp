@@ -37,6 +37,8 @@
 
 #include "file_mapping.hpp"
 
+#include <algorithm>
+
 #if defined(_WIN32)
 inline DWORD HIDWORD(size_t x)
 {
@@ -81,7 +83,7 @@ nvutils::FileMapping& FileMapping::operator=(FileMapping&& other) noexcept
   return *this;
 }
 
-bool FileMapping::open(const std::filesystem::path& filePath, MappingType mappingType, size_t fileSize)
+bool FileMapping::open(const std::filesystem::path& filePath, MappingType mappingType, size_t fileSize, uint32_t flags)
 {
   // wchar_t* on Windows, char* on Linux
   const std::filesystem::path::value_type* nativePath = filePath.c_str();
@@ -205,9 +207,103 @@ bool FileMapping::open(const std::filesystem::path& filePath, MappingType mappin
     }
   }
 #endif
+  if(m_isValid && flags)
+  {
+    applyHints(flags);
+  }
   return m_isValid;
 }
 
+void FileMapping::applyHints(uint32_t flags)
+{
+#if defined(__linux__)
+  if(flags & MAPPING_FLAG_SEQUENTIAL)
+  {
+    madvise(m_mappingPtr, m_mappingSize, MADV_SEQUENTIAL);
+    posix_fadvise(m_unix.file, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+  else if(flags & MAPPING_FLAG_RANDOM)
+  {
+    madvise(m_mappingPtr, m_mappingSize, MADV_RANDOM);
+    posix_fadvise(m_unix.file, 0, 0, POSIX_FADV_RANDOM);
+  }
+#ifdef MADV_HUGEPAGE
+  if(flags & MAPPING_FLAG_HUGE_PAGES)
+  {
+    // only honored for file systems supporting large folios, or read-only THP for regular files
+    madvise(m_mappingPtr, m_mappingSize, MADV_HUGEPAGE);
+  }
+#endif
+#endif
+  // Windows has no per-mapping access pattern hint, the prefetch below covers sequential reads
+
+  if(flags & MAPPING_FLAG_PREFETCH)
+  {
+    prefetch(0, m_mappingSize);
+  }
+}
+
+bool FileMapping::getAlignedRange(size_t offset, size_t size, char*& begin, size_t& length) const
+{
+  if(!m_isValid || offset >= m_mappingSize)
+    return false;
+
+  size = std::min(size, m_mappingSize - offset);
+  // the mapping starts page aligned, g_pageSize is the allocation granularity on Windows, also a multiple of the page size
+  const size_t alignedOffset = (offset / g_pageSize) * g_pageSize;
+  begin                      = static_cast<char*>(m_mappingPtr) + alignedOffset;
+  length                     = offset + size - alignedOffset;
+  return length != 0;
+}
+
+void FileMapping::prefetch(size_t offset, size_t size) const
+{
+  char*  begin;
+  size_t length;
+  if(!getAlignedRange(offset, size, begin, length))
+    return;
+
+#if defined(_WIN32)
+#if _WIN32_WINNT >= 0x0602  // _WIN32_WINNT_WIN8
+  WIN32_MEMORY_RANGE_ENTRY range{begin, length};
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#elif defined(__linux__)
+  madvise(begin, length, MADV_WILLNEED);
+#endif
+}
+
+std::future<void> FileMapping::prefetchAsync(size_t offset, size_t size) const
+{
+  char*  begin;
+  size_t length;
+  if(!getAlignedRange(offset, size, begin, length))
+  {
+    std::promise<void> ready;
+    ready.set_value();
+    return ready.get_future();
+  }
+
+  return std::async(std::launch::async, [begin, length]() {
+#if defined(__linux__) && defined(MADV_POPULATE_READ)
+    // Linux 5.14+, populates the page tables without touching the data
+    if(madvise(begin, length, MADV_POPULATE_READ) == 0)
+      return;
+#endif
+    // fault in every page, the hint first so the reads are issued ahead of the touches
+#if defined(__linux__)
+    madvise(begin, length, MADV_WILLNEED);
+#endif
+    const size_t      pageSize = 4096;
+    volatile uint8_t  sink     = 0;
+    const char* const end      = begin + length;
+    for(const char* page = begin; page < end; page += pageSize)
+    {
+      sink = sink + uint8_t(*page);
+    }
+  });
+}
+
 void FileMapping::close()
 {
   if(m_isValid)
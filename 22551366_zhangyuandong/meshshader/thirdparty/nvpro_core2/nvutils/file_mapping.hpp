@@ -20,8 +20,10 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <filesystem>
+#include <future>
 
 namespace nvutils {
 
@@ -45,11 +47,30 @@ public:
     MAPPING_READOVERWRITE,  // creates new file with read/write access, overwriting existing files
   };
 
+  // Access hints given to the OS when opening, combine as bits
+  enum MappingFlagBits : uint32_t
+  {
+    MAPPING_FLAG_SEQUENTIAL = 1 << 0,  // mostly read front to back: reads ahead aggressively
+    MAPPING_FLAG_RANDOM     = 1 << 1,  // scattered reads: no read-ahead beyond the faulting page
+    MAPPING_FLAG_PREFETCH   = 1 << 2,  // starts reading the whole file in the background, see `prefetch`
+    MAPPING_FLAG_HUGE_PAGES = 1 << 3,  // backs the mapping with huge pages where the OS and file system allow it,
+                                       // Linux only (transparent huge pages), ignored elsewhere
+  };
+
   // fileSize must only be provided for write access
-  bool open(const std::filesystem::path& filePath, MappingType mappingType, size_t fileSize = 0);
+  bool open(const std::filesystem::path& filePath, MappingType mappingType, size_t fileSize = 0, uint32_t flags = 0);
 
   void close();
 
+  // Hints the OS to read the byte range into memory, returns without waiting.
+  // The range is clamped to the mapping.
+  void prefetch(size_t offset, size_t size) const;
+
+  // Reads the byte range into memory on a background thread, the future is ready once it is resident.
+  // Lets loaders overlap the disk reads of the next chunk with the parsing of the current one.
+  // The mapping must stay open until the future is ready.
+  std::future<void> prefetchAsync(size_t offset, size_t size) const;
+
   const void* data() const { return m_mappingPtr; }
   void*       data() { return m_mappingPtr; }
   size_t      size() const { return m_mappingSize; }
@@ -58,6 +79,10 @@ public:
 protected:
   static size_t g_pageSize;
 
+  void applyHints(uint32_t flags);
+  // page aligned sub-range of the mapping, returns false if empty
+  bool getAlignedRange(size_t offset, size_t size, char*& begin, size_t& length) const;
+
 #ifdef _WIN32
   struct
   {
@@ -82,8 +107,19 @@ protected:
 class FileReadMapping : private FileMapping
 {
 public:
-  bool        open(const std::filesystem::path& filePath) { return FileMapping::open(filePath, MAPPING_READONLY, 0); }
-  void        close() { FileMapping::close(); }
+  using FileMapping::MappingFlagBits;
+  using FileMapping::MAPPING_FLAG_SEQUENTIAL;
+  using FileMapping::MAPPING_FLAG_RANDOM;
+  using FileMapping::MAPPING_FLAG_PREFETCH;
+  using FileMapping::MAPPING_FLAG_HUGE_PAGES;
+
+  bool open(const std::filesystem::path& filePath, uint32_t flags = 0)
+  {
+    return FileMapping::open(filePath, MAPPING_READONLY, 0, flags);
+  }
+  void              close() { FileMapping::close(); }
+  void              prefetch(size_t offset, size_t size) const { FileMapping::prefetch(offset, size); }
+  std::future<void> prefetchAsync(size_t offset, size_t size) const { return FileMapping::prefetchAsync(offset, size); }
   const void* data() const { return m_mappingPtr; }
   size_t      size() const { return m_fileSize; }
   bool        valid() const { return m_isValid; }
@@ -93,9 +129,9 @@ public:
 class FileReadOverWriteMapping : private FileMapping
 {
 public:
-  bool open(const std::filesystem::path& filePath, size_t fileSize)
+  bool open(const std::filesystem::path& filePath, size_t fileSize, uint32_t flags = 0)
   {
-    return FileMapping::open(filePath, MAPPING_READOVERWRITE, fileSize);
+    return FileMapping::open(filePath, MAPPING_READOVERWRITE, fileSize, flags);
   }
   void   close() { FileMapping::close(); }
   void*  data() { return m_mappingPtr; }
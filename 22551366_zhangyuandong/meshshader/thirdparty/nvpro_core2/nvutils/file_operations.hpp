@@ -32,6 +32,8 @@ std::filesystem::path findFile(const std::filesystem::path&              filenam
 
 // Open a file and return its content as a string. On error, returns an
 // empty string.
+// For many outstanding chunked reads that don't block the caller, see
+// `nvutils::AsyncFileReader` in async_file_reader.hpp.
 std::string loadFile(const std::filesystem::path& filePath);
 
 // Return the path to the executable
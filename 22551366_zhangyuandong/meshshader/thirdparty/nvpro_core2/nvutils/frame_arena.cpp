@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "frame_arena.hpp"
+
+namespace nvutils {
+
+void* LinearArena::allocate(size_t size, size_t alignment)
+{
+  assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+  while(m_blockIndex < m_blocks.size())
+  {
+    const Block&    block   = m_blocks[m_blockIndex];
+    const uintptr_t base    = reinterpret_cast<uintptr_t>(block.data.get());
+    const uintptr_t aligned = (base + m_offset + alignment - 1) & ~uintptr_t(alignment - 1);
+    if(aligned + size <= base + block.size)
+    {
+      m_usedSize += aligned + size - (base + m_offset);
+      m_offset = aligned + size - base;
+      return reinterpret_cast<void*>(aligned);
+    }
+    // the rest of the block is lost until the reset
+    m_blockIndex++;
+    m_offset = 0;
+  }
+
+  const size_t blockSize = std::max(m_blockSize, size + alignment);
+  m_blocks.push_back({std::unique_ptr<std::byte[]>(new std::byte[blockSize]), blockSize});
+  m_blockIndex = m_blocks.size() - 1;
+  return allocate(size, alignment);
+}
+
+void LinearArena::reset()
+{
+  if(m_blocks.size() > 1)
+  {
+    // one block for all of it the next time
+    const size_t capacity = getCapacity();
+    m_blocks.clear();
+    m_blocks.push_back({std::unique_ptr<std::byte[]>(new std::byte[capacity]), capacity});
+  }
+  m_blockIndex = 0;
+  m_offset     = 0;
+  m_usedSize   = 0;
+}
+
+size_t LinearArena::getCapacity() const
+{
+  size_t capacity = 0;
+  for(const Block& block : m_blocks)
+  {
+    capacity += block.size;
+  }
+  return capacity;
+}
+
+static std::atomic<uint64_t> s_frameArenaUid{0};
+
+void FrameArena::init(uint32_t framesInFlight, size_t blockSize)
+{
+  assert(m_frameCount == 0 && framesInFlight > 0);
+  m_frameCount = framesInFlight;
+  m_blockSize  = blockSize;
+  m_uid        = ++s_frameArenaUid;
+  m_frameIndex.store(0, std::memory_order_release);
+}
+
+void FrameArena::deinit()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_threads.clear();
+  m_frameCount = 0;
+  m_uid        = 0;
+}
+
+void FrameArena::beginFrame(uint32_t frameIndex)
+{
+  assert(frameIndex < m_frameCount);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto& thread : m_threads)
+    {
+      thread->frames[frameIndex]->reset();
+    }
+  }
+  m_frameIndex.store(frameIndex, std::memory_order_release);
+}
+
+FrameArena::ThreadArenas& FrameArena::getThreadArenas()
+{
+  struct Cache
+  {
+    uint64_t      uid    = 0;
+    ThreadArenas* arenas = nullptr;
+  };
+  thread_local Cache cache;
+  if(cache.uid == m_uid && cache.arenas)
+  {
+    return *cache.arenas;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const std::thread::id       threadId = std::this_thread::get_id();
+  auto it = std::find_if(m_threads.begin(), m_threads.end(), [&](const auto& thread) { return thread->threadId == threadId; });
+  if(it == m_threads.end())
+  {
+    auto thread      = std::make_unique<ThreadArenas>();
+    thread->threadId = threadId;
+    for(uint32_t i = 0; i < m_frameCount; i++)
+    {
+      thread->frames.push_back(std::make_unique<LinearArena>(m_blockSize));
+    }
+    m_threads.push_back(std::move(thread));
+    it = m_threads.end() - 1;
+  }
+  cache = {m_uid, it->get()};
+  return *cache.arenas;
+}
+
+LinearArena& FrameArena::getThreadArena(uint32_t frameIndex)
+{
+  assert(frameIndex < m_frameCount && "FrameArena not initialized");
+  return *getThreadArenas().frames[frameIndex];
+}
+
+size_t FrameArena::getUsedSize()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t                      usedSize = 0;
+  for(auto& thread : m_threads)
+  {
+    usedSize += thread->frames[getFrameIndex()]->getUsedSize();
+  }
+  return usedSize;
+}
+
+}  // namespace nvutils
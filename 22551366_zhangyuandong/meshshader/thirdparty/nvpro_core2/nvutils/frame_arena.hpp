@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nvutils {
+
+// Bump allocator for short-lived memory: an allocation moves a pointer, nothing is freed on its own and
+// `reset` releases everything at once. The blocks are kept across resets, when an arena needed several
+// of them they are merged into one: after the first frames, resetting and refilling it doesn't touch the heap.
+// Not thread safe, see FrameArena for one arena per thread.
+class LinearArena
+{
+public:
+  LinearArena() = default;
+  explicit LinearArena(size_t blockSize)
+      : m_blockSize(blockSize)
+  {
+  }
+
+  LinearArena(const LinearArena& other)            = delete;
+  LinearArena& operator=(const LinearArena& other) = delete;
+
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  template <typename T>
+  T* allocateArray(size_t count)
+  {
+    return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  void reset();
+
+  size_t getUsedSize() const { return m_usedSize; }
+  size_t getCapacity() const;
+
+private:
+  struct Block
+  {
+    std::unique_ptr<std::byte[]> data;
+    size_t                       size = 0;
+  };
+
+  std::vector<Block> m_blocks;
+  size_t             m_blockIndex = 0;  // block being filled
+  size_t             m_offset     = 0;  // in that block
+  size_t             m_usedSize   = 0;
+  size_t             m_blockSize  = 64 * 1024;
+};
+
+//-----------------------------------------------------------------------------
+// Linear arenas for the data living at most as long as a frame, e.g. the arrays filled while
+// recording the command buffer. Each frame of the ring has one arena per thread: `beginFrame`
+// resets those of the frame that starts, once its previous use is done (after waiting for
+// its fence), and the allocations stay valid until the same frame of the ring starts again.
+//
+//  nvutils::FrameArena arena;
+//  arena.init(framesInFlight);
+//
+//  // each frame, after waiting for its fence
+//  arena.beginFrame(frameIndex);
+//  nvutils::ArenaVector<VkImageMemoryBarrier2> barriers(&arena.getThreadArena());
+//-----------------------------------------------------------------------------
+class FrameArena
+{
+public:
+  FrameArena() = default;
+  ~FrameArena() { deinit(); }
+
+  FrameArena(const FrameArena& other)            = delete;
+  FrameArena& operator=(const FrameArena& other) = delete;
+
+  void init(uint32_t framesInFlight, size_t blockSize = 64 * 1024);
+  void deinit();
+
+  // Resets the arenas of all threads for `frameIndex`, which becomes the current frame
+  void     beginFrame(uint32_t frameIndex);
+  uint32_t getFrameIndex() const { return m_frameIndex.load(std::memory_order_acquire); }
+  uint32_t getFrameCount() const { return m_frameCount; }
+
+  // Arena of the calling thread, for the current frame or for `frameIndex`
+  LinearArena& getThreadArena() { return getThreadArena(getFrameIndex()); }
+  LinearArena& getThreadArena(uint32_t frameIndex);
+
+  // Sum over the threads of the current frame
+  size_t getUsedSize();
+
+private:
+  struct ThreadArenas
+  {
+    std::thread::id                           threadId;
+    std::vector<std::unique_ptr<LinearArena>> frames;
+  };
+
+  ThreadArenas& getThreadArenas();
+
+  std::vector<std::unique_ptr<ThreadArenas>> m_threads;  // stable addresses, cached by the threads
+  std::mutex                                 m_mutex;    // guards m_threads
+  std::atomic<uint32_t>                      m_frameIndex{0};
+  uint32_t                                   m_frameCount = 0;
+  size_t                                     m_blockSize  = 64 * 1024;
+  uint64_t                                   m_uid        = 0;  // identifies this init in the thread caches
+};
+
+// STL allocator in a LinearArena, the deallocations do nothing. Default constructed it uses the heap,
+// for containers that are only transient sometimes. `reserve` avoids leaving the grown-out storage in the arena.
+template <typename T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+
+  ArenaAllocator() noexcept = default;
+  ArenaAllocator(LinearArena* arena) noexcept
+      : m_arena(arena)
+  {
+  }
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+      : m_arena(other.getArena())
+  {
+  }
+
+  T* allocate(size_t count) { return m_arena ? m_arena->allocateArray<T>(count) : std::allocator<T>().allocate(count); }
+  void deallocate(T* ptr, size_t count) noexcept
+  {
+    if(!m_arena)
+    {
+      std::allocator<T>().deallocate(ptr, count);
+    }
+  }
+
+  LinearArena* getArena() const noexcept { return m_arena; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const noexcept
+  {
+    return m_arena == other.getArena();
+  }
+
+private:
+  LinearArena* m_arena = nullptr;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+}  // namespace nvutils
@@ -17,8 +17,11 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
+#include <vector>
 
 #include "id_pool.hpp"
 
@@ -334,6 +337,160 @@ void IDPool::destroyRange(const uint32_t index)
   ::memmove(m_ranges + index, m_ranges + index + 1, (m_count - index) * sizeof(Range));
 }
 
+//////////////////////////////////////////////////////////////////////////
+// ConcurrentIDPool
+
+struct ConcurrentIDPool::ThreadCache
+{
+  uint64_t              uid = 0;
+  std::weak_ptr<Shared> shared;
+  std::vector<uint32_t> ids;
+
+  // IDs are returned sorted so consecutive ones become a single range
+  static void returnIDs(Shared& shared, std::vector<uint32_t>::iterator begin, std::vector<uint32_t>::iterator end)
+  {
+    std::sort(begin, end);
+    for(auto it = begin; it != end;)
+    {
+      auto runEnd = it + 1;
+      while(runEnd != end && *runEnd == *(runEnd - 1) + 1)
+      {
+        ++runEnd;
+      }
+      shared.pool.destroyRangeID(*it, uint32_t(runEnd - it));
+      it = runEnd;
+    }
+  }
+
+  ~ThreadCache()
+  {
+    // thread exit, the pool may be gone already
+    std::shared_ptr<Shared> locked = shared.lock();
+    if(locked && !ids.empty())
+    {
+      std::lock_guard lock(locked->mutex);
+      returnIDs(*locked, ids.begin(), ids.end());
+    }
+  }
+};
+
+namespace {
+std::atomic_uint64_t s_concurrentIDPoolUid{0};
+}  // namespace
+
+void ConcurrentIDPool::init(uint32_t poolSize, uint32_t batchSize)
+{
+  assert(!m_shared && "init called twice");
+  m_shared            = std::make_shared<Shared>();
+  m_shared->pool.init(poolSize);
+  m_shared->batchSize = std::max(batchSize, 1u);
+  m_shared->maxID     = poolSize - 1;
+  m_uid               = ++s_concurrentIDPoolUid;
+}
+
+void ConcurrentIDPool::deinit()
+{
+  if(m_shared)
+  {
+    // IDs still in use or cached by other threads are dropped
+    std::lock_guard lock(m_shared->mutex);
+    m_shared->pool.destroyAll();
+  }
+  // thread caches still referring to it see the pool expired
+  m_shared.reset();
+  m_uid = 0;
+}
+
+ConcurrentIDPool::ThreadCache& ConcurrentIDPool::getThreadCache()
+{
+  // caches of the pools used by this thread, usually very few
+  static thread_local std::vector<std::unique_ptr<ThreadCache>> caches;
+  for(auto& cache : caches)
+  {
+    if(cache->uid == m_uid)
+      return *cache;
+  }
+
+  // drop the caches of destroyed pools before adding a new one
+  std::erase_if(caches, [](const std::unique_ptr<ThreadCache>& cache) { return cache->shared.expired(); });
+
+  auto cache    = std::make_unique<ThreadCache>();
+  cache->uid    = m_uid;
+  cache->shared = m_shared;
+  cache->ids.reserve(m_shared->batchSize * 2);
+  caches.push_back(std::move(cache));
+  return *caches.back();
+}
+
+bool ConcurrentIDPool::createID(uint32_t& id)
+{
+  assert(m_shared && "missing init");
+  ThreadCache& cache = getThreadCache();
+
+  if(cache.ids.empty())
+  {
+    Shared&         shared = *m_shared;
+    std::lock_guard lock(shared.mutex);
+
+    // a consecutive batch when available, else whatever is left
+    uint32_t first;
+    if(shared.pool.createRangeID(first, shared.batchSize))
+    {
+      // handed out from the back, keep the lowest ID last
+      for(uint32_t i = shared.batchSize; i > 0; i--)
+      {
+        cache.ids.push_back(first + i - 1);
+      }
+    }
+    else
+    {
+      uint32_t single;
+      while(cache.ids.size() < shared.batchSize && shared.pool.createID(single))
+      {
+        cache.ids.push_back(single);
+      }
+    }
+
+    if(cache.ids.empty())
+      return false;
+  }
+
+  id = cache.ids.back();
+  cache.ids.pop_back();
+  return true;
+}
+
+bool ConcurrentIDPool::destroyID(const uint32_t id)
+{
+  assert(m_shared && "missing init");
+  if(id > m_shared->maxID)
+    return false;
+
+  ThreadCache& cache = getThreadCache();
+  cache.ids.push_back(id);
+
+  Shared& shared = *m_shared;
+  // threads destroying more than they create, e.g. an unloading thread, hand back the overflow
+  if(cache.ids.size() >= size_t(shared.batchSize) * 2)
+  {
+    std::lock_guard lock(shared.mutex);
+    ThreadCache::returnIDs(shared, cache.ids.begin() + shared.batchSize, cache.ids.end());
+    cache.ids.resize(shared.batchSize);
+  }
+  return true;
+}
+
+void ConcurrentIDPool::flushThreadCache()
+{
+  if(!m_shared)
+    return;
+
+  ThreadCache&    cache = getThreadCache();
+  std::lock_guard lock(m_shared->mutex);
+  ThreadCache::returnIDs(*m_shared, cache.ids.begin(), cache.ids.end());
+  cache.ids.clear();
+}
+
 }  // namespace nvutils
 
 [[maybe_unused]] static void usage_IDPool()
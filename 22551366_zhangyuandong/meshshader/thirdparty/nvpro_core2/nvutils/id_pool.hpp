@@ -20,6 +20,8 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <mutex>
 
 namespace nvutils {
 
@@ -86,4 +88,51 @@ private:
   void destroyRange(const uint32_t index);
 };
 
+// Thread-safe variant of IDPool for IDs allocated from many threads (e.g. loaders).
+// Each thread keeps a small cache of free IDs: `createID` takes from it and refills it from the
+// central IDPool `batchSize` IDs at a time, `destroyID` puts the ID back into the cache of the
+// calling thread without synchronization. Only refills and overflowing caches lock the central pool.
+//
+// - IDs cached by other threads are not available to the calling thread, so `createID` may fail
+//   while up to `2 * batchSize` IDs per thread are still free. Threads return their cache
+//   when they exit, or explicitly with `flushThreadCache`.
+// - Single IDs only, double destruction is not detected.
+// - The pool may be destroyed while threads still hold caches, those are dropped.
+class ConcurrentIDPool
+{
+public:
+  ConcurrentIDPool() = default;
+  ConcurrentIDPool(uint32_t poolSize, uint32_t batchSize = 64) { init(poolSize, batchSize); }
+
+  ConcurrentIDPool(const ConcurrentIDPool& other)            = delete;
+  ConcurrentIDPool& operator=(const ConcurrentIDPool& other) = delete;
+
+  ~ConcurrentIDPool() { deinit(); }
+
+  // poolSize must be >= 1, highest id is `poolSize-1`
+  void init(uint32_t poolSize, uint32_t batchSize = 64);
+  void deinit();
+
+  bool createID(uint32_t& id);
+  bool destroyID(const uint32_t id);
+
+  // returns the IDs cached by the calling thread to the central pool
+  void flushThreadCache();
+
+private:
+  struct Shared
+  {
+    std::mutex mutex;
+    IDPool     pool;
+    uint32_t   batchSize = 0;
+    uint32_t   maxID     = 0;
+  };
+  struct ThreadCache;
+
+  ThreadCache& getThreadCache();
+
+  std::shared_ptr<Shared> m_shared;
+  uint64_t                m_uid = 0;  // unique per init, identifies the thread caches
+};
+
 }  // namespace nvutils
@@ -18,9 +18,12 @@
  */
 
 
+#include <algorithm>
+#include <bit>
 #include <csignal>
 #include <cstdarg>
 #include <ctime>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <functional>
@@ -28,6 +31,8 @@
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 
 #ifdef _WIN32
@@ -46,8 +51,126 @@
 #include "timers.hpp"
 
 
+// Bounded multi-producer single-consumer queue of the asynchronous output (Vyukov's bounded queue):
+// each cell has a sequence number telling whether it is free for the producer of a position,
+// or filled for the consumer. A producer only claims a position with a compare-exchange.
+struct nvutils::Logger::AsyncQueue
+{
+  struct Cell
+  {
+    std::atomic<uint64_t> sequence{0};
+    LogLevel              level{};
+    uint64_t              timeMs = 0;
+    std::string           message;
+  };
+
+  explicit AsyncQueue(uint32_t capacity)
+      : cells(std::bit_ceil(std::max(capacity, 2u)))
+      , mask(cells.size() - 1)
+  {
+    for(uint64_t i = 0; i < cells.size(); i++)
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // Returns false when full
+  bool push(LogLevel level, uint64_t timeMs, std::string&& message) noexcept
+  {
+    uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell*    cell;
+    for(;;)
+    {
+      cell                 = &cells[pos & mask];
+      const int64_t offset = int64_t(cell->sequence.load(std::memory_order_acquire)) - int64_t(pos);
+      if(offset == 0)
+      {
+        if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if(offset < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+    cell->level   = level;
+    cell->timeMs  = timeMs;
+    cell->message = std::move(message);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    pending.fetch_add(1, std::memory_order_release);
+    pending.notify_one();
+    return true;
+  }
+
+  // Consumer only, under the log mutex
+  bool pop(LogLevel& level, uint64_t& timeMs, std::string& message) noexcept
+  {
+    Cell& cell = cells[dequeuePos & mask];
+    if(int64_t(cell.sequence.load(std::memory_order_acquire)) - int64_t(dequeuePos + 1) < 0)
+      return false;
+    level   = cell.level;
+    timeMs  = cell.timeMs;
+    message = std::move(cell.message);
+    cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+    dequeuePos++;
+    return true;
+  }
+
+  std::vector<Cell>     cells;
+  const uint64_t        mask;
+  std::atomic<uint64_t> enqueuePos{0};
+  uint64_t              dequeuePos = 0;
+
+  std::atomic<uint64_t> dropped{0};  // Messages dropped since the last drain
+  std::atomic<uint32_t> pending{0};  // Incremented by the producers, waited on by the writer thread
+  std::atomic_bool      stop{false};
+  std::thread           writer;
+};
+
+
+static uint64_t elapsedMilliseconds()
+{
+  static nvutils::PerformanceTimer startTimer;
+  return static_cast<uint64_t>(startTimer.getMilliseconds());
+}
+
+
+// Flushes the asynchronous output before the crash handlers that were installed before ours
+static std::terminate_handler s_previousTerminate = nullptr;
+
+static void flushOnSignal(int signal)
+{
+  nvutils::Logger::getInstance().flush();
+  std::signal(signal, SIG_DFL);
+  std::raise(signal);
+}
+
+static void installCrashFlush()
+{
+  static std::once_flag once;
+  std::call_once(once, []() {
+    s_previousTerminate = std::set_terminate([]() {
+      nvutils::Logger::getInstance().flush();
+      if(s_previousTerminate)
+        s_previousTerminate();
+      std::abort();
+    });
+    std::signal(SIGABRT, flushOnSignal);
+    std::signal(SIGSEGV, flushOnSignal);
+  });
+}
+
+
+nvutils::Logger::Logger() = default;
+
+
 nvutils::Logger::~Logger()
 {
+  setAsyncOutput(false);
+
   try  // Destructors in C++ are noexcept; catch just in case
   {
     if(m_logFile.is_open())
@@ -133,12 +256,9 @@ void nvutils::Logger::log(LogLevel level,
                           const char* format,
                           ...) noexcept
 {
-  std::lock_guard<std::recursive_mutex> lock(m_logMutex);
   if(level < m_minLogLevel)
     return;
 
-  ensureLogFileIsOpen();
-
   // Format message
   std::string message;
   va_list     args;
@@ -146,7 +266,6 @@ void nvutils::Logger::log(LogLevel level,
   try
   {
     message = formatString(format, args);
-    addPrefixes(level, message);
   }
   catch(const std::exception& e)
   {
@@ -156,11 +275,120 @@ void nvutils::Logger::log(LogLevel level,
   }
   va_end(args);
 
+  const uint64_t timeMs = elapsedMilliseconds();
+  if(m_asyncEnabled.load(std::memory_order_acquire))
+  {
+    if(level != LogLevel::eERROR)
+    {
+      if(!m_async->push(level, timeMs, std::move(message)))
+        m_async->dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    flush();  // The queued messages come before the error
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(m_logMutex);
+  output(level, message, timeMs);
+  breakOnErrors(level, message);
+}
+
+
+void nvutils::Logger::output(LogLevel level, std::string& message, uint64_t timeMs) noexcept
+{
+  ensureLogFileIsOpen();
+
+  try
+  {
+    addPrefixes(level, message, timeMs);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "Could not format string: " << e.what() << "\n";
+    return;
+  }
+
   outputToConsoles(level, message);
   outputToFile(message);
   outputToCallback(level, message);
+}
 
-  breakOnErrors(level, message);
+
+void nvutils::Logger::setAsyncOutput(bool enable, uint32_t capacity) noexcept
+{
+  std::thread writer;  // Joined without the lock, which it takes to drain
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_logMutex);
+    if(enable == m_asyncEnabled.load())
+      return;
+
+    try
+    {
+      if(enable)
+      {
+        if(!m_async)
+          m_async = std::make_unique<AsyncQueue>(capacity);
+        m_async->stop   = false;
+        m_async->writer = std::thread([this]() {
+          while(!m_async->stop.load(std::memory_order_acquire))
+          {
+            const uint32_t seen = m_async->pending.load(std::memory_order_acquire);
+            drainAsync();
+            m_async->pending.wait(seen, std::memory_order_acquire);
+          }
+          drainAsync();
+        });
+        installCrashFlush();
+        m_asyncEnabled = true;
+      }
+      else
+      {
+        // Threads still pushing after this are drained by the writer before it exits, or by the next flush
+        m_asyncEnabled = false;
+        m_async->stop  = true;
+        m_async->pending.fetch_add(1, std::memory_order_release);
+        m_async->pending.notify_one();
+        writer = std::move(m_async->writer);
+      }
+    }
+    catch(const std::exception& e)
+    {
+      std::cerr << "Could not start the asynchronous log output: " << e.what() << "\n";
+    }
+  }
+  if(writer.joinable())
+    writer.join();
+}
+
+
+void nvutils::Logger::flush() noexcept
+{
+  if(m_async)
+    drainAsync();
+}
+
+
+// The log mutex also makes this the single consumer of the queue
+void nvutils::Logger::drainAsync() noexcept
+{
+  std::lock_guard<std::recursive_mutex> lock(m_logMutex);
+
+  LogLevel    level;
+  uint64_t    timeMs;
+  std::string message;
+  while(m_async->pop(level, timeMs, message))
+  {
+    output(level, message, timeMs);
+  }
+
+  if(const uint64_t dropped = m_async->dropped.exchange(0, std::memory_order_relaxed))
+  {
+    message = fmt::format("Logger: {} messages were dropped, the asynchronous queue was full\n", dropped);
+    output(LogLevel::eWARNING, message, elapsedMilliseconds());
+  }
+  if(m_logFile.is_open())
+  {
+    m_logFile.flush();
+  }
 }
 
 
@@ -243,12 +471,9 @@ std::string nvutils::Logger::formatString(const char* format, va_list args)
 }
 
 
-static std::string currentTime()
+static std::string currentTime(uint64_t duration)
 {
-  static nvutils::PerformanceTimer startTimer;
-
-  // Get total milliseconds and extract hours, minutes, seconds
-  uint64_t duration = static_cast<uint64_t>(startTimer.getMilliseconds());
+  // Extract hours, minutes, seconds from the total milliseconds
   // clang-format off
   const uint64_t ms      = duration % 1000; duration /= 1000;
   const uint64_t seconds = duration % 60;   duration /= 60;
@@ -288,7 +513,7 @@ static const char* logLevelToString(nvutils::Logger::LogLevel level)
 }
 
 
-void nvutils::Logger::addPrefixes(LogLevel level, std::string& message)
+void nvutils::Logger::addPrefixes(LogLevel level, std::string& message, uint64_t timeMs)
 {
   static bool suppressPrefixes = false;
   if(!suppressPrefixes && m_show != 0)
@@ -297,7 +522,7 @@ void nvutils::Logger::addPrefixes(LogLevel level, std::string& message)
     if(m_show & eSHOW_LEVEL)
       logStream << logLevelToString(level) << ": ";
     if(m_show & eSHOW_TIME)
-      logStream << "[" << currentTime() << "] ";
+      logStream << "[" << currentTime(timeMs) << "] ";
     logStream << message;
     message = logStream.str();
   }
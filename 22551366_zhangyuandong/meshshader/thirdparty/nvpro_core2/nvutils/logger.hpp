@@ -18,9 +18,11 @@
  */
 
 #pragma once
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -46,6 +48,14 @@ On error, all functions print an error message. None throw.
 
 All functions are thread-safe.
 
+# Asynchronous output:
+By default, each message is written to the outputs before the LOG call returns,
+and threads logging at the same time wait for each other. With
+`setAsyncOutput(true)`, the calling threads only format their message into a
+bounded lock-free queue and a background thread writes it. Messages logged
+while the queue is full are dropped and counted. Errors are still written
+synchronously, after the queued messages.
+
 `Printf`-style functions have annotations that should produce warnings at
 compile-time or when performing static analysis. Their format strings may be
 dynamic - but this can be bad if an adversary can choose the content of the
@@ -150,11 +160,19 @@ public:
   // Set whether to break on errors
   void breakOnError(bool enable) noexcept;
 
+  // Messages are queued and written by a background thread, see "Asynchronous output" above.
+  // `capacity` is the number of queued messages before dropping (rounded up to a power of 2), used at the first enable.
+  // The queue is flushed at exit, and also on std::terminate, SIGABRT and SIGSEGV (best effort).
+  void setAsyncOutput(bool enable, uint32_t capacity = 4096) noexcept;
+
+  // Writes the queued messages of the asynchronous output, returns once done
+  void flush() noexcept;
+
 private:
 #ifdef DEBUG
-  LogLevel m_minLogLevel = LogLevel::eDEBUG;  // Messages with levels lower than this are omitted
+  std::atomic<LogLevel> m_minLogLevel = LogLevel::eDEBUG;  // Messages with levels lower than this are omitted
 #else
-  LogLevel m_minLogLevel = LogLevel::eSTATS;  // Messages with levels lower than this are omitted
+  std::atomic<LogLevel> m_minLogLevel = LogLevel::eSTATS;  // Messages with levels lower than this are omitted
 #endif
   std::ofstream        m_logFile;                    // Output file stream
   bool                 m_logToFile = true;           // Enable file output
@@ -164,14 +182,21 @@ private:
   ShowFlags            m_show         = eSHOW_NONE;  // Default shows no extra information
   bool                 m_breakOnError = true;        // Break on errors by default
 
-  Logger() {}
+  std::atomic_bool     m_asyncEnabled = false;       // See setAsyncOutput
+
+  struct AsyncQueue;                    // See logger.cpp
+  std::unique_ptr<AsyncQueue> m_async;  // Created by the first setAsyncOutput(true), kept for threads still pushing
+
+  Logger();
   ~Logger();
   Logger(const Logger&)            = delete;
   Logger& operator=(const Logger&) = delete;
 
   void        ensureLogFileIsOpen() noexcept;
   std::string formatString(const char* format, va_list args);
-  void        addPrefixes(LogLevel level, std::string& message);
+  void        addPrefixes(LogLevel level, std::string& message, uint64_t timeMs);
+  void        output(LogLevel level, std::string& message, uint64_t timeMs) noexcept;
+  void        drainAsync() noexcept;
   void        outputToConsoles(LogLevel level, const std::string& message) noexcept;
   void        outputToFile(const std::string& message) noexcept;
   void        outputToCallback(LogLevel level, const std::string& message) noexcept;
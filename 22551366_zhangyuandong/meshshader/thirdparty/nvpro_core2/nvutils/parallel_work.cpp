@@ -17,18 +17,319 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
 #include "parallel_work.hpp"
 
 namespace nvutils {
 
-BS::thread_pool& get_thread_pool()
+#ifndef _WIN32
+// "0-3,8,10-11"
+static std::vector<uint32_t> parseCpuList(const std::string& list)
+{
+  std::vector<uint32_t> processors;
+  std::stringstream     stream(list);
+  std::string           range;
+  while(std::getline(stream, range, ','))
+  {
+    uint32_t first = 0;
+    uint32_t last  = 0;
+    if(std::sscanf(range.c_str(), "%u-%u", &first, &last) == 2)
+    {
+      for(uint32_t i = first; i <= last; i++)
+        processors.push_back(i);
+    }
+    else if(std::sscanf(range.c_str(), "%u", &first) == 1)
+    {
+      processors.push_back(first);
+    }
+  }
+  return processors;
+}
+
+static std::string readLine(const char* filename)
+{
+  std::ifstream file(filename);
+  std::string   line;
+  std::getline(file, line);
+  return line;
+}
+#endif
+
+static CpuTopology detectCpuTopology()
+{
+  CpuTopology topology;
+
+#ifdef _WIN32
+  // the cores with the highest efficiency class are the performance cores
+  DWORD length = 0;
+  GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+  std::vector<uint8_t> buffer(length);
+  if(length && GetLogicalProcessorInformationEx(RelationProcessorCore, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length))
+  {
+    std::map<BYTE, std::vector<uint32_t>> classes;
+    for(DWORD offset = 0; offset < length;)
+    {
+      const auto* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+      const PROCESSOR_RELATIONSHIP& core = info->Processor;
+      for(WORD g = 0; g < core.GroupCount; g++)
+      {
+        for(uint32_t bit = 0; bit < 64; bit++)
+        {
+          if(core.GroupMask[g].Mask & (KAFFINITY(1) << bit))
+            classes[core.EfficiencyClass].push_back(uint32_t(core.GroupMask[g].Group) * 64 + bit);
+        }
+      }
+      offset += info->Size;
+    }
+    if(!classes.empty())
+    {
+      topology.performanceProcessors = classes.rbegin()->second;
+      for(auto it = std::next(classes.rbegin()); it != classes.rend(); ++it)
+        topology.efficiencyProcessors.insert(topology.efficiencyProcessors.end(), it->second.begin(), it->second.end());
+    }
+  }
+#else
+  // Intel hybrid CPUs expose one PMU per core type
+  topology.performanceProcessors = parseCpuList(readLine("/sys/devices/cpu_core/cpus"));
+  topology.efficiencyProcessors  = parseCpuList(readLine("/sys/devices/cpu_atom/cpus"));
+
+  if(topology.performanceProcessors.empty())
+  {
+    // otherwise the cores clearly slower than the fastest ones, such as the little cores of ARM CPUs. The
+    // maximum frequencies of the cores of a non-hybrid CPU with per-core boost differ by a few percent, they
+    // are all within the tolerance. Without the frequency of every core, all are performance cores.
+    constexpr double                           kTierTolerance = 0.85;
+    std::vector<std::pair<uint64_t, uint32_t>> frequencies;
+    for(uint32_t processor : parseCpuList(readLine("/sys/devices/system/cpu/online")))
+    {
+      const std::string frequency =
+          readLine(("/sys/devices/system/cpu/cpu" + std::to_string(processor) + "/cpufreq/cpuinfo_max_freq").c_str());
+      frequencies.push_back({frequency.empty() ? 0 : std::stoull(frequency), processor});
+    }
+    const bool allKnown = std::none_of(frequencies.begin(), frequencies.end(), [](const auto& f) { return f.first == 0; });
+    if(!frequencies.empty() && allKnown)
+    {
+      const uint64_t maxFrequency = std::max_element(frequencies.begin(), frequencies.end())->first;
+      for(const auto& [frequency, processor] : frequencies)
+      {
+        if(double(frequency) >= double(maxFrequency) * kTierTolerance)
+          topology.performanceProcessors.push_back(processor);
+        else
+          topology.efficiencyProcessors.push_back(processor);
+      }
+    }
+  }
+#endif
+
+  if(topology.performanceProcessors.empty())
+  {
+    topology.efficiencyProcessors.clear();
+    for(uint32_t i = 0; i < std::max(std::thread::hardware_concurrency(), 1U); i++)
+      topology.performanceProcessors.push_back(i);
+  }
+  return topology;
+}
+
+const CpuTopology& get_cpu_topology()
+{
+  static const CpuTopology topology = detectCpuTopology();
+  return topology;
+}
+
+std::vector<uint32_t> CpuTopology::getProcessors(CoreType coreType) const
+{
+  if(coreType == CoreType::ePerformance || (coreType == CoreType::eEfficiency && efficiencyProcessors.empty()))
+    return performanceProcessors;
+  if(coreType == CoreType::eEfficiency)
+    return efficiencyProcessors;
+
+  std::vector<uint32_t> processors = performanceProcessors;
+  processors.insert(processors.end(), efficiencyProcessors.begin(), efficiencyProcessors.end());
+  std::sort(processors.begin(), processors.end());
+  return processors;
+}
+
+bool configure_current_thread(const ThreadConfig& config)
+{
+  bool success = true;
+
+  std::vector<uint32_t> processors = config.processors;
+  if(processors.empty() && config.coreType != CoreType::eAny)
+  {
+    processors = get_cpu_topology().getProcessors(config.coreType);
+  }
+
+#ifdef _WIN32
+  if(!config.name.empty())
+  {
+    const std::wstring name(config.name.begin(), config.name.end());
+    success = SUCCEEDED(SetThreadDescription(GetCurrentThread(), name.c_str())) && success;
+  }
+  if(!processors.empty())
+  {
+    // a thread runs in one processor group, the one of the first processor
+    GROUP_AFFINITY affinity{};
+    affinity.Group = WORD(processors[0] / 64);
+    for(uint32_t processor : processors)
+    {
+      if(processor / 64 == affinity.Group)
+        affinity.Mask |= KAFFINITY(1) << (processor % 64);
+    }
+    success = SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) && success;
+  }
+  if(config.priority != ThreadPriority::eNormal)
+  {
+    success = SetThreadPriority(GetCurrentThread(), config.priority == ThreadPriority::eHigh ? THREAD_PRIORITY_ABOVE_NORMAL : THREAD_PRIORITY_BELOW_NORMAL)
+              && success;
+  }
+#else
+#ifdef __linux__
+  if(!config.name.empty())
+  {
+    success = pthread_setname_np(pthread_self(), config.name.substr(0, 15).c_str()) == 0 && success;
+  }
+  if(!processors.empty())
+  {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for(uint32_t processor : processors)
+    {
+      if(processor < CPU_SETSIZE)
+        CPU_SET(processor, &cpuSet);
+    }
+    success = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0 && success;
+  }
+  if(config.priority != ThreadPriority::eNormal)
+  {
+    // the nice value is per thread on Linux
+    const int nice = config.priority == ThreadPriority::eHigh ? -5 : 10;
+    success        = setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), nice) == 0 && success;
+  }
+#endif
+#endif
+
+  return success;
+}
+
+ThreadPoolConfig get_default_thread_pool_config(ThreadPoolType type)
+{
+  const CpuTopology& topology = get_cpu_topology();
+
+  ThreadPoolConfig config;
+  switch(type)
+  {
+    case ThreadPoolType::eThroughput:
+      config.thread.name = "nv Worker";
+      break;
+    case ThreadPoolType::eLatency:
+      config.thread.name     = "nv Latency";
+      config.thread.coreType = CoreType::ePerformance;
+      config.thread.priority = ThreadPriority::eHigh;
+      config.threadCount     = uint32_t(std::max(topology.performanceProcessors.size(), size_t(2)) - 1);
+      break;
+    case ThreadPoolType::eIO:
+      config.thread.name     = "nv I/O";
+      config.thread.priority = ThreadPriority::eLow;
+      config.threadCount     = 4;
+      break;
+    default:
+      assert(0);
+  }
+  return config;
+}
+
+namespace {
+struct ThreadPools
+{
+  std::mutex                                                                    mutex;
+  std::array<ThreadPoolConfig, size_t(ThreadPoolType::eCount)>                  configs;
+  std::array<std::atomic<BS::thread_pool*>, size_t(ThreadPoolType::eCount)>     pools{};
+  std::array<std::unique_ptr<BS::thread_pool>, size_t(ThreadPoolType::eCount)> storage;
+
+  ThreadPools()
+  {
+    for(size_t i = 0; i < configs.size(); i++)
+      configs[i] = get_default_thread_pool_config(ThreadPoolType(i));
+  }
+};
+
+ThreadPools& getThreadPools()
 {
   // Marking this as static ensures it's only initialized the first time
   // execution enters this function, even if it's called from multiple threads,
   // since C++11. See
   // https://en.cppreference.com/w/cpp/language/storage_duration#Static_block_variables
-  static BS::thread_pool threadPool;
-  return threadPool;
+  static ThreadPools threadPools;
+  return threadPools;
+}
+}  // namespace
+
+bool set_thread_pool_config(ThreadPoolType type, const ThreadPoolConfig& config)
+{
+  ThreadPools&    pools = getThreadPools();
+  std::lock_guard lock(pools.mutex);
+  if(pools.pools[size_t(type)].load())
+    return false;
+
+  pools.configs[size_t(type)] = config;
+  return true;
+}
+
+BS::thread_pool& get_thread_pool(ThreadPoolType type)
+{
+  ThreadPools&     pools = getThreadPools();
+  BS::thread_pool* pool  = pools.pools[size_t(type)].load(std::memory_order_acquire);
+  if(pool)
+    return *pool;
+
+  std::lock_guard lock(pools.mutex);
+  pool = pools.pools[size_t(type)].load(std::memory_order_relaxed);
+  if(!pool)
+  {
+    const ThreadPoolConfig config = pools.configs[size_t(type)];
+
+    uint32_t threadCount = config.threadCount;
+    if(!threadCount)
+    {
+      threadCount = config.thread.processors.empty() ? uint32_t(get_cpu_topology().getProcessors(config.thread.coreType).size()) :
+                                                       uint32_t(config.thread.processors.size());
+    }
+
+    pools.storage[size_t(type)] = std::make_unique<BS::thread_pool>(threadCount, [config]() {
+      ThreadConfig threadConfig = config.thread;
+      if(!threadConfig.name.empty())
+        threadConfig.name += " " + std::to_string(BS::this_thread::get_index().value_or(0));
+      configure_current_thread(threadConfig);
+    });
+    pool = pools.storage[size_t(type)].get();
+    pools.pools[size_t(type)].store(pool, std::memory_order_release);
+  }
+  return *pool;
 }
 
-}  // namespace nvutils
\ No newline at end of file
+}  // namespace nvutils
@@ -22,9 +22,14 @@
 
 #include "BS_thread_pool.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <execution>
 #include <functional>
+#include <string>
+#include <vector>
 
 namespace nvutils {
 /*-------------------------------------------------------------------------------------------------
@@ -54,12 +59,33 @@ the given function. Some examples are:
 * 1 for full parallelization (load an image)
 
 If numThreads is equal to 1, runs single-threaded. Otherwise, `numThreads`
-is ignored.
+is ignored, except by batches_auto which uses at most that many threads.
 
 All functions here are thread-safe. However, if the callback does
 synchronization (e.g. locking, mutexes), then it is only safe to use
 batches_pooled and ranges_pooled.
 
+batches_auto:    fn (uint64_t itemIndex)
+                 callback does single item
+                 picks the batch size and thread count from the measured cost per item,
+                 see `parallel_batches_auto` below
+
+These loops block the caller until done. For dependent phases that should not block,
+see the task graph of `nvutils::TaskScheduler` in task_scheduler.hpp.
+
+The loops run on the throughput pool. There are separate pools for render-critical work
+and for blocking I/O, see `ThreadPoolType`; their thread count, cores and priority can be
+configured before their first use:
+
+```cpp
+nvutils::ThreadPoolConfig config = nvutils::get_default_thread_pool_config(nvutils::ThreadPoolType::eThroughput);
+config.thread.coreType           = nvutils::CoreType::eEfficiency;  // keep the loaders off the render thread's cores
+nvutils::set_thread_pool_config(nvutils::ThreadPoolType::eThroughput, config);
+
+nvutils::configure_current_thread({.name = "Render", .coreType = nvutils::CoreType::ePerformance});
+nvutils::get_thread_pool(nvutils::ThreadPoolType::eIO).detach_task(blockingRead);
+```
+
 -------------------------------------------------------------------------------------------------*/
 
 // Utility to support parallel execution with indices without unnecessarily
@@ -204,11 +230,75 @@ inline void parallel_batches(uint64_t numItems, F&& fn, uint32_t numThreads = 0)
   }
 }
 
+// Kinds of cores of hybrid CPUs
+enum class CoreType
+{
+  eAny,
+  ePerformance,
+  eEfficiency,
+};
+
+enum class ThreadPriority
+{
+  eLow,
+  eNormal,
+  eHigh,  // may need privileges on Linux (CAP_SYS_NICE), ignored otherwise
+};
+
+struct ThreadConfig
+{
+  std::string           name;  // shown by debuggers and profilers (Nsight Systems, Tracy), at most 15 characters on Linux
+  CoreType              coreType = CoreType::eAny;  // used when `processors` is empty
+  std::vector<uint32_t> processors;                 // logical processors the thread may run on
+  ThreadPriority        priority = ThreadPriority::eNormal;
+};
+
+// Logical processors per kind of core. All are performance cores on CPUs that are not hybrid.
+struct CpuTopology
+{
+  std::vector<uint32_t> performanceProcessors;
+  std::vector<uint32_t> efficiencyProcessors;
+
+  bool isHybrid() const { return !performanceProcessors.empty() && !efficiencyProcessors.empty(); }
+  // processors of a core type, all for eAny, the performance ones when there are no efficiency ones
+  std::vector<uint32_t> getProcessors(CoreType coreType) const;
+};
+
+// Detected once: Intel hybrid CPUs (cpu_core/cpu_atom), and clearly separate tiers of maximum core frequency on Linux,
+// the efficiency class of the cores on Windows
+const CpuTopology& get_cpu_topology();
+
+// Applies the name, affinity and priority to the calling thread, e.g. for the render thread.
+// Returns false if a part failed.
+bool configure_current_thread(const ThreadConfig& config);
+
+enum class ThreadPoolType
+{
+  eThroughput,  // loading and batch work, used by the loops of this file; all cores
+  eLatency,     // short render-critical tasks; performance cores, high priority, one core left to the render thread
+  eIO,          // blocking file and network operations; 4 threads at a low priority
+  eCount,
+};
+
+struct ThreadPoolConfig
+{
+  uint32_t     threadCount = 0;  // 0 for one per processor of `thread`
+  ThreadConfig thread;           // the threads are named "<name> <index>"
+};
+
+ThreadPoolConfig get_default_thread_pool_config(ThreadPoolType type);
+// Must be called before the first use of the pool, returns false otherwise
+bool set_thread_pool_config(ThreadPoolType type, const ThreadPoolConfig& config);
+
 // Returns the thread pool; creates it if it hasn't been created yet.
 // Safe to call from multiple threads, but for performance reasons, should
 // only be called if you know you'll run on multiple threads using the
 // pool functions.
-BS::thread_pool& get_thread_pool();
+BS::thread_pool& get_thread_pool(ThreadPoolType type);
+inline BS::thread_pool& get_thread_pool()
+{
+  return get_thread_pool(ThreadPoolType::eThroughput);
+}
 
 // Like parallel_batches, but provides a thread index from within the pool of threads.
 template <uint64_t BATCHSIZE = 512, typename F>
@@ -303,4 +393,114 @@ inline void parallel_ranges_pooled(uint64_t numItems, F&& fn, uint32_t numThread
   }
 }
 
+// Measured cost of the items of one call site, for `parallel_batches_auto`
+struct ParallelAutoState
+{
+  // 0 until the first call has sampled it
+  std::atomic<uint64_t> picosecondsPerItem{0};
+};
+
+// Like parallel_batches, but without a hard-coded BATCHSIZE: the first call runs items serially
+// on the caller until about 20 us have passed, which gives the cost per item. The remaining items
+// are then split into tasks of about 50 us; workloads of only a few tasks stay on the caller, so
+// the number of threads grows with the total work.
+//
+// The cost is remembered in `state`. The overload without it keeps one state per `F`, and since every
+// lambda expression has a distinct type, that is one state per call site. Call sites passing the same
+// callable type (function pointers, std::function) with different workloads should pass their own state.
+//
+// `numThreads` caps the threads used, 0 for all the pool threads and 1 to run serially. With a cap,
+// the items are split in at most `numThreads` tasks, without the extra tasks used for load balancing.
+//
+// Runs serially when called from within a thread pool thread, see parallel_batches_pooled.
+template <typename F>
+inline void parallel_batches_auto(uint64_t numItems, F&& fn, ParallelAutoState& state, uint32_t numThreads = 0)
+{
+  using Clock = std::chrono::steady_clock;
+
+  constexpr uint64_t kSampleDurationPs = 20'000'000;  // 20 us
+  constexpr uint64_t kTaskDurationPs   = 50'000'000;  // 50 us, amortizes the submission overhead
+  constexpr uint64_t kTasksPerThread   = 8;           // leaves room for load balancing
+
+  if(numThreads == 1 || BS::this_thread::get_index().has_value())
+  {
+    for(uint64_t i = 0; i < numItems; i++)
+    {
+      fn(i);
+    }
+    return;
+  }
+
+  uint64_t start = 0;
+  uint64_t cost  = state.picosecondsPerItem.load(std::memory_order_relaxed);
+  if(cost == 0)
+  {
+    // Sample on the caller, doubling the chunk so that cheap items are timed over many iterations
+    const Clock::time_point sampleBegin = Clock::now();
+    uint64_t                elapsedPs   = 0;
+    for(uint64_t chunk = 1; start < numItems && elapsedPs < kSampleDurationPs; chunk *= 2)
+    {
+      const uint64_t end = std::min(start + chunk, numItems);
+      for(uint64_t i = start; i < end; i++)
+      {
+        fn(i);
+      }
+      start     = end;
+      elapsedPs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sampleBegin).count()) * 1000;
+    }
+    if(start == 0)
+      return;
+
+    cost = std::max(elapsedPs / start, uint64_t(1));
+    state.picosecondsPerItem.store(cost, std::memory_order_relaxed);
+  }
+
+  const uint64_t remaining = numItems - start;
+  if(remaining == 0)
+    return;
+
+  uint64_t itemsPerTask = std::max(kTaskDurationPs / cost, uint64_t(1));
+  uint64_t numTasks     = (remaining + itemsPerTask - 1) / itemsPerTask;
+
+  // Too little work to pay for waking up other threads
+  if(numTasks <= 2)
+  {
+    for(uint64_t i = start; i < numItems; i++)
+    {
+      fn(i);
+    }
+    return;
+  }
+
+  // A cap on the threads is a cap on the tasks, each pool thread running at most one of them at a time
+  const uint64_t numPoolThreads = get_thread_pool().get_thread_count();
+  const uint64_t maxTasks       = numThreads > 0 ? std::clamp(uint64_t(numThreads), uint64_t(1), std::max(numPoolThreads, uint64_t(1))) :
+                                                   std::max(numPoolThreads * kTasksPerThread, uint64_t(1));
+  if(numTasks > maxTasks)
+  {
+    numTasks     = maxTasks;
+    itemsPerTask = (remaining + numTasks - 1) / numTasks;
+  }
+
+  const auto worker = [&](const uint64_t taskIndex) {
+    const uint64_t taskBegin = start + taskIndex * itemsPerTask;
+    const uint64_t taskEnd   = std::min(taskBegin + itemsPerTask, numItems);
+    for(uint64_t i = taskBegin; i < taskEnd; i++)
+    {
+      fn(i);
+    }
+  };
+
+  // One block per task, so threads that finish early pick up the others
+  BS::multi_future<void> future = get_thread_pool().submit_loop<uint64_t>(0, numTasks, worker, numTasks);
+  future.wait();
+}
+
+template <typename F>
+inline void parallel_batches_auto(uint64_t numItems, F&& fn, uint32_t numThreads = 0)
+{
+  static ParallelAutoState s_state;
+  parallel_batches_auto(numItems, std::forward<F>(fn), s_state, numThreads);
+}
+
 }  // namespace nvutils
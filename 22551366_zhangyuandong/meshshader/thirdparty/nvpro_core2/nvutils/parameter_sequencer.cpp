@@ -17,17 +17,456 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+
+#include <fmt/format.h>
+
+#include "file_operations.hpp"
 #include "logger.hpp"
 #include "parameter_sequencer.hpp"
 
 namespace nvutils {
 
+static const char* s_reportCsvHeader =
+    "kind,sequence,description,timeline,name,level,averagedFrames,async,"
+    "cpuAverage,cpuMin,cpuMax,cpuP50,cpuP95,cpuP99,gpuAverage,gpuMin,gpuMax,gpuP50,gpuP95,gpuP99,value";
+
+static std::string reportCsvEscape(const std::string& str)
+{
+  if(str.find_first_of(",\"\n") == std::string::npos)
+    return str;
+
+  std::string result = "\"";
+  for(char c : str)
+  {
+    result += c == '\n' ? ' ' : c;
+    if(c == '"')
+      result += '"';
+  }
+  return result + "\"";
+}
+
+static std::vector<std::string> reportCsvSplit(const std::string& line)
+{
+  std::vector<std::string> fields(1);
+  bool                     quoted = false;
+  for(size_t i = 0; i < line.size(); i++)
+  {
+    char c = line[i];
+    if(quoted && c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+    {
+      fields.back() += c;
+      i++;
+    }
+    else if(c == '"')
+      quoted = !quoted;
+    else if(c == ',' && !quoted)
+      fields.emplace_back();
+    else if(c != '\r')
+      fields.back() += c;
+  }
+  return fields;
+}
+
+static std::string reportJsonEscape(const std::string& str)
+{
+  std::string result;
+  result.reserve(str.size());
+  for(char c : str)
+  {
+    if(c == '"' || c == '\\')
+    {
+      result += '\\';
+      result += c;
+    }
+    else if(static_cast<unsigned char>(c) < 0x20)
+      result += fmt::format("\\u{:04x}", int(c));
+    else
+      result += c;
+  }
+  return result;
+}
+
+// JSON has no NaN or infinity, such values are written as null
+static std::string reportJsonNumber(double value, const char* format = "{}")
+{
+  return std::isfinite(value) ? fmt::format(fmt::runtime(format), value) : "null";
+}
+
+static SequenceReport::Times reportTimes(const ProfilerTimeline::TimerStats& stats)
+{
+  return {stats.average, stats.absMinValue, stats.absMaxValue, stats.p50, stats.p95, stats.p99};
+}
+
+void SequenceReport::addSystemInfo()
+{
+#if defined(_WIN32)
+  machineInfo.push_back({"os", "Windows"});
+#elif defined(__APPLE__)
+  machineInfo.push_back({"os", "macOS"});
+#elif defined(__linux__)
+  machineInfo.push_back({"os", "Linux"});
+#else
+  machineInfo.push_back({"os", "unknown"});
+#endif
+  machineInfo.push_back({"cpuThreads", std::to_string(std::thread::hardware_concurrency())});
+#if defined(_MSC_VER)
+  machineInfo.push_back({"compiler", fmt::format("MSVC {}", _MSC_VER)});
+#elif defined(__clang__)
+  machineInfo.push_back({"compiler", fmt::format("clang {}.{}", __clang_major__, __clang_minor__)});
+#elif defined(__GNUC__)
+  machineInfo.push_back({"compiler", fmt::format("gcc {}.{}", __GNUC__, __GNUC_MINOR__)});
+#endif
+#ifdef NDEBUG
+  machineInfo.push_back({"build", "release"});
+#else
+  machineInfo.push_back({"build", "debug"});
+#endif
+
+  std::time_t now = std::time(nullptr);
+  char        date[32]{};
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  machineInfo.push_back({"date", date});
+}
+
+SequenceReport::Sequence& SequenceReport::addSequence(uint32_t index, const std::string& description, const ProfilerManager* profilerManager)
+{
+  Sequence& sequence   = sequences.emplace_back();
+  sequence.index       = index;
+  sequence.description = description;
+
+  if(!profilerManager)
+    return sequence;
+
+  std::vector<ProfilerTimeline::Snapshot> frameSnapshots;
+  std::vector<ProfilerTimeline::Snapshot> asyncSnapshots;
+  profilerManager->getSnapshots(frameSnapshots, asyncSnapshots);
+
+  for(const std::vector<ProfilerTimeline::Snapshot>* snapshots : {&frameSnapshots, &asyncSnapshots})
+  {
+    for(const ProfilerTimeline::Snapshot& snapshot : *snapshots)
+    {
+      for(size_t i = 0; i < snapshot.timerInfos.size(); i++)
+      {
+        const ProfilerTimeline::TimerInfo& info = snapshot.timerInfos[i];
+        if(info.numAveraged == 0)
+          continue;
+
+        Section& section    = sequence.sections.emplace_back();
+        section.timeline    = snapshot.name;
+        section.name        = snapshot.timerNames[i];
+        section.level       = info.level;
+        section.numAveraged = info.numAveraged;
+        section.async       = info.async;
+        section.hasGpu      = !snapshot.timerApiNames[i].empty();
+        section.cpu         = reportTimes(info.cpu);
+        section.gpu         = reportTimes(info.gpu);
+      }
+    }
+  }
+
+  return sequence;
+}
+
+bool SequenceReport::write(const std::filesystem::path& filename) const
+{
+  std::ofstream file(filename);
+  if(!file)
+  {
+    LOGE("Failed to write the sequence report %s\n", utf8FromPath(filename).c_str());
+    return false;
+  }
+
+  auto formatTimes = [](const Times& times) {
+    return fmt::format("{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f}", times.average, times.min, times.max, times.p50,
+                       times.p95, times.p99);
+  };
+  auto formatTimesJson = [](const Times& times) {
+    return fmt::format("{{\"average\": {}, \"min\": {}, \"max\": {}, \"p50\": {}, \"p95\": {}, \"p99\": {}}}",
+                       reportJsonNumber(times.average, "{:.3f}"), reportJsonNumber(times.min, "{:.3f}"),
+                       reportJsonNumber(times.max, "{:.3f}"), reportJsonNumber(times.p50, "{:.3f}"),
+                       reportJsonNumber(times.p95, "{:.3f}"), reportJsonNumber(times.p99, "{:.3f}"));
+  };
+
+  if(filename.extension() == ".json")
+  {
+    file << "{\n  \"machine\": {";
+    for(size_t i = 0; i < machineInfo.size(); i++)
+    {
+      file << fmt::format("{}\n    \"{}\": \"{}\"", i ? "," : "", reportJsonEscape(machineInfo[i].first),
+                          reportJsonEscape(machineInfo[i].second));
+    }
+    file << "\n  },\n  \"sequences\": [";
+    for(size_t s = 0; s < sequences.size(); s++)
+    {
+      const Sequence& sequence = sequences[s];
+      file << fmt::format("{}\n    {{\n      \"index\": {},\n      \"description\": \"{}\",\n      \"sections\": [",
+                          s ? "," : "", sequence.index, reportJsonEscape(sequence.description));
+      for(size_t i = 0; i < sequence.sections.size(); i++)
+      {
+        const Section& section = sequence.sections[i];
+        file << fmt::format("{}\n        {{\"timeline\": \"{}\", \"name\": \"{}\", \"level\": {}, \"averagedFrames\": {}, "
+                            "\"async\": {}, \"cpu\": {}, \"gpu\": {}}}",
+                            i ? "," : "", reportJsonEscape(section.timeline), reportJsonEscape(section.name), section.level,
+                            section.numAveraged, section.async, formatTimesJson(section.cpu),
+                            section.hasGpu ? formatTimesJson(section.gpu) : "null");
+      }
+      file << "\n      ],\n      \"counters\": {";
+      for(size_t i = 0; i < sequence.counters.size(); i++)
+      {
+        file << fmt::format("{}\"{}\": {}", i ? ", " : "", reportJsonEscape(sequence.counters[i].name),
+                            reportJsonNumber(sequence.counters[i].value));
+      }
+      file << "}\n    }";
+    }
+    file << "\n  ]\n}\n";
+  }
+  else
+  {
+    file << s_reportCsvHeader << "\n";
+    for(const auto& info : machineInfo)
+    {
+      file << fmt::format("machine,,,,{},,,,,,,,,,,,,,,,{}\n", reportCsvEscape(info.first), reportCsvEscape(info.second));
+    }
+    for(const Sequence& sequence : sequences)
+    {
+      const std::string description = reportCsvEscape(sequence.description);
+      for(const Section& section : sequence.sections)
+      {
+        file << fmt::format("section,{},{},{},{},{},{},{},{},{},\n", sequence.index, description,
+                            reportCsvEscape(section.timeline), reportCsvEscape(section.name), section.level,
+                            section.numAveraged, section.async ? 1 : 0, formatTimes(section.cpu),
+                            section.hasGpu ? formatTimes(section.gpu) : ",,,,,");
+      }
+      for(const Counter& counter : sequence.counters)
+      {
+        file << fmt::format("counter,{},{},,{},,,,,,,,,,,,,,,,{}\n", sequence.index, description,
+                            reportCsvEscape(counter.name), counter.value);
+      }
+    }
+  }
+
+  if(!file)
+  {
+    LOGE("Failed to write the sequence report %s\n", utf8FromPath(filename).c_str());
+    return false;
+  }
+  LOGI("Sequence report of %zu sequences written to %s\n", sequences.size(), utf8FromPath(filename).c_str());
+  return true;
+}
+
+bool SequenceReport::read(const std::filesystem::path& filename)
+{
+  machineInfo.clear();
+  sequences.clear();
+
+  std::ifstream file(filename);
+  std::string   line;
+  if(!file || !std::getline(file, line) || line.rfind(s_reportCsvHeader, 0) != 0)
+  {
+    LOGE("Failed to read the sequence report %s, expected a CSV report\n", utf8FromPath(filename).c_str());
+    return false;
+  }
+
+  enum Column
+  {
+    eKind,
+    eSequence,
+    eDescription,
+    eTimeline,
+    eName,
+    eLevel,
+    eAveragedFrames,
+    eAsync,
+    eCpuTimes,
+    eGpuTimes = eCpuTimes + 6,
+    eValue    = eGpuTimes + 6,
+    eColumnCount,
+  };
+
+  auto parseTimes = [](const std::vector<std::string>& fields, size_t first) {
+    double values[6]{};
+    for(size_t i = 0; i < 6; i++)
+      values[i] = fields[first + i].empty() ? 0.0 : std::atof(fields[first + i].c_str());
+    return Times{values[0], values[1], values[2], values[3], values[4], values[5]};
+  };
+
+  while(std::getline(file, line))
+  {
+    if(line.empty())
+      continue;
+
+    std::vector<std::string> fields = reportCsvSplit(line);
+    if(fields.size() < eColumnCount)
+    {
+      LOGW("Skipping malformed line in sequence report %s: %s\n", utf8FromPath(filename).c_str(), line.c_str());
+      continue;
+    }
+
+    if(fields[eKind] == "machine")
+    {
+      machineInfo.push_back({fields[eName], fields[eValue]});
+      continue;
+    }
+
+    uint32_t index = uint32_t(std::strtoul(fields[eSequence].c_str(), nullptr, 10));
+    if(sequences.empty() || sequences.back().index != index || sequences.back().description != fields[eDescription])
+    {
+      sequences.push_back({.index = index, .description = fields[eDescription]});
+    }
+    Sequence& sequence = sequences.back();
+
+    if(fields[eKind] == "section")
+    {
+      Section& section    = sequence.sections.emplace_back();
+      section.timeline    = fields[eTimeline];
+      section.name        = fields[eName];
+      section.level       = uint32_t(std::strtoul(fields[eLevel].c_str(), nullptr, 10));
+      section.numAveraged = uint32_t(std::strtoul(fields[eAveragedFrames].c_str(), nullptr, 10));
+      section.async       = fields[eAsync] == "1";
+      section.hasGpu      = !fields[eGpuTimes].empty();
+      section.cpu         = parseTimes(fields, eCpuTimes);
+      section.gpu         = parseTimes(fields, eGpuTimes);
+    }
+    else if(fields[eKind] == "counter")
+    {
+      sequence.counters.push_back({fields[eName], std::atof(fields[eValue].c_str())});
+    }
+  }
+
+  return true;
+}
+
+uint32_t SequenceReport::compare(const SequenceReport& baseline, const SequenceReport& current, float thresholdPercent, double minTimeMicroseconds)
+{
+  for(const auto& info : current.machineInfo)
+  {
+    // the date always differs
+    if(info.first == "date")
+      continue;
+    for(const auto& baseInfo : baseline.machineInfo)
+    {
+      if(baseInfo.first == info.first && baseInfo.second != info.second)
+      {
+        LOGW("Sequence report machine differs: %s \"%s\" -> \"%s\"\n", info.first.c_str(), baseInfo.second.c_str(),
+             info.second.c_str());
+      }
+    }
+  }
+
+  std::unordered_map<std::string, const Sequence*> baseSequences;
+  for(const Sequence& sequence : baseline.sequences)
+  {
+    baseSequences.insert({sequence.description, &sequence});
+  }
+
+  auto sectionKey = [](const Section& section) {
+    return fmt::format("{}/{}/{}/{}", section.timeline, section.name, section.level, section.async);
+  };
+
+  uint32_t regressions = 0;
+  for(const Sequence& sequence : current.sequences)
+  {
+    auto itSequence = baseSequences.find(sequence.description);
+    if(itSequence == baseSequences.end())
+    {
+      LOGI("Sequence \"%s\": not in baseline\n", sequence.description.c_str());
+      continue;
+    }
+    const Sequence& baseSequence = *itSequence->second;
+
+    std::unordered_map<std::string, const Section*> baseSections;
+    for(const Section& section : baseSequence.sections)
+    {
+      baseSections.insert({sectionKey(section), &section});
+    }
+
+    LOGI("Sequence \"%s\":\n", sequence.description.c_str());
+    for(const Section& section : sequence.sections)
+    {
+      auto itSection = baseSections.find(sectionKey(section));
+      if(itSection == baseSections.end())
+      {
+        LOGI("  %-40s not in baseline\n", (section.timeline + "/" + section.name).c_str());
+        continue;
+      }
+
+      const Section& baseSection = *itSection->second;
+      const bool     useGpu      = section.hasGpu && baseSection.hasGpu;
+      const double   baseTime    = useGpu ? baseSection.gpu.average : baseSection.cpu.average;
+      const double   time        = useGpu ? section.gpu.average : section.cpu.average;
+      if(baseTime < minTimeMicroseconds && time < minTimeMicroseconds)
+        continue;
+
+      const double percent    = baseTime > 0 ? (time - baseTime) * 100.0 / baseTime : 100.0;
+      const bool   regression = percent > double(thresholdPercent);
+      const char*  format     = "  %-40s %s %10.3f -> %10.3f us %+7.1f%%%s\n";
+      const char*  api        = useGpu ? "GPU" : "CPU";
+      if(regression)
+      {
+        regressions++;
+        LOGW(format, (section.timeline + "/" + section.name).c_str(), api, baseTime, time, percent, " REGRESSION");
+      }
+      else
+      {
+        LOGI(format, (section.timeline + "/" + section.name).c_str(), api, baseTime, time, percent, "");
+      }
+    }
+
+    for(const Counter& counter : sequence.counters)
+    {
+      for(const Counter& baseCounter : baseSequence.counters)
+      {
+        if(baseCounter.name == counter.name && baseCounter.value != counter.value)
+        {
+          LOGI("  counter %-32s %g -> %g\n", counter.name.c_str(), baseCounter.value, counter.value);
+        }
+      }
+    }
+  }
+
+  if(regressions)
+  {
+    LOGW("Sequence report: %u sections regressed by more than %.1f%%\n", regressions, thresholdPercent);
+  }
+  else
+  {
+    LOGI("Sequence report: no regressions above %.1f%%\n", thresholdPercent);
+  }
+  return regressions;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 
 void ParameterSequencer::InitInfo::registerScriptParameters(ParameterRegistry& registry, ParameterParser& parser)
 {
   parser.add(registry.add({.name = "sequencefile", .help = "filename for text file containing sequences of parameters to be set."},
                           &scriptFilename));
   parser.add(registry.add({.name = "sequencestring", .help = "string containing sequences of parameters to be set."}, &scriptContent));
+  parser.add(registry.add({.name = "sequencereport", .help = "write the results of all sequences to this file (.json, CSV otherwise)"},
+                          &reportFilename));
+  parser.add(registry.add({.name = "sequencebaseline", .help = "CSV sequence report of a previous run to compare the results against"},
+                          &reportBaselineFilename));
+  parser.add(registry.add({.name = "sequencethreshold", .help = "percentage above the baseline time that is reported as regression"},
+                          &reportThresholdPercent));
+}
+
+uint32_t ParameterSequencer::InitInfo::compareReports() const
+{
+  SequenceReport baseline;
+  SequenceReport current;
+  if(!baseline.read(reportBaselineFilename) || !current.read(reportFilename))
+  {
+    return ~0u;
+  }
+  LOGI("Comparing sequence report %s against baseline %s\n", utf8FromPath(reportFilename).c_str(),
+       utf8FromPath(reportBaselineFilename).c_str());
+  return SequenceReport::compare(baseline, current, reportThresholdPercent);
 }
 
 bool ParameterSequencer::init(const InitInfo& info)
@@ -71,6 +510,13 @@ bool ParameterSequencer::init(const InitInfo& info)
                           &m_info.profilerResetFrameCount, 0, 8));
 
 
+  m_report = {};
+  if(!m_info.reportFilename.empty())
+  {
+    m_report.addSystemInfo();
+    m_report.machineInfo.insert(m_report.machineInfo.end(), m_info.reportMachineInfo.begin(), m_info.reportMachineInfo.end());
+  }
+
   m_frameCount = 0;
   m_completed  = false;
 
@@ -97,6 +543,11 @@ bool ParameterSequencer::prepareFrame()
                                   m_sequenceState.description.c_str(), statsFrame.c_str(), statsSingle.c_str());
       }
 
+      SequenceReport::Sequence& sequence =
+          m_report.addSequence(m_sequenceState.index, m_sequenceState.description, m_info.profilerManager);
+      if(m_info.reportCounters)
+        m_info.reportCounters(m_sequenceState, sequence.counters);
+
       // Callback all registered functions
       for(auto& func : m_info.postCallbacks)
         func(m_sequenceState);
@@ -107,6 +558,12 @@ bool ParameterSequencer::prepareFrame()
     // test if done
     m_completed = (m_currentArgument >= m_tokenizedScript.getArgs().size());
 
+    if(m_completed && !m_info.reportFilename.empty() && m_report.write(m_info.reportFilename)
+       && !m_info.reportBaselineFilename.empty())
+    {
+      m_info.compareReports();
+    }
+
     if(!m_completed)
     {
       m_sequenceState.description = m_tokenizedScript.getArgs(m_currentArgument)[0];
@@ -181,6 +638,13 @@ bool ParameterSequencer::prepareFrame()
 
   sequencerInfo.profilerManager = &profilerManager;
 
+  // optionally, write all results to a CSV report, and add application counters to each sequence
+  sequencerInfo.reportFilename = "sequences.csv";
+  sequencerInfo.reportMachineInfo.push_back({"gpu", "my gpu name"});
+  sequencerInfo.reportCounters = [&](const nvutils::ParameterSequencer::State&, std::vector<nvutils::SequenceReport::Counter>& counters) {
+    counters.push_back({"blah", double(blah)});
+  };
+
   // optionally, add a function called once each sequence is finished:
   sequencerInfo.postCallbacks.push_back([](const nvutils::ParameterSequencer::State& sequence) {
     LOGI("Finished sequence %d: %s\n", sequence.index, sequence.description.c_str());
@@ -23,9 +23,85 @@
 #include "profiler.hpp"
 
 #include <filesystem>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace nvutils {
 
+// Structured results of the sequences run by a `ParameterSequencer`, see `InitInfo::reportFilename`.
+//
+// Each sequence keeps all profiler sections with their CPU and GPU time distribution (in microseconds),
+// and the application counters provided by `InitInfo::reportCounters`.
+// The report also holds key/value information about the machine it ran on.
+//
+// The report is written as JSON when the filename ends with ".json", as CSV otherwise.
+// The CSV has one row per machine info, section or counter, distinguished by the `kind` column,
+// it is the format that can be read back to compare two runs.
+class SequenceReport
+{
+public:
+  struct Times
+  {
+    double average = 0;
+    double min     = 0;
+    double max     = 0;
+    double p50     = 0;
+    double p95     = 0;
+    double p99     = 0;
+  };
+
+  struct Section
+  {
+    std::string timeline;
+    std::string name;
+    uint32_t    level       = 0;
+    uint32_t    numAveraged = 0;
+    bool        async       = false;
+    bool        hasGpu      = false;
+    Times       cpu;
+    Times       gpu;
+  };
+
+  struct Counter
+  {
+    std::string name;
+    double      value = 0;
+  };
+
+  struct Sequence
+  {
+    uint32_t             index = 0;
+    std::string          description;
+    std::vector<Section> sections;
+    std::vector<Counter> counters;
+  };
+
+  std::vector<std::pair<std::string, std::string>> machineInfo;
+  std::vector<Sequence>                            sequences;
+
+  // adds the operating system, cpu and build information to `machineInfo`
+  void addSystemInfo();
+
+  // captures the current sections of all timelines of the profiler (can be null)
+  Sequence& addSequence(uint32_t index, const std::string& description, const ProfilerManager* profilerManager);
+
+  bool write(const std::filesystem::path& filename) const;
+  // only CSV reports can be read
+  bool read(const std::filesystem::path& filename);
+
+  // Compares the sections of the sequences with matching descriptions, and logs the differences.
+  // A section regresses when its time (GPU if it has one, else CPU) is above the baseline by more than
+  // `thresholdPercent`. Sections below `minTimeMicroseconds` in both runs are ignored as noise.
+  // Machine info differences are logged as warnings.
+  // Returns the number of regressions.
+  static uint32_t compare(const SequenceReport& baseline,
+                          const SequenceReport& current,
+                          float                 thresholdPercent,
+                          double                minTimeMicroseconds = 1.0);
+};
+
 // The ParameterSequencer class allows parsing a parameter file
 // in sequences. Each sequence starts with the "SEQUENCE" keyword
 // followed by a string or file end
@@ -47,6 +123,17 @@ namespace nvutils {
 // Each sequence is measured for a length of `sequenceFrameCount` many frames,
 // and the profiler uses a window of `profilerAverageCount` many frames for averaging.
 // After each sequence a report is generated from the profiler and logged via `LogLevel::eSTATS`.
+//
+// Optionally all sequences are collected into a `SequenceReport`, which is written once the script
+// completed and can be compared against the report of a previous run to detect regressions:
+//
+//   ```
+//   app --sequencefile bench.txt --sequencereport baseline.csv
+//   # later, flags the sections that got more than 5% slower
+//   app --sequencefile bench.txt --sequencereport current.csv --sequencebaseline baseline.csv --sequencethreshold 5
+//   # compare only, without running a script
+//   app --sequencereport current.csv --sequencebaseline baseline.csv
+//   ```
 
 class ParameterSequencer
 {
@@ -66,11 +153,24 @@ public:
     std::string           scriptContent;   // parameter: "sequencestring"
     std::filesystem::path scriptFilename;  // parameter: "sequencefile"
 
+    // optional, structured report of all sequences, written when the script completed (.json, CSV otherwise)
+    std::filesystem::path reportFilename;  // parameter: "sequencereport"
+    // optional, CSV report of a previous run the written report is compared against
+    std::filesystem::path reportBaselineFilename;  // parameter: "sequencebaseline"
+    // sections slower than the baseline by more than this percentage are regressions
+    float reportThresholdPercent = 5.0f;  // parameter: "sequencethreshold"
+
     // registers the above using this
     void registerScriptParameters(ParameterRegistry& registry, ParameterParser& parser);
 
     bool hasScript() const { return !scriptFilename.empty() || !scriptContent.empty(); }
 
+    // Compare tool mode: both reports are provided without a script.
+    // `compareReports` then tells the regressions of `reportFilename` against `reportBaselineFilename`.
+    bool hasReportCompare() const { return !reportFilename.empty() && !reportBaselineFilename.empty(); }
+    // Returns the number of regressions, or ~0 if a report could not be read
+    uint32_t compareReports() const;
+
     // internal parameters that are allowed to change per sequence
     // these are registered and added to the `parameterParser` and `parameterRegistry`
     // at `ParameterSequencer::init` time.
@@ -93,6 +193,11 @@ public:
     // To get called after a new benchmark setting.
     // The input to each function is the description of the previous benchmark.
     std::vector<std::function<void(const State&)>> postCallbacks;
+
+    // optional, application counters added to the report of each sequence that just ran
+    std::function<void(const State&, std::vector<SequenceReport::Counter>&)> reportCounters;
+    // optional, e.g. GPU and driver, added to the machine info of the report
+    std::vector<std::pair<std::string, std::string>> reportMachineInfo;
   };
 
   // The script is parsed using the provided `parameterParser` (must be kept alive).
@@ -116,6 +221,9 @@ public:
   // Returns `true` if the sequences were completed and no more frames are required.
   bool prepareFrame();
 
+  // sequences completed so far
+  const SequenceReport& getReport() const { return m_report; }
+
 protected:
   bool     m_completed = true;
   InitInfo m_info;
@@ -131,5 +239,7 @@ protected:
 
   // Info about the current sequence
   State m_sequenceState = {};
+
+  SequenceReport m_report;
 };
 }  // namespace nvutils
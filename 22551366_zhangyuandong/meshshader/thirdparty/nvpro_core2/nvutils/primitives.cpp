@@ -19,6 +19,7 @@
 
 
 #include <array>
+#include <bit>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -30,6 +31,7 @@
 
 #include "primitives.hpp"
 #include "hash_operations.hpp"
+#include "parallel_work.hpp"
 
 
 namespace nvutils {
@@ -673,40 +675,45 @@ std::vector<nvutils::Node> sunflower(int seeds)
 // Merge all nodes meshes into a single one
 // - nodes: the nodes to merge
 // - meshes: the mesh array that the nodes is referring to
-nvutils::PrimitiveMesh mergeNodes(const std::vector<nvutils::Node>& nodes, const std::vector<nvutils::PrimitiveMesh> meshes)
+nvutils::PrimitiveMesh mergeNodes(const std::vector<nvutils::Node>& nodes, const std::vector<nvutils::PrimitiveMesh>& meshes)
 {
   nvutils::PrimitiveMesh resultMesh;
 
-  // Find how many triangles and vertices the merged mesh will have
-  size_t nb_triangles = 0;
-  size_t nb_vertices  = 0;
-  for(const auto& n : nodes)
+  // Offsets of each node in the merged mesh
+  std::vector<size_t> firstTriangle(nodes.size());
+  std::vector<size_t> firstVertex(nodes.size());
+  size_t              nb_triangles = 0;
+  size_t              nb_vertices  = 0;
+  for(size_t i = 0; i < nodes.size(); i++)
   {
-    nb_triangles += meshes[n.mesh].triangles.size();
-    nb_vertices += meshes[n.mesh].vertices.size();
+    firstTriangle[i] = nb_triangles;
+    firstVertex[i]   = nb_vertices;
+    nb_triangles += meshes[nodes[i].mesh].triangles.size();
+    nb_vertices += meshes[nodes[i].mesh].vertices.size();
   }
-  resultMesh.triangles.reserve(nb_triangles);
-  resultMesh.vertices.reserve(nb_vertices);
-
-  // Merge all nodes meshes into a single one
-  for(const auto& n : nodes)
-  {
-    const glm::mat4 mat = n.localMatrix();
-
-    uint32_t                      tIndex = static_cast<uint32_t>(resultMesh.vertices.size());
+  resultMesh.triangles.resize(nb_triangles);
+  resultMesh.vertices.resize(nb_vertices);
+
+  // Merge all nodes meshes into a single one, each node writes its own part
+  nvutils::parallel_batches<1>(nodes.size(), [&](uint64_t i) {
+    const nvutils::Node&          n      = nodes[i];
+    const glm::mat4               mat    = n.localMatrix();
+    const uint32_t                tIndex = static_cast<uint32_t>(firstVertex[i]);
     const nvutils::PrimitiveMesh& mesh   = meshes[n.mesh];
 
+    PrimitiveVertex* vertices = resultMesh.vertices.data() + firstVertex[i];
     for(auto v : mesh.vertices)
     {
-      v.pos = glm::vec3(mat * glm::vec4(v.pos, 1));
-      resultMesh.vertices.push_back(v);
+      v.pos       = glm::vec3(mat * glm::vec4(v.pos, 1));
+      *vertices++ = v;
     }
+    PrimitiveTriangle* triangles = resultMesh.triangles.data() + firstTriangle[i];
     for(auto t : mesh.triangles)
     {
       t.indices += tIndex;
-      resultMesh.triangles.push_back(t);
+      *triangles++ = t;
     }
-  }
+  });
 
   return resultMesh;
 }
@@ -747,7 +754,17 @@ nvutils::PrimitiveMesh wobblePrimitive(const nvutils::PrimitiveMesh& mesh, float
 // compares its vertices, and creates a new set of unique vertices in uniqueVertices.
 // We use an unordered_map called vertexIndexMap to keep track of the mapping between
 // the original vertices and their corresponding indices in the uniqueVertices vector.
-PrimitiveMesh removeDuplicateVertices(const PrimitiveMesh& mesh, bool testNormal, bool testUv)
+// Remapping of the triangle corners to unique vertices
+struct VertexRemap
+{
+  std::vector<uint32_t> cornerToVertex;  // unique vertex of each triangle corner
+  std::vector<uint32_t> vertexToCorner;  // first corner referencing each unique vertex
+};
+
+// Finds the unique vertices over all triangle corners. The corners are distributed over shards by hash,
+// each shard maps its corners to the first equal one, independently of the others. Numbering the corners
+// that map to themselves, in corner order, gives the same result as a sequential pass.
+static VertexRemap buildVertexRemap(const PrimitiveMesh& mesh, bool testNormal, bool testUv)
 {
   auto hash = [&](const PrimitiveVertex& v) {
     if(testNormal)
@@ -764,40 +781,156 @@ PrimitiveMesh removeDuplicateVertices(const PrimitiveMesh& mesh, bool testNormal
   auto equal = [&](const PrimitiveVertex& l, const PrimitiveVertex& r) {
     return (l.pos == r.pos) && (testNormal ? l.nrm == r.nrm : true) && (testUv ? l.tex == r.tex : true);
   };
-  std::unordered_map<PrimitiveVertex, uint32_t, decltype(hash), decltype(equal)> vertexIndexMap(0, hash, equal);
 
-  std::vector<PrimitiveVertex>   uniqueVertices;
-  std::vector<PrimitiveTriangle> uniqueTriangles;
+  static_assert(sizeof(PrimitiveTriangle) == sizeof(uint32_t) * 3);
+  const uint32_t* cornerIndices = reinterpret_cast<const uint32_t*>(mesh.triangles.data());
+  const size_t    numCorners    = mesh.triangles.size() * 3;
+  auto cornerVertex = [&](uint32_t corner) -> const PrimitiveVertex& { return mesh.vertices[cornerIndices[corner]]; };
+
+  std::vector<size_t> cornerHashes(numCorners);
+  nvutils::parallel_batches<4096>(numCorners, [&](uint64_t c) { cornerHashes[c] = hash(cornerVertex(uint32_t(c))); });
 
-  for(const auto& triangle : mesh.triangles)
+  // Small meshes in a single shard
+  const uint32_t numShards = numCorners < (1 << 16) ? 1 : 64;
+
+  // Bucket the corners per shard, keeping them in increasing order within a shard
+  const uint64_t        chunkSize = 1 << 16;
+  const uint64_t        numChunks = (numCorners + chunkSize - 1) / chunkSize;
+  std::vector<uint32_t> chunkShardOffsets(numChunks * numShards, 0);
+  nvutils::parallel_batches<1>(numChunks, [&](uint64_t chunk) {
+    const uint64_t end = std::min((chunk + 1) * chunkSize, uint64_t(numCorners));
+    for(uint64_t c = chunk * chunkSize; c < end; c++)
+    {
+      chunkShardOffsets[chunk * numShards + cornerHashes[c] % numShards]++;
+    }
+  });
+  std::vector<uint32_t> shardBegin(numShards + 1, 0);
+  uint32_t              offset = 0;
+  for(uint32_t shard = 0; shard < numShards; shard++)
   {
-    PrimitiveTriangle uniqueTriangle = {};
-    for(int i = 0; i < 3; i++)
+    shardBegin[shard] = offset;
+    for(uint64_t chunk = 0; chunk < numChunks; chunk++)
     {
-      const PrimitiveVertex& vertex = mesh.vertices[triangle.indices[i]];
+      const uint32_t count = chunkShardOffsets[chunk * numShards + shard];
+      chunkShardOffsets[chunk * numShards + shard] = offset;
+      offset += count;
+    }
+  }
+  shardBegin[numShards] = offset;
 
-      // Check if the vertex is already in the uniqueVertices list
-      auto it = vertexIndexMap.find(vertex);
-      if(it == vertexIndexMap.end())
+  std::vector<uint32_t> shardCorners(numCorners);
+  nvutils::parallel_batches<1>(numChunks, [&](uint64_t chunk) {
+    const uint64_t end = std::min((chunk + 1) * chunkSize, uint64_t(numCorners));
+    for(uint64_t c = chunk * chunkSize; c < end; c++)
+    {
+      shardCorners[chunkShardOffsets[chunk * numShards + cornerHashes[c] % numShards]++] = uint32_t(c);
+    }
+  });
+
+  // First equal corner of each corner, using an open addressing table of corners per shard
+  std::vector<uint32_t> firstCorner(numCorners);
+  nvutils::parallel_batches<1>(numShards, [&](uint64_t shard) {
+    const uint32_t        count = shardBegin[shard + 1] - shardBegin[shard];
+    const size_t          mask  = std::bit_ceil(size_t(count) * 2 + 1) - 1;
+    std::vector<uint32_t> table(mask + 1, ~0u);
+
+    for(uint32_t i = shardBegin[shard]; i < shardBegin[shard + 1]; i++)
+    {
+      const uint32_t corner = shardCorners[i];
+      const size_t   hash   = cornerHashes[corner];
+      // the low bits picked the shard
+      size_t slot = (hash / numShards) & mask;
+      while(table[slot] != ~0u
+            && !(cornerHashes[table[slot]] == hash && equal(cornerVertex(table[slot]), cornerVertex(corner))))
       {
-        // Vertex not found, add it to uniqueVertices and update the index map
-        uint32_t newIndex      = static_cast<uint32_t>(uniqueVertices.size());
-        vertexIndexMap[vertex] = newIndex;
-        uniqueVertices.push_back(vertex);
-        uniqueTriangle.indices[i] = newIndex;
+        slot = (slot + 1) & mask;
       }
-      else
+      if(table[slot] == ~0u)
       {
-        // Vertex found, use its index in uniqueVertices
-        uniqueTriangle.indices[i] = it->second;
+        table[slot] = corner;
       }
+      firstCorner[corner] = table[slot];
+    }
+  });
+
+  // A first corner precedes all its duplicates, so it is numbered before them
+  VertexRemap remap;
+  remap.cornerToVertex.resize(numCorners);
+  for(uint32_t c = 0; c < numCorners; c++)
+  {
+    if(firstCorner[c] == c)
+    {
+      remap.cornerToVertex[c] = uint32_t(remap.vertexToCorner.size());
+      remap.vertexToCorner.push_back(c);
+    }
+    else
+    {
+      remap.cornerToVertex[c] = remap.cornerToVertex[firstCorner[c]];
     }
-    uniqueTriangles.push_back(uniqueTriangle);
   }
 
+  return remap;
+}
+
+PrimitiveMesh removeDuplicateVertices(const PrimitiveMesh& mesh, bool testNormal, bool testUv)
+{
+  const VertexRemap remap         = buildVertexRemap(mesh, testNormal, testUv);
+  const uint32_t*   cornerIndices = reinterpret_cast<const uint32_t*>(mesh.triangles.data());
+
+  PrimitiveMesh result;
+  result.vertices.resize(remap.vertexToCorner.size());
+  result.triangles.resize(mesh.triangles.size());
+  nvutils::parallel_batches<4096>(result.vertices.size(), [&](uint64_t v) {
+    result.vertices[v] = mesh.vertices[cornerIndices[remap.vertexToCorner[v]]];
+  });
+  nvutils::parallel_batches<4096>(result.triangles.size(), [&](uint64_t t) {
+    result.triangles[t].indices = {remap.cornerToVertex[t * 3 + 0], remap.cornerToVertex[t * 3 + 1],
+                                   remap.cornerToVertex[t * 3 + 2]};
+  });
+
   // nvprintf("Before: %d vertex, %d triangles\n", mesh.vertices.size(), mesh.triangles.size());
-  // nvprintf("After: %d vertex, %d triangles\n", uniqueVertices.size(), uniqueTriangles.size());
+  // nvprintf("After: %d vertex, %d triangles\n", result.vertices.size(), result.triangles.size());
+
+  return result;
+}
 
-  return {std::move(uniqueVertices), std::move(uniqueTriangles)};
+PrimitiveMeshSoA removeDuplicateVerticesSoA(const PrimitiveMesh& mesh, bool testNormal, bool testUv)
+{
+  VertexRemap     remap         = buildVertexRemap(mesh, testNormal, testUv);
+  const uint32_t* cornerIndices = reinterpret_cast<const uint32_t*>(mesh.triangles.data());
+
+  PrimitiveMeshSoA result;
+  result.positions.resize(remap.vertexToCorner.size());
+  result.normals.resize(remap.vertexToCorner.size());
+  result.texcoords.resize(remap.vertexToCorner.size());
+  nvutils::parallel_batches<4096>(remap.vertexToCorner.size(), [&](uint64_t v) {
+    const PrimitiveVertex& vertex = mesh.vertices[cornerIndices[remap.vertexToCorner[v]]];
+    result.positions[v]           = vertex.pos;
+    result.normals[v]             = vertex.nrm;
+    result.texcoords[v]           = vertex.tex;
+  });
+  result.indices = std::move(remap.cornerToVertex);
+
+  return result;
+}
+
+PrimitiveMeshSoA convertToSoA(const PrimitiveMesh& mesh)
+{
+  PrimitiveMeshSoA result;
+  result.positions.resize(mesh.vertices.size());
+  result.normals.resize(mesh.vertices.size());
+  result.texcoords.resize(mesh.vertices.size());
+  result.indices.resize(mesh.triangles.size() * 3);
+  nvutils::parallel_batches<4096>(mesh.vertices.size(), [&](uint64_t v) {
+    result.positions[v] = mesh.vertices[v].pos;
+    result.normals[v]   = mesh.vertices[v].nrm;
+    result.texcoords[v] = mesh.vertices[v].tex;
+  });
+  nvutils::parallel_batches<4096>(mesh.triangles.size(), [&](uint64_t t) {
+    result.indices[t * 3 + 0] = mesh.triangles[t].indices.x;
+    result.indices[t * 3 + 1] = mesh.triangles[t].indices.y;
+    result.indices[t * 3 + 2] = mesh.triangles[t].indices.z;
+  });
+  return result;
 }
 }  // namespace nvutils
@@ -72,6 +72,15 @@ struct PrimitiveMesh
   std::vector<PrimitiveTriangle> triangles;  // Indices forming triangles
 };
 
+// Structure-of-arrays layout of a PrimitiveMesh, each array can be uploaded as its own vertex stream
+struct PrimitiveMeshSoA
+{
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec2> texcoords;
+  std::vector<uint32_t>  indices;  // 3 per triangle
+};
+
 struct Node
 {
   glm::vec3 translation{};  //
@@ -105,8 +114,12 @@ std::vector<Node> mengerSpongeNodes(int level = 3, float probability = -1.f, int
 std::vector<Node> sunflower(int seeds = 3000);
 
 // Utilities
-PrimitiveMesh mergeNodes(const std::vector<Node>& nodes, const std::vector<PrimitiveMesh> meshes);
-PrimitiveMesh removeDuplicateVertices(const PrimitiveMesh& mesh, bool testNormal = true, bool testUv = true);
-PrimitiveMesh wobblePrimitive(const PrimitiveMesh& mesh, float amplitude = 0.05F);
+// mergeNodes and removeDuplicateVertices are multi-threaded for large meshes, the result does not
+// depend on the number of threads: vertices are kept in the order of their first reference.
+PrimitiveMesh    mergeNodes(const std::vector<Node>& nodes, const std::vector<PrimitiveMesh>& meshes);
+PrimitiveMesh    removeDuplicateVertices(const PrimitiveMesh& mesh, bool testNormal = true, bool testUv = true);
+PrimitiveMeshSoA removeDuplicateVerticesSoA(const PrimitiveMesh& mesh, bool testNormal = true, bool testUv = true);
+PrimitiveMeshSoA convertToSoA(const PrimitiveMesh& mesh);
+PrimitiveMesh    wobblePrimitive(const PrimitiveMesh& mesh, float amplitude = 0.05F);
 
 }  // namespace nvutils
@@ -17,10 +17,15 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <fstream>
 
 #include <fmt/format.h>
 
+#include "file_operations.hpp"
+#include "logger.hpp"
 #include "profiler.hpp"
 
 namespace nvutils {
@@ -52,17 +57,34 @@ void ProfilerTimeline::Snapshot::appendToString(std::string& stats, bool full =
 
     if(full)
     {
-      stats += fmt::format("Timeline \"{}\"; level {}; Timer \"{}\"; GPU; avg {}; min {}; max {}; last {}; CPU; avg {}; min {}; max {}; last {}; samples {};\n",
+      stats += fmt::format("Timeline \"{}\"; level {}; Timer \"{}\"; GPU; avg {}; min {}; max {}; last {}; p50 {}; p95 {}; p99 {}; window max {}; CPU; avg {}; min {}; max {}; last {}; p50 {}; p95 {}; p99 {}; window max {}; samples {};\n",
                            name, int32_t(info.async ? -1 : info.level), timerNames[i], (uint32_t)(info.gpu.average),
-                           (uint32_t)(info.gpu.absMinValue), (uint32_t)(info.gpu.absMaxValue),
-                           (uint32_t)(info.gpu.last), (uint32_t)(info.cpu.average), (uint32_t)(info.cpu.absMinValue),
-                           (uint32_t)(info.cpu.absMaxValue), (uint32_t)(info.cpu.last), info.numAveraged);
+                           (uint32_t)(info.gpu.absMinValue), (uint32_t)(info.gpu.absMaxValue), (uint32_t)(info.gpu.last),
+                           (uint32_t)(info.gpu.p50), (uint32_t)(info.gpu.p95), (uint32_t)(info.gpu.p99),
+                           (uint32_t)(info.gpu.windowMax), (uint32_t)(info.cpu.average), (uint32_t)(info.cpu.absMinValue),
+                           (uint32_t)(info.cpu.absMaxValue), (uint32_t)(info.cpu.last), (uint32_t)(info.cpu.p50),
+                           (uint32_t)(info.cpu.p95), (uint32_t)(info.cpu.p99), (uint32_t)(info.cpu.windowMax), info.numAveraged);
     }
     else
     {
-      stats += fmt::format("{:12}; {:3};{}{:16}{}; GPU; avg {:6}; CPU; avg {:6}; microseconds;\n", name,
+      stats += fmt::format("{:12}; {:3};{}{:16}{}; GPU; avg {:6}; p99 {:6}; CPU; avg {:6}; p99 {:6}; microseconds;\n", name,
                            int32_t(info.async ? -1 : info.level), indentSpaces, timerNames[i], indentSpacesOp,
-                           (uint32_t)(info.gpu.average), (uint32_t)(info.cpu.average));
+                           (uint32_t)(info.gpu.average), (uint32_t)(info.gpu.p99), (uint32_t)(info.cpu.average),
+                           (uint32_t)(info.cpu.p99));
+    }
+  }
+
+  for(size_t i = 0; i < counterInfos.size(); i++)
+  {
+    const CounterInfo& info = counterInfos[i];
+    if(full)
+    {
+      stats += fmt::format("Timeline \"{}\"; Counter \"{}\"; avg {}; min {}; max {}; last {}; samples {};\n", name,
+                           counterNames[i], info.average, info.absMinValue, info.absMaxValue, info.last, info.numAveraged);
+    }
+    else
+    {
+      stats += fmt::format("{:12}; counter; {:16}; avg {:10.1f}; last {:10.0f};\n", name, counterNames[i], info.average, info.last);
     }
   }
 }
@@ -80,12 +102,38 @@ void ProfilerTimeline::TimeValues::reset()
   times       = {};
 }
 
+void ProfilerTimeline::TimeValues::getPercentiles(TimerStats& stats) const
+{
+  // the last `count` samples end before cycleIndex
+  const uint32_t                      count = std::min(validCount, MAX_LAST_FRAMES);
+  std::array<double, MAX_LAST_FRAMES> sorted;
+  for(uint32_t i = 0; i < count; i++)
+  {
+    sorted[i] = times[(MAX_LAST_FRAMES + cycleIndex - count + i) % MAX_LAST_FRAMES];
+  }
+  std::sort(sorted.begin(), sorted.begin() + count);
+
+  auto percentile = [&](double p) {
+    return count ? sorted[std::max(uint32_t(std::ceil(p * double(count))), 1u) - 1] : 0.0;
+  };
+  stats.p50       = percentile(0.50);
+  stats.p95       = percentile(0.95);
+  stats.p99       = percentile(0.99);
+  stats.windowMax = count ? sorted[count - 1] : 0.0;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 void ProfilerTimeline::setFrameAveragingCount(uint32_t num)
 {
   assert(num <= MAX_LAST_FRAMES);
   m_frame.averagingCount = num;
+
+  std::lock_guard guard(m_countersMutex);
+  for(CounterData& counter : m_counters)
+  {
+    counter.values.init(num);
+  }
 }
 
 void ProfilerTimeline::clear()
@@ -100,6 +148,16 @@ void ProfilerTimeline::clear()
     std::lock_guard guard(m_frameSnapshotMutex);
     m_frameSnapshot = {};
   }
+
+  {
+    std::lock_guard guard(m_threadStatsMutex);
+    m_threadStats.clear();
+  }
+
+  {
+    std::lock_guard guard(m_countersMutex);
+    m_counters.clear();
+  }
 }
 
 void ProfilerTimeline::resetFrameSections(uint32_t delay)
@@ -135,7 +193,23 @@ void ProfilerTimeline::frameEnd()
   assert(m_frame.level == 1);
   assert(m_inFrame);
 
-  m_frame.cpuCurrentTime += m_profiler->getMicroseconds();
+  const double frameEndTime = m_profiler->getMicroseconds();
+  m_frame.cpuCurrentTime += frameEndTime;
+
+  // Take one frame of the trace capture; the sections are the ones of the frame queried below
+  std::vector<ProfilerManager::TraceEvent> traceEvents;
+  uint32_t                                 traceFramesLeft = m_traceFramesLeft.load();
+  while(traceFramesLeft && !m_traceFramesLeft.compare_exchange_weak(traceFramesLeft, traceFramesLeft - 1))
+  {
+  }
+  if(traceFramesLeft)
+  {
+    traceEvents.push_back({.name        = "Frame",
+                           .timeline    = m_info.name,
+                           .frame       = m_frame.count,
+                           .cpuBegin    = frameEndTime - m_frame.cpuCurrentTime,
+                           .cpuDuration = m_frame.cpuCurrentTime});
+  }
 
   if(m_frame.sectionsCount && m_frame.sectionsCount != m_frame.sectionsCountLast)
   {
@@ -198,6 +272,24 @@ void ProfilerTimeline::frameEnd()
         gpuLastLevel = ~0;
       }
 
+      if(available && traceFramesLeft)
+      {
+        ProfilerManager::TraceEvent event{.name        = section.name,
+                                          .timeline    = m_info.name,
+                                          .frame       = m_frame.count + 1 - m_info.frameDelay,
+                                          .level       = section.level,
+                                          .cpuBegin    = section.cpuBegins[queryFrame],
+                                          .cpuDuration = section.cpuTimes[queryFrame]};
+        if(section.gpuTimeProvider)
+        {
+          event.hasGpu      = true;
+          event.gpuDuration = section.gpuTimes[queryFrame];
+          event.hasGpuBegin = section.gpuTimeProvider->frameBeginFunction
+                              && section.gpuTimeProvider->frameBeginFunction(sec, event.gpuBegin);
+        }
+        traceEvents.push_back(std::move(event));
+      }
+
       if(available)
       {
         section.cpuTime.add(section.cpuTimes[queryFrame]);
@@ -216,6 +308,13 @@ void ProfilerTimeline::frameEnd()
     m_frame.cpuTime.add(m_frame.cpuCurrentTime);
   }
 
+  threadMerge(traceFramesLeft != 0);
+
+  if(traceFramesLeft)
+  {
+    m_profiler->traceAddEvents(traceEvents, traceFramesLeft == 1);
+  }
+
   frameInternalSnapshot();
 
   m_frame.count++;
@@ -317,8 +416,9 @@ ProfilerTimeline::FrameSectionID ProfilerTimeline::frameBeginSection(const std::
   section.splitter        = false;
   section.gpuTimeProvider = gpuTimeProvider;
 
-  section.cpuTimes[sectionID.subFrame] = -m_profiler->getMicroseconds();
-  section.gpuTimes[sectionID.subFrame] = 0;
+  section.cpuBegins[sectionID.subFrame] = m_profiler->getMicroseconds();
+  section.cpuTimes[sectionID.subFrame]  = -section.cpuBegins[sectionID.subFrame];
+  section.gpuTimes[sectionID.subFrame]  = 0;
 
   return sectionID;
 }
@@ -332,8 +432,14 @@ void ProfilerTimeline::frameEndSection(FrameSectionID sectionID)
 
 void ProfilerTimeline::frameResetCpuBegin(FrameSectionID sectionID)
 {
-  SectionData& section                 = m_frame.sections[sectionID.id];
-  section.cpuTimes[sectionID.subFrame] = -m_profiler->getMicroseconds();
+  frameResetCpuBegin(sectionID, m_profiler->getMicroseconds());
+}
+
+void ProfilerTimeline::frameResetCpuBegin(FrameSectionID sectionID, double cpuBeginMicroseconds)
+{
+  SectionData& section                  = m_frame.sections[sectionID.id];
+  section.cpuBegins[sectionID.subFrame] = cpuBeginMicroseconds;
+  section.cpuTimes[sectionID.subFrame]  = -cpuBeginMicroseconds;
 }
 
 ProfilerTimeline::AsyncSectionID ProfilerTimeline::asyncBeginSection(const std::string& name, GpuTimeProvider* gpuTimeProvider)
@@ -425,6 +531,197 @@ void ProfilerTimeline::asyncRemoveTimer(const std::string& name)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////
+
+ProfilerTimeline::ThreadBuffer* ProfilerTimeline::threadGetBuffer()
+{
+  // buffers of the timelines used by this thread, the uids of destroyed timelines are never matched again
+  struct Cache
+  {
+    std::vector<std::pair<uint64_t, std::shared_ptr<ThreadBuffer>>> buffers;
+    ~Cache()
+    {
+      for(auto& [uid, buffer] : buffers)
+      {
+        buffer->exited.store(true, std::memory_order_release);
+      }
+    }
+  };
+  thread_local Cache cache;
+  for(const auto& [uid, buffer] : cache.buffers)
+  {
+    if(uid == m_uid)
+      return buffer.get();
+  }
+
+  std::lock_guard lock(m_threadBuffersMutex);
+
+  // the buffer of an exited thread, once merged, or a new one
+  std::shared_ptr<ThreadBuffer> buffer;
+  for(size_t i = 0; i < m_threadBuffers.size() && !buffer; i++)
+  {
+    ThreadBuffer& other = *m_threadBuffers[i];
+    if(other.exited.load(std::memory_order_acquire) && other.tail.load() == other.head.load())
+    {
+      buffer            = m_threadBuffers[i];
+      buffer->name      = fmt::format("Thread {}", i + 1);
+      buffer->openCount = 0;
+      buffer->exited    = false;
+    }
+  }
+  if(!buffer)
+  {
+    buffer       = m_threadBuffers.emplace_back(std::make_shared<ThreadBuffer>());
+    buffer->name = fmt::format("Thread {}", m_threadBuffers.size());
+  }
+  cache.buffers.push_back({m_uid, buffer});
+  return buffer.get();
+}
+
+void ProfilerTimeline::threadBeginSection(const char* name)
+{
+  ThreadBuffer* buffer = threadGetBuffer();
+  assert(buffer->openCount < ThreadBuffer::MAX_LEVEL && "too many nested thread sections");
+  if(buffer->openCount < ThreadBuffer::MAX_LEVEL)
+  {
+    buffer->open[buffer->openCount] = {.name = name, .cpuBegin = m_profiler->getMicroseconds(), .level = buffer->openCount};
+  }
+  buffer->openCount++;
+}
+
+void ProfilerTimeline::threadEndSection()
+{
+  const double  endTime = m_profiler->getMicroseconds();
+  ThreadBuffer* buffer  = threadGetBuffer();
+  assert(buffer->openCount && "threadEndSection without threadBeginSection");
+  if(!buffer->openCount || --buffer->openCount >= ThreadBuffer::MAX_LEVEL)
+    return;
+
+  ThreadEvent event = buffer->open[buffer->openCount];
+  event.cpuTime     = endTime - event.cpuBegin;
+
+  const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+  if(head - buffer->tail.load(std::memory_order_acquire) >= ThreadBuffer::CAPACITY)
+  {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer->events[head % ThreadBuffer::CAPACITY] = event;
+  buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void ProfilerTimeline::threadSetName(const std::string& name)
+{
+  ThreadBuffer*   buffer = threadGetBuffer();
+  std::lock_guard lock(m_threadBuffersMutex);
+  buffer->name = name;
+}
+
+void ProfilerTimeline::threadMerge(bool trace)
+{
+  std::vector<ProfilerManager::TraceEvent> traceEvents;
+  {
+    std::lock_guard lock(m_threadBuffersMutex);
+    std::lock_guard statsLock(m_threadStatsMutex);
+
+    for(uint32_t t = 0; t < uint32_t(m_threadBuffers.size()); t++)
+    {
+      ThreadBuffer&  buffer = *m_threadBuffers[t];
+      const uint64_t head   = buffer.head.load(std::memory_order_acquire);
+      for(uint64_t i = buffer.tail.load(std::memory_order_relaxed); i < head; i++)
+      {
+        const ThreadEvent& event = buffer.events[i % ThreadBuffer::CAPACITY];
+
+        auto it = std::find_if(m_threadStats.begin(), m_threadStats.end(), [&](const ThreadStats& stats) {
+          return stats.thread == t && stats.level == event.level && stats.name == event.name;
+        });
+        if(it == m_threadStats.end())
+        {
+          it = m_threadStats.insert(m_threadStats.end(), {.thread = t, .name = event.name, .level = event.level});
+          it->cpuTime.init(m_frame.averagingCount);
+        }
+        it->frameTime += event.cpuTime;
+        it->inFrame = true;
+
+        if(trace)
+        {
+          traceEvents.push_back({.name        = event.name,
+                                 .timeline    = m_info.name,
+                                 .thread      = buffer.name,
+                                 .frame       = m_frame.count,
+                                 .level       = event.level + 1,
+                                 .cpuBegin    = event.cpuBegin,
+                                 .cpuDuration = event.cpuTime});
+        }
+      }
+      buffer.tail.store(head, std::memory_order_release);
+
+      if(uint32_t dropped = buffer.dropped.exchange(0, std::memory_order_relaxed))
+      {
+        LOGW("Profiler timeline %s: %u sections of %s dropped, more than %u in a frame\n", m_info.name.c_str(),
+             dropped, buffer.name.c_str(), ThreadBuffer::CAPACITY);
+      }
+    }
+
+    // the threads without sections in the frame keep their last value
+    for(ThreadStats& stats : m_threadStats)
+    {
+      if(stats.inFrame)
+      {
+        stats.cpuTime.add(stats.frameTime);
+        stats.frameTime = 0;
+        stats.inFrame   = false;
+      }
+    }
+  }
+
+  if(!traceEvents.empty())
+  {
+    m_profiler->traceAddEvents(traceEvents, false);
+  }
+}
+
+void ProfilerTimeline::threadAppendSnapshot(Snapshot& snapShot) const
+{
+  std::lock_guard lock(m_threadBuffersMutex);
+  std::lock_guard statsLock(m_threadStatsMutex);
+
+  for(uint32_t t = 0; t < uint32_t(m_threadBuffers.size()); t++)
+  {
+    bool hasParent = false;
+    for(const ThreadStats& stats : m_threadStats)
+    {
+      if(stats.thread != t || !stats.cpuTime.validCount)
+        continue;
+
+      // artificial parent per thread, like "Async"
+      if(!hasParent)
+      {
+        snapShot.timerInfos.push_back({});
+        snapShot.timerNames.push_back(m_threadBuffers[t]->name);
+        snapShot.timerApiNames.push_back("");
+        hasParent = true;
+      }
+
+      TimerInfo timerInfo;
+      timerInfo.async           = true;
+      timerInfo.accumulated     = true;
+      timerInfo.level           = stats.level + 1;
+      timerInfo.numAveraged     = stats.cpuTime.validCount;
+      timerInfo.cpu.last        = stats.cpuTime.valueLast;
+      timerInfo.cpu.average     = stats.cpuTime.getAveraged();
+      timerInfo.cpu.absMinValue = stats.cpuTime.absMinValue;
+      timerInfo.cpu.absMaxValue = stats.cpuTime.absMaxValue;
+      timerInfo.cpu.times       = stats.cpuTime.times;
+      timerInfo.cpu.index       = stats.cpuTime.cycleIndex;
+      stats.cpuTime.getPercentiles(timerInfo.cpu);
+
+      snapShot.timerInfos.push_back(timerInfo);
+      snapShot.timerNames.push_back(stats.name);
+      snapShot.timerApiNames.push_back("");
+    }
+  }
+}
 
 void ProfilerTimeline::grow(std::vector<SectionData>& sections, size_t newSize, uint32_t averagingCount)
 {
@@ -467,7 +764,9 @@ bool ProfilerTimeline::frameGetTimerInfo(uint32_t i, TimerInfo& info)
   info.gpu.times       = section.gpuTime.times;
   info.cpu.index       = section.cpuTime.cycleIndex;
   info.gpu.index       = section.gpuTime.cycleIndex;
-  bool found           = false;
+  section.cpuTime.getPercentiles(info.cpu);
+  section.gpuTime.getPercentiles(info.gpu);
+  bool found = false;
   if(section.level != LEVEL_SINGLESHOT && m_frame.hasSplitter)
   {
     for(uint32_t n = i + 1; n < m_frame.sectionsCountLast; n++)
@@ -485,6 +784,20 @@ bool ProfilerTimeline::frameGetTimerInfo(uint32_t i, TimerInfo& info)
         info.cpu.absMaxValue += otherSection.cpuTime.absMaxValue;
         info.gpu.absMinValue += otherSection.gpuTime.absMinValue;
         info.gpu.absMaxValue += otherSection.gpuTime.absMaxValue;
+
+        // approximation, the percentiles of a sum are not the sum of the percentiles
+        TimerStats otherCpu;
+        TimerStats otherGpu;
+        otherSection.cpuTime.getPercentiles(otherCpu);
+        otherSection.gpuTime.getPercentiles(otherGpu);
+        info.cpu.p50 += otherCpu.p50;
+        info.cpu.p95 += otherCpu.p95;
+        info.cpu.p99 += otherCpu.p99;
+        info.cpu.windowMax += otherCpu.windowMax;
+        info.gpu.p50 += otherGpu.p50;
+        info.gpu.p95 += otherGpu.p95;
+        info.gpu.p99 += otherGpu.p99;
+        info.gpu.windowMax += otherGpu.windowMax;
         otherSection.accumulated = true;
       }
 
@@ -521,11 +834,19 @@ bool ProfilerTimeline::asyncGetTimerInfo(uint32_t i, TimerInfo& info) const
     info.cpu.absMaxValue = cpuTime;
     info.cpu.average     = cpuTime;
     info.cpu.last        = cpuTime;
+    info.cpu.p50         = cpuTime;
+    info.cpu.p95         = cpuTime;
+    info.cpu.p99         = cpuTime;
+    info.cpu.windowMax   = cpuTime;
 
     info.gpu.absMaxValue = gpuTime;
     info.gpu.absMaxValue = gpuTime;
     info.gpu.average     = gpuTime;
     info.gpu.last        = gpuTime;
+    info.gpu.p50         = gpuTime;
+    info.gpu.p95         = gpuTime;
+    info.gpu.p99         = gpuTime;
+    info.gpu.windowMax   = gpuTime;
 
     return true;
   }
@@ -573,6 +894,8 @@ void ProfilerTimeline::getAsyncSnapshot(Snapshot& snapShot) const
     snapShot.timerNames.clear();
     snapShot.timerApiNames.clear();
   }
+
+  threadAppendSnapshot(snapShot);
 }
 
 bool ProfilerTimeline::getAsyncTimerInfo(const std::string& name, TimerInfo& timerInfo, std::string& apiName) const
@@ -597,9 +920,27 @@ bool ProfilerTimeline::getAsyncTimerInfo(const std::string& name, TimerInfo& tim
 
 void ProfilerTimeline::getFrameSnapshot(Snapshot& snapShot) const
 {
-  std::lock_guard lock(m_frameSnapshotMutex);
+  {
+    std::lock_guard lock(m_frameSnapshotMutex);
 
-  snapShot = m_frameSnapshot;
+    snapShot = m_frameSnapshot;
+  }
+
+  std::lock_guard lock(m_countersMutex);
+
+  snapShot.counterInfos.clear();
+  snapShot.counterNames.clear();
+  for(const CounterData& counter : m_counters)
+  {
+    Snapshot::CounterInfo info;
+    info.last        = counter.values.valueLast;
+    info.average     = counter.values.getAveraged();
+    info.absMinValue = counter.values.validCount ? counter.values.absMinValue : 0;
+    info.absMaxValue = counter.values.absMaxValue;
+    info.numAveraged = counter.values.validCount;
+    snapShot.counterInfos.push_back(info);
+    snapShot.counterNames.push_back(counter.name);
+  }
 }
 
 bool ProfilerTimeline::getFrameTimerInfo(const std::string& name, TimerInfo& info, std::string& apiName) const
@@ -621,6 +962,27 @@ bool ProfilerTimeline::getFrameTimerInfo(const std::string& name, TimerInfo& inf
 
 //////////////////////////////////////////////////////////////////////////
 
+void ProfilerTimeline::setCounter(const std::string& name, double value)
+{
+  std::lock_guard lock(m_countersMutex);
+
+  auto it = std::find_if(m_counters.begin(), m_counters.end(), [&](const CounterData& counter) { return counter.name == name; });
+  if(it == m_counters.end())
+  {
+    it = m_counters.insert(m_counters.end(), {name, TimeValues(m_frame.averagingCount)});
+  }
+  it->values.add(value);
+}
+
+void ProfilerTimeline::removeCounter(const std::string& name)
+{
+  std::lock_guard lock(m_countersMutex);
+
+  std::erase_if(m_counters, [&](const CounterData& counter) { return counter.name == name; });
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 ProfilerManager::~ProfilerManager()
 {
   assert(m_timelines.empty() && "forgot to destroy all timelines");
@@ -630,7 +992,16 @@ ProfilerTimeline* ProfilerManager::createTimeline(const ProfilerTimeline::Create
 {
   std::lock_guard lock(m_mutex);
 
-  return m_timelines.emplace_back(new ProfilerTimeline(this, createInfo)).get();
+  ProfilerTimeline* timeline = m_timelines.emplace_back(new ProfilerTimeline(this, createInfo)).get();
+
+  std::lock_guard traceLock(m_traceMutex);
+  if(m_traceCapturing)
+  {
+    timeline->m_traceFramesLeft = m_traceFrameCount;
+    m_traceTimelineLeft++;
+  }
+
+  return timeline;
 }
 
 void ProfilerManager::destroyTimeline(ProfilerTimeline* timeline)
@@ -641,6 +1012,12 @@ void ProfilerManager::destroyTimeline(ProfilerTimeline* timeline)
   {
     if(it->get() == timeline)
     {
+      // a timeline still capturing does not hold back the end of the capture
+      if(timeline->m_traceFramesLeft.exchange(0) != 0)
+      {
+        std::vector<TraceEvent> noEvents;
+        traceAddEvents(noEvents, true);
+      }
       m_timelines.erase(it);
       return;
     }
@@ -699,6 +1076,161 @@ void ProfilerManager::getSnapshots(std::vector<ProfilerTimeline::Snapshot>& fram
   }
 }
 
+void ProfilerManager::beginTraceCapture(uint32_t frameCount)
+{
+  std::lock_guard lock(m_mutex);
+  std::lock_guard traceLock(m_traceMutex);
+
+  m_traceEvents.clear();
+  m_traceFrameCount   = frameCount ? frameCount : ~0u;
+  m_traceTimelineLeft = uint32_t(m_timelines.size());
+  for(auto& it : m_timelines)
+  {
+    it->m_traceFramesLeft = m_traceFrameCount;
+  }
+  m_traceCapturing = true;
+}
+
+void ProfilerManager::endTraceCapture()
+{
+  std::lock_guard lock(m_mutex);
+  std::lock_guard traceLock(m_traceMutex);
+
+  for(auto& it : m_timelines)
+  {
+    it->m_traceFramesLeft = 0;
+  }
+  m_traceTimelineLeft = 0;
+  m_traceCapturing    = false;
+}
+
+void ProfilerManager::traceAddEvents(std::vector<TraceEvent>& events, bool last)
+{
+  std::lock_guard traceLock(m_traceMutex);
+
+  m_traceEvents.insert(m_traceEvents.end(), std::make_move_iterator(events.begin()), std::make_move_iterator(events.end()));
+  if(last && m_traceTimelineLeft && --m_traceTimelineLeft == 0)
+  {
+    m_traceCapturing = false;
+  }
+}
+
+std::vector<ProfilerManager::TraceEvent> ProfilerManager::getTraceEvents() const
+{
+  std::lock_guard traceLock(m_traceMutex);
+  return m_traceEvents;
+}
+
+static std::string jsonEscape(const std::string& str)
+{
+  std::string result;
+  result.reserve(str.size());
+  for(char c : str)
+  {
+    switch(c)
+    {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      default:
+        if(static_cast<unsigned char>(c) < 0x20)
+          result += fmt::format("\\u{:04x}", int(c));
+        else
+          result += c;
+    }
+  }
+  return result;
+}
+
+void ProfilerManager::appendTraceJson(std::string& json) const
+{
+  std::vector<TraceEvent> events = getTraceEvents();
+
+  // One process, and two threads per timeline: thread 2*i+1 for the CPU, 2*i+2 for the GPU,
+  // then one per thread with per-thread sections
+  std::vector<std::string> timelines;
+  std::vector<std::string> threads;  // "<timeline> <thread>"
+  auto                     getIndex = [&](std::vector<std::string>& names, const std::string& name) {
+    auto it = std::find(names.begin(), names.end(), name);
+    if(it == names.end())
+    {
+      names.push_back(name);
+      return uint32_t(names.size() - 1);
+    }
+    return uint32_t(it - names.begin());
+  };
+  for(const TraceEvent& event : events)
+  {
+    if(event.thread.empty())
+      getIndex(timelines, event.timeline);
+  }
+
+  json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool first = true;
+  auto append = [&](const std::string& event) {
+    json += first ? "  " : ",\n  ";
+    json += event;
+    first = false;
+  };
+
+  for(const TraceEvent& event : events)
+  {
+    const uint32_t    tid  = event.thread.empty() ?
+                                 getIndex(timelines, event.timeline) * 2 + 1 :
+                                 uint32_t(timelines.size()) * 2 + 1 + getIndex(threads, event.timeline + " " + event.thread);
+    const std::string name = jsonEscape(event.name);
+    const std::string args = event.hasGpu ? fmt::format("{{\"frame\":{},\"level\":{},\"gpu_us\":{:.3f}}}", event.frame,
+                                                        event.level, event.gpuDuration) :
+                                            fmt::format("{{\"frame\":{},\"level\":{}}}", event.frame, event.level);
+
+    append(fmt::format("{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{}}}",
+                       name, tid, event.cpuBegin, event.cpuDuration, args));
+    if(event.hasGpu && event.hasGpuBegin)
+    {
+      append(fmt::format("{{\"name\":\"{}\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{}}}",
+                         name, tid + 1, event.gpuBegin, event.gpuDuration, args));
+    }
+  }
+
+  // Track names
+  for(uint32_t i = 0; i < uint32_t(timelines.size()); i++)
+  {
+    const std::string name = jsonEscape(timelines[i]);
+    append(fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{} CPU\"}}}}", i * 2 + 1, name));
+    append(fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{} GPU\"}}}}", i * 2 + 2, name));
+  }
+  for(uint32_t i = 0; i < uint32_t(threads.size()); i++)
+  {
+    append(fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                       uint32_t(timelines.size()) * 2 + 1 + i, jsonEscape(threads[i])));
+  }
+
+  json += "\n]}\n";
+}
+
+bool ProfilerManager::saveTraceJson(const std::filesystem::path& filename) const
+{
+  std::string json;
+  appendTraceJson(json);
+
+  std::ofstream file(filename, std::ios::binary);
+  if(!file)
+  {
+    LOGE("Failed to open file for writing: %s\n", nvutils::utf8FromPath(filename).c_str());
+    return false;
+  }
+  file.write(json.data(), json.size());
+  if(!file)
+  {
+    LOGE("Failed to write the profiler trace to file: %s\n", nvutils::utf8FromPath(filename).c_str());
+    return false;
+  }
+  return true;
+}
+
 }  // namespace nvutils
 
 //--------------------------------------------------------------------------------------------------
@@ -758,4 +1290,19 @@ void ProfilerManager::getSnapshots(std::vector<ProfilerTimeline::Snapshot>& fram
   profilerManager.appendPrint(myFrameStats, myAsyncStats);
 
   // output strings to log etc.
+
+  // Worker threads use lock-free per-thread sections, merged at the frame end of the timeline
+  /* std::thread worker([&] { */
+  {
+    profilerTimeline->threadSetName("Texture decoder");
+    auto profiledSection = profilerTimeline->threadSection("decode");
+
+    // do some work
+  }
+  /* }); */
+
+  // Capture the next 60 frames of all timelines, then open the file in chrome://tracing or ui.perfetto.dev
+  profilerManager.beginTraceCapture(60);
+  /* while(profilerManager.isTraceCapturing()) { ... profilerTimeline->frameAdvance(); } */
+  profilerManager.saveTraceJson("profiler_trace.json");
 }
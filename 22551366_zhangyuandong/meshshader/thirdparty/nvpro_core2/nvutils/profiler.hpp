@@ -20,7 +20,9 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <filesystem>
 #include <limits>
 #include <functional>
 #include <memory>
@@ -45,6 +47,8 @@ class ProfilerManager;
 // - single shot operations start with the "async" prefix.
 //   They are thread-safe and can be called at any time.
 //   Timer results using the same timer name are then overwritten.
+// - per-thread CPU operations start with the "thread" prefix.
+//   They are lock-free, for the work of worker threads, and are merged at `frameEnd`.
 
 class ProfilerTimeline
 {
@@ -94,14 +98,18 @@ public:
   typedef std::function<bool(FrameSectionID, double& gpuTime)> gpuFrameTimeProvider_fn;
   // GPU times for AsyncSectionID are queried at "
   typedef std::function<bool(AsyncSectionID, double& gpuTime)> gpuAsyncTimeProvider_fn;
+  // Optional, used by trace captures: returns true if the GPU begin of the section is available,
+  // and writes it into gpuBegin in `ProfilerManager::getMicroseconds()` time (calibrated timestamps).
+  typedef std::function<bool(FrameSectionID, double& gpuBegin)> gpuFrameBeginProvider_fn;
 
   // This class can hold timer sections from different APIs (Vk, GL, CUDA...). We use the
   // below struct to serve as API agnostic interface.
   struct GpuTimeProvider
   {
-    std::string             apiName;
-    gpuFrameTimeProvider_fn frameFunction;
-    gpuAsyncTimeProvider_fn asyncFunction;
+    std::string              apiName;
+    gpuFrameTimeProvider_fn  frameFunction;
+    gpuAsyncTimeProvider_fn  asyncFunction;
+    gpuFrameBeginProvider_fn frameBeginFunction;
 
     // Utility functions that help converting the FrameSectionID or AsyncSectionID to a linear array index.
     // Useful for GPU timer classes to manage resources as big arrays, or pools of arrays.
@@ -140,6 +148,9 @@ public:
 
   // GPU timer implementations may want to use this function to reset the cpu time to exclude internal setup overhead
   void frameResetCpuBegin(FrameSectionID sec);
+  // Moves the cpu begin to an earlier time point from `ProfilerManager::getMicroseconds()`, so a section can
+  // measure an interval that started before the current frame (e.g. input to present latency)
+  void frameResetCpuBegin(FrameSectionID sec, double cpuBeginMicroseconds);
 
   // When a section is used within a loop (same nesting level), and the the same arguments for name and api are
   // passed, we normally average the results of those sections together when printing the stats or using the
@@ -188,6 +199,30 @@ public:
   // can release timer names you never want to use again
   void asyncRemoveTimer(const std::string& name);
 
+  //////////////////////////////////////////////////////////////////////////
+  // per-thread CPU timer operations
+  // lock-free, to measure worker threads (texture decode, BLAS build...) without perturbing them
+
+  // Each thread appends its sections to its own buffer, only its first section on the timeline
+  // takes a lock to register it. The buffers are merged at `frameEnd`: the times are summed per
+  // thread and name over the frame and reported in the async snapshot, one group per thread,
+  // and trace captures show each thread as its own track.
+  // `name` is not copied, it must stay valid until the section is merged (e.g. a literal).
+  void threadBeginSection(const char* name);
+  void threadEndSection();
+  // names the track and the group of the calling thread, "Thread N" otherwise
+  void threadSetName(const std::string& name);
+
+  //////////////////////////////////////////////////////////////////////////
+  // counters
+  // thread-safe
+
+  // Values sampled once per frame next to the timers, e.g. the GPU counters read back by `nvvk::GpuCounters`.
+  // They are averaged over the window of the frame sections and reported in the frame snapshot.
+  void setCounter(const std::string& name, double value);
+  // can release counter names you never want to use again
+  void removeCounter(const std::string& name);
+
   //////////////////////////////////////////////////////////////////////////
   // getters
 
@@ -200,6 +235,13 @@ public:
     double   absMaxValue = 0;
     uint32_t index       = 0;
 
+    // distribution over the averaged frames (at most MAX_LAST_FRAMES),
+    // shows the stutter hidden by the average
+    double p50       = 0;
+    double p95       = 0;
+    double p99       = 0;
+    double windowMax = 0;
+
     std::array<double, MAX_LAST_FRAMES> times = {};
   };
 
@@ -242,8 +284,21 @@ public:
     // name of the GPU api the timer used
     std::vector<std::string> timerApiNames;
 
+    struct CounterInfo
+    {
+      double   last        = 0;
+      double   average     = 0;
+      double   absMinValue = 0;
+      double   absMaxValue = 0;
+      uint32_t numAveraged = 0;
+    };
+
+    // counters of the timeline, in the order they were first set, frame snapshots only
+    std::vector<CounterInfo> counterInfos;
+    std::vector<std::string> counterNames;
+
     // If `full == true` appends all properties of a `TimerInfo`,
-    // otherwise only the `level` and `averages` for GPU and CPU are added.
+    // otherwise only the `level`, `averages` and p99 for GPU and CPU are added.
     void appendToString(std::string& stats, bool full) const;
   };
 
@@ -315,6 +370,25 @@ public:
   // thread-safe
   AsyncSection asyncSection(const std::string& name) { return AsyncSection(*this, asyncBeginSection(name, nullptr)); }
 
+  // utility class to call begin/end within local scope
+  class ThreadSection
+  {
+  public:
+    ThreadSection(ProfilerTimeline& ProfilerTimeline)
+        : m_ProfilerTimeline(ProfilerTimeline) {};
+    ~ThreadSection() { m_ProfilerTimeline.threadEndSection(); }
+
+  private:
+    ProfilerTimeline& m_ProfilerTimeline;
+  };
+
+  // lock-free
+  ThreadSection threadSection(const char* name)
+  {
+    threadBeginSection(name);
+    return ThreadSection(*this);
+  }
+
   //////////////////////////////////////////////////////////////////////////
   // internals
   ProfilerTimeline() = default;
@@ -326,6 +400,9 @@ protected:
   {
     assert(profiler);
 
+    static std::atomic<uint64_t> s_uid = 0;
+    m_uid                              = ++s_uid;
+
     m_info     = createInfo;
     m_profiler = profiler;
 
@@ -404,7 +481,10 @@ protected:
       cycleIndex = (cycleIndex + 1) % MAX_LAST_FRAMES;
     }
 
-    double getAveraged()
+    // nearest-rank percentiles of the samples in the averaging window
+    void getPercentiles(TimerStats& stats) const;
+
+    double getAveraged() const
     {
       if(validCount)
       {
@@ -425,7 +505,8 @@ protected:
     uint32_t level    = 0;
     uint32_t subFrame = 0;
 
-    std::array<double, MAX_FRAME_DELAY> cpuTimes = {};  // In microseconds
+    std::array<double, MAX_FRAME_DELAY> cpuBegins = {};  // In microseconds, for trace captures
+    std::array<double, MAX_FRAME_DELAY> cpuTimes  = {};  // In microseconds
     std::array<double, MAX_FRAME_DELAY> gpuTimes = {};  // In microseconds
 
     // number of times summed since last reset
@@ -487,6 +568,51 @@ protected:
 
   void grow(std::vector<SectionData>& sections, size_t newSize, uint32_t averagingCount);
 
+  struct ThreadEvent
+  {
+    const char* name     = nullptr;
+    double      cpuBegin = 0;  // In microseconds
+    double      cpuTime  = 0;
+    uint32_t    level    = 0;
+  };
+
+  // Single producer (its thread), single consumer (`frameEnd`) ring
+  struct ThreadBuffer
+  {
+    static constexpr uint32_t CAPACITY  = 4096;  // events between two frame ends, more are dropped
+    static constexpr uint32_t MAX_LEVEL = 32;
+
+    std::string                        name;
+    std::array<ThreadEvent, CAPACITY>  events;
+    std::atomic<uint64_t>              head    = 0;  // written by the thread
+    std::atomic<uint64_t>              tail    = 0;  // written by the merge
+    std::atomic<uint32_t>              dropped = 0;
+    std::atomic<bool>                  exited  = false;  // the thread ended, reused once merged
+    std::array<ThreadEvent, MAX_LEVEL> open;  // sections begun and not ended, only used by the thread
+    uint32_t                           openCount = 0;
+  };
+
+  // frame sums per thread and name, guarded by m_threadStatsMutex
+  struct ThreadStats
+  {
+    uint32_t    thread    = 0;
+    std::string name      = {};
+    uint32_t    level     = 0;
+    double      frameTime = 0;
+    bool        inFrame   = false;
+    TimeValues  cpuTime;
+  };
+
+  struct CounterData
+  {
+    std::string name;
+    TimeValues  values;
+  };
+
+  ThreadBuffer* threadGetBuffer();
+  void          threadMerge(bool trace);
+  void          threadAppendSnapshot(Snapshot& snapShot) const;
+
   bool             m_inFrame = false;
   ProfilerManager* m_profiler{};
 
@@ -499,6 +625,18 @@ protected:
 
   AsyncData          m_async;
   mutable std::mutex m_asyncMutex;
+
+  uint64_t                                   m_uid = 0;  // identifies the timeline in the thread caches
+  std::vector<std::shared_ptr<ThreadBuffer>> m_threadBuffers;  // shared with the thread caches
+  mutable std::mutex                         m_threadBuffersMutex;  // registration and merge
+  std::vector<ThreadStats>                   m_threadStats;
+  mutable std::mutex                         m_threadStatsMutex;
+
+  std::vector<CounterData> m_counters;
+  mutable std::mutex       m_countersMutex;
+
+  // frames left to record in the trace capture of the ProfilerManager, 0 when not capturing
+  std::atomic<uint32_t> m_traceFramesLeft = 0;
 };
 
 class ProfilerManager
@@ -531,9 +669,56 @@ public:
   void getSnapshots(std::vector<ProfilerTimeline::Snapshot>& frameSnapshots,
                     std::vector<ProfilerTimeline::Snapshot>& asyncSnapshots) const;
 
+  //////////////////////////////////////////////////////////////////////////
+  // trace capture
+  // Records the frame sections of all timelines, frame by frame, for offline analysis
+  // with chrome://tracing or https://ui.perfetto.dev
+  // GPU sections are only placed on the timeline when their provider has a `frameBeginFunction`.
+
+  struct TraceEvent
+  {
+    std::string name;
+    std::string timeline;  // name of the ProfilerTimeline
+    std::string thread;    // per-thread sections: name of the thread, empty for the frame sections
+    uint32_t    frame = 0;
+    uint32_t    level = 0;  // 0 for the whole frame
+
+    // in microseconds, `getMicroseconds()` time
+    double cpuBegin    = 0;
+    double cpuDuration = 0;
+    double gpuBegin    = 0;
+    double gpuDuration = 0;
+    bool   hasGpu      = false;  // gpuDuration is valid
+    bool   hasGpuBegin = false;  // gpuBegin is valid
+  };
+
+  // Clears the previous capture, then records `frameCount` frames of each timeline,
+  // until `endTraceCapture` when 0.
+  void beginTraceCapture(uint32_t frameCount = 0);
+  void endTraceCapture();
+  bool isTraceCapturing() const { return m_traceCapturing; }
+
+  std::vector<TraceEvent> getTraceEvents() const;
+
+  // Chrome trace event format (JSON object format), one CPU and one GPU track per timeline,
+  // and one track per thread with per-thread sections
+  void appendTraceJson(std::string& json) const;
+  bool saveTraceJson(const std::filesystem::path& filename) const;
+
 protected:
+  friend class ProfilerTimeline;
+
+  // called by the timelines at `frameEnd`, `last` when the timeline recorded its last frame
+  void traceAddEvents(std::vector<TraceEvent>& events, bool last);
+
   std::list<std::unique_ptr<ProfilerTimeline>> m_timelines;
   mutable std::mutex                           m_mutex;
   PerformanceTimer                             m_timer;
+
+  std::atomic<bool>       m_traceCapturing    = false;
+  uint32_t                m_traceFrameCount   = 0;
+  uint32_t                m_traceTimelineLeft = 0;  // timelines that have frames left to record
+  std::vector<TraceEvent> m_traceEvents;
+  mutable std::mutex      m_traceMutex;
 };
 }  // namespace nvutils
@@ -22,6 +22,8 @@
 
 Utilities for working with SPIR-V data.
 
+The descriptor and push constant interface of modules is reflected by `nvvk::ShaderReflection`.
+
 */
 
 #include <filesystem>
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2022-2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "task_scheduler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace nvutils {
+
+namespace {
+// Identifies the scheduler and worker of the calling thread
+thread_local const TaskScheduler* s_threadScheduler = nullptr;
+thread_local uint32_t             s_threadIndex     = ~0u;
+}  // namespace
+
+TaskScheduler::TaskScheduler(uint32_t numThreads)
+{
+  if(numThreads == 0)
+  {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  m_queues.resize(numThreads + 1);
+  for(auto& queue : m_queues)
+  {
+    queue = std::make_unique<WorkQueue>();
+  }
+
+  m_workers.reserve(numThreads);
+  for(uint32_t t = 0; t < numThreads; t++)
+  {
+    m_workers.emplace_back(&TaskScheduler::workerLoop, this, t);
+  }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+  waitAll();
+  {
+    std::lock_guard lock(m_sleepMutex);
+    m_stop = true;
+  }
+  m_sleepCondition.notify_all();
+  for(std::thread& worker : m_workers)
+  {
+    worker.join();
+  }
+}
+
+uint32_t TaskScheduler::getThreadIndex() const
+{
+  return s_threadScheduler == this ? s_threadIndex : ~0u;
+}
+
+void TaskScheduler::addDependency(const TaskRef& task, const TaskRef& dependency)
+{
+  std::lock_guard lock(dependency->mutex);
+  if(!dependency->done.load(std::memory_order_relaxed))
+  {
+    task->pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+    dependency->continuations.push_back(task);
+  }
+}
+
+void TaskScheduler::releaseDependency(TaskRef task)
+{
+  if(task->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    schedule(std::move(task));
+  }
+}
+
+TaskScheduler::TaskRef TaskScheduler::run(std::function<void()> fn, std::span<const TaskRef> dependencies)
+{
+  TaskRef task = std::make_shared<Task>();
+  task->fn     = std::move(fn);
+  m_unfinishedCount.fetch_add(1, std::memory_order_relaxed);
+
+  for(const TaskRef& dependency : dependencies)
+  {
+    if(dependency)
+    {
+      addDependency(task, dependency);
+    }
+  }
+
+  // release the registration count, dependencies may all have finished meanwhile
+  releaseDependency(task);
+  return task;
+}
+
+TaskScheduler::TaskRef TaskScheduler::runLoop(uint64_t                      numItems,
+                                              std::function<void(uint64_t)> fn,
+                                              std::span<const TaskRef>      dependencies,
+                                              uint64_t                      batchSize)
+{
+  batchSize           = std::max(batchSize, uint64_t(1));
+  uint64_t numBatches = (numItems + batchSize - 1) / batchSize;
+
+  // the join task finishes the loop, its registration count is released by the spawn task
+  // once all batches are registered as its dependencies
+  TaskRef join = std::make_shared<Task>();
+  join->fn     = [] {};
+  m_unfinishedCount.fetch_add(1, std::memory_order_relaxed);
+
+  // the batches are spawned by a task, so they land in a worker deque and get stolen by the others
+  auto shared = std::make_shared<std::function<void(uint64_t)>>(std::move(fn));
+  run(
+      [this, shared, join, numItems, numBatches, batchSize] {
+        for(uint64_t b = 0; b < numBatches; b++)
+        {
+          TaskRef batch = run([shared, b, numItems, batchSize] {
+            uint64_t itemEnd = std::min((b + 1) * batchSize, numItems);
+            for(uint64_t itemIndex = b * batchSize; itemIndex < itemEnd; itemIndex++)
+            {
+              (*shared)(itemIndex);
+            }
+          });
+          addDependency(join, batch);
+        }
+        releaseDependency(join);
+      },
+      dependencies);
+
+  return join;
+}
+
+bool TaskScheduler::isDone(const TaskRef& task)
+{
+  return !task || task->done.load(std::memory_order_acquire);
+}
+
+void TaskScheduler::wait(const TaskRef& task)
+{
+  uint32_t idleCount = 0;
+  while(!isDone(task))
+  {
+    if(tryRunTask())
+    {
+      idleCount = 0;
+    }
+    else if(++idleCount < 64)
+    {
+      std::this_thread::yield();
+    }
+    else
+    {
+      // nothing to help with, the task runs on another thread
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+}
+
+void TaskScheduler::wait(std::span<const TaskRef> tasks)
+{
+  for(const TaskRef& task : tasks)
+  {
+    wait(task);
+  }
+}
+
+void TaskScheduler::waitAll()
+{
+  uint32_t idleCount = 0;
+  while(m_unfinishedCount.load(std::memory_order_acquire) != 0)
+  {
+    if(tryRunTask())
+    {
+      idleCount = 0;
+    }
+    else if(++idleCount < 64)
+    {
+      std::this_thread::yield();
+    }
+    else
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+}
+
+void TaskScheduler::schedule(TaskRef task)
+{
+  uint32_t   threadIndex = getThreadIndex();
+  WorkQueue& queue       = *m_queues[threadIndex == ~0u ? m_workers.size() : threadIndex];
+  {
+    std::lock_guard lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  m_queuedCount.fetch_add(1, std::memory_order_release);
+
+  // taking the lock orders the increment with a worker going to sleep
+  {
+    std::lock_guard lock(m_sleepMutex);
+  }
+  m_sleepCondition.notify_one();
+}
+
+TaskScheduler::TaskRef TaskScheduler::popTask(uint32_t threadIndex)
+{
+  const uint32_t numQueues = uint32_t(m_queues.size());
+
+  // own deque first, newest task
+  if(threadIndex != ~0u)
+  {
+    WorkQueue&      queue = *m_queues[threadIndex];
+    std::lock_guard lock(queue.mutex);
+    if(!queue.tasks.empty())
+    {
+      TaskRef task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      return task;
+    }
+  }
+
+  // steal the oldest task of the others, including the injection queue,
+  // starting after the own index so thieves spread over the victims
+  uint32_t start = threadIndex == ~0u ? 0 : threadIndex + 1;
+  for(uint32_t i = 0; i < numQueues; i++)
+  {
+    uint32_t victim = (start + i) % numQueues;
+    if(victim == threadIndex)
+      continue;
+
+    WorkQueue&      queue = *m_queues[victim];
+    std::lock_guard lock(queue.mutex);
+    if(!queue.tasks.empty())
+    {
+      TaskRef task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      return task;
+    }
+  }
+
+  return nullptr;
+}
+
+bool TaskScheduler::tryRunTask()
+{
+  if(m_queuedCount.load(std::memory_order_acquire) == 0)
+    return false;
+
+  TaskRef task = popTask(getThreadIndex());
+  if(!task)
+    return false;
+
+  execute(std::move(task));
+  return true;
+}
+
+void TaskScheduler::execute(TaskRef task)
+{
+  m_queuedCount.fetch_sub(1, std::memory_order_relaxed);
+
+  task->fn();
+  task->fn = nullptr;
+
+  std::vector<TaskRef> continuations;
+  {
+    std::lock_guard lock(task->mutex);
+    task->done.store(true, std::memory_order_release);
+    continuations.swap(task->continuations);
+  }
+
+  for(TaskRef& continuation : continuations)
+  {
+    releaseDependency(std::move(continuation));
+  }
+
+  m_unfinishedCount.fetch_sub(1, std::memory_order_release);
+}
+
+void TaskScheduler::workerLoop(uint32_t threadIndex)
+{
+  s_threadScheduler = this;
+  s_threadIndex     = threadIndex;
+
+  while(true)
+  {
+    if(tryRunTask())
+      continue;
+
+    std::unique_lock lock(m_sleepMutex);
+    m_sleepCondition.wait(lock, [&] { return m_stop || m_queuedCount.load(std::memory_order_acquire) != 0; });
+    if(m_stop)
+      return;
+  }
+}
+
+TaskScheduler& get_task_scheduler()
+{
+  static TaskScheduler scheduler;
+  return scheduler;
+}
+
+}  // namespace nvutils
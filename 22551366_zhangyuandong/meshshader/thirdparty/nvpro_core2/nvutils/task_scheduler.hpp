@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2022-2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace nvutils {
+/*-------------------------------------------------------------------------------------------------
+Task graph scheduler with continuations, complementing the fork-join loops of parallel_work.hpp.
+
+A task runs once all of its dependencies have finished. Tasks are executed by a set of worker
+threads, each owning a deque: a worker pushes and pops the tasks it spawns at the back
+(depth-first, cache friendly), idle workers steal from the front of the other deques.
+Tasks submitted from outside the workers go to a shared injection queue.
+
+`wait` does not block idly: the waiting thread executes pending tasks until the awaited
+one has finished, so it is safe to wait from within a task.
+
+```cpp
+nvutils::TaskScheduler& scheduler = nvutils::get_task_scheduler();
+
+// pipeline the load phases of each asset, assets progress independently
+std::vector<nvutils::TaskScheduler::TaskRef> uploads;
+for(Asset& asset : assets)
+{
+  auto read   = scheduler.run([&] { asset.read(); });
+  auto decode = scheduler.runLoop(asset.imageCount, [&](uint64_t i) { asset.decode(i); }, {&read, 1});
+  uploads.push_back(scheduler.then(decode, [&] { asset.upload(); }));
+}
+
+// a task depending on all uploads, the caller is not blocked
+auto done = scheduler.run([&] { LOGI("all loaded\n"); }, uploads);
+...
+scheduler.wait(done);
+```
+
+Tasks must not throw. Captured references must outlive the task.
+-------------------------------------------------------------------------------------------------*/
+class TaskScheduler
+{
+public:
+  struct Task;
+  using TaskRef = std::shared_ptr<Task>;
+
+  // 0 uses std::thread::hardware_concurrency() workers
+  explicit TaskScheduler(uint32_t numThreads = 0);
+  // waits for all submitted tasks
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler&)            = delete;
+  TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+  // Runs `fn` once all `dependencies` have finished, immediately if there are none.
+  // Dependencies may be null or already finished.
+  TaskRef run(std::function<void()> fn, std::span<const TaskRef> dependencies = {});
+
+  // Continuation, runs `fn` after `task`
+  TaskRef then(const TaskRef& task, std::function<void()> fn) { return run(std::move(fn), {&task, 1}); }
+
+  // Runs `fn(itemIndex)` for all items in [0, numItems) after `dependencies`, split into tasks of `batchSize` items.
+  // The returned task finishes once all items are done.
+  TaskRef runLoop(uint64_t                      numItems,
+                  std::function<void(uint64_t)> fn,
+                  std::span<const TaskRef>      dependencies = {},
+                  uint64_t                      batchSize    = 1);
+
+  static bool isDone(const TaskRef& task);
+
+  // Executes pending tasks until `task` has finished
+  void wait(const TaskRef& task);
+  void wait(std::span<const TaskRef> tasks);
+  // Executes pending tasks until all submitted tasks have finished
+  void waitAll();
+
+  uint32_t getThreadCount() const { return uint32_t(m_workers.size()); }
+
+  // Index of the calling worker thread in [0, getThreadCount()), ~0 for threads outside this scheduler
+  uint32_t getThreadIndex() const;
+
+  struct Task
+  {
+    std::function<void()> fn;
+    // unfinished dependencies, +1 while `run` registers them
+    std::atomic_uint32_t pendingDependencies{1};
+    std::atomic_bool     done{false};
+
+    // tasks to notify on completion, guarded by `mutex` until `done`
+    std::mutex           mutex;
+    std::vector<TaskRef> continuations;
+  };
+
+private:
+  struct WorkQueue
+  {
+    std::mutex          mutex;
+    std::deque<TaskRef> tasks;
+  };
+
+  // registers `task` as continuation of `dependency` unless that one has finished
+  static void addDependency(const TaskRef& task, const TaskRef& dependency);
+  // schedules `task` when this was its last pending dependency
+  void releaseDependency(TaskRef task);
+
+  void    schedule(TaskRef task);
+  TaskRef popTask(uint32_t threadIndex);
+  // runs one pending task, returns false if there was none
+  bool tryRunTask();
+  void execute(TaskRef task);
+  void workerLoop(uint32_t threadIndex);
+
+  // one queue per worker, the last one is the injection queue for external threads
+  std::vector<std::unique_ptr<WorkQueue>> m_queues;
+  std::vector<std::thread>                m_workers;
+
+  // tasks that are scheduled but not started, to put idle workers to sleep
+  std::atomic_uint32_t m_queuedCount{0};
+  // tasks that are submitted but not finished, for `waitAll`
+  std::atomic_uint32_t m_unfinishedCount{0};
+
+  std::mutex              m_sleepMutex;
+  std::condition_variable m_sleepCondition;
+  bool                    m_stop = false;
+};
+
+// Default scheduler, using as many workers as hardware threads
+TaskScheduler& get_task_scheduler();
+
+}  // namespace nvutils
@@ -19,14 +19,17 @@
 
 
 #include <assert.h>
+#include <chrono>
 
 #include <nvutils/alignment.hpp>
+#include <nvutils/logger.hpp>
 #include <nvvk/check_error.hpp>
 #include <fmt/format.h>
 
 #include "acceleration_structures.hpp"
 #include "debug_util.hpp"
 #include "commands.hpp"
+#include "semaphore.hpp"
 
 namespace nvvk {
 
@@ -317,7 +320,8 @@ VkResult AccelerationStructureBuilder::cmdBuildAccelerationStructures(VkCommandB
       break;
 
     // Create and store acceleration structure
-    NVVK_FAIL_RETURN(m_alloc->createAcceleration(blasAccel[m_currentBlasIdx], createInfo));
+    const VmaAllocationCreateInfo allocInfo{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE};
+    NVVK_FAIL_RETURN(m_alloc->createAcceleration(blasAccel[m_currentBlasIdx], createInfo, allocInfo, m_queueFamilies));
     NVVK_DBG_NAME(blasAccel[m_currentBlasIdx].accel);
     collectedAccel.push_back(blasAccel[m_currentBlasIdx].accel);
 
@@ -427,7 +431,8 @@ VkResult AccelerationStructureBuilder::cmdCompactBlas(VkCommandBuffer
         VkAccelerationStructureCreateInfoKHR asCreateInfo{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR};
         asCreateInfo.size = compactSize;
         asCreateInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
-        NVVK_FAIL_RETURN(m_alloc->createAcceleration(blasAccel[blasIdx], asCreateInfo));
+        const VmaAllocationCreateInfo allocInfo{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE};
+        NVVK_FAIL_RETURN(m_alloc->createAcceleration(blasAccel[blasIdx], asCreateInfo, allocInfo, m_queueFamilies));
         NVVK_DBG_NAME(blasAccel[blasIdx].accel);
 
         // Command to copy the original BLAS to the newly created compacted version.
@@ -509,14 +514,289 @@ std::string AccelerationStructureBuilder::Stats::toString() const
   const VkDeviceSize savedSize = totalOriginalSize - totalCompactSize;
   const float fractionSmaller  = (totalOriginalSize == 0) ? 0.0f : savedSize / static_cast<float>(totalOriginalSize);
 
-  const std::string output = fmt::format("BLAS Compaction: {} bytes -> {} bytes ({} bytes saved, {:.2f}% smaller)",
-                                         totalOriginalSize, totalCompactSize, savedSize, fractionSmaller * 100.0f);
+  std::string output = fmt::format("BLAS Compaction: {} bytes -> {} bytes ({} bytes saved, {:.2f}% smaller)",
+                                   totalOriginalSize, totalCompactSize, savedSize, fractionSmaller * 100.0f);
+
+  if(buildTimeMs > 0)
+  {
+    const double seconds = buildTimeMs / 1000.0;
+    output += fmt::format("\nBLAS Build: {} BLAS in {} batches, {:.2f} ms ({:.0f} BLAS/s, {:.1f} MB/s)", blasCount,
+                          batchCount, buildTimeMs, blasCount / seconds, double(totalBuildSize) / (1024.0 * 1024.0) / seconds);
+  }
 
   return output;
 }
 
 //////////////////////////////////////////////////////////////////////////
 
+VkResult AccelerationStructurePipelinedBuilder::init(ResourceAllocator*        allocator,
+                                                     const QueueInfo&          queueInfo,
+                                                     std::span<const uint32_t> sharingQueueFamilies,
+                                                     VkDeviceSize              hintMaxScratchSize)
+{
+  assert(m_cmdPool == VK_NULL_HANDLE && "init() called multiple times");
+
+  m_alloc         = allocator;
+  m_device        = allocator->getDevice();
+  m_queueInfo     = queueInfo;
+  m_scratchBudget = hintMaxScratchSize;
+  m_value         = 0;
+  m_sharingQueueFamilies.assign(sharingQueueFamilies.begin(), sharingQueueFamilies.end());
+
+  const VkCommandPoolCreateInfo poolCreateInfo{
+      .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+      .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+      .queueFamilyIndex = queueInfo.familyIndex,
+  };
+  NVVK_FAIL_RETURN(vkCreateCommandPool(m_device, &poolCreateInfo, nullptr, &m_cmdPool));
+  NVVK_DBG_NAME(m_cmdPool);
+  NVVK_FAIL_RETURN(createTimelineSemaphore(m_device, 0, m_semaphore));
+  NVVK_DBG_NAME(m_semaphore);
+
+  return VK_SUCCESS;
+}
+
+void AccelerationStructurePipelinedBuilder::deinit()
+{
+  if(m_cmdPool == VK_NULL_HANDLE)
+  {
+    return;
+  }
+
+  const VkSemaphoreWaitInfo waitInfo{
+      .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .semaphoreCount = 1,
+      .pSemaphores    = &m_semaphore,
+      .pValues        = &m_value,
+  };
+  NVVK_CHECK(vkWaitSemaphores(m_device, &waitInfo, ~0ULL));
+
+  m_builder.deinit();
+  for(nvvk::Buffer& scratch : m_scratchBuffers)
+  {
+    m_alloc->destroyBuffer(scratch);
+  }
+  vkDestroyCommandPool(m_device, m_cmdPool, nullptr);
+  vkDestroySemaphore(m_device, m_semaphore, nullptr);
+
+  m_cmdPool   = VK_NULL_HANDLE;
+  m_semaphore = VK_NULL_HANDLE;
+  m_pendingCommands.clear();
+  m_sharingQueueFamilies.clear();
+  m_alloc  = nullptr;
+  m_device = VK_NULL_HANDLE;
+}
+
+uint64_t AccelerationStructurePipelinedBuilder::getCompletedValue() const
+{
+  uint64_t value = 0;
+  NVVK_CHECK(vkGetSemaphoreCounterValue(m_device, m_semaphore, &value));
+  return value;
+}
+
+VkResult AccelerationStructurePipelinedBuilder::beginCommandBuffer(VkCommandBuffer& cmd)
+{
+  const VkCommandBufferAllocateInfo allocInfo{
+      .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool        = m_cmdPool,
+      .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+  };
+  NVVK_FAIL_RETURN(vkAllocateCommandBuffers(m_device, &allocInfo, &cmd));
+
+  const VkCommandBufferBeginInfo beginInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  return vkBeginCommandBuffer(cmd, &beginInfo);
+}
+
+// Submits `cmd` signaling the next timeline value. A non-zero `waitValue` makes the
+// acceleration structure work wait for that earlier submit of the same queue.
+VkResult AccelerationStructurePipelinedBuilder::submit(VkCommandBuffer cmd, uint64_t waitValue)
+{
+  NVVK_FAIL_RETURN(vkEndCommandBuffer(cmd));
+
+  const VkSemaphoreSubmitInfo waitInfo{
+      .sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .semaphore = m_semaphore,
+      .value     = waitValue,
+      .stageMask = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_COPY_BIT_KHR,
+  };
+  const VkSemaphoreSubmitInfo signalInfo{
+      .sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .semaphore = m_semaphore,
+      .value     = m_value + 1,
+      .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+  };
+  const VkCommandBufferSubmitInfo cmdInfo{
+      .sType         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+      .commandBuffer = cmd,
+  };
+  const VkSubmitInfo2 submitInfo{
+      .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+      .waitSemaphoreInfoCount   = waitValue ? 1u : 0u,
+      .pWaitSemaphoreInfos      = &waitInfo,
+      .commandBufferInfoCount   = 1,
+      .pCommandBufferInfos      = &cmdInfo,
+      .signalSemaphoreInfoCount = 1,
+      .pSignalSemaphoreInfos    = &signalInfo,
+  };
+  NVVK_FAIL_RETURN(vkQueueSubmit2(m_queueInfo.queue, 1, &submitInfo, VK_NULL_HANDLE));
+
+  m_value++;
+  m_pendingCommands.push_back({cmd, m_value});
+
+  return VK_SUCCESS;
+}
+
+VkResult AccelerationStructurePipelinedBuilder::releaseCommandBuffers()
+{
+  const uint64_t completed = getCompletedValue();
+  while(!m_pendingCommands.empty() && m_pendingCommands.front().value <= completed)
+  {
+    vkFreeCommandBuffers(m_device, m_cmdPool, 1, &m_pendingCommands.front().cmd);
+    m_pendingCommands.pop_front();
+  }
+  return VK_SUCCESS;
+}
+
+VkResult AccelerationStructurePipelinedBuilder::buildBlas(std::span<AccelerationStructureBuildData> blasBuildData,
+                                                          std::span<AccelerationStructure>          blasAccel,
+                                                          VkDeviceSize                              hintMaxBudget)
+{
+  assert(m_cmdPool && "Missing init()");
+  assert(blasBuildData.size() == blasAccel.size());
+
+  const auto startTime = std::chrono::steady_clock::now();
+
+  AccelerationStructureBuilder& builder = m_builder;
+  builder.deinit();
+  builder.init(m_alloc);
+  builder.setQueueFamilies(m_sharingQueueFamilies);
+
+  // each of the two batches in flight gets half of the scratch budget
+  const VkDeviceSize scratchSize = builder.getScratchSize(m_scratchBudget / 2, blasBuildData);
+  for(nvvk::Buffer& scratch : m_scratchBuffers)
+  {
+    if(scratch.bufferSize < scratchSize)
+    {
+      m_alloc->destroyBuffer(scratch);
+      NVVK_FAIL_RETURN(m_alloc->createBuffer(scratch, scratchSize,
+                                             VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT
+                                                 | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR,
+                                             VMA_MEMORY_USAGE_AUTO, {}, builder.getScratchAlignment()));
+      NVVK_DBG_NAME(scratch.buffer);
+    }
+  }
+
+  bool compaction = false;
+  m_stats         = {};
+  for(const AccelerationStructureBuildData& data : blasBuildData)
+  {
+    compaction = compaction || data.hasCompactFlag();
+    m_stats.totalBuildSize += data.sizeInfo.accelerationStructureSize;
+  }
+
+  std::array<uint64_t, 2> scratchValues{};     // last build using each scratch buffer
+  std::deque<uint64_t>    compactionPending;   // builds whose compaction is not submitted yet
+  uint64_t                lastCompactValue{};  // last compaction, guards the non-compacted BLAS
+  uint32_t                scratchIndex{};
+  bool                    finished{};
+
+  while(!finished || !compactionPending.empty())
+  {
+    NVVK_FAIL_RETURN(releaseCommandBuffers());
+
+    if(!finished)
+    {
+      VkCommandBuffer cmd{};
+      NVVK_FAIL_RETURN(beginCommandBuffer(cmd));
+
+      const nvvk::Buffer& scratch = m_scratchBuffers[scratchIndex];
+      VkResult result = builder.cmdCreateBlas(cmd, blasBuildData, blasAccel, scratch.address, scratch.bufferSize, hintMaxBudget);
+      if(result != VK_SUCCESS && result != VK_INCOMPLETE)
+      {
+        return result;
+      }
+      finished = result == VK_SUCCESS;
+
+      // only the build that used the same scratch buffer must have completed
+      NVVK_FAIL_RETURN(submit(cmd, scratchValues[scratchIndex]));
+      scratchValues[scratchIndex] = m_value;
+      scratchIndex                = (scratchIndex + 1) % 2;
+      m_stats.batchCount++;
+
+      if(compaction)
+      {
+        compactionPending.push_back(m_value);
+      }
+    }
+
+    if(!compactionPending.empty())
+    {
+      // don't stall while another build can be queued
+      uint64_t completed = getCompletedValue();
+      if(completed < compactionPending.front() && (finished || compactionPending.size() > 1))
+      {
+        const VkSemaphoreWaitInfo waitInfo{
+            .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .semaphoreCount = 1,
+            .pSemaphores    = &m_semaphore,
+            .pValues        = &compactionPending.front(),
+        };
+        NVVK_FAIL_RETURN(vkWaitSemaphores(m_device, &waitInfo, ~0ULL));
+        completed = compactionPending.front();
+      }
+
+      if(completed >= compactionPending.front())
+      {
+        // the previous compaction copies are done, their sources can go
+        if(lastCompactValue && completed >= lastCompactValue)
+        {
+          builder.destroyNonCompactedBlas();
+        }
+
+        // query results are available, the build completed
+        VkCommandBuffer cmd{};
+        NVVK_FAIL_RETURN(beginCommandBuffer(cmd));
+        VkResult result = builder.cmdCompactBlas(cmd, blasBuildData, blasAccel);
+        if(result != VK_SUCCESS && result != VK_INCOMPLETE)
+        {
+          return result;
+        }
+        NVVK_FAIL_RETURN(submit(cmd, 0));
+        lastCompactValue = m_value;
+        compactionPending.pop_front();
+      }
+    }
+  }
+
+  // wait for the last submit, then everything can be cleaned up
+  const VkSemaphoreWaitInfo waitInfo{
+      .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .semaphoreCount = 1,
+      .pSemaphores    = &m_semaphore,
+      .pValues        = &m_value,
+  };
+  NVVK_FAIL_RETURN(vkWaitSemaphores(m_device, &waitInfo, ~0ULL));
+  NVVK_FAIL_RETURN(releaseCommandBuffers());
+
+  builder.destroyNonCompactedBlas();
+
+  AccelerationStructureBuilder::Stats compactStats = builder.getStatistics();
+  m_stats.totalOriginalSize                        = compactStats.totalOriginalSize;
+  m_stats.totalCompactSize                         = compactStats.totalCompactSize;
+  m_stats.blasCount                                = static_cast<uint32_t>(blasBuildData.size());
+  m_stats.buildTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+  builder.deinit();
+
+  return VK_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 // Returns the maximum scratch buffer size needed for building all provided acceleration structures.
 // This function iterates through a vector of AccelerationStructureBuildData, comparing the scratch
 // size required for each structure and returns the largest value found.
@@ -780,3 +1060,29 @@ void AccelerationStructureHelper::tlasSubmitUpdateAndWait(const std::vector<VkAc
 }
 
 }  // namespace nvvk
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_AccelerationStructurePipelinedBuilder()
+{
+  nvvk::ResourceAllocator* allocator{};
+  nvvk::QueueInfo          computeQueue{};   // async compute queue
+  nvvk::QueueInfo          graphicsQueue{};  // queue using the BLAS (TLAS build and ray tracing)
+
+  std::vector<nvvk::AccelerationStructureBuildData> blasBuildData;  // filled and finalized with compaction flag
+  std::vector<nvvk::AccelerationStructure>          blasAccel(blasBuildData.size());
+
+  // BLAS are used from the graphics queue family as well
+  const uint32_t queueFamilies[] = {computeQueue.familyIndex, graphicsQueue.familyIndex};
+  const bool     sameFamily      = computeQueue.familyIndex == graphicsQueue.familyIndex;
+
+  nvvk::AccelerationStructurePipelinedBuilder builder;
+  NVVK_CHECK(builder.init(allocator, computeQueue, sameFamily ? std::span<const uint32_t>() : queueFamilies));
+
+  // typically run from a loading thread, the graphics queue is not blocked meanwhile
+  NVVK_CHECK(builder.buildBlas(blasBuildData, blasAccel));
+  LOGI("%s\n", builder.getStatistics().toString().c_str());
+
+  builder.deinit();
+}
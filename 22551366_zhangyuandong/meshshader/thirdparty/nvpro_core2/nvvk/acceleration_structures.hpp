@@ -18,7 +18,10 @@
  */
 
 #pragma once
+#include <array>
 #include <cassert>
+#include <deque>
+#include <span>
 #include <string>
 #include <sstream>
 #include <queue>
@@ -183,6 +186,12 @@ public:
     VkDeviceSize totalOriginalSize = 0;
     VkDeviceSize totalCompactSize  = 0;
 
+    // filled by AccelerationStructurePipelinedBuilder
+    uint32_t     blasCount      = 0;
+    uint32_t     batchCount     = 0;
+    VkDeviceSize totalBuildSize = 0;  // sum of acceleration structure sizes before compaction
+    double       buildTimeMs    = 0;  // from first submit to completion of the last compaction
+
     std::string toString() const;
   };
 
@@ -231,6 +240,14 @@ public:
   // Get the minimum offset alignment of the scratch buffer
   VkDeviceSize getScratchAlignment() const { return m_scratchAlignment; }
 
+  // Queue families the acceleration structures are shared between (VK_SHARING_MODE_CONCURRENT),
+  // required when they are built on another queue family than the one using them.
+  // Empty by default, meaning exclusive to a single queue family.
+  void setQueueFamilies(std::span<const uint32_t> queueFamilies)
+  {
+    m_queueFamilies.assign(queueFamilies.begin(), queueFamilies.end());
+  }
+
 private:
   AccelerationStructureBuilder& operator=(const AccelerationStructureBuilder&) = default;
 
@@ -263,11 +280,85 @@ private:
   std::queue<CompactBatchInfo> m_batches;             // Queue of compact batches to be processed
 
   std::vector<nvvk::AccelerationStructure> m_cleanupBlasAccel;  // List of BLAS to be cleaned up
+  std::vector<uint32_t>                    m_queueFamilies;     // Queue families for concurrent sharing
 
   // Stats
   Stats m_stats;  // Statistics about the compacted BLAS
 };
 
+/*-------------------------------------------------------------------------------------------------
+
+ Builds and compacts BLAS on a dedicated (typically async compute) queue without idling between batches.
+
+ The loop described for `AccelerationStructureBuilder` waits for each batch's build before
+ compacting it. Here the batches are chained with a timeline semaphore instead:
+  - batch N+1 is submitted while batch N builds, each using its own half of the scratch memory
+  - the compacted sizes of batch N are read once its build signaled, and its compaction is
+    submitted behind the build of batch N+1
+  - the non-compacted BLAS are destroyed once the compaction copies completed
+
+ `buildBlas` returns once all BLAS are built and compacted, it can be run from a worker thread
+ while the main queue keeps rendering (the queue must not be used by another thread meanwhile).
+ When the BLAS are used by another queue family, list both in `init` so they are created
+ with concurrent sharing.
+
+ Usage:
+      see usage_AccelerationStructurePipelinedBuilder in acceleration_structures.cpp
+
+ --------------------------------------------------------------------------------------------------- */
+class AccelerationStructurePipelinedBuilder
+{
+public:
+  AccelerationStructurePipelinedBuilder()                                             = default;
+  AccelerationStructurePipelinedBuilder(const AccelerationStructurePipelinedBuilder&) = delete;
+  AccelerationStructurePipelinedBuilder& operator=(const AccelerationStructurePipelinedBuilder&) = delete;
+
+  ~AccelerationStructurePipelinedBuilder() { assert(m_cmdPool == VK_NULL_HANDLE && "Missing deinit()"); }
+
+  VkResult init(nvvk::ResourceAllocator*  allocator,
+                const nvvk::QueueInfo&    queueInfo,
+                std::span<const uint32_t> sharingQueueFamilies = {},
+                VkDeviceSize              hintMaxScratchSize   = 128'000'000);
+  void     deinit();
+
+  // Builds all BLAS, and compacts those with VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR.
+  // `hintMaxBudget` is the ceiling for the sum of acceleration structure sizes of one batch.
+  VkResult buildBlas(std::span<AccelerationStructureBuildData> blasBuildData,
+                     std::span<nvvk::AccelerationStructure>    blasAccel,
+                     VkDeviceSize                              hintMaxBudget = 512'000'000);
+
+  // Statistics of the last `buildBlas`
+  AccelerationStructureBuilder::Stats getStatistics() const { return m_stats; }
+
+private:
+  VkResult beginCommandBuffer(VkCommandBuffer& cmd);
+  VkResult submit(VkCommandBuffer cmd, uint64_t waitValue);
+  VkResult releaseCommandBuffers();
+  uint64_t getCompletedValue() const;
+
+  nvvk::ResourceAllocator* m_alloc{};
+  VkDevice                 m_device{};
+  nvvk::QueueInfo          m_queueInfo{};
+  VkCommandPool            m_cmdPool{};
+  VkSemaphore              m_semaphore{};  // timeline, signaled by every submit
+  uint64_t                 m_value{};      // last signaled value
+  VkDeviceSize             m_scratchBudget{};
+  std::vector<uint32_t>    m_sharingQueueFamilies;
+
+  std::array<nvvk::Buffer, 2> m_scratchBuffers{};  // batches alternate between the two
+
+  AccelerationStructureBuilder m_builder;
+
+  struct PendingCommands
+  {
+    VkCommandBuffer cmd{};
+    uint64_t        value{};
+  };
+  std::deque<PendingCommands> m_pendingCommands;
+
+  AccelerationStructureBuilder::Stats m_stats;
+};
+
 // Helper class for building both Bottom-Level Acceleration Structures (BLAS) and
 // Top-Level Acceleration Structures (TLAS). This utility
 // abstracts the complexity of acceleration structure generation while allowing
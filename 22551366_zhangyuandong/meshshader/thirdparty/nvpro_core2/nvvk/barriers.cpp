@@ -117,4 +117,79 @@ void BarrierContainer::clear()
   imageBarriers.clear();
 }
 
+void BarrierContainer::appendMemoryBarrier(VkPipelineStageFlags2 srcStageMask,
+                                           VkPipelineStageFlags2 dstStageMask,
+                                           VkAccessFlags2        srcAccessMask /* = INFER_BARRIER_PARAMS */,
+                                           VkAccessFlags2        dstAccessMask /* = INFER_BARRIER_PARAMS */)
+{
+  const VkMemoryBarrier2 barrier = makeMemoryBarrier(srcStageMask, dstStageMask, srcAccessMask, dstAccessMask);
+  if(memoryBarriers.empty())
+  {
+    memoryBarriers.push_back(barrier);
+    return;
+  }
+
+  VkMemoryBarrier2& merged = memoryBarriers.front();
+  merged.srcStageMask |= barrier.srcStageMask;
+  merged.srcAccessMask |= barrier.srcAccessMask;
+  merged.dstStageMask |= barrier.dstStageMask;
+  merged.dstAccessMask |= barrier.dstAccessMask;
+}
+
+void BarrierContainer::appendBufferMemoryBarrier(const BufferMemoryBarrierParams& params)
+{
+  const VkBufferMemoryBarrier2 barrier = makeBufferMemoryBarrier(params);
+  for(VkBufferMemoryBarrier2& merged : bufferBarriers)
+  {
+    if(merged.buffer == barrier.buffer && merged.offset == barrier.offset && merged.size == barrier.size
+       && merged.srcQueueFamilyIndex == barrier.srcQueueFamilyIndex && merged.dstQueueFamilyIndex == barrier.dstQueueFamilyIndex)
+    {
+      merged.srcStageMask |= barrier.srcStageMask;
+      merged.srcAccessMask |= barrier.srcAccessMask;
+      merged.dstStageMask |= barrier.dstStageMask;
+      merged.dstAccessMask |= barrier.dstAccessMask;
+      return;
+    }
+  }
+  bufferBarriers.push_back(barrier);
+}
+
+void BarrierContainer::appendImageMemoryBarrier(const ImageMemoryBarrierParams& params)
+{
+  const VkImageMemoryBarrier2 barrier = makeImageMemoryBarrier(params);
+  for(VkImageMemoryBarrier2& merged : imageBarriers)
+  {
+    const VkImageSubresourceRange& a = merged.subresourceRange;
+    const VkImageSubresourceRange& b = barrier.subresourceRange;
+    if(merged.image == barrier.image && merged.oldLayout == barrier.oldLayout && merged.newLayout == barrier.newLayout
+       && a.aspectMask == b.aspectMask && a.baseMipLevel == b.baseMipLevel && a.levelCount == b.levelCount
+       && a.baseArrayLayer == b.baseArrayLayer && a.layerCount == b.layerCount
+       && merged.srcQueueFamilyIndex == barrier.srcQueueFamilyIndex && merged.dstQueueFamilyIndex == barrier.dstQueueFamilyIndex)
+    {
+      merged.srcStageMask |= barrier.srcStageMask;
+      merged.srcAccessMask |= barrier.srcAccessMask;
+      merged.dstStageMask |= barrier.dstStageMask;
+      merged.dstAccessMask |= barrier.dstAccessMask;
+      return;
+    }
+  }
+  imageBarriers.push_back(barrier);
+}
+
+void BarrierContainer::appendImageMemoryBarrier(nvvk::Image& image, const ImageMemoryBarrierParams& params)
+{
+  if(image.descriptor.imageLayout == params.newLayout && params.srcStageMask == INFER_BARRIER_PARAMS
+     && params.dstStageMask == INFER_BARRIER_PARAMS)
+  {
+    return;
+  }
+
+  ImageMemoryBarrierParams localParams = params;
+  localParams.image                    = image.image;
+  localParams.oldLayout                = image.descriptor.imageLayout;
+  appendImageMemoryBarrier(localParams);
+
+  image.descriptor.imageLayout = params.newLayout;
+}
+
 }  // namespace nvvk
@@ -41,6 +41,9 @@
 //
 // * BarrierContainer can be used to batch together multiple pipeline barriers,
 // or to also automatically update nvvk::Image::descriptor::imageLayout.
+// The append* functions merge the barriers that can be merged, and `cmdFlush`
+// records them with a single vkCmdPipelineBarrier2, typically right before the
+// next draw or dispatch.
 //
 // Constexpr functions are in this header file so that structs can be
 // determined at compile-time; `cmd` functions are in the source file.
@@ -312,6 +315,35 @@ public:
 
   // Clears all vectors.
   void clear();
+
+  // The barriers of a batch are executed together and don't order against each other:
+  // only batch barriers that have no dependent command recorded between them.
+
+  // Global memory barriers are merged into a single one, combining their masks
+  void appendMemoryBarrier(VkPipelineStageFlags2 srcStageMask,
+                           VkPipelineStageFlags2 dstStageMask,
+                           VkAccessFlags2        srcAccessMask = INFER_BARRIER_PARAMS,
+                           VkAccessFlags2        dstAccessMask = INFER_BARRIER_PARAMS);
+
+  // Merged with a previous barrier on the same buffer range and queue families
+  void appendBufferMemoryBarrier(const BufferMemoryBarrierParams& params);
+
+  // Merged with a previous barrier on the same image, subresource range and layouts
+  void appendImageMemoryBarrier(const ImageMemoryBarrierParams& params);
+
+  // Like cmdImageMemoryBarrier with an nvvk::Image: the old layout is the one tracked in
+  // image.descriptor.imageLayout, which is updated. A transition to the current layout
+  // without explicit stages is redundant and dropped.
+  void appendImageMemoryBarrier(nvvk::Image& image, const ImageMemoryBarrierParams& params);
+
+  bool empty() const { return memoryBarriers.empty() && bufferBarriers.empty() && imageBarriers.empty(); }
+
+  // Submits all barriers and clears them
+  void cmdFlush(VkCommandBuffer cmd, VkDependencyFlags dependencyFlags = 0)
+  {
+    cmdPipelineBarrier(cmd, dependencyFlags);
+    clear();
+  }
 };
 
 }  // namespace nvvk
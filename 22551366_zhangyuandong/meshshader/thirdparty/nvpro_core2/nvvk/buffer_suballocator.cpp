@@ -17,12 +17,17 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 
+#include "barriers.hpp"
 #include "check_error.hpp"
 #include "debug_util.hpp"
 #include "buffer_suballocator.hpp"
 
+#include <nvutils/parallel_work.hpp>
+
 namespace nvvk {
 
 BufferSubAllocator::~BufferSubAllocator()
@@ -37,6 +42,7 @@ BufferSubAllocator::BufferSubAllocator(BufferSubAllocator&& other) noexcept
   std::swap(m_info, other.m_info);
   std::swap(m_state.internalBlockUnits, other.m_state.internalBlockUnits);
   std::swap(m_state.maxBlocks, other.m_state.maxBlocks);
+  std::swap(m_defragFrees, other.m_defragFrees);
 }
 
 BufferSubAllocator& BufferSubAllocator::operator=(BufferSubAllocator&& other) noexcept
@@ -50,6 +56,7 @@ BufferSubAllocator& BufferSubAllocator::operator=(BufferSubAllocator&& other) no
     std::swap(m_info, other.m_info);
     std::swap(m_state.internalBlockUnits, other.m_state.internalBlockUnits);
     std::swap(m_state.maxBlocks, other.m_state.maxBlocks);
+    std::swap(m_defragFrees, other.m_defragFrees);
   }
 
   return *this;
@@ -110,6 +117,7 @@ void BufferSubAllocator::deinit()
   m_state = {};
   m_blocks.clear();
   m_blocks.shrink_to_fit();
+  m_defragFrees.clear();
 }
 
 BufferSubAllocator::Report BufferSubAllocator::getReport() const
@@ -157,6 +165,11 @@ uint32_t BufferSubAllocator::acquireBlockIndex()
 }
 
 VkResult BufferSubAllocator::subAllocate(BufferSubAllocation& subAllocation, VkDeviceSize size, uint32_t alignment)
+{
+  return subAllocateInternal(subAllocation, size, alignment, true);
+}
+
+VkResult BufferSubAllocator::subAllocateInternal(BufferSubAllocation& subAllocation, VkDeviceSize size, uint32_t alignment, bool allowNewBlock)
 {
   subAllocation = {};
 
@@ -171,8 +184,6 @@ VkResult BufferSubAllocator::subAllocate(BufferSubAllocation& subAllocation, VkD
     return VK_ERROR_OUT_OF_DEVICE_MEMORY;
   }
 
-  m_state.allocatedSize += size;
-
   // if large use a dedicated block
   if(size >= m_info.blockSize)
   {
@@ -213,6 +224,7 @@ VkResult BufferSubAllocator::subAllocate(BufferSubAllocation& subAllocation, VkD
 #ifndef NDEBUG
     subAllocation.allocator = this;
 #endif
+    m_state.allocatedSize += size;
 
     // dedicated blocks are _not_ thrown into the active block list (m_activeBlockIndex)
 
@@ -247,6 +259,13 @@ VkResult BufferSubAllocator::subAllocate(BufferSubAllocation& subAllocation, VkD
   {
     Block& block = m_blocks[activeBlockIndex];
 
+    // blocks being defragmented are skipped
+    if(block.evacuate)
+    {
+      activeBlockIndex = block.nextActiveIndex;
+      continue;
+    }
+
     // attempt to sub allocate from active blocks
 
     OffsetAllocator::Allocation allocation = block.offsetAllocator->allocate(allocatorUnits);
@@ -260,6 +279,7 @@ VkResult BufferSubAllocator::subAllocate(BufferSubAllocation& subAllocation, VkD
 #ifndef NDEBUG
       subAllocation.allocator = this;
 #endif
+      m_state.allocatedSize += size;
 
       return VK_SUCCESS;
     }
@@ -270,7 +290,7 @@ VkResult BufferSubAllocator::subAllocate(BufferSubAllocation& subAllocation, VkD
   // could not find anything
 
   // if we reached the limit for blocks, bail out
-  if(m_state.freeBlockIndex == INVALID_BLOCK_INDEX && m_blocks.size() == size_t(m_state.maxBlocks))
+  if(!allowNewBlock || (m_state.freeBlockIndex == INVALID_BLOCK_INDEX && m_blocks.size() == size_t(m_state.maxBlocks)))
   {
     return VK_ERROR_OUT_OF_DEVICE_MEMORY;
   }
@@ -311,6 +331,7 @@ VkResult BufferSubAllocator::subAllocate(BufferSubAllocation& subAllocation, VkD
 #ifndef NDEBUG
       subAllocation.allocator = this;
 #endif
+      m_state.allocatedSize += size;
 
       return VK_SUCCESS;
     }
@@ -378,6 +399,11 @@ void BufferSubAllocator::subFree(BufferSubAllocation& subAllocation)
         }
       }
 
+      if(m_state.defragBlockIndex == subAllocation.block)
+      {
+        m_state.defragBlockIndex = INVALID_BLOCK_INDEX;
+      }
+
       // nuke it completely
       m_blocks[subAllocation.block] = {};
 
@@ -436,6 +462,139 @@ BufferRange BufferSubAllocator::subRange(const BufferSubAllocation& subAllocatio
   return info;
 }
 
+uint32_t BufferSubAllocator::findDefragmentBlock(float maxBlockUsage) const
+{
+  // the sparsest active block, as long as another one can take its content
+  uint32_t bestIndex = INVALID_BLOCK_INDEX;
+  float    bestUsage = maxBlockUsage;
+
+  if(m_state.activeBlockCount < 2)
+  {
+    return INVALID_BLOCK_INDEX;
+  }
+
+  for(uint32_t blockIndex = m_state.activeBlockIndex; blockIndex != INVALID_BLOCK_INDEX;
+      blockIndex          = m_blocks[blockIndex].nextActiveIndex)
+  {
+    const OffsetAllocator::StorageReport storageReport = m_blocks[blockIndex].offsetAllocator->storageReport();
+
+    float usage = float(m_state.internalBlockUnits - storageReport.totalFreeSpace) / float(m_state.internalBlockUnits);
+    if(usage > 0.0f && usage < bestUsage)
+    {
+      bestIndex = blockIndex;
+      bestUsage = usage;
+    }
+  }
+
+  return bestIndex;
+}
+
+VkDeviceSize BufferSubAllocator::cmdDefragment(VkCommandBuffer                  cmd,
+                                               std::span<BufferSubAllocation*> subAllocations,
+                                               const SemaphoreState&            semaphoreState,
+                                               const DefragmentInfo&            info,
+                                               const DefragmentCallback&        movedCallback)
+{
+  if(m_state.defragBlockIndex == INVALID_BLOCK_INDEX)
+  {
+    m_state.defragBlockIndex = findDefragmentBlock(info.maxBlockUsage);
+    if(m_state.defragBlockIndex == INVALID_BLOCK_INDEX)
+    {
+      return 0;
+    }
+    m_blocks[m_state.defragBlockIndex].evacuate = true;
+  }
+
+  const uint32_t defragBlockIndex = m_state.defragBlockIndex;
+  VkDeviceSize   copySize         = 0;
+  bool           remaining        = false;
+
+  for(BufferSubAllocation* subAllocation : subAllocations)
+  {
+    if(!*subAllocation || subAllocation->block != defragBlockIndex)
+    {
+      continue;
+    }
+
+    if(copySize >= info.maxCopySize)
+    {
+      remaining = true;
+      break;
+    }
+
+    // no new blocks, the point is to reduce them
+    BufferSubAllocation newAllocation;
+    if(subAllocateInternal(newAllocation, subAllocation->size, uint32_t(subAllocation->alignmentMinusOne) + 1, false) != VK_SUCCESS)
+    {
+      remaining = true;
+      break;
+    }
+
+    const BufferRange oldRange = subRange(*subAllocation);
+    const BufferRange newRange = subRange(newAllocation);
+
+    if(copySize == 0)
+    {
+      cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_COPY_BIT,
+                       VK_ACCESS_2_MEMORY_WRITE_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+    }
+
+    const VkBufferCopy region{.srcOffset = oldRange.offset, .dstOffset = newRange.offset, .size = oldRange.range};
+    vkCmdCopyBuffer(cmd, oldRange.buffer, newRange.buffer, 1, &region);
+    copySize += oldRange.range;
+
+    m_defragFrees.push_back({*subAllocation, semaphoreState});
+    *subAllocation = newAllocation;
+
+    if(movedCallback)
+    {
+      movedCallback(*subAllocation, oldRange, newRange);
+    }
+  }
+
+  if(copySize)
+  {
+    cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COPY_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                     VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT);
+  }
+
+  // The block is released with its last pending free (see `subFree`).
+  // Without pending frees, its remaining sub-allocations weren't provided: give up on it.
+  auto isPending = [&](const DefragmentFree& defragFree) { return defragFree.subAllocation.block == defragBlockIndex; };
+  if(!remaining && std::none_of(m_defragFrees.begin(), m_defragFrees.end(), isPending))
+  {
+    m_blocks[defragBlockIndex].evacuate = false;
+    m_state.defragBlockIndex            = INVALID_BLOCK_INDEX;
+  }
+
+  return copySize;
+}
+
+void BufferSubAllocator::releaseDefragmented(bool forceAll)
+{
+  VkDevice device   = m_info.resourceAllocator->getDevice();
+  size_t   writeIdx = 0;
+
+  for(size_t i = 0; i < m_defragFrees.size(); i++)
+  {
+    DefragmentFree& defragFree = m_defragFrees[i];
+    if(forceAll || !defragFree.semaphoreState.isValid() || defragFree.semaphoreState.testSignaled(device))
+    {
+      subFree(defragFree.subAllocation);
+    }
+    else
+    {
+      if(writeIdx != i)
+      {
+        m_defragFrees[writeIdx] = std::move(defragFree);
+      }
+      writeIdx++;
+    }
+  }
+
+  m_defragFrees.resize(writeIdx);
+}
+
 VkResult BufferSubAllocator::createNewBuffer(nvvk::Buffer& buffer, VkDeviceSize size, uint32_t alignment, uint32_t blockIndex)
 {
   NVVK_FAIL_RETURN(m_info.resourceAllocator->createBuffer(buffer, size, m_info.usageFlags, m_info.memoryUsage,
@@ -446,6 +605,137 @@ VkResult BufferSubAllocator::createNewBuffer(nvvk::Buffer& buffer, VkDeviceSize
   return VK_SUCCESS;
 }
 
+//////////////////////////////////////////////////////////////////////////
+
+VkResult BufferSubAllocatorShared::init(const BufferSubAllocator::InitInfo& createInfo, uint32_t shardCount)
+{
+  assert(m_shards.empty());
+  assert(shardCount > 0);
+
+  BufferSubAllocator::InitInfo shardInfo = createInfo;
+  if(shardInfo.maxAllocatedSize)
+  {
+    shardInfo.maxAllocatedSize = std::max(shardInfo.maxAllocatedSize / shardCount, shardInfo.blockSize);
+  }
+
+  for(uint32_t i = 0; i < shardCount; i++)
+  {
+    shardInfo.debugName = createInfo.debugName + "_shard" + std::to_string(i);
+
+    m_shards.push_back(std::make_unique<Shard>());
+    VkResult result = m_shards.back()->allocator.init(shardInfo);
+    if(result != VK_SUCCESS)
+    {
+      deinit();
+      return result;
+    }
+  }
+
+  return VK_SUCCESS;
+}
+
+void BufferSubAllocatorShared::deinit()
+{
+  for(std::unique_ptr<Shard>& shard : m_shards)
+  {
+    shard->allocator.deinit();
+  }
+  m_shards.clear();
+}
+
+BufferSubAllocator::Report BufferSubAllocatorShared::getReport() const
+{
+  BufferSubAllocator::Report report;
+
+  for(const std::unique_ptr<Shard>& shard : m_shards)
+  {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    BufferSubAllocator::Report  shardReport = shard->allocator.getReport();
+    report.requestedSize += shardReport.requestedSize;
+    report.reservedSize += shardReport.reservedSize;
+    report.freeSize += shardReport.freeSize;
+  }
+
+  return report;
+}
+
+uint32_t BufferSubAllocatorShared::getThreadShard() const
+{
+  // threads are assigned round-robin on first use
+  static std::atomic_uint32_t s_threadCounter = 0;
+  thread_local uint32_t       t_threadIndex   = s_threadCounter++;
+
+  return t_threadIndex % uint32_t(m_shards.size());
+}
+
+VkResult BufferSubAllocatorShared::subAllocate(BufferSubAllocationShared& subAllocation, VkDeviceSize size, uint32_t alignment)
+{
+  subAllocation = {};
+
+  const uint32_t shardCount = uint32_t(m_shards.size());
+  const uint32_t homeShard  = getThreadShard();
+  VkResult       result     = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+  // first pass skips the shards other threads are busy with,
+  // second pass waits on them before giving up
+  for(uint32_t pass = 0; pass < 2; pass++)
+  {
+    for(uint32_t i = 0; i < shardCount; i++)
+    {
+      const uint32_t shardIndex = (homeShard + i) % shardCount;
+      Shard&         shard      = *m_shards[shardIndex];
+
+      std::unique_lock<std::mutex> lock(shard.mutex, std::defer_lock);
+      if(pass == 0 && !lock.try_lock())
+      {
+        continue;
+      }
+      if(pass == 1)
+      {
+        lock.lock();
+      }
+
+      result = shard.allocator.subAllocate(subAllocation.subAllocation, size, alignment);
+      if(result == VK_SUCCESS)
+      {
+        subAllocation.shard = shardIndex;
+        return VK_SUCCESS;
+      }
+    }
+  }
+
+  return result;
+}
+
+void BufferSubAllocatorShared::subFree(BufferSubAllocationShared& subAllocation)
+{
+  if(!subAllocation)
+  {
+    return;
+  }
+
+  Shard& shard = *m_shards[subAllocation.shard];
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.allocator.subFree(subAllocation.subAllocation);
+  }
+
+  subAllocation = {};
+}
+
+BufferRange BufferSubAllocatorShared::subRange(const BufferSubAllocationShared& subAllocation) const
+{
+  if(!subAllocation)
+  {
+    return {};
+  }
+
+  // the shard's block vector may grow concurrently
+  const Shard&                shard = *m_shards[subAllocation.shard];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return shard.allocator.subRange(subAllocation.subAllocation);
+}
+
 }  // namespace nvvk
 
 
@@ -490,6 +780,21 @@ VkResult BufferSubAllocator::createNewBuffer(nvvk::Buffer& buffer, VkDeviceSize
   {
     VkCommandBuffer cmd{};  // per-frame command buffer, setup state etc.
 
+    // after streaming meshes in and out, compact the blocks a bit every frame
+    {
+      nvvk::SemaphoreState frameSemaphoreState{};  // EX. signaled once no frame in flight uses the old ranges
+
+      std::vector<nvvk::BufferSubAllocation*> liveAllocations;
+      for(Mesh& mesh : meshes)
+      {
+        liveAllocations.push_back(&mesh.vertex);
+        liveAllocations.push_back(&mesh.index);
+      }
+
+      bufferSubAllocator.releaseDefragmented();
+      bufferSubAllocator.cmdDefragment(cmd, liveAllocations, frameSemaphoreState);
+    }
+
     VkBuffer lastVertexBuffer = {};
     VkBuffer lastIndexBuffer  = {};
 
@@ -524,3 +829,37 @@ VkResult BufferSubAllocator::createNewBuffer(nvvk::Buffer& buffer, VkDeviceSize
     }
   }
 }
+
+[[maybe_unused]] static void usage_BufferSubAllocatorShared()
+{
+  struct Mesh
+  {
+    size_t vertexSize;
+
+    nvvk::BufferSubAllocationShared vertex;
+  };
+
+  std::vector<Mesh> meshes;
+
+  nvvk::ResourceAllocator resourceAllocator;  // EX. initialize somehow
+
+  // one lock per shard, instead of funneling all loader threads through one
+  nvvk::BufferSubAllocatorShared bufferSubAllocator;
+  bufferSubAllocator.init({.resourceAllocator = &resourceAllocator,
+                           .debugName         = "meshes",
+                           .usageFlags        = VK_BUFFER_USAGE_2_VERTEX_BUFFER_BIT,
+                           .memoryUsage       = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+                           .blockSize         = 16 * 1024 * 1024});
+
+  nvutils::parallel_batches<64>(meshes.size(), [&](uint64_t idx) {
+    Mesh& mesh = meshes[idx];
+    bufferSubAllocator.subAllocate(mesh.vertex, mesh.vertexSize);
+  });
+
+  for(Mesh& mesh : meshes)
+  {
+    bufferSubAllocator.subFree(mesh.vertex);
+  }
+
+  bufferSubAllocator.deinit();
+}
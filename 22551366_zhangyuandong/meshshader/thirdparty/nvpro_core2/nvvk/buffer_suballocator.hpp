@@ -19,14 +19,19 @@
 
 #pragma once
 
+#include <cassert>
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <functional>
+#include <span>
 
 #include <offsetallocator/offsetAllocator.hpp>
 #include <vulkan/vulkan_core.h>
 
 #include "resource_allocator.hpp"
+#include "semaphore.hpp"
 
 namespace nvvk {
 
@@ -142,11 +147,44 @@ public:
   // and will just return a zeroed output
   BufferRange subRange(const BufferSubAllocation& subAllocation) const;
 
+  // Incremental defragmentation
+  //
+  // Evacuates one sparsely used block at a time: its live sub-allocations found in `subAllocations`
+  // are re-allocated within the other active blocks and copied in `cmd`, up to `maxCopySize` bytes per call.
+  // The handles are updated in place, `movedCallback` reports the old and new ranges (e.g. to patch device addresses).
+  // The old ranges are only freed by `releaseDefragmented` once `semaphoreState` was signaled,
+  // it must cover the submit of `cmd` and all frames still using the old ranges.
+  // The block is released once empty.
+  struct DefragmentInfo
+  {
+    // blocks with a lower fraction of used space are evacuated
+    float maxBlockUsage = 0.25f;
+    // bytes copied per call
+    VkDeviceSize maxCopySize = VkDeviceSize(16) * 1024 * 1024;
+  };
+
+  using DefragmentCallback =
+      std::function<void(const BufferSubAllocation& subAllocation, const BufferRange& oldRange, const BufferRange& newRange)>;
+
+  // returns the number of bytes copied, 0 when nothing was moved
+  VkDeviceSize cmdDefragment(VkCommandBuffer                  cmd,
+                             std::span<BufferSubAllocation*> subAllocations,
+                             const SemaphoreState&            semaphoreState,
+                             const DefragmentInfo&            info          = {},
+                             const DefragmentCallback&        movedCallback = {});
+
+  // frees the old ranges of completed moves, `forceAll` ignores their semaphore state
+  void releaseDefragmented(bool forceAll = false);
+
 protected:
   static constexpr uint32_t INVALID_BLOCK_INDEX = ~0u;
 
   VkResult createNewBuffer(nvvk::Buffer& buffer, VkDeviceSize size, uint32_t alignment, uint32_t blockIndex);
 
+  VkResult subAllocateInternal(BufferSubAllocation& subAllocation, VkDeviceSize size, uint32_t alignment, bool allowNewBlock);
+
+  uint32_t findDefragmentBlock(float maxBlockUsage) const;
+
   uint32_t acquireBlockIndex();
 
   struct Block
@@ -160,6 +198,8 @@ protected:
     // continuation of double linked list of blocks that have OffsetAllocators
     uint32_t nextActiveIndex = INVALID_BLOCK_INDEX;
     uint32_t prevActiveIndex = INVALID_BLOCK_INDEX;
+    // being defragmented, no new sub-allocations
+    bool evacuate = false;
   };
 
   struct State
@@ -184,11 +224,77 @@ protected:
     // double linked list of blocks that are active
     // list head
     uint32_t activeBlockIndex = INVALID_BLOCK_INDEX;
+
+    // block currently evacuated by `cmdDefragment`
+    uint32_t defragBlockIndex = INVALID_BLOCK_INDEX;
   };
 
-  InitInfo           m_info;
-  State              m_state;
-  std::vector<Block> m_blocks;
+  struct DefragmentFree
+  {
+    BufferSubAllocation subAllocation;
+    SemaphoreState      semaphoreState;
+  };
+
+  InitInfo                    m_info;
+  State                       m_state;
+  std::vector<Block>          m_blocks;
+  std::vector<DefragmentFree> m_defragFrees;
+};
+
+class BufferSubAllocationShared
+{
+public:
+  BufferSubAllocationShared() = default;
+
+  operator bool() const { return bool(subAllocation); }
+
+private:
+  friend class BufferSubAllocatorShared;
+
+  BufferSubAllocation subAllocation;
+  uint32_t            shard{};
+};
+
+// Thread-safe BufferSubAllocator, e.g. for parallel loaders in `nvutils::parallel_batches`.
+// Sub-allocations are spread over `shardCount` BufferSubAllocators, each with its own lock.
+// A thread starts at its own shard and moves on to the next one that isn't locked
+// if it is busy or out of space, so threads rarely contend.
+// Frees can happen from any thread, they lock the shard of the sub-allocation.
+class BufferSubAllocatorShared
+{
+public:
+  static constexpr uint32_t DEFAULT_SHARD_COUNT = 8;
+
+  BufferSubAllocatorShared() = default;
+  ~BufferSubAllocatorShared() { assert(m_shards.empty() && "Missing deinit()"); }
+
+  BufferSubAllocatorShared(const BufferSubAllocatorShared&)            = delete;
+  BufferSubAllocatorShared& operator=(const BufferSubAllocatorShared&) = delete;
+
+  // each shard uses `createInfo` as is, but shares `createInfo.maxAllocatedSize`
+  // with `keepLastBlock` each shard keeps one block alive, account for it in `blockSize`
+  VkResult init(const BufferSubAllocator::InitInfo& createInfo, uint32_t shardCount = DEFAULT_SHARD_COUNT);
+  void     deinit();
+
+  // sum of all shards
+  BufferSubAllocator::Report getReport() const;
+
+  // same rules as BufferSubAllocator
+  VkResult    subAllocate(BufferSubAllocationShared& subAllocation, VkDeviceSize size,
+                          uint32_t alignment = BufferSubAllocator::DEFAULT_ALIGNMENT);
+  void        subFree(BufferSubAllocationShared& subAllocation);
+  BufferRange subRange(const BufferSubAllocationShared& subAllocation) const;
+
+protected:
+  struct Shard
+  {
+    mutable std::mutex mutex;
+    BufferSubAllocator allocator;
+  };
+
+  uint32_t getThreadShard() const;
+
+  std::vector<std::unique_ptr<Shard>> m_shards;
 };
 
 }  // namespace nvvk
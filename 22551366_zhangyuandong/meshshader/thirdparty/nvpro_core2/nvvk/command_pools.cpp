@@ -250,6 +250,126 @@ VkResult ManagedCommandPools::releaseIndexed(uint32_t explicitIndex, VkCommandPo
   return VK_SUCCESS;
 }
 
+//--------------------------------------------------------------------------------------------------
+// FrameCommandPools
+
+VkResult FrameCommandPools::init(VkDevice device, uint32_t queueFamilyIndex, uint32_t frameCount, VkCommandPoolCreateFlags flags)
+{
+  assert((flags & VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT) == 0 && "command buffers are reset with their pool");
+  assert(frameCount > 0);
+
+  m_device           = device;
+  m_queueFamilyIndex = queueFamilyIndex;
+  m_flags            = flags;
+  m_frameIndex       = 0;
+  m_frames.resize(frameCount);
+
+  return VK_SUCCESS;
+}
+
+void FrameCommandPools::deinit()
+{
+  if(!m_device)
+    return;
+
+  for(Frame& frame : m_frames)
+  {
+    for(std::unique_ptr<ThreadPool>& threadPool : frame.threadPools)
+    {
+      // destroying the pool frees its command buffers
+      vkDestroyCommandPool(m_device, threadPool->commandPool, nullptr);
+    }
+  }
+  m_frames = {};
+  m_device = nullptr;
+}
+
+VkResult FrameCommandPools::beginFrame(const nvvk::SemaphoreState& submitSemaphoreState, uint64_t waitTimeOut)
+{
+  assert(submitSemaphoreState.isValid());
+
+  std::lock_guard lock(m_mutex);
+
+  m_frameIndex = (m_frameIndex + 1) % static_cast<uint32_t>(m_frames.size());
+  Frame& frame = m_frames[m_frameIndex];
+
+  if(frame.semaphoreState.isValid())
+  {
+    NVVK_FAIL_RETURN(frame.semaphoreState.wait(m_device, waitTimeOut));
+  }
+
+  // recycle all the command buffers of the slot at once, they remain allocated
+  for(std::unique_ptr<ThreadPool>& threadPool : frame.threadPools)
+  {
+    if(threadPool->usedPrimary || threadPool->usedSecondary)
+    {
+      NVVK_FAIL_RETURN(vkResetCommandPool(m_device, threadPool->commandPool, 0));
+    }
+    threadPool->usedPrimary   = 0;
+    threadPool->usedSecondary = 0;
+  }
+
+  frame.semaphoreState = submitSemaphoreState;
+
+  return VK_SUCCESS;
+}
+
+FrameCommandPools::ThreadPool* FrameCommandPools::getThreadPool()
+{
+  const std::thread::id threadId = std::this_thread::get_id();
+
+  std::lock_guard lock(m_mutex);
+
+  Frame& frame = m_frames[m_frameIndex];
+  for(std::unique_ptr<ThreadPool>& threadPool : frame.threadPools)
+  {
+    if(threadPool->threadId == threadId)
+      return threadPool.get();
+  }
+
+  const VkCommandPoolCreateInfo createInfo = {
+      .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+      .flags            = m_flags,
+      .queueFamilyIndex = m_queueFamilyIndex,
+  };
+
+  auto threadPool      = std::make_unique<ThreadPool>();
+  threadPool->threadId = threadId;
+  if(vkCreateCommandPool(m_device, &createInfo, nullptr, &threadPool->commandPool) != VK_SUCCESS)
+    return nullptr;
+
+  return frame.threadPools.emplace_back(std::move(threadPool)).get();
+}
+
+VkResult FrameCommandPools::acquireCommandBuffer(VkCommandBuffer& cmd, VkCommandBufferLevel level)
+{
+  ThreadPool* threadPool = getThreadPool();
+  if(!threadPool)
+    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+  // only the calling thread uses this pool
+  const bool                    isPrimary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  std::vector<VkCommandBuffer>& buffers   = isPrimary ? threadPool->primary : threadPool->secondary;
+  size_t&                       used      = isPrimary ? threadPool->usedPrimary : threadPool->usedSecondary;
+
+  if(used == buffers.size())
+  {
+    const VkCommandBufferAllocateInfo info = {
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool        = threadPool->commandPool,
+        .level              = level,
+        .commandBufferCount = 1,
+    };
+    VkCommandBuffer newCmd{};
+    NVVK_FAIL_RETURN(vkAllocateCommandBuffers(m_device, &info, &newCmd));
+    buffers.push_back(newCmd);
+  }
+
+  cmd = buffers[used++];
+
+  return VK_SUCCESS;
+}
+
 }  // namespace nvvk
 
 
@@ -356,3 +476,55 @@ static void usage_ManagedCommandPools()
     managedCmdPools.deinit();
   }
 }
+
+static void usage_FrameCommandPools()
+{
+  VkDevice    device{};
+  VkQueue     queue{};
+  uint32_t    queueFamilyIndex{};
+  VkSemaphore timelineSemaphore{};
+  uint64_t    timelineValue = 1;
+
+  // One slot per frame in flight, the pools of a slot are reset when its previous frame completed
+  nvvk::FrameCommandPools framePools;
+  framePools.init(device, queueFamilyIndex, 3);
+
+  // frame loop
+  /* while(!glfwWindowShouldClose()) */
+  {
+    nvvk::SemaphoreState semaphoreState = nvvk::SemaphoreState::makeFixed(timelineSemaphore, timelineValue);
+    framePools.beginFrame(semaphoreState);
+
+    // loaders and uploads record into command buffers of this frame, possibly from multiple threads,
+    // instead of submitting and waiting for each of them
+    std::vector<VkCommandBufferSubmitInfo> cmdSubmitInfos;
+    for(uint32_t i = 0; i < 4; i++)
+    {
+      VkCommandBuffer cmd{};
+      framePools.acquireCommandBuffer(cmd);
+
+      const VkCommandBufferBeginInfo beginInfo{.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                               .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+      vkBeginCommandBuffer(cmd, &beginInfo);
+      // record work
+      vkEndCommandBuffer(cmd);
+
+      cmdSubmitInfos.push_back({.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, .commandBuffer = cmd});
+    }
+
+    // a single submission for the frame
+    VkSemaphoreSubmitInfo semSubmitInfo = nvvk::makeSemaphoreSubmitInfo(semaphoreState, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+
+    VkSubmitInfo2 submitInfo2            = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2};
+    submitInfo2.commandBufferInfoCount   = uint32_t(cmdSubmitInfos.size());
+    submitInfo2.pCommandBufferInfos      = cmdSubmitInfos.data();
+    submitInfo2.signalSemaphoreInfoCount = 1;
+    submitInfo2.pSignalSemaphoreInfos    = &semSubmitInfo;
+    vkQueueSubmit2(queue, 1, &submitInfo2, VK_NULL_HANDLE);
+
+    timelineValue++;
+  }
+
+  vkDeviceWaitIdle(device);
+  framePools.deinit();
+}
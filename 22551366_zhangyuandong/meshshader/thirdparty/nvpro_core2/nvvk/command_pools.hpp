@@ -19,6 +19,10 @@
 
 #pragma once
 
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <vulkan/vulkan_core.h>
@@ -120,4 +124,66 @@ protected:
                                    VkCommandBuffer&            cmd);
   VkResult reset(ManagedCommandPool& entry, VkCommandPoolResetFlags resetFlags);
 };
+
+// Command pools for the work of a frame in flight, one per thread recording into the frame.
+// Any number of command buffers can be acquired during a frame, they are recycled all at once
+// with `vkResetCommandPool` when the frame's SemaphoreState is signaled, and stay allocated for the
+// next use of the frame slot. This avoids allocating, submitting and waiting on a temporary
+// command buffer each time: the work is recorded into the frame's submission instead.
+//
+// `beginFrame` must be called from a single thread, while no command buffer is being acquired.
+// `acquireCommandBuffer` can be called from any thread, the command buffers of a thread come
+// from its own pool, so they can be recorded in parallel.
+
+class FrameCommandPools
+{
+public:
+  FrameCommandPools()                                    = default;
+  FrameCommandPools(const FrameCommandPools&)            = delete;
+  FrameCommandPools& operator=(const FrameCommandPools&) = delete;
+  ~FrameCommandPools() { assert(m_device == nullptr && "Missing deinit()"); }
+
+  // `frameCount` is the number of frames in flight
+  // `flags` must not contain VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+  VkResult init(VkDevice device, uint32_t queueFamilyIndex, uint32_t frameCount, VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+  // destroys all pools independent of SemaphoreState
+  void deinit();
+
+  // Moves to the next frame slot, whose command buffers will be submitted with a signal of `submitSemaphoreState`.
+  // Waits for the previous submission of that slot (based on waitTimeOut), then resets its pools.
+  VkResult beginFrame(const nvvk::SemaphoreState& submitSemaphoreState, uint64_t waitTimeOut = ~0ULL);
+
+  // Returns an unused command buffer of the current frame and the calling thread, not yet begun.
+  VkResult acquireCommandBuffer(VkCommandBuffer& cmd, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+  uint32_t getFrameIndex() const { return m_frameIndex; }
+
+protected:
+  struct ThreadPool
+  {
+    std::thread::id              threadId;
+    VkCommandPool                commandPool{};
+    std::vector<VkCommandBuffer> primary;
+    std::vector<VkCommandBuffer> secondary;
+    size_t                       usedPrimary{};
+    size_t                       usedSecondary{};
+  };
+
+  struct Frame
+  {
+    nvvk::SemaphoreState semaphoreState{};
+    // never shrinks during a frame, pointers are stable
+    std::vector<std::unique_ptr<ThreadPool>> threadPools;
+  };
+
+  VkDevice           m_device{};
+  uint32_t           m_queueFamilyIndex{};
+  uint32_t           m_flags{};
+  uint32_t           m_frameIndex{};
+  std::vector<Frame> m_frames;
+  std::mutex         m_mutex;  // protects the threadPools of the current frame
+
+  ThreadPool* getThreadPool();
+};
 }  // namespace nvvk
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <volk.h>
+
+#include <nvutils/parallel_work.hpp>
+
+#include "check_error.hpp"
+#include "completion_service.hpp"
+
+void nvvk::CompletionService::init(VkDevice device)
+{
+  assert(m_device == VK_NULL_HANDLE);
+  m_device = device;
+}
+
+void nvvk::CompletionService::deinit()
+{
+  if(m_device == VK_NULL_HANDLE)
+  {
+    return;
+  }
+  waitAll();
+  m_device = VK_NULL_HANDLE;
+}
+
+void nvvk::CompletionService::enqueue(const SemaphoreState& semaphoreState, std::function<void()>&& callback, Dispatch dispatch)
+{
+  assert(m_device && semaphoreState.isValid() && callback);
+  std::lock_guard lock(m_mutex);
+  m_pending.push_back({semaphoreState, std::move(callback), dispatch});
+}
+
+std::vector<nvvk::CompletionService::Pending> nvvk::CompletionService::takeReady(bool wait)
+{
+  std::vector<Pending> ready;
+  std::lock_guard      lock(m_mutex);
+
+  // Counter values read once per semaphore, most callbacks wait on the same few ones
+  std::vector<std::pair<VkSemaphore, uint64_t>> completed;
+  auto getCompleted = [&](VkSemaphore semaphore) {
+    auto it = std::find_if(completed.begin(), completed.end(), [&](const auto& c) { return c.first == semaphore; });
+    if(it == completed.end())
+    {
+      uint64_t value{};
+      NVVK_CHECK(vkGetSemaphoreCounterValue(m_device, semaphore, &value));
+      it = completed.insert(completed.end(), {semaphore, value});
+    }
+    return it->second;
+  };
+
+  auto isReady = [&](Pending& pending) {
+    if(!pending.semaphoreState.canWait())
+    {
+      // dynamic state not submitted yet, it stays pending
+      assert(!wait && "waiting for a SemaphoreState that was never submitted");
+      return false;
+    }
+    if(wait)
+    {
+      NVVK_CHECK(pending.semaphoreState.wait(m_device, std::numeric_limits<uint64_t>::max()));
+      return true;
+    }
+    return getCompleted(pending.semaphoreState.getSemaphore()) >= pending.semaphoreState.getTimelineValue();
+  };
+
+  // Keeps the order of registration among the ready callbacks
+  auto split = std::stable_partition(m_pending.begin(), m_pending.end(), [&](Pending& pending) { return !isReady(pending); });
+  ready.insert(ready.end(), std::make_move_iterator(split), std::make_move_iterator(m_pending.end()));
+  m_pending.erase(split, m_pending.end());
+  return ready;
+}
+
+void nvvk::CompletionService::dispatch(std::vector<Pending>& ready)
+{
+  for(Pending& pending : ready)
+  {
+    if(pending.dispatch == Dispatch::eThreadPool)
+    {
+      std::future<void> future = nvutils::get_thread_pool().submit_task(std::move(pending.callback));
+      std::lock_guard   lock(m_mutex);
+      m_running.push_back(std::move(future));
+    }
+    else
+    {
+      // outside of the lock, the callback may enqueue
+      pending.callback();
+    }
+  }
+
+  std::lock_guard lock(m_mutex);
+  std::erase_if(m_running, [](const std::future<void>& future) {
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  });
+}
+
+uint32_t nvvk::CompletionService::poll()
+{
+  std::vector<Pending> ready = takeReady(false);
+  dispatch(ready);
+  return uint32_t(ready.size());
+}
+
+void nvvk::CompletionService::wait(const SemaphoreState& semaphoreState)
+{
+  NVVK_CHECK(semaphoreState.wait(m_device, std::numeric_limits<uint64_t>::max()));
+  poll();
+}
+
+void nvvk::CompletionService::waitAll()
+{
+  // Callbacks may enqueue more, loop until none is left
+  while(true)
+  {
+    std::vector<Pending> ready = takeReady(true);
+    dispatch(ready);
+
+    std::vector<std::future<void>> running;
+    {
+      std::lock_guard lock(m_mutex);
+      running.swap(m_running);
+    }
+    for(std::future<void>& future : running)
+    {
+      future.get();
+    }
+
+    // Done, or only unsubmitted states are left
+    if(ready.empty() && running.empty())
+    {
+      break;
+    }
+  }
+}
+
+size_t nvvk::CompletionService::getPendingCount() const
+{
+  std::lock_guard lock(m_mutex);
+  return m_pending.size();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_CompletionService()
+{
+  VkDevice                device{};       // EX: the logical device
+  nvvk::SemaphoreInfo     frameSignal{};  // EX: m_app->getFrameSignalSemaphore()
+  nvvk::CompletionService completions;
+
+  completions.init(device);
+
+  // Recording a frame that copies into a readback buffer: read it, then write it to a file
+  {
+    completions.enqueue(nvvk::SemaphoreState::makeFixed(frameSignal), [] { /* read the mapped readback buffer */ });
+    completions.enqueue(
+        frameSignal.semaphore, frameSignal.value, [] { /* write the readback to a file */ },
+        nvvk::CompletionService::Dispatch::eThreadPool);
+  }
+
+  // Begin of each frame, no wait
+  completions.poll();
+
+  // Shutdown: runs what is left
+  completions.deinit();
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+/**
+  # class nvvk::CompletionService
+
+  nvvk::CompletionService runs CPU callbacks once the GPU has reached a timeline semaphore value,
+  instead of each subsystem polling or blocking on its own semaphores: readbacks, freeing of
+  resources still in use, asynchronous saves of images...
+
+  - enqueue() registers a callback with the `nvvk::SemaphoreState` to wait for. A dynamic state
+    whose submit hasn't happened yet simply stays pending.
+  - poll(), called once per frame, reads the counter of each semaphore once with `vkGetSemaphoreCounterValue`
+    and dispatches the callbacks whose value has been reached, without waiting.
+  - wait() blocks until a given value is reached, then polls; waitAll() blocks until all the callbacks
+    have run, e.g. before destroying what they use.
+
+  Callbacks run either on the thread calling poll() (`Dispatch::eCaller`, for work touching non thread-safe
+  state such as the allocator), or on the `nvutils::get_thread_pool()` workers (`Dispatch::eThreadPool`, for
+  heavy work such as encoding images). They may enqueue other callbacks.
+
+  It is thread-safe. `nvapp::Application` owns one, polled before recording each frame.
+
+  See usage_CompletionService() in completion_service.cpp for an example.
+*/
+
+#include <cassert>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include "semaphore.hpp"
+
+namespace nvvk {
+
+class CompletionService
+{
+public:
+  enum class Dispatch
+  {
+    eCaller,      // run in poll() or waitAll(), on the calling thread
+    eThreadPool,  // handed to the thread pool, waitAll() also waits for them
+  };
+
+  CompletionService() = default;
+  ~CompletionService() { assert(m_device == VK_NULL_HANDLE); }  // Missing deinit()
+
+  void init(VkDevice device);
+  // Waits and runs the pending callbacks
+  void deinit();
+
+  void enqueue(const SemaphoreState& semaphoreState, std::function<void()>&& callback, Dispatch dispatch = Dispatch::eCaller);
+  void enqueue(VkSemaphore semaphore, uint64_t value, std::function<void()>&& callback, Dispatch dispatch = Dispatch::eCaller)
+  {
+    enqueue(SemaphoreState::makeFixed(semaphore, value), std::move(callback), dispatch);
+  }
+
+  // Dispatches the callbacks whose semaphore value has been reached, returns how many
+  uint32_t poll();
+  // Blocks until the GPU reaches `semaphoreState`, then polls
+  void wait(const SemaphoreState& semaphoreState);
+  // Blocks until all the callbacks have run, including the thread pool ones
+  void waitAll();
+
+  size_t getPendingCount() const;
+
+private:
+  struct Pending
+  {
+    SemaphoreState        semaphoreState;
+    std::function<void()> callback;
+    Dispatch              dispatch{};
+  };
+
+  // Returns the callbacks that are ready, or all of them when `wait` (waiting for their semaphores)
+  std::vector<Pending> takeReady(bool wait);
+  void                 dispatch(std::vector<Pending>& ready);
+
+  VkDevice                       m_device{};
+  mutable std::mutex             m_mutex;
+  std::vector<Pending>           m_pending;
+  std::vector<std::future<void>> m_running;  // thread pool callbacks not known to be finished
+};
+
+}  // namespace nvvk
@@ -18,6 +18,7 @@
  */
 
 
+#include <algorithm>
 #include <csignal>
 #include <cstring>
 #include <sstream>
@@ -92,6 +93,10 @@ VkResult nvvk::Context::init(const ContextInitInfo& contextInitInfo)
     NVVK_FAIL_RETURN(printInstanceExtensions(contextInfo.instanceExtensions));
     NVVK_FAIL_RETURN(printDeviceExtensions(m_physicalDevice, contextInfo.deviceExtensions));
     NVVK_FAIL_RETURN(printGpus(m_instance, m_physicalDevice));
+    if(m_deviceGroup.size() > 1)
+    {
+      LOGI("Device group of %u GPUs\n", uint32_t(m_deviceGroup.size()));
+    }
     LOGI("_________________________________________________\n");
   }
   return VK_SUCCESS;
@@ -254,6 +259,36 @@ VkResult nvvk::Context::selectPhysicalDevice()
     }
   }
 
+  // The devices of the group of the selected one, which stays the first
+  m_deviceGroup = {m_physicalDevice};
+  if(contextInfo.useDeviceGroup)
+  {
+    uint32_t groupCount = 0;
+    NVVK_FAIL_RETURN(vkEnumeratePhysicalDeviceGroups(m_instance, &groupCount, nullptr));
+    std::vector<VkPhysicalDeviceGroupProperties> groups(groupCount, {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GROUP_PROPERTIES});
+    NVVK_FAIL_RETURN(vkEnumeratePhysicalDeviceGroups(m_instance, &groupCount, groups.data()));
+    for(const VkPhysicalDeviceGroupProperties& group : groups)
+    {
+      const VkPhysicalDevice* begin = group.physicalDevices;
+      const VkPhysicalDevice* end   = group.physicalDevices + group.physicalDeviceCount;
+      if(std::find(begin, end, m_physicalDevice) != end)
+      {
+        for(const VkPhysicalDevice* device = begin; device != end; device++)
+        {
+          if(*device != m_physicalDevice)
+          {
+            m_deviceGroup.push_back(*device);
+          }
+        }
+        break;
+      }
+    }
+    if(m_deviceGroup.size() == 1)
+    {
+      LOGW("No device group for the selected GPU, using it alone\n");
+    }
+  }
+
   // Query the physical device features
   m_deviceFeatures.pNext = &m_deviceFeatures11;
   if(vkVersionAtLeast(contextInfo.apiVersion, VK_API_VERSION_1_2))
@@ -333,9 +368,17 @@ VkResult nvvk::Context::createDevice()
     enabledExtensions.push_back(ext.extensionName);
   }
 
+  // The device indices are the order of the devices in the group, the selected one is device 0
+  const VkDeviceGroupDeviceCreateInfo deviceGroupInfo{
+      .sType               = VK_STRUCTURE_TYPE_DEVICE_GROUP_DEVICE_CREATE_INFO,
+      .pNext               = &m_deviceFeatures,
+      .physicalDeviceCount = uint32_t(m_deviceGroup.size()),
+      .pPhysicalDevices    = m_deviceGroup.data(),
+  };
+
   VkDeviceCreateInfo createInfo{
       .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-      .pNext                   = &m_deviceFeatures,
+      .pNext                   = m_deviceGroup.size() > 1 ? static_cast<const void*>(&deviceGroupInfo) : &m_deviceFeatures,
       .queueCreateInfoCount    = uint32_t(m_queueCreateInfos.size()),
       .pQueueCreateInfos       = m_queueCreateInfos.data(),
       .enabledExtensionCount   = static_cast<uint32_t>(enabledExtensions.size()),
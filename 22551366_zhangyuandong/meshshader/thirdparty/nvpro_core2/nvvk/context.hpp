@@ -62,6 +62,7 @@ struct ExtensionInfo
 // alloc                : Allocation callbacks
 // enableAllFeatures    : If true, pull all capability of `features` from the physical device
 // forceGPU             : If != -1, use GPU index, useful to select a specific GPU
+// useDeviceGroup       : If true, the device spans all GPUs of the device group of the selected one (see nvvk::DeviceGroup)
 struct ContextInitInfo
 {
   std::vector<const char*>         instanceExtensions    = {};
@@ -73,6 +74,7 @@ struct ContextInitInfo
   VkAllocationCallbacks*           alloc                 = nullptr;
   bool                             enableAllFeatures     = true;
   int32_t                          forceGPU              = -1;
+  bool                             useDeviceGroup        = false;
 #if NDEBUG
   bool enableValidationLayers = false;  // Disable validation layers in release
   bool verbose                = false;
@@ -110,6 +112,10 @@ public:
   const std::vector<nvvk::QueueInfo>& getQueueInfos() const { return m_queueInfos; }
   bool                                hasExtensionEnabled(const char* name) const;
 
+  // Physical devices of the logical device, the selected one first. Only that one without `useDeviceGroup`.
+  const std::vector<VkPhysicalDevice>& getDeviceGroup() const { return m_deviceGroup; }
+  uint32_t                             getDeviceCount() const { return uint32_t(m_deviceGroup.size()); }
+
   const VkPhysicalDeviceFeatures&         getPhysicalDeviceFeatures() const { return m_deviceFeatures.features; }
   const VkPhysicalDeviceVulkan11Features& getPhysicalDeviceFeatures11() const { return m_deviceFeatures11; }
   const VkPhysicalDeviceVulkan12Features& getPhysicalDeviceFeatures12() const { return m_deviceFeatures12; }
@@ -138,6 +144,8 @@ private:
   VkDevice         m_device{};
   VkPhysicalDevice m_physicalDevice{};
 
+  std::vector<VkPhysicalDevice> m_deviceGroup{};
+
   // For device creation
   VkPhysicalDeviceFeatures2        m_deviceFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
   VkPhysicalDeviceVulkan11Features m_deviceFeatures11{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES};
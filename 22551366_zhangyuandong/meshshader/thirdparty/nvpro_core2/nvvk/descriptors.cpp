@@ -17,9 +17,12 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 
+#include <algorithm>
+
 #include "descriptors.hpp"
 
 #include <nvvk/check_error.hpp>
+#include <nvvk/resource_allocator.hpp>
 
 namespace nvvk {
 
@@ -309,7 +312,7 @@ void WriteSetContainer::append(const VkWriteDescriptorSet& writeSet, const nvvk:
   BufferOrImageData basics;
   basics.buffer.buffer = buffer.buffer;
   basics.buffer.offset = offset;
-  basics.buffer.range  = range;
+  basics.buffer.range  = range == VK_WHOLE_SIZE ? buffer.bufferSize - offset : range;  // explicit, for DescriptorBufferPack
   m_bufferOrImageDatas.emplace_back(basics);
 
   m_needPointerUpdate = true;
@@ -327,7 +330,7 @@ void WriteSetContainer::append(const VkWriteDescriptorSet& writeSet, const nvvk:
     BufferOrImageData basics;
     basics.buffer.buffer = buffers[i].buffer;
     basics.buffer.offset = 0;
-    basics.buffer.range  = VK_WHOLE_SIZE;
+    basics.buffer.range  = buffers[i].bufferSize;
     m_bufferOrImageDatas.emplace_back(basics);
   }
 
@@ -592,6 +595,200 @@ const VkWriteDescriptorSet* WriteSetContainer::data()
 
   return m_writeSets.empty() ? nullptr : m_writeSets.data();
 }
+
+//////////////////////////////////////////////////////////////////////////
+
+DescriptorBufferPack::~DescriptorBufferPack()
+{
+  assert(m_allocator == nullptr && "Missing deinit()");
+}
+
+VkResult DescriptorBufferPack::init(const DescriptorBindings&        bindings,
+                                    ResourceAllocator*               allocator,
+                                    uint32_t                         numSets,
+                                    VkDescriptorSetLayoutCreateFlags layoutFlags)
+{
+  assert(m_allocator == nullptr && "init must not be called twice in a row!");
+  assert(numSets > 0);
+
+  m_allocator = allocator;
+  m_bindings  = bindings;
+
+  VkDevice device = allocator->getDevice();
+
+  m_props = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT};
+  VkPhysicalDeviceProperties2 props2{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &m_props};
+  vkGetPhysicalDeviceProperties2(allocator->getPhysicalDevice(), &props2);
+
+  NVVK_FAIL_RETURN(bindings.createDescriptorSetLayout(device, layoutFlags | VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT, &m_layout));
+
+  // Layout of a set within the buffer
+  VkDeviceSize layoutSize = 0;
+  vkGetDescriptorSetLayoutSizeEXT(device, m_layout, &layoutSize);
+  const VkDeviceSize alignment = m_props.descriptorBufferOffsetAlignment;
+  m_setStride                  = (layoutSize + alignment - 1) / alignment * alignment;
+
+  // matches the usage `ResourceAllocator::createBuffer` ends up with
+  m_bufferUsage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  for(const VkDescriptorSetLayoutBinding& binding : bindings.getBindings())
+  {
+    if(binding.binding >= m_bindingOffsets.size())
+    {
+      m_bindingOffsets.resize(binding.binding + 1, 0);
+    }
+    vkGetDescriptorSetLayoutBindingOffsetEXT(device, m_layout, binding.binding, &m_bindingOffsets[binding.binding]);
+
+    if(binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER || binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+    {
+      m_bufferUsage |= VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+    }
+  }
+
+  // Mapped for the CPU writes, device-local when resizable BAR allows it
+  NVVK_FAIL_RETURN(allocator->createBuffer(m_buffer, std::max(m_setStride * numSets, alignment), m_bufferUsage,
+                                           VMA_MEMORY_USAGE_AUTO,
+                                           VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT));
+
+  return VK_SUCCESS;
+}
+
+void DescriptorBufferPack::deinit()
+{
+  if(!m_allocator)
+    return;
+
+  vkDestroyDescriptorSetLayout(m_allocator->getDevice(), m_layout, nullptr);
+  m_allocator->destroyBuffer(m_buffer);
+
+  m_bindings.clear();
+  m_bindingOffsets.clear();
+  m_layout      = VK_NULL_HANDLE;
+  m_bufferUsage = 0;
+  m_setStride   = 0;
+  m_allocator   = nullptr;
+}
+
+size_t DescriptorBufferPack::getDescriptorSize(VkDescriptorType type) const
+{
+  switch(type)
+  {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+      return m_props.samplerDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+      return m_props.combinedImageSamplerDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+      return m_props.sampledImageDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+      return m_props.storageImageDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+      return m_props.uniformTexelBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+      return m_props.storageTexelBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      return m_props.uniformBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+      return m_props.storageBufferDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+      return m_props.inputAttachmentDescriptorSize;
+    case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+      return m_props.accelerationStructureDescriptorSize;
+    default:
+      assert(0 && "descriptor type not supported by descriptor buffers");
+      return 0;
+  }
+}
+
+void DescriptorBufferPack::update(WriteSetContainer& writes, uint32_t setIndex)
+{
+  update(std::span<const VkWriteDescriptorSet>(writes.data(), writes.size()), setIndex);
+}
+
+void DescriptorBufferPack::update(std::span<const VkWriteDescriptorSet> writes, uint32_t setIndex)
+{
+  VkDevice device  = m_allocator->getDevice();
+  uint8_t* mapping = m_buffer.mapping + getSetOffset(setIndex);
+
+  for(const VkWriteDescriptorSet& write : writes)
+  {
+    const size_t descriptorSize = getDescriptorSize(write.descriptorType);
+    uint8_t*     dst = mapping + m_bindingOffsets[write.dstBinding] + size_t(write.dstArrayElement) * descriptorSize;
+
+    const VkWriteDescriptorSetAccelerationStructureKHR* writeAccel =
+        write.descriptorType == VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR ?
+            static_cast<const VkWriteDescriptorSetAccelerationStructureKHR*>(write.pNext) :
+            nullptr;
+
+    for(uint32_t i = 0; i < write.descriptorCount; i++, dst += descriptorSize)
+    {
+      VkDescriptorGetInfoEXT     getInfo{.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT, .type = write.descriptorType};
+      VkDescriptorAddressInfoEXT addressInfo{.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT};
+
+      switch(write.descriptorType)
+      {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+          getInfo.data.pSampler = &write.pImageInfo[i].sampler;
+          break;
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+          getInfo.data.pCombinedImageSampler = &write.pImageInfo[i];
+          break;
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+          getInfo.data.pSampledImage = &write.pImageInfo[i];
+          break;
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+          getInfo.data.pStorageImage = &write.pImageInfo[i];
+          break;
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+          getInfo.data.pInputAttachmentImage = &write.pImageInfo[i];
+          break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: {
+          const VkDescriptorBufferInfo& bufferInfo = write.pBufferInfo[i];
+          assert(bufferInfo.range != VK_WHOLE_SIZE && "descriptor buffers need explicit ranges");
+          if(bufferInfo.buffer)
+          {
+            const VkBufferDeviceAddressInfo info{.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, .buffer = bufferInfo.buffer};
+            addressInfo.address = vkGetBufferDeviceAddress(device, &info) + bufferInfo.offset;
+            addressInfo.range   = bufferInfo.range;
+          }
+          // a null address info writes a null descriptor (VK_EXT_robustness2 nullDescriptor)
+          if(write.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+            getInfo.data.pUniformBuffer = addressInfo.address ? &addressInfo : nullptr;
+          else
+            getInfo.data.pStorageBuffer = addressInfo.address ? &addressInfo : nullptr;
+          break;
+        }
+        case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: {
+          const VkAccelerationStructureDeviceAddressInfoKHR info{
+              .sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR,
+              .accelerationStructure = writeAccel->pAccelerationStructures[i],
+          };
+          getInfo.data.accelerationStructure = vkGetAccelerationStructureDeviceAddressKHR(device, &info);
+          break;
+        }
+        default:
+          assert(0 && "descriptor type not supported by DescriptorBufferPack");
+          continue;
+      }
+
+      vkGetDescriptorEXT(device, &getInfo, descriptorSize, dst);
+    }
+  }
+}
+
+void DescriptorBufferPack::cmdBind(VkCommandBuffer cmd, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setIndex) const
+{
+  const VkDescriptorBufferBindingInfoEXT bindingInfo{
+      .sType   = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+      .address = m_buffer.address,
+      .usage   = m_bufferUsage,
+  };
+  vkCmdBindDescriptorBuffersEXT(cmd, 1, &bindingInfo);
+
+  const uint32_t     bufferIndex = 0;
+  const VkDeviceSize offset      = getSetOffset(setIndex);
+  vkCmdSetDescriptorBufferOffsetsEXT(cmd, bindPoint, layout, firstSet, 1, &bufferIndex, &offset);
+}
+
 }  // namespace nvvk
 
 
@@ -687,3 +884,31 @@ const VkWriteDescriptorSet* WriteSetContainer::data()
   vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
   dpack.deinit();
 }
+
+[[maybe_unused]] static void usage_DescriptorBufferPack()
+{
+  nvvk::ResourceAllocator  allocator;  // EX: initialized on a device with VK_EXT_descriptor_buffer
+  nvvk::Buffer             myBuffer;
+  std::vector<nvvk::Image> textures;
+  VkPipelineLayout         pipelineLayout = VK_NULL_HANDLE;
+  VkCommandBuffer          cmd            = VK_NULL_HANDLE;
+
+  // same bindings as for a DescriptorPack
+  nvvk::DescriptorBindings bindings;
+  bindings.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL);
+  bindings.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, uint32_t(textures.size()), VK_SHADER_STAGE_ALL);
+
+  nvvk::DescriptorBufferPack dbuffer;
+  NVVK_CHECK(dbuffer.init(bindings, &allocator));
+
+  // the writes are memcpy'd into the buffer, no vkUpdateDescriptorSets
+  nvvk::WriteSetContainer writeContainer;
+  writeContainer.append(dbuffer.makeWrite(0), myBuffer);
+  writeContainer.append(dbuffer.makeWrite(1), textures.data());
+  dbuffer.update(writeContainer);
+
+  // pipelines need VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT, binding is an offset
+  dbuffer.cmdBind(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout);
+
+  dbuffer.deinit();
+}
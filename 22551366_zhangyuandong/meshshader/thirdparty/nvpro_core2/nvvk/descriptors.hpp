@@ -24,10 +24,14 @@
 
 #include <volk.h>
 
+#include <nvutils/frame_arena.hpp>
+
 #include "resources.hpp"
 
 namespace nvvk {
 
+class ResourceAllocator;
+
 // Descriptor Bindings
 // Helps you build descriptor set layouts by storing information about each
 // binding's type, number of descriptors, stages, and other properties.
@@ -100,6 +104,8 @@ public:
 
   // Returns the bindings that were added
   const std::vector<VkDescriptorSetLayoutBinding>& getBindings() const { return m_bindings; }
+  // Returns the flags of the bindings, in the same order
+  const std::vector<VkDescriptorBindingFlags>& getBindingFlags() const { return m_bindingFlags; }
 
 private:
   std::vector<VkDescriptorSetLayoutBinding> m_bindings;
@@ -204,9 +210,19 @@ inline VkResult createPipelineLayout(VkDevice
 // Storage class for write set containers with their payload
 // Can be used to drive `vkUpdateDescriptorSets` as well
 // as `vkCmdPushDescriptorSet`
+// The payload is on the heap, or in `arena` for the containers recorded every frame
 class WriteSetContainer
 {
 public:
+  WriteSetContainer() = default;
+  explicit WriteSetContainer(nvutils::LinearArena* arena)
+      : m_writeSets(arena)
+      , m_writeAccels(arena)
+      , m_bufferOrImageDatas(arena)
+      , m_accelOrViewDatas(arena)
+  {
+  }
+
   // single element (writeSet.descriptorCount must be 1)
   void append(const VkWriteDescriptorSet& writeSet, const nvvk::Buffer& buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
   void append(const VkWriteDescriptorSet& writeSet, const nvvk::AccelerationStructure& accel);
@@ -257,11 +273,71 @@ private:
   };
   static_assert(sizeof(VkBufferView) == sizeof(VkAccelerationStructureKHR));
 
-  std::vector<VkWriteDescriptorSet>                         m_writeSets;
-  std::vector<VkWriteDescriptorSetAccelerationStructureKHR> m_writeAccels;
-  std::vector<BufferOrImageData>                            m_bufferOrImageDatas;
-  std::vector<AccelOrViewData>                              m_accelOrViewDatas;
-  bool                                                      m_needPointerUpdate = true;
+  nvutils::ArenaVector<VkWriteDescriptorSet>                         m_writeSets;
+  nvutils::ArenaVector<VkWriteDescriptorSetAccelerationStructureKHR> m_writeAccels;
+  nvutils::ArenaVector<BufferOrImageData>                            m_bufferOrImageDatas;
+  nvutils::ArenaVector<AccelOrViewData>                              m_accelOrViewDatas;
+  bool                                                               m_needPointerUpdate = true;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+// Alternative to `DescriptorPack` using VK_EXT_descriptor_buffer, from the same `DescriptorBindings`.
+// The `numSets` sets live in one host-visible buffer: updates write the descriptors straight into
+// its mapping (no `vkUpdateDescriptorSets`), and binding a set is just an offset into it.
+//
+// - The device needs `VkPhysicalDeviceDescriptorBufferFeaturesEXT::descriptorBuffer`
+// - Pipelines using the layout must be created with VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+// - Texel buffer views are not supported, buffer descriptors need explicit ranges
+// - As with regular descriptor sets, don't update a set the GPU may still be reading
+//
+// Usage:
+//   see usage_DescriptorBufferPack() in descriptors.cpp
+class DescriptorBufferPack
+{
+public:
+  DescriptorBufferPack() = default;
+  ~DescriptorBufferPack();
+
+  DescriptorBufferPack(const DescriptorBufferPack&)            = delete;
+  DescriptorBufferPack& operator=(const DescriptorBufferPack&) = delete;
+
+  VkResult init(const DescriptorBindings&        bindings,
+                ResourceAllocator*               allocator,
+                uint32_t                         numSets     = 1,
+                VkDescriptorSetLayoutCreateFlags layoutFlags = 0);
+  void     deinit();
+
+  VkDescriptorSetLayout        getLayout() const { return m_layout; }
+  const VkDescriptorSetLayout* getLayoutPtr() const { return &m_layout; }
+  const nvvk::Buffer&          getBuffer() const { return m_buffer; }
+  VkDeviceSize                 getSetOffset(uint32_t setIndex) const { return m_setStride * setIndex; }
+
+  // see `DescriptorBindings::getWriteSet`, the set is chosen in `update`
+  VkWriteDescriptorSet makeWrite(uint32_t binding, uint32_t dstArrayElement = ~0, uint32_t descriptorCount = 1) const
+  {
+    return m_bindings.getWriteSet(binding, VK_NULL_HANDLE, dstArrayElement, descriptorCount);
+  }
+
+  // writes the descriptors into the buffer mapping
+  void update(WriteSetContainer& writes, uint32_t setIndex = 0);
+  void update(std::span<const VkWriteDescriptorSet> writes, uint32_t setIndex = 0);
+
+  // binds the buffer and points set `firstSet` of `layout` at `setIndex`
+  void cmdBind(VkCommandBuffer cmd, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet = 0, uint32_t setIndex = 0) const;
+
+private:
+  size_t getDescriptorSize(VkDescriptorType type) const;
+
+  DescriptorBindings                            m_bindings;
+  VkDescriptorSetLayout                         m_layout = VK_NULL_HANDLE;
+  nvvk::Buffer                                  m_buffer;
+  VkBufferUsageFlags                            m_bufferUsage = 0;
+  VkDeviceSize                                  m_setStride   = 0;
+  std::vector<VkDeviceSize>                     m_bindingOffsets;  // per `VkDescriptorSetLayoutBinding::binding`
+  VkPhysicalDeviceDescriptorBufferPropertiesEXT m_props{};
+
+  ResourceAllocator* m_allocator = nullptr;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <volk.h>
+
+#include "device_group.hpp"
+#include "barriers.hpp"
+#include "check_error.hpp"
+#include "context.hpp"
+
+void nvvk::DeviceGroup::init(VkDevice device, uint32_t deviceCount, DeviceGroupMode mode)
+{
+  assert(deviceCount >= 1 && deviceCount <= 32);
+  m_device      = device;
+  m_deviceCount = std::clamp(deviceCount, 1U, 32U);
+  m_mode        = m_deviceCount > 1 ? mode : DeviceGroupMode::eSingle;
+  m_splitWeights.assign(m_deviceCount, 1.0f);
+}
+
+uint32_t nvvk::DeviceGroup::getFrameDeviceMask(uint64_t frameNumber) const
+{
+  switch(m_mode)
+  {
+    case DeviceGroupMode::eAlternateFrame:
+      return 1U << uint32_t(frameNumber % m_deviceCount);
+    case DeviceGroupMode::eSplitFrame:
+      return getAllDeviceMask();
+    default:
+      return 1U;
+  }
+}
+
+uint32_t nvvk::DeviceGroup::getFrameDeviceIndex(uint64_t frameNumber) const
+{
+  return m_mode == DeviceGroupMode::eAlternateFrame ? uint32_t(frameNumber % m_deviceCount) : 0;
+}
+
+void nvvk::DeviceGroup::setSplitWeights(std::span<const float> weights)
+{
+  assert(weights.size() == m_deviceCount);
+  m_splitWeights.assign(weights.begin(), weights.end());
+}
+
+VkRect2D nvvk::DeviceGroup::getSplitRect(VkExtent2D extent, uint32_t deviceIndex) const
+{
+  float total = 0.0f;
+  float start = 0.0f;
+  for(uint32_t i = 0; i < m_deviceCount; i++)
+  {
+    start += i < deviceIndex ? m_splitWeights[i] : 0.0f;
+    total += m_splitWeights[i];
+  }
+
+  // the last band ends at the bottom, without rounding gaps
+  const uint32_t y0 = uint32_t(std::lround(double(extent.height) * start / total));
+  const uint32_t y1 = deviceIndex + 1 == m_deviceCount ? extent.height :
+                                                         uint32_t(std::lround(double(extent.height) * (start + m_splitWeights[deviceIndex]) / total));
+  return {{0, int32_t(y0)}, {extent.width, y1 - y0}};
+}
+
+void nvvk::DeviceGroup::balanceSplit(std::span<const double> deviceTimes, float damping)
+{
+  assert(deviceTimes.size() == m_deviceCount);
+
+  float total = 0.0f;
+  for(uint32_t i = 0; i < m_deviceCount; i++)
+  {
+    if(deviceTimes[i] <= 0.0)
+    {
+      return;  // no timing yet
+    }
+    total += m_splitWeights[i];
+  }
+
+  // the speed of a device is its band per time, the bands of equal times are proportional to the speeds
+  std::vector<float> speeds(m_deviceCount);
+  float              totalSpeed = 0.0f;
+  for(uint32_t i = 0; i < m_deviceCount; i++)
+  {
+    speeds[i] = float(m_splitWeights[i] / deviceTimes[i]);
+    totalSpeed += speeds[i];
+  }
+  for(uint32_t i = 0; i < m_deviceCount; i++)
+  {
+    const float target = total * speeds[i] / totalSpeed;
+    // keeps a band on every device, to go on measuring it
+    m_splitWeights[i] = std::max(damping * m_splitWeights[i] + (1.0f - damping) * target, 0.05f * total / float(m_deviceCount));
+  }
+}
+
+VkDeviceGroupRenderPassBeginInfo nvvk::DeviceGroup::makeRenderingDeviceGroupInfo(VkExtent2D extent, std::vector<VkRect2D>& rects) const
+{
+  rects.resize(m_deviceCount);
+  for(uint32_t i = 0; i < m_deviceCount; i++)
+  {
+    rects[i] = getSplitRect(extent, i);
+  }
+  return {
+      .sType                 = VK_STRUCTURE_TYPE_DEVICE_GROUP_RENDER_PASS_BEGIN_INFO,
+      .deviceMask            = getAllDeviceMask(),
+      .deviceRenderAreaCount = m_deviceCount,
+      .pDeviceRenderAreas    = rects.data(),
+  };
+}
+
+VkPeerMemoryFeatureFlags nvvk::DeviceGroup::getPeerMemoryFeatures(uint32_t heapIndex, uint32_t localDevice, uint32_t remoteDevice) const
+{
+  VkPeerMemoryFeatureFlags features = 0;
+  vkGetDeviceGroupPeerMemoryFeatures(m_device, heapIndex, localDevice, remoteDevice, &features);
+  return features;
+}
+
+VkResult nvvk::DeviceGroup::createPeerImage(const ResourceAllocator& allocator,
+                                            const nvvk::Image&       image,
+                                            const VkImageCreateInfo& imageInfo,
+                                            uint32_t                 targetDevice,
+                                            VkImage&                 peerImage) const
+{
+  assert((imageInfo.flags & VK_IMAGE_CREATE_ALIAS_BIT) && "Peer images alias the memory of the image");
+  NVVK_FAIL_RETURN(vkCreateImage(m_device, &imageInfo, nullptr, &peerImage));
+
+  // the instance of every device binds the memory of the target
+  const std::vector<uint32_t>            deviceIndices(m_deviceCount, targetDevice);
+  const VkBindImageMemoryDeviceGroupInfo groupInfo{
+      .sType            = VK_STRUCTURE_TYPE_BIND_IMAGE_MEMORY_DEVICE_GROUP_INFO,
+      .deviceIndexCount = m_deviceCount,
+      .pDeviceIndices   = deviceIndices.data(),
+  };
+  const VkResult result = vmaBindImageMemory2(allocator, image.allocation, 0, peerImage, &groupInfo);
+  if(result != VK_SUCCESS)
+  {
+    vkDestroyImage(m_device, peerImage, nullptr);
+    peerImage = VK_NULL_HANDLE;
+  }
+  return result;
+}
+
+void nvvk::DeviceGroup::cmdGatherSplit(VkCommandBuffer    cmd,
+                                       VkImage            image,
+                                       VkImage            peerImage,
+                                       VkExtent2D         extent,
+                                       VkImageAspectFlags aspectMask,
+                                       uint32_t           targetDevice) const
+{
+  for(uint32_t i = 0; i < m_deviceCount; i++)
+  {
+    const VkRect2D rect = getSplitRect(extent, i);
+    if(i == targetDevice || rect.extent.height == 0)
+    {
+      continue;
+    }
+
+    vkCmdSetDeviceMask(cmd, 1U << i);
+    // after the rendering of the band
+    cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+
+    const VkImageCopy region{
+        .srcSubresource = {aspectMask, 0, 0, 1},
+        .srcOffset      = {rect.offset.x, rect.offset.y, 0},
+        .dstSubresource = {aspectMask, 0, 0, 1},
+        .dstOffset      = {rect.offset.x, rect.offset.y, 0},
+        .extent         = {rect.extent.width, rect.extent.height, 1},
+    };
+    vkCmdCopyImage(cmd, image, VK_IMAGE_LAYOUT_GENERAL, peerImage, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+  }
+  vkCmdSetDeviceMask(cmd, getAllDeviceMask());
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_DeviceGroup()
+{
+  nvvk::Context           context;    // EX: initialized with ContextInitInfo::useDeviceGroup
+  nvvk::ResourceAllocator allocator;  // EX: initialized somewhere
+  nvvk::Image             colorImage;  // EX: created with VK_IMAGE_CREATE_ALIAS_BIT, in VK_IMAGE_LAYOUT_GENERAL
+  VkImageCreateInfo       colorInfo{};  // EX: its create info
+  VkExtent2D              extent{1920, 1080};
+
+  nvvk::DeviceGroup deviceGroup;
+  deviceGroup.init(context.getDevice(), context.getDeviceCount(), nvvk::DeviceGroupMode::eSplitFrame);
+
+  // device 0 gathers the bands
+  VkImage peerImage{};
+  NVVK_CHECK(deviceGroup.createPeerImage(allocator, colorImage, colorInfo, 0, peerImage));
+
+  // each frame, in a command buffer running on all devices
+  VkCommandBuffer                        cmd{};
+  std::vector<VkRect2D>                  rects;
+  const VkDeviceGroupRenderPassBeginInfo groupInfo = deviceGroup.makeRenderingDeviceGroupInfo(extent, rects);
+  const VkRenderingInfo                  renderingInfo{
+                       .sType      = VK_STRUCTURE_TYPE_RENDERING_INFO,
+                       .pNext      = &groupInfo,
+                       .renderArea = {{0, 0}, extent},
+                       .layerCount = 1,
+  };  // ... and the attachments
+  vkCmdBeginRendering(cmd, &renderingInfo);
+  // ... draw the whole frame, each device rasterizes its band
+  vkCmdEndRendering(cmd);
+  deviceGroup.cmdGatherSplit(cmd, colorImage.image, peerImage, extent, VK_IMAGE_ASPECT_COLOR_BIT, 0);
+  // end and submit with a semaphore signaled by the other devices, use colorImage on device 0 in the next submit
+
+  // with the GPU times of the devices, e.g. from one nvvk::ProfilerGpuTimer per device (setDeviceIndex)
+  const std::vector<double> deviceTimes(deviceGroup.getDeviceCount(), 8.0);
+  deviceGroup.balanceSplit(deviceTimes);
+
+  vkDestroyImage(context.getDevice(), peerImage, nullptr);
+}
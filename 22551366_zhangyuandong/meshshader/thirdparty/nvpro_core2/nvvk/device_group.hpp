@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include "resource_allocator.hpp"
+
+namespace nvvk {
+
+enum class DeviceGroupMode
+{
+  eSingle,          // device 0 only
+  eAlternateFrame,  // each frame on one device, in turn
+  eSplitFrame,      // each frame on all devices, each rendering a band of the image
+};
+
+//-----------------------------------------------------------------
+// Device Group
+//
+// Helpers for a logical device made of several physical devices (`ContextInitInfo::useDeviceGroup`).
+// The resources are replicated: the memory of device-local heaps has one instance per device, which
+// each device reads and writes on its own. The commands run on the devices of the device mask of the
+// command buffer and submit, vkCmdSetDeviceMask restricts the following commands to some of them.
+//
+// - Alternate frames: the frame runs on `getFrameDeviceMask`, see `nvapp::ApplicationCreateInfo::deviceGroupMode`.
+// - Split frames: each device renders the band `getSplitRect` of the image, with `makeRenderingDeviceGroupInfo`
+//   chained to VkRenderingInfo. `cmdGatherSplit` copies the bands of the other devices into the instance of the
+//   target device through a peer image (`createPeerImage`). The devices don't synchronize within a command buffer:
+//   end the submit after the gather, the next submit consumes the image on the target device after waiting for a
+//   semaphore. `balanceSplit` resizes the bands from the GPU times of the devices.
+//
+// Usage:
+//   see usage_DeviceGroup in device_group.cpp
+//-----------------------------------------------------------------
+class DeviceGroup
+{
+public:
+  void init(VkDevice device, uint32_t deviceCount, DeviceGroupMode mode);
+
+  uint32_t        getDeviceCount() const { return m_deviceCount; }
+  DeviceGroupMode getMode() const { return m_mode; }
+  uint32_t        getAllDeviceMask() const { return (1U << m_deviceCount) - 1; }
+
+  // Devices of the frame: one in turn for alternate frames, all for split frames, device 0 otherwise
+  uint32_t getFrameDeviceMask(uint64_t frameNumber) const;
+  // First device of the frame, e.g. the one signaling its semaphores
+  uint32_t getFrameDeviceIndex(uint64_t frameNumber) const;
+
+  // Split frame: horizontal bands, the height of each proportional to its weight (equal by default)
+  void     setSplitWeights(std::span<const float> weights);
+  VkRect2D getSplitRect(VkExtent2D extent, uint32_t deviceIndex) const;
+  // Weights moving towards equal GPU times of the devices, from their times of the last frame
+  void balanceSplit(std::span<const double> deviceTimes, float damping = 0.5f);
+
+  // To chain to VkRenderingInfo, each device renders its band. Fills `rects`, which must outlive the begin.
+  VkDeviceGroupRenderPassBeginInfo makeRenderingDeviceGroupInfo(VkExtent2D extent, std::vector<VkRect2D>& rects) const;
+
+  VkPeerMemoryFeatureFlags getPeerMemoryFeatures(uint32_t heapIndex, uint32_t localDevice, uint32_t remoteDevice) const;
+
+  // A second VkImage on the memory of `image`, whose instance on every device is the memory of `targetDevice`.
+  // Both images must be created with VK_IMAGE_CREATE_ALIAS_BIT, and the memory heap must support
+  // VK_PEER_MEMORY_FEATURE_COPY_DST_BIT. Transition the peer image to VK_IMAGE_LAYOUT_GENERAL before its first use.
+  VkResult createPeerImage(const ResourceAllocator& allocator,
+                           const nvvk::Image&       image,
+                           const VkImageCreateInfo& imageInfo,
+                           uint32_t                 targetDevice,
+                           VkImage&                 peerImage) const;
+
+  // Split frame: each other device copies its band of `image` to `peerImage`, both in VK_IMAGE_LAYOUT_GENERAL.
+  // Leaves all devices in the device mask.
+  void cmdGatherSplit(VkCommandBuffer cmd, VkImage image, VkImage peerImage, VkExtent2D extent, VkImageAspectFlags aspectMask, uint32_t targetDevice) const;
+
+private:
+  VkDevice           m_device{};
+  uint32_t           m_deviceCount = 1;
+  DeviceGroupMode    m_mode        = DeviceGroupMode::eSingle;
+  std::vector<float> m_splitWeights{1.0f};
+};
+
+}  // namespace nvvk
@@ -17,6 +17,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <array>
 
 #include "gbuffers.hpp"
@@ -29,6 +30,9 @@ nvvk::GBuffer::GBuffer(nvvk::GBuffer&& other) noexcept
   assert(m_info.allocator == nullptr && "Missing deinit()");
   std::swap(m_res, other.m_res);
   std::swap(m_size, other.m_size);
+  std::swap(m_displaySize, other.m_displaySize);
+  std::swap(m_allocatedSize, other.m_allocatedSize);
+  std::swap(m_renderScale, other.m_renderScale);
   std::swap(m_info, other.m_info);
   std::swap(m_descLayout, other.m_descLayout);
 }
@@ -40,6 +44,9 @@ nvvk::GBuffer& nvvk::GBuffer::operator=(nvvk::GBuffer&& other) noexcept
     assert(m_info.allocator == nullptr && "Missing deinit()");
     std::swap(m_res, other.m_res);
     std::swap(m_size, other.m_size);
+    std::swap(m_displaySize, other.m_displaySize);
+    std::swap(m_allocatedSize, other.m_allocatedSize);
+    std::swap(m_renderScale, other.m_renderScale);
     std::swap(m_info, other.m_info);
     std::swap(m_descLayout, other.m_descLayout);
   }
@@ -61,7 +68,10 @@ void nvvk::GBuffer::deinit()
 {
   deinitResources();
   m_res        = {};
-  m_size       = {};
+  m_size          = {};
+  m_displaySize   = {};
+  m_allocatedSize = {};
+  m_renderScale   = 1.0f;
   m_descLayout = {};
 
   m_info = {};
@@ -69,16 +79,34 @@ void nvvk::GBuffer::deinit()
 
 VkResult nvvk::GBuffer::update(VkCommandBuffer cmd, VkExtent2D newSize)
 {
-  if(newSize.width == m_size.width && newSize.height == m_size.height)
+  if(newSize.width == m_displaySize.width && newSize.height == m_displaySize.height)
   {
     return VK_SUCCESS;  // Nothing to do
   }
 
+  // Size classes: resizing within the same one only changes the rendered area
+  const uint32_t   granularity = std::max(m_info.sizeGranularity, 1U);
+  const VkExtent2D allocatedSize{(newSize.width + granularity - 1) / granularity * granularity,
+                                 (newSize.height + granularity - 1) / granularity * granularity};
+  m_displaySize = newSize;
+  setRenderScale(m_renderScale);
+  if(allocatedSize.width == m_allocatedSize.width && allocatedSize.height == m_allocatedSize.height)
+  {
+    return VK_SUCCESS;
+  }
+
   deinitResources();
-  m_size = newSize;
+  m_allocatedSize = allocatedSize;
   return initResources(cmd);
 }
 
+void nvvk::GBuffer::setRenderScale(float scale)
+{
+  m_renderScale = std::clamp(scale, 0.01f, 1.0f);
+  m_size        = {std::max(1U, uint32_t(float(m_displaySize.width) * m_renderScale + 0.5f)),
+                   std::max(1U, uint32_t(float(m_displaySize.height) * m_renderScale + 0.5f))};
+}
+
 VkDescriptorSet nvvk::GBuffer::getDescriptorSet(uint32_t i) const
 {
   return m_res.uiDescriptorSets[i];
@@ -89,6 +117,28 @@ VkExtent2D nvvk::GBuffer::getSize() const
   return m_size;
 }
 
+VkExtent2D nvvk::GBuffer::getDisplaySize() const
+{
+  return m_displaySize;
+}
+
+float nvvk::GBuffer::getRenderScale() const
+{
+  return m_renderScale;
+}
+
+VkExtent2D nvvk::GBuffer::getAllocatedSize() const
+{
+  return m_allocatedSize;
+}
+
+glm::vec2 nvvk::GBuffer::getUVScale() const
+{
+  if(m_allocatedSize.width == 0 || m_allocatedSize.height == 0)
+    return glm::vec2(1.0f);
+  return glm::vec2(float(m_size.width) / float(m_allocatedSize.width), float(m_size.height) / float(m_allocatedSize.height));
+}
+
 VkImage nvvk::GBuffer::getColorImage(uint32_t i /*= 0*/) const
 {
   return m_res.gBufferColor[i].image;
@@ -156,7 +206,7 @@ VkResult nvvk::GBuffer::initResources(VkCommandBuffer cmd)
         .sType       = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .imageType   = VK_IMAGE_TYPE_2D,
         .format      = m_info.colorFormats[c],
-        .extent      = {m_size.width, m_size.height, 1},
+        .extent      = {m_allocatedSize.width, m_allocatedSize.height, 1},
         .mipLevels   = 1,
         .arrayLayers = 1,
         .samples     = m_info.sampleCount,
@@ -189,7 +239,7 @@ VkResult nvvk::GBuffer::initResources(VkCommandBuffer cmd)
         .sType       = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .imageType   = VK_IMAGE_TYPE_2D,
         .format      = m_info.depthFormat,
-        .extent      = {m_size.width, m_size.height, 1},
+        .extent      = {m_allocatedSize.width, m_allocatedSize.height, 1},
         .mipLevels   = 1,
         .arrayLayers = 1,
         .samples     = m_info.sampleCount,
@@ -336,6 +386,10 @@ void nvvk::GBuffer::deinitResources()
   VkCommandBuffer cmd = VK_NULL_HANDLE;  // EX: create a command buffer
   gbuffer.update(cmd, VkExtent2D{600, 480});
 
+  // Dynamic resolution: render the 300x240 top-left rectangle (viewport/scissor of getSize()),
+  // then upscale it to getDisplaySize(), sampling with getUVScale()
+  gbuffer.setRenderScale(0.5f);
+
   // Get the image views
   VkImageView colorImageViewRgba8   = gbuffer.getColorImageView(0);
   VkImageView colorImageViewRgbaF32 = gbuffer.getColorImageView(1);
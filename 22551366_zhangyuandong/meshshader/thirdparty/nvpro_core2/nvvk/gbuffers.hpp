@@ -20,6 +20,8 @@
 #pragma once
 #include <vector>
 
+#include <glm/glm.hpp>
+
 #include "resource_allocator.hpp"
 
 namespace nvvk {
@@ -41,6 +43,7 @@ struct GBufferInitInfo
   VkSampleCountFlagBits    sampleCount{VK_SAMPLE_COUNT_1_BIT};  // MSAA sample count (default: no MSAA)
   VkSampler                imageSampler{};                      // Linear sampler for displaying the images (ImGui)
   VkDescriptorPool         descriptorPool{};                    // Pool for the ImGui descriptors
+  uint32_t                 sizeGranularity{1};                  // Images are allocated rounded up to this, see `update`
 };
 
 /*--
@@ -77,12 +80,24 @@ public:
   void deinit();
 
   // Set or reset the size of the G-Buffers
+  // With a `sizeGranularity` > 1, the images are only re-created when the size rounded up to it changes,
+  // rendering happens in the top-left `getSize()` rectangle of the `getAllocatedSize()` images:
+  // set the viewport/scissor to `getSize()` and sample with `getUVScale()`.
   VkResult update(VkCommandBuffer cmd, VkExtent2D newSize);
 
+  // Dynamic resolution: render in a scaled `getSize()` rectangle of the images allocated for the size given
+  // to `update` (`getDisplaySize()`), which the application upscales. Changing the scale never re-creates
+  // the images, the scale is clamped to (0, 1].
+  void setRenderScale(float scale);
+
 
   //--- Getters for the GBuffer resources -------------------------
   VkDescriptorSet              getDescriptorSet(uint32_t i = 0) const;  // Can be use as ImTextureID for ImGui
-  VkExtent2D                   getSize() const;
+  VkExtent2D                   getSize() const;         // Rendered size, the display size scaled by the render scale
+  VkExtent2D                   getDisplaySize() const;  // Size given to `update`
+  float                        getRenderScale() const;
+  VkExtent2D                   getAllocatedSize() const;
+  glm::vec2                    getUVScale() const;  // getSize() / getAllocatedSize()
   VkImage                      getColorImage(uint32_t i = 0) const;
   VkImage                      getDepthImage() const;
   VkImageView                  getColorImageView(uint32_t i = 0) const;
@@ -134,7 +149,10 @@ private:
     std::vector<VkDescriptorSet> uiDescriptorSets{};  // ImGui descriptor sets
   } m_res;                                            // All Vulkan resources
 
-  VkExtent2D m_size{};  // Width and height of the buffers
+  VkExtent2D m_size{};           // Width and height of the buffers
+  VkExtent2D m_displaySize{};    // Size given to `update`, `m_size` before the render scale
+  VkExtent2D m_allocatedSize{};  // Width and height of the images, `m_displaySize` rounded up to `sizeGranularity`
+  float      m_renderScale = 1.0f;
 
   GBufferInitInfo       m_info{};        // Configuration
   VkDescriptorSetLayout m_descLayout{};  // Layout for the ImGui descriptors
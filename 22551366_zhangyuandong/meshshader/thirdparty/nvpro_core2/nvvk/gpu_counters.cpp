@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cstring>
+
+#include "barriers.hpp"
+#include "check_error.hpp"
+#include "debug_util.hpp"
+#include "gpu_counters.hpp"
+
+VkResult nvvk::GpuCounters::init(const InitInfo& info)
+{
+  assert(m_allocator == nullptr && info.allocator && info.size > 0 && info.numFrames > 0);
+
+  m_allocator        = info.allocator;
+  m_profilerTimeline = info.profilerTimeline;
+  m_size             = info.size;
+
+  NVVK_FAIL_RETURN(m_allocator->createBuffer(m_deviceBuffer, m_size,
+                                             VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT
+                                                 | VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
+                                             VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
+  NVVK_DBG_NAME(m_deviceBuffer.buffer);
+
+  m_readbackBuffers.resize(info.numFrames);
+  m_readbackFrames.assign(info.numFrames, kNoFrame);
+  for(Buffer& buffer : m_readbackBuffers)
+  {
+    NVVK_FAIL_RETURN(m_allocator->createBuffer(buffer, m_size, VK_BUFFER_USAGE_2_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+                                               VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT));
+    NVVK_DBG_NAME(buffer.buffer);
+  }
+  m_snapshot.assign(m_size, 0);
+  m_snapshotFrame = kNoFrame;
+  m_frameNumber   = 0;
+  return VK_SUCCESS;
+}
+
+void nvvk::GpuCounters::deinit()
+{
+  if(m_allocator == nullptr)
+  {
+    return;
+  }
+  if(m_profilerTimeline)
+  {
+    for(const Counter& counter : m_counters)
+    {
+      m_profilerTimeline->removeCounter(counter.name);
+    }
+  }
+  m_allocator->destroyBuffer(m_deviceBuffer);
+  for(Buffer& buffer : m_readbackBuffers)
+  {
+    m_allocator->destroyBuffer(buffer);
+  }
+  m_readbackBuffers.clear();
+  m_readbackFrames.clear();
+  m_counters.clear();
+  m_snapshot.clear();
+  m_allocator = nullptr;
+}
+
+uint32_t nvvk::GpuCounters::addCounter(const std::string& name, VkDeviceSize offset, Type type)
+{
+  [[maybe_unused]] VkDeviceSize size = type == Type::eUint64 ? sizeof(uint64_t) : sizeof(uint32_t);
+  assert(offset % size == 0 && offset + size <= m_size && "counter outside of the buffer, or misaligned");
+  m_counters.push_back({name, offset, type});
+  return uint32_t(m_counters.size() - 1);
+}
+
+uint64_t nvvk::GpuCounters::getValue(uint32_t counter) const
+{
+  const Counter& c = m_counters[counter];
+  if(c.type == Type::eUint64)
+  {
+    uint64_t value;
+    memcpy(&value, m_snapshot.data() + c.offset, sizeof(value));
+    return value;
+  }
+  uint32_t value;
+  memcpy(&value, m_snapshot.data() + c.offset, sizeof(value));
+  return value;
+}
+
+void nvvk::GpuCounters::cmdBeginFrame(VkCommandBuffer cmd, uint32_t frameSlot, VkPipelineStageFlags2 dstStages)
+{
+  // The frame previously recorded in this slot has completed
+  if(m_readbackFrames[frameSlot] != kNoFrame)
+  {
+    memcpy(m_snapshot.data(), m_readbackBuffers[frameSlot].mapping, m_size);
+    m_snapshotFrame             = m_readbackFrames[frameSlot];
+    m_readbackFrames[frameSlot] = kNoFrame;
+    if(m_profilerTimeline)
+    {
+      for(uint32_t i = 0; i < getCounterCount(); i++)
+      {
+        m_profilerTimeline->setCounter(m_counters[i].name, double(getValue(i)));
+      }
+    }
+  }
+  m_frameSlot = frameSlot;
+  m_frameNumber++;
+
+  // The copy of the previous frame may still be reading the buffer
+  cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+  vkCmdFillBuffer(cmd, m_deviceBuffer.buffer, 0, m_size, 0);
+  cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, dstStages);
+}
+
+void nvvk::GpuCounters::cmdEndFrame(VkCommandBuffer cmd, VkPipelineStageFlags2 srcStages)
+{
+  cmdMemoryBarrier(cmd, srcStages, VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+  const VkBufferCopy region{.size = m_size};
+  vkCmdCopyBuffer(cmd, m_deviceBuffer.buffer, m_readbackBuffers[m_frameSlot].buffer, 1, &region);
+  m_readbackFrames[m_frameSlot] = m_frameNumber;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_GpuCounters()
+{
+  // Shared with the shaders, which get the address from getDeviceAddress() (e.g. in push constants)
+  struct Statistics
+  {
+    uint32_t bladesDrawn;
+    uint64_t fragmentsShaded;
+  };
+
+  nvvk::ResourceAllocator    allocator;           // EX: initialized allocator
+  nvutils::ProfilerTimeline* profilerTimeline{};  // EX: a timeline of the nvutils::ProfilerManager
+  uint32_t                   numFrames = 3;       // EX: m_app->getFrameCycleSize()
+
+  nvvk::GpuCounters counters;
+  NVVK_CHECK(counters.init({.allocator = &allocator, .size = sizeof(Statistics), .numFrames = numFrames, .profilerTimeline = profilerTimeline}));
+  uint32_t bladesDrawn = counters.addCounter("Blades drawn", offsetof(Statistics, bladesDrawn));
+  counters.addCounter("Fragments shaded", offsetof(Statistics, fragmentsShaded), nvvk::GpuCounters::Type::eUint64);
+
+  // Each frame
+  {
+    VkCommandBuffer cmd       = VK_NULL_HANDLE;  // EX: the command buffer of the frame
+    uint32_t        frameSlot = 0;               // EX: m_app->getFrameCycleIndex()
+    counters.cmdBeginFrame(cmd, frameSlot);
+    // ... draws incrementing the counters ...
+    counters.cmdEndFrame(cmd);
+
+    // Values of a completed frame, also in the profiler tables
+    if(counters.hasData())
+    {
+      [[maybe_unused]] uint64_t blades = counters.getValue(bladesDrawn);
+    }
+  }
+
+  counters.deinit();
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+/**
+  # class nvvk::GpuCounters
+
+  nvvk::GpuCounters holds named counters that shaders increment during a frame, and reads them back without stalls.
+
+  The counters live in a device buffer, at byte offsets chosen by the application; usually they are the fields
+  of a struct shared with the shaders, which get the buffer through its device address. Adding a counter is then
+  one line on each side:
+    - host: `counters.addCounter("Blades drawn", offsetof(shaderio::Statistics, bladesDrawn));`
+    - shader: `InterlockedAdd(stats->bladesDrawn, 1);`
+
+  Every frame:
+  - call cmdBeginFrame() with the frame slot, before the shaders write the counters: the buffer is cleared
+  - call cmdEndFrame() after the last shader writing them: the buffer is copied into the readback buffer of the slot
+
+  When a slot comes around again, the application has waited for its frame to complete: cmdBeginFrame() picks up
+  its values, which lag the GPU by the number of frames in flight, and sets them as counters of the
+  `nvutils::ProfilerTimeline` (shown with the timers by `nvapp::ElementProfiler`).
+
+  See usage_GpuCounters() for a complete example.
+*/
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include <nvutils/profiler.hpp>
+
+#include "resource_allocator.hpp"
+
+namespace nvvk {
+
+class GpuCounters
+{
+public:
+  enum class Type
+  {
+    eUint32,
+    eUint64,
+  };
+
+  struct InitInfo
+  {
+    ResourceAllocator*         allocator{};
+    VkDeviceSize               size{};              // size of the device buffer holding the counters
+    uint32_t                   numFrames = 3;       // frames in flight, `nvapp::Application::getFrameCycleSize()`
+    nvutils::ProfilerTimeline* profilerTimeline{};  // optional, receives the values as counters
+  };
+
+  GpuCounters() = default;
+  ~GpuCounters() { assert(m_allocator == nullptr); }  // Missing deinit()
+
+  VkResult init(const InitInfo& info);
+  void     deinit();
+
+  // Registers a counter at `offset` bytes in the buffer, returns its index for getValue()
+  uint32_t addCounter(const std::string& name, VkDeviceSize offset, Type type = Type::eUint32);
+
+  // Device buffer written by the shaders
+  VkBuffer        getBuffer() const { return m_deviceBuffer.buffer; }
+  VkDeviceAddress getDeviceAddress() const { return m_deviceBuffer.address; }
+
+  // Picks up the values of the frame previously recorded in `frameSlot`, which has completed,
+  // then clears the buffer and makes it visible to the writes of `dstStages`
+  void cmdBeginFrame(VkCommandBuffer cmd, uint32_t frameSlot, VkPipelineStageFlags2 dstStages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+  // Copies the buffer into the readback buffer of the slot, after the writes of `srcStages`
+  void cmdEndFrame(VkCommandBuffer cmd, VkPipelineStageFlags2 srcStages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+
+  // Values of the last completed frame, zero until the first one completes
+  bool     hasData() const { return m_snapshotFrame != kNoFrame; }
+  uint64_t getFrameNumber() const { return m_frameNumber; }            // frames begun so far
+  uint64_t getSnapshotFrameNumber() const { return m_snapshotFrame; }  // frame that produced the values
+  uint64_t getValue(uint32_t counter) const;
+
+  // All the values of the last completed frame, e.g. as the struct shared with the shaders
+  template <typename T>
+  const T& get() const
+  {
+    assert(sizeof(T) <= m_snapshot.size());
+    return *reinterpret_cast<const T*>(m_snapshot.data());
+  }
+
+  uint32_t           getCounterCount() const { return uint32_t(m_counters.size()); }
+  const std::string& getCounterName(uint32_t counter) const { return m_counters[counter].name; }
+
+private:
+  static constexpr uint64_t kNoFrame = ~uint64_t(0);
+
+  struct Counter
+  {
+    std::string  name;
+    VkDeviceSize offset{};
+    Type         type{};
+  };
+
+  ResourceAllocator*         m_allocator{};
+  nvutils::ProfilerTimeline* m_profilerTimeline{};
+  VkDeviceSize               m_size{};
+  std::vector<Counter>       m_counters;
+
+  Buffer                m_deviceBuffer;
+  std::vector<Buffer>   m_readbackBuffers;  // one host-visible mapped buffer per frame in flight
+  std::vector<uint64_t> m_readbackFrames;   // frame whose copy is pending in each buffer
+  std::vector<uint8_t>  m_snapshot;
+  uint64_t              m_snapshotFrame = kNoFrame;
+  uint64_t              m_frameNumber   = 0;
+  uint32_t              m_frameSlot     = 0;
+};
+
+}  // namespace nvvk
@@ -17,7 +17,9 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 
+#include "debug_util.hpp"
 #include "graphics_pipeline.hpp"
+#include "pipeline.hpp"
 
 namespace nvvk {
 
@@ -185,7 +187,118 @@ VkResult GraphicsPipelineCreator::createGraphicsPipeline(VkDevice
 
   buildPipelineCreateInfo(pipelineInfoTemp, graphicsState);
 
+  PipelineCreationFeedback feedback;
+  feedback.chain(pipelineInfoTemp.pNext, pipelineInfoTemp.stageCount);
+
   VkResult result = vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfoTemp, nullptr, pPipeline);
+  if(result == VK_SUCCESS)
+  {
+    feedback.record(debugName, {pipelineInfoTemp.pStages, pipelineInfoTemp.stageCount});
+    if(!debugName.empty())
+    {
+      DebugUtil::getInstance().setObjectName(*pPipeline, debugName);
+    }
+  }
+
+  return result;
+}
+
+VkResult GraphicsPipelineCreator::createGraphicsPipelineLibrary(VkDevice                          device,
+                                                                VkPipelineCache                   cache,
+                                                                const GraphicsPipelineState&      graphicsState,
+                                                                VkGraphicsPipelineLibraryFlagsEXT libraryFlags,
+                                                                VkPipeline*                       pLibrary)
+{
+  VkGraphicsPipelineCreateInfo pipelineInfoTemp;
+
+  buildPipelineCreateInfo(pipelineInfoTemp, graphicsState);
+
+  pipelineInfoTemp.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+  if(flags2 != 0)
+  {
+    // flags2 takes precedence over pipelineInfo.flags
+    m_flags2Info.flags |= VK_PIPELINE_CREATE_2_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_2_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+  }
+
+  m_libraryInfo.flags   = libraryFlags;
+  m_libraryInfo.pNext   = pipelineInfoTemp.pNext;
+  pipelineInfoTemp.pNext = &m_libraryInfo;
+
+  // stages of other parts are not allowed within a library
+  const VkShaderStageFlags preRasterStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT
+                                             | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT | VK_SHADER_STAGE_GEOMETRY_BIT
+                                             | VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT;
+
+  VkShaderStageFlags usedStages = 0;
+  if(libraryFlags & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)
+  {
+    usedStages |= preRasterStages;
+  }
+  if(libraryFlags & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)
+  {
+    usedStages |= VK_SHADER_STAGE_FRAGMENT_BIT;
+  }
+
+  m_libraryShaderStages.clear();
+  for(uint32_t i = 0; i < pipelineInfoTemp.stageCount; i++)
+  {
+    if(pipelineInfoTemp.pStages[i].stage & usedStages)
+    {
+      m_libraryShaderStages.push_back(pipelineInfoTemp.pStages[i]);
+    }
+  }
+  pipelineInfoTemp.stageCount = static_cast<uint32_t>(m_libraryShaderStages.size());
+  pipelineInfoTemp.pStages    = m_libraryShaderStages.data();
+
+  PipelineCreationFeedback feedback;
+  feedback.chain(pipelineInfoTemp.pNext, pipelineInfoTemp.stageCount);
+
+  VkResult result = vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfoTemp, nullptr, pLibrary);
+  if(result == VK_SUCCESS)
+  {
+    feedback.record(debugName + " (library)", {pipelineInfoTemp.pStages, pipelineInfoTemp.stageCount});
+  }
+
+  return result;
+}
+
+VkResult GraphicsPipelineCreator::linkGraphicsPipeline(VkDevice                    device,
+                                                       VkPipelineCache             cache,
+                                                       std::span<const VkPipeline> libraries,
+                                                       bool                        linkTimeOptimization,
+                                                       VkPipeline*                 pPipeline) const
+{
+  VkPipelineLibraryCreateInfoKHR libraryInfo{
+      .sType        = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+      .libraryCount = static_cast<uint32_t>(libraries.size()),
+      .pLibraries   = libraries.data(),
+  };
+
+  VkPipelineCreateFlags2CreateInfo flags2Info{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATE_FLAGS_2_CREATE_INFO,
+      .pNext = &libraryInfo,
+      .flags = flags2 | (linkTimeOptimization ? VK_PIPELINE_CREATE_2_LINK_TIME_OPTIMIZATION_BIT_EXT : 0),
+  };
+
+  VkGraphicsPipelineCreateInfo linkInfo{
+      .sType  = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .pNext  = flags2 != 0 ? static_cast<const void*>(&flags2Info) : &libraryInfo,
+      .flags  = linkTimeOptimization ? VkPipelineCreateFlags(VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT) : 0,
+      .layout = pipelineInfo.layout,
+  };
+
+  PipelineCreationFeedback feedback;
+  feedback.chain(linkInfo.pNext, 0);
+
+  VkResult result = vkCreateGraphicsPipelines(device, cache, 1, &linkInfo, nullptr, pPipeline);
+  if(result == VK_SUCCESS)
+  {
+    feedback.record(debugName + (linkTimeOptimization ? " (optimized link)" : " (fast link)"), {});
+    if(!debugName.empty())
+    {
+      DebugUtil::getInstance().setObjectName(*pPipeline, debugName);
+    }
+  }
 
   return result;
 }
@@ -411,6 +524,54 @@ void GraphicsPipelineCreator::buildPipelineCreateInfo(VkGraphicsPipelineCreateIn
     vkCmdDraw(cmd, 1, 2, 3, 4);
   }
 
+  // example using graphics pipeline libraries
+  {
+    std::vector<uint32_t> vertexCode;
+    std::vector<uint32_t> fragmentCode;
+    VkPipelineLayout      pipelineLayout{};
+
+    nvvk::GraphicsPipelineCreator graphicsPipelineCreator;
+    graphicsPipelineCreator.pipelineInfo.layout = pipelineLayout;
+    graphicsPipelineCreator.addShader(VK_SHADER_STAGE_VERTEX_BIT, "main", vertexCode.size() * sizeof(uint32_t),
+                                      vertexCode.data());
+    graphicsPipelineCreator.addShader(VK_SHADER_STAGE_FRAGMENT_BIT, "main", fragmentCode.size() * sizeof(uint32_t),
+                                      fragmentCode.data());
+
+    // build the parts once
+    std::array<VkPipeline, 4> libraries{};
+    graphicsPipelineCreator.createGraphicsPipelineLibrary(device, nullptr, graphicsState,
+                                                          VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, &libraries[0]);
+    graphicsPipelineCreator.createGraphicsPipelineLibrary(device, nullptr, graphicsState,
+                                                          VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+                                                          &libraries[1]);
+    graphicsPipelineCreator.createGraphicsPipelineLibrary(device, nullptr, graphicsState,
+                                                          VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, &libraries[2]);
+    graphicsPipelineCreator.createGraphicsPipelineLibrary(device, nullptr, graphicsState,
+                                                          VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT,
+                                                          &libraries[3]);
+
+    // a state change (e.g. polygon mode) only requires to rebuild the affected part
+    graphicsState.rasterizationState.polygonMode = VK_POLYGON_MODE_LINE;
+    vkDestroyPipeline(device, libraries[1], nullptr);
+    graphicsPipelineCreator.createGraphicsPipelineLibrary(device, nullptr, graphicsState,
+                                                          VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+                                                          &libraries[1]);
+
+    // fast link to use it right away
+    VkPipeline fastPipeline{};
+    graphicsPipelineCreator.linkGraphicsPipeline(device, nullptr, libraries, false, &fastPipeline);
+
+    // the optimized link is slower, typically done on a worker thread and swapped in once ready
+    VkPipeline optimizedPipeline{};
+    graphicsPipelineCreator.linkGraphicsPipeline(device, nullptr, libraries, true, &optimizedPipeline);
+
+    // libraries can be destroyed once linked pipelines no longer need to be created from them
+    for(VkPipeline library : libraries)
+    {
+      vkDestroyPipeline(device, library, nullptr);
+    }
+  }
+
   // example in combination with shader objects
   {
     VkCommandBuffer cmd{};
@@ -23,6 +23,7 @@
 #include <cassert>
 #include <span>
 #include <array>
+#include <string>
 
 #include <volk.h>
 
@@ -204,6 +205,9 @@ public:
   // if non-zero, is used instead of pipelineInfo's
   VkPipelineCreateFlags2 flags2 = 0;
 
+  // names the created pipelines, and their creation feedback in `nvvk::PipelineFeedbackLog`
+  std::string debugName;
+
   // used when pipelineInfo.renderPass is null
   VkPipelineRenderingCreateInfo renderingState{
       .sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
@@ -245,6 +249,29 @@ public:
   // none of the public class members are changed during this process
   VkResult createGraphicsPipeline(VkDevice device, VkPipelineCache cache, const GraphicsPipelineState& graphicsState, VkPipeline* pPipeline);
 
+  // VK_EXT_graphics_pipeline_library
+  // Creates a library for the parts in `libraryFlags`, can be called once per part to re-use them independently:
+  // - VERTEX_INPUT_INTERFACE: vertex input and input assembly (omit for mesh shading)
+  // - PRE_RASTERIZATION_SHADERS: vertex/tessellation/geometry/task/mesh shaders, rasterization state
+  // - FRAGMENT_SHADER: fragment shader, depth/stencil state
+  // - FRAGMENT_OUTPUT_INTERFACE: color blend, multisample state and attachment formats
+  // Only the shaders added for the requested parts are used. Libraries are created with
+  // link-time optimization info retained, so they can be linked optimized later on.
+  VkResult createGraphicsPipelineLibrary(VkDevice                          device,
+                                         VkPipelineCache                   cache,
+                                         const GraphicsPipelineState&      graphicsState,
+                                         VkGraphicsPipelineLibraryFlagsEXT libraryFlags,
+                                         VkPipeline*                       pLibrary);
+
+  // Links the libraries into an executable pipeline, using `pipelineInfo.layout`.
+  // Without `linkTimeOptimization` this is a fast link suited to create variants at runtime,
+  // the optimized version can then be linked on a worker thread and swapped in when ready.
+  VkResult linkGraphicsPipeline(VkDevice                    device,
+                                VkPipelineCache             cache,
+                                std::span<const VkPipeline> libraries,
+                                bool                        linkTimeOptimization,
+                                VkPipeline*                 pPipeline) const;
+
 protected:
   void buildPipelineCreateInfo(VkGraphicsPipelineCreateInfo& createInfoTemp, const GraphicsPipelineState& graphicsState);
 
@@ -270,6 +297,12 @@ protected:
       .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATE_FLAGS_2_CREATE_INFO,
   };
 
+  VkGraphicsPipelineLibraryCreateInfoEXT m_libraryInfo{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+  };
+
+  std::vector<VkPipelineShaderStageCreateInfo> m_libraryShaderStages;
+
   VkPipelineVertexInputStateCreateInfo   m_vertexInputState{};
   VkPipelineMultisampleStateCreateInfo   m_multisampleState{};
   VkPipelineRasterizationStateCreateInfo m_rasterizationState{};
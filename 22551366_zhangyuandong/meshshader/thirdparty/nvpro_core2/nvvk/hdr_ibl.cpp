@@ -24,10 +24,14 @@
  */
 
 #include <array>
+#include <cstring>
+#include <fstream>
 #include <numeric>
 #include <limits>
+#include <string_view>
 
 #include <glm/glm.hpp>
+#include <fmt/format.h>
 #include <glm/gtc/constants.hpp>
 
 #include "nvshaders/slang_types.h"
@@ -35,6 +39,7 @@
 
 #include <nvutils/file_operations.hpp>
 #include <nvutils/logger.hpp>
+#include <nvutils/parallel_work.hpp>
 #include <nvutils/timers.hpp>
 #include <stb/stb_image.h>
 
@@ -89,6 +94,12 @@ void HdrIbl::loadEnvironment(VkCommandBuffer cmd, nvvk::StagingUploader& staging
   int32_t     component{0};
   std::string fileContents;
   float*      pixels = nullptr;
+
+  // Importance sampling table and pixels (with the PDF in alpha), when found in the cache
+  std::vector<shaderio::EnvAccel> envAccel;
+  std::vector<float>              cachedPixels;
+  bool                            fromCache = false;
+  m_contentHash                             = 0;
   if(m_valid)
   {
     // Read the contents into memory so that we don't have to worry about text
@@ -107,6 +118,13 @@ void HdrIbl::loadEnvironment(VkCommandBuffer cmd, nvvk::StagingUploader& staging
   }
 
   if(m_valid)
+  {
+    m_contentHash = std::hash<std::string_view>{}(fileContents);
+    fromCache     = loadCache(fileContents.size(), width, height, envAccel, cachedPixels);
+    pixels        = fromCache ? cachedPixels.data() : nullptr;
+  }
+
+  if(m_valid && !fromCache)
   {
     const stbi_uc* fileData = reinterpret_cast<const stbi_uc*>(fileContents.data());
     const int      fileSize = static_cast<int>(fileContents.size());
@@ -147,8 +165,11 @@ void HdrIbl::loadEnvironment(VkCommandBuffer cmd, nvvk::StagingUploader& staging
       nvutils::ScopedTimer st("Generating Acceleration structure");
       {
         // Creating the importance sampling for the HDR and storing the info in the m_accelImpSmpl buffer
-        std::vector<shaderio::EnvAccel> envAccel =
-            createEnvironmentAccel(pixels, imgSize.width, imgSize.height, m_average, m_integral);
+        if(!fromCache)
+        {
+          envAccel = createEnvironmentAccel(pixels, imgSize.width, imgSize.height, m_average, m_integral);
+          saveCache(fileContents.size(), imgSize, envAccel, pixels);
+        }
 
         NVVK_CHECK(m_alloc->createBuffer(m_accelImpSmpl, std::span(envAccel).size_bytes(), VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT));
         NVVK_CHECK(staging.appendBuffer(m_accelImpSmpl, 0, std::span(envAccel)));
@@ -160,7 +181,10 @@ void HdrIbl::loadEnvironment(VkCommandBuffer cmd, nvvk::StagingUploader& staging
       }
     }
 
-    stbi_image_free(pixels);
+    if(!fromCache)
+    {
+      stbi_image_free(pixels);
+    }
   }
   else
   {  // Create a Dummy image and buffer, such that the code can still run
@@ -211,6 +235,89 @@ void HdrIbl::destroyEnvironment()
   }
 }
 
+//--------------------------------------------------------------------------------------------------
+// Cache of the importance sampling table, next to the pixels holding the PDF in alpha,
+// so that loading them only costs reading the file.
+//
+struct HdrIblCacheHeader
+{
+  uint32_t magic       = 0x4C424948;  // "HIBL"
+  uint32_t version     = 1;
+  uint64_t contentHash = 0;
+  uint64_t sourceSize  = 0;  // size of the HDR file, against hash collisions
+  uint32_t width       = 0;
+  uint32_t height      = 0;
+  float    average     = 0;
+  float    integral    = 0;
+};
+
+std::filesystem::path HdrIbl::getCacheFilename(const char* extension) const
+{
+  return m_cacheDirectory / (fmt::format("{:016x}", m_contentHash) + extension);
+}
+
+bool HdrIbl::loadCache(size_t sourceSize, int32_t& width, int32_t& height, std::vector<shaderio::EnvAccel>& envAccel, std::vector<float>& pixels)
+{
+  if(m_cacheDirectory.empty())
+    return false;
+
+  nvutils::ScopedTimer st(__FUNCTION__);
+
+  const std::string data = nvutils::loadFile(getCacheFilename(".envaccel"));
+  HdrIblCacheHeader header;
+  if(data.size() < sizeof(header))
+    return false;
+  memcpy(&header, data.data(), sizeof(header));
+
+  const size_t texelCount = size_t(header.width) * size_t(header.height);
+  const size_t accelSize  = texelCount * sizeof(shaderio::EnvAccel);
+  const size_t pixelSize  = texelCount * 4 * sizeof(float);
+  if(header.magic != HdrIblCacheHeader().magic || header.version != HdrIblCacheHeader().version
+     || header.contentHash != m_contentHash || header.sourceSize != sourceSize || data.size() != sizeof(header) + accelSize + pixelSize)
+  {
+    LOGW("Ignoring outdated HDR cache for %016llx\n", static_cast<unsigned long long>(m_contentHash));
+    return false;
+  }
+
+  envAccel.resize(texelCount);
+  pixels.resize(texelCount * 4);
+  memcpy(envAccel.data(), data.data() + sizeof(header), accelSize);
+  memcpy(pixels.data(), data.data() + sizeof(header) + accelSize, pixelSize);
+
+  width      = int32_t(header.width);
+  height     = int32_t(header.height);
+  m_average  = header.average;
+  m_integral = header.integral;
+  return true;
+}
+
+void HdrIbl::saveCache(size_t sourceSize, VkExtent2D size, const std::vector<shaderio::EnvAccel>& envAccel, const float* pixels) const
+{
+  if(m_cacheDirectory.empty())
+    return;
+
+  std::error_code ec;
+  std::filesystem::create_directories(m_cacheDirectory, ec);
+
+  const std::filesystem::path filename = getCacheFilename(".envaccel");
+  std::ofstream               file(filename, std::ios::binary);
+  if(!file)
+  {
+    LOGW("Failed to open file for writing: %s\n", nvutils::utf8FromPath(filename).c_str());
+    return;
+  }
+
+  const HdrIblCacheHeader header{.contentHash = m_contentHash,
+                                 .sourceSize  = sourceSize,
+                                 .width       = size.width,
+                                 .height      = size.height,
+                                 .average     = m_average,
+                                 .integral    = m_integral};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(envAccel.data()), std::span(envAccel).size_bytes());
+  file.write(reinterpret_cast<const char*>(pixels), size_t(size.width) * size.height * 4 * sizeof(float));
+}
+
 //--------------------------------------------------------------------------------------------------
 // Descriptors of the HDR and the acceleration structure
 //
@@ -259,11 +366,10 @@ inline static float buildAliasmap(const std::vector<float>& data, std::vector<sh
   // We also initialize the aliases to identity, ie. each texel is its own alias
   auto  f_size          = static_cast<float>(size);
   float inverse_average = f_size / sum;
-  for(uint32_t i = 0; i < size; ++i)
-  {
+  nvutils::parallel_batches(size, [&](uint64_t i) {
     accel[i].q     = data[i] * inverse_average;
-    accel[i].alias = i;
-  }
+    accel[i].alias = uint32_t(i);
+  });
 
   // Partition the texels according to their emitted radiance ratio wrt. average.
   // Texels with a value q < 1 (ie. below average) are stored incrementally from the beginning of the
@@ -339,21 +445,21 @@ inline std::vector<shaderio::EnvAccel> createEnvironmentAccel(float*&         pi
   // Create importance sampling data
   std::vector<shaderio::EnvAccel> env_accel(rx * ry);
   std::vector<float>              importance_data(rx * ry);
-  float                           cos_theta0 = 1.0F;
+  std::vector<double>             row_totals(ry);
   const float                     step_phi   = glm::two_pi<float>() / static_cast<float>(rx);
   const float                     step_theta = glm::pi<float>() / static_cast<float>(ry);
-  double                          total      = 0.0;
 
   // For each texel of the environment map, we compute the related solid angle
   // subtended by the texel, and store the weighted luminance in importance_data,
   // representing the amount of energy emitted through each texel.
   // Also compute the average CIE luminance to drive the tonemapping of the final image
-  for(uint32_t y = 0; y < ry; ++y)
-  {
-    const float theta1     = static_cast<float>(y + 1) * step_theta;
-    const float cos_theta1 = std::cos(theta1);
-    const float area       = (cos_theta0 - cos_theta1) * step_phi;  // solid angle
-    cos_theta0             = cos_theta1;
+  // The rows are independent, and processed in parallel.
+  nvutils::parallel_batches<8>(ry, [&](uint64_t row) {
+    const uint32_t y          = uint32_t(row);
+    const float    cos_theta0 = std::cos(static_cast<float>(y) * step_theta);
+    const float    cos_theta1 = std::cos(static_cast<float>(y + 1) * step_theta);
+    const float    area       = (cos_theta0 - cos_theta1) * step_phi;  // solid angle
+    double         row_total  = 0.0;
 
     for(uint32_t x = 0; x < rx; ++x)
     {
@@ -361,11 +467,13 @@ inline std::vector<shaderio::EnvAccel> createEnvironmentAccel(float*&         pi
       const uint32_t idx4          = idx * 4;
       float          cie_luminance = luminance(&pixels[idx4]);
       importance_data[idx]         = area * std::max(pixels[idx4], std::max(pixels[idx4 + 1], pixels[idx4 + 2]));
-      total += cie_luminance;
+      row_total += cie_luminance;
     }
-  }
+    row_totals[y] = row_total;
+  });
 
-  average = static_cast<float>(total) / static_cast<float>(rx * ry);
+  const double total = std::accumulate(row_totals.begin(), row_totals.end(), 0.0);
+  average            = static_cast<float>(total) / static_cast<float>(rx * ry);
 
   // Build the alias map, which aims at creating a set of texel couples
   // so that all couples emit roughly the same amount of energy. To this aim,
@@ -379,11 +487,10 @@ inline std::vector<shaderio::EnvAccel> createEnvironmentAccel(float*&         pi
 
   // We deduce the PDF of each texel by normalizing its emitted radiance by the radiance integral
   const float inv_env_integral = 1.0F / integral;
-  for(uint32_t i = 0; i < rx * ry; ++i)
-  {
-    const uint32_t idx4 = i * 4;
+  nvutils::parallel_batches(rx * ry, [&](uint64_t i) {
+    const uint64_t idx4 = i * 4;
     pixels[idx4 + 3]    = std::max(pixels[idx4], std::max(pixels[idx4 + 1], pixels[idx4 + 2])) * inv_env_integral;
-  }
+  });
 
   return env_accel;
 }
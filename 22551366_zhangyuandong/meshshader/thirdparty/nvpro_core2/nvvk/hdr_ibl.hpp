@@ -29,6 +29,8 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include "nvshaders/hdr_io.h.slang"
+
 #include "descriptors.hpp"
 #include "resource_allocator.hpp"
 #include "sampler_pool.hpp"
@@ -45,6 +47,9 @@ class Context;
 High-Dynamic-Range (HDR) environment map used for Image-Based Lighting (IBL).
 
 >  Load an environment image (HDR) and create an acceleration structure for important light sampling.
+
+With `setCacheDirectory`, the acceleration structure and the pixels are stored on disk, keyed by the
+hash of the HDR file (`getContentHash`), and loaded from there the next time the same file is used.
   
 -------------------------------------------------------------------------------------------------*/
 class HdrIbl
@@ -56,12 +61,17 @@ public:
   void init(nvvk::ResourceAllocator* allocator, nvvk::SamplerPool* samplerPool);
   void deinit();
 
+  // Empty disables the cache (default)
+  void setCacheDirectory(const std::filesystem::path& directory) { m_cacheDirectory = directory; }
+  const std::filesystem::path& getCacheDirectory() const { return m_cacheDirectory; }
+
   void loadEnvironment(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const std::filesystem::path& hdrImage, bool enableMipmaps = false);
   void destroyEnvironment();
 
   float              getIntegral() const { return m_integral; }
   float              getAverage() const { return m_average; }
   bool               isValid() const { return m_valid; }
+  uint64_t           getContentHash() const { return m_contentHash; }  // hash of the loaded HDR file, 0 if none
   const nvvk::Buffer getEnvAccel() const { return m_accelImpSmpl; }
 
   // HDR + importance sampling
@@ -79,6 +89,9 @@ private:
   float      m_average{1.F};
   bool       m_valid{false};
   VkExtent2D m_hdrImageSize{1, 1};
+  uint64_t   m_contentHash{0};
+
+  std::filesystem::path m_cacheDirectory;
 
   // Resources
   nvvk::Image          m_texHdr;
@@ -87,6 +100,10 @@ private:
 
 
   void createDescriptorSetLayout();
+
+  std::filesystem::path getCacheFilename(const char* extension) const;
+  bool loadCache(size_t sourceSize, int32_t& width, int32_t& height, std::vector<shaderio::EnvAccel>& envAccel, std::vector<float>& pixels);
+  void saveCache(size_t sourceSize, VkExtent2D size, const std::vector<shaderio::EnvAccel>& envAccel, const float* pixels) const;
 };
 
 }  // namespace nvvk
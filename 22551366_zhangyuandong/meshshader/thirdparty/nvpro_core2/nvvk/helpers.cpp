@@ -37,15 +37,13 @@
 #include "helpers.hpp"
 
 
-// Convert a tiled image to RGBA8 linear
-VkResult nvvk::imageToLinear(VkCommandBuffer  cmd,
-                             VkDevice         device,
-                             VkPhysicalDevice physicalDevice,
-                             VkImage          srcImage,
-                             VkExtent2D       size,
-                             VkImage&         dstImage,
-                             VkDeviceMemory&  dstImageMemory,
-                             VkFormat         format)
+// Create a host visible, linear tiled image to read back a tiled image
+VkResult nvvk::createLinearImage(VkDevice         device,
+                                 VkPhysicalDevice physicalDevice,
+                                 VkExtent2D       size,
+                                 VkImage&         dstImage,
+                                 VkDeviceMemory&  dstImageMemory,
+                                 VkFormat         format)
 {
   // Find the memory type index for the memory
   auto getMemoryType = [&](uint32_t typeBits, const VkMemoryPropertyFlags& properties) {
@@ -85,7 +83,13 @@ VkResult nvvk::imageToLinear(VkCommandBuffer  cmd,
       getMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
   NVVK_FAIL_RETURN(vkAllocateMemory(device, &memAllocInfo, nullptr, &dstImageMemory));
   NVVK_FAIL_RETURN(vkBindImageMemory(device, dstImage, dstImageMemory, 0));
+  return VK_SUCCESS;
+}
 
+// Blit the source image (in GENERAL layout) into a linear image made by createLinearImage
+// Both images are left in GENERAL layout
+void nvvk::cmdBlitImageToLinear(VkCommandBuffer cmd, VkImage srcImage, VkImage dstImage, VkExtent2D size)
+{
   nvvk::cmdImageMemoryBarrier(cmd, {srcImage, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL});
   nvvk::cmdImageMemoryBarrier(cmd, {dstImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL});
 
@@ -104,6 +108,19 @@ VkResult nvvk::imageToLinear(VkCommandBuffer  cmd,
 
   nvvk::cmdImageMemoryBarrier(cmd, {srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL});
   nvvk::cmdImageMemoryBarrier(cmd, {dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL});
+}
+
+VkResult nvvk::imageToLinear(VkCommandBuffer  cmd,
+                             VkDevice         device,
+                             VkPhysicalDevice physicalDevice,
+                             VkImage          srcImage,
+                             VkExtent2D       size,
+                             VkImage&         dstImage,
+                             VkDeviceMemory&  dstImageMemory,
+                             VkFormat         format)
+{
+  NVVK_FAIL_RETURN(createLinearImage(device, physicalDevice, size, dstImage, dstImageMemory, format));
+  cmdBlitImageToLinear(cmd, srcImage, dstImage, size);
   return VK_SUCCESS;
 }
 
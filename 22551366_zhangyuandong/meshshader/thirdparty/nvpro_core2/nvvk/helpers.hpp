@@ -28,6 +28,15 @@ namespace nvvk {
 
 //-----------------------------------
 // Image helpers
+VkResult createLinearImage(VkDevice         device,
+                           VkPhysicalDevice physicalDevice,
+                           VkExtent2D       size,
+                           VkImage&         dstImage,
+                           VkDeviceMemory&  dstImageMemory,
+                           VkFormat         format);
+
+void cmdBlitImageToLinear(VkCommandBuffer cmd, VkImage srcImage, VkImage dstImage, VkExtent2D size);
+
 VkResult imageToLinear(VkCommandBuffer  cmd,
                        VkDevice         device,
                        VkPhysicalDevice physicalDevice,
@@ -46,6 +46,9 @@ inline uint32_t mipLevels(VkExtent3D extent)
 //      uint32_t levelCount = nvvk::mipLevels(extent);
 //
 // The current layout of the image is the layout of the image before the mipmaps are generated.
+//
+// This records one blit and barrier per level, `nvshaders::SinglePassDownsampler` generates up to 12 levels
+// in a single compute dispatch.
 void cmdGenerateMipmaps(VkCommandBuffer   cmd,                // Command buffer to record the command
                         VkImage           image,              // Image to generate mipmaps for
                         const VkExtent2D& size,               // Size of the image
@@ -22,8 +22,16 @@
 #include <string.h>
 #include <vector>
 
+#include <algorithm>
+
+#include <fmt/format.h>
 #include <volk.h>
+#include <vulkan/vk_enum_string_helper.h>
+
+#include <nvutils/logger.hpp>
+#include <nvutils/profiler.hpp>
 
+#include "debug_util.hpp"
 #include "pipeline.hpp"
 
 namespace nvvk {
@@ -168,4 +176,139 @@ void dumpPipelineInternals(VkDevice device, VkPipeline pipeline, const std::file
   }
 }
 
+void PipelineCreationFeedback::chain(const void*& pNext, uint32_t stageCount)
+{
+  if(!PipelineFeedbackLog::getInstance().isEnabled())
+  {
+    return;
+  }
+  stages.assign(stageCount, {});
+  createInfo.pNext                              = pNext;
+  createInfo.pPipelineCreationFeedback          = &pipeline;
+  createInfo.pipelineStageCreationFeedbackCount = stageCount;
+  createInfo.pPipelineStageCreationFeedbacks    = stages.data();
+  pNext                                         = &createInfo;
+}
+
+void PipelineCreationFeedback::record(const std::string& name, std::span<const VkPipelineShaderStageCreateInfo> pStages) const
+{
+  if(createInfo.pPipelineCreationFeedback == nullptr)
+  {
+    return;
+  }
+
+  PipelineFeedbackRecord record;
+  record.name         = name.empty() ? "unnamed" : name;
+  record.valid        = (pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) != 0;
+  record.cacheHit     = (pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0;
+  record.milliseconds = double(pipeline.duration) / 1.0e6;
+  for(size_t i = 0; i < stages.size() && i < pStages.size(); i++)
+  {
+    if(stages[i].flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)
+    {
+      record.stages.push_back({pStages[i].stage, double(stages[i].duration) / 1.0e6,
+                               (stages[i].flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0});
+    }
+  }
+  PipelineFeedbackLog::getInstance().add(std::move(record));
+}
+
+void PipelineFeedbackLog::setProfilerTimeline(nvutils::ProfilerTimeline* timeline)
+{
+  std::lock_guard lock(m_mutex);
+  m_timeline = timeline;
+}
+
+void PipelineFeedbackLog::add(PipelineFeedbackRecord&& record)
+{
+  std::lock_guard lock(m_mutex);
+  m_records.push_back(std::move(record));
+
+  if(m_timeline)
+  {
+    const PipelineFeedbackRecord& added = m_records.back();
+    double                        total = 0;
+    uint32_t                      hits  = 0;
+    for(const PipelineFeedbackRecord& r : m_records)
+    {
+      total += r.milliseconds;
+      hits += r.cacheHit ? 1 : 0;
+    }
+    m_timeline->setCounter("Pipeline " + added.name + " [ms]", added.milliseconds);
+    m_timeline->setCounter("Pipelines created", double(m_records.size()));
+    m_timeline->setCounter("Pipeline cache hits", double(hits));
+    m_timeline->setCounter("Pipeline creation [ms]", total);
+  }
+}
+
+std::vector<PipelineFeedbackRecord> PipelineFeedbackLog::getRecords() const
+{
+  std::lock_guard lock(m_mutex);
+  return m_records;
+}
+
+void PipelineFeedbackLog::clear()
+{
+  std::lock_guard lock(m_mutex);
+  m_records.clear();
+}
+
+void PipelineFeedbackLog::logSummary(uint32_t count) const
+{
+  std::vector<PipelineFeedbackRecord> records = getRecords();
+  if(records.empty())
+  {
+    return;
+  }
+
+  double   total = 0;
+  uint32_t hits  = 0;
+  for(const PipelineFeedbackRecord& record : records)
+  {
+    total += record.milliseconds;
+    hits += record.cacheHit ? 1 : 0;
+  }
+  LOGI("Pipeline creation: %zu pipelines in %.2f ms, %u from the pipeline cache\n", records.size(), total, hits);
+
+  std::sort(records.begin(), records.end(),
+            [](const PipelineFeedbackRecord& a, const PipelineFeedbackRecord& b) { return a.milliseconds > b.milliseconds; });
+  records.resize(std::min(records.size(), size_t(count)));
+  for(const PipelineFeedbackRecord& record : records)
+  {
+    if(!record.valid)
+    {
+      LOGI("  %-40s no feedback\n", record.name.c_str());
+      continue;
+    }
+    std::string stages;
+    for(const PipelineFeedbackRecord::Stage& stage : record.stages)
+    {
+      stages += fmt::format(" {} {:.2f} ms{}", string_VkShaderStageFlagBits(stage.stage), stage.milliseconds, stage.cacheHit ? " (hit)" : "");
+    }
+    LOGI("  %-40s %8.2f ms%s |%s\n", record.name.c_str(), record.milliseconds, record.cacheHit ? " (cache hit)" : "", stages.c_str());
+  }
+}
+
+VkResult createComputePipeline(VkDevice                           device,
+                               VkPipelineCache                    cache,
+                               const VkComputePipelineCreateInfo& createInfo,
+                               VkPipeline*                        pPipeline,
+                               const std::string&                 debugName)
+{
+  VkComputePipelineCreateInfo info = createInfo;
+  PipelineCreationFeedback    feedback;
+  feedback.chain(info.pNext, 1);
+
+  VkResult result = vkCreateComputePipelines(device, cache, 1, &info, nullptr, pPipeline);
+  if(result == VK_SUCCESS)
+  {
+    feedback.record(debugName, {&info.stage, 1});
+    if(!debugName.empty())
+    {
+      DebugUtil::getInstance().setObjectName(*pPipeline, debugName);
+    }
+  }
+  return result;
+}
+
 }  // namespace nvvk
@@ -20,8 +20,15 @@
 #pragma once
 
 #include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
 #include <vulkan/vulkan_core.h>
 
+namespace nvutils {
+class ProfilerTimeline;
+}
 
 namespace nvvk {
 
@@ -34,4 +41,81 @@ void dumpPipelineStats(VkDevice device, VkPipeline pipeline, const std::filesyst
 // pipeline must have been created with VK_PIPELINE_CREATE_CAPTURE_INTERNAL_REPRESENTATIONS_BIT_KHR
 void dumpPipelineInternals(VkDevice device, VkPipeline pipeline, const std::filesystem::path& baseFileName);
 
+//////////////////////////////////////////////////////////////////////////
+// Pipeline creation feedback (VK_EXT_pipeline_creation_feedback, core in Vulkan 1.3)
+//
+// The driver reports how long each pipeline and each of its stages took to create, and whether
+// the pipeline cache provided them. `nvvk::GraphicsPipelineCreator` and `nvvk::createComputePipeline`
+// chain it in and add the results to `PipelineFeedbackLog::getInstance()`, under their debug name:
+//
+//   nvvk::PipelineFeedbackLog::getInstance().setProfilerTimeline(timeline);  // optional, adds counters
+//   ... create the pipelines ...
+//   nvvk::PipelineFeedbackLog::getInstance().logSummary();  // slowest pipelines of the startup
+
+struct PipelineFeedbackRecord
+{
+  struct Stage
+  {
+    VkShaderStageFlagBits stage{};
+    double                milliseconds = 0;
+    bool                  cacheHit     = false;
+  };
+
+  std::string        name;
+  double             milliseconds = 0;
+  bool               valid        = false;  // the driver provided the feedback
+  bool               cacheHit     = false;  // provided without compilation by the pipeline cache
+  std::vector<Stage> stages;                // valid ones only, in the order of the create info
+};
+
+// To chain in the create info of one pipeline, then `record` once created
+struct PipelineCreationFeedback
+{
+  VkPipelineCreationFeedback              pipeline{};
+  std::vector<VkPipelineCreationFeedback> stages;
+  VkPipelineCreationFeedbackCreateInfo    createInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO};
+
+  // Inserts itself at the front of `pNext`, does nothing when the log is disabled
+  void chain(const void*& pNext, uint32_t stageCount);
+  // Adds the feedback to the log, `pStages` gives the stage of each feedback
+  void record(const std::string& name, std::span<const VkPipelineShaderStageCreateInfo> pStages) const;
+};
+
+// Thread-safe collection of the feedback of all the pipelines created
+class PipelineFeedbackLog
+{
+public:
+  static PipelineFeedbackLog& getInstance()
+  {
+    static PipelineFeedbackLog instance;
+    return instance;
+  }
+
+  void setEnabled(bool enabled) { m_enabled = enabled; }
+  bool isEnabled() const { return m_enabled; }
+
+  // Counters `Pipeline <name> [ms]`, plus the totals, are set on the timeline for each record
+  void setProfilerTimeline(nvutils::ProfilerTimeline* timeline);
+
+  void                                add(PipelineFeedbackRecord&& record);
+  std::vector<PipelineFeedbackRecord> getRecords() const;
+  void                                clear();
+
+  // LOGI of the totals and of the `count` slowest pipelines with their stages
+  void logSummary(uint32_t count = 10) const;
+
+private:
+  mutable std::mutex                  m_mutex;
+  std::vector<PipelineFeedbackRecord> m_records;
+  nvutils::ProfilerTimeline*          m_timeline{};
+  bool                                m_enabled = true;
+};
+
+// vkCreateComputePipelines of a single pipeline, named `debugName` with its creation feedback recorded
+VkResult createComputePipeline(VkDevice                           device,
+                               VkPipelineCache                    cache,
+                               const VkComputePipelineCreateInfo& createInfo,
+                               VkPipeline*                        pPipeline,
+                               const std::string&                 debugName = {});
+
 }  // namespace nvvk
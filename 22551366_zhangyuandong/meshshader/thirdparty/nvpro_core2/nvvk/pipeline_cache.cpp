@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <volk.h>
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include <nvutils/file_operations.hpp>
+#include <nvutils/logger.hpp>
+
+#include "pipeline_cache.hpp"
+#include "check_error.hpp"
+
+static uint64_t hashCacheData(const void* data, size_t size)
+{
+  return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(data), size));
+}
+
+nvvk::PipelineCache::~PipelineCache()
+{
+  assert(m_cache == VK_NULL_HANDLE && "Missing deinit()");
+}
+
+VkResult nvvk::PipelineCache::init(VkDevice device, VkPhysicalDevice physicalDevice, const std::filesystem::path& filename)
+{
+  m_device   = device;
+  m_filename = filename;
+  m_loaded   = false;
+
+  VkPhysicalDeviceIDProperties idProperties{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES};
+  VkPhysicalDeviceProperties2  properties{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &idProperties};
+  vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+  m_header = FileHeader{
+      .magic         = kMagic,
+      .headerVersion = kHeaderVersion,
+      .vendorID      = properties.properties.vendorID,
+      .deviceID      = properties.properties.deviceID,
+      .driverVersion = properties.properties.driverVersion,
+  };
+  std::memcpy(m_header.deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+  std::memcpy(m_header.pipelineCacheUUID, properties.properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+  // Initial data, only when the file was written by this device and driver
+  std::vector<char> data;
+  std::ifstream     file(filename, std::ios::binary);
+  FileHeader        header{};
+  if(file && file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+  {
+    if(header.magic == kMagic && header.headerVersion == kHeaderVersion && header.vendorID == m_header.vendorID
+       && header.deviceID == m_header.deviceID && header.driverVersion == m_header.driverVersion
+       && std::memcmp(header.deviceUUID, m_header.deviceUUID, VK_UUID_SIZE) == 0
+       && std::memcmp(header.pipelineCacheUUID, m_header.pipelineCacheUUID, VK_UUID_SIZE) == 0)
+    {
+      data.resize(header.dataSize);
+      if(file.read(data.data(), data.size()) && hashCacheData(data.data(), data.size()) == header.dataHash)
+      {
+        m_loaded = true;
+      }
+      else
+      {
+        LOGW("Pipeline cache %s is truncated or corrupt, starting empty\n", nvutils::utf8FromPath(filename).c_str());
+        data.clear();
+      }
+    }
+    else
+    {
+      LOGI("Pipeline cache %s was created by another device or driver, starting empty\n", nvutils::utf8FromPath(filename).c_str());
+    }
+  }
+
+  const VkPipelineCacheCreateInfo createInfo{
+      .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .initialDataSize = data.size(),
+      .pInitialData    = data.empty() ? nullptr : data.data(),
+  };
+  VkResult result = vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache);
+  if(result != VK_SUCCESS && !data.empty())
+  {
+    // The driver may still reject the content, fall back to an empty cache
+    const VkPipelineCacheCreateInfo emptyInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    m_loaded = false;
+    result   = vkCreatePipelineCache(m_device, &emptyInfo, nullptr, &m_cache);
+  }
+  NVVK_FAIL_RETURN(result);
+  return result;
+}
+
+void nvvk::PipelineCache::deinit()
+{
+  if(m_cache == VK_NULL_HANDLE)
+  {
+    return;
+  }
+  save();
+  vkDestroyPipelineCache(m_device, m_cache, nullptr);
+  m_cache  = VK_NULL_HANDLE;
+  m_device = VK_NULL_HANDLE;
+}
+
+bool nvvk::PipelineCache::save()
+{
+  if(m_cache == VK_NULL_HANDLE || m_filename.empty())
+  {
+    return false;
+  }
+
+  size_t dataSize = 0;
+  if(vkGetPipelineCacheData(m_device, m_cache, &dataSize, nullptr) != VK_SUCCESS)
+  {
+    return false;
+  }
+  std::vector<char> data(dataSize);
+  if(vkGetPipelineCacheData(m_device, m_cache, &dataSize, data.data()) != VK_SUCCESS)
+  {
+    return false;
+  }
+
+  FileHeader header = m_header;
+  header.dataSize   = dataSize;
+  header.dataHash   = hashCacheData(data.data(), dataSize);
+
+  // Replace the file only once it was written entirely
+  std::filesystem::path tempFilename = m_filename;
+  tempFilename += ".tmp";
+  {
+    std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+    if(!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) || !file.write(data.data(), dataSize))
+    {
+      LOGW("Failed to write the pipeline cache %s\n", nvutils::utf8FromPath(tempFilename).c_str());
+      return false;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(tempFilename, m_filename, error);
+  if(error)
+  {
+    LOGW("Failed to replace the pipeline cache %s: %s\n", nvutils::utf8FromPath(m_filename).c_str(), error.message().c_str());
+    std::filesystem::remove(tempFilename, error);
+    return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_PipelineCache()
+{
+  VkDevice         device         = nullptr;  // EX: get the device from the app (m_app->getDevice())
+  VkPhysicalDevice physicalDevice = nullptr;  // EX: m_app->getPhysicalDevice()
+
+  nvvk::PipelineCache pipelineCache;
+  pipelineCache.init(device, physicalDevice, nvutils::getExecutablePath().replace_extension(".pipelinecache"));
+
+  // Pass it wherever a VkPipelineCache is expected, for example
+  // nvvk::GraphicsPipelineCreator::createGraphicsPipeline(device, pipelineCache, graphicsState, &pipeline);
+  // or vkCreateComputePipelines(device, pipelineCache, 1, &createInfo, nullptr, &pipeline);
+
+  // Writes the cache to the file
+  pipelineCache.deinit();
+}
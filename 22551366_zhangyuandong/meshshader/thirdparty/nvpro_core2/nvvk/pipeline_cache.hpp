@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+
+#include <vulkan/vulkan_core.h>
+
+namespace nvvk {
+
+//-----------------------------------------------------------------
+// VkPipelineCache persisted in a file, so the driver compilation of the
+// pipelines is skipped on the next launches.
+//
+// The file starts with a header holding the device UUID, vendor, device and
+// driver version it was created with. A file from another device or driver,
+// or a truncated one, is ignored and the cache starts empty.
+// The cache is written back at `deinit` or on `save`, through a temporary file
+// so an interrupted write never leaves a corrupt cache.
+//
+// Usage:
+//      see usage_PipelineCache in pipeline_cache.cpp
+//-----------------------------------------------------------------
+class PipelineCache
+{
+public:
+  PipelineCache() = default;
+  ~PipelineCache();
+
+  PipelineCache(const PipelineCache&)            = delete;
+  PipelineCache& operator=(const PipelineCache&) = delete;
+
+  // Creates the cache, with the content of `filename` when it matches the device
+  VkResult init(VkDevice device, VkPhysicalDevice physicalDevice, const std::filesystem::path& filename);
+  // Saves the cache to the file, then destroys it
+  void deinit();
+
+  // Writes the current content of the cache to the file
+  bool save();
+
+  VkPipelineCache getPipelineCache() const { return m_cache; }
+  operator VkPipelineCache() const { return m_cache; }
+
+  // Whether init found a valid file for this device
+  bool wasLoaded() const { return m_loaded; }
+
+private:
+  struct FileHeader
+  {
+    uint32_t magic;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t  deviceUUID[VK_UUID_SIZE];
+    uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint64_t dataHash;
+  };
+
+  static constexpr uint32_t kMagic         = 0x4B565650;  // "PVVK"
+  static constexpr uint32_t kHeaderVersion = 1;
+
+  VkDevice              m_device{};
+  VkPipelineCache       m_cache{};
+  std::filesystem::path m_filename;
+  FileHeader            m_header{};  // Header expected for this device
+  bool                  m_loaded = false;
+};
+
+}  // namespace nvvk
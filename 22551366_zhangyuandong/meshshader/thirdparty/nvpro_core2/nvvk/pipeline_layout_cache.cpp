@@ -0,0 +1,206 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <nvutils/hash_operations.hpp>
+
+#include "check_error.hpp"
+#include "pipeline_layout_cache.hpp"
+
+namespace nvvk {
+
+std::size_t PipelineLayoutCache::KeyHash::operator()(const Key& key) const
+{
+  std::size_t seed = 0;
+  for(uint64_t word : key)
+  {
+    nvutils::hashCombine(seed, word);
+  }
+  return seed;
+}
+
+void PipelineLayoutCache::init(VkDevice device)
+{
+  assert(m_device == nullptr);
+  m_device = device;
+}
+
+void PipelineLayoutCache::deinit()
+{
+  if(!m_device)
+    return;
+
+  for(auto& it : m_pipelineLayouts)
+  {
+    vkDestroyPipelineLayout(m_device, it.second, nullptr);
+  }
+  for(auto& it : m_setLayouts)
+  {
+    vkDestroyDescriptorSetLayout(m_device, it.second, nullptr);
+  }
+  m_pipelineLayouts.clear();
+  m_setLayouts.clear();
+  m_hits   = 0;
+  m_misses = 0;
+  m_device = nullptr;
+}
+
+VkResult PipelineLayoutCache::getDescriptorSetLayout(const DescriptorBindings&        bindings,
+                                                     VkDescriptorSetLayoutCreateFlags flags,
+                                                     VkDescriptorSetLayout*           pLayout)
+{
+  const std::vector<VkDescriptorSetLayoutBinding>& layoutBindings = bindings.getBindings();
+  const std::vector<VkDescriptorBindingFlags>&     bindingFlags   = bindings.getBindingFlags();
+
+  Key key;
+  key.reserve(1 + layoutBindings.size() * 4);
+  key.push_back(flags);
+  for(size_t i = 0; i < layoutBindings.size(); i++)
+  {
+    const VkDescriptorSetLayoutBinding& binding = layoutBindings[i];
+    key.push_back((uint64_t(binding.binding) << 32) | uint64_t(binding.descriptorType));
+    key.push_back((uint64_t(binding.descriptorCount) << 32) | uint64_t(binding.stageFlags));
+    key.push_back(bindingFlags[i]);
+    key.push_back(binding.pImmutableSamplers ? binding.descriptorCount : 0);
+    if(binding.pImmutableSamplers)
+    {
+      for(uint32_t s = 0; s < binding.descriptorCount; s++)
+        key.push_back(uint64_t(binding.pImmutableSamplers[s]));
+    }
+  }
+
+  std::lock_guard lock(m_mutex);
+  auto            it = m_setLayouts.find(key);
+  if(it != m_setLayouts.end())
+  {
+    m_hits++;
+    *pLayout = it->second;
+    return VK_SUCCESS;
+  }
+
+  m_misses++;
+  NVVK_FAIL_RETURN(bindings.createDescriptorSetLayout(m_device, flags, pLayout));
+  m_setLayouts.insert({std::move(key), *pLayout});
+  return VK_SUCCESS;
+}
+
+VkResult PipelineLayoutCache::getPipelineLayout(std::span<const VkDescriptorSetLayout> setLayouts,
+                                                std::span<const VkPushConstantRange>   pushConstantRanges,
+                                                VkPipelineLayout*                      pLayout)
+{
+  Key key;
+  key.reserve(2 + setLayouts.size() + pushConstantRanges.size() * 2);
+  key.push_back(setLayouts.size());
+  for(VkDescriptorSetLayout setLayout : setLayouts)
+  {
+    key.push_back(uint64_t(setLayout));
+  }
+  key.push_back(pushConstantRanges.size());
+  for(const VkPushConstantRange& range : pushConstantRanges)
+  {
+    key.push_back(range.stageFlags);
+    key.push_back((uint64_t(range.offset) << 32) | uint64_t(range.size));
+  }
+
+  std::lock_guard lock(m_mutex);
+  auto            it = m_pipelineLayouts.find(key);
+  if(it != m_pipelineLayouts.end())
+  {
+    m_hits++;
+    *pLayout = it->second;
+    return VK_SUCCESS;
+  }
+
+  m_misses++;
+  NVVK_FAIL_RETURN(createPipelineLayout(m_device, pLayout, setLayouts, pushConstantRanges));
+  m_pipelineLayouts.insert({std::move(key), *pLayout});
+  return VK_SUCCESS;
+}
+
+VkResult PipelineLayoutCache::getPipelineLayout(const ShaderReflection&                           reflection,
+                                                VkPipelineLayout*                                 pLayout,
+                                                std::vector<VkDescriptorSetLayout>*               pSetLayouts,
+                                                std::span<const VkDescriptorSetLayoutCreateFlags> setFlags,
+                                                uint32_t                                          runtimeArrayCount)
+{
+  // sets without bindings in between get an empty layout
+  std::vector<VkDescriptorSetLayout> setLayouts(reflection.getSetCount());
+  for(uint32_t set = 0; set < reflection.getSetCount(); set++)
+  {
+    DescriptorBindings bindings;
+    reflection.getSetBindings(set, bindings, runtimeArrayCount);
+    NVVK_FAIL_RETURN(getDescriptorSetLayout(bindings, set < setFlags.size() ? setFlags[set] : 0, &setLayouts[set]));
+  }
+
+  const VkPushConstantRange& pushConstantRange = reflection.getPushConstantRange();
+  NVVK_FAIL_RETURN(getPipelineLayout(setLayouts, {&pushConstantRange, pushConstantRange.size ? 1u : 0u}, pLayout));
+
+  if(pSetLayouts)
+  {
+    *pSetLayouts = std::move(setLayouts);
+  }
+  return VK_SUCCESS;
+}
+
+PipelineLayoutCache::Stats PipelineLayoutCache::getStats() const
+{
+  std::lock_guard lock(m_mutex);
+  return {.setLayouts      = uint32_t(m_setLayouts.size()),
+          .pipelineLayouts = uint32_t(m_pipelineLayouts.size()),
+          .hits            = m_hits,
+          .misses          = m_misses};
+}
+
+}  // namespace nvvk
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_PipelineLayoutCache(VkDevice                  device,
+                                                       std::span<const uint32_t> computeSpirv,
+                                                       std::span<const uint32_t> otherComputeSpirv)
+{
+  nvvk::PipelineLayoutCache layoutCache;
+  layoutCache.init(device);
+
+  // Layout of the first pipeline, from its shader
+  nvvk::ShaderReflection reflection;
+  reflection.addModule(computeSpirv);
+
+  VkPipelineLayout                   pipelineLayout{};
+  std::vector<VkDescriptorSetLayout> setLayouts;
+  NVVK_CHECK(layoutCache.getPipelineLayout(reflection, &pipelineLayout, &setLayouts));
+
+  // A second pipeline with the same interface gets the same layout handle, so switching
+  // between the two keeps the bound descriptor sets and push constants
+  nvvk::ShaderReflection otherReflection;
+  otherReflection.addModule(otherComputeSpirv);
+
+  VkPipelineLayout otherPipelineLayout{};
+  NVVK_CHECK(layoutCache.getPipelineLayout(otherReflection, &otherPipelineLayout));
+
+  // Push descriptors for set 0
+  const VkDescriptorSetLayoutCreateFlags setFlags[] = {VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR};
+  VkPipelineLayout                       pushDescriptorLayout{};
+  NVVK_CHECK(layoutCache.getPipelineLayout(reflection, &pushDescriptorLayout, nullptr, setFlags));
+
+  // ... create pipelines
+
+  // Destroys all layouts, after the pipelines using them
+  layoutCache.deinit();
+}
@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+
+#include <cassert>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include "descriptors.hpp"
+#include "shader_reflection.hpp"
+
+namespace nvvk {
+
+//-----------------------------------------------------------------
+// Creates each unique descriptor set layout and pipeline layout once, and hands out the same handle
+// for identical create infos. Pipelines that share a layout keep their bound descriptor sets and
+// push constants when switching between them, and rebuilding pipelines doesn't recreate layouts.
+//
+// - The layouts are owned by the cache and destroyed in `deinit`.
+// - Set layouts with immutable samplers are keyed by the sampler handles.
+// - All functions are thread-safe.
+//
+// Usage:
+//      see usage_PipelineLayoutCache in pipeline_layout_cache.cpp
+//-----------------------------------------------------------------
+class PipelineLayoutCache
+{
+public:
+  PipelineLayoutCache() = default;
+  ~PipelineLayoutCache() { assert(m_device == nullptr && "Missing deinit()"); }
+
+  PipelineLayoutCache(const PipelineLayoutCache&)            = delete;
+  PipelineLayoutCache& operator=(const PipelineLayoutCache&) = delete;
+
+  void init(VkDevice device);
+  // destroys all the layouts
+  void deinit();
+
+  VkResult getDescriptorSetLayout(const DescriptorBindings&        bindings,
+                                  VkDescriptorSetLayoutCreateFlags flags,
+                                  VkDescriptorSetLayout*           pLayout);
+
+  VkResult getPipelineLayout(std::span<const VkDescriptorSetLayout> setLayouts,
+                             std::span<const VkPushConstantRange>   pushConstantRanges,
+                             VkPipelineLayout*                      pLayout);
+
+  // Derives the set layouts and the push constant range from the reflected modules.
+  // `setFlags[set]` are the create flags of each set (may be shorter than the set count),
+  // runtime arrays get `runtimeArrayCount` descriptors.
+  // The set layouts are returned in `pSetLayouts` (optional), e.g. to allocate descriptor sets.
+  VkResult getPipelineLayout(const ShaderReflection&                           reflection,
+                             VkPipelineLayout*                                 pLayout,
+                             std::vector<VkDescriptorSetLayout>*               pSetLayouts       = nullptr,
+                             std::span<const VkDescriptorSetLayoutCreateFlags> setFlags          = {},
+                             uint32_t                                          runtimeArrayCount = 0);
+
+  struct Stats
+  {
+    uint32_t setLayouts      = 0;
+    uint32_t pipelineLayouts = 0;
+    uint64_t hits            = 0;  // requests served by an existing layout
+    uint64_t misses          = 0;
+  };
+  Stats getStats() const;
+
+private:
+  // The create info serialized into words, compared as a whole
+  using Key = std::vector<uint64_t>;
+  struct KeyHash
+  {
+    std::size_t operator()(const Key& key) const;
+  };
+
+  VkDevice m_device{};
+
+  std::unordered_map<Key, VkDescriptorSetLayout, KeyHash> m_setLayouts;
+  std::unordered_map<Key, VkPipelineLayout, KeyHash>      m_pipelineLayouts;
+  uint64_t                                                m_hits   = 0;
+  uint64_t                                                m_misses = 0;
+  mutable std::mutex                                      m_mutex;
+};
+
+}  // namespace nvvk
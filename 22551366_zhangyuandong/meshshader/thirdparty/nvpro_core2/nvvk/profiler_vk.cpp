@@ -17,7 +17,10 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
+#include <vector>
 
 #include "check_error.hpp"
 #include "profiler_vk.hpp"
@@ -62,6 +65,27 @@ void ProfilerGpuTimer::init(nvutils::ProfilerTimeline* profilerTimeline, VkDevic
     return provideTime(m_async, idx, gpuTime);
   };
 
+  m_timeProvider.frameBeginFunction = nullptr;
+
+  // Calibrated timestamps: device function only loaded when the extension is enabled
+  m_calibrated = false;
+  if(vkGetCalibratedTimestampsEXT && vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
+  {
+    uint32_t domainCount = 0;
+    vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(physicalDevice, &domainCount, nullptr);
+    std::vector<VkTimeDomainEXT> domains(domainCount);
+    vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(physicalDevice, &domainCount, domains.data());
+    m_calibrated = std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end();
+  }
+  if(m_calibrated)
+  {
+    calibrate();
+    m_timeProvider.frameBeginFunction = [&](nvutils::ProfilerTimeline::FrameSectionID sec, double& gpuBegin) {
+      uint32_t idx = nvutils::ProfilerTimeline::GpuTimeProvider::getTimerBaseIdx(sec);
+      return provideBeginTime(m_frame, idx, gpuBegin);
+    };
+  }
+
   resizePool(m_frame, PoolContainer::POOL_QUERY_COUNT);
   resizePool(m_async, PoolContainer::POOL_QUERY_COUNT);
 
@@ -89,6 +113,27 @@ void ProfilerGpuTimer::deinit()
   m_profilerTimeline = nullptr;
 }
 
+void ProfilerGpuTimer::setDeviceIndex(uint32_t deviceIndex, uint32_t deviceMask)
+{
+  assert(deviceMask & (1U << deviceIndex));
+  m_deviceIndex = deviceIndex;
+  m_deviceMask  = deviceMask;
+}
+
+void ProfilerGpuTimer::cmdWriteTimestamp(VkCommandBuffer cmd, VkPipelineStageFlagBits stage, VkQueryPool queryPool, uint32_t idxInPool)
+{
+  if(m_deviceIndex == ~0U)
+  {
+    vkCmdWriteTimestamp(cmd, stage, queryPool, idxInPool);
+    return;
+  }
+
+  // the query has a single writer, whose result the host reads
+  vkCmdSetDeviceMask(cmd, 1U << m_deviceIndex);
+  vkCmdWriteTimestamp(cmd, stage, queryPool, idxInPool);
+  vkCmdSetDeviceMask(cmd, m_deviceMask);
+}
+
 nvutils::ProfilerTimeline::FrameSectionID ProfilerGpuTimer::cmdFrameBeginSection(VkCommandBuffer cmd, const std::string& name)
 {
   nvutils::ProfilerTimeline::FrameSectionID sec = m_profilerTimeline->frameBeginSection(name, &m_timeProvider);
@@ -110,7 +155,7 @@ nvutils::ProfilerTimeline::FrameSectionID ProfilerGpuTimer::cmdFrameBeginSection
   m_profilerTimeline->frameResetCpuBegin(sec);
 
   // log timestamp
-  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, idxInPool);
+  cmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, idxInPool);
 
   return sec;
 }
@@ -121,7 +166,7 @@ void ProfilerGpuTimer::cmdFrameEndSection(VkCommandBuffer cmd, nvutils::Profiler
   uint32_t    idxInPool;
   VkQueryPool queryPool = getPool(m_frame, idx, idxInPool);
 
-  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, idxInPool);
+  cmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, idxInPool);
   if(m_useLabels)
   {
     vkCmdEndDebugUtilsLabelEXT(cmd);
@@ -154,7 +199,7 @@ nvutils::ProfilerTimeline::AsyncSectionID ProfilerGpuTimer::cmdAsyncBeginSection
   m_profilerTimeline->asyncResetCpuBegin(sec);
 
   // log timestamp
-  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, idxInPool);
+  cmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, idxInPool);
 
   return sec;
 }
@@ -166,7 +211,7 @@ void ProfilerGpuTimer::cmdAsyncEndSection(VkCommandBuffer cmd, nvutils::Profiler
   uint32_t    idxInPool;
   VkQueryPool queryPool = getPool(m_async, idx, idxInPool);
 
-  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, idxInPool);
+  cmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, idxInPool);
   if(m_useLabels)
   {
     vkCmdEndDebugUtilsLabelEXT(cmd);
@@ -196,6 +241,63 @@ bool ProfilerGpuTimer::provideTime(const PoolContainer& container, uint32_t idxB
   }
 }
 
+bool ProfilerGpuTimer::provideBeginTime(const PoolContainer& container, uint32_t idxBegin, double& gpuBegin)
+{
+  uint32_t    idxInPool;
+  VkQueryPool queryPool = getPool(container, idxBegin, idxInPool);
+
+  uint64_t time;
+  VkResult result = vkGetQueryPoolResults(m_device, queryPool, idxInPool, 1, sizeof(uint64_t), &time, sizeof(uint64_t),
+                                          VK_QUERY_RESULT_64_BIT);
+  if(result != VK_SUCCESS)
+  {
+    return false;
+  }
+
+  // The clocks drift apart, recalibrate every second
+  if(m_profilerTimeline->getProfiler()->getMicroseconds() - m_calibrationCpu > 1000000.0)
+  {
+    calibrate();
+  }
+
+  // Signed distance to the calibration point, within the valid bits
+  uint64_t mask  = m_queueFamilyMask;
+  uint64_t delta = (time - m_calibrationGpu) & mask;
+  double   ticks = delta > (mask >> 1) ? -double((m_calibrationGpu - time) & mask) : double(delta);
+
+  gpuBegin = m_calibrationCpu + ticks * double(m_frequency) / double(1000);
+  return true;
+}
+
+void ProfilerGpuTimer::calibrate()
+{
+  const nvutils::ProfilerManager* profiler = m_profilerTimeline->getProfiler();
+
+  const VkCalibratedTimestampInfoEXT info{
+      .sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+      .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT,
+  };
+
+  // The device timestamp is taken between two reads of the profiler time,
+  // keep the tightest of a few attempts
+  double bestInterval = std::numeric_limits<double>::max();
+  for(uint32_t attempt = 0; attempt < 4; attempt++)
+  {
+    uint64_t timestamp    = 0;
+    uint64_t maxDeviation = 0;
+    double   before       = profiler->getMicroseconds();
+    VkResult result       = vkGetCalibratedTimestampsEXT(m_device, 1, &info, &timestamp, &maxDeviation);
+    double   after        = profiler->getMicroseconds();
+
+    if(result == VK_SUCCESS && after - before < bestInterval)
+    {
+      bestInterval     = after - before;
+      m_calibrationGpu = timestamp & m_queueFamilyMask;
+      m_calibrationCpu = (before + after) * 0.5;
+    }
+  }
+}
+
 VkQueryPool ProfilerGpuTimer::getPool(PoolContainer& container, uint32_t idx, uint32_t& idxInPool)
 {
   idxInPool = idx % PoolContainer::POOL_QUERY_COUNT;
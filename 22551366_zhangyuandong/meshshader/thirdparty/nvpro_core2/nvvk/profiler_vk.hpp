@@ -32,12 +32,20 @@ public:
   ~ProfilerGpuTimer();
 
   // `profilerTimeline` pointer is copied and must be kept alive during this class lifetime
+  // When VK_EXT_calibrated_timestamps is enabled, the GPU sections of trace captures
+  // (`nvutils::ProfilerManager::beginTraceCapture`) are placed on the CPU timeline.
   void init(nvutils::ProfilerTimeline* profilerTimeline, VkDevice device, VkPhysicalDevice physicalDevice, int queueFamilyIndex, bool useLabels);
   void deinit();
 
   nvutils::ProfilerTimeline*       getProfilerTimeline() { return m_profilerTimeline; }
   const nvutils::ProfilerTimeline* getProfilerTimeline() const { return m_profilerTimeline; }
 
+  bool hasCalibratedTimestamps() const { return m_calibrated; }
+
+  // Device groups, one timer and timeline per device: the timestamps of this timer are written by `deviceIndex`
+  // only. The sections are recorded with the devices of `deviceMask` active, restored after each timestamp.
+  void setDeviceIndex(uint32_t deviceIndex, uint32_t deviceMask);
+
   // not thread-safe
   nvutils::ProfilerTimeline::FrameSectionID cmdFrameBeginSection(VkCommandBuffer cmd, const std::string& name);
   void cmdFrameEndSection(VkCommandBuffer cmd, nvutils::ProfilerTimeline::FrameSectionID slot);
@@ -111,10 +119,15 @@ protected:
   };
 
   bool provideTime(const PoolContainer& container, uint32_t idx, double& time) const;
+  // begin timestamp in `nvutils::ProfilerManager::getMicroseconds()` time
+  bool provideBeginTime(const PoolContainer& container, uint32_t idx, double& time);
+  // correlates the GPU timestamps with the profiler time
+  void calibrate();
 
   VkQueryPool getPool(PoolContainer& container, uint32_t idx, uint32_t& idxInPool);
   VkQueryPool getPool(const PoolContainer& container, uint32_t idx, uint32_t& idxInPool) const;
   void        resizePool(PoolContainer& container, uint32_t requiredSize);
+  void        cmdWriteTimestamp(VkCommandBuffer cmd, VkPipelineStageFlagBits stage, VkQueryPool queryPool, uint32_t idxInPool);
 
   nvutils::ProfilerTimeline*                 m_profilerTimeline{};
   nvutils::ProfilerTimeline::GpuTimeProvider m_timeProvider;
@@ -124,6 +137,15 @@ protected:
   float    m_frequency       = 1.0f;
   uint64_t m_queueFamilyMask = ~0;
 
+  // device group
+  uint32_t m_deviceIndex = ~0U;  // all devices of the command buffer
+  uint32_t m_deviceMask  = 0;
+
+  // calibrated timestamps
+  bool     m_calibrated     = false;
+  uint64_t m_calibrationGpu = 0;  // GPU ticks
+  double   m_calibrationCpu = 0;  // profiler microseconds of m_calibrationGpu
+
   PoolContainer      m_frame;
   PoolContainer      m_async;
   mutable std::mutex m_asyncMutex;
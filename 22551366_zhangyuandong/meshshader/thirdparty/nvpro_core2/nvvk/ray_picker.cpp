@@ -17,8 +17,12 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+
 #include <glm/glm.hpp>
+#include <nvutils/alignment.hpp>
 
+#include "barriers.hpp"
 #include "check_error.hpp"
 #include "debug_util.hpp"
 #include "descriptors.hpp"
@@ -46,6 +50,13 @@ void nvvk::RayPicker::deinit()
 
   m_alloc->destroyBuffer(m_pickResult);
   m_alloc->destroyBuffer(m_sbtBuffer);
+  for(BatchSlot& slot : m_batchSlots)
+  {
+    m_alloc->destroyBuffer(slot.results);
+  }
+  m_batchSlots.clear();
+  m_batchIndex   = 0;
+  m_batchHasRead = false;
   vkDestroyDescriptorSetLayout(device, m_descriptorSetLayout, nullptr);
   vkDestroyPipeline(device, m_pipeline, nullptr);
   vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
@@ -63,11 +74,11 @@ bool nvvk::RayPicker::isValid() const
   return m_pipeline != VK_NULL_HANDLE;
 }
 
-void nvvk::RayPicker::run(VkCommandBuffer cmd, const PickInfo& pickInfo)
+void nvvk::RayPicker::pushDescriptors(VkCommandBuffer cmd, VkAccelerationStructureKHR tlas, const VkDescriptorBufferInfo& result)
 {
   nvvk::WriteSetContainer writeContainer;
-  writeContainer.append(m_bindings.getWriteSet(0), pickInfo.tlas);
-  writeContainer.append(m_bindings.getWriteSet(1), m_pickResult);
+  writeContainer.append(m_bindings.getWriteSet(0), tlas);
+  writeContainer.append(m_bindings.getWriteSet(1), result);
 
   VkPushDescriptorSetInfo pushDescriptorSetInfo{
       .sType                = VK_STRUCTURE_TYPE_PUSH_DESCRIPTOR_SET_INFO_KHR,
@@ -77,6 +88,11 @@ void nvvk::RayPicker::run(VkCommandBuffer cmd, const PickInfo& pickInfo)
       .pDescriptorWrites    = writeContainer.data(),
   };
   vkCmdPushDescriptorSet2(cmd, &pushDescriptorSetInfo);
+}
+
+void nvvk::RayPicker::run(VkCommandBuffer cmd, const PickInfo& pickInfo)
+{
+  pushDescriptors(cmd, pickInfo.tlas, {m_pickResult.buffer, 0, VK_WHOLE_SIZE});
 
   vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
   //vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_descriptorSet, 0, nullptr);
@@ -102,6 +118,127 @@ nvvk::RayPicker::PickResult nvvk::RayPicker::getResult() const
   return pr;
 }
 
+void nvvk::RayPicker::initBatch(uint32_t maxPicksPerBatch, uint32_t ringSize /*= 3*/)
+{
+  assert(m_alloc && "Missing init()");
+  assert(maxPicksPerBatch > 0 && ringSize > 0);
+
+  for(BatchSlot& slot : m_batchSlots)
+  {
+    m_alloc->destroyBuffer(slot.results);
+  }
+
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(m_alloc->getPhysicalDevice(), &properties);
+
+  // the shader writes one `PickResult` with std430 layout (16 bytes aligned) at binding offset 0
+  m_batchStride   = nvutils::align_up(nvutils::align_up(sizeof(PickResult), 16), properties.limits.minStorageBufferOffsetAlignment);
+  m_batchMaxPicks = maxPicksPerBatch;
+  m_batchIndex    = 0;
+  m_batchHasRead  = false;
+  m_batchSlots.clear();
+  m_batchSlots.resize(ringSize);
+
+  for(BatchSlot& slot : m_batchSlots)
+  {
+    NVVK_CHECK(m_alloc->createBuffer(slot.results, m_batchStride * maxPicksPerBatch, VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT,
+                                     VMA_MEMORY_USAGE_AUTO,
+                                     VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT));
+    NVVK_DBG_NAME(slot.results.buffer);
+  }
+}
+
+bool nvvk::RayPicker::runBatch(VkCommandBuffer             cmd,
+                               std::span<const PickInfo>   picks,
+                               uint64_t                    frameIndex,
+                               const nvvk::SemaphoreState& semaphoreState)
+{
+  assert(!m_batchSlots.empty() && "Missing initBatch()");
+  assert(picks.size() <= m_batchMaxPicks);
+
+  BatchSlot& slot = m_batchSlots[m_batchIndex];
+  if(slot.pending && !slot.semaphoreState.testSignaled(m_alloc->getDevice()))
+  {
+    // more frames in flight than the ring covers, drop this batch rather than waiting
+    return false;
+  }
+
+  // The existing shader traces a single ray, each pick gets its own dispatch and result range.
+  // They are independent, so no barrier between them.
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+  const uint32_t count = std::min(static_cast<uint32_t>(picks.size()), m_batchMaxPicks);
+  for(uint32_t i = 0; i < count; i++)
+  {
+    pushDescriptors(cmd, picks[i].tlas, {slot.results.buffer, m_batchStride * i, m_batchStride});
+    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PickInfo), &picks[i]);
+    vkCmdDispatch(cmd, 1, 1, 1);
+  }
+
+  // Make the results visible to the host
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_HOST_BIT,
+                         VK_ACCESS_2_SHADER_WRITE_BIT, VK_ACCESS_2_HOST_READ_BIT);
+
+  slot.count          = count;
+  slot.frameIndex     = frameIndex;
+  slot.semaphoreState = semaphoreState;
+  slot.pending        = true;
+
+  m_batchIndex = (m_batchIndex + 1) % static_cast<uint32_t>(m_batchSlots.size());
+  return true;
+}
+
+bool nvvk::RayPicker::getBatchResults(uint64_t& frameIndex, std::vector<PickResult>& results)
+{
+  VkDevice   device = m_alloc->getDevice();
+  BatchSlot* latest = nullptr;
+
+  for(BatchSlot& slot : m_batchSlots)
+  {
+    if(!slot.pending || (m_batchHasRead && slot.frameIndex <= m_batchLastReadFrame))
+    {
+      continue;
+    }
+    if((!latest || slot.frameIndex > latest->frameIndex) && slot.semaphoreState.testSignaled(device))
+    {
+      latest = &slot;
+    }
+  }
+
+  if(!latest)
+  {
+    return false;
+  }
+
+  NVVK_CHECK(m_alloc->autoInvalidateBuffer(latest->results, 0, m_batchStride * latest->count));
+
+  results.resize(latest->count);
+  for(uint32_t i = 0; i < latest->count; i++)
+  {
+    memcpy(&results[i], latest->results.mapping + m_batchStride * i, sizeof(PickResult));
+  }
+
+  frameIndex           = latest->frameIndex;
+  m_batchLastReadFrame = latest->frameIndex;
+  m_batchHasRead       = true;
+  return true;
+}
+
+std::vector<glm::vec2> nvvk::RayPicker::makeBoxPickPositions(glm::vec2 minPos, glm::vec2 maxPos, glm::uvec2 count)
+{
+  std::vector<glm::vec2> positions;
+  positions.reserve(size_t(count.x) * count.y);
+  for(uint32_t y = 0; y < count.y; y++)
+  {
+    for(uint32_t x = 0; x < count.x; x++)
+    {
+      // sample the center of each cell
+      glm::vec2 t = (glm::vec2(x, y) + 0.5f) / glm::vec2(count);
+      positions.push_back(glm::mix(minPos, maxPos, t));
+    }
+  }
+  return positions;
+}
+
 void nvvk::RayPicker::createOutputResult()
 {
   PickResult presult{};
@@ -355,5 +492,34 @@ std::string nvvk::RayPicker::getGlsl()
     // g_cameraManip->setLookat(eye, worldPos, up, false);  // Nice with CameraManip.updateAnim();
   }
 
+  // Batched picking every frame, reading the results of a previous frame without waiting
+  {
+    uint32_t maxFramesInFlight = 3;
+    rayPicker.initBatch(256 + 1, maxFramesInFlight);
+
+    uint64_t             frameIndex{};
+    nvvk::SemaphoreState frameSemaphoreState{};  // signaled by the frame's submit, e.g. from nvvk::QueueTimeline
+
+    nvvk::RayPicker::PickInfo              hover{.pickPos = localMousePos};
+    std::vector<nvvk::RayPicker::PickInfo> picks{hover};
+
+    // box selection with 16x16 rays
+    for(glm::vec2 pos : nvvk::RayPicker::makeBoxPickPositions({0.25f, 0.25f}, {0.5f, 0.5f}, {16, 16}))
+    {
+      nvvk::RayPicker::PickInfo boxPick = hover;
+      boxPick.pickPos                   = pos;
+      picks.push_back(boxPick);
+    }
+    rayPicker.runBatch(cmd, picks, frameIndex, frameSemaphoreState);
+
+    // later, typically at the start of the next frame
+    uint64_t                                resultFrame{};
+    std::vector<nvvk::RayPicker::PickResult> results;
+    if(rayPicker.getBatchResults(resultFrame, results))
+    {
+      [[maybe_unused]] bool hoverHit = results[0].instanceID > -1;
+    }
+  }
+
   rayPicker.deinit();
 }
@@ -37,14 +37,23 @@
   - call run()
   - call getResult() to get all the information above
 
+  For picking every frame without waiting (hover, box selection), use the batched API:
+  - call initBatch() once, with the number of frames in flight
+  - call runBatch() with all the rays of the frame and the SemaphoreState of its submit
+  - call getBatchResults(), which returns the latest completed batch, usually the previous frame's
+
   See usage_RayPicker() for a complete example.
 
     ```
 */
 
+#include <span>
+#include <vector>
+
 #include <glm/glm.hpp>
 #include "resource_allocator.hpp"
 #include "descriptors.hpp"
+#include "semaphore.hpp"
 
 namespace nvvk {
 
@@ -82,7 +91,33 @@ public:
   PickResult getResult() const;
   bool       isValid() const;
 
+  // Batched picking, results are read back through a ring of `ringSize` buffers.
+  // `ringSize` must cover the frames in flight, as a slot is reused `ringSize` batches later.
+  void initBatch(uint32_t maxPicksPerBatch, uint32_t ringSize = 3);
+
+  // Records all picks into the next ring slot, tagged with `frameIndex`.
+  // `semaphoreState` must be signaled by the submit of `cmd`.
+  // Returns false and records nothing if the slot is still in flight.
+  bool runBatch(VkCommandBuffer cmd, std::span<const PickInfo> picks, uint64_t frameIndex, const nvvk::SemaphoreState& semaphoreState);
+
+  // Copies the results of the most recent completed batch, in the order of its picks, never waits.
+  // Returns false if no new batch completed since the last call.
+  bool getBatchResults(uint64_t& frameIndex, std::vector<PickResult>& results);
+
+  // Normalized positions of a `count.x` x `count.y` grid covering the rectangle [minPos, maxPos], for box selection
+  static std::vector<glm::vec2> makeBoxPickPositions(glm::vec2 minPos, glm::vec2 maxPos, glm::uvec2 count);
+
 private:
+  struct BatchSlot
+  {
+    nvvk::Buffer         results;
+    uint32_t             count{};
+    uint64_t             frameIndex{};
+    nvvk::SemaphoreState semaphoreState;
+    bool                 pending{};
+  };
+
+  void                            pushDescriptors(VkCommandBuffer cmd, VkAccelerationStructureKHR tlas, const VkDescriptorBufferInfo& result);
   void                            createOutputResult();
   void                            createDescriptorSet();
   void                            createPipeline();
@@ -97,6 +132,13 @@ private:
   VkDescriptorSetLayout m_descriptorSetLayout{};
   VkPipelineLayout      m_pipelineLayout{};
   VkPipeline            m_pipeline{};
+
+  std::vector<BatchSlot> m_batchSlots;
+  uint32_t               m_batchIndex{};         // next slot used by runBatch
+  uint32_t               m_batchMaxPicks{};      // capacity of a slot
+  VkDeviceSize           m_batchStride{};        // size of one result in a slot, honors the storage buffer alignment
+  uint64_t               m_batchLastReadFrame{};  // frame of the last batch returned by getBatchResults
+  bool                   m_batchHasRead{};
 };
 
 
@@ -0,0 +1,788 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+
+#include <volk.h>
+
+#include "render_graph.hpp"
+#include "check_error.hpp"
+#include "debug_util.hpp"
+
+//--------------------------------------------------------------------------------------------------
+// Pass declaration
+//--------------------------------------------------------------------------------------------------
+
+nvvk::RenderGraph::PassBuilder& nvvk::RenderGraph::PassBuilder::read(ImageHandle           image,
+                                                                     VkImageLayout         layout,
+                                                                     VkPipelineStageFlags2 stages,
+                                                                     VkAccessFlags2        access)
+{
+  return addAccess(image.index, layout, stages, access != INFER_BARRIER_PARAMS ? access : inferAccessMaskFromStage(stages, true), 0);
+}
+
+nvvk::RenderGraph::PassBuilder& nvvk::RenderGraph::PassBuilder::write(ImageHandle           image,
+                                                                      VkImageLayout         layout,
+                                                                      VkPipelineStageFlags2 stages,
+                                                                      VkAccessFlags2        access)
+{
+  return addAccess(image.index, layout, stages, 0, access != INFER_BARRIER_PARAMS ? access : inferAccessMaskFromStage(stages, false));
+}
+
+nvvk::RenderGraph::PassBuilder& nvvk::RenderGraph::PassBuilder::readWrite(ImageHandle image, VkImageLayout layout, VkPipelineStageFlags2 stages)
+{
+  return addAccess(image.index, layout, stages, inferAccessMaskFromStage(stages, true), inferAccessMaskFromStage(stages, false));
+}
+
+nvvk::RenderGraph::PassBuilder& nvvk::RenderGraph::PassBuilder::read(BufferHandle buffer, VkPipelineStageFlags2 stages, VkAccessFlags2 access)
+{
+  return addAccess(buffer.index, VK_IMAGE_LAYOUT_UNDEFINED, stages,
+                   access != INFER_BARRIER_PARAMS ? access : inferAccessMaskFromStage(stages, true), 0);
+}
+
+nvvk::RenderGraph::PassBuilder& nvvk::RenderGraph::PassBuilder::write(BufferHandle buffer, VkPipelineStageFlags2 stages, VkAccessFlags2 access)
+{
+  return addAccess(buffer.index, VK_IMAGE_LAYOUT_UNDEFINED, stages, 0,
+                   access != INFER_BARRIER_PARAMS ? access : inferAccessMaskFromStage(stages, false));
+}
+
+nvvk::RenderGraph::PassBuilder& nvvk::RenderGraph::PassBuilder::readWrite(BufferHandle buffer, VkPipelineStageFlags2 stages)
+{
+  return addAccess(buffer.index, VK_IMAGE_LAYOUT_UNDEFINED, stages, inferAccessMaskFromStage(stages, true),
+                   inferAccessMaskFromStage(stages, false));
+}
+
+nvvk::RenderGraph::PassBuilder& nvvk::RenderGraph::PassBuilder::setSideEffect()
+{
+  m_graph.m_passes[m_pass].sideEffect = true;
+  return *this;
+}
+
+nvvk::RenderGraph::PassBuilder& nvvk::RenderGraph::PassBuilder::addAccess(uint32_t              resource,
+                                                                          VkImageLayout         layout,
+                                                                          VkPipelineStageFlags2 stages,
+                                                                          VkAccessFlags2        readAccess,
+                                                                          VkAccessFlags2        writeAccess)
+{
+  assert(resource < m_graph.m_resources.size() && "Invalid handle");
+  assert((readAccess | writeAccess) != 0 && "No access for these stages");
+
+  std::vector<Access>& accesses = m_graph.m_passes[m_pass].accesses;
+  for(const Access& access : accesses)
+  {
+    assert(access.resource != resource && "Resource accessed twice by the pass, use readWrite");
+  }
+  accesses.push_back({resource, layout, stages, readAccess, writeAccess});
+  return *this;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Graph
+//--------------------------------------------------------------------------------------------------
+
+void nvvk::RenderGraph::init(ResourceAllocator* allocator)
+{
+  assert(m_allocator == nullptr && "Missing deinit()");
+  m_allocator = allocator;
+  m_transientImages.init(allocator);
+}
+
+void nvvk::RenderGraph::deinit()
+{
+  if(!m_allocator)
+    return;
+
+  clear();
+  m_transientImages.deinit();
+  m_allocator = nullptr;
+}
+
+void nvvk::RenderGraph::clear()
+{
+  destroyResources();
+  m_passes.clear();
+  m_resources.clear();
+}
+
+nvvk::RenderGraph::ImageHandle nvvk::RenderGraph::createImage(const VkImageCreateInfo&     imageInfo,
+                                                                const VkImageViewCreateInfo& viewInfo,
+                                                                const std::string&           name)
+{
+  Resource resource;
+  resource.name      = name;
+  resource.isImage   = true;
+  resource.imageInfo = imageInfo;
+  resource.viewInfo  = viewInfo;
+  resource.range     = {viewInfo.subresourceRange.aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+  m_resources.push_back(std::move(resource));
+  return {uint32_t(m_resources.size() - 1)};
+}
+
+nvvk::RenderGraph::BufferHandle nvvk::RenderGraph::createBuffer(VkDeviceSize size, VkBufferUsageFlags2KHR usage, const std::string& name)
+{
+  Resource resource;
+  resource.name        = name;
+  resource.bufferSize  = size;
+  resource.bufferUsage = usage;
+  m_resources.push_back(std::move(resource));
+  return {uint32_t(m_resources.size() - 1)};
+}
+
+nvvk::RenderGraph::ImageHandle nvvk::RenderGraph::importImage(nvvk::Image* image, VkImageAspectFlags aspectMask, const std::string& name)
+{
+  Resource resource;
+  resource.name          = name;
+  resource.isImage       = true;
+  resource.imported      = true;
+  resource.importedImage = image;
+  resource.range         = {aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+  m_resources.push_back(std::move(resource));
+  return {uint32_t(m_resources.size() - 1)};
+}
+
+nvvk::RenderGraph::BufferHandle nvvk::RenderGraph::importBuffer(const nvvk::Buffer& buffer, const std::string& name)
+{
+  Resource resource;
+  resource.name           = name;
+  resource.imported       = true;
+  resource.importedBuffer = buffer;
+  m_resources.push_back(std::move(resource));
+  return {uint32_t(m_resources.size() - 1)};
+}
+
+nvvk::RenderGraph::PassBuilder nvvk::RenderGraph::addPass(const std::string& name, QueueType queue, RecordCallback callback)
+{
+  Pass pass;
+  pass.name     = name;
+  pass.queue    = queue;
+  pass.callback = std::move(callback);
+  m_passes.push_back(std::move(pass));
+  return PassBuilder(*this, uint32_t(m_passes.size() - 1));
+}
+
+void nvvk::RenderGraph::setExtent(ImageHandle image, VkExtent3D extent)
+{
+  assert(m_resources[image.index].isImage && !m_resources[image.index].imported);
+  m_resources[image.index].imageInfo.extent = extent;
+}
+
+void nvvk::RenderGraph::cullPasses()
+{
+  // backwards: a pass is needed when a recorded pass after it reads what it writes, before it's written again
+  std::vector<bool> needed(m_resources.size(), false);
+  for(size_t p = m_passes.size(); p-- > 0;)
+  {
+    Pass& pass  = m_passes[p];
+    pass.culled = !pass.sideEffect;
+    for(const Access& access : pass.accesses)
+    {
+      if(access.writeAccess && (m_resources[access.resource].imported || needed[access.resource]))
+      {
+        pass.culled = false;
+      }
+    }
+    if(pass.culled)
+    {
+      continue;
+    }
+
+    // a write serves the reads after it, unless the pass reads the resource too
+    for(const Access& access : pass.accesses)
+    {
+      if(access.writeAccess)
+      {
+        needed[access.resource] = false;
+      }
+      if(access.readAccess)
+      {
+        needed[access.resource] = true;
+      }
+    }
+  }
+}
+
+void nvvk::RenderGraph::schedulePasses()
+{
+  // the compute submit of the frame runs before the graphics one: an async pass can't follow a graphics access
+  std::vector<bool> graphicsAccessed(m_resources.size(), false);
+  for(Pass& pass : m_passes)
+  {
+    pass.scheduledQueue = QueueType::eGraphics;
+    if(pass.culled)
+    {
+      continue;
+    }
+
+    if(pass.queue == QueueType::eAsyncCompute && m_info.asyncCompute)
+    {
+      bool followsGraphics = false;
+      for(const Access& access : pass.accesses)
+      {
+        followsGraphics = followsGraphics || graphicsAccessed[access.resource];
+      }
+      if(!followsGraphics)
+      {
+        pass.scheduledQueue = QueueType::eAsyncCompute;
+        for(const Access& access : pass.accesses)
+        {
+          m_resources[access.resource].async = true;
+        }
+        continue;
+      }
+    }
+
+    for(const Access& access : pass.accesses)
+    {
+      graphicsAccessed[access.resource] = true;
+    }
+  }
+}
+
+VkResult nvvk::RenderGraph::compile(const CompileInfo& info)
+{
+  assert(m_allocator && "Missing init()");
+
+  destroyResources();
+  m_info                = info;
+  m_info.frameCycleSize = std::max(info.frameCycleSize, 1U);
+  m_queueFamilies[0]    = info.graphicsQueueFamily;
+  m_queueFamilies[1]    = info.computeQueueFamily;
+
+  cullPasses();
+  schedulePasses();
+
+  m_report        = {};
+  m_report.passes = uint32_t(m_passes.size());
+
+  // lifetimes of the transients, over the order of the recorded graphics passes
+  uint32_t order = 0;
+  for(const Pass& pass : m_passes)
+  {
+    if(pass.culled)
+    {
+      m_report.culledPasses++;
+      continue;
+    }
+    if(pass.scheduledQueue == QueueType::eAsyncCompute)
+    {
+      m_report.asyncPasses++;
+      continue;
+    }
+    if(pass.queue == QueueType::eAsyncCompute)
+    {
+      m_report.movedPasses++;
+    }
+
+    for(const Access& access : pass.accesses)
+    {
+      Resource& resource = m_resources[access.resource];
+      resource.firstPass = std::min(resource.firstPass, order);
+      resource.lastPass  = std::max(resource.lastPass, order);
+    }
+    order++;
+  }
+
+  const bool concurrent = m_info.asyncCompute && m_queueFamilies[0] != m_queueFamilies[1];
+  for(uint32_t r = 0; r < uint32_t(m_resources.size()); r++)
+  {
+    Resource& resource = m_resources[r];
+    if(resource.imported || (resource.firstPass == ~0U && !resource.async))
+    {
+      continue;  // only used by culled passes
+    }
+
+    // the copies of the async transients are live all the time, they don't alias
+    const uint32_t copies    = resource.async ? m_info.frameCycleSize : 1;
+    const uint32_t firstPass = resource.async ? 0 : resource.firstPass;
+    const uint32_t lastPass  = resource.async ? ~0U : resource.lastPass;
+    for(uint32_t copy = 0; copy < copies; copy++)
+    {
+      const std::string name = copies > 1 ? resource.name + "[" + std::to_string(copy) + "]" : resource.name;
+      if(resource.isImage)
+      {
+        VkImageCreateInfo imageInfo = resource.imageInfo;
+        if(resource.async && concurrent)
+        {
+          imageInfo.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+          imageInfo.queueFamilyIndexCount = 2;
+          imageInfo.pQueueFamilyIndices   = m_queueFamilies;
+        }
+        resource.slots.push_back(m_transientImages.addImage(imageInfo, resource.viewInfo, firstPass, lastPass, name));
+      }
+      else
+      {
+        TransientBuffer transient;
+        transient.resource  = r;
+        transient.name      = name;
+        transient.firstPass = firstPass;
+        transient.lastPass  = lastPass;
+        m_transientBuffers.push_back(std::move(transient));
+        resource.slots.push_back(uint32_t(m_transientBuffers.size() - 1));
+      }
+    }
+  }
+
+  NVVK_FAIL_RETURN(m_transientImages.build());
+  NVVK_FAIL_RETURN(createBuffers());
+
+  const TransientImageAllocator::Report imageReport = m_transientImages.getReport();
+  m_report.aliasedSize += imageReport.aliasedSize;
+  m_report.unaliasedSize += imageReport.unaliasedSize;
+  m_report.dedicatedSize += imageReport.dedicatedSize;
+
+  m_compiled = true;
+  return VK_SUCCESS;
+}
+
+VkResult nvvk::RenderGraph::createBuffers()
+{
+  VkDevice device = m_allocator->getDevice();
+
+  const bool concurrent = m_info.asyncCompute && m_queueFamilies[0] != m_queueFamilies[1];
+  for(TransientBuffer& transient : m_transientBuffers)
+  {
+    const Resource& resource    = m_resources[transient.resource];
+    const bool      isShared    = resource.async && concurrent;
+    const VkBufferUsageFlags2CreateInfo usageInfo{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_USAGE_FLAGS_2_CREATE_INFO,
+        .usage = resource.bufferUsage | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
+    };
+    const VkBufferCreateInfo bufferInfo{
+        .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext                 = &usageInfo,
+        .size                  = resource.bufferSize,
+        .sharingMode           = isShared ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = isShared ? 2U : 0U,
+        .pQueueFamilyIndices   = m_queueFamilies,
+    };
+    NVVK_FAIL_RETURN(vkCreateBuffer(device, &bufferInfo, nullptr, &transient.buffer.buffer));
+    vkGetBufferMemoryRequirements(device, transient.buffer.buffer, &transient.memReqs);
+    transient.buffer.bufferSize = resource.bufferSize;
+  }
+
+  // as TransientImageAllocator::build: the largest buffers first, each at the lowest offset
+  // not used by a buffer live in the same passes
+  std::vector<uint32_t> order(m_transientBuffers.size());
+  for(uint32_t i = 0; i < uint32_t(order.size()); i++)
+  {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+            [&](uint32_t a, uint32_t b) { return m_transientBuffers[a].memReqs.size > m_transientBuffers[b].memReqs.size; });
+
+  VkMemoryRequirements  totalReqs{.size = 0, .alignment = 1, .memoryTypeBits = ~0U};
+  std::vector<uint32_t> placed;
+  for(uint32_t index : order)
+  {
+    TransientBuffer&            transient = m_transientBuffers[index];
+    const VkMemoryRequirements& req       = transient.memReqs;
+
+    // memory types must be compatible with all buffers of the allocation
+    if((totalReqs.memoryTypeBits & req.memoryTypeBits) == 0)
+    {
+      const VmaAllocationCreateInfo allocInfo{.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE};
+      VmaAllocationInfo             allocInfoOut{};
+      NVVK_FAIL_RETURN(vmaAllocateMemoryForBuffer(*m_allocator, transient.buffer.buffer, &allocInfo,
+                                                  &transient.buffer.allocation, &allocInfoOut));
+      NVVK_FAIL_RETURN(vmaBindBufferMemory(*m_allocator, transient.buffer.allocation, transient.buffer.buffer));
+      m_report.dedicatedSize += allocInfoOut.size;
+      continue;
+    }
+
+    std::vector<uint32_t> conflicts;
+    for(uint32_t other : placed)
+    {
+      const TransientBuffer& otherTransient = m_transientBuffers[other];
+      if(otherTransient.firstPass <= transient.lastPass && transient.firstPass <= otherTransient.lastPass)
+      {
+        conflicts.push_back(other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [&](uint32_t a, uint32_t b) { return m_transientBuffers[a].offset < m_transientBuffers[b].offset; });
+
+    VkDeviceSize offset = 0;
+    for(uint32_t other : conflicts)
+    {
+      offset = (offset + req.alignment - 1) / req.alignment * req.alignment;
+      if(offset + req.size <= m_transientBuffers[other].offset)
+      {
+        break;
+      }
+      offset = std::max(offset, m_transientBuffers[other].offset + m_transientBuffers[other].memReqs.size);
+    }
+    offset = (offset + req.alignment - 1) / req.alignment * req.alignment;
+
+    transient.offset = offset;
+    placed.push_back(index);
+
+    totalReqs.size      = std::max(totalReqs.size, offset + req.size);
+    totalReqs.alignment = std::max(totalReqs.alignment, req.alignment);
+    totalReqs.memoryTypeBits &= req.memoryTypeBits;
+    m_report.unaliasedSize += req.size;
+  }
+
+  if(!placed.empty())
+  {
+    const VmaAllocationCreateInfo allocInfo{.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+    NVVK_FAIL_RETURN(vmaAllocateMemory(*m_allocator, &totalReqs, &allocInfo, &m_bufferMemory, nullptr));
+    m_report.aliasedSize += totalReqs.size;
+
+    for(uint32_t index : placed)
+    {
+      TransientBuffer& transient = m_transientBuffers[index];
+      NVVK_FAIL_RETURN(vmaBindBufferMemory2(*m_allocator, m_bufferMemory, transient.offset, transient.buffer.buffer, nullptr));
+    }
+  }
+
+  for(TransientBuffer& transient : m_transientBuffers)
+  {
+    const VkBufferDeviceAddressInfo info{.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, .buffer = transient.buffer.buffer};
+    transient.buffer.address = vkGetBufferDeviceAddress(device, &info);
+    nvvk::DebugUtil::getInstance().setObjectName(transient.buffer.buffer, transient.name);
+  }
+
+  return VK_SUCCESS;
+}
+
+void nvvk::RenderGraph::destroyResources()
+{
+  if(!m_allocator)
+    return;
+
+  // drops the declarations of the images too, `compile` declares them again
+  m_transientImages.deinit();
+  m_transientImages.init(m_allocator);
+
+  VkDevice device = m_allocator->getDevice();
+  for(TransientBuffer& transient : m_transientBuffers)
+  {
+    if(transient.buffer.allocation)
+    {
+      vmaDestroyBuffer(*m_allocator, transient.buffer.buffer, transient.buffer.allocation);
+    }
+    else
+    {
+      vkDestroyBuffer(device, transient.buffer.buffer, nullptr);
+    }
+  }
+  m_transientBuffers.clear();
+
+  if(m_bufferMemory)
+  {
+    vmaFreeMemory(*m_allocator, m_bufferMemory);
+    m_bufferMemory = nullptr;
+  }
+
+  for(Resource& resource : m_resources)
+  {
+    resource.firstPass   = ~0U;
+    resource.lastPass    = 0;
+    resource.async       = false;
+    resource.asyncLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resource.slots.clear();
+  }
+  m_compiled = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Recording
+//--------------------------------------------------------------------------------------------------
+
+uint32_t nvvk::RenderGraph::getSlot(const Resource& resource) const
+{
+  assert(!resource.slots.empty() && "Not created, all the passes using it are culled");
+  return resource.slots[resource.async ? m_frameCycle : 0];
+}
+
+const nvvk::Image& nvvk::RenderGraph::getImage(ImageHandle image) const
+{
+  const Resource& resource = m_resources[image.index];
+  assert(resource.isImage);
+  return resource.imported ? *resource.importedImage : m_transientImages.getImage(getSlot(resource));
+}
+
+const nvvk::Buffer& nvvk::RenderGraph::getBuffer(BufferHandle buffer) const
+{
+  const Resource& resource = m_resources[buffer.index];
+  assert(!resource.isImage);
+  return resource.imported ? resource.importedBuffer : m_transientBuffers[getSlot(resource)].buffer;
+}
+
+void nvvk::RenderGraph::appendBarriers(BarrierContainer& barriers, QueueType queue, const Access& access)
+{
+  Resource& resource = m_resources[access.resource];
+  State&    state    = resource.state;
+
+  if(!state.touched)
+  {
+    state.touched = true;
+    if(resource.imported)
+    {
+      // after the previous frame, or the commands outside of the graph
+      state.layout      = resource.isImage ? resource.importedImage->descriptor.imageLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+      state.writeStages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+      state.writeAccess = VK_ACCESS_2_MEMORY_WRITE_BIT;
+    }
+    else if(resource.async && queue == QueueType::eGraphics)
+    {
+      // written on the compute queue, the graphics submit waits for it
+      state.layout = resource.asyncLayout;
+    }
+    else
+    {
+      // discards the content, after the previous user of the memory
+      state.layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+      state.writeStages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+      state.writeAccess = VK_ACCESS_2_MEMORY_WRITE_BIT;
+    }
+  }
+
+  const VkAccessFlags2 dstAccess = access.readAccess | access.writeAccess;
+
+  if(resource.isImage && access.layout != state.layout)
+  {
+    const VkPipelineStageFlags2 srcStages = state.writeStages | state.readStages;
+    barriers.appendImageMemoryBarrier({
+        .image            = getImage({access.resource}).image,
+        .oldLayout        = state.layout,
+        .newLayout        = access.layout,
+        .subresourceRange = resource.range,
+        // nothing to wait for after the semaphore of the compute submit, but the transition must follow it
+        .srcStageMask  = srcStages ? srcStages : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        .dstStageMask  = access.stages,
+        .srcAccessMask = state.writeAccess,
+        .dstAccessMask = dstAccess,
+    });
+    if(resource.imported)
+    {
+      resource.importedImage->descriptor.imageLayout = access.layout;
+    }
+
+    // the transition is a write, seen by the stages of the access
+    const bool isRead   = access.writeAccess == 0;
+    state.layout        = access.layout;
+    state.writeStages   = access.stages;
+    state.writeAccess   = access.writeAccess;
+    state.readStages    = isRead ? access.stages : 0;
+    state.visibleStages = isRead ? access.stages : 0;
+    state.visibleAccess = isRead ? access.readAccess : 0;
+    return;
+  }
+
+  if(access.writeAccess)
+  {
+    // after the last write and the reads since
+    const VkPipelineStageFlags2 srcStages = state.writeStages | state.readStages;
+    if(srcStages)
+    {
+      barriers.appendMemoryBarrier(srcStages, access.stages, state.writeAccess, dstAccess);
+    }
+    state.writeStages   = access.stages;
+    state.writeAccess   = access.writeAccess;
+    state.readStages    = 0;
+    state.visibleStages = 0;
+    state.visibleAccess = 0;
+  }
+  else
+  {
+    // reads in the same layout only wait when they don't see the last write yet
+    if(state.writeStages && ((access.stages & ~state.visibleStages) || (access.readAccess & ~state.visibleAccess)))
+    {
+      barriers.appendMemoryBarrier(state.writeStages, access.stages, state.writeAccess, access.readAccess);
+      state.visibleStages |= access.stages;
+      state.visibleAccess |= access.readAccess;
+    }
+    state.readStages |= access.stages;
+  }
+}
+
+void nvvk::RenderGraph::recordPasses(VkCommandBuffer cmd, QueueType queue, uint32_t frameCycle)
+{
+  assert(m_compiled && "Missing compile()");
+
+  m_frameCycle = frameCycle % m_info.frameCycleSize;
+  for(Resource& resource : m_resources)
+  {
+    resource.state = {};
+  }
+
+  QueueStats& stats = m_queueStats[uint32_t(queue)];
+  stats             = {};
+
+  BarrierContainer barriers;
+  for(const Pass& pass : m_passes)
+  {
+    if(pass.culled || pass.scheduledQueue != queue)
+    {
+      continue;
+    }
+
+    for(const Access& access : pass.accesses)
+    {
+      appendBarriers(barriers, queue, access);
+    }
+    if(!barriers.empty())
+    {
+      stats.barrierBatches++;
+      stats.imageBarriers += uint32_t(barriers.imageBarriers.size());
+      stats.memoryBarriers += uint32_t(barriers.memoryBarriers.size());
+      barriers.cmdFlush(cmd);
+    }
+
+    nvvk::DebugUtil::ScopedCmdLabel scopedCmdLabel(cmd, pass.name);
+    pass.callback(cmd, *this);
+  }
+
+  // where the graphics queue continues from
+  if(queue == QueueType::eAsyncCompute)
+  {
+    for(Resource& resource : m_resources)
+    {
+      if(resource.async && resource.state.touched)
+      {
+        resource.asyncLayout = resource.state.layout;
+      }
+    }
+  }
+}
+
+void nvvk::RenderGraph::recordCompute(VkCommandBuffer cmd, uint32_t frameCycle)
+{
+  if(m_info.asyncCompute)
+  {
+    recordPasses(cmd, QueueType::eAsyncCompute, frameCycle);
+  }
+}
+
+void nvvk::RenderGraph::recordGraphics(VkCommandBuffer cmd, uint32_t frameCycle)
+{
+  recordPasses(cmd, QueueType::eGraphics, frameCycle);
+}
+
+nvvk::RenderGraph::Report nvvk::RenderGraph::getReport() const
+{
+  Report report = m_report;
+  for(const QueueStats& stats : m_queueStats)
+  {
+    report.barrierBatches += stats.barrierBatches;
+    report.imageBarriers += stats.imageBarriers;
+    report.memoryBarriers += stats.memoryBarriers;
+  }
+  return report;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_RenderGraph()
+{
+  nvvk::ResourceAllocator allocator;  // EX: initialized somewhere
+  nvvk::Image             outputImage;  // EX: the G-Buffer color displayed by the UI
+  nvvk::Buffer            sceneBuffer;  // EX: scene data written outside of the graph
+
+  nvvk::RenderGraph graph;
+  graph.init(&allocator);
+
+  // cull -> shadow -> scene -> tonemap
+  const nvvk::RenderGraph::BufferHandle scene    = graph.importBuffer(sceneBuffer, "Scene");
+  const nvvk::RenderGraph::ImageHandle  output   = graph.importImage(&outputImage, VK_IMAGE_ASPECT_COLOR_BIT, "Output");
+  const nvvk::RenderGraph::BufferHandle indirect = graph.createBuffer(4096, VK_BUFFER_USAGE_2_INDIRECT_BUFFER_BIT, "DrawIndirect");
+
+  VkImageCreateInfo imageInfo{
+      .sType       = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .imageType   = VK_IMAGE_TYPE_2D,
+      .format      = VK_FORMAT_D32_SFLOAT,
+      .extent      = {2048, 2048, 1},
+      .mipLevels   = 1,
+      .arrayLayers = 1,
+      .samples     = VK_SAMPLE_COUNT_1_BIT,
+      .usage       = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+  };
+  VkImageViewCreateInfo viewInfo{
+      .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+      .format           = imageInfo.format,
+      .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT, .levelCount = 1, .layerCount = 1},
+  };
+  const nvvk::RenderGraph::ImageHandle shadowMap = graph.createImage(imageInfo, viewInfo, "ShadowMap");
+
+  // the HDR color is only live after the shadow pass: it shares the shadow map memory
+  imageInfo.format                     = VK_FORMAT_R16G16B16A16_SFLOAT;
+  imageInfo.extent                     = {1920, 1080, 1};
+  imageInfo.usage                      = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+  viewInfo.format                      = imageInfo.format;
+  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  const nvvk::RenderGraph::ImageHandle hdrColor = graph.createImage(imageInfo, viewInfo, "HdrColor");
+
+  graph
+      .addPass("Cull", nvvk::RenderGraph::QueueType::eAsyncCompute,
+               [&](VkCommandBuffer cmd, const nvvk::RenderGraph& g) {
+                 // vkCmdDispatch(...) writing g.getBuffer(indirect).address
+               })
+      .read(scene, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+      .write(indirect, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+  graph
+      .addPass("Shadow", nvvk::RenderGraph::QueueType::eGraphics,
+               [&](VkCommandBuffer cmd, const nvvk::RenderGraph& g) {
+                 // vkCmdBeginRendering with g.getImage(shadowMap).descriptor.imageView ...
+               })
+      .read(scene, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT)
+      .write(shadowMap, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+             VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT);
+
+  graph
+      .addPass("Scene", nvvk::RenderGraph::QueueType::eGraphics,
+               [&](VkCommandBuffer cmd, const nvvk::RenderGraph& g) {
+                 // vkCmdDrawIndirect(cmd, g.getBuffer(indirect).buffer, ...)
+               })
+      .read(indirect, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT)
+      .read(shadowMap, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT)
+      .write(hdrColor, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+  graph
+      .addPass("Tonemap", nvvk::RenderGraph::QueueType::eGraphics,
+               [&](VkCommandBuffer cmd, const nvvk::RenderGraph& g) {
+                 // vkCmdDispatch(...) from g.getImage(hdrColor) to g.getImage(output)
+               })
+      .read(hdrColor, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+      .write(output, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+  // nvapp::Application* app;  // EX: the application of the element
+  NVVK_CHECK(graph.compile({
+      .asyncCompute        = false,  // app->hasAsyncCompute()
+      .frameCycleSize      = 1,      // app->getFrameCycleSize()
+      .graphicsQueueFamily = 0,      // app->getQueue(0).familyIndex
+      .computeQueueFamily  = 0,      // app->getComputeQueue().familyIndex
+  }));
+
+  // each frame, from onRenderCompute(cmd) and onRender(cmd)
+  VkCommandBuffer cmd{};
+  uint32_t        frameCycle = 0;  // app->getFrameCycleIndex()
+  graph.recordCompute(cmd, frameCycle);
+  graph.recordGraphics(cmd, frameCycle);
+
+  // on resize
+  graph.setExtent(hdrColor, {1280, 720, 1});
+  NVVK_CHECK(graph.compile({}));
+
+  graph.deinit();
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cassert>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include "barriers.hpp"
+#include "resource_allocator.hpp"
+#include "transient_images.hpp"
+
+namespace nvvk {
+
+//-----------------------------------------------------------------
+// Render Graph
+//
+// The passes of a frame declare the images and buffers they read and write, the graph records
+// them with the barriers in between, in place of those written by hand in `IAppElement::onRender`.
+//
+// - Barriers: each access is compared to the previous access of the resource. A read after a read
+//   in the same layout needs none. Layout changes are image barriers, the other hazards global
+//   memory barriers, and the barriers of a pass are recorded with one vkCmdPipelineBarrier2.
+// - Culling: a pass is not recorded when no recorded pass reads what it writes. The passes writing
+//   an imported resource, or marked with `setSideEffect`, are always recorded.
+// - Aliasing: the transient images and buffers created by the graph live from their first to their
+//   last pass, the ones whose passes don't overlap share memory (see `TransientImageAllocator`).
+//   The content of a transient is undefined at its first pass, which must write it.
+// - Async compute: the `eAsyncCompute` passes are recorded by `recordCompute`, from `IAppElement::onRenderCompute`.
+//   The graphics submit of the frame waits for the compute one: an async pass accessing a resource a graphics pass
+//   of the frame accessed before is moved to the graphics queue, like all passes without an async queue.
+//   The transients of the async passes overlap the previous frames, they have one copy per frame in flight.
+//
+// Imported resources are owned by the application and keep their content between frames. Their first access of
+// a frame waits for all previous commands of the queue, an imported image starts from and keeps its layout in
+// `descriptor.imageLayout`. As with `onRenderCompute`, an async pass must not overwrite an imported resource that
+// the previous frame still reads. When the queue families differ, the transients of the async passes are
+// VK_SHARING_MODE_CONCURRENT, and the imported resources used on both queues must be too.
+//
+// Usage:
+//   see usage_RenderGraph in render_graph.cpp
+//-----------------------------------------------------------------
+class RenderGraph
+{
+public:
+  enum class QueueType
+  {
+    eGraphics,
+    eAsyncCompute,
+  };
+
+  struct ImageHandle
+  {
+    uint32_t index = ~0U;
+  };
+  struct BufferHandle
+  {
+    uint32_t index = ~0U;
+  };
+
+  using RecordCallback = std::function<void(VkCommandBuffer cmd, const RenderGraph& graph)>;
+
+  // Declares the accesses of a pass, the access masks are inferred from the stages by default.
+  // A pass accesses a resource once: `readWrite` for the in-place updates (storage images, depth test and write...)
+  class PassBuilder
+  {
+  public:
+    PassBuilder& read(ImageHandle image, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 access = INFER_BARRIER_PARAMS);
+    PassBuilder& write(ImageHandle image, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 access = INFER_BARRIER_PARAMS);
+    PassBuilder& readWrite(ImageHandle image, VkImageLayout layout, VkPipelineStageFlags2 stages);
+
+    PassBuilder& read(BufferHandle buffer, VkPipelineStageFlags2 stages, VkAccessFlags2 access = INFER_BARRIER_PARAMS);
+    PassBuilder& write(BufferHandle buffer, VkPipelineStageFlags2 stages, VkAccessFlags2 access = INFER_BARRIER_PARAMS);
+    PassBuilder& readWrite(BufferHandle buffer, VkPipelineStageFlags2 stages);
+
+    // Recorded even when nothing reads its writes, e.g. readbacks or writes outside of the graph
+    PassBuilder& setSideEffect();
+
+  private:
+    friend class RenderGraph;
+    PassBuilder(RenderGraph& graph, uint32_t pass)
+        : m_graph(graph)
+        , m_pass(pass)
+    {
+    }
+    PassBuilder& addAccess(uint32_t resource, VkImageLayout layout, VkPipelineStageFlags2 stages, VkAccessFlags2 readAccess, VkAccessFlags2 writeAccess);
+
+    RenderGraph& m_graph;
+    uint32_t     m_pass;
+  };
+
+  struct CompileInfo
+  {
+    bool     asyncCompute        = false;  // nvapp::Application::hasAsyncCompute()
+    uint32_t frameCycleSize      = 1;      // nvapp::Application::getFrameCycleSize(), compile again when it changes
+    uint32_t graphicsQueueFamily = 0;
+    uint32_t computeQueueFamily  = 0;
+  };
+
+  struct Report
+  {
+    uint32_t     passes{};          // declared
+    uint32_t     culledPasses{};    // not recorded, nothing reads their writes
+    uint32_t     asyncPasses{};     // recorded on the async compute queue
+    uint32_t     movedPasses{};     // declared async, recorded on the graphics queue
+    VkDeviceSize aliasedSize{};     // memory of the transients
+    VkDeviceSize unaliasedSize{};   // sum of their sizes, what they would cost without aliasing
+    VkDeviceSize dedicatedSize{};   // transients with their own allocation
+    uint32_t     barrierBatches{};  // of the last recorded frame
+    uint32_t     imageBarriers{};
+    uint32_t     memoryBarriers{};
+  };
+
+  RenderGraph() = default;
+  ~RenderGraph() { assert(m_allocator == nullptr && "Missing deinit()"); }
+
+  RenderGraph(const RenderGraph&)            = delete;
+  RenderGraph& operator=(const RenderGraph&) = delete;
+
+  void init(ResourceAllocator* allocator);
+  void deinit();
+
+  // Destroys the resources and drops the declarations, before declaring another graph
+  void clear();
+
+  // Transient resources, created by `compile`. `viewInfo.image` is filled by the graph.
+  ImageHandle  createImage(const VkImageCreateInfo& imageInfo, const VkImageViewCreateInfo& viewInfo, const std::string& name);
+  BufferHandle createBuffer(VkDeviceSize size, VkBufferUsageFlags2KHR usage, const std::string& name);
+
+  // Resources of the application, which must outlive the graph: the image is referenced to track its layout
+  ImageHandle  importImage(nvvk::Image* image, VkImageAspectFlags aspectMask, const std::string& name);
+  BufferHandle importBuffer(const nvvk::Buffer& buffer, const std::string& name);
+
+  // Passes are recorded in the order they are added
+  PassBuilder addPass(const std::string& name, QueueType queue, RecordCallback callback);
+
+  // Culls and schedules the passes and creates the transients
+  VkResult compile(const CompileInfo& info);
+
+  // Destroys the transients but keeps the declarations, e.g. to change extents with `setExtent` and compile again
+  void destroyResources();
+
+  void setExtent(ImageHandle image, VkExtent3D extent);
+
+  // The async passes, from IAppElement::onRenderCompute(), before `recordGraphics`. `frameCycle` is
+  // nvapp::Application::getFrameCycleIndex() and selects the copy of the transients of the async passes.
+  void recordCompute(VkCommandBuffer cmd, uint32_t frameCycle);
+  // The graphics passes, from IAppElement::onRender()
+  void recordGraphics(VkCommandBuffer cmd, uint32_t frameCycle);
+
+  // The resources while recording, the copy of the frame for the transients of the async passes
+  const nvvk::Image&  getImage(ImageHandle image) const;
+  const nvvk::Buffer& getBuffer(BufferHandle buffer) const;
+
+  Report getReport() const;
+
+private:
+  struct Access
+  {
+    uint32_t              resource{};
+    VkImageLayout         layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 stages{};
+    VkAccessFlags2        readAccess{};
+    VkAccessFlags2        writeAccess{};
+  };
+
+  struct Pass
+  {
+    std::string         name;
+    QueueType           queue{};
+    RecordCallback      callback;
+    std::vector<Access> accesses;
+    bool                sideEffect{};
+
+    bool      culled{};
+    QueueType scheduledQueue{};
+  };
+
+  // Synchronization of a resource within the commands of a queue
+  struct State
+  {
+    VkImageLayout         layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 writeStages{};  // of the last write or layout transition
+    VkAccessFlags2        writeAccess{};
+    VkPipelineStageFlags2 readStages{};  // of the reads since
+    VkPipelineStageFlags2 visibleStages{};  // the reads that see the last write
+    VkAccessFlags2        visibleAccess{};
+    bool                  touched{};  // accessed in the recorded frame
+  };
+
+  struct Resource
+  {
+    std::string             name;
+    bool                    isImage{};
+    bool                    imported{};
+    VkImageSubresourceRange range{};
+
+    VkImageCreateInfo      imageInfo{};
+    VkImageViewCreateInfo  viewInfo{};
+    VkDeviceSize           bufferSize{};
+    VkBufferUsageFlags2KHR bufferUsage{};
+
+    nvvk::Image* importedImage{};
+    nvvk::Buffer importedBuffer;
+
+    // compile: order of the first and last graphics passes, and the copies of a transient
+    uint32_t              firstPass = ~0U;
+    uint32_t              lastPass  = 0;
+    bool                  async{};  // accessed by an async pass
+    std::vector<uint32_t> slots;    // in m_transientImages or m_transientBuffers, one per frame cycle when async
+    VkImageLayout         asyncLayout = VK_IMAGE_LAYOUT_UNDEFINED;  // left by the compute queue
+
+    State state;
+  };
+
+  struct TransientBuffer
+  {
+    uint32_t             resource{};
+    std::string          name;
+    nvvk::Buffer         buffer;  // `buffer.allocation` when not in m_bufferMemory
+    VkMemoryRequirements memReqs{};
+    VkDeviceSize         offset{};
+    uint32_t             firstPass{};
+    uint32_t             lastPass{};
+  };
+
+  struct QueueStats
+  {
+    uint32_t barrierBatches{};
+    uint32_t imageBarriers{};
+    uint32_t memoryBarriers{};
+  };
+
+  void     cullPasses();
+  void     schedulePasses();
+  VkResult createBuffers();
+  void     recordPasses(VkCommandBuffer cmd, QueueType queue, uint32_t frameCycle);
+  void     appendBarriers(BarrierContainer& barriers, QueueType queue, const Access& access);
+  uint32_t getSlot(const Resource& resource) const;
+
+  ResourceAllocator*           m_allocator{};
+  std::vector<Pass>            m_passes;
+  std::vector<Resource>        m_resources;
+  CompileInfo                  m_info;
+  uint32_t                     m_queueFamilies[2]{};
+  TransientImageAllocator      m_transientImages;
+  std::vector<TransientBuffer> m_transientBuffers;
+  VmaAllocation                m_bufferMemory{};
+  uint32_t                     m_frameCycle{};
+  bool                         m_compiled{};
+  Report                       m_report;
+  QueueStats                   m_queueStats[2];
+};
+
+}  // namespace nvvk
@@ -40,6 +40,14 @@ nvvk::ResourceAllocator::ResourceAllocator(ResourceAllocator&& other) noexcept
   std::swap(m_physicalDevice, other.m_physicalDevice);
   std::swap(m_leakID, other.m_leakID);
   std::swap(m_maxMemoryAllocationSize, other.m_maxMemoryAllocationSize);
+  std::swap(m_reBarHeapIndex, other.m_reBarHeapIndex);
+  std::swap(m_evictionCallbacks, other.m_evictionCallbacks);
+  std::swap(m_evictionCounter, other.m_evictionCounter);
+  std::swap(m_evictionThreshold, other.m_evictionThreshold);
+  for(uint32_t i = 0; i < eMemoryCategoryCount; i++)
+  {
+    m_categoryUsage[i] = other.m_categoryUsage[i].exchange(m_categoryUsage[i]);
+  }
 }
 
 nvvk::ResourceAllocator& nvvk::ResourceAllocator::operator=(ResourceAllocator&& other) noexcept
@@ -53,6 +61,14 @@ nvvk::ResourceAllocator& nvvk::ResourceAllocator::operator=(ResourceAllocator&&
     std::swap(m_physicalDevice, other.m_physicalDevice);
     std::swap(m_leakID, other.m_leakID);
     std::swap(m_maxMemoryAllocationSize, other.m_maxMemoryAllocationSize);
+    std::swap(m_reBarHeapIndex, other.m_reBarHeapIndex);
+    std::swap(m_evictionCallbacks, other.m_evictionCallbacks);
+    std::swap(m_evictionCounter, other.m_evictionCounter);
+    std::swap(m_evictionThreshold, other.m_evictionThreshold);
+    for(uint32_t i = 0; i < eMemoryCategoryCount; i++)
+    {
+      m_categoryUsage[i] = other.m_categoryUsage[i].exchange(m_categoryUsage[i]);
+    }
   }
 
   return *this;
@@ -98,7 +114,130 @@ VkResult nvvk::ResourceAllocator::init(VmaAllocatorCreateInfo allocatorInfo)
       .vkGetDeviceProcAddr   = vkGetDeviceProcAddr,
   };
   allocatorInfo.pVulkanFunctions = &functions;
-  return vmaCreateAllocator(&allocatorInfo, &m_allocator);
+  NVVK_FAIL_RETURN(vmaCreateAllocator(&allocatorInfo, &m_allocator));
+
+  // Resizable BAR: the device-local heap is (almost) entirely host-visible
+  VkPhysicalDeviceMemoryProperties memProps{};
+  vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &memProps);
+  const VkMemoryPropertyFlags reBarFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+  for(uint32_t i = 0; i < memProps.memoryTypeCount; i++)
+  {
+    const VkMemoryType& memType = memProps.memoryTypes[i];
+    if((memType.propertyFlags & reBarFlags) == reBarFlags && memProps.memoryHeaps[memType.heapIndex].size > (256ULL << 20))
+    {
+      m_reBarHeapIndex = memType.heapIndex;
+      break;
+    }
+  }
+
+  return VK_SUCCESS;
+}
+
+VmaAllocationCreateFlags nvvk::ResourceAllocator::getDirectUploadFlags(VkDeviceSize size) const
+{
+  if(!hasReBAR())
+    return 0;
+
+  // Keep an eighth of the heap for the regular device-local allocations sharing it
+  VmaBudget budgets[VK_MAX_MEMORY_HEAPS]{};
+  vmaGetHeapBudgets(m_allocator, budgets);
+  const VmaBudget& budget = budgets[m_reBarHeapIndex];
+  if(budget.usage + size + budget.budget / 8 > budget.budget)
+    return 0;
+
+  // ALLOW_TRANSFER_INSTEAD lets VMA fall back to non-mappable memory, `mapping` is then null
+  return VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+         | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT;
+}
+
+void nvvk::ResourceAllocator::trackAllocations(MemoryCategory category, std::span<const VmaAllocation> allocations, bool add) const
+{
+  VkDeviceSize size = 0;
+  for(VmaAllocation allocation : allocations)
+  {
+    if(allocation)
+    {
+      VmaAllocationInfo allocationInfo{};
+      vmaGetAllocationInfo(m_allocator, allocation, &allocationInfo);
+      size += allocationInfo.size;
+    }
+  }
+
+  if(add)
+    m_categoryUsage[category] += size;
+  else
+    m_categoryUsage[category] -= size;
+}
+
+nvvk::ResourceAllocator::BudgetReport nvvk::ResourceAllocator::getBudgetReport() const
+{
+  BudgetReport report;
+
+  VmaBudget budgets[VK_MAX_MEMORY_HEAPS]{};
+  vmaGetHeapBudgets(m_allocator, budgets);
+
+  const VkPhysicalDeviceMemoryProperties* memProps{};
+  vmaGetMemoryProperties(m_allocator, &memProps);
+  for(uint32_t i = 0; i < memProps->memoryHeapCount; i++)
+  {
+    if(memProps->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+    {
+      report.usage += budgets[i].usage;
+      report.budget += budgets[i].budget;
+    }
+  }
+
+  for(uint32_t i = 0; i < eMemoryCategoryCount; i++)
+  {
+    report.categoryUsage[i] = m_categoryUsage[i];
+  }
+
+  return report;
+}
+
+uint32_t nvvk::ResourceAllocator::addEvictionCallback(EvictionCallback callback)
+{
+  std::lock_guard<std::mutex> lock(m_evictionMutex);
+  m_evictionCallbacks.push_back({++m_evictionCounter, std::move(callback)});
+  return m_evictionCounter;
+}
+
+void nvvk::ResourceAllocator::removeEvictionCallback(uint32_t id)
+{
+  std::lock_guard<std::mutex> lock(m_evictionMutex);
+  std::erase_if(m_evictionCallbacks, [id](const EvictionEntry& entry) { return entry.id == id; });
+}
+
+VkDeviceSize nvvk::ResourceAllocator::checkBudget()
+{
+  const BudgetReport report    = getBudgetReport();
+  const VkDeviceSize threshold = VkDeviceSize(double(report.budget) * m_evictionThreshold);
+  if(report.usage <= threshold)
+  {
+    return 0;
+  }
+
+  // callbacks may free resources right away, which calls back into this allocator, but must not (un)register
+  std::lock_guard<std::mutex> lock(m_evictionMutex);
+
+  const VkDeviceSize bytesToFree = report.usage - threshold;
+  VkDeviceSize       freed       = 0;
+  for(EvictionEntry& entry : m_evictionCallbacks)
+  {
+    freed += entry.callback(bytesToFree - freed);
+    if(freed >= bytesToFree)
+    {
+      break;
+    }
+  }
+
+  if(freed < bytesToFree)
+  {
+    LOGW("Memory budget: %.1f / %.1f MB used, evicted only %.1f of %.1f MB\n", double(report.usage) / (1024.0 * 1024.0),
+         double(report.budget) / (1024.0 * 1024.0), double(freed) / (1024.0 * 1024.0), double(bytesToFree) / (1024.0 * 1024.0));
+  }
+
+  return freed;
 }
 
 void nvvk::ResourceAllocator::deinit()
@@ -111,6 +250,7 @@ void nvvk::ResourceAllocator::deinit()
   m_device         = nullptr;
   m_physicalDevice = nullptr;
   m_leakID         = ~0;
+  m_reBarHeapIndex = ~0U;
 }
 
 void nvvk::ResourceAllocator::addLeakDetection(VmaAllocation allocation) const
@@ -180,6 +320,7 @@ VkResult nvvk::ResourceAllocator::createBuffer(nvvk::Buffer&                  re
 
   resultBuffer.bufferSize = bufferInfo.size;
   resultBuffer.mapping    = static_cast<uint8_t*>(allocInfoOut.pMappedData);
+  m_categoryUsage[eMemoryBuffers] += allocInfoOut.size;
 
   // Get the GPU address of the buffer
   const VkBufferDeviceAddressInfo info = {.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, .buffer = resultBuffer.buffer};
@@ -192,6 +333,7 @@ VkResult nvvk::ResourceAllocator::createBuffer(nvvk::Buffer&                  re
 
 void nvvk::ResourceAllocator::destroyBuffer(nvvk::Buffer& buffer) const
 {
+  trackAllocations(eMemoryBuffers, {&buffer.allocation, 1}, false);
   vmaDestroyBuffer(m_allocator, buffer.buffer, buffer.allocation);
   buffer = {};
 }
@@ -335,6 +477,7 @@ VkResult nvvk::ResourceAllocator::createLargeBuffer(LargeBuffer&
     };
     largeBuffer.address    = vkGetBufferDeviceAddress(m_device, &info);
     largeBuffer.bufferSize = createInfo.size;
+    trackAllocations(eMemoryBuffers, largeBuffer.allocations, true);
 
     return VK_SUCCESS;
   }
@@ -378,6 +521,7 @@ VkResult nvvk::ResourceAllocator::createLargeBuffer(LargeBuffer&           large
 
 void nvvk::ResourceAllocator::destroyLargeBuffer(LargeBuffer& buffer) const
 {
+  trackAllocations(eMemoryBuffers, buffer.allocations, false);
   vkDestroyBuffer(m_device, buffer.buffer, nullptr);
   vmaFreeMemoryPages(m_allocator, buffer.allocations.size(), buffer.allocations.data());
   buffer = {};
@@ -403,6 +547,7 @@ VkResult nvvk::ResourceAllocator::createImage(nvvk::Image& image, const VkImageC
   image.descriptor.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
   addLeakDetection(image.allocation);
+  trackAllocations(eMemoryImages, {&image.allocation, 1}, true);
 
   return result;
 }
@@ -447,6 +592,7 @@ VkResult nvvk::ResourceAllocator::createImage(Image&                         ima
 
 void nvvk::ResourceAllocator::destroyImage(Image& image) const
 {
+  trackAllocations(eMemoryImages, {&image.allocation, 1}, false);
   vkDestroyImageView(m_device, image.descriptor.imageView, nullptr);
   vmaDestroyImage(m_allocator, image.image, image.allocation);
   image = {};
@@ -500,6 +646,10 @@ VkResult nvvk::ResourceAllocator::createAcceleration(nvvk::AccelerationStructure
     resultAccel.address = vkGetAccelerationStructureDeviceAddressKHR(m_device, &info);
   }
 
+  // moves from the buffer to the acceleration structure category
+  trackAllocations(eMemoryBuffers, {&resultAccel.buffer.allocation, 1}, false);
+  trackAllocations(eMemoryAccelerationStructures, {&resultAccel.buffer.allocation, 1}, true);
+
   return result;
 }
 
@@ -513,6 +663,9 @@ VkResult nvvk::ResourceAllocator::createAcceleration(nvvk::AccelerationStructure
 
 void nvvk::ResourceAllocator::destroyAcceleration(nvvk::AccelerationStructure& accel) const
 {
+  // counted as buffer again for `destroyBuffer`
+  trackAllocations(eMemoryAccelerationStructures, {&accel.buffer.allocation, 1}, false);
+  trackAllocations(eMemoryBuffers, {&accel.buffer.allocation, 1}, true);
   destroyBuffer(accel.buffer);
   vkDestroyAccelerationStructureKHR(m_device, accel.accel, nullptr);
   accel = {};
@@ -570,6 +723,9 @@ VkResult nvvk::ResourceAllocator::createLargeAcceleration(LargeAccelerationStruc
     resultAccel.address = vkGetAccelerationStructureDeviceAddressKHR(m_device, &info);
   }
 
+  trackAllocations(eMemoryBuffers, resultAccel.buffer.allocations, false);
+  trackAllocations(eMemoryAccelerationStructures, resultAccel.buffer.allocations, true);
+
   return result;
 }
 
@@ -586,6 +742,8 @@ VkResult nvvk::ResourceAllocator::createLargeAcceleration(LargeAccelerationStruc
 
 void nvvk::ResourceAllocator::destroyLargeAcceleration(LargeAccelerationStructure& accel) const
 {
+  trackAllocations(eMemoryAccelerationStructures, accel.buffer.allocations, false);
+  trackAllocations(eMemoryBuffers, accel.buffer.allocations, true);
   vkDestroyAccelerationStructureKHR(m_device, accel.accel, nullptr);
   destroyLargeBuffer(accel.buffer);
 
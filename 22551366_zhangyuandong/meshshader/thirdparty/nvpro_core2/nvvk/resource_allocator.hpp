@@ -21,6 +21,7 @@
 #include <array>
 #include <cstring>
 #include <atomic>
+#include <functional>
 #include <mutex>
 #include <span>
 #include <vector>
@@ -74,6 +75,9 @@
 // m_allocator.destroyBuffer(buffer);
 // m_allocator.destroyImage(image);
 //
+// Memory budget: pass VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT when VK_EXT_memory_budget is enabled
+// (VMA estimates the budget otherwise), register eviction callbacks and call `checkBudget()` once per frame.
+//
 //  See also the staging classes for uploading data to the GPU.
 //
 //-----------------------------------------------------------------
@@ -91,6 +95,28 @@ class ResourceAllocator
 public:
   static constexpr VkDeviceSize DEFAULT_LARGE_CHUNK_SIZE = VkDeviceSize(2) * 1024ull * 1024ull * 1024ull;
 
+  // usage counters of the memory allocated through this allocator
+  enum MemoryCategory : uint32_t
+  {
+    eMemoryBuffers,
+    eMemoryImages,
+    eMemoryAccelerationStructures,
+    eMemoryCategoryCount,
+  };
+
+  struct BudgetReport
+  {
+    // over all DEVICE_LOCAL heaps, from VMA (includes other processes with VK_EXT_memory_budget)
+    VkDeviceSize usage{};
+    VkDeviceSize budget{};
+    // allocated through this allocator
+    std::array<VkDeviceSize, eMemoryCategoryCount> categoryUsage{};
+  };
+
+  // Called when the device usage exceeds the eviction threshold of the budget.
+  // Should release (or schedule the release of) about `bytesToFree` and return how much it freed.
+  using EvictionCallback = std::function<VkDeviceSize(VkDeviceSize bytesToFree)>;
+
   ResourceAllocator()                                    = default;
   ResourceAllocator(const ResourceAllocator&)            = delete;
   ResourceAllocator& operator=(const ResourceAllocator&) = delete;
@@ -110,6 +136,30 @@ public:
   VkPhysicalDevice getPhysicalDevice() const { return m_physicalDevice; }
   VkDeviceSize     getMaxMemoryAllocationSize() const { return m_maxMemoryAllocationSize; }
 
+  BudgetReport getBudgetReport() const;
+
+  // Callbacks are invoked in registration order, until enough was freed.
+  // Returns an id for `removeEvictionCallback`
+  uint32_t addEvictionCallback(EvictionCallback callback);
+  void     removeEvictionCallback(uint32_t id);
+
+  // fraction of the budget at which `checkBudget` starts evicting
+  void  setEvictionThreshold(float threshold) { m_evictionThreshold = threshold; }
+  float getEvictionThreshold() const { return m_evictionThreshold; }
+
+  // Checks the device-local budget and invokes the eviction callbacks when over the threshold,
+  // to get back below it. Returns the bytes reported as freed.
+  VkDeviceSize checkBudget();
+
+  // True when a DEVICE_LOCAL | HOST_VISIBLE heap is larger than the legacy 256 MB BAR window (resizable BAR / SAM)
+  bool hasReBAR() const { return m_reBarHeapIndex != ~0U; }
+
+  // Allocation flags for buffers the CPU rewrites often, e.g. per-frame data, used with VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE.
+  // With resizable BAR and enough budget left for `size`, the buffer lands in mapped device-local memory
+  // and `StagingUploader` writes into it directly, skipping the staging copy.
+  // Otherwise returns 0, the buffer is regular device memory and its uploads are staged.
+  VmaAllocationCreateFlags getDirectUploadFlags(VkDeviceSize size) const;
+
   //////////////////////////////////////////////////////////////////////////
 
   // Create a VkBuffer
@@ -249,17 +299,35 @@ private:
   // (see comments around m_leakID)
   void addLeakDetection(VmaAllocation allocation) const;
 
+  // Adds (or removes) the size of the allocations to the category's usage counter
+  void trackAllocations(MemoryCategory category, std::span<const VmaAllocation> allocations, bool add) const;
+
 private:
   VmaAllocator     m_allocator{};
   VkDevice         m_device{};
   VkPhysicalDevice m_physicalDevice{};
   VkDeviceSize     m_maxMemoryAllocationSize = 0;
+  uint32_t         m_reBarHeapIndex          = ~0U;
 
   // Each vma allocation is named using a global monotonic counter
   mutable std::atomic_uint32_t m_allocationCounter = 0;
   // Throws breakpoint/signal when a resource using "nvvkAllocID: <id>" name was
   // created. Only works if `m_allocationCounter` is used deterministically.
   uint32_t m_leakID = ~0U;
+
+  // Allocation sizes per category
+  mutable std::array<std::atomic<VkDeviceSize>, eMemoryCategoryCount> m_categoryUsage{};
+
+  struct EvictionEntry
+  {
+    uint32_t         id{};
+    EvictionCallback callback;
+  };
+
+  std::mutex                 m_evictionMutex;
+  std::vector<EvictionEntry> m_evictionCallbacks;
+  uint32_t                   m_evictionCounter   = 0;
+  float                      m_evictionThreshold = 0.9f;
 };
 
 
@@ -24,11 +24,13 @@
 
 #include <cassert>
 #include <mutex>
+#include <vector>
 
 nvvk::SamplerPool::SamplerPool(SamplerPool&& other) noexcept
     : m_device(other.m_device)
-    , m_samplerMap(std::move(other.m_samplerMap))
-    , m_samplerToState(std::move(other.m_samplerToState))
+    , m_snapshot(other.m_snapshot.exchange(nullptr))
+    , m_snapshots(std::move(other.m_snapshots))
+    , m_entries(std::move(other.m_entries))
 {
   // Reset the moved-from object to a valid state
   other.m_device = VK_NULL_HANDLE;
@@ -38,9 +40,11 @@ nvvk::SamplerPool& nvvk::SamplerPool::operator=(SamplerPool&& other) noexcept
 {
   if(this != &other)
   {
-    m_device         = std::move(other.m_device);
-    m_samplerMap     = std::move(other.m_samplerMap);
-    m_samplerToState = std::move(other.m_samplerToState);
+    m_device    = std::move(other.m_device);
+    m_snapshots = std::move(other.m_snapshots);
+    m_entries   = std::move(other.m_entries);
+    m_snapshot.store(other.m_snapshot.exchange(nullptr));
+    other.m_device = VK_NULL_HANDLE;
   }
   return *this;
 }
@@ -58,15 +62,46 @@ void nvvk::SamplerPool::init(VkDevice device)
 void nvvk::SamplerPool::deinit()
 {
   std::lock_guard<std::mutex> lock(m_mutex);
-  for(const auto& entry : m_samplerMap)
+  assert(m_readers == 0 && "Sampler pool still in use");
+  if(const Snapshot* snapshot = m_snapshot.load())
   {
-    vkDestroySampler(m_device, entry.second.sampler, nullptr);
+    for(const auto& entry : snapshot->samplerMap)
+    {
+      vkDestroySampler(m_device, entry.second->sampler, nullptr);
+    }
   }
-  m_samplerMap.clear();
-  m_samplerToState.clear();
+  m_snapshot = nullptr;
+  m_snapshots.clear();
+  m_entries.clear();
   m_device = VK_NULL_HANDLE;
 }
 
+const nvvk::SamplerPool::Snapshot* nvvk::SamplerPool::beginRead() const
+{
+  // Sequentially consistent: a writer that sees no reader after publishing knows that
+  // the readers coming later will load the new snapshot
+  m_readers.fetch_add(1);
+  return m_snapshot.load();
+}
+
+void nvvk::SamplerPool::endRead() const
+{
+  m_readers.fetch_sub(1);
+}
+
+void nvvk::SamplerPool::publish(std::unique_ptr<Snapshot> snapshot)
+{
+  m_snapshot.store(snapshot.get());
+  m_snapshots.push_back(std::move(snapshot));
+
+  // Without readers, nobody can still reference the previous snapshots or the destroyed entries
+  if(m_readers.load() == 0)
+  {
+    m_snapshots.erase(m_snapshots.begin(), m_snapshots.end() - 1);
+    std::erase_if(m_entries, [](const std::unique_ptr<SamplerEntry>& entry) { return entry->sampler == VK_NULL_HANDLE; });
+  }
+}
+
 VkResult nvvk::SamplerPool::acquireSampler(VkSampler& sampler, const VkSamplerCreateInfo& createInfo)
 {
   SamplerState samplerState;
@@ -96,48 +131,110 @@ VkResult nvvk::SamplerPool::acquireSampler(VkSampler& sampler, const VkSamplerCr
 
   assert(m_device && "Initialization was missing");
 
+  // Fast path: the sampler exists, take a reference unless it is being destroyed
+  if(const Snapshot* snapshot = beginRead())
+  {
+    if(auto it = snapshot->samplerMap.find(samplerState); it != snapshot->samplerMap.end())
+    {
+      SamplerEntry* entry    = it->second;
+      uint32_t      refCount = entry->refCount.load();
+      while(refCount != 0 && !entry->refCount.compare_exchange_weak(refCount, refCount + 1))
+      {
+      }
+      if(refCount != 0)
+      {
+        sampler = entry->sampler;
+        endRead();
+        return VK_SUCCESS;
+      }
+    }
+  }
+  endRead();
+
   std::lock_guard<std::mutex> lock(m_mutex);
-  if(auto it = m_samplerMap.find(samplerState); it != m_samplerMap.end())
+  return createSampler(sampler, samplerState, createInfo);
+}
+
+VkResult nvvk::SamplerPool::createSampler(VkSampler& sampler, const SamplerState& samplerState, const VkSamplerCreateInfo& createInfo)
+{
+  const Snapshot* current = m_snapshot.load();
+  if(current)
   {
-    // If found, increment reference count and return existing sampler
-    it->second.refCount++;
-    sampler = it->second.sampler;
-    return VK_SUCCESS;
+    if(auto it = current->samplerMap.find(samplerState); it != current->samplerMap.end())
+    {
+      // Created by another thread, or released to 0 and not destroyed yet: revive it
+      it->second->refCount++;
+      sampler = it->second->sampler;
+      return VK_SUCCESS;
+    }
   }
 
   // Otherwise, create a new sampler
   NVVK_FAIL_RETURN(vkCreateSampler(m_device, &createInfo, nullptr, &sampler));
-  m_samplerMap[samplerState] = {sampler, 1};
-  m_samplerToState[sampler]  = samplerState;
+
+  auto entry      = std::make_unique<SamplerEntry>();
+  entry->state    = samplerState;
+  entry->sampler  = sampler;
+  entry->refCount = 1;
+
+  auto snapshot = current ? std::make_unique<Snapshot>(*current) : std::make_unique<Snapshot>();
+  snapshot->samplerMap[samplerState] = entry.get();
+  snapshot->samplerToEntry[sampler]  = entry.get();
+  m_entries.push_back(std::move(entry));
+  publish(std::move(snapshot));
   return VK_SUCCESS;
 }
 
 void nvvk::SamplerPool::releaseSampler(VkSampler sampler)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
   if(sampler == VK_NULL_HANDLE)
     return;
 
-  auto stateIt = m_samplerToState.find(sampler);
-  if(stateIt == m_samplerToState.end())
+  bool found = false;
+  bool last  = false;
+  if(const Snapshot* snapshot = beginRead())
+  {
+    if(auto it = snapshot->samplerToEntry.find(sampler); it != snapshot->samplerToEntry.end())
+    {
+      uint32_t previous = it->second->refCount.fetch_sub(1);
+      assert(previous != 0 && "Releasing a sampler more times than it was acquired");
+      found = true;
+      last  = previous == 1;
+    }
+  }
+  endRead();
+
+  if(!found)
   {
     // Sampler not found - this shouldn't happen in correct usage
     assert(false && "Attempting to release unknown sampler");
     return;
   }
 
-  auto samplerIt = m_samplerMap.find(stateIt->second);
-  assert(samplerIt != m_samplerMap.end() && "Inconsistent sampler pool state");
-
-  samplerIt->second.refCount--;
-  if(samplerIt->second.refCount == 0)
+  if(last)
   {
-    vkDestroySampler(m_device, sampler, nullptr);
-    m_samplerMap.erase(samplerIt);
-    m_samplerToState.erase(stateIt);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    destroyUnused(sampler);
   }
 }
 
+void nvvk::SamplerPool::destroyUnused(VkSampler sampler)
+{
+  const Snapshot* current = m_snapshot.load();
+  auto            it      = current->samplerToEntry.find(sampler);
+  // Already destroyed by another release, or acquired again since the reference count reached 0
+  if(it == current->samplerToEntry.end() || it->second->refCount != 0)
+    return;
+
+  SamplerEntry* entry = it->second;
+  vkDestroySampler(m_device, sampler, nullptr);
+
+  auto snapshot = std::make_unique<Snapshot>(*current);
+  snapshot->samplerMap.erase(entry->state);
+  snapshot->samplerToEntry.erase(sampler);
+  entry->sampler = VK_NULL_HANDLE;  // freed once no reader can see it
+  publish(std::move(snapshot));
+}
 
 //--------------------------------------------------------------------------------------------------
 // Usage example
@@ -18,9 +18,12 @@
  */
 
 #pragma once
+#include <atomic>
 #include <cstring>
-#include <unordered_map>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <vulkan/vulkan_core.h>
 
@@ -32,6 +35,11 @@ namespace nvvk {
 // Samplers are limited in Vulkan.
 // This class is used to create and store samplers, and to avoid creating the same sampler multiple times.
 //
+// Acquiring or releasing an existing sampler is lock-free: the maps are an immutable snapshot that
+// is replaced (copy, modify, publish) under the mutex when a sampler is created or destroyed.
+// Replaced snapshots are freed once no reader is active, so the copies stay cheap as long as the
+// number of unique samplers is small, which the Vulkan limits enforce anyway.
+//
 // Usage:
 //      see usage_SamplerPool in sampler_pool.cpp
 //-----------------------------------------------------------------
@@ -111,17 +119,36 @@ private:
 
   struct SamplerEntry
   {
-    VkSampler sampler;
-    uint32_t  refCount;
+    SamplerState          state;
+    VkSampler             sampler{};
+    std::atomic<uint32_t> refCount{};  // 0: being destroyed, only revived under the mutex
+  };
+
+  // Immutable once published, readers only access it between beginRead/endRead
+  struct Snapshot
+  {
+    // Stores unique samplers with their corresponding VkSamplerCreateInfo
+    std::unordered_map<SamplerState, SamplerEntry*, SamplerStateHashFn> samplerMap;
+    // Reverse lookup map for O(1) sampler release - must stay in sync with samplerMap
+    std::unordered_map<VkSampler, SamplerEntry*> samplerToEntry;
   };
 
-  // Stores unique samplers with their corresponding VkSamplerCreateInfo and reference counts
-  std::unordered_map<SamplerState, SamplerEntry, SamplerStateHashFn> m_samplerMap{};
+  const Snapshot* beginRead() const;
+  void            endRead() const;
+
+  // Slow paths, under the mutex
+  VkResult createSampler(VkSampler& sampler, const SamplerState& samplerState, const VkSamplerCreateInfo& createInfo);
+  void     destroyUnused(VkSampler sampler);
+  void     publish(std::unique_ptr<Snapshot> snapshot);
+
+  std::atomic<const Snapshot*>  m_snapshot{};  // current snapshot, owned by m_snapshots.back()
+  mutable std::atomic<uint32_t> m_readers{};   // threads between beginRead and endRead
 
-  // Reverse lookup map for O(1) sampler release - must stay in sync with m_samplerMap
-  std::unordered_map<VkSampler, SamplerState> m_samplerToState{};
+  // Owned snapshots and entries, the ones no longer reachable are freed when there are no readers
+  std::vector<std::unique_ptr<Snapshot>>     m_snapshots;
+  std::vector<std::unique_ptr<SamplerEntry>> m_entries;
 
-  // Mutex for thread-safe access to both maps
+  // Mutex for the creation and destruction of samplers
   mutable std::mutex m_mutex;
 };
 
@@ -18,6 +18,8 @@
 */
 
 #include <algorithm>
+#include <cstring>
+#include <map>
 
 #include <nvutils/alignment.hpp>
 
@@ -60,11 +62,63 @@ void SBTGenerator::reset()
   m_dataSize           = 0;
   m_totalGroupCount    = 0;
   m_pipeline           = 0;
+  m_hitRecords         = {};
+  m_hitRecordUsers     = {};
+  m_hitRecordCount     = 0;
+  resetBuffer();
 }
 
 void SBTGenerator::resetBuffer()
 {
-  m_bufferAddresses = {};
+  m_bufferAddresses   = {};
+  m_bufferBaseAddress = 0;
+  m_shaderHandles     = {};
+  m_dirty             = {};
+  m_layoutChanged     = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Sets the data of a record. Before populating the buffer it only stores it; after, a change either
+// marks the record for updateSBTBuffer(), or requires a rebuild if it no longer fits the layout.
+//
+void SBTGenerator::addData(GroupType t, uint32_t groupIndex, const uint8_t* data, size_t dataSize)
+{
+  std::vector<uint8_t>& record = m_data[t][groupIndex];
+  if(isPopulated() && record.size() == dataSize && std::equal(record.begin(), record.end(), data))
+  {
+    return;  // unchanged, nothing to upload
+  }
+  record.assign(data, data + dataSize);
+
+  if(!isPopulated())
+  {
+    return;
+  }
+
+  const bool outgrowsStride = m_handleSize + dataSize > m_stride[t];
+  const bool newIndex       = groupIndex >= getGroupIndexCount(t);
+  // Other hit indices share the record, it must be split
+  const bool sharedRecord = t == eHit && !newIndex && !m_hitRecords.empty() && m_hitRecordUsers[m_hitRecords[groupIndex]] > 1;
+  if(outgrowsStride || newIndex || sharedRecord)
+  {
+    m_layoutChanged = true;
+  }
+  else
+  {
+    m_dirty[t].push_back(groupIndex);
+  }
+}
+
+uint32_t SBTGenerator::getDirtyRecordCount() const
+{
+  uint32_t count = 0;
+  for(const std::vector<uint32_t>& dirty : m_dirty)
+  {
+    std::vector<uint32_t> unique = dirty;
+    std::sort(unique.begin(), unique.end());
+    count += static_cast<uint32_t>(std::unique(unique.begin(), unique.end()) - unique.begin());
+  }
+  return count;
 }
 
 uint32_t SBTGenerator::getBufferAlignment() const
@@ -177,6 +231,30 @@ size_t SBTGenerator::calculateSBTBufferSize(VkPipeline
       stride = std::max(stride, dataHandleSize);  // Use the largest stride needed
     }
   };
+  // Hit indices with the same group handle and the same data share their record
+  m_hitRecords.clear();
+  m_hitRecordUsers.clear();
+  m_hitRecordCount = 0;
+  if(m_shareHitRecords)
+  {
+    std::map<std::pair<uint32_t, std::vector<uint8_t>>, uint32_t> records;
+    const std::vector<uint32_t>&                                  hitIndices = m_shaderGroupIndices[eHit];
+    for(uint32_t index = 0; index < static_cast<uint32_t>(hitIndices.size()); index++)
+    {
+      auto                 recordIt = m_data[eHit].find(index);
+      std::vector<uint8_t> data     = recordIt != m_data[eHit].end() ? recordIt->second : std::vector<uint8_t>{};
+
+      auto [it, inserted] = records.try_emplace({hitIndices[index], std::move(data)}, m_hitRecordCount);
+      if(inserted)
+      {
+        m_hitRecordCount++;
+        m_hitRecordUsers.push_back(0);
+      }
+      m_hitRecords.push_back(it->second);
+      m_hitRecordUsers[it->second]++;
+    }
+  }
+
   // Calculate stride for each group type
   findStride(m_data[eRaygen], m_stride[eRaygen]);
   findStride(m_data[eMiss], m_stride[eMiss]);
@@ -192,13 +270,13 @@ size_t SBTGenerator::calculateSBTBufferSize(VkPipeline
   // Compute buffer offsets for each group type and accumulate total buffer size
   // Each group section is aligned to bufferAlignment
   m_bufferAddresses[eRaygen] = totalSize;
-  totalSize += nvutils::align_up(m_stride[eRaygen] * getGroupIndexCount(eRaygen), bufferAlignment);
+  totalSize += nvutils::align_up(m_stride[eRaygen] * getRecordCount(eRaygen), bufferAlignment);
   m_bufferAddresses[eMiss] = totalSize;
-  totalSize += nvutils::align_up(m_stride[eMiss] * getGroupIndexCount(eMiss), bufferAlignment);
+  totalSize += nvutils::align_up(m_stride[eMiss] * getRecordCount(eMiss), bufferAlignment);
   m_bufferAddresses[eHit] = totalSize;
-  totalSize += nvutils::align_up(m_stride[eHit] * getGroupIndexCount(eHit), bufferAlignment);
+  totalSize += nvutils::align_up(m_stride[eHit] * getRecordCount(eHit), bufferAlignment);
   m_bufferAddresses[eCallable] = totalSize;
-  totalSize += nvutils::align_up(m_stride[eCallable] * getGroupIndexCount(eCallable), bufferAlignment);
+  totalSize += nvutils::align_up(m_stride[eCallable] * getRecordCount(eCallable), bufferAlignment);
 
   // Store the final computed buffer size
   m_dataSize = totalSize;
@@ -215,44 +293,30 @@ size_t SBTGenerator::calculateSBTBufferSize(VkPipeline
 VkResult SBTGenerator::populateSBTBuffer(VkDeviceAddress bufferAddress, size_t bufferSize, void* bufferData)
 {
   assert(m_pipeline && "Missing updatePipeline()");
-  assert(bufferSize == m_dataSize);
-  assert(m_bufferAddresses[eRaygen] == 0 && "must not call updateBuffer multiple times");
+  assert(bufferSize >= m_dataSize);
+  assert(!isPopulated() && "must not call updateBuffer multiple times, resetBuffer() to rebuild");
   assert(bufferAddress % getBufferAlignment() == 0);
 
   uint8_t* dataBytes = static_cast<uint8_t*>(bufferData);
 
-  // Fetch all the shader handles used in the pipeline, so that they can be written in the SBT
-  uint32_t             sbtSize = m_totalGroupCount * m_handleSize;
-  std::vector<uint8_t> shaderHandleStorage(sbtSize);
+  // Fetch all the shader handles used in the pipeline, so that they can be written in the SBT,
+  // they are kept for the incremental updates
+  uint32_t sbtSize = m_totalGroupCount * m_handleSize;
+  m_shaderHandles.resize(sbtSize);
 
   // Get the shader handles for all groups in the pipeline
   NVVK_FAIL_RETURN(vkGetRayTracingShaderGroupHandlesKHR(m_device, m_pipeline, 0, m_totalGroupCount, sbtSize,
-                                                        shaderHandleStorage.data()));
+                                                        m_shaderHandles.data()));
 
   // Write the handles in the SBT buffer + data info (if any)
-  auto copyHandles = [&](VkDeviceAddress offset, std::vector<uint32_t>& indices, uint32_t stride, shaderRecordMap& data) {
-    uint8_t* pBuffer = dataBytes + offset;
-    for(uint32_t index = 0; index < static_cast<uint32_t>(indices.size()); index++)
+  // Shared hit records are written by each of their indices, with the same content
+  for(GroupType t : {eRaygen, eMiss, eHit, eCallable})
+  {
+    for(uint32_t index = 0; index < getGroupIndexCount(t); index++)
     {
-      uint8_t* pStart = pBuffer;
-      // Copy the handle for this group
-      memcpy(pBuffer, shaderHandleStorage.data() + (indices[index] * m_handleSize), m_handleSize);
-      // If there is data for this group index, copy it too
-      auto recordIt = data.find(index);
-      if(recordIt != data.end())
-      {
-        pBuffer += m_handleSize;  // Move pointer past handle
-        memcpy(pBuffer, recordIt->second.data(), recordIt->second.size() * sizeof(uint8_t));
-      }
-      pBuffer = pStart + stride;  // Jumping to next group
+      writeRecord(dataBytes + m_bufferAddresses[t] + getRecordIndex(t, index) * m_stride[t], t, index);
     }
-  };
-
-  // Copy the handles/data to each staging buffer for each group type
-  copyHandles(m_bufferAddresses[eRaygen], m_shaderGroupIndices[eRaygen], m_stride[eRaygen], m_data[eRaygen]);
-  copyHandles(m_bufferAddresses[eMiss], m_shaderGroupIndices[eMiss], m_stride[eMiss], m_data[eMiss]);
-  copyHandles(m_bufferAddresses[eHit], m_shaderGroupIndices[eHit], m_stride[eHit], m_data[eHit]);
-  copyHandles(m_bufferAddresses[eCallable], m_shaderGroupIndices[eCallable], m_stride[eCallable], m_data[eCallable]);
+  }
 
   // update the addresses from offsets to full address
   m_bufferAddresses[eRaygen] += bufferAddress;
@@ -260,9 +324,84 @@ VkResult SBTGenerator::populateSBTBuffer(VkDeviceAddress bufferAddress, size_t b
   m_bufferAddresses[eHit] += bufferAddress;
   m_bufferAddresses[eCallable] += bufferAddress;
 
+  m_bufferBaseAddress = bufferAddress;
+  m_dirty             = {};
+  m_layoutChanged     = false;
+
+  return VK_SUCCESS;
+}
+
+VkResult SBTGenerator::populateSBTBuffer(StagingUploader& uploader, const nvvk::Buffer& sbtBuffer, const SemaphoreState& semaphoreState)
+{
+  assert(sbtBuffer.bufferSize >= m_dataSize);
+
+  void* mapping = nullptr;
+  NVVK_FAIL_RETURN(uploader.appendBufferMapping(sbtBuffer, 0, m_dataSize, mapping, semaphoreState));
+  return populateSBTBuffer(sbtBuffer.address, m_dataSize, mapping);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Uploads the records marked by addData(), at the offsets they got when populating the buffer.
+// Runs of consecutive records are written with a single copy.
+//
+VkResult SBTGenerator::updateSBTBuffer(StagingUploader& uploader, const nvvk::Buffer& sbtBuffer, const SemaphoreState& semaphoreState)
+{
+  assert(isPopulated() && "Missing populateSBTBuffer()");
+  assert(!needsRebuild() && "layout changed, resetBuffer() and rebuild");
+  assert(sbtBuffer.address == m_bufferBaseAddress && "must be the populated buffer");
+
+  for(GroupType t : {eRaygen, eMiss, eHit, eCallable})
+  {
+    // (record, group index), in the order of the records
+    std::vector<std::pair<uint32_t, uint32_t>> records;
+    for(uint32_t index : m_dirty[t])
+    {
+      records.push_back({getRecordIndex(t, index), index});
+    }
+    std::sort(records.begin(), records.end());
+    records.erase(std::unique(records.begin(), records.end()), records.end());
+
+    const VkDeviceSize groupOffset = m_bufferAddresses[t] - m_bufferBaseAddress;
+    for(size_t first = 0; first < records.size();)
+    {
+      size_t last = first;
+      while(last + 1 < records.size() && records[last + 1].first == records[last].first + 1)
+      {
+        last++;
+      }
+
+      const uint32_t count   = static_cast<uint32_t>(last - first + 1);
+      uint8_t*       mapping = nullptr;
+      NVVK_FAIL_RETURN(uploader.appendBufferMapping(sbtBuffer, groupOffset + records[first].first * m_stride[t],
+                                                    count * m_stride[t], mapping, semaphoreState));
+      for(uint32_t i = 0; i < count; i++)
+      {
+        writeRecord(mapping + i * m_stride[t], t, records[first + i].second);
+      }
+      first = last + 1;
+    }
+    m_dirty[t].clear();
+  }
+
   return VK_SUCCESS;
 }
 
+void SBTGenerator::writeRecord(uint8_t* dst, GroupType t, uint32_t index) const
+{
+  // Copy the handle for this group
+  memcpy(dst, m_shaderHandles.data() + (m_shaderGroupIndices[t][index] * m_handleSize), m_handleSize);
+  size_t written = m_handleSize;
+  // If there is data for this group index, copy it too
+  auto recordIt = m_data[t].find(index);
+  if(recordIt != m_data[t].end())
+  {
+    memcpy(dst + m_handleSize, recordIt->second.data(), recordIt->second.size() * sizeof(uint8_t));
+    written += recordIt->second.size();
+  }
+  // A patched record may have less data than before
+  memset(dst + written, 0, m_stride[t] - written);
+}
+
 VkDeviceAddress SBTGenerator::getGroupAddress(GroupType t) const
 {
   assert(m_bufferAddresses[t]);
@@ -366,6 +505,48 @@ const SBTGenerator::Regions SBTGenerator::getSBTRegions(uint32_t rayGenIndexOffs
   sbtGenerator.addIndex(SBTGenerator::eHit, 4);  // Adding a 3rd hit, duplicate from the hit:1, which make hit:2 available.
   sbtGenerator.addData(SBTGenerator::eHit, 2, m_hitShaderRecord[1]);  // Adding data to this hit shader
   sbtGenerator.calculateSBTBufferSize(rtPipeline);
+
+  //------------------------------------------------------------------------------------------------------------------
+  // Extra: Incremental updates
+  // A device-local SBT is populated once through the uploader, then only the changed records are patched.
+  // Identical hit records (same hit group, same material) are stored once.
+  {
+    nvvk::StagingUploader uploader;  // EX: initialized uploader
+    nvvk::Buffer          deviceSbt;
+
+    sbtGenerator.reset();
+    sbtGenerator.setHitRecordSharing(true);
+    sbtGenerator.addData(SBTGenerator::eHit, 0, m_hitShaderRecord[0]);
+    sbtGenerator.addData(SBTGenerator::eHit, 1, m_hitShaderRecord[0]);  // shares the record of hit 0
+    sbtGenerator.addData(SBTGenerator::eHit, 2, m_hitShaderRecord[1]);
+    size_t deviceSbtSize = sbtGenerator.calculateSBTBufferSize(rtPipeline, rayPipelineInfo);
+    NVVK_CHECK(allocator.createBuffer(deviceSbt, deviceSbtSize,
+                                      VK_BUFFER_USAGE_2_SHADER_BINDING_TABLE_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
+                                      VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE, {}, sbtGenerator.getBufferAlignment()));
+    NVVK_CHECK(sbtGenerator.populateSBTBuffer(uploader, deviceSbt));
+    uploader.cmdUploadAppended(cmd);
+
+    // The instances use the records, not the hit indices
+    [[maybe_unused]] uint32_t instanceSbtOffset = sbtGenerator.getHitRecordIndex(2);
+
+    // Later, a material changed
+    m_hitShaderRecord[1].color = {0.0f, 0.0f, 1.0f, 0.0f};
+    sbtGenerator.addData(SBTGenerator::eHit, 2, m_hitShaderRecord[1]);
+    if(sbtGenerator.needsRebuild())
+    {
+      sbtGenerator.resetBuffer();
+      sbtGenerator.calculateSBTBufferSize(rtPipeline, rayPipelineInfo);  // recreate deviceSbt if larger
+      NVVK_CHECK(sbtGenerator.populateSBTBuffer(uploader, deviceSbt));
+    }
+    else
+    {
+      NVVK_CHECK(sbtGenerator.updateSBTBuffer(uploader, deviceSbt));  // a single record
+    }
+    uploader.cmdUploadAppended(cmd);
+    // barrier, transfer to VK_ACCESS_2_SHADER_BINDING_TABLE_READ_BIT_KHR, then trace
+
+    allocator.destroyBuffer(deviceSbt);
+  }
 }
 
 
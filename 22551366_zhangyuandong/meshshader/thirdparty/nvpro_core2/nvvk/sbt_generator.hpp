@@ -23,9 +23,12 @@
 #include <unordered_map>
 
 #include "resource_allocator.hpp"
+#include "semaphore.hpp"
 
 namespace nvvk {
 
+class StagingUploader;
+
 /*------------------------------------------------------------------------------------
 #class nvvk::SBTGenerator
 
@@ -44,6 +47,24 @@ Convenient functions exist to retrieve all information to be used in TraceRayKHR
 - Create the buffer then call `populateSBTBuffer()` to fill the buffer with the handles and data
 - Use `getSBTRegions()` to get all the vk::StridedDeviceAddressRegionKHR needed by TraceRayKHR()
 
+## Incremental updates
+Once populated, the layout (strides and record offsets) stays as it is. Calling `addData()` again
+only marks the records whose data changed, and `updateSBTBuffer()` patches those records in place
+through the `nvvk::StagingUploader`, instead of rebuilding and uploading the whole table:
+- Populate a device-local buffer with the `StagingUploader` overload of `populateSBTBuffer()`
+- When materials change, call `addData()` for the changed records, then `updateSBTBuffer()`
+- A record outgrowing its stride, a new index or a change of a shared hit record makes `needsRebuild()` true:
+  call `resetBuffer()`, `calculateSBTBufferSize()` and `populateSBTBuffer()` again (the buffer can be kept if large enough)
+
+The copies are recorded by `StagingUploader::cmdUploadAppended()`; like any buffer write, they need a barrier
+after previous traces reading the table (and a mapped buffer is written directly, while frames in flight may use it),
+and one to `VK_ACCESS_2_SHADER_BINDING_TABLE_READ_BIT_KHR` before the next trace.
+
+With `setHitRecordSharing(true)`, hit records having the same shader group and the same data are stored once.
+The hit region then has fewer records than hit indices: the record of a hit index, given by `getHitRecordIndex()`,
+is what the instances must use as `instanceShaderBindingTableRecordOffset`. This suits instances addressing a single
+hit record (one geometry, or `sbtRecordStride` 0 in the shaders), e.g. one record per material.
+
 
 See under usage_SBTGenerator()
 ------------------------------------------------------------------------------------*/
@@ -86,6 +107,28 @@ public:
   // The buffer should be created with VK_BUFFER_USAGE_2_SHADER_BINDING_TABLE_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT
   VkResult populateSBTBuffer(VkDeviceAddress bufferAddress, size_t bufferSize, void* bufferData);
 
+  // Same as above, writing through the uploader, so that `sbtBuffer` can be device local.
+  // `sbtBuffer` also needs VK_BUFFER_USAGE_2_TRANSFER_DST_BIT and must stay the same for updateSBTBuffer()
+  VkResult populateSBTBuffer(StagingUploader& uploader, const nvvk::Buffer& sbtBuffer, const SemaphoreState& semaphoreState = {});
+
+  // Patches the records changed by addData() since the buffer was populated or last updated,
+  // consecutive records are merged into one copy. Must not be called when needsRebuild()
+  VkResult updateSBTBuffer(StagingUploader& uploader, const nvvk::Buffer& sbtBuffer, const SemaphoreState& semaphoreState = {});
+
+  // True when the changes since populateSBTBuffer() do not fit in its layout
+  bool needsRebuild() const { return m_layoutChanged; }
+  // Number of records updateSBTBuffer() would write
+  uint32_t getDirtyRecordCount() const;
+
+  // Stores identical hit records once, must be set before calculateSBTBufferSize()
+  void setHitRecordSharing(bool enable) { m_shareHitRecords = enable; }
+  // Record of a hit index in the hit region, to be used by the instances; the index itself without sharing
+  uint32_t getHitRecordIndex(uint32_t hitIndex) const
+  {
+    return hitIndex < m_hitRecords.size() ? m_hitRecords[hitIndex] : hitIndex;
+  }
+  uint32_t getHitRecordCount() const { return getRecordCount(eHit); }
+
 
   // After updateBuffer one can retrieve the regions
   // Return the address region of a group. indexOffset allow to offset the starting shader of the group.
@@ -103,20 +146,22 @@ public:
 
   // Pushing back a GroupType and the handle pipeline index to use
   // i.e addIndex(eHit, 3) is pushing a Hit shader group using the 3rd entry in the pipeline
-  void addIndex(GroupType t, uint32_t index) { m_shaderGroupIndices[t].push_back(index); }
+  void addIndex(GroupType t, uint32_t index)
+  {
+    m_shaderGroupIndices[t].push_back(index);
+    m_layoutChanged = m_layoutChanged || isPopulated();
+  }
 
   // Adding 'Shader Record' data to the group index.
   // i.e. addData(eHit, 0, myValue) is adding 'myValue' to the HIT group 0.
+  // Once the buffer is populated, a change of data marks the record for updateSBTBuffer()
   template <typename T>
-  void addData(GroupType t, uint32_t groupIndex, T& data)
+  void addData(GroupType t, uint32_t groupIndex, const T& data)
   {
-    addData(t, groupIndex, (uint8_t*)&data, sizeof(T));
+    addData(t, groupIndex, (const uint8_t*)&data, sizeof(T));
   }
 
-  void addData(GroupType t, uint32_t groupIndex, uint8_t* data, size_t dataSize)
-  {
-    m_data[t][groupIndex].assign(data, data + dataSize);
-  }
+  void addData(GroupType t, uint32_t groupIndex, const uint8_t* data, size_t dataSize);
 
   // Get buffer alignment
   uint32_t getBufferAlignment() const;
@@ -132,13 +177,24 @@ private:
   uint32_t getGroupIndexCount(GroupType t) const { return static_cast<uint32_t>(m_shaderGroupIndices[t].size()); }
   uint32_t getGroupStride(GroupType t) const { return m_stride[t]; }
   VkDeviceAddress getGroupAddress(GroupType t) const;
+  bool            isPopulated() const { return m_bufferBaseAddress != 0; }
+
+  // Records stored for a group, fewer than indices for shared hit records
+  uint32_t getRecordCount(GroupType t) const
+  {
+    return t == eHit && !m_hitRecords.empty() ? m_hitRecordCount : getGroupIndexCount(t);
+  }
+  uint32_t getRecordIndex(GroupType t, uint32_t index) const { return t == eHit ? getHitRecordIndex(index) : index; }
 
   // returns the entire size of a group. Raygen Stride and Size must be equal, even if the buffer contains many of them.
   uint32_t getSize(GroupType t) const
   {
-    return t == eRaygen ? getGroupStride(eRaygen) : getGroupStride(t) * getGroupIndexCount(t);
+    return t == eRaygen ? getGroupStride(eRaygen) : getGroupStride(t) * getRecordCount(t);
   }
 
+  // Writes the handle and data of the group index, the rest of the stride is cleared
+  void writeRecord(uint8_t* dst, GroupType t, uint32_t index) const;
+
   using shaderRecordMap = std::unordered_map<uint32_t, std::vector<uint8_t>>;
 
   std::array<std::vector<uint32_t>, 4> m_shaderGroupIndices;  // For each group type, stores the pipeline indices of shader groups
@@ -154,6 +210,16 @@ private:
   size_t     m_dataSize{0};
   VkPipeline m_pipeline{VK_NULL_HANDLE};
 
+  // Incremental updates
+  std::vector<uint8_t>                 m_shaderHandles;         // handles of the pipeline, kept for the updates
+  VkDeviceAddress                      m_bufferBaseAddress{0};  // address of the populated buffer
+  std::array<std::vector<uint32_t>, 4> m_dirty;                 // group indices whose data changed, to patch
+  bool                                 m_layoutChanged{false};
+  bool                                 m_shareHitRecords{false};
+  std::vector<uint32_t>                m_hitRecords;      // record of each hit index when sharing
+  std::vector<uint32_t>                m_hitRecordUsers;  // hit indices using each record
+  uint32_t                             m_hitRecordCount{0};
+
   VkDevice m_device{VK_NULL_HANDLE};
 };
 }  // namespace nvvk
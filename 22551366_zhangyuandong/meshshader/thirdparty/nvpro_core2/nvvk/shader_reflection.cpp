@@ -0,0 +1,612 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+* SPDX-License-Identifier: Apache-2.0
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include <nvutils/logger.hpp>
+
+#include "shader_reflection.hpp"
+
+namespace nvvk {
+
+namespace {
+
+// The subset of the SPIR-V grammar needed for the resource interface
+namespace spv {
+constexpr uint32_t MAGIC_NUMBER = 0x07230203;
+
+enum Op : uint32_t
+{
+  OpName                         = 5,
+  OpEntryPoint                   = 15,
+  OpTypeBool                     = 20,
+  OpTypeInt                      = 21,
+  OpTypeFloat                    = 22,
+  OpTypeVector                   = 23,
+  OpTypeMatrix                   = 24,
+  OpTypeImage                    = 25,
+  OpTypeSampler                  = 26,
+  OpTypeSampledImage             = 27,
+  OpTypeArray                    = 28,
+  OpTypeRuntimeArray             = 29,
+  OpTypeStruct                   = 30,
+  OpTypePointer                  = 32,
+  OpConstant                     = 43,
+  OpSpecConstant                 = 50,
+  OpVariable                     = 59,
+  OpDecorate                     = 71,
+  OpMemberDecorate               = 72,
+  OpTypeAccelerationStructureKHR = 5341,
+};
+
+enum Decoration : uint32_t
+{
+  DecorationBlock         = 2,
+  DecorationBufferBlock   = 3,
+  DecorationRowMajor      = 4,
+  DecorationArrayStride   = 6,
+  DecorationMatrixStride  = 7,
+  DecorationBinding       = 33,
+  DecorationDescriptorSet = 34,
+  DecorationOffset        = 35,
+};
+
+enum StorageClass : uint32_t
+{
+  StorageClassUniformConstant       = 0,
+  StorageClassUniform               = 2,
+  StorageClassPushConstant          = 9,
+  StorageClassStorageBuffer         = 12,
+  StorageClassPhysicalStorageBuffer = 5349,
+};
+
+enum Dim : uint32_t
+{
+  DimBuffer      = 5,
+  DimSubpassData = 6,
+};
+}  // namespace spv
+
+struct SpirvId
+{
+  uint32_t    opcode = 0;
+  std::string name;
+
+  // decorations
+  uint32_t set         = ~0u;
+  uint32_t binding     = ~0u;
+  uint32_t arrayStride = 0;
+  bool     block       = false;
+  bool     bufferBlock = false;
+
+  // types, variables and constants
+  uint32_t typeId       = 0;  // pointee, element, component, column or variable type
+  uint32_t storageClass = 0;
+  uint32_t value        = 0;  // constant low word, array length id, scalar width, vector/matrix count
+  uint32_t dim          = 0;
+  uint32_t sampled      = 0;
+
+  struct Member
+  {
+    uint32_t typeId       = 0;
+    uint32_t offset       = 0;
+    uint32_t matrixStride = 0;
+    bool     rowMajor     = false;
+  };
+  std::vector<Member> members;
+};
+
+struct SpirvModule
+{
+  struct EntryPoint
+  {
+    std::string           name;
+    VkShaderStageFlagBits stage{};
+    std::vector<uint32_t> interfaceIds;
+  };
+
+  uint32_t                version = 0;
+  std::vector<SpirvId>    ids;
+  std::vector<EntryPoint> entryPoints;
+  std::vector<uint32_t>   variables;
+
+  bool parse(std::span<const uint32_t> spirv);
+
+  uint32_t getSize(uint32_t typeId, const SpirvId::Member* member = nullptr, uint32_t depth = 0) const;
+};
+
+std::string readString(std::span<const uint32_t> words)
+{
+  const char* chars  = reinterpret_cast<const char*>(words.data());
+  size_t      length = strnlen(chars, words.size_bytes());
+  return std::string(chars, length);
+}
+
+VkShaderStageFlagBits getStage(uint32_t executionModel)
+{
+  switch(executionModel)
+  {
+    case 0:
+      return VK_SHADER_STAGE_VERTEX_BIT;
+    case 1:
+      return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case 2:
+      return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case 3:
+      return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case 4:
+      return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case 5:
+      return VK_SHADER_STAGE_COMPUTE_BIT;
+    case 5267:
+    case 5364:
+      return VK_SHADER_STAGE_TASK_BIT_EXT;
+    case 5268:
+    case 5365:
+      return VK_SHADER_STAGE_MESH_BIT_EXT;
+    case 5313:
+      return VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+    case 5314:
+      return VK_SHADER_STAGE_INTERSECTION_BIT_KHR;
+    case 5315:
+      return VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+    case 5316:
+      return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+    case 5317:
+      return VK_SHADER_STAGE_MISS_BIT_KHR;
+    case 5318:
+      return VK_SHADER_STAGE_CALLABLE_BIT_KHR;
+    default:
+      return VkShaderStageFlagBits(0);
+  }
+}
+
+bool SpirvModule::parse(std::span<const uint32_t> spirv)
+{
+  if(spirv.size() < 5 || spirv[0] != spv::MAGIC_NUMBER)
+  {
+    return false;
+  }
+
+  version = spirv[1];
+  ids.resize(spirv[3]);
+
+  auto getId = [&](uint32_t id) -> SpirvId* { return id < ids.size() ? &ids[id] : nullptr; };
+
+  size_t offset = 5;
+  while(offset < spirv.size())
+  {
+    const uint32_t wordCount = spirv[offset] >> 16;
+    const uint32_t opcode    = spirv[offset] & 0xFFFF;
+    if(wordCount == 0 || offset + wordCount > spirv.size())
+    {
+      return false;
+    }
+    std::span<const uint32_t> ops = spirv.subspan(offset + 1, wordCount - 1);
+    offset += wordCount;
+
+    switch(opcode)
+    {
+      case spv::OpName:
+        if(ops.size() >= 1 && getId(ops[0]))
+          ids[ops[0]].name = readString(ops.subspan(1));
+        break;
+      case spv::OpEntryPoint: {
+        if(ops.size() < 3)
+          return false;
+        EntryPoint entry{.name = readString(ops.subspan(2)), .stage = getStage(ops[0])};
+        // the name is null terminated and padded to whole words
+        const size_t nameWords = entry.name.size() / 4 + 1;
+        for(size_t i = 2 + nameWords; i < ops.size(); i++)
+          entry.interfaceIds.push_back(ops[i]);
+        entryPoints.push_back(std::move(entry));
+        break;
+      }
+      case spv::OpDecorate:
+        if(ops.size() >= 2 && getId(ops[0]))
+        {
+          SpirvId& id = ids[ops[0]];
+          if(ops[1] == spv::DecorationBlock)
+            id.block = true;
+          else if(ops[1] == spv::DecorationBufferBlock)
+            id.bufferBlock = true;
+          else if(ops.size() >= 3 && ops[1] == spv::DecorationArrayStride)
+            id.arrayStride = ops[2];
+          else if(ops.size() >= 3 && ops[1] == spv::DecorationBinding)
+            id.binding = ops[2];
+          else if(ops.size() >= 3 && ops[1] == spv::DecorationDescriptorSet)
+            id.set = ops[2];
+        }
+        break;
+      case spv::OpMemberDecorate:
+        // the member index bound protects against corrupt modules
+        if(ops.size() >= 3 && getId(ops[0]) && ops[1] < 0x10000)
+        {
+          std::vector<SpirvId::Member>& members = ids[ops[0]].members;
+          if(members.size() <= ops[1])
+            members.resize(ops[1] + 1);
+          SpirvId::Member& member = members[ops[1]];
+          if(ops[2] == spv::DecorationRowMajor)
+            member.rowMajor = true;
+          else if(ops.size() >= 4 && ops[2] == spv::DecorationOffset)
+            member.offset = ops[3];
+          else if(ops.size() >= 4 && ops[2] == spv::DecorationMatrixStride)
+            member.matrixStride = ops[3];
+        }
+        break;
+      case spv::OpTypeBool:
+      case spv::OpTypeSampler:
+      case spv::OpTypeAccelerationStructureKHR:
+        if(ops.size() >= 1 && getId(ops[0]))
+          ids[ops[0]].opcode = opcode;
+        break;
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat:
+      case spv::OpTypeRuntimeArray:
+      case spv::OpTypeSampledImage:
+        if(ops.size() >= 2 && getId(ops[0]))
+        {
+          ids[ops[0]].opcode = opcode;
+          // width for scalars, element or image type otherwise
+          if(opcode == spv::OpTypeInt || opcode == spv::OpTypeFloat)
+            ids[ops[0]].value = ops[1];
+          else
+            ids[ops[0]].typeId = ops[1];
+        }
+        break;
+      case spv::OpTypeVector:
+      case spv::OpTypeMatrix:
+      case spv::OpTypeArray:
+        if(ops.size() >= 3 && getId(ops[0]))
+        {
+          ids[ops[0]].opcode = opcode;
+          ids[ops[0]].typeId = ops[1];
+          ids[ops[0]].value  = ops[2];
+        }
+        break;
+      case spv::OpTypeImage:
+        if(ops.size() >= 7 && getId(ops[0]))
+        {
+          ids[ops[0]].opcode  = opcode;
+          ids[ops[0]].dim     = ops[2];
+          ids[ops[0]].sampled = ops[6];
+        }
+        break;
+      case spv::OpTypeStruct:
+        if(ops.size() >= 1 && getId(ops[0]))
+        {
+          SpirvId& id = ids[ops[0]];
+          id.opcode   = opcode;
+          // member decorations can precede or follow the type
+          if(id.members.size() < ops.size() - 1)
+            id.members.resize(ops.size() - 1);
+          for(size_t i = 1; i < ops.size(); i++)
+            id.members[i - 1].typeId = ops[i];
+        }
+        break;
+      case spv::OpTypePointer:
+        if(ops.size() >= 3 && getId(ops[0]))
+        {
+          ids[ops[0]].opcode       = opcode;
+          ids[ops[0]].storageClass = ops[1];
+          ids[ops[0]].typeId       = ops[2];
+        }
+        break;
+      case spv::OpConstant:
+      case spv::OpSpecConstant:
+        if(ops.size() >= 3 && getId(ops[1]))
+        {
+          ids[ops[1]].opcode = opcode;
+          ids[ops[1]].value  = ops[2];
+        }
+        break;
+      case spv::OpVariable:
+        if(ops.size() >= 3 && getId(ops[1]))
+        {
+          ids[ops[1]].opcode       = opcode;
+          ids[ops[1]].typeId       = ops[0];
+          ids[ops[1]].storageClass = ops[2];
+          variables.push_back(ops[1]);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  return true;
+}
+
+uint32_t SpirvModule::getSize(uint32_t typeId, const SpirvId::Member* member, uint32_t depth) const
+{
+  if(typeId >= ids.size() || depth > 32)
+    return 0;
+
+  const SpirvId& type = ids[typeId];
+  switch(type.opcode)
+  {
+    case spv::OpTypeBool:
+      return 4;
+    case spv::OpTypeInt:
+    case spv::OpTypeFloat:
+      return type.value / 8;
+    case spv::OpTypeVector:
+      return type.value * getSize(type.typeId, nullptr, depth + 1);
+    case spv::OpTypeMatrix: {
+      if(member && member->matrixStride)
+      {
+        // row major matrices are strided by rows, the component count of the column vector
+        const uint32_t rows = type.typeId < ids.size() ? ids[type.typeId].value : 0;
+        return (member->rowMajor ? rows : type.value) * member->matrixStride;
+      }
+      return type.value * getSize(type.typeId, nullptr, depth + 1);
+    }
+    case spv::OpTypeArray: {
+      const uint32_t length = type.value < ids.size() ? ids[type.value].value : 0;
+      const uint32_t stride = type.arrayStride ? type.arrayStride : getSize(type.typeId, member, depth + 1);
+      return length * stride;
+    }
+    case spv::OpTypeStruct: {
+      uint32_t size = 0;
+      for(const SpirvId::Member& structMember : type.members)
+      {
+        size = std::max(size, structMember.offset + getSize(structMember.typeId, &structMember, depth + 1));
+      }
+      return size;
+    }
+    case spv::OpTypePointer:
+      // buffer references
+      return type.storageClass == spv::StorageClassPhysicalStorageBuffer ? 8 : 0;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
+bool ShaderReflection::addModule(std::span<const uint32_t> spirv, const char* entryPoint)
+{
+  SpirvModule module;
+  if(!module.parse(spirv))
+  {
+    LOGE("ShaderReflection: invalid SPIR-V\n");
+    return false;
+  }
+
+  // Before SPIR-V 1.4 the entry point interfaces only list the input and output variables
+  const bool                      interfaceHasResources = module.version >= 0x00010400;
+  std::vector<VkShaderStageFlags> variableStages(module.ids.size(), 0);
+  bool                            foundEntryPoint = false;
+  for(const SpirvModule::EntryPoint& entry : module.entryPoints)
+  {
+    if(entryPoint && entry.name != entryPoint)
+      continue;
+
+    foundEntryPoint = true;
+    m_stageFlags |= entry.stage;
+    if(interfaceHasResources)
+    {
+      for(uint32_t id : entry.interfaceIds)
+      {
+        if(id < variableStages.size())
+          variableStages[id] |= entry.stage;
+      }
+    }
+    else
+    {
+      for(uint32_t id : module.variables)
+        variableStages[id] |= entry.stage;
+    }
+  }
+  if(!foundEntryPoint)
+  {
+    LOGE("ShaderReflection: entry point %s not found\n", entryPoint ? entryPoint : "");
+    return false;
+  }
+
+  bool success = true;
+  for(uint32_t variableId : module.variables)
+  {
+    const SpirvId&           variable = module.ids[variableId];
+    const VkShaderStageFlags stages   = variableStages[variableId];
+    if(!stages || variable.typeId >= module.ids.size())
+      continue;
+
+    const SpirvId& pointer = module.ids[variable.typeId];
+    if(pointer.opcode != spv::OpTypePointer || pointer.typeId >= module.ids.size())
+      continue;
+
+    if(variable.storageClass == spv::StorageClassPushConstant)
+    {
+      const SpirvId& block = module.ids[pointer.typeId];
+      uint32_t       begin = ~0u;
+      for(const SpirvId::Member& member : block.members)
+        begin = std::min(begin, member.offset);
+      const uint32_t end = module.getSize(pointer.typeId);
+      if(begin >= end)
+        continue;
+
+      if(m_pushConstantRange.size == 0)
+      {
+        m_pushConstantRange.offset = begin;
+        m_pushConstantRange.size   = end - begin;
+      }
+      else
+      {
+        const uint32_t rangeEnd    = std::max(m_pushConstantRange.offset + m_pushConstantRange.size, end);
+        m_pushConstantRange.offset = std::min(m_pushConstantRange.offset, begin);
+        m_pushConstantRange.size   = rangeEnd - m_pushConstantRange.offset;
+      }
+      m_pushConstantRange.stageFlags |= stages;
+      continue;
+    }
+
+    if(variable.storageClass != spv::StorageClassUniformConstant && variable.storageClass != spv::StorageClassUniform
+       && variable.storageClass != spv::StorageClassStorageBuffer)
+      continue;
+    if(variable.binding == ~0u)
+      continue;
+
+    Binding binding{.set             = variable.set == ~0u ? 0 : variable.set,
+                    .binding         = variable.binding,
+                    .descriptorCount = 1,
+                    .stageFlags      = stages,
+                    .name            = variable.name};
+
+    // arrays of descriptors
+    uint32_t typeId = pointer.typeId;
+    while(typeId < module.ids.size()
+          && (module.ids[typeId].opcode == spv::OpTypeArray || module.ids[typeId].opcode == spv::OpTypeRuntimeArray))
+    {
+      const SpirvId& array = module.ids[typeId];
+      if(array.opcode == spv::OpTypeRuntimeArray)
+        binding.descriptorCount = 0;
+      else if(array.value < module.ids.size())
+        binding.descriptorCount *= module.ids[array.value].value;
+      typeId = array.typeId;
+    }
+    if(typeId >= module.ids.size())
+      continue;
+
+    const SpirvId& type = module.ids[typeId];
+    if(binding.name.empty())
+      binding.name = type.name;
+
+    switch(type.opcode)
+    {
+      case spv::OpTypeSampler:
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        break;
+      case spv::OpTypeSampledImage: {
+        const bool isBuffer    = type.typeId < module.ids.size() && module.ids[type.typeId].dim == spv::DimBuffer;
+        binding.descriptorType = isBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        break;
+      }
+      case spv::OpTypeImage:
+        // sampled 2 means storage, 1 (or 0, known at runtime) sampled
+        if(type.dim == spv::DimSubpassData)
+          binding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        else if(type.dim == spv::DimBuffer)
+          binding.descriptorType = type.sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        else
+          binding.descriptorType = type.sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        break;
+      case spv::OpTypeAccelerationStructureKHR:
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+        break;
+      case spv::OpTypeStruct:
+        if(variable.storageClass == spv::StorageClassStorageBuffer || type.bufferBlock)
+          binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        else
+          binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        break;
+      default:
+        continue;
+    }
+
+    auto it = std::lower_bound(m_bindings.begin(), m_bindings.end(), binding, [](const Binding& a, const Binding& b) {
+      return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    if(it != m_bindings.end() && it->set == binding.set && it->binding == binding.binding)
+    {
+      if(it->descriptorType != binding.descriptorType || it->descriptorCount != binding.descriptorCount)
+      {
+        LOGE("ShaderReflection: set %u binding %u (%s) differs between modules\n", binding.set, binding.binding,
+             binding.name.c_str());
+        success = false;
+      }
+      it->stageFlags |= binding.stageFlags;
+    }
+    else
+    {
+      m_bindings.insert(it, std::move(binding));
+    }
+  }
+
+  return success;
+}
+
+void ShaderReflection::clear()
+{
+  m_bindings.clear();
+  m_pushConstantRange = {};
+  m_stageFlags        = 0;
+}
+
+bool ShaderReflection::setDescriptorType(uint32_t set, uint32_t binding, VkDescriptorType descriptorType)
+{
+  for(Binding& it : m_bindings)
+  {
+    if(it.set == set && it.binding == binding)
+    {
+      it.descriptorType = descriptorType;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t ShaderReflection::getSetCount() const
+{
+  return m_bindings.empty() ? 0 : m_bindings.back().set + 1;
+}
+
+void ShaderReflection::getSetBindings(uint32_t set, DescriptorBindings& bindings, uint32_t runtimeArrayCount) const
+{
+  for(const Binding& it : m_bindings)
+  {
+    if(it.set != set)
+      continue;
+
+    if(it.descriptorCount)
+    {
+      bindings.addBinding(it.binding, it.descriptorType, it.descriptorCount, it.stageFlags);
+    }
+    else
+    {
+      bindings.addBinding(it.binding, it.descriptorType, runtimeArrayCount, it.stageFlags, nullptr,
+                          VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+    }
+  }
+}
+
+}  // namespace nvvk
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_ShaderReflection(std::span<const uint32_t> vertexSpirv, std::span<const uint32_t> fragmentSpirv)
+{
+  nvvk::ShaderReflection reflection;
+  reflection.addModule(vertexSpirv);
+  reflection.addModule(fragmentSpirv, "main");
+
+  // SPIR-V has no dynamic buffers, the application tells which ones are
+  reflection.setDescriptorType(0, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+
+  // Bindings of set 0, e.g. for a `nvvk::DescriptorPack`
+  nvvk::DescriptorBindings bindings;
+  reflection.getSetBindings(0, bindings);
+
+  // The push constant range of the pipeline layout, and the stages to push them with
+  [[maybe_unused]] const VkPushConstantRange& pushConstantRange = reflection.getPushConstantRange();
+
+  // `nvvk::PipelineLayoutCache` creates the layouts from the reflection directly
+}
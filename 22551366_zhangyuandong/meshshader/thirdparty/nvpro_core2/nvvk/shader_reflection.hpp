@@ -0,0 +1,90 @@
+/*
+* Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include "descriptors.hpp"
+
+namespace nvvk {
+
+//-----------------------------------------------------------------
+// Resource interface of SPIR-V modules, reflected from the modules themselves.
+// Gives the descriptor set bindings and the push constant range the pipeline layout needs,
+// instead of declaring them by hand next to the shaders.
+//
+// - Several modules (or entry points of one module) are merged, the stage flags of a binding
+//   are those of the entry points using it (all the entry points of the module before SPIR-V 1.4,
+//   whose interfaces don't list the resources).
+// - Descriptors that SPIR-V can't tell apart must be patched with `setDescriptorType`,
+//   e.g. dynamic uniform or storage buffers.
+// - Runtime arrays (bindless) have a `descriptorCount` of 0 in the reflection,
+//   `getSetBindings` replaces it with the provided count.
+//
+// Usage:
+//      see usage_ShaderReflection in shader_reflection.cpp
+//-----------------------------------------------------------------
+class ShaderReflection
+{
+public:
+  struct Binding
+  {
+    uint32_t           set             = 0;
+    uint32_t           binding         = 0;
+    VkDescriptorType   descriptorType  = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    uint32_t           descriptorCount = 1;  // 0 for runtime arrays
+    VkShaderStageFlags stageFlags      = 0;
+    std::string        name;
+  };
+
+  // Adds the resources of all entry points of the module, or only of `entryPoint` when not null.
+  // Returns false if the code isn't valid SPIR-V or if a binding conflicts with a previous module.
+  bool addModule(std::span<const uint32_t> spirv, const char* entryPoint = nullptr);
+  void clear();
+
+  // Overrides the type of a reflected binding, returns false when there is no such binding
+  bool setDescriptorType(uint32_t set, uint32_t binding, VkDescriptorType descriptorType);
+
+  // Sorted by set and binding
+  const std::vector<Binding>& getBindings() const { return m_bindings; }
+
+  // Number of sets covering all bindings (highest set index + 1)
+  uint32_t getSetCount() const;
+
+  // Adds the bindings of `set`, runtime arrays get `runtimeArrayCount` descriptors and
+  // VARIABLE_DESCRIPTOR_COUNT | PARTIALLY_BOUND flags.
+  void getSetBindings(uint32_t set, DescriptorBindings& bindings, uint32_t runtimeArrayCount = 0) const;
+
+  // The single range covering the push constants of all stages, size 0 if there are none
+  const VkPushConstantRange& getPushConstantRange() const { return m_pushConstantRange; }
+
+  // Stages of all the added entry points
+  VkShaderStageFlags getStageFlags() const { return m_stageFlags; }
+
+private:
+  std::vector<Binding> m_bindings;
+  VkPushConstantRange  m_pushConstantRange{};
+  VkShaderStageFlags   m_stageFlags = 0;
+};
+
+}  // namespace nvvk
@@ -17,6 +17,8 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 
+#include <algorithm>
+
 #include "staging.hpp"
 #include "barriers.hpp"
 #include "check_error.hpp"
@@ -31,6 +33,9 @@ StagingUploader::StagingUploader(StagingUploader&& other) noexcept
     std::swap(m_resourceAllocator, other.m_resourceAllocator);
     std::swap(m_stagingResourcesSize, other.m_stagingResourcesSize);
     std::swap(m_stagingResources, other.m_stagingResources);
+    std::swap(m_ring, other.m_ring);
+    std::swap(m_transfer, other.m_transfer);
+    std::swap(m_memoryDecompression, other.m_memoryDecompression);
   }
 }
 
@@ -44,6 +49,9 @@ nvvk::StagingUploader& StagingUploader::operator=(StagingUploader&& other) noexc
     std::swap(m_resourceAllocator, other.m_resourceAllocator);
     std::swap(m_stagingResourcesSize, other.m_stagingResourcesSize);
     std::swap(m_stagingResources, other.m_stagingResources);
+    std::swap(m_ring, other.m_ring);
+    std::swap(m_transfer, other.m_transfer);
+    std::swap(m_memoryDecompression, other.m_memoryDecompression);
   }
   return *this;
 }
@@ -61,6 +69,18 @@ void StagingUploader::deinit()
   {
     releaseStaging(true);
     assert(m_stagingResources.empty() && m_stagingResourcesSize == 0);  // must have released all staged uploads
+    if(hasRingArena())
+    {
+      m_resourceAllocator->destroyBuffer(m_ring.buffer);
+    }
+    if(hasTransferQueue())
+    {
+      VkDevice device = m_resourceAllocator->getDevice();
+      releaseTransferCommands(true);
+      vkDestroyCommandPool(device, m_transfer.cmdPool, nullptr);
+      vkDestroySemaphore(device, m_transfer.semaphore, nullptr);
+      m_transfer = {};
+    }
   }
   m_resourceAllocator = nullptr;
 }
@@ -70,17 +90,20 @@ void StagingUploader::setEnableLayoutBarriers(bool enableLayoutBarriers)
   m_enableLayoutBarriers = enableLayoutBarriers;
 }
 
+void StagingUploader::setMemoryDecompression(bool enable)
+{
+  assert((!enable || vkCmdDecompressMemoryNV) && "VK_NV_memory_decompression not enabled");
+  m_memoryDecompression = enable && vkCmdDecompressMemoryNV;
+}
+
 nvvk::ResourceAllocator* StagingUploader::getResourceAllocator()
 {
   assert(m_resourceAllocator);
   return m_resourceAllocator;
 }
 
-VkResult StagingUploader::acquireStagingSpace(BufferRange& stagingSpace, size_t dataSize, const void* data, const SemaphoreState& semaphoreState)
+VkResult StagingUploader::createStagingBuffer(nvvk::Buffer& buffer, VkDeviceSize size)
 {
-  StagingResource stagingResource;
-  stagingResource.semaphoreState = semaphoreState;
-
   // VMA_MEMORY_USAGE_AUTO_PREFER_HOST staging memory is meant to not cost additional device memory
   //
   // VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT staging memory is filled sequentially
@@ -105,21 +128,122 @@ VkResult StagingUploader::acquireStagingSpace(BufferRange& stagingSpace, size_t
   const VkBufferCreateInfo bufferInfo{
       .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
       .pNext       = &bufferUsageFlags2CreateInfo,
-      .size        = dataSize,
+      .size        = size,
       .usage       = 0,
       .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
   };
 
   // Create a staging buffer
-  NVVK_FAIL_RETURN(m_resourceAllocator->createBuffer(stagingResource.buffer, bufferInfo, allocInfo));
-  NVVK_DBG_NAME(stagingResource.buffer.buffer);
+  NVVK_FAIL_RETURN(m_resourceAllocator->createBuffer(buffer, bufferInfo, allocInfo));
+  NVVK_DBG_NAME(buffer.buffer);
 
-  if(!stagingResource.buffer.mapping)
+  if(!buffer.mapping)
   {
-    m_resourceAllocator->destroyBuffer(stagingResource.buffer);
+    m_resourceAllocator->destroyBuffer(buffer);
     return VK_ERROR_MEMORY_MAP_FAILED;
   }
 
+  return VK_SUCCESS;
+}
+
+VkResult StagingUploader::initRingArena(VkDeviceSize arenaSize)
+{
+  assert(m_resourceAllocator && !hasRingArena());
+  NVVK_FAIL_RETURN(createStagingBuffer(m_ring.buffer, arenaSize));
+  m_ring.head = 0;
+  return VK_SUCCESS;
+}
+
+// Sub-allocations are a multiple of every texel block size (1, 2, 3, 4, 6, 8, 12 and 16 bytes),
+// as required for the buffer offsets of buffer to image copies.
+static constexpr VkDeviceSize s_ringAlignment = 48;
+
+bool StagingUploader::acquireRingSpace(BufferRange& stagingSpace, size_t dataSize, const SemaphoreState& semaphoreState)
+{
+  const VkDeviceSize capacity = m_ring.buffer.bufferSize;
+  if(!hasRingArena() || dataSize > capacity / 4)
+  {
+    return false;
+  }
+
+  // The used space goes from the oldest region to the head, possibly wrapping around the end.
+  // A head reaching the oldest region again means the arena is full.
+  const VkDeviceSize tail   = m_ring.regions.empty() ? 0 : m_ring.regions.front().offset;
+  VkDeviceSize       offset = ((m_ring.regions.empty() ? 0 : m_ring.head) + s_ringAlignment - 1) / s_ringAlignment * s_ringAlignment;
+  if(!m_ring.regions.empty() && m_ring.head == tail)
+  {
+    return false;
+  }
+  if(m_ring.regions.empty() || m_ring.head > tail)
+  {
+    if(offset + dataSize > capacity)
+    {
+      // wrap around, skipping the end of the arena
+      offset = 0;
+      if(m_ring.regions.empty() ? dataSize > capacity : dataSize > tail)
+      {
+        return false;
+      }
+    }
+  }
+  else if(offset + dataSize > tail)
+  {
+    return false;
+  }
+
+  // the padding skipped by the alignment or the wrap is reclaimed together with the previous region
+  m_ring.head = offset + dataSize;
+  m_ring.regions.push_back({offset, dataSize, semaphoreState});
+  m_stagingResourcesSize += dataSize;
+
+  stagingSpace.buffer  = m_ring.buffer.buffer;
+  stagingSpace.offset  = offset;
+  stagingSpace.range   = dataSize;
+  stagingSpace.address = m_ring.buffer.address + offset;
+  stagingSpace.mapping = m_ring.buffer.mapping + offset;
+
+  return true;
+}
+
+void StagingUploader::releaseRingSpace(bool forceAll)
+{
+  VkDevice device = m_resourceAllocator->getDevice();
+
+  // regions are released in allocation order, this keeps the used space contiguous
+  while(!m_ring.regions.empty())
+  {
+    RingRegion& region = m_ring.regions.front();
+    bool canRelease    = forceAll || (!region.semaphoreState.isValid()) || region.semaphoreState.testSignaled(device);
+    if(!canRelease)
+    {
+      break;
+    }
+    m_stagingResourcesSize -= region.size;
+    m_ring.regions.pop_front();
+  }
+
+  if(m_ring.regions.empty())
+  {
+    m_ring.head = 0;
+  }
+}
+
+VkResult StagingUploader::acquireStagingSpace(BufferRange& stagingSpace, size_t dataSize, const void* data, const SemaphoreState& semaphoreState)
+{
+  if(acquireRingSpace(stagingSpace, dataSize, semaphoreState))
+  {
+    if(data)
+    {
+      memcpy(stagingSpace.mapping, data, dataSize);
+    }
+    return VK_SUCCESS;
+  }
+
+  StagingResource stagingResource;
+  stagingResource.semaphoreState = semaphoreState;
+
+  NVVK_FAIL_RETURN(createStagingBuffer(stagingResource.buffer, dataSize));
+
   if(data)
   {
     memcpy(stagingResource.buffer.mapping, data, dataSize);
@@ -146,6 +270,8 @@ void StagingUploader::cancelAppended()
   m_batch.copyBufferImageRegions.clear();
   m_batch.copyBufferInfos.clear();
   m_batch.copyBufferRegions.clear();
+  m_batch.decompressRegions.clear();
+  m_batch.decompressBarriers.clear();
   m_batch.pre.clear();
   m_batch.post.clear();
   m_batch.stagingSize  = 0;
@@ -154,7 +280,7 @@ void StagingUploader::cancelAppended()
 
 bool StagingUploader::isAppendedEmpty() const
 {
-  return m_batch.copyBufferImageInfos.empty() && m_batch.copyBufferInfos.empty();
+  return m_batch.copyBufferImageInfos.empty() && m_batch.copyBufferInfos.empty() && m_batch.decompressRegions.empty();
 }
 
 void StagingUploader::beginTransferOnly()
@@ -185,7 +311,9 @@ VkResult StagingUploader::appendBuffer(const nvvk::Buffer&   buffer,
 
   if(buffer.mapping)
   {
+    // host-visible destination (e.g. resizable BAR), no staging or copy needed
     memcpy(buffer.mapping + bufferOffset, data, dataSize);
+    NVVK_FAIL_RETURN(m_resourceAllocator->autoFlushBuffer(buffer, bufferOffset, dataSize));
   }
   else
   {
@@ -215,6 +343,87 @@ VkResult StagingUploader::appendBuffer(const nvvk::Buffer&   buffer,
   return VK_SUCCESS;
 }
 
+// GDeflate tiles decompress to 64 KiB, the maximum of VK_MEMORY_DECOMPRESSION_METHOD_GDEFLATE_1_0_BIT_NV
+static constexpr VkDeviceSize s_gdeflateTileSize = 65536;
+
+VkResult StagingUploader::appendBufferGDeflate(const nvvk::Buffer&       buffer,
+                                               VkDeviceSize              bufferOffset,
+                                               VkDeviceSize              decompressedSize,
+                                               std::span<const uint8_t>  compressedData,
+                                               std::span<const uint32_t> tileOffsets,
+                                               const SemaphoreState&     semaphoreState)
+{
+  assert(m_memoryDecompression && "Missing setMemoryDecompression(true)");
+  assert(buffer.address && bufferOffset % 4 == 0);
+  assert(bufferOffset + decompressedSize <= buffer.bufferSize);
+
+  if(decompressedSize == 0)
+  {
+    return VK_SUCCESS;
+  }
+
+  const size_t tileCount = tileOffsets.size() - 1;
+  assert(tileOffsets.size() >= 2 && tileOffsets.back() <= compressedData.size());
+  assert(tileCount == (decompressedSize + s_gdeflateTileSize - 1) / s_gdeflateTileSize);
+
+  // the tiles are repacked at 4 byte aligned addresses, as required for the sources
+  size_t stagingSize = 0;
+  for(size_t i = 0; i < tileCount; i++)
+  {
+    stagingSize += (tileOffsets[i + 1] - tileOffsets[i] + 3) & ~size_t(3);
+  }
+
+  BufferRange stagingSpace;
+  NVVK_FAIL_RETURN(acquireStagingSpace(stagingSpace, stagingSize, nullptr, semaphoreState));
+
+  VkDeviceSize stagingOffset = 0;
+  for(size_t i = 0; i < tileCount; i++)
+  {
+    const VkDeviceSize tileSize  = tileOffsets[i + 1] - tileOffsets[i];
+    const VkDeviceSize dstOffset = i * s_gdeflateTileSize;
+    memcpy(stagingSpace.mapping + stagingOffset, compressedData.data() + tileOffsets[i], tileSize);
+
+    m_batch.decompressRegions.push_back({
+        .srcAddress          = stagingSpace.address + stagingOffset,
+        .dstAddress          = buffer.address + bufferOffset + dstOffset,
+        .compressedSize      = tileSize,
+        .decompressedSize    = std::min(s_gdeflateTileSize, decompressedSize - dstOffset),
+        .decompressionMethod = VK_MEMORY_DECOMPRESSION_METHOD_GDEFLATE_1_0_BIT_NV,
+    });
+    stagingOffset += (tileSize + 3) & ~VkDeviceSize(3);
+  }
+
+  m_batch.decompressBarriers.push_back({
+      .sType  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+      .buffer = buffer.buffer,
+      .offset = bufferOffset,
+      .size   = decompressedSize,
+  });
+  m_batch.stagingSize += stagingSize;
+
+  return VK_SUCCESS;
+}
+
+// Makes the decompressions an earlier part of the transfer stage, chained by the barriers after the copies
+static void cmdDecompressAppended(VkCommandBuffer cmd, const std::vector<VkDecompressMemoryRegionNV>& regions)
+{
+  if(regions.empty())
+  {
+    return;
+  }
+  vkCmdDecompressMemoryNV(cmd, uint32_t(regions.size()), regions.data());
+
+  const VkMemoryBarrier2 barrier{
+      .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+      .srcStageMask  = VK_PIPELINE_STAGE_2_MEMORY_DECOMPRESSION_BIT_NV,
+      .srcAccessMask = VK_ACCESS_2_MEMORY_DECOMPRESSION_WRITE_BIT_NV,
+      .dstStageMask  = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+      .dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+  };
+  const VkDependencyInfo depInfo{.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .memoryBarrierCount = 1, .pMemoryBarriers = &barrier};
+  vkCmdPipelineBarrier2(cmd, &depInfo);
+}
+
 VkResult StagingUploader::appendBufferRange(const nvvk::BufferRange& bufferRange, const void* data, const SemaphoreState& semaphoreState)
 {
   // allow empty without throwing error
@@ -506,6 +715,12 @@ bool StagingUploader::checkAppendedSize(size_t limitInBytes, size_t addedSize) c
 
 void StagingUploader::cmdUploadAppended(VkCommandBuffer cmd)
 {
+  if(hasTransferQueue())
+  {
+    submitTransferAppended(cmd);
+    return;
+  }
+
   if(m_enableLayoutBarriers)
   {
     m_batch.pre.cmdPipelineBarrier(cmd, 0);
@@ -523,6 +738,8 @@ void StagingUploader::cmdUploadAppended(VkCommandBuffer cmd)
     vkCmdCopyBufferToImage2(cmd, &m_batch.copyBufferImageInfos[i]);
   }
 
+  cmdDecompressAppended(cmd, m_batch.decompressRegions);
+
   if(m_enableLayoutBarriers)
   {
     m_batch.post.cmdPipelineBarrier(cmd, 0);
@@ -582,6 +799,226 @@ void StagingUploader::releaseStaging(bool forceAll)
   }
 
   m_stagingResources.resize(writeIdx);
+
+  releaseRingSpace(forceAll);
+  if(hasTransferQueue())
+  {
+    releaseTransferCommands(forceAll);
+  }
+}
+
+VkResult StagingUploader::initTransferQueue(const QueueInfo& transferQueue, uint32_t dstQueueFamilyIndex)
+{
+  assert(m_resourceAllocator && !hasTransferQueue());
+  VkDevice device = m_resourceAllocator->getDevice();
+
+  const VkCommandPoolCreateInfo poolCreateInfo{
+      .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+      .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+      .queueFamilyIndex = transferQueue.familyIndex,
+  };
+  NVVK_FAIL_RETURN(vkCreateCommandPool(device, &poolCreateInfo, nullptr, &m_transfer.cmdPool));
+  NVVK_DBG_NAME(m_transfer.cmdPool);
+  NVVK_FAIL_RETURN(createTimelineSemaphore(device, 0, m_transfer.semaphore));
+  NVVK_DBG_NAME(m_transfer.semaphore);
+
+  m_transfer.queue               = transferQueue;
+  m_transfer.dstQueueFamilyIndex = dstQueueFamilyIndex;
+  m_transfer.value               = 0;
+  return VK_SUCCESS;
+}
+
+VkSemaphoreSubmitInfo StagingUploader::getTransferWait(VkPipelineStageFlags2 stageMask) const
+{
+  return {
+      .sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .semaphore = m_transfer.semaphore,
+      .value     = m_transfer.value,
+      .stageMask = stageMask,
+  };
+}
+
+// Records the appended copies into a command buffer of the transfer queue and submits it.
+// The resources written by the copies are released to the destination queue family at the
+// end of it, and acquired in `dstCmd`.
+void StagingUploader::submitTransferAppended(VkCommandBuffer dstCmd)
+{
+  if(isAppendedEmpty())
+  {
+    cancelAppended();
+    return;
+  }
+
+  VkDevice device = m_resourceAllocator->getDevice();
+  releaseTransferCommands(false);
+
+  const bool ownershipTransfer = m_transfer.queue.familyIndex != m_transfer.dstQueueFamilyIndex;
+  const uint32_t srcFamily = ownershipTransfer ? m_transfer.queue.familyIndex : VK_QUEUE_FAMILY_IGNORED;
+  const uint32_t dstFamily = ownershipTransfer ? m_transfer.dstQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+
+  BarrierContainer& release = m_transfer.release;
+  BarrierContainer& acquire = m_transfer.acquire;
+  release.clear();
+  acquire.clear();
+
+  // the previous content, if any, is ordered by the caller's semaphores: only the copies are waited on
+  for(VkImageMemoryBarrier2& barrier : m_batch.pre.imageBarriers)
+  {
+    barrier.srcStageMask  = VK_PIPELINE_STAGE_2_NONE;
+    barrier.srcAccessMask = VK_ACCESS_2_NONE;
+    barrier.dstStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+  }
+
+  for(const VkCopyBufferInfo2& copyInfo : m_batch.copyBufferInfos)
+  {
+    const VkBufferCopy2& region = m_batch.copyBufferRegions[&copyInfo - m_batch.copyBufferInfos.data()];
+    release.bufferBarriers.push_back({
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .srcQueueFamilyIndex = srcFamily,
+        .dstQueueFamilyIndex = dstFamily,
+        .buffer              = copyInfo.dstBuffer,
+        .offset              = region.dstOffset,
+        .size                = region.size,
+    });
+  }
+
+  // the decompressions are synchronized as copies, see cmdDecompressAppended
+  for(VkBufferMemoryBarrier2 barrier : m_batch.decompressBarriers)
+  {
+    barrier.srcStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    barrier.srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = srcFamily;
+    barrier.dstQueueFamilyIndex = dstFamily;
+    release.bufferBarriers.push_back(barrier);
+  }
+
+  // one barrier per image, with the final layout of the post barriers
+  for(const VkCopyBufferToImageInfo2& copyInfo : m_batch.copyBufferImageInfos)
+  {
+    auto sameImage = [&](const VkImageMemoryBarrier2& barrier) { return barrier.image == copyInfo.dstImage; };
+    if(std::any_of(release.imageBarriers.begin(), release.imageBarriers.end(), sameImage))
+    {
+      continue;
+    }
+
+    const VkBufferImageCopy2& region = m_batch.copyBufferImageRegions[&copyInfo - m_batch.copyBufferImageInfos.data()];
+    auto          post      = std::find_if(m_batch.post.imageBarriers.begin(), m_batch.post.imageBarriers.end(), sameImage);
+    VkImageLayout newLayout = post != m_batch.post.imageBarriers.end() ? post->newLayout : copyInfo.dstImageLayout;
+    release.imageBarriers.push_back(makeImageMemoryBarrier({
+        .image               = copyInfo.dstImage,
+        .oldLayout           = copyInfo.dstImageLayout,
+        .newLayout           = newLayout,
+        .subresourceRange    = {region.imageSubresource.aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS},
+        .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_NONE,
+        .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstAccessMask       = VK_ACCESS_2_NONE,
+        .srcQueueFamilyIndex = srcFamily,
+        .dstQueueFamilyIndex = dstFamily,
+    }));
+  }
+
+  // the acquire barriers repeat the release ones, with the destination masks
+  if(ownershipTransfer)
+  {
+    acquire.bufferBarriers = release.bufferBarriers;
+    acquire.imageBarriers  = release.imageBarriers;
+    for(VkBufferMemoryBarrier2& barrier : acquire.bufferBarriers)
+    {
+      barrier.srcStageMask  = VK_PIPELINE_STAGE_2_NONE;
+      barrier.srcAccessMask = VK_ACCESS_2_NONE;
+      barrier.dstStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+      barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+    }
+    for(VkImageMemoryBarrier2& barrier : acquire.imageBarriers)
+    {
+      barrier.srcStageMask  = VK_PIPELINE_STAGE_2_NONE;
+      barrier.srcAccessMask = VK_ACCESS_2_NONE;
+      barrier.dstStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+      barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+    }
+  }
+
+  // record the transfer command buffer
+  VkCommandBuffer                   cmd{};
+  const VkCommandBufferAllocateInfo allocInfo{
+      .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool        = m_transfer.cmdPool,
+      .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+  };
+  NVVK_CHECK(vkAllocateCommandBuffers(device, &allocInfo, &cmd));
+  const VkCommandBufferBeginInfo beginInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  NVVK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+
+  if(m_enableLayoutBarriers)
+  {
+    m_batch.pre.cmdPipelineBarrier(cmd, 0);
+  }
+  for(size_t i = 0; i < m_batch.copyBufferInfos.size(); i++)
+  {
+    m_batch.copyBufferInfos[i].pRegions = &m_batch.copyBufferRegions[i];
+    vkCmdCopyBuffer2(cmd, &m_batch.copyBufferInfos[i]);
+  }
+  for(size_t i = 0; i < m_batch.copyBufferImageInfos.size(); i++)
+  {
+    m_batch.copyBufferImageInfos[i].pRegions = &m_batch.copyBufferImageRegions[i];
+    vkCmdCopyBufferToImage2(cmd, &m_batch.copyBufferImageInfos[i]);
+  }
+  cmdDecompressAppended(cmd, m_batch.decompressRegions);
+  release.cmdPipelineBarrier(cmd, 0);
+  NVVK_CHECK(vkEndCommandBuffer(cmd));
+
+  // submit, signaling the next timeline value
+  m_transfer.value++;
+  const VkCommandBufferSubmitInfo cmdInfo{
+      .sType         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+      .commandBuffer = cmd,
+  };
+  const VkSemaphoreSubmitInfo signalInfo = getTransferWait();
+  const VkSubmitInfo2         submitInfo{
+              .sType                    = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+              .commandBufferInfoCount   = 1,
+              .pCommandBufferInfos      = &cmdInfo,
+              .signalSemaphoreInfoCount = 1,
+              .pSignalSemaphoreInfos    = &signalInfo,
+  };
+  NVVK_CHECK(vkQueueSubmit2(m_transfer.queue.queue, 1, &submitInfo, VK_NULL_HANDLE));
+  m_transfer.pending.emplace_back(cmd, m_transfer.value);
+
+  acquire.cmdPipelineBarrier(dstCmd, 0);
+
+  // reset
+  cancelAppended();
+}
+
+void StagingUploader::releaseTransferCommands(bool forceAll)
+{
+  VkDevice device    = m_resourceAllocator->getDevice();
+  uint64_t completed = 0;
+  if(forceAll)
+  {
+    const VkSemaphoreWaitInfo waitInfo{
+        .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores    = &m_transfer.semaphore,
+        .pValues        = &m_transfer.value,
+    };
+    NVVK_CHECK(vkWaitSemaphores(device, &waitInfo, ~0ULL));
+  }
+  NVVK_CHECK(vkGetSemaphoreCounterValue(device, m_transfer.semaphore, &completed));
+
+  while(!m_transfer.pending.empty() && m_transfer.pending.front().second <= completed)
+  {
+    vkFreeCommandBuffers(device, m_transfer.cmdPool, 1, &m_transfer.pending.front().first);
+    m_transfer.pending.pop_front();
+  }
 }
 
 }  // namespace nvvk
@@ -682,6 +1119,28 @@ void StagingUploader::releaseStaging(bool forceAll)
   }
 
 
+  //////////////////////////////////////////////////////////////////////////
+  // uploading compressed data, decompressed on the GPU
+
+  {
+    // with VK_NV_memory_decompression and its feature enabled on the device
+    stagingUploader.setMemoryDecompression(true);
+
+    // a GDeflate payload, e.g. read from disk as it is, with the offsets of its tiles
+    std::vector<uint8_t>  compressed;
+    std::vector<uint32_t> tileOffsets;
+    VkDeviceSize          decompressedSize = 0;
+    nvvk::Buffer          vertexBuffer;
+    VkResult              result = resourceAllocator.createBuffer(vertexBuffer, decompressedSize, VK_BUFFER_USAGE_2_VERTEX_BUFFER_BIT);
+
+    result = stagingUploader.appendBufferGDeflate(vertexBuffer, 0, decompressedSize, compressed, tileOffsets);
+
+    // records the copies and the decompressions
+    VkCommandBuffer cmd{};
+    stagingUploader.cmdUploadAppended(cmd);
+  }
+
+
   //////////////////////////////////////////////////////////////////////////
   // using semaphore state to track deletion of temporary resources
 
@@ -696,6 +1155,10 @@ void StagingUploader::releaseStaging(bool forceAll)
     VkSemaphore timelineSemaphore{};
     uint64_t    timelineValue = 1;
 
+    // optionally, sub-allocate the per-frame uploads from one persistent buffer
+    // instead of creating a staging buffer for each of them
+    result = stagingUploader.initRingArena(64 * 1024 * 1024);
+
     // frame loop
     while(true)
     {
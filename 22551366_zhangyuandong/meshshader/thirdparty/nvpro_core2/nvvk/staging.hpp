@@ -20,6 +20,8 @@
 #pragma once
 
 #include <cassert>
+#include <deque>
+#include <span>
 
 #include "semaphore.hpp"
 #include "barriers.hpp"
@@ -54,8 +56,40 @@ public:
   // deinit implicitly calls `releaseStaging(true)`
   void deinit();
 
+  // optional ring arena: one persistently mapped staging buffer of `arenaSize` bytes,
+  // sub-allocated linearly and reclaimed in `releaseStaging` once the SemaphoreState
+  // of the oldest sub-allocations was signaled.
+  // Uploads larger than a quarter of the arena, or that don't fit while the arena is
+  // still in use, fall back to dedicated staging buffers.
+  VkResult initRingArena(VkDeviceSize arenaSize);
+  bool     hasRingArena() const { return m_ring.buffer.buffer != VK_NULL_HANDLE; }
+
+  // optional dedicated transfer queue: `cmdUploadAppended` then submits the copies on `transferQueue`,
+  // overlapping with the work of the other queues, and only records into its `cmd` the acquire half of
+  // the queue family ownership transfers to `dstQueueFamilyIndex`.
+  // The submit of that `cmd` must wait on `getTransferWait()`.
+  // Images must be uploaded from VK_IMAGE_LAYOUT_UNDEFINED (or be VK_SHARING_MODE_CONCURRENT),
+  // as the first layout transition happens on the transfer queue.
+  VkResult initTransferQueue(const QueueInfo& transferQueue, uint32_t dstQueueFamilyIndex);
+  bool     hasTransferQueue() const { return m_transfer.semaphore != VK_NULL_HANDLE; }
+
+  // timeline semaphore value signaled by the last transfer submit
+  VkSemaphoreSubmitInfo getTransferWait(VkPipelineStageFlags2 stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) const;
+
+  // state of the next transfer submit, releases the staging space of the uploads appended with it
+  SemaphoreState getTransferSemaphoreState() const
+  {
+    return SemaphoreState::makeFixed(m_transfer.semaphore, m_transfer.value + 1);
+  }
+
   void setEnableLayoutBarriers(bool enableLayoutBarriers);
 
+  // optional GPU decompression with VK_NV_memory_decompression (GDeflate 1.0), for `appendBufferGDeflate`.
+  // The device must be created with the extension and VkPhysicalDeviceMemoryDecompressionFeaturesNV::memoryDecompression.
+  // Without it, see nvshaders::MeshoptDecoder for meshopt streams decoded by a compute shader.
+  void setMemoryDecompression(bool enable);
+  bool hasMemoryDecompression() const { return m_memoryDecompression; }
+
   ResourceAllocator* getResourceAllocator();
 
   // All temporary staging resources are associated with the provided SemaphoreState.
@@ -91,6 +125,8 @@ public:
 
   // buffer.buffer, buffer.bufferSize and buffer.mapping are used
   // if buffer.mapping is valid, then we directly write to it
+  // (see `ResourceAllocator::getDirectUploadFlags` to get such buffers on resizable BAR systems),
+  // the GPU must no longer access the overwritten range
   // else staging space is acquired and a copy command appended
   // for later execution via `cmdUploadAppended`.
   // `dataSize` can be `0` does return VK_SUCCESS
@@ -104,6 +140,17 @@ public:
   VkResult appendBufferRange(const nvvk::BufferRange& bufferRange, const void* data, const SemaphoreState& semaphoreState = {});
 
 
+  // GDeflate payload decompressed by the GPU into `buffer` (see `setMemoryDecompression`): the staging space
+  // and the PCIe transfer are the compressed size. Tile `i` of `compressedData` is [tileOffsets[i], tileOffsets[i + 1]),
+  // each tile decompresses to 64 KiB but the last one, to the rest of `decompressedSize`.
+  // The decompressions end with a barrier to the transfer stage, so that the barriers after the copies cover them.
+  VkResult appendBufferGDeflate(const nvvk::Buffer&       buffer,
+                                VkDeviceSize              bufferOffset,
+                                VkDeviceSize              decompressedSize,
+                                std::span<const uint8_t>  compressedData,
+                                std::span<const uint32_t> tileOffsets,
+                                const SemaphoreState&     semaphoreState = {});
+
   // buffer.buffer, buffer.bufferSize and buffer.mapping are used
   // if buffer.mapping is valid, then we return it as `uploadMapping`
   // else staging space is acquired its mapping is returned in `uploadMapping`
@@ -208,6 +255,7 @@ public:
 
   // records pending operations (copy & relevant layout transitions) into the command buffer
   // and then resets the internal state for appended.
+  // With a transfer queue, they are submitted on it instead, see `initTransferQueue`
   void cmdUploadAppended(VkCommandBuffer cmd);
 
 protected:
@@ -218,12 +266,14 @@ protected:
     bool   transferOnly = false;
     size_t stagingSize  = 0;
 
-    std::vector<VkBufferCopy2>            copyBufferRegions;
-    std::vector<VkCopyBufferInfo2>        copyBufferInfos;
-    std::vector<VkBufferImageCopy2>       copyBufferImageRegions;
-    std::vector<VkCopyBufferToImageInfo2> copyBufferImageInfos;
-    BarrierContainer                      pre;
-    BarrierContainer                      post;
+    std::vector<VkBufferCopy2>              copyBufferRegions;
+    std::vector<VkCopyBufferInfo2>          copyBufferInfos;
+    std::vector<VkBufferImageCopy2>         copyBufferImageRegions;
+    std::vector<VkCopyBufferToImageInfo2>   copyBufferImageInfos;
+    std::vector<VkDecompressMemoryRegionNV> decompressRegions;
+    std::vector<VkBufferMemoryBarrier2>     decompressBarriers;  // destination ranges, for the transfer queue
+    BarrierContainer                        pre;
+    BarrierContainer                        post;
   };
 
   struct StagingResource
@@ -232,11 +282,48 @@ protected:
     SemaphoreState semaphoreState;
   };
 
+  // sub-allocation of the ring arena, kept in allocation order
+  struct RingRegion
+  {
+    VkDeviceSize   offset = 0;
+    VkDeviceSize   size   = 0;
+    SemaphoreState semaphoreState;
+  };
+
+  struct RingArena
+  {
+    nvvk::Buffer           buffer;
+    VkDeviceSize           head = 0;  // next allocation offset
+    std::deque<RingRegion> regions;
+  };
+
+  struct TransferQueue
+  {
+    QueueInfo        queue;
+    uint32_t         dstQueueFamilyIndex = ~0U;
+    VkCommandPool    cmdPool{};
+    VkSemaphore      semaphore{};
+    uint64_t         value = 0;  // signaled by the last submit
+    BarrierContainer release;
+    BarrierContainer acquire;
+
+    std::deque<std::pair<VkCommandBuffer, uint64_t>> pending;  // freed once their value is reached
+  };
+
+  VkResult createStagingBuffer(nvvk::Buffer& buffer, VkDeviceSize size);
+  void     submitTransferAppended(VkCommandBuffer dstCmd);
+  void     releaseTransferCommands(bool forceAll);
+  bool     acquireRingSpace(BufferRange& stagingSpace, size_t dataSize, const SemaphoreState& semaphoreState);
+  void     releaseRingSpace(bool forceAll);
+
   ResourceAllocator* m_resourceAllocator    = nullptr;
   size_t             m_stagingResourcesSize = 0;
   bool               m_enableLayoutBarriers = false;
+  bool               m_memoryDecompression  = false;
 
   std::vector<StagingResource> m_stagingResources;
+  RingArena                    m_ring{};
+  TransferQueue                m_transfer{};
   Batch                        m_batch{};
 };
 
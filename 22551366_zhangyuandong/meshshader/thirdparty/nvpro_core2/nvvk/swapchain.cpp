@@ -18,6 +18,8 @@
  */
 
 
+#include <algorithm>
+
 #include "nvutils/logger.hpp"
 
 #include "commands.hpp"
@@ -33,6 +35,11 @@ VkResult nvvk::Swapchain::init(const InitInfo& info)
   m_queue          = info.queue;
   m_surface        = info.surface;
   m_cmdPool        = info.cmdPool;
+  m_presentWait    = info.presentWait;
+  m_lowLatency2    = info.lowLatency2;
+  m_swapchainMaintenance1 = info.swapchainMaintenance1;
+  m_requestedPresentMode  = info.presentMode;
+  m_requestedImageCount   = info.imageCount;
   if(info.preferredVsyncOffMode != VK_PRESENT_MODE_MAX_ENUM_KHR)
     m_preferredVsyncOffMode = info.preferredVsyncOffMode;
   if(info.preferredVsyncOnMode != VK_PRESENT_MODE_MAX_ENUM_KHR)
@@ -77,15 +84,54 @@ VkResult nvvk::Swapchain::initResources(VkExtent2D& outWindowSize, bool vSync)
   std::vector<VkPresentModeKHR> presentModes(presentModeCount);
   NVVK_FAIL_RETURN(
       vkGetPhysicalDeviceSurfacePresentModesKHR(m_physicalDevice, m_surface, &presentModeCount, presentModes.data()));
+  m_supportedPresentModes = presentModes;
 
   // Choose the best available surface format and present mode
   const VkSurfaceFormat2KHR surfaceFormat2 = selectSwapSurfaceFormat(formats);
-  const VkPresentModeKHR    presentMode    = selectSwapPresentMode(presentModes, vSync);
+  VkPresentModeKHR          presentMode    = selectSwapPresentMode(presentModes, vSync);
+  if(m_requestedPresentMode != VK_PRESENT_MODE_MAX_ENUM_KHR)
+  {
+    if(std::find(presentModes.begin(), presentModes.end(), m_requestedPresentMode) != presentModes.end())
+      presentMode = m_requestedPresentMode;
+    else
+      LOGW("Present mode %d is not supported by the surface, using %d\n", m_requestedPresentMode, presentMode);
+  }
+  m_presentMode = presentMode;
+
+  // The modes the swapchain can switch to at present time, it needs enough images for all of them
+  uint32_t minImageCount = capabilities2.surfaceCapabilities.minImageCount;
+  m_compatiblePresentModes.clear();
+  if(m_swapchainMaintenance1)
+  {
+    VkSurfacePresentModeEXT               surfacePresentMode{.sType = VK_STRUCTURE_TYPE_SURFACE_PRESENT_MODE_EXT, .presentMode = presentMode};
+    const VkPhysicalDeviceSurfaceInfo2KHR modeSurfaceInfo{.sType   = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SURFACE_INFO_2_KHR,
+                                                          .pNext   = &surfacePresentMode,
+                                                          .surface = m_surface};
+    VkSurfacePresentModeCompatibilityEXT compatibility{.sType = VK_STRUCTURE_TYPE_SURFACE_PRESENT_MODE_COMPATIBILITY_EXT};
+    VkSurfaceCapabilities2KHR modeCapabilities{.sType = VK_STRUCTURE_TYPE_SURFACE_CAPABILITIES_2_KHR, .pNext = &compatibility};
+    NVVK_FAIL_RETURN(vkGetPhysicalDeviceSurfaceCapabilities2KHR(m_physicalDevice, &modeSurfaceInfo, &modeCapabilities));
+    m_compatiblePresentModes.resize(compatibility.presentModeCount);
+    compatibility.pPresentModes = m_compatiblePresentModes.data();
+    NVVK_FAIL_RETURN(vkGetPhysicalDeviceSurfaceCapabilities2KHR(m_physicalDevice, &modeSurfaceInfo, &modeCapabilities));
+
+    for(VkPresentModeKHR mode : m_compatiblePresentModes)
+    {
+      surfacePresentMode.presentMode = mode;
+      VkSurfaceCapabilities2KHR caps{.sType = VK_STRUCTURE_TYPE_SURFACE_CAPABILITIES_2_KHR};
+      NVVK_FAIL_RETURN(vkGetPhysicalDeviceSurfaceCapabilities2KHR(m_physicalDevice, &modeSurfaceInfo, &caps));
+      minImageCount = std::max(minImageCount, caps.surfaceCapabilities.minImageCount);
+    }
+  }
+
   // Set the window size according to the surface's current extent
   outWindowSize = capabilities2.surfaceCapabilities.currentExtent;
-  // Set the number of images in flight, respecting the GPU's maxImageCount limit.
-  // If maxImageCount is equal to 0, then there is no limit other than memory,
-  // so don't change m_maxFramesInFlight.
+  // Set the number of images in flight, respecting the GPU's limits.
+  // If maxImageCount is equal to 0, then there is no limit other than memory.
+  if(m_requestedImageCount > 0)
+  {
+    m_maxFramesInFlight = m_requestedImageCount;
+  }
+  m_maxFramesInFlight = std::max(m_maxFramesInFlight, minImageCount);
   if(capabilities2.surfaceCapabilities.maxImageCount > 0)
   {
     m_maxFramesInFlight = std::min(m_maxFramesInFlight, capabilities2.surfaceCapabilities.maxImageCount);
@@ -93,9 +139,26 @@ VkResult nvvk::Swapchain::initResources(VkExtent2D& outWindowSize, bool vSync)
   // Store the chosen image format
   m_imageFormat = surfaceFormat2.surfaceFormat.format;
 
+  // The latency markers and the driver sleep need the swapchain to opt in
+  const VkSwapchainLatencyCreateInfoNV latencyCreateInfo{
+      .sType             = VK_STRUCTURE_TYPE_SWAPCHAIN_LATENCY_CREATE_INFO_NV,
+      .latencyModeEnable = VK_TRUE,
+  };
+
+  // Present modes that can be switched to without rebuild
+  const VkSwapchainPresentModesCreateInfoEXT presentModesCreateInfo{
+      .sType            = VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_MODES_CREATE_INFO_EXT,
+      .pNext            = m_lowLatency2 ? &latencyCreateInfo : nullptr,
+      .presentModeCount = uint32_t(m_compatiblePresentModes.size()),
+      .pPresentModes    = m_compatiblePresentModes.data(),
+  };
+
   // Create the swapchain itself
   const VkSwapchainCreateInfoKHR swapchainCreateInfo{
       .sType            = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+      .pNext            = !m_compatiblePresentModes.empty() ? static_cast<const void*>(&presentModesCreateInfo) :
+                          m_lowLatency2                     ? &latencyCreateInfo :
+                                                              nullptr,
       .surface          = m_surface,
       .minImageCount    = m_maxFramesInFlight,
       .imageFormat      = surfaceFormat2.surfaceFormat.format,
@@ -112,6 +175,21 @@ VkResult nvvk::Swapchain::initResources(VkExtent2D& outWindowSize, bool vSync)
   NVVK_FAIL_RETURN(vkCreateSwapchainKHR(m_device, &swapchainCreateInfo, nullptr, &m_swapChain));
   NVVK_DBG_NAME(m_swapChain);
 
+  // The sleep mode belongs to the swapchain, re-apply it after a rebuild
+  if(m_lowLatency2)
+  {
+    const VkSemaphoreTypeCreateInfo timelineCreateInfo{
+        .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue  = 0,
+    };
+    const VkSemaphoreCreateInfo semaphoreCreateInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, .pNext = &timelineCreateInfo};
+    NVVK_FAIL_RETURN(vkCreateSemaphore(m_device, &semaphoreCreateInfo, nullptr, &m_latencySemaphore));
+    NVVK_DBG_NAME(m_latencySemaphore);
+    m_latencySleepValue = 0;
+    NVVK_FAIL_RETURN(vkSetLatencySleepModeNV(m_device, m_swapChain, &m_latencySleepMode));
+  }
+
   // Retrieve the swapchain images
   uint32_t imageCount;
   NVVK_FAIL_RETURN(vkGetSwapchainImagesKHR(m_device, m_swapChain, &imageCount, nullptr));
@@ -157,6 +235,12 @@ VkResult nvvk::Swapchain::initResources(VkExtent2D& outWindowSize, bool vSync)
     NVVK_DBG_NAME(m_frameResources[i].imageAvailableSemaphore);
     NVVK_FAIL_RETURN(vkCreateSemaphore(m_device, &semaphoreCreateInfo, nullptr, &m_frameResources[i].renderFinishedSemaphore));
     NVVK_DBG_NAME(m_frameResources[i].renderFinishedSemaphore);
+    if(m_swapchainMaintenance1)
+    {
+      const VkFenceCreateInfo fenceCreateInfo{.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, .flags = VK_FENCE_CREATE_SIGNALED_BIT};
+      NVVK_FAIL_RETURN(vkCreateFence(m_device, &fenceCreateInfo, nullptr, &m_frameResources[i].presentFence));
+      NVVK_DBG_NAME(m_frameResources[i].presentFence);
+    }
   }
 
   // Transition images to present layout
@@ -186,11 +270,30 @@ VkResult nvvk::Swapchain::reinitResources(VkExtent2D& outWindowSize, bool vSync)
 
 void nvvk::Swapchain::deinitResources()
 {
+  // The queue being idle doesn't cover the presentation engine, the fences do
+  if(m_swapchainMaintenance1)
+  {
+    std::vector<VkFence> fences;
+    for(auto& frameRes : m_frameResources)
+    {
+      if(frameRes.presentFence)
+        fences.push_back(frameRes.presentFence);
+    }
+    if(!fences.empty())
+    {
+      // Bounded, a failed present may never signal its fence
+      vkWaitForFences(m_device, uint32_t(fences.size()), fences.data(), VK_TRUE, 1'000'000'000ULL);
+    }
+  }
+
   vkDestroySwapchainKHR(m_device, m_swapChain, nullptr);
+  vkDestroySemaphore(m_device, m_latencySemaphore, nullptr);
+  m_latencySemaphore = VK_NULL_HANDLE;
   for(auto& frameRes : m_frameResources)
   {
     vkDestroySemaphore(m_device, frameRes.imageAvailableSemaphore, nullptr);
     vkDestroySemaphore(m_device, frameRes.renderFinishedSemaphore, nullptr);
+    vkDestroyFence(m_device, frameRes.presentFence, nullptr);
   }
   m_frameResources.clear();
   for(auto& image : m_images)
@@ -209,6 +312,13 @@ VkResult nvvk::Swapchain::acquireNextImage(VkDevice device)
   // that are still in use by previous frames
   auto& frame = m_frameResources[m_frameResourceIndex];
 
+  // The previous present of this frame must have released its semaphores, this is
+  // usually already the case, so it doesn't add latency to the acquire
+  if(frame.presentFence)
+  {
+    NVVK_FAIL_RETURN(vkWaitForFences(device, 1, &frame.presentFence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
+  }
+
   // Acquire the next image from the swapchain
   // This will signal frame.imageAvailableSemaphore when the image is ready
   // and store the index of the acquired image in m_nextImageIndex
@@ -238,9 +348,38 @@ void nvvk::Swapchain::presentFrame(VkQueue queue)
   // associated with the image we just finished rendering
   auto& frame = m_frameResources[m_frameImageIndex];
 
+  // Signaled when the presentation engine is done with this present, waited before the frame is acquired again
+  const VkSwapchainPresentModeInfoEXT presentModeInfo{
+      .sType          = VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_MODE_INFO_EXT,
+      .swapchainCount = 1,
+      .pPresentModes  = &m_presentMode,
+  };
+  const VkFence                        presentFence = m_frameResources[m_frameResourceIndex].presentFence;
+  const VkSwapchainPresentFenceInfoEXT presentFenceInfo{
+      .sType          = VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_FENCE_INFO_EXT,
+      .pNext          = &presentModeInfo,
+      .swapchainCount = 1,
+      .pFences        = &presentFence,
+  };
+  if(presentFence)
+  {
+    vkResetFences(m_device, 1, &presentFence);
+  }
+  const void* presentNext = presentFence ? &presentFenceInfo : nullptr;
+
+  // The id lets vkWaitForPresentKHR and the latency markers refer to this present
+  const uint64_t       presentId = m_presentId + 1;
+  const VkPresentIdKHR presentIdInfo{
+      .sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+      .pNext          = presentNext,
+      .swapchainCount = 1,
+      .pPresentIds    = &presentId,
+  };
+
   // Setup the presentation info, linking the swapchain and the image index
   const VkPresentInfoKHR presentInfo{
       .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+      .pNext              = (m_presentWait || m_lowLatency2) ? &presentIdInfo : presentNext,
       .waitSemaphoreCount = 1,                               // Wait for rendering to finish
       .pWaitSemaphores    = &frame.renderFinishedSemaphore,  // Synchronize presentation
       .swapchainCount     = 1,                               // Swapchain to present the image
@@ -262,6 +401,121 @@ void nvvk::Swapchain::presentFrame(VkQueue queue)
 
   // Advance to the next frame in the swapchain
   m_frameResourceIndex = (m_frameResourceIndex + 1) % m_maxFramesInFlight;
+  m_presentId          = presentId;
+}
+
+void nvvk::Swapchain::setPresentMode(VkPresentModeKHR presentMode)
+{
+  m_requestedPresentMode = presentMode;
+
+  const bool compatible = std::find(m_compatiblePresentModes.begin(), m_compatiblePresentModes.end(), presentMode)
+                          != m_compatiblePresentModes.end();
+  if(compatible)
+  {
+    m_presentMode = presentMode;  // given to the next present
+  }
+  else
+  {
+    m_needRebuild = true;
+  }
+}
+
+void nvvk::Swapchain::setImageCount(uint32_t imageCount)
+{
+  m_requestedImageCount = imageCount;
+  m_maxFramesInFlight   = imageCount > 0 ? imageCount : 3;
+  m_needRebuild         = true;
+}
+
+VkResult nvvk::Swapchain::waitForPresent(uint64_t presentId, uint64_t timeoutNs) const
+{
+  if(!m_presentWait || presentId == 0)
+  {
+    return VK_SUCCESS;
+  }
+  return vkWaitForPresentKHR(m_device, m_swapChain, presentId, timeoutNs);
+}
+
+void nvvk::Swapchain::setLatencySleepMode(bool lowLatencyMode, bool lowLatencyBoost, uint32_t minimumIntervalUs)
+{
+  m_latencySleepMode.lowLatencyMode    = lowLatencyMode ? VK_TRUE : VK_FALSE;
+  m_latencySleepMode.lowLatencyBoost   = lowLatencyBoost ? VK_TRUE : VK_FALSE;
+  m_latencySleepMode.minimumIntervalUs = minimumIntervalUs;
+  if(m_lowLatency2 && m_swapChain)
+  {
+    NVVK_CHECK(vkSetLatencySleepModeNV(m_device, m_swapChain, &m_latencySleepMode));
+  }
+}
+
+void nvvk::Swapchain::latencySleep()
+{
+  if(!m_lowLatency2 || !m_swapChain)
+  {
+    return;
+  }
+
+  // The driver signals the semaphore when the frame should start, the wait happens on the CPU
+  m_latencySleepValue++;
+  const VkLatencySleepInfoNV sleepInfo{
+      .sType           = VK_STRUCTURE_TYPE_LATENCY_SLEEP_INFO_NV,
+      .signalSemaphore = m_latencySemaphore,
+      .value           = m_latencySleepValue,
+  };
+  NVVK_CHECK(vkLatencySleepNV(m_device, m_swapChain, &sleepInfo));
+
+  const VkSemaphoreWaitInfo waitInfo{
+      .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .semaphoreCount = 1,
+      .pSemaphores    = &m_latencySemaphore,
+      .pValues        = &m_latencySleepValue,
+  };
+  vkWaitSemaphores(m_device, &waitInfo, std::numeric_limits<uint64_t>::max());
+}
+
+void nvvk::Swapchain::setLatencyMarker(VkLatencyMarkerNV marker) const
+{
+  if(!m_lowLatency2 || !m_swapChain)
+  {
+    return;
+  }
+
+  const VkSetLatencyMarkerInfoNV markerInfo{
+      .sType     = VK_STRUCTURE_TYPE_SET_LATENCY_MARKER_INFO_NV,
+      .presentID = m_presentId + 1,
+      .marker    = marker,
+  };
+  vkSetLatencyMarkerNV(m_device, m_swapChain, &markerInfo);
+}
+
+bool nvvk::Swapchain::getLatencyTimings(VkLatencyTimingsFrameReportNV& report) const
+{
+  if(!m_lowLatency2 || !m_swapChain)
+  {
+    return false;
+  }
+
+  VkGetLatencyMarkerInfoNV markerInfo{.sType = VK_STRUCTURE_TYPE_GET_LATENCY_MARKER_INFO_NV};
+  vkGetLatencyTimingsNV(m_device, m_swapChain, &markerInfo);
+  if(markerInfo.timingCount == 0)
+  {
+    return false;
+  }
+
+  std::vector<VkLatencyTimingsFrameReportNV> timings(markerInfo.timingCount, {.sType = VK_STRUCTURE_TYPE_LATENCY_TIMINGS_FRAME_REPORT_NV});
+  markerInfo.pTimings = timings.data();
+  vkGetLatencyTimingsNV(m_device, m_swapChain, &markerInfo);
+
+  // The reports are not guaranteed to be sorted, keep the latest complete frame
+  bool found = false;
+  for(uint32_t i = 0; i < markerInfo.timingCount; i++)
+  {
+    if(timings[i].presentEndTimeUs != 0 && (!found || timings[i].presentID > report.presentID))
+    {
+      report = timings[i];
+      found  = true;
+    }
+  }
+  return found;
 }
 
 VkSurfaceFormat2KHR nvvk::Swapchain::selectSwapSurfaceFormat(const std::vector<VkSurfaceFormat2KHR>& availableFormats) const
@@ -34,6 +34,8 @@ namespace nvvk {
  * window size determined during its setup.
  * "Frames in flight" refers to the number of images being processed concurrently (e.g., double buffering = 2, triple buffering = 3).
  * vSync enabled (FIFO mode) uses double buffering, while disabling vSync  (MAILBOX mode) uses triple buffering.
+ * The present mode can also be chosen explicitly (`InitInfo::presentMode`, `setPresentMode`), as well as the
+ * number of images (`InitInfo::imageCount`, `setImageCount`).
  *
  * The "current frame" is the frame currently being processed.
  * The "next image index" points to the swapchain image that will be rendered next, which might differ from the current frame's index.
@@ -66,6 +68,16 @@ public:
     VkCommandPool    cmdPool{};
     VkPresentModeKHR preferredVsyncOffMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
     VkPresentModeKHR preferredVsyncOnMode  = VK_PRESENT_MODE_FIFO_KHR;
+    // The device extensions must have been enabled by the caller
+    bool presentWait = false;  // VK_KHR_present_id + VK_KHR_present_wait: tag presents with an id that can be waited on
+    bool lowLatency2 = false;  // VK_NV_low_latency2 (+ VK_KHR_present_id): driver frame pacing and latency markers
+    // VK_EXT_swapchain_maintenance1 (+ instance VK_EXT_surface_maintenance1): present fences release the resources
+    // of a present as soon as it is done, and present modes can be switched without rebuilding the swapchain
+    bool swapchainMaintenance1 = false;
+    // Explicit present mode, used instead of the vSync based selection when supported
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAX_ENUM_KHR;
+    // Number of swapchain images, clamped to the surface limits. 0 uses the default (3)
+    uint32_t imageCount = 0;
   };
 
   // Initialize the swapchain with the provided context and surface, then we can create and re-create it
@@ -106,6 +118,43 @@ public:
   -*/
   void presentFrame(VkQueue queue);
 
+  /*--
+   * Present ids are only given to the driver when `presentWait` or `lowLatency2` was set at init.
+   * The id of the last presented frame is 0 before the first present, the id of the frame being
+   * recorded is `getPresentId() + 1`.
+  -*/
+  /*--
+   * Explicit present mode (FIFO, FIFO_RELAXED, MAILBOX, IMMEDIATE), VK_PRESENT_MODE_MAX_ENUM_KHR goes back to the
+   * vSync based selection. With `swapchainMaintenance1`, a mode compatible with the current one is applied at the
+   * next present, otherwise the swapchain is rebuilt. Unsupported modes fall back to the vSync based selection.
+  -*/
+  void                                 setPresentMode(VkPresentModeKHR presentMode);
+  VkPresentModeKHR                     getPresentMode() const { return m_presentMode; }  // Mode of the next present
+  const std::vector<VkPresentModeKHR>& getSupportedPresentModes() const { return m_supportedPresentModes; }
+
+  // Number of swapchain images to request, applied by rebuilding the swapchain (0 uses the default)
+  void setImageCount(uint32_t imageCount);
+
+  bool     hasSwapchainMaintenance1() const { return m_swapchainMaintenance1; }
+  bool     hasPresentWait() const { return m_presentWait; }
+  bool     hasLowLatency2() const { return m_lowLatency2; }
+  uint64_t getPresentId() const { return m_presentId; }
+
+  // Block until the present with `presentId` is displayed, returns VK_TIMEOUT when `timeoutNs` elapsed first
+  VkResult waitForPresent(uint64_t presentId, uint64_t timeoutNs) const;
+
+  /*--
+   * VK_NV_low_latency2, these do nothing when `lowLatency2` was not set at init.
+   * The sleep mode is kept across swapchain rebuilds. latencySleep() blocks the calling thread
+   * until the driver wants the next frame to start, and must be called once per frame before
+   * sampling the input. Markers are attached to the frame being recorded.
+  -*/
+  void setLatencySleepMode(bool lowLatencyMode, bool lowLatencyBoost = false, uint32_t minimumIntervalUs = 0);
+  void latencySleep();
+  void setLatencyMarker(VkLatencyMarkerNV marker) const;
+  // Returns the most recent frame report of the driver, false if none is available yet
+  bool getLatencyTimings(VkLatencyTimingsFrameReportNV& report) const;
+
 
 private:
   // Represents an image within the swapchain that can be rendered to.
@@ -122,6 +171,7 @@ private:
   {
     VkSemaphore imageAvailableSemaphore{};  // Signals when the image is ready for rendering
     VkSemaphore renderFinishedSemaphore{};  // Signals when rendering is finished
+    VkFence     presentFence{};  // Signaled when the last present of this frame released its resources (swapchainMaintenance1)
   };
 
   // We choose the format that is the most common, and that is supported by* the physical device.
@@ -157,9 +207,25 @@ private:
   uint32_t                    m_frameImageIndex    = 0;  // Index of the swapchain image we're currently rendering to
   bool                        m_needRebuild        = false;  // Flag indicating if the swapchain needs to be rebuilt
 
+  // Present id and low latency
+  bool                     m_presentWait       = false;  // Presents are tagged with m_presentId
+  bool                     m_lowLatency2       = false;  // The swapchain is created with the latency mode enabled
+  uint64_t                 m_presentId         = 0;      // Id of the last present
+  VkSemaphore              m_latencySemaphore  = {};     // Timeline semaphore signaled by vkLatencySleepNV
+  uint64_t                 m_latencySleepValue = 0;      // Last value waited on m_latencySemaphore
+  VkLatencySleepModeInfoNV m_latencySleepMode{.sType = VK_STRUCTURE_TYPE_LATENCY_SLEEP_MODE_INFO_NV};
+
   VkPresentModeKHR m_preferredVsyncOffMode = VK_PRESENT_MODE_IMMEDIATE_KHR;  // used if available
   VkPresentModeKHR m_preferredVsyncOnMode  = VK_PRESENT_MODE_FIFO_KHR;       // used if available
 
+  // Present modes
+  bool                          m_swapchainMaintenance1 = false;
+  VkPresentModeKHR              m_requestedPresentMode  = VK_PRESENT_MODE_MAX_ENUM_KHR;  // explicit mode, if any
+  VkPresentModeKHR              m_presentMode           = VK_PRESENT_MODE_FIFO_KHR;      // mode given to the next present
+  std::vector<VkPresentModeKHR> m_supportedPresentModes;   // by the surface
+  std::vector<VkPresentModeKHR> m_compatiblePresentModes;  // can be switched to without rebuild (swapchainMaintenance1)
+  uint32_t                      m_requestedImageCount = 0;
+
   // Triple buffering allows us to pipeline CPU and GPU work, which gives us
   // good throughput if their sum takes more than a frame.
   // But if we're using VK_PRESENT_MODE_FIFO_KHR without frame pacing and
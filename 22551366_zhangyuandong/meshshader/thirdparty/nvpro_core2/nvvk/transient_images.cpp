@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+
+#include "transient_images.hpp"
+#include "barriers.hpp"
+#include "check_error.hpp"
+#include "debug_util.hpp"
+
+void nvvk::TransientImageAllocator::init(ResourceAllocator* allocator)
+{
+  assert(m_allocator == nullptr && "Missing deinit()");
+  m_allocator = allocator;
+}
+
+void nvvk::TransientImageAllocator::deinit()
+{
+  if(!m_allocator)
+    return;
+
+  destroyImages();
+  m_entries.clear();
+  m_allocator = nullptr;
+}
+
+uint32_t nvvk::TransientImageAllocator::addImage(const VkImageCreateInfo&     imageInfo,
+                                                 const VkImageViewCreateInfo& viewInfo,
+                                                 uint32_t                     firstPass,
+                                                 uint32_t                     lastPass,
+                                                 const std::string&           debugName)
+{
+  assert(firstPass <= lastPass);
+
+  Entry entry;
+  entry.imageInfo = imageInfo;
+  entry.viewInfo  = viewInfo;
+  entry.firstPass = firstPass;
+  entry.lastPass  = lastPass;
+  entry.debugName = debugName;
+  m_entries.push_back(std::move(entry));
+
+  return uint32_t(m_entries.size() - 1);
+}
+
+VkResult nvvk::TransientImageAllocator::createView(Entry& entry)
+{
+  VkDevice device = m_allocator->getDevice();
+
+  entry.image.extent                 = entry.imageInfo.extent;
+  entry.image.mipLevels              = entry.imageInfo.mipLevels;
+  entry.image.arrayLayers            = entry.imageInfo.arrayLayers;
+  entry.image.format                 = entry.imageInfo.format;
+  entry.image.descriptor.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  VkImageViewCreateInfo viewInfo = entry.viewInfo;
+  viewInfo.image                 = entry.image.image;
+  NVVK_FAIL_RETURN(vkCreateImageView(device, &viewInfo, nullptr, &entry.image.descriptor.imageView));
+
+  if(!entry.debugName.empty())
+  {
+    nvvk::DebugUtil& dutil = nvvk::DebugUtil::getInstance();
+    dutil.setObjectName(entry.image.image, entry.debugName);
+    dutil.setObjectName(entry.image.descriptor.imageView, entry.debugName);
+  }
+  return VK_SUCCESS;
+}
+
+VkResult nvvk::TransientImageAllocator::createDedicated(Entry& entry, VmaMemoryUsage memoryUsage)
+{
+  // not through `ResourceAllocator::createImage`, it adds TRANSFER_DST which transient attachments can't have
+  const VmaAllocationCreateInfo allocInfo{.usage = memoryUsage};
+  VmaAllocationInfo             allocInfoOut{};
+  VkResult result = vmaCreateImage(*m_allocator, &entry.imageInfo, &allocInfo, &entry.image.image, &entry.image.allocation, &allocInfoOut);
+  if(result != VK_SUCCESS)
+  {
+    entry.image = {};
+    return result;
+  }
+
+  entry.aliased = false;
+  m_report.dedicatedSize += allocInfoOut.size;
+  return createView(entry);
+}
+
+VkResult nvvk::TransientImageAllocator::build()
+{
+  assert(m_memory == nullptr && "Missing destroyImages()");
+
+  VkDevice device = m_allocator->getDevice();
+  m_report        = {};
+
+  std::vector<uint32_t>             aliased;
+  std::vector<VkMemoryRequirements> memReqs(m_entries.size());
+
+  for(uint32_t i = 0; i < uint32_t(m_entries.size()); i++)
+  {
+    Entry& entry = m_entries[i];
+
+    // tiled GPUs: render targets that never leave the tile memory
+    if(entry.imageInfo.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+    {
+      VkResult result = createDedicated(entry, VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED);
+      if(result == VK_SUCCESS)
+      {
+        continue;
+      }
+      if(result != VK_ERROR_FEATURE_NOT_PRESENT)  // no lazily allocated memory type
+      {
+        return result;
+      }
+    }
+
+    NVVK_FAIL_RETURN(vkCreateImage(device, &entry.imageInfo, nullptr, &entry.image.image));
+    vkGetImageMemoryRequirements(device, entry.image.image, &memReqs[i]);
+    entry.aliased = true;
+    aliased.push_back(i);
+  }
+
+  // place the largest images first, each at the lowest offset not used by an image live in the same passes
+  std::sort(aliased.begin(), aliased.end(), [&](uint32_t a, uint32_t b) { return memReqs[a].size > memReqs[b].size; });
+
+  VkMemoryRequirements  totalReqs{.size = 0, .alignment = 1, .memoryTypeBits = ~0U};
+  std::vector<uint32_t> placed;
+  for(uint32_t index : aliased)
+  {
+    Entry&                      entry = m_entries[index];
+    const VkMemoryRequirements& req   = memReqs[index];
+
+    // memory types must be compatible with all images of the allocation
+    if((totalReqs.memoryTypeBits & req.memoryTypeBits) == 0)
+    {
+      vkDestroyImage(device, entry.image.image, nullptr);
+      entry.image = {};
+      NVVK_FAIL_RETURN(createDedicated(entry, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE));
+      continue;
+    }
+
+    std::vector<uint32_t> conflicts;
+    for(uint32_t other : placed)
+    {
+      const Entry& otherEntry = m_entries[other];
+      if(otherEntry.firstPass <= entry.lastPass && entry.firstPass <= otherEntry.lastPass)
+      {
+        conflicts.push_back(other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(), [&](uint32_t a, uint32_t b) { return m_entries[a].offset < m_entries[b].offset; });
+
+    VkDeviceSize offset = 0;
+    for(uint32_t other : conflicts)
+    {
+      offset = (offset + req.alignment - 1) / req.alignment * req.alignment;
+      if(offset + req.size <= m_entries[other].offset)
+      {
+        break;
+      }
+      offset = std::max(offset, m_entries[other].offset + memReqs[other].size);
+    }
+    offset = (offset + req.alignment - 1) / req.alignment * req.alignment;
+
+    entry.offset = offset;
+    placed.push_back(index);
+
+    totalReqs.size      = std::max(totalReqs.size, offset + req.size);
+    totalReqs.alignment = std::max(totalReqs.alignment, req.alignment);
+    totalReqs.memoryTypeBits &= req.memoryTypeBits;
+    m_report.unaliasedSize += req.size;
+  }
+
+  if(placed.empty())
+  {
+    return VK_SUCCESS;
+  }
+
+  const VmaAllocationCreateInfo allocInfo{.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+  NVVK_FAIL_RETURN(vmaAllocateMemory(*m_allocator, &totalReqs, &allocInfo, &m_memory, nullptr));
+  m_report.aliasedSize = totalReqs.size;
+
+  for(uint32_t index : placed)
+  {
+    Entry& entry = m_entries[index];
+    NVVK_FAIL_RETURN(vmaBindImageMemory2(*m_allocator, m_memory, entry.offset, entry.image.image, nullptr));
+    NVVK_FAIL_RETURN(createView(entry));
+  }
+
+  return VK_SUCCESS;
+}
+
+void nvvk::TransientImageAllocator::destroyImages()
+{
+  VkDevice device = m_allocator->getDevice();
+
+  for(Entry& entry : m_entries)
+  {
+    vkDestroyImageView(device, entry.image.descriptor.imageView, nullptr);
+    if(entry.aliased)
+    {
+      vkDestroyImage(device, entry.image.image, nullptr);
+    }
+    else
+    {
+      vmaDestroyImage(*m_allocator, entry.image.image, entry.image.allocation);
+    }
+    entry.image   = {};
+    entry.offset  = 0;
+    entry.aliased = false;
+  }
+
+  if(m_memory)
+  {
+    vmaFreeMemory(*m_allocator, m_memory);
+    m_memory = nullptr;
+  }
+  m_report = {};
+}
+
+VkImageMemoryBarrier2 nvvk::TransientImageAllocator::makeFirstUseBarrier(uint32_t              index,
+                                                                         VkImageLayout         newLayout,
+                                                                         VkPipelineStageFlags2 dstStageMask) const
+{
+  // the previous image in this memory may still be written to
+  return nvvk::makeImageMemoryBarrier({
+      .image            = m_entries[index].image.image,
+      .oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED,
+      .newLayout        = newLayout,
+      .subresourceRange = m_entries[index].viewInfo.subresourceRange,
+      .srcStageMask     = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+      .dstStageMask     = dstStageMask,
+      .srcAccessMask    = VK_ACCESS_2_MEMORY_WRITE_BIT,
+  });
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Usage example
+//--------------------------------------------------------------------------------------------------
+[[maybe_unused]] static void usage_TransientImageAllocator()
+{
+  nvvk::ResourceAllocator allocator;  // EX: initialized somewhere
+  VkExtent2D              size{1920, 1080};
+
+  // passes of the frame: 0 shadow, 1 lighting, 2 bloom down, 3 bloom up, 4 tonemap
+  nvvk::TransientImageAllocator transients;
+  transients.init(&allocator);
+
+  VkImageCreateInfo imageInfo{
+      .sType       = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .imageType   = VK_IMAGE_TYPE_2D,
+      .format      = VK_FORMAT_D32_SFLOAT,
+      .extent      = {2048, 2048, 1},
+      .mipLevels   = 1,
+      .arrayLayers = 1,
+      .samples     = VK_SAMPLE_COUNT_1_BIT,
+      .usage       = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+  };
+  VkImageViewCreateInfo viewInfo{
+      .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+      .format           = imageInfo.format,
+      .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT, .levelCount = 1, .layerCount = 1},
+  };
+  uint32_t shadowMap = transients.addImage(imageInfo, viewInfo, 0, 1, "ShadowMap");
+
+  // the bloom targets are only live after lighting: they reuse the shadow map memory
+  imageInfo.format                     = VK_FORMAT_R16G16B16A16_SFLOAT;
+  imageInfo.extent                     = {size.width / 2, size.height / 2, 1};
+  imageInfo.usage                      = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  viewInfo.format                      = imageInfo.format;
+  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  [[maybe_unused]] uint32_t bloomDown  = transients.addImage(imageInfo, viewInfo, 2, 3, "BloomDown");
+  [[maybe_unused]] uint32_t bloomUp    = transients.addImage(imageInfo, viewInfo, 3, 4, "BloomUp");
+
+  NVVK_CHECK(transients.build());
+
+  // each frame, at the start of the shadow pass
+  VkCommandBuffer       cmd{};
+  VkImageMemoryBarrier2 barrier = transients.makeFirstUseBarrier(shadowMap, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+                                                                 VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT);
+  const VkDependencyInfo depInfo{.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &barrier};
+  vkCmdPipelineBarrier2(cmd, &depInfo);
+
+  // on resize
+  transients.destroyImages();
+  // transients.setExtent(bloomDown, ...), transients.setExtent(bloomUp, ...)
+  NVVK_CHECK(transients.build());
+
+  transients.deinit();
+}
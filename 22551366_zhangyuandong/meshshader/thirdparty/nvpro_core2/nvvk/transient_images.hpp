@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include "resource_allocator.hpp"
+
+namespace nvvk {
+
+//-----------------------------------------------------------------
+// Transient images are render targets that only live within a range of passes of a frame
+// (intermediate targets, shadow maps, blur ping-pong ...).
+// Images whose pass ranges don't overlap share the same memory, so the footprint is the
+// peak of the concurrently live images rather than their sum.
+//
+// - Images with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT use lazily allocated memory when the
+//   device has it (tiled GPUs), which may never be backed by physical memory.
+// - The content of an aliased image is undefined at its first pass: transition it from
+//   VK_IMAGE_LAYOUT_UNDEFINED with `makeFirstUseBarrier`, which also waits for the previous user of the memory.
+// - Images that are persistent across frames (e.g. accumulation, or displayed by the UI like `nvvk::GBuffer`)
+//   must not be declared here.
+//
+// Usage:
+//      see usage_TransientImageAllocator in transient_images.cpp
+//-----------------------------------------------------------------
+class TransientImageAllocator
+{
+public:
+  TransientImageAllocator() = default;
+  ~TransientImageAllocator() { assert(m_allocator == nullptr && "Missing deinit()"); }
+
+  TransientImageAllocator(const TransientImageAllocator&)            = delete;
+  TransientImageAllocator& operator=(const TransientImageAllocator&) = delete;
+
+  void init(ResourceAllocator* allocator);
+  // destroys the images and their declarations
+  void deinit();
+
+  // Declares an image used from pass `firstPass` to `lastPass` (inclusive), returns its index.
+  // The pass indices are arbitrary, only their order matters.
+  // `viewInfo.image` is filled in `build`.
+  uint32_t addImage(const VkImageCreateInfo&     imageInfo,
+                    const VkImageViewCreateInfo& viewInfo,
+                    uint32_t                     firstPass,
+                    uint32_t                     lastPass,
+                    const std::string&           debugName = {});
+
+  // Creates all the declared images, placing the aliased ones in a single allocation
+  VkResult build();
+
+  // Destroys the images but keeps the declarations, e.g. to change extents with `setExtent` and `build` again
+  void destroyImages();
+
+  void setExtent(uint32_t index, VkExtent3D extent) { m_entries[index].imageInfo.extent = extent; }
+
+  const Image& getImage(uint32_t index) const { return m_entries[index].image; }
+
+  // Barrier for the start of the image's first pass, discards the content left by the previous user of the memory
+  VkImageMemoryBarrier2 makeFirstUseBarrier(uint32_t              index,
+                                            VkImageLayout         newLayout,
+                                            VkPipelineStageFlags2 dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) const;
+
+  struct Report
+  {
+    // memory of the shared allocation
+    VkDeviceSize aliasedSize{};
+    // sum of the image sizes in the shared allocation, what it would cost without aliasing
+    VkDeviceSize unaliasedSize{};
+    // images with their own allocation (lazily allocated ones or incompatible memory types)
+    VkDeviceSize dedicatedSize{};
+  };
+  Report getReport() const { return m_report; }
+
+protected:
+  struct Entry
+  {
+    VkImageCreateInfo     imageInfo{};
+    VkImageViewCreateInfo viewInfo{};
+    uint32_t              firstPass{};
+    uint32_t              lastPass{};
+    std::string           debugName;
+
+    Image        image;
+    VkDeviceSize offset = 0;
+    bool         aliased{};  // bound to m_memory, else owns `image.allocation`
+  };
+
+  VkResult createDedicated(Entry& entry, VmaMemoryUsage memoryUsage);
+  VkResult createView(Entry& entry);
+
+  ResourceAllocator* m_allocator{};
+  std::vector<Entry> m_entries;
+  VmaAllocation      m_memory{};
+  Report             m_report;
+};
+
+}  // namespace nvvk
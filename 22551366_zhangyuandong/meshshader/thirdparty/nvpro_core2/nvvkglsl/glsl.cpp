@@ -17,6 +17,13 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 #include <volk.h>
 #include <nvutils/logger.hpp>
 #include <nvutils/file_operations.hpp>
@@ -25,13 +32,89 @@
 
 #include "glsl.hpp"
 
+// FNV-1a, stable between runs and builds so the cache keys are too
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for(size_t i = 0; i < size; i++)
+  {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static uint64_t hashString(uint64_t hash, const std::string& str)
+{
+  const uint64_t length = str.size();
+  hash                  = hashBytes(hash, &length, sizeof(length));
+  return hashBytes(hash, str.data(), str.size());
+}
+
+static constexpr uint64_t kHashSeed         = 0xcbf29ce484222325ull;
+static constexpr uint32_t kCacheMagic       = 0x56505347;  // "GSPV"
+static constexpr uint32_t kCacheFileVersion = 1;
+
+
+// Files are read again only when their modification time changed
+class nvvkglsl::GlslCompiler::FileCache
+{
+public:
+  std::string load(const std::filesystem::path& filename)
+  {
+    std::error_code error;
+    const auto      writeTime = std::filesystem::last_write_time(filename, error);
+    if(error)
+    {
+      return nvutils::loadFile(filename);
+    }
+
+    {
+      std::lock_guard lock(m_mutex);
+      auto            it = m_files.find(filename);
+      if(it != m_files.end() && it->second.writeTime == writeTime)
+      {
+        return it->second.content;
+      }
+    }
+
+    // Read outside of the lock, concurrent compilations may load other files
+    std::string     content = nvutils::loadFile(filename);
+    std::lock_guard lock(m_mutex);
+    m_files[filename] = {content, writeTime};
+    return content;
+  }
+
+  void clear()
+  {
+    std::lock_guard lock(m_mutex);
+    m_files.clear();
+  }
+
+private:
+  struct File
+  {
+    std::string                     content;
+    std::filesystem::file_time_type writeTime;
+  };
+
+  struct PathHash
+  {
+    size_t operator()(const std::filesystem::path& path) const { return std::filesystem::hash_value(path); }
+  };
+
+  std::mutex                                                m_mutex;
+  std::unordered_map<std::filesystem::path, File, PathHash> m_files;
+};
+
 
 // Implementation of the libshaderc includer interface.
 class GlslIncluder : public shaderc::CompileOptions::IncluderInterface
 {
 public:
-  GlslIncluder(const std::vector<std::filesystem::path>& searchPaths)
+  // Options copied for the threads of a batch keep using this includer: it must be thread-safe
+  GlslIncluder(const std::vector<std::filesystem::path>& searchPaths, std::shared_ptr<nvvkglsl::GlslCompiler::FileCache> fileCache)
       : m_searchPaths(searchPaths)
+      , m_fileCache(std::move(fileCache))
   {
   }
 
@@ -79,7 +162,7 @@ public:
     }
     else
     {
-      src_code = nvutils::loadFile(find_name);
+      src_code = m_fileCache->load(find_name);
     }
     return new IncludeResult(src_code, nvutils::utf8FromPath(find_name));
   }
@@ -87,11 +170,13 @@ public:
   // Handles shaderc_include_result_release_fn callbacks.
   void ReleaseInclude(shaderc_include_result* data) override { delete static_cast<IncludeResult*>(data); };
 
-  const std::vector<std::filesystem::path>& m_searchPaths;
+  const std::vector<std::filesystem::path>&            m_searchPaths;
+  std::shared_ptr<nvvkglsl::GlslCompiler::FileCache> m_fileCache;
 };
 
 
 nvvkglsl::GlslCompiler::GlslCompiler()
+    : m_fileCache(std::make_shared<FileCache>())
 {
   m_compilerOptions = std::move(makeOptions());
 }
@@ -105,7 +190,7 @@ void nvvkglsl::GlslCompiler::addSearchPaths(const std::vector<std::filesystem::p
 std::unique_ptr<shaderc::CompileOptions> nvvkglsl::GlslCompiler::makeOptions()
 {
   std::unique_ptr<shaderc::CompileOptions> options = std::make_unique<shaderc::CompileOptions>();
-  options->SetIncluder(std::make_unique<GlslIncluder>(m_searchPaths));
+  options->SetIncluder(std::make_unique<GlslIncluder>(m_searchPaths, m_fileCache));
   options->AddMacroDefinition("__GLSL__", "1");
   return options;
 }
@@ -117,7 +202,7 @@ shaderc::SpvCompilationResult nvvkglsl::GlslCompiler::compileFile(const std::fil
   std::filesystem::path sourceFile = nvutils::findFile(filename, m_searchPaths);
   if(sourceFile.empty())
     return {};
-  std::string                   sourceCode = nvutils::loadFile(sourceFile);
+  std::string                   sourceCode = m_fileCache->load(sourceFile);
   shaderc::SpvCompilationResult compResult =
       CompileGlslToSpv(sourceCode, shader_kind, nvutils::utf8FromPath(sourceFile.filename()).c_str(),
                        overrideOptions ? *overrideOptions : *m_compilerOptions);
@@ -133,6 +218,189 @@ shaderc::SpvCompilationResult nvvkglsl::GlslCompiler::compileFile(const std::fil
 }
 
 
+std::vector<nvvkglsl::GlslCompiler::BatchResult> nvvkglsl::GlslCompiler::compileBatch(std::span<const BatchRequest> requests,
+                                                                                     uint32_t numThreads)
+{
+  std::vector<BatchResult> results(requests.size());
+  if(requests.empty())
+  {
+    return results;
+  }
+  if(numThreads == 0)
+  {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = std::min(numThreads, uint32_t(requests.size()));
+
+  auto compileRequest = [&](const BatchRequest& request, BatchResult& result) {
+    const std::filesystem::path sourceFile = nvutils::findFile(request.filename, m_searchPaths);
+    if(sourceFile.empty())
+    {
+      result.diagnostics = "File not found: " + nvutils::utf8FromPath(request.filename);
+      LOGW("%s\n", result.diagnostics.c_str());
+      return;
+    }
+    const std::string sourceCode = m_fileCache->load(sourceFile);
+    const std::string sourceName = nvutils::utf8FromPath(sourceFile.filename());
+
+    // The copy shares the includer, and the file cache with it
+    shaderc::CompileOptions options(*m_compilerOptions);
+    for(const auto& macro : request.macros)
+    {
+      options.AddMacroDefinition(macro.first, macro.second);
+    }
+
+    // The preprocessed source has the includes and the macros expanded, an edit of any of them changes the key
+    uint64_t cacheKey = 0;
+    if(!m_cacheDirectory.empty())
+    {
+      shaderc::PreprocessedSourceCompilationResult preprocessed =
+          PreprocessGlsl(sourceCode, request.shaderKind, sourceName.c_str(), options);
+      if(preprocessed.GetCompilationStatus() != shaderc_compilation_status_success)
+      {
+        result.diagnostics = preprocessed.GetErrorMessage();
+        LOGW("Shader compilation error: %s\n", result.diagnostics.c_str());
+        return;
+      }
+      cacheKey = getCacheKey(std::string(preprocessed.begin(), preprocessed.end()), request.shaderKind);
+      if(loadFromCache(cacheKey, result.spirv))
+      {
+        result.success   = true;
+        result.fromCache = true;
+      }
+    }
+
+    if(!result.success)
+    {
+      shaderc::SpvCompilationResult compResult = CompileGlslToSpv(sourceCode, request.shaderKind, sourceName.c_str(), options);
+      result.diagnostics                       = compResult.GetErrorMessage();
+      if(compResult.GetCompilationStatus() != shaderc_compilation_status_success)
+      {
+        LOGW("Shader compilation error: %s\n", result.diagnostics.c_str());
+        return;
+      }
+      result.success = true;
+      result.spirv.assign(compResult.begin(), compResult.end());
+      if(!m_cacheDirectory.empty())
+      {
+        saveToCache(cacheKey, result.spirv);
+      }
+    }
+
+    if(m_callback)
+    {
+      m_callback(sourceFile, result.spirv.data(), result.spirv.size() * sizeof(uint32_t));
+    }
+  };
+
+  // Each thread pulls the next request, the stages can have very different compile times
+  std::atomic<size_t> nextRequest{0};
+  auto                compileRequests = [&]() {
+    for(size_t i = nextRequest++; i < requests.size(); i = nextRequest++)
+    {
+      compileRequest(requests[i], results[i]);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for(uint32_t t = 1; t < numThreads; t++)
+  {
+    threads.emplace_back(compileRequests);
+  }
+  compileRequests();
+  for(std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  return results;
+}
+
+void nvvkglsl::GlslCompiler::clearIncludeCache()
+{
+  m_fileCache->clear();
+}
+
+uint64_t nvvkglsl::GlslCompiler::getCacheKey(const std::string& preprocessedSource, shaderc_shader_kind shaderKind) const
+{
+  uint64_t hash = hashBytes(kHashSeed, &kCacheFileVersion, sizeof(kCacheFileVersion));
+  hash          = hashBytes(hash, &shaderKind, sizeof(shaderKind));
+  hash          = hashString(hash, m_optionsKey);
+  hash          = hashString(hash, m_cacheTag);
+  hash          = hashString(hash, preprocessedSource);
+  return hash;
+}
+
+std::filesystem::path nvvkglsl::GlslCompiler::getCacheFilename(uint64_t cacheKey) const
+{
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.glslcache", static_cast<unsigned long long>(cacheKey));
+  return m_cacheDirectory / name;
+}
+
+// Cache entry:
+//   uint32_t magic, version
+//   uint64_t SPIR-V size in bytes, SPIR-V
+bool nvvkglsl::GlslCompiler::loadFromCache(uint64_t cacheKey, std::vector<uint32_t>& spirv) const
+{
+  std::ifstream file(getCacheFilename(cacheKey), std::ios::binary);
+  if(!file)
+  {
+    return false;
+  }
+
+  auto read = [&file](auto& value) { return bool(file.read(reinterpret_cast<char*>(&value), sizeof(value))); };
+
+  uint32_t magic = 0, version = 0;
+  uint64_t spirvSize = 0;
+  if(!read(magic) || !read(version) || magic != kCacheMagic || version != kCacheFileVersion || !read(spirvSize)
+     || spirvSize == 0 || spirvSize % sizeof(uint32_t) != 0)
+  {
+    return false;
+  }
+  spirv.resize(spirvSize / sizeof(uint32_t));
+  if(!file.read(reinterpret_cast<char*>(spirv.data()), spirvSize))
+  {
+    spirv.clear();
+    return false;
+  }
+  return true;
+}
+
+void nvvkglsl::GlslCompiler::saveToCache(uint64_t cacheKey, std::span<const uint32_t> spirv) const
+{
+  std::error_code error;
+  std::filesystem::create_directories(m_cacheDirectory, error);
+
+  // Write to a temporary file first, so concurrent runs never read a partial entry
+  const std::filesystem::path filename     = getCacheFilename(cacheKey);
+  std::filesystem::path       tempFilename = filename;
+  tempFilename += ".tmp";
+  {
+    std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+      LOGW("Cannot write the shader cache entry %s\n", nvutils::utf8FromPath(tempFilename).c_str());
+      return;
+    }
+
+    auto write = [&file](const auto& value) { file.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    write(kCacheMagic);
+    write(kCacheFileVersion);
+    write(uint64_t(spirv.size_bytes()));
+    file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size_bytes());
+    if(!file)
+    {
+      return;
+    }
+  }
+  std::filesystem::rename(tempFilename, filename, error);
+  if(error)
+  {
+    std::filesystem::remove(tempFilename, error);
+  }
+}
+
 bool nvvkglsl::GlslCompiler::isValid(const shaderc::SpvCompilationResult& compResult)
 {
   if(compResult.GetCompilationStatus() != shaderc_compilation_status_success)
@@ -178,4 +446,20 @@ bool nvvkglsl::GlslCompiler::isValid(const shaderc::SpvCompilationResult& compRe
   VkShaderEXT computeShader{};  // The compute shader
   VkDevice    device = nullptr;
   NVVK_CHECK(vkCreateShadersEXT(device, 1, &shaderCreateInfos, NULL, &computeShader));
+
+  // The stages of a pipeline compiled in parallel, unchanged ones are loaded from the disk cache
+  glslCompiler.setCacheDirectory(exePath / "shader_cache");
+  const nvvkglsl::GlslCompiler::BatchRequest requests[] = {
+      {"shader.task.glsl", shaderc_glsl_task_shader},
+      {"shader.mesh.glsl", shaderc_glsl_mesh_shader, {{"MESH_WORKGROUP_SIZE", "64"}}},
+      {"shader.frag.glsl", shaderc_glsl_fragment_shader},
+  };
+  std::vector<nvvkglsl::GlslCompiler::BatchResult> results = glslCompiler.compileBatch(requests);
+  for(const nvvkglsl::GlslCompiler::BatchResult& result : results)
+  {
+    if(!result.success)
+    {
+      LOGE("Compilation failed: %s\n", result.diagnostics.c_str());
+    }
+  }
 }
@@ -22,6 +22,10 @@
 
 >  This class is a wrapper around the shaderc compiler to help compiling GLSL to Spir-V using Shaderc
 
+- Source and include files are read once and kept in memory, a file is read again when its
+  modification time changes. Reloading shaders only reads the edited files.
+- `compileBatch` compiles independent shaders (e.g. the stages of a pipeline) in parallel,
+  and uses the SPIR-V disk cache when `setCacheDirectory` was called.
 
 Example: 
     see usage_GlslCompiler() in glsl.cpp
@@ -35,6 +39,9 @@ Example:
 #include <functional>
 #include <memory>
 #include <span>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <shaderc/shaderc.hpp>
 #include <vulkan/vulkan_core.h>
@@ -92,7 +99,11 @@ public:
   // Accesses the Shaderc compile options. You can use this for preprocessor macros,
   // for instance; see the code sample.
   shaderc::CompileOptions& options() { return *m_compilerOptions; }
-  void                     clearOptions() { m_compilerOptions = makeOptions(); }
+  void                     clearOptions()
+  {
+    m_compilerOptions = makeOptions();
+    m_optionsKey.clear();
+  }
 
   // Compiles a GLSL shader to SPIR-V. The file is found using the given
   // filename and include paths. `shaderKind` must be the correct type
@@ -134,6 +145,38 @@ public:
 
   static bool isValid(const shaderc::SpvCompilationResult& compResult);
 
+  // One shader of a batch compilation: the macros are added to the compile options
+  struct BatchRequest
+  {
+    std::filesystem::path                            filename;
+    shaderc_shader_kind                              shaderKind = shaderc_glsl_infer_from_source;
+    std::vector<std::pair<std::string, std::string>> macros;
+  };
+
+  struct BatchResult
+  {
+    bool                  success   = false;
+    bool                  fromCache = false;
+    std::vector<uint32_t> spirv;
+    std::string           diagnostics;
+  };
+
+  // Compiles the requests in parallel on `numThreads` threads (0 uses all hardware threads), in the order of the requests.
+  // The shaderc compiler is shared by the threads, each compilation gets its own copy of the options.
+  // The compile callback is called from the compiling threads.
+  std::vector<BatchResult> compileBatch(std::span<const BatchRequest> requests, uint32_t numThreads = 0);
+
+  // SPIR-V disk cache of `compileBatch`, disabled when empty (default).
+  // Entries are named by a hash of the preprocessed source, which covers the included files and the macros,
+  // the shader kind and the options set with defaultTarget/defaultOptions. Options set directly on `options()`
+  // aren't visible: describe them with `setCacheTag` so the entries of different options don't mix.
+  void                         setCacheDirectory(const std::filesystem::path& directory) { m_cacheDirectory = directory; }
+  const std::filesystem::path& getCacheDirectory() const { return m_cacheDirectory; }
+  void                         setCacheTag(const std::string& tag) { m_cacheTag = tag; }
+
+  // Drops the file contents kept in memory
+  void clearIncludeCache();
+
 
   // The compile callback is called on every successful compilation with the
   // input file and its SPIR-V result. You can use this, for instance,
@@ -148,6 +191,7 @@ public:
   {
     m_compilerOptions->SetTargetSpirv(shaderc_spirv_version::shaderc_spirv_version_1_6);
     m_compilerOptions->SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_4);
+    m_optionsKey += "spirv1.6,vulkan1.4;";
   }
 
   // Sets the most typical compilation options. Note that without this, the
@@ -156,14 +200,28 @@ public:
   {
     m_compilerOptions->SetGenerateDebugInfo();
     m_compilerOptions->SetOptimizationLevel(shaderc_optimization_level_zero);
+    m_optionsKey += "debug,O0;";
   }
 
+  // Content of the files read by the compiler, shared by the threads of a batch
+  class FileCache;
+
 private:
   std::unique_ptr<shaderc::CompileOptions> makeOptions();
 
+  uint64_t              getCacheKey(const std::string& preprocessedSource, shaderc_shader_kind shaderKind) const;
+  std::filesystem::path getCacheFilename(uint64_t cacheKey) const;
+  bool                  loadFromCache(uint64_t cacheKey, std::vector<uint32_t>& spirv) const;
+  void                  saveToCache(uint64_t cacheKey, std::span<const uint32_t> spirv) const;
+
   std::vector<std::filesystem::path>       m_searchPaths{};
+  std::shared_ptr<FileCache>               m_fileCache;
   std::unique_ptr<shaderc::CompileOptions> m_compilerOptions;
 
+  std::filesystem::path m_cacheDirectory;
+  std::string           m_cacheTag;
+  std::string           m_optionsKey;  // options set by defaultTarget and defaultOptions
+
   std::function<void(const std::filesystem::path& sourceFile, const uint32_t* spirvCode, size_t spirvSize)> m_callback;
 };
 
@@ -0,0 +1,893 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+#include <tinygltf/json.hpp>
+
+#include "stb_image.h"
+
+#include <nvutils/file_mapping.hpp>
+#include <nvutils/file_operations.hpp>
+#include <nvutils/parallel_work.hpp>
+
+#include "cgltf_loader.hpp"
+#include "tinygltf_utils.hpp"
+
+namespace {
+
+using Value  = tinygltf::Value;
+using Object = tinygltf::Value::Object;
+using Array  = tinygltf::Value::Array;
+
+template <typename T>
+int indexOf(const T* element, const T* first)
+{
+  return element ? int(element - first) : -1;
+}
+
+std::string toString(const char* text)
+{
+  return text ? std::string(text) : std::string();
+}
+
+// Same conversion as tinygltf: the null members and the empty objects and arrays are dropped
+Value jsonToValue(const nlohmann::json& json)
+{
+  switch(json.type())
+  {
+    case nlohmann::json::value_t::object: {
+      Object object;
+      for(auto it = json.begin(); it != json.end(); ++it)
+      {
+        Value entry = jsonToValue(it.value());
+        if(entry.Type() != tinygltf::NULL_TYPE)
+          object.emplace(it.key(), std::move(entry));
+      }
+      return object.empty() ? Value() : Value(std::move(object));
+    }
+    case nlohmann::json::value_t::array: {
+      Array array;
+      array.reserve(json.size());
+      for(const nlohmann::json& element : json)
+      {
+        Value entry = jsonToValue(element);
+        if(entry.Type() != tinygltf::NULL_TYPE)
+          array.emplace_back(std::move(entry));
+      }
+      return array.empty() ? Value() : Value(std::move(array));
+    }
+    case nlohmann::json::value_t::string:
+      return Value(json.get<std::string>());
+    case nlohmann::json::value_t::boolean:
+      return Value(json.get<bool>());
+    case nlohmann::json::value_t::number_integer:
+    case nlohmann::json::value_t::number_unsigned:
+      return Value(json.get<int64_t>());
+    case nlohmann::json::value_t::number_float:
+      return Value(json.get<double>());
+    default:
+      return {};
+  }
+}
+
+Value parseJson(const char* text)
+{
+  if(!text)
+    return {};
+  const nlohmann::json json = nlohmann::json::parse(text, nullptr, false);
+  return json.is_discarded() ? Value() : jsonToValue(json);
+}
+
+// The extensions cgltf doesn't know, kept as JSON
+void addExtensions(tinygltf::ExtensionMap& extensions, const cgltf_extension* cextensions, cgltf_size count)
+{
+  for(cgltf_size i = 0; i < count; i++)
+  {
+    Value value = parseJson(cextensions[i].data);
+    // An empty extension is still an object, as with tinygltf (e.g. KHR_materials_unlit)
+    extensions[toString(cextensions[i].name)] = value.IsObject() ? std::move(value) : Value(Object());
+  }
+}
+
+Value makeFloats(const float* values, size_t count)
+{
+  Array array;
+  array.reserve(count);
+  for(size_t i = 0; i < count; i++)
+    array.emplace_back(double(values[i]));
+  return Value(std::move(array));
+}
+
+std::vector<double> toDoubles(const float* values, size_t count)
+{
+  return std::vector<double>(values, values + count);
+}
+
+Value makeTextureTransform(const cgltf_texture_transform& transform)
+{
+  Object object;
+  object["offset"]   = makeFloats(transform.offset, 2);
+  object["rotation"] = Value(double(transform.rotation));
+  object["scale"]    = makeFloats(transform.scale, 2);
+  if(transform.has_texcoord)
+    object["texCoord"] = Value(int(transform.texcoord));
+  return Value(std::move(object));
+}
+
+// The members shared by TextureInfo, NormalTextureInfo and OcclusionTextureInfo
+template <typename TextureInfo>
+void setTextureInfo(TextureInfo& info, const cgltf_texture_view& view, const cgltf_data* data)
+{
+  info.index    = indexOf(view.texture, data->textures);
+  info.texCoord = int(view.texcoord);
+  if(view.texture && view.has_transform)
+    info.extensions[KHR_TEXTURE_TRANSFORM_EXTENSION_NAME] = makeTextureTransform(view.transform);
+}
+
+// A texture of a material extension, as read by tinygltf::utils::getValue
+void setTextureValue(Object& object, const char* key, const cgltf_texture_view& view, const cgltf_data* data)
+{
+  if(!view.texture)
+    return;
+  Object texture;
+  texture["index"]    = Value(indexOf(view.texture, data->textures));
+  texture["texCoord"] = Value(int(view.texcoord));
+  if(view.scale != 1.0f)
+    texture["scale"] = Value(double(view.scale));  // clearcoatNormalTexture
+  if(view.has_transform)
+    texture["extensions"] = Value(Object{{KHR_TEXTURE_TRANSFORM_EXTENSION_NAME, makeTextureTransform(view.transform)}});
+  object[key] = Value(std::move(texture));
+}
+
+int toTinygltf(cgltf_component_type type)
+{
+  switch(type)
+  {
+    case cgltf_component_type_r_8:
+      return TINYGLTF_COMPONENT_TYPE_BYTE;
+    case cgltf_component_type_r_8u:
+      return TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+    case cgltf_component_type_r_16:
+      return TINYGLTF_COMPONENT_TYPE_SHORT;
+    case cgltf_component_type_r_16u:
+      return TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+    case cgltf_component_type_r_32u:
+      return TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+    case cgltf_component_type_r_32f:
+      return TINYGLTF_COMPONENT_TYPE_FLOAT;
+    default:
+      return -1;
+  }
+}
+
+int toTinygltf(cgltf_type type)
+{
+  switch(type)
+  {
+    case cgltf_type_scalar:
+      return TINYGLTF_TYPE_SCALAR;
+    case cgltf_type_vec2:
+      return TINYGLTF_TYPE_VEC2;
+    case cgltf_type_vec3:
+      return TINYGLTF_TYPE_VEC3;
+    case cgltf_type_vec4:
+      return TINYGLTF_TYPE_VEC4;
+    case cgltf_type_mat2:
+      return TINYGLTF_TYPE_MAT2;
+    case cgltf_type_mat3:
+      return TINYGLTF_TYPE_MAT3;
+    case cgltf_type_mat4:
+      return TINYGLTF_TYPE_MAT4;
+    default:
+      return -1;
+  }
+}
+
+int toTinygltf(cgltf_primitive_type type)
+{
+  switch(type)
+  {
+    case cgltf_primitive_type_points:
+      return TINYGLTF_MODE_POINTS;
+    case cgltf_primitive_type_lines:
+      return TINYGLTF_MODE_LINE;
+    case cgltf_primitive_type_line_loop:
+      return TINYGLTF_MODE_LINE_LOOP;
+    case cgltf_primitive_type_line_strip:
+      return TINYGLTF_MODE_LINE_STRIP;
+    case cgltf_primitive_type_triangle_strip:
+      return TINYGLTF_MODE_TRIANGLE_STRIP;
+    case cgltf_primitive_type_triangle_fan:
+      return TINYGLTF_MODE_TRIANGLE_FAN;
+    default:
+      return TINYGLTF_MODE_TRIANGLES;
+  }
+}
+
+const char* getMeshoptModeName(cgltf_meshopt_compression_mode mode)
+{
+  switch(mode)
+  {
+    case cgltf_meshopt_compression_mode_attributes:
+      return "ATTRIBUTES";
+    case cgltf_meshopt_compression_mode_triangles:
+      return "TRIANGLES";
+    case cgltf_meshopt_compression_mode_indices:
+      return "INDICES";
+    default:
+      return "";
+  }
+}
+
+const char* getMeshoptFilterName(cgltf_meshopt_compression_filter filter)
+{
+  switch(filter)
+  {
+    case cgltf_meshopt_compression_filter_octahedral:
+      return "OCTAHEDRAL";
+    case cgltf_meshopt_compression_filter_quaternion:
+      return "QUATERNION";
+    case cgltf_meshopt_compression_filter_exponential:
+      return "EXPONENTIAL";
+    default:
+      return "NONE";
+  }
+}
+
+// Decodes the base64 payload of a data URI, returns false when `uri` is not one
+bool decodeDataUri(const char* uri, std::vector<unsigned char>& out, const cgltf_options& options, std::string& error)
+{
+  const std::string_view view(uri);
+  const size_t           comma = view.find(',');
+  if(view.substr(0, 5) != "data:" || comma == std::string_view::npos)
+    return false;
+  if(view.substr(0, comma).find(";base64") == std::string_view::npos)
+  {
+    error += "Unsupported data URI encoding, only base64 is supported\n";
+    return true;
+  }
+
+  const std::string_view payload = view.substr(comma + 1);
+  size_t                 size    = payload.size() / 4 * 3;
+  size -= (payload.size() >= 1 && payload[payload.size() - 1] == '=') ? 1 : 0;
+  size -= (payload.size() >= 2 && payload[payload.size() - 2] == '=') ? 1 : 0;
+  void* decoded = nullptr;
+  if(cgltf_load_buffer_base64(&options, size, payload.data(), &decoded) != cgltf_result_success)
+  {
+    error += "Failed to decode a data URI\n";
+    return true;
+  }
+  out.assign(static_cast<const unsigned char*>(decoded), static_cast<const unsigned char*>(decoded) + size);
+  options.memory.free_func ? options.memory.free_func(options.memory.user_data, decoded) : free(decoded);
+  return true;
+}
+
+bool loadBuffers(tinygltf::Model& model, const cgltf_data* data, const cgltf_options& options, const std::filesystem::path& baseDir, std::string& error)
+{
+  model.buffers.resize(data->buffers_count);
+  for(cgltf_size i = 0; i < data->buffers_count; i++)
+  {
+    const cgltf_buffer& cbuffer = data->buffers[i];
+    tinygltf::Buffer&   buffer  = model.buffers[i];
+    buffer.name                 = toString(cbuffer.name);
+    buffer.byteLength           = cbuffer.size;
+    buffer.uri                  = toString(cbuffer.uri);
+    buffer.extras               = parseJson(cbuffer.extras.data);
+    addExtensions(buffer.extensions, cbuffer.extensions, cbuffer.extensions_count);
+
+    if(!cbuffer.uri)
+    {
+      // The binary chunk of a GLB, or the fallback buffer of EXT_meshopt_compression left empty
+      if(i == 0 && data->bin)
+      {
+        if(data->bin_size < cbuffer.size)
+        {
+          error += "The GLB binary chunk is smaller than the buffer\n";
+          return false;
+        }
+        const unsigned char* bin = static_cast<const unsigned char*>(data->bin);
+        buffer.data.assign(bin, bin + cbuffer.size);
+      }
+      continue;
+    }
+
+    if(decodeDataUri(cbuffer.uri, buffer.data, options, error))
+    {
+      if(buffer.data.size() < cbuffer.size)
+      {
+        error += "Buffer " + std::to_string(i) + ": the data URI is smaller than the buffer\n";
+        return false;
+      }
+      buffer.data.resize(cbuffer.size);
+      continue;
+    }
+
+    std::string path = buffer.uri;
+    path.resize(cgltf_decode_uri(path.data()));  // e.g. whitespace represented as %20
+    const std::filesystem::path filename = baseDir / nvutils::pathFromUtf8(path);
+    nvutils::FileReadMapping    mapping;
+    if(!mapping.open(filename, nvutils::FileReadMapping::MAPPING_FLAG_SEQUENTIAL) || mapping.size() < cbuffer.size)
+    {
+      error += "Failed to read the buffer: " + nvutils::utf8FromPath(filename) + "\n";
+      return false;
+    }
+    const unsigned char* bytes = static_cast<const unsigned char*>(mapping.data());
+    buffer.data.assign(bytes, bytes + cbuffer.size);
+  }
+  return true;
+}
+
+void convertMaterial(tinygltf::Material& material, const cgltf_material& cmaterial, const cgltf_data* data)
+{
+  material.name = toString(cmaterial.name);
+
+  if(cmaterial.has_pbr_metallic_roughness)
+  {
+    const cgltf_pbr_metallic_roughness& pbr = cmaterial.pbr_metallic_roughness;
+    material.pbrMetallicRoughness.baseColorFactor = toDoubles(pbr.base_color_factor, 4);
+    material.pbrMetallicRoughness.metallicFactor  = pbr.metallic_factor;
+    material.pbrMetallicRoughness.roughnessFactor = pbr.roughness_factor;
+    setTextureInfo(material.pbrMetallicRoughness.baseColorTexture, pbr.base_color_texture, data);
+    setTextureInfo(material.pbrMetallicRoughness.metallicRoughnessTexture, pbr.metallic_roughness_texture, data);
+  }
+  setTextureInfo(material.normalTexture, cmaterial.normal_texture, data);
+  material.normalTexture.scale = cmaterial.normal_texture.scale;
+  setTextureInfo(material.occlusionTexture, cmaterial.occlusion_texture, data);
+  material.occlusionTexture.strength = cmaterial.occlusion_texture.scale;
+  setTextureInfo(material.emissiveTexture, cmaterial.emissive_texture, data);
+  material.emissiveFactor = toDoubles(cmaterial.emissive_factor, 3);
+  material.alphaMode      = cmaterial.alpha_mode == cgltf_alpha_mode_mask  ? "MASK" :
+                            cmaterial.alpha_mode == cgltf_alpha_mode_blend ? "BLEND" :
+                                                                             "OPAQUE";
+  material.alphaCutoff    = cmaterial.alpha_cutoff;
+  material.doubleSided    = cmaterial.double_sided != 0;
+  material.extras         = parseJson(cmaterial.extras.data);
+
+  tinygltf::ExtensionMap& extensions = material.extensions;
+  if(cmaterial.has_pbr_specular_glossiness)
+  {
+    const cgltf_pbr_specular_glossiness& ext = cmaterial.pbr_specular_glossiness;
+    Object                               object;
+    object["diffuseFactor"]    = makeFloats(ext.diffuse_factor, 4);
+    object["specularFactor"]   = makeFloats(ext.specular_factor, 3);
+    object["glossinessFactor"] = Value(double(ext.glossiness_factor));
+    setTextureValue(object, "diffuseTexture", ext.diffuse_texture, data);
+    setTextureValue(object, "specularGlossinessTexture", ext.specular_glossiness_texture, data);
+    extensions[KHR_MATERIALS_PBR_SPECULAR_GLOSSINESS_EXTENSION_NAME] = Value(std::move(object));
+  }
+  if(cmaterial.has_clearcoat)
+  {
+    const cgltf_clearcoat& ext = cmaterial.clearcoat;
+    Object                 object;
+    object["clearcoatFactor"]          = Value(double(ext.clearcoat_factor));
+    object["clearcoatRoughnessFactor"] = Value(double(ext.clearcoat_roughness_factor));
+    setTextureValue(object, "clearcoatTexture", ext.clearcoat_texture, data);
+    setTextureValue(object, "clearcoatRoughnessTexture", ext.clearcoat_roughness_texture, data);
+    setTextureValue(object, "clearcoatNormalTexture", ext.clearcoat_normal_texture, data);
+    extensions[KHR_MATERIALS_CLEARCOAT_EXTENSION_NAME] = Value(std::move(object));
+  }
+  if(cmaterial.has_transmission)
+  {
+    Object object;
+    object["transmissionFactor"] = Value(double(cmaterial.transmission.transmission_factor));
+    setTextureValue(object, "transmissionTexture", cmaterial.transmission.transmission_texture, data);
+    extensions[KHR_MATERIALS_TRANSMISSION_EXTENSION_NAME] = Value(std::move(object));
+  }
+  if(cmaterial.has_volume)
+  {
+    const cgltf_volume& ext = cmaterial.volume;
+    Object              object;
+    object["thicknessFactor"]     = Value(double(ext.thickness_factor));
+    object["attenuationDistance"] = Value(double(ext.attenuation_distance));
+    object["attenuationColor"]    = makeFloats(ext.attenuation_color, 3);
+    setTextureValue(object, "thicknessTexture", ext.thickness_texture, data);
+    extensions[KHR_MATERIALS_VOLUME_EXTENSION_NAME] = Value(std::move(object));
+  }
+  if(cmaterial.has_ior)
+  {
+    extensions[KHR_MATERIALS_IOR_EXTENSION_NAME] = Value(Object{{"ior", Value(double(cmaterial.ior.ior))}});
+  }
+  if(cmaterial.has_specular)
+  {
+    const cgltf_specular& ext = cmaterial.specular;
+    Object                object;
+    object["specularFactor"]      = Value(double(ext.specular_factor));
+    object["specularColorFactor"] = makeFloats(ext.specular_color_factor, 3);
+    setTextureValue(object, "specularTexture", ext.specular_texture, data);
+    setTextureValue(object, "specularColorTexture", ext.specular_color_texture, data);
+    extensions[KHR_MATERIALS_SPECULAR_EXTENSION_NAME] = Value(std::move(object));
+  }
+  if(cmaterial.has_sheen)
+  {
+    const cgltf_sheen& ext = cmaterial.sheen;
+    Object             object;
+    object["sheenColorFactor"]     = makeFloats(ext.sheen_color_factor, 3);
+    object["sheenRoughnessFactor"] = Value(double(ext.sheen_roughness_factor));
+    setTextureValue(object, "sheenColorTexture", ext.sheen_color_texture, data);
+    setTextureValue(object, "sheenRoughnessTexture", ext.sheen_roughness_texture, data);
+    extensions[KHR_MATERIALS_SHEEN_EXTENSION_NAME] = Value(std::move(object));
+  }
+  if(cmaterial.has_emissive_strength)
+  {
+    extensions[KHR_MATERIALS_EMISSIVE_STRENGTH_EXTENSION_NAME] =
+        Value(Object{{"emissiveStrength", Value(double(cmaterial.emissive_strength.emissive_strength))}});
+  }
+  if(cmaterial.has_iridescence)
+  {
+    const cgltf_iridescence& ext = cmaterial.iridescence;
+    Object                   object;
+    object["iridescenceFactor"]           = Value(double(ext.iridescence_factor));
+    object["iridescenceIor"]              = Value(double(ext.iridescence_ior));
+    object["iridescenceThicknessMinimum"] = Value(double(ext.iridescence_thickness_min));
+    object["iridescenceThicknessMaximum"] = Value(double(ext.iridescence_thickness_max));
+    setTextureValue(object, "iridescenceTexture", ext.iridescence_texture, data);
+    setTextureValue(object, "iridescenceThicknessTexture", ext.iridescence_thickness_texture, data);
+    extensions[KHR_MATERIALS_IRIDESCENCE_EXTENSION_NAME] = Value(std::move(object));
+  }
+  if(cmaterial.has_diffuse_transmission)
+  {
+    const cgltf_diffuse_transmission& ext = cmaterial.diffuse_transmission;
+    Object                            object;
+    object["diffuseTransmissionFactor"] = Value(double(ext.diffuse_transmission_factor));
+    object["diffuseTransmissionColor"]  = makeFloats(ext.diffuse_transmission_color_factor, 3);
+    setTextureValue(object, "diffuseTransmissionTexture", ext.diffuse_transmission_texture, data);
+    setTextureValue(object, "diffuseTransmissionColorTexture", ext.diffuse_transmission_color_texture, data);
+    extensions[KHR_MATERIALS_DIFFUSE_TRANSMISSION_EXTENSION_NAME] = Value(std::move(object));
+  }
+  if(cmaterial.has_anisotropy)
+  {
+    const cgltf_anisotropy& ext = cmaterial.anisotropy;
+    Object                  object;
+    object["anisotropyStrength"] = Value(double(ext.anisotropy_strength));
+    object["anisotropyRotation"] = Value(double(ext.anisotropy_rotation));
+    setTextureValue(object, "anisotropyTexture", ext.anisotropy_texture, data);
+    extensions[KHR_MATERIALS_ANISOTROPY_EXTENSION_NAME] = Value(std::move(object));
+  }
+  if(cmaterial.has_dispersion)
+  {
+    extensions[KHR_MATERIALS_DISPERSION_EXTENSION_NAME] =
+        Value(Object{{"dispersion", Value(double(cmaterial.dispersion.dispersion))}});
+  }
+  if(cmaterial.unlit)
+  {
+    extensions[KHR_MATERIALS_UNLIT_EXTENSION_NAME] = Value(Object());
+  }
+  // KHR_materials_displacement and the other unknown extensions
+  addExtensions(extensions, cmaterial.extensions, cmaterial.extensions_count);
+}
+
+std::map<std::string, int> convertAttributes(const cgltf_attribute* attributes, cgltf_size count, const cgltf_data* data)
+{
+  std::map<std::string, int> result;
+  for(cgltf_size i = 0; i < count; i++)
+    result[toString(attributes[i].name)] = indexOf(attributes[i].data, data->accessors);
+  return result;
+}
+
+void convertMesh(tinygltf::Mesh& mesh, const cgltf_mesh& cmesh, const cgltf_data* data)
+{
+  mesh.name    = toString(cmesh.name);
+  mesh.weights = toDoubles(cmesh.weights, cmesh.weights_count);
+  mesh.extras  = parseJson(cmesh.extras.data);
+  addExtensions(mesh.extensions, cmesh.extensions, cmesh.extensions_count);
+
+  mesh.primitives.resize(cmesh.primitives_count);
+  for(cgltf_size p = 0; p < cmesh.primitives_count; p++)
+  {
+    const cgltf_primitive& cprimitive = cmesh.primitives[p];
+    tinygltf::Primitive&   primitive  = mesh.primitives[p];
+    primitive.attributes              = convertAttributes(cprimitive.attributes, cprimitive.attributes_count, data);
+    primitive.material                = indexOf(cprimitive.material, data->materials);
+    primitive.indices                 = indexOf(cprimitive.indices, data->accessors);
+    primitive.mode                    = toTinygltf(cprimitive.type);
+    primitive.extras                  = parseJson(cprimitive.extras.data);
+    for(cgltf_size t = 0; t < cprimitive.targets_count; t++)
+    {
+      const cgltf_morph_target& target = cprimitive.targets[t];
+      primitive.targets.push_back(convertAttributes(target.attributes, target.attributes_count, data));
+    }
+
+    // One mapping per variant, which getMaterialVariantIndex reads as the grouped ones
+    if(cprimitive.mappings_count > 0)
+    {
+      Array mappings;
+      for(cgltf_size m = 0; m < cprimitive.mappings_count; m++)
+      {
+        const cgltf_material_mapping& mapping = cprimitive.mappings[m];
+        mappings.emplace_back(Object{{"material", Value(indexOf(mapping.material, data->materials))},
+                                     {"variants", Value(Array{Value(int(mapping.variant))})}});
+      }
+      primitive.extensions[KHR_MATERIALS_VARIANTS_EXTENSION_NAME] = Value(Object{{"mappings", Value(std::move(mappings))}});
+    }
+    addExtensions(primitive.extensions, cprimitive.extensions, cprimitive.extensions_count);
+  }
+}
+
+void convertNode(tinygltf::Node& node, const cgltf_node& cnode, const cgltf_data* data)
+{
+  node.name   = toString(cnode.name);
+  node.camera = indexOf(cnode.camera, data->cameras);
+  node.skin   = indexOf(cnode.skin, data->skins);
+  node.mesh   = indexOf(cnode.mesh, data->meshes);
+  node.light  = indexOf(cnode.light, data->lights);
+  for(cgltf_size c = 0; c < cnode.children_count; c++)
+    node.children.push_back(indexOf(cnode.children[c], data->nodes));
+  if(cnode.has_translation)
+    node.translation = toDoubles(cnode.translation, 3);
+  if(cnode.has_rotation)
+    node.rotation = toDoubles(cnode.rotation, 4);
+  if(cnode.has_scale)
+    node.scale = toDoubles(cnode.scale, 3);
+  if(cnode.has_matrix)
+    node.matrix = toDoubles(cnode.matrix, 16);
+  node.weights = toDoubles(cnode.weights, cnode.weights_count);
+  node.extras  = parseJson(cnode.extras.data);
+
+  if(cnode.has_mesh_gpu_instancing)
+  {
+    Object                           attributes;
+    const cgltf_mesh_gpu_instancing& instancing = cnode.mesh_gpu_instancing;
+    for(cgltf_size a = 0; a < instancing.attributes_count; a++)
+      attributes[toString(instancing.attributes[a].name)] = Value(indexOf(instancing.attributes[a].data, data->accessors));
+    node.extensions[EXT_MESH_GPU_INSTANCING_EXTENSION_NAME] = Value(Object{{"attributes", Value(std::move(attributes))}});
+  }
+  // KHR_node_visibility, NV_attributes_iray, ...
+  addExtensions(node.extensions, cnode.extensions, cnode.extensions_count);
+}
+
+// The embedded images, which SceneVk takes decoded from `image.image`
+void decodeImages(tinygltf::Model& model, const cgltf_data* data, const cgltf_options& options, std::string& warn)
+{
+  std::vector<std::string> warnings(data->images_count);
+  nvutils::parallel_batches<1>(data->images_count, [&](uint64_t i) {
+    const cgltf_image&         cimage = data->images[i];
+    tinygltf::Image&           image  = model.images[i];
+    std::vector<unsigned char> encoded;
+    const unsigned char*       bytes = nullptr;
+    size_t                     size  = 0;
+    if(cimage.buffer_view)
+    {
+      const tinygltf::BufferView& view   = model.bufferViews[indexOf(cimage.buffer_view, data->buffer_views)];
+      const tinygltf::Buffer&     buffer = model.buffers[view.buffer];
+      if(view.byteOffset + view.byteLength > buffer.data.size())
+      {
+        warnings[i] = "Image " + std::to_string(i) + ": the buffer view is out of its buffer\n";
+        return;
+      }
+      bytes = buffer.data.data() + view.byteOffset;
+      size  = view.byteLength;
+    }
+    else if(cimage.uri && decodeDataUri(cimage.uri, encoded, options, warnings[i]))
+    {
+      bytes = encoded.data();
+      size  = encoded.size();
+    }
+    if(!bytes || size > size_t(std::numeric_limits<int>::max()))
+      return;
+
+    int            w = 0, h = 0, comp = 0;
+    unsigned char* pixels = stbi_load_from_memory(bytes, int(size), &w, &h, &comp, STBI_rgb_alpha);
+    if(!pixels)
+    {
+      // e.g. KTX2 or DDS, which stb doesn't decode
+      warnings[i] = "Image " + std::to_string(i) + ": the embedded image could not be decoded\n";
+      return;
+    }
+    image.width      = w;
+    image.height     = h;
+    image.component  = 4;
+    image.bits       = 8;
+    image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+    image.image.assign(pixels, pixels + size_t(w) * h * 4);
+    stbi_image_free(pixels);
+  });
+  for(const std::string& warning : warnings)
+    warn += warning;
+}
+
+}  // namespace
+
+bool nvvkgltf::loadModelCgltf(tinygltf::Model&             model,
+                              std::string&                 error,
+                              std::string&                 warn,
+                              const void*                  fileData,
+                              size_t                       fileSize,
+                              const std::filesystem::path& baseDir)
+{
+  // The buffers and images are not loaded by cgltf, see loadBuffers and decodeImages
+  const cgltf_options options{};
+  cgltf_data*         data   = nullptr;
+  cgltf_result        result = cgltf_parse(&options, fileData, fileSize, &data);
+  if(result == cgltf_result_success)
+  {
+    result = cgltf_validate(data);
+  }
+  if(result != cgltf_result_success)
+  {
+    error = "cgltf failed to parse the file, error " + std::to_string(int(result));
+    cgltf_free(data);
+    return false;
+  }
+
+  model                    = {};
+  model.asset.version      = toString(data->asset.version);
+  model.asset.generator    = toString(data->asset.generator);
+  model.asset.minVersion   = toString(data->asset.min_version);
+  model.asset.copyright    = toString(data->asset.copyright);
+  model.asset.extras       = parseJson(data->asset.extras.data);
+  model.defaultScene       = indexOf(data->scene, data->scenes);
+  model.extras             = parseJson(data->extras.data);
+  model.extensionsUsed.assign(data->extensions_used, data->extensions_used + data->extensions_used_count);
+  model.extensionsRequired.assign(data->extensions_required, data->extensions_required + data->extensions_required_count);
+  addExtensions(model.extensions, data->data_extensions, data->data_extensions_count);
+  if(data->variants_count > 0)
+  {
+    Array variants;
+    for(cgltf_size i = 0; i < data->variants_count; i++)
+      variants.emplace_back(Object{{"name", Value(toString(data->variants[i].name))}});
+    model.extensions[KHR_MATERIALS_VARIANTS_EXTENSION_NAME] = Value(Object{{"variants", Value(std::move(variants))}});
+  }
+
+  if(!loadBuffers(model, data, options, baseDir, error))
+  {
+    cgltf_free(data);
+    return false;
+  }
+
+  model.bufferViews.resize(data->buffer_views_count);
+  for(cgltf_size i = 0; i < data->buffer_views_count; i++)
+  {
+    const cgltf_buffer_view& cview = data->buffer_views[i];
+    tinygltf::BufferView&    view  = model.bufferViews[i];
+    view.name                      = toString(cview.name);
+    view.buffer                    = indexOf(cview.buffer, data->buffers);
+    view.byteOffset                = cview.offset;
+    view.byteLength                = cview.size;
+    view.byteStride                = cview.stride;
+    view.target                    = cview.type == cgltf_buffer_view_type_vertices ? TINYGLTF_TARGET_ARRAY_BUFFER :
+                                     cview.type == cgltf_buffer_view_type_indices  ? TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER :
+                                                                                     0;
+    view.extras                    = parseJson(cview.extras.data);
+    if(cview.has_meshopt_compression)
+    {
+      const cgltf_meshopt_compression& mc = cview.meshopt_compression;
+      Object                           object;
+      object["buffer"]     = Value(indexOf(mc.buffer, data->buffers));
+      object["byteOffset"] = Value(int64_t(mc.offset));
+      object["byteLength"] = Value(int64_t(mc.size));
+      object["byteStride"] = Value(int64_t(mc.stride));
+      object["count"]      = Value(int64_t(mc.count));
+      object["mode"]       = Value(getMeshoptModeName(mc.mode));
+      object["filter"]     = Value(getMeshoptFilterName(mc.filter));
+      view.extensions[EXT_MESHOPT_COMPRESSION_EXTENSION_NAME] = Value(std::move(object));
+    }
+    addExtensions(view.extensions, cview.extensions, cview.extensions_count);
+  }
+
+  model.accessors.resize(data->accessors_count);
+  for(cgltf_size i = 0; i < data->accessors_count; i++)
+  {
+    const cgltf_accessor& caccessor = data->accessors[i];
+    tinygltf::Accessor&   accessor  = model.accessors[i];
+    accessor.name                   = toString(caccessor.name);
+    accessor.bufferView             = indexOf(caccessor.buffer_view, data->buffer_views);
+    accessor.byteOffset             = caccessor.offset;
+    accessor.normalized             = caccessor.normalized != 0;
+    accessor.componentType          = toTinygltf(caccessor.component_type);
+    accessor.count                  = caccessor.count;
+    accessor.type                   = toTinygltf(caccessor.type);
+    const size_t numComponents      = cgltf_num_components(caccessor.type);
+    if(caccessor.has_min)
+      accessor.minValues = toDoubles(caccessor.min, numComponents);
+    if(caccessor.has_max)
+      accessor.maxValues = toDoubles(caccessor.max, numComponents);
+    if(caccessor.is_sparse)
+    {
+      const cgltf_accessor_sparse& sparse = caccessor.sparse;
+      accessor.sparse.isSparse              = true;
+      accessor.sparse.count                 = int(sparse.count);
+      accessor.sparse.indices.bufferView    = indexOf(sparse.indices_buffer_view, data->buffer_views);
+      accessor.sparse.indices.byteOffset    = sparse.indices_byte_offset;
+      accessor.sparse.indices.componentType = toTinygltf(sparse.indices_component_type);
+      accessor.sparse.values.bufferView     = indexOf(sparse.values_buffer_view, data->buffer_views);
+      accessor.sparse.values.byteOffset     = sparse.values_byte_offset;
+    }
+    accessor.extras = parseJson(caccessor.extras.data);
+    addExtensions(accessor.extensions, caccessor.extensions, caccessor.extensions_count);
+  }
+
+  model.materials.resize(data->materials_count);
+  for(cgltf_size i = 0; i < data->materials_count; i++)
+    convertMaterial(model.materials[i], data->materials[i], data);
+
+  model.meshes.resize(data->meshes_count);
+  for(cgltf_size i = 0; i < data->meshes_count; i++)
+    convertMesh(model.meshes[i], data->meshes[i], data);
+
+  model.nodes.resize(data->nodes_count);
+  for(cgltf_size i = 0; i < data->nodes_count; i++)
+    convertNode(model.nodes[i], data->nodes[i], data);
+
+  model.scenes.resize(data->scenes_count);
+  for(cgltf_size i = 0; i < data->scenes_count; i++)
+  {
+    const cgltf_scene& cscene = data->scenes[i];
+    tinygltf::Scene&   scene  = model.scenes[i];
+    scene.name                = toString(cscene.name);
+    for(cgltf_size n = 0; n < cscene.nodes_count; n++)
+      scene.nodes.push_back(indexOf(cscene.nodes[n], data->nodes));
+    scene.extras = parseJson(cscene.extras.data);
+    addExtensions(scene.extensions, cscene.extensions, cscene.extensions_count);
+  }
+
+  model.textures.resize(data->textures_count);
+  for(cgltf_size i = 0; i < data->textures_count; i++)
+  {
+    const cgltf_texture& ctexture = data->textures[i];
+    tinygltf::Texture&   texture  = model.textures[i];
+    texture.name                  = toString(ctexture.name);
+    texture.sampler               = indexOf(ctexture.sampler, data->samplers);
+    texture.source                = indexOf(ctexture.image, data->images);
+    texture.extras                = parseJson(ctexture.extras.data);
+    if(ctexture.has_basisu)
+    {
+      texture.extensions[KHR_TEXTURE_BASISU_EXTENSION_NAME] =
+          Value(Object{{"source", Value(indexOf(ctexture.basisu_image, data->images))}});
+    }
+    if(ctexture.has_webp)
+    {
+      texture.extensions["EXT_texture_webp"] = Value(Object{{"source", Value(indexOf(ctexture.webp_image, data->images))}});
+    }
+    // MSFT_texture_dds, ...
+    addExtensions(texture.extensions, ctexture.extensions, ctexture.extensions_count);
+  }
+
+  model.images.resize(data->images_count);
+  for(cgltf_size i = 0; i < data->images_count; i++)
+  {
+    const cgltf_image& cimage = data->images[i];
+    tinygltf::Image&   image  = model.images[i];
+    image.name                = toString(cimage.name);
+    image.uri                 = cimage.uri && strncmp(cimage.uri, "data:", 5) != 0 ? cimage.uri : "";
+    image.mimeType            = toString(cimage.mime_type);
+    image.bufferView          = indexOf(cimage.buffer_view, data->buffer_views);
+    image.extras              = parseJson(cimage.extras.data);
+    addExtensions(image.extensions, cimage.extensions, cimage.extensions_count);
+  }
+  decodeImages(model, data, options, warn);
+
+  model.samplers.resize(data->samplers_count);
+  for(cgltf_size i = 0; i < data->samplers_count; i++)
+  {
+    const cgltf_sampler& csampler = data->samplers[i];
+    tinygltf::Sampler&   sampler  = model.samplers[i];
+    sampler.name                  = toString(csampler.name);
+    sampler.minFilter             = csampler.min_filter == cgltf_filter_type_undefined ? -1 : int(csampler.min_filter);
+    sampler.magFilter             = csampler.mag_filter == cgltf_filter_type_undefined ? -1 : int(csampler.mag_filter);
+    sampler.wrapS                 = int(csampler.wrap_s);
+    sampler.wrapT                 = int(csampler.wrap_t);
+    sampler.extras                = parseJson(csampler.extras.data);
+    addExtensions(sampler.extensions, csampler.extensions, csampler.extensions_count);
+  }
+
+  model.cameras.resize(data->cameras_count);
+  for(cgltf_size i = 0; i < data->cameras_count; i++)
+  {
+    const cgltf_camera& ccamera = data->cameras[i];
+    tinygltf::Camera&   camera  = model.cameras[i];
+    camera.name                 = toString(ccamera.name);
+    if(ccamera.type == cgltf_camera_type_orthographic)
+    {
+      const cgltf_camera_orthographic& ortho = ccamera.data.orthographic;
+      camera.type                            = "orthographic";
+      camera.orthographic.xmag               = ortho.xmag;
+      camera.orthographic.ymag               = ortho.ymag;
+      camera.orthographic.zfar               = ortho.zfar;
+      camera.orthographic.znear              = ortho.znear;
+    }
+    else
+    {
+      const cgltf_camera_perspective& persp = ccamera.data.perspective;
+      camera.type                           = "perspective";
+      camera.perspective.aspectRatio        = persp.has_aspect_ratio ? persp.aspect_ratio : 0.0;
+      camera.perspective.yfov               = persp.yfov;
+      camera.perspective.zfar               = persp.has_zfar ? persp.zfar : 0.0;
+      camera.perspective.znear              = persp.znear;
+    }
+    camera.extras = parseJson(ccamera.extras.data);
+    addExtensions(camera.extensions, ccamera.extensions, ccamera.extensions_count);
+  }
+
+  model.lights.resize(data->lights_count);
+  for(cgltf_size i = 0; i < data->lights_count; i++)
+  {
+    const cgltf_light& clight = data->lights[i];
+    tinygltf::Light&   light  = model.lights[i];
+    light.name                = toString(clight.name);
+    light.color               = toDoubles(clight.color, 3);
+    light.intensity           = clight.intensity;
+    light.type                = clight.type == cgltf_light_type_spot  ? "spot" :
+                                clight.type == cgltf_light_type_point ? "point" :
+                                                                        "directional";
+    light.range               = clight.range;
+    light.spot.innerConeAngle = clight.spot_inner_cone_angle;
+    light.spot.outerConeAngle = clight.spot_outer_cone_angle;
+    light.extras              = parseJson(clight.extras.data);
+  }
+
+  model.skins.resize(data->skins_count);
+  for(cgltf_size i = 0; i < data->skins_count; i++)
+  {
+    const cgltf_skin& cskin = data->skins[i];
+    tinygltf::Skin&   skin  = model.skins[i];
+    skin.name                = toString(cskin.name);
+    skin.inverseBindMatrices = indexOf(cskin.inverse_bind_matrices, data->accessors);
+    skin.skeleton            = indexOf(cskin.skeleton, data->nodes);
+    for(cgltf_size j = 0; j < cskin.joints_count; j++)
+      skin.joints.push_back(indexOf(cskin.joints[j], data->nodes));
+    skin.extras = parseJson(cskin.extras.data);
+    addExtensions(skin.extensions, cskin.extensions, cskin.extensions_count);
+  }
+
+  static const char* pathNames[] = {"", "translation", "rotation", "scale", "weights"};
+  model.animations.resize(data->animations_count);
+  for(cgltf_size i = 0; i < data->animations_count; i++)
+  {
+    const cgltf_animation& canimation = data->animations[i];
+    tinygltf::Animation&   animation  = model.animations[i];
+    animation.name                    = toString(canimation.name);
+    animation.extras                  = parseJson(canimation.extras.data);
+    addExtensions(animation.extensions, canimation.extensions, canimation.extensions_count);
+    for(cgltf_size s = 0; s < canimation.samplers_count; s++)
+    {
+      const cgltf_animation_sampler& csampler = canimation.samplers[s];
+      tinygltf::AnimationSampler     sampler;
+      sampler.input         = indexOf(csampler.input, data->accessors);
+      sampler.output        = indexOf(csampler.output, data->accessors);
+      sampler.interpolation = csampler.interpolation == cgltf_interpolation_type_step         ? "STEP" :
+                              csampler.interpolation == cgltf_interpolation_type_cubic_spline ? "CUBICSPLINE" :
+                                                                                                "LINEAR";
+      sampler.extras        = parseJson(csampler.extras.data);
+      animation.samplers.push_back(std::move(sampler));
+    }
+    for(cgltf_size c = 0; c < canimation.channels_count; c++)
+    {
+      const cgltf_animation_channel& cchannel = canimation.channels[c];
+      if(cchannel.target_path == cgltf_animation_path_type_invalid || cchannel.target_path >= std::size(pathNames))
+      {
+        warn += "Animation " + std::to_string(i) + ": channel with an unsupported path, e.g. KHR_animation_pointer\n";
+        continue;
+      }
+      tinygltf::AnimationChannel channel;
+      channel.sampler     = indexOf(cchannel.sampler, canimation.samplers);
+      channel.target_node = indexOf(cchannel.target_node, data->nodes);
+      channel.target_path = pathNames[cchannel.target_path];
+      channel.extras      = parseJson(cchannel.extras.data);
+      animation.channels.push_back(std::move(channel));
+    }
+  }
+
+  cgltf_free(data);
+  return true;
+}
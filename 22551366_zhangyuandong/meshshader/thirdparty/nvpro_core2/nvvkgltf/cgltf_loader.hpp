@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+#include <tinygltf/tiny_gltf.h>
+
+/*-------------------------------------------------------------------------------------------------
+# function nvvkgltf::loadModelCgltf
+
+>  Parses a .gltf or .glb file held in memory with cgltf, and fills `model` as tinygltf would.
+
+Used by `nvvkgltf::Scene::load` with `Scene::LoaderBackend::eCgltf`, the rest of the scene code
+is unchanged. cgltf tokenizes the JSON in place, without building a DOM, and the model is converted
+from its structures:
+- The buffers are read once: the GLB binary chunk and the external .bin files are copied into
+  `tinygltf::Buffer::data` straight from the mapped file, the data URIs are decoded.
+- The images referenced by a URI are not read, `SceneVk` loads them from the file. The embedded ones
+  (buffer view or data URI) are decoded to RGBA8 in `tinygltf::Image::image`, in parallel.
+- The extensions cgltf parses (KHR_materials_*, KHR_texture_transform, KHR_texture_basisu,
+  KHR_lights_punctual, KHR_materials_variants, EXT_mesh_gpu_instancing, EXT_meshopt_compression)
+  are written back as the `tinygltf::Value` read by `tinygltf_utils`. The others, and the extras,
+  are kept as JSON by cgltf and converted to values.
+
+Not supported: KHR_animation_pointer channels and KHR_draco_mesh_compression, like tinygltf without draco.
+-------------------------------------------------------------------------------------------------*/
+
+namespace nvvkgltf {
+
+bool loadModelCgltf(tinygltf::Model&             model,
+                    std::string&                 error,
+                    std::string&                 warn,
+                    const void*                  fileData,
+                    size_t                       fileSize,
+                    const std::filesystem::path& baseDir);
+
+}  // namespace nvvkgltf
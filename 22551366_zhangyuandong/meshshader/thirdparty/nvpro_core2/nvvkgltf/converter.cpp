@@ -17,10 +17,20 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+
+#include <meshoptimizer/src/meshoptimizer.h>
+
 #include "converter.hpp"
+#include "nvutils/parallel_work.hpp"
 
 
 void TinyConverter::convert(tinygltf::Model& gltf, const tinyobj::ObjReader& reader)
+{
+  convert(gltf, reader, Settings{});
+}
+
+void TinyConverter::convert(tinygltf::Model& gltf, const tinyobj::ObjReader& reader, const Settings& settings)
 {
   // Default assets
   gltf.asset.copyright = "NVIDIA Corporation";
@@ -38,6 +48,12 @@ void TinyConverter::convert(tinygltf::Model& gltf, const tinyobj::ObjReader& rea
   if(gltf.materials.empty())
     gltf.materials.emplace_back();  // Default material
 
+  if(settings.optimize || settings.numLods > 0)
+  {
+    convertOptimizedShapes(gltf, reader, settings);
+    return;
+  }
+
   // Unordered map of unique Vertex
   auto hash  = [&](const Vertex& v) { return makeHash(v); };
   auto equal = [&](const Vertex& l, const Vertex& r) { return l == r; };
@@ -262,6 +278,225 @@ void TinyConverter::convert(tinygltf::Model& gltf, const tinyobj::ObjReader& rea
   tBuffer.data.shrink_to_fit();
 }
 
+// Same as convert, but each shape has its own vertices, optimized with meshoptimizer, and optionally simplified LODs.
+// The triangles of a shape are split in one primitive per material, the primitives share the vertices of the shape.
+void TinyConverter::convertOptimizedShapes(tinygltf::Model& gltf, const tinyobj::ObjReader& reader, const Settings& settings)
+{
+  struct OptimizedPrimitive
+  {
+    int                                material{0};
+    std::vector<uint32_t>              indices;
+    std::vector<std::vector<uint32_t>> lods;
+  };
+  struct OptimizedShape
+  {
+    std::vector<Vertex>             vertices;
+    std::vector<OptimizedPrimitive> primitives;
+    size_t                          numLods{0};
+    Bbox                            bb;
+  };
+
+  const auto&                 attrib = reader.GetAttrib();
+  const auto&                 shapes = reader.GetShapes();
+  std::vector<OptimizedShape> optimized(shapes.size());
+
+  // The shapes are independent, optimize them in parallel
+  nvutils::parallel_batches<1>(shapes.size(), [&](uint64_t shapeID) {
+    const tinyobj::shape_t& shape      = shapes[shapeID];
+    OptimizedShape&         out        = optimized[shapeID];
+    const size_t            numIndices = shape.mesh.indices.size();
+    if(numIndices == 0)
+      return;
+
+    // Deduplicate the vertices of the shape
+    std::vector<Vertex> unindexed(numIndices);
+    for(size_t i = 0; i < numIndices; i++)
+      unindexed[i] = getVertex(attrib, shape.mesh.indices[i]);
+    std::vector<uint32_t> remap(numIndices);
+    const size_t numVertices = meshopt_generateVertexRemap(remap.data(), nullptr, numIndices, unindexed.data(), numIndices, sizeof(Vertex));
+    std::vector<uint32_t> indices(numIndices);
+    out.vertices.resize(numVertices);
+    meshopt_remapVertexBuffer(out.vertices.data(), unindexed.data(), numIndices, sizeof(Vertex), remap.data());
+    meshopt_remapIndexBuffer(indices.data(), nullptr, numIndices, remap.data());
+
+    // Split the triangles by material, the faces without material use the default one
+    size_t current = 0;
+    for(size_t face = 0; face < numIndices / 3; face++)
+    {
+      const int material = face < shape.mesh.material_ids.size() ? std::max(0, shape.mesh.material_ids[face]) : 0;
+      if(out.primitives.empty() || out.primitives[current].material != material)
+      {
+        auto it = std::find_if(out.primitives.begin(), out.primitives.end(),
+                               [&](const OptimizedPrimitive& prim) { return prim.material == material; });
+        current = it - out.primitives.begin();
+        if(it == out.primitives.end())
+          out.primitives.push_back({material});
+      }
+      std::vector<uint32_t>& primIndices = out.primitives[current].indices;
+      primIndices.insert(primIndices.end(), indices.begin() + face * 3, indices.begin() + face * 3 + 3);
+    }
+
+    // Reorder the triangles for the vertex cache, then for overdraw, then the vertices for the fetches of all primitives
+    const float* positions = &out.vertices[0].pos.x;
+    indices.clear();
+    for(OptimizedPrimitive& prim : out.primitives)
+    {
+      meshopt_optimizeVertexCache(prim.indices.data(), prim.indices.data(), prim.indices.size(), numVertices);
+      meshopt_optimizeOverdraw(prim.indices.data(), prim.indices.data(), prim.indices.size(), positions, numVertices,
+                               sizeof(Vertex), settings.overdrawThreshold);
+      indices.insert(indices.end(), prim.indices.begin(), prim.indices.end());
+    }
+    meshopt_optimizeVertexFetch(out.vertices.data(), indices.data(), indices.size(), out.vertices.data(), numVertices, sizeof(Vertex));
+    for(size_t p = 0, offset = 0; p < out.primitives.size(); offset += out.primitives[p].indices.size(), p++)
+    {
+      std::copy_n(indices.begin() + offset, out.primitives[p].indices.size(), out.primitives[p].indices.begin());
+    }
+
+    // LODs, simplified from the previous level; they reference the vertices of the shape. The borders between
+    // the materials are locked, such that the primitives stay connected.
+    const unsigned int simplifyOptions = out.primitives.size() > 1 ? meshopt_SimplifyLockBorder : 0;
+    for(uint32_t lod = 0; lod < settings.numLods; lod++)
+    {
+      std::vector<std::vector<uint32_t>> lodIndices(out.primitives.size());
+      size_t                             sourceTotal = 0;
+      size_t                             lodTotal    = 0;
+      for(size_t p = 0; p < out.primitives.size(); p++)
+      {
+        const std::vector<uint32_t>& source = lod == 0 ? out.primitives[p].indices : out.primitives[p].lods.back();
+        const size_t                 targetIndices = (source.size() / 6) * 3;
+        lodIndices[p].resize(source.size());
+        lodIndices[p].resize(meshopt_simplify(lodIndices[p].data(), source.data(), source.size(), positions, numVertices,
+                                              sizeof(Vertex), targetIndices, settings.lodTargetError, simplifyOptions));
+        // A primitive simplified away keeps its previous level
+        if(lodIndices[p].empty())
+          lodIndices[p] = source;
+        sourceTotal += source.size();
+        lodTotal += lodIndices[p].size();
+      }
+      // Stop once the simplification no longer reduces the triangles meaningfully
+      if(lodTotal * 10 > sourceTotal * 9)
+        break;
+      for(size_t p = 0; p < out.primitives.size(); p++)
+      {
+        meshopt_optimizeVertexCache(lodIndices[p].data(), lodIndices[p].data(), lodIndices[p].size(), numVertices);
+        out.primitives[p].lods.emplace_back(std::move(lodIndices[p]));
+      }
+      out.numLods++;
+    }
+
+    for(const Vertex& v : out.vertices)
+      out.bb.insert(v.pos);
+  });
+
+  // Storing the information in the glTF buffer, in the order of the shapes
+  std::vector<int> lodNodes;
+  for(size_t shapeID = 0; shapeID < shapes.size(); shapeID++)
+  {
+    OptimizedShape& shape = optimized[shapeID];
+
+    // Adding a glTF mesh, with one primitive per material, and the node referencing it
+    tinygltf::Mesh mesh;
+    mesh.name = shapes[shapeID].name;
+
+    if(shape.vertices.empty())
+    {
+      tinygltf::Primitive tPrim;
+      tPrim.mode     = TINYGLTF_MODE_TRIANGLES;
+      tPrim.material = 0;
+      mesh.primitives.emplace_back(tPrim);
+    }
+    else
+    {
+      std::vector<glm::vec3> vertices(shape.vertices.size());
+      std::vector<glm::vec3> normals(attrib.normals.empty() ? 0 : shape.vertices.size());
+      std::vector<glm::vec2> texcoords(attrib.texcoords.empty() ? 0 : shape.vertices.size());
+      for(size_t i = 0; i < shape.vertices.size(); i++)
+      {
+        vertices[i] = shape.vertices[i].pos;
+        if(!normals.empty())
+          normals[i] = shape.vertices[i].nrm;
+        if(!texcoords.empty())
+          texcoords[i] = shape.vertices[i].tex;
+      }
+
+      std::map<std::string, int> attributes;
+      int posAccessor = appendAccessor(gltf, vertices, TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT, 3 * sizeof(float));
+      gltf.accessors[posAccessor].minValues = {shape.bb.min()[0], shape.bb.min()[1], shape.bb.min()[2]};
+      gltf.accessors[posAccessor].maxValues = {shape.bb.max()[0], shape.bb.max()[1], shape.bb.max()[2]};
+      attributes["POSITION"]                = posAccessor;
+      if(!normals.empty())
+        attributes["NORMAL"] = appendAccessor(gltf, normals, TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT, 3 * sizeof(float));
+      if(!texcoords.empty())
+        attributes["TEXCOORD_0"] =
+            appendAccessor(gltf, texcoords, TINYGLTF_TYPE_VEC2, TINYGLTF_COMPONENT_TYPE_FLOAT, 2 * sizeof(float));
+
+      for(const OptimizedPrimitive& prim : shape.primitives)
+      {
+        tinygltf::Primitive tPrim;
+        tPrim.mode       = TINYGLTF_MODE_TRIANGLES;
+        tPrim.material   = prim.material;
+        tPrim.attributes = attributes;
+        // "bufferView.byteStride must not be defined for indices accessor."
+        tPrim.indices = appendAccessor(gltf, prim.indices, TINYGLTF_TYPE_SCALAR, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, 0);
+        mesh.primitives.emplace_back(tPrim);
+      }
+    }
+    gltf.meshes.emplace_back(mesh);
+
+    tinygltf::Node node;
+    node.name = mesh.name;
+    node.mesh = static_cast<int>(gltf.meshes.size() - 1);
+    gltf.nodes.emplace_back(node);
+
+    // The LODs share the vertex attributes, only the indices differ. Their nodes are added after the
+    // nodes of the shapes, and are only referenced by MSFT_lod.
+    for(size_t lod = 0; lod < shape.numLods; lod++)
+    {
+      tinygltf::Mesh lodMesh = mesh;
+      lodMesh.name += "_lod" + std::to_string(lod + 1);
+      for(size_t p = 0; p < shape.primitives.size(); p++)
+      {
+        lodMesh.primitives[p].indices = appendAccessor(gltf, shape.primitives[p].lods[lod], TINYGLTF_TYPE_SCALAR,
+                                                       TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, 0);
+      }
+      gltf.meshes.emplace_back(lodMesh);
+      lodNodes.push_back(static_cast<int>(gltf.meshes.size() - 1));
+    }
+  }
+
+  // Nodes of the LODs, and their references from the shape nodes
+  const int numShapeNodes = static_cast<int>(gltf.nodes.size());
+  size_t    lodNodeID     = 0;
+  for(size_t shapeID = 0; shapeID < shapes.size(); shapeID++)
+  {
+    if(optimized[shapeID].numLods == 0)
+      continue;
+    tinygltf::Value::Array ids;
+    for(size_t lod = 0; lod < optimized[shapeID].numLods; lod++, lodNodeID++)
+    {
+      tinygltf::Node node;
+      node.mesh = lodNodes[lodNodeID];
+      node.name = gltf.meshes[node.mesh].name;
+      gltf.nodes.emplace_back(node);
+      ids.emplace_back(static_cast<int>(gltf.nodes.size() - 1));
+    }
+    tinygltf::Value::Object lodExt;
+    lodExt["ids"]                              = tinygltf::Value(ids);
+    gltf.nodes[shapeID].extensions["MSFT_lod"] = tinygltf::Value(lodExt);
+  }
+  if(lodNodeID > 0)
+    gltf.extensionsUsed.emplace_back("MSFT_lod");
+
+  // Scene, without the LOD nodes
+  gltf.defaultScene = 0;
+  tinygltf::Scene scene;
+  for(int n = 0; n < numShapeNodes; n++)
+    scene.nodes.push_back(n);
+  gltf.scenes.emplace_back(scene);
+
+  gltf.buffers.back().data.shrink_to_fit();
+}
+
 TinyConverter::Vertex TinyConverter::getVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index)
 {
   Vertex       v{};
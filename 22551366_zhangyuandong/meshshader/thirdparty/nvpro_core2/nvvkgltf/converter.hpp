@@ -32,13 +32,32 @@ Class TinyConverter
 
 > This class is used to convert a tinyobj::ObjReader to a tinygltf::Model.
 
+By default, all shapes share one vertex buffer of the unique vertices. With `Settings::optimize`,
+each shape gets its own vertices, deduplicated and reordered with meshoptimizer for the vertex
+cache, overdraw and vertex fetches. `Settings::numLods` adds simplified versions of each shape,
+referenced by the `MSFT_lod` extension of its node. The shapes are processed in parallel.
+
+Usage:
+  TinyConverter           converter;
+  TinyConverter::Settings settings{.optimize = true, .numLods = 3};
+  converter.convert(gltf, reader, settings);
+
 -------------------------------------------------------------------------------------------------*/
 
 
 class TinyConverter
 {
 public:
+  struct Settings
+  {
+    bool     optimize          = false;  // Per-shape vertices, optimized for the vertex cache, overdraw and fetches
+    float    overdrawThreshold = 1.05f;  // Vertex cache efficiency that the overdraw optimization may trade
+    uint32_t numLods           = 0;      // Simplified LODs per shape, each with about half the triangles of the previous
+    float    lodTargetError    = 0.01f;  // Maximum simplification error of the LODs, relative to the shape extent
+  };
+
   void convert(tinygltf::Model& gltf, const tinyobj::ObjReader& reader);
+  void convert(tinygltf::Model& gltf, const tinyobj::ObjReader& reader, const Settings& settings);
 
 
 private:
@@ -79,6 +98,7 @@ private:
 
 
   Vertex getVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index);
+  void   convertOptimizedShapes(tinygltf::Model& gltf, const tinyobj::ObjReader& reader, const Settings& settings);
   void   convertMaterial(tinygltf::Model& gltf, const tinyobj::material_t& mat);
   int    convertTexture(tinygltf::Model& gltf, const std::string& diffuse_texname);
 
@@ -97,6 +117,28 @@ private:
     return len;
   }
 
+  // Appends the data to the binary buffer with a buffer view and an accessor, and returns the accessor index.
+  template <class T>
+  int appendAccessor(tinygltf::Model& gltf, const T& inData, int type, int componentType, size_t byteStride)
+  {
+    auto&                tBuffer = gltf.buffers.back();
+    tinygltf::BufferView tBufferView;
+    tBufferView.buffer     = 0;
+    tBufferView.byteOffset = tBuffer.data.size();
+    tBufferView.byteStride = byteStride;
+    tBufferView.byteLength = appendData(tBuffer, inData);
+    gltf.bufferViews.emplace_back(tBufferView);
+
+    tinygltf::Accessor tAccessor;
+    tAccessor.bufferView    = static_cast<int>(gltf.bufferViews.size() - 1);
+    tAccessor.byteOffset    = 0;
+    tAccessor.componentType = componentType;
+    tAccessor.count         = inData.size();
+    tAccessor.type          = type;
+    gltf.accessors.emplace_back(tAccessor);
+    return static_cast<int>(gltf.accessors.size() - 1);
+  }
+
 
   struct Bbox
   {
@@ -50,6 +50,14 @@ struct GpuMemoryStats
   uint64_t totalDeallocations = 0;  // Lifetime deallocation count
   uint64_t peakBytes          = 0;  // High water mark for bytes
   uint32_t peakCount          = 0;  // Maximum concurrent allocations
+  uint64_t savedBytes         = 0;  // Bytes avoided by compact layouts (e.g. packed vertices)
+};
+
+// A live allocation, see GpuMemoryTracker::getLargestAllocations
+struct GpuAllocationRecord
+{
+  std::string category;
+  uint64_t    bytes = 0;
 };
 
 // GPU memory tracker for monitoring allocations
@@ -75,6 +83,7 @@ public:
     stats.currentBytes += allocInfo.size;
     stats.currentCount += 1;
     stats.totalAllocations += 1;
+    m_allocations[allocation] = {categoryStr, allocInfo.size};
 
     // Update peaks
     if(stats.currentBytes > stats.peakBytes)
@@ -103,6 +112,16 @@ public:
     if(stats.currentCount > 0)
       stats.currentCount -= 1;
     stats.totalDeallocations += 1;
+    m_allocations.erase(allocation);
+  }
+
+  // Bytes that a compact layout avoided allocating in the category, reported along the allocations
+  void trackSaved(std::string_view category, uint64_t bytes) { m_stats[std::string(category)].savedBytes += bytes; }
+  void untrackSaved(std::string_view category, uint64_t bytes)
+  {
+    auto it = m_stats.find(std::string(category));
+    if(it != m_stats.end())
+      it->second.savedBytes -= std::min(it->second.savedBytes, bytes);
   }
 
   // Get statistics for a specific category
@@ -127,10 +146,26 @@ public:
       total.totalDeallocations += stats.totalDeallocations;
       total.peakBytes += stats.peakBytes;
       total.peakCount += stats.peakCount;
+      total.savedBytes += stats.savedBytes;
     }
     return total;
   }
 
+  // The `count` largest live allocations, largest first
+  std::vector<GpuAllocationRecord> getLargestAllocations(size_t count) const
+  {
+    std::vector<GpuAllocationRecord> records;
+    records.reserve(m_allocations.size());
+    for(const auto& [allocation, record] : m_allocations)
+      records.push_back(record);
+
+    count = std::min(count, records.size());
+    std::partial_sort(records.begin(), records.begin() + count, records.end(),
+                      [](const GpuAllocationRecord& a, const GpuAllocationRecord& b) { return a.bytes > b.bytes; });
+    records.resize(count);
+    return records;
+  }
+
   // Get all category names that have non-zero current bytes (for UI iteration)
   // sortBy: How to sort the returned categories
   // ascending: true for ascending order, false for descending (default depends on sort type)
@@ -177,16 +212,23 @@ public:
       stats.currentCount = 0;
       stats.peakBytes    = 0;
       stats.peakCount    = 0;
+      stats.savedBytes   = 0;
       // Keep stats.totalAllocations and stats.totalDeallocations for lifetime tracking
     }
+    m_allocations.clear();
   }
 
   // Complete reset - clears all statistics including totals
-  void resetAll() { m_stats.clear(); }
+  void resetAll()
+  {
+    m_stats.clear();
+    m_allocations.clear();
+  }
 
 private:
-  nvvk::ResourceAllocator*                        m_alloc = nullptr;
-  std::unordered_map<std::string, GpuMemoryStats> m_stats;
+  nvvk::ResourceAllocator*                               m_alloc = nullptr;
+  std::unordered_map<std::string, GpuMemoryStats>        m_stats;
+  std::unordered_map<VmaAllocation, GpuAllocationRecord> m_allocations;  // Live allocations
 };
 
 }  // namespace nvvkgltf
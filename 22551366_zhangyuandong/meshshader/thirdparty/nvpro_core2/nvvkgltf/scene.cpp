@@ -17,20 +17,27 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <atomic>
+#include <cstring>
 #include <execution>
 #include <filesystem>
+#include <limits>
 #include <unordered_set>
 
 #include <glm/gtx/norm.hpp>
 #include <fmt/format.h>
 #include <meshoptimizer/src/meshoptimizer.h>
 
+#include <nvutils/file_mapping.hpp>
 #include <nvutils/file_operations.hpp>
+#include <nvutils/hash_operations.hpp>
 #include <nvutils/logger.hpp>
 #include <nvutils/parallel_work.hpp>
 #include <nvutils/timers.hpp>
 
+#include "cgltf_loader.hpp"
 #include "scene.hpp"
+#include "scene_cache.hpp"
 
 // List of supported extensions
 static const std::set<std::string> supportedExtensions = {
@@ -83,6 +90,21 @@ static glm::vec4 makeFastTangent(const glm::vec3& n)
 }
 
 // Loading a GLTF file and extracting all information
+// Reads the external buffers and images through a file mapping, filling `out` with a single copy
+static bool readWholeFileMapped(std::vector<unsigned char>* out, std::string* err, const std::string& filepath, void*)
+{
+  nvutils::FileReadMapping mapping;
+  if(!mapping.open(nvutils::pathFromUtf8(filepath), nvutils::FileReadMapping::MAPPING_FLAG_SEQUENTIAL))
+  {
+    if(err)
+      *err = "Failed to map file: " + filepath;
+    return false;
+  }
+  const unsigned char* bytes = static_cast<const unsigned char*>(mapping.data());
+  out->assign(bytes, bytes + mapping.size());
+  return true;
+}
+
 bool nvvkgltf::Scene::load(const std::filesystem::path& filename)
 {
   nvutils::ScopedTimer st(std::string(__FUNCTION__) + "\n");
@@ -95,21 +117,43 @@ bool nvvkgltf::Scene::load(const std::filesystem::path& filename)
   std::string        warn;
   std::string        error;
   tcontext.SetMaxExternalFileSize(-1);  // No limit for external files (images, buffers, etc.)
+  tcontext.SetFsCallbacks({&tinygltf::FileExists, &tinygltf::ExpandFilePath, &readWholeFileMapped,
+                           &tinygltf::WriteWholeFile, &tinygltf::GetFileSizeInBytes, nullptr});
   const std::string ext = nvutils::utf8FromPath(filename.extension());
-  bool              result{false};
-  if(ext == ".gltf")
+  if(ext != ".gltf" && ext != ".glb")
+  {
+    LOGE("%sUnknown file extension: %s\n", st.indent().c_str(), ext.c_str());
+    return false;
+  }
+
+  // The file is mapped instead of being read into a temporary copy: for a GLB, only the
+  // binary chunk is copied out of the mapping into the buffer, halving the peak memory.
+  // The whole file is read ahead, so the binary chunk comes from disk while the JSON is parsed.
+  nvutils::FileReadMapping fileMapping;
+  const uint32_t           mappingFlags =
+      nvutils::FileReadMapping::MAPPING_FLAG_SEQUENTIAL | nvutils::FileReadMapping::MAPPING_FLAG_PREFETCH;
+  if(!fileMapping.open(filename, mappingFlags) || fileMapping.size() > std::numeric_limits<unsigned int>::max())
+  {
+    LOGE("%sCould not map file: %s\n", st.indent().c_str(), filenameUtf8.c_str());
+    return false;
+  }
+  const std::string  baseDir  = nvutils::utf8FromPath(filename.parent_path());
+  const unsigned int fileSize = static_cast<unsigned int>(fileMapping.size());
+  bool               result{false};
+  if(m_loaderBackend == LoaderBackend::eCgltf)
   {
-    result = tcontext.LoadASCIIFromFile(&m_model, &error, &warn, filenameUtf8.c_str());
+    result = loadModelCgltf(m_model, error, warn, fileMapping.data(), fileMapping.size(), filename.parent_path());
   }
-  else if(ext == ".glb")
+  else if(ext == ".gltf")
   {
-    result = tcontext.LoadBinaryFromFile(&m_model, &error, &warn, filenameUtf8.c_str());
+    result = tcontext.LoadASCIIFromString(&m_model, &error, &warn, static_cast<const char*>(fileMapping.data()), fileSize, baseDir);
   }
   else
   {
-    LOGE("%sUnknown file extension: %s\n", st.indent().c_str(), ext.c_str());
-    return false;
+    result = tcontext.LoadBinaryFromMemory(&m_model, &error, &warn, static_cast<const unsigned char*>(fileMapping.data()),
+                                           fileSize, baseDir);
   }
+  fileMapping.close();
 
   if(!result)
   {
@@ -161,90 +205,129 @@ bool nvvkgltf::Scene::load(const std::filesystem::path& filename)
     // first used to tag buffers that can be removed after decompression
     std::vector<int> isFullyCompressedBuffer(m_model.buffers.size(), 1);
 
+    struct CompressedView
+    {
+      EXT_meshopt_compression mcomp;
+      unsigned char*          result = nullptr;
+    };
+    std::vector<CompressedView> compressedViews;
+
     for(auto& bufferView : m_model.bufferViews)
     {
       if(bufferView.buffer < 0)
         continue;
 
-      bool warned = false;
-
       EXT_meshopt_compression mcomp;
       if(tinygltf::utils::getMeshoptCompression(bufferView, mcomp))
       {
-        // this decoding logic was derived from `decompressMeshopt`
-        // in https://github.com/zeux/meshoptimizer/blob/master/gltf/parsegltf.cpp
-
-
-        const tinygltf::Buffer& sourceBuffer = m_model.buffers[mcomp.buffer];
-        const unsigned char*    source       = &sourceBuffer.data[mcomp.byteOffset];
-        assert(mcomp.byteOffset + mcomp.byteLength <= sourceBuffer.data.size());
-
         tinygltf::Buffer& resultBuffer = m_model.buffers[bufferView.buffer];
-        unsigned char*    result       = &resultBuffer.data[bufferView.byteOffset];
+        assert(mcomp.byteOffset + mcomp.byteLength <= m_model.buffers[mcomp.buffer].data.size());
         assert(bufferView.byteOffset + bufferView.byteLength <= resultBuffer.data.size());
+        compressedViews.push_back({mcomp, &resultBuffer.data[bufferView.byteOffset]});
 
-        int  rc   = -1;
-        bool warn = false;
+        // remove extension for saving uncompressed
+        bufferView.extensions.erase(EXT_MESHOPT_COMPRESSION_EXTENSION_NAME);
+      }
 
-        switch(mcomp.compressionMode)
-        {
-          case EXT_meshopt_compression::MESHOPT_COMPRESSION_MODE_ATTRIBUTES:
-            warn = meshopt_decodeVertexVersion(source, mcomp.byteLength) != 0;
-            rc   = meshopt_decodeVertexBuffer(result, mcomp.count, mcomp.byteStride, source, mcomp.byteLength);
-            break;
+      isFullyCompressedBuffer[bufferView.buffer] = 0;
+    }
 
-          case EXT_meshopt_compression::MESHOPT_COMPRESSION_MODE_TRIANGLES:
-            warn = meshopt_decodeIndexVersion(source, mcomp.byteLength) != 1;
-            rc   = meshopt_decodeIndexBuffer(result, mcomp.count, mcomp.byteStride, source, mcomp.byteLength);
-            break;
+    // The views are independent, each is decoded by its own task.
+    // this decoding logic was derived from `decompressMeshopt`
+    // in https://github.com/zeux/meshoptimizer/blob/master/gltf/parsegltf.cpp
+    std::atomic_bool failed = false;
+    std::atomic_bool warned = false;
+    nvutils::parallel_batches<1>(compressedViews.size(), [&](uint64_t viewIdx) {
+      const EXT_meshopt_compression& mcomp  = compressedViews[viewIdx].mcomp;
+      const unsigned char*           source = &m_model.buffers[mcomp.buffer].data[mcomp.byteOffset];
+      unsigned char*                 result = compressedViews[viewIdx].result;
 
-          case EXT_meshopt_compression::MESHOPT_COMPRESSION_MODE_INDICES:
-            warn = meshopt_decodeIndexVersion(source, mcomp.byteLength) != 1;
-            rc   = meshopt_decodeIndexSequence(result, mcomp.count, mcomp.byteStride, source, mcomp.byteLength);
-            break;
+      int  rc   = -1;
+      bool warn = false;
 
-          default:
-            break;
-        }
+      switch(mcomp.compressionMode)
+      {
+        case EXT_meshopt_compression::MESHOPT_COMPRESSION_MODE_ATTRIBUTES:
+          warn = meshopt_decodeVertexVersion(source, mcomp.byteLength) != 0;
+          rc   = meshopt_decodeVertexBuffer(result, mcomp.count, mcomp.byteStride, source, mcomp.byteLength);
+          break;
 
-        if(rc != 0)
-        {
-          LOGW("EXT_meshopt_compression decompression failed\n");
-          clearParsedData();
-          return false;
-        }
+        case EXT_meshopt_compression::MESHOPT_COMPRESSION_MODE_TRIANGLES:
+          warn = meshopt_decodeIndexVersion(source, mcomp.byteLength) != 1;
+          rc   = meshopt_decodeIndexBuffer(result, mcomp.count, mcomp.byteStride, source, mcomp.byteLength);
+          break;
 
-        if(warn && !warned)
-        {
-          LOGW("Warning: EXT_meshopt_compression data uses versions outside of the glTF specification (vertex 0 / index 1 expected)\n");
-          warned = true;
-        }
+        case EXT_meshopt_compression::MESHOPT_COMPRESSION_MODE_INDICES:
+          warn = meshopt_decodeIndexVersion(source, mcomp.byteLength) != 1;
+          rc   = meshopt_decodeIndexSequence(result, mcomp.count, mcomp.byteStride, source, mcomp.byteLength);
+          break;
 
-        switch(mcomp.compressionFilter)
-        {
-          case EXT_meshopt_compression::MESHOPT_COMPRESSION_FILTER_OCTAHEDRAL:
-            meshopt_decodeFilterOct(result, mcomp.count, mcomp.byteStride);
-            break;
+        default:
+          break;
+      }
 
-          case EXT_meshopt_compression::MESHOPT_COMPRESSION_FILTER_QUATERNION:
-            meshopt_decodeFilterQuat(result, mcomp.count, mcomp.byteStride);
-            break;
+      if(rc != 0)
+        failed = true;
+      if(warn)
+        warned = true;
+    });
 
-          case EXT_meshopt_compression::MESHOPT_COMPRESSION_FILTER_EXPONENTIAL:
-            meshopt_decodeFilterExp(result, mcomp.count, mcomp.byteStride);
-            break;
+    if(failed)
+    {
+      LOGW("EXT_meshopt_compression decompression failed\n");
+      clearParsedData();
+      return false;
+    }
 
-          default:
-            break;
-        }
+    if(warned)
+    {
+      LOGW("Warning: EXT_meshopt_compression data uses versions outside of the glTF specification (vertex 0 / index 1 expected)\n");
+    }
 
-        // remove extension for saving uncompressed
-        bufferView.extensions.erase(EXT_MESHOPT_COMPRESSION_EXTENSION_NAME);
+    // The filters work per element: large views are split in chunks so they don't serialize the work
+    struct FilterChunk
+    {
+      uint32_t view;
+      size_t   first;
+      size_t   count;
+    };
+    constexpr size_t         kFilterChunkSize = 64 * 1024;
+    std::vector<FilterChunk> filterChunks;
+    for(uint32_t viewIdx = 0; viewIdx < uint32_t(compressedViews.size()); viewIdx++)
+    {
+      const EXT_meshopt_compression& mcomp = compressedViews[viewIdx].mcomp;
+      if(mcomp.compressionFilter == EXT_meshopt_compression::MESHOPT_COMPRESSION_FILTER_NONE)
+        continue;
+      for(size_t first = 0; first < mcomp.count; first += kFilterChunkSize)
+      {
+        filterChunks.push_back({viewIdx, first, std::min(kFilterChunkSize, mcomp.count - first)});
       }
-
-      isFullyCompressedBuffer[bufferView.buffer] = 0;
     }
 
+    nvutils::parallel_batches<1>(filterChunks.size(), [&](uint64_t chunkIdx) {
+      const FilterChunk&             chunk  = filterChunks[chunkIdx];
+      const EXT_meshopt_compression& mcomp  = compressedViews[chunk.view].mcomp;
+      unsigned char*                 result = compressedViews[chunk.view].result + chunk.first * mcomp.byteStride;
+
+      switch(mcomp.compressionFilter)
+      {
+        case EXT_meshopt_compression::MESHOPT_COMPRESSION_FILTER_OCTAHEDRAL:
+          meshopt_decodeFilterOct(result, chunk.count, mcomp.byteStride);
+          break;
+
+        case EXT_meshopt_compression::MESHOPT_COMPRESSION_FILTER_QUATERNION:
+          meshopt_decodeFilterQuat(result, chunk.count, mcomp.byteStride);
+          break;
+
+        case EXT_meshopt_compression::MESHOPT_COMPRESSION_FILTER_EXPONENTIAL:
+          meshopt_decodeFilterExp(result, chunk.count, mcomp.byteStride);
+          break;
+
+        default:
+          break;
+      }
+    });
+
     // remove fully compressed buffers
     // isFullyCompressedBuffer is repurposed as buffer index remap table
     size_t writeIndex = 0;
@@ -290,6 +373,59 @@ bool nvvkgltf::Scene::load(const std::filesystem::path& filename)
   return result;
 }
 
+bool nvvkgltf::benchmarkLoaderBackends(std::span<const std::filesystem::path> files, uint32_t repetitions)
+{
+  struct Backend
+  {
+    Scene::LoaderBackend backend;
+    const char*          name;
+  };
+  const Backend backends[] = {{Scene::LoaderBackend::eTinygltf, "tinygltf"}, {Scene::LoaderBackend::eCgltf, "cgltf"}};
+
+  bool success = true;
+  LOGI("%-40s %12s %12s %8s\n", "File", "tinygltf ms", "cgltf ms", "Speedup");
+  for(const std::filesystem::path& file : files)
+  {
+    double medians[2]{};
+    size_t renderNodes[2]{};
+    size_t renderPrimitives[2]{};
+    for(int b = 0; b < 2; b++)
+    {
+      std::vector<double> times;
+      for(uint32_t r = 0; r < std::max(repetitions, 1U); r++)
+      {
+        Scene scene;
+        scene.setLoaderBackend(backends[b].backend);
+        nvutils::PerformanceTimer timer;
+        if(!scene.load(file))
+        {
+          LOGW("%s failed to load %s\n", backends[b].name, nvutils::utf8FromPath(file).c_str());
+          success = false;
+          break;
+        }
+        times.push_back(timer.getMilliseconds());
+        renderNodes[b]      = scene.getRenderNodes().size();
+        renderPrimitives[b] = scene.getNumRenderPrimitives();
+      }
+      if(times.empty())
+        continue;
+      std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+      medians[b] = times[times.size() / 2];
+    }
+
+    if(renderNodes[0] != renderNodes[1] || renderPrimitives[0] != renderPrimitives[1])
+    {
+      LOGW("%s: the backends differ, %zu / %zu render nodes and %zu / %zu render primitives\n",
+           nvutils::utf8FromPath(file).c_str(), renderNodes[0], renderNodes[1], renderPrimitives[0], renderPrimitives[1]);
+      success = false;
+      continue;
+    }
+    LOGI("%-40s %12.2f %12.2f %7.2fx\n", nvutils::utf8FromPath(file.filename()).c_str(), medians[0], medians[1],
+         medians[1] > 0.0 ? medians[0] / medians[1] : 0.0);
+  }
+  return success;
+}
+
 bool nvvkgltf::Scene::save(const std::filesystem::path& filename)
 {
   namespace fs = std::filesystem;
@@ -375,6 +511,8 @@ void nvvkgltf::Scene::parseScene()
     createRootIfMultipleNodes(scene);
   }
   m_sceneRootNode = m_model.scenes[m_currentScene].nodes[0];  // Set the root node of the scene
+  m_nodeRenderNodes.resize(m_model.nodes.size());
+  hashAccessorContents();
 
   // There must be at least one material in the scene
   if(m_model.materials.empty())
@@ -424,9 +562,41 @@ void nvvkgltf::Scene::parseScene()
   }
 
   // We are updating the scene to the first state, animation, skinning, morph, ..
+  buildNodeHierarchy();
   updateRenderNodes();
 }
 
+// Parents of the nodes of the current scene, to update only the subtrees of the dirty nodes
+void nvvkgltf::Scene::buildNodeHierarchy()
+{
+  m_nodeParents.assign(m_model.nodes.size(), kNodeNotInScene);
+  m_nodeRenderNodes.resize(m_model.nodes.size());
+  m_nodesDirty.assign(m_model.nodes.size(), 0);
+  m_dirtyNodes.clear();
+
+  std::vector<int> stack;
+  for(const int sceneNode : m_model.scenes[m_currentScene].nodes)
+  {
+    m_nodeParents[sceneNode] = -1;
+    stack.push_back(sceneNode);
+  }
+  while(!stack.empty())
+  {
+    const int nodeID = stack.back();
+    stack.pop_back();
+    for(const int child : m_model.nodes[nodeID].children)
+    {
+      m_nodeParents[child] = nodeID;
+      stack.push_back(child);
+    }
+  }
+
+  // Forces a full update
+  m_nodesWorldMatrices.clear();
+  m_allNodesDirty  = true;
+  m_materialsDirty = true;
+}
+
 
 // This function recursively updates the visibility of nodes in the scene graph.
 // If a node is marked as not visible, all its children will also be marked as not visible,
@@ -530,61 +700,199 @@ void nvvkgltf::Scene::createSceneCamera()
   tnode.rotation    = {q.x, q.y, q.z, q.w};
 }
 
-// This function will update the matrices and the materials of the render nodes
-void nvvkgltf::Scene::updateRenderNodes()
+// This function will update the matrices, the materials and the visibility of the render nodes,
+// traversing only the subtrees of the dirty nodes
+const std::vector<uint32_t>& nvvkgltf::Scene::updateRenderNodes()
 {
   const tinygltf::Scene& scene = m_model.scenes[m_currentScene];
   assert(scene.nodes.size() > 0 && "No nodes in the glTF file");
   //assert(scene.nodes.size() == 1 && "Only one top node per scene is supported");
   assert(m_sceneRootNode > -1 && "No root node in the scene");
 
-  m_nodesWorldMatrices.resize(m_model.nodes.size());
+  m_dirtyRenderNodes.clear();
+  m_updateStamp++;
 
-  uint32_t renderNodeID = 0;  // Index of the render node
-  for(auto& sceneNode : scene.nodes)
+  // First update after parsing: every node is placed, and every skin is evaluated
+  const bool firstUpdate = m_nodesWorldMatrices.size() != m_model.nodes.size();
+  if(firstUpdate)
   {
-    tinygltf::utils::traverseSceneGraph(
-        m_model, sceneNode, glm::mat4(1),  //
-        nullptr,                           // Camera fct
-        // Dealing with lights
-        [&](int nodeID, const glm::mat4& mat) {
-          tinygltf::Node& tnode             = m_model.nodes[nodeID];
-          m_lights[tnode.light].worldMatrix = mat;
-          return false;  // Continue traversal
-        },
-        // Dealing with Nodes and Variant Materials
-        [&](int nodeID, const glm::mat4& mat) {
-          tinygltf::Node&       tnode = m_model.nodes[nodeID];
-          const tinygltf::Mesh& mesh  = m_model.meshes[tnode.mesh];
-          for(size_t j = 0; j < mesh.primitives.size(); j++)
-          {
-            const tinygltf::Primitive& primitive  = mesh.primitives[j];
-            nvvkgltf::RenderNode&      renderNode = m_renderNodes[renderNodeID];
-            renderNode.worldMatrix                = mat;
-            renderNode.materialID                 = getMaterialVariantIndex(primitive, m_currentVariant);
-            renderNodeID++;
-          }
-          return false;  // Continue traversal
-        },
-        [&](int nodeID, const glm::mat4& mat) {
-          m_nodesWorldMatrices[nodeID] = mat;
-          return false;
-        });
+    m_nodesWorldMatrices.assign(m_model.nodes.size(), glm::mat4(1));
+    m_nodesVisible.assign(m_model.nodes.size(), 1);
+    m_nodesMovedStamp.assign(m_model.nodes.size(), 0);
+    m_allNodesDirty = true;
   }
 
-  // Update the visibility of the render nodes
-  renderNodeID = 0;
-  for(const int sceneNode : m_model.scenes[m_currentScene].nodes)
+  if(m_allNodesDirty)
+  {
+    for(const int sceneNode : scene.nodes)
+    {
+      updateSubtree(sceneNode, glm::mat4(1), true);
+    }
+  }
+  else
+  {
+    for(const int nodeID : m_dirtyNodes)
+    {
+      const int parent = m_nodeParents[nodeID];
+      if(parent == kNodeNotInScene)
+        continue;
+
+      // The subtree of a dirty ancestor already contains this node
+      bool ancestorDirty = false;
+      for(int ancestor = parent; ancestor >= 0 && !ancestorDirty; ancestor = m_nodeParents[ancestor])
+      {
+        ancestorDirty = m_nodesDirty[ancestor] != 0;
+      }
+      if(!ancestorDirty)
+      {
+        updateSubtree(nodeID, parent >= 0 ? m_nodesWorldMatrices[parent] : glm::mat4(1), parent < 0 || m_nodesVisible[parent]);
+      }
+    }
+  }
+
+  for(const int nodeID : m_dirtyNodes)
+  {
+    m_nodesDirty[nodeID] = 0;
+  }
+  m_dirtyNodes.clear();
+  m_allNodesDirty  = false;
+  m_materialsDirty = false;
+
+  // Edited materials, published with the other changes
+  m_dirtyMaterials.swap(m_editedMaterials);
+  m_editedMaterials.clear();
+  for(const uint32_t materialID : m_dirtyMaterials)
+  {
+    m_materialsEdited[materialID] = 0;
+  }
+  std::sort(m_dirtyMaterials.begin(), m_dirtyMaterials.end());
+
+  std::sort(m_dirtyRenderNodes.begin(), m_dirtyRenderNodes.end());
+  updateDirtyPrimitives(firstUpdate);
+
+  return m_dirtyRenderNodes;
+}
+
+void nvvkgltf::Scene::markNodeDirty(int nodeID)
+{
+  if(nodeID < 0 || nodeID >= static_cast<int>(m_nodesDirty.size()) || m_nodesDirty[nodeID])
+    return;
+
+  m_nodesDirty[nodeID] = 1;
+  m_dirtyNodes.push_back(nodeID);
+}
+
+void nvvkgltf::Scene::markMaterialDirty(int materialID)
+{
+  if(materialID < 0 || materialID >= static_cast<int>(m_model.materials.size()))
+    return;
+
+  // Materials can be added to the model after the load
+  m_materialsEdited.resize(m_model.materials.size(), 0);
+  if(m_materialsEdited[materialID])
+    return;
+
+  m_materialsEdited[materialID] = 1;
+  m_editedMaterials.push_back(materialID);
+}
+
+// Recomputes the world matrix and visibility of the node and its children, and of their
+// render nodes and lights. Render nodes that changed are added to m_dirtyRenderNodes.
+void nvvkgltf::Scene::updateSubtree(int nodeID, const glm::mat4& parentMatrix, bool parentVisible)
+{
+  const tinygltf::Node& node    = m_model.nodes[nodeID];
+  const glm::mat4       world   = parentMatrix * tinygltf::utils::getNodeMatrix(node);
+  const bool            visible = parentVisible && tinygltf::utils::getNodeVisibility(node).visible;
+
+  if(world != m_nodesWorldMatrices[nodeID])
+  {
+    m_nodesWorldMatrices[nodeID] = world;
+    m_nodesMovedStamp[nodeID]    = m_updateStamp;
+  }
+  m_nodesVisible[nodeID] = visible ? 1 : 0;
+
+  if(node.light > -1)
+  {
+    m_lights[node.light].worldMatrix = world;
+  }
+
+  if(node.mesh > -1)
+  {
+    const RenderNodeRange& range     = m_nodeRenderNodes[nodeID];
+    const tinygltf::Mesh&  mesh      = m_model.meshes[node.mesh];
+    const auto             instances = m_nodeInstanceMatrices.find(nodeID);
+    // Instanced render nodes are ordered by primitive, then by instance
+    const uint32_t perPrimitive = std::max(1U, range.count / std::max(1U, uint32_t(mesh.primitives.size())));
+
+    for(uint32_t k = 0; k < range.count; k++)
+    {
+      const uint32_t        renderNodeID = range.first + k;
+      nvvkgltf::RenderNode& renderNode   = m_renderNodes[renderNodeID];
+      const glm::mat4       worldMatrix  = instances != m_nodeInstanceMatrices.end() ? world * instances->second[k] : world;
+      const int             materialID =
+          m_materialsDirty ? getMaterialVariantIndex(mesh.primitives[k / perPrimitive], m_currentVariant) : renderNode.materialID;
+
+      if(renderNode.worldMatrix != worldMatrix || renderNode.visible != visible || renderNode.materialID != materialID)
+      {
+        renderNode.worldMatrix = worldMatrix;
+        renderNode.visible     = visible;
+        renderNode.materialID  = materialID;
+        m_dirtyRenderNodes.push_back(renderNodeID);
+      }
+    }
+  }
+
+  for(const int child : node.children)
+  {
+    updateSubtree(child, world, visible);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Collect the render primitives that changed in the last `updateRenderNodes`
+//
+void nvvkgltf::Scene::updateDirtyPrimitives(bool firstUpdate)
+{
+  m_dirtyRenderPrimitives.clear();
+
+  // Morph targets: weights changed by the animation
+  for(uint32_t renderPrimID : m_morphPrimitives)
+  {
+    if(m_morphedMeshes.contains(m_renderPrimitives[renderPrimID].meshID))
+    {
+      m_dirtyRenderPrimitives.push_back(renderPrimID);
+    }
+  }
+  m_morphedMeshes.clear();
+
+  // Skinning: the node or one of its joints moved
+  auto nodeMoved = [&](int nodeID) { return firstUpdate || m_nodesMovedStamp[nodeID] == m_updateStamp; };
+  for(uint32_t skinNodeID : m_skinNodes)
   {
-    KHR_node_visibility nvisible = tinygltf::utils::getNodeVisibility(m_model.nodes[sceneNode]);
-    updateVisibility(sceneNode, nvisible.visible, renderNodeID);
+    const nvvkgltf::RenderNode& skinNode = m_renderNodes[skinNodeID];
+    bool                        moved    = nodeMoved(skinNode.refNodeID);
+    for(size_t j = 0; j < m_model.skins[skinNode.skinID].joints.size() && !moved; j++)
+    {
+      moved = nodeMoved(m_model.skins[skinNode.skinID].joints[j]);
+    }
+    if(moved)
+    {
+      m_dirtyRenderPrimitives.push_back(uint32_t(skinNode.renderPrimID));
+    }
   }
+
+  // A primitive can be both morphed and skinned, or skinned by several nodes
+  std::sort(m_dirtyRenderPrimitives.begin(), m_dirtyRenderPrimitives.end());
+  m_dirtyRenderPrimitives.erase(std::unique(m_dirtyRenderPrimitives.begin(), m_dirtyRenderPrimitives.end()),
+                                m_dirtyRenderPrimitives.end());
 }
 
 void nvvkgltf::Scene::setCurrentVariant(int variant)
 {
   m_currentVariant = variant;
   // Updating the render nodes with the new material variant
+  m_materialsDirty = true;
+  m_allNodesDirty  = true;
   updateRenderNodes();
 }
 
@@ -602,6 +910,12 @@ void nvvkgltf::Scene::clearParsedData()
   m_sceneBounds     = {};
   m_sceneCameraNode = -1;
   m_sceneRootNode   = -1;
+  m_nodeRenderNodes.clear();
+  m_nodeInstanceMatrices.clear();
+  m_nodesWorldMatrices.clear();
+  m_dirtyMaterials.clear();
+  m_editedMaterials.clear();
+  m_materialsEdited.clear();
 }
 
 void nvvkgltf::Scene::destroy()
@@ -615,23 +929,146 @@ void nvvkgltf::Scene::destroy()
 // Get the unique index of a primitive, and add it to the list if it is not already there
 int nvvkgltf::Scene::getUniqueRenderPrimitive(tinygltf::Primitive& primitive, int meshID)
 {
-  const std::string& key = tinygltf::utils::generatePrimitiveKey(primitive);
+  const uint64_t key = getPrimitiveHash(primitive);
+
+  // Primitives with the same hash, which are the same unless the hashes collide
+  auto [first, last] = m_uniquePrimitiveIndex.equal_range(key);
+  for(auto it = first; it != last; ++it)
+  {
+    if(isSamePrimitive(primitive, *m_renderPrimitives[it->second].pPrimitive))
+      return it->second;
+  }
+
+  const int renderPrimID = static_cast<int>(m_renderPrimitives.size());
+  m_uniquePrimitiveIndex.emplace(key, renderPrimID);
 
-  // Attempt to insert the key with the next available index if it doesn't exist
-  auto [it, inserted] = m_uniquePrimitiveIndex.try_emplace(key, static_cast<int>(m_uniquePrimitiveIndex.size()));
+  nvvkgltf::RenderPrimitive renderPrim;
+  renderPrim.pPrimitive  = &primitive;
+  renderPrim.vertexCount = int(tinygltf::utils::getVertexCount(m_model, primitive));
+  renderPrim.indexCount  = int(tinygltf::utils::getIndexCount(m_model, primitive));
+  renderPrim.meshID      = meshID;
+  m_renderPrimitives.push_back(renderPrim);
 
-  // If the primitive was newly inserted, add it to the render primitives list
-  if(inserted)
+  return renderPrimID;
+}
+
+// Bytes of a tightly packed and non-sparse accessor, empty otherwise
+static std::span<const unsigned char> getPackedAccessorBytes(const tinygltf::Model& model, const tinygltf::Accessor& accessor)
+{
+  if(accessor.sparse.isSparse || accessor.bufferView < 0)
+    return {};
+
+  const tinygltf::BufferView& view          = model.bufferViews[accessor.bufferView];
+  const int                   componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+  const int                   numComponents = tinygltf::GetNumComponentsInType(accessor.type);
+  if(componentSize <= 0 || numComponents <= 0)
+    return {};
+  const size_t elementSize = size_t(componentSize) * size_t(numComponents);
+  if(view.byteStride != 0 && view.byteStride != elementSize)
+    return {};
+
+  const tinygltf::Buffer& buffer = model.buffers[view.buffer];
+  const size_t            offset = view.byteOffset + accessor.byteOffset;
+  const size_t            size   = elementSize * accessor.count;
+  if(offset + size > buffer.data.size())
+    return {};
+  return {buffer.data.data() + offset, size};
+}
+
+// Hash of the accessors of the primitive, or of their content with setContentDeduplication
+uint64_t nvvkgltf::Scene::getPrimitiveHash(const tinygltf::Primitive& primitive) const
+{
+  const bool byContent   = m_contentDeduplication && primitive.targets.empty();
+  const auto accessorKey = [&](int accessorID) -> uint64_t {
+    if(byContent && accessorID >= 0 && m_accessorContentHashes[accessorID] != 0)
+      return m_accessorContentHashes[accessorID];
+    return uint64_t(int64_t(accessorID));
+  };
+
+  std::size_t hash = 0;
+  nvutils::hashCombine(hash, accessorKey(primitive.indices));
+  for(const auto& [name, accessorID] : primitive.attributes)
+  {
+    nvutils::hashCombine(hash, std::string_view(name), accessorKey(accessorID));
+  }
+  return hash;
+}
+
+// Same accessors, or accessors with the same content with setContentDeduplication
+bool nvvkgltf::Scene::isSamePrimitive(const tinygltf::Primitive& a, const tinygltf::Primitive& b) const
+{
+  if(&a == &b)
+    return true;
+  if(a.attributes.size() != b.attributes.size())
+    return false;
+
+  const bool byContent    = m_contentDeduplication && a.targets.empty() && b.targets.empty();
+  const auto sameAccessor = [&](int idA, int idB) {
+    if(idA == idB)
+      return true;
+    if(!byContent || idA < 0 || idB < 0 || m_accessorContentHashes[idA] == 0 || m_accessorContentHashes[idA] != m_accessorContentHashes[idB])
+      return false;
+
+    const tinygltf::Accessor& accA = m_model.accessors[idA];
+    const tinygltf::Accessor& accB = m_model.accessors[idB];
+    if(accA.type != accB.type || accA.componentType != accB.componentType || accA.count != accB.count
+       || accA.normalized != accB.normalized)
+      return false;
+    const std::span<const unsigned char> bytesA = getPackedAccessorBytes(m_model, accA);
+    const std::span<const unsigned char> bytesB = getPackedAccessorBytes(m_model, accB);
+    return bytesA.size() == bytesB.size() && memcmp(bytesA.data(), bytesB.data(), bytesA.size()) == 0;
+  };
+
+  if(!sameAccessor(a.indices, b.indices))
+    return false;
+  for(auto itA = a.attributes.begin(), itB = b.attributes.begin(); itA != a.attributes.end(); ++itA, ++itB)
+  {
+    if(itA->first != itB->first || !sameAccessor(itA->second, itB->second))
+      return false;
+  }
+  return true;
+}
+
+// Hashes the content of the accessors of the mesh primitives in parallel, see setContentDeduplication
+void nvvkgltf::Scene::hashAccessorContents()
+{
+  m_accessorContentHashes.assign(m_model.accessors.size(), 0);
+  if(!m_contentDeduplication)
+    return;
+
+  nvutils::ScopedTimer st(__FUNCTION__);
+
+  std::vector<int>     accessors;
+  std::vector<uint8_t> used(m_model.accessors.size(), 0);
+  const auto           addAccessor = [&](int accessorID) {
+    if(accessorID >= 0 && accessorID < int(used.size()) && !used[accessorID])
+    {
+      used[accessorID] = 1;
+      accessors.push_back(accessorID);
+    }
+  };
+  for(const tinygltf::Mesh& mesh : m_model.meshes)
   {
-    nvvkgltf::RenderPrimitive renderPrim;
-    renderPrim.pPrimitive  = &primitive;
-    renderPrim.vertexCount = int(tinygltf::utils::getVertexCount(m_model, primitive));
-    renderPrim.indexCount  = int(tinygltf::utils::getIndexCount(m_model, primitive));
-    renderPrim.meshID      = meshID;
-    m_renderPrimitives.push_back(renderPrim);
+    for(const tinygltf::Primitive& primitive : mesh.primitives)
+    {
+      if(!primitive.targets.empty())
+        continue;
+      addAccessor(primitive.indices);
+      for(const auto& [name, accessorID] : primitive.attributes)
+        addAccessor(accessorID);
+    }
   }
 
-  return it->second;
+  nvutils::parallel_batches_auto(accessors.size(), [&](uint64_t i) {
+    const tinygltf::Accessor&            accessor = m_model.accessors[accessors[i]];
+    const std::span<const unsigned char> bytes    = getPackedAccessorBytes(m_model, accessor);
+    if(bytes.empty())
+      return;  // Strided or sparse, deduplicated by index only
+
+    std::size_t hash = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+    nvutils::hashCombine(hash, accessor.type, accessor.componentType, accessor.normalized);
+    m_accessorContentHashes[accessors[i]] = hash != 0 ? hash : 1;
+  });
 }
 
 
@@ -798,6 +1235,7 @@ bool nvvkgltf::Scene::handleRenderNode(int nodeID, glm::mat4 worldMatrix)
 {
   const tinygltf::Node& node = m_model.nodes[nodeID];
   tinygltf::Mesh&       mesh = m_model.meshes[node.mesh];
+  m_nodeRenderNodes[nodeID].first = static_cast<uint32_t>(m_renderNodes.size());
   for(size_t primID = 0; primID < mesh.primitives.size(); primID++)
   {
     tinygltf::Primitive& primitive    = mesh.primitives[primID];
@@ -824,6 +1262,7 @@ bool nvvkgltf::Scene::handleRenderNode(int nodeID, glm::mat4 worldMatrix)
       m_numTriangles += numTriangles;  // Statistics
     }
   }
+  m_nodeRenderNodes[nodeID].count = static_cast<uint32_t>(m_renderNodes.size()) - m_nodeRenderNodes[nodeID].first;
   return false;  // Continue traversal
 }
 
@@ -857,6 +1296,7 @@ size_t nvvkgltf::Scene::handleGpuInstancing(const tinygltf::Value& attributes, n
 
     instNode.worldMatrix = worldMatrix * mat;
     m_renderNodes.push_back(instNode);
+    m_nodeInstanceMatrices[renderNode.refNodeID].push_back(mat);
   }
   return numInstances;
 }
@@ -884,11 +1324,67 @@ void nvvkgltf::Scene::createMissingTangents()
     }
   }
 
-  // Generate the tangents in parallel
-  nvutils::parallel_batches<1>(missTangentPrimitives.size(), [&](uint64_t primID) {
-    tinygltf::Primitive& primitive = *m_renderPrimitives[missTangentPrimitives[primID]].pPrimitive;
-    tinygltf::utils::simpleCreateTangents(m_model, primitive);
+  if(missTangentPrimitives.empty())
+    return;
+
+  // Tangents generated by a previous load of the same file: one chunk per primitive
+  constexpr uint32_t    kTangentCacheMagic = 0x474e4154;  // 'TANG'
+  std::filesystem::path cacheFile;
+  uint64_t              cacheKey = 0;
+  if(!m_cacheDirectory.empty())  // 0 without a source file
+    cacheKey = cache::getFileKey(m_filename, cache::combineKey(missTangentPrimitives.size(), uint64_t(m_tangentMethod)));
+  if(cacheKey != 0)
+  {
+    cacheFile = m_cacheDirectory / fmt::format("{}_{:016x}.tangents", nvutils::utf8FromPath(m_filename.stem()), cacheKey);
+
+    cache::Reader reader;
+    if(reader.open(cacheFile, kTangentCacheMagic, cacheKey) && reader.getNumChunks() == missTangentPrimitives.size())
+    {
+      bool valid = true;
+      for(size_t i = 0; i < missTangentPrimitives.size() && valid; i++)
+      {
+        tinygltf::Primitive& primitive = *m_renderPrimitives[missTangentPrimitives[i]].pPrimitive;
+        std::span<glm::vec4> tangents  = tinygltf::utils::getAttributeData3<glm::vec4>(m_model, primitive, "TANGENT", nullptr);
+        valid = reader.getChunk(i).size() == tangents.size_bytes();
+        if(valid)
+          memcpy(tangents.data(), reader.getChunk(i).data(), tangents.size_bytes());
+      }
+      if(valid)
+        return;
+    }
+  }
+
+  // Generate the tangents in parallel: the small primitives together, the large ones one at a time split in vertex ranges
+  constexpr int    kLargeVertexCount = 1 << 20;
+  std::vector<int> smallPrimitives;
+  for(int renderPrimID : missTangentPrimitives)
+  {
+    if(m_renderPrimitives[renderPrimID].vertexCount < kLargeVertexCount)
+    {
+      smallPrimitives.push_back(renderPrimID);
+      continue;
+    }
+    const uint32_t numRanges = uint32_t(nvutils::get_thread_pool().get_thread_count());
+    tinygltf::utils::createTangents(m_model, *m_renderPrimitives[renderPrimID].pPrimitive, m_tangentMethod, numRanges);
+  }
+  nvutils::parallel_batches<1>(smallPrimitives.size(), [&](uint64_t primID) {
+    tinygltf::Primitive& primitive = *m_renderPrimitives[smallPrimitives[primID]].pPrimitive;
+    tinygltf::utils::createTangents(m_model, primitive, m_tangentMethod);
   });
+
+  if(!cacheFile.empty())
+  {
+    std::vector<std::span<const char>> chunks;
+    for(int renderPrimID : missTangentPrimitives)
+    {
+      std::span<glm::vec4> tangents =
+          tinygltf::utils::getAttributeData3<glm::vec4>(m_model, *m_renderPrimitives[renderPrimID].pPrimitive, "TANGENT", nullptr);
+      chunks.push_back({reinterpret_cast<const char*>(tangents.data()), tangents.size_bytes()});
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(m_cacheDirectory, ec);
+    cache::save(cacheFile, kTangentCacheMagic, cacheKey, chunks);
+  }
 }
 
 
@@ -946,6 +1442,7 @@ void nvvkgltf::Scene::setSceneRootNode(const tinygltf::Node& node)
   tinygltf::Node& rootNode = m_model.nodes[scene.nodes[0]];  // Root node
   rootNode                 = node;
 
+  markNodeDirty(scene.nodes[0]);
   updateRenderNodes();
 }
 
@@ -1146,225 +1643,328 @@ void nvvkgltf::Scene::parseAnimations()
 // - Morph target weights are updated
 bool nvvkgltf::Scene::updateAnimation(uint32_t animationIndex)
 {
-  bool       animated  = false;
-  Animation& animation = m_animations[animationIndex];
-  float      time      = animation.info.currentTime;
+  sampleAnimation(animationIndex);
+  return applyAnimation(animationIndex);
+}
 
-  for(auto& channel : animation.channels)
+//--------------------------------------------------------------------------------------------------
+// Update several animations (e.g. crowds): sampling only reads the keyframes of each animation,
+// so the animations are sampled in parallel, then written to the model one after the other.
+// The indices must be distinct.
+bool nvvkgltf::Scene::updateAnimations(std::span<const uint32_t> animationIndices)
+{
+  nvutils::parallel_batches_pooled<1>(animationIndices.size(),
+                                      [&](uint64_t i, uint32_t /*threadIdx*/) { sampleAnimation(animationIndices[i]); });
+
+  bool animated = false;
+  for(uint32_t animationIndex : animationIndices)
   {
-    if(channel.node < 0 || channel.node >= m_model.nodes.size())  // Invalid node
-      continue;
+    animated |= applyAnimation(animationIndex);
+  }
+  return animated;
+}
+
+void nvvkgltf::Scene::AnimationLanes::clear()
+{
+  channels.clear();
+  c0.clear();
+  c1.clear();
+  cA.clear();
+  cB.clear();
+  slerpT.clear();
+  for(int c = 0; c < 4; c++)
+  {
+    v0[c].clear();
+    v1[c].clear();
+    a[c].clear();
+    b[c].clear();
+  }
+}
 
-    tinygltf::Node&   gltfNode = m_model.nodes[channel.node];
-    AnimationSampler& sampler  = animation.samplers[channel.samplerIndex];
+void nvvkgltf::Scene::AnimationLanes::add(uint32_t     channel,
+                                          int          numComponents,
+                                          const float* pv0,
+                                          const float* pv1,
+                                          const float* pa,
+                                          const float* pb,
+                                          float        t0,
+                                          float        t1,
+                                          float        tA,
+                                          float        tB)
+{
+  channels.push_back(channel);
+  c0.push_back(t0);
+  c1.push_back(t1);
+  cA.push_back(tA);
+  cB.push_back(tB);
+  slerpT.push_back(-1.0f);
+  for(int c = 0; c < 4; c++)
+  {
+    const bool valid = c < numComponents;
+    v0[c].push_back(valid ? pv0[c] : 0.0f);
+    v1[c].push_back(valid && pv1 ? pv1[c] : 0.0f);
+    a[c].push_back(valid && pa ? pa[c] : 0.0f);
+    b[c].push_back(valid && pb ? pb[c] : 0.0f);
+  }
+}
 
-    if(channel.path == AnimationChannel::PathType::ePointer)
-    {
-      static std::unordered_set<int> warnedAnimations;
-      if(warnedAnimations.insert(animationIndex).second)
-      {
-        LOGE("AnimationChannel::PathType::POINTER not implemented for animation %d", animationIndex);
-      }
+// Weights of glm::slerp, taking the shortest path
+void nvvkgltf::Scene::AnimationLanes::computeSlerpWeights()
+{
+  for(size_t i = 0; i < channels.size(); i++)
+  {
+    const float t = slerpT[i];
+    if(t < 0.0f)
       continue;
+
+    float       cosTheta = v0[0][i] * v1[0][i] + v0[1][i] * v1[1][i] + v0[2][i] * v1[2][i] + v0[3][i] * v1[3][i];
+    const float sign     = cosTheta < 0.0f ? -1.0f : 1.0f;
+    cosTheta *= sign;
+    if(cosTheta > 1.0f - std::numeric_limits<float>::epsilon())
+    {
+      // Linear interpolation, to avoid the division by sin(angle) close to 0
+      c0[i] = 1.0f - t;
+      c1[i] = sign * t;
+    }
+    else
+    {
+      const float angle  = std::acos(cosTheta);
+      const float invSin = 1.0f / std::sin(angle);
+      c0[i]              = std::sin((1.0f - t) * angle) * invSin;
+      c1[i]              = sign * std::sin(t * angle) * invSin;
     }
+  }
+}
 
-    animated |= processAnimationChannel(gltfNode, sampler, channel, time, animationIndex);
+// Same operation on all the lanes, the loops over the components vectorize
+void nvvkgltf::Scene::AnimationLanes::evaluate(int numComponents)
+{
+  const size_t numLanes = channels.size();
+  for(int c = 0; c < numComponents; c++)
+  {
+    result[c].resize(numLanes);
+    const float* pv0 = v0[c].data();
+    const float* pv1 = v1[c].data();
+    const float* pa  = a[c].data();
+    const float* pb  = b[c].data();
+    float*       res = result[c].data();
+    for(size_t i = 0; i < numLanes; i++)
+    {
+      res[i] = c0[i] * pv0[i] + c1[i] * pv1[i] + cA[i] * pa[i] + cB[i] * pb[i];
+    }
   }
+}
 
-  return animated;
+void nvvkgltf::Scene::AnimationLanes::normalizeResults()
+{
+  for(size_t i = 0; i < channels.size(); i++)
+  {
+    const float lengthSq = result[0][i] * result[0][i] + result[1][i] * result[1][i] + result[2][i] * result[2][i]
+                           + result[3][i] * result[3][i];
+    const float invLength = lengthSq > 0.0f ? 1.0f / std::sqrt(lengthSq) : 1.0f;
+    for(int c = 0; c < 4; c++)
+    {
+      result[c][i] *= invLength;
+    }
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
-// Process the animation channel
-// - Interpolates the keyframes
-// - Updates the node transformation
-// - Updates the morph target weights
-bool nvvkgltf::Scene::processAnimationChannel(tinygltf::Node&         gltfNode,
-                                              AnimationSampler&       sampler,
-                                              const AnimationChannel& channel,
-                                              float                   time,
-                                              uint32_t                animationIndex)
+// Find the key before `time`: inputs[key] <= time <= inputs[key + 1], or SIZE_MAX when out of range.
+// Time mostly advances by small steps, so the search starts at the key found last time.
+size_t nvvkgltf::Scene::findAnimationKey(AnimationSampler& sampler, float time)
 {
-  std::unordered_set<int> warnedAnimations;
+  const std::vector<float>& inputs = sampler.inputs;
+  if(inputs.size() < 2 || time < inputs.front() || time > inputs.back())
+    return std::numeric_limits<size_t>::max();
 
-  bool animated = false;
+  auto binarySearch = [&]() {
+    const size_t upper = std::upper_bound(inputs.begin(), inputs.end(), time) - inputs.begin();
+    return std::clamp<size_t>(upper, 1, inputs.size() - 1) - 1;
+  };
 
-  for(size_t i = 0; i < sampler.inputs.size() - 1; i++)
+  size_t key = std::min(sampler.cursor, inputs.size() - 2);
+  if(time < inputs[key])
   {
-    float inputStart = sampler.inputs[i];
-    float inputEnd   = sampler.inputs[i + 1];
-
-    if(inputStart <= time && time <= inputEnd)
+    key = binarySearch();  // Looped or went backward
+  }
+  else
+  {
+    for(int steps = 0; key + 2 < inputs.size() && inputs[key + 1] <= time; steps++)
     {
-      float t  = calculateInterpolationFactor(inputStart, inputEnd, time);
-      animated = true;
-
-      switch(sampler.interpolation)
+      if(steps == 4)
       {
-        case AnimationSampler::InterpolationType::eLinear:
-          handleLinearInterpolation(gltfNode, sampler, channel, t, i);
-          break;
-        case AnimationSampler::InterpolationType::eStep:
-          handleStepInterpolation(gltfNode, sampler, channel, i);
-          break;
-        case AnimationSampler::InterpolationType::eCubicSpline: {
-          float keyDelta = inputEnd - inputStart;
-          handleCubicSplineInterpolation(gltfNode, sampler, channel, t, keyDelta, i);
-          break;
-        }
+        key = binarySearch();  // Large step
+        break;
       }
+      key++;
     }
   }
 
-  return animated;
+  sampler.cursor = key;
+  return key;
 }
 
 //--------------------------------------------------------------------------------------------------
-// Calculate the interpolation factor: [0..1] between two keyframes
-float nvvkgltf::Scene::calculateInterpolationFactor(float inputStart, float inputEnd, float time)
+// Sample all the channels of the animation at its current time into the lanes
+// - Keyframes are found from the cursor of each sampler
+// - Translations, scales and rotations are interpolated in batches, the morph weights in `applyAnimation`
+void nvvkgltf::Scene::sampleAnimation(uint32_t animationIndex)
 {
-  float keyDelta = inputEnd - inputStart;
-  return std::clamp((time - inputStart) / keyDelta, 0.0f, 1.0f);
-}
+  Animation&  animation = m_animations[animationIndex];
+  const float time      = animation.info.currentTime;
 
-//--------------------------------------------------------------------------------------------------
-// Interpolates the keyframes linearly
-void nvvkgltf::Scene::handleLinearInterpolation(tinygltf::Node&         gltfNode,
-                                                AnimationSampler&       sampler,
-                                                const AnimationChannel& channel,
-                                                float                   t,
-                                                size_t                  index)
-{
-  switch(channel.path)
+  animation.vec3Lanes.clear();
+  animation.quatLanes.clear();
+  animation.weightsSamples.clear();
+
+  for(uint32_t channelID = 0; channelID < uint32_t(animation.channels.size()); channelID++)
   {
-    case AnimationChannel::PathType::eRotation: {
-      const glm::quat q1 = glm::make_quat(glm::value_ptr(sampler.outputsVec4[index]));
-      const glm::quat q2 = glm::make_quat(glm::value_ptr(sampler.outputsVec4[index + 1]));
-      glm::quat       q  = glm::normalize(glm::slerp(q1, q2, t));
-      gltfNode.rotation  = {q.x, q.y, q.z, q.w};
-      break;
-    }
-    case AnimationChannel::PathType::eTranslation: {
-      glm::vec3 trans      = glm::mix(sampler.outputsVec3[index], sampler.outputsVec3[index + 1], t);
-      gltfNode.translation = {trans.x, trans.y, trans.z};
-      break;
-    }
-    case AnimationChannel::PathType::eScale: {
-      glm::vec3 s    = glm::mix(sampler.outputsVec3[index], sampler.outputsVec3[index + 1], t);
-      gltfNode.scale = {s.x, s.y, s.z};
-      break;
+    const AnimationChannel& channel = animation.channels[channelID];
+    if(channel.node < 0 || channel.node >= m_model.nodes.size() || channel.path == AnimationChannel::PathType::ePointer)
+      continue;
+
+    AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+    const size_t      key     = findAnimationKey(sampler, time);
+    if(key == std::numeric_limits<size_t>::max())
+      continue;
+
+    const float keyDelta = sampler.inputs[key + 1] - sampler.inputs[key];
+    const float t        = calculateInterpolationFactor(sampler.inputs[key], sampler.inputs[key + 1], time);
+
+    if(channel.path == AnimationChannel::PathType::eWeights)
+    {
+      animation.weightsSamples.push_back({channelID, key, t});
+      continue;
     }
-    case AnimationChannel::PathType::eWeights: {
-      {
-        // Retrieve the mesh from the node
-        if(gltfNode.mesh >= 0)
-        {
-          tinygltf::Mesh& mesh = m_model.meshes[gltfNode.mesh];
 
-          // Make sure the weights vector is resized to match the number of morph targets
-          if(mesh.weights.size() != sampler.outputsFloat[index].size())
-          {
-            mesh.weights.resize(sampler.outputsFloat[index].size());
-          }
+    const bool      isRotation    = channel.path == AnimationChannel::PathType::eRotation;
+    AnimationLanes& lanes         = isRotation ? animation.quatLanes : animation.vec3Lanes;
+    const int       numComponents = isRotation ? 4 : 3;
+    auto value = [&](size_t index) { return isRotation ? &sampler.outputsVec4[index].x : &sampler.outputsVec3[index].x; };
 
-          // Interpolating between weights for morph targets
-          for(size_t j = 0; j < mesh.weights.size(); j++)
-          {
-            float weight1   = sampler.outputsFloat[index][j];
-            float weight2   = sampler.outputsFloat[index + 1][j];
-            mesh.weights[j] = glm::mix(weight1, weight2, t);
-          }
-        }
+    switch(sampler.interpolation)
+    {
+      case AnimationSampler::InterpolationType::eLinear:
+        lanes.add(channelID, numComponents, value(key), value(key + 1), nullptr, nullptr, 1.0f - t, t, 0.0f, 0.0f);
+        if(isRotation)
+          lanes.slerpT.back() = t;
+        break;
+      case AnimationSampler::InterpolationType::eStep:
+        lanes.add(channelID, numComponents, value(key), nullptr, nullptr, nullptr, 1.0f, 0.0f, 0.0f, 0.0f);
+        break;
+      case AnimationSampler::InterpolationType::eCubicSpline: {
+        // Implements the logic in
+        // https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#interpolation-cubic
+        // The keys are stored as (in-tangent, value, out-tangent)
+        const size_t prevIndex = key * 3;
+        const size_t nextIndex = (key + 1) * 3;
+
+        const float tSq = t * t;
+        const float tCb = tSq * t;
+        const float cV1 = -2 * tCb + 3 * tSq;              // -2 t^3 + 3 t^2
+        const float cV0 = 1 - cV1;                         //  2 t^3 - 3 t^2 + 1
+        const float cA  = keyDelta * (tCb - tSq);          // t_d (t^3 - t^2)
+        const float cB  = keyDelta * (tCb - 2 * tSq + t);  // t_d (t^3 - 2 t^2 + t)
+
+        // v_k, v_{k+1}, a_{k+1}, b_k
+        lanes.add(channelID, numComponents, value(prevIndex + 1), value(nextIndex + 1), value(nextIndex), value(prevIndex + 2),
+                  cV0, cV1, cA, cB);
         break;
       }
     }
   }
+
+  animation.quatLanes.computeSlerpWeights();
+  animation.quatLanes.evaluate(4);
+  animation.quatLanes.normalizeResults();
+  animation.vec3Lanes.evaluate(3);
 }
 
 //--------------------------------------------------------------------------------------------------
-// Interpolates the keyframes with a step interpolation
-void nvvkgltf::Scene::handleStepInterpolation(tinygltf::Node& gltfNode, AnimationSampler& sampler, const AnimationChannel& channel, size_t index)
+// Write the sampled animation to the model
+// - Moved nodes are marked dirty for the next updateRenderNodes
+// - Meshes with new morph target weights are kept to blend them again
+bool nvvkgltf::Scene::applyAnimation(uint32_t animationIndex)
 {
-  switch(channel.path)
+  Animation& animation = m_animations[animationIndex];
+  bool       animated  = false;
+
+  for(const AnimationChannel& channel : animation.channels)
   {
-    case AnimationChannel::PathType::eRotation: {
-      glm::quat q       = glm::quat(sampler.outputsVec4[index]);
-      gltfNode.rotation = {q.x, q.y, q.z, q.w};
-      break;
-    }
-    case AnimationChannel::PathType::eTranslation: {
-      glm::vec3 t          = glm::vec3(sampler.outputsVec3[index]);
-      gltfNode.translation = {t.x, t.y, t.z};
-      break;
-    }
-    case AnimationChannel::PathType::eScale: {
-      glm::vec3 s    = glm::vec3(sampler.outputsVec3[index]);
-      gltfNode.scale = {s.x, s.y, s.z};
+    if(channel.path == AnimationChannel::PathType::ePointer)
+    {
+      static std::unordered_set<int> warnedAnimations;
+      if(warnedAnimations.insert(animationIndex).second)
+      {
+        LOGE("AnimationChannel::PathType::POINTER not implemented for animation %d", animationIndex);
+      }
       break;
     }
   }
-}
-
-//--------------------------------------------------------------------------------------------------
-// Interpolates the keyframes with a cubic spline interpolation
-void nvvkgltf::Scene::handleCubicSplineInterpolation(tinygltf::Node&         gltfNode,
-                                                     AnimationSampler&       sampler,
-                                                     const AnimationChannel& channel,
-                                                     float                   t,
-                                                     float                   keyDelta,
-                                                     size_t                  index)
-{
-  // Implements the logic in
-  // https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#interpolation-cubic
-  // for quaternions (first case) and other values (second case).
-
-  const size_t prevIndex = index * 3;
-  const size_t nextIndex = (index + 1) * 3;
-  const size_t A         = 0;  // Offset for the in-tangent
-  const size_t V         = 1;  // Offset for the value
-  const size_t B         = 2;  // Offset for the out-tangent
-
-  const float tSq = t * t;
-  const float tCb = tSq * t;
-  const float tD  = keyDelta;
 
-  // Compute each of the coefficient terms in the specification
-  const float cV1 = -2 * tCb + 3 * tSq;        // -2 t^3 + 3 t^2
-  const float cV0 = 1 - cV1;                   //  2 t^3 - 3 t^2 + 1
-  const float cA  = tD * (tCb - tSq);          // t_d (t^3 - t^2)
-  const float cB  = tD * (tCb - 2 * tSq + t);  // t_d (t^3 - 2 t^2 + t)
-
-  if(channel.path == AnimationChannel::PathType::eRotation)
+  const AnimationLanes& quatLanes = animation.quatLanes;
+  for(size_t i = 0; i < quatLanes.channels.size(); i++)
   {
-    const glm::vec4& v0 = sampler.outputsVec4[prevIndex + V];  // v_k
-    const glm::vec4& a  = sampler.outputsVec4[nextIndex + A];  // a_{k+1}
-    const glm::vec4& b  = sampler.outputsVec4[prevIndex + B];  // b_k
-    const glm::vec4& v1 = sampler.outputsVec4[nextIndex + V];  // v_{k+1}
-
-    glm::vec4 result = cV0 * v0 + cB * b + cV1 * v1 + cA * a;
+    const AnimationChannel& channel      = animation.channels[quatLanes.channels[i]];
+    m_model.nodes[channel.node].rotation = {quatLanes.result[0][i], quatLanes.result[1][i], quatLanes.result[2][i],
+                                            quatLanes.result[3][i]};
+    markNodeDirty(channel.node);  // Its subtree moves at the next updateRenderNodes
+    animated = true;
+  }
 
-    glm::quat quatResult = glm::make_quat(glm::value_ptr(result));
-    quatResult           = glm::normalize(quatResult);
-    gltfNode.rotation    = {quatResult.x, quatResult.y, quatResult.z, quatResult.w};
+  const AnimationLanes& vec3Lanes = animation.vec3Lanes;
+  for(size_t i = 0; i < vec3Lanes.channels.size(); i++)
+  {
+    const AnimationChannel&   channel = animation.channels[vec3Lanes.channels[i]];
+    tinygltf::Node&           node    = m_model.nodes[channel.node];
+    const std::vector<double> value   = {vec3Lanes.result[0][i], vec3Lanes.result[1][i], vec3Lanes.result[2][i]};
+    if(channel.path == AnimationChannel::PathType::eTranslation)
+      node.translation = value;
+    else
+      node.scale = value;
+    markNodeDirty(channel.node);
+    animated = true;
   }
-  else
+
+  for(const AnimationWeightsSample& sample : animation.weightsSamples)
   {
-    const glm::vec3& v0 = sampler.outputsVec3[prevIndex + V];  // v_k
-    const glm::vec3& a  = sampler.outputsVec3[nextIndex + A];  // a_{k+1}
-    const glm::vec3& b  = sampler.outputsVec3[prevIndex + B];  // b_k
-    const glm::vec3& v1 = sampler.outputsVec3[nextIndex + V];  // v_{k+1}
+    const AnimationChannel& channel = animation.channels[sample.channel];
+    const AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+    const int               meshID  = m_model.nodes[channel.node].mesh;
+    animated                        = true;
+    if(meshID < 0 || sampler.interpolation != AnimationSampler::InterpolationType::eLinear)
+      continue;
 
-    glm::vec3 result = cV0 * v0 + cB * b + cV1 * v1 + cA * a;
+    // Make sure the weights vector is resized to match the number of morph targets
+    tinygltf::Mesh&           mesh     = m_model.meshes[meshID];
+    const std::vector<float>& weights1 = sampler.outputsFloat[sample.key];
+    const std::vector<float>& weights2 = sampler.outputsFloat[sample.key + 1];
+    bool                      changed  = mesh.weights.size() != weights1.size();
+    mesh.weights.resize(weights1.size());
 
-    if(channel.path == AnimationChannel::PathType::eTranslation)
-    {
-      gltfNode.translation = {result.x, result.y, result.z};
-    }
-    else if(channel.path == AnimationChannel::PathType::eScale)
+    // Interpolating between weights for morph targets
+    for(size_t j = 0; j < mesh.weights.size(); j++)
     {
-      gltfNode.scale = {result.x, result.y, result.z};
+      const double weight = glm::mix(weights1[j], weights2[j], sample.t);
+      changed |= mesh.weights[j] != weight;
+      mesh.weights[j] = weight;
     }
+
+    // Keep track of the meshes whose morph targets must be blended again
+    if(changed)
+      m_morphedMeshes.insert(meshID);
   }
+
+  return animated;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Calculate the interpolation factor: [0..1] between two keyframes
+float nvvkgltf::Scene::calculateInterpolationFactor(float inputStart, float inputEnd, float time)
+{
+  float keyDelta = inputEnd - inputStart;
+  return std::clamp((time - inputStart) / keyDelta, 0.0f, 1.0f);
 }
 
 // Parse the variants of the materials
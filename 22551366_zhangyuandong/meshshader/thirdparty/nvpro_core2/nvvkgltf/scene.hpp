@@ -25,9 +25,11 @@
 #include <functional>
 #include <map>
 #include <set>
+#include <span>
 #include <string>
 #include <string.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -155,10 +157,26 @@ public:
     eRasterAll
   };
 
+  // Parser of the glTF file, both fill the same tinygltf::Model
+  enum class LoaderBackend
+  {
+    eTinygltf,
+    eCgltf,  // Faster: no JSON DOM, external images are not read at load (see nvvkgltf::loadModelCgltf)
+  };
+
   // File Management
   bool                         load(const std::filesystem::path& filename);  // Load the glTF file, .gltf or .glb
   bool                         save(const std::filesystem::path& filename);  // Save the glTF file, .gltf or .glb
   const std::filesystem::path& getFilename() const { return m_filename; }
+  // Generated data (missing tangents) is stored there and reused by the next loads of the same file, when not empty
+  void setCacheDirectory(const std::filesystem::path& directory) { m_cacheDirectory = directory; }
+  // Primitives whose accessors hold the same data share one render primitive, not only those using the same
+  // accessors. The accessors are hashed in parallel at each parse of the scene. Morphed primitives are excluded.
+  void setContentDeduplication(bool enable) { m_contentDeduplication = enable; }
+  // Method used for the tangents missing on normal mapped primitives, applies to the next load
+  void setTangentMethod(tinygltf::utils::TangentMethod method) { m_tangentMethod = method; }
+  // Parser used by the next loads
+  void setLoaderBackend(LoaderBackend backend) { m_loaderBackend = backend; }
   void                         takeModel(tinygltf::Model&& model);  // Use a model that has been loaded
 
   // Getters
@@ -167,8 +185,16 @@ public:
   bool                   valid() const { return !m_renderNodes.empty(); }
 
   // Animation Management
-  void                     updateRenderNodes();  // Update the render nodes matrices and materials
+  // Update the render nodes matrices, materials and visibility, returns the changed render nodes (getDirtyRenderNodes)
+  // Only the subtrees of the dirty nodes are traversed: nodes moved by `updateAnimation` or `setSceneRootNode`,
+  // and the ones given to `markNodeDirty` after editing the model
+  const std::vector<uint32_t>& updateRenderNodes();
+  void                     markNodeDirty(int nodeID);  // The node transform or visibility was changed in the model
+  void                     markAllNodesDirty() { m_allNodesDirty = true; }
+  void                     markMaterialDirty(int materialID);  // The material was edited in the model
   bool                     updateAnimation(uint32_t animationIndex);
+  // Same as `updateAnimation` for each animation, with the animations sampled in parallel
+  bool                     updateAnimations(std::span<const uint32_t> animationIndices);
   int                      getNumAnimations() const { return static_cast<int>(m_animations.size()); }
   bool                     hasAnimation() const { return !m_animations.empty(); }
   nvvkgltf::AnimationInfo& getAnimationInfo(int index) { return m_animations[index].info; }
@@ -193,6 +219,15 @@ public:
   const std::vector<uint32_t>&                  getMorphPrimitives() const { return m_morphPrimitives; }
   const std::vector<uint32_t>&                  getSkinNodes() const { return m_skinNodes; }
 
+  // Changes made by the last `updateRenderNodes`, so consumers can update only what changed
+  // - render nodes with a new world matrix, material or visibility
+  // - render primitives with new vertex positions: morph weights changed by `updateAnimation`, or skin joints moved
+  const std::vector<uint32_t>& getDirtyRenderNodes() const { return m_dirtyRenderNodes; }
+  const std::vector<uint32_t>& getDirtyRenderPrimitives() const { return m_dirtyRenderPrimitives; }
+  // - materials given to `markMaterialDirty` (sorted, for SceneVk::updateMaterialBuffer). Switching variants
+  //   only changes the materials of the render nodes, not the materials.
+  const std::vector<uint32_t>& getDirtyMaterials() const { return m_dirtyMaterials; }
+
   // Scene Management
   void           setCurrentScene(int sceneID);  // Parse the scene and create the render nodes, call when changing scene
   int            getCurrentScene() const { return m_currentScene; }
@@ -242,6 +277,31 @@ private:
     std::vector<glm::vec3>          outputsVec3;
     std::vector<glm::vec4>          outputsVec4;
     std::vector<std::vector<float>> outputsFloat;
+    size_t                          cursor = 0;  // Key of the last sampled time, the search starts there
+  };
+
+  // Channels sampled at the current time in structure-of-arrays, one lane per channel:
+  // result = c0 * v0 + c1 * v1 + cA * a + cB * b, which covers step, linear, slerp and cubic spline
+  struct AnimationLanes
+  {
+    std::vector<uint32_t> channels;
+    std::vector<float>    c0, c1, cA, cB;
+    std::vector<float>    slerpT;  // >= 0 when c0 and c1 are the slerp weights of this factor
+    std::vector<float>    v0[4], v1[4], a[4], b[4], result[4];
+
+    void clear();
+    // `a` and `b` may be nullptr, when cA and cB are 0
+    void add(uint32_t channel, int numComponents, const float* pv0, const float* pv1, const float* pa, const float* pb, float t0, float t1, float tA, float tB);
+    void computeSlerpWeights();
+    void evaluate(int numComponents);
+    void normalizeResults();  // Quaternions
+  };
+
+  struct AnimationWeightsSample
+  {
+    uint32_t channel = 0;
+    size_t   key     = 0;
+    float    t       = 0.0f;
   };
 
   struct Animation
@@ -249,6 +309,11 @@ private:
     AnimationInfo                 info;
     std::vector<AnimationSampler> samplers;
     std::vector<AnimationChannel> channels;
+
+    // Filled by sampleAnimation, written to the model by applyAnimation
+    AnimationLanes                      vec3Lanes;  // translations and scales
+    AnimationLanes                      quatLanes;  // rotations
+    std::vector<AnimationWeightsSample> weightsSamples;
   };
 
 
@@ -260,7 +325,10 @@ private:
   void createSceneCamera();             // Create a camera for the scene
   void createRootIfMultipleNodes(tinygltf::Scene& scene);
 
-  int getUniqueRenderPrimitive(tinygltf::Primitive& primitive, int meshID);
+  int      getUniqueRenderPrimitive(tinygltf::Primitive& primitive, int meshID);
+  uint64_t getPrimitiveHash(const tinygltf::Primitive& primitive) const;
+  bool     isSamePrimitive(const tinygltf::Primitive& a, const tinygltf::Primitive& b) const;
+  void     hashAccessorContents();  // See setContentDeduplication
   int getMaterialVariantIndex(const tinygltf::Primitive& primitive, int currentVariant);
 
   bool   handleRenderNode(int nodeID, glm::mat4 worldMatrix);
@@ -268,30 +336,56 @@ private:
   bool   handleCameraTraversal(int nodeID, const glm::mat4& worldMatrix);
   bool   handleLightTraversal(int nodeID, const glm::mat4& worldMatrix);
   void   updateVisibility(int nodeID, bool visible, uint32_t& renderNodeID);
+  void   buildNodeHierarchy();
+  void   updateSubtree(int nodeID, const glm::mat4& parentMatrix, bool parentVisible);
+  void   updateDirtyPrimitives(bool firstUpdate);
   void   createMissingTangents();
-  bool processAnimationChannel(tinygltf::Node& gltfNode, AnimationSampler& sampler, const AnimationChannel& channel, float time, uint32_t animationIndex);
-  float calculateInterpolationFactor(float inputStart, float inputEnd, float time);
-  void handleLinearInterpolation(tinygltf::Node& gltfNode, AnimationSampler& sampler, const AnimationChannel& channel, float t, size_t index);
-  void handleStepInterpolation(tinygltf::Node& gltfNode, AnimationSampler& sampler, const AnimationChannel& channel, size_t index);
-  void handleCubicSplineInterpolation(tinygltf::Node&         gltfNode,
-                                      AnimationSampler&       sampler,
-                                      const AnimationChannel& channel,
-                                      float                   t,
-                                      float                   keyDelta,
-                                      size_t                  index);
+  void   sampleAnimation(uint32_t animationIndex);  // Does not modify the model, can run in parallel
+  bool   applyAnimation(uint32_t animationIndex);
+  size_t findAnimationKey(AnimationSampler& sampler, float time);
+  float  calculateInterpolationFactor(float inputStart, float inputEnd, float time);
 
   tinygltf::Model                        m_model;                 // The glTF model
   std::filesystem::path                  m_filename;              // Filename of the glTF
+  std::filesystem::path                  m_cacheDirectory;        // See setCacheDirectory
   std::vector<nvvkgltf::RenderNode>      m_renderNodes;           // Render nodes
   std::vector<nvvkgltf::RenderPrimitive> m_renderPrimitives;      // Unique primitives from key
   std::vector<nvvkgltf::RenderCamera>    m_cameras;               // Cameras
   std::vector<nvvkgltf::RenderLight>     m_lights;                // Lights
   std::vector<Animation>                 m_animations;            // Animations
   std::vector<std::string>               m_variants;              // KHR_materials_variants
-  std::unordered_map<std::string, int>   m_uniquePrimitiveIndex;  // Key: primitive, Value: renderPrimID
+  std::unordered_multimap<uint64_t, int> m_uniquePrimitiveIndex;  // Key: getPrimitiveHash, Value: renderPrimID
+  std::vector<uint64_t>                  m_accessorContentHashes;  // Per accessor, 0 when not hashed
+  bool                                   m_contentDeduplication = false;
+  tinygltf::utils::TangentMethod         m_tangentMethod        = tinygltf::utils::TangentMethod::eUvAccumulation;
+  LoaderBackend                          m_loaderBackend        = LoaderBackend::eTinygltf;
   std::vector<uint32_t>                  m_morphPrimitives;       // All the primitives that are animated
   std::vector<uint32_t>                  m_skinNodes;             // All the primitives that are animated
   std::vector<glm::mat4>                 m_nodesWorldMatrices;
+  std::vector<uint32_t>                  m_dirtyRenderNodes;       // Render nodes changed by the last updateRenderNodes
+  std::vector<uint32_t>                  m_dirtyRenderPrimitives;  // Render primitives whose positions changed
+  std::unordered_set<int>                m_morphedMeshes;          // Meshes whose weights changed since updateRenderNodes
+  std::vector<uint32_t>                  m_dirtyMaterials;         // Materials edited before the last updateRenderNodes
+  std::vector<uint32_t>                  m_editedMaterials;        // Materials edited since updateRenderNodes
+  std::vector<uint8_t>                   m_materialsEdited;        // Flags of m_editedMaterials
+
+  // Incremental updates of the render nodes
+  struct RenderNodeRange
+  {
+    uint32_t first = 0;  // First render node of a glTF node, they are contiguous
+    uint32_t count = 0;
+  };
+  static constexpr int                            kNodeNotInScene = -2;
+  std::vector<int>                                m_nodeParents;           // -1 for the scene roots, kNodeNotInScene
+  std::vector<RenderNodeRange>                    m_nodeRenderNodes;       // Render nodes of each glTF node
+  std::unordered_map<int, std::vector<glm::mat4>> m_nodeInstanceMatrices;  // EXT_mesh_gpu_instancing, per render node
+  std::vector<uint8_t>                            m_nodesVisible;          // Visibility including the parents
+  std::vector<uint8_t>                            m_nodesDirty;            // Flags of m_dirtyNodes
+  std::vector<int>                                m_dirtyNodes;            // Subtrees to update
+  std::vector<uint32_t>                           m_nodesMovedStamp;       // Update in which the world matrix changed
+  uint32_t                                        m_updateStamp    = 0;
+  bool                                            m_allNodesDirty  = true;
+  bool                                            m_materialsDirty = true;  // Variant changed
 
   int           m_numTriangles    = 0;   // Stat - Number of triangles
   int           m_currentScene    = 0;   // Scene index
@@ -301,4 +395,8 @@ private:
   nvutils::Bbox m_sceneBounds;           // Scene bounds
 };
 
+// Loads each file `repetitions` times with both backends and logs the median load times, for the files
+// where the backends give the same number of render nodes and primitives. Returns false if one fails.
+bool benchmarkLoaderBackends(std::span<const std::filesystem::path> files, uint32_t repetitions = 5);
+
 }  // namespace nvvkgltf
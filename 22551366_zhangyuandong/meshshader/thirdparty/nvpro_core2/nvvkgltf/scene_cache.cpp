@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+
+#include "nvutils/file_operations.hpp"
+#include "nvutils/logger.hpp"
+
+#include "scene_cache.hpp"
+
+namespace {
+struct BlobHeader
+{
+  uint32_t magic{};
+  uint32_t version{};
+  uint64_t key{};
+  uint64_t numChunks{};
+};
+
+constexpr uint64_t kChunkAlignment = 16;
+
+uint64_t alignChunk(uint64_t offset)
+{
+  return (offset + kChunkAlignment - 1) & ~(kChunkAlignment - 1);
+}
+}  // namespace
+
+uint64_t nvvkgltf::cache::getFileKey(const std::filesystem::path& file, uint64_t options)
+{
+  std::error_code ec;
+  const uint64_t  size = std::filesystem::file_size(file, ec);
+  if(ec)
+    return 0;
+  const auto time = std::filesystem::last_write_time(file, ec);
+  if(ec)
+    return 0;
+
+  const std::string path = nvutils::utf8FromPath(std::filesystem::absolute(file, ec));
+  uint64_t          key  = std::hash<std::string_view>{}(path);
+  key                    = combineKey(key, size);
+  key                    = combineKey(key, uint64_t(time.time_since_epoch().count()));
+  key                    = combineKey(key, options);
+  key                    = combineKey(key, kVersion);
+  return key == 0 ? 1 : key;
+}
+
+bool nvvkgltf::cache::save(const std::filesystem::path& filename, uint32_t magic, uint64_t key, std::span<const std::span<const char>> chunks)
+{
+  std::filesystem::path tempName = filename;
+  tempName += ".tmp";
+  {
+    std::ofstream file(tempName, std::ios::binary);
+    if(!file)
+    {
+      LOGW("Could not write cache %s\n", nvutils::utf8FromPath(filename).c_str());
+      return false;
+    }
+
+    const BlobHeader header{.magic = magic, .version = kVersion, .key = key, .numChunks = chunks.size()};
+    std::vector<uint64_t> sizes;
+    for(const std::span<const char>& chunk : chunks)
+      sizes.push_back(chunk.size());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(sizes.data()), std::span(sizes).size_bytes());
+
+    const char padding[kChunkAlignment]{};
+    uint64_t   offset = sizeof(header) + std::span(sizes).size_bytes();
+    for(const std::span<const char>& chunk : chunks)
+    {
+      file.write(padding, alignChunk(offset) - offset);
+      file.write(chunk.data(), chunk.size());
+      offset = alignChunk(offset) + chunk.size();
+    }
+    if(!file)
+      return false;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tempName, filename, ec);
+  return !ec;
+}
+
+bool nvvkgltf::cache::Reader::open(const std::filesystem::path& filename, uint32_t magic, uint64_t key)
+{
+  close();
+  if(key == 0 || !m_mapping.open(filename, nvutils::FileReadMapping::MAPPING_FLAG_SEQUENTIAL))
+    return false;
+
+  const char*  data = static_cast<const char*>(m_mapping.data());
+  const size_t size = m_mapping.size();
+  BlobHeader   header{};
+  if(size < sizeof(header))
+  {
+    close();
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+  if(header.magic != magic || header.version != kVersion || header.key != key
+     || header.numChunks > (size - sizeof(header)) / sizeof(uint64_t))
+  {
+    close();
+    return false;
+  }
+
+  uint64_t offset = sizeof(header) + header.numChunks * sizeof(uint64_t);
+  for(uint64_t i = 0; i < header.numChunks; i++)
+  {
+    uint64_t chunkSize = 0;
+    memcpy(&chunkSize, data + sizeof(header) + i * sizeof(uint64_t), sizeof(chunkSize));
+    offset = alignChunk(offset);
+    if(offset > size || chunkSize > size - offset)
+    {
+      close();
+      return false;  // Truncated
+    }
+    m_chunks.push_back({data + offset, chunkSize});
+    offset += chunkSize;
+  }
+  return true;
+}
+
+void nvvkgltf::cache::Reader::close()
+{
+  m_chunks.clear();
+  if(m_mapping.valid())
+    m_mapping.close();
+}
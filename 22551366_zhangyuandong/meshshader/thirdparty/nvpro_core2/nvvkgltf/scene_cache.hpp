@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include <nvutils/file_mapping.hpp>
+
+/*-------------------------------------------------------------------------------------------------
+# namespace nvvkgltf::cache
+
+>  Versioned binary blobs of the data derived from the glTF files, to skip their generation on the next loads.
+
+A blob is a header (magic, version, key) followed by the sizes of its chunks and their payloads, aligned
+to 16 bytes. The key identifies the source, `getFileKey` combines its path, size and modification time
+with the options the data was built with. Blobs are memory mapped when read, and a stale or truncated blob
+is ignored.
+
+Used by `nvvkgltf::Scene::setCacheDirectory` (generated tangents) and `nvvkgltf::SceneVk::setCacheDirectory`
+(decoded and transcoded images).
+ -------------------------------------------------------------------------------------------------*/
+namespace nvvkgltf::cache {
+
+// Changes of the layout of the cached data must bump this version
+constexpr uint32_t kVersion = 1;
+
+// Key of the content of `file` built with `options`, 0 if the file does not exist
+uint64_t getFileKey(const std::filesystem::path& file, uint64_t options);
+
+// Combines hashes, e.g. of options
+inline uint64_t combineKey(uint64_t key, uint64_t value)
+{
+  return key ^ (value + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2));
+}
+
+// Writes the blob atomically (to a temporary file renamed once complete)
+bool save(const std::filesystem::path& filename, uint32_t magic, uint64_t key, std::span<const std::span<const char>> chunks);
+
+class Reader
+{
+public:
+  // Maps `filename`, fails if it doesn't match the magic, version and key
+  bool open(const std::filesystem::path& filename, uint32_t magic, uint64_t key);
+  void close();
+
+  size_t                getNumChunks() const { return m_chunks.size(); }
+  std::span<const char> getChunk(size_t index) const { return m_chunks[index]; }
+
+private:
+  nvutils::FileReadMapping           m_mapping;
+  std::vector<std::span<const char>> m_chunks;
+};
+
+}  // namespace nvvkgltf::cache
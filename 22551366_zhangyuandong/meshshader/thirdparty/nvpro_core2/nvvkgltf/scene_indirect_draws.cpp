@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_access.hpp>
+
+#include <nvvk/barriers.hpp>
+#include <nvvk/check_error.hpp>
+#include <nvvk/compute_pipeline.hpp>
+#include <nvvk/debug_util.hpp>
+#include <nvvk/default_structs.hpp>
+
+#include "scene_indirect_draws.hpp"
+
+VkResult nvvkgltf::SceneIndirectDraws::init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv)
+{
+  assert(!m_device);
+  m_alloc  = alloc;
+  m_device = alloc->getDevice();
+
+  // Bound in place of the depth pyramid, never read
+  VkImageCreateInfo imageInfo = DEFAULT_VkImageCreateInfo;
+  imageInfo.extent            = {1, 1, 1};
+  imageInfo.format            = VK_FORMAT_R32_SFLOAT;
+  imageInfo.usage             = VK_IMAGE_USAGE_SAMPLED_BIT;
+  VkImageViewCreateInfo viewInfo = DEFAULT_VkImageViewCreateInfo;
+  viewInfo.format                = imageInfo.format;
+  NVVK_FAIL_RETURN(m_alloc->createImage(m_dummyHiz, imageInfo, viewInfo));
+  NVVK_DBG_NAME(m_dummyHiz.image);
+  m_dummyHizReady = false;
+
+  NVVK_FAIL_RETURN(m_alloc->createBuffer(m_bCullInfo, sizeof(shaderio::GltfMeshletCullInfo),
+                                         VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT
+                                             | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT));
+  NVVK_DBG_NAME(m_bCullInfo.buffer);
+
+  // Shader descriptor set layout
+  nvvk::DescriptorBindings bindings;
+  bindings.addBinding(shaderio::GltfDrawCullBinding::eGltfDrawCullHiz, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+  bindings.addBinding(shaderio::GltfDrawCullBinding::eGltfDrawCullCommands, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+  bindings.addBinding(shaderio::GltfDrawCullBinding::eGltfDrawCullCounts, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+
+  NVVK_FAIL_RETURN(m_descriptorPack.init(bindings, m_device, 0, VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR));
+  NVVK_DBG_NAME(m_descriptorPack.getLayout());
+
+  // Push constant
+  VkPushConstantRange pushConstantRange{.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .size = sizeof(shaderio::GltfDrawCullPushConstant)};
+
+  // Pipeline layout
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+      .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .setLayoutCount         = 1,
+      .pSetLayouts            = m_descriptorPack.getLayoutPtr(),
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges    = &pushConstantRange,
+  };
+  NVVK_FAIL_RETURN(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout));
+  NVVK_DBG_NAME(m_pipelineLayout);
+
+  // Compute Pipeline
+  VkShaderModuleCreateInfo shaderInfo{
+      .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      .codeSize = spirv.size_bytes(),
+      .pCode    = spirv.data(),
+  };
+  VkComputePipelineCreateInfo compInfo{
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .stage =
+          {
+              .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+              .pNext = &shaderInfo,
+              .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+              .pName = "drawCullMain",
+          },
+      .layout = m_pipelineLayout,
+  };
+  NVVK_FAIL_RETURN(vkCreateComputePipelines(m_device, nullptr, 1, &compInfo, nullptr, &m_pipeline));
+  NVVK_DBG_NAME(m_pipeline);
+
+  return VK_SUCCESS;
+}
+
+void nvvkgltf::SceneIndirectDraws::deinit()
+{
+  if(!m_device)
+    return;
+
+  destroy();
+  m_alloc->destroyBuffer(m_bCullInfo);
+  m_alloc->destroyImage(m_dummyHiz);
+
+  vkDestroyPipeline(m_device, m_pipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+  m_descriptorPack.deinit();
+
+  m_pipelineLayout = VK_NULL_HANDLE;
+  m_pipeline       = VK_NULL_HANDLE;
+  m_device         = VK_NULL_HANDLE;
+}
+
+uint32_t nvvkgltf::SceneIndirectDraws::getDefaultBucket(const nvvkgltf::Scene& scn, const nvvkgltf::RenderNode& renderNode)
+{
+  if(!renderNode.visible)
+    return GLTF_DRAW_BUCKET_NONE;
+
+  const tinygltf::Model& model = scn.getModel();
+  if(renderNode.materialID < 0 || renderNode.materialID >= int(model.materials.size()))
+    return 0;
+
+  const tinygltf::Material& material  = model.materials[renderNode.materialID];
+  const uint32_t            alphaMode = material.alphaMode == "OPAQUE" ? 0 : (material.alphaMode == "MASK" ? 1 : 2 /*BLEND*/);
+  return alphaMode * 2 + (material.doubleSided ? 1 : 0);
+}
+
+void nvvkgltf::SceneIndirectDraws::create(VkCommandBuffer        cmd,
+                                          nvvk::StagingUploader& staging,
+                                          const nvvkgltf::Scene& scn,
+                                          const SceneVk&         scnVk,
+                                          uint32_t               numBuckets,
+                                          BucketFunction         bucketFunction)
+{
+  destroy();
+
+  const std::vector<nvvkgltf::RenderNode>&      renderNodes      = scn.getRenderNodes();
+  const std::vector<nvvkgltf::RenderPrimitive>& renderPrimitives = scn.getRenderPrimitives();
+  const tinygltf::Model&                        model            = scn.getModel();
+
+  m_bucketFunction     = std::move(bucketFunction);
+  m_numRenderNodes     = uint32_t(renderNodes.size());
+  m_renderNodesAddress = scnVk.instances().address;
+  m_bucketRanges.resize(numBuckets);
+  m_nodeBuckets.resize(renderNodes.size());
+
+  // Bounding spheres from the POSITION bounds, required by glTF
+  std::vector<shaderio::GltfDrawPrimitive> drawPrims(renderPrimitives.size());
+  for(size_t primID = 0; primID < renderPrimitives.size(); primID++)
+  {
+    const nvvkgltf::RenderPrimitive& renderPrim = renderPrimitives[primID];
+    shaderio::GltfDrawPrimitive&     drawPrim   = drawPrims[primID];
+    drawPrim.radius                             = -1.0f;
+
+    const std::span<const shaderio::GltfPrimitiveLod> lods = scnVk.getLods(primID);
+    drawPrim.lodCount = uint32_t(std::min<size_t>(lods.size(), GLTF_MAX_LODS));
+    std::copy_n(lods.begin(), drawPrim.lodCount, drawPrim.lods);
+
+    const auto it = renderPrim.pPrimitive->attributes.find("POSITION");
+    if(it == renderPrim.pPrimitive->attributes.end() || !renderPrim.pPrimitive->targets.empty())
+      continue;
+    const tinygltf::Accessor& accessor = model.accessors[it->second];
+    if(accessor.minValues.size() != 3 || accessor.maxValues.size() != 3 || accessor.normalized)
+      continue;  // Quantized positions keep their bounds in the stored type
+
+    const glm::vec3 pmin(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]);
+    const glm::vec3 pmax(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]);
+    drawPrim.center = (pmin + pmax) * 0.5f;
+    drawPrim.radius = glm::length(pmax - pmin) * 0.5f;
+  }
+  // Skinned vertices leave the bind pose bounds
+  for(const nvvkgltf::RenderNode& renderNode : renderNodes)
+  {
+    if(renderNode.skinID > -1 && renderNode.renderPrimID >= 0)
+      drawPrims[renderNode.renderPrimID].radius = -1.0f;
+  }
+
+  const VkBufferUsageFlags2 usage = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT;
+  NVVK_CHECK(m_alloc->createBuffer(m_bPrimitives, std::span(drawPrims).size_bytes(), usage));
+  NVVK_CHECK(staging.appendBuffer(m_bPrimitives, 0, std::span(drawPrims)));
+  NVVK_DBG_NAME(m_bPrimitives.buffer);
+
+  NVVK_CHECK(m_alloc->createBuffer(m_bNodeBuckets, std::max<size_t>(1, m_nodeBuckets.size()) * sizeof(uint32_t), usage));
+  NVVK_DBG_NAME(m_bNodeBuckets.buffer);
+  NVVK_CHECK(m_alloc->createBuffer(m_bBuckets, std::max<size_t>(1, numBuckets) * sizeof(shaderio::GltfDrawBucket), usage));
+  NVVK_DBG_NAME(m_bBuckets.buffer);
+  NVVK_CHECK(m_alloc->createBuffer(m_bCommands, std::max<size_t>(1, renderNodes.size()) * sizeof(shaderio::GltfDrawCommand),
+                                   VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_INDIRECT_BUFFER_BIT));
+  NVVK_DBG_NAME(m_bCommands.buffer);
+  NVVK_CHECK(m_alloc->createBuffer(m_bCounts, std::max<size_t>(1, numBuckets) * sizeof(uint32_t),
+                                   VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_INDIRECT_BUFFER_BIT
+                                       | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT));
+  NVVK_DBG_NAME(m_bCounts.buffer);
+
+  updateBuckets(cmd, staging, scn);
+}
+
+void nvvkgltf::SceneIndirectDraws::updateBuckets(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn)
+{
+  const std::vector<nvvkgltf::RenderNode>& renderNodes = scn.getRenderNodes();
+  assert(renderNodes.size() == m_nodeBuckets.size() && "Render nodes changed, call create again");
+
+  // Contiguous range of commands per bucket, sized for all of its render nodes
+  for(shaderio::GltfDrawBucket& range : m_bucketRanges)
+    range = {};
+  for(size_t nodeID = 0; nodeID < renderNodes.size(); nodeID++)
+  {
+    uint32_t bucket = renderNodes[nodeID].renderPrimID < 0 ? GLTF_DRAW_BUCKET_NONE : m_bucketFunction(scn, renderNodes[nodeID]);
+    if(bucket >= m_bucketRanges.size())
+      bucket = GLTF_DRAW_BUCKET_NONE;
+    else
+      m_bucketRanges[bucket].maxCommands++;
+    m_nodeBuckets[nodeID] = bucket;
+  }
+  uint32_t firstCommand = 0;
+  for(shaderio::GltfDrawBucket& range : m_bucketRanges)
+  {
+    range.firstCommand = firstCommand;
+    firstCommand += range.maxCommands;
+  }
+
+  NVVK_CHECK(staging.appendBuffer(m_bNodeBuckets, 0, std::span(m_nodeBuckets)));
+  NVVK_CHECK(staging.appendBuffer(m_bBuckets, 0, std::span(m_bucketRanges)));
+}
+
+void nvvkgltf::SceneIndirectDraws::destroy()
+{
+  m_alloc->destroyBuffer(m_bPrimitives);
+  m_alloc->destroyBuffer(m_bNodeBuckets);
+  m_alloc->destroyBuffer(m_bBuckets);
+  m_alloc->destroyBuffer(m_bCommands);
+  m_alloc->destroyBuffer(m_bCounts);
+  m_bucketRanges.clear();
+  m_nodeBuckets.clear();
+  m_numRenderNodes = 0;
+}
+
+void nvvkgltf::SceneIndirectDraws::getFrustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6])
+{
+  const glm::vec4 row0 = glm::row(viewProj, 0);
+  const glm::vec4 row1 = glm::row(viewProj, 1);
+  const glm::vec4 row2 = glm::row(viewProj, 2);
+  const glm::vec4 row3 = glm::row(viewProj, 3);
+
+  planes[0] = row3 + row0;  // left
+  planes[1] = row3 - row0;  // right
+  planes[2] = row3 + row1;  // bottom, top with a flipped y
+  planes[3] = row3 - row1;  // top
+  planes[4] = row2;         // near, depth in [0, 1]
+  planes[5] = row3 - row2;  // far
+  for(int i = 0; i < 6; i++)
+  {
+    planes[i] /= glm::length(glm::vec3(planes[i]));
+  }
+}
+
+void nvvkgltf::SceneIndirectDraws::cmdCull(VkCommandBuffer cmd, const CullInfo& info)
+{
+  NVVK_DBG_SCOPE(cmd);  // <-- Helps to debug in NSight
+  assert(m_device && "Missing init()");
+
+  if(m_numRenderNodes == 0)
+    return;
+
+  if(!m_dummyHizReady)
+  {
+    nvvk::cmdImageMemoryBarrier(cmd, {m_dummyHiz.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+    m_dummyHizReady = true;
+  }
+
+  shaderio::GltfMeshletCullInfo cull{};
+  getFrustumPlanes(info.viewProj, cull.frustumPlanes);
+  cull.viewProj       = info.viewProj;
+  cull.cameraPosition = info.cameraPosition;
+  cull.hizLevels      = info.hizView ? info.hizLevels : 0;
+  cull.hizSize        = {info.hizSize.width, info.hizSize.height};
+
+  // The previous draws have consumed the commands and counts
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_NONE, VK_ACCESS_2_NONE);
+  vkCmdUpdateBuffer(cmd, m_bCullInfo.buffer, 0, sizeof(cull), &cull);
+  vkCmdFillBuffer(cmd, m_bCounts.buffer, 0, VK_WHOLE_SIZE, 0);
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                         VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+  const shaderio::GltfDrawCullPushConstant pushConstant{
+      .renderNodes      = (shaderio::GltfRenderNode*)m_renderNodesAddress,
+      .primitives       = (shaderio::GltfDrawPrimitive*)m_bPrimitives.address,
+      .nodeBuckets      = (uint32_t*)m_bNodeBuckets.address,
+      .buckets          = (shaderio::GltfDrawBucket*)m_bBuckets.address,
+      .cullInfo         = (shaderio::GltfMeshletCullInfo*)m_bCullInfo.address,
+      .numRenderNodes   = m_numRenderNodes,
+      .lodPixelsPerUnit = info.lodPixelsPerUnit,
+      .lodMaxPixelError = info.lodMaxPixelError,
+  };
+  vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstant), &pushConstant);
+
+  nvvk::WriteSetContainer writeSetContainer;
+  if(cull.hizLevels != 0)
+    writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::GltfDrawCullBinding::eGltfDrawCullHiz), info.hizView, info.hizLayout);
+  else
+    writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::GltfDrawCullBinding::eGltfDrawCullHiz),
+                             m_dummyHiz.descriptor.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::GltfDrawCullBinding::eGltfDrawCullCommands), m_bCommands);
+  writeSetContainer.append(m_descriptorPack.makeWrite(shaderio::GltfDrawCullBinding::eGltfDrawCullCounts), m_bCounts);
+  vkCmdPushDescriptorSetKHR(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, writeSetContainer.size(),
+                            writeSetContainer.data());
+
+  vkCmdDispatch(cmd, nvvk::getGroupCounts(m_numRenderNodes, GLTF_DRAW_CULL_WORKGROUP_SIZE), 1, 1);
+
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                         VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+}
+
+void nvvkgltf::SceneIndirectDraws::cmdDrawBucket(VkCommandBuffer cmd, uint32_t bucket) const
+{
+  const shaderio::GltfDrawBucket& range = m_bucketRanges[bucket];
+  if(range.maxCommands == 0)
+    return;
+
+  vkCmdDrawIndirectCount(cmd, m_bCommands.buffer, range.firstCommand * sizeof(shaderio::GltfDrawCommand), m_bCounts.buffer,
+                         bucket * sizeof(uint32_t), range.maxCommands, sizeof(shaderio::GltfDrawCommand));
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <functional>
+#include <span>
+
+#include <nvvk/descriptors.hpp>
+#include <nvvk/resource_allocator.hpp>
+#include <nvvk/staging.hpp>
+
+#include "nvshaders/gltf_draw_cull_io.h.slang"  // Shared between host and device
+#include "scene_vk.hpp"
+
+/*-------------------------------------------------------------------------------------------------
+# class nvvkgltf::SceneIndirectDraws
+
+>  GPU generated draws of the render nodes, instead of one draw recorded per node on the CPU.
+
+A compute pass (nvshaders/gltf_draw_cull.slang) culls the render nodes with the bounding sphere of their
+primitive against the frustum and optionally a depth pyramid, and writes the draw commands of the visible
+ones grouped by bucket: the nodes sharing a pipeline (by default the alpha mode and double sidedness of
+their material). Each bucket is then drawn with one vkCmdDrawIndirectCount.
+
+- The draws are not indexed, since each primitive has its own index buffer: the vertex shader fetches the
+  indices, see `getIndirectDrawVertexIndex`, and the render node is the first instance.
+- The render nodes are read from `SceneVk::instances()`, the culling follows their updates.
+- With `SceneVk::LodOptions`, each visible node is drawn with the level of detail picked by
+  `SceneVk::selectLod` from the distance to its sphere, when `CullInfo::lodPixelsPerUnit` is set.
+- Requires drawIndirectCount (Vulkan 1.2) and push descriptors.
+
+Usage:
+  nvvkgltf::SceneIndirectDraws draws;
+  draws.init(&alloc, gltf_draw_cull_slang);  // SPIR-V compiled from nvshaders/gltf_draw_cull.slang
+  draws.create(cmd, staging, scene, sceneVk);
+  // each frame, outside of the rendering
+  draws.cmdCull(cmd, {.viewProj = proj * view, .cameraPosition = eye});
+  // in the rendering
+  for(uint32_t bucket = 0; bucket < draws.getNumBuckets(); bucket++)
+  {
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[bucket]);
+    draws.cmdDrawBucket(cmd, bucket);
+  }
+ -------------------------------------------------------------------------------------------------*/
+namespace nvvkgltf {
+
+class SceneIndirectDraws
+{
+public:
+  SceneIndirectDraws() = default;
+  ~SceneIndirectDraws() { assert(m_device == VK_NULL_HANDLE); }  // Missing deinit call
+
+  // `spirv` is compiled from nvshaders/gltf_draw_cull.slang
+  VkResult init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv);
+  void     deinit();
+
+  // Bucket of a render node, GLTF_DRAW_BUCKET_NONE to never draw it
+  using BucketFunction = std::function<uint32_t(const nvvkgltf::Scene& scn, const nvvkgltf::RenderNode& renderNode)>;
+
+  // Default buckets: alphaMode (opaque, mask, blend) * 2 + doubleSided, hidden nodes are skipped
+  static constexpr uint32_t kNumDefaultBuckets = 6;
+  static uint32_t           getDefaultBucket(const nvvkgltf::Scene& scn, const nvvkgltf::RenderNode& renderNode);
+
+  // Creates the buffers for the render nodes of the scene, to call again when their number changes
+  void create(VkCommandBuffer        cmd,
+              nvvk::StagingUploader& staging,
+              const nvvkgltf::Scene& scn,
+              const SceneVk&         scnVk,
+              uint32_t               numBuckets     = kNumDefaultBuckets,
+              BucketFunction         bucketFunction = getDefaultBucket);
+  // Uploads the buckets again, after changes of visibility or materials
+  void updateBuckets(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn);
+  void destroy();
+
+  struct CullInfo
+  {
+    glm::mat4     viewProj{1};  // of the camera drawing the buckets
+    glm::vec3     cameraPosition{};
+    VkImageView   hizView{};  // optional, farthest depth per texel of the previous frame or of the occluders
+    VkImageLayout hizLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkExtent2D    hizSize{};
+    uint32_t      hizLevels        = 0;
+    float         lodPixelsPerUnit = 0.0f;  // projection[1][1] * viewport height / 2, 0 draws the full detail
+    float         lodMaxPixelError = 1.0f;
+  };
+
+  // Writes the draws of the buckets, ends with a barrier for the indirect draws
+  void cmdCull(VkCommandBuffer cmd, const CullInfo& info);
+  // Draws the visible render nodes of the bucket, with its pipeline bound
+  void cmdDrawBucket(VkCommandBuffer cmd, uint32_t bucket) const;
+
+  uint32_t getNumBuckets() const { return uint32_t(m_bucketRanges.size()); }
+
+  // World space planes pointing inside, from a Vulkan projection (depth in [0, 1])
+  static void getFrustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6]);
+
+private:
+  nvvk::ResourceAllocator* m_alloc{};
+  VkDevice                 m_device{};
+  nvvk::DescriptorPack     m_descriptorPack;
+  VkPipelineLayout         m_pipelineLayout{};
+  VkPipeline               m_pipeline{};
+  nvvk::Image              m_dummyHiz;  // bound when occlusion culling is disabled
+  bool                     m_dummyHizReady = false;
+
+  BucketFunction                        m_bucketFunction;
+  std::vector<shaderio::GltfDrawBucket> m_bucketRanges;
+  std::vector<uint32_t>                 m_nodeBuckets;
+  uint32_t                              m_numRenderNodes = 0;
+
+  nvvk::Buffer    m_bPrimitives;   // GltfDrawPrimitive per render primitive
+  nvvk::Buffer    m_bNodeBuckets;  // uint per render node
+  nvvk::Buffer    m_bBuckets;      // GltfDrawBucket
+  nvvk::Buffer    m_bCullInfo;     // GltfMeshletCullInfo, updated by cmdCull
+  nvvk::Buffer    m_bCommands;     // GltfDrawCommand per render node
+  nvvk::Buffer    m_bCounts;       // uint per bucket
+  VkDeviceAddress m_renderNodesAddress{};
+};
+
+}  // namespace nvvkgltf
@@ -132,10 +132,12 @@ void nvvkgltf::SceneRtx::destroy()
     m_memoryTracker.untrack(kMemCategoryTLAS, m_tlasAccel.buffer.allocation);
     m_alloc->destroyAcceleration(m_tlasAccel);
   }
-  m_blasAccel     = {};
-  m_blasBuildData = {};
-  m_tlasAccel     = {};
-  m_tlasBuildData = {};
+  m_blasAccel      = {};
+  m_blasBuildData  = {};
+  m_blasRefitCount = {};
+  m_blasUpdated    = false;
+  m_tlasAccel      = {};
+  m_tlasBuildData  = {};
   if(m_blasBuilder)
   {
     m_blasBuilder->deinit();
@@ -279,6 +281,33 @@ bool nvvkgltf::SceneRtx::cmdBuildBottomLevelAccelerationStructure(VkCommandBuffe
   return result == VK_SUCCESS;
 }
 
+//--------------------------------------------------------------------------------------------------
+// Build the bottom-level acceleration structure on a separate queue
+//
+// Unlike the loop over cmdBuildBottomLevelAccelerationStructure / cmdCompactBlas, the batches
+// are pipelined: the next batch builds while the previous one is compacted.
+//
+VkResult nvvkgltf::SceneRtx::buildBottomLevelAccelerationStructure(const nvvk::QueueInfo&    queueInfo,
+                                                                   std::span<const uint32_t> sharingQueueFamilies,
+                                                                   VkDeviceSize              hintMaxBudget /*= 512'000'000*/)
+{
+  nvutils::ScopedTimer st(__FUNCTION__);
+  assert(m_blasBuilder && "createBottomLevelAccelerationStructure must be called first");
+
+  nvvk::AccelerationStructurePipelinedBuilder builder;
+  NVVK_FAIL_RETURN(builder.init(m_alloc, queueInfo, sharingQueueFamilies));
+
+  VkResult result = builder.buildBlas(m_blasBuildData, m_blasAccel, hintMaxBudget);
+  if(result == VK_SUCCESS)
+  {
+    trackBlasMemory();
+    LOGI("%s%s\n", nvutils::ScopedTimer::indent().c_str(), builder.getStatistics().toString().c_str());
+  }
+
+  builder.deinit();
+  return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Get the instance flag,
 // The instance flag is used to determine if the material is opaque or not, and if the material is double sided or not
@@ -398,33 +427,58 @@ void nvvkgltf::SceneRtx::cmdCreateBuildTopLevelAccelerationStructure(VkCommandBu
 
 
 // This function is called when the scene has been updated
+// Only the instances of the render nodes changed by the last `Scene::updateRenderNodes` are uploaded
 void nvvkgltf::SceneRtx::updateTopLevelAS(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scene)
 {
   //nvh::ScopedTimer st(__FUNCTION__);
   const std::vector<nvvkgltf::RenderNode>& drawObjects = scene.getRenderNodes();
   const auto&                              materials   = scene.getModel().materials;
+  const std::vector<uint32_t>&             dirtyNodes  = scene.getDirtyRenderNodes();
 
-  uint32_t numVisibleElement = 0;
-  // Updating all matrices
-  for(size_t i = 0; i < drawObjects.size(); i++)
+  // Neither the instances nor the BLAS they reference changed
+  if(dirtyNodes.empty() && !m_blasUpdated)
   {
-    auto&                     object      = drawObjects[i];
-    const tinygltf::Material& mat         = materials[object.materialID];
-    VkDeviceAddress           blasAddress = m_blasAccel[object.renderPrimID].address;
-
-    m_tlasInstances[i].transform = nvvk::toTransformMatrixKHR(object.worldMatrix);  // Position of the instance
-    m_tlasInstances[i].flags     = getInstanceFlag(mat);
-    m_tlasInstances[i].accelerationStructureReference = (object.visible ? blasAddress : 0);  // The reference to the BLAS
-    numVisibleElement += object.visible;
+    return;
   }
+  m_blasUpdated = false;
 
-  // Update the instance buffer
-  staging.appendBuffer(m_instancesBuffer, 0, std::span(m_tlasInstances));
-  staging.cmdUploadAppended(cmd);
+  // Instances cannot be activated or deactivated by an update, it requires a build
+  bool activeChanged = false;
 
-  // Make sure the copy of the instance buffer are copied before triggering the acceleration structure build
-  nvvk::accelerationStructureBarrier(cmd, VK_ACCESS_TRANSFER_WRITE_BIT,
-                                     VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR | VK_ACCESS_2_SHADER_READ_BIT);
+  // Updating the changed matrices, consecutive instances are uploaded together
+  for(size_t d = 0; d < dirtyNodes.size();)
+  {
+    const uint32_t first = dirtyNodes[d];
+    uint32_t       count = 0;
+    while(d < dirtyNodes.size() && dirtyNodes[d] == first + count)
+    {
+      const auto&                         object      = drawObjects[first + count];
+      const tinygltf::Material&           mat         = materials[object.materialID];
+      VkAccelerationStructureInstanceKHR& instance    = m_tlasInstances[first + count];
+      VkDeviceAddress                     blasAddress = object.visible ? m_blasAccel[object.renderPrimID].address : 0;
+
+      activeChanged |= (instance.accelerationStructureReference == 0) != (blasAddress == 0);
+
+      instance.transform                      = nvvk::toTransformMatrixKHR(object.worldMatrix);  // Position of the instance
+      instance.flags                          = getInstanceFlag(mat);
+      instance.accelerationStructureReference = blasAddress;  // The reference to the BLAS
+      count++;
+      d++;
+    }
+
+    staging.appendBuffer(m_instancesBuffer, first * sizeof(VkAccelerationStructureInstanceKHR),
+                         std::span(m_tlasInstances).subspan(first, count));
+  }
+
+  if(!dirtyNodes.empty())
+  {
+    // Update the instance buffer
+    staging.cmdUploadAppended(cmd);
+
+    // Make sure the copy of the instance buffer are copied before triggering the acceleration structure build
+    nvvk::accelerationStructureBarrier(cmd, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                       VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR | VK_ACCESS_2_SHADER_READ_BIT);
+  }
 
   if(m_tlasScratchBuffer.buffer == VK_NULL_HANDLE)
   {
@@ -435,7 +489,7 @@ void nvvkgltf::SceneRtx::updateTopLevelAS(VkCommandBuffer cmd, nvvk::StagingUplo
   }
 
   // Building or updating the top-level acceleration structure
-  if(m_numVisibleElement != numVisibleElement)
+  if(activeChanged)
   {
     m_tlasBuildData.cmdBuildAccelerationStructure(cmd, m_tlasAccel.accel, m_tlasScratchBuffer.address);
   }
@@ -444,30 +498,62 @@ void nvvkgltf::SceneRtx::updateTopLevelAS(VkCommandBuffer cmd, nvvk::StagingUplo
     m_tlasBuildData.cmdUpdateAccelerationStructure(cmd, m_tlasAccel.accel, m_tlasScratchBuffer.address);
   }
 
-  m_numVisibleElement = numVisibleElement;
-
   // Make sure to have the TLAS ready before using it
   nvvk::accelerationStructureBarrier(cmd, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
 }
 
+// Refit the BLAS whose vertices changed, or rebuild them once refitted too often
 void nvvkgltf::SceneRtx::updateBottomLevelAS(VkCommandBuffer cmd, const nvvkgltf::Scene& scene)
 {
-  // #TODO - Check that primID aren't duplicated
-  for(auto& primID : scene.getMorphPrimitives())
+  const std::vector<uint32_t>& dirtyPrimitives = scene.getDirtyRenderPrimitives();
+  if(dirtyPrimitives.empty())
   {
-    m_blasBuildData[primID].cmdUpdateAccelerationStructure(cmd, m_blasAccel[primID].accel, m_blasScratchBuffer.address);
-    // Add synchronization between consecutive acceleration structure updates that use the same scratch buffer
-    nvvk::accelerationStructureBarrier(cmd, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
-                                       VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR);
+    return;
   }
-  for(auto& skinNode : scene.getSkinNodes())  // Update the BLAS
+
+  // The scratch buffer is gone when the BLAS were built with buildBottomLevelAccelerationStructure
+  if(m_blasScratchBuffer.buffer == VK_NULL_HANDLE)
   {
-    int primID = scene.getRenderNodes()[skinNode].renderPrimID;
-    m_blasBuildData[primID].cmdUpdateAccelerationStructure(cmd, m_blasAccel[primID].accel, m_blasScratchBuffer.address);
+    VkDeviceSize scratchSize = 0;
+    for(uint32_t primID : scene.getMorphPrimitives())
+    {
+      scratchSize = std::max(scratchSize, m_blasBuildData[primID].sizeInfo.buildScratchSize);
+    }
+    for(uint32_t skinNode : scene.getSkinNodes())
+    {
+      int primID  = scene.getRenderNodes()[skinNode].renderPrimID;
+      scratchSize = std::max(scratchSize, m_blasBuildData[primID].sizeInfo.buildScratchSize);
+    }
+    NVVK_CHECK(m_alloc->createBuffer(m_blasScratchBuffer, scratchSize,
+                                     VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT
+                                         | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR,
+                                     VMA_MEMORY_USAGE_AUTO, {}, m_rtASProperties.minAccelerationStructureScratchOffsetAlignment));
+    NVVK_DBG_NAME(m_blasScratchBuffer.buffer);
+    m_memoryTracker.track(kMemCategoryScratch, m_blasScratchBuffer.allocation);
+  }
+
+  m_blasRefitCount.resize(m_blasAccel.size(), 0);
+
+  for(uint32_t primID : dirtyPrimitives)
+  {
+    nvvk::AccelerationStructureBuildData& buildData = m_blasBuildData[primID];
+
+    // Compacted BLAS are smaller than what a build requires
+    if(m_blasRebuildThreshold && !buildData.hasCompactFlag() && ++m_blasRefitCount[primID] > m_blasRebuildThreshold)
+    {
+      buildData.cmdBuildAccelerationStructure(cmd, m_blasAccel[primID].accel, m_blasScratchBuffer.address);
+      m_blasRefitCount[primID] = 0;
+    }
+    else
+    {
+      buildData.cmdUpdateAccelerationStructure(cmd, m_blasAccel[primID].accel, m_blasScratchBuffer.address);
+    }
     // Add synchronization between consecutive acceleration structure updates that use the same scratch buffer
     nvvk::accelerationStructureBarrier(cmd, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
                                        VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR);
   }
+
+  m_blasUpdated = true;
 }
 
 VkResult nvvkgltf::SceneRtx::cmdCompactBlas(VkCommandBuffer cmd)
@@ -50,6 +50,11 @@ public:
   void createBottomLevelAccelerationStructure(const nvvkgltf::Scene& scene, const SceneVk& sceneVk, VkBuildAccelerationStructureFlagsKHR flags);
   // Build the bottom level acceleration structure
   bool cmdBuildBottomLevelAccelerationStructure(VkCommandBuffer cmd, VkDeviceSize hintMaxBudget = 512'000'000);
+  // Build and compact the bottom level acceleration structure on `queueInfo` (e.g. async compute), returns once done.
+  // `sharingQueueFamilies` must list the queue families using the BLAS if they differ from `queueInfo`'s.
+  VkResult buildBottomLevelAccelerationStructure(const nvvk::QueueInfo&    queueInfo,
+                                                 std::span<const uint32_t> sharingQueueFamilies = {},
+                                                 VkDeviceSize              hintMaxBudget        = 512'000'000);
 
   // Create the top level acceleration structure
   void cmdCreateBuildTopLevelAccelerationStructure(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scene);
@@ -57,11 +62,16 @@ public:
   VkResult cmdCompactBlas(VkCommandBuffer cmd);
   // Destroy the original acceleration structures that was compacted
   void destroyNonCompactedBlas();
-  // Update the instance buffer and build the TLAS (animation)
+  // Update the instances changed by the last `Scene::updateRenderNodes` and update the TLAS (animation)
   void updateTopLevelAS(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scene);
-  // Update the bottom level acceleration structure
+  // Refit the BLAS of the primitives changed by the last `Scene::updateRenderNodes` (morph, skin)
   void updateBottomLevelAS(VkCommandBuffer cmd, const nvvkgltf::Scene& scene);
 
+  // Refits degrade the BLAS quality, after this many refits a BLAS is rebuilt instead (0 = always refit).
+  // Compacted BLAS are always refit, as their memory is too small for a rebuild.
+  void     setBlasRebuildThreshold(uint32_t refitCount) { m_blasRebuildThreshold = refitCount; }
+  uint32_t getBlasRebuildThreshold() const { return m_blasRebuildThreshold; }
+
   // Return the constructed acceleration structure
   VkAccelerationStructureKHR tlas();
 
@@ -99,7 +109,9 @@ protected:
   nvvk::Buffer m_tlasScratchBuffer;
   nvvk::Buffer m_instancesBuffer;
 
-  uint32_t m_numVisibleElement = 0;
+  std::vector<uint32_t> m_blasRefitCount;            // Refits since the last build, per BLAS
+  uint32_t              m_blasRebuildThreshold = 64;  // See setBlasRebuildThreshold
+  bool                  m_blasUpdated          = false;  // A BLAS changed since the last TLAS update
 
   GpuMemoryTracker m_memoryTracker;  // GPU memory tracking
 };
@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <nvutils/logger.hpp>
+#include <nvutils/timers.hpp>
+#include <nvvk/barriers.hpp>
+#include <nvvk/check_error.hpp>
+#include <nvvk/compute_pipeline.hpp>
+#include <nvvk/debug_util.hpp>
+
+#include "scene_skinning.hpp"
+
+VkResult nvvkgltf::SceneSkinning::init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv)
+{
+  assert(!m_device);
+  m_alloc  = alloc;
+  m_device = alloc->getDevice();
+
+  // All the data is accessed through the addresses of the push constant
+  VkPushConstantRange pushConstantRange{.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT, .size = sizeof(shaderio::GltfSkinningPushConstant)};
+
+  // Pipeline layout
+  const VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+      .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges    = &pushConstantRange,
+  };
+  NVVK_FAIL_RETURN(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout));
+  NVVK_DBG_NAME(m_pipelineLayout);
+
+  // Compute Pipeline
+  VkShaderModuleCreateInfo shaderInfo{
+      .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      .codeSize = spirv.size_bytes(),
+      .pCode    = spirv.data(),
+  };
+  VkComputePipelineCreateInfo compInfo{
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .stage =
+          {
+              .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+              .pNext = &shaderInfo,
+              .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+              .pName = "skinningMain",
+          },
+      .layout = m_pipelineLayout,
+  };
+  NVVK_FAIL_RETURN(vkCreateComputePipelines(m_device, nullptr, 1, &compInfo, nullptr, &m_pipeline));
+  NVVK_DBG_NAME(m_pipeline);
+
+  return VK_SUCCESS;
+}
+
+void nvvkgltf::SceneSkinning::deinit()
+{
+  if(!m_device)
+    return;
+
+  destroy();
+  vkDestroyPipeline(m_device, m_pipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+
+  m_pipelineLayout = VK_NULL_HANDLE;
+  m_pipeline       = VK_NULL_HANDLE;
+  m_device         = VK_NULL_HANDLE;
+}
+
+void nvvkgltf::SceneSkinning::create(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn, const SceneVk& scnVk)
+{
+  nvutils::ScopedTimer st(__FUNCTION__);
+  destroy();
+
+  const tinygltf::Model&                     model         = scn.getModel();
+  const std::vector<nvvkgltf::RenderNode>&   renderNodes   = scn.getRenderNodes();
+  const std::vector<SceneVk::VertexBuffers>& vertexBuffers = scnVk.vertexBuffers();
+  const VkBufferUsageFlags2 usage = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT;
+
+  // The skinned primitives are also morphed by their job, the others only have a morph job
+  std::vector<bool> skinnedPrims(scn.getNumRenderPrimitives(), false);
+  for(uint32_t skinNodeID : scn.getSkinNodes())
+  {
+    m_jobs.push_back({uint32_t(renderNodes[skinNodeID].renderPrimID), int32_t(skinNodeID)});
+    skinnedPrims[renderNodes[skinNodeID].renderPrimID] = true;
+  }
+  for(uint32_t renderPrimID : scn.getMorphPrimitives())
+  {
+    if(!skinnedPrims[renderPrimID])
+      m_jobs.push_back({renderPrimID, -1});
+  }
+  if(m_jobs.empty())
+    return;
+
+  auto uploadArray = [&](const auto& data) -> VkDeviceAddress {
+    if(data.empty())
+      return 0;
+    nvvk::Buffer& buffer = m_bResident.emplace_back();
+    NVVK_CHECK(m_alloc->createBuffer(buffer, std::span(data).size_bytes(), usage));
+    NVVK_CHECK(staging.appendBuffer(buffer, 0, std::span(data)));
+    NVVK_DBG_NAME(buffer.buffer);
+    return buffer.address;
+  };
+
+  // Inverse bind matrices of the skins
+  m_inverseBindMatrices.resize(model.skins.size());
+  for(size_t skinID = 0; skinID < model.skins.size(); skinID++)
+  {
+    const tinygltf::Skin& skin = model.skins[skinID];
+    m_inverseBindMatrices[skinID].assign(skin.joints.size(), glm::mat4(1));
+    if(skin.inverseBindMatrices > -1)
+    {
+      std::vector<glm::mat4>     storage;
+      std::span<const glm::mat4> ibm = tinygltf::utils::getAccessorData(model, model.accessors[skin.inverseBindMatrices], &storage);
+      std::copy_n(ibm.begin(), std::min(ibm.size(), skin.joints.size()), m_inverseBindMatrices[skinID].begin());
+    }
+  }
+
+  // Resident inputs of each primitive, shared by the jobs skinning the same primitive
+  std::unordered_map<uint32_t, shaderio::GltfSkinningJob> primInputs;
+  uint32_t                                                numWeights = 0;
+  uint32_t                                                numJoints  = 0;
+  for(const Job& job : m_jobs)
+  {
+    const nvvkgltf::RenderPrimitive& renderPrim = scn.getRenderPrimitive(job.renderPrimID);
+    const tinygltf::Primitive&       primitive  = *renderPrim.pPrimitive;
+
+    auto it = primInputs.find(job.renderPrimID);
+    if(it == primInputs.end())
+    {
+      shaderio::GltfSkinningJob inputs{};
+
+      std::vector<glm::vec3>     tempPosStorage;
+      std::span<const glm::vec3> positions = tinygltf::utils::getAttributeData3(model, primitive, "POSITION", &tempPosStorage);
+      std::vector<glm::vec3>     tempNrmStorage;
+      std::span<const glm::vec3> normals = tinygltf::utils::getAttributeData3(model, primitive, "NORMAL", &tempNrmStorage);
+      const size_t               vertexCount = positions.size();
+
+      inputs.vertexCount   = uint32_t(vertexCount);
+      inputs.bindPositions = (glm::vec3*)uploadArray(positions);
+      if(normals.size() == vertexCount)
+        inputs.bindNormals = (glm::vec3*)uploadArray(normals);
+
+      // Deltas of the targets one after the other, zero for the attributes a target doesn't move
+      const size_t numTargets = primitive.targets.size();
+      if(numTargets > 0 && !model.meshes[renderPrim.meshID].weights.empty())
+      {
+        std::vector<glm::vec3> morphPositions(numTargets * vertexCount, glm::vec3(0));
+        std::vector<glm::vec3> morphNormals;
+        for(size_t t = 0; t < numTargets; t++)
+        {
+          for(const char* attribute : {"POSITION", "NORMAL"})
+          {
+            const auto& findResult = primitive.targets[t].find(attribute);
+            if(findResult == primitive.targets[t].end())
+              continue;
+            std::vector<glm::vec3>           tempStorage;
+            const std::span<const glm::vec3> deltas =
+                tinygltf::utils::getAccessorData(model, model.accessors[findResult->second], &tempStorage);
+            std::vector<glm::vec3>& dst = attribute[0] == 'P' ? morphPositions : morphNormals;
+            dst.resize(numTargets * vertexCount, glm::vec3(0));
+            std::copy_n(deltas.begin(), std::min(deltas.size(), vertexCount), dst.begin() + t * vertexCount);
+          }
+        }
+        inputs.numTargets     = uint32_t(numTargets);
+        inputs.morphPositions = (glm::vec3*)uploadArray(morphPositions);
+        if(inputs.bindNormals)
+          inputs.morphNormals = (glm::vec3*)uploadArray(morphNormals);
+      }
+
+      if(job.skinNodeID > -1)
+      {
+        std::vector<glm::vec4>      tempWeightStorage;
+        std::span<const glm::vec4>  weights = tinygltf::utils::getAttributeData3(model, primitive, "WEIGHTS_0", &tempWeightStorage);
+        std::vector<glm::ivec4>     tempJointStorage;
+        std::span<const glm::ivec4> joints = tinygltf::utils::getAttributeData3(model, primitive, "JOINTS_0", &tempJointStorage);
+        if(weights.size() == vertexCount && joints.size() == vertexCount)
+        {
+          inputs.joints  = (glm::uvec4*)uploadArray(joints);
+          inputs.weights = (glm::vec4*)uploadArray(weights);
+        }
+      }
+
+      it = primInputs.emplace(job.renderPrimID, inputs).first;
+    }
+
+    shaderio::GltfSkinningJob info = it->second;
+    info.outPositions              = (glm::vec3*)vertexBuffers[job.renderPrimID].position.address;
+    info.outNormals                = info.bindNormals ? (glm::vec3*)vertexBuffers[job.renderPrimID].normal.address : nullptr;
+    info.firstWeight               = numWeights;
+    info.firstJoint                = numJoints;
+    numWeights += info.numTargets;
+    if(job.skinNodeID > -1 && info.joints)
+      numJoints += uint32_t(model.skins[renderNodes[job.skinNodeID].skinID].joints.size());
+    else
+      info.joints = nullptr;  // Only morphed by this job
+    m_jobInfos.push_back(info);
+  }
+  m_weightsScratch.resize(numWeights);
+  m_jointsScratch.resize(numJoints);
+
+  NVVK_CHECK(m_alloc->createBuffer(m_bJobs, std::span(m_jobInfos).size_bytes(), usage));
+  NVVK_CHECK(staging.appendBuffer(m_bJobs, 0, std::span(m_jobInfos)));
+  NVVK_DBG_NAME(m_bJobs.buffer);
+
+  // Uploaded at each update: written in place on resizable BAR systems
+  const VkDeviceSize weightsSize = std::max<size_t>(1, numWeights) * sizeof(float);
+  const VkDeviceSize jointsSize  = std::max<size_t>(1, numJoints) * sizeof(glm::mat4);
+  NVVK_CHECK(m_alloc->createBuffer(m_bMorphWeights, weightsSize, usage, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+                                   m_alloc->getDirectUploadFlags(weightsSize)));
+  NVVK_DBG_NAME(m_bMorphWeights.buffer);
+  NVVK_CHECK(m_alloc->createBuffer(m_bJointMatrices, jointsSize, usage, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+                                   m_alloc->getDirectUploadFlags(jointsSize)));
+  NVVK_DBG_NAME(m_bJointMatrices.buffer);
+
+  m_firstUpdate = true;
+  LOGI("%s%zu animated primitives, %u morph weights, %u joints\n", st.indent().c_str(), m_jobs.size(), numWeights, numJoints);
+}
+
+void nvvkgltf::SceneSkinning::destroy()
+{
+  for(nvvk::Buffer& buffer : m_bResident)
+  {
+    m_alloc->destroyBuffer(buffer);
+  }
+  m_bResident.clear();
+  m_alloc->destroyBuffer(m_bJobs);
+  m_alloc->destroyBuffer(m_bMorphWeights);
+  m_alloc->destroyBuffer(m_bJointMatrices);
+  m_jobs.clear();
+  m_jobInfos.clear();
+  m_inverseBindMatrices.clear();
+}
+
+void nvvkgltf::SceneSkinning::cmdUpdate(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn)
+{
+  NVVK_DBG_SCOPE(cmd);  // <-- Helps to debug in NSight
+  assert(m_device && "Missing init()");
+
+  const tinygltf::Model&                   model        = scn.getModel();
+  const std::vector<nvvkgltf::RenderNode>& renderNodes  = scn.getRenderNodes();
+  const std::vector<glm::mat4>&            nodeMatrices = scn.getNodesWorldMatrices();
+  const std::vector<uint32_t>&             dirtyPrims   = scn.getDirtyRenderPrimitives();
+
+  // Jobs of the primitives that moved
+  std::vector<uint32_t> jobIDs;
+  for(uint32_t jobID = 0; jobID < uint32_t(m_jobs.size()); jobID++)
+  {
+    if(m_firstUpdate || std::binary_search(dirtyPrims.begin(), dirtyPrims.end(), m_jobs[jobID].renderPrimID))
+      jobIDs.push_back(jobID);
+  }
+  if(jobIDs.empty())
+    return;
+  m_firstUpdate = false;
+
+  // Weights and joint matrices of all the jobs, the same values as the CPU path
+  for(size_t jobID = 0; jobID < m_jobs.size(); jobID++)
+  {
+    const Job&                       job  = m_jobs[jobID];
+    const shaderio::GltfSkinningJob& info = m_jobInfos[jobID];
+
+    const std::vector<double>& meshWeights = model.meshes[scn.getRenderPrimitive(job.renderPrimID).meshID].weights;
+    for(uint32_t t = 0; t < info.numTargets; t++)
+    {
+      m_weightsScratch[info.firstWeight + t] = t < meshWeights.size() ? float(meshWeights[t]) : 0.0f;
+    }
+
+    if(info.joints)
+    {
+      const nvvkgltf::RenderNode& skinNode = renderNodes[job.skinNodeID];
+      const tinygltf::Skin&       skin     = model.skins[skinNode.skinID];
+      glm::mat4 invNode = glm::inverse(nodeMatrices[skinNode.refNodeID]);  // Removing current node transform as it will be applied by the shaders
+      for(size_t i = 0; i < skin.joints.size(); i++)
+      {
+        m_jointsScratch[info.firstJoint + i] = invNode * nodeMatrices[skin.joints[i]] * m_inverseBindMatrices[skinNode.skinID][i];
+      }
+    }
+  }
+
+  if(!m_weightsScratch.empty())
+    NVVK_CHECK(staging.appendBuffer(m_bMorphWeights, 0, std::span(m_weightsScratch)));
+  if(!m_jointsScratch.empty())
+    NVVK_CHECK(staging.appendBuffer(m_bJointMatrices, 0, std::span(m_jointsScratch)));
+  staging.cmdUploadAppended(cmd);
+
+  // Uploads done, and the previous users of the vertex buffers (draws, acceleration structure builds) are finished
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                         VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+  shaderio::GltfSkinningPushConstant pushConstant{
+      .jobs          = (shaderio::GltfSkinningJob*)m_bJobs.address,
+      .morphWeights  = (float*)m_bMorphWeights.address,
+      .jointMatrices = (glm::mat4*)m_bJointMatrices.address,
+  };
+  for(uint32_t jobID : jobIDs)
+  {
+    pushConstant.jobID = jobID;
+    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstant), &pushConstant);
+    vkCmdDispatch(cmd, nvvk::getGroupCounts(m_jobInfos[jobID].vertexCount, GLTF_SKINNING_WORKGROUP_SIZE), 1, 1);
+  }
+
+  // The vertex buffers are read by the rendering and the acceleration structure builds
+  nvvk::cmdMemoryBarrier(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                         VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_ACCESS_2_MEMORY_READ_BIT);
+}
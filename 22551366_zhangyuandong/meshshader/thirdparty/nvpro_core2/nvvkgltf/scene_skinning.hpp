@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2025, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025, NVIDIA CORPORATION.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <span>
+
+#include <nvvk/resource_allocator.hpp>
+#include <nvvk/staging.hpp>
+
+#include "nvshaders/gltf_skinning_io.h.slang"  // Shared between host and device
+#include "scene_vk.hpp"
+
+/*-------------------------------------------------------------------------------------------------
+# class nvvkgltf::SceneSkinning
+
+>  GPU morph targets and skinning, replacing the CPU blending of `SceneVk::update`.
+
+The bind poses, morph target deltas, joints and weights of the animated primitives stay resident on the
+device. A compute pass (nvshaders/gltf_skinning.slang) blends them and writes the positions and normals
+in the vertex buffers of SceneVk, so an update only uploads the morph weights and the joint matrices.
+
+- Call `SceneVk::setGpuAnimation(true)` so that `SceneVk::update` no longer rewrites the positions.
+- Only the primitives of `Scene::getDirtyRenderPrimitives()` are recomputed, all of them after `create`.
+- The vertex buffers are ready for the vertex input, the shaders and the acceleration structure builds
+  (e.g. `SceneRtx::updateBottomAS`) after `cmdUpdate`.
+
+Usage:
+  nvvkgltf::SceneSkinning skinning;
+  skinning.init(&alloc, gltf_skinning_slang);  // SPIR-V compiled from nvshaders/gltf_skinning.slang
+  sceneVk.setGpuAnimation(true);
+  sceneVk.create(cmd, staging, scene);
+  skinning.create(cmd, staging, scene, sceneVk);
+  // after the animation of the scene
+  sceneVk.update(cmd, staging, scene);
+  skinning.cmdUpdate(cmd, staging, scene);
+ -------------------------------------------------------------------------------------------------*/
+namespace nvvkgltf {
+
+class SceneSkinning
+{
+public:
+  SceneSkinning() = default;
+  ~SceneSkinning() { assert(m_device == VK_NULL_HANDLE); }  // Missing deinit call
+
+  // `spirv` is compiled from nvshaders/gltf_skinning.slang
+  VkResult init(nvvk::ResourceAllocator* alloc, std::span<const uint32_t> spirv);
+  void     deinit();
+
+  // Uploads the resident data of the morphed and skinned primitives, to call again when the scene changes
+  void create(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn, const SceneVk& scnVk);
+  void destroy();
+
+  // Uploads the weights and joint matrices, flushes the staging and writes the animated vertex buffers
+  void cmdUpdate(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn);
+
+  bool hasJobs() const { return !m_jobs.empty(); }
+
+private:
+  struct Job
+  {
+    uint32_t renderPrimID = 0;
+    int32_t  skinNodeID   = -1;  // -1 when only morphed
+  };
+
+  nvvk::ResourceAllocator* m_alloc{};
+  VkDevice                 m_device{};
+  VkPipelineLayout         m_pipelineLayout{};
+  VkPipeline               m_pipeline{};
+
+  std::vector<Job>                       m_jobs;
+  std::vector<shaderio::GltfSkinningJob> m_jobInfos;
+  std::vector<std::vector<glm::mat4>>    m_inverseBindMatrices;  // per skin
+  std::vector<float>                     m_weightsScratch;
+  std::vector<glm::mat4>                 m_jointsScratch;
+  bool                                   m_firstUpdate = true;
+
+  std::vector<nvvk::Buffer> m_bResident;       // bind poses, deltas, joints and weights of the jobs
+  nvvk::Buffer              m_bJobs;           // GltfSkinningJob
+  nvvk::Buffer              m_bMorphWeights;   // float, updated by cmdUpdate
+  nvvk::Buffer              m_bJointMatrices;  // mat4, updated by cmdUpdate
+};
+
+}  // namespace nvvkgltf
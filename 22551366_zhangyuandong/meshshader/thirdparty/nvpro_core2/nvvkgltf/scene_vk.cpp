@@ -18,17 +18,29 @@
  */
 
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cinttypes>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <limits>
 #include <mutex>
 #include <sstream>
 #include <span>
 
 
 #include <glm/glm.hpp>
+#include <fmt/format.h>
+#include <meshoptimizer/src/meshoptimizer.h>
 
 #include "nvshaders/gltf_scene_io.h.slang"  // Shared between host and device
 
 #include "stb_image.h"
+#include "nvimageformats/nv_bcenc.h"
 #include "nvimageformats/nv_dds.h"
 #include "nvimageformats/nv_ktx.h"
 #include "nvimageformats/texture_formats.h"
@@ -41,6 +53,7 @@
 #include "nvvk/default_structs.hpp"
 #include "nvvk/mipmaps.hpp"
 
+#include "scene_cache.hpp"
 #include "scene_vk.hpp"
 #include "nvutils/parallel_work.hpp"
 #include "nvvk/helpers.hpp"
@@ -70,6 +83,11 @@ void nvvkgltf::SceneVk::init(nvvk::ResourceAllocator* alloc, nvvk::SamplerPool*
   m_alloc          = alloc;
   m_samplerPool    = samplerPool;
   m_memoryTracker.init(alloc);
+
+  VkPhysicalDeviceFeatures features{};
+  vkGetPhysicalDeviceFeatures(m_physicalDevice, &features);
+  m_supportsAstc = features.textureCompressionASTC_LDR == VK_TRUE;
+  m_supportsBc   = features.textureCompressionBC == VK_TRUE;
 }
 
 void nvvkgltf::SceneVk::deinit()
@@ -107,20 +125,23 @@ void nvvkgltf::SceneVk::create(VkCommandBuffer        cmd,
   updateMaterialBuffer(cmd, staging, scn);
   updateRenderNodesBuffer(cmd, staging, scn);
   createVertexBuffers(cmd, staging, scn);
+  createMeshletBuffers(cmd, staging, scn);
   createTextureImages(cmd, staging, scn.getModel(), basedir);
   updateRenderLightsBuffer(cmd, staging, scn);
 
   // Update the buffers for morph and skinning
-  updateRenderPrimitivesBuffer(cmd, staging, scn);
+  if(!m_gpuAnimation)
+    updateRenderPrimitivesBuffer(cmd, staging, scn);
 
   // Buffer references
   shaderio::GltfScene scene_desc{};
-  scene_desc.materials        = (shaderio::GltfShadeMaterial*)m_bMaterial.address;
-  scene_desc.textureInfos     = (shaderio::GltfTextureInfo*)m_bTextureInfos.address;
-  scene_desc.renderPrimitives = (shaderio::GltfRenderPrimitive*)m_bRenderPrim.address;
-  scene_desc.renderNodes      = (shaderio::GltfRenderNode*)m_bRenderNode.address;
-  scene_desc.lights           = (shaderio::GltfLight*)m_bLights.address;
-  scene_desc.numLights        = static_cast<int>(scn.getRenderLights().size());
+  scene_desc.materials         = (shaderio::GltfShadeMaterial*)m_bMaterial.address;
+  scene_desc.textureInfos      = (shaderio::GltfTextureInfo*)m_bTextureInfos.address;
+  scene_desc.renderPrimitives  = (shaderio::GltfRenderPrimitive*)m_bRenderPrim.address;
+  scene_desc.renderNodes       = (shaderio::GltfRenderNode*)m_bRenderNode.address;
+  scene_desc.lights            = (shaderio::GltfLight*)m_bLights.address;
+  scene_desc.numLights         = static_cast<int>(scn.getRenderLights().size());
+  scene_desc.meshletPrimitives = (shaderio::GltfMeshletPrimitive*)m_bMeshletPrim.address;
 
   NVVK_CHECK(m_alloc->createBuffer(m_bSceneDesc, std::span(&scene_desc, 1).size_bytes(),
                                    VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT));
@@ -131,9 +152,10 @@ void nvvkgltf::SceneVk::create(VkCommandBuffer        cmd,
 
 void nvvkgltf::SceneVk::update(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn)
 {
-  updateMaterialBuffer(cmd, staging, scn);
+  updateMaterialBuffer(cmd, staging, scn, scn.getDirtyMaterials());
   updateRenderNodesBuffer(cmd, staging, scn);
-  updateRenderPrimitivesBuffer(cmd, staging, scn);
+  if(!m_gpuAnimation)
+    updateRenderPrimitivesBuffer(cmd, staging, scn);
 }
 
 template <typename T>
@@ -152,23 +174,54 @@ inline shaderio::GltfTextureInfo getTextureInfo(const T& tinfo)
   };
 }
 
+// Texture infos of a material, they are stored in the slots starting at `first`
+struct MaterialTextureInfos
+{
+  uint32_t                               first = 0;
+  std::vector<shaderio::GltfTextureInfo> infos;
+};
+
 // Helper to handle texture info and update textureInfos vector
 template <typename T>
-uint16_t addTextureInfo(const T& tinfo, std::vector<shaderio::GltfTextureInfo>& textureInfos)
+uint16_t addTextureInfo(const T& tinfo, MaterialTextureInfos& textureInfos)
 {
   shaderio::GltfTextureInfo ti = getTextureInfo(tinfo);
   if(ti.index != -1)
   {
-    uint16_t idx = static_cast<uint16_t>(textureInfos.size());
-    textureInfos.push_back(ti);
+    uint16_t idx = static_cast<uint16_t>(textureInfos.first + textureInfos.infos.size());
+    textureInfos.infos.push_back(ti);
     return idx;
   }
   return 0;  // No texture
 }
 
-static void getShaderMaterial(const tinygltf::Material&                 srcMat,
-                              std::vector<shaderio::GltfShadeMaterial>& shadeMaterial,
-                              std::vector<shaderio::GltfTextureInfo>&   textureInfos)
+// Features changing the shading: the others keep their glTF defaults, which is what
+// pbr_material_eval.h.slang uses for the features left out of PBR_MATERIAL_FEATURES
+static uint16_t computeMaterialFeatures(const shaderio::GltfShadeMaterial& mat)
+{
+  uint16_t features = 0;
+  if(mat.usePbrSpecularGlossiness != 0)
+    features |= GLTF_MATERIAL_FEATURE_SPECULAR_GLOSSINESS;
+  if(mat.specularFactor != 1.0f || mat.specularColorFactor != glm::vec3(1.0f) || mat.specularTexture != 0 || mat.specularColorTexture != 0)
+    features |= GLTF_MATERIAL_FEATURE_SPECULAR;
+  if(mat.transmissionFactor > 0.0f)
+    features |= GLTF_MATERIAL_FEATURE_TRANSMISSION;
+  if(mat.clearcoatFactor > 0.0f)
+    features |= GLTF_MATERIAL_FEATURE_CLEARCOAT;
+  if(mat.iridescenceFactor > 0.0f)
+    features |= GLTF_MATERIAL_FEATURE_IRIDESCENCE;
+  if(mat.anisotropyStrength > 0.0f)
+    features |= GLTF_MATERIAL_FEATURE_ANISOTROPY;
+  if(mat.sheenColorFactor != glm::vec3(0.0f))
+    features |= GLTF_MATERIAL_FEATURE_SHEEN;
+  if(mat.dispersion > 0.0f)
+    features |= GLTF_MATERIAL_FEATURE_DISPERSION;
+  if(mat.diffuseTransmissionFactor > 0.0f)
+    features |= GLTF_MATERIAL_FEATURE_DIFFUSE_TRANSMISSION;
+  return features;
+}
+
+static shaderio::GltfShadeMaterial getShaderMaterial(const tinygltf::Material& srcMat, MaterialTextureInfos& textureInfos)
 {
   int alphaMode = srcMat.alphaMode == "OPAQUE" ? 0 : (srcMat.alphaMode == "MASK" ? 1 : 2 /*BLEND*/);
 
@@ -265,12 +318,13 @@ static void getShaderMaterial(const tinygltf::Material&                 srcMat,
   dstMat.diffuseTransmissionColor   = diffuseTransmission.diffuseTransmissionColor;
   dstMat.diffuseTransmissionColorTexture = addTextureInfo(diffuseTransmission.diffuseTransmissionColorTexture, textureInfos);
 
-  shadeMaterial.emplace_back(dstMat);
+  dstMat.features = computeMaterialFeatures(dstMat);
+  return dstMat;
 }
 
 //--------------------------------------------------------------------------------------------------
 // Create a buffer of all materials, with only the elements we need
-//
+// - The texture infos of each material are packed in a range of slots, which incremental updates rewrite in place
 void nvvkgltf::SceneVk::updateMaterialBuffer(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn)
 {
   nvutils::ScopedTimer st(__FUNCTION__);
@@ -278,33 +332,157 @@ void nvvkgltf::SceneVk::updateMaterialBuffer(VkCommandBuffer cmd, nvvk::StagingU
   using namespace tinygltf;
   const std::vector<tinygltf::Material>& materials = scn.getModel().materials;
 
-  std::vector<shaderio::GltfShadeMaterial> shadeMaterials;
-  std::vector<shaderio::GltfTextureInfo>   textureInfos;
-  textureInfos.push_back({});  // 0 is reserved for no texture
-  shadeMaterials.reserve(materials.size());
-  for(const auto& srcMat : materials)
+  m_materialsScratch.resize(materials.size());
+  m_materialTextureSlots.resize(materials.size());
+  m_textureInfosScratch.clear();
+  m_textureInfosScratch.push_back({});  // 0 is reserved for no texture
+  for(size_t i = 0; i < materials.size(); i++)
   {
-    getShaderMaterial(srcMat, shadeMaterials, textureInfos);
+    MaterialTextureInfos textureInfos{.first = static_cast<uint32_t>(m_textureInfosScratch.size())};
+    m_materialsScratch[i]     = getShaderMaterial(materials[i], textureInfos);
+    m_materialTextureSlots[i] = {textureInfos.first, static_cast<uint32_t>(textureInfos.infos.size())};
+    m_textureInfosScratch.insert(m_textureInfosScratch.end(), textureInfos.infos.begin(), textureInfos.infos.end());
   }
 
-  if(m_bMaterial.buffer == VK_NULL_HANDLE)
+  m_materialFeatures.resize(m_materialsScratch.size());
+  for(size_t i = 0; i < m_materialsScratch.size(); i++)
   {
-    NVVK_CHECK(m_alloc->createBuffer(m_bMaterial, std::span(shadeMaterials).size_bytes(),
+    m_materialFeatures[i] = m_materialsScratch[i].features;
+  }
+  updateMaterialPermutations();
+
+  const VkDeviceSize materialsSize    = std::span(m_materialsScratch).size_bytes();
+  const VkDeviceSize textureInfosSize = std::span(m_textureInfosScratch).size_bytes();
+  if(m_bMaterial.buffer == VK_NULL_HANDLE || m_bMaterial.bufferSize < materialsSize || m_bTextureInfos.bufferSize < textureInfosSize)
+  {
+    // Materials or textures were added since the first upload: the GPU must no longer use the previous buffers
+    if(m_bMaterial.buffer != VK_NULL_HANDLE)
+    {
+      m_memoryTracker.untrack(kMemCategorySceneData, m_bMaterial.allocation);
+      m_alloc->destroyBuffer(m_bMaterial);
+      m_memoryTracker.untrack(kMemCategorySceneData, m_bTextureInfos.allocation);
+      m_alloc->destroyBuffer(m_bTextureInfos);
+    }
+
+    NVVK_CHECK(m_alloc->createBuffer(m_bMaterial, materialsSize,
                                      VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT));
-    NVVK_CHECK(staging.appendBuffer(m_bMaterial, 0, std::span(shadeMaterials)));
+    NVVK_CHECK(staging.appendBuffer(m_bMaterial, 0, std::span(m_materialsScratch)));
     NVVK_DBG_NAME(m_bMaterial.buffer);
     m_memoryTracker.track(kMemCategorySceneData, m_bMaterial.allocation);
 
-    NVVK_CHECK(m_alloc->createBuffer(m_bTextureInfos, std::span(textureInfos).size_bytes(),
+    NVVK_CHECK(m_alloc->createBuffer(m_bTextureInfos, textureInfosSize,
                                      VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT));
-    NVVK_CHECK(staging.appendBuffer(m_bTextureInfos, 0, std::span(textureInfos)));
+    NVVK_CHECK(staging.appendBuffer(m_bTextureInfos, 0, std::span(m_textureInfosScratch)));
     NVVK_DBG_NAME(m_bTextureInfos.buffer);
     m_memoryTracker.track(kMemCategorySceneData, m_bTextureInfos.allocation);
+
+    // The scene description references the new buffers
+    if(m_bSceneDesc.buffer != VK_NULL_HANDLE)
+    {
+      const shaderio::GltfShadeMaterial* materialsAddress    = (shaderio::GltfShadeMaterial*)m_bMaterial.address;
+      const shaderio::GltfTextureInfo*   textureInfosAddress = (shaderio::GltfTextureInfo*)m_bTextureInfos.address;
+      NVVK_CHECK(staging.appendBuffer(m_bSceneDesc, offsetof(shaderio::GltfScene, materials), std::span(&materialsAddress, 1)));
+      NVVK_CHECK(staging.appendBuffer(m_bSceneDesc, offsetof(shaderio::GltfScene, textureInfos), std::span(&textureInfosAddress, 1)));
+    }
   }
   else
   {
-    staging.appendBuffer(m_bMaterial, 0, std::span(shadeMaterials));
-    staging.appendBuffer(m_bTextureInfos, 0, std::span(textureInfos));
+    staging.appendBuffer(m_bMaterial, 0, std::span(m_materialsScratch));
+    staging.appendBuffer(m_bTextureInfos, 0, std::span(m_textureInfosScratch));
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Same as above, for the materials that changed
+// - Each material is regenerated in its own texture info slots, the others are left untouched
+// - One copy per run of consecutive materials, and one for their texture infos, which are contiguous
+// - A material having more textures than when packed needs more slots: everything is packed again
+void nvvkgltf::SceneVk::updateMaterialBuffer(VkCommandBuffer           cmd,
+                                             nvvk::StagingUploader&    staging,
+                                             const nvvkgltf::Scene&    scn,
+                                             std::span<const uint32_t> materialIDs)
+{
+  const std::vector<tinygltf::Material>& materials = scn.getModel().materials;
+  if(m_bMaterial.buffer == VK_NULL_HANDLE || m_materialsScratch.size() != materials.size())
+  {
+    updateMaterialBuffer(cmd, staging, scn);  // First upload, or materials were added
+    return;
+  }
+  if(materialIDs.empty())
+    return;
+
+  assert(std::is_sorted(materialIDs.begin(), materialIDs.end()) && "Materials must be sorted");
+
+  std::vector<MaterialTextureInfos> textureInfos(materialIDs.size());
+  nvutils::parallel_batches_auto(materialIDs.size(), [&](uint64_t i) {
+    const uint32_t materialID      = materialIDs[i];
+    textureInfos[i].first          = m_materialTextureSlots[materialID].first;
+    m_materialsScratch[materialID] = getShaderMaterial(materials[materialID], textureInfos[i]);
+  });
+
+  bool featuresChanged = false;
+  for(size_t i = 0; i < materialIDs.size(); i++)
+  {
+    const uint32_t              materialID = materialIDs[i];
+    const TextureInfoSlots&     slots      = m_materialTextureSlots[materialID];
+    const MaterialTextureInfos& infos      = textureInfos[i];
+    if(infos.infos.size() > slots.count)
+    {
+      updateMaterialBuffer(cmd, staging, scn);
+      return;
+    }
+    // Fewer textures than before leave unused slots, kept for later edits
+    std::copy(infos.infos.begin(), infos.infos.end(), m_textureInfosScratch.begin() + slots.first);
+
+    featuresChanged                = featuresChanged || m_materialFeatures[materialID] != m_materialsScratch[materialID].features;
+    m_materialFeatures[materialID] = m_materialsScratch[materialID].features;
+  }
+  if(featuresChanged)
+  {
+    updateMaterialPermutations();
+  }
+
+  // Merging the adjacent materials
+  size_t runStart = 0;
+  for(size_t i = 1; i <= materialIDs.size(); i++)
+  {
+    if(i < materialIDs.size() && materialIDs[i] <= materialIDs[i - 1] + 1)
+      continue;
+
+    const uint32_t first = materialIDs[runStart];
+    const uint32_t last  = materialIDs[i - 1];
+    NVVK_CHECK(staging.appendBuffer(m_bMaterial, sizeof(shaderio::GltfShadeMaterial) * first,
+                                    std::span(m_materialsScratch).subspan(first, last - first + 1)));
+
+    const uint32_t firstSlot = m_materialTextureSlots[first].first;
+    const uint32_t endSlot   = m_materialTextureSlots[last].first + m_materialTextureSlots[last].count;
+    if(endSlot > firstSlot)
+    {
+      NVVK_CHECK(staging.appendBuffer(m_bTextureInfos, sizeof(shaderio::GltfTextureInfo) * firstSlot,
+                                      std::span(m_textureInfosScratch).subspan(firstSlot, endSlot - firstSlot)));
+    }
+    runStart = i;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Materials sorted by features, one permutation per distinct set
+//
+void nvvkgltf::SceneVk::updateMaterialPermutations()
+{
+  m_materialPermutations.clear();
+  std::vector<uint32_t> sortedMaterials(m_materialFeatures.size());
+  for(uint32_t i = 0; i < uint32_t(m_materialFeatures.size()); i++)
+  {
+    sortedMaterials[i] = i;
+  }
+  std::stable_sort(sortedMaterials.begin(), sortedMaterials.end(),
+                   [&](uint32_t a, uint32_t b) { return m_materialFeatures[a] < m_materialFeatures[b]; });
+  for(uint32_t materialID : sortedMaterials)
+  {
+    if(m_materialPermutations.empty() || m_materialPermutations.back().features != m_materialFeatures[materialID])
+      m_materialPermutations.push_back({.features = m_materialFeatures[materialID]});
+    m_materialPermutations.back().materials.push_back(materialID);
   }
 }
 
@@ -336,8 +514,8 @@ std::vector<glm::vec3> getBlendedPositions(const tinygltf::Accessor&  baseAccess
       const std::span<const glm::vec3> morphTargetData = tinygltf::utils::getAccessorData(model, morphAccessor, &tempStorage);
 
       // Apply the morph target offset in parallel, scaled by the corresponding weight
-      nvutils::parallel_batches(blendedPositions.size(),
-                                [&](uint64_t v) { blendedPositions[v] += weight * morphTargetData[v]; });
+      nvutils::parallel_batches_auto(blendedPositions.size(),
+                                     [&](uint64_t v) { blendedPositions[v] += weight * morphTargetData[v]; });
     }
   }
 
@@ -356,7 +534,7 @@ std::vector<glm::vec3> getSkinnedPositions(const std::span<const glm::vec3>&  ba
   std::vector<glm::vec3> skinnedPositions(vertexCount);
 
   // Apply skinning using multi-threading
-  nvutils::parallel_batches<2048>(weights.size(), [&](uint64_t v) {
+  nvutils::parallel_batches_auto(weights.size(), [&](uint64_t v) {
     glm::vec3 skinnedPosition(0.0f);
 
     // Skinning: blend the position based on joint weights and transforms
@@ -376,6 +554,16 @@ std::vector<glm::vec3> getSkinnedPositions(const std::span<const glm::vec3>&  ba
   return skinnedPositions;
 }
 
+static shaderio::GltfRenderNode makeGltfRenderNode(const nvvkgltf::RenderNode& renderNode)
+{
+  shaderio::GltfRenderNode info{};
+  info.objectToWorld = renderNode.worldMatrix;
+  info.worldToObject = glm::inverse(renderNode.worldMatrix);
+  info.materialID    = renderNode.materialID;
+  info.renderPrimID  = renderNode.renderPrimID;
+  return info;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Array of instance information
 // - Use by the vertex shader to retrieve the position of the instance
@@ -383,27 +571,63 @@ void nvvkgltf::SceneVk::updateRenderNodesBuffer(VkCommandBuffer cmd, nvvk::Stagi
 {
   // nvutils::ScopedTimer st(__FUNCTION__);
 
-  std::vector<shaderio::GltfRenderNode> instanceInfo;
-  for(const nvvkgltf::RenderNode& renderNode : scn.getRenderNodes())
-  {
-    shaderio::GltfRenderNode info{};
-    info.objectToWorld = renderNode.worldMatrix;
-    info.worldToObject = glm::inverse(renderNode.worldMatrix);
-    info.materialID    = renderNode.materialID;
-    info.renderPrimID  = renderNode.renderPrimID;
-    instanceInfo.emplace_back(info);
-  }
+  const std::vector<nvvkgltf::RenderNode>& renderNodes = scn.getRenderNodes();
+  m_renderNodesScratch.resize(renderNodes.size());
+  nvutils::parallel_batches_auto(renderNodes.size(),
+                                 [&](uint64_t i) { m_renderNodesScratch[i] = makeGltfRenderNode(renderNodes[i]); });
+
   if(m_bRenderNode.buffer == VK_NULL_HANDLE)
   {
-    NVVK_CHECK(m_alloc->createBuffer(m_bRenderNode, std::span(instanceInfo).size_bytes(),
-                                     VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT));
-    NVVK_CHECK(staging.appendBuffer(m_bRenderNode, 0, std::span(instanceInfo)));
+    // Updated when nodes animate: written in place on resizable BAR systems
+    const VkDeviceSize bufferSize = std::span(m_renderNodesScratch).size_bytes();
+    NVVK_CHECK(m_alloc->createBuffer(m_bRenderNode, bufferSize, VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT,
+                                     VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE, m_alloc->getDirectUploadFlags(bufferSize)));
+    NVVK_CHECK(staging.appendBuffer(m_bRenderNode, 0, std::span(m_renderNodesScratch)));
     NVVK_DBG_NAME(m_bRenderNode.buffer);
     m_memoryTracker.track(kMemCategorySceneData, m_bRenderNode.allocation);
   }
   else
   {
-    staging.appendBuffer(m_bRenderNode, 0, std::span(instanceInfo));
+    staging.appendBuffer(m_bRenderNode, 0, std::span(m_renderNodesScratch));
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Same as above, for the render nodes that changed
+// - The cost is proportional to the number of changed nodes, with one copy per run of consecutive nodes
+void nvvkgltf::SceneVk::updateRenderNodesBuffer(VkCommandBuffer           cmd,
+                                                nvvk::StagingUploader&    staging,
+                                                const nvvkgltf::Scene&    scn,
+                                                std::span<const uint32_t> renderNodeIDs)
+{
+  const std::vector<nvvkgltf::RenderNode>& renderNodes = scn.getRenderNodes();
+  if(m_bRenderNode.buffer == VK_NULL_HANDLE || m_renderNodesScratch.size() != renderNodes.size())
+  {
+    updateRenderNodesBuffer(cmd, staging, scn);  // First upload, or the render nodes were recreated
+    return;
+  }
+  if(renderNodeIDs.empty())
+    return;
+
+  assert(std::is_sorted(renderNodeIDs.begin(), renderNodeIDs.end()) && "Render nodes must be sorted");
+
+  nvutils::parallel_batches_auto(renderNodeIDs.size(), [&](uint64_t i) {
+    const uint32_t renderNodeID          = renderNodeIDs[i];
+    m_renderNodesScratch[renderNodeID] = makeGltfRenderNode(renderNodes[renderNodeID]);
+  });
+
+  // Merging the adjacent render nodes
+  size_t runStart = 0;
+  for(size_t i = 1; i <= renderNodeIDs.size(); i++)
+  {
+    if(i < renderNodeIDs.size() && renderNodeIDs[i] <= renderNodeIDs[i - 1] + 1)
+      continue;
+
+    const uint32_t first = renderNodeIDs[runStart];
+    const uint32_t count = renderNodeIDs[i - 1] - first + 1;
+    NVVK_CHECK(staging.appendBuffer(m_bRenderNode, sizeof(shaderio::GltfRenderNode) * first,
+                                    std::span(m_renderNodesScratch).subspan(first, count)));
+    runStart = i;
   }
 }
 
@@ -561,8 +785,547 @@ bool nvvkgltf::SceneVk::updateAttributeBuffer(VkCommandBuffer cmd,
   return false;
 }
 
+//--------------------------------------------------------------------------------------------------
+// Meshlets of a render primitive, as built by meshoptimizer
+struct MeshletData
+{
+  std::vector<meshopt_Meshlet>             meshlets;
+  std::vector<uint32_t>                    vertices;
+  std::vector<uint8_t>                     triangles;  // padded to a multiple of 4 bytes
+  std::vector<shaderio::GltfMeshletBounds> bounds;
+};
+
+static_assert(sizeof(meshopt_Meshlet) == sizeof(shaderio::GltfMeshlet), "GltfMeshlet must match meshopt_Meshlet");
+
+// Header of the meshlet cache files, followed by the arrays of MeshletData
+struct MeshletCacheHeader
+{
+  uint32_t magic   = 0x4c48534d;  // 'MSHL'
+  uint32_t version = 1;
+  uint64_t numMeshlets{};
+  uint64_t numVertices{};
+  uint64_t numTriangleBytes{};
+};
+
+static bool loadMeshletCache(const std::filesystem::path& filename, MeshletData& data)
+{
+  std::ifstream file(filename, std::ios::binary);
+  if(!file)
+    return false;
+
+  MeshletCacheHeader       header{};
+  const MeshletCacheHeader expected{};
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if(!file || header.magic != expected.magic || header.version != expected.version)
+    return false;
+
+  data.meshlets.resize(header.numMeshlets);
+  data.bounds.resize(header.numMeshlets);
+  data.vertices.resize(header.numVertices);
+  data.triangles.resize(header.numTriangleBytes);
+  file.read(reinterpret_cast<char*>(data.meshlets.data()), std::span(data.meshlets).size_bytes());
+  file.read(reinterpret_cast<char*>(data.bounds.data()), std::span(data.bounds).size_bytes());
+  file.read(reinterpret_cast<char*>(data.vertices.data()), std::span(data.vertices).size_bytes());
+  file.read(reinterpret_cast<char*>(data.triangles.data()), std::span(data.triangles).size_bytes());
+  return static_cast<bool>(file);
+}
+
+static void saveMeshletCache(const std::filesystem::path& filename, const MeshletData& data)
+{
+  std::ofstream file(filename, std::ios::binary);
+  if(!file)
+  {
+    LOGW("Could not write meshlet cache %s\n", nvutils::utf8FromPath(filename).c_str());
+    return;
+  }
+
+  MeshletCacheHeader header{};
+  header.numMeshlets      = data.meshlets.size();
+  header.numVertices      = data.vertices.size();
+  header.numTriangleBytes = data.triangles.size();
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(data.meshlets.data()), std::span(data.meshlets).size_bytes());
+  file.write(reinterpret_cast<const char*>(data.bounds.data()), std::span(data.bounds).size_bytes());
+  file.write(reinterpret_cast<const char*>(data.vertices.data()), std::span(data.vertices).size_bytes());
+  file.write(reinterpret_cast<const char*>(data.triangles.data()), std::span(data.triangles).size_bytes());
+}
+
+static void buildMeshlets(std::span<const uint32_t>                indices,
+                          std::span<const glm::vec3>               positions,
+                          const nvvkgltf::SceneVk::MeshletOptions& options,
+                          MeshletData&                             data)
+{
+  const size_t maxMeshlets = meshopt_buildMeshletsBound(indices.size(), options.maxVertices, options.maxTriangles);
+  data.meshlets.resize(maxMeshlets);
+  data.vertices.resize(maxMeshlets * options.maxVertices);
+  data.triangles.resize(maxMeshlets * options.maxTriangles * 3);
+
+  const size_t numMeshlets =
+      meshopt_buildMeshlets(data.meshlets.data(), data.vertices.data(), data.triangles.data(), indices.data(), indices.size(),
+                            &positions[0].x, positions.size(), sizeof(glm::vec3), options.maxVertices,
+                            options.maxTriangles, options.coneWeight);
+
+  // Trimming to the used part, the triangles of each meshlet start on 4 bytes
+  const meshopt_Meshlet& last = data.meshlets[numMeshlets - 1];
+  data.meshlets.resize(numMeshlets);
+  data.vertices.resize(last.vertex_offset + last.vertex_count);
+  data.triangles.resize(last.triangle_offset + ((last.triangle_count * 3 + 3) & ~3));
+
+  data.bounds.resize(numMeshlets);
+  for(size_t i = 0; i < numMeshlets; i++)
+  {
+    const meshopt_Meshlet& meshlet = data.meshlets[i];
+    const meshopt_Bounds   bounds =
+        meshopt_computeMeshletBounds(&data.vertices[meshlet.vertex_offset], &data.triangles[meshlet.triangle_offset],
+                                     meshlet.triangle_count, &positions[0].x, positions.size(), sizeof(glm::vec3));
+
+    shaderio::GltfMeshletBounds& gpuBounds = data.bounds[i];
+    gpuBounds.center                       = glm::make_vec3(bounds.center);
+    gpuBounds.radius                       = bounds.radius;
+    gpuBounds.coneApex                     = glm::make_vec3(bounds.cone_apex);
+    gpuBounds.coneAxis                     = glm::make_vec3(bounds.cone_axis);
+    gpuBounds.coneCutoff                   = bounds.cone_cutoff;
+    gpuBounds.padding                      = 0.0f;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Creating the meshlets of the triangle primitives, when enabled with setMeshletOptions
+// - The primitives are clustered in parallel, reusing the cached clusters of unchanged geometry
+//
+void nvvkgltf::SceneVk::createMeshletBuffers(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn)
+{
+  if(!m_meshletOptions.enable)
+    return;
+
+  nvutils::ScopedTimer st(__FUNCTION__);
+  assert(m_meshletOptions.maxVertices <= 256 && m_meshletOptions.maxTriangles <= 512 && m_meshletOptions.maxTriangles % 4 == 0);
+
+  const tinygltf::Model&   model         = scn.getModel();
+  const size_t             numPrimitives = scn.getNumRenderPrimitives();
+  std::vector<MeshletData> meshletData(numPrimitives);
+  std::atomic_uint32_t     cachedPrimitives = 0;
+
+  if(!m_meshletOptions.cacheDirectory.empty())
+  {
+    std::error_code ec;
+    std::filesystem::create_directories(m_meshletOptions.cacheDirectory, ec);
+  }
+
+  nvutils::parallel_batches<1>(numPrimitives, [&](uint64_t primID) {
+    const tinygltf::Primitive& primitive = *scn.getRenderPrimitive(primID).pPrimitive;
+    if(primitive.mode != TINYGLTF_MODE_TRIANGLES || !tinygltf::utils::hasElementName(primitive.attributes, "POSITION"))
+      return;
+
+    const tinygltf::Accessor&  posAccessor = model.accessors[primitive.attributes.at("POSITION")];
+    std::vector<glm::vec3>     posStorage;
+    std::span<const glm::vec3> positions = tinygltf::utils::getAccessorData(model, posAccessor, &posStorage);
+
+    std::vector<uint32_t> indices;
+    if(primitive.indices > -1)
+    {
+      tinygltf::utils::copyAccessorData(model, model.accessors[primitive.indices], indices);
+    }
+    else
+    {
+      indices.resize(positions.size());
+      for(size_t i = 0; i < indices.size(); i++)
+        indices[i] = uint32_t(i);
+    }
+    if(indices.empty() || positions.empty())
+      return;
+
+    // The cache is keyed by the geometry and the build options
+    std::filesystem::path cacheFile;
+    if(!m_meshletOptions.cacheDirectory.empty())
+    {
+      const auto bytes = [](auto span) {
+        return std::string_view(reinterpret_cast<const char*>(span.data()), span.size_bytes());
+      };
+      size_t hash = std::hash<std::string_view>{}(bytes(std::span(indices)));
+      hash ^= std::hash<std::string_view>{}(bytes(positions)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      cacheFile = m_meshletOptions.cacheDirectory
+                  / fmt::format("{:016x}_{}_{}_{}.meshlets", hash, m_meshletOptions.maxVertices,
+                                m_meshletOptions.maxTriangles, m_meshletOptions.coneWeight);
+      if(loadMeshletCache(cacheFile, meshletData[primID]))
+      {
+        cachedPrimitives++;
+        return;
+      }
+    }
+
+    buildMeshlets(indices, positions, m_meshletOptions, meshletData[primID]);
+
+    if(!cacheFile.empty())
+      saveMeshletCache(cacheFile, meshletData[primID]);
+  });
+
+  // Uploading the meshlets of each primitive
+  const VkBufferUsageFlags2 usageFlags = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT
+                                         | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT;
+  const auto createBuffer = [&](nvvk::Buffer& buffer, auto data) {
+    NVVK_CHECK(m_alloc->createBuffer(buffer, data.size_bytes(), usageFlags));
+    NVVK_CHECK(staging.appendBuffer(buffer, 0, data));
+    NVVK_DBG_NAME(buffer.buffer);
+    m_memoryTracker.track(kMemCategoryGeometry, buffer.allocation);
+  };
+
+  std::vector<shaderio::GltfMeshletPrimitive> meshletPrims(numPrimitives);
+  m_meshletBuffers.resize(numPrimitives);
+  m_numMeshlets = 0;
+  for(size_t primID = 0; primID < numPrimitives; primID++)
+  {
+    const MeshletData& data = meshletData[primID];
+    if(data.meshlets.empty())
+      continue;
+
+    MeshletBuffers& buffers = m_meshletBuffers[primID];
+    createBuffer(buffers.meshlets, std::span(data.meshlets));
+    createBuffer(buffers.bounds, std::span(data.bounds));
+    createBuffer(buffers.vertices, std::span(data.vertices));
+    createBuffer(buffers.triangles, std::span(data.triangles));
+
+    shaderio::GltfMeshletPrimitive& meshletPrim = meshletPrims[primID];
+    meshletPrim.meshlets                        = (shaderio::GltfMeshlet*)buffers.meshlets.address;
+    meshletPrim.bounds                          = (shaderio::GltfMeshletBounds*)buffers.bounds.address;
+    meshletPrim.vertices                        = (glm::uint*)buffers.vertices.address;
+    meshletPrim.triangles                       = (glm::uint*)buffers.triangles.address;
+    meshletPrim.meshletCount                    = uint32_t(data.meshlets.size());
+    m_numMeshlets += meshletPrim.meshletCount;
+  }
+
+  NVVK_CHECK(m_alloc->createBuffer(m_bMeshletPrim, std::span(meshletPrims).size_bytes(), getBufferUsageFlags()));
+  NVVK_CHECK(staging.appendBuffer(m_bMeshletPrim, 0, std::span(meshletPrims)));
+  NVVK_DBG_NAME(m_bMeshletPrim.buffer);
+  m_memoryTracker.track(kMemCategorySceneData, m_bMeshletPrim.allocation);
+
+  LOGI("%s%u meshlets, %u of %zu primitives from the cache\n", st.indent().c_str(), m_numMeshlets,
+       cachedPrimitives.load(), numPrimitives);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Simplified index levels of the triangle primitives, when enabled with setLodOptions
+// - Each level is simplified from the full detail, with `reduction` times the triangles of the previous one,
+//   and the chain stops once a level no longer removes triangles
+// - The primitives are simplified in parallel, the levels of a previous load are reused from the cache
+// Returns the indices to append after the full detail ones of each primitive, and fills m_primitiveLods
+//
+std::vector<std::vector<uint32_t>> nvvkgltf::SceneVk::generateLodIndices(const nvvkgltf::Scene& scn)
+{
+  const tinygltf::Model&             model         = scn.getModel();
+  const size_t                       numPrimitives = scn.getNumRenderPrimitives();
+  std::vector<std::vector<uint32_t>> lodIndices(numPrimitives);
+
+  // The full detail, the only level without the option
+  m_primitiveLods.resize(numPrimitives);
+  for(size_t primID = 0; primID < numPrimitives; primID++)
+    m_primitiveLods[primID] = {{0, uint32_t(scn.getRenderPrimitive(primID).indexCount), 0.0f, 0}};
+
+  if(!m_lodOptions.enable || m_lodOptions.numLods == 0)
+    return lodIndices;
+
+  nvutils::ScopedTimer st(__FUNCTION__);
+
+  // Levels of a previous load of the same file: the level ranges then the indices, per primitive
+  constexpr uint32_t kLodCacheMagic = 0x53444f4c;  // 'LODS'
+  std::filesystem::path cacheFile;
+  uint64_t              cacheKey = 0;
+  if(!m_cacheDirectory.empty())
+  {
+    uint64_t options = cache::combineKey(m_lodOptions.numLods, std::bit_cast<uint32_t>(m_lodOptions.reduction));
+    options          = cache::combineKey(options, std::bit_cast<uint32_t>(m_lodOptions.targetError));
+    cacheKey         = cache::getFileKey(scn.getFilename(), cache::combineKey(options, numPrimitives));
+  }
+  if(cacheKey != 0)
+  {
+    cacheFile = m_cacheDirectory / fmt::format("{}_{:016x}.lods", nvutils::utf8FromPath(scn.getFilename().stem()), cacheKey);
+
+    cache::Reader reader;
+    if(reader.open(cacheFile, kLodCacheMagic, cacheKey) && reader.getNumChunks() == 2 * numPrimitives)
+    {
+      bool valid = true;
+      for(size_t primID = 0; primID < numPrimitives && valid; primID++)
+      {
+        std::span<const char> lods    = reader.getChunk(2 * primID);
+        std::span<const char> indices = reader.getChunk(2 * primID + 1);
+        valid = !lods.empty() && lods.size() % sizeof(shaderio::GltfPrimitiveLod) == 0
+                && lods.size() <= GLTF_MAX_LODS * sizeof(shaderio::GltfPrimitiveLod) && indices.size() % sizeof(uint32_t) == 0;
+        if(!valid)
+          break;
+        m_primitiveLods[primID].resize(lods.size() / sizeof(shaderio::GltfPrimitiveLod));
+        memcpy(m_primitiveLods[primID].data(), lods.data(), lods.size());
+        lodIndices[primID].resize(indices.size() / sizeof(uint32_t));
+        memcpy(lodIndices[primID].data(), indices.data(), indices.size());
+        valid = m_primitiveLods[primID][0].indexCount == uint32_t(scn.getRenderPrimitive(primID).indexCount);
+      }
+      if(valid)
+      {
+        LOGI("%sLODs of %zu primitives from the cache\n", st.indent().c_str(), numPrimitives);
+        return lodIndices;
+      }
+      // Stale blob: start over
+      for(size_t primID = 0; primID < numPrimitives; primID++)
+      {
+        m_primitiveLods[primID].resize(1);
+        m_primitiveLods[primID][0] = {0, uint32_t(scn.getRenderPrimitive(primID).indexCount), 0.0f, 0};
+        lodIndices[primID].clear();
+      }
+    }
+  }
+
+  const uint32_t       numLods      = std::min(m_lodOptions.numLods, uint32_t(GLTF_MAX_LODS - 1));
+  std::atomic_uint32_t numLodLevels = 0;
+  nvutils::parallel_batches<1>(numPrimitives, [&](uint64_t primID) {
+    const tinygltf::Primitive& primitive = *scn.getRenderPrimitive(primID).pPrimitive;
+    if(primitive.mode != TINYGLTF_MODE_TRIANGLES || !tinygltf::utils::hasElementName(primitive.attributes, "POSITION"))
+      return;
+
+    const tinygltf::Accessor&  posAccessor = model.accessors[primitive.attributes.at("POSITION")];
+    std::vector<glm::vec3>     posStorage;
+    std::span<const glm::vec3> positions = tinygltf::utils::getAccessorData(model, posAccessor, &posStorage);
+
+    std::vector<uint32_t> indices;
+    if(primitive.indices > -1)
+    {
+      tinygltf::utils::copyAccessorData(model, model.accessors[primitive.indices], indices);
+    }
+    else
+    {
+      indices.resize(positions.size());
+      for(size_t i = 0; i < indices.size(); i++)
+        indices[i] = uint32_t(i);
+    }
+    if(indices.size() < 3 || positions.empty())
+      return;
+
+    // meshopt_simplify errors are relative to the extent of the mesh
+    const float errorScale = meshopt_simplifyScale(&positions[0].x, positions.size(), sizeof(glm::vec3));
+
+    std::vector<shaderio::GltfPrimitiveLod>& lods       = m_primitiveLods[primID];
+    std::vector<uint32_t>&                   outIndices = lodIndices[primID];
+    std::vector<uint32_t>                    lod(indices.size());
+    double                                   target = double(indices.size());
+    for(uint32_t level = 1; level <= numLods; level++)
+    {
+      target *= m_lodOptions.reduction;
+      const size_t targetIndices = size_t(target) / 3 * 3;
+      if(targetIndices < 3)
+        break;
+
+      float resultError = 0.0f;
+      lod.resize(indices.size());
+      lod.resize(meshopt_simplify(lod.data(), indices.data(), indices.size(), &positions[0].x, positions.size(),
+                                  sizeof(glm::vec3), targetIndices, m_lodOptions.targetError, 0, &resultError));
+      // Stop once the topology or the error bound prevent further simplification
+      if(lod.empty() || lod.size() * 10 > size_t(lods.back().indexCount) * 9)
+        break;
+      meshopt_optimizeVertexCache(lod.data(), lod.data(), lod.size(), positions.size());
+
+      lods.push_back({uint32_t(indices.size() + outIndices.size()), uint32_t(lod.size()), resultError * errorScale, 0});
+      outIndices.insert(outIndices.end(), lod.begin(), lod.end());
+      numLodLevels++;
+    }
+  });
+
+  if(!cacheFile.empty())
+  {
+    std::vector<std::span<const char>> chunks;
+    for(size_t primID = 0; primID < numPrimitives; primID++)
+    {
+      const std::vector<shaderio::GltfPrimitiveLod>& lods = m_primitiveLods[primID];
+      chunks.push_back({reinterpret_cast<const char*>(lods.data()), std::span(lods).size_bytes()});
+      chunks.push_back({reinterpret_cast<const char*>(lodIndices[primID].data()), std::span(lodIndices[primID]).size_bytes()});
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(m_cacheDirectory, ec);
+    cache::save(cacheFile, kLodCacheMagic, cacheKey, chunks);
+  }
+
+  LOGI("%s%u LODs for %zu primitives\n", st.indent().c_str(), numLodLevels.load(), numPrimitives);
+  return lodIndices;
+}
+
+uint32_t nvvkgltf::SceneVk::selectLod(std::span<const shaderio::GltfPrimitiveLod> lods,
+                                      float                                       worldScale,
+                                      float                                       distance,
+                                      float                                       pixelsPerUnit,
+                                      float                                       maxPixelError)
+{
+  if(pixelsPerUnit <= 0.0f || worldScale <= 0.0f)
+    return 0;
+
+  // error * worldScale * pixelsPerUnit / distance <= maxPixelError
+  const float maxError = maxPixelError * std::max(distance, 0.0f) / (pixelsPerUnit * worldScale);
+  uint32_t    lod      = 0;
+  while(lod + 1 < lods.size() && lods[lod + 1].error <= maxError)
+    lod++;
+  return lod;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Shader view of the vertex buffers of a primitive, with the full precision or the packed streams
+static shaderio::VertexBuffers getShaderVertexBuffers(const nvvkgltf::SceneVk::VertexBuffers& vertexBuffers)
+{
+  shaderio::VertexBuffers vBuf = {};
+  vBuf.positions               = (glm::vec3*)vertexBuffers.position.address;
+  vBuf.normals                 = (glm::vec3*)vertexBuffers.normal.address;
+  vBuf.tangents                = (glm::vec4*)vertexBuffers.tangent.address;
+  vBuf.texCoords0              = (glm::vec2*)vertexBuffers.texCoord0.address;
+  vBuf.texCoords1              = (glm::vec2*)vertexBuffers.texCoord1.address;
+  vBuf.colors                  = (glm::uint*)vertexBuffers.color.address;
+  vBuf.packedPositions         = (glm::uvec2*)vertexBuffers.packedPosition.address;
+  vBuf.packedNormals           = (glm::uint*)vertexBuffers.packedNormal.address;
+  vBuf.packedTangents          = (glm::uint*)vertexBuffers.packedTangent.address;
+  vBuf.packedTexCoords0        = (glm::uint*)vertexBuffers.packedTexCoord0.address;
+  vBuf.packedTexCoords1        = (glm::uint*)vertexBuffers.packedTexCoord1.address;
+  vBuf.positionMin             = vertexBuffers.positionMin;
+  vBuf.positionExtent          = vertexBuffers.positionExtent;
+  return vBuf;
+}
+
+// Octahedral encoding of a unit vector, same as compressUnitVec in nvshaders/normal_compress.h.slang
+static uint32_t packOctahedral(const glm::vec3& nv)
+{
+  const float sum = std::abs(nv.x) + std::abs(nv.y) + std::abs(nv.z);
+  if(sum == 0.0f || !std::isfinite(sum))
+    return (32767u << 16) | 32767u;  // +Z
+
+  const float d = 32767.0f / sum;
+  int         x = int(std::round(nv.x * d));
+  int         y = int(std::round(nv.y * d));
+
+  // Negative Z hemisphere, reflected across the octahedron edges
+  if(nv.z < 0.0f)
+  {
+    const int maskx = x >> 31;
+    const int masky = y >> 31;
+    const int tmp   = 32767 + maskx + masky;
+    const int tmpx  = x;
+    x               = (tmp - (y ^ masky)) ^ maskx;
+    y               = (tmp - (tmpx ^ maskx)) ^ masky;
+  }
+
+  const uint32_t packed = (uint32_t(y + 32767) << 16) | uint32_t(x + 32767);
+  return packed == ~0u ? ~0x1u : packed;
+}
+
+template <typename T>
+static std::span<const T> getAttributeData(const tinygltf::Model&     model,
+                                           const tinygltf::Primitive& primitive,
+                                           const std::string&         attributeName,
+                                           std::vector<T>&            storage)
+{
+  const auto& findResult = primitive.attributes.find(attributeName);
+  if(findResult == primitive.attributes.end())
+    return {};
+  return tinygltf::utils::getAccessorData(model, model.accessors[findResult->second], &storage);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Creates the buffer of a vertex stream, or updates its content when it exists
+// Returns true when the buffer was created
+template <typename T>
+bool nvvkgltf::SceneVk::uploadVertexStream(nvvk::StagingUploader& staging, std::span<const T> data, nvvk::Buffer& buffer)
+{
+  if(data.empty())
+    return false;
+
+  if(buffer.buffer == VK_NULL_HANDLE)
+  {
+    NVVK_CHECK(m_alloc->createBuffer(buffer, data.size_bytes(), getBufferUsageFlags() | VK_BUFFER_USAGE_2_VERTEX_BUFFER_BIT));
+    NVVK_CHECK(staging.appendBuffer(buffer, 0, data));
+    NVVK_DBG_NAME(buffer.buffer);
+    m_memoryTracker.track(kMemCategoryGeometry, buffer.allocation);
+    return true;
+  }
+  staging.appendBuffer(buffer, 0, data);
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Packed vertex streams of a static primitive (see setVertexPacking)
+// - positions: 16-bit unorm in the bounds of the primitive, 8 bytes instead of 12
+// - normals and tangents: octahedral in 32 bits, instead of 12 and 16 bytes
+// - texture coordinates: half2, instead of 8 bytes
+// Returns true when a buffer was created
+bool nvvkgltf::SceneVk::updatePackedVertexBuffers(VkCommandBuffer            cmd,
+                                                  nvvk::StagingUploader&     staging,
+                                                  const tinygltf::Model&     model,
+                                                  const tinygltf::Primitive& primitive,
+                                                  VertexBuffers&             vertexBuffers)
+{
+  bool     newBuffer  = false;
+  uint64_t savedBytes = 0;
+
+  // The acceleration structures are built from the fp32 positions
+  if(m_rayTracingEnabled)
+  {
+    newBuffer |= updateAttributeBuffer<glm::vec3>(cmd, "POSITION", model, primitive, m_alloc, &staging, vertexBuffers.position);
+  }
+  else
+  {
+    std::vector<glm::vec3>     storage;
+    std::span<const glm::vec3> positions = getAttributeData(model, primitive, "POSITION", storage);
+    if(!positions.empty())
+    {
+      glm::vec3 posMin(std::numeric_limits<float>::max());
+      glm::vec3 posMax(-std::numeric_limits<float>::max());
+      for(const glm::vec3& pos : positions)
+      {
+        posMin = glm::min(posMin, pos);
+        posMax = glm::max(posMax, pos);
+      }
+      vertexBuffers.positionMin    = posMin;
+      vertexBuffers.positionExtent = posMax - posMin;
+      const glm::vec3 invExtent    = glm::mix(1.0f / vertexBuffers.positionExtent, glm::vec3(0.0f),
+                                              glm::equal(vertexBuffers.positionExtent, glm::vec3(0.0f)));
+
+      std::vector<glm::uvec2> packed(positions.size());
+      nvutils::parallel_batches_auto(positions.size(), [&](uint64_t i) {
+        const glm::uvec3 q(glm::round(glm::clamp((positions[i] - posMin) * invExtent, 0.0f, 1.0f) * 65535.0f));
+        packed[i] = {q.x | (q.y << 16), q.z};
+      });
+      if(uploadVertexStream(staging, std::span<const glm::uvec2>(packed), vertexBuffers.packedPosition))
+      {
+        newBuffer = true;
+        savedBytes += positions.size_bytes() - std::span(packed).size_bytes();
+      }
+    }
+  }
+
+  const auto packStream = [&](auto attributeData, nvvk::Buffer& buffer, auto packFunc) {
+    if(attributeData.empty())
+      return;
+    std::vector<uint32_t> packed(attributeData.size());
+    nvutils::parallel_batches_auto(attributeData.size(), [&](uint64_t i) { packed[i] = packFunc(attributeData[i]); });
+    if(uploadVertexStream(staging, std::span<const uint32_t>(packed), buffer))
+    {
+      newBuffer = true;
+      savedBytes += attributeData.size_bytes() - std::span(packed).size_bytes();
+    }
+  };
+
+  std::vector<glm::vec3> normalStorage;
+  std::vector<glm::vec4> tangentStorage;
+  std::vector<glm::vec2> uv0Storage;
+  std::vector<glm::vec2> uv1Storage;
+  packStream(getAttributeData(model, primitive, "NORMAL", normalStorage), vertexBuffers.packedNormal,
+             [](const glm::vec3& n) { return packOctahedral(n); });
+  packStream(getAttributeData(model, primitive, "TANGENT", tangentStorage), vertexBuffers.packedTangent,
+             [](const glm::vec4& t) { return (packOctahedral(glm::vec3(t)) & ~1u) | (t.w < 0.0f ? 1u : 0u); });
+  packStream(getAttributeData(model, primitive, "TEXCOORD_0", uv0Storage), vertexBuffers.packedTexCoord0,
+             [](const glm::vec2& uv) { return glm::packHalf2x16(uv); });
+  packStream(getAttributeData(model, primitive, "TEXCOORD_1", uv1Storage), vertexBuffers.packedTexCoord1,
+             [](const glm::vec2& uv) { return glm::packHalf2x16(uv); });
+
+  m_packedSavedBytes += savedBytes;
+  m_memoryTracker.trackSaved(kMemCategoryGeometry, savedBytes);
+  return newBuffer;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Returns the common usage flags used for all buffers.
+//--------------------------------------------------------------------------------------------------
 VkBufferUsageFlags2 nvvkgltf::SceneVk::getBufferUsageFlags() const
 {
   VkBufferUsageFlags2 bufferUsageFlag =
@@ -595,20 +1358,38 @@ void nvvkgltf::SceneVk::createVertexBuffers(VkCommandBuffer cmd, nvvk::StagingUp
 
   size_t numUniquePrimitive = scn.getNumRenderPrimitives();
   m_bIndices.resize(numUniquePrimitive);
+  std::vector<std::vector<uint32_t>> lodIndices = generateLodIndices(scn);
   m_vertexBuffers.resize(numUniquePrimitive);
   renderPrim.resize(numUniquePrimitive);
 
+  // Morphed and skinned primitives are rewritten in fp32 by the animation, they are not packed
+  std::vector<bool> animatedPrims(numUniquePrimitive, false);
+  for(const nvvkgltf::RenderNode& renderNode : scn.getRenderNodes())
+  {
+    if(renderNode.skinID > -1)
+      animatedPrims[renderNode.renderPrimID] = true;
+  }
+  m_packedPrimitives.assign(numUniquePrimitive, false);
+
   for(size_t primID = 0; primID < scn.getNumRenderPrimitives(); primID++)
   {
     const tinygltf::Primitive& primitive     = *scn.getRenderPrimitive(primID).pPrimitive;
     const tinygltf::Mesh&      mesh          = model.meshes[scn.getRenderPrimitive(primID).meshID];
     VertexBuffers&             vertexBuffers = m_vertexBuffers[primID];
 
-    updateAttributeBuffer<glm::vec3>(cmd, "POSITION", model, primitive, m_alloc, &staging, vertexBuffers.position);
-    updateAttributeBuffer<glm::vec3>(cmd, "NORMAL", model, primitive, m_alloc, &staging, vertexBuffers.normal);
-    updateAttributeBuffer<glm::vec2>(cmd, "TEXCOORD_0", model, primitive, m_alloc, &staging, vertexBuffers.texCoord0);
-    updateAttributeBuffer<glm::vec2>(cmd, "TEXCOORD_1", model, primitive, m_alloc, &staging, vertexBuffers.texCoord1);
-    updateAttributeBuffer<glm::vec4>(cmd, "TANGENT", model, primitive, m_alloc, &staging, vertexBuffers.tangent);
+    if(m_vertexPacking && primitive.targets.empty() && !animatedPrims[primID])
+    {
+      m_packedPrimitives[primID] = true;
+      updatePackedVertexBuffers(cmd, staging, model, primitive, vertexBuffers);
+    }
+    else
+    {
+      updateAttributeBuffer<glm::vec3>(cmd, "POSITION", model, primitive, m_alloc, &staging, vertexBuffers.position);
+      updateAttributeBuffer<glm::vec3>(cmd, "NORMAL", model, primitive, m_alloc, &staging, vertexBuffers.normal);
+      updateAttributeBuffer<glm::vec2>(cmd, "TEXCOORD_0", model, primitive, m_alloc, &staging, vertexBuffers.texCoord0);
+      updateAttributeBuffer<glm::vec2>(cmd, "TEXCOORD_1", model, primitive, m_alloc, &staging, vertexBuffers.texCoord1);
+      updateAttributeBuffer<glm::vec4>(cmd, "TANGENT", model, primitive, m_alloc, &staging, vertexBuffers.tangent);
+    }
 
     if(tinygltf::utils::hasElementName(primitive.attributes, "COLOR_0"))
     {
@@ -675,6 +1456,8 @@ void nvvkgltf::SceneVk::createVertexBuffers(VkCommandBuffer cmd, nvvk::StagingUp
       for(auto i = 0; i < accessor.count; i++)
         indexBuffer[i] = i;
     }
+    // The simplified levels follow the full detail, see getLods
+    indexBuffer.insert(indexBuffer.end(), lodIndices[primID].begin(), lodIndices[primID].end());
 
     // Creating the buffer for the indices
     nvvk::Buffer& i_buffer = m_bIndices[primID];
@@ -687,15 +1470,7 @@ void nvvkgltf::SceneVk::createVertexBuffers(VkCommandBuffer cmd, nvvk::StagingUp
     // Filling the primitive information
     renderPrim[primID].indices = (glm::uvec3*)i_buffer.address;
 
-    shaderio::VertexBuffers vBuf = {};
-    vBuf.positions               = (glm::vec3*)vertexBuffers.position.address;
-    vBuf.normals                 = (glm::vec3*)vertexBuffers.normal.address;
-    vBuf.tangents                = (glm::vec4*)vertexBuffers.tangent.address;
-    vBuf.texCoords0              = (glm::vec2*)vertexBuffers.texCoord0.address;
-    vBuf.texCoords1              = (glm::vec2*)vertexBuffers.texCoord1.address;
-    vBuf.colors                  = (glm::uint*)vertexBuffers.color.address;
-
-    renderPrim[primID].vertexBuffer = vBuf;
+    renderPrim[primID].vertexBuffer = getShaderVertexBuffers(vertexBuffers);
   }
 
   // Creating the buffer of all primitive information
@@ -726,23 +1501,25 @@ void nvvkgltf::SceneVk::updateVertexBuffers(VkCommandBuffer cmd, nvvk::StagingUp
     const tinygltf::Primitive& primitive     = *scene.getRenderPrimitive(primID).pPrimitive;
     VertexBuffers&             vertexBuffers = m_vertexBuffers[primID];
     bool                       newBuffer     = false;
-    updateAttributeBuffer<glm::vec3>(cmd, "POSITION", model, primitive, m_alloc, &staging, vertexBuffers.position);
-    newBuffer |= updateAttributeBuffer<glm::vec3>(cmd, "NORMAL", model, primitive, m_alloc, &staging, vertexBuffers.normal);
-    newBuffer |= updateAttributeBuffer<glm::vec2>(cmd, "TEXCOORD_0", model, primitive, m_alloc, &staging, vertexBuffers.texCoord0);
-    newBuffer |= updateAttributeBuffer<glm::vec2>(cmd, "TEXCOORD_1", model, primitive, m_alloc, &staging, vertexBuffers.texCoord1);
-    newBuffer |= updateAttributeBuffer<glm::vec4>(cmd, "TANGENT", model, primitive, m_alloc, &staging, vertexBuffers.tangent);
+    if(m_packedPrimitives[primID])
+    {
+      newBuffer = updatePackedVertexBuffers(cmd, staging, model, primitive, vertexBuffers);
+    }
+    else
+    {
+      updateAttributeBuffer<glm::vec3>(cmd, "POSITION", model, primitive, m_alloc, &staging, vertexBuffers.position);
+      newBuffer |= updateAttributeBuffer<glm::vec3>(cmd, "NORMAL", model, primitive, m_alloc, &staging, vertexBuffers.normal);
+      newBuffer |= updateAttributeBuffer<glm::vec2>(cmd, "TEXCOORD_0", model, primitive, m_alloc, &staging, vertexBuffers.texCoord0);
+      newBuffer |= updateAttributeBuffer<glm::vec2>(cmd, "TEXCOORD_1", model, primitive, m_alloc, &staging, vertexBuffers.texCoord1);
+      newBuffer |= updateAttributeBuffer<glm::vec4>(cmd, "TANGENT", model, primitive, m_alloc, &staging, vertexBuffers.tangent);
+    }
 
     // A buffer was created (most likely tangent buffer), we need to update the RenderPrimitive buffer
     if(newBuffer)
     {
       shaderio::GltfRenderPrimitive renderPrim{};  // The array of all primitive information
-      renderPrim.indices                 = (glm::uvec3*)m_bIndices[primID].address;
-      renderPrim.vertexBuffer.positions  = (glm::vec3*)vertexBuffers.position.address;
-      renderPrim.vertexBuffer.normals    = (glm::vec3*)vertexBuffers.normal.address;
-      renderPrim.vertexBuffer.tangents   = (glm::vec4*)vertexBuffers.tangent.address;
-      renderPrim.vertexBuffer.texCoords0 = (glm::vec2*)vertexBuffers.texCoord0.address;
-      renderPrim.vertexBuffer.texCoords1 = (glm::vec2*)vertexBuffers.texCoord1.address;
-      renderPrim.vertexBuffer.colors     = (glm::uint*)vertexBuffers.color.address;
+      renderPrim.indices      = (glm::uvec3*)m_bIndices[primID].address;
+      renderPrim.vertexBuffer = getShaderVertexBuffers(vertexBuffers);
       staging.appendBuffer(m_bRenderPrim, sizeof(shaderio::GltfRenderPrimitive) * primID, std::span(&renderPrim, 1));
     }
   }
@@ -810,6 +1587,7 @@ void nvvkgltf::SceneVk::createTextureImages(VkCommandBuffer              cmd,
 
   // Find and all textures/images that should be sRgb encoded.
   findSrgbImages(model);
+  findNormalImages(model);
 
   // Make dummy image(1,1), needed as we cannot have an empty array
   auto addDefaultImage = [&](uint32_t idx, const std::array<uint8_t, 4>& color) {
@@ -844,29 +1622,70 @@ void nvvkgltf::SceneVk::createTextureImages(VkCommandBuffer              cmd,
     usedImages.insert(source_image);
   }
 
-  // Load images in parallel
   m_images.resize(model.images.size());
-  uint32_t          num_threads = std::min((uint32_t)model.images.size(), std::thread::hardware_concurrency());
-  const std::string indent      = st.indent();
-  nvutils::parallel_batches<1>(  // Not batching
-      model.images.size(),
-      [&](uint64_t i) {
-        if(usedImages.find(static_cast<int>(i)) == usedImages.end())
-          return;  // Skip unused images
-        const auto& image     = model.images[i];
-        const char* imageName = image.uri.empty() ? "Embedded image" : image.uri.c_str();
-        LOGI("%s(%" PRIu64 ") %s \n", indent.c_str(), i, imageName);
-        loadImage(basedir, image, static_cast<int>(i));
-      },
-      num_threads);
-
-  // Create Vulkan images
-  for(size_t i = 0; i < m_images.size(); i++)
+  if(m_streamingOptions.enable)
+  {
+    // Placeholders, replaced by updateTextureStreaming once the images are decoded in the background
+    std::vector<int> streamedImages;
+    m_streamedImages.assign(m_images.size(), {});
+    for(size_t i = 0; i < m_images.size(); i++)
+    {
+      addDefaultImage((uint32_t)i, {128, 128, 128, 255});
+      if(usedImages.find(static_cast<int>(i)) == usedImages.end())
+        m_streamedImages[i] = {.loaded = true, .residentLevel = 0};  // Nothing to stream
+      else
+        streamedImages.push_back(static_cast<int>(i));
+    }
+    startTextureStreaming(model, basedir, std::move(streamedImages));
+  }
+  else
   {
-    if(!createImage(cmd, staging, m_images[i]))
+    // Load images in parallel on a decoding thread, while this thread creates the Vulkan images of the ones
+    // already decoded: file reads, transcoding and staging copies overlap
+    uint32_t                num_threads = std::min((uint32_t)model.images.size(), std::thread::hardware_concurrency());
+    const std::string       indent      = st.indent();
+    std::mutex              readyMutex;
+    std::condition_variable readyCondition;
+    std::vector<int>        readyImages;
+    std::thread             decoder([&]() {
+      nvutils::parallel_batches_pooled<1>(  // Not batching
+          model.images.size(),
+          [&](uint64_t i, uint32_t) {
+            if(usedImages.find(static_cast<int>(i)) != usedImages.end())  // Skip unused images
+            {
+              const auto& image     = model.images[i];
+              const char* imageName = image.uri.empty() ? "Embedded image" : image.uri.c_str();
+              LOGI("%s(%" PRIu64 ") %s \n", indent.c_str(), i, imageName);
+              loadImage(basedir, image, static_cast<int>(i));
+            }
+            {
+              std::lock_guard<std::mutex> lock(readyMutex);
+              readyImages.push_back(static_cast<int>(i));
+            }
+            readyCondition.notify_one();
+          },
+          num_threads);
+    });
+
+    // Create Vulkan images
+    for(size_t created = 0; created < m_images.size();)
     {
-      addDefaultImage((uint32_t)i, {255, 0, 255, 255});  // Image not present or incorrectly loaded (image.empty)
+      std::vector<int> batch;
+      {
+        std::unique_lock<std::mutex> lock(readyMutex);
+        readyCondition.wait(lock, [&]() { return !readyImages.empty(); });
+        batch.swap(readyImages);
+      }
+      for(int i : batch)
+      {
+        if(!createImage(cmd, staging, m_images[i]))
+        {
+          addDefaultImage((uint32_t)i, {255, 0, 255, 255});  // Image not present or incorrectly loaded (image.empty)
+        }
+        created++;
+      }
     }
+    decoder.join();
   }
 
   // Add default image if nothing was loaded
@@ -886,6 +1705,7 @@ void nvvkgltf::SceneVk::createTextureImages(VkCommandBuffer              cmd,
     if(source_image >= model.images.size() || source_image < 0)
     {
       addDefaultTexture();  // Incorrect source image
+      m_textureImages.push_back(-1);
       continue;
     }
 
@@ -897,6 +1717,7 @@ void nvvkgltf::SceneVk::createTextureImages(VkCommandBuffer              cmd,
     NVVK_CHECK(m_samplerPool->acquireSampler(tex.descriptor.sampler, sampler));
     NVVK_DBG_NAME(tex.descriptor.sampler);
     m_textures.push_back(tex);
+    m_textureImages.push_back(source_image);
   }
 
   // Add a default texture, cannot work with empty descriptor set
@@ -961,9 +1782,70 @@ void nvvkgltf::SceneVk::findSrgbImages(const tinygltf::Model& model)
   }
 }
 
+// Images sampled as normal maps, which are compressed to BC5 instead of BC7
+void nvvkgltf::SceneVk::findNormalImages(const tinygltf::Model& model)
+{
+  auto addImage = [&](int texID) {
+    if(texID > -1)
+      m_normalImages.insert(tinygltf::utils::getTextureImageIndex(model.textures[texID]));
+  };
+
+  for(const tinygltf::Material& mat : model.materials)
+  {
+    addImage(mat.normalTexture.index);
+
+    // https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Khronos/KHR_materials_clearcoat
+    const auto& ext = mat.extensions.find("KHR_materials_clearcoat");
+    if(ext != mat.extensions.end() && ext->second.Has("clearcoatNormalTexture"))
+    {
+      const tinygltf::Value& info = ext->second.Get("clearcoatNormalTexture");
+      if(info.Has("index"))
+        addImage(info.Get("index").Get<int>());
+    }
+  }
+}
+
 //--------------------------------------------------------------------------------------------------
 // Loading images from disk
 //
+//--------------------------------------------------------------------------------------------------
+// Decoded images, see setCacheDirectory: the description then one chunk per mip
+constexpr uint32_t kImageCacheMagic = 0x47414d49;  // 'IMAG'
+
+struct ImageCacheInfo
+{
+  VkFormat   format{};
+  VkExtent2D size{};
+};
+
+static bool loadImageCache(const std::filesystem::path& filename, uint64_t key, VkFormat& format, VkExtent2D& size, std::vector<std::vector<char>>& mipData)
+{
+  nvvkgltf::cache::Reader reader;
+  if(!reader.open(filename, kImageCacheMagic, key) || reader.getNumChunks() < 2 || reader.getChunk(0).size() != sizeof(ImageCacheInfo))
+    return false;
+
+  ImageCacheInfo info;
+  memcpy(&info, reader.getChunk(0).data(), sizeof(info));
+  format = info.format;
+  size   = info.size;
+  mipData.resize(reader.getNumChunks() - 1);
+  for(size_t mip = 0; mip < mipData.size(); mip++)
+  {
+    std::span<const char> chunk = reader.getChunk(mip + 1);
+    mipData[mip].assign(chunk.begin(), chunk.end());
+  }
+  return true;
+}
+
+static void saveImageCache(const std::filesystem::path& filename, uint64_t key, VkFormat format, VkExtent2D size, const std::vector<std::vector<char>>& mipData)
+{
+  const ImageCacheInfo               info{format, size};
+  std::vector<std::span<const char>> chunks{{reinterpret_cast<const char*>(&info), sizeof(info)}};
+  for(const std::vector<char>& mip : mipData)
+    chunks.push_back(mip);
+  nvvkgltf::cache::save(filename, kImageCacheMagic, key, chunks);
+}
+
 void nvvkgltf::SceneVk::loadImage(const std::filesystem::path& basedir, const tinygltf::Image& gltfImage, int imageID)
 {
   namespace fs = std::filesystem;
@@ -976,12 +1858,49 @@ void nvvkgltf::SceneVk::loadImage(const std::filesystem::path& basedir, const ti
   const fs::path uri = basedir / nvutils::pathFromUtf8(uriDecoded);
   image.imgName      = nvutils::utf8FromPath(uri.filename());
 
+  // Decoded and transcoded files of a previous load, DDS files are already in their GPU format
+  fs::path cacheFile;
+  uint64_t cacheKey = 0;
+  if(!m_cacheDirectory.empty() && !gltfImage.uri.empty() && !nvutils::extensionMatches(uri, ".dds"))
+    cacheKey = cache::getFileKey(uri, cache::combineKey(cache::combineKey(isSrgb ? 1 : 0, m_supportsAstc ? 1 : 0),
+                                                        m_textureCompression && m_supportsBc ? 1 : 0));
+  if(cacheKey != 0)
+  {
+    cacheFile = m_cacheDirectory / fmt::format("{}_{:016x}.image", image.imgName, cacheKey);
+    if(loadImageCache(cacheFile, cacheKey, image.format, image.size, image.mipData))
+    {
+      image.srgb = isSrgb;
+      return;
+    }
+  }
+
+  // DDS and KTX2 payloads stored as-is are uploaded straight from the mapped file. Not with streaming,
+  // which keeps the mips of the images and downsamples them.
+  std::shared_ptr<nvutils::FileReadMapping> mapping;
+  auto                                      mapFile = [&]() -> bool {
+    if(m_streamingOptions.enable)
+      return false;
+    mapping = std::make_shared<nvutils::FileReadMapping>();
+    if(mapping->open(uri))
+      return true;
+    mapping.reset();
+    return false;
+  };
+
   if(nvutils::extensionMatches(uri, ".dds"))
   {
-    nv_dds::Image               ddsImage{};
-    nv_dds::ReadSettings        settings{};
-    std::ifstream               imageFile(uri, std::ios::binary);
-    const nv_dds::ErrorWithText readResult = ddsImage.readFromStream(imageFile, settings);
+    nv_dds::Image         ddsImage{};
+    nv_dds::ReadSettings  settings{};
+    nv_dds::ErrorWithText readResult;
+    if(mapFile())
+    {
+      readResult = ddsImage.readFromMappedMemory(static_cast<const char*>(mapping->data()), mapping->size(), settings);
+    }
+    else
+    {
+      std::ifstream imageFile(uri, std::ios::binary);
+      readResult = ddsImage.readFromStream(imageFile, settings);
+    }
     if(readResult.has_value())
     {
       LOGW("Failed to read %s using nv_dds: %s\n", nvutils::utf8FromPath(uri).c_str(), readResult.value().c_str());
@@ -1016,18 +1935,38 @@ void nvvkgltf::SceneVk::loadImage(const std::filesystem::path& basedir, const ti
     }
 
     // Add all mip-levels. We don't need the ddsImage after this so we can move instead of copy.
+    bool zeroCopy = mapping != nullptr;
+    for(uint32_t i = 0; i < ddsImage.getNumMips(); i++)
+      zeroCopy = zeroCopy && !ddsImage.subresource(i, 0, 0).mapped.empty();  // Bitmasked data is decoded
     for(uint32_t i = 0; i < ddsImage.getNumMips(); i++)
     {
-      std::vector<char>& mip = ddsImage.subresource(i, 0, 0).data;
-      image.mipData.push_back(std::move(mip));
+      if(zeroCopy)
+        image.mipViews.push_back(ddsImage.subresource(i, 0, 0).mapped);
+      else
+        image.mipData.push_back(std::move(ddsImage.subresource(i, 0, 0).data));
     }
+    if(zeroCopy)
+      image.mapping = std::move(mapping);
   }
   else if(nvutils::extensionMatches(uri, ".ktx") || nvutils::extensionMatches(uri, ".ktx2"))
   {
-    nv_ktx::KTXImage            ktxImage;
-    const nv_ktx::ReadSettings  ktxReadSettings;
-    std::ifstream               imageFile(uri, std::ios::binary);
-    const nv_ktx::ErrorWithText maybeError = ktxImage.readFromStream(imageFile, ktxReadSettings);
+    nv_ktx::KTXImage     ktxImage;
+    nv_ktx::ReadSettings ktxReadSettings;
+    // Basis Universal targets: ASTC when sampled by the device, else BC7 (UASTC is lossless to ASTC)
+    ktxReadSettings.device_supports_astc = m_supportsAstc;
+    ktxReadSettings.parallel_for         = [](size_t numJobs, const std::function<void(size_t)>& job) {
+      nvutils::parallel_batches<1>(numJobs, [&](uint64_t i) { job(size_t(i)); });
+    };
+    nv_ktx::ErrorWithText maybeError;
+    if(mapFile())
+    {
+      maybeError = ktxImage.readFromMappedMemory(static_cast<const char*>(mapping->data()), mapping->size(), ktxReadSettings);
+    }
+    else
+    {
+      std::ifstream imageFile(uri, std::ios::binary);
+      maybeError = ktxImage.readFromStream(imageFile, ktxReadSettings);
+    }
     if(maybeError.has_value())
     {
       LOGW("Failed to read %s using nv_ktx: %s\n", nvutils::utf8FromPath(uri).c_str(), maybeError->c_str());
@@ -1055,11 +1994,18 @@ void nvvkgltf::SceneVk::loadImage(const std::filesystem::path& basedir, const ti
     image.format = texture_formats::tryForceVkFormatTransferFunction(ktxImage.format, image.srgb);
 
     // Add all mip-levels. We don't need the ktxImage after this so we can move instead of copy.
+    bool zeroCopy = mapping != nullptr;
+    for(uint32_t i = 0; i < ktxImage.num_mips; i++)
+      zeroCopy = zeroCopy && ktxImage.subresource(i, 0, 0).empty();  // Supercompressed, transcoded and KTX1 data is copied
     for(uint32_t i = 0; i < ktxImage.num_mips; i++)
     {
-      std::vector<char>& mip = ktxImage.subresource(i, 0, 0);
-      image.mipData.push_back(std::move(mip));
+      if(zeroCopy)
+        image.mipViews.push_back(ktxImage.subresourceView(i, 0, 0));
+      else
+        image.mipData.push_back(std::move(ktxImage.subresource(i, 0, 0)));
     }
+    if(zeroCopy)
+      image.mapping = std::move(mapping);
   }
   else if(uri.has_extension())
   {
@@ -1134,6 +2080,16 @@ void nvvkgltf::SceneVk::loadImage(const std::filesystem::path& basedir, const ti
     image.format = isSrgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
     image.mipData.emplace_back(gltfImage.image.data(), gltfImage.image.data() + gltfImage.image.size());
   }
+
+  if(m_textureCompression && m_supportsBc)
+    compressImage(image, !isSrgb && m_normalImages.find(imageID) != m_normalImages.end());
+
+  if(!cacheFile.empty() && !image.mipData.empty())
+  {
+    std::error_code ec;
+    fs::create_directories(m_cacheDirectory, ec);
+    saveImageCache(cacheFile, cacheKey, image.format, image.size, image.mipData);
+  }
 }
 
 bool nvvkgltf::SceneVk::createImage(const VkCommandBuffer& cmd, nvvk::StagingUploader& staging, SceneImage& image)
@@ -1158,9 +2114,9 @@ bool nvvkgltf::SceneVk::createImage(const VkCommandBuffer& cmd, nvvk::StagingUpl
   imageCreateInfo.usage             = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
   // Mip-mapping images were defined (.ktx, .dds), use the number of levels defined
-  if(image.mipData.size() > 1)
+  if(image.getNumMips() > 1)
   {
-    imageCreateInfo.mipLevels = static_cast<uint32_t>(image.mipData.size());
+    imageCreateInfo.mipLevels = static_cast<uint32_t>(image.getNumMips());
   }
   else if(canGenerateMipmaps && m_generateMipmaps)
   {
@@ -1179,11 +2135,11 @@ bool nvvkgltf::SceneVk::createImage(const VkCommandBuffer& cmd, nvvk::StagingUpl
   // Set the initial layout to TRANSFER_DST_OPTIMAL
   resultImage.descriptor.imageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;  // Setting this, tells the appendImage that the image is in this layout (no need to transfer)
   nvvk::cmdImageMemoryBarrier(cmd, {resultImage.image, VK_IMAGE_LAYOUT_UNDEFINED, resultImage.descriptor.imageLayout});
-  NVVK_CHECK(staging.appendImage(resultImage, std::span(image.mipData[0]), resultImage.descriptor.imageLayout));
+  NVVK_CHECK(staging.appendImage(resultImage, image.getMip(0), resultImage.descriptor.imageLayout));
   staging.cmdUploadAppended(cmd);  // Upload the first mip level
 
   // The image require to generate the mipmaps
-  if(image.mipData.size() == 1 && (canGenerateMipmaps && m_generateMipmaps))
+  if(image.getNumMips() == 1 && (canGenerateMipmaps && m_generateMipmaps))
   {
     nvvk::cmdGenerateMipmaps(cmd, resultImage.image, imgSize, imageCreateInfo.mipLevels, 1, resultImage.descriptor.imageLayout);
   }
@@ -1202,7 +2158,7 @@ bool nvvkgltf::SceneVk::createImage(const VkCommandBuffer& cmd, nvvk::StagingUpl
 
       if(imageCreateInfo.extent.width > 0 && imageCreateInfo.extent.height > 0)
       {
-        staging.appendImageSub(resultImage, offset, imageCreateInfo.extent, subresource, std::span(image.mipData[mip]));
+        staging.appendImageSub(resultImage, offset, imageCreateInfo.extent, subresource, image.getMip(mip));
       }
     }
     // Upload all the mip levels
@@ -1221,14 +2177,390 @@ bool nvvkgltf::SceneVk::createImage(const VkCommandBuffer& cmd, nvvk::StagingUpl
     NVVK_DBG_NAME(resultImage.image);
   }
 
-  // Clear image.mipData as it is no longer needed
+  // Clear image.mipData as it is no longer needed, and unmap the file of the zero-copy loads
   // image.srgb and image.imgName are preserved
   image.imageTexture = resultImage;
   image.mipData.clear();
+  image.mipViews.clear();
+  image.mapping.reset();
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Texture streaming
+//
+
+// Bytes per pixel of the formats produced by loadImage for the images without mips, 0 for the others
+static size_t getDownsampleBytesPerPixel(VkFormat format)
+{
+  switch(format)
+  {
+    case VK_FORMAT_R8_UNORM:
+      return 1;
+    case VK_FORMAT_R16_UNORM:
+      return 2;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+      return 4;
+    case VK_FORMAT_R16G16B16A16_UNORM:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+template <typename T>
+static void downsampleBox(const T* src, VkExtent2D srcSize, T* dst, VkExtent2D dstSize, uint32_t channels)
+{
+  for(uint32_t y = 0; y < dstSize.height; y++)
+  {
+    const uint32_t y0 = std::min(y * 2, srcSize.height - 1);
+    const uint32_t y1 = std::min(y * 2 + 1, srcSize.height - 1);
+    for(uint32_t x = 0; x < dstSize.width; x++)
+    {
+      const uint32_t x0 = std::min(x * 2, srcSize.width - 1);
+      const uint32_t x1 = std::min(x * 2 + 1, srcSize.width - 1);
+      for(uint32_t c = 0; c < channels; c++)
+      {
+        const uint32_t sum = src[(y0 * srcSize.width + x0) * channels + c] + src[(y0 * srcSize.width + x1) * channels + c]
+                             + src[(y1 * srcSize.width + x0) * channels + c] + src[(y1 * srcSize.width + x1) * channels + c];
+        dst[(y * dstSize.width + x) * channels + c] = T((sum + 2) / 4);
+      }
+    }
+  }
+}
+
+// Box filtered mip chain of an uncompressed image, the sRGB images are filtered in their encoded space
+static void generateMipData(VkFormat format, VkExtent2D size, std::vector<std::vector<char>>& mipData)
+{
+  const size_t bytesPerPixel = getDownsampleBytesPerPixel(format);
+  if(bytesPerPixel == 0 || mipData.size() != 1)
+    return;
+
+  const bool     is16Bit  = format == VK_FORMAT_R16_UNORM || format == VK_FORMAT_R16G16B16A16_UNORM;
+  const uint32_t channels = uint32_t(bytesPerPixel / (is16Bit ? 2 : 1));
+  VkExtent2D     srcSize  = size;
+  for(uint32_t mip = 1; mip < nvvk::mipLevels(size); mip++)
+  {
+    const VkExtent2D dstSize{std::max(1u, size.width >> mip), std::max(1u, size.height >> mip)};
+    mipData.emplace_back(size_t(dstSize.width) * dstSize.height * bytesPerPixel);
+    const char* src = mipData[mip - 1].data();
+    char*       dst = mipData[mip].data();
+    if(is16Bit)
+      downsampleBox((const uint16_t*)src, srcSize, (uint16_t*)dst, dstSize, channels);
+    else
+      downsampleBox((const uint8_t*)src, srcSize, (uint8_t*)dst, dstSize, channels);
+    srcSize = dstSize;
+  }
+}
+
+// Block compression of the decoded 8-bit images, see setTextureCompression. The device can't generate the mips of
+// compressed formats, they are box filtered here before the encoding.
+void nvvkgltf::SceneVk::compressImage(SceneImage& image, bool normalMap)
+{
+  if((image.format != VK_FORMAT_R8G8B8A8_UNORM && image.format != VK_FORMAT_R8G8B8A8_SRGB) || image.mipData.size() != 1)
+    return;
+
+  if(m_generateMipmaps)
+    generateMipData(image.format, image.size, image.mipData);
+
+  const nv_bcenc::ParallelForFunc parallelFor = [](size_t numJobs, const std::function<void(size_t)>& job) {
+    nvutils::parallel_batches<1>(numJobs, [&](uint64_t i) { job(size_t(i)); });
+  };
+
+  std::vector<std::vector<char>> compressed(image.mipData.size());
+  for(size_t mip = 0; mip < image.mipData.size(); mip++)
+  {
+    const uint32_t width  = std::max(1u, image.size.width >> mip);
+    const uint32_t height = std::max(1u, image.size.height >> mip);
+    compressed[mip].resize(nv_bcenc::getCompressedSize(width, height));
+    const uint8_t* rgba   = reinterpret_cast<const uint8_t*>(image.mipData[mip].data());
+    uint8_t*       output = reinterpret_cast<uint8_t*>(compressed[mip].data());
+
+    const bool perceptual = image.format == VK_FORMAT_R8G8B8A8_SRGB;
+    const bool ok         = normalMap ? nv_bcenc::compressBC5(rgba, width, height, output, parallelFor) :
+                                        nv_bcenc::compressBC7(rgba, width, height, perceptual, output, parallelFor);
+    if(!ok)
+      return;  // Without Basis Universal, kept uncompressed
+  }
+
+  image.format  = normalMap                                 ? VK_FORMAT_BC5_UNORM_BLOCK :
+                  image.format == VK_FORMAT_R8G8B8A8_SRGB ? VK_FORMAT_BC7_SRGB_BLOCK :
+                                                              VK_FORMAT_BC7_UNORM_BLOCK;
+  image.mipData = std::move(compressed);
+}
+
+// Decodes the images on a background thread, the uploads are done by updateTextureStreaming
+void nvvkgltf::SceneVk::startTextureStreaming(const tinygltf::Model& model, const std::filesystem::path& basedir, std::vector<int> images)
+{
+  m_streamCancel = false;
+  m_streamThread = std::thread([this, &model, basedir, images = std::move(images)]() {
+    nvutils::parallel_batches_pooled<1>(images.size(), [&](uint64_t i, uint32_t) {
+      if(m_streamCancel)
+        return;
+      const int imageID = images[i];
+      loadImage(basedir, model.images[imageID], imageID);
+
+      // Images without mips get theirs on the host, the coarse levels are uploaded first
+      SceneImage& image = m_images[imageID];
+      if(m_generateMipmaps)
+        generateMipData(image.format, image.size, image.mipData);
+
+      std::lock_guard<std::mutex> lock(m_streamMutex);
+      m_streamLoaded.push_back(imageID);
+    });
+  });
+
+  // Over the budget, the finest levels are dropped at the next update
+  m_evictionCallbackID = m_alloc->addEvictionCallback([this](VkDeviceSize bytesToFree) {
+    const VkDeviceSize freed = std::min(bytesToFree, m_streamResidentBytes.load());
+    m_streamEvictBytes += freed;
+    return freed;
+  });
+}
+
+void nvvkgltf::SceneVk::stopTextureStreaming()
+{
+  m_streamCancel = true;
+  if(m_streamThread.joinable())
+    m_streamThread.join();
+  if(m_evictionCallbackID != ~0U)
+  {
+    m_alloc->removeEvictionCallback(m_evictionCallbackID);
+    m_evictionCallbackID = ~0U;
+  }
+
+  for(RetiredImage& retired : m_retiredImages)
+  {
+    m_memoryTracker.untrack(kMemCategoryImages, retired.image.allocation);
+    m_alloc->destroyImage(retired.image);
+  }
+  m_retiredImages.clear();
+  m_streamedImages.clear();
+  m_streamLoaded.clear();
+  m_streamEvictBytes    = 0;
+  m_streamResidentBytes = 0;
+}
+
+void nvvkgltf::SceneVk::setImageRequiredMipLevel(uint32_t imageID, uint32_t mipLevel)
+{
+  if(imageID < m_streamedImages.size())
+    m_streamedImages[imageID].requiredLevel = mipLevel;
+}
 
+bool nvvkgltf::SceneVk::isTextureStreamingDone() const
+{
+  for(size_t i = 0; i < m_streamedImages.size(); i++)
+  {
+    const StreamedImage& streamed = m_streamedImages[i];
+    const uint32_t       numMips  = uint32_t(m_images[i].mipData.size());
+    if(!streamed.loaded || (numMips > 0 && streamed.residentLevel > std::min(streamed.requiredLevel, numMips - 1)))
+      return false;
+  }
   return true;
 }
 
+// Replaces the device image by one holding the mips from `mipLevel`, uploaded from the host copy
+void nvvkgltf::SceneVk::setResidentMipLevel(VkCommandBuffer cmd, nvvk::StagingUploader& staging, int imageID, uint32_t mipLevel)
+{
+  SceneImage&    image    = m_images[imageID];
+  StreamedImage& streamed = m_streamedImages[imageID];
+  const uint32_t numMips  = uint32_t(image.mipData.size());
+
+  VkImageCreateInfo imageCreateInfo = DEFAULT_VkImageCreateInfo;
+  imageCreateInfo.extent    = {std::max(1u, image.size.width >> mipLevel), std::max(1u, image.size.height >> mipLevel), 1};
+  imageCreateInfo.format    = image.format;
+  imageCreateInfo.mipLevels = numMips - mipLevel;
+  imageCreateInfo.usage     = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+  nvvk::Image resultImage;
+  NVVK_CHECK(m_alloc->createImage(resultImage, imageCreateInfo, DEFAULT_VkImageViewCreateInfo));
+  m_memoryTracker.track(kMemCategoryImages, resultImage.allocation);
+  if(!image.imgName.empty())
+    nvvk::DebugUtil::getInstance().setObjectName(resultImage.image, image.imgName);
+
+  resultImage.descriptor.imageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  nvvk::cmdImageMemoryBarrier(cmd, {resultImage.image, VK_IMAGE_LAYOUT_UNDEFINED, resultImage.descriptor.imageLayout,
+                                    {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1}});
+  VkDeviceSize bytes = 0;
+  for(uint32_t mip = mipLevel; mip < numMips; mip++)
+  {
+    VkImageSubresourceLayers subresource{};
+    subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    subresource.layerCount = 1;
+    subresource.mipLevel   = mip - mipLevel;
+    const VkExtent3D extent{std::max(1u, image.size.width >> mip), std::max(1u, image.size.height >> mip), 1};
+    NVVK_CHECK(staging.appendImageSub(resultImage, {}, extent, subresource, std::span(image.mipData[mip])));
+    bytes += image.mipData[mip].size();
+  }
+  staging.cmdUploadAppended(cmd);
+  resultImage.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  nvvk::cmdImageMemoryBarrier(cmd, {resultImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, resultImage.descriptor.imageLayout,
+                                    {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1}});
+
+  // The previous image may still be used by the frames in flight
+  m_retiredImages.push_back({image.imageTexture, m_streamingOptions.framesInFlight});
+  image.imageTexture = resultImage;
+  for(size_t t = 0; t < m_textures.size(); t++)
+  {
+    if(m_textureImages[t] == imageID)
+    {
+      m_textures[t].image                = resultImage.image;
+      m_textures[t].descriptor.imageView = resultImage.descriptor.imageView;
+      m_textures[t].descriptor.imageLayout = resultImage.descriptor.imageLayout;
+    }
+  }
+
+  // What eviction could free, above the coarsest level
+  const VkDeviceSize coarsest = image.mipData.back().size();
+  m_streamResidentBytes -= streamed.residentBytes > coarsest ? streamed.residentBytes - coarsest : 0;
+  m_streamResidentBytes += bytes > coarsest ? bytes - coarsest : 0;
+  streamed.residentLevel = mipLevel;
+  streamed.residentBytes = bytes;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Progressive uploads of the streamed images, within the upload bandwidth and the memory budget:
+// - decoded images first get their mips up to `initialMaxSize`
+// - then one finer level per update, until the level required by the renderer feedback
+// - images finer than required, or when the allocator asks to evict, drop their finest level
+//
+bool nvvkgltf::SceneVk::updateTextureStreaming(VkCommandBuffer cmd, nvvk::StagingUploader& staging)
+{
+  if(m_streamedImages.empty())
+    return false;
+
+  // Images replaced by the previous updates and no longer used by the frames in flight
+  for(size_t i = 0; i < m_retiredImages.size();)
+  {
+    if(m_retiredImages[i].updatesLeft-- == 0)
+    {
+      m_memoryTracker.untrack(kMemCategoryImages, m_retiredImages[i].image.allocation);
+      m_alloc->destroyImage(m_retiredImages[i].image);
+      m_retiredImages[i] = m_retiredImages.back();
+      m_retiredImages.pop_back();
+    }
+    else
+    {
+      i++;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_streamMutex);
+    for(int imageID : m_streamLoaded)
+      m_streamedImages[imageID].loaded = true;
+    m_streamLoaded.clear();
+  }
+
+  const nvvk::ResourceAllocator::BudgetReport report = m_alloc->getBudgetReport();
+  const VkDeviceSize budget     = VkDeviceSize(double(report.budget) * m_streamingOptions.budgetFraction);
+  VkDeviceSize       available  = budget > report.usage ? budget - report.usage : 0;
+  VkDeviceSize       evictBytes = m_streamEvictBytes.exchange(0);
+  VkDeviceSize       uploadLeft = m_streamingOptions.maxUploadBytesPerUpdate;
+  bool               changed    = false;
+
+  const auto levelBytes = [&](int imageID, uint32_t mipLevel) {
+    VkDeviceSize bytes = 0;
+    for(size_t mip = mipLevel; mip < m_images[imageID].mipData.size(); mip++)
+      bytes += m_images[imageID].mipData[mip].size();
+    return bytes;
+  };
+
+  // Coarsening: not needed by the renderer, or asked by the allocator (largest images first)
+  std::vector<int> resident;
+  for(int imageID = 0; imageID < int(m_streamedImages.size()); imageID++)
+  {
+    const StreamedImage& streamed = m_streamedImages[imageID];
+    if(streamed.loaded && streamed.residentLevel != ~0U && streamed.residentLevel + 1 < m_images[imageID].mipData.size())
+      resident.push_back(imageID);
+  }
+  std::sort(resident.begin(), resident.end(),
+            [&](int a, int b) { return m_streamedImages[a].residentBytes > m_streamedImages[b].residentBytes; });
+  for(int imageID : resident)
+  {
+    StreamedImage& streamed = m_streamedImages[imageID];
+    const bool     evict    = evictBytes > 0;
+    if(!evict && streamed.residentLevel >= streamed.requiredLevel)
+      continue;
+
+    const uint32_t     mipLevel = evict ? streamed.residentLevel + 1 : streamed.requiredLevel;
+    const VkDeviceSize bytes    = levelBytes(imageID, std::min(mipLevel, uint32_t(m_images[imageID].mipData.size()) - 1));
+    if(bytes > uploadLeft)
+      continue;
+
+    const VkDeviceSize freed = streamed.residentBytes - bytes;
+    setResidentMipLevel(cmd, staging, imageID, std::min(mipLevel, uint32_t(m_images[imageID].mipData.size()) - 1));
+    evictBytes -= std::min(evictBytes, freed);
+    uploadLeft -= bytes;
+    changed = true;
+  }
+
+  // Refining: images still on their placeholder first, then the ones furthest from their required level
+  std::vector<std::pair<int, uint32_t>> refine;  // image, next level
+  for(int imageID = 0; imageID < int(m_streamedImages.size()); imageID++)
+  {
+    const StreamedImage& streamed = m_streamedImages[imageID];
+    const uint32_t       numMips  = uint32_t(m_images[imageID].mipData.size());
+    if(!streamed.loaded || numMips == 0)
+      continue;
+
+    const uint32_t target = std::min(streamed.requiredLevel, numMips - 1);
+    if(streamed.residentLevel == ~0U)
+    {
+      uint32_t initial = 0;
+      while(initial + 1 < numMips
+            && std::max(m_images[imageID].size.width, m_images[imageID].size.height) >> initial > m_streamingOptions.initialMaxSize)
+        initial++;
+      refine.push_back({imageID, std::max(target, initial)});
+    }
+    else if(streamed.residentLevel > target)
+    {
+      refine.push_back({imageID, streamed.residentLevel - 1});
+    }
+  }
+  std::stable_sort(refine.begin(), refine.end(), [&](const auto& a, const auto& b) {
+    const StreamedImage& sa = m_streamedImages[a.first];
+    const StreamedImage& sb = m_streamedImages[b.first];
+    if((sa.residentLevel == ~0U) != (sb.residentLevel == ~0U))
+      return sa.residentLevel == ~0U;
+    return sa.residentLevel - sa.requiredLevel > sb.residentLevel - sb.requiredLevel;
+  });
+
+  const bool overBudget = evictBytes > 0;
+  for(const auto& [imageID, mipLevel] : refine)
+  {
+    StreamedImage&     streamed = m_streamedImages[imageID];
+    const VkDeviceSize bytes    = levelBytes(imageID, mipLevel);
+    const VkDeviceSize growth   = bytes - std::min(bytes, streamed.residentBytes);
+    const bool         initial  = streamed.residentLevel == ~0U;
+
+    // The coarse levels are always uploaded, the finer ones within the budget and the bandwidth
+    if(!initial && (overBudget || growth > available))
+      continue;
+    if(bytes > uploadLeft && uploadLeft != m_streamingOptions.maxUploadBytesPerUpdate)
+      break;
+
+    setResidentMipLevel(cmd, staging, imageID, mipLevel);
+    uploadLeft -= std::min(uploadLeft, bytes);
+    available -= std::min(available, growth);
+    changed = true;
+  }
+
+  // All images are decoded
+  if(m_streamThread.joinable())
+  {
+    bool allLoaded = true;
+    for(const StreamedImage& streamed : m_streamedImages)
+      allLoaded = allLoaded && streamed.loaded;
+    if(allLoaded)
+      m_streamThread.join();
+  }
+
+  return changed;
+}
+
 std::vector<shaderio::GltfLight> getShaderLights(const std::vector<nvvkgltf::RenderLight>& renderlights,
                                                  const std::vector<tinygltf::Light>&       gltfLights)
 {
@@ -1304,8 +2636,20 @@ void nvvkgltf::SceneVk::destroy()
       m_memoryTracker.untrack(kMemCategoryGeometry, vertexBuffer.color.allocation);
       m_alloc->destroyBuffer(vertexBuffer.color);
     }
+    for(nvvk::Buffer* buffer : {&vertexBuffer.packedPosition, &vertexBuffer.packedNormal, &vertexBuffer.packedTangent,
+                                &vertexBuffer.packedTexCoord0, &vertexBuffer.packedTexCoord1})
+    {
+      if(buffer->buffer != VK_NULL_HANDLE)
+      {
+        m_memoryTracker.untrack(kMemCategoryGeometry, buffer->allocation);
+        m_alloc->destroyBuffer(*buffer);
+      }
+    }
   }
   m_vertexBuffers.clear();
+  m_packedPrimitives.clear();
+  m_memoryTracker.untrackSaved(kMemCategoryGeometry, m_packedSavedBytes);
+  m_packedSavedBytes = 0;
 
   for(auto& indicesBuffer : m_bIndices)
   {
@@ -1317,6 +2661,26 @@ void nvvkgltf::SceneVk::destroy()
   }
   m_bIndices.clear();
 
+  for(auto& meshletBuffer : m_meshletBuffers)
+  {
+    for(nvvk::Buffer* buffer : {&meshletBuffer.meshlets, &meshletBuffer.bounds, &meshletBuffer.vertices, &meshletBuffer.triangles})
+    {
+      if(buffer->buffer != VK_NULL_HANDLE)
+      {
+        m_memoryTracker.untrack(kMemCategoryGeometry, buffer->allocation);
+        m_alloc->destroyBuffer(*buffer);
+      }
+    }
+  }
+  m_meshletBuffers.clear();
+  if(m_bMeshletPrim.buffer != VK_NULL_HANDLE)
+  {
+    m_memoryTracker.untrack(kMemCategorySceneData, m_bMeshletPrim.allocation);
+    m_alloc->destroyBuffer(m_bMeshletPrim);
+  }
+  m_numMeshlets = 0;
+  m_primitiveLods.clear();
+
   if(m_bMaterial.buffer != VK_NULL_HANDLE)
   {
     m_memoryTracker.untrack(kMemCategorySceneData, m_bMaterial.allocation);
@@ -1327,6 +2691,11 @@ void nvvkgltf::SceneVk::destroy()
     m_memoryTracker.untrack(kMemCategorySceneData, m_bTextureInfos.allocation);
     m_alloc->destroyBuffer(m_bTextureInfos);
   }
+  m_materialFeatures.clear();
+  m_materialPermutations.clear();
+  m_materialsScratch.clear();
+  m_textureInfosScratch.clear();
+  m_materialTextureSlots.clear();
   if(m_bLights.buffer != VK_NULL_HANDLE)
   {
     m_memoryTracker.untrack(kMemCategorySceneData, m_bLights.allocation);
@@ -1348,6 +2717,8 @@ void nvvkgltf::SceneVk::destroy()
     m_alloc->destroyBuffer(m_bSceneDesc);
   }
 
+  stopTextureStreaming();
+
   for(auto& texture : m_textures)
   {
     m_samplerPool->releaseSampler(texture.descriptor.sampler);
@@ -1362,6 +2733,8 @@ void nvvkgltf::SceneVk::destroy()
   }
   m_images.clear();
   m_textures.clear();
+  m_textureImages.clear();
 
   m_sRgbImages.clear();
+  m_normalImages.clear();
 }
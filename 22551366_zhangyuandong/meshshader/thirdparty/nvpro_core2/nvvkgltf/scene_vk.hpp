@@ -19,15 +19,21 @@
 
 #pragma once
 
+#include <atomic>
 #include <filesystem>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <thread>
 
 #include <nvvk/resource_allocator.hpp>
 
 #include "scene.hpp"
+#include "nvutils/file_mapping.hpp"
 #include "nvvk/sampler_pool.hpp"
 #include "nvvk/staging.hpp"
 #include "gpu_memory_tracker.hpp"
+#include "nvshaders/gltf_scene_io.h.slang"
 
 
 /*-------------------------------------------------------------------------------------------------
@@ -54,6 +60,55 @@ public:
     nvvk::Buffer texCoord0;
     nvvk::Buffer texCoord1;
     nvvk::Buffer color;
+
+    // Packed streams, replacing the ones above (see setVertexPacking)
+    nvvk::Buffer packedPosition;
+    nvvk::Buffer packedNormal;
+    nvvk::Buffer packedTangent;
+    nvvk::Buffer packedTexCoord0;
+    nvvk::Buffer packedTexCoord1;
+    glm::vec3    positionMin{};
+    glm::vec3    positionExtent{};
+  };
+
+  // Optional clusters of the render primitives, for task and mesh shader rendering with per-meshlet
+  // frustum, backface and occlusion culling (see nvshaders/gltf_meshlet.h.slang)
+  struct MeshletOptions
+  {
+    bool                  enable       = false;
+    uint32_t              maxVertices  = 64;   // at most 256
+    uint32_t              maxTriangles = 124;  // multiple of 4, at most 512
+    float                 coneWeight   = 0.25f;
+    std::filesystem::path cacheDirectory;  // the built meshlets are stored there, when not empty
+  };
+
+  // Optional simplified levels of detail of the triangle primitives, built with meshopt_simplify. Their indices
+  // are stored after the full detail ones in the index buffer of the primitive (see shaderio::GltfPrimitiveLod),
+  // and are reused from the cache directory (see setCacheDirectory).
+  struct LodOptions
+  {
+    bool     enable      = false;
+    uint32_t numLods     = 3;      // simplified levels, at most GLTF_MAX_LODS - 1
+    float    reduction   = 0.5f;   // triangles of a level relative to the previous one
+    float    targetError = 0.05f;  // largest error of a level, relative to the primitive extent
+  };
+
+  // Progressive texture residency: `create` returns with placeholder images while the images are decoded on
+  // worker threads, then `updateTextureStreaming` uploads their coarse mips first and refines them within the budget
+  struct TextureStreamingOptions
+  {
+    bool         enable                  = false;
+    uint32_t     initialMaxSize          = 256;          // largest side of the first upload of an image
+    VkDeviceSize maxUploadBytesPerUpdate = 64ull << 20;  // staging bandwidth of an update
+    float        budgetFraction          = 0.8f;         // of the device-local budget, that the textures may fill
+    uint32_t     framesInFlight          = 3;            // replaced images are destroyed after as many updates
+  };
+
+  // Materials sharing the same GLTF_MATERIAL_FEATURE_* (nvshaders/gltf_scene_io.h.slang), see getMaterialPermutations
+  struct MaterialPermutation
+  {
+    uint32_t              features = 0;
+    std::vector<uint32_t> materials;  // indices in material()
   };
 
   SceneVk() = default;
@@ -70,19 +125,71 @@ public:
 
   void update(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn);
   void updateRenderNodesBuffer(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn);
+  // Uploads only the given render nodes (sorted, e.g. Scene::getDirtyRenderNodes), adjacent ones in a single copy
+  void updateRenderNodesBuffer(VkCommandBuffer           cmd,
+                               nvvk::StagingUploader&    staging,
+                               const nvvkgltf::Scene&    scn,
+                               std::span<const uint32_t> renderNodeIDs);
   void updateRenderPrimitivesBuffer(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn);
   void updateRenderLightsBuffer(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn);
   void updateMaterialBuffer(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn);
+  // Regenerates and uploads only the given materials (sorted, e.g. Scene::getDirtyMaterials), in their texture info slots
+  void updateMaterialBuffer(VkCommandBuffer           cmd,
+                            nvvk::StagingUploader&    staging,
+                            const nvvkgltf::Scene&    scn,
+                            std::span<const uint32_t> materialIDs);
   void updateVertexBuffers(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scene);
   virtual void destroy();
 
+  // Applies at the next `create`
+  void setMeshletOptions(const MeshletOptions& options) { m_meshletOptions = options; }
+  void setLodOptions(const LodOptions& options) { m_lodOptions = options; }
+  // Packed vertex streams for the primitives that are not morphed or skinned: 16-bit positions in the primitive
+  // bounds (kept in fp32 with ray tracing, for the acceleration structures), octahedral normals and tangents,
+  // half texture coordinates. Shaders decode them with nvshaders/gltf_vertex_access.h.slang. Applies at the next `create`.
+  void setVertexPacking(bool enable) { m_vertexPacking = enable; }
+  void setTextureStreaming(const TextureStreamingOptions& options) { m_streamingOptions = options; }
+  // The 8-bit PNG, JPG and embedded images are block compressed on the loading threads: BC7 for the colors, BC5 for
+  // the normal maps (the shaders rebuild Z), with their mips. Cached with setCacheDirectory. Needs textureCompressionBC.
+  void setTextureCompression(bool enable) { m_textureCompression = enable; }
+  // The morphed and skinned positions are written on the device by nvvkgltf::SceneSkinning, `update` leaves them
+  void setGpuAnimation(bool enable) { m_gpuAnimation = enable; }
+  // The decoded and transcoded image files and the LODs are stored there and reused by the next loads, when not empty (see nvvkgltf::cache)
+  void setCacheDirectory(const std::filesystem::path& directory) { m_cacheDirectory = directory; }
+
+  // Texture streaming, see TextureStreamingOptions. The glTF model must outlive the streaming.
+  // Renderer feedback, e.g. from a screen-space mip level readback: finest mip the image needs (0 by default)
+  void setImageRequiredMipLevel(uint32_t imageID, uint32_t mipLevel);
+  // Once per frame, outside of rendering. Returns true when images of `textures()` were replaced:
+  // the descriptors referencing them must be rewritten.
+  bool updateTextureStreaming(VkCommandBuffer cmd, nvvk::StagingUploader& staging);
+  bool isTextureStreamingDone() const;
+
   // Getters
   const nvvk::Buffer&               material() const { return m_bMaterial; }
+  // Features of each material, also in GltfShadeMaterial::features, set by updateMaterialBuffer
+  const std::vector<uint32_t>& getMaterialFeatures() const { return m_materialFeatures; }
+  // The materials grouped by features, in increasing order of them. Compile a shader permutation per entry with
+  // PBR_MATERIAL_FEATURES = features (e.g. with nvslang::ShaderPermutations, GLTF_MATERIAL_FEATURE_ALL being
+  // the fallback that renders every material) and draw the primitives of each group with its own pipeline.
+  const std::vector<MaterialPermutation>& getMaterialPermutations() const { return m_materialPermutations; }
   const nvvk::Buffer&               primInfo() const { return m_bRenderPrim; }
   const nvvk::Buffer&               instances() const { return m_bRenderNode; }
   const nvvk::Buffer&               sceneDesc() const { return m_bSceneDesc; }
+  const nvvk::Buffer&               meshletPrimitives() const { return m_bMeshletPrim; }  // GltfMeshletPrimitive per render primitive
+  uint32_t                          getNumMeshlets() const { return m_numMeshlets; }
   const std::vector<VertexBuffers>& vertexBuffers() const { return m_vertexBuffers; }
   const std::vector<nvvk::Buffer>&  indices() const { return m_bIndices; }
+  // Levels of detail of a render primitive, the full detail first, then the simplified ones if any (see LodOptions)
+  std::span<const shaderio::GltfPrimitiveLod> getLods(size_t primID) const { return m_primitiveLods[primID]; }
+  // Coarsest level whose error, scaled by `worldScale`, projects to at most `maxPixelError` pixels at `distance`.
+  // `pixelsPerUnit` is the size in pixels of a unit at distance 1: projection[1][1] * viewport height / 2.
+  // Same selection as the culling of nvvkgltf::SceneIndirectDraws.
+  static uint32_t selectLod(std::span<const shaderio::GltfPrimitiveLod> lods,
+                            float                                       worldScale,
+                            float                                       distance,
+                            float                                       pixelsPerUnit,
+                            float                                       maxPixelError = 1.0f);
   const std::vector<nvvk::Image>&   textures() const { return m_textures; }
   uint32_t                          nbTextures() const { return static_cast<uint32_t>(m_textures.size()); }
   const GpuMemoryTracker&           getMemoryTracker() const { return m_memoryTracker; }
@@ -99,10 +206,26 @@ protected:
     VkExtent2D                     size{0, 0};
     VkFormat                       format{VK_FORMAT_UNDEFINED};
     std::vector<std::vector<char>> mipData{};
+
+    // Zero-copy loads of .dds and .ktx2 files: the mips are spans into the mapped file, instead of mipData
+    std::vector<std::span<const char>>        mipViews{};
+    std::shared_ptr<nvutils::FileReadMapping> mapping{};
+
+    size_t                getNumMips() const { return mipViews.empty() ? mipData.size() : mipViews.size(); }
+    std::span<const char> getMip(size_t mip) const { return mipViews.empty() ? std::span<const char>(mipData[mip]) : mipViews[mip]; }
   };
 
   VkBufferUsageFlags2 getBufferUsageFlags() const;
   virtual void createVertexBuffers(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn);
+  virtual void createMeshletBuffers(VkCommandBuffer cmd, nvvk::StagingUploader& staging, const nvvkgltf::Scene& scn);
+  std::vector<std::vector<uint32_t>> generateLodIndices(const nvvkgltf::Scene& scn);
+  bool updatePackedVertexBuffers(VkCommandBuffer            cmd,
+                                 nvvk::StagingUploader&     staging,
+                                 const tinygltf::Model&     model,
+                                 const tinygltf::Primitive& primitive,
+                                 VertexBuffers&             vertexBuffers);
+  template <typename T>
+  bool uploadVertexStream(nvvk::StagingUploader& staging, std::span<const T> data, nvvk::Buffer& buffer);
   template <typename T>
   bool         updateAttributeBuffer(VkCommandBuffer            cmd,
                                      const std::string&         attributeName,
@@ -117,10 +240,17 @@ protected:
                                    const std::filesystem::path& basedir);
 
   void findSrgbImages(const tinygltf::Model& model);
+  void findNormalImages(const tinygltf::Model& model);
+  void compressImage(SceneImage& image, bool normalMap);
 
   virtual void loadImage(const std::filesystem::path& basedir, const tinygltf::Image& gltfImage, int imageID);
   virtual bool createImage(const VkCommandBuffer& cmd, nvvk::StagingUploader& staging, SceneImage& image);
 
+  void startTextureStreaming(const tinygltf::Model& model, const std::filesystem::path& basedir, std::vector<int> images);
+  void stopTextureStreaming();
+  void setResidentMipLevel(VkCommandBuffer cmd, nvvk::StagingUploader& staging, int imageID, uint32_t mipLevel);
+  void updateMaterialPermutations();  // From m_materialFeatures
+
   //--
   VkDevice         m_device{VK_NULL_HANDLE};
   VkPhysicalDevice m_physicalDevice{VK_NULL_HANDLE};
@@ -130,19 +260,81 @@ protected:
 
   nvvk::Buffer               m_bMaterial;
   nvvk::Buffer               m_bTextureInfos;
+  struct TextureInfoSlots
+  {
+    uint32_t first = 0;  // Texture infos of a material, in m_bTextureInfos
+    uint32_t count = 0;  // Slots reserved, the number of its textures when packed
+  };
+  std::vector<shaderio::GltfShadeMaterial> m_materialsScratch;     // Content of m_bMaterial, reused between updates
+  std::vector<shaderio::GltfTextureInfo>   m_textureInfosScratch;  // Content of m_bTextureInfos
+  std::vector<TextureInfoSlots>            m_materialTextureSlots;
+  std::vector<uint32_t>            m_materialFeatures;
+  std::vector<MaterialPermutation> m_materialPermutations;
   nvvk::Buffer               m_bLights;
   nvvk::Buffer               m_bRenderPrim;
   nvvk::Buffer               m_bRenderNode;
+  std::vector<shaderio::GltfRenderNode> m_renderNodesScratch;  // Content of m_bRenderNode, reused between updates
   nvvk::Buffer               m_bSceneDesc;
   std::vector<nvvk::Buffer>  m_bIndices;
   std::vector<VertexBuffers> m_vertexBuffers;
+
+  struct MeshletBuffers
+  {
+    nvvk::Buffer meshlets;
+    nvvk::Buffer bounds;
+    nvvk::Buffer vertices;
+    nvvk::Buffer triangles;
+  };
+  MeshletOptions              m_meshletOptions;
+  std::vector<MeshletBuffers> m_meshletBuffers;
+  nvvk::Buffer                m_bMeshletPrim;
+  uint32_t                    m_numMeshlets = 0;
+
+  LodOptions                                           m_lodOptions;
+  std::vector<std::vector<shaderio::GltfPrimitiveLod>> m_primitiveLods;  // per render primitive, see getLods
+
+  bool              m_vertexPacking = false;
+  bool              m_gpuAnimation  = false;
+  std::vector<bool> m_packedPrimitives;      // Render primitives using the packed streams
+  uint64_t          m_packedSavedBytes = 0;  // Reported to m_memoryTracker
+
   std::vector<SceneImage>    m_images;
   std::vector<nvvk::Image>   m_textures;  // Vector of all textures of the scene
 
-  std::set<int> m_sRgbImages;  // All images that are in sRGB (typically, only the one used by baseColorTexture)
+  std::set<int> m_sRgbImages;    // All images that are in sRGB (typically, only the one used by baseColorTexture)
+  std::set<int> m_normalImages;  // Images used as normal maps, see setTextureCompression
+
+  struct StreamedImage
+  {
+    bool         loaded        = false;  // mipData is filled, the host copy is kept to change levels
+    uint32_t     residentLevel = ~0U;    // finest mip on the device, ~0U while the placeholder is used
+    uint32_t     requiredLevel = 0;
+    VkDeviceSize residentBytes = 0;
+  };
+  struct RetiredImage
+  {
+    nvvk::Image image;
+    uint32_t    updatesLeft = 0;
+  };
+  TextureStreamingOptions    m_streamingOptions;
+  std::vector<StreamedImage> m_streamedImages;
+  std::vector<int>           m_textureImages;  // Source image of each texture
+  std::vector<RetiredImage>  m_retiredImages;
+  std::thread                m_streamThread;
+  std::mutex                 m_streamMutex;
+  std::vector<int>           m_streamLoaded;  // Decoded by m_streamThread, protected by m_streamMutex
+  std::atomic_bool           m_streamCancel{false};
+  std::atomic<VkDeviceSize>  m_streamEvictBytes{0};     // Requested by the allocator eviction callback
+  std::atomic<VkDeviceSize>  m_streamResidentBytes{0};  // Above the coarsest mips, what eviction can free
+  uint32_t                   m_evictionCallbackID = ~0U;
+
+  bool m_generateMipmaps    = {};
+  bool m_rayTracingEnabled  = {};
+  bool m_supportsAstc       = {};  // Target of the Basis Universal transcoding, else BC7
+  bool m_supportsBc         = {};
+  bool m_textureCompression = {};  // See setTextureCompression
 
-  bool m_generateMipmaps   = {};
-  bool m_rayTracingEnabled = {};
+  std::filesystem::path m_cacheDirectory;  // See setCacheDirectory
 
   GpuMemoryTracker m_memoryTracker;  // GPU memory tracking
 };
@@ -688,20 +688,27 @@ void tinygltf::utils::createTangentAttribute(tinygltf::Model& model, tinygltf::P
 // http://foundationsofgameenginedev.com/FGED2-sample.pdf
 void tinygltf::utils::simpleCreateTangents(tinygltf::Model& model, tinygltf::Primitive& primitive)
 {
-  const size_t  indexCount  = tinygltf::utils::getIndexCount(model, primitive);
-  const size_t  numVertices = tinygltf::utils::getVertexCount(model, primitive);
-  const int32_t numFaces    = static_cast<int32_t>(indexCount / 3);
+  createTangents(model, primitive, TangentMethod::eUvAccumulation);
+}
+
+void tinygltf::utils::createTangents(tinygltf::Model& model, tinygltf::Primitive& primitive, TangentMethod method, uint32_t numRanges)
+{
+  const size_t indexCount  = tinygltf::utils::getIndexCount(model, primitive);
+  const size_t numVertices = tinygltf::utils::getVertexCount(model, primitive);
+  const size_t numFaces    = indexCount / 3;
 
   std::vector<uint32_t>      indexStorage;
   std::vector<glm::vec3>     positionStorage;
   std::vector<glm::vec3>     normalStorage;
   std::vector<glm::vec2>     uvStorage;
-  std::span<const uint32_t>  indices   = getAccessorData(model, model.accessors[primitive.indices], &indexStorage);
+  std::span<const uint32_t>  indices;
   std::span<const glm::vec3> positions = getAttributeData3(model, primitive, "POSITION", &positionStorage);
   std::span<const glm::vec3> normals   = getAttributeData3(model, primitive, "NORMAL", &normalStorage);
   std::span<const glm::vec2> uvs       = getAttributeData3(model, primitive, "TEXCOORD_0", &uvStorage);
   // Must not be complex, since we write to it
   std::span<glm::vec4> tangents = getAttributeData3<glm::vec4>(model, primitive, "TANGENT", nullptr);
+  if(primitive.indices > -1)
+    indices = getAccessorData(model, model.accessors[primitive.indices], &indexStorage);
 
   if(tangents.data() == nullptr || positions.data() == nullptr)
   {
@@ -709,102 +716,126 @@ void tinygltf::utils::simpleCreateTangents(tinygltf::Model& model, tinygltf::Pri
     return;
   }
 
-  bool hasUV     = uvs.data() != nullptr;
-  bool hasNormal = normals.data() != nullptr;
+  const bool hasUV     = uvs.data() != nullptr;
+  const bool hasNormal = normals.data() != nullptr;
+  const bool useUV     = hasUV && method != TangentMethod::eFast;
 
-  // In case the normal is missing, we will compute it
-  std::vector<glm::vec3> geoNormal;
-  if(!hasNormal)
-  {
-    geoNormal.resize(numVertices);
-  }
+  // Each range owns the accumulation of its vertices, so the ranges run in parallel without atomics.
+  // A range visits all the faces but only computes those touching its vertices.
+  numRanges                     = std::max(1u, std::min(numRanges, uint32_t(numVertices)));
+  const size_t verticesPerRange = (numVertices + numRanges - 1) / numRanges;
 
+  nvutils::parallel_batches<1>(numRanges, [&](uint64_t rangeID) {
+    const size_t begin = rangeID * verticesPerRange;
+    const size_t end   = std::min(begin + verticesPerRange, numVertices);
+    if(begin >= end)
+      return;
 
-  for(int32_t i = 0; i < numFaces; i++)
-  {
-    // local index
-    uint32_t i0 = indices[i * 3 + 0];
-    uint32_t i1 = indices[i * 3 + 1];
-    uint32_t i2 = indices[i * 3 + 2];
+    // Per vertex of the range: sum of the face normals (when missing), tangents and bitangents
+    std::vector<glm::vec3> geoNormal(hasNormal ? 0 : end - begin, glm::vec3(0.0F));
+    std::vector<glm::vec3> tangentSum(useUV ? end - begin : 0, glm::vec3(0.0F));
+    std::vector<glm::vec3> bitangentSum(useUV ? end - begin : 0, glm::vec3(0.0F));
 
-    const glm::vec3& p0 = positions[i0];
-    const glm::vec3& p1 = positions[i1];
-    const glm::vec3& p2 = positions[i2];
-    glm::vec4&       t0 = tangents[i0];
-    glm::vec4&       t1 = tangents[i1];
-    glm::vec4&       t2 = tangents[i2];
-
-    // Find the normal or create it
-    glm::vec3 n0;
-    if(hasNormal)
-    {
-      n0 = normals[i0];
-    }
-    else
+    if(!hasNormal || useUV)
     {
-      geoNormal[i0] = geoNormal[i1] = geoNormal[i2] = glm::normalize(glm::cross(p1 - p0, p2 - p0));
-      n0                                            = geoNormal[i0];
+      for(size_t i = 0; i < numFaces; i++)
+      {
+        const uint32_t face[3] = {indices.empty() ? uint32_t(i * 3 + 0) : indices[i * 3 + 0],
+                                  indices.empty() ? uint32_t(i * 3 + 1) : indices[i * 3 + 1],
+                                  indices.empty() ? uint32_t(i * 3 + 2) : indices[i * 3 + 2]};
+        const bool     inRange[3] = {face[0] >= begin && face[0] < end, face[1] >= begin && face[1] < end,
+                                     face[2] >= begin && face[2] < end};
+        if(!inRange[0] && !inRange[1] && !inRange[2])
+          continue;
+
+        const glm::vec3& p0 = positions[face[0]];
+        const glm::vec3& p1 = positions[face[1]];
+        const glm::vec3& p2 = positions[face[2]];
+
+        glm::vec3 edge1 = p1 - p0;
+        glm::vec3 edge2 = p2 - p0;
+
+        glm::vec3 tangent{};
+        glm::vec3 bitangent{};
+        if(useUV)
+        {
+          glm::vec2 deltaUV1 = uvs[face[1]] - uvs[face[0]];
+          glm::vec2 deltaUV2 = uvs[face[2]] - uvs[face[0]];
+
+          float f = 1.0F;
+          float a = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+          if(fabs(a) > 0.0F)  // Catch degenerated UV
+          {
+            f = 1.0f / a;
+          }
+
+          tangent   = f * (deltaUV2.y * edge1 - deltaUV1.y * edge2);
+          bitangent = f * (deltaUV2.x * edge1 - deltaUV1.x * edge2);
+        }
+
+        for(int c = 0; c < 3; c++)
+        {
+          if(!inRange[c])
+            continue;
+          const size_t local = face[c] - begin;
+
+          if(!hasNormal)
+            geoNormal[local] += glm::cross(edge1, edge2);  // Area weighted
+
+          if(method == TangentMethod::eUvAccumulation)
+          {
+            tangentSum[local] += tangent;
+            bitangentSum[local] += bitangent;
+          }
+          else if(method == TangentMethod::eQuality)
+          {
+            // Tangent frame projected on the vertex normal plane, weighted by the angle of the corner
+            const glm::vec3 e0     = positions[face[(c + 1) % 3]] - positions[face[c]];
+            const glm::vec3 e1     = positions[face[(c + 2) % 3]] - positions[face[c]];
+            const float     denom  = glm::length(e0) * glm::length(e1);
+            const float     angle  = denom > 0.0F ? std::acos(glm::clamp(glm::dot(e0, e1) / denom, -1.0F, 1.0F)) : 0.0F;
+            const glm::vec3 n      = hasNormal ? normals[face[c]] : glm::cross(edge1, edge2);
+            const float     nLen2  = glm::length2(n);
+            glm::vec3       pTan   = tangent;
+            glm::vec3       pBitan = bitangent;
+            if(nLen2 > 0.0F)
+            {
+              pTan -= (glm::dot(n, pTan) / nLen2) * n;
+              pBitan -= (glm::dot(n, pBitan) / nLen2) * n;
+            }
+            if(glm::length2(pTan) > 0.0F)
+              tangentSum[local] += angle * glm::normalize(pTan);
+            if(glm::length2(pBitan) > 0.0F)
+              bitangentSum[local] += angle * glm::normalize(pBitan);
+          }
+        }
+      }
     }
 
-    if(hasUV)
+    // Ortho-normalize each tangent and apply the handedness.
+    for(size_t vertex = begin; vertex < end; vertex++)
     {
-      const glm::vec2& uv0 = uvs[i0];
-      const glm::vec2& uv1 = uvs[i1];
-      const glm::vec2& uv2 = uvs[i2];
-
-      glm::vec3 edge1 = p1 - p0;
-      glm::vec3 edge2 = p2 - p0;
+      const size_t local = vertex - begin;
+      glm::vec3    n0    = hasNormal ? normals[vertex] : glm::normalize(geoNormal[local]);
+      if(glm::length2(n0) < 0.1F || glm::any(glm::isnan(n0)))
+        n0 = glm::vec3(0.0F, 0.0F, 1.0F);
 
-      glm::vec2 deltaUV1 = uv1 - uv0;
-      glm::vec2 deltaUV2 = uv2 - uv0;
-
-      float f = 1.0F;
-      float a = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
-      if(fabs(a) > 0.0F)  // Catch degenerated UV
+      if(!useUV)
       {
-        f = 1.0f / a;
+        tangents[vertex] = shaderio::makeFastTangent(n0);
+        continue;
       }
 
-      glm::vec3 tangent   = f * (deltaUV2.y * edge1 - deltaUV1.y * edge2);
-      glm::vec3 bitangent = f * (deltaUV2.x * edge1 - deltaUV1.x * edge2);
+      // Gram-Schmidt orthogonalize
+      const glm::vec3& t0  = tangentSum[local];
+      glm::vec3        ot0 = glm::normalize(t0 - (glm::dot(n0, t0) * n0));
 
-      // Handedness calculation:
-      float handedness = (glm::dot(glm::cross(tangent, bitangent), n0) > 0.0F) ? 1.0F : -1.0F;
+      // In case the tangent is invalid
+      if(glm::length2(ot0) < 0.1F || glm::any(glm::isnan(ot0)))
+        ot0 = glm::vec3(shaderio::makeFastTangent(n0));
 
-      t0 = glm::vec4(tangent + glm::vec3(t0), handedness);
-      t1 = glm::vec4(tangent + glm::vec3(t1), handedness);
-      t2 = glm::vec4(tangent + glm::vec3(t2), handedness);
-    }
-    else
-    {
-      // No UVs, we will use the geometric normal to calculate the tangent
-      t0 = t1 = t2 = shaderio::makeFastTangent(n0);
+      const float handedness = (glm::dot(glm::cross(n0, ot0), bitangentSum[local]) < 0.0F) ? -1.0F : 1.0F;
+      tangents[vertex]       = glm::vec4(ot0, handedness);
     }
-  }
-
-
-  // Ortho-normalize each tangent and apply the handedness.
-  nvutils::parallel_batches(numVertices, [&](uint64_t i) {
-    const uint32_t vertex = static_cast<uint32_t>(i);
-    glm::vec4&     t0     = tangents[vertex];
-    glm::vec3      n0;
-    if(hasNormal)
-    {
-      n0 = normals[vertex];
-    }
-    else
-    {
-      n0 = geoNormal[i];
-    }
-
-    // Gram-Schmidt orthogonalize
-    glm::vec3 ot0 = glm::normalize(glm::vec3(t0) - (glm::dot(n0, glm::vec3(t0)) * n0));
-
-    // In case the tangent is invalid
-    if(glm::length2(ot0) < 0.1F || glm::any(glm::isnan(ot0)))
-      ot0 = glm::vec3(shaderio::makeFastTangent(n0));
-
-    float handedness = t0.w;
-    t0               = glm::vec4(ot0, handedness);
   });
 }
@@ -1083,6 +1083,24 @@ Compute tangents based on the texture coordinates, using also position and norma
 -------------------------------------------------------------------------------------------------*/
 void simpleCreateTangents(tinygltf::Model& model, tinygltf::Primitive& primitive);
 
+/*-------------------------------------------------------------------------------------------------
+## Function `createTangents`
+Compute tangents with the given method, the `TANGENT` attribute must exist (see `createTangentAttribute`).
+- `eFast`: from the normal only, ignoring the texture coordinates
+- `eUvAccumulation`: sum of the face tangents from the texture coordinates, as `simpleCreateTangents`
+- `eQuality`: face tangents projected on the vertex normal plane and weighted by the corner angle,
+  like MikkTSpace but without splitting the vertices on tangent seams
+
+`numRanges` splits the vertices into ranges generated in parallel, which helps for very large primitives.
+-------------------------------------------------------------------------------------------------*/
+enum class TangentMethod
+{
+  eFast,
+  eUvAccumulation,
+  eQuality,
+};
+void createTangents(tinygltf::Model& model, tinygltf::Primitive& primitive, TangentMethod method, uint32_t numRanges = 1);
+
 /*------------------------------------------------------------------------------------------------*/
 bool getMeshoptCompression(const tinygltf::BufferView& bview, EXT_meshopt_compression& mcomp);
 
@@ -0,0 +1,99 @@
+// 资源烘焙：图片转为含完整mip链的 BC7 KTX2，由 CMake 在构建时调用
+// 用法：asset_baker <输入图片> <输出.ktx2> [--flip]
+// --flip 上下翻转，与读取时调用 stbi_set_flip_vertically_on_load(true) 的程序一致
+// mip 由上一级线性缩放得到，与 glGenerateMipmap 的结果相近；数据按 UNORM 存储，与运行时上传的 GL_RGBA8 一致
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize2.h>
+
+#include <nvimageformats/nv_bcenc.h>
+#include <nvimageformats/nv_ktx.h>
+
+// 块行分给所有核心压缩
+static void parallelFor(size_t numJobs, const std::function<void(size_t)> &job)
+{
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> threads(std::max(std::thread::hardware_concurrency(), 1u));
+    for (std::thread &thread : threads)
+    {
+        thread = std::thread([&]()
+                             {
+                                 for (size_t i = next++; i < numJobs; i = next++)
+                                     job(i); });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "用法: asset_baker <输入图片> <输出.ktx2> [--flip]" << std::endl;
+        return 1;
+    }
+    const char *input = argv[1];
+    const char *output = argv[2];
+    stbi_set_flip_vertically_on_load(argc > 3 && strcmp(argv[3], "--flip") == 0);
+
+    int width, height, channels;
+    unsigned char *pixels = stbi_load(input, &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels)
+    {
+        std::cerr << "无法读取 " << input << ": " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+    std::vector<unsigned char> level(pixels, pixels + (size_t)width * height * 4);
+    stbi_image_free(pixels);
+
+    const uint32_t levels = 1 + (uint32_t)std::floor(std::log2((float)std::max(width, height)));
+    nv_ktx::KTXImage image;
+    if (image.allocate(levels, 0, 1))
+        return 1;
+    image.mip_0_width = (uint32_t)width;
+    image.mip_0_height = (uint32_t)height;
+    image.format = VK_FORMAT_BC7_UNORM_BLOCK;
+    image.is_srgb = false;
+
+    int levelWidth = width, levelHeight = height;
+    for (uint32_t mip = 0; mip < levels; mip++)
+    {
+        if (mip > 0)
+        {
+            int nextWidth = std::max(levelWidth / 2, 1), nextHeight = std::max(levelHeight / 2, 1);
+            std::vector<unsigned char> next((size_t)nextWidth * nextHeight * 4);
+            stbir_resize_uint8_linear(level.data(), levelWidth, levelHeight, 0, next.data(), nextWidth, nextHeight, 0, STBIR_RGBA);
+            level.swap(next);
+            levelWidth = nextWidth;
+            levelHeight = nextHeight;
+        }
+        std::vector<char> &compressed = image.subresource(mip);
+        compressed.resize(nv_bcenc::getCompressedSize(levelWidth, levelHeight));
+        if (!nv_bcenc::compressBC7(level.data(), levelWidth, levelHeight, true, (uint8_t *)compressed.data(), parallelFor))
+        {
+            std::cerr << "BC7 压缩失败: " << input << std::endl;
+            return 1;
+        }
+    }
+
+    if (nv_ktx::ErrorWithText error = image.writeKTX2File(output, {}))
+    {
+        std::cerr << "无法写入 " << output << ": " << *error << std::endl;
+        return 1;
+    }
+    std::cout << "烘焙 " << input << " → " << output << "（" << width << "x" << height << "，" << levels << " 级mip）" << std::endl;
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+// 各次作业共用的窗口、帧循环和着色器编译
+#include "glcore/app.h"
+#include "glcore/program.h"
 
 // 窗口大小
 const unsigned int SCR_WIDTH = 800;
@@ -35,71 +38,20 @@ void processInput(GLFWwindow* window)
 
 int main()
 {
-    // 初始化GLFW
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // 创建GLFW窗口
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "GLAD+GLFW Triangle", NULL, NULL);
+    // 初始化GLFW和GLAD，创建窗口
+    glcore::WindowSettings windowSettings;
+    windowSettings.title = "GLAD+GLFW Triangle";
+    windowSettings.width = SCR_WIDTH;
+    windowSettings.height = SCR_HEIGHT;
+    GLFWwindow* window = glcore::createWindow(windowSettings);
     if (window == NULL)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
         return -1;
     }
-    glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
-    // 初始化GLAD（加载OpenGL函数指针）
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
-    }
-
     // --------------------- 编译着色器程序 ---------------------
-    // 顶点着色器
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    // 检查编译错误
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-    // 片段着色器
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    // 检查编译错误
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-    // 链接着色器程序
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    // 检查链接错误
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-    // 删除已链接的着色器（不再需要）
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    unsigned int shaderProgram = glcore::compileShaderProgram(vertexShaderSource, fragmentShaderSource);
 
     // --------------------- 设置顶点数据（VAO/VBO） ---------------------
     float vertices[] = {
@@ -128,7 +80,8 @@ int main()
     glBindVertexArray(0);
 
     // --------------------- 渲染循环 ---------------------
-    while (!glfwWindowShouldClose(window))
+    glcore::FrameLoop frameLoop;
+    while (frameLoop.begin(window))
     {
         // 处理输入
         processInput(window);
@@ -143,8 +96,7 @@ int main()
         glDrawArrays(GL_TRIANGLES, 0, 3);
 
         // 交换缓冲+轮询事件
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        frameLoop.end(window);
     }
 
     // 释放资源
@@ -1,14 +1,43 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <stb_easy_font.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <tiny_obj_loader.h>
+#define TINYOBJ_LOADER_OPT_IMPLEMENTATION
+#include <tinyobj_loader_opt.h>
+#include <meshoptimizer.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <future>
+#include <iomanip>
+#include <thread>
 #include <vector>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include "glcore/app.h"
+#include "glcore/gpu_timer.h"
+#include "glcore/program.h"
+#include "glcore/texture_loader.h"
+#include "glcore/uniform_buffer.h"
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CULLING_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 // 全局变量
 GLFWwindow *window;
@@ -18,11 +47,239 @@ unsigned int shaderProgram;
 unsigned int uiShaderProgram; // 2D UI着色器
 unsigned int VAO, VBO, EBO;
 unsigned int uiVAO, uiVBO; // 2D UI顶点缓冲
+unsigned int uiTextVAO, uiTextVBO, uiTextEBO; // HUD文字（stb_easy_font 生成的四边形）
+int uiProjectionLocation, uiTextColorLocation, uiAlphaLocation;
+const int uiTextMaxQuads = 1000;
 std::vector<glm::vec3> vertices;
 std::vector<glm::vec2> texCoords;
 std::vector<glm::vec3> normals;
 std::vector<unsigned int> indices;
-unsigned int textureID = 0;
+std::vector<float> vertexData; // 交错顶点（位置+纹理+法线，8个float），loadOBJ的结果，追加到场景缓冲
+
+// 多模型场景：所有网格合并到同一套VBO/EBO，每个部件一条绘制命令
+struct SceneMesh
+{
+    unsigned int baseVertex, firstIndex, indexCount;
+    glm::vec3 boundsMin, boundsMax;
+};
+struct ScenePart
+{
+    unsigned int mesh;
+    glm::mat4 transform; // 只含旋转、平移和等比缩放（法线直接用 mat3(transform) 变换）
+    unsigned int material;
+};
+// 部件包围盒按分量分开存放（SoA），SIMD一次测试4/8个包围盒，长度补齐到8的倍数
+struct CullingBoxes
+{
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+    size_t count = 0;
+};
+CullingBoxes partBounds;      // 变换后的包围盒，与 sceneParts 一一对应
+std::vector<unsigned int> visibleParts; // 剔除结果
+// 与 glMultiDrawElementsIndirect 的命令格式一致，baseInstance 为部件编号
+struct DrawElementsIndirectCommand
+{
+    unsigned int count, instanceCount, firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+std::vector<SceneMesh> sceneMeshes;
+std::vector<ScenePart> sceneParts;
+std::vector<float> sceneVertexData;
+std::vector<unsigned int> sceneIndices;
+// 上传到GPU的压缩顶点（16字节，交错的8个float为32字节）：位置为相对场景包围盒的16位归一化整数，
+// 着色器中 positionOffset + aPos * positionScale 反量化；法线为 GL_INT_2_10_10_10_REV，纹理坐标为半精度
+struct PackedVertex
+{
+    uint16_t position[4]; // w 未使用，法线按4字节对齐
+    uint32_t normal;
+    uint16_t texCoord[2];
+};
+static_assert(sizeof(PackedVertex) == 16, "one RGBA32UI texel per vertex in the resolve pass");
+glm::vec3 positionOffset(0.0f), positionScale(1.0f);
+// 每个网格的顶点数都不超过65536时（索引相对 baseVertex）使用16位索引
+GLenum sceneIndexType = GL_UNSIGNED_INT;
+unsigned int sceneIndexSize = sizeof(unsigned int);
+std::vector<DrawElementsIndirectCommand> drawCommands; // 本帧可见部件
+unsigned int partTransformVBO = 0;                     // 每个部件的 mat4，实例属性 3-6
+bool frustumCulling = true;                            // C键切换
+
+// 材质纹理，着色器按部件的材质编号采样，不同纹理的部件仍在同一次间接绘制中。
+// 支持 GL_ARB_bindless_texture 时每个材质一个纹理，常驻句柄按材质存入纹理缓冲，着色器由句柄构造采样器；
+// 否则所有材质缩放到 materialArraySize 放入一个纹理数组，材质编号即层号
+std::vector<std::string> materialPaths{"texture.png"}; // 材质0：单模型和未指定纹理的部件
+bool bindlessTextures = false;
+std::vector<unsigned int> materialTextures;            // bindless：每个材质的纹理
+std::vector<GLuint64> materialHandles;                 // bindless：已常驻的句柄，纹理上传前为白色纹理的句柄
+unsigned int whiteTexture = 0;
+GLuint64 whiteHandle = 0;
+unsigned int materialArrayTexture = 0; // 无 bindless 时
+const int materialArraySize = 512;
+size_t pendingMaterialHandles = 0;                             // 还在使用白色纹理句柄的材质数
+unsigned int materialHandleTBO = 0, materialHandleTexture = 0; // 每个材质的句柄，RG32UI
+unsigned int partMaterialTBO = 0, partMaterialTexture = 0;     // 每个部件的材质编号，R32UI
+std::string scenePath;                                 // 命令行 --scene
+unsigned int drawnTriangles = 0;
+
+// 光源UBO，布局与着色器中的 std140 块 Lights 一致（vec3 按16字节对齐）
+struct DirLightData
+{
+    glm::vec3 direction;
+    float pad0;
+    glm::vec3 ambient;
+    float pad1;
+    glm::vec3 diffuse;
+    float pad2;
+    glm::vec3 specular;
+    float pad3;
+};
+struct LightsData
+{
+    DirLightData dirLight;
+};
+static_assert(sizeof(DirLightData) == 64, "std140 layout of the Lights block");
+const unsigned int lightsBinding = 0;
+LightsData lights;
+glcore::UniformBuffer<LightsData> lightsUBO;
+bool lightsDirty = true; // 光源修改后置为true，下一帧上传
+
+// 点光源（数量不限），radius 为衰减到 1/256 以下的距离，超出后不再计算
+struct PointLight
+{
+    glm::vec3 position;
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+    float constant;
+    float linear;
+    float quadratic;
+    float radius;
+};
+std::vector<PointLight> pointLights;
+bool showroomLights = false; // L键切换：额外的展厅光源
+
+// 分簇前向渲染：视锥按屏幕瓦片和对数深度切片划分为簇，每帧在CPU上把点光源分配到簇
+// GL 3.3 没有SSBO，光源数据和簇内光源列表放在纹理缓冲（TBO）中
+const int clusterCountX = 16, clusterCountY = 9, clusterCountZ = 24;
+const float nearPlane = 0.1f, farPlane = 100.0f;
+unsigned int lightDataTBO = 0, lightDataTexture = 0;       // 每个光源4个RGBA32F
+unsigned int clusterGridTBO = 0, clusterGridTexture = 0;   // 每个簇 (offset, count)，RG32UI
+unsigned int lightIndexTBO = 0, lightIndexTexture = 0;     // 簇内光源编号，R32UI
+std::vector<unsigned int> clusterGrid;
+std::vector<unsigned int> clusterLightIndices;
+
+// 阴影：方向光用级联阴影贴图（CSM），3个基础点光源用立方体阴影贴图（展厅光源不投射阴影）。
+// 阴影贴图缓存：点光源只在光源或几何体变化时重绘；级联按放大的包围球拟合，
+// 当前视锥分段仍在缓存的包围球内时沿用，不随相机的每次移动重绘
+const int shadowCascadeCount = 4;
+const int shadowCascadeSize = 2048;
+const float shadowDistance = 40.0f;     // 级联覆盖的最远视距
+const float cascadeSplitLambda = 0.75f; // 对数划分与均匀划分的混合比例
+const float cascadePadding = 1.25f;     // 级联包围球放大比例，越大重绘越少、精度越低
+const int shadowedPointLightCount = 3;
+const int pointShadowSize = 512;
+struct ShadowCascade
+{
+    glm::vec3 center;   // 世界空间包围球（已放大）
+    float radius = 0.0f;
+    glm::mat4 viewProjection;
+    float splitFar;     // 视空间深度上界
+    bool valid = false;
+};
+ShadowCascade shadowCascades[shadowCascadeCount];
+unsigned int shadowProgram = 0;
+unsigned int shadowFBO = 0;
+unsigned int cascadeShadowTexture = 0;                      // 深度纹理数组，每层一个级联
+unsigned int pointShadowTextures[shadowedPointLightCount] = {}; // 深度立方体贴图，存 距离/半径
+bool pointShadowsDirty = true;
+glm::mat4 shadowModel = glm::mat4(0.0f); // 上次绘制阴影时的 model，变化说明几何体移动了
+int shadowPcfQuality = 1;                // P键切换：0 单次硬件比较，1 3x3，2 5x5
+int shadowPassesRendered = 0;            // 本帧重绘的阴影贴图面数
+glm::vec3 sceneBoundsCenter = glm::vec3(0.0f);
+float sceneBoundsRadius = 0.0f;
+struct ShadowUniforms
+{
+    int model;
+    int lightViewProjection;
+    int lightPos;
+    int lightFar;
+    int linearDepth;
+};
+ShadowUniforms shadowUniforms;
+
+// 着色器程序创建时查询的uniform位置
+struct ModelUniforms
+{
+    int model;
+    int view;
+    int projection;
+    int viewPos;
+    int tileSize;
+    int sliceScaleBias;
+    int normalMatrix;
+    int perVertexNormalMatrix;
+    int cascadeMatrices;
+    int cascadeSplits;
+    int cascadeTexelSizes;
+    int pointShadowFar;
+    int pcfQuality;
+};
+ModelUniforms modelUniforms;
+ModelUniforms resolveUniforms;
+
+// 可见性缓冲模式（V键切换）：可见性通道只写 (部件编号+1, 三角形编号)，全屏解析通道按编号取回三角形，
+// 重建重心坐标及其屏幕导数后每个像素只着色一次。GL 3.3 没有SSBO，顶点、索引和部件数据都经纹理缓冲读取
+bool visibilityBufferMode = false;
+bool visibilityBufferSupported = false;
+unsigned int visibilityProgram = 0, resolveProgram = 0;
+unsigned int visibilityFBO = 0, visibilityTexture = 0, visibilityDepth = 0; // RG32UI + 深度，与帧缓冲同尺寸
+int visibilityWidth = 0, visibilityHeight = 0;
+unsigned int resolveVAO = 0;                       // 空VAO，全屏三角形由 gl_VertexID 生成
+unsigned int partIndexVBO = 0;                     // 每个部件的编号，实例属性7
+unsigned int partInfoTBO = 0, partInfoTexture = 0; // 每个部件 (firstIndex, baseVertex)，RG32UI
+unsigned int vertexDataTexture = 0, indexDataTexture = 0, partTransformTexture = 0; // 引用 VBO/EBO/partTransformVBO
+struct VisibilityUniforms
+{
+    int model;
+    int view;
+    int projection;
+};
+VisibilityUniforms visibilityUniforms;
+
+// 遮挡剔除（O键切换）：相机通道画完后，可见部件的包围盒对深度缓冲做遮挡查询，下一帧以查询结果条件渲染该部件。
+// GL_QUERY_NO_WAIT 下结果未就绪时照常绘制，CPU从不等待查询结果；上一帧没有查询的部件（刚进入视锥）无条件绘制
+#ifndef GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+#define GL_ANY_SAMPLES_PASSED_CONSERVATIVE 0x8D6A
+#endif
+bool occlusionCulling = false;
+GLenum occlusionQueryTarget = GL_ANY_SAMPLES_PASSED; // 支持时用保守查询（GL 4.3 / GL_ARB_ES3_compatibility）
+unsigned int boxProgram = 0, boxVAO = 0, boxVBO = 0, boxEBO = 0; // 单位立方体，按部件包围盒缩放
+int boxSceneToClipLocation, boxMinLocation, boxMaxLocation;
+std::vector<unsigned int> occlusionQueries;     // 每个部件一个查询对象
+std::vector<unsigned int> occlusionQueryFrames; // 部件最近一次查询的帧号，0 为从未查询
+unsigned int occlusionFrame = 1;
+std::vector<unsigned int> drawConditions; // 与 drawCommands 一一对应：作为绘制条件的查询，0 为无条件绘制
+
+// GPU分段计时（glcore::GpuTimer）的各段
+enum GpuSection
+{
+    gpuSectionShadow,
+    gpuSectionModel,   // 前向绘制，或可见性通道
+    gpuSectionResolve, // 可见性缓冲解析（前向模式下为空段）
+    gpuSectionUI,
+    gpuSectionCount
+};
+glcore::GpuTimer gpuTimer;
+double gpuTimeSum = 0.0; // 模型绘制（含解析）耗时，每120帧输出一次平均值
+int gpuTimeSamples = 0;
+
+// --bench N：N帧后输出平均值并退出
+int benchFrames = 0;
+int benchFrame = 0;
+bool meshCacheEnabled = true; // --benchmark-load 计时解析时关闭 .meshcache
+double benchCpuSum = 0.0, benchGpuSum[gpuSectionCount] = {};
+double benchDrawSum = 0.0, benchTriangleSum = 0.0;
+bool perVertexNormalMatrix = false; // N键切换：对比顶点着色器中逐顶点 inverse(model) 的耗时
 
 // 视角控制
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 8.0f);
@@ -32,7 +289,7 @@ bool firstMouse = true;
 float yaw = -90.0f, pitch = 0.0f;
 float lastX = 400.0f, lastY = 300.0f;
 float fov = 45.0f;
-float deltaTime = 0.0f, lastFrame = 0.0f;
+glcore::FrameLoop frameLoop; // 帧时间差 frameLoop.deltaTime
 
 // 操作提示文本
 const std::vector<std::string> operationTips = {
@@ -41,6 +298,14 @@ const std::vector<std::string> operationTips = {
     "鼠标拖动：旋转视角",
     "滚轮：缩放视角",
     "ESC：退出程序",
+    "L：切换展厅光源（分簇着色，数量不限）",
+    "N：切换法线矩阵计算方式（对比GPU耗时）",
+    "C：切换视锥剔除",
+    "P：切换阴影PCF质量",
+    "V：切换前向 / 可见性缓冲渲染（对比GPU耗时）",
+    "F：切换交换模式（自适应垂直同步 / 不等待 / 垂直同步）",
+    "T：切换帧率上限（不限 / 刷新率 / 半刷新率）",
+    "K：切换低延迟（交换后等待GPU再读输入）",
     "当前光源：1个方向光 + 3个点光源"};
 
 // 3D模型着色器（包含4个光源：1方向光 + 3点光源）
@@ -49,34 +314,62 @@ const char *vertexShaderSource = R"(
     layout (location = 0) in vec3 aPos;
     layout (location = 1) in vec2 aTexCoord;
     layout (location = 2) in vec3 aNormal;
+    layout (location = 3) in mat4 partTransform; // 部件变换，实例属性（baseInstance 为部件编号）
+    layout (location = 7) in uint partIndex;     // 部件编号，实例属性
 
     uniform mat4 model;
     uniform mat4 view;
     uniform mat4 projection;
+    uniform mat3 normalMatrix;          // CPU上每次绘制计算一次
+    uniform bool perVertexNormalMatrix; // 仅用于计时对比
+    uniform vec3 positionOffset;        // 场景包围盒，aPos 为其中的归一化坐标（见 PackedVertex）
+    uniform vec3 positionScale;
 
     out vec2 TexCoord;
     out vec3 Normal;
     out vec3 FragPos;
+    out float ViewDepth;
+    flat out uint PartIndex;
 
     void main() {
-        gl_Position = projection * view * model * vec4(aPos, 1.0);
-        FragPos = vec3(model * vec4(aPos, 1.0));
-        Normal = mat3(transpose(inverse(model))) * aNormal;
+        mat4 partModel = model * partTransform;
+        vec3 position = positionOffset + aPos * positionScale;
+        vec4 viewPosition = view * partModel * vec4(position, 1.0);
+        gl_Position = projection * viewPosition;
+        ViewDepth = -viewPosition.z;
+        FragPos = vec3(partModel * vec4(position, 1.0));
+        Normal = (perVertexNormalMatrix ? mat3(transpose(inverse(partModel))) : normalMatrix * mat3(partTransform)) * aNormal;
         TexCoord = aTexCoord;
+        PartIndex = partIndex;
     }
 )";
 
-const char *fragmentShaderSource = R"(
+// 着色部分由前向片段着色器和可见性缓冲解析着色器共用，各自的 main 准备好材质和表面后调用 ShadePixel
+// （前向模式来自顶点插值，可见性缓冲模式由解析通道重建）
+// 支持 bindless 纹理时编译前在 #version 之后加入 bindlessShaderHeader
+const char *shadingShaderSource = R"(
     #version 330 core
+    #include "lighting.glsl"
     out vec4 FragColor;
 
-    in vec2 TexCoord;
-    in vec3 Normal;
-    in vec3 FragPos;
-
-    uniform sampler2D texture1;
     uniform vec3 viewPos;
 
+    // 材质纹理：部件的材质编号选择 bindless 句柄或纹理数组的层
+    uniform usamplerBuffer partMaterials;
+#ifdef BINDLESS_TEXTURES
+    uniform usamplerBuffer materialHandles;
+    vec3 SampleMaterial(int part, vec2 uv, vec2 uvDx, vec2 uvDy) {
+        uint material = texelFetch(partMaterials, part).r;
+        return textureGrad(sampler2D(texelFetch(materialHandles, int(material)).xy), uv, uvDx, uvDy).rgb;
+    }
+#else
+    uniform sampler2DArray materialTextures;
+    vec3 SampleMaterial(int part, vec2 uv, vec2 uvDx, vec2 uvDy) {
+        uint material = texelFetch(partMaterials, part).r;
+        return textureGrad(materialTextures, vec3(uv, float(material)), uvDx, uvDy).rgb;
+    }
+#endif
+
     // 方向光（1个）
     struct DirLight {
         vec3 direction;
@@ -84,71 +377,324 @@ const char *fragmentShaderSource = R"(
         vec3 diffuse;
         vec3 specular;
     };
-    uniform DirLight dirLight;
 
-    // 点光源（3个，组成数组）
-    struct PointLight {
-        vec3 position;
-        vec3 ambient;
-        vec3 diffuse;
-        vec3 specular;
-        float constant;
-        float linear;
-        float quadratic;
+    // 光源数据在UBO中，只在光源变化时更新
+    layout(std140) uniform Lights {
+        DirLight dirLight;
     };
-    #define POINT_LIGHT_NUM 3
-    uniform PointLight pointLights[POINT_LIGHT_NUM];
-
-    // 计算方向光贡献
-    vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
-        vec3 lightDir = normalize(-light.direction);
-        // 漫反射
-        float diff = max(dot(normal, lightDir), 0.0);
-        // 镜面反射
-        vec3 reflectDir = reflect(-lightDir, normal);
-        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
-        // 合并分量
-        vec3 ambient = light.ambient * vec3(texture(texture1, TexCoord));
-        vec3 diffuse = light.diffuse * diff * vec3(texture(texture1, TexCoord));
-        vec3 specular = light.specular * spec * vec3(1.0); // 镜面高光用白色
-        return (ambient + diffuse + specular);
-    }
-
-    // 计算单个点光源贡献
-    vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
-        vec3 lightDir = normalize(light.position - fragPos);
-        // 漫反射
-        float diff = max(dot(normal, lightDir), 0.0);
-        // 镜面反射
-        vec3 reflectDir = reflect(-lightDir, normal);
-        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
-        // 衰减计算
-        float distance = length(light.position - fragPos);
-        float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * distance * distance);
-        // 合并分量
-        vec3 ambient = light.ambient * vec3(texture(texture1, TexCoord));
-        vec3 diffuse = light.diffuse * diff * vec3(texture(texture1, TexCoord));
-        vec3 specular = light.specular * spec * vec3(1.0);
-        // 应用衰减
-        ambient *= attenuation;
-        diffuse *= attenuation;
-        specular *= attenuation;
-        return (ambient + diffuse + specular);
+
+    // 点光源：每个4个texel (position, radius) (ambient, constant) (diffuse, linear) (specular, quadratic)
+    uniform samplerBuffer lightData;
+    // 每个簇 (offset, count)，指向 lightIndices 中的一段
+    uniform usamplerBuffer clusterGrid;
+    uniform usamplerBuffer lightIndices;
+    uniform ivec3 clusterCount;
+    uniform vec2 tileSize;       // 瓦片像素大小
+    uniform vec2 sliceScaleBias; // slice = log(depth) * scale + bias
+
+    // 阴影：方向光级联 + 前3个点光源的立方体贴图（存 距离/半径）
+    const int CASCADE_COUNT = 4;
+    const int POINT_SHADOW_COUNT = 3;
+    uniform sampler2DArrayShadow cascadeShadowMap;
+    uniform mat4 cascadeMatrices[CASCADE_COUNT];
+    uniform float cascadeSplits[CASCADE_COUNT];     // 视空间深度上界
+    uniform float cascadeTexelSizes[CASCADE_COUNT]; // 每个纹素的世界空间大小，用于法线偏移
+    uniform samplerCubeShadow pointShadowMaps[POINT_SHADOW_COUNT];
+    uniform float pointShadowFar[POINT_SHADOW_COUNT];
+    uniform int pcfQuality; // 0 单次比较，1 3x3，2 5x5
+
+    float CascadeShadow(Surface surface, float viewDepth, vec3 lightDir) {
+        vec3 normal = surface.normal;
+        int cascade = 0;
+        while (cascade < CASCADE_COUNT && viewDepth > cascadeSplits[cascade])
+            cascade++;
+        if (cascade == CASCADE_COUNT)
+            return 1.0; // 超出阴影距离
+        // 法线偏移随入射角增大，避免阴影粉刺
+        float slope = 1.0 - max(dot(normal, lightDir), 0.0);
+        vec3 offsetPos = surface.position + normal * cascadeTexelSizes[cascade] * (1.0 + 2.0 * slope);
+        vec4 shadowPos = cascadeMatrices[cascade] * vec4(offsetPos, 1.0);
+        vec3 coord = shadowPos.xyz * 0.5 + 0.5;
+        if (coord.z > 1.0)
+            return 1.0;
+        vec2 texel = 1.0 / vec2(textureSize(cascadeShadowMap, 0).xy);
+        int radius = pcfQuality;
+        float lit = 0.0;
+        for (int y = -radius; y <= radius; y++)
+            for (int x = -radius; x <= radius; x++)
+                lit += texture(cascadeShadowMap, vec4(coord.xy + vec2(x, y) * texel, cascade, coord.z));
+        return lit / float((2 * radius + 1) * (2 * radius + 1));
+    }
+
+    // 立方体贴图的 PCF：沿固定的20个方向偏移
+    const vec3 pointShadowOffsets[20] = vec3[](
+        vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1), vec3(-1, 1, 1),
+        vec3(1, 1, -1), vec3(1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+        vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0), vec3(-1, 1, 0),
+        vec3(1, 0, 1), vec3(-1, 0, 1), vec3(1, 0, -1), vec3(-1, 0, -1),
+        vec3(0, 1, 1), vec3(0, -1, 1), vec3(0, -1, -1), vec3(0, 1, -1));
+
+    float SamplePointShadow(int index, vec4 coord) {
+        // GLSL 3.30 的采样器数组只能用常量下标
+        if (index == 0) return texture(pointShadowMaps[0], coord);
+        if (index == 1) return texture(pointShadowMaps[1], coord);
+        return texture(pointShadowMaps[2], coord);
+    }
+
+    float PointShadow(int index, vec3 lightToFrag) {
+        float far = pointShadowFar[index];
+        float distance = length(lightToFrag);
+        float reference = (distance - 0.05 - 0.02 * distance) / far;
+        vec3 direction = lightToFrag / distance;
+        if (pcfQuality == 0)
+            return SamplePointShadow(index, vec4(direction, reference));
+        int taps = pcfQuality == 1 ? 8 : 20;
+        float diskRadius = 0.004 * float(pcfQuality) * (1.0 + distance / far);
+        float lit = 0.0;
+        for (int i = 0; i < taps; i++)
+            lit += SamplePointShadow(index, vec4(direction + pointShadowOffsets[i] * diskRadius, reference));
+        return lit / float(taps);
+    }
+
+    // 方向光
+    LightSample DirLightSample(DirLight light) {
+        return LightSample(normalize(-light.direction), light.ambient, light.diffuse, light.specular, 1.0);
+    }
+
+    // 点光源：超出半径时 attenuation 为0
+    LightSample PointLightSample(int index, vec3 fragPos) {
+        vec4 positionRadius = texelFetch(lightData, index * 4);
+        vec4 ambientConstant = texelFetch(lightData, index * 4 + 1);
+        vec4 diffuseLinear = texelFetch(lightData, index * 4 + 2);
+        vec4 specularQuadratic = texelFetch(lightData, index * 4 + 3);
+        vec3 toLight = positionRadius.xyz - fragPos;
+        float distance = length(toLight);
+        float attenuation = distance > positionRadius.w ? 0.0 : LightAttenuation(vec3(ambientConstant.w, diffuseLinear.w, specularQuadratic.w), distance);
+        return LightSample(toLight / distance, ambientConstant.rgb, diffuseLinear.rgb, specularQuadratic.rgb, attenuation);
+    }
+
+    // 第0个光源为方向光，其后为所在簇的点光源，在同一个循环中累加
+    vec3 ShadePixel(Material material, Surface surface, float viewDepth) {
+        int slice = int(log(viewDepth) * sliceScaleBias.x + sliceScaleBias.y);
+        ivec3 cluster = clamp(ivec3(ivec2(gl_FragCoord.xy / tileSize), slice), ivec3(0), clusterCount - 1);
+        uvec2 range = texelFetch(clusterGrid, (cluster.z * clusterCount.y + cluster.y) * clusterCount.x + cluster.x).xy;
+
+        vec3 result = vec3(0.0);
+        for (uint i = 0u; i <= range.y; i++) {
+            LightSample light;
+            float shadow = 1.0;
+            if (i == 0u) {
+                light = DirLightSample(dirLight);
+                if (FacesLight(surface, light))
+                    shadow = CascadeShadow(surface, viewDepth, light.direction);
+            } else {
+                int index = int(texelFetch(lightIndices, int(range.x + i - 1u)).r);
+                light = PointLightSample(index, surface.position);
+                if (light.attenuation == 0.0)
+                    continue;
+                if (index < POINT_SHADOW_COUNT && FacesLight(surface, light))
+                    shadow = PointShadow(index, surface.position - texelFetch(lightData, index * 4).xyz);
+            }
+            result += ShadeLight(material, surface, light, shadow);
+        }
+        return result;
+    }
+)";
+
+const char *bindlessShaderHeader = "#extension GL_ARB_bindless_texture : require\n#define BINDLESS_TEXTURES\n";
+
+const char *forwardFragmentMainSource = R"(
+    in vec2 TexCoord;
+    in vec3 Normal;
+    in vec3 FragPos;
+    in float ViewDepth;
+    flat in uint PartIndex;
+
+    void main() {
+        // 纹理每个像素只采样一次，镜面高光用白色
+        Material material = Material(SampleMaterial(int(PartIndex), TexCoord, dFdx(TexCoord), dFdy(TexCoord)), vec3(1.0), 32.0);
+        Surface surface = Surface(FragPos, normalize(Normal), normalize(viewPos - FragPos));
+        FragColor = vec4(ShadePixel(material, surface, ViewDepth), 1.0);
+    }
+)";
+
+// 可见性通道：只写部件编号（+1，0 表示背景）和三角形编号
+const char *visibilityVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 3) in mat4 partTransform;
+    layout (location = 7) in uint partIndex; // 部件编号，实例属性
+
+    uniform mat4 model;
+    uniform mat4 view;
+    uniform mat4 projection;
+    uniform vec3 positionOffset;
+    uniform vec3 positionScale;
+
+    flat out uint PartIndex;
+
+    void main() {
+        PartIndex = partIndex;
+        gl_Position = projection * view * (model * partTransform) * vec4(positionOffset + aPos * positionScale, 1.0);
+    }
+)";
+
+const char *visibilityFragmentShaderSource = R"(
+    #version 330 core
+    flat in uint PartIndex;
+
+    out uvec2 VisibilityID;
+
+    void main() {
+        // 多绘制中每条命令的 gl_PrimitiveID 从0开始，即部件内的三角形编号
+        VisibilityID = uvec2(PartIndex + 1u, uint(gl_PrimitiveID));
     }
+)";
 
+// 解析通道：覆盖全屏的三角形
+const char *resolveVertexShaderSource = R"(
+    #version 330 core
     void main() {
-        vec3 norm = normalize(Normal);
-        vec3 viewDir = normalize(viewPos - FragPos);
+        vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+        gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+    }
+)";
+
+// 取回像素所在的三角形，由三个顶点的裁剪坐标解析计算透视校正的重心坐标及其屏幕导数（Wihlidal 的方法），
+// 导数用于 textureGrad，与前向渲染的 mip 选择一致
+const char *resolveFragmentMainSource = R"(
+    uniform usampler2D visibility;
+    uniform usamplerBuffer vertexData;    // 每个顶点1个texel (位置xy, 位置z, 法线, 纹理坐标)，见 PackedVertex
+    uniform usamplerBuffer indexData;     // R16UI 或 R32UI，与场景的索引类型一致
+    uniform samplerBuffer partTransforms; // 每个部件4个texel（mat4 的列）
+    uniform usamplerBuffer partInfo;      // 每个部件 (firstIndex, baseVertex)
+    uniform mat4 model;
+    uniform mat4 view;
+    uniform mat4 projection;
+    uniform mat3 normalMatrix;
+    uniform vec3 positionOffset;
+    uniform vec3 positionScale;
+
+    // GL 3.3 没有 unpackHalf2x16，纹理坐标不会是无穷大或NaN
+    float halfToFloat(uint h) {
+        uint exponent = (h >> 10) & 31u;
+        uint mantissa = h & 1023u;
+        float value = exponent == 0u ? float(mantissa) * exp2(-24.0) : float(mantissa | 1024u) * exp2(float(exponent) - 25.0);
+        return (h & 0x8000u) != 0u ? -value : value;
+    }
 
-        // 1. 方向光贡献
-        vec3 result = CalcDirLight(dirLight, norm, viewDir);
+    // GL_INT_2_10_10_10_REV 的 xyz，符号扩展后归一化
+    vec3 unpackNormal(uint n) {
+        ivec3 v = ivec3(int(n << 22u), int(n << 12u), int(n << 2u)) >> 22;
+        return max(vec3(v) / 511.0, vec3(-1.0));
+    }
 
-        // 2. 3个点光源贡献
-        for(int i = 0; i < POINT_LIGHT_NUM; i++) {
-            result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
+    void main() {
+        uvec2 id = texelFetch(visibility, ivec2(gl_FragCoord.xy), 0).xy;
+        if (id.x == 0u)
+            discard;
+        int part = int(id.x - 1u);
+        uvec2 info = texelFetch(partInfo, part).xy;
+        mat4 partTransform = mat4(texelFetch(partTransforms, part * 4), texelFetch(partTransforms, part * 4 + 1),
+                                  texelFetch(partTransforms, part * 4 + 2), texelFetch(partTransforms, part * 4 + 3));
+        mat4 partModel = model * partTransform;
+        mat4 partToClip = projection * view * partModel;
+
+        // 三个顶点的属性按列存放，乘以重心坐标即为插值结果
+        mat3 positions;
+        mat3x2 uvs;
+        mat3 normals;
+        vec4 clip[3];
+        for (int i = 0; i < 3; i++) {
+            int vertex = int(texelFetch(indexData, int(info.x + id.y * 3u) + i).r + info.y);
+            uvec4 texel = texelFetch(vertexData, vertex);
+            vec3 position = positionOffset + vec3(texel.x & 0xFFFFu, texel.x >> 16, texel.y & 0xFFFFu) / 65535.0 * positionScale;
+            positions[i] = position;
+            uvs[i] = vec2(halfToFloat(texel.w & 0xFFFFu), halfToFloat(texel.w >> 16));
+            normals[i] = unpackNormal(texel.z);
+            clip[i] = partToClip * vec4(position, 1.0);
         }
 
-        FragColor = vec4(result, 1.0);
+        // 屏幕空间中 lambda/w 是线性的：先求其对 NDC 的梯度，再透视校正
+        vec2 viewport = vec2(textureSize(visibility, 0));
+        vec2 pixelNdc = gl_FragCoord.xy / viewport * 2.0 - 1.0;
+        vec3 invW = 1.0 / vec3(clip[0].w, clip[1].w, clip[2].w);
+        vec2 ndc0 = clip[0].xy * invW.x;
+        vec2 ndc1 = clip[1].xy * invW.y;
+        vec2 ndc2 = clip[2].xy * invW.z;
+        float invDet = 1.0 / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+        vec3 ddx = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+        vec3 ddy = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+        float ddxSum = dot(ddx, vec3(1.0));
+        float ddySum = dot(ddy, vec3(1.0));
+        vec2 delta = pixelNdc - ndc0;
+        float interpInvW = invW.x + delta.x * ddxSum + delta.y * ddySum;
+        vec3 lambda = (vec3(invW.x, 0.0, 0.0) + delta.x * ddx + delta.y * ddy) / interpInvW;
+        // 相邻像素的 lambda 之差（NDC 中一个像素为 2/viewport）
+        ddx *= 2.0 / viewport.x;
+        ddy *= 2.0 / viewport.y;
+        ddxSum *= 2.0 / viewport.x;
+        ddySum *= 2.0 / viewport.y;
+        vec3 lambdaDx = (lambda * interpInvW + ddx) / (interpInvW + ddxSum) - lambda;
+        vec3 lambdaDy = (lambda * interpInvW + ddy) / (interpInvW + ddySum) - lambda;
+
+        vec3 worldPos = vec3(partModel * vec4(positions * lambda, 1.0));
+        Material material = Material(SampleMaterial(part, uvs * lambda, uvs * lambdaDx, uvs * lambdaDy), vec3(1.0), 32.0);
+        Surface surface = Surface(worldPos, normalize(normalMatrix * mat3(partTransform) * (normals * lambda)), normalize(viewPos - worldPos));
+        FragColor = vec4(ShadePixel(material, surface, -(view * vec4(worldPos, 1.0)).z), 1.0);
+    }
+)";
+
+// 阴影贴图着色器：级联写入硬件深度，点光源写入 距离/半径
+const char *shadowVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 3) in mat4 partTransform;
+
+    uniform mat4 model;
+    uniform mat4 lightViewProjection;
+    uniform vec3 positionOffset;
+    uniform vec3 positionScale;
+
+    out vec3 WorldPos;
+
+    void main() {
+        vec4 worldPosition = model * partTransform * vec4(positionOffset + aPos * positionScale, 1.0);
+        WorldPos = worldPosition.xyz;
+        gl_Position = lightViewProjection * worldPosition;
+    }
+)";
+
+const char *shadowFragmentShaderSource = R"(
+    #version 330 core
+    in vec3 WorldPos;
+
+    uniform vec3 lightPos;
+    uniform float lightFar;
+    uniform bool linearDepth;
+
+    void main() {
+        gl_FragDepth = linearDepth ? length(WorldPos - lightPos) / lightFar : gl_FragCoord.z;
+    }
+)";
+
+// 遮挡查询的包围盒：只写深度测试结果，不写颜色和深度
+const char *boxVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+
+    uniform mat4 sceneToClip;
+    uniform vec3 boxMin;
+    uniform vec3 boxMax;
+
+    void main() {
+        gl_Position = sceneToClip * vec4(mix(boxMin, boxMax, aPos), 1.0);
+    }
+)";
+
+const char *boxFragmentShaderSource = R"(
+    #version 330 core
+    void main() {
     }
 )";
 
@@ -227,12 +773,13 @@ void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
         fov = 45.0f;
 }
 bool isModelRotating = true;
+void setupPointLights();
 void processInput(GLFWwindow *window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    float cameraSpeed = 2.5f * deltaTime;
+    float cameraSpeed = 2.5f * frameLoop.deltaTime;
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
         cameraPos += cameraSpeed * cameraFront;
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
@@ -246,234 +793,337 @@ void processInput(GLFWwindow *window)
         isModelRotating = !isModelRotating; // 切换旋转状态
         glfwWaitEvents();                   // 避免重复触发
     }
-}
-
-// 加载OBJ模型
-bool loadOBJ(const std::string &path)
-{
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
-
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS)
     {
-        std::cerr << warn << err << std::endl;
-        return false;
+        perVertexNormalMatrix = !perVertexNormalMatrix; // 切换法线矩阵计算方式
+        gpuTimeSum = 0.0;
+        gpuTimeSamples = 0;
+        glfwWaitEvents();
     }
-
-    for (const auto &shape : shapes)
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS)
+    {
+        frustumCulling = !frustumCulling; // 切换视锥剔除
+        glfwWaitEvents();
+    }
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS)
+    {
+        occlusionCulling = !occlusionCulling; // 切换遮挡剔除
+        std::cout << "Occlusion culling: " << (occlusionCulling ? "on" : "off") << std::endl;
+        gpuTimeSum = 0.0;
+        gpuTimeSamples = 0;
+        glfwWaitEvents();
+    }
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)
+    {
+        showroomLights = !showroomLights; // 切换展厅光源
+        setupPointLights();
+        glfwWaitEvents();
+    }
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
+    {
+        shadowPcfQuality = (shadowPcfQuality + 1) % 3; // 切换阴影PCF质量
+        std::cout << "Shadow PCF quality: " << shadowPcfQuality << std::endl;
+        glfwWaitEvents();
+    }
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS)
     {
-        for (const auto &index : shape.mesh.indices)
+        if (visibilityBufferSupported)
         {
-            // 顶点位置
-            vertices.push_back(glm::vec3(
-                attrib.vertices[3 * index.vertex_index + 0],
-                attrib.vertices[3 * index.vertex_index + 1],
-                attrib.vertices[3 * index.vertex_index + 2]));
-            // 纹理坐标
-            if (attrib.texcoords.size() > 0)
-            {
-                texCoords.push_back(glm::vec2(
-                    attrib.texcoords[2 * index.texcoord_index + 0],
-                    1.0f - attrib.texcoords[2 * index.texcoord_index + 1]));
-            }
-            else
-            {
-                texCoords.push_back(glm::vec2(0.0f, 0.0f));
-            }
-            // 法线
-            if (attrib.normals.size() > 0)
-            {
-                normals.push_back(glm::vec3(
-                    attrib.normals[3 * index.normal_index + 0],
-                    attrib.normals[3 * index.normal_index + 1],
-                    attrib.normals[3 * index.normal_index + 2]));
-            }
-            else
-            {
-                normals.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
-            }
-            indices.push_back(indices.size());
+            visibilityBufferMode = !visibilityBufferMode; // 切换前向 / 可见性缓冲
+            std::cout << "Render mode: " << (visibilityBufferMode ? "visibility buffer" : "forward") << std::endl;
+            gpuTimeSum = 0.0;
+            gpuTimeSamples = 0;
         }
+        glfwWaitEvents();
     }
-    return true;
-}
-
-// 加载纹理
-unsigned int loadTexture(const std::string &path)
-{
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    // 纹理参数设置
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // 加载图片
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-    if (data)
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS)
     {
-        GLenum format = (nrChannels == 3) ? GL_RGB : GL_RGBA;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        // 自适应 -> 不等待 -> 垂直同步 -> 自适应
+        glcore::SwapMode next = frameLoop.swapMode == glcore::SwapMode::Adaptive ? glcore::SwapMode::Immediate
+                                : frameLoop.swapMode == glcore::SwapMode::Immediate ? glcore::SwapMode::Vsync
+                                                                                     : glcore::SwapMode::Adaptive;
+        frameLoop.setSwapMode(next);
+        std::cout << "Swap mode: " << glcore::swapModeName(frameLoop.swapMode) << std::endl;
+        glfwWaitEvents();
     }
-    else
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS)
+    {
+        // 不限 -> 刷新率 -> 半刷新率 -> 不限
+        double refreshRate = videoMode->refreshRate;
+        frameLoop.frameRateLimit = frameLoop.frameRateLimit == 0.0 ? refreshRate : frameLoop.frameRateLimit == refreshRate ? refreshRate * 0.5 : 0.0;
+        std::cout << "Frame rate limit: " << frameLoop.frameRateLimit << std::endl;
+        glfwWaitEvents();
+    }
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS)
     {
-        std::cerr << "Failed to load texture: " << path << std::endl;
-        // 若纹理加载失败，创建默认白色纹理
-        unsigned char defaultData[] = {255, 255, 255};
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, defaultData);
+        frameLoop.lowLatency = !frameLoop.lowLatency; // 切换低延迟
+        std::cout << "Low latency: " << (frameLoop.lowLatency ? "on" : "off") << std::endl;
+        glfwWaitEvents();
     }
-    stbi_image_free(data);
-    return texture;
 }
 
-// 编译着色器工具函数
-unsigned int compileShaderProgram(const char *vertSource, const char *fragSource)
+// 索引三元组 -> 顶点编号（tinyobj 与 tinyobj_opt 的 index_t 字段相同）
+struct ObjIndex
+{
+    int vertex_index, texcoord_index, normal_index;
+    bool operator==(const ObjIndex &other) const
+    {
+        return vertex_index == other.vertex_index && texcoord_index == other.texcoord_index && normal_index == other.normal_index;
+    }
+};
+struct ObjIndexHash
 {
-    // 编译顶点着色器
-    unsigned int vertShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertShader, 1, &vertSource, NULL);
-    glCompileShader(vertShader);
-    // 检查顶点着色器编译错误
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertShader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    size_t operator()(const ObjIndex &index) const
     {
-        glGetShaderInfoLog(vertShader, 512, NULL, infoLog);
-        std::cerr << "Vertex Shader Compilation Failed:\n"
-                  << infoLog << std::endl;
+        size_t seed = std::hash<int>()(index.vertex_index);
+        seed ^= std::hash<int>()(index.texcoord_index) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= std::hash<int>()(index.normal_index) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
     }
+};
+
+// 由解析结果构建索引网格：
+// 相同 (位置, 纹理坐标, 法线) 组合的面顶点只保留一份，生成真正的索引网格，
+// 再用 meshoptimizer 重排三角形（顶点缓存命中）和顶点（顺序读取）
+template <typename Attrib, typename IndexList>
+void buildIndexedMesh(const Attrib &attrib, const IndexList &cornerIndices)
+{
+    const size_t cornerCount = cornerIndices.size();
+    std::unordered_map<ObjIndex, unsigned int, ObjIndexHash> uniqueVertices;
+    uniqueVertices.reserve(cornerCount);
+    indices.reserve(cornerCount);
 
-    // 编译片段着色器
-    unsigned int fragShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragShader, 1, &fragSource, NULL);
-    glCompileShader(fragShader);
-    // 检查片段着色器编译错误
-    glGetShaderiv(fragShader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    for (const auto &corner : cornerIndices)
     {
-        glGetShaderInfoLog(fragShader, 512, NULL, infoLog);
-        std::cerr << "Fragment Shader Compilation Failed:\n"
-                  << infoLog << std::endl;
+        ObjIndex index = {corner.vertex_index, corner.texcoord_index, corner.normal_index};
+        auto it = uniqueVertices.find(index);
+        if (it != uniqueVertices.end())
+        {
+            indices.push_back(it->second);
+            continue;
+        }
+        unsigned int vertexIndex = (unsigned int)vertices.size();
+        uniqueVertices.emplace(index, vertexIndex);
+        indices.push_back(vertexIndex);
+
+        // 顶点位置
+        vertices.push_back(glm::vec3(
+            attrib.vertices[3 * index.vertex_index + 0],
+            attrib.vertices[3 * index.vertex_index + 1],
+            attrib.vertices[3 * index.vertex_index + 2]));
+        // 纹理坐标
+        if (attrib.texcoords.size() > 0 && index.texcoord_index >= 0)
+        {
+            texCoords.push_back(glm::vec2(
+                attrib.texcoords[2 * index.texcoord_index + 0],
+                1.0f - attrib.texcoords[2 * index.texcoord_index + 1]));
+        }
+        else
+        {
+            texCoords.push_back(glm::vec2(0.0f, 0.0f));
+        }
+        // 法线
+        if (attrib.normals.size() > 0 && index.normal_index >= 0)
+        {
+            normals.push_back(glm::vec3(
+                attrib.normals[3 * index.normal_index + 0],
+                attrib.normals[3 * index.normal_index + 1],
+                attrib.normals[3 * index.normal_index + 2]));
+        }
+        else
+        {
+            normals.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+        }
     }
 
-    // 链接着色器程序
-    unsigned int program = glCreateProgram();
-    glAttachShader(program, vertShader);
-    glAttachShader(program, fragShader);
-    glLinkProgram(program);
-    // 检查链接错误
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success)
+    if (indices.empty())
     {
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        std::cerr << "Shader Program Linking Failed:\n"
-                  << infoLog << std::endl;
+        return;
     }
 
-    // 删除临时着色器对象
-    glDeleteShader(vertShader);
-    glDeleteShader(fragShader);
-    return program;
+    // 三角形按顶点缓存命中重排，32 为常见的后变换缓存大小
+    const size_t vertexCount = vertices.size();
+    float acmrBefore = meshopt_analyzeVertexCache(indices.data(), indices.size(), vertexCount, 32, 0, 0).acmr;
+    meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), vertexCount);
+    float acmrAfter = meshopt_analyzeVertexCache(indices.data(), indices.size(), vertexCount, 32, 0, 0).acmr;
+
+    // 顶点按首次使用的顺序排列，三个属性数组使用同一个重映射
+    std::vector<unsigned int> remap(vertexCount);
+    meshopt_optimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), vertexCount);
+    meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+    meshopt_remapVertexBuffer(vertices.data(), vertices.data(), vertexCount, sizeof(glm::vec3), remap.data());
+    meshopt_remapVertexBuffer(texCoords.data(), texCoords.data(), vertexCount, sizeof(glm::vec2), remap.data());
+    meshopt_remapVertexBuffer(normals.data(), normals.data(), vertexCount, sizeof(glm::vec3), remap.data());
+
+    std::cout << "模型: " << cornerCount << " 个面顶点合并为 " << vertexCount << " 个顶点, "
+              << indices.size() / 3 << " 个三角形, ACMR " << acmrBefore << " -> " << acmrAfter << std::endl;
 }
 
-// 初始化2D UI
-void initUI()
+// 多线程解析：文件映射到内存后交给 tinyobj_opt 按行分块并行解析
+bool parseOBJMultithreaded(const std::string &path)
 {
-    // 编译UI着色器
-    uiShaderProgram = compileShaderProgram(uiVertexShaderSource, uiFragmentShaderSource);
-
-    // 创建UI顶点缓冲
-    glGenVertexArrays(1, &uiVAO);
-    glGenBuffers(1, &uiVBO);
-    glBindVertexArray(uiVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, uiVBO);
+    size_t length = 0;
+    const char *data = nullptr;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    length = (size_t)fileSize.QuadPart;
+    HANDLE mapping = length ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    data = mapping ? (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file == -1)
+        return false;
+    struct stat fileStat;
+    if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+    {
+        length = (size_t)fileStat.st_size;
+        void *mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, file, 0);
+        data = mapped != MAP_FAILED ? (const char *)mapped : nullptr;
+    }
+#endif
 
-    // 6个顶点组成2个三角形（替代GL_QUADS，核心模式兼容）
-    float uiVertices[] = {
-        // 位置          // 纹理坐标
-        0.0f, 0.0f, 0.0f, 0.0f,     // 左下
-        300.0f, 0.0f, 1.0f, 0.0f,   // 右下
-        300.0f, 200.0f, 1.0f, 1.0f, // 右上
-        0.0f, 0.0f, 0.0f, 0.0f,     // 左下（复用）
-        300.0f, 200.0f, 1.0f, 1.0f, // 右上（复用）
-        0.0f, 200.0f, 0.0f, 1.0f    // 左上
-    };
-    glBufferData(GL_ARRAY_BUFFER, sizeof(uiVertices), uiVertices, GL_STATIC_DRAW);
+    bool result = false;
+    if (data)
+    {
+        tinyobj_opt::attrib_t attrib;
+        std::vector<tinyobj_opt::shape_t> shapes;
+        std::vector<tinyobj_opt::material_t> materials;
+        tinyobj_opt::LoadOption option; // 默认使用全部硬件线程，并三角化
+        result = tinyobj_opt::parseObj(&attrib, &shapes, &materials, data, length, option);
+        if (result)
+        {
+            buildIndexedMesh(attrib, attrib.indices);
+        }
+    }
 
-    // 配置顶点属性
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+#ifdef _WIN32
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    if (data)
+        munmap((void *)data, length);
+    close(file);
+#endif
+    return result;
 }
 
-// 初始化（全屏+4光源配置）
-void init()
+// 单线程解析（tinyobj::LoadObj），多线程解析失败时使用
+bool parseOBJ(const std::string &path)
 {
-    // GLFW初始化
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // 获取主显示器和视频模式（实现全屏）
-    primaryMonitor = glfwGetPrimaryMonitor();
-    videoMode = glfwGetVideoMode(primaryMonitor);
-    glfwWindowHint(GLFW_RED_BITS, videoMode->redBits);
-    glfwWindowHint(GLFW_GREEN_BITS, videoMode->greenBits);
-    glfwWindowHint(GLFW_BLUE_BITS, videoMode->blueBits);
-    glfwWindowHint(GLFW_REFRESH_RATE, videoMode->refreshRate);
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
 
-    // 创建全屏窗口
-    window = glfwCreateWindow(videoMode->width, videoMode->height, "4-Light OBJ Model Viewer", primaryMonitor, NULL);
-    if (window == NULL)
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
     {
-        std::cerr << "Failed to create fullscreen GLFW window" << std::endl;
-        glfwTerminate();
-        return;
+        std::cerr << warn << err << std::endl;
+        return false;
     }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    // GLAD加载
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    std::vector<tinyobj::index_t> cornerIndices;
+    for (const auto &shape : shapes)
     {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        return;
+        cornerIndices.insert(cornerIndices.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
     }
+    buildIndexedMesh(attrib, cornerIndices);
+    return true;
+}
+
+// 网格二进制缓存：OBJ 旁边的 .meshcache 文件，保存最终的交错顶点和索引，
+// 以 OBJ 的大小和修改时间校验，OBJ 变化后自动重建
+const uint32_t meshCacheMagic = 0x4843424f; // "OBCH"
+const uint32_t meshCacheVersion = 1;
+
+struct MeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t vertexFloatCount;
+    uint64_t indexCount;
+};
+
+bool getSourceStamp(const std::string &path, uint64_t &size, int64_t &time)
+{
+    std::error_code ec;
+    size = (uint64_t)std::filesystem::file_size(path, ec);
+    if (ec)
+        return false;
+    time = (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
 
-    // 编译3D模型着色器
-    shaderProgram = compileShaderProgram(vertexShaderSource, fragmentShaderSource);
+bool loadMeshCache(const std::string &path)
+{
+    MeshCacheHeader header = {};
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    std::ifstream file(path + ".meshcache", std::ios::binary);
+    if (!file || !getSourceStamp(path, sourceSize, sourceTime) || !file.read((char *)&header, sizeof(header)))
+        return false;
+    if (header.magic != meshCacheMagic || header.version != meshCacheVersion || header.sourceSize != sourceSize ||
+        header.sourceTime != sourceTime)
+        return false;
 
-    // 加载模型（替换为你的OBJ路径）
-    if (!loadOBJ("model.obj"))
+    vertexData.resize(header.vertexFloatCount);
+    indices.resize(header.indexCount);
+    if (!file.read((char *)vertexData.data(), vertexData.size() * sizeof(float)) ||
+        !file.read((char *)indices.data(), indices.size() * sizeof(unsigned int)))
     {
-        std::cerr << "Failed to load OBJ model (请替换为有效OBJ路径)" << std::endl;
-        // 模型加载失败仍继续运行（显示默认顶点）
+        vertexData.clear();
+        indices.clear();
+        return false;
     }
+    std::cout << "模型: 从缓存 " << path << ".meshcache 读取 " << vertexData.size() / 8 << " 个顶点, "
+              << indices.size() / 3 << " 个三角形" << std::endl;
+    return true;
+}
 
-    // 加载纹理（替换为你的纹理路径，无纹理则使用默认白色纹理）
-    textureID = loadTexture("texture.png");
+void saveMeshCache(const std::string &path)
+{
+    MeshCacheHeader header = {meshCacheMagic, meshCacheVersion, 0, 0, vertexData.size(), indices.size()};
+    if (!getSourceStamp(path, header.sourceSize, header.sourceTime))
+        return;
+    std::ofstream file(path + ".meshcache", std::ios::binary);
+    file.write((const char *)&header, sizeof(header));
+    file.write((const char *)vertexData.data(), vertexData.size() * sizeof(float));
+    file.write((const char *)indices.data(), indices.size() * sizeof(unsigned int));
+    if (!file)
+        std::cerr << "Failed to write mesh cache: " << path << ".meshcache" << std::endl;
+}
 
-    // 绑定3D模型VAO/VBO/EBO
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    glBindVertexArray(VAO);
+// 加载OBJ模型：优先读取二进制缓存，否则解析后写入缓存
+bool loadOBJ(const std::string &path)
+{
+    vertices.clear();
+    texCoords.clear();
+    normals.clear();
+    indices.clear();
+    if (meshCacheEnabled && loadMeshCache(path))
+        return true;
+
+    if (!parseOBJMultithreaded(path))
+    {
+        vertices.clear();
+        texCoords.clear();
+        normals.clear();
+        indices.clear();
+        if (!parseOBJ(path))
+            return false;
+    }
 
     // 合并顶点数据（位置+纹理+法线）
-    std::vector<float> vertexData;
+    vertexData.clear();
+    vertexData.reserve(vertices.size() * 8);
     for (size_t i = 0; i < vertices.size(); i++)
     {
         vertexData.push_back(vertices[i].x);
@@ -485,22 +1135,1511 @@ void init()
         vertexData.push_back(normals[i].y);
         vertexData.push_back(normals[i].z);
     }
+    if (meshCacheEnabled)
+        saveMeshCache(path);
+    return true;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), &vertexData[0], GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-    // 配置顶点属性
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(5 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    // 初始化2D UI和深度测试
-    initUI();
+// --benchmark-load：不创建窗口，计时 loadOBJ 的解析（不读写缓存）与缓存读取，
+// 取中位数，以 vk_mini_samples_benchmarks 相同的 JSON 格式写入 jsonPath
+int benchmarkLoad(const std::string &path, int iterations, const std::string &jsonPath)
+{
+    struct Result
+    {
+        const char *name;
+        size_t items;
+        std::vector<double> times;
+    };
+    Result results[] = {{"loadOBJ/parse", 0, {}}, {"loadOBJ/meshcache", 0, {}}};
+    for (int r = 0; r < 2; r++)
+    {
+        meshCacheEnabled = r == 1;
+        if (meshCacheEnabled)
+            saveMeshCache(path); // 缓存由上一次解析的结果写入
+        for (int i = 0; i < iterations; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (!loadOBJ(path))
+            {
+                std::cerr << "Failed to load " << path << std::endl;
+                return 1;
+            }
+            results[r].times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        }
+        results[r].items = vertexData.size() / 8;
+        std::sort(results[r].times.begin(), results[r].times.end());
+    }
+
+    std::ofstream json(jsonPath);
+    json << "{\n  \"cpuThreads\": " << std::thread::hardware_concurrency() << ",\n  \"benchmarks\": [";
+    for (int r = 0; r < 2; r++)
+    {
+        json << (r ? ",\n" : "\n") << "    {\"name\": \"" << results[r].name << "\", \"items\": " << results[r].items
+             << ", \"iterations\": " << iterations << ", \"medianNs\": " << std::fixed << std::setprecision(1)
+             << results[r].times[iterations / 2] << ", \"minNs\": " << results[r].times.front() << "}";
+    }
+    json << "\n  ]\n}" << std::endl;
+    if (!json)
+    {
+        std::cerr << "Failed to write " << jsonPath << std::endl;
+        return 1;
+    }
+    std::cout << "loadOBJ: parse " << results[0].times[iterations / 2] * 1e-6 << " ms, meshcache "
+              << results[1].times[iterations / 2] * 1e-6 << " ms, written to " << jsonPath << std::endl;
+    return 0;
+}
+
+// 追加一个包围盒，补齐部分用空包围盒（min > max），其结果在剔除时丢弃
+void addCullingBox(CullingBoxes &boxes, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+    size_t padded = (boxes.count + 8) & ~size_t(7);
+    boxes.minX.resize(padded, FLT_MAX);
+    boxes.minY.resize(padded, FLT_MAX);
+    boxes.minZ.resize(padded, FLT_MAX);
+    boxes.maxX.resize(padded, -FLT_MAX);
+    boxes.maxY.resize(padded, -FLT_MAX);
+    boxes.maxZ.resize(padded, -FLT_MAX);
+    boxes.minX[boxes.count] = boundsMin.x;
+    boxes.minY[boxes.count] = boundsMin.y;
+    boxes.minZ[boxes.count] = boundsMin.z;
+    boxes.maxX[boxes.count] = boundsMax.x;
+    boxes.maxY[boxes.count] = boundsMax.y;
+    boxes.maxZ[boxes.count] = boundsMax.z;
+    boxes.count++;
+}
+
+// 每个平面取包围盒沿法线方向最远的顶点（按法线分量的符号选 min 或 max 数组），
+// 该顶点在平面外侧则整个包围盒在视锥外
+void cullBoxesScalar(const glm::vec4 planes[6], const CullingBoxes &boxes, std::vector<unsigned int> &visible)
+{
+    for (size_t i = 0; i < boxes.count; i++)
+    {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++)
+        {
+            float x = planes[p].x > 0.0f ? boxes.maxX[i] : boxes.minX[i];
+            float y = planes[p].y > 0.0f ? boxes.maxY[i] : boxes.minY[i];
+            float z = planes[p].z > 0.0f ? boxes.maxZ[i] : boxes.minZ[i];
+            inside = planes[p].x * x + planes[p].y * y + planes[p].z * z + planes[p].w >= 0.0f;
+        }
+        if (inside)
+            visible.push_back((unsigned int)i);
+    }
+}
+
+#ifdef CULLING_X86
+#if defined(__GNUC__) || defined(__clang__)
+#define CULLING_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CULLING_TARGET_AVX2
+#endif
+
+// 掩码最低位1的位置
+inline int lowestBit(int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, (unsigned long)mask);
+    return (int)index;
+#else
+    return __builtin_ctz((unsigned int)mask);
+#endif
+}
+
+bool cpuSupportsAVX2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    return avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// 4个包围盒一组（SSE，x86-64的基线）
+void cullBoxesSSE(const glm::vec4 planes[6], const CullingBoxes &boxes, std::vector<unsigned int> &visible)
+{
+    for (size_t i = 0; i < boxes.count; i += 4)
+    {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 x = _mm_loadu_ps(&(planes[p].x > 0.0f ? boxes.maxX : boxes.minX)[i]);
+            __m128 y = _mm_loadu_ps(&(planes[p].y > 0.0f ? boxes.maxY : boxes.minY)[i]);
+            __m128 z = _mm_loadu_ps(&(planes[p].z > 0.0f ? boxes.maxZ : boxes.minZ)[i]);
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), x), _mm_mul_ps(_mm_set1_ps(planes[p].y), y)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), z), _mm_set1_ps(planes[p].w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+        }
+        for (int mask = _mm_movemask_ps(inside); mask; mask &= mask - 1)
+        {
+            size_t index = i + lowestBit(mask);
+            if (index < boxes.count)
+                visible.push_back((unsigned int)index);
+        }
+    }
+}
+
+// 8个包围盒一组（AVX2），运行时检测CPU支持
+CULLING_TARGET_AVX2 void cullBoxesAVX2(const glm::vec4 planes[6], const CullingBoxes &boxes, std::vector<unsigned int> &visible)
+{
+    for (size_t i = 0; i < boxes.count; i += 8)
+    {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 x = _mm256_loadu_ps(&(planes[p].x > 0.0f ? boxes.maxX : boxes.minX)[i]);
+            __m256 y = _mm256_loadu_ps(&(planes[p].y > 0.0f ? boxes.maxY : boxes.minY)[i]);
+            __m256 z = _mm256_loadu_ps(&(planes[p].z > 0.0f ? boxes.maxZ : boxes.minZ)[i]);
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].x), x), _mm256_mul_ps(_mm256_set1_ps(planes[p].y), y)),
+                                            _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].z), z), _mm256_set1_ps(planes[p].w)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        for (int mask = _mm256_movemask_ps(inside); mask; mask &= mask - 1)
+        {
+            size_t index = i + lowestBit(mask);
+            if (index < boxes.count)
+                visible.push_back((unsigned int)index);
+        }
+    }
+}
+#endif
+
+// 视锥剔除：结果为可见包围盒的编号（升序）
+void cullBoxes(const glm::vec4 planes[6], const CullingBoxes &boxes, std::vector<unsigned int> &visible)
+{
+    visible.clear();
+#ifdef CULLING_X86
+    static const bool avx2 = cpuSupportsAVX2();
+    if (avx2)
+        cullBoxesAVX2(planes, boxes, visible);
+    else
+        cullBoxesSSE(planes, boxes, visible);
+#else
+    cullBoxesScalar(planes, boxes, visible);
+#endif
+}
+
+// 把一个OBJ追加到场景缓冲，同一个文件只加载一次，失败返回-1
+int addSceneMesh(const std::string &path, std::unordered_map<std::string, int> &loadedMeshes)
+{
+    auto it = loadedMeshes.find(path);
+    if (it != loadedMeshes.end())
+        return it->second;
+
+    int meshIndex = -1;
+    if (loadOBJ(path) && !indices.empty())
+    {
+        SceneMesh mesh;
+        mesh.baseVertex = (unsigned int)(sceneVertexData.size() / 8);
+        mesh.firstIndex = (unsigned int)sceneIndices.size();
+        mesh.indexCount = (unsigned int)indices.size();
+        mesh.boundsMin = glm::vec3(FLT_MAX);
+        mesh.boundsMax = glm::vec3(-FLT_MAX);
+        for (size_t i = 0; i < vertexData.size(); i += 8)
+        {
+            glm::vec3 position(vertexData[i], vertexData[i + 1], vertexData[i + 2]);
+            mesh.boundsMin = glm::min(mesh.boundsMin, position);
+            mesh.boundsMax = glm::max(mesh.boundsMax, position);
+        }
+        sceneVertexData.insert(sceneVertexData.end(), vertexData.begin(), vertexData.end());
+        sceneIndices.insert(sceneIndices.end(), indices.begin(), indices.end());
+        meshIndex = (int)sceneMeshes.size();
+        sceneMeshes.push_back(mesh);
+    }
+    else
+    {
+        std::cerr << "Failed to load OBJ model: " << path << std::endl;
+    }
+    loadedMeshes[path] = meshIndex;
+    return meshIndex;
+}
+
+void addScenePart(unsigned int mesh, const glm::mat4 &transform, unsigned int material = 0)
+{
+    ScenePart part;
+    part.mesh = mesh;
+    part.transform = transform;
+    part.material = material;
+    sceneParts.push_back(part);
+
+    glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const SceneMesh &sceneMesh = sceneMeshes[mesh];
+        glm::vec3 local((corner & 1) ? sceneMesh.boundsMax.x : sceneMesh.boundsMin.x,
+                        (corner & 2) ? sceneMesh.boundsMax.y : sceneMesh.boundsMin.y,
+                        (corner & 4) ? sceneMesh.boundsMax.z : sceneMesh.boundsMin.z);
+        glm::vec3 world = glm::vec3(transform * glm::vec4(local, 1.0f));
+        boundsMin = glm::min(boundsMin, world);
+        boundsMax = glm::max(boundsMax, world);
+    }
+    addCullingBox(partBounds, boundsMin, boundsMax);
+}
+
+// 场景文件每行一个部件：OBJ路径 x y z [绕Y轴旋转角度] [缩放] [纹理路径]，#开头为注释
+// 纹理路径相同的部件共用材质
+unsigned int addMaterial(const std::string &path)
+{
+    auto it = std::find(materialPaths.begin(), materialPaths.end(), path);
+    if (it != materialPaths.end())
+        return (unsigned int)(it - materialPaths.begin());
+    materialPaths.push_back(path);
+    return (unsigned int)materialPaths.size() - 1;
+}
+
+bool loadScene(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open scene: " << path << std::endl;
+        return false;
+    }
+    std::unordered_map<std::string, int> loadedMeshes;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string objPath;
+        glm::vec3 position(0.0f);
+        float angle = 0.0f, scale = 1.0f;
+        std::string texturePath;
+        if (!(stream >> objPath) || objPath[0] == '#')
+            continue;
+        stream >> position.x >> position.y >> position.z >> angle >> scale >> texturePath;
+
+        int mesh = addSceneMesh(objPath, loadedMeshes);
+        if (mesh < 0)
+            continue;
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+        transform = glm::rotate(transform, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
+        transform = glm::scale(transform, glm::vec3(scale));
+        addScenePart(mesh, transform, texturePath.empty() ? 0 : addMaterial(texturePath));
+    }
+    std::cout << "场景: " << sceneParts.size() << " 个部件, " << sceneMeshes.size() << " 个网格, "
+              << materialPaths.size() << " 个材质, " << sceneIndices.size() / 3 << " 个三角形" << std::endl;
+    return !sceneParts.empty();
+}
+
+// 初始化2D UI
+void initUI()
+{
+    // 编译UI着色器
+    uiShaderProgram = glcore::compileShaderProgram(uiVertexShaderSource, uiFragmentShaderSource);
+
+    // 创建UI顶点缓冲
+    glGenVertexArrays(1, &uiVAO);
+    glGenBuffers(1, &uiVBO);
+    glBindVertexArray(uiVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, uiVBO);
+
+    // 6个顶点组成2个三角形（替代GL_QUADS，核心模式兼容）
+    float uiVertices[] = {
+        // 位置          // 纹理坐标
+        0.0f, 0.0f, 0.0f, 0.0f,     // 左下
+        300.0f, 0.0f, 1.0f, 0.0f,   // 右下
+        300.0f, 200.0f, 1.0f, 1.0f, // 右上
+        0.0f, 0.0f, 0.0f, 0.0f,     // 左下（复用）
+        300.0f, 200.0f, 1.0f, 1.0f, // 右上（复用）
+        0.0f, 200.0f, 0.0f, 1.0f    // 左上
+    };
+    glBufferData(GL_ARRAY_BUFFER, sizeof(uiVertices), uiVertices, GL_STATIC_DRAW);
+
+    // 配置顶点属性
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    uiProjectionLocation = glGetUniformLocation(uiShaderProgram, "projection");
+    uiTextColorLocation = glGetUniformLocation(uiShaderProgram, "textColor");
+    uiAlphaLocation = glGetUniformLocation(uiShaderProgram, "alpha");
+
+    // HUD文字：stb_easy_font 每个顶点16字节（x, y, z, 颜色），四边形用索引拆成三角形
+    glGenVertexArrays(1, &uiTextVAO);
+    glGenBuffers(1, &uiTextVBO);
+    glGenBuffers(1, &uiTextEBO);
+    glBindVertexArray(uiTextVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, uiTextVBO);
+    glBufferData(GL_ARRAY_BUFFER, uiTextMaxQuads * 64, NULL, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 16, (void *)0);
+    glEnableVertexAttribArray(0);
+    std::vector<unsigned int> quadIndices;
+    for (unsigned int quad = 0; quad < (unsigned int)uiTextMaxQuads; quad++)
+    {
+        unsigned int first = quad * 4;
+        unsigned int corners[] = {first, first + 1, first + 2, first, first + 2, first + 3};
+        quadIndices.insert(quadIndices.end(), corners, corners + 6);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, uiTextEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, quadIndices.size() * sizeof(unsigned int), quadIndices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+// 左上角HUD：CPU帧时间、GPU分段时间、绘制统计
+void drawHUD(int width, int height)
+{
+    char text[512];
+    snprintf(text, sizeof(text),
+             "CPU frame: %.2f ms\nGPU shadow: %.2f ms  model: %.2f ms  resolve: %.2f ms  UI: %.2f ms\nMode: %s  Occlusion culling: %s\nDraws: %zu  Parts: %zu / %zu\nTriangles: %u\nShadow maps redrawn: %d  PCF: %d\nSwap: %s  Limit: %.0f fps  Low latency: %s",
+             frameLoop.deltaTime * 1000.0f, gpuTimer.getMs(gpuSectionShadow), gpuTimer.getMs(gpuSectionModel), gpuTimer.getMs(gpuSectionResolve), gpuTimer.getMs(gpuSectionUI),
+             visibilityBufferMode ? "visibility buffer" : "forward", occlusionCulling ? "on" : "off", drawCommands.size(), visibleParts.size(), sceneParts.size(), drawnTriangles, shadowPassesRendered, shadowPcfQuality,
+             glcore::swapModeName(frameLoop.swapMode), frameLoop.frameRateLimit, frameLoop.lowLatency ? "on" : "off");
+
+    static char textVertices[uiTextMaxQuads * 64];
+    unsigned char color[4] = {255, 255, 255, 255};
+    int quads = stb_easy_font_print(4.0f, 4.0f, text, color, textVertices, sizeof(textVertices));
+    const float textScale = 2.0f;
+    float panelWidth = (stb_easy_font_width(text) + 8.0f) * textScale;
+    float panelHeight = (stb_easy_font_height(text) + 8.0f) * textScale;
+
+    glDisable(GL_DEPTH_TEST);
+    glUseProgram(uiShaderProgram);
+
+    // 背景：uiVAO 是 300x200 的四边形，缩放到文字大小
+    glm::mat4 screen = glm::ortho(0.0f, (float)width, (float)height, 0.0f);
+    glm::mat4 panel = glm::scale(screen, glm::vec3(panelWidth / 300.0f, panelHeight / 200.0f, 1.0f));
+    glUniformMatrix4fv(uiProjectionLocation, 1, GL_FALSE, glm::value_ptr(panel));
+    glUniform3f(uiTextColorLocation, 0.0f, 0.0f, 0.0f);
+    glUniform1f(uiAlphaLocation, 0.5f);
+    glBindVertexArray(uiVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    glm::mat4 textProjection = glm::scale(screen, glm::vec3(textScale, textScale, 1.0f));
+    glUniformMatrix4fv(uiProjectionLocation, 1, GL_FALSE, glm::value_ptr(textProjection));
+    glUniform3f(uiTextColorLocation, 1.0f, 1.0f, 1.0f);
+    glUniform1f(uiAlphaLocation, 1.0f);
+    glBindVertexArray(uiTextVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, uiTextVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, quads * 64, textVertices);
+    glDrawElements(GL_TRIANGLES, quads * 6, GL_UNSIGNED_INT, 0);
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+// --bench：累计每帧数据，N帧后输出平均值并退出
+void updateBench()
+{
+    // 前几帧还没有GPU计时结果，不计入
+    if (benchFrames <= 0 || gpuTimer.frame <= glcore::GpuTimer::frameLatency)
+        return;
+    benchCpuSum += frameLoop.deltaTime * 1000.0;
+    for (int section = 0; section < gpuSectionCount; section++)
+        benchGpuSum[section] += gpuTimer.getMs(section);
+    benchDrawSum += drawCommands.size();
+    benchTriangleSum += drawnTriangles;
+    if (++benchFrame < benchFrames)
+        return;
+
+    std::cout << "Benchmark (" << benchFrames << " frames, " << (visibilityBufferMode ? "visibility buffer" : "forward") << "): CPU frame " << benchCpuSum / benchFrames << " ms, GPU shadow "
+              << benchGpuSum[gpuSectionShadow] / benchFrames << " ms, GPU model " << benchGpuSum[gpuSectionModel] / benchFrames << " ms, GPU resolve " << benchGpuSum[gpuSectionResolve] / benchFrames
+              << " ms, GPU UI " << benchGpuSum[gpuSectionUI] / benchFrames << " ms, "
+              << benchDrawSum / benchFrames << " draws, " << benchTriangleSum / benchFrames << " triangles" << std::endl;
+    glfwSetWindowShouldClose(window, true);
+}
+
+// 衰减 1/(c + l*d + q*d^2) 乘以最亮分量降到 1/256 时的距离
+float computeLightRadius(const PointLight &light)
+{
+    float maxIntensity = std::max({light.ambient.r, light.ambient.g, light.ambient.b,
+                                   light.diffuse.r, light.diffuse.g, light.diffuse.b,
+                                   light.specular.r, light.specular.g, light.specular.b});
+    float c = light.constant - 256.0f * maxIntensity;
+    if (c >= 0.0f)
+    {
+        return 0.0f;
+    }
+    if (light.quadratic > 0.0f)
+    {
+        return (-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+    }
+    return light.linear > 0.0f ? -c / light.linear : farPlane;
+}
+
+void addPointLight(glm::vec3 position, glm::vec3 color, float constant, float linear, float quadratic)
+{
+    PointLight light;
+    light.position = position;
+    light.ambient = color * 0.2f;
+    light.diffuse = color * 0.8f;
+    light.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    light.constant = constant;
+    light.linear = linear;
+    light.quadratic = quadratic;
+    light.radius = computeLightRadius(light);
+    pointLights.push_back(light);
+}
+
+// 3个基础点光源，开启展厅光源时再加一圈圈小范围彩色光源
+void setupPointLights()
+{
+    pointLights.clear();
+    // 右侧红光、左侧绿光、上方蓝光
+    addPointLight(glm::vec3(5.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1.0f, 0.09f, 0.032f);
+    addPointLight(glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 1.0f, 0.09f, 0.032f);
+    addPointLight(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 1.0f, 0.09f, 0.032f);
+
+    if (showroomLights)
+    {
+        const int rings = 8, lightsPerRing = 32;
+        for (int ring = 0; ring < rings; ring++)
+        {
+            for (int i = 0; i < lightsPerRing; i++)
+            {
+                float angle = glm::two_pi<float>() * (i + 0.5f * ring) / lightsPerRing;
+                float radius = 2.0f + 0.5f * ring;
+                glm::vec3 position(radius * std::cos(angle), -2.0f + 0.6f * ring, radius * std::sin(angle));
+                glm::vec3 color(0.5f + 0.5f * std::cos(angle), 0.5f + 0.5f * std::cos(angle + 2.094f), 0.5f + 0.5f * std::cos(angle + 4.189f));
+                addPointLight(position, color * 0.15f, 1.0f, 0.7f, 1.8f);
+            }
+        }
+    }
+    lightsDirty = true;
+    pointShadowsDirty = true;
+}
+
+// 创建纹理缓冲及其缓冲纹理
+void createTextureBuffer(unsigned int &buffer, unsigned int &texture, GLenum format)
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_DYNAMIC_DRAW);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+}
+
+// 配置光源，创建光源UBO和分簇用的纹理缓冲
+void initLights()
+{
+    // 1. 方向光（第1个光源）
+    lights.dirLight.direction = glm::vec3(-0.5f, -1.0f, -0.3f);
+    lights.dirLight.ambient = glm::vec3(0.2f, 0.2f, 0.2f);
+    lights.dirLight.diffuse = glm::vec3(0.5f, 0.5f, 0.5f);
+    lights.dirLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+
+    // 2. 点光源
+    setupPointLights();
+
+    lightsUBO.init(lightsBinding);
+
+    createTextureBuffer(lightDataTBO, lightDataTexture, GL_RGBA32F);
+    createTextureBuffer(clusterGridTBO, clusterGridTexture, GL_RG32UI);
+    createTextureBuffer(lightIndexTBO, lightIndexTexture, GL_R32UI);
+    clusterGrid.resize(clusterCountX * clusterCountY * clusterCountZ * 2);
+
+    // 纹理单元：0 材质纹理数组，13-14 材质编号和句柄，1-3 分簇数据（前向与解析程序相同）
+    for (unsigned int program : {shaderProgram, resolveProgram})
+    {
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "materialTextures"), 0);
+        glUniform1i(glGetUniformLocation(program, "partMaterials"), 13);
+        glUniform1i(glGetUniformLocation(program, "materialHandles"), 14);
+        glUniform1i(glGetUniformLocation(program, "lightData"), 1);
+        glUniform1i(glGetUniformLocation(program, "clusterGrid"), 2);
+        glUniform1i(glGetUniformLocation(program, "lightIndices"), 3);
+        glUniform3i(glGetUniformLocation(program, "clusterCount"), clusterCountX, clusterCountY, clusterCountZ);
+    }
+}
+
+// 上传点光源数据（光源变化时）
+void uploadPointLights()
+{
+    std::vector<glm::vec4> texels;
+    texels.reserve(pointLights.size() * 4);
+    for (const PointLight &light : pointLights)
+    {
+        texels.push_back(glm::vec4(light.position, light.radius));
+        texels.push_back(glm::vec4(light.ambient, light.constant));
+        texels.push_back(glm::vec4(light.diffuse, light.linear));
+        texels.push_back(glm::vec4(light.specular, light.quadratic));
+    }
+    if (texels.empty())
+    {
+        texels.push_back(glm::vec4(0.0f));
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, lightDataTBO);
+    glBufferData(GL_TEXTURE_BUFFER, texels.size() * sizeof(glm::vec4), texels.data(), GL_DYNAMIC_DRAW);
+}
+
+// 深度所在的切片，切片按对数划分，近处更细
+int depthToSlice(float depth)
+{
+    float slice = std::log(depth / nearPlane) * clusterCountZ / std::log(farPlane / nearPlane);
+    return std::clamp((int)slice, 0, clusterCountZ - 1);
+}
+
+// 把点光源分配到与其包围球相交的簇，并上传簇表
+void buildClusters(const glm::mat4 &view, const glm::mat4 &projection)
+{
+    // 每个光源覆盖的簇范围（保守：用视空间包围盒投影到屏幕）
+    struct ClusterRange
+    {
+        int minX, minY, minZ, maxX, maxY, maxZ;
+    };
+    std::vector<ClusterRange> ranges;
+    std::vector<unsigned int> rangeLights;
+    std::fill(clusterGrid.begin(), clusterGrid.end(), 0u);
+    for (unsigned int i = 0; i < pointLights.size(); i++)
+    {
+        const PointLight &light = pointLights[i];
+        glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        float minDepth = -center.z - light.radius;
+        float maxDepth = -center.z + light.radius;
+        if (light.radius <= 0.0f || maxDepth < nearPlane || minDepth > farPlane)
+        {
+            continue;
+        }
+
+        ClusterRange range = {0, 0, depthToSlice(std::max(minDepth, nearPlane)), clusterCountX - 1, clusterCountY - 1, depthToSlice(maxDepth)};
+        if (minDepth > nearPlane)
+        {
+            glm::vec2 ndcMin(1.0f), ndcMax(-1.0f);
+            for (int corner = 0; corner < 8; corner++)
+            {
+                glm::vec3 offset((corner & 1) ? light.radius : -light.radius, (corner & 2) ? light.radius : -light.radius, (corner & 4) ? light.radius : -light.radius);
+                glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f)
+            {
+                continue;
+            }
+            range.minX = std::clamp((int)((ndcMin.x * 0.5f + 0.5f) * clusterCountX), 0, clusterCountX - 1);
+            range.maxX = std::clamp((int)((ndcMax.x * 0.5f + 0.5f) * clusterCountX), 0, clusterCountX - 1);
+            range.minY = std::clamp((int)((ndcMin.y * 0.5f + 0.5f) * clusterCountY), 0, clusterCountY - 1);
+            range.maxY = std::clamp((int)((ndcMax.y * 0.5f + 0.5f) * clusterCountY), 0, clusterCountY - 1);
+        }
+        ranges.push_back(range);
+        rangeLights.push_back(i);
+
+        // 第一遍：统计每个簇的光源数
+        for (int z = range.minZ; z <= range.maxZ; z++)
+            for (int y = range.minY; y <= range.maxY; y++)
+                for (int x = range.minX; x <= range.maxX; x++)
+                    clusterGrid[((z * clusterCountY + y) * clusterCountX + x) * 2 + 1]++;
+    }
+
+    // 前缀和得到每个簇的起始位置
+    unsigned int offset = 0;
+    for (size_t cluster = 0; cluster < clusterGrid.size(); cluster += 2)
+    {
+        clusterGrid[cluster] = offset;
+        offset += clusterGrid[cluster + 1];
+        clusterGrid[cluster + 1] = 0;
+    }
+
+    // 第二遍：填充光源编号
+    clusterLightIndices.resize(std::max(offset, 1u));
+    for (size_t r = 0; r < ranges.size(); r++)
+    {
+        const ClusterRange &range = ranges[r];
+        for (int z = range.minZ; z <= range.maxZ; z++)
+            for (int y = range.minY; y <= range.maxY; y++)
+                for (int x = range.minX; x <= range.maxX; x++)
+                {
+                    unsigned int *cluster = &clusterGrid[((z * clusterCountY + y) * clusterCountX + x) * 2];
+                    clusterLightIndices[cluster[0] + cluster[1]++] = rangeLights[r];
+                }
+    }
+
+    // 每帧重新分配存储，避免等待上一帧的读取
+    glBindBuffer(GL_TEXTURE_BUFFER, clusterGridTBO);
+    glBufferData(GL_TEXTURE_BUFFER, clusterGrid.size() * sizeof(unsigned int), clusterGrid.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, lightIndexTBO);
+    glBufferData(GL_TEXTURE_BUFFER, clusterLightIndices.size() * sizeof(unsigned int), clusterLightIndices.data(), GL_STREAM_DRAW);
+}
+
+// 多绘制间接（GL_ARB_multi_draw_indirect + GL_ARB_base_instance）和持久映射（GL_ARB_buffer_storage）
+// glad只生成了3.3，函数手动加载；不支持时每个部件一次 glDrawElementsBaseVertex
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void(APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+typedef void(APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC multiDrawElementsIndirect = nullptr;
+PFNGLBUFFERSTORAGEPROC bufferStorage = nullptr;
+// GL_ARB_bindless_texture，同样手动加载
+typedef GLuint64(APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void(APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void(APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+PFNGLGETTEXTUREHANDLEARBPROC getTextureHandle = nullptr;
+PFNGLMAKETEXTUREHANDLERESIDENTARBPROC makeTextureHandleResident = nullptr;
+PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC makeTextureHandleNonResident = nullptr;
+// 每帧的场景绘制：级联 + 点光源立方体的6个面 + 相机
+const int sceneDrawsPerFrame = shadowCascadeCount + shadowedPointLightCount * 6 + 1;
+const int indirectRingSize = 3 * sceneDrawsPerFrame; // 间接命令缓冲按绘制分段轮流写入（约3帧），围栏保证GPU已读完
+unsigned int indirectBuffer = 0;
+DrawElementsIndirectCommand *indirectCommands = nullptr; // 持久映射的地址
+GLsync indirectFences[indirectRingSize] = {};
+unsigned int indirectFrame = 0;
+
+// 压缩场景顶点，位置的反量化参数为所有网格顶点的包围盒
+std::vector<PackedVertex> packSceneVertices()
+{
+    const size_t vertexCount = sceneVertexData.size() / 8;
+    glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 position = glm::make_vec3(&sceneVertexData[i * 8]);
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+    positionOffset = vertexCount ? boundsMin : glm::vec3(0.0f);
+    positionScale = vertexCount ? boundsMax - boundsMin : glm::vec3(1.0f);
+    // 平面网格在某一轴上没有厚度
+    positionScale = glm::max(positionScale, glm::vec3(FLT_MIN));
+
+    std::vector<PackedVertex> packed(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const float *v = &sceneVertexData[i * 8];
+        glm::vec3 position = (glm::make_vec3(v) - positionOffset) / positionScale;
+        glm::vec3 normal = glm::make_vec3(v + 5);
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : normal;
+
+        PackedVertex &vertex = packed[i];
+        for (int c = 0; c < 3; c++)
+        {
+            vertex.position[c] = (uint16_t)meshopt_quantizeUnorm(position[c], 16);
+        }
+        vertex.position[3] = 0;
+        vertex.normal = (uint32_t(meshopt_quantizeSnorm(normal.x, 10)) & 1023u) |
+                        ((uint32_t(meshopt_quantizeSnorm(normal.y, 10)) & 1023u) << 10) |
+                        ((uint32_t(meshopt_quantizeSnorm(normal.z, 10)) & 1023u) << 20);
+        vertex.texCoord[0] = meshopt_quantizeHalf(v[3]);
+        vertex.texCoord[1] = meshopt_quantizeHalf(v[4]);
+    }
+    return packed;
+}
+
+// 场景顶点位置的反量化参数（packSceneVertices），各个绘制场景的程序都需要
+void setPositionDequantization(unsigned int program)
+{
+    glUseProgram(program);
+    glUniform3fv(glGetUniformLocation(program, "positionOffset"), 1, glm::value_ptr(positionOffset));
+    glUniform3fv(glGetUniformLocation(program, "positionScale"), 1, glm::value_ptr(positionScale));
+}
+
+// 上传场景的合并缓冲，配置部件变换实例属性和间接命令缓冲
+void initSceneBuffers()
+{
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glBindVertexArray(VAO);
+
+    // sceneVertexData 由各个OBJ拼接而成（位置+纹理+法线），压缩后上传
+    std::vector<PackedVertex> packedVertices = packSceneVertices();
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, packedVertices.size() * sizeof(PackedVertex), packedVertices.data(), GL_STATIC_DRAW);
+    setPositionDequantization(shaderProgram);
+    setPositionDequantization(resolveProgram);
+
+    unsigned int maxMeshVertices = 0;
+    for (size_t i = 0; i < sceneMeshes.size(); i++)
+    {
+        size_t end = i + 1 < sceneMeshes.size() ? sceneMeshes[i + 1].baseVertex : sceneVertexData.size() / 8;
+        maxMeshVertices = std::max(maxMeshVertices, (unsigned int)(end - sceneMeshes[i].baseVertex));
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    if (maxMeshVertices <= 65536)
+    {
+        std::vector<uint16_t> shortIndices(sceneIndices.begin(), sceneIndices.end());
+        sceneIndexType = GL_UNSIGNED_SHORT;
+        sceneIndexSize = sizeof(uint16_t);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        sceneIndexType = GL_UNSIGNED_INT;
+        sceneIndexSize = sizeof(unsigned int);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sceneIndices.size() * sizeof(unsigned int), sceneIndices.data(), GL_STATIC_DRAW);
+    }
+    std::cout << "场景顶点: " << packedVertices.size() << " 个 " << sizeof(PackedVertex) << " 字节的压缩顶点, "
+              << sceneIndexSize * 8 << " 位索引" << std::endl;
+
+    // 配置顶点属性：位置归一化到 [0, 1]，法线归一化到 [-1, 1]
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, texCoord));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, normal));
+    glEnableVertexAttribArray(2);
+
+    if (glfwExtensionSupported("GL_ARB_multi_draw_indirect") && glfwExtensionSupported("GL_ARB_base_instance") &&
+        glfwExtensionSupported("GL_ARB_buffer_storage"))
+    {
+        multiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)glfwGetProcAddress("glMultiDrawElementsIndirect");
+        bufferStorage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+    }
+
+    // 部件变换：实例属性3-6，baseInstance 选择部件
+    std::vector<glm::mat4> transforms;
+    for (const ScenePart &part : sceneParts)
+    {
+        transforms.push_back(part.transform);
+    }
+    glGenBuffers(1, &partTransformVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, partTransformVBO);
+    glBufferData(GL_ARRAY_BUFFER, transforms.size() * sizeof(glm::mat4), transforms.data(), GL_STATIC_DRAW);
+    for (int column = 0; column < 4; column++)
+    {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(3 + column, 1);
+        // 不支持间接绘制时属性数组保持关闭，改用 glVertexAttrib4fv 设置的常量值
+        if (multiDrawElementsIndirect && bufferStorage)
+        {
+            glEnableVertexAttribArray(3 + column);
+        }
+    }
+
+    // 部件编号：实例属性7，供可见性通道写入（GL 3.3 没有 gl_BaseInstance）
+    std::vector<unsigned int> partIndices(sceneParts.size());
+    for (unsigned int i = 0; i < partIndices.size(); i++)
+    {
+        partIndices[i] = i;
+    }
+    glGenBuffers(1, &partIndexVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, partIndexVBO);
+    glBufferData(GL_ARRAY_BUFFER, partIndices.size() * sizeof(unsigned int), partIndices.data(), GL_STATIC_DRAW);
+    glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void *)0);
+    glVertexAttribDivisor(7, 1);
+    if (multiDrawElementsIndirect && bufferStorage)
+    {
+        glEnableVertexAttribArray(7);
+    }
+
+    if (multiDrawElementsIndirect && bufferStorage && !sceneParts.empty())
+    {
+        GLsizeiptr size = indirectRingSize * sceneParts.size() * sizeof(DrawElementsIndirectCommand);
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &indirectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        bufferStorage(GL_DRAW_INDIRECT_BUFFER, size, NULL, flags);
+        indirectCommands = (DrawElementsIndirectCommand *)glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, size, flags);
+        std::cout << "场景绘制: glMultiDrawElementsIndirect" << std::endl;
+    }
+    else
+    {
+        std::cout << "场景绘制: 不支持多绘制间接，逐部件 glDrawElementsBaseVertex" << std::endl;
+    }
+    glBindVertexArray(0);
+}
+
+// 材质纹理和部件的材质编号；bindless 时先常驻白色纹理的句柄，各纹理上传后由 updateMaterialHandles 替换
+void initMaterials()
+{
+    std::vector<unsigned int> partMaterials;
+    for (const ScenePart &part : sceneParts)
+    {
+        partMaterials.push_back(part.material);
+    }
+    createTextureBuffer(partMaterialTBO, partMaterialTexture, GL_R32UI);
+    glBufferData(GL_TEXTURE_BUFFER, partMaterials.size() * sizeof(unsigned int), partMaterials.data(), GL_STATIC_DRAW);
+
+    if (!bindlessTextures)
+    {
+        materialArrayTexture = glcore::loadTextureArray(materialPaths, materialArraySize);
+        std::cout << "材质纹理: " << materialPaths.size() << " 层纹理数组（" << materialArraySize << "x" << materialArraySize << "）" << std::endl;
+        return;
+    }
+
+    unsigned char white[] = {255, 255, 255, 255};
+    glGenTextures(1, &whiteTexture);
+    glBindTexture(GL_TEXTURE_2D, whiteTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    whiteHandle = getTextureHandle(whiteTexture);
+    makeTextureHandleResident(whiteHandle);
+
+    for (const std::string &path : materialPaths)
+    {
+        materialTextures.push_back(glcore::loadTexture(path));
+    }
+    materialHandles.assign(materialPaths.size(), whiteHandle);
+    pendingMaterialHandles = materialPaths.size();
+    createTextureBuffer(materialHandleTBO, materialHandleTexture, GL_RG32UI);
+    glBufferData(GL_TEXTURE_BUFFER, materialHandles.size() * sizeof(GLuint64), materialHandles.data(), GL_DYNAMIC_DRAW);
+    std::cout << "材质纹理: " << materialPaths.size() << " 个 bindless 纹理" << std::endl;
+}
+
+// 每帧调用：上传完成的材质纹理不再变化，创建常驻句柄写入句柄缓冲
+void updateMaterialHandles()
+{
+    if (pendingMaterialHandles == 0)
+        return;
+    glBindBuffer(GL_TEXTURE_BUFFER, materialHandleTBO);
+    for (size_t material = 0; material < materialTextures.size(); material++)
+    {
+        if (materialHandles[material] != whiteHandle || !glcore::isTextureLoaded(materialTextures[material]))
+            continue;
+        materialHandles[material] = getTextureHandle(materialTextures[material]);
+        makeTextureHandleResident(materialHandles[material]);
+        glBufferSubData(GL_TEXTURE_BUFFER, material * sizeof(GLuint64), sizeof(GLuint64), &materialHandles[material]);
+        pendingMaterialHandles--;
+    }
+}
+
+// 从裁剪矩阵提取6个视锥平面，法线朝内并归一化（与期末项目 MeshShaderGrass::calculateFrustumPlanes 相同）
+void extractFrustumPlanes(const glm::mat4 &vp, glm::vec4 planes[6])
+{
+    // 左
+    planes[0] = glm::vec4(vp[0][3] + vp[0][0], vp[1][3] + vp[1][0], vp[2][3] + vp[2][0], vp[3][3] + vp[3][0]);
+    // 右
+    planes[1] = glm::vec4(vp[0][3] - vp[0][0], vp[1][3] - vp[1][0], vp[2][3] - vp[2][0], vp[3][3] - vp[3][0]);
+    // 下
+    planes[2] = glm::vec4(vp[0][3] + vp[0][1], vp[1][3] + vp[1][1], vp[2][3] + vp[2][1], vp[3][3] + vp[3][1]);
+    // 上
+    planes[3] = glm::vec4(vp[0][3] - vp[0][1], vp[1][3] - vp[1][1], vp[2][3] - vp[2][1], vp[3][3] - vp[3][1]);
+    // 近
+    planes[4] = glm::vec4(vp[0][3] + vp[0][2], vp[1][3] + vp[1][2], vp[2][3] + vp[2][2], vp[3][3] + vp[3][2]);
+    // 远
+    planes[5] = glm::vec4(vp[0][3] - vp[0][2], vp[1][3] - vp[1][2], vp[2][3] - vp[2][2], vp[3][3] - vp[3][2]);
+
+    for (int i = 0; i < 6; i++)
+    {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+// 剔除视锥外的部件，生成本帧的绘制命令
+void buildDrawCommands(const glm::mat4 &sceneToClip)
+{
+    glm::vec4 planes[6];
+    extractFrustumPlanes(sceneToClip, planes);
+
+    if (frustumCulling)
+    {
+        cullBoxes(planes, partBounds, visibleParts);
+    }
+    else
+    {
+        visibleParts.resize(sceneParts.size());
+        for (unsigned int i = 0; i < sceneParts.size(); i++)
+            visibleParts[i] = i;
+    }
+
+    drawCommands.clear();
+    drawnTriangles = 0;
+    for (unsigned int i : visibleParts)
+    {
+        const SceneMesh &mesh = sceneMeshes[sceneParts[i].mesh];
+        drawCommands.push_back({mesh.indexCount, 1, mesh.firstIndex, (int)mesh.baseVertex, i});
+        drawnTriangles += mesh.indexCount / 3;
+    }
+}
+
+// 一次 glMultiDrawElementsIndirect 绘制所有可见部件；
+// 给出 conditions 时逐部件绘制，条件查询非0的部件在条件渲染中绘制
+void drawScene(const std::vector<unsigned int> *conditions = nullptr)
+{
+    if (drawCommands.empty())
+        return;
+
+    if (indirectCommands)
+    {
+        unsigned int slot = indirectFrame % indirectRingSize;
+        if (indirectFences[slot])
+        {
+            glClientWaitSync(indirectFences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            glDeleteSync(indirectFences[slot]);
+        }
+        size_t offset = slot * sceneParts.size();
+        memcpy(indirectCommands + offset, drawCommands.data(), drawCommands.size() * sizeof(DrawElementsIndirectCommand));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        if (conditions)
+        {
+            // 条件渲染作用于整条绘制命令，每个部件单独一条
+            for (size_t i = 0; i < drawCommands.size(); i++)
+            {
+                if ((*conditions)[i])
+                    glBeginConditionalRender((*conditions)[i], GL_QUERY_NO_WAIT);
+                multiDrawElementsIndirect(GL_TRIANGLES, sceneIndexType, (void *)((offset + i) * sizeof(DrawElementsIndirectCommand)), 1, 0);
+                if ((*conditions)[i])
+                    glEndConditionalRender();
+            }
+        }
+        else
+        {
+            multiDrawElementsIndirect(GL_TRIANGLES, sceneIndexType, (void *)(offset * sizeof(DrawElementsIndirectCommand)), (GLsizei)drawCommands.size(), 0);
+        }
+        indirectFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        indirectFrame++;
+        return;
+    }
+
+    for (size_t i = 0; i < drawCommands.size(); i++)
+    {
+        const DrawElementsIndirectCommand &command = drawCommands[i];
+        unsigned int condition = conditions ? (*conditions)[i] : 0;
+        const glm::mat4 &transform = sceneParts[command.baseInstance].transform;
+        for (int column = 0; column < 4; column++)
+        {
+            glVertexAttrib4fv(3 + column, glm::value_ptr(transform[column]));
+        }
+        glVertexAttribI4ui(7, command.baseInstance, 0, 0, 0);
+        if (condition)
+            glBeginConditionalRender(condition, GL_QUERY_NO_WAIT);
+        glDrawElementsBaseVertex(GL_TRIANGLES, command.count, sceneIndexType, (void *)((size_t)command.firstIndex * sceneIndexSize), command.baseVertex);
+        if (condition)
+            glEndConditionalRender();
+    }
+}
+
+// 遮挡查询的包围盒程序、单位立方体和每个部件的查询对象
+void initOcclusionCulling()
+{
+    if (glfwExtensionSupported("GL_ARB_ES3_compatibility"))
+    {
+        occlusionQueryTarget = GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+    }
+    boxProgram = glcore::compileShaderProgram(boxVertexShaderSource, boxFragmentShaderSource);
+    boxSceneToClipLocation = glGetUniformLocation(boxProgram, "sceneToClip");
+    boxMinLocation = glGetUniformLocation(boxProgram, "boxMin");
+    boxMaxLocation = glGetUniformLocation(boxProgram, "boxMax");
+
+    // 顶点编号的3位即 x/y/z 取 boxMax 还是 boxMin，两面都画，不依赖绕序
+    float corners[8 * 3];
+    for (int corner = 0; corner < 8; corner++)
+    {
+        corners[corner * 3 + 0] = (corner & 1) ? 1.0f : 0.0f;
+        corners[corner * 3 + 1] = (corner & 2) ? 1.0f : 0.0f;
+        corners[corner * 3 + 2] = (corner & 4) ? 1.0f : 0.0f;
+    }
+    const unsigned int faces[36] = {0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6, 0, 1, 5, 0, 5, 4,
+                                    2, 6, 7, 2, 7, 3, 0, 4, 6, 0, 6, 2, 1, 3, 7, 1, 7, 5};
+    glGenVertexArrays(1, &boxVAO);
+    glGenBuffers(1, &boxVBO);
+    glGenBuffers(1, &boxEBO);
+    glBindVertexArray(boxVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, boxVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boxEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(faces), faces, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    occlusionQueries.resize(sceneParts.size());
+    occlusionQueryFrames.assign(sceneParts.size(), 0);
+    if (!occlusionQueries.empty())
+    {
+        glGenQueries((GLsizei)occlusionQueries.size(), occlusionQueries.data());
+    }
+    std::cout << "遮挡剔除: " << (occlusionQueryTarget == GL_ANY_SAMPLES_PASSED_CONSERVATIVE ? "GL_ANY_SAMPLES_PASSED_CONSERVATIVE" : "GL_ANY_SAMPLES_PASSED") << std::endl;
+}
+
+// 部件包围盒（场景空间），略微放大，避免与部件表面深度相同时查询失败
+void getOcclusionBox(unsigned int part, glm::vec3 &boxMin, glm::vec3 &boxMax)
+{
+    boxMin = glm::vec3(partBounds.minX[part], partBounds.minY[part], partBounds.minZ[part]);
+    boxMax = glm::vec3(partBounds.maxX[part], partBounds.maxY[part], partBounds.maxZ[part]);
+    glm::vec3 margin = 0.01f * (boxMax - boxMin) + 0.001f;
+    boxMin -= margin;
+    boxMax += margin;
+}
+
+// 以上一帧的查询结果条件绘制可见部件，再对本帧的深度缓冲查询它们的包围盒。
+// 相机在包围盒内（近平面会裁掉包围盒）或上一帧未查询的部件无条件绘制
+void drawSceneOccluded(const glm::mat4 &model, const glm::mat4 &sceneToClip)
+{
+    occlusionFrame++;
+    glm::vec3 eye = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+    // 近平面的角点离相机最远约 2 * nearPlane（fov 不超过45度）
+    auto containsEye = [&](const glm::vec3 &boxMin, const glm::vec3 &boxMax)
+    {
+        return glm::all(glm::greaterThan(eye, boxMin - 2.0f * nearPlane)) && glm::all(glm::lessThan(eye, boxMax + 2.0f * nearPlane));
+    };
+
+    drawConditions.resize(drawCommands.size());
+    for (size_t i = 0; i < drawCommands.size(); i++)
+    {
+        unsigned int part = drawCommands[i].baseInstance;
+        glm::vec3 boxMin, boxMax;
+        getOcclusionBox(part, boxMin, boxMax);
+        bool queried = occlusionQueryFrames[part] + 1 == occlusionFrame && !containsEye(boxMin, boxMax);
+        drawConditions[i] = queried ? occlusionQueries[part] : 0;
+    }
+    drawScene(&drawConditions);
+
+    glUseProgram(boxProgram);
+    glUniformMatrix4fv(boxSceneToClipLocation, 1, GL_FALSE, glm::value_ptr(sceneToClip));
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_LEQUAL);
+    glBindVertexArray(boxVAO);
+    for (const DrawElementsIndirectCommand &command : drawCommands)
+    {
+        unsigned int part = command.baseInstance;
+        glm::vec3 boxMin, boxMax;
+        getOcclusionBox(part, boxMin, boxMax);
+        if (containsEye(boxMin, boxMax))
+            continue;
+        glUniform3fv(boxMinLocation, 1, glm::value_ptr(boxMin));
+        glUniform3fv(boxMaxLocation, 1, glm::value_ptr(boxMax));
+        glBeginQuery(occlusionQueryTarget, occlusionQueries[part]);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        glEndQuery(occlusionQueryTarget);
+        occlusionQueryFrames[part] = occlusionFrame;
+    }
+    glBindVertexArray(VAO);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+// 本帧查询中已有结果且被遮挡的部件数；只检查结果是否就绪，不等待
+unsigned int countOccludedParts()
+{
+    unsigned int occluded = 0;
+    for (size_t part = 0; part < occlusionQueries.size(); part++)
+    {
+        if (occlusionQueryFrames[part] != occlusionFrame)
+            continue;
+        GLuint available = GL_FALSE, passed = GL_TRUE;
+        glGetQueryObjectuiv(occlusionQueries[part], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+            glGetQueryObjectuiv(occlusionQueries[part], GL_QUERY_RESULT, &passed);
+        occluded += available && !passed;
+    }
+    return occluded;
+}
+
+// 阴影贴图纹理、帧缓冲和着色器；场景包围球用于确定级联的深度范围
+void initShadows()
+{
+    shadowProgram = glcore::compileShaderProgram(shadowVertexShaderSource, shadowFragmentShaderSource);
+    shadowUniforms.model = glGetUniformLocation(shadowProgram, "model");
+    shadowUniforms.lightViewProjection = glGetUniformLocation(shadowProgram, "lightViewProjection");
+    shadowUniforms.lightPos = glGetUniformLocation(shadowProgram, "lightPos");
+    shadowUniforms.lightFar = glGetUniformLocation(shadowProgram, "lightFar");
+    shadowUniforms.linearDepth = glGetUniformLocation(shadowProgram, "linearDepth");
+    setPositionDequantization(shadowProgram);
+
+    // 深度比较纹理：采样即得到硬件 2x2 PCF 结果
+    glGenTextures(1, &cascadeShadowTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, cascadeShadowTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, shadowCascadeSize, shadowCascadeSize, shadowCascadeCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    glGenTextures(shadowedPointLightCount, pointShadowTextures);
+    for (unsigned int texture : pointShadowTextures)
+    {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        for (int face = 0; face < 6; face++)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, pointShadowSize, pointShadowSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+
+    glGenFramebuffers(1, &shadowFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // 纹理单元：4 级联，5-7 点光源
+    for (unsigned int program : {shaderProgram, resolveProgram})
+    {
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "cascadeShadowMap"), 4);
+        for (int i = 0; i < shadowedPointLightCount; i++)
+        {
+            glUniform1i(glGetUniformLocation(program, ("pointShadowMaps[" + std::to_string(i) + "]").c_str()), 5 + i);
+        }
+    }
+
+    // 场景（model 变换前）的包围球
+    glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+    for (size_t i = 0; i < partBounds.count; i++)
+    {
+        boundsMin = glm::min(boundsMin, glm::vec3(partBounds.minX[i], partBounds.minY[i], partBounds.minZ[i]));
+        boundsMax = glm::max(boundsMax, glm::vec3(partBounds.maxX[i], partBounds.maxY[i], partBounds.maxZ[i]));
+    }
+    if (partBounds.count > 0)
+    {
+        sceneBoundsCenter = (boundsMin + boundsMax) * 0.5f;
+        sceneBoundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+    }
+}
+
+// 可见性缓冲：可见性程序、帧缓冲，以及解析通道读取场景数据用的纹理缓冲
+void initVisibilityBuffer()
+{
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    visibilityBufferSupported = sceneVertexData.size() / 8 <= (size_t)maxTexels && sceneIndices.size() <= (size_t)maxTexels;
+    if (!visibilityBufferSupported)
+    {
+        std::cout << "可见性缓冲: 场景超出纹理缓冲大小上限（" << maxTexels << " texel），仅前向渲染" << std::endl;
+        return;
+    }
+
+    visibilityProgram = glcore::compileShaderProgram(visibilityVertexShaderSource, visibilityFragmentShaderSource);
+    visibilityUniforms.model = glGetUniformLocation(visibilityProgram, "model");
+    visibilityUniforms.view = glGetUniformLocation(visibilityProgram, "view");
+    visibilityUniforms.projection = glGetUniformLocation(visibilityProgram, "projection");
+    setPositionDequantization(visibilityProgram);
+
+    // 场景缓冲直接作为纹理缓冲读取，不复制：每个压缩顶点一个RGBA32UI，每个部件变换4个RGBA32F
+    glGenTextures(1, &vertexDataTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, vertexDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, VBO);
+    glGenTextures(1, &indexDataTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, indexDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, sceneIndexType == GL_UNSIGNED_SHORT ? GL_R16UI : GL_R32UI, EBO);
+    glGenTextures(1, &partTransformTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, partTransformTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, partTransformVBO);
+
+    std::vector<unsigned int> partInfo;
+    for (const ScenePart &part : sceneParts)
+    {
+        partInfo.push_back(sceneMeshes[part.mesh].firstIndex);
+        partInfo.push_back(sceneMeshes[part.mesh].baseVertex);
+    }
+    createTextureBuffer(partInfoTBO, partInfoTexture, GL_RG32UI);
+    glBufferData(GL_TEXTURE_BUFFER, partInfo.size() * sizeof(unsigned int), partInfo.data(), GL_STATIC_DRAW);
+
+    // 纹理单元：8 可见性缓冲，9-12 场景数据
+    glUseProgram(resolveProgram);
+    glUniform1i(glGetUniformLocation(resolveProgram, "visibility"), 8);
+    glUniform1i(glGetUniformLocation(resolveProgram, "vertexData"), 9);
+    glUniform1i(glGetUniformLocation(resolveProgram, "indexData"), 10);
+    glUniform1i(glGetUniformLocation(resolveProgram, "partTransforms"), 11);
+    glUniform1i(glGetUniformLocation(resolveProgram, "partInfo"), 12);
+
+    glGenFramebuffers(1, &visibilityFBO);
+    glGenTextures(1, &visibilityTexture);
+    glGenRenderbuffers(1, &visibilityDepth);
+    glGenVertexArrays(1, &resolveVAO);
+}
+
+// 帧缓冲尺寸变化时重建可见性缓冲
+void resizeVisibilityBuffer(int width, int height)
+{
+    if (width == visibilityWidth && height == visibilityHeight)
+        return;
+    visibilityWidth = width;
+    visibilityHeight = height;
+
+    glBindTexture(GL_TEXTURE_2D, visibilityTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, width, height, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindRenderbuffer(GL_RENDERBUFFER, visibilityDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, visibilityFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, visibilityTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, visibilityDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Visibility framebuffer incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// 可见性通道：与前向绘制相同的剔除结果和绘制命令，只写编号和深度
+void renderVisibilityPass(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection, int width, int height)
+{
+    resizeVisibilityBuffer(width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, visibilityFBO);
+    const GLuint background[4] = {0, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, background);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    glUseProgram(visibilityProgram);
+    glUniformMatrix4fv(visibilityUniforms.model, 1, GL_FALSE, glm::value_ptr(model));
+    glUniformMatrix4fv(visibilityUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(visibilityUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+    if (occlusionCulling)
+        drawSceneOccluded(model, projection * view * model);
+    else
+        drawScene();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// 解析通道：全屏三角形，背景像素丢弃；着色uniform已在绘制前设置
+void resolveVisibility()
+{
+    glUseProgram(resolveProgram);
+    glActiveTexture(GL_TEXTURE8);
+    glBindTexture(GL_TEXTURE_2D, visibilityTexture);
+    glActiveTexture(GL_TEXTURE9);
+    glBindTexture(GL_TEXTURE_BUFFER, vertexDataTexture);
+    glActiveTexture(GL_TEXTURE10);
+    glBindTexture(GL_TEXTURE_BUFFER, indexDataTexture);
+    glActiveTexture(GL_TEXTURE11);
+    glBindTexture(GL_TEXTURE_BUFFER, partTransformTexture);
+    glActiveTexture(GL_TEXTURE12);
+    glBindTexture(GL_TEXTURE_BUFFER, partInfoTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(resolveVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(VAO);
+    glEnable(GL_DEPTH_TEST);
+}
+
+// 视锥分段 [splitNear, splitFar] 的世界空间包围球
+void frustumSliceSphere(const glm::mat4 &inverseView, float aspect, float splitNear, float splitFar, glm::vec3 &center, float &radius)
+{
+    float tanHalfFov = std::tan(glm::radians(fov) * 0.5f);
+    glm::vec3 corners[8];
+    center = glm::vec3(0.0f);
+    for (int i = 0; i < 8; i++)
+    {
+        float depth = (i & 4) ? splitFar : splitNear;
+        glm::vec3 viewCorner(((i & 1) ? 1.0f : -1.0f) * depth * tanHalfFov * aspect, ((i & 2) ? 1.0f : -1.0f) * depth * tanHalfFov, -depth);
+        corners[i] = glm::vec3(inverseView * glm::vec4(viewCorner, 1.0f));
+        center += corners[i] * 0.125f;
+    }
+    radius = 0.0f;
+    for (const glm::vec3 &corner : corners)
+    {
+        radius = std::max(radius, glm::length(corner - center));
+    }
+}
+
+// 更新级联：当前分段的包围球不在缓存的（放大的）包围球内时才重新拟合，返回是否需要重绘
+bool updateCascade(int cascade, const glm::mat4 &inverseView, float aspect, float splitNear, float splitFar, const glm::vec3 &sceneCenter, bool force)
+{
+    ShadowCascade &shadowCascade = shadowCascades[cascade];
+    shadowCascade.splitFar = splitFar;
+    glm::vec3 center;
+    float radius;
+    frustumSliceSphere(inverseView, aspect, splitNear, splitFar, center, radius);
+    bool contained = shadowCascade.valid && glm::length(center - shadowCascade.center) + radius <= shadowCascade.radius &&
+                     radius * cascadePadding > shadowCascade.radius * 0.5f; // 缩放视角后范围过大也要重新拟合
+    if (contained && !force)
+        return false;
+
+    // 光源空间只含旋转，中心对齐到纹素，重新拟合时阴影边缘不闪烁
+    glm::vec3 lightDir = glm::normalize(lights.dirLight.direction);
+    glm::vec3 up = std::abs(lightDir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), lightDir, up);
+    if (!contained)
+    {
+        shadowCascade.radius = radius * cascadePadding;
+        float texelSize = 2.0f * shadowCascade.radius / shadowCascadeSize;
+        glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+        lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+        shadowCascade.center = glm::vec3(glm::inverse(lightView) * glm::vec4(lightCenter, 1.0f));
+        shadowCascade.valid = true;
+    }
+
+    // 深度范围包含整个场景，分段外朝向光源的物体也能投下阴影
+    glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(shadowCascade.center, 1.0f));
+    float sceneZ = glm::vec3(lightView * glm::vec4(sceneCenter, 1.0f)).z;
+    float zMax = std::max(lightCenter.z + shadowCascade.radius, sceneZ + sceneBoundsRadius);
+    float zMin = std::min(lightCenter.z - shadowCascade.radius, sceneZ - sceneBoundsRadius);
+    glm::mat4 lightProjection = glm::ortho(lightCenter.x - shadowCascade.radius, lightCenter.x + shadowCascade.radius,
+                                           lightCenter.y - shadowCascade.radius, lightCenter.y + shadowCascade.radius, -zMax, -zMin);
+    shadowCascade.viewProjection = lightProjection * lightView;
+    return true;
+}
+
+// 绘制阴影贴图的一个面：按该面的视锥剔除部件
+void renderShadowPass(const glm::mat4 &lightViewProjection, const glm::mat4 &model)
+{
+    glUniformMatrix4fv(shadowUniforms.lightViewProjection, 1, GL_FALSE, glm::value_ptr(lightViewProjection));
+    glClear(GL_DEPTH_BUFFER_BIT);
+    buildDrawCommands(lightViewProjection * model);
+    drawScene();
+    shadowPassesRendered++;
+}
+
+// 重绘失效的阴影贴图，光源或几何体变化时全部重绘
+void updateShadows(const glm::mat4 &model, const glm::mat4 &view, float aspect)
+{
+    shadowPassesRendered = 0;
+    bool geometryMoved = model != shadowModel;
+    shadowModel = model;
+    if (geometryMoved)
+    {
+        pointShadowsDirty = true;
+    }
+
+    glUseProgram(shadowProgram);
+    glUniformMatrix4fv(shadowUniforms.model, 1, GL_FALSE, glm::value_ptr(model));
+    glBindFramebuffer(GL_FRAMEBUFFER, shadowFBO);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.5f, 2.0f);
+
+    // 方向光级联：对数与均匀划分混合
+    glViewport(0, 0, shadowCascadeSize, shadowCascadeSize);
+    glUniform1i(shadowUniforms.linearDepth, 0);
+    glm::mat4 inverseView = glm::inverse(view);
+    glm::vec3 sceneCenter = glm::vec3(model * glm::vec4(sceneBoundsCenter, 1.0f));
+    float splitNear = nearPlane;
+    for (int cascade = 0; cascade < shadowCascadeCount; cascade++)
+    {
+        float fraction = (cascade + 1.0f) / shadowCascadeCount;
+        float logSplit = nearPlane * std::pow(shadowDistance / nearPlane, fraction);
+        float uniformSplit = nearPlane + (shadowDistance - nearPlane) * fraction;
+        float splitFar = glm::mix(uniformSplit, logSplit, cascadeSplitLambda);
+        if (updateCascade(cascade, inverseView, aspect, splitNear, splitFar, sceneCenter, geometryMoved || lightsDirty))
+        {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cascadeShadowTexture, 0, cascade);
+            renderShadowPass(shadowCascades[cascade].viewProjection, model);
+        }
+        splitNear = splitFar;
+    }
+
+    // 点光源立方体贴图：90度透视，6个面
+    if (pointShadowsDirty)
+    {
+        static const glm::vec3 faceDirections[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+        static const glm::vec3 faceUps[6] = {{0, -1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0}};
+        glViewport(0, 0, pointShadowSize, pointShadowSize);
+        glUniform1i(shadowUniforms.linearDepth, 1);
+        for (int light = 0; light < shadowedPointLightCount && light < (int)pointLights.size(); light++)
+        {
+            const PointLight &pointLight = pointLights[light];
+            float lightFar = std::min(pointLight.radius, farPlane);
+            glm::mat4 faceProjection = glm::perspective(glm::half_pi<float>(), 1.0f, 0.05f, lightFar);
+            glUniform3fv(shadowUniforms.lightPos, 1, glm::value_ptr(pointLight.position));
+            glUniform1f(shadowUniforms.lightFar, lightFar);
+            for (int face = 0; face < 6; face++)
+            {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, pointShadowTextures[light], 0);
+                glm::mat4 faceView = glm::lookAt(pointLight.position, pointLight.position + faceDirections[face], faceUps[face]);
+                renderShadowPass(faceProjection * faceView, model);
+            }
+        }
+        pointShadowsDirty = false;
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// 查询着色uniform的位置，解析程序中没有的（如 perVertexNormalMatrix）为 -1
+ModelUniforms getModelUniforms(unsigned int program)
+{
+    ModelUniforms uniforms;
+    uniforms.model = glGetUniformLocation(program, "model");
+    uniforms.view = glGetUniformLocation(program, "view");
+    uniforms.projection = glGetUniformLocation(program, "projection");
+    uniforms.viewPos = glGetUniformLocation(program, "viewPos");
+    uniforms.tileSize = glGetUniformLocation(program, "tileSize");
+    uniforms.sliceScaleBias = glGetUniformLocation(program, "sliceScaleBias");
+    uniforms.normalMatrix = glGetUniformLocation(program, "normalMatrix");
+    uniforms.perVertexNormalMatrix = glGetUniformLocation(program, "perVertexNormalMatrix");
+    uniforms.cascadeMatrices = glGetUniformLocation(program, "cascadeMatrices");
+    uniforms.cascadeSplits = glGetUniformLocation(program, "cascadeSplits");
+    uniforms.cascadeTexelSizes = glGetUniformLocation(program, "cascadeTexelSizes");
+    uniforms.pointShadowFar = glGetUniformLocation(program, "pointShadowFar");
+    uniforms.pcfQuality = glGetUniformLocation(program, "pcfQuality");
+    glcore::bindUniformBlock(program, "Lights", lightsBinding);
+    return uniforms;
+}
+
+// 初始化（全屏+4光源配置）
+void init()
+{
+    // 创建全屏窗口（主显示器的当前模式），同时加载GLAD和程序二进制缓存
+    glcore::WindowSettings windowSettings;
+    windowSettings.title = "4-Light OBJ Model Viewer";
+    windowSettings.fullscreen = true;
+    window = glcore::createWindow(windowSettings);
+    if (window == NULL)
+    {
+        return;
+    }
+    primaryMonitor = glfwGetPrimaryMonitor();
+    videoMode = glfwGetVideoMode(primaryMonitor);
+    // 独占全屏以显示器刷新率运行：默认自适应垂直同步，赶得上刷新时不撕裂，赶不上时不掉到半帧率
+    frameLoop.swapMode = glcore::SwapMode::Adaptive;
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // 编译3D模型着色器：前向程序和可见性缓冲解析程序共用着色代码
+    if (glfwExtensionSupported("GL_ARB_bindless_texture"))
+    {
+        getTextureHandle = (PFNGLGETTEXTUREHANDLEARBPROC)glfwGetProcAddress("glGetTextureHandleARB");
+        makeTextureHandleResident = (PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)glfwGetProcAddress("glMakeTextureHandleResidentARB");
+        makeTextureHandleNonResident = (PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)glfwGetProcAddress("glMakeTextureHandleNonResidentARB");
+        bindlessTextures = getTextureHandle && makeTextureHandleResident && makeTextureHandleNonResident;
+    }
+    std::string shadingSource = shadingShaderSource;
+    if (bindlessTextures)
+    {
+        size_t version = shadingSource.find('\n', shadingSource.find("#version")) + 1;
+        shadingSource.insert(version, bindlessShaderHeader);
+    }
+    std::string forwardFragmentSource = shadingSource + forwardFragmentMainSource;
+    std::string resolveFragmentSource = shadingSource + resolveFragmentMainSource;
+    shaderProgram = glcore::compileShaderProgram(vertexShaderSource, forwardFragmentSource.c_str());
+    resolveProgram = glcore::compileShaderProgram(resolveVertexShaderSource, resolveFragmentSource.c_str());
+    modelUniforms = getModelUniforms(shaderProgram);
+    resolveUniforms = getModelUniforms(resolveProgram);
+    initLights();
+
+    // 加载模型（替换为你的OBJ路径），--scene 指定时加载多个部件
+    if (!scenePath.empty())
+    {
+        loadScene(scenePath);
+    }
+    else
+    {
+        std::unordered_map<std::string, int> loadedMeshes;
+        int mesh = addSceneMesh("model.obj", loadedMeshes);
+        if (mesh >= 0)
+        {
+            addScenePart(mesh, glm::mat4(1.0f));
+        }
+        else
+        {
+            std::cerr << "Failed to load OBJ model (请替换为有效OBJ路径)" << std::endl;
+            // 模型加载失败仍继续运行（不绘制模型）
+        }
+    }
+    initSceneBuffers();
+    // 加载材质纹理（默认 texture.png，无纹理则使用白色），解码在后台进行，完成后在渲染循环中上传
+    initMaterials();
+    initShadows();
+    initVisibilityBuffer();
+    initOcclusionCulling();
+
+    gpuTimer.init(gpuSectionCount);
+
+    // 初始化2D UI和深度测试
+    initUI();
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND); // 启用混合，实现半透明UI
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -509,105 +2648,274 @@ void init()
 // 渲染循环（设置4个光源并绘制）
 void render()
 {
-    while (!glfwWindowShouldClose(window))
+    while (frameLoop.begin(window))
     {
-        // 计算帧时间差
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
         // 处理输入
         processInput(window);
 
-        // 清空缓冲
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 绘制3D模型
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        // 上传已解码完成的纹理
+        glcore::updateTextureUploads();
+        if (bindlessTextures)
+        {
+            updateMaterialHandles();
+        }
 
-        // 模型/视图/投影矩阵
+        // 模型/视图/投影矩阵（model 作用于整个场景）
         glm::mat4 model = glm::mat4(1.0f);
         if (isModelRotating)
         {
             model = glm::rotate(model, (float)glfwGetTime() * glm::radians(15.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         }
         glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-        glm::mat4 projection = glm::perspective(glm::radians(fov), (float)videoMode->width / videoMode->height, 0.1f, 100.0f);
-
-        // 设置矩阵uniform
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(cameraPos));
-
-        // 1. 设置方向光（第1个光源）
-        glUniform3fv(glGetUniformLocation(shaderProgram, "dirLight.direction"), 1, glm::value_ptr(glm::vec3(-0.5f, -1.0f, -0.3f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "dirLight.ambient"), 1, glm::value_ptr(glm::vec3(0.2f, 0.2f, 0.2f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "dirLight.diffuse"), 1, glm::value_ptr(glm::vec3(0.5f, 0.5f, 0.5f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "dirLight.specular"), 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 1.0f)));
-
-        // 2. 设置3个点光源（第2-4个光源）
-        // 点光源1：右侧
-        std::string pointLight1 = "pointLights[0]";
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight1 + ".position").c_str()), 1, glm::value_ptr(glm::vec3(5.0f, 0.0f, 0.0f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight1 + ".ambient").c_str()), 1, glm::value_ptr(glm::vec3(0.2f, 0.0f, 0.0f))); // 红光
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight1 + ".diffuse").c_str()), 1, glm::value_ptr(glm::vec3(0.8f, 0.0f, 0.0f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight1 + ".specular").c_str()), 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 1.0f)));
-        glUniform1f(glGetUniformLocation(shaderProgram, (pointLight1 + ".constant").c_str()), 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, (pointLight1 + ".linear").c_str()), 0.09f);
-        glUniform1f(glGetUniformLocation(shaderProgram, (pointLight1 + ".quadratic").c_str()), 0.032f);
-
-        // 点光源2：左侧
-        std::string pointLight2 = "pointLights[1]";
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight2 + ".position").c_str()), 1, glm::value_ptr(glm::vec3(-5.0f, 0.0f, 0.0f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight2 + ".ambient").c_str()), 1, glm::value_ptr(glm::vec3(0.0f, 0.2f, 0.0f))); // 绿光
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight2 + ".diffuse").c_str()), 1, glm::value_ptr(glm::vec3(0.0f, 0.8f, 0.0f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight2 + ".specular").c_str()), 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 1.0f)));
-        glUniform1f(glGetUniformLocation(shaderProgram, (pointLight2 + ".constant").c_str()), 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, (pointLight2 + ".linear").c_str()), 0.09f);
-        glUniform1f(glGetUniformLocation(shaderProgram, (pointLight2 + ".quadratic").c_str()), 0.032f);
-
-        // 点光源3：上方
-        std::string pointLight3 = "pointLights[2]";
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight3 + ".position").c_str()), 1, glm::value_ptr(glm::vec3(0.0f, 5.0f, 0.0f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight3 + ".ambient").c_str()), 1, glm::value_ptr(glm::vec3(0.0f, 0.0f, 0.2f))); // 蓝光
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight3 + ".diffuse").c_str()), 1, glm::value_ptr(glm::vec3(0.0f, 0.0f, 0.8f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram, (pointLight3 + ".specular").c_str()), 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 1.0f)));
-        glUniform1f(glGetUniformLocation(shaderProgram, (pointLight3 + ".constant").c_str()), 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, (pointLight3 + ".linear").c_str()), 0.09f);
-        glUniform1f(glGetUniformLocation(shaderProgram, (pointLight3 + ".quadratic").c_str()), 0.032f);
-
-        // 绘制模型
-        if (!indices.empty())
-        {
-            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        float aspect = (float)videoMode->width / videoMode->height;
+        glm::mat4 projection = glm::perspective(glm::radians(fov), aspect, nearPlane, farPlane);
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+        // 阴影贴图（只重绘失效的），GPU计时
+        gpuTimer.beginFrame();
+        glBindVertexArray(VAO);
+        gpuTimer.begin(gpuSectionShadow);
+        updateShadows(model, view, aspect);
+        gpuTimer.end(gpuSectionShadow);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+
+        // 清空缓冲
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // 绘制3D模型：着色参数设置到前向程序，或可见性缓冲模式下的解析程序
+        glUseProgram(visibilityBufferMode ? resolveProgram : shaderProgram);
+        const ModelUniforms &uniforms = visibilityBufferMode ? resolveUniforms : modelUniforms;
+        glBindTexture(GL_TEXTURE_2D_ARRAY, materialArrayTexture);
+        glActiveTexture(GL_TEXTURE13);
+        glBindTexture(GL_TEXTURE_BUFFER, partMaterialTexture);
+        glActiveTexture(GL_TEXTURE14);
+        glBindTexture(GL_TEXTURE_BUFFER, materialHandleTexture);
+        glActiveTexture(GL_TEXTURE0);
+
+        // 设置矩阵uniform（位置在创建程序时已查询）
+        glUniformMatrix4fv(uniforms.model, 1, GL_FALSE, glm::value_ptr(model));
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+        glUniformMatrix3fv(uniforms.normalMatrix, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+        glUniform1i(uniforms.perVertexNormalMatrix, perVertexNormalMatrix);
+        glUniformMatrix4fv(uniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(uniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform3fv(uniforms.viewPos, 1, glm::value_ptr(cameraPos));
+
+        // 阴影参数
+        glm::mat4 cascadeMatrices[shadowCascadeCount];
+        float cascadeSplits[shadowCascadeCount], cascadeTexelSizes[shadowCascadeCount];
+        for (int cascade = 0; cascade < shadowCascadeCount; cascade++)
+        {
+            cascadeMatrices[cascade] = shadowCascades[cascade].viewProjection;
+            cascadeSplits[cascade] = shadowCascades[cascade].splitFar;
+            cascadeTexelSizes[cascade] = 2.0f * shadowCascades[cascade].radius / shadowCascadeSize;
+        }
+        float pointShadowFar[shadowedPointLightCount] = {};
+        for (int light = 0; light < shadowedPointLightCount && light < (int)pointLights.size(); light++)
+        {
+            pointShadowFar[light] = std::min(pointLights[light].radius, farPlane);
+        }
+        glUniformMatrix4fv(uniforms.cascadeMatrices, shadowCascadeCount, GL_FALSE, glm::value_ptr(cascadeMatrices[0]));
+        glUniform1fv(uniforms.cascadeSplits, shadowCascadeCount, cascadeSplits);
+        glUniform1fv(uniforms.cascadeTexelSizes, shadowCascadeCount, cascadeTexelSizes);
+        glUniform1fv(uniforms.pointShadowFar, shadowedPointLightCount, pointShadowFar);
+        glUniform1i(uniforms.pcfQuality, shadowPcfQuality);
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, cascadeShadowTexture);
+        for (int light = 0; light < shadowedPointLightCount; light++)
+        {
+            glActiveTexture(GL_TEXTURE5 + light);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, pointShadowTextures[light]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+
+        // 光源只在变化时上传
+        if (lightsDirty)
+        {
+            lightsUBO.upload(lights);
+            uploadPointLights();
+            lightsDirty = false;
+        }
+
+        // 分簇：相机每帧都可能移动，重新分配光源
+        buildClusters(view, projection);
+        float sliceScale = clusterCountZ / std::log(farPlane / nearPlane);
+        glUniform2f(uniforms.tileSize, (float)framebufferWidth / clusterCountX, (float)framebufferHeight / clusterCountY);
+        glUniform2f(uniforms.sliceScaleBias, sliceScale, -std::log(nearPlane) * sliceScale);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, lightDataTexture);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_BUFFER, clusterGridTexture);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_BUFFER, lightIndexTexture);
+        glActiveTexture(GL_TEXTURE0);
+
+        // 绘制模型（GPU计时）
+        if (gpuTimer.hasResults())
+        {
+            gpuTimeSum += gpuTimer.getMs(gpuSectionModel) + gpuTimer.getMs(gpuSectionResolve);
+            if (++gpuTimeSamples == 120)
+            {
+                std::cout << "Model draw GPU time: " << gpuTimeSum / gpuTimeSamples << " ms ("
+                          << (visibilityBufferMode ? "visibility buffer" : "forward") << ", "
+                          << (perVertexNormalMatrix ? "per-vertex inverse(model)" : "CPU normal matrix") << ", "
+                          << drawnTriangles << " triangles, " << drawCommands.size() << " draws";
+                if (occlusionCulling)
+                    std::cout << ", " << countOccludedParts() << " occluded";
+                std::cout << ")" << std::endl;
+                gpuTimeSum = 0.0;
+                gpuTimeSamples = 0;
+            }
+        }
+        buildDrawCommands(projection * view * model);
+        gpuTimer.begin(gpuSectionModel);
+        if (visibilityBufferMode)
+        {
+            renderVisibilityPass(model, view, projection, framebufferWidth, framebufferHeight);
+        }
+        else if (occlusionCulling)
+        {
+            drawSceneOccluded(model, projection * view * model);
+        }
+        else
+        {
+            drawScene();
+        }
+        gpuTimer.end(gpuSectionModel);
+        // 前向模式下解析段为空，查询仍成对写入
+        gpuTimer.begin(gpuSectionResolve);
+        if (visibilityBufferMode)
+        {
+            resolveVisibility();
         }
+        gpuTimer.end(gpuSectionResolve);
+
+        // HUD
+        gpuTimer.begin(gpuSectionUI);
+        drawHUD(framebufferWidth, framebufferHeight);
+        gpuTimer.end(gpuSectionUI);
+        gpuTimer.endFrame();
+        updateBench();
 
         // 交换缓冲并轮询事件
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        frameLoop.end(window);
     }
 }
 
 // 清理资源
 void cleanup()
 {
+    glcore::shutdownTextureLoader();
+    for (GLuint64 handle : materialHandles)
+    {
+        if (handle != whiteHandle)
+        {
+            makeTextureHandleNonResident(handle);
+        }
+    }
+    if (whiteHandle)
+    {
+        makeTextureHandleNonResident(whiteHandle);
+    }
+    glDeleteTextures((GLsizei)materialTextures.size(), materialTextures.data());
+    glDeleteTextures(1, &whiteTexture);
+    glDeleteTextures(1, &materialArrayTexture);
+    glDeleteBuffers(1, &materialHandleTBO);
+    glDeleteTextures(1, &materialHandleTexture);
+    glDeleteBuffers(1, &partMaterialTBO);
+    glDeleteTextures(1, &partMaterialTexture);
     glDeleteVertexArrays(1, &VAO);
     glDeleteVertexArrays(1, &uiVAO);
+    glDeleteVertexArrays(1, &uiTextVAO);
+    glDeleteBuffers(1, &uiTextVBO);
+    glDeleteBuffers(1, &uiTextEBO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &uiVBO);
     glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &partTransformVBO);
+    glDeleteBuffers(1, &partIndexVBO);
+    for (GLsync fence : indirectFences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    glDeleteBuffers(1, &indirectBuffer);
+    lightsUBO.deinit();
+    gpuTimer.deinit();
+    glDeleteBuffers(1, &lightDataTBO);
+    glDeleteBuffers(1, &clusterGridTBO);
+    glDeleteBuffers(1, &lightIndexTBO);
+    glDeleteTextures(1, &lightDataTexture);
+    glDeleteTextures(1, &clusterGridTexture);
+    glDeleteTextures(1, &lightIndexTexture);
     glDeleteProgram(shaderProgram);
     glDeleteProgram(uiShaderProgram);
+    glDeleteProgram(shadowProgram);
+    glDeleteFramebuffers(1, &shadowFBO);
+    glDeleteTextures(1, &cascadeShadowTexture);
+    glDeleteTextures(shadowedPointLightCount, pointShadowTextures);
+    glDeleteProgram(visibilityProgram);
+    glDeleteProgram(resolveProgram);
+    glDeleteFramebuffers(1, &visibilityFBO);
+    glDeleteTextures(1, &visibilityTexture);
+    glDeleteRenderbuffers(1, &visibilityDepth);
+    glDeleteVertexArrays(1, &resolveVAO);
+    glDeleteBuffers(1, &partInfoTBO);
+    glDeleteTextures(1, &partInfoTexture);
+    glDeleteTextures(1, &vertexDataTexture);
+    glDeleteTextures(1, &indexDataTexture);
+    glDeleteTextures(1, &partTransformTexture);
+    glDeleteProgram(boxProgram);
+    glDeleteVertexArrays(1, &boxVAO);
+    glDeleteBuffers(1, &boxVBO);
+    glDeleteBuffers(1, &boxEBO);
+    if (!occlusionQueries.empty())
+    {
+        glDeleteQueries((GLsizei)occlusionQueries.size(), occlusionQueries.data());
+    }
     glfwTerminate();
 }
 
-// 主函数
-int main()
+// 主函数：--scene <文件> 加载多模型场景，--bench <N> 输出N帧的平均耗时后退出，
+// --benchmark-load <OBJ> 不打开窗口计时模型加载（--benchmark-iterations <N>，--benchmark-json <文件>，默认 benchmark_load.json），
+// --bake-mesh <OBJ> 不打开窗口解析模型并写入 .meshcache（构建时由 CMake 调用）
+int main(int argc, char **argv)
 {
+    std::string benchmarkLoadPath, benchmarkJsonPath = "benchmark_load.json";
+    int benchmarkIterations = 10;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+        {
+            scenePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc)
+        {
+            benchFrames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bake-mesh") == 0 && i + 1 < argc)
+        {
+            return loadOBJ(argv[i + 1]) ? 0 : 1;
+        }
+        else if (strcmp(argv[i], "--benchmark-load") == 0 && i + 1 < argc)
+        {
+            benchmarkLoadPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--benchmark-iterations") == 0 && i + 1 < argc)
+        {
+            benchmarkIterations = std::max(atoi(argv[++i]), 1);
+        }
+        else if (strcmp(argv[i], "--benchmark-json") == 0 && i + 1 < argc)
+        {
+            benchmarkJsonPath = argv[++i];
+        }
+    }
+    if (!benchmarkLoadPath.empty())
+        return benchmarkLoad(benchmarkLoadPath, benchmarkIterations, benchmarkJsonPath);
     init();
     render();
     cleanup();
@@ -7,10 +7,27 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <cmath>
 #include <string>
-
-// 纹理加载库
-#define STB_IMAGE_IMPLEMENTATION
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMULATION_SSE 1
+#endif
+
+// 纹理加载库（stb_image 和 stb_image_resize2 的实现在 glcore 中）
 #include "stb_image.h"
+#include "stb_image_resize2.h"
+// 各次作业共用的窗口、帧循环和着色器编译（着色库见 glcore/shader_library.h）
+#include "glcore/app.h"
+#include "glcore/program.h"
+#include "glcore/texture_loader.h"
 
 // 窗口尺寸
 const unsigned int SCR_WIDTH = 800;
@@ -23,17 +40,85 @@ const float MOON_RADIUS = 0.3f;
 const float EARTH_ORBIT_RADIUS = 12.0f;
 const float MOON_ORBIT_RADIUS = 2.5f;
 const float SHADOW_BIAS = 0.01f; // 阴影偏移（防止自遮挡）
-
-// 着色器程序ID
-unsigned int shaderProgram;
-
-// 纹理ID
-unsigned int sunTexture, earthTexture, moonTexture;
+const int ASTEROID_COUNT = 400;   // 小行星带（月亮纹理），验证大量天体一次绘制
+const float ASTEROID_BELT_INNER = 18.0f;
+const float ASTEROID_BELT_OUTER = 24.0f;
+const int MAX_OCCLUDERS_PER_BODY = 16; // 每个天体着色时最多检测的遮挡物数量
+
+// 轨道模拟：引力常数×质量。太阳按地球原先的公转角速度（0.3 弧度/秒）推出 GM = ω²r³；
+// 月球轨道须在地球希尔半径 r·(GM地/3GM日)^(1/3) 的约 0.35 倍以内才能长期稳定，由此定出地球的 GM
+const float EARTH_ANGULAR_SPEED = 0.3f;
+const float GM_SUN = EARTH_ANGULAR_SPEED * EARTH_ANGULAR_SPEED * EARTH_ORBIT_RADIUS * EARTH_ORBIT_RADIUS * EARTH_ORBIT_RADIUS;
+const float MOON_HILL_FRACTION = 0.35f;
+const float GM_EARTH = 3.0f * GM_SUN * powf(MOON_ORBIT_RADIUS / (MOON_HILL_FRACTION * EARTH_ORBIT_RADIUS), 3.0f);
+const float GM_MOON = 0.05f;
+const float SIM_TIME_STEP = 1.0f / 120.0f;  // 固定步长，与渲染帧率无关
+const int SIM_MAX_STEPS_PER_FRAME = 8;       // 卡顿时丢弃多余的时间，避免越追越慢
+const float SIM_SOFTENING = 0.01f;           // 软化项（距离平方），防止近距离加速度发散
+const int SIM_BODIES_PER_TASK = 256;         // 线程池每个任务处理的天体数（4 的倍数）
+
+// 着色器程序ID：网格球体 / 光线求交的替身球体（impostor）
+unsigned int shaderProgram, impostorProgram;
+bool useImpostors = true; // I 键切换
+
+// 纹理数组：第 objectType 层为该类天体的纹理
+enum ObjectType { OBJECT_SUN = 0, OBJECT_EARTH = 1, OBJECT_MOON = 2, OBJECT_ASTEROID = 3, OBJECT_TYPE_COUNT };
+unsigned int bodyTextureArray;
+
+// 每个天体一个实例：模型矩阵、半径、类型，全部天体一次 glDrawElementsInstanced
+struct CelestialBody {
+    int objectType;
+    glm::vec3 pos;
+    float radius;
+};
+struct BodyInstance {
+    glm::mat4 model;
+    float radius;
+    int objectType;
+};
+std::vector<CelestialBody> bodies;
+std::vector<BodyInstance> bodyInstances;
+unsigned int instanceVBO;
+
+// 每帧只设置一次的uniform（着色器编译后查询位置）
+struct FrameUniforms {
+    int view, projection, cameraPos, sunPos, sunRadius, shadowBias;
+};
+FrameUniforms frameUniforms, impostorUniforms;
+
+// 遮挡物列表（GL 3.3 没有 SSBO，用纹理缓冲代替），纹理单元 1-3：
+// occluderData 每个天体一个 vec4(中心, 半径)，按实例序号索引
+// occluderLists 每个天体 (偏移, 数量)，指向 occluderIndices 中该天体的候选遮挡物
+struct TextureBuffer {
+    unsigned int buffer, texture;
+};
+TextureBuffer occluderData, occluderLists, occluderIndices;
+std::vector<glm::vec4> occluderDataCPU;
+std::vector<glm::uvec2> occluderListsCPU;
+std::vector<unsigned int> occluderIndicesCPU;
 
 // 球体顶点数据
 std::vector<float> sphereVertices;
 unsigned int sphereVAO, sphereVBO, sphereEBO;
 int sphereIndexCount = 0;
+// 替身球体：每个天体一个朝向摄像机的四边形
+unsigned int impostorVAO, impostorVBO;
+
+// 固定摄像机
+const glm::vec3 CAMERA_POS = glm::vec3(0.0f, 0.0f, 35.0f);
+
+// ===================== GPU拾取 =====================
+// 主绘制写入多重采样的场景帧缓冲：颜色 + 天体ID（R32UI，0 为背景，否则为实例序号+1）。
+// 点击时只把光标处的一个像素从多重采样ID缓冲解析到单采样ID缓冲，再异步读回 PBO，
+// 后续帧检查 fence 就绪后再映射，不会阻塞渲染
+int framebufferWidth = SCR_WIDTH, framebufferHeight = SCR_HEIGHT;
+unsigned int sceneFBO, sceneColorRBO, sceneIdRBO, sceneDepthRBO;
+unsigned int pickFBO, pickIdRBO;
+unsigned int pickPBO;
+GLsync pickFence = 0;             // 非0表示有读回在进行中
+bool pickRequested = false;       // 点击后等待下一帧绘制完成再读取
+int pickX = 0, pickY = 0;         // 帧缓冲像素坐标（原点在左下角）
+double pickCursorX = 0.0, pickCursorY = 0.0; // 点击时的窗口坐标，CPU 求交回退用
 
 // 天体位置（全局更新）
 glm::vec3 sunPos = glm::vec3(0.0f);
@@ -61,8 +146,11 @@ const char* vertexShaderSource = R"(
     #version 330 core
     layout (location = 0) in vec3 aPos;
     layout (location = 1) in vec2 aTexCoord;
+    // 实例属性：每个天体一份
+    layout (location = 2) in mat4 model;      // 占用 2-5
+    layout (location = 6) in float bodyRadius;
+    layout (location = 7) in int bodyType;
 
-    uniform mat4 model;
     uniform mat4 view;
     uniform mat4 projection;
 
@@ -70,35 +158,161 @@ const char* vertexShaderSource = R"(
     out vec2 TexCoord;
     out vec3 WorldPos;  // 世界空间坐标（精准）
     out vec3 Normal;    // 世界空间法线
+    flat out int objectType;
+    flat out int bodyIndex; // 实例序号，即天体在遮挡物表中的序号
 
     void main()
     {
         WorldPos = vec3(model * vec4(aPos, 1.0));
-        Normal = mat3(transpose(inverse(model))) * aPos; // 球体法线=顶点方向
+        Normal = mat3(model) * aPos; // 球体法线=顶点方向（模型矩阵只含平移和等比缩放）
         TexCoord = aTexCoord;
+        objectType = bodyType;
+        bodyIndex = gl_InstanceID;
         gl_Position = projection * view * model * vec4(aPos, 1.0);
     }
 )";
 
-const char* fragmentShaderSource = R"(
+// 两种球体共用的光照与阴影，各自的 main 拼接在后面
+const char* shadingShaderSource = R"(
     #version 330 core
-    out vec4 FragColor;
+    #include "lighting.glsl"
+    layout (location = 0) out vec4 FragColor;
+    layout (location = 1) out uint BodyID; // 拾取用：实例序号+1
 
-    in vec2 TexCoord;
-    in vec3 WorldPos;  // 像素的世界空间精准位置
-    in vec3 Normal;
+    flat in int objectType;      // 0=太阳, 1=地球, 2=月亮, 3=小行星
+    flat in int bodyIndex;
 
     // 全局参数（精准传递）
-    uniform sampler2D texture1;
-    uniform int objectType;      // 0=太阳, 1=地球, 2=月亮
+    uniform sampler2DArray bodyTextures; // 第 objectType 层
+    uniform samplerBuffer occluderData;   // 每个天体 vec4(中心, 半径)
+    uniform usamplerBuffer occluderLists; // 每个天体 (偏移, 数量)
+    uniform usamplerBuffer occluderIndices;
     uniform vec3 sunPos;         // 太阳精准位置
-    uniform vec3 earthPos;       // 地球精准位置
-    uniform vec3 moonPos;        // 月亮精准位置
     uniform float sunRadius;     // 太阳半径
-    uniform float earthRadius;   // 地球半径
-    uniform float moonRadius;    // 月亮半径
     uniform float shadowBias;    // 阴影偏移
 
+    // ===================== 精准软阴影：太阳圆盘被遮挡的比例 =====================
+    // 从像素看去，太阳和遮挡物都是圆盘（角半径 asin(r/d)），两圆重叠面积 / 太阳圆盘面积即为遮挡比例，
+    // 完全遮住为本影，部分遮住为半影
+    float sunOcclusion(vec3 fragPos, vec3 occluderPos, float occluderRadius) {
+        vec3 toSun = sunPos - fragPos;
+        vec3 toOccluder = occluderPos - fragPos;
+        float sunDist = length(toSun);
+        float occluderDist = length(toOccluder);
+        // 遮挡物须位于像素和太阳之间，且不包含像素本身
+        if (occluderDist <= occluderRadius + shadowBias || occluderDist > sunDist) return 0.0;
+
+        float sunAngle = asin(min(sunRadius / sunDist, 1.0));
+        float occluderAngle = asin(min(occluderRadius / occluderDist, 1.0));
+        float separation = acos(clamp(dot(toSun / sunDist, toOccluder / occluderDist), -1.0, 1.0));
+
+        if (separation >= sunAngle + occluderAngle) return 0.0;                 // 不重叠
+        if (separation <= occluderAngle - sunAngle) return 1.0;                 // 本影：太阳被完全遮住
+        if (separation <= sunAngle - occluderAngle)                             // 环食：遮挡物完全落在太阳圆盘内
+            return (occluderAngle * occluderAngle) / (sunAngle * sunAngle);
+
+        // 两圆部分重叠的面积（小角度下按平面圆处理）
+        float r0 = sunAngle, r1 = occluderAngle, d = separation;
+        float a0 = acos(clamp((d * d + r0 * r0 - r1 * r1) / (2.0 * d * r0), -1.0, 1.0));
+        float a1 = acos(clamp((d * d + r1 * r1 - r0 * r0) / (2.0 * d * r1), -1.0, 1.0));
+        float overlap = r0 * r0 * (a0 - 0.5 * sin(2.0 * a0)) + r1 * r1 * (a1 - 0.5 * sin(2.0 * a1));
+        return clamp(overlap / (3.14159265 * r0 * r0), 0.0, 1.0);
+    }
+
+    // 只遍历 CPU 预筛选出的候选遮挡物
+    float sunVisibility(vec3 fragPos) {
+        uvec2 list = texelFetch(occluderLists, bodyIndex).rg;
+        float visibility = 1.0;
+        for (uint i = 0u; i < list.y; i++) {
+            int occluder = int(texelFetch(occluderIndices, int(list.x + i)).r);
+            vec4 sphere = texelFetch(occluderData, occluder);
+            visibility *= 1.0 - sunOcclusion(fragPos, sphere.xyz, sphere.w);
+        }
+        return visibility;
+    }
+
+    vec4 shadeBody(vec3 worldPos, vec3 normal, vec4 texColor) {
+        // 太阳自发光：无阴影，直接输出
+        if (objectType == 0) {
+            return texColor;
+        }
+
+        // ===================== 基础光照（精准漫反射） =====================
+        // 太阳是唯一光源：环境光 0.15（避免纯黑），无高光
+        Material material = Material(texColor.rgb, vec3(0.0), 1.0);
+        Surface surface = Surface(worldPos, normalize(normal), vec3(0.0));
+        LightSample sun = LightSample(normalize(sunPos - worldPos), vec3(0.15), vec3(1.0), vec3(0.0), 1.0);
+
+        // ===================== 精准阴影判断 =====================
+        // 背光面本来就没有漫反射，不必检测遮挡物
+        float visibility = FacesLight(surface, sun) ? sunVisibility(worldPos) : 1.0;
+
+        // ===================== 最终颜色（精准阴影应用） =====================
+        // 本影仅保留环境光，半影按太阳圆盘的可见比例衰减
+        return vec4(ShadeLight(material, surface, sun, visibility), 1.0);
+    }
+)";
+
+const char* fragmentShaderSource = R"(
+    in vec2 TexCoord;
+    in vec3 WorldPos;  // 像素的世界空间精准位置
+    in vec3 Normal;
+
+    void main() {
+        vec4 texColor = texture(bodyTextures, vec3(TexCoord, objectType));
+        FragColor = shadeBody(WorldPos, Normal, texColor);
+        BodyID = uint(bodyIndex) + 1u;
+    }
+)";
+
+// ===================== 替身球体：四边形 + 逐像素射线-球体求交 =====================
+// 四边形垂直于摄像机到球心的视线，边长按球体轮廓（切线锥）放大，保证完整覆盖
+const char* impostorVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aCorner;    // (-1,-1) 到 (1,1)
+    layout (location = 2) in mat4 model;      // 占用 2-5，只用平移
+    layout (location = 6) in float bodyRadius;
+    layout (location = 7) in int bodyType;
+
+    uniform mat4 view;
+    uniform mat4 projection;
+    uniform vec3 cameraPos;
+
+    out vec3 WorldPos;  // 四边形上的点，片段着色器从摄像机向它发射射线
+    flat out vec3 sphereCenter;
+    flat out float sphereRadius;
+    flat out int objectType;
+    flat out int bodyIndex;
+
+    void main()
+    {
+        sphereCenter = vec3(model[3]);
+        sphereRadius = bodyRadius;
+        objectType = bodyType;
+        bodyIndex = gl_InstanceID;
+
+        vec3 toCenter = sphereCenter - cameraPos;
+        float dist = length(toCenter);
+        vec3 forward = toCenter / dist;
+        vec3 right = normalize(cross(forward, abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+        vec3 up = cross(right, forward);
+        // 切线锥与过球心平面的交圆半径 r*d/sqrt(d^2-r^2)
+        float halfSize = bodyRadius * dist / sqrt(max(dist * dist - bodyRadius * bodyRadius, 1e-6));
+
+        WorldPos = sphereCenter + (right * aCorner.x + up * aCorner.y) * halfSize;
+        gl_Position = projection * view * vec4(WorldPos, 1.0);
+    }
+)";
+
+const char* impostorFragmentShaderSource = R"(
+    in vec3 WorldPos;
+    flat in vec3 sphereCenter;
+    flat in float sphereRadius;
+
+    uniform mat4 view;
+    uniform mat4 projection;
+    uniform vec3 cameraPos;
+
     // ===================== 精准射线-球体相交检测（GLSL版本） =====================
     bool raySphereIntersect(vec3 rayOrigin, vec3 rayDir, vec3 sphereCenter, float sphereRadius, out float t0, out float t1) {
         vec3 oc = rayOrigin - sphereCenter;
@@ -115,59 +329,31 @@ const char* fragmentShaderSource = R"(
         return true;
     }
 
-    // ===================== 精准阴影检测 =====================
-    bool isInPreciseShadow(vec3 fragPos, vec3 lightPos, vec3 occluderPos, float occluderRadius) {
-        // 1. 构建从像素到光源的射线（反向：光源→像素，用于检测遮挡）
-        vec3 rayDir = normalize(fragPos - lightPos);
-        vec3 rayOrigin = lightPos + rayDir * shadowBias; // 偏移避免自遮挡
-        
-        // 2. 检测射线是否与遮挡物相交
-        float t0, t1;
-        if (raySphereIntersect(rayOrigin, rayDir, occluderPos, occluderRadius, t0, t1)) {
-            // 3. 相交条件：遮挡物在光源和像素之间（t0 < 像素距离 且 t1 > 0）
-            float fragDist = length(fragPos - lightPos);
-            return (t0 < fragDist - shadowBias) && (t1 > 0.0);
-        }
-        return false;
-    }
-
     void main() {
-        vec4 texColor = texture(texture1, TexCoord);
-        
-        // 太阳自发光：无阴影，直接输出
-        if (objectType == 0) {
-            FragColor = texColor;
-            return;
-        }
-
-        // ===================== 基础光照（精准漫反射） =====================
-        vec3 norm = normalize(Normal);
-        vec3 lightDir = normalize(sunPos - WorldPos);
-        float ambient = 0.15; // 环境光（避免纯黑）
-        float diffuse = max(dot(norm, lightDir), 0.0);
-        float totalLight = ambient + diffuse;
-
-        // ===================== 精准阴影判断 =====================
-        bool inShadow = false;
-
-        // 地球的阴影：检测月亮是否遮挡太阳→地球的光
-        if (objectType == 1) {
-            inShadow = isInPreciseShadow(WorldPos, sunPos, moonPos, moonRadius);
-        }
-        // 月亮的阴影：检测地球是否遮挡太阳→月亮的光
-        else if (objectType == 2) {
-            inShadow = isInPreciseShadow(WorldPos, sunPos, earthPos, earthRadius);
-        }
-
-        // ===================== 最终颜色（精准阴影应用） =====================
-        if (inShadow) {
-            // 完全遮挡：仅保留环境光
-            FragColor = texColor * ambient;
-        } else {
-            // 无遮挡：正常光照
-            FragColor = texColor * totalLight;
+        vec3 rayDir = normalize(WorldPos - cameraPos);
+        float t0, t1;
+        if (!raySphereIntersect(cameraPos, rayDir, sphereCenter, sphereRadius, t0, t1) || t0 <= 0.0) {
+            discard; // 落在轮廓外
         }
-        FragColor.a = 1.0;
+        vec3 hitPos = cameraPos + rayDir * t0;
+        vec3 normal = (hitPos - sphereCenter) / sphereRadius;
+
+        // 命中点的深度，与网格球体在同一深度空间
+        vec4 clipPos = projection * view * vec4(hitPos, 1.0);
+        gl_FragDepth = (clipPos.z / clipPos.w) * 0.5 + 0.5;
+
+        // UV 与 generateHighPrecisionSphere 一致：u = 经度 / 2π，v 从北极 (z=1) 的 0 到南极的 1
+        // 经度在 u=0/1 处跳变，两套导数取较小者，避免接缝处选到最低一级 mipmap
+        float u = atan(normal.y, normal.x) / 6.28318531;
+        float v = 0.5 - asin(clamp(normal.z, -1.0, 1.0)) / 3.14159265;
+        vec2 uvA = vec2(fract(u), v);
+        vec2 uvB = vec2(fract(u + 0.5) - 0.5, v);
+        vec2 dx = abs(dFdx(uvA.x)) < abs(dFdx(uvB.x)) ? dFdx(uvA) : dFdx(uvB);
+        vec2 dy = abs(dFdy(uvA.x)) < abs(dFdy(uvB.x)) ? dFdy(uvA) : dFdy(uvB);
+        vec4 texColor = textureGrad(bodyTextures, vec3(uvA, objectType), dx, dy);
+
+        FragColor = shadeBody(hitPos, normal, texColor);
+        BodyID = uint(bodyIndex) + 1u;
     }
 )";
 
@@ -232,193 +418,831 @@ void generateHighPrecisionSphere(float radius, int sectors = 64, int stacks = 64
     glBindVertexArray(0);
 }
 
-// 加载纹理（保持原始精度）
-unsigned int loadTexture(const char* path) {
+// 解码原始图片逐层上传，之后生成mip
+static void loadDecodedTextureArray(const std::vector<const char*>& paths) {
+    stbi_set_flip_vertically_on_load(true);
+    int layerWidth = 0, layerHeight = 0;
+    for (size_t layer = 0; layer < paths.size(); layer++) {
+        int width, height, nrChannels;
+        unsigned char* data = stbi_load(paths[layer], &width, &height, &nrChannels, STBI_rgb_alpha);
+        if (!data) {
+            std::cerr << "纹理加载失败: " << paths[layer] << std::endl;
+            // 缺失的层用白色
+            width = height = 1;
+            data = (unsigned char*)malloc(4);
+            memset(data, 255, 4);
+        }
+        if (layer == 0) {
+            layerWidth = width;
+            layerHeight = height;
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, layerWidth, layerHeight, (GLsizei)paths.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+        if (width != layerWidth || height != layerHeight) {
+            unsigned char* resized = stbir_resize_uint8_linear(data, width, height, 0, NULL, layerWidth, layerHeight, 0, STBIR_RGBA);
+            stbi_image_free(data);
+            data = resized;
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, layerWidth, layerHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        free(data);
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+// 读取所有层烘焙的 KTX2（构建时已翻转），尺寸、格式、mip级数一致时才使用
+static bool loadBakedTextureArray(const std::vector<const char*>& paths) {
+    if (!glcore::isBakedTextureSupported())
+        return false;
+    std::vector<glcore::CompressedImage> layers(paths.size());
+    for (size_t layer = 0; layer < paths.size(); layer++) {
+        if (!glcore::readKTX2(glcore::getBakedTexturePath(paths[layer]), layers[layer]))
+            return false;
+        const glcore::CompressedImage& first = layers[0];
+        if (layers[layer].internalFormat != first.internalFormat || layers[layer].width != first.width ||
+            layers[layer].height != first.height || layers[layer].levels.size() != first.levels.size())
+            return false;
+    }
+    const glcore::CompressedImage& first = layers[0];
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (GLint)first.levels.size() - 1);
+    for (size_t level = 0; level < first.levels.size(); level++) {
+        GLsizei width = std::max(first.width >> level, 1), height = std::max(first.height >> level, 1);
+        GLsizei levelSize = (GLsizei)first.levels[level].size();
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, first.internalFormat, width, height, (GLsizei)paths.size(), 0,
+                               levelSize * (GLsizei)paths.size(), NULL);
+        for (size_t layer = 0; layer < paths.size(); layer++)
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, 0, (GLint)layer, width, height, 1, first.internalFormat,
+                                      levelSize, layers[layer].levels[level].data());
+    }
+    return true;
+}
+
+// 加载纹理数组：每个文件一层，尺寸与第一层不同时缩放；有烘焙的 KTX2 时直接上传压缩数据
+unsigned int loadTextureArray(const std::vector<const char*>& paths) {
     unsigned int textureID;
     glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
 
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true);
-    // 加载原始精度纹理，不缩放
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = (nrChannels == 3) ? GL_RGB : GL_RGBA;
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        // 纹理过滤（精准采样）
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-        stbi_image_free(data);
-    } else {
-        std::cerr << "纹理加载失败: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    if (!loadBakedTextureArray(paths))
+        loadDecodedTextureArray(paths);
 
+    // 纹理过滤（精准采样）
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
     return textureID;
 }
 
-// 编译着色器（保留错误日志）
-void compileShaders() {
-    // 顶点着色器
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "顶点着色器编译失败:\n" << infoLog << std::endl;
-    }
-
-    // 片段着色器
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "片段着色器编译失败:\n" << infoLog << std::endl;
-    }
+// 编译着色器（保留错误日志，有程序二进制缓存时直接加载），片段着色器由共用部分和 main 拼接
+unsigned int createProgram(const char* vertexSource, const char* fragmentSource) {
+    std::string fullFragmentSource = std::string(shadingShaderSource) + fragmentSource;
+    unsigned int program = glcore::compileShaderProgram(vertexSource, fullFragmentSource.c_str());
+
+    // 纹理单元固定
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "bodyTextures"), 0);
+    glUniform1i(glGetUniformLocation(program, "occluderData"), 1);
+    glUniform1i(glGetUniformLocation(program, "occluderLists"), 2);
+    glUniform1i(glGetUniformLocation(program, "occluderIndices"), 3);
+    glUseProgram(0);
+    return program;
+}
 
-    // 链接着色器程序
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "着色器链接失败:\n" << infoLog << std::endl;
-    }
+FrameUniforms getFrameUniforms(unsigned int program) {
+    FrameUniforms uniforms;
+    uniforms.view = glGetUniformLocation(program, "view");
+    uniforms.projection = glGetUniformLocation(program, "projection");
+    uniforms.cameraPos = glGetUniformLocation(program, "cameraPos");
+    uniforms.sunPos = glGetUniformLocation(program, "sunPos");
+    uniforms.sunRadius = glGetUniformLocation(program, "sunRadius");
+    uniforms.shadowBias = glGetUniformLocation(program, "shadowBias");
+    return uniforms;
+}
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+void compileShaders() {
+    shaderProgram = createProgram(vertexShaderSource, fragmentShaderSource);
+    impostorProgram = createProgram(impostorVertexShaderSource, impostorFragmentShaderSource);
+    frameUniforms = getFrameUniforms(shaderProgram);
+    impostorUniforms = getFrameUniforms(impostorProgram);
 }
 
+void createFramebuffers(int width, int height);
+
 // 窗口回调
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
+    if (width > 0 && height > 0) {
+        createFramebuffers(width, height);
+    }
 }
 
 // 输入处理
 void processInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+
+    // I 键切换替身球体 / 网格球体
+    static bool impostorKeyDown = false;
+    bool keyDown = glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS;
+    if (keyDown && !impostorKeyDown) {
+        useImpostors = !useImpostors;
+        std::cout << (useImpostors ? "impostor spheres" : "mesh spheres") << std::endl;
+    }
+    impostorKeyDown = keyDown;
 }
 
-// 精准射线-球体碰撞检测（点击交互）
-bool preciseRaySphereHit(double mouseX, double mouseY, GLFWwindow* window, const glm::vec3& sphereCenter, float sphereRadius) {
+// 屏幕坐标 → 世界空间射线
+void cursorRay(double mouseX, double mouseY, glm::vec3& rayOrigin, glm::vec3& rayDir) {
     // 屏幕坐标转NDC
     float x = (2.0f * (float)mouseX) / SCR_WIDTH - 1.0f;
     float y = 1.0f - (2.0f * (float)mouseY) / SCR_HEIGHT;
-    glm::vec3 ray_nds = glm::vec3(x, y, 1.0f);
 
     // NDC转世界空间射线
-    glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -35.0f));
+    glm::mat4 view = glm::translate(glm::mat4(1.0f), -CAMERA_POS);
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH/SCR_HEIGHT, 0.1f, 200.0f);
-    glm::vec4 ray_clip = glm::vec4(ray_nds.x, ray_nds.y, -1.0f, 1.0f);
+    glm::vec4 ray_clip = glm::vec4(x, y, -1.0f, 1.0f);
     glm::vec4 ray_eye = glm::inverse(projection) * ray_clip;
     ray_eye = glm::vec4(ray_eye.x, ray_eye.y, -1.0f, 0.0f);
-    glm::vec3 ray_dir = glm::normalize(glm::vec3(glm::inverse(view) * ray_eye));
-    glm::vec3 ray_origin = glm::vec3(0.0f, 0.0f, 35.0f);
+    rayDir = glm::normalize(glm::vec3(glm::inverse(view) * ray_eye));
+    rayOrigin = CAMERA_POS;
+}
+
+// ===================== CPU回退：天体包围盒 BVH =====================
+// 拾取结果不在ID缓冲里时使用（光标在帧缓冲外、帧缓冲不完整），也可用于任意射线的查询
+struct BvhNode {
+    glm::vec3 boundsMin, boundsMax;
+    int left, right;        // 内部节点的子节点
+    int first, count;       // 叶节点在 bvhBodies 中的范围，count > 0 表示叶节点
+};
+std::vector<BvhNode> bvhNodes;
+std::vector<int> bvhBodies;
+
+int buildBvhNode(int first, int count) {
+    BvhNode node;
+    node.boundsMin = glm::vec3(1e30f);
+    node.boundsMax = glm::vec3(-1e30f);
+    for (int i = first; i < first + count; i++) {
+        const CelestialBody& body = bodies[bvhBodies[i]];
+        node.boundsMin = glm::min(node.boundsMin, body.pos - glm::vec3(body.radius));
+        node.boundsMax = glm::max(node.boundsMax, body.pos + glm::vec3(body.radius));
+    }
+    node.left = node.right = -1;
+    node.first = first;
+    node.count = count;
+    int index = (int)bvhNodes.size();
+    bvhNodes.push_back(node);
+    if (count <= 4) return index;
+
+    // 沿最长轴按中位数划分
+    glm::vec3 extent = node.boundsMax - node.boundsMin;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    int half = count / 2;
+    std::nth_element(bvhBodies.begin() + first, bvhBodies.begin() + first + half, bvhBodies.begin() + first + count,
+                     [axis](int a, int b) { return bodies[a].pos[axis] < bodies[b].pos[axis]; });
+    int left = buildBvhNode(first, half);
+    int right = buildBvhNode(first + half, count - half);
+    bvhNodes[index].left = left;
+    bvhNodes[index].right = right;
+    bvhNodes[index].count = 0;
+    return index;
+}
+
+// 天体每帧移动，查询时重建（几百个天体，开销很小）
+void buildBvh() {
+    bvhNodes.clear();
+    bvhBodies.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) bvhBodies[i] = (int)i;
+    if (!bodies.empty()) buildBvhNode(0, (int)bodies.size());
+}
 
-    // 精准相交检测（调用CPU端的raySphereIntersect）
-    float t0, t1;
-    return raySphereIntersect(ray_origin, ray_dir, sphereCenter, sphereRadius, t0, t1) && t0 > 0.0f;
+bool rayBoxIntersect(const glm::vec3& rayOrigin, const glm::vec3& invDir, const glm::vec3& boxMin, const glm::vec3& boxMax, float maxT) {
+    glm::vec3 t0 = (boxMin - rayOrigin) * invDir;
+    glm::vec3 t1 = (boxMax - rayOrigin) * invDir;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+    return enter <= exit;
 }
 
-// 鼠标点击回调（精准选中）
+// 返回最近的被射线击中的天体序号，未击中返回 -1
+int pickBodyRay(const glm::vec3& rayOrigin, const glm::vec3& rayDir) {
+    buildBvh();
+    if (bvhNodes.empty()) return -1;
+    glm::vec3 invDir = 1.0f / rayDir;
+    int closest = -1;
+    float closestT = 1e30f;
+    int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const BvhNode& node = bvhNodes[stack[--stackSize]];
+        if (!rayBoxIntersect(rayOrigin, invDir, node.boundsMin, node.boundsMax, closestT)) continue;
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                // 精准相交检测（调用CPU端的raySphereIntersect）
+                float t0, t1;
+                const CelestialBody& body = bodies[bvhBodies[i]];
+                if (raySphereIntersect(rayOrigin, rayDir, body.pos, body.radius, t0, t1) && t0 > 0.0f && t0 < closestT) {
+                    closestT = t0;
+                    closest = bvhBodies[i];
+                }
+            }
+        } else {
+            stack[stackSize++] = node.left;
+            stack[stackSize++] = node.right;
+        }
+    }
+    return closest;
+}
+
+void printSelection(int body) {
+    if (body < 0) {
+        std::cout << "no selected" << std::endl;
+        return;
+    }
+    static const char* names[OBJECT_TYPE_COUNT] = {"sun", "earth", "moon", "asteroid"};
+    std::cout << "selected " << names[bodies[body].objectType];
+    if (bodies[body].objectType == OBJECT_ASTEROID) std::cout << " " << body;
+    std::cout << std::endl;
+}
+
+// 鼠标点击回调（精准选中）：记录像素，下一帧绘制后从ID缓冲读取
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-        double xpos, ypos;
-        glfwGetCursorPos(window, &xpos, &ypos);
-
-        if (preciseRaySphereHit(xpos, ypos, window, sunPos, SUN_RADIUS)) {
-            std::cout << "selected sun" << std::endl;
-        } else if (preciseRaySphereHit(xpos, ypos, window, earthPos, EARTH_RADIUS)) {
-            std::cout << "selected earth" << std::endl;
-        } else if (preciseRaySphereHit(xpos, ypos, window, moonPos, MOON_RADIUS)) {
-            std::cout << "selected moon" << std::endl;
-        } else {
-            std::cout << "no selected" << std::endl;
+        glfwGetCursorPos(window, &pickCursorX, &pickCursorY);
+
+        // 窗口坐标 → 帧缓冲像素（高DPI下两者不同，且帧缓冲原点在左下角）
+        int windowWidth, windowHeight;
+        glfwGetWindowSize(window, &windowWidth, &windowHeight);
+        pickX = (int)(pickCursorX * framebufferWidth / std::max(windowWidth, 1));
+        pickY = framebufferHeight - 1 - (int)(pickCursorY * framebufferHeight / std::max(windowHeight, 1));
+        pickRequested = true;
+    }
+}
+
+// ===================== 线程池 =====================
+// parallelFor 把 [0, count) 切成 grain 大小的块分给工作线程，调用线程也参与，全部完成后返回
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int workerCount) {
+        for (unsigned int i = 0; i < workerCount; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    void parallelFor(int count, int grain, const std::function<void(int, int)>& fn) {
+        int chunks = (count + grain - 1) / grain;
+        if (chunks <= 1 || workers.empty()) {
+            if (count > 0) fn(0, count);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            jobGrain = grain;
+            jobChunks = chunks;
+            pendingChunks = chunks;
+            nextChunk = 0;
+            generation++;
+        }
+        wake.notify_all();
+        runChunks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pendingChunks == 0; });
+    }
+
+private:
+    void runChunks() {
+        while (true) {
+            int chunk = nextChunk.fetch_add(1);
+            if (chunk >= jobChunks) return;
+            int begin = chunk * jobGrain;
+            (*job)(begin, std::min(begin + jobGrain.load(), jobCount.load()));
+            if (pendingChunks.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_one();
+            }
+        }
+    }
+
+    void workerLoop() {
+        unsigned long long seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = generation;
+            }
+            runChunks();
         }
     }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    bool stopping = false;
+    unsigned long long generation = 0;
+    std::atomic<const std::function<void(int, int)>*> job{nullptr};
+    std::atomic<int> jobCount{0}, jobGrain{1}, jobChunks{0}, nextChunk{0}, pendingChunks{0};
+};
+
+// ===================== 轨道模拟（固定步长，SoA） =====================
+// 天体状态按分量分开存放，4 个一组用 SSE 积分；只有有质量的天体（太阳、地球、月亮）产生引力，
+// 小行星是试验粒子，所以每步开销是 O(天体数 × 引力源数)。
+// 为了让月球稳定，地球的质量远大于真实比例，小行星因此只受太阳引力（否则小行星带会被地球打散）。
+// 渲染在最近两步的状态之间按剩余时间插值，模拟结果与帧率无关
+struct SimulationState {
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> velX, velY, velZ;
+};
+
+struct Simulation {
+    int count = 0;                   // 真实天体数，数组按 4 的倍数补齐
+    SimulationState previous, current;
+    std::vector<float> mobility;     // 0 = 固定不动（太阳），1 = 参与积分
+    std::vector<float> major;        // 1 = 受所有引力源作用，0 = 小天体，只受 attractorMinor 为 1 的引力源作用
+    std::vector<int> attractors;     // 引力源的天体序号
+    std::vector<float> attractorGM;
+    std::vector<float> attractorMinor;
+    // 每步开始时引力源位置的快照，避免与并行写入冲突
+    std::vector<float> attractorX, attractorY, attractorZ;
+    double accumulator = 0.0;
+};
+
+Simulation simulation;
+ThreadPool* simulationPool = nullptr;
+
+// minor：小天体，只受 perturbsMinor 的引力源作用
+void simulationAddBody(const glm::vec3& pos, const glm::vec3& vel, float gm, bool fixed, bool minor, bool perturbsMinor) {
+    SimulationState& state = simulation.current;
+    if (gm > 0.0f) {
+        simulation.attractors.push_back(simulation.count);
+        simulation.attractorGM.push_back(gm);
+        simulation.attractorMinor.push_back(perturbsMinor ? 1.0f : 0.0f);
+    }
+    // 补齐的空位（位置、速度、mobility 均为 0）放在末尾，新天体覆盖第一个空位
+    if (simulation.count == (int)state.posX.size()) {
+        for (std::vector<float>* component : {&state.posX, &state.posY, &state.posZ, &state.velX, &state.velY, &state.velZ, &simulation.mobility, &simulation.major}) {
+            component->resize(component->size() + 4, 0.0f);
+        }
+    }
+    int i = simulation.count++;
+    state.posX[i] = pos.x; state.posY[i] = pos.y; state.posZ[i] = pos.z;
+    state.velX[i] = vel.x; state.velY[i] = vel.y; state.velZ[i] = vel.z;
+    simulation.mobility[i] = fixed ? 0.0f : 1.0f;
+    simulation.major[i] = minor ? 0.0f : 1.0f;
+    simulation.previous = state;
+}
+
+// 积分 [begin, end)，begin/end 为 4 的倍数：半隐式欧拉（先更新速度再更新位置，辛积分，轨道长期稳定）
+void simulationIntegrate(int begin, int end) {
+    SimulationState& state = simulation.current;
+    const int attractorCount = (int)simulation.attractors.size();
+#ifdef SIMULATION_SSE
+    const __m128 dt = _mm_set1_ps(SIM_TIME_STEP);
+    const __m128 softening = _mm_set1_ps(SIM_SOFTENING);
+    for (int i = begin; i < end; i += 4) {
+        __m128 px = _mm_loadu_ps(&state.posX[i]);
+        __m128 py = _mm_loadu_ps(&state.posY[i]);
+        __m128 pz = _mm_loadu_ps(&state.posZ[i]);
+        __m128 major = _mm_loadu_ps(&simulation.major[i]);
+        __m128 ax = _mm_setzero_ps(), ay = _mm_setzero_ps(), az = _mm_setzero_ps();
+        for (int a = 0; a < attractorCount; a++) {
+            // 引力源自身：距离为 0，贡献为 0
+            __m128 dx = _mm_sub_ps(_mm_set1_ps(simulation.attractorX[a]), px);
+            __m128 dy = _mm_sub_ps(_mm_set1_ps(simulation.attractorY[a]), py);
+            __m128 dz = _mm_sub_ps(_mm_set1_ps(simulation.attractorZ[a]), pz);
+            __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_add_ps(_mm_mul_ps(dz, dz), softening));
+            __m128 invR = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(r2));
+            __m128 gm = _mm_mul_ps(_mm_set1_ps(simulation.attractorGM[a]), _mm_max_ps(_mm_set1_ps(simulation.attractorMinor[a]), major));
+            __m128 scale = _mm_mul_ps(gm, _mm_mul_ps(invR, _mm_mul_ps(invR, invR)));
+            ax = _mm_add_ps(ax, _mm_mul_ps(dx, scale));
+            ay = _mm_add_ps(ay, _mm_mul_ps(dy, scale));
+            az = _mm_add_ps(az, _mm_mul_ps(dz, scale));
+        }
+        __m128 step = _mm_mul_ps(dt, _mm_loadu_ps(&simulation.mobility[i]));
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(&state.velX[i]), _mm_mul_ps(ax, step));
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(&state.velY[i]), _mm_mul_ps(ay, step));
+        __m128 vz = _mm_add_ps(_mm_loadu_ps(&state.velZ[i]), _mm_mul_ps(az, step));
+        _mm_storeu_ps(&state.velX[i], vx);
+        _mm_storeu_ps(&state.velY[i], vy);
+        _mm_storeu_ps(&state.velZ[i], vz);
+        _mm_storeu_ps(&state.posX[i], _mm_add_ps(px, _mm_mul_ps(vx, step)));
+        _mm_storeu_ps(&state.posY[i], _mm_add_ps(py, _mm_mul_ps(vy, step)));
+        _mm_storeu_ps(&state.posZ[i], _mm_add_ps(pz, _mm_mul_ps(vz, step)));
+    }
+#else
+    for (int i = begin; i < end; i++) {
+        float ax = 0.0f, ay = 0.0f, az = 0.0f;
+        for (int a = 0; a < attractorCount; a++) {
+            float dx = simulation.attractorX[a] - state.posX[i];
+            float dy = simulation.attractorY[a] - state.posY[i];
+            float dz = simulation.attractorZ[a] - state.posZ[i];
+            float invR = 1.0f / sqrtf(dx * dx + dy * dy + dz * dz + SIM_SOFTENING);
+            float gm = simulation.attractorGM[a] * std::max(simulation.attractorMinor[a], simulation.major[i]);
+            float scale = gm * invR * invR * invR;
+            ax += dx * scale;
+            ay += dy * scale;
+            az += dz * scale;
+        }
+        float step = SIM_TIME_STEP * simulation.mobility[i];
+        state.velX[i] += ax * step;
+        state.velY[i] += ay * step;
+        state.velZ[i] += az * step;
+        state.posX[i] += state.velX[i] * step;
+        state.posY[i] += state.velY[i] * step;
+        state.posZ[i] += state.velZ[i] * step;
+    }
+#endif
+}
+
+void simulationStep() {
+    simulation.previous = simulation.current;
+
+    const SimulationState& state = simulation.current;
+    simulation.attractorX.resize(simulation.attractors.size());
+    simulation.attractorY.resize(simulation.attractors.size());
+    simulation.attractorZ.resize(simulation.attractors.size());
+    for (size_t a = 0; a < simulation.attractors.size(); a++) {
+        int body = simulation.attractors[a];
+        simulation.attractorX[a] = state.posX[body];
+        simulation.attractorY[a] = state.posY[body];
+        simulation.attractorZ[a] = state.posZ[body];
+    }
+
+    simulationPool->parallelFor((int)state.posX.size(), SIM_BODIES_PER_TASK, simulationIntegrate);
 }
 
-// 绘制天体（传递所有精准参数）
-void drawPreciseCelestialBody(unsigned int texture, int objectType, const glm::vec3& pos, float scale) {
-    glUseProgram(shaderProgram);
+// 按真实经过的时间推进若干个固定步，返回插值系数（剩余时间 / 步长）
+float simulationAdvance(double frameTime) {
+    simulation.accumulator += frameTime;
+    int steps = 0;
+    while (simulation.accumulator >= SIM_TIME_STEP && steps < SIM_MAX_STEPS_PER_FRAME) {
+        simulationStep();
+        simulation.accumulator -= SIM_TIME_STEP;
+        steps++;
+    }
+    if (steps == SIM_MAX_STEPS_PER_FRAME) {
+        simulation.accumulator = std::min(simulation.accumulator, (double)SIM_TIME_STEP);
+    }
+    return (float)(simulation.accumulator / SIM_TIME_STEP);
+}
+
+// 渲染位置：上一步与当前步之间插值
+void simulationInterpolate(float alpha) {
+    const SimulationState& a = simulation.previous;
+    const SimulationState& b = simulation.current;
+    for (int i = 0; i < simulation.count; i++) {
+        bodies[i].pos = glm::vec3(a.posX[i] + (b.posX[i] - a.posX[i]) * alpha,
+                                  a.posY[i] + (b.posY[i] - a.posY[i]) * alpha,
+                                  a.posZ[i] + (b.posZ[i] - a.posZ[i]) * alpha);
+    }
+    sunPos = bodies[OBJECT_SUN].pos;
+    earthPos = bodies[OBJECT_EARTH].pos;
+    moonPos = bodies[OBJECT_MOON].pos;
+}
 
-    // 模型矩阵（精准变换）
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, pos);
-    model = glm::scale(model, glm::vec3(scale));
+void bindInstanceAttributes();
+
+// 天体列表：太阳、地球、月亮，再加一圈小行星，初速度取圆轨道速度
+void createBodies() {
+    bodies.clear();
+    earthPos = sunPos + glm::vec3(EARTH_ORBIT_RADIUS, 0.0f, 0.0f);
+    moonPos = earthPos + glm::vec3(MOON_ORBIT_RADIUS, 0.0f, 0.0f);
+    glm::vec3 earthVel = glm::vec3(0.0f, 0.0f, EARTH_ANGULAR_SPEED * EARTH_ORBIT_RADIUS);
+    glm::vec3 moonVel = earthVel + glm::vec3(0.0f, 0.0f, sqrtf(GM_EARTH / MOON_ORBIT_RADIUS));
+    bodies.push_back({OBJECT_SUN, sunPos, SUN_RADIUS});
+    simulationAddBody(sunPos, glm::vec3(0.0f), GM_SUN, true, false, true);
+    bodies.push_back({OBJECT_EARTH, earthPos, EARTH_RADIUS});
+    simulationAddBody(earthPos, earthVel, GM_EARTH, false, false, false);
+    bodies.push_back({OBJECT_MOON, moonPos, MOON_RADIUS});
+    simulationAddBody(moonPos, moonVel, GM_MOON, false, false, false);
+    srand(1);
+    for (int i = 0; i < ASTEROID_COUNT; i++) {
+        CelestialBody asteroid = {OBJECT_ASTEROID, glm::vec3(0.0f), 0.05f + 0.1f * (rand() / (float)RAND_MAX)};
+        float orbitRadius = ASTEROID_BELT_INNER + (ASTEROID_BELT_OUTER - ASTEROID_BELT_INNER) * (rand() / (float)RAND_MAX);
+        float orbitPhase = 2.0f * glm::pi<float>() * (rand() / (float)RAND_MAX);
+        float orbitHeight = 0.8f * (rand() / (float)RAND_MAX - 0.5f);
+        // 圆轨道速度 sqrt(GM/r)，与公转方向一致
+        float speed = sqrtf(GM_SUN / orbitRadius);
+        asteroid.pos = glm::vec3(cos(orbitPhase) * orbitRadius, orbitHeight, sin(orbitPhase) * orbitRadius);
+        glm::vec3 vel = glm::vec3(-sin(orbitPhase), 0.0f, cos(orbitPhase)) * speed;
+        bodies.push_back(asteroid);
+        simulationAddBody(asteroid.pos, vel, 0.0f, false, true, false);
+    }
+
+    // 实例缓冲，每帧整体更新，网格球体和替身球体共用
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, bodies.size() * sizeof(BodyInstance), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(sphereVAO);
+    bindInstanceAttributes();
+    glBindVertexArray(0);
 
-    // 视图/投影矩阵（固定摄像机，精准视角）
-    glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -35.0f));
+    // 替身四边形（三角形带）
+    const float corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+    glGenVertexArrays(1, &impostorVAO);
+    glGenBuffers(1, &impostorVBO);
+    glBindVertexArray(impostorVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, impostorVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    bindInstanceAttributes();
+    glBindVertexArray(0);
+}
+
+// 实例属性 2-7，绑定到当前 VAO
+void bindInstanceAttributes() {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (int column = 0; column < 4; column++) {
+        glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance), (void*)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(2 + column, 1);
+        glEnableVertexAttribArray(2 + column);
+    }
+    glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, sizeof(BodyInstance), (void*)offsetof(BodyInstance, radius));
+    glVertexAttribDivisor(6, 1);
+    glEnableVertexAttribArray(6);
+    glVertexAttribIPointer(7, 1, GL_INT, sizeof(BodyInstance), (void*)offsetof(BodyInstance, objectType));
+    glVertexAttribDivisor(7, 1);
+    glEnableVertexAttribArray(7);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// 纹理缓冲：数据放在 GL_TEXTURE_BUFFER 中，着色器用 texelFetch 读取
+TextureBuffer createTextureBuffer(GLenum format) {
+    TextureBuffer textureBuffer;
+    glGenBuffers(1, &textureBuffer.buffer);
+    glGenTextures(1, &textureBuffer.texture);
+    glBindBuffer(GL_TEXTURE_BUFFER, textureBuffer.buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, textureBuffer.texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, textureBuffer.buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    return textureBuffer;
+}
+
+void updateTextureBuffer(const TextureBuffer& textureBuffer, const void* data, size_t size) {
+    glBindBuffer(GL_TEXTURE_BUFFER, textureBuffer.buffer);
+    glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW); // 重新分配，避免等待上一帧
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void deleteTextureBuffer(TextureBuffer& textureBuffer) {
+    glDeleteTextures(1, &textureBuffer.texture);
+    glDeleteBuffers(1, &textureBuffer.buffer);
+}
+
+// 遮挡物能否在接收者上投下阴影（含半影）：
+// 太阳和遮挡物的外公切线围成半影锥，锥顶在两者之间，接收者球体与锥相交才可能被遮挡
+bool castsShadowOn(const CelestialBody& occluder, const CelestialBody& receiver) {
+    glm::vec3 axis = occluder.pos - sunPos;
+    float occluderDist = glm::length(axis);
+    if (occluderDist <= SUN_RADIUS + occluder.radius) return false;
+    axis /= occluderDist;
+
+    // 接收者必须在遮挡物背离太阳的一侧
+    if (glm::dot(receiver.pos - occluder.pos, axis) < -receiver.radius) return false;
+
+    // 半影锥：锥顶到遮挡物的距离 = occluderDist * r / (R + r)，半角 = asin((R + r) / occluderDist)
+    float sinAngle = (SUN_RADIUS + occluder.radius) / occluderDist;
+    float cosAngle = sqrtf(1.0f - sinAngle * sinAngle);
+    glm::vec3 apex = occluder.pos - axis * (occluderDist * occluder.radius / (SUN_RADIUS + occluder.radius));
+
+    // 球-锥相交：球心到锥面的有符号距离小于半径
+    glm::vec3 toReceiver = receiver.pos - apex;
+    float along = glm::dot(toReceiver, axis);
+    float across = glm::length(toReceiver - axis * along);
+    return across * cosAngle - along * sinAngle < receiver.radius;
+}
+
+// CPU预处理：为每个天体筛选出可能遮挡太阳光的天体，片段着色器只遍历这份短列表
+void buildOccluderLists() {
+    occluderDataCPU.resize(bodies.size());
+    occluderListsCPU.resize(bodies.size());
+    occluderIndicesCPU.clear();
+    for (size_t i = 0; i < bodies.size(); i++) {
+        occluderDataCPU[i] = glm::vec4(bodies[i].pos, bodies[i].radius);
+    }
+    for (size_t receiver = 0; receiver < bodies.size(); receiver++) {
+        unsigned int offset = (unsigned int)occluderIndicesCPU.size();
+        if (bodies[receiver].objectType != OBJECT_SUN) {
+            for (size_t occluder = 0; occluder < bodies.size(); occluder++) {
+                if (occluder == receiver || bodies[occluder].objectType == OBJECT_SUN) continue;
+                if (!castsShadowOn(bodies[occluder], bodies[receiver])) continue;
+                occluderIndicesCPU.push_back((unsigned int)occluder);
+                if (occluderIndicesCPU.size() - offset == MAX_OCCLUDERS_PER_BODY) break;
+            }
+        }
+        occluderListsCPU[receiver] = glm::uvec2(offset, (unsigned int)occluderIndicesCPU.size() - offset);
+    }
+    // 纹理缓冲不能为空
+    if (occluderIndicesCPU.empty()) occluderIndicesCPU.push_back(0);
+
+    updateTextureBuffer(occluderData, occluderDataCPU.data(), occluderDataCPU.size() * sizeof(glm::vec4));
+    updateTextureBuffer(occluderLists, occluderListsCPU.data(), occluderListsCPU.size() * sizeof(glm::uvec2));
+    updateTextureBuffer(occluderIndices, occluderIndicesCPU.data(), occluderIndicesCPU.size() * sizeof(unsigned int));
+}
+
+// 场景帧缓冲：多重采样的颜色、ID、深度；拾取帧缓冲：单采样ID，只解析点击的像素
+void createFramebuffers(int width, int height) {
+    if (sceneFBO) {
+        glDeleteFramebuffers(1, &sceneFBO);
+        glDeleteFramebuffers(1, &pickFBO);
+        unsigned int renderbuffers[] = {sceneColorRBO, sceneIdRBO, sceneDepthRBO, pickIdRBO};
+        glDeleteRenderbuffers(4, renderbuffers);
+    }
+    framebufferWidth = width;
+    framebufferHeight = height;
+
+    // 同一帧缓冲的附件采样数必须一致，整数格式受 GL_MAX_INTEGER_SAMPLES 限制
+    int maxIntegerSamples = 1;
+    glGetIntegerv(GL_MAX_INTEGER_SAMPLES, &maxIntegerSamples);
+    int samples = std::min(4, maxIntegerSamples); // 4x抗锯齿，提升精准度
+
+    glGenRenderbuffers(1, &sceneColorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, sceneColorRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &sceneIdRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, sceneIdRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_R32UI, width, height);
+    glGenRenderbuffers(1, &sceneDepthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, sceneDepthRBO);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+
+    glGenFramebuffers(1, &sceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, sceneColorRBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_RENDERBUFFER, sceneIdRBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, sceneDepthRBO);
+    GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "场景帧缓冲不完整" << std::endl;
+    }
+
+    // 多重采样解析要求源、目标矩形相同，所以单采样ID缓冲与窗口同大
+    glGenRenderbuffers(1, &pickIdRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, pickIdRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_R32UI, width, height);
+    glGenFramebuffers(1, &pickFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, pickFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, pickIdRBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "拾取帧缓冲不完整" << std::endl;
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// 绘制完成后：发起光标像素的异步读回
+void requestPick() {
+    if (!pickRequested || pickFence) return; // 上一次读回未完成时，这次点击留到下一帧
+    pickRequested = false;
+
+    if (pickX < 0 || pickY < 0 || pickX >= framebufferWidth || pickY >= framebufferHeight) {
+        // 光标不在帧缓冲内，ID缓冲里没有答案
+        glm::vec3 rayOrigin, rayDir;
+        cursorRay(pickCursorX, pickCursorY, rayOrigin, rayDir);
+        printSelection(pickBodyRay(rayOrigin, rayDir));
+        return;
+    }
+
+    // 整数缓冲的解析取其中一个采样，不做平均
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+    glReadBuffer(GL_COLOR_ATTACHMENT1);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pickFBO);
+    glBlitFramebuffer(pickX, pickY, pickX + 1, pickY + 1, pickX, pickY, pickX + 1, pickY + 1, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, pickFBO);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pickPBO);
+    glReadPixels(pickX, pickY, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    pickFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// 每帧检查读回是否完成（不等待），完成后输出选中的天体
+void resolvePick() {
+    if (!pickFence) return;
+    GLenum status = glClientWaitSync(pickFence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+    glDeleteSync(pickFence);
+    pickFence = 0;
+
+    unsigned int id = 0;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pickPBO);
+    if (void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(unsigned int), GL_MAP_READ_BIT)) {
+        memcpy(&id, data, sizeof(unsigned int));
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    printSelection(id > 0 && id <= bodies.size() ? (int)id - 1 : -1);
+}
+
+// 一次实例化绘制所有天体（传递所有精准参数）
+void drawCelestialBodies() {
+    unsigned int program = useImpostors ? impostorProgram : shaderProgram;
+    const FrameUniforms& uniforms = useImpostors ? impostorUniforms : frameUniforms;
+    glUseProgram(program);
+
+    // 视图/投影矩阵（固定摄像机，精准视角），每帧设置一次
+    glm::mat4 view = glm::translate(glm::mat4(1.0f), -CAMERA_POS);
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH/SCR_HEIGHT, 0.1f, 200.0f);
+    glUniformMatrix4fv(uniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(uniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3fv(uniforms.cameraPos, 1, glm::value_ptr(CAMERA_POS));
+    glUniform3fv(uniforms.sunPos, 1, glm::value_ptr(sunPos));
+    glUniform1f(uniforms.sunRadius, SUN_RADIUS);
+    glUniform1f(uniforms.shadowBias, SHADOW_BIAS);
+
+    // 实例数据（模型矩阵精准变换）
+    bodyInstances.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), bodies[i].pos);
+        bodyInstances[i].model = glm::scale(model, glm::vec3(bodies[i].radius));
+        bodyInstances[i].radius = bodies[i].radius;
+        bodyInstances[i].objectType = bodies[i].objectType;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, bodyInstances.size() * sizeof(BodyInstance), NULL, GL_STREAM_DRAW); // 重新分配，避免等待上一帧
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bodyInstances.size() * sizeof(BodyInstance), bodyInstances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // 传递所有精准参数到着色器
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform1i(glGetUniformLocation(shaderProgram, "objectType"), objectType);
-    glUniform3fv(glGetUniformLocation(shaderProgram, "sunPos"), 1, glm::value_ptr(sunPos));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "earthPos"), 1, glm::value_ptr(earthPos));
-    glUniform3fv(glGetUniformLocation(shaderProgram, "moonPos"), 1, glm::value_ptr(moonPos));
-    glUniform1f(glGetUniformLocation(shaderProgram, "sunRadius"), SUN_RADIUS);
-    glUniform1f(glGetUniformLocation(shaderProgram, "earthRadius"), EARTH_RADIUS);
-    glUniform1f(glGetUniformLocation(shaderProgram, "moonRadius"), MOON_RADIUS);
-    glUniform1f(glGetUniformLocation(shaderProgram, "shadowBias"), SHADOW_BIAS);
-
-    // 绑定纹理（精准采样）
+    buildOccluderLists();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, bodyTextureArray);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, occluderData.texture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, occluderLists.texture);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, occluderIndices.texture);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0);
 
-    // 绘制高精度球体
-    glBindVertexArray(sphereVAO);
-    glDrawElements(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0);
+    if (useImpostors) {
+        // 每个天体 4 个顶点，轮廓和深度逐像素求出
+        glBindVertexArray(impostorVAO);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)bodies.size());
+    } else {
+        // 绘制高精度球体
+        glBindVertexArray(sphereVAO);
+        glDrawElementsInstanced(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0, (GLsizei)bodies.size());
+    }
     glBindVertexArray(0);
 }
 
 int main() {
-    // 初始化GLFW（强制高精度上下文）
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 4); // 4x抗锯齿，提升精准度
-
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Precise Celestial Shadow", NULL, NULL);
+    // 初始化GLFW和GLAD（GL 3.3 核心上下文）
+    // 抗锯齿在场景帧缓冲中做，窗口本身不需要多重采样
+    glcore::WindowSettings windowSettings;
+    windowSettings.title = "Precise Celestial Shadow";
+    windowSettings.width = SCR_WIDTH;
+    windowSettings.height = SCR_HEIGHT;
+    GLFWwindow* window = glcore::createWindow(windowSettings);
     if (!window) {
-        std::cerr << "GLFW窗口创建失败" << std::endl;
-        glfwTerminate();
         return -1;
     }
-    glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
 
-    // 初始化GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "GLAD初始化失败" << std::endl;
-        return -1;
-    }
+    // 模拟线程池：主线程也参与计算
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    simulationPool = new ThreadPool(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
 
     // 初始化高精度资源
     generateHighPrecisionSphere(1.0f, 64, 64); // 64*64高精度球体
     compileShaders();
-    sunTexture = loadTexture("sun.bmp");
-    earthTexture = loadTexture("earth.bmp");
-    moonTexture = loadTexture("moon.bmp");
+    // 层顺序与 objectType 一致，小行星使用月亮纹理
+    bodyTextureArray = loadTextureArray({"sun.bmp", "earth.bmp", "moon.bmp", "moon.bmp"});
+    occluderData = createTextureBuffer(GL_RGBA32F);
+    occluderLists = createTextureBuffer(GL_RG32UI);
+    occluderIndices = createTextureBuffer(GL_R32UI);
+    createBodies();
+
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    createFramebuffers(framebufferWidth, framebufferHeight);
+    glGenBuffers(1, &pickPBO);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pickPBO);
+    glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(unsigned int), NULL, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
     // 启用深度测试（精准深度）
     glEnable(GL_DEPTH_TEST);
@@ -428,53 +1252,59 @@ int main() {
     glCullFace(GL_BACK);
 
     // 主循环
-    while (!glfwWindowShouldClose(window)) {
+    glcore::FrameLoop frameLoop;
+    while (frameLoop.begin(window)) {
         processInput(window);
-
-        // 清空缓冲区（精准颜色）
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 更新时间和天体位置（精准浮点运算）
-        float timeValue = (float)glfwGetTime();
-        
-        // 太阳固定在中心
-        sunPos = glm::vec3(0.0f, 0.0f, 0.0f);
-        
-        // 地球绕太阳公转（精准角度计算）
-        float earthAngle = timeValue * 0.3f; // 放慢速度，便于观察精准阴影
-        earthPos = glm::vec3(
-            cos(earthAngle) * EARTH_ORBIT_RADIUS,
-            0.0f,
-            sin(earthAngle) * EARTH_ORBIT_RADIUS
-        );
-        
-        // 月亮绕地球公转（精准角度计算）
-        float moonAngle = timeValue * 1.2f;
-        moonPos = earthPos + glm::vec3(
-            cos(moonAngle) * MOON_ORBIT_RADIUS,
-            0.0f,
-            sin(moonAngle) * MOON_ORBIT_RADIUS
-        );
-
-        // 绘制精准天体
-        drawPreciseCelestialBody(sunTexture, 0, sunPos, SUN_RADIUS);    // 太阳
-        drawPreciseCelestialBody(earthTexture, 1, earthPos, EARTH_RADIUS); // 地球
-        drawPreciseCelestialBody(moonTexture, 2, moonPos, MOON_RADIUS);  // 月亮
+        resolvePick();
+
+        // 清空缓冲区（精准颜色），ID清为0（背景）
+        glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+        const float clearColor[] = {0.0f, 0.0f, 0.0f, 1.0f};
+        const unsigned int clearId[] = {0, 0, 0, 0};
+        glClearBufferfv(GL_COLOR, 0, clearColor);
+        glClearBufferuiv(GL_COLOR, 1, clearId);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        // 推进固定步长的轨道模拟，渲染取最近两步之间的插值
+        float alpha = simulationAdvance(frameLoop.deltaTime);
+        simulationInterpolate(alpha);
+
+        // 绘制精准天体（一次实例化绘制）
+        drawCelestialBodies();
+        requestPick();
+
+        // 解析多重采样颜色到窗口
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, framebufferWidth, framebufferHeight, 0, 0, framebufferWidth, framebufferHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // 交换缓冲区（双缓冲保证精准显示）
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        frameLoop.end(window);
     }
 
     // 释放资源
     glDeleteVertexArrays(1, &sphereVAO);
     glDeleteBuffers(1, &sphereVBO);
     glDeleteBuffers(1, &sphereEBO);
+    if (pickFence) glDeleteSync(pickFence);
+    glDeleteBuffers(1, &pickPBO);
+    glDeleteFramebuffers(1, &sceneFBO);
+    glDeleteFramebuffers(1, &pickFBO);
+    unsigned int renderbuffers[] = {sceneColorRBO, sceneIdRBO, sceneDepthRBO, pickIdRBO};
+    glDeleteRenderbuffers(4, renderbuffers);
+    glDeleteVertexArrays(1, &impostorVAO);
+    glDeleteBuffers(1, &impostorVBO);
+    glDeleteBuffers(1, &instanceVBO);
+    deleteTextureBuffer(occluderData);
+    deleteTextureBuffer(occluderLists);
+    deleteTextureBuffer(occluderIndices);
     glDeleteProgram(shaderProgram);
-    glDeleteTextures(1, &sunTexture);
-    glDeleteTextures(1, &earthTexture);
-    glDeleteTextures(1, &moonTexture);
+    glDeleteProgram(impostorProgram);
+    glDeleteTextures(1, &bodyTextureArray);
+
+    delete simulationPool;
 
     glfwTerminate();
     return 0;